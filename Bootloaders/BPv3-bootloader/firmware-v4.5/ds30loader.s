@@ -10,7 +10,8 @@
 ;
 ; Webpage: 			http://mrmackey.no-ip.org/elektronik/ds30loader/
 ;
-; History:			1.0.2 Erase is now made just before write to increase reliability					
+; History:			1.0.3 The pc program can raise the baudrate after hello, command 0x04
+;					1.0.2 Erase is now made just before write to increase reliability					
 ;					1.0.1 Fixed baudrate error check
 ;					1.0.0 Added flash verification
 ;						  Removed PIC24FxxKAyyy stuff, se separate fw
@@ -127,7 +128,7 @@
 ;------------------------------------------------------------------------------
 		.equ	VERMAJ,		1										/*firmware version major*/
 		.equ	VERMIN,		0										/*fimrware version minor*/
-		.equ	VERREV,		2										/*firmware version revision*/
+		.equ	VERREV,		3										/*firmware version revision*/
 
 		.equ 	HELLO, 		0xC1		
 		.equ 	OK, 		'K'										/*erase/write ok*/
@@ -335,9 +336,10 @@ setup:
 ;------------------------------------------------------------------------------
 ; Init
 ;------------------------------------------------------------------------------
-		clr		DOERASE
+init:	clr		DOERASE
 		
 		;UART
+		bclr	USTA, #OERR			;a failed baudrate change may leave an overrun
 		mov		#UARTBR, W0 		;set	
 		mov 	W0, UBRG			; baudrate
 		bset	UMODE, #BRGH		;enable BRGH
@@ -426,9 +428,29 @@ rcvdata:
 		; Check checksum
 		;----------------------------------------------------------------------
 		cp0.b 	WCRC
-		bra 	z, bladdrchk
+		bra 	z, baudchk
 		SendL 	CHECKSUMERR
 		bra 	main1			
+
+
+		;----------------------------------------------------------------------
+		; Change baudrate	0x00 00 00 - 0x04 02 BRG CRC
+		;----------------------------------------------------------------------
+		;acknowledged at the current baudrate, then the pc program confirms
+		;with a hello at the new one and gets OK back. Anything else, or a
+		;receive timeout, goes back to the default baudrate and waits for hello.
+baudchk:btss	WCMD,	#2
+		bra		bladdrchk
+		SendL	OK
+baudtx:	btss	USTA, #TRMT			;let OK out at the old baudrate
+		bra		baudtx
+		mov 	#buffer, WBUFPTR
+		ze		[WBUFPTR], W0
+		mov		W0, UBRG
+		rcall 	Receive
+		sub 	#HELLO, W0			;check
+		bra 	z, Main
+		bra		init
 		
 	
 
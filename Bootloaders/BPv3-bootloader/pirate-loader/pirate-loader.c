@@ -2,9 +2,12 @@
  
  Pirate-Loader for Bootloader v4
  
- Version  : 1.0.2
+ Version  : 1.1.0
  
  Changelog:
+ +2026-10-14 - Raises the link speed after hello on bootloaders 1.0.3+ ( --baud ),
+               falling back to 115200 if that does not work
+ 
  +2010-06-28 - Made HEX parser case-insensative
  
   + 2010-02-04 - Changed polling interval to 10ms on Windows select wrapper, suggested by Michal (robots)
@@ -42,7 +45,7 @@
 #include <fcntl.h>
 #include <errno.h>
 
-#define PIRATE_LOADER_VERSION "1.0.2"
+#define PIRATE_LOADER_VERSION "1.1.0"
 
 #define STR_EXPAND(tok) #tok
 #define OS_NAME(tok) STR_EXPAND(tok)
@@ -55,6 +58,8 @@
 	#define O_NOCTTY 0
 	#define O_NDELAY 0
 	#define B115200 115200
+	#define B500000 500000
+	#define B1000000 1000000
 
 	#define OS WINDOWS
 	
@@ -187,17 +192,40 @@
 #define LENGTH_OFFSET 4
 #define COMMAND_OFFSET 3
 
+/* bootloader 1.0.3 and later switch U1BRG on command 0x04 */
+#define BOOTLOADER_BAUD_COMMAND 0x04
+#define BOOTLOADER_BAUD_VERSION 0x0103
+#define DEFAULT_BAUD 115200
+
 /* type definitions */
 
 typedef unsigned char  uint8;
 typedef unsigned short uint16;
 typedef unsigned long  uint32;
 
+typedef struct {
+	unsigned long rate;
+	unsigned long port_speed; // for configurePort
+	uint8 brg;                // U1BRG with BRGH set, FCY / (4 * rate) - 1
+} link_speed;
+
+/* rates both the FT232 and the PIC hit exactly */
+static const link_speed LINK_SPEEDS[] = {
+#ifdef B1000000
+	{ 1000000, B1000000, 3 },
+#endif
+#ifdef B500000
+	{  500000, B500000,  7 },
+#endif
+	{ DEFAULT_BAUD, B115200, 34 } // what the bootloader starts at, last
+};
+
 /* global settings, command line arguments */
 
 uint8		g_verbose = 0;
 uint8		g_hello_only = 0;
 uint8		g_simulate = 0;
+unsigned long g_baud = 0; // 0 is the first of LINK_SPEEDS
 const char* g_device_path  = NULL;
 const char* g_hexfile_path = NULL;
 
@@ -577,6 +605,73 @@ int openPort(const char* dev, unsigned long flags)
 	return open(dev, O_RDWR | O_NOCTTY | O_NDELAY | flags);
 }
 
+int sayHello(int fd, uint8* reply)
+{
+	int res = 0;
+
+	res = write(fd, BOOTLOADER_HELLO_STR, 1);
+	if( res != 1 ) {
+		return -1;
+	}
+
+	res = readWithTimeout(fd, reply, 4, 3);
+	if( res != 4 || reply[3] != BOOTLOADER_OK ) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* moves the link to g_baud, or back to DEFAULT_BAUD if the new speed fails */
+int raiseLinkSpeed(int fd)
+{
+	const link_speed* speed = NULL;
+	uint8  command[HEADER_LENGTH + 2] = {0};
+	uint8  reply[4] = {0};
+	int    i = 0;
+
+	for( i=0; i<(sizeof(LINK_SPEEDS) / sizeof(LINK_SPEEDS[0])) - 1; i++ ) {
+		if( LINK_SPEEDS[i].rate == g_baud ) {
+			speed = &LINK_SPEEDS[i];
+		}
+	}
+	if( speed == NULL ) {
+		return 0;
+	}
+
+	printf("Switching to %ld baud...", speed->rate);
+
+	command[COMMAND_OFFSET] = BOOTLOADER_BAUD_COMMAND;
+	command[LENGTH_OFFSET ] = 0x02; //BRG + CRC
+	command[PAYLOAD_OFFSET] = speed->brg;
+	command[PAYLOAD_OFFSET + 1] = makeCrc(command, HEADER_LENGTH + 1);
+
+	if( write(fd, command, sizeof(command)) != sizeof(command) ||
+		readWithTimeout(fd, reply, 1, 3) != 1 || reply[0] != BOOTLOADER_OK ) {
+		puts("ERROR");
+		return -1;
+	}
+
+	//confirm with a hello at the new speed, answered by OK alone
+	if( configurePort(fd, speed->port_speed) >= 0 &&
+		write(fd, BOOTLOADER_HELLO_STR, 1) == 1 &&
+		readWithTimeout(fd, reply, 1, 1) == 1 && reply[0] == BOOTLOADER_OK ) {
+		puts("OK");
+		return 0;
+	}
+
+	//the bootloader goes back to the default speed on its own
+	printf("no answer, staying at %d baud...", DEFAULT_BAUD);
+	sleep(1);
+	configurePort(fd, B115200); //also drops anything garbled meanwhile
+	if( sayHello(fd, reply) < 0 ) {
+		puts("ERROR");
+		return -1;
+	}
+	puts("OK");
+	return 0;
+}
+
 int parseCommandLine(int argc, const char** argv)
 {
 	int i = 0;
@@ -594,6 +689,8 @@ int parseCommandLine(int argc, const char** argv)
 			g_hello_only = 1;
 		} else if ( !strcmp(argv[i], "--simulate") ) {
 			g_simulate = 1;
+		} else if ( !strncmp(argv[i], "--baud=", 7) ) {
+			g_baud = strtoul(argv[i] + 7, NULL, 10);
 		} else if ( !strcmp(argv[i], "--help") ) {
 			argc = 1; //that's not pretty, but it works :)
 			break;
@@ -608,9 +705,16 @@ int parseCommandLine(int argc, const char** argv)
 		//print usage
 		puts("pirate-loader usage:\n");
 		puts(" ./pirate-loader --dev=/path/to/device --hello");
-		puts(" ./pirate-loader --dev=/path/to/device --hex=/path/to/hexfile.hex [ --verbose ]");
+		puts(" ./pirate-loader --dev=/path/to/device --hex=/path/to/hexfile.hex [ --verbose ] [ --baud=N ]");
 		puts(" ./pirate-loader --simulate --hex=/path/to/hexfile.hex [ --verbose ]");
 		puts("");
+		printf(" --baud=N sets the programming speed,");
+		for( i=0; i<sizeof(LINK_SPEEDS) / sizeof(LINK_SPEEDS[0]); i++ ) {
+			printf(" %ld", LINK_SPEEDS[i].rate);
+		}
+		printf(" (default %ld)\n", LINK_SPEEDS[0].rate);
+		puts("          it needs bootloader 1.0.3 or later, others stay at 115200");
+		puts("");
 		
 		return 0;
 	}
@@ -669,6 +773,19 @@ int main (int argc, const char** argv)
 		fixJumps(bin_buff, pages_used);
 	}
 	
+	if( g_baud == 0 ) {
+		g_baud = LINK_SPEEDS[0].rate;
+	}
+	for( res=0; res<sizeof(LINK_SPEEDS) / sizeof(LINK_SPEEDS[0]); res++ ) {
+		if( LINK_SPEEDS[res].rate == g_baud ) {
+			break;
+		}
+	}
+	if( res == sizeof(LINK_SPEEDS) / sizeof(LINK_SPEEDS[0]) ) {
+		fprintf(stderr, "Unsupported speed %ld, please use pirate-loader --help for the list\n", g_baud);
+		goto Error;
+	}
+
 	if( g_simulate ) {
 		sendFirmware(dev_fd, bin_buff, pages_used);
 		goto Finished;
@@ -702,13 +819,11 @@ int main (int argc, const char** argv)
 	printf("Sending Hello to the Bootloader...");
 	
 	//send HELLO
-	res = write(dev_fd, BOOTLOADER_HELLO_STR, 1);
-	
-	res = readWithTimeout(dev_fd, buffer, 4, 3);
+	res = sayHello(dev_fd, buffer);
 	
-	if( res != 4 || buffer[3] != BOOTLOADER_OK ) {
+	if( res < 0 ) {
 		puts("ERROR");
-		fprintf(stderr, "No reply from the bootloader, or invalid reply received: %d\n", res);
+		fprintf(stderr, "No reply from the bootloader, or invalid reply received\n");
 		fprintf(stderr, "Please make sure that PGND and PGC are connected, replug the device and try again\n");
 		goto Error;
 	}
@@ -724,6 +839,11 @@ int main (int argc, const char** argv)
 	
 	if( !g_hello_only ) {
 	
+		if( ((buffer[1] << 8) | buffer[2]) >= BOOTLOADER_BAUD_VERSION && raiseLinkSpeed(dev_fd) < 0 ) {
+			fprintf(stderr, "Lost the bootloader while changing speed, replug the device and try again\n");
+			goto Error;
+		}
+	
 		res = sendFirmware(dev_fd, bin_buff, pages_used);
 		
 		if( res > 0 ) {
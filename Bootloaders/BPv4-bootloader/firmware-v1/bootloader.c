@@ -7,6 +7,7 @@ void usbbufservice(void);
 void bootloader(void);
 void usb_handler(void);
 void WritePage(void);
+void PageCRC(void);
 void __builtin_write_NVM(void);
 void __builtin_tblwtl(unsigned int offset, unsigned int data);
 void __builtin_tblwth(unsigned int offset, unsigned int data);
@@ -22,7 +23,7 @@ BYTE bldone = 0;
 extern BYTE cdc_In_buffer[64];
 extern BYTE cdc_Out_buffer[64];
 #define VER_H 0x04
-#define VER_L 0x0a
+#define VER_L 0x0b
 
 unsigned int userversion  __attribute__((space(prog),address(BLENDADDR-9))) = ((VER_H<<8)|VER_L); 
 
@@ -38,6 +39,8 @@ struct _bootstruct {
     BYTE datasize;
     BYTE checksum;
     BYTE data[64 * 3];
+    BYTE replysize; //extra reply bytes sent after blreturn
+    BYTE reply[2];
 
 } bootstruct;
 
@@ -52,6 +55,7 @@ void bootloader(void) {
 	BYTE crc;
 
     bootstruct.enableerase = 0;
+    bootstruct.replysize = 0;
 
     do {
         do {
@@ -77,7 +81,11 @@ error:
         	usb_handler();
         	WaitInReady();
             cdc_In_buffer[0] = bootstruct.blreturn; //answer OK
-            putUnsignedCharArrayUsbUsart(cdc_In_buffer, 1);
+            for (i = 0; i < bootstruct.replysize; i++) {
+                cdc_In_buffer[1 + i] = bootstruct.reply[i];
+            }
+            putUnsignedCharArrayUsbUsart(cdc_In_buffer, 1 + bootstruct.replysize);
+            bootstruct.replysize = 0;
 			
 			crc=0;
 
@@ -125,9 +133,13 @@ error:
 	        switch (bootstruct.cmd) {
 	            case 1: // enable erase, actual erase is before the next write
 	                bootstruct.enableerase = 1;        
+	                bootstruct.blreturn = 'K';
 	                break;
 	            case 2: //protect the bootloader and write the row
 	                WritePage();
+	                break;
+	            case 3: //CRC of the page, so unchanged pages can be skipped
+	                PageCRC();
 	                break;
 				case 0xff:
 					 U1CONbits.USBEN=0; //USB off
@@ -257,3 +269,31 @@ void WritePage() {
     }
 }
 
+// CRC-16-CCITT (0x1021, starting from 0xFFFF) of the erase page at fulladdress,
+// over the same three bytes per word, in the same order, as a row write.
+void PageCRC() {
+    unsigned int offset;
+    unsigned int crc = 0xFFFF;
+    unsigned int word;
+    BYTE bytes[3];
+    BYTE i, bit;
+
+    offset = (unsigned int) fulladdress;
+    for (word = 0; word < (PAGESIZER * ROWSIZEW); word++) {
+        bytes[0] = (BYTE) __builtin_tblrdh(offset);
+        bytes[1] = (BYTE) __builtin_tblrdl(offset);
+        bytes[2] = (BYTE) (__builtin_tblrdl(offset) >> 8);
+        for (i = 0; i < 3; i++) {
+            crc ^= ((unsigned int) bytes[i]) << 8;
+            for (bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+            }
+        }
+        offset += 2;
+    }
+
+    bootstruct.reply[0] = (BYTE) (crc >> 8);
+    bootstruct.reply[1] = (BYTE) crc;
+    bootstruct.replysize = 2;
+    bootstruct.blreturn = 'K';
+}
@@ -2,10 +2,22 @@
 
  Pirate-Loader for Bootloader v4
 
- Version  : 1.0.3
+ Version  : 1.4.0
 
  Changelog:
 
+  + 2026-10-14 - Can save the parsed HEX file as an image ( --save-image ) and
+                 flash from it ( --image ), which is mapped instead of parsed.
+
+  + 2026-10-14 - Updates several devices at once, --dev takes a comma separated
+                 list and wildcards. The HEX file is parsed once.
+
+  + 2026-10-14 - Pages whose CRC already matches the image are not rewritten,
+                 with bootloaders that support it ( --full writes them all ).
+
+  + 2026-10-14 - Keeps several commands in flight instead of waiting for each
+                 reply ( --window ), progress is shown per page.
+
   + 2016-08-22 - Migrated to CMake, minor fixes.
 
   + 2010-06-28 - Made HEX parser case-insensitive
@@ -57,7 +69,7 @@
 #include <fcntl.h>
 #include <errno.h>
 
-#define PIRATE_LOADER_VERSION "1.0.3"
+#define PIRATE_LOADER_VERSION "1.4.0"
 
 #define STR_EXPAND(tok) #tok
 #define OS_NAME(tok) STR_EXPAND(tok)
@@ -182,6 +194,10 @@ unsigned int sleep(unsigned int sec)
 #include <sys/select.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glob.h>
 #endif
 
 /* macro definitions */
@@ -199,6 +215,8 @@ typedef unsigned long  uint32;
 #define BOOTLOADER_HELLO_STR "\xC1"
 #define BOOTLOADER_OK 0x4B
 #define BOOTLOADER_PROT 'P'
+#define BOOTLOADER_UNKNOWN 'U'
+#define PAGE_CRC_LENGTH 2
 #define PIC_WORD_SIZE  (3)
 #define PIC_NUM_ROWS_IN_PAGE  8
 #define PIC_NUM_WORDS_IN_ROW 64
@@ -215,6 +233,26 @@ typedef unsigned long  uint32;
 #define IS_24FJ 1
 #define PIC_NUM_PAGES 512
 
+/* The bootloader answers each command in order, once it is done with it, and
+   USB flow control holds back whatever it has not read yet.  Commands can then
+   be sent ahead of the replies, so the link never sits idle waiting. */
+#define PIPELINE_DEFAULT_WINDOW 8
+#define PIPELINE_MAX_WINDOW 32
+
+/* devices updated in one run, and how much of each one's output is shown */
+#define MAX_DEVICES 32
+#define DEVICE_TEXT_LENGTH 56
+#define DEVICE_RUNNING 1
+
+/* pre-parsed image file, --save-image / --image. Numbers are big endian:
+   magic, format, 3 unused bytes, words found in the HEX file (4 bytes),
+   pages_used, page CRCs (2 bytes each), then the flat flash image */
+#define IMAGE_MAGIC "BPLI"
+#define IMAGE_FORMAT 1
+#define IMAGE_DATA_SIZE (PIC_NUM_PAGES * PIC_PAGE_SIZE)
+#define IMAGE_HEADER_SIZE (4 + 4 + 4 + PIC_NUM_PAGES + PIC_NUM_PAGES * PAGE_CRC_LENGTH)
+#define IMAGE_FILE_SIZE (IMAGE_HEADER_SIZE + IMAGE_DATA_SIZE)
+
 //#define flashsize 0x2AC00 //was 0xac00
 //#define PIC_NUM_PAGES 512
 
@@ -231,8 +269,67 @@ unsigned long blendaddr = 0x23FFL; // not currently used
 uint8		g_verbose = 0;
 uint8		g_hello_only = 0;
 uint8		g_simulate = 0;
-const char* g_device_path  = NULL;
+uint32		g_window = PIPELINE_DEFAULT_WINDOW;
+uint8		g_full = 0;
+
+/* set when the bootloader did not know the page CRC command, it keeps
+   answering 'U' until the next row write */
+uint8		g_stale_unknown = 0;
+const char* g_device_paths[MAX_DEVICES];
+uint32		g_device_count = 0;
 const char* g_hexfile_path = NULL;
+const char* g_image_path = NULL;
+const char* g_save_image_path = NULL;
+
+/* what gets written, parsed once for all the devices */
+
+typedef struct
+{
+    uint8* data;          // PIC_PAGE_ADDR() layout, at least IMAGE_DATA_SIZE
+    uint8  pages_used[PIC_NUM_PAGES];
+    uint16 page_crcs[PIC_NUM_PAGES];
+    uint32 words;
+    uint8* file;          // the mapped image file, or NULL if data was allocated
+    uint32 file_size;
+} firmware_image;
+
+/* commands sent to the bootloader, waiting for a reply */
+
+typedef struct
+{
+    uint8  command;
+    uint32 page;
+    uint32 address;
+    uint8* reply;       // PAGE_CRC_LENGTH bytes following the status, or NULL
+    uint8* reply_valid; // set once the reply was received
+} pending_command;
+
+typedef struct
+{
+    pending_command entries[PIPELINE_MAX_WINDOW];
+    uint32 oldest;
+    uint32 count;
+} command_pipeline;
+
+/* one device being updated by a child process */
+
+typedef struct
+{
+    char   partial[DEVICE_TEXT_LENGTH]; // line being printed
+    uint32 length;
+    char   line[DEVICE_TEXT_LENGTH];    // last complete line
+} output_lines;
+
+typedef struct
+{
+    const char*  path;
+    int          result;      // DEVICE_RUNNING, 0 when updated, -1 on error
+#ifndef WIN32
+    pid_t        pid;
+    int          output[2];   // read ends of the child's stdout and stderr
+#endif
+    output_lines lines[2];
+} device_worker;
 
 /* functions */
 
@@ -468,43 +565,236 @@ uint8 makeCrc(uint8* buf, uint32 len)
     return crc;
 }
 
-int sendCommandAndWaitForResponse(int fd, uint8 *command)
+/* CRC-16-CCITT, as computed by the bootloader page CRC command */
+uint16 makeCrc16(const uint8* buf, uint32 len)
 {
-    uint8  response[4] = {0};
-    int    res = 0;
+    uint16 crc = 0xFFFF;
+    uint32 i = 0;
+    int    bit = 0;
+
+    for(i=0; i<len; i++)
+    {
+        crc ^= (uint16)(buf[i] << 8);
+        for(bit=0; bit<8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16)((crc << 1) ^ 0x1021) : (uint16)(crc << 1);
+        }
+    }
+
+    return crc;
+}
 
-    res = write(fd, command, HEADER_LENGTH + command[LENGTH_OFFSET]);
+int writeAll(int fd, const uint8* data, int length)
+{
+    int res = 0;
 
-    if( res <= 0 )
+    while( length > 0 )
     {
-        puts("ERROR");
-        return -1;
+        res = write(fd, data, length);
+
+        if( res < 0 && errno == EAGAIN )
+        {
+            /* the port is opened non-blocking, wait for the output to drain */
+            sleep(0);
+            continue;
+        }
+        else if( res <= 0 )
+        {
+            return -1;
+        }
+
+        data   += res;
+        length -= res;
     }
 
+    return 0;
+}
+
+int readResponse(int fd, const pending_command* pending)
+{
+    uint8  response[4] = {0};
+    int    res = 0;
+
     res = readWithTimeout(fd, response, 1, 5);
     if( res != 1 )
     {
-        puts("ERROR");
+        fprintf(stderr, "\nNo reply to the command for %04lx\n", pending->address);
         return -1;
     }
+    else if ( response[0] == BOOTLOADER_UNKNOWN && pending->reply )
+    {
+        //older bootloader, the page just gets written
+        g_stale_unknown = 1;
+        return 0;
+    }
+    else if ( response[0] == BOOTLOADER_UNKNOWN && g_stale_unknown && pending->command == 0x01 )
+    {
+        //the erase went through, only the answer is left over
+        g_stale_unknown = 0;
+        return 0;
+    }
     else if (response[0]== BOOTLOADER_PROT)
     {
-        printf("(SKIPPED by bootloader)...");
+        if( g_verbose )
+        {
+            printf("Page %ld, %04lx SKIPPED by bootloader\n", pending->page, pending->address);
+        }
         return 0;
-
     }
     else if ( response[0] != BOOTLOADER_OK )
     {
-        printf("ERROR [%02x]\n", response[0]);
+        fprintf(stderr, "\n%s page %ld, %04lx...ERROR [%02x]\n",
+                (pending->command == 0x01) ? "Erasing" : (pending->command == 0x03) ? "Checking" : "Writing",
+                pending->page, pending->address, response[0]);
         return -1;
     }
+    else if ( pending->reply )
+    {
+        if( readWithTimeout(fd, pending->reply, PAGE_CRC_LENGTH, 5) != PAGE_CRC_LENGTH )
+        {
+            fprintf(stderr, "\nIncomplete CRC of page %ld, %04lx\n", pending->page, pending->address);
+            return -1;
+        }
+        *pending->reply_valid = 1;
+        return 0;
+    }
     else
+    {
+        g_stale_unknown = 0;
+        return 0;
+    }
+}
+
+/* waits for the oldest reply, until at most `limit` commands are in flight */
+int drainPipeline(int fd, command_pipeline* pipeline, uint32 limit)
+{
+    while( pipeline->count > limit )
+    {
+        if( readResponse(fd, &pipeline->entries[pipeline->oldest]) < 0 )
+        {
+            return -1;
+        }
+
+        pipeline->oldest = (pipeline->oldest + 1) % PIPELINE_MAX_WINDOW;
+        pipeline->count--;
+    }
+
+    return 0;
+}
+
+int sendCommand(int fd, command_pipeline* pipeline, uint8* command, uint32 page, uint32 address,
+                uint8* reply, uint8* reply_valid)
+{
+    pending_command* pending;
+
+    if( g_verbose )
+    {
+        dumpHex(command, HEADER_LENGTH + command[LENGTH_OFFSET]);
+    }
+
+    if( g_simulate )
     {
         return 0;
     }
+
+    /* make room in the window first */
+    if( drainPipeline(fd, pipeline, g_window - 1) < 0 )
+    {
+        return -1;
+    }
+
+    if( writeAll(fd, command, HEADER_LENGTH + command[LENGTH_OFFSET]) < 0 )
+    {
+        fprintf(stderr, "\nCould not send the command for %04lx\n", address);
+        return -1;
+    }
+
+    pending = &pipeline->entries[(pipeline->oldest + pipeline->count) % PIPELINE_MAX_WINDOW];
+    pending->command = command[COMMAND_OFFSET];
+    pending->page    = page;
+    pending->address = address;
+    pending->reply = reply;
+    pending->reply_valid = reply_valid;
+    pipeline->count++;
+
+    return 0;
 }
 
 
+/* drops the pages the device already holds from pages_used */
+int skipUnchangedPages(int fd, const uint16* page_crcs, uint8* pages_used)
+{
+    uint32 u_addr;
+    uint32 page  = 0;
+    uint32 checked = 0;
+    uint32 skipped = 0;
+    uint8  command[256] = {0};
+    uint8  crcs[PIC_NUM_PAGES][PAGE_CRC_LENGTH];
+    uint8  crc_valid[PIC_NUM_PAGES] = {0};
+    command_pipeline pipeline = {{{0}}};
+
+    printf("Checking which pages changed...");
+    fflush(stdout);
+
+    for( page=0; page<PIC_NUM_PAGES; page++)
+    {
+        u_addr = page * ( PIC_NUM_WORDS_IN_ROW * 2 * PIC_NUM_ROWS_IN_PAGE );
+
+        if( pages_used[page] != 1 || u_addr >= flashsize )
+        {
+            continue;
+        }
+
+        command[0] = (u_addr & 0x00FF0000) >> 16;
+        command[1] = (u_addr & 0x0000FF00) >>  8;
+        command[2] = (u_addr & 0x000000FF) >>  0;
+        command[COMMAND_OFFSET] = 0x03; //page CRC command
+        command[LENGTH_OFFSET ] = 0x01; //1 byte, CRC
+        command[PAYLOAD_OFFSET] = makeCrc(command, 5);
+
+        if( sendCommand(fd, &pipeline, command, page, u_addr, crcs[page], &crc_valid[page]) < 0 )
+        {
+            return -1;
+        }
+
+        //see whether the bootloader knows the command before sending more
+        if( checked++ == 0 )
+        {
+            if( drainPipeline(fd, &pipeline, 0) < 0 )
+            {
+                return -1;
+            }
+            if( !crc_valid[page] )
+            {
+                puts("not supported by the bootloader");
+                return 0;
+            }
+        }
+    }
+
+    if( drainPipeline(fd, &pipeline, 0) < 0 )
+    {
+        return -1;
+    }
+
+    for( page=0; page<PIC_NUM_PAGES; page++)
+    {
+        if( crc_valid[page] &&
+            page_crcs[page] == ((crcs[page][0] << 8) | crcs[page][1]) )
+        {
+            if( g_verbose )
+            {
+                printf("\nPage %ld unchanged", page);
+            }
+            pages_used[page] = 0;
+            skipped++;
+        }
+    }
+
+    printf("%ld of %ld pages unchanged\n", skipped, checked);
+    return skipped;
+}
+
 int sendFirmware(int fd, uint8* data, uint8* pages_used)
 {
     uint32 u_addr;
@@ -513,8 +803,15 @@ int sendFirmware(int fd, uint8* data, uint8* pages_used)
     uint32 page  = 0;
     uint32 done  = 0;
     uint32 row   = 0;
+    uint32 pages_total = 0;
+    uint32 pages_sent  = 0;
     uint8  command[256] = {0};
+    command_pipeline pipeline = {{{0}}};
 
+    for( page=0; page<PIC_NUM_PAGES; page++)
+    {
+        pages_total += (pages_used[page] == 1);
+    }
 
     for( page=0; page<PIC_NUM_PAGES; page++)
     {
@@ -536,6 +833,17 @@ int sendFirmware(int fd, uint8* data, uint8* pages_used)
             return -1;
         }
 
+        pages_sent++;
+        if( g_verbose )
+        {
+            printf("Erasing and writing page %ld, %04lx\n", page, u_addr);
+        }
+        else
+        {
+            printf("\rWriting page %ld, %04lx (%ld of %ld)...", page, u_addr, pages_sent, pages_total);
+            fflush(stdout);
+        }
+
         //erase page
         command[0] = (u_addr & 0x00FF0000) >> 16;
         command[1] = (u_addr & 0x0000FF00) >>  8;
@@ -544,20 +852,11 @@ int sendFirmware(int fd, uint8* data, uint8* pages_used)
         command[LENGTH_OFFSET ] = 0x01; //1 byte, CRC
         command[PAYLOAD_OFFSET] = makeCrc(command, 5);
 
-        if( g_verbose )
-        {
-            dumpHex(command, HEADER_LENGTH + command[LENGTH_OFFSET]);
-        }
-
-        printf("Erasing page %ld, %04lx...", page, u_addr);
-
-        if( g_simulate == 0 && sendCommandAndWaitForResponse(fd, command) < 0 )
+        if( sendCommand(fd, &pipeline, command, page, u_addr, NULL, NULL) < 0 )
         {
             return -1;
         }
 
-        puts("OK");
-
         //write 8 rows
         for( row = 0; row < PIC_NUM_ROWS_IN_PAGE; row ++, u_addr += (PIC_NUM_WORDS_IN_ROW * 2))
         {
@@ -571,27 +870,30 @@ int sendFirmware(int fd, uint8* data, uint8* pages_used)
 
             command[PAYLOAD_OFFSET + PIC_ROW_SIZE] = makeCrc(command, HEADER_LENGTH + PIC_ROW_SIZE);
 
-            printf("Writing page %ld row %ld, %04lx...", page, row + page*PIC_NUM_ROWS_IN_PAGE, u_addr);
-
-            if( g_verbose )
-            {
-                dumpHex(command, HEADER_LENGTH + command[LENGTH_OFFSET]);
-            }
-
-            if( g_simulate == 0 && sendCommandAndWaitForResponse(fd, command) < 0 )
+            if( sendCommand(fd, &pipeline, command, page, u_addr, NULL, NULL) < 0 )
             {
                 return -1;
             }
 
-            puts("OK");
-
-            sleep(0);
-
-
             done += PIC_ROW_SIZE;
         }
     }
 
+    //wait for the last replies
+    if( !g_simulate && drainPipeline(fd, &pipeline, 0) < 0 )
+    {
+        return -1;
+    }
+
+    if( pages_sent == 0 )
+    {
+        puts("Nothing to write, the device already holds this firmware");
+    }
+    else if( !g_verbose )
+    {
+        puts("OK");
+    }
+
     return done;
 }
 
@@ -646,6 +948,62 @@ int openPort(const char* dev, unsigned long flags)
     return open(dev, O_RDWR | O_NOCTTY | O_NDELAY | flags);
 }
 
+int addDevice(const char* path)
+{
+    if( g_device_count == MAX_DEVICES )
+    {
+        fprintf(stderr, "At most %d devices can be updated at once\n", MAX_DEVICES);
+        return -1;
+    }
+    g_device_paths[g_device_count++] = path;
+    return 0;
+}
+
+/* --dev takes a comma separated list, entries with wildcards are expanded */
+int addDevices(const char* list)
+{
+    char* copy = strdup(list); //the paths point into it until the end
+    char* path = NULL;
+
+    if( !copy )
+    {
+        return -1;
+    }
+
+    for( path = strtok(copy, ","); path; path = strtok(NULL, ",") )
+    {
+#ifndef WIN32
+        if( strpbrk(path, "*?[") )
+        {
+            glob_t matches;
+            size_t i = 0;
+
+            if( glob(path, 0, NULL, &matches) != 0 )
+            {
+                fprintf(stderr, "No device matches %s\n", path);
+                return -1;
+            }
+            for( i=0; i<matches.gl_pathc; i++ )
+            {
+                if( addDevice(strdup(matches.gl_pathv[i])) < 0 )
+                {
+                    globfree(&matches);
+                    return -1;
+                }
+            }
+            globfree(&matches);
+            continue;
+        }
+#endif
+        if( addDevice(path) < 0 )
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 int parseCommandLine(int argc, const char** argv)
 {
     int i = 0;
@@ -657,9 +1015,20 @@ int parseCommandLine(int argc, const char** argv)
         {
             g_hexfile_path = argv[i] + 6;
         }
+        else if ( !strncmp(argv[i], "--image=", 8) )
+        {
+            g_image_path = argv[i] + 8;
+        }
+        else if ( !strncmp(argv[i], "--save-image=", 13) )
+        {
+            g_save_image_path = argv[i] + 13;
+        }
         else if ( !strncmp(argv[i], "--dev=", 6) )
         {
-            g_device_path = argv[i] + 6;
+            if( addDevices(argv[i] + 6) < 0 )
+            {
+                return -1;
+            }
         }
         else if ( !strcmp(argv[i], "--verbose") )
         {
@@ -673,6 +1042,19 @@ int parseCommandLine(int argc, const char** argv)
         {
             g_simulate = 1;
         }
+        else if ( !strcmp(argv[i], "--full") )
+        {
+            g_full = 1;
+        }
+        else if ( !strncmp(argv[i], "--window=", 9) )
+        {
+            g_window = strtoul(argv[i] + 9, NULL, 10);
+            if( g_window < 1 || g_window > PIPELINE_MAX_WINDOW )
+            {
+                fprintf(stderr, "The window must be between 1 and %d commands\n", PIPELINE_MAX_WINDOW);
+                return -1;
+            }
+        }
         else if ( !strcmp(argv[i], "--help") )
         {
             argc = 1; //that's not pretty, but it works :)
@@ -690,7 +1072,18 @@ int parseCommandLine(int argc, const char** argv)
         //print usage
         puts("pirate-loader usage:\n");
         puts(" ./pirate-loader --dev=/path/to/device --hello");
-        puts(" ./pirate-loader --dev=/path/to/device --hex=/path/to/hexfile.hex [ --verbose ]");
+        puts(" ./pirate-loader --dev=/path/to/device --hex=/path/to/hexfile.hex [ --verbose ] [ --window=N ] [ --full ]");
+        puts("");
+        puts(" --window=N keeps up to N commands in flight (1-32, default 8),");
+        puts("            --window=1 waits for each reply like older versions did");
+        puts(" --full     also rewrites the pages that did not change");
+        puts(" --dev=/dev/ttyACM0,/dev/ttyACM1 or --dev='/dev/ttyACM*' updates several");
+        puts("            devices at once, --dev can also be given more than once");
+        puts(" ./pirate-loader --hex=/path/to/hexfile.hex --save-image=/path/to/image.bpli");
+        puts(" ./pirate-loader --dev=/path/to/device --image=/path/to/image.bpli [ ... ]");
+        puts("");
+        puts(" an image holds the parsed HEX file and its page CRCs, it is mapped as is");
+        puts(" instead of being parsed again, e.g. for many devices in turn");
         puts(" ./pirate-loader --simulate --hex=/path/to/hexfile.hex [ --verbose ] ");
         puts("");
 
@@ -700,97 +1093,38 @@ int parseCommandLine(int argc, const char** argv)
     return 1;
 }
 
-/* entry point */
-
-int main (int argc, const char** argv)
+/* opens one device, identifies it and updates it, 0 on success */
+int updateDevice(const char* path, const firmware_image* image)
 {
     int		dev_fd = -1, res = -1;
     uint8	buffer[256] = {0};
-    uint8	pages_used[PIC_NUM_PAGES] = {0};
-    uint8*	bin_buff = NULL;
+    uint8	pages_used[PIC_NUM_PAGES];
 
+    //skipUnchangedPages() edits the list, keep the image's for the next device
+    memcpy(pages_used, image->pages_used, sizeof(pages_used));
+    g_stale_unknown = 0;
 
-    puts("+++++++++++++++++++++++++++++++++++++++++++");
-    puts("  Pirate-Loader for BP with Bootloader v4+  ");
-    puts("  Loader version: " PIRATE_LOADER_VERSION "  OS: " OS_NAME(OS));
-    puts("+++++++++++++++++++++++++++++++++++++++++++\n");
+    printf("Opening serial device %s...", path);
 
-    if( (res = parseCommandLine(argc, argv)) < 0 )
+    dev_fd = openPort(path, 0);
+
+    if( dev_fd < 0 )
     {
-        return -1;
+        puts("ERROR");
+        fprintf(stderr, "Could not open %s\n", path);
+        goto Error;
     }
-    else if( res == 0 )
+    puts("OK");
+
+    printf("Configuring serial port settings...");
+
+    if( configurePort(dev_fd, B115200) < 0 )
     {
-        return 0;
+        puts("ERROR");
+        fprintf(stderr, "Could not configure device, errno=%d\n", errno);
+        goto Error;
     }
-
-    if( !g_hello_only )
-    {
-
-        if( !g_hexfile_path )
-        {
-            fprintf(stderr, "Please specify hexfile path --hex=/path/to/hexfile.hex\n");
-            return -1;
-        }
-
-        bin_buff = (uint8*)malloc(0xFFFFFF * sizeof(uint8)); //256kB
-        if( !bin_buff )
-        {
-            fprintf(stderr, "Could not allocate 256kB buffer\n");
-            goto Error;
-        }
-
-        //fill the buffer with 0xFF
-        memset(bin_buff, 0xFFFFFFFF, (0xFFFFFF * sizeof(uint8)));
-
-        printf("Parsing HEX file [%s]\n", g_hexfile_path);
-
-        res = readHEX(g_hexfile_path, bin_buff, (0xFFFFFF * sizeof(uint8)), pages_used);
-        if( res <= 0 || res > flashsize )
-        {
-            fprintf(stderr, "Could not load HEX file, result=%d\n", res);
-            goto Error;
-        }
-
-        printf("Found %d words (%d bytes)\n", res, res * 3);
-
-        //printf("Fixing bootloader/userprogram jumps\n");
-        //fixJumps(bin_buff, pages_used);
-    }
-
-    if( g_simulate )
-    {
-        sendFirmware(dev_fd, bin_buff, pages_used);
-        goto Finished;
-    }
-
-    if( !g_device_path )
-    {
-        fprintf(stderr, "Please specify serial device path --dev=/dev/...\n");
-        return -1;
-    }
-
-    printf("Opening serial device %s...", g_device_path);
-
-    dev_fd = openPort(g_device_path, 0);
-
-    if( dev_fd < 0 )
-    {
-        puts("ERROR");
-        fprintf(stderr, "Could not open %s\n", g_device_path);
-        goto Error;
-    }
-    puts("OK");
-
-    printf("Configuring serial port settings...");
-
-    if( configurePort(dev_fd, B115200) < 0 )
-    {
-        puts("ERROR");
-        fprintf(stderr, "Could not configure device, errno=%d\n", errno);
-        goto Error;
-    }
-    puts("OK");
+    puts("OK");
 
     printf("Sending Hello to the Bootloader...");
 
@@ -1231,12 +1565,18 @@ int main (int argc, const char** argv)
     if( !g_hello_only )
     {
 
-        res = sendFirmware(dev_fd, bin_buff, pages_used);
+        if( !g_full && skipUnchangedPages(dev_fd, image->page_crcs, pages_used) < 0 )
+        {
+            puts("\nError updating firmware :(");
+            goto Error;
+        }
+
+        res = sendFirmware(dev_fd, image->data, pages_used);
 
-        if( res > 0 )
+        if( res >= 0 )
         {
             puts("\nFirmware updated successfully :)!");
-            //printf("Use screen %s 115200 to verify\n", g_device_path);
+            //printf("Use screen %s 115200 to verify\n", path);
         }
         else
         {
@@ -1246,25 +1586,499 @@ int main (int argc, const char** argv)
 
     }
 
-Finished:
-    if( bin_buff )
-    {
-        free( bin_buff );
-    }
+    close(dev_fd);
+    return 0;
+
+Error:
     if( dev_fd >= 0 )
     {
         close(dev_fd);
     }
+    return -1;
+}
+
+void putBigEndian(uint8* out, uint32 value, int length)
+{
+    while( length-- > 0 )
+    {
+        out[length] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+uint32 getBigEndian(const uint8* in, int length)
+{
+    uint32 value = 0;
+
+    while( length-- > 0 )
+    {
+        value = (value << 8) | *in++;
+    }
+    return value;
+}
+
+/* parses a HEX file into image, the page CRCs included */
+int parseImage(const char* path, firmware_image* image)
+{
+    int    res = 0;
+    uint32 page = 0;
+
+    memset(image, 0, sizeof(*image));
+
+    image->data = (uint8*)malloc(0xFFFFFF * sizeof(uint8)); //256kB
+    if( !image->data )
+    {
+        fprintf(stderr, "Could not allocate 256kB buffer\n");
+        return -1;
+    }
+
+    //fill the buffer with 0xFF
+    memset(image->data, 0xFFFFFFFF, (0xFFFFFF * sizeof(uint8)));
+
+    printf("Parsing HEX file [%s]\n", path);
+
+    res = readHEX(path, image->data, (0xFFFFFF * sizeof(uint8)), image->pages_used);
+    if( res <= 0 || res > flashsize )
+    {
+        fprintf(stderr, "Could not load HEX file, result=%d\n", res);
+        return -1;
+    }
+    image->words = res;
+
+    for( page=0; page<PIC_NUM_PAGES; page++ )
+    {
+        image->page_crcs[page] = makeCrc16(&image->data[PIC_PAGE_ADDR(page)], PIC_PAGE_SIZE);
+    }
+
+    //printf("Fixing bootloader/userprogram jumps\n");
+    //fixJumps(image->data, image->pages_used);
+
     return 0;
+}
 
-Error:
-    if( bin_buff )
+int saveImage(const char* path, const firmware_image* image)
+{
+    uint8  header[IMAGE_HEADER_SIZE] = {0};
+    uint8* crcs = &header[12 + PIC_NUM_PAGES];
+    uint32 page = 0;
+    FILE*  fp = NULL;
+    int    res = 0;
+
+    memcpy(header, IMAGE_MAGIC, 4);
+    header[4] = IMAGE_FORMAT;
+    putBigEndian(&header[8], image->words, 4);
+    memcpy(&header[12], image->pages_used, PIC_NUM_PAGES);
+    for( page=0; page<PIC_NUM_PAGES; page++ )
     {
-        free( bin_buff );
+        putBigEndian(&crcs[page * PAGE_CRC_LENGTH], image->page_crcs[page], PAGE_CRC_LENGTH);
     }
-    if( dev_fd >= 0 )
+
+    printf("Saving image [%s]...", path);
+
+    fp = fopen(path, "wb");
+    if( !fp )
     {
-        close(dev_fd);
+        puts("ERROR");
+        fprintf(stderr, "Could not create %s\n", path);
+        return -1;
+    }
+
+    res = fwrite(header, sizeof(header), 1, fp) == 1 &&
+          fwrite(image->data, IMAGE_DATA_SIZE, 1, fp) == 1;
+    res = (fclose(fp) == 0) && res;
+    if( !res )
+    {
+        puts("ERROR");
+        fprintf(stderr, "Could not write %s\n", path);
+        return -1;
+    }
+
+    puts("OK");
+    return 0;
+}
+
+/* maps an image saved by saveImage(), the Windows build reads it */
+int loadImage(const char* path, firmware_image* image)
+{
+    uint8* file = NULL;
+    uint32 page = 0;
+#ifdef WIN32
+    FILE*  fp = NULL;
+#else
+    struct stat st;
+    int    fd = -1;
+#endif
+
+    memset(image, 0, sizeof(*image));
+
+    printf("Loading image [%s]\n", path);
+
+#ifdef WIN32
+    fp = fopen(path, "rb");
+    file = (uint8*)malloc(IMAGE_FILE_SIZE + 1);
+    if( !fp || !file || fread(file, 1, IMAGE_FILE_SIZE + 1, fp) != IMAGE_FILE_SIZE )
+    {
+        fprintf(stderr, "Could not read %s, or it is not an image\n", path);
+        if( fp )
+        {
+            fclose(fp);
+        }
+        free(file);
+        return -1;
+    }
+    fclose(fp);
+#else
+    fd = open(path, O_RDONLY);
+    if( fd < 0 || fstat(fd, &st) < 0 || st.st_size != IMAGE_FILE_SIZE )
+    {
+        fprintf(stderr, "Could not open %s, or it is not an image\n", path);
+        if( fd >= 0 )
+        {
+            close(fd);
+        }
+        return -1;
+    }
+
+    file = (uint8*)mmap(NULL, IMAGE_FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( file == (uint8*)MAP_FAILED )
+    {
+        fprintf(stderr, "Could not map %s, errno=%d\n", path, errno);
+        return -1;
+    }
+#endif
+
+    image->file = file;
+    image->file_size = IMAGE_FILE_SIZE;
+
+    if( memcmp(file, IMAGE_MAGIC, 4) || file[4] != IMAGE_FORMAT )
+    {
+        fprintf(stderr, "%s is not an image of this pirate-loader version\n", path);
+        return -1;
+    }
+
+    image->words = getBigEndian(&file[8], 4);
+    memcpy(image->pages_used, &file[12], PIC_NUM_PAGES);
+    for( page=0; page<PIC_NUM_PAGES; page++ )
+    {
+        image->page_crcs[page] = getBigEndian(&file[12 + PIC_NUM_PAGES + page * PAGE_CRC_LENGTH], PAGE_CRC_LENGTH);
+    }
+    image->data = &file[IMAGE_HEADER_SIZE]; //not written to, sendFirmware() copies rows out
+
+    if( image->words == 0 || image->words > flashsize )
+    {
+        fprintf(stderr, "%s holds no usable firmware\n", path);
+        return -1;
     }
+
+    return 0;
+}
+
+void releaseImage(firmware_image* image)
+{
+    if( image->file )
+    {
+#ifdef WIN32
+        free(image->file);
+#else
+        munmap(image->file, image->file_size);
+#endif
+    }
+    else if( image->data )
+    {
+        free(image->data);
+    }
+    image->file = image->data = NULL;
+}
+
+/* keeps what a child prints, progress lines end with \r. Errors span
+   several lines, the first one says what went wrong */
+void collectOutput(output_lines* lines, const char* data, int length, uint8 keep_first)
+{
+    int i = 0;
+
+    for( i=0; i<length; i++ )
+    {
+        if( data[i] == '\r' || data[i] == '\n' )
+        {
+            if( lines->length > 0 && !(keep_first && lines->line[0]) )
+            {
+                memcpy(lines->line, lines->partial, lines->length + 1);
+            }
+            lines->length = 0;
+            lines->partial[0] = 0;
+        }
+        else if( lines->length < DEVICE_TEXT_LENGTH - 1 )
+        {
+            lines->partial[lines->length++] = data[i];
+            lines->partial[lines->length] = 0;
+        }
+    }
+}
+
+void printDevices(const device_worker* workers, uint32 count, const char* clear)
+{
+    const device_worker* worker = NULL;
+    const char* text = NULL;
+    uint32 i = 0;
+
+    for( i=0; i<count; i++ )
+    {
+        worker = &workers[i];
+        if( worker->result == DEVICE_RUNNING )
+        {
+            text = worker->lines[0].length ? worker->lines[0].partial : worker->lines[0].line;
+        }
+        else if( worker->result < 0 && worker->lines[1].line[0] )
+        {
+            text = worker->lines[1].line;
+        }
+        else
+        {
+            text = worker->lines[0].line;
+        }
+        printf("%s%-20s %-8s %s\n", clear, worker->path,
+            worker->result == DEVICE_RUNNING ? "..." : (worker->result == 0 ? "OK" : "FAILED"), text);
+    }
+    fflush(stdout);
+}
+
+/* updates all the devices, each one from its own process on POSIX systems */
+int updateDevices(const firmware_image* image)
+{
+    device_worker workers[MAX_DEVICES];
+    uint32 i = 0;
+    uint32 failed = 0;
+#ifndef WIN32
+    char   chunk[256];
+    fd_set fds;
+    uint32 running = 0;
+    int    s = 0, n = 0, max_fd = 0, status = 0;
+    int    pipes[2][2];
+    int    tty = isatty(STDOUT_FILENO);
+#endif
+
+    memset(workers, 0, sizeof(workers));
+
+#ifdef WIN32
+    //no fork() here, one after the other
+    for( i=0; i<g_device_count; i++ )
+    {
+        workers[i].path = g_device_paths[i];
+        printf("\n[%s]\n", workers[i].path);
+        workers[i].result = updateDevice(workers[i].path, image);
+    }
+#else
+    fflush(stdout);
+    fflush(stderr);
+
+    for( i=0; i<g_device_count; i++ )
+    {
+        workers[i].path = g_device_paths[i];
+        workers[i].result = DEVICE_RUNNING;
+        workers[i].output[0] = workers[i].output[1] = -1;
+
+        if( pipe(pipes[0]) < 0 || pipe(pipes[1]) < 0 || (workers[i].pid = fork()) < 0 )
+        {
+            fprintf(stderr, "Could not start updating %s, errno=%d\n", workers[i].path, errno);
+            strcpy(workers[i].lines[1].line, "not started");
+            workers[i].result = -1;
+            continue;
+        }
+
+        if( workers[i].pid == 0 )
+        {
+            dup2(pipes[0][1], STDOUT_FILENO);
+            dup2(pipes[1][1], STDERR_FILENO);
+            for( s=0; s<2; s++ )
+            {
+                close(pipes[s][0]);
+                close(pipes[s][1]);
+            }
+            setvbuf(stdout, NULL, _IONBF, 0);
+            exit(updateDevice(workers[i].path, image) < 0 ? 1 : 0);
+        }
+
+        for( s=0; s<2; s++ )
+        {
+            close(pipes[s][1]);
+            workers[i].output[s] = pipes[s][0];
+        }
+        running++;
+    }
+
+    if( tty )
+    {
+        printDevices(workers, g_device_count, "\033[K");
+    }
+
+    while( running > 0 )
+    {
+        FD_ZERO(&fds);
+        max_fd = 0;
+        for( i=0; i<g_device_count; i++ )
+        {
+            for( s=0; s<2; s++ )
+            {
+                if( workers[i].output[s] >= 0 )
+                {
+                    FD_SET(workers[i].output[s], &fds);
+                    max_fd = workers[i].output[s] > max_fd ? workers[i].output[s] : max_fd;
+                }
+            }
+        }
+
+        if( select(max_fd + 1, &fds, NULL, NULL, NULL) < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            fprintf(stderr, "Lost track of the devices, errno=%d\n", errno);
+            return -1;
+        }
+
+        for( i=0; i<g_device_count; i++ )
+        {
+            for( s=0; s<2; s++ )
+            {
+                if( workers[i].output[s] < 0 || !FD_ISSET(workers[i].output[s], &fds) )
+                {
+                    continue;
+                }
+
+                n = read(workers[i].output[s], chunk, sizeof(chunk));
+                if( n > 0 )
+                {
+                    collectOutput(&workers[i].lines[s], chunk, n, s == 1);
+                    continue;
+                }
+
+                close(workers[i].output[s]);
+                workers[i].output[s] = -1;
+                collectOutput(&workers[i].lines[s], "\n", 1, s == 1);
+                if( workers[i].output[!s] < 0 )
+                {
+                    waitpid(workers[i].pid, &status, 0);
+                    workers[i].result = (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+                    running--;
+                }
+            }
+        }
+
+        if( tty )
+        {
+            printf("\033[%ldA", g_device_count);
+            printDevices(workers, g_device_count, "\033[K");
+        }
+    }
+#endif
+
+    for( i=0; i<g_device_count; i++ )
+    {
+        failed += (workers[i].result != 0);
+    }
+
+#ifndef WIN32
+    if( !tty )
+#endif
+    {
+        puts("");
+        printDevices(workers, g_device_count, "");
+    }
+    printf("\n%ld of %ld devices updated\n", g_device_count - failed, g_device_count);
+
+    return failed ? -1 : 0;
+}
+
+/* entry point */
+
+int main (int argc, const char** argv)
+{
+    int		res = -1;
+    firmware_image image = {0};
+
+
+    puts("+++++++++++++++++++++++++++++++++++++++++++");
+    puts("  Pirate-Loader for BP with Bootloader v4+  ");
+    puts("  Loader version: " PIRATE_LOADER_VERSION "  OS: " OS_NAME(OS));
+    puts("+++++++++++++++++++++++++++++++++++++++++++\n");
+
+    if( (res = parseCommandLine(argc, argv)) < 0 )
+    {
+        return -1;
+    }
+    else if( res == 0 )
+    {
+        return 0;
+    }
+
+    if( !g_hello_only )
+    {
+
+        if( g_image_path )
+        {
+            res = loadImage(g_image_path, &image);
+        }
+        else if( g_hexfile_path )
+        {
+            res = parseImage(g_hexfile_path, &image);
+        }
+        else
+        {
+            fprintf(stderr, "Please specify hexfile path --hex=/path/to/hexfile.hex\n");
+            return -1;
+        }
+        if( res < 0 )
+        {
+            goto Error;
+        }
+
+        printf("Found %ld words (%ld bytes)\n", image.words, image.words * 3);
+
+        if( g_save_image_path )
+        {
+            if( saveImage(g_save_image_path, &image) < 0 )
+            {
+                goto Error;
+            }
+            if( g_device_count == 0 && !g_simulate )
+            {
+                goto Finished;
+            }
+        }
+    }
+
+    if( g_simulate )
+    {
+        sendFirmware(-1, image.data, image.pages_used);
+        goto Finished;
+    }
+
+    if( g_device_count == 0 )
+    {
+        fprintf(stderr, "Please specify serial device path --dev=/dev/...\n");
+        goto Error;
+    }
+
+    if( g_device_count == 1 )
+    {
+        res = updateDevice(g_device_paths[0], &image);
+    }
+    else
+    {
+        res = updateDevices(&image);
+    }
+    if( res < 0 )
+    {
+        goto Error;
+    }
+
+Finished:
+    releaseImage(&image);
+    return 0;
+
+Error:
+    releaseImage(&image);
     return -1;
 }
@@ -5,17 +5,44 @@
 //
 #include "base.h"
 
+//receive ring buffer, filled from the RX interrupt so bytes keep coming in
+//while the main loop is busy talking to the target. Big enough for a whole
+//STK500v2 packet, the host never sends more before it gets an answer.
+#define UART1_RX_BUFFER_SIZE 512 //must be a power of two
+static volatile unsigned char rx_buffer[UART1_RX_BUFFER_SIZE];
+static volatile unsigned int rx_head=0;
+static volatile unsigned int rx_tail=0;
+
+void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void){
+	unsigned int next;
+
+	while(U1STAbits.URXDA){
+		next=(rx_head+1)&(UART1_RX_BUFFER_SIZE-1);
+		if(next!=rx_tail){
+			rx_buffer[rx_head]=U1RXREG;
+			rx_head=next;
+		}else{
+			(void)U1RXREG; //buffer full, drop it
+		}
+	}
+	if(U1STAbits.OERR) U1STAbits.OERR=0;
+	IFS0bits.U1RXIF=0;
+}
+
 //is data available in RX buffer?
 //#define UART1RXRdy() U1STAbits.URXDA
 unsigned char UART1RXRdy(void){
-    return U1STAbits.URXDA;
+    return (rx_head!=rx_tail);
 }
 
 //get a byte from UART
 unsigned char UART1RX(void){
+	unsigned char c;
 
-    while(U1STAbits.URXDA == 0);
-	return U1RXREG;
+	while(rx_head==rx_tail);
+	c=rx_buffer[rx_tail];
+	rx_tail=(rx_tail+1)&(UART1_RX_BUFFER_SIZE-1);
+	return c;
 }
 
 //add byte to buffer, pause if full
@@ -35,5 +62,6 @@ void InitializeUART1(void){
     U1MODEbits.UARTEN = 1;
     U1STAbits.UTXEN = 1;
     IFS0bits.U1RXIF = 0;
+    IEC0bits.U1RXIE = 1;
 }
 
@@ -69,6 +69,163 @@ static unsigned char extended_address=0;
 static unsigned long address=0;
 static uint16_t saddress=0;
 
+// longest a page write or chip erase may keep the target busy
+#define WRITE_TIMEOUT_MS 50
+
+// A page write still running in the target. The answer goes out as soon as
+// the write page command is sent, the target is polled before the next
+// command that talks to it, so the host sends the next packet meanwhile.
+#define PENDING_NONE 0
+#define PENDING_RDY_BSY 1
+#define PENDING_DATA_POLL 2
+static unsigned char pending_write=PENDING_NONE;
+static unsigned char pending_poll_cmd=0;
+static unsigned char pending_poll_value=0;
+static uint16_t pending_poll_address=0;
+// a timeout of a pending write, reported with the next program command
+static unsigned char pending_status=STATUS_CMD_OK;
+
+// The page being loaded. Loading starts while the rest of a page mode
+// program packet is still arriving, see page_stream().
+static unsigned char page_started=0;
+static unsigned int page_loaded=0;
+static unsigned char page_can_poll=0;
+static unsigned char page_poll_cmd=0;
+static uint16_t page_poll_address=0;
+// address state before loading, restored if the packet turns out corrupted
+static unsigned long page_saved_address=0;
+static unsigned char page_saved_extended_address=0;
+static unsigned char page_saved_new_address=0;
+
+/* wait for a pending page write to finish */
+static void finish_pending_write(void)
+{
+        unsigned int ci;
+
+        if (pending_write==PENDING_RDY_BSY){
+                if (!spi_wait_ready(WRITE_TIMEOUT_MS)){
+                        pending_status=STATUS_RDY_BSY_TOUT;
+                }
+        }else if (pending_write==PENDING_DATA_POLL){
+                for(ci=0;ci<WRITE_TIMEOUT_MS*10;ci++){
+                        spi_mastertransmit(pending_poll_cmd);
+                        spi_mastertransmit_16(pending_poll_address);
+                        if (spi_mastertransmit(0x00)!=pending_poll_value){
+                                break;
+                        }
+                        _delay_ms(0.10);
+                }
+                if (ci==WRITE_TIMEOUT_MS*10){
+                        pending_status=STATUS_CMD_TOUT;
+                }
+        }
+        pending_write=PENDING_NONE;
+}
+
+/* start loading a page, the target must be done with the previous one */
+static void page_load_begin(void)
+{
+        finish_pending_write();
+        page_saved_address=address;
+        page_saved_extended_address=extended_address;
+        page_saved_new_address=new_address;
+        saddress=address&0xFFFF; // previous address, start address 
+        page_loaded=0;
+        page_can_poll=0;
+        page_started=1;
+}
+
+/* drop a page loaded from a corrupted packet, the host sends it again */
+static void page_load_abort(void)
+{
+        address=page_saved_address;
+        extended_address=page_saved_extended_address;
+        new_address=page_saved_new_address;
+        page_started=0;
+}
+
+/* load data byte i of the program packet in msg_buf into the page buffer */
+static void page_load_byte(unsigned int i)
+{
+        unsigned char addressing_is_word;
+
+        addressing_is_word=(msg_buf[0]!=CMD_PROGRAM_EEPROM_ISP);
+        // In commands PROGRAM_FLASH and READ_FLASH "Load Extended Address" 
+        // command is executed before every operation if we are programming 
+        // processor with Flash memory bigger than 64k words and 64k words boundary 
+        // is just crossed or new address was just loaded.
+        if (larger_than_64k && ((address&0xFFFF)==0 || new_address)){
+                // load extended addr byte 0x4d
+                spi_mastertransmit(0x4d);
+                spi_mastertransmit(0x00);
+                spi_mastertransmit(extended_address);
+                spi_mastertransmit(0x00);
+                new_address = 0;
+        }
+        // The Low/High byte selection bit is
+        // bit number 3. Set high byte for uneven bytes
+        if(addressing_is_word && i&1) {
+                spi_mastertransmit(msg_buf[5]|(1<<3));
+        } else {
+                spi_mastertransmit(msg_buf[5]);
+        }
+        spi_mastertransmit_16(address&0xFFFF);
+        spi_mastertransmit(msg_buf[i+10]);
+        
+        // if the data byte is not same as poll value
+        // we can poll on it once the page is written
+        if(msg_buf[8]!=msg_buf[i+10]) {
+                page_can_poll=1;
+                page_poll_address = address&0xFFFF;
+                if(addressing_is_word && i&1) {
+                        page_poll_cmd=msg_buf[7]|(1<<3);
+                } else {
+                        page_poll_cmd=msg_buf[7];
+                }
+        }
+        if (addressing_is_word){
+                //increment word address only when we have an uneven byte
+                if(i&1) {
+                        address++;
+                        if((address&0xFFFF)==0xFFFF){ 
+                                extended_address++;
+                        }
+                }
+        }else{
+                address++;
+        }
+        page_loaded++;
+}
+
+/* called for every message byte as it comes in, loads the page data of
+ * a page mode program packet while the rest of it is still on the way */
+static void page_stream(unsigned int received)
+{
+        unsigned int nbytes;
+
+        // header complete and a data byte in?
+        if (received<11){
+                return;
+        }
+        if (msg_buf[0]!=CMD_PROGRAM_FLASH_ISP && msg_buf[0]!=CMD_PROGRAM_EEPROM_ISP){
+                return;
+        }
+        if ((msg_buf[3]&1)==0){
+                // word mode, done in programcmd()
+                return;
+        }
+        nbytes = ((unsigned int)msg_buf[1])<<8;
+        nbytes |= msg_buf[2];
+        if (nbytes> 280 || received-10 > nbytes){
+                return;
+        }
+        wd_kick();
+        if (!page_started){
+                page_load_begin();
+        }
+        page_load_byte(received-11);
+}
+
 /* transmit an answer back to the programmer software, message is
  * in msg_buf, seqnum is the seqnum of the last message from the programmer software,
  * len=1..275 according to avr068 */
@@ -113,6 +270,11 @@ void programcmd(unsigned char seqnum)
         // distingush addressing CMD_READ_EEPROM_ISP (8bit) and CMD_READ_FLASH_ISP (16bit)
         addressing_is_word=1; // 16 bit is default
 
+        // anything talking to the target has to wait for the page write
+        if (msg_buf[0]!=CMD_LOAD_ADDRESS && msg_buf[0]!=CMD_GET_PARAMETER){
+                finish_pending_write();
+        }
+
         switch(msg_buf[0]){
                 case CMD_SIGN_ON:
                 // prepare answer:
@@ -257,6 +419,7 @@ void programcmd(unsigned char seqnum)
                 // cmd4 1 byte
                 LED_ON;
                 spi_init();
+                pending_status=STATUS_CMD_OK;
                 delay_ms(msg_buf[2]); // stabDelay
 
                 answerlen=2;
@@ -337,10 +500,7 @@ void programcmd(unsigned char seqnum)
                         delay_ms(msg_buf[1]); // eraseDelay
                 } else {
                         // pollMethod RDY/BSY cmd
-                        ci=150; // timeout
-                        while((spi_mastertransmit_32(0xF0000000)&1)&&ci){
-                                ci--;
-                        }
+                        spi_wait_ready(WRITE_TIMEOUT_MS);
                 }
                 answerlen = 2;
                 //msg_buf[0] = CMD_CHIP_ERASE_ISP;
@@ -371,7 +531,6 @@ void programcmd(unsigned char seqnum)
                 if (msg_buf[4] > 32){
                         msg_buf[4]=32;
                 }
-				saddress=address&0xFFFF; // previous address, start address 
 				nbytes = ((unsigned int)msg_buf[1])<<8;
 				nbytes |= msg_buf[2];
                 if (nbytes> 280){
@@ -383,10 +542,12 @@ void programcmd(unsigned char seqnum)
                 wd_kick();
                 // store the original mode:
                 tmp2=msg_buf[3];
-                // result code
-                cstatus=STATUS_CMD_OK;
+                // result code, includes a timeout of the previous page
+                cstatus=pending_status;
+                pending_status=STATUS_CMD_OK;
                 // msg_buf[3] test Word/Page Mode bit:
                 if ((msg_buf[3]&1)==0){
+                        saddress=address&0xFFFF; // previous address, start address 
                         // word mode
                         for(i=0;i<nbytes;i++)
                         {        
@@ -458,53 +619,16 @@ void programcmd(unsigned char seqnum)
                         }                        
                 }else{
                         //page mode, all modern chips
-                        for(i=0;i<nbytes;i++)
+                        //most of the page was usually loaded during reception
+                        if (!page_started){
+                                page_load_begin();
+                        }
+                        for(i=page_loaded;i<nbytes;i++)
                         {
                                 wd_kick();
-                                // In commands PROGRAM_FLASH and READ_FLASH "Load Extended Address" 
-                                // command is executed before every operation if we are programming 
-                                // processor with Flash memory bigger than 64k words and 64k words boundary 
-                                // is just crossed or new address was just loaded.
-                                if (larger_than_64k && ((address&0xFFFF)==0 || new_address)){
-                                        // load extended addr byte 0x4d
-                                        spi_mastertransmit(0x4d);
-                                        spi_mastertransmit(0x00);
-                                        spi_mastertransmit(extended_address);
-                                        spi_mastertransmit(0x00);
-                                        new_address = 0;
-                                }
-                                // The Low/High byte selection bit is
-                                // bit number 3. Set high byte for uneven bytes
-                                if(addressing_is_word && i&1) {
-                                        spi_mastertransmit(msg_buf[5]|(1<<3));
-                                } else {
-                                        spi_mastertransmit(msg_buf[5]);
-                                }
-                                spi_mastertransmit_16(address&0xFFFF);
-                                spi_mastertransmit(msg_buf[i+10]);
-                                
-                                // that the data byte is not same as poll value
-                                // in that case we can do polling:
-                                if(msg_buf[8]!=msg_buf[i+10]) {
-                                        poll_address = address&0xFFFF;
-                                } else {
-                                        //switch the mode to timed delay (waiting)
-                                        //we must preserve bit 0x80
-                                        msg_buf[3]= (msg_buf[3]&0x80)|0x10;
-                                
-                                }
-                                if (addressing_is_word){
-                                        //increment word address only when we have an uneven byte
-                                        if(i&1) {
-                                                address++;
-                                                if((address&0xFFFF)==0xFFFF){ 
-                                                        extended_address++;
-                                                }
-                                        }
-                                }else{
-                                        address++;
-                                }
+                                page_load_byte(i);
                         }
+                        page_started=0;
                         
                         wd_kick();
                         //page mode check result:
@@ -520,35 +644,17 @@ void programcmd(unsigned char seqnum)
                                         // eeprom writing, eeprom needs more time
                                         delay_ms(1);
                                 }
-                                //check the different polling mode methods
-                                ci=150; // timeout
-                                if(msg_buf[3]&0x20 && poll_address) {
+                                //check the different polling mode methods,
+                                //polling is left for the next command
+                                if(msg_buf[3]&0x20 && page_can_poll) {
                                         //Data value polling
-                                        tmp=msg_buf[8];
-                                        while(tmp==msg_buf[8] && ci){
-                                                // The Low/High byte selection bit is
-                                                // bit number 3. Set high byte for uneven bytes
-                                                // Read data:
-                                                if(poll_address&1) {
-                                                        spi_mastertransmit(msg_buf[7]|(1<<3));
-                                                } else {
-                                                        spi_mastertransmit(msg_buf[7]);
-                                                }
-                                                spi_mastertransmit_16(poll_address);
-                                                tmp=spi_mastertransmit(0x00);
-                                                ci--;
-                                        }
-                                        if (ci==0){
-                                                cstatus=STATUS_CMD_TOUT;
-                                        }
+                                        pending_write=PENDING_DATA_POLL;
+                                        pending_poll_cmd=page_poll_cmd;
+                                        pending_poll_value=msg_buf[8];
+                                        pending_poll_address=page_poll_address;
                                 } else if(msg_buf[3]& 0x40){
                                         //RDY/BSY polling
-                                        while((spi_mastertransmit_32(0xF0000000)&1)&&ci){
-                                                ci--;
-                                        }
-                                        if (ci==0){
-                                                cstatus=STATUS_RDY_BSY_TOUT;
-                                        }
+                                        pending_write=PENDING_RDY_BSY;
                                 }else{
                                         // simple waiting
                                         delay_ms(msg_buf[4]);
@@ -636,7 +742,6 @@ void programcmd(unsigned char seqnum)
                     if (msg_buf[1] == (ci + 1)){
                             msg_buf[2] = tmp;
                     }
-					delay_ms(5);
                 }
                 answerlen = 4;
                 // msg_buf[0] = CMD_READ_FUSE_ISP; or CMD_READ_LOCK_ISP or ...
@@ -657,7 +762,6 @@ void programcmd(unsigned char seqnum)
                 cj=0; 
                 ci=0;
                 for (cj=0; cj<msg_buf[1]; cj++) {
-				delay_ms(5);
                         if (cj >= tmp2 && ci <tmp){
                                 // store answer starting from msg_buf[2]
                                 msg_buf[ci+2]=spi_mastertransmit(msg_buf[cj+4]);
@@ -761,6 +865,7 @@ int main(void)
                         msg_buf[i]=ch;
                         i++;
 						wdt_reset(); //wd_kick();
+                        page_stream(i);
                         if (i==msglen){
                                 msgparsestate=MSG_WAIT_CKSUM;
                         }
@@ -779,6 +884,10 @@ int main(void)
                         }
                         // no continue here, set state=MSG_IDLE
                 }
+                if (page_started){
+                        // packet dropped halfway through loading
+                        page_load_abort();
+                }
                 msgparsestate=MSG_IDLE;
                 msglen=0;
                 seqnum=0;
@@ -185,6 +185,19 @@ unsigned char spi_mastertransmit_32(unsigned long data)
         return(spi_mastertransmit(data&0xFF));
 }
 
+// poll RDY/BSY until the target is done with a write or erase.
+// Polls about every 100us, returns 0 if still busy after timeout_ms.
+unsigned char spi_wait_ready(unsigned char timeout_ms)
+{
+        unsigned int i;
+        for(i=0;i<(unsigned int)timeout_ms*10;i++){
+                if ((spi_mastertransmit_32(0xF0000000)&1)==0){
+                        return(1);
+                }
+                _delay_ms(0.10);
+        }
+        return(0);
+}
 
 void spi_disable(void)
 {
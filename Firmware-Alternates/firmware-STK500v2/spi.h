@@ -13,6 +13,7 @@ extern unsigned char spi_get_sck_duration(void);
 extern unsigned char spi_mastertransmit(unsigned char data);
 extern unsigned char spi_mastertransmit_16(unsigned int data);
 extern unsigned char spi_mastertransmit_32(unsigned long data);
+extern unsigned char spi_wait_ready(unsigned char timeout_ms);
 extern void spi_disable(void);
 extern void spi_reset_pulse(void);
 extern void spi_sck_pulse(void);
@@ -56,8 +56,10 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "core.h"
 #include "proc_menu.h"
 
+extern bus_pirate_configuration_t bus_pirate_configuration;
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
 
@@ -72,6 +74,10 @@ extern command_t last_command;
 #error "BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS too big"
 #endif /* BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS > MAXIMUM_DEVICES_ROSTER_SIZE */
 
+#if defined(BP_1WIRE_UART_SLOT_TIMING) && defined(BP_1WIRE_HARDWARE_SLOT_TIMING)
+#error "BP_1WIRE_UART_SLOT_TIMING and BP_1WIRE_HARDWARE_SLOT_TIMING are exclusive"
+#endif /* BP_1WIRE_UART_SLOT_TIMING && BP_1WIRE_HARDWARE_SLOT_TIMING */
+
 /**
  * @brief Size of a 1-Wire ROM number identifier, in bytes.
  */
@@ -112,6 +118,21 @@ extern command_t last_command;
  */
 #define DS2431 0x2D
 
+/**
+ * @brief DS18x20 function command to start a temperature conversion.
+ */
+#define DS18X20_CONVERT_T 0x44
+
+/**
+ * @brief DS18x20 function command to read the scratchpad contents.
+ */
+#define DS18X20_READ_SCRATCHPAD 0xBE
+
+/**
+ * @brief Size of a DS18x20 scratchpad, CRC byte excluded.
+ */
+#define DS18X20_SCRATCHPAD_SIZE 8
+
 /**
  * @brief Binary I/O 1-Wire Action command.
  *
@@ -126,16 +147,16 @@ extern command_t last_command;
  * * `0b0000` : BINARY_IO_ONEWIRE_ACTION_EXIT.
  * * `0b0001` : BINARY_IO_ONEWIRE_ACTION_VERSION_STRING.
  * * `0b0010` : BINARY_IO_ONEWIRE_ACTION_BUS_RESET.
- * * `0b0011` : Reserved.
+ * * `0b0011` : BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM.
  * * `0b0100` : BINARY_IO_ONEWIRE_ACTION_READ_BYTE.
- * * `0b0101` : Reserved.
- * * `0b0110` : Reserved.
- * * `0b0111` : Reserved.
+ * * `0b0101` : BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_MATCH_ROM.
+ * * `0b0110` : BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8.
+ * * `0b0111` : BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16.
  * * `0b1000` : BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO.
  * * `0b1001` : BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO.
- * * `0b1010` : Reserved.
- * * `0b1011` : Reserved.
- * * `0b1100` : Reserved.
+ * * `0b1010` : BINARY_IO_ONEWIRE_ACTION_ROM_ENUMERATE.
+ * * `0b1011` : BINARY_IO_ONEWIRE_ACTION_TEMPERATURE_BATCH.
+ * * `0b1100` : BINARY_IO_ONEWIRE_ACTION_TELEMETRY.
  * * `0b1101` : Reserved.
  * * `0b1110` : Reserved.
  * * `0b1111` : Reserved.
@@ -144,9 +165,16 @@ extern command_t last_command;
  * @see BINARY_IO_ONEWIRE_ACTION_EXIT
  * @see BINARY_IO_ONEWIRE_ACTION_VERSION_STRING
  * @see BINARY_IO_ONEWIRE_ACTION_BUS_RESET
+ * @see BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM
  * @see BINARY_IO_ONEWIRE_ACTION_READ_BYTE
+ * @see BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_MATCH_ROM
+ * @see BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8
+ * @see BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16
  * @see BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO
  * @see BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO
+ * @see BINARY_IO_ONEWIRE_ACTION_ROM_ENUMERATE
+ * @see BINARY_IO_ONEWIRE_ACTION_TEMPERATURE_BATCH
+ * @see BINARY_IO_ONEWIRE_ACTION_TELEMETRY
  */
 #define BINARY_IO_ONEWIRE_COMMAND_ACTION 0x00
 
@@ -333,6 +361,31 @@ extern command_t last_command;
  */
 #define BINARY_IO_ONEWIRE_ACTION_BUS_RESET 0x02
 
+/**
+ * @brief Binary I/O 1-Wire Action command to address all devices in overdrive.
+ *
+ * The board resets the bus at standard speed and sends an Overdrive Skip ROM
+ * command (`0x3C`), then switches itself to overdrive timings.  Every command
+ * that follows runs at overdrive speed, until a standard speed reset is
+ * requested with BINARY_IO_ONEWIRE_COMMAND_CONFIGURE.  If no device answers
+ * the reset the speed is left untouched and a FAILURE value is returned.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b0011` (OVERDRIVE_SKIP_ROM).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00000011`</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM 0x03
+
 /**
  * @brief Binary I/O 1-Wire Action command to read a byte from the bus.
  *
@@ -353,6 +406,92 @@ extern command_t last_command;
  */
 #define BINARY_IO_ONEWIRE_ACTION_READ_BYTE 0x04
 
+/**
+ * @brief Binary I/O 1-Wire Action command to address one device in overdrive.
+ *
+ * Like BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM, but an Overdrive Match ROM
+ * command (`0x69`) is sent instead, followed by the given ROM address at
+ * overdrive speed.  Only the matching device is left in overdrive mode.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b0101` (OVERDRIVE_MATCH_ROM).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00000101`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>ROM address, 8 bytes.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_MATCH_ROM 0x05
+
+/**
+ * @brief Binary I/O 1-Wire Action command to read a CRC8 protected block.
+ *
+ * Reads the given amount of bytes from the bus, followed by the CRC8 byte the
+ * device appends to them (as with a DS18B20 scratchpad).  The CRC is checked
+ * on the board, starting from the given seed: the data is only sent back if
+ * the check passes, otherwise a lone FAILURE value is returned and the host
+ * can just retry.  The length is sent MSB first, and can be up to
+ * BP_TERMINAL_BUFFER_SIZE bytes.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b0110` (CHECKED_READ_CRC8).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00000110`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Data length, 2 bytes.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>CRC8 seed, 1 byte (usually `0x00`).</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) followed by the data bytes, or
+ * `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8 0x06
+
+/**
+ * @brief Binary I/O 1-Wire Action command to read a CRC16 protected block.
+ *
+ * Like BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8, but the block is followed
+ * by the inverted 1-Wire CRC16, LSB first, as DS2431 and DS28EC20 memories
+ * send it.  Those devices also cover the command and address bytes with the
+ * CRC, so the host passes the CRC16 of what it sent so far as the seed.  The
+ * seed is sent LSB first.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b0111` (CHECKED_READ_CRC16).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00000111`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Data length, 2 bytes.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>CRC16 seed, 2 bytes.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) followed by the data bytes, or
+ * `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16 0x07
+
 /**
  * @brief Binary I/O 1-Wire Action command to invoke the "ROM search" macro.
  *
@@ -429,6 +568,141 @@ extern command_t last_command;
  */
 #define BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO 0x09
 
+/**
+ * @brief Binary I/O 1-Wire Action command to enumerate the bus, resumably.
+ *
+ * Works like BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO, with no limit on the
+ * number of devices, but every ROM address is followed by a one byte resume
+ * token: the search discrepancy left after finding that device.  The ROM
+ * address plus its token can be sent back with a later enumeration request to
+ * carry on right after that device, so a host that lost part of a long
+ * enumeration does not have to start over.  An all zeroes resume token starts
+ * a fresh search.
+ *
+ * Every ROM address is CRC checked on the board, and the end marker is
+ * followed by a status byte: SUCCESS if the last device on the bus was
+ * reached, FAILURE if the search stopped early on a bus reset with no
+ * presence pulse, a bit collision, or a CRC mismatch.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b1010` (ROM_ENUMERATE).</td>
+ * </tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00001010`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Resume ROM address, 8 bytes.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Resume token, 1 byte.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS).</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>For every device: ROM address, 8 bytes, then resume token, 1 byte.</td>
+ * </tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>End marker, eight `0xFF` bytes.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr></table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_ROM_ENUMERATE 0x0A
+
+/**
+ * @brief Binary I/O 1-Wire Action command to read a batch of thermometers.
+ *
+ * Starts a temperature conversion on every DS18x20 on the bus at once with
+ * SKIP ROM + CONVERT T, waits for the given amount of milliseconds, then
+ * reads back the scratchpad of every device in the given ROM list.  Each
+ * scratchpad is CRC checked on the board.
+ *
+ * If the strong pull-up flag is set the CS line is driven LOW for the whole
+ * conversion, then put back in its previous state.  That is enough to turn
+ * on a P-channel MOSFET between Vpu and the bus, as needed by parasite
+ * powered sensors.
+ *
+ * Flags are as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:2`</td><td>Reserved, set to `0b000000`.</td></tr>
+ * <tr><td>`1`</td><td>Return the whole 8 bytes scratchpad rather than just
+ * the 2 temperature bytes.</td></tr>
+ * <tr><td>`0`</td><td>Strong pull-up through CS during conversion.</td></tr>
+ * </table>
+ *
+ * The conversion time is sent MSB first (750 ms for a 12 bits conversion).
+ * The ROM list holds up to 255 entries, 8 bytes each.  Every device gets a
+ * record made of a status byte, SUCCESS or FAILURE (no presence pulse or CRC
+ * mismatch), followed by the temperature (or scratchpad) bytes, zeroed on
+ * failure.  If nothing answers the initial reset, a lone FAILURE is returned
+ * instead of the records.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b1011` (TEMPERATURE_BATCH).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00001011`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Flags, 1 byte.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Conversion time in milliseconds, 2 bytes.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Number of devices, 1 byte.</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>ROM addresses, 8 bytes each.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>For every device: status byte, then 2 (or 8) data bytes.</td></tr>
+ * </table>
+ */
+#define BINARY_IO_ONEWIRE_ACTION_TEMPERATURE_BATCH 0x0B
+
+/**
+ * @brief Temperature batch flag: strong pull-up through CS.
+ */
+#define TEMPERATURE_BATCH_STRONG_PULLUP 0b00000001
+
+/**
+ * @brief Temperature batch flag: return the whole scratchpad.
+ */
+#define TEMPERATURE_BATCH_FULL_SCRATCHPAD 0b00000010
+
+/**
+ * @brief Binary I/O action for reading the telemetry counters.
+ *
+ * Current format is as follows:
+ *
+ * <table><tr><th>Bits</th><th>Meaning</th></tr>
+ * <tr><td>`7:4`</td><td>Command type, set to `0b0000` (ACTION).</td></tr>
+ * <tr><td>`3:0`</td><td>Action type, set to `0b1100` (TELEMETRY).
+ * </td></tr></table>
+ *
+ * Interaction flow is as follows:
+ *
+ * <table><tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>`0b00001100`</td></tr>
+ * <tr><td>PC</td><td>&rarr;</td><td>Bus Pirate</td>
+ * <td>Flags, 1 byte.</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>`0b00000001` (SUCCESS) or `0b00000000` (FAILURE).</td></tr>
+ * <tr><td>PC</td><td>&larr;</td><td>Bus Pirate</td>
+ * <td>Counter count, then every counter, 4 bytes each.</td></tr>
+ * </table>
+ *
+ * @see bp_binary_io_send_telemetry
+ */
+#define BINARY_IO_ONEWIRE_ACTION_TELEMETRY 0x0C
+
 /**
  * @brief 1-Wire protocol macro identifiers.
  */
@@ -439,9 +713,15 @@ typedef enum {
   /** Identifier for the "Read ROM" macro entry. */
   MACRO_READ_ROM = 0x33,
 
+  /** Identifier for the "Overdrive Skip ROM" macro entry. */
+  MACRO_OVERDRIVE_SKIP_ROM = 0x3C,
+
   /** Identifier for the "Match ROM" macro entry. */
   MACRO_MATCH_ROM = 0x55,
 
+  /** Identifier for the "Overdrive Match ROM" macro entry. */
+  MACRO_OVERDRIVE_MATCH_ROM = 0x69,
+
   /** Identifier for the "Skip ROM" macro entry. */
   MACRO_SKIP_ROM = 0xCC,
 
@@ -452,6 +732,209 @@ typedef enum {
   MACRO_SEARCH_ROM = 0xF0
 } onewire_macros_t;
 
+/**
+ * @brief 1-Wire bus speeds, as stored in mode_configuration.speed.
+ */
+typedef enum {
+  /** Standard speed, about 16kbps. */
+  ONEWIRE_SPEED_STANDARD = 0,
+
+  /** Overdrive speed, about 140kbps. */
+  ONEWIRE_SPEED_OVERDRIVE
+} onewire_speed_t;
+
+/**
+ * @brief Converts the given amount of microseconds into instruction cycles.
+ */
+#define ONEWIRE_MICROSECONDS(value) ((uint16_t)((value) * (FCY / 1000000UL)))
+
+/**
+ * @brief 1-Wire time slot timings for one bus speed, in instruction cycles.
+ *
+ * Letters refer to the parameters in Maxim's AN126.  Zero means no delay at
+ * all, rather than the shortest one the delay loop can do.
+ */
+typedef struct {
+  /** Bit slot, LOW time before releasing a 1 or sampling (A). */
+  uint16_t slot_start;
+  /** Bit slot, wait between releasing the line and sampling it (E). */
+  uint16_t read_sample;
+  /** Bit slot, wait after sampling (F). */
+  uint16_t read_recovery;
+  /** Bit slot, extra LOW time when writing a 0 (C). */
+  uint16_t write_zero_low;
+  /** Bit slot, recovery after writing a 0 (D). */
+  uint16_t write_zero_recovery;
+  /** Bit slot, padding bringing every slot to the same length. */
+  uint16_t slot_padding;
+  /** Byte padding, added after every 8 slots. */
+  uint16_t byte_padding;
+  /** Reset, wait before pulling the line LOW (G). */
+  uint16_t reset_start;
+  /** Reset, LOW time (H). */
+  uint16_t reset_low;
+  /** Reset, wait before sampling the presence pulse (I). */
+  uint16_t presence_sample;
+  /** Reset, wait after sampling the presence pulse (J). */
+  uint16_t presence_recovery;
+  /** Bit slot, latest line release still read as a 1. */
+  uint16_t read_threshold;
+} onewire_timings_t;
+
+/**
+ * @brief Time slot timings, indexed by onewire_speed_t.
+ */
+static const onewire_timings_t ONEWIRE_TIMINGS[] = {
+    [ONEWIRE_SPEED_STANDARD] = {.slot_start = ONEWIRE_MICROSECONDS(4),
+                                .read_sample = ONEWIRE_MICROSECONDS(8),
+                                .read_recovery = ONEWIRE_MICROSECONDS(32),
+                                .write_zero_low = ONEWIRE_MICROSECONDS(25),
+                                .write_zero_recovery = ONEWIRE_MICROSECONDS(7),
+                                .slot_padding = ONEWIRE_MICROSECONDS(5),
+                                .byte_padding = ONEWIRE_MICROSECONDS(8),
+                                .reset_start = 0,
+                                .reset_low = ONEWIRE_MICROSECONDS(500),
+                                .presence_sample = ONEWIRE_MICROSECONDS(65),
+                                .presence_recovery = ONEWIRE_MICROSECONDS(500),
+                                .read_threshold = ONEWIRE_MICROSECONDS(15)},
+    [ONEWIRE_SPEED_OVERDRIVE] = {.slot_start = ONEWIRE_MICROSECONDS(1),
+                                 .read_sample = 0,
+                                 .read_recovery = ONEWIRE_MICROSECONDS(6),
+                                 .write_zero_low = ONEWIRE_MICROSECONDS(4),
+                                 .write_zero_recovery = ONEWIRE_MICROSECONDS(2),
+                                 .slot_padding = 0,
+                                 .byte_padding = 0,
+                                 .reset_start = ONEWIRE_MICROSECONDS(1),
+                                 .reset_low = ONEWIRE_MICROSECONDS(70),
+                                 .presence_sample = ONEWIRE_MICROSECONDS(6),
+                                 .presence_recovery = ONEWIRE_MICROSECONDS(32),
+                                 .read_threshold = ONEWIRE_MICROSECONDS(2)}};
+
+/**
+ * @brief Timings for the currently selected bus speed.
+ */
+static const onewire_timings_t *onewire_timings =
+    &ONEWIRE_TIMINGS[ONEWIRE_SPEED_STANDARD];
+
+/**
+ * @brief Selects the bus speed used by all following bus operations.
+ *
+ * @param[in] speed the speed to switch to, from onewire_speed_t.
+ */
+static void onewire_select_speed(const onewire_speed_t speed);
+
+/**
+ * @brief Waits the given amount of cycles, if any.
+ *
+ * @param[in] cycles a timing value out of onewire_timings_t.
+ */
+static inline void onewire_wait(const uint16_t cycles);
+
+#ifdef BP_1WIRE_HARDWARE_SLOT_TIMING
+
+/**
+ * @brief Hands the data line to OC4 and starts a LOW pulse on it.
+ *
+ * Timer 3 is restarted from zero as the pulse begins, OC4 releases the line
+ * once the given amount of cycles has elapsed, and IC3 timestamps every
+ * rising edge from then on.  Nothing here depends on the CPU being on time.
+ *
+ * @param[in] release when to release the line, in cycles from the start.
+ */
+static void onewire_slot_start(const uint16_t release);
+
+/**
+ * @brief Waits for the end of the current slot and gives the line back.
+ *
+ * Interrupts are free to run while waiting, as the line is already released
+ * by then and the edges are timestamped by IC3.
+ *
+ * @param[in] end when the slot ends, in cycles from the start.
+ * @param[out] last_edge when the last rising edge was seen, in cycles from
+ *                       the start, if any.
+ *
+ * @return how many rising edges were seen during the slot.
+ */
+static uint8_t onewire_slot_finish(const uint16_t end, uint16_t *last_edge);
+
+#endif /* BP_1WIRE_HARDWARE_SLOT_TIMING */
+
+#ifdef BP_1WIRE_UART_SLOT_TIMING
+
+/**
+ * @brief Converts the given baud rate into a UART2 BRG value, high speed mode.
+ */
+#define ONEWIRE_UART_BRG(baud)                                                 \
+  ((uint16_t)((((FCY / 4) + ((baud) / 2)) / (baud)) - 1))
+
+/**
+ * @brief How many slots can be in flight at once without the UART2 receive
+ * FIFO overflowing.
+ */
+#define ONEWIRE_UART_FIFO_DEPTH 4
+
+/**
+ * @brief UART2 settings for one bus speed.
+ */
+typedef struct {
+  /** BRG value for reset pulses. */
+  uint16_t reset_brg;
+  /** Character sent for reset pulses, LOW for its start bit and low bits. */
+  uint8_t reset_pattern;
+  /** BRG value for bit slots. */
+  uint16_t slot_brg;
+} onewire_uart_rates_t;
+
+/**
+ * @brief UART2 settings, indexed by onewire_speed_t.
+ *
+ * Standard speed resets are 520us long at 9600 baud, and slots are 9us LOW for
+ * a 1 and 78us LOW for a 0 at 115200 baud.  Overdrive resets are 52us long at
+ * 115200 baud, leaving the presence pulse to the last two data bits, and slots
+ * run at 1000000 baud.
+ */
+static const onewire_uart_rates_t ONEWIRE_UART_RATES[] = {
+    [ONEWIRE_SPEED_STANDARD] = {.reset_brg = ONEWIRE_UART_BRG(9600),
+                                .reset_pattern = 0xF0,
+                                .slot_brg = ONEWIRE_UART_BRG(115200)},
+    [ONEWIRE_SPEED_OVERDRIVE] = {.reset_brg = ONEWIRE_UART_BRG(115200),
+                                 .reset_pattern = 0xE0,
+                                 .slot_brg = ONEWIRE_UART_BRG(1000000)}};
+
+/**
+ * @brief UART2 settings for the currently selected bus speed.
+ */
+static const onewire_uart_rates_t *onewire_uart_rates =
+    &ONEWIRE_UART_RATES[ONEWIRE_SPEED_STANDARD];
+
+/**
+ * @brief Hands the data line to UART2 at the given speed.
+ *
+ * TX drives the line as open drain and RX reads it back from the same pin.
+ *
+ * @param[in] brg the UART2 baud rate generator value to use.
+ */
+static void onewire_uart_attach(const uint16_t brg);
+
+/**
+ * @brief Stops UART2 and gives the data line back, released.
+ */
+static void onewire_uart_detach(void);
+
+/**
+ * @brief Sends the given characters through UART2, replacing each one with
+ * what was read back from the line during its slot.
+ *
+ * Interrupts keep running meanwhile, as the slots are timed by UART2 and the
+ * line just idles HIGH between characters if the FIFO runs dry.
+ *
+ * @param[in,out] slots the characters to send, then the characters read.
+ * @param[in]     count how many characters to exchange.
+ */
+static void onewire_uart_exchange(uint8_t *slots, const uint8_t count);
+
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
+
 /**
  * @brief Sends and receives 1-bit values on/from the bus.
  *
@@ -587,6 +1070,12 @@ typedef struct {
    */
   uint8_t last_device_flag : 1;
 
+  /**
+   * Flag indicating if the last search attempt stopped because of a bus
+   * error rather than having no more devices to report.
+   */
+  uint8_t search_failed : 1;
+
 } __attribute__((packed)) onewire_state_t;
 
 /**
@@ -603,7 +1092,28 @@ static onewire_state_t onewire_state = {.command_byte = MACRO_SEARCH_ROM};
 static onewire_bus_reset_result_t perform_bus_reset(void);
 
 /**
- * @brief 1-wire protocol precalculated CRC table.
+ * @brief Prints the outcome of a bus reset on the serial port.
+ *
+ * @param[in] reset_result what perform_bus_reset returned.
+ */
+static void print_bus_reset_result(const onewire_bus_reset_result_t reset_result);
+
+/**
+ * @brief Sends an overdrive ROM command, then switches to overdrive speed.
+ *
+ * The bus is reset at standard speed first, as devices only listen for
+ * overdrive commands then.  The bus stays at standard speed if no device
+ * answers the reset.
+ *
+ * @param[in] command MACRO_OVERDRIVE_SKIP_ROM or MACRO_OVERDRIVE_MATCH_ROM.
+ *
+ * @return the result of the standard speed bus reset.
+ */
+static onewire_bus_reset_result_t
+enter_overdrive_speed(const onewire_macros_t command);
+
+/**
+ * @brief 1-wire protocol precalculated CRC8 table.
  *
  * Taken from https://www.maximintegrated.com/en/app-notes/index.mvp/id/27
  */
@@ -639,6 +1149,72 @@ static const uint8_t CRC_TABLE[] = {
  */
 static uint8_t update_crc8(const uint8_t value);
 
+/**
+ * @brief 1-Wire CRC16 (x^16 + x^15 + x^2 + 1) precalculated table.
+ */
+static const uint16_t CRC16_TABLE[] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040};
+
+/**
+ * @brief Updates the given 1-Wire CRC16 value with the given data value.
+ *
+ * @param[in] crc the current CRC16 value.
+ * @param[in] value the new byte to update the CRC16 value with.
+ * @return the updated CRC16 value.
+ */
+static inline uint16_t update_crc16(const uint16_t crc, const uint8_t value);
+
+/**
+ * @brief Reads a block of bytes from the bus and checks its trailing CRC.
+ *
+ * The block is sent back only if the CRC matches.
+ *
+ * @param[in] use_crc16 true if the block ends with an inverted CRC16, false
+ *                      if it ends with a CRC8.
+ *
+ * @see BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8
+ * @see BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16
+ */
+static void binary_io_checked_read(const bool use_crc16);
+
+/**
+ * @brief Converts and reads back a list of DS18x20 thermometers.
+ *
+ * @see BINARY_IO_ONEWIRE_ACTION_TEMPERATURE_BATCH
+ */
+static void binary_io_temperature_batch(void);
+
 /**
  * @brief Looks up the given model identifier.
  *
@@ -680,6 +1256,18 @@ static bool device_find_next(void);
  */
 static bool perform_device_search(void);
 
+/**
+ * @brief Streams all device ROM addresses, resuming from the given point.
+ *
+ * @param[in] resume_rom the ROM address of the last device already known, or
+ *                       all zeroes to start from scratch.
+ * @param[in] resume_token the token that was reported with resume_rom.
+ *
+ * @see BINARY_IO_ONEWIRE_ACTION_ROM_ENUMERATE
+ */
+static void binary_io_enumerate_devices(const uint8_t *resume_rom,
+                                        const uint8_t resume_token);
+
 #ifdef BP_1WIRE_LOOKUP_FAMILY_ID
 
 /**
@@ -708,6 +1296,22 @@ uint16_t onewire_write(const uint16_t value) {
   return 0x100;
 }
 
+void onewire_send_buffer(const uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    ONEWIRE_WRITE_BYTE(buffer[index]);
+  }
+}
+
+void onewire_read_buffer(uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    buffer[index] = ONEWIRE_READ_BYTE();
+  }
+}
+
 bool onewire_read_bit(void) { return ONEWIRE_READ_BIT(); }
 
 void onewire_clock_pulse(void) { ONEWIRE_WRITE_BIT(onewire_state.data_state); }
@@ -728,11 +1332,11 @@ void onewire_setup_prepare(void) {
   consumewhitechars();
   speed = getint();
   if ((speed > 0) && (speed <= 2)) {
-    mode_configuration.speed = speed - 1;
+    onewire_select_speed(speed - 1);
   } else {
     mode_configuration.command_error = NO;
     MSG_1WIRE_SPEED_PROMPT;
-    mode_configuration.speed = getnumber(1, 1, 2, 0) - 1;
+    onewire_select_speed(getnumber(1, 1, 2, 0) - 1);
   }
 
   /* Clear the saved device roster entries. */
@@ -905,6 +1509,24 @@ void onewire_run_macro(const uint16_t macro) {
     ONEWIRE_WRITE_BYTE(MACRO_SKIP_ROM);
     break;
 
+  case MACRO_OVERDRIVE_SKIP_ROM:
+  case MACRO_OVERDRIVE_MATCH_ROM: {
+    onewire_bus_reset_result_t reset_result;
+
+    reset_result = enter_overdrive_speed(macro_id);
+    print_bus_reset_result(reset_result);
+    if (reset_result != ONEWIRE_BUS_RESET_OK) {
+      break;
+    }
+
+    if (macro_id == MACRO_OVERDRIVE_SKIP_ROM) {
+      MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME;
+    } else {
+      MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME;
+    }
+    break;
+  }
+
   default:
     MSG_UNKNOWN_MACRO_ERROR;
     break;
@@ -914,9 +1536,10 @@ void onewire_run_macro(const uint16_t macro) {
 void onewire_pins_state(void) { MSG_1WIRE_PINS_STATE; }
 
 void onewire_reset(void) {
-  onewire_bus_reset_result_t reset_result;
+  print_bus_reset_result(perform_bus_reset());
+}
 
-  reset_result = perform_bus_reset();
+void print_bus_reset_result(const onewire_bus_reset_result_t reset_result) {
   MSG_1WIRE_BUS_RESET;
 
   if (reset_result == ONEWIRE_BUS_RESET_OK) {
@@ -935,17 +1558,73 @@ void onewire_reset(void) {
 }
 
 onewire_bus_reset_result_t perform_bus_reset(void) {
+#if defined(BP_1WIRE_UART_SLOT_TIMING)
+  uint8_t slot;
+
+  /* AN126: Parameter G */
+  ONEWIRE_DATA_DIRECTION = INPUT;
+  onewire_wait(onewire_timings->reset_start);
+
+  /*
+   * AN126: Parameters H and I.  A device answering the reset pulls the line
+   * LOW while the high bits of the pattern are sent, changing what is read.
+   */
+  slot = onewire_uart_rates->reset_pattern;
+  onewire_uart_attach(onewire_uart_rates->reset_brg);
+  onewire_uart_exchange(&slot, 1);
+  onewire_uart_detach();
+
+  /* AN126: Parameter J */
+  onewire_wait(onewire_timings->presence_recovery);
+
+  if (ONEWIRE_DATA_LINE == LOW) {
+    /* If the data line was not pulled high now, there is a short on the bus. */
+    return ONEWIRE_BUS_RESET_SHORT;
+  }
+
+  return (slot == onewire_uart_rates->reset_pattern)
+             ? ONEWIRE_BUS_RESET_NO_DEVICE
+             : ONEWIRE_BUS_RESET_OK;
+#elif defined(BP_1WIRE_HARDWARE_SLOT_TIMING)
+  uint16_t last_edge;
+  uint8_t edges;
+
+  /* AN126: Parameter G */
+  ONEWIRE_DATA_DIRECTION = INPUT;
+  onewire_wait(onewire_timings->reset_start);
+
+  /*
+   * AN126: Parameters H, I, and J.  A device answering the reset holds the
+   * line LOW for a while after it is released, so its presence shows up as a
+   * rising edge well past the one caused by the release itself.
+   */
+  onewire_slot_start(onewire_timings->reset_low);
+  edges = onewire_slot_finish(onewire_timings->reset_low +
+                                  onewire_timings->presence_recovery,
+                              &last_edge);
+
+  if (ONEWIRE_DATA_LINE == LOW) {
+    /* If the data line was not pulled high now, there is a short on the bus. */
+    return ONEWIRE_BUS_RESET_SHORT;
+  }
+
+  if ((edges == 0) || (last_edge < (onewire_timings->reset_low +
+                                    onewire_timings->presence_sample))) {
+    return ONEWIRE_BUS_RESET_NO_DEVICE;
+  }
+
+  return ONEWIRE_BUS_RESET_OK;
+#else
   onewire_bus_reset_result_t result;
+  uint16_t interrupt_level;
 
   result = ONEWIRE_BUS_RESET_OK;
 
   /* Pull the bus line LOW. */
 
   ONEWIRE_DATA_DIRECTION = INPUT;
-  if (mode_configuration.speed == 1) {
-    /* AN126: Parameter G */
-    bp_delay_us(1);
-  }
+  /* AN126: Parameter G */
+  onewire_wait(onewire_timings->reset_start);
   ONEWIRE_DATA_LINE = LOW;
   ONEWIRE_DATA_DIRECTION = OUTPUT;
 
@@ -954,33 +1633,23 @@ onewire_bus_reset_result_t perform_bus_reset(void) {
    * reading the line in standard mode, or no more than 70us for overdrive.
    * AN126: Parameter H
    */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(500);
-  } else {
-    bp_delay_us(70);
-  }
+  onewire_wait(onewire_timings->reset_low);
 
-  /* Release the bus. */
+  /* Release the bus, the presence pulse must be sampled on time. */
+  BP_MASK_HOST_LINK_INTERRUPTS(interrupt_level);
   ONEWIRE_DATA_DIRECTION = INPUT;
   /* AN126: Parameter I */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(65);
-  } else {
-    bp_delay_us(6);
-  }
+  onewire_wait(onewire_timings->presence_sample);
 
   /* Read the data line. */
   if (ONEWIRE_DATA_LINE) {
     /* If the data line is still high, no device is available on the bus. */
     result = ONEWIRE_BUS_RESET_NO_DEVICE;
   }
+  BP_RESTORE_INTERRUPT_LEVEL(interrupt_level);
 
   /* AN126: Parameter J */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(500);
-  } else {
-    bp_delay_us(32);
-  }
+  onewire_wait(onewire_timings->presence_recovery);
 
   /* Read the data line. */
   if (ONEWIRE_DATA_LINE == LOW) {
@@ -989,8 +1658,176 @@ onewire_bus_reset_result_t perform_bus_reset(void) {
   }
 
   return result;
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
+}
+
+onewire_bus_reset_result_t
+enter_overdrive_speed(const onewire_macros_t command) {
+  onewire_bus_reset_result_t result;
+
+  onewire_select_speed(ONEWIRE_SPEED_STANDARD);
+  result = perform_bus_reset();
+  if (result == ONEWIRE_BUS_RESET_OK) {
+    ONEWIRE_WRITE_BYTE(command);
+    onewire_select_speed(ONEWIRE_SPEED_OVERDRIVE);
+  }
+
+  return result;
+}
+
+void onewire_select_speed(const onewire_speed_t speed) {
+  mode_configuration.speed = speed;
+  onewire_timings = &ONEWIRE_TIMINGS[(speed == ONEWIRE_SPEED_OVERDRIVE)
+                                         ? ONEWIRE_SPEED_OVERDRIVE
+                                         : ONEWIRE_SPEED_STANDARD];
+#ifdef BP_1WIRE_UART_SLOT_TIMING
+  onewire_uart_rates =
+      &ONEWIRE_UART_RATES[(speed == ONEWIRE_SPEED_OVERDRIVE)
+                              ? ONEWIRE_SPEED_OVERDRIVE
+                              : ONEWIRE_SPEED_STANDARD];
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
+}
+
+void onewire_wait(const uint16_t cycles) {
+  if (cycles > 0) {
+    bp_delay_cycles(cycles);
+  }
+}
+
+#ifdef BP_1WIRE_HARDWARE_SLOT_TIMING
+
+void onewire_slot_start(const uint16_t release) {
+  T3CON = 0;
+  PR3 = 0xFFFF;
+  TMR3 = 0;
+
+#ifdef BUSPIRATEV4
+  /*
+   * OC4 and IC3 count instruction cycles on their own timers, cleared along
+   * with Timer 3 so all three agree on when the slot started.
+   */
+  OC4CON1 = 0;
+  OC4CON2 = 0;
+  IC3CON1 = 0;
+  IC3CON2 = 0;
+  OC4TMR = 0;
+  IC3TMR = 0;
+#else
+  OC4CON = 0;
+  IC3CON = 0;
+#endif /* BUSPIRATEV4 */
+
+  OC4R = release;
+  RPINR8bits.IC3R = BP_MOSI_RPIN;
+  BP_MOSI_ODC = ON;
+  BP_MOSI_RPOUT = OC4_IO;
+
+#ifdef BUSPIRATEV4
+  /* IC3: capture every rising edge, system clock. */
+  IC3CON1 = (0b111 << _IC3CON1_ICTSEL_POSITION) |
+            (0b011 << _IC3CON1_ICM_POSITION);
+  T3CON = ON << _T3CON_TON_POSITION;
+  /* OC4: single compare single-shot, start LOW, go HIGH on match. */
+  OC4CON1 = (0b111 << _OC4CON1_OCTSEL_POSITION) |
+            (0b001 << _OC4CON1_OCM_POSITION);
+#else
+  /* IC3: capture every rising edge, Timer 3. */
+  IC3CON = (OFF << _IC3CON_ICTMR_POSITION) | (0b011 << _IC3CON_ICM_POSITION);
+  T3CON = ON << _T3CON_TON_POSITION;
+  /* OC4: start LOW, go HIGH on match, Timer 3. */
+  OC4CON = (ON << _OC4CON_OCTSEL_POSITION) | (0b001 << _OC4CON_OCM_POSITION);
+#endif /* BUSPIRATEV4 */
+
+  /* The line goes LOW now, OC4 drives it open drain. */
+  ONEWIRE_DATA_DIRECTION = OUTPUT;
+}
+
+uint8_t onewire_slot_finish(const uint16_t end, uint16_t *last_edge) {
+  uint8_t edges;
+
+  while (TMR3 < end) {
+  }
+
+  /* Release the line before detaching OC4, LAT is still LOW. */
+  ONEWIRE_DATA_DIRECTION = INPUT;
+  BP_MOSI_RPOUT = 0;
+  BP_MOSI_ODC = OFF;
+
+  edges = 0;
+#ifdef BUSPIRATEV4
+  OC4CON1 = 0;
+  while (IC3CON1bits.ICBNE) {
+    *last_edge = IC3BUF;
+    edges++;
+  }
+  IC3CON1 = 0;
+#else
+  OC4CON = 0;
+  while (IC3CONbits.ICBNE) {
+    *last_edge = IC3BUF;
+    edges++;
+  }
+  IC3CON = 0;
+#endif /* BUSPIRATEV4 */
+  T3CON = 0;
+
+  return edges;
+}
+
+#endif /* BP_1WIRE_HARDWARE_SLOT_TIMING */
+
+#ifdef BP_1WIRE_UART_SLOT_TIMING
+
+void onewire_uart_attach(const uint16_t brg) {
+  U2MODE = 0;
+  U2STA = 0;
+  U2BRG = brg;
+
+  /* 8 data bits, no parity, one stop bit, high speed mode. */
+  U2MODE = 1 << _U2MODE_BRGH_POSITION;
+
+  /* The line stays released until UART2 starts driving it. */
+  ONEWIRE_DATA_LINE = HIGH;
+  BP_MOSI_ODC = ON;
+  RPINR19bits.U2RXR = BP_MOSI_RPIN;
+  BP_MOSI_RPOUT = U2TX_IO;
+  U2MODEbits.UARTEN = ON;
+  U2STAbits.UTXEN = ON;
+  ONEWIRE_DATA_DIRECTION = OUTPUT;
+}
+
+void onewire_uart_detach(void) {
+  ONEWIRE_DATA_DIRECTION = INPUT;
+  ONEWIRE_DATA_LINE = LOW;
+  BP_MOSI_RPOUT = 0;
+  RPINR19bits.U2RXR = 0b11111;
+  U2STAbits.UTXEN = OFF;
+  U2MODEbits.UARTEN = OFF;
+  BP_MOSI_ODC = OFF;
 }
 
+void onewire_uart_exchange(uint8_t *slots, const uint8_t count) {
+  uint8_t sent;
+  uint8_t received;
+
+  sent = 0;
+  received = 0;
+
+  while (received < count) {
+    while ((sent < count) && (U2STAbits.UTXBF == OFF) &&
+           ((uint8_t)(sent - received) < ONEWIRE_UART_FIFO_DEPTH)) {
+      U2TXREG = slots[sent++];
+    }
+
+    /* A framing error only means the line was still LOW at the stop bit. */
+    while (U2STAbits.URXDA == ON) {
+      slots[received++] = U2RXREG;
+    }
+  }
+}
+
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
+
 #ifdef BP_1WIRE_LOOKUP_FAMILY_ID
 
 void lookup_device_model(const uint8_t model) {
@@ -1051,6 +1888,7 @@ bool perform_device_search(void) {
   rom_byte_mask = 1;
   search_result = 0;
   onewire_state.crc8 = 0;
+  onewire_state.search_failed = false;
 
   /* Check if the bus enumeration is still in progress. */
 
@@ -1062,6 +1900,7 @@ bool perform_device_search(void) {
       onewire_state.last_device_discrepancy = 0;
       onewire_state.last_family_discrepancy = 0;
       onewire_state.last_device_flag = false;
+      onewire_state.search_failed = true;
 
       return false;
     }
@@ -1167,6 +2006,10 @@ bool perform_device_search(void) {
 
       search_result = true;
     }
+
+    /* A collision, a short read, or a bad CRC. */
+
+    onewire_state.search_failed = !search_result || !onewire_state.rom_bytes[0];
   }
 
   /* No device was found, so reset search state to a clean slate. */
@@ -1181,11 +2024,188 @@ bool perform_device_search(void) {
   return search_result;
 }
 
+void binary_io_enumerate_devices(const uint8_t *resume_rom,
+                                 const uint8_t resume_token) {
+  bool next;
+  size_t index;
+
+  onewire_state.command_byte = MACRO_SEARCH_ROM;
+
+  if (resume_rom[0] == 0) {
+    next = device_find_first();
+  } else if (resume_token == 0) {
+    /* The resume point was already the last device on the bus. */
+    onewire_state.search_failed = false;
+    next = false;
+  } else {
+    memcpy(onewire_state.rom_bytes, resume_rom, ROM_BYTES_SIZE);
+    onewire_state.last_device_discrepancy = resume_token;
+    onewire_state.last_family_discrepancy = 0;
+    onewire_state.last_device_flag = false;
+    next = device_find_next();
+  }
+
+  while (next) {
+    bp_write_buffer(&onewire_state.rom_bytes[0],
+                    sizeof(onewire_state.rom_bytes));
+    user_serial_transmit_character(onewire_state.last_device_discrepancy);
+    next = device_find_next();
+  }
+
+  for (index = 0; index < ROM_BYTES_SIZE; index++) {
+    user_serial_transmit_character(0xFF);
+  }
+
+  if (onewire_state.search_failed) {
+    REPORT_IO_FAILURE();
+  } else {
+    REPORT_IO_SUCCESS();
+  }
+}
+
 uint8_t update_crc8(const uint8_t value) {
   onewire_state.crc8 = CRC_TABLE[onewire_state.crc8 ^ value];
   return onewire_state.crc8;
 }
 
+uint16_t update_crc16(const uint16_t crc, const uint8_t value) {
+  return (crc >> 8) ^ CRC16_TABLE[(crc ^ value) & 0xFF];
+}
+
+void binary_io_checked_read(const bool use_crc16) {
+  uint16_t length;
+  uint16_t index;
+  uint16_t crc16;
+  uint8_t *buffer;
+  bool valid;
+
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+  if (use_crc16) {
+    crc16 = user_serial_read_byte();
+    crc16 |= user_serial_read_byte() << 8;
+  } else {
+    onewire_state.crc8 = user_serial_read_byte();
+  }
+
+  if (length > BP_TERMINAL_BUFFER_SIZE) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  buffer = bus_pirate_configuration.terminal_input;
+  for (index = 0; index < length; index++) {
+    buffer[index] = ONEWIRE_READ_BYTE();
+  }
+
+  if (use_crc16) {
+    uint16_t received;
+
+    for (index = 0; index < length; index++) {
+      crc16 = update_crc16(crc16, buffer[index]);
+    }
+    received = ONEWIRE_READ_BYTE();
+    received |= ONEWIRE_READ_BYTE() << 8;
+    valid = (received == (uint16_t)~crc16);
+  } else {
+    for (index = 0; index < length; index++) {
+      update_crc8(buffer[index]);
+    }
+    valid = (update_crc8(ONEWIRE_READ_BYTE()) == 0);
+  }
+
+  if (!valid) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  bp_write_buffer(buffer, length);
+}
+
+void binary_io_temperature_batch(void) {
+  uint8_t flags;
+  uint16_t conversion_time;
+  uint8_t devices;
+  uint8_t *roms;
+  uint8_t scratchpad[DS18X20_SCRATCHPAD_SIZE];
+  size_t record_size;
+  size_t device;
+  size_t index;
+
+  flags = user_serial_read_byte();
+  conversion_time = user_serial_read_byte() << 8;
+  conversion_time |= user_serial_read_byte();
+  devices = user_serial_read_byte();
+
+  /* 255 entries always fit in the terminal buffer. */
+  roms = bus_pirate_configuration.terminal_input;
+  for (index = 0; index < (devices * ROM_BYTES_SIZE); index++) {
+    roms[index] = user_serial_read_byte();
+  }
+
+  /* Start every conversion at once. */
+
+  if (perform_bus_reset() != ONEWIRE_BUS_RESET_OK) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  ONEWIRE_WRITE_BYTE(MACRO_SKIP_ROM);
+  ONEWIRE_WRITE_BYTE(DS18X20_CONVERT_T);
+
+  if (flags & TEMPERATURE_BATCH_STRONG_PULLUP) {
+    bool cs_direction;
+    bool cs_level;
+
+    cs_direction = BP_CS_DIR;
+    cs_level = BP_CS;
+    BP_CS = LOW;
+    BP_CS_DIR = OUTPUT;
+    bp_delay_ms(conversion_time);
+    BP_CS = cs_level;
+    BP_CS_DIR = cs_direction;
+  } else {
+    bp_delay_ms(conversion_time);
+  }
+
+  REPORT_IO_SUCCESS();
+
+  /* Collect the results, one record per device. */
+
+  record_size = (flags & TEMPERATURE_BATCH_FULL_SCRATCHPAD)
+                    ? DS18X20_SCRATCHPAD_SIZE
+                    : 2;
+  for (device = 0; device < devices; device++) {
+    bool valid;
+
+    valid = (perform_bus_reset() == ONEWIRE_BUS_RESET_OK);
+    if (valid) {
+      ONEWIRE_WRITE_BYTE(MACRO_MATCH_ROM);
+      for (index = 0; index < ROM_BYTES_SIZE; index++) {
+        ONEWIRE_WRITE_BYTE(roms[(device * ROM_BYTES_SIZE) + index]);
+      }
+      ONEWIRE_WRITE_BYTE(DS18X20_READ_SCRATCHPAD);
+
+      onewire_state.crc8 = 0;
+      for (index = 0; index < DS18X20_SCRATCHPAD_SIZE; index++) {
+        scratchpad[index] = ONEWIRE_READ_BYTE();
+        update_crc8(scratchpad[index]);
+      }
+      valid = (update_crc8(ONEWIRE_READ_BYTE()) == 0);
+    }
+
+    if (valid) {
+      REPORT_IO_SUCCESS();
+      bp_write_buffer(scratchpad, record_size);
+    } else {
+      REPORT_IO_FAILURE();
+      for (index = 0; index < record_size; index++) {
+        user_serial_transmit_character(0x00);
+      }
+    }
+  }
+}
+
 void binary_io_enter_1wire_mode(void) {
   uint8_t input_byte;
   uint8_t command;
@@ -1201,6 +2221,7 @@ void binary_io_enter_1wire_mode(void) {
   /* Just in case. */
 
   mode_configuration.little_endian = NO;
+  onewire_select_speed(ONEWIRE_SPEED_STANDARD);
 
   /* Send version string. */
 
@@ -1208,6 +2229,8 @@ void binary_io_enter_1wire_mode(void) {
 
   for (;;) {
     input_byte = user_serial_read_byte();
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_1WIRE, input_byte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
     command = input_byte >> 4;
 
     switch (command) {
@@ -1220,15 +2243,58 @@ void binary_io_enter_1wire_mode(void) {
         MSG_1WIRE_MODE_IDENTIFIER;
         break;
 
-      case BINARY_IO_ONEWIRE_ACTION_BUS_RESET:
-        perform_bus_reset();
+      case BINARY_IO_ONEWIRE_ACTION_BUS_RESET: {
+        onewire_bus_reset_result_t reset_result = perform_bus_reset();
+
+        BP_FLIGHT_RECORDER_LOG(
+            BP_FLIGHT_RECORDER_MODE_1WIRE | BP_FLIGHT_RECORDER_BUS_EVENT,
+            BP_FLIGHT_RECORDER_EVENT_1WIRE_RESET, 0, reset_result);
+        (void)reset_result;
         REPORT_IO_SUCCESS();
         break;
+      }
 
       case BINARY_IO_ONEWIRE_ACTION_READ_BYTE:
         user_serial_transmit_character(ONEWIRE_READ_BYTE());
         break;
 
+      case BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC8:
+      case BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16:
+        binary_io_checked_read(input_byte ==
+                               BINARY_IO_ONEWIRE_ACTION_CHECKED_READ_CRC16);
+        break;
+
+      case BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_SKIP_ROM:
+        if (enter_overdrive_speed(MACRO_OVERDRIVE_SKIP_ROM) ==
+            ONEWIRE_BUS_RESET_OK) {
+          REPORT_IO_SUCCESS();
+        } else {
+          REPORT_IO_FAILURE();
+        }
+        break;
+
+      case BINARY_IO_ONEWIRE_ACTION_OVERDRIVE_MATCH_ROM: {
+        uint8_t rom_address[ROM_BYTES_SIZE];
+        size_t index;
+
+        for (index = 0; index < ROM_BYTES_SIZE; index++) {
+          rom_address[index] = user_serial_read_byte();
+        }
+
+        if (enter_overdrive_speed(MACRO_OVERDRIVE_MATCH_ROM) !=
+            ONEWIRE_BUS_RESET_OK) {
+          REPORT_IO_FAILURE();
+          break;
+        }
+
+        /* The address already goes out at overdrive speed. */
+        for (index = 0; index < ROM_BYTES_SIZE; index++) {
+          ONEWIRE_WRITE_BYTE(rom_address[index]);
+        }
+        REPORT_IO_SUCCESS();
+        break;
+      }
+
       case BINARY_IO_ONEWIRE_ACTION_ROM_SEARCH_MACRO:
       case BINARY_IO_ONEWIRE_ACTION_ALARM_SEARCH_MACRO: {
         bool next;
@@ -1260,6 +2326,29 @@ void binary_io_enter_1wire_mode(void) {
         break;
       }
 
+      case BINARY_IO_ONEWIRE_ACTION_TEMPERATURE_BATCH:
+        binary_io_temperature_batch();
+        break;
+
+      case BINARY_IO_ONEWIRE_ACTION_TELEMETRY:
+        bp_binary_io_send_telemetry();
+        break;
+
+      case BINARY_IO_ONEWIRE_ACTION_ROM_ENUMERATE: {
+        uint8_t resume_rom[ROM_BYTES_SIZE];
+        uint8_t resume_token;
+        size_t index;
+
+        for (index = 0; index < ROM_BYTES_SIZE; index++) {
+          resume_rom[index] = user_serial_read_byte();
+        }
+        resume_token = user_serial_read_byte();
+        REPORT_IO_SUCCESS();
+
+        binary_io_enumerate_devices(resume_rom, resume_token);
+        break;
+      }
+
       default:
         REPORT_IO_FAILURE();
         break;
@@ -1281,7 +2370,7 @@ void binary_io_enter_1wire_mode(void) {
     }
 
     case BINARY_IO_ONEWIRE_COMMAND_CONFIGURE:
-      mode_configuration.speed = (input_byte & 1);
+      onewire_select_speed(input_byte & 1);
       user_serial_transmit_character(BP_BINARY_IO_RESULT_SUCCESS);
       break;
 
@@ -1304,23 +2393,61 @@ void binary_io_enter_1wire_mode(void) {
 }
 
 bool onewire_internal_bit_io(bool bit_value) {
+#if defined(BP_1WIRE_UART_SLOT_TIMING)
+  uint8_t slot;
+
+  /* AN126: Parameters A to F all come from the UART2 character timing. */
+  slot = bit_value ? 0xFF : 0x00;
+  onewire_uart_attach(onewire_uart_rates->slot_brg);
+  onewire_uart_exchange(&slot, 1);
+  onewire_uart_detach();
+
+  return bit_value && (slot == 0xFF);
+#elif defined(BP_1WIRE_HARDWARE_SLOT_TIMING)
+  uint16_t sample;
+  uint16_t last_edge;
+  uint8_t edges;
+
+  /* AN126: Parameters A and E. */
+  sample = onewire_timings->slot_start + onewire_timings->read_sample;
+
+  if (bit_value) {
+    /*
+     * Release the line early: a device sending a 0 keeps it LOW past the
+     * sampling point, which IC3 sees as a late rising edge.
+     * AN126: Parameter F.
+     */
+    onewire_slot_start(onewire_timings->slot_start);
+    edges = onewire_slot_finish(sample + onewire_timings->read_recovery +
+                                    onewire_timings->slot_padding,
+                                &last_edge);
+    return (edges > 0) && (last_edge < onewire_timings->read_threshold);
+  }
+
+  /* AN126: Parameters C and D. */
+  onewire_slot_start(sample + onewire_timings->write_zero_low);
+  onewire_slot_finish(sample + onewire_timings->write_zero_low +
+                          onewire_timings->write_zero_recovery +
+                          onewire_timings->slot_padding,
+                      &last_edge);
+  return false;
+#else
+  uint16_t interrupt_level;
+
+  /* The host link must not stretch the time slot. */
+  BP_MASK_HOST_LINK_INTERRUPTS(interrupt_level);
+
   ONEWIRE_DATA_DIRECTION = INPUT;
   ONEWIRE_DATA_LINE = LOW;
   ONEWIRE_DATA_DIRECTION = OUTPUT;
 
   /* AN126: Parameter A */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(4);
-  } else {
-    bp_delay_us(1);
-  }
+  onewire_wait(onewire_timings->slot_start);
   if (bit_value) {
     ONEWIRE_DATA_DIRECTION = INPUT;
   }
   /* AN126: Parameter E */
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(8);
-  }
+  onewire_wait(onewire_timings->read_sample);
 
   /*
    * This is where the magic happens. If a bit_value value of 1 is sent to this
@@ -1334,38 +2461,49 @@ bool onewire_internal_bit_io(bool bit_value) {
   if (bit_value) {
     bit_value = ONEWIRE_DATA_LINE;
     /* AN126: Parameter F */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(32);
-    } else {
-      bp_delay_us(6);
-    }
+    onewire_wait(onewire_timings->read_recovery);
   } else {
     /* AN126: Parameter C */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(25);
-    } else {
-      bp_delay_us(4);
-    }
+    onewire_wait(onewire_timings->write_zero_low);
     ONEWIRE_DATA_DIRECTION = INPUT;
     /* AN126: Parameter D */
-    if (mode_configuration.speed == 0) {
-      bp_delay_us(7);
-    } else {
-      bp_delay_us(2);
-    }
+    onewire_wait(onewire_timings->write_zero_recovery);
   }
 
   /* Adjust timing to take 70us per bit for standard mode. */
+  onewire_wait(onewire_timings->slot_padding);
 
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(5);
-  }
+  BP_RESTORE_INTERRUPT_LEVEL(interrupt_level);
 
   return bit_value;
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
 }
 
 uint8_t onewire_internal_byte_io(uint8_t byte_value) {
   uint8_t bit_index;
+
+#ifdef BP_1WIRE_UART_SLOT_TIMING
+  uint8_t slots[8];
+
+  /* All eight slots go out back to back. */
+  for (bit_index = 0; bit_index < 8; bit_index++) {
+    slots[bit_index] = (byte_value & (1 << bit_index)) ? 0xFF : 0x00;
+  }
+  onewire_uart_attach(onewire_uart_rates->slot_brg);
+  onewire_uart_exchange(slots, sizeof(slots));
+  onewire_uart_detach();
+
+  byte_value = 0;
+  for (bit_index = 0; bit_index < 8; bit_index++) {
+    if (slots[bit_index] == 0xFF) {
+      byte_value |= 1 << bit_index;
+    }
+  }
+
+  onewire_wait(onewire_timings->byte_padding);
+
+  return byte_value;
+#else
   uint8_t current_bit;
 
   current_bit = 0;
@@ -1387,11 +2525,10 @@ uint8_t onewire_internal_byte_io(uint8_t byte_value) {
     }
   }
 
-  if (mode_configuration.speed == 0) {
-    bp_delay_us(8);
-  }
+  onewire_wait(onewire_timings->byte_padding);
 
   return byte_value;
+#endif /* BP_1WIRE_UART_SLOT_TIMING */
 }
 
 void onewire_internal_set_data_state(const bool state) {
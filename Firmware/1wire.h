@@ -43,6 +43,7 @@
 #ifdef BP_ENABLE_1WIRE_SUPPORT
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -67,6 +68,22 @@ uint16_t onewire_read(void);
  */
 uint16_t onewire_write(const uint16_t data);
 
+/**
+ * @brief Sends the given bytes to the bus.
+ *
+ * @param[in] buffer the bytes to send.
+ * @param[in] length how many bytes to send.
+ */
+void onewire_send_buffer(const uint8_t *buffer, const size_t length);
+
+/**
+ * @brief Reads the given number of bytes from the bus.
+ *
+ * @param[out] buffer where to store the bytes read.
+ * @param[in]  length how many bytes to read.
+ */
+void onewire_read_buffer(uint8_t *buffer, const size_t length);
+
 /**
  * @brief Reads one bit from the data bus.
  *
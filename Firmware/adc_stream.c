@@ -0,0 +1,398 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate. This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "adc_stream.h"
+
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+
+#include "base.h"
+#include "binary_io.h"
+#include "buffer_arena.h"
+#include "core.h"
+
+/**
+ * Most blocks the ring can hold, head and tail being eight bits wide.
+ */
+#define ADC_STREAM_MAXIMUM_BLOCKS 255
+
+/**
+ * Fewest blocks the ring can work with, one block always being kept free to
+ * tell a full ring from an empty one.
+ */
+#define ADC_STREAM_MINIMUM_BLOCKS 2
+
+/**
+ * How many conversions end up in each half of the ADC result buffer before
+ * the interrupt fires.
+ */
+#define ADC_STREAM_BATCH_SAMPLES 8
+
+/**
+ * Timer #3 ticks per microsecond, with a 1:8 prescaler.
+ */
+#define ADC_STREAM_TICKS_PER_US ((FCY / 8) / 1000000UL)
+
+/**
+ * Inputs sampled in scan mode.
+ */
+#define ADC_STREAM_SCAN_MASK                                                   \
+  ((1 << BP_ADC_PROBE) | (1 << BP_ADC_3V3) | (1 << BP_ADC_5V0) |               \
+   (1 << BP_ADC_VPU))
+
+/**
+ * Order in which the ADC goes through the inputs in scan mode, from the
+ * lowest analog channel number up.
+ */
+static const uint8_t ADC_STREAM_SCAN_ORDER[ADC_STREAM_SCAN_CHANNELS] = {
+#ifdef BUSPIRATEV3
+    ADC_STREAM_CHANNEL_5V0, ADC_STREAM_CHANNEL_3V3, ADC_STREAM_CHANNEL_VPU,
+    ADC_STREAM_CHANNEL_PROBE
+#else
+    ADC_STREAM_CHANNEL_3V3, ADC_STREAM_CHANNEL_PROBE, ADC_STREAM_CHANNEL_5V0,
+    ADC_STREAM_CHANNEL_VPU
+#endif /* BUSPIRATEV3 */
+};
+
+/**
+ * Block ring state, shared between adc_stream_run() and the ADC interrupt.
+ */
+static struct {
+  /** Blocks storage, reserved from the buffer arena. */
+  uint8_t *blocks;
+
+  /** Size of each block, in bytes. */
+  size_t block_size;
+
+  /** How many blocks the ring holds. */
+  uint8_t block_count;
+
+  /** Block being filled by the interrupt handler. */
+  volatile uint8_t head;
+
+  /** Next block to send to the host. */
+  volatile uint8_t tail;
+
+  /** Offset of the next free byte in the block being filled. */
+  uint8_t offset;
+
+  /** Whether samples were dropped since the last block was started. */
+  bool overrun;
+
+  /** Whether the interrupt decimates samples instead of packing them. */
+  bool decimate;
+
+  /** Input of a sample from its position in the ADC result buffer. */
+  uint8_t channel_mask;
+
+  /** Samples per input in a decimated block, as a power of two. */
+  uint8_t shift;
+
+  /** Samples per input accumulated so far for the current block. */
+  uint16_t count;
+
+  /** Running minimum, maximum and sum of the current block, per input. */
+  struct {
+    uint16_t minimum;
+    uint16_t maximum;
+    uint32_t sum;
+  } accumulators[ADC_STREAM_SCAN_CHANNELS];
+} adc_stream_state;
+
+/**
+ * Packs the finished half of the ADC result buffer into the current block.
+ */
+static void adc_stream_collect(void);
+
+/**
+ * Folds the finished half of the ADC result buffer into the accumulators,
+ * and turns them into a block once they hold enough samples.
+ */
+static void adc_stream_accumulate(void);
+
+/**
+ * Moves the ring head on to the next block, unless the host is too far
+ * behind, in which case the current block is filled again.
+ */
+static void adc_stream_next_block(void);
+
+/**
+ * Resets the accumulators for a new decimated block.
+ */
+static void adc_stream_reset_accumulators(void);
+
+/**
+ * ADC interrupt handler, registered while a stream runs.
+ */
+static void adc_stream_interrupt(void);
+
+/**
+ * Reserves as many blocks as the buffer arena can hold, then sets up timer #3
+ * and the ADC, and streams blocks until a byte is received from the serial
+ * port.  0x01 is sent once the blocks are reserved, or 0x00 if fewer than
+ * ADC_STREAM_MINIMUM_BLOCKS fit, in which case nothing else is touched.
+ *
+ * @param[in] period the sampling period, in microseconds.
+ * @param[in] scan true to sample all inputs, false for the probe pin only.
+ */
+static void adc_stream_pump(const uint16_t period, const bool scan);
+
+void adc_stream_collect(void) {
+  const volatile uint16_t *samples;
+  uint8_t *output;
+  size_t index;
+
+  /* BUFS is set while the ADC fills the upper half. */
+  samples = (AD1CON2bits.BUFS == ON) ? &ADC1BUF0 : &ADC1BUF8;
+
+  output = &adc_stream_state.blocks[adc_stream_state.head *
+                                    ADC_STREAM_BLOCK_SIZE];
+  if (adc_stream_state.offset == 0) {
+    output[0] = adc_stream_state.overrun ? ADC_STREAM_STATUS_OVERRUN : 0x00;
+    adc_stream_state.overrun = false;
+    adc_stream_state.offset = 1;
+  }
+  output += adc_stream_state.offset;
+
+  for (index = 0; index < ADC_STREAM_BATCH_SAMPLES; index += 4) {
+    output[0] = samples[index] & 0xFF;
+    output[1] = samples[index + 1] & 0xFF;
+    output[2] = samples[index + 2] & 0xFF;
+    output[3] = samples[index + 3] & 0xFF;
+    output[4] = ((samples[index] >> 8) & 0x03) |
+                (((samples[index + 1] >> 8) & 0x03) << 2) |
+                (((samples[index + 2] >> 8) & 0x03) << 4) |
+                (((samples[index + 3] >> 8) & 0x03) << 6);
+    output += 5;
+  }
+  adc_stream_state.offset += (ADC_STREAM_BATCH_SAMPLES / 4) * 5;
+
+  if (adc_stream_state.offset < ADC_STREAM_BLOCK_SIZE) {
+    return;
+  }
+
+  adc_stream_state.offset = 0;
+  adc_stream_next_block();
+}
+
+void adc_stream_accumulate(void) {
+  const volatile uint16_t *samples;
+  uint8_t *output;
+  size_t index;
+
+  samples = (AD1CON2bits.BUFS == ON) ? &ADC1BUF0 : &ADC1BUF8;
+
+  for (index = 0; index < ADC_STREAM_BATCH_SAMPLES; index++) {
+    uint16_t sample = samples[index];
+
+    /* The buffer holds whole scans, so its position gives the input. */
+    uint8_t channel = index & adc_stream_state.channel_mask;
+    if (sample < adc_stream_state.accumulators[channel].minimum) {
+      adc_stream_state.accumulators[channel].minimum = sample;
+    }
+    if (sample > adc_stream_state.accumulators[channel].maximum) {
+      adc_stream_state.accumulators[channel].maximum = sample;
+    }
+    adc_stream_state.accumulators[channel].sum += sample;
+  }
+  adc_stream_state.count +=
+      ADC_STREAM_BATCH_SAMPLES / (adc_stream_state.channel_mask + 1);
+
+  if (adc_stream_state.count < (1U << adc_stream_state.shift)) {
+    return;
+  }
+
+  output = &adc_stream_state.blocks[adc_stream_state.head *
+                                    adc_stream_state.block_size];
+  *output++ = adc_stream_state.overrun ? ADC_STREAM_STATUS_OVERRUN : 0x00;
+  adc_stream_state.overrun = false;
+  for (index = 0; index <= adc_stream_state.channel_mask; index++) {
+    uint32_t sum = adc_stream_state.accumulators[index].sum;
+    uint16_t values[4];
+    size_t value;
+
+    values[0] = adc_stream_state.accumulators[index].minimum;
+    values[1] = adc_stream_state.accumulators[index].maximum;
+    values[2] = (sum + (1UL << (adc_stream_state.shift - 1))) >>
+                adc_stream_state.shift;
+    /* Every four times as many samples buy one more bit. */
+    values[3] = sum >> ((adc_stream_state.shift + 1) >> 1);
+    for (value = 0; value < 4; value++) {
+      *output++ = values[value] >> 8;
+      *output++ = values[value] & 0xFF;
+    }
+  }
+
+  adc_stream_reset_accumulators();
+  adc_stream_next_block();
+}
+
+void adc_stream_next_block(void) {
+  uint8_t next = adc_stream_state.head + 1;
+  if (next == adc_stream_state.block_count) {
+    next = 0;
+  }
+  if (next == adc_stream_state.tail) {
+    /* Ring full, this block will be filled again. */
+    adc_stream_state.overrun = true;
+    bp_notify(BP_NOTIFICATION_OVERFLOW);
+  } else {
+    adc_stream_state.head = next;
+  }
+}
+
+void adc_stream_reset_accumulators(void) {
+  size_t index;
+
+  for (index = 0; index < ADC_STREAM_SCAN_CHANNELS; index++) {
+    adc_stream_state.accumulators[index].minimum = UINT16_MAX;
+    adc_stream_state.accumulators[index].maximum = 0;
+    adc_stream_state.accumulators[index].sum = 0;
+  }
+  adc_stream_state.count = 0;
+}
+
+void adc_stream_run(const uint16_t period, const bool scan) {
+  adc_stream_state.decimate = false;
+  adc_stream_state.block_size = ADC_STREAM_BLOCK_SIZE;
+  adc_stream_pump(period, scan);
+}
+
+void adc_stream_decimate(const uint16_t period, const bool scan,
+                         const uint8_t shift) {
+  adc_stream_state.decimate = true;
+  adc_stream_state.channel_mask = scan ? (ADC_STREAM_SCAN_CHANNELS - 1) : 0;
+  adc_stream_state.shift = shift;
+  adc_stream_state.block_size =
+      ADC_DECIMATE_BLOCK_SIZE(adc_stream_state.channel_mask + 1);
+  adc_stream_reset_accumulators();
+  adc_stream_pump(period, scan);
+}
+
+void adc_stream_pump(const uint16_t period, const bool scan) {
+  size_t block_count;
+
+  block_count = bp_buffer_arena_largest_free() / adc_stream_state.block_size;
+  if (block_count > ADC_STREAM_MAXIMUM_BLOCKS) {
+    block_count = ADC_STREAM_MAXIMUM_BLOCKS;
+  }
+  adc_stream_state.blocks =
+      (block_count >= ADC_STREAM_MINIMUM_BLOCKS)
+          ? bp_buffer_arena_reserve(block_count * adc_stream_state.block_size)
+          : NULL;
+  if (adc_stream_state.blocks == NULL) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  REPORT_IO_SUCCESS();
+
+  adc_stream_state.block_count = block_count;
+  adc_stream_state.head = 0;
+  adc_stream_state.tail = 0;
+  adc_stream_state.offset = 0;
+  adc_stream_state.overrun = false;
+
+  /*
+   * T3CON - TIMER 3 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------01---0-
+   * | |      ||   |
+   * | |      ||   +---- TCS:   Internal clock (Fosc/2).
+   * | |      ++-------- TCKPS: 1:8 Prescaler.
+   * | +---------------- TSIDL: Continue module operation in idle mode.
+   * +------------------ TON:   Timer OFF.
+   */
+  T3CON = 0x0010;
+  TMR3 = 0;
+  PR3 = (period * ADC_STREAM_TICKS_PER_US) - 1;
+
+  if (scan) {
+    user_serial_write_stream(ADC_STREAM_SCAN_ORDER,
+                             sizeof(ADC_STREAM_SCAN_ORDER));
+    AD1CSSL = ADC_STREAM_SCAN_MASK;
+  } else {
+    AD1CHS = BP_ADC_PROBE;
+  }
+
+  /*
+   * AD1CON2 : A/D CONTROL REGISTER 2
+   *
+   * MSB
+   * 000--0--x-011110
+   * |||  |    ||||||
+   * |||  |    |||||+-- ALTS:  Use MUX A input settings.
+   * |||  |    ||||+--- BUFM:  Buffer is two 8-words halves.
+   * |||  |    ++++---- SMPI:  Interrupt every 8th sample conversion.
+   * |||  +------------ CSCNA: Do not scan inputs.
+   * +++--------------- VCFG:  VR+ is AVdd and VR- is AVss.
+   */
+  AD1CON2 = 0x001E;
+  if (scan) {
+    /*
+     * The scanning sequence uses MUX A and restarts after each interrupt,
+     * 8 conversions being two scans of the four inputs.
+     */
+    AD1CON2bits.CSCNA = ON;
+  }
+
+  /* Conversions are started by timer #3, sampling restarts right after. */
+  AD1CON1bits.SSRC = 0b010;
+  AD1CON1bits.ASAM = ON;
+
+  IFS0bits.AD1IF = OFF;
+  bp_set_adc_interrupt_handler(adc_stream_interrupt);
+  IEC0bits.AD1IE = ON;
+  bp_enable_adc();
+  T3CONbits.TON = ON;
+
+  while (!user_serial_ready_to_read()) {
+    if (adc_stream_state.tail != adc_stream_state.head) {
+      uint8_t tail = adc_stream_state.tail;
+
+      user_serial_write_stream(
+          &adc_stream_state.blocks[tail * adc_stream_state.block_size],
+          adc_stream_state.block_size);
+      tail++;
+      adc_stream_state.tail =
+          (tail == adc_stream_state.block_count) ? 0 : tail;
+    }
+  }
+  user_serial_read_byte();
+
+  /* Put the ADC back as bp_reset_board_state() leaves it. */
+  T3CON = 0x0000;
+  IEC0bits.AD1IE = OFF;
+  bp_set_adc_interrupt_handler(NULL);
+  bp_disable_adc();
+  AD1CON1bits.ASAM = OFF;
+  AD1CON1bits.SSRC = 0b111;
+  AD1CON2 = 0x0000;
+  AD1CSSL = 0x0000;
+  IFS0bits.AD1IF = OFF;
+
+  bp_buffer_arena_release(adc_stream_state.blocks);
+}
+
+void adc_stream_interrupt(void) {
+  if (adc_stream_state.decimate) {
+    adc_stream_accumulate();
+  } else {
+    adc_stream_collect();
+  }
+}
+
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
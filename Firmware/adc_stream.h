@@ -0,0 +1,149 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef BP_ADC_STREAM_H
+#define BP_ADC_STREAM_H
+
+#include "configuration.h"
+
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Shortest sampling period accepted by adc_stream_run(), in microseconds.
+ */
+#define ADC_STREAM_MINIMUM_PERIOD 4
+
+/**
+ * Longest sampling period accepted by adc_stream_run(), in microseconds.
+ */
+#define ADC_STREAM_MAXIMUM_PERIOD 32767
+
+/**
+ * How many samples each streamed block carries.
+ */
+#define ADC_STREAM_BLOCK_SAMPLES 64
+
+/**
+ * Size of a streamed block, in bytes: a status byte followed by the samples,
+ * packed four at a time in five bytes.
+ */
+#define ADC_STREAM_BLOCK_SIZE (1 + ((ADC_STREAM_BLOCK_SAMPLES / 4) * 5))
+
+/**
+ * Block status flag set when samples were thrown away before this block
+ * because the host did not read them fast enough.
+ */
+#define ADC_STREAM_STATUS_OVERRUN 0x01
+
+/**
+ * How many inputs are sampled in scan mode.
+ */
+#define ADC_STREAM_SCAN_CHANNELS 4
+
+/**
+ * Smallest number of samples per input in a decimated block, as a power of
+ * two.
+ */
+#define ADC_DECIMATE_MINIMUM_SHIFT 3
+
+/**
+ * Largest number of samples per input in a decimated block, as a power of
+ * two: the oversampled value takes all 16 bits then.
+ */
+#define ADC_DECIMATE_MAXIMUM_SHIFT 12
+
+/**
+ * Binary I/O decimation command flag asking for all inputs to be sampled.
+ */
+#define ADC_DECIMATE_SCAN 0x01
+
+/**
+ * Size of a decimated block, in bytes: a status byte followed by the
+ * minimum, maximum, mean and oversampled value of each input, 16 bits each.
+ */
+#define ADC_DECIMATE_BLOCK_SIZE(channels) (1 + ((channels)*8))
+
+/**
+ * Input identifiers sent at the start of a scan mode stream.
+ */
+typedef enum {
+  ADC_STREAM_CHANNEL_PROBE = 0,
+  ADC_STREAM_CHANNEL_3V3,
+  ADC_STREAM_CHANNEL_5V0,
+  ADC_STREAM_CHANNEL_VPU
+} adc_stream_channel_t;
+
+/**
+ * Samples the probe pin, or all of the probe pin and the 3.3V, 5V and VPU
+ * rails, at a fixed rate and streams the samples to the serial port in
+ * blocks, until a byte is received from the serial port.
+ *
+ * Conversions are triggered by timer #3, and collected by the ADC interrupt
+ * handler in a block ring kept in the terminal buffer, so the interval
+ * between two samples does not depend on how fast the serial port is.  Each
+ * block is ADC_STREAM_BLOCK_SIZE bytes long: a status byte first, then groups
+ * of five bytes, each holding the lower eight bits of four samples followed
+ * by a byte with their upper two bits (first sample in bits 0-1).
+ *
+ * In scan mode the ADC goes through the four inputs in one sequence, one per
+ * conversion, so each group of four samples is one full scan.  The order of
+ * the inputs within a scan depends on the board, and is sent first as
+ * ADC_STREAM_SCAN_CHANNELS adc_stream_channel_t bytes.  Each input is then
+ * sampled every ADC_STREAM_SCAN_CHANNELS * period microseconds.
+ *
+ * 0x01 is sent before the stream starts, or 0x00 if the buffer arena has no
+ * room left for the blocks ring.
+ *
+ * @warning the period must be between ADC_STREAM_MINIMUM_PERIOD and
+ * ADC_STREAM_MAXIMUM_PERIOD.
+ *
+ * @param[in] period the sampling period, in microseconds.
+ * @param[in] scan true to sample all inputs, false for the probe pin only.
+ */
+void adc_stream_run(const uint16_t period, const bool scan);
+
+/**
+ * Samples the same inputs at the same rate as adc_stream_run(), but
+ * streams one summary per 2^shift samples of each input instead of the
+ * samples themselves, so the host can watch a rail for hours at a small
+ * fraction of the bandwidth.
+ *
+ * Each block is ADC_DECIMATE_BLOCK_SIZE bytes long: a status byte, then
+ * for each input, in scan order, the minimum, the maximum, the rounded mean
+ * and the oversampled value of its samples, MSB first.  The oversampled
+ * value is the sum of the samples shifted right by (shift + 1) / 2 bits,
+ * so it has 10 + shift / 2 significant bits.  The scan order is sent
+ * first in scan mode, and the start of the stream is answered, as with
+ * adc_stream_run().
+ *
+ * @warning the period must be between ADC_STREAM_MINIMUM_PERIOD and
+ * ADC_STREAM_MAXIMUM_PERIOD, and shift between ADC_DECIMATE_MINIMUM_SHIFT and
+ * ADC_DECIMATE_MAXIMUM_SHIFT.
+ *
+ * @param[in] period the sampling period, in microseconds.
+ * @param[in] scan true to sample all inputs, false for the probe pin only.
+ * @param[in] shift the samples per input in a block, as a power of two.
+ */
+void adc_stream_decimate(const uint16_t period, const bool scan,
+                         const uint8_t shift);
+
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+
+#endif /* !BP_ADC_STREAM_H */
@@ -24,6 +24,8 @@
 
 #include "aux_pin.h"
 #include "base.h"
+#include "binary_io.h"
+#include "core.h"
 #include "proc_menu.h"
 
 #define AUXPIN_DIR BP_AUX0_DIR
@@ -61,6 +63,73 @@ static uint32_t poll_frequency_counter_value(void);
  */
 static uint32_t average_sample_frequency(const uint16_t count);
 
+/**
+ * @brief Starts timestamping rising edges on the AUX pin.
+ *
+ * Input capture #1 and #2 latch the two halves of a free running 32 bits
+ * timer clocked at FCY on every rising edge, so each edge gets a single cycle
+ * resolution timestamp.
+ */
+static void start_edge_capture(void);
+
+/**
+ * @brief Stops the input capture units and timer started by
+ * start_edge_capture().
+ */
+static void stop_edge_capture(void);
+
+/**
+ * @brief Waits for the next rising edge on the AUX pin.
+ *
+ * @param[out] timestamp the edge timestamp, in FCY ticks.
+ * @param[in] abort_on_input true to give up as soon as a byte arrives from the
+ * serial port.
+ *
+ * @return true if an edge was captured, false if no edge showed up within
+ * EDGE_CAPTURE_TIMEOUT, the capture buffer overflowed losing edges, or input
+ * arrived when asked to watch for it.
+ */
+static bool capture_next_edge(uint32_t *timestamp, const bool abort_on_input);
+
+/**
+ * @brief Reads the timer the edge timestamps are taken from.
+ *
+ * @return the current timer value, in FCY ticks.
+ */
+static inline uint32_t edge_timer_value(void);
+
+/**
+ * Priority of the frequency monitor input capture interrupt, kept below the
+ * host link so USB and UART servicing are never held up by a fast signal.
+ */
+#define FREQUENCY_MONITOR_INTERRUPT_PRIORITY 2
+
+/**
+ * @brief Background frequency monitor state, shared with the input capture
+ * interrupt handler.
+ */
+static volatile struct {
+  /** Statistics gathered so far, mean excluded. */
+  bp_frequency_statistics_t statistics;
+
+  /** Sum of all the periods measured so far, for the mean. */
+  uint64_t total;
+
+  /** Timestamp of the last edge seen. */
+  uint32_t previous;
+
+  /** Whether previous holds a valid timestamp. */
+  bool synchronised;
+
+  /** Whether the monitor is running. */
+  bool running;
+} frequency_monitor;
+
+/**
+ * @brief Clears the background frequency monitor statistics.
+ */
+static void reset_frequency_monitor_statistics(void);
+
 /**
  * @brief Stops the two timers used in the PWM/frequency counting process.
  */
@@ -95,6 +164,48 @@ static aux_state_t state = {0};
  */
 static uint16_t setup_prescaler_divisor(const uint16_t frequency);
 
+/**
+ * @brief Starts output compare #5 in edge-aligned PWM mode on timer #2.
+ *
+ * @param[in] cycle the initial duty cycle, in timer #2 ticks.
+ */
+static void enable_pwm_output(const uint16_t cycle);
+
+/**
+ * Priority of the PWM sequence timer #2 interrupt.
+ */
+#define PWM_SEQUENCE_INTERRUPT_PRIORITY 2
+
+/**
+ * @brief PWM sequence playback state, shared with the timer #2 interrupt
+ * handler.
+ */
+static volatile struct {
+  /** Duty cycle table, in timer #2 ticks. */
+  uint16_t duty_cycles[PWM_SEQUENCE_MAXIMUM_STEPS];
+
+  /** Number of valid entries in duty_cycles. */
+  uint8_t steps;
+
+  /** Table entry being output. */
+  uint8_t step;
+
+  /** PWM periods each step lasts. */
+  uint16_t step_periods;
+
+  /** PWM periods left for the current step. */
+  uint16_t periods_left;
+
+  /** Table passes left, for one-shot and burst modes. */
+  uint16_t passes_left;
+
+  /** What to do at the end of the table. */
+  pwm_sequence_mode_t mode;
+
+  /** Whether the sequence is being played. */
+  bool running;
+} pwm_sequence;
+
 /**
  * @brief PWM frequency divisor for 1:256 prescaler.
  */
@@ -211,6 +322,12 @@ void bp_update_pwm(const uint16_t frequency, const uint16_t duty_cycle) {
   AUXPIN_RPOUT = OC5_IO;
 
   /* Setup the PWM generator. */
+  enable_pwm_output(cycle);
+  T2CONbits.TON = ON;
+  state.mode = AUX_MODE_PWM;
+}
+
+void enable_pwm_output(const uint16_t cycle) {
   OC5R = cycle;
   OC5RS = cycle;
 #if defined(BUSPIRATEV4)
@@ -246,8 +363,86 @@ void bp_update_pwm(const uint16_t frequency, const uint16_t duty_cycle) {
   OC5CON = (0b110 << _OC5CON_OCM_POSITION) | (OFF << _OC5CON_OCTSEL_POSITION) |
            (OFF << _OC5CON_OCFLT_POSITION) | (OFF << _OC5CON_OCSIDL_POSITION);
 #endif /* BUSPIRATEV4 */
+}
+
+bool bp_pwm_sequence_start(const bp_pwm_sequence_t *sequence) {
+  uint8_t index;
+
+  if ((sequence->steps == 0) ||
+      (sequence->steps > PWM_SEQUENCE_MAXIMUM_STEPS) ||
+      (sequence->step_periods == 0) ||
+      (sequence->prescaler > PWM_SEQUENCE_PRESCALER_1_256) ||
+      (sequence->mode > PWM_SEQUENCE_BURSTS) ||
+      ((sequence->mode == PWM_SEQUENCE_BURSTS) && (sequence->bursts == 0))) {
+    return false;
+  }
+
+  stop_timers();
+
+  /* Output compare is reprogrammed below, see bp_update_pwm(). */
+  OC5CON = 0x0000;
+
+  for (index = 0; index < sequence->steps; index++) {
+    pwm_sequence.duty_cycles[index] = sequence->duty_cycles[index];
+  }
+  pwm_sequence.steps = sequence->steps;
+  pwm_sequence.step = 0;
+  pwm_sequence.step_periods = sequence->step_periods;
+  pwm_sequence.periods_left = sequence->step_periods;
+  pwm_sequence.passes_left =
+      (sequence->mode == PWM_SEQUENCE_BURSTS) ? sequence->bursts : 1;
+  pwm_sequence.mode = sequence->mode;
+  pwm_sequence.running = true;
+
+  T2CONbits.TCKPS = sequence->prescaler;
+  TMR2 = 0;
+  PR2 = sequence->period;
+
+  /* Attach the AUX pin to the PWM generator. */
+  AUXPIN_RPOUT = OC5_IO;
+  enable_pwm_output(pwm_sequence.duty_cycles[0]);
+
+  /* Step through the table on timer #2 period matches. */
+  IFS0bits.T2IF = OFF;
+  IPC1bits.T2IP = PWM_SEQUENCE_INTERRUPT_PRIORITY;
+  IEC0bits.T2IE = ON;
+
   T2CONbits.TON = ON;
   state.mode = AUX_MODE_PWM;
+
+  return true;
+}
+
+void bp_pwm_sequence_stop(void) {
+  IEC0bits.T2IE = OFF;
+  IFS0bits.T2IF = OFF;
+  IPC1bits.T2IP = 0;
+  pwm_sequence.running = false;
+}
+
+bool bp_pwm_sequence_running(void) { return pwm_sequence.running; }
+
+void __attribute__((interrupt, no_auto_psv)) _T2Interrupt(void) {
+  IFS0bits.T2IF = OFF;
+
+  if (--pwm_sequence.periods_left > 0) {
+    return;
+  }
+  pwm_sequence.periods_left = pwm_sequence.step_periods;
+
+  if (++pwm_sequence.step == pwm_sequence.steps) {
+    if ((pwm_sequence.mode != PWM_SEQUENCE_LOOP) &&
+        (--pwm_sequence.passes_left == 0)) {
+      /* Done, the last step duty cycle stays on. */
+      IEC0bits.T2IE = OFF;
+      pwm_sequence.running = false;
+      return;
+    }
+    pwm_sequence.step = 0;
+  }
+
+  /* OC5RS is latched at the start of the next PWM period. */
+  OC5RS = pwm_sequence.duty_cycles[pwm_sequence.step];
 }
 
 void bp_pwm_setup(void) {
@@ -429,6 +624,11 @@ void bp_frequency_counter_setup(void) {
     if (frequency > 0) {
       BPMSG1245;
       period = average_sample_frequency(frequency);
+      if (period == 0) {
+        /* The signal went away while sampling. */
+        bp_write_dec_byte(0);
+        goto write_marker;
+      }
       if (period > 400000) {
         frequency = 16e11 / period;
         bp_write_dec_dword_friendly(frequency / 100000);
@@ -589,8 +789,9 @@ uint32_t poll_frequency_counter_value(void) {
   /* Start timer #2. */
   T2CONbits.TON = ON;
 
-  /* Wait for timer #4 interrupt to occur. */
+  /* Wait for timer #4 interrupt to occur, the timers count on their own. */
   while (IFS1bits.T5IF == 0) {
+    bp_yield();
   }
 
   /* Stop timers. */
@@ -607,15 +808,43 @@ uint32_t poll_frequency_counter_value(void) {
 #if defined(BUSPIRATEV4)
 #define IC1ICBNE IC1CON1bits.ICBNE
 #define IC2ICBNE IC2CON1bits.ICBNE
+#define IC1ICOV IC1CON1bits.ICOV
 #else
 #define IC1ICBNE IC1CONbits.ICBNE
 #define IC2ICBNE IC2CONbits.ICBNE
+#define IC1ICOV IC1CONbits.ICOV
 #endif /* BUSPIRATEV4 */
 
+/**
+ * How long to wait for a rising edge on the AUX pin, in FCY ticks (two
+ * seconds).
+ */
+#define EDGE_CAPTURE_TIMEOUT (FCY * 2)
+
 uint32_t average_sample_frequency(const uint16_t count) {
-  uint32_t current_low, counter_low, current_high, counter_high, total_samples;
+  uint32_t previous, current, total_samples;
   uint16_t index;
 
+  start_edge_capture();
+
+  total_samples = 0;
+  if (capture_next_edge(&previous, false)) {
+    for (index = 0; index < count; index++) {
+      if (!capture_next_edge(&current, false)) {
+        total_samples = 0;
+        break;
+      }
+      total_samples += current - previous;
+      previous = current;
+    }
+  }
+
+  stop_edge_capture();
+
+  return total_samples / count;
+}
+
+void start_edge_capture(void) {
   /* Clear input capture interrupts. */
   IFS0bits.IC2IF = OFF;
   IFS0bits.IC1IF = OFF;
@@ -767,34 +996,16 @@ uint32_t average_sample_frequency(const uint16_t count) {
 
   /* Flush IC1. */
   while (IC1ICBNE == ON) {
-    current_low = IC1BUF;
+    (void)IC1BUF;
   }
 
   /* Flush IC2. */
   while (IC2ICBNE == ON) {
-    counter_low = IC2BUF;
-  }
-
-  while (IC1ICBNE == OFF) {
-  }
-
-  counter_low = IC1BUF;
-  counter_high = IC2BUF;
-  total_samples = 0;
-
-  for (index = 0; index < count; index++) {
-    /* Wait for signal. */
-    while (IC1ICBNE == OFF) {
-    }
-
-    current_low = IC1BUF;
-    current_high = IC2BUF;
-    total_samples +=
-        ((current_high - counter_high) << 16) + (current_low - counter_low);
-    counter_high = current_high;
-    counter_low = current_low;
+    (void)IC2BUF;
   }
+}
 
+void stop_edge_capture(void) {
 #if defined(BUSPIRATEV4)
 
   /* Stop input capture units. */
@@ -862,8 +1073,219 @@ uint32_t average_sample_frequency(const uint16_t count) {
   T2CONbits.TON = OFF;
 
 #endif /* BUSPIRATEV4 */
+}
 
-  return total_samples / count;
+uint32_t edge_timer_value(void) {
+  uint16_t low;
+
+  /* Reading the low half latches the high half into the holding register. */
+#if defined(BUSPIRATEV4)
+  low = TMR4;
+  return ((uint32_t)TMR5HLD << 16) | low;
+#else
+  low = TMR2;
+  return ((uint32_t)TMR3HLD << 16) | low;
+#endif /* BUSPIRATEV4 */
+}
+
+bool capture_next_edge(uint32_t *timestamp, const bool abort_on_input) {
+  uint32_t started;
+  uint16_t low;
+
+  started = edge_timer_value();
+  while (IC1ICBNE == OFF) {
+    if ((edge_timer_value() - started) > EDGE_CAPTURE_TIMEOUT) {
+      return false;
+    }
+    if (abort_on_input && user_serial_ready_to_read()) {
+      return false;
+    }
+  }
+
+  /* A full buffer means edges got dropped, the count would be off. */
+  if (IC1ICOV == ON) {
+    return false;
+  }
+
+  low = IC1BUF;
+  *timestamp = ((uint32_t)IC2BUF << 16) | low;
+  return true;
+}
+
+uint32_t bp_measure_periods(const uint16_t periods) {
+  uint32_t first, last;
+  uint16_t index;
+
+  stop_timers();
+  AUXPIN_DIR = INPUT;
+  start_edge_capture();
+
+  last = 0;
+  first = 0;
+  if (capture_next_edge(&first, false)) {
+    last = first;
+    for (index = 0; index < periods; index++) {
+      if (!capture_next_edge(&last, false)) {
+        last = first;
+        break;
+      }
+    }
+  }
+
+  stop_edge_capture();
+  RPINR7bits.IC1R = 0b011111;
+  RPINR7bits.IC2R = 0b011111;
+
+  return last - first;
+}
+
+void bp_stream_periods(const uint16_t periods) {
+  uint32_t first, current;
+  uint16_t index;
+  bool synchronised;
+
+  stop_timers();
+  AUXPIN_DIR = INPUT;
+  start_edge_capture();
+
+  synchronised = false;
+  first = 0;
+  index = 0;
+  while (!user_serial_ready_to_read()) {
+    if (!capture_next_edge(&current, true)) {
+      if (user_serial_ready_to_read()) {
+        break;
+      }
+
+      /* Report the gap and start over from a fresh edge. */
+      bp_binary_io_write_uint32(0);
+      stop_edge_capture();
+      start_edge_capture();
+      synchronised = false;
+      continue;
+    }
+
+    if (!synchronised) {
+      first = current;
+      index = 0;
+      synchronised = true;
+      continue;
+    }
+
+    if (++index == periods) {
+      /* Windows are back to back, this edge also opens the next one. */
+      bp_binary_io_write_uint32(current - first);
+      first = current;
+      index = 0;
+    }
+  }
+  user_serial_read_byte();
+
+  stop_edge_capture();
+  RPINR7bits.IC1R = 0b011111;
+  RPINR7bits.IC2R = 0b011111;
+}
+
+void reset_frequency_monitor_statistics(void) {
+  frequency_monitor.statistics.periods = 0;
+  frequency_monitor.statistics.overruns = 0;
+  frequency_monitor.statistics.last = 0;
+  frequency_monitor.statistics.minimum = 0;
+  frequency_monitor.statistics.maximum = 0;
+  frequency_monitor.statistics.mean = 0;
+  frequency_monitor.total = 0;
+}
+
+void bp_frequency_monitor_start(void) {
+  stop_timers();
+  AUXPIN_DIR = INPUT;
+
+  reset_frequency_monitor_statistics();
+  frequency_monitor.synchronised = false;
+  frequency_monitor.running = true;
+
+  start_edge_capture();
+  IFS0bits.IC1IF = OFF;
+  IPC0bits.IC1IP = FREQUENCY_MONITOR_INTERRUPT_PRIORITY;
+  IEC0bits.IC1IE = ON;
+}
+
+void bp_frequency_monitor_stop(void) {
+  if (!frequency_monitor.running) {
+    return;
+  }
+
+  IEC0bits.IC1IE = OFF;
+  IFS0bits.IC1IF = OFF;
+  IPC0bits.IC1IP = 0;
+  frequency_monitor.running = false;
+
+  stop_edge_capture();
+  RPINR7bits.IC1R = 0b011111;
+  RPINR7bits.IC2R = 0b011111;
+}
+
+void bp_frequency_monitor_read(bp_frequency_statistics_t *statistics,
+                               const bool reset) {
+  uint64_t total;
+
+  /* Keep the interrupt handler out while the fields are copied. */
+  IEC0bits.IC1IE = OFF;
+  statistics->periods = frequency_monitor.statistics.periods;
+  statistics->overruns = frequency_monitor.statistics.overruns;
+  statistics->last = frequency_monitor.statistics.last;
+  statistics->minimum = frequency_monitor.statistics.minimum;
+  statistics->maximum = frequency_monitor.statistics.maximum;
+  total = frequency_monitor.total;
+  if (reset) {
+    reset_frequency_monitor_statistics();
+  }
+  if (frequency_monitor.running) {
+    IEC0bits.IC1IE = ON;
+  }
+
+  statistics->mean =
+      (statistics->periods > 0) ? (uint32_t)(total / statistics->periods) : 0;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _IC1Interrupt(void) {
+  uint32_t timestamp;
+  uint32_t period;
+  uint16_t low;
+
+  IFS0bits.IC1IF = OFF;
+
+  if (IC1ICOV == ON) {
+    /* Edges were lost, restart capturing and wait for a fresh edge. */
+    frequency_monitor.statistics.overruns++;
+    frequency_monitor.synchronised = false;
+    stop_edge_capture();
+    start_edge_capture();
+    IFS0bits.IC1IF = OFF;
+    return;
+  }
+
+  while (IC1ICBNE == ON) {
+    low = IC1BUF;
+    timestamp = ((uint32_t)IC2BUF << 16) | low;
+
+    if (frequency_monitor.synchronised) {
+      period = timestamp - frequency_monitor.previous;
+      if ((frequency_monitor.statistics.periods == 0) ||
+          (period < frequency_monitor.statistics.minimum)) {
+        frequency_monitor.statistics.minimum = period;
+      }
+      if (period > frequency_monitor.statistics.maximum) {
+        frequency_monitor.statistics.maximum = period;
+      }
+      frequency_monitor.statistics.last = period;
+      frequency_monitor.statistics.periods++;
+      frequency_monitor.total += period;
+    }
+
+    frequency_monitor.previous = timestamp;
+    frequency_monitor.synchronised = true;
+  }
 }
 
 void bp_aux_pin_set_high_impedance(void) {
@@ -1147,6 +1569,10 @@ void bp_servo_setup(void) {
 
 void stop_timers(void) {
 
+  /* The frequency monitor relies on the timers being stopped here. */
+  bp_frequency_monitor_stop();
+  bp_pwm_sequence_stop();
+
   /*
    * T4CON
    *
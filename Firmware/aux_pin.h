@@ -54,6 +54,51 @@
  */
 #define PWM_MAXIMUM_DUTY_CYCLE 100
 
+/**
+ * @brief Maximum number of duty cycle steps in a PWM sequence.
+ */
+#define PWM_SEQUENCE_MAXIMUM_STEPS 64
+
+/**
+ * @brief Highest timer #2 prescaler setting (1:256) a PWM sequence can use.
+ */
+#define PWM_SEQUENCE_PRESCALER_1_256 0b11
+
+/**
+ * @brief What a PWM sequence does once its last step is over.
+ */
+typedef enum {
+  /** Go through the table once, the last step stays on afterwards. */
+  PWM_SEQUENCE_ONE_SHOT = 0,
+  /** Go through the table over and over until stopped. */
+  PWM_SEQUENCE_LOOP,
+  /** Go through the table a given number of times, like one-shot. */
+  PWM_SEQUENCE_BURSTS
+} __attribute__((packed)) pwm_sequence_mode_t;
+
+/**
+ * @brief Table driven PWM sequence description.
+ *
+ * The PWM timing is given in raw timer #2 units, as with the binary I/O PWM
+ * setup command.
+ */
+typedef struct {
+  /** Timer #2 prescaler setting, 0 (1:1) to PWM_SEQUENCE_PRESCALER_1_256. */
+  uint8_t prescaler;
+  /** PWM period, in timer #2 ticks minus one. */
+  uint16_t period;
+  /** How many PWM periods each step lasts, at least 1. */
+  uint16_t step_periods;
+  /** What to do at the end of the table. */
+  pwm_sequence_mode_t mode;
+  /** How many times to go through the table in PWM_SEQUENCE_BURSTS mode. */
+  uint16_t bursts;
+  /** Number of steps in the table, 1 to PWM_SEQUENCE_MAXIMUM_STEPS. */
+  uint8_t steps;
+  /** Duty cycle for each step, in timer #2 ticks. */
+  uint16_t duty_cycles[PWM_SEQUENCE_MAXIMUM_STEPS];
+} bp_pwm_sequence_t;
+
 /**
  * @brief Updates the internal PWM generation variables.
  *
@@ -83,6 +128,35 @@ void bp_update_pwm(const uint16_t frequency, const uint16_t duty_cycle);
  */
 void bp_update_duty_cycle(const uint16_t duty_cycle);
 
+/**
+ * @brief Starts playing a table driven PWM sequence on the AUX pin.
+ *
+ * The timer #2 period interrupt moves to the next duty cycle once the current
+ * step is over, so steps change on PWM period boundaries without any host
+ * involvement.  PWM frequencies in the upper tens of kHz spend a fair share
+ * of CPU time in that interrupt.
+ *
+ * @param[in] sequence the sequence to play, copied before returning.
+ *
+ * @return true if the sequence started, false if its description is not
+ * valid.
+ */
+bool bp_pwm_sequence_start(const bp_pwm_sequence_t *sequence);
+
+/**
+ * @brief Stops stepping through the PWM sequence.
+ *
+ * The PWM output keeps the duty cycle it had when this was called.
+ */
+void bp_pwm_sequence_stop(void);
+
+/**
+ * @brief Tells whether a PWM sequence is still being played.
+ *
+ * @return true if the sequence is still stepping, false otherwise.
+ */
+bool bp_pwm_sequence_running(void);
+
 /**
  * @brief Sets the currently chosen AUX pin into INPUT/HiZ mode.
  */
@@ -120,7 +194,85 @@ void bp_frequency_counter_setup(void);
  *
  * @return the frequency read by the frequency counter hardware, in Hz.
  */
-unsigned long bp_measure_frequency(void);
+uint32_t bp_measure_frequency(void);
+
+/**
+ * @brief Times the given number of signal periods on the AUX pin.
+ *
+ * Unlike bp_measure_frequency(), which counts edges over a one second gate,
+ * this timestamps the rising edges against a timer clocked at FCY, so the
+ * resolution is one instruction cycle whatever the signal frequency is.  The
+ * frequency is FCY * periods / result.  Edges coming in faster than the
+ * capture buffer is emptied (a few hundred kHz) make the measurement fail,
+ * the gated counter is the better choice up there.
+ *
+ * @param[in] periods how many full signal periods to time, at least 1.
+ *
+ * @return the length of the given periods in FCY ticks, or 0 if the signal
+ * was missing or too fast.
+ */
+uint32_t bp_measure_periods(const uint16_t periods);
+
+/**
+ * @brief Streams back to back period measurements of the AUX pin signal.
+ *
+ * Each measurement covers the given number of signal periods and is sent as
+ * four bytes, MSB first, in FCY ticks; the edge closing a window opens the
+ * next one, so no signal time goes unaccounted for.  A zero is sent whenever
+ * the signal goes missing, and timing restarts from the next edge.  Any byte
+ * sent to the board stops the stream.
+ *
+ * @param[in] periods how many full signal periods each measurement covers,
+ * at least 1.
+ */
+void bp_stream_periods(const uint16_t periods);
+
+/**
+ * @brief Background frequency monitor statistics.
+ *
+ * All periods are in FCY ticks.
+ */
+typedef struct {
+  /** Number of signal periods measured. */
+  uint32_t periods;
+  /** How many times edges came in too fast and some got lost. */
+  uint32_t overruns;
+  /** Length of the most recent period. */
+  uint32_t last;
+  /** Shortest period seen. */
+  uint32_t minimum;
+  /** Longest period seen. */
+  uint32_t maximum;
+  /** Average period length. */
+  uint32_t mean;
+} bp_frequency_statistics_t;
+
+/**
+ * @brief Starts measuring the AUX pin signal in the background.
+ *
+ * Every rising edge is timestamped by the input capture units and folded into
+ * the statistics from an interrupt handler, so the firmware keeps running
+ * normally while the measurement goes on.  This uses the same timers as the
+ * PWM generator and the other frequency measurements, which stop the
+ * monitor when they start.
+ */
+void bp_frequency_monitor_start(void);
+
+/**
+ * @brief Stops the background frequency monitor, if it is running.
+ *
+ * The statistics gathered so far can still be read afterwards.
+ */
+void bp_frequency_monitor_stop(void);
+
+/**
+ * @brief Reads the background frequency monitor statistics.
+ *
+ * @param[out] statistics where to store the statistics.
+ * @param[in] reset true to clear the statistics once read.
+ */
+void bp_frequency_monitor_read(bp_frequency_statistics_t *statistics,
+                               const bool reset);
 
 /**
  * @brief Starts the setup process for generating a PWM signal.
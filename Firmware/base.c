@@ -21,14 +21,24 @@
  * @brief Base functions implementation file.
  */
 
+#include <string.h>
+
 #include "base.h"
+#include "buffer_arena.h"
 #include "core.h"
+#include "profiling.h"
+#include "telemetry.h"
 
 /**
  * @brief Prefix string for hexadecimal values in human-readable form.
  */
 static const uint8_t HEX_PREFIX[] = {'0', 'x'};
 
+/**
+ * @brief Prefix string for binary values in human-readable form.
+ */
+static const uint8_t BIN_PREFIX[] = {'0', 'b'};
+
 /**
  * @brief Look-up table for hexadecimal to ASCII transformations.
  */
@@ -36,6 +46,26 @@ static const unsigned char HEX_ASCII_TABLE[] = {'0', '1', '2', '3', '4', '5',
                                                 '6', '7', '8', '9', 'A', 'B',
                                                 'C', 'D', 'E', 'F'};
 
+/**
+ * @brief Powers of ten for 16-bits decimal conversions.
+ *
+ * Digits are found by repeated subtraction, as each 32-bits division is a
+ * library call taking hundreds of cycles on the PIC24.
+ */
+static const uint16_t DECIMAL_POWERS_16[] = {10000, 1000, 100, 10};
+
+/**
+ * @brief Powers of ten for the upper digits of 32-bits decimal conversions.
+ */
+static const uint32_t DECIMAL_POWERS_32[] = {1000000000UL, 100000000UL,
+                                             10000000UL,   1000000UL,
+                                             100000UL,     10000UL};
+
+/**
+ * @brief Longest text bp_format_dec_dword can write.
+ */
+#define DEC_DWORD_MAX_LENGTH 10
+
 #if defined(BUSPIRATEV4)
 extern BYTE cdc_In_len;
 extern BYTE cdc_Out_len;
@@ -73,14 +103,13 @@ extern mode_configuration_t mode_configuration;
 #pragma config DISUVREG = OFF
 #endif /* BUSPIRATEV4 */
 
-#ifdef BUSPIRATEV4
-
 /**
  * @brief Precomputed table with the reversed bit representation of all possible
  * 8-bits integers.
  *
- * On v4 boards flash space is not a concern, so we can speed things up a bit
- * without worrying too much about it.
+ * LSB first modes reverse every byte that goes on or comes off the bus, so the
+ * table lives in flash on v3 boards as well: it costs less than the time a bit
+ * by bit loop takes on each transfer.
  */
 static const uint8_t REVERSED_BITS_TABLE[] = {
     0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0,
@@ -107,24 +136,89 @@ static const uint8_t REVERSED_BITS_TABLE[] = {
     0x3F, 0xBF, 0x7F, 0xFF,
 };
 
-#endif /* BUSPIRATEV4 */
-
 /**
  * @brief Clear configuration on mode change.
  */
 static void clear_mode_configuration(void);
 
 /**
- * @brief Prints the given value to the serial port as a decimal number.
+ * @brief Renders the given value in hexadecimal form into a buffer.
+ *
+ * @param[out] buffer where to write the text.
+ * @param[in] value the value to render.
+ * @param[in] digits how many hexadecimal digits to write, from the least
+ * significant one.
+ * @param[in] prefix true to prepend HEX_PREFIX, false otherwise.
+ *
+ * @return how many bytes were written.
+ */
+static size_t format_hex(uint8_t *buffer, const uint16_t value,
+                         const uint8_t digits, const bool prefix);
+
+/**
+ * @brief Renders the given value in binary form into a buffer, with
+ * BIN_PREFIX in front of it.
  *
- * @warning the denominator *must* be equal to 10^digits.
+ * @param[out] buffer where to write the text, must be able to hold at least 10
+ * bytes.
+ * @param[in] value the value to render.
  *
- * @param[in] value the value to print.
- * @param[in] denominator the divisor to use when printing the value.
- * @param[in] digits how many digits to print.
+ * @return how many bytes were written.
+ */
+static size_t format_bin_byte(uint8_t *buffer, const uint8_t value);
+
+#ifdef BUSPIRATEV4
+
+/**
+ * @brief Sends the reply so far if the next read has to wait for the host.
+ */
+static void user_serial_end_of_response(void);
+
+#endif /* BUSPIRATEV4 */
+
+#ifdef BP_CHANGE_NOTIFICATION_DISPATCH
+
+/**
+ * Handler the change notification interrupt is routed to.
+ */
+static volatile bp_change_notification_handler_t
+    change_notification_handler = NULL;
+
+void bp_set_change_notification_handler(
+    const bp_change_notification_handler_t handler) {
+  change_notification_handler = handler;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _CNInterrupt(void) {
+  IFS1bits.CNIF = OFF;
+
+  if (change_notification_handler != NULL) {
+    change_notification_handler();
+  }
+}
+
+#endif /* BP_CHANGE_NOTIFICATION_DISPATCH */
+
+#ifdef BP_ADC_INTERRUPT_DISPATCH
+
+/**
+ * Handler the ADC interrupt is routed to.
  */
-static void print_decimal(const uint32_t value, const uint32_t denominator,
-                          const uint8_t digits);
+static volatile bp_adc_interrupt_handler_t adc_interrupt_handler = NULL;
+
+void bp_set_adc_interrupt_handler(const bp_adc_interrupt_handler_t handler) {
+  adc_interrupt_handler = handler;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _ADC1Interrupt(void) {
+  IFS0bits.AD1IF = OFF;
+
+  if (adc_interrupt_handler != NULL) {
+    adc_interrupt_handler();
+  }
+}
+
+#endif /* BP_ADC_INTERRUPT_DISPATCH */
 
 void clear_mode_configuration(void) {
   mode_configuration.high_impedance = OFF;
@@ -154,6 +248,7 @@ void bp_reset_board_state(void) {
 
   bus_pirate_configuration.bus_mode = BP_HIZ;
   clear_mode_configuration();
+  bp_buffer_arena_release_all();
   bp_disable_pullup();
   bp_disable_voltage_regulator();
   bp_adc_pin_setup();
@@ -265,92 +360,172 @@ void bp_adc_continuous_probe(void) {
 }
 
 void bp_write_formatted_integer(const uint16_t value) {
-  uint16_t integer;
+  uint8_t buffer[BP_FORMATTED_INTEGER_MAX_LENGTH];
+
+  user_serial_write_buffer(buffer, bp_format_integer(buffer, value));
+}
+
+size_t bp_format_dec_word(uint8_t *buffer, const uint16_t value) {
+  uint8_t *output;
+  uint16_t number;
+  size_t index;
+  uint8_t digit;
+  bool started;
+
+  output = buffer;
+  number = value;
+  started = false;
+
+  for (index = 0; index < sizeof(DECIMAL_POWERS_16) / sizeof(uint16_t);
+       index++) {
+    digit = '0';
+    while (number >= DECIMAL_POWERS_16[index]) {
+      number -= DECIMAL_POWERS_16[index];
+      digit++;
+    }
+    if (started || (digit != '0')) {
+      *output++ = digit;
+      started = true;
+    }
+  }
+  *output++ = number + '0';
+
+  return output - buffer;
+}
+
+size_t bp_format_dec_dword(uint8_t *buffer, const uint32_t value) {
+  uint8_t *output;
+  uint32_t number;
+  size_t index;
+  uint8_t digit;
+  bool started;
+
+  if (value <= 0xFFFF) {
+    return bp_format_dec_word(buffer, value);
+  }
+
+  output = buffer;
+  number = value;
+  started = false;
+
+  /* Strip the upper digits until what is left fits in 16 bits. */
+  for (index = 0; index < sizeof(DECIMAL_POWERS_32) / sizeof(uint32_t);
+       index++) {
+    digit = '0';
+    while (number >= DECIMAL_POWERS_32[index]) {
+      number -= DECIMAL_POWERS_32[index];
+      digit++;
+    }
+    if (started || (digit != '0')) {
+      *output++ = digit;
+      started = true;
+    }
+  }
+
+  /* The last four digits, zero padded. */
+  for (index = 1; index < sizeof(DECIMAL_POWERS_16) / sizeof(uint16_t);
+       index++) {
+    digit = '0';
+    while ((uint16_t)number >= DECIMAL_POWERS_16[index]) {
+      number -= DECIMAL_POWERS_16[index];
+      digit++;
+    }
+    *output++ = digit;
+  }
+  *output++ = number + '0';
+
+  return output - buffer;
+}
+
+size_t format_hex(uint8_t *buffer, const uint16_t value, const uint8_t digits,
+                  const bool prefix) {
+  uint8_t *output;
+  uint8_t shift;
+
+  output = buffer;
+  if (prefix) {
+    *output++ = HEX_PREFIX[0];
+    *output++ = HEX_PREFIX[1];
+  }
+  for (shift = digits * 4; shift > 0; shift -= 4) {
+    *output++ = HEX_ASCII_TABLE[(value >> (shift - 4)) & 0x0F];
+  }
+
+  return output - buffer;
+}
+
+size_t format_bin_byte(uint8_t *buffer, const uint8_t value) {
+  uint8_t *output;
+  uint8_t mask;
+
+  output = buffer;
+  *output++ = BIN_PREFIX[0];
+  *output++ = BIN_PREFIX[1];
+  for (mask = 0x80; mask > 0; mask >>= 1) {
+    *output++ = (value & mask) ? '1' : '0';
+  }
+
+  return output - buffer;
+}
+
+size_t bp_format_integer(uint8_t *buffer, const uint16_t value) {
+  uint8_t *output;
 
-  integer = (mode_configuration.numbits < 16)
-                ? MASKBOTTOM16(value, mode_configuration.numbits)
-                : value;
+  output = buffer;
 
   switch (bus_pirate_configuration.display_mode) {
   case HEX:
-    if (mode_configuration.int16 == YES) {
-      bp_write_hex_word(value);
-    } else {
-      bp_write_hex_byte(value);
-    }
+  case DUMP:
+    output += format_hex(output, value,
+                         (mode_configuration.int16 == YES) ? 4 : 2,
+                         bus_pirate_configuration.display_mode == HEX);
     break;
 
   case DEC:
-    if (mode_configuration.int16 == YES) {
-      bp_write_dec_word(value);
-    } else {
-      bp_write_dec_byte(value);
-    }
+    output += bp_format_dec_word(
+        output, (mode_configuration.int16 == YES) ? value : (value & 0xFF));
     break;
 
   case BIN:
     if (mode_configuration.int16 == YES) {
-      bp_write_bin_byte(value >> 8);
-      bpSP;
+      output += format_bin_byte(output, value >> 8);
+      *output++ = ' ';
     }
-    bp_write_bin_byte(value & 0xFF);
+    output += format_bin_byte(output, value & 0xFF);
     break;
 
   case RAW:
     if (mode_configuration.int16 == YES) {
-      user_serial_transmit_character(value >> 8);
+      *output++ = value >> 8;
     }
-    user_serial_transmit_character(value & 0xFF);
+    *output++ = value & 0xFF;
     break;
   }
+
+  return output - buffer;
 }
 
 inline uint8_t bp_reverse_byte(const uint8_t value) {
-#ifdef BUSPIRATEV4
   return REVERSED_BITS_TABLE[value];
-#else
-  return bp_reverse_integer(value, 8);
-#endif /* BUSPIRATEV4 */
 }
 
 inline uint16_t bp_reverse_word(const uint16_t value) {
-#ifdef BUSPIRATEV4
   return (REVERSED_BITS_TABLE[value & 0xFF] << 8) |
          REVERSED_BITS_TABLE[value >> 8];
-#else
-  return bp_reverse_integer(value, 16);
-#endif /* BUSPIRATEV4 */
 }
 
 uint16_t bp_reverse_integer(const uint16_t value, const uint8_t bits) {
-#ifdef BUSPIRATEV4
+  if (bits <= 8) {
+    return REVERSED_BITS_TABLE[value & 0xFF] >> (8 - bits);
+  }
+
   return ((REVERSED_BITS_TABLE[value & 0xFF] << 8) |
           REVERSED_BITS_TABLE[value >> 8]) >>
          ((sizeof(uint16_t) * 8) - bits);
-#else
-  uint16_t reversed;
-  uint16_t bitmask;
-
-  reversed = 0;
-  bitmask = 1;
-  while (bitmask != 0) {
-    reversed <<= 1;
-    if (value & bitmask) {
-      reversed |= 0b00000001;
-    }
-    bitmask <<= 1;
-  }
-
-  return reversed >> ((sizeof(uint16_t) * 8) - bits);
-#endif /* BUSPIRATEV4 */
 }
 
 void bp_write_buffer(const uint8_t *buffer, const size_t length) {
-  size_t offset;
-
-  for (offset = 0; offset < length; offset++) {
-    user_serial_transmit_character(buffer[offset]);
-  }
+  user_serial_write_buffer(buffer, length);
 }
 
 void bp_write_string(const char *string) {
@@ -368,108 +543,54 @@ void bp_write_line(const char *string) {
 }
 
 void bp_write_bin_byte(const uint8_t value) {
-  uint8_t mask = 0x80;
-  size_t index;
+  uint8_t buffer[10];
 
-  MSG_BINARY_NUMBER_PREFIX;
-
-  for (index = 0; index < 8; index++) {
-    user_serial_transmit_character((value & mask) ? '1' : '0');
-    mask >>= 1;
-  }
+  user_serial_write_buffer(buffer, format_bin_byte(buffer, value));
 }
 
 void bp_write_dec_dword_friendly(const uint32_t value) {
-  unsigned long int temp;
-  int mld, mil;
-  uint32_t number;
-
-  number = value;
-  mld = 0;
-  mil = 0;
-  temp = 0;
-
-  if (number >= 1000000) {
-    temp = number / 1000000;
-    bp_write_dec_word(temp);
-    user_serial_transmit_character(',');
-    number %= 1000000;
-    if (number < 1000)
-      bp_write_string("000,");
-    mld = 1;
-    mil = 1;
-  }
-  if (number >= 1000) {
-    temp = number / 1000;
-    if (temp >= 100) {
-      bp_write_dec_word(temp);
-    } else if (mld) {
-      if (temp >= 10) {
-        user_serial_transmit_character('0'); // 1 leading zero
-      } else {
-        bp_write_string("00");
-      }
-      bp_write_dec_word(temp);
-    } else
-      bp_write_dec_word(temp);
-    user_serial_transmit_character(',');
-    number %= 1000;
-    mil = 1;
-  }
-  if (number >= 100) {
-    bp_write_dec_word(number);
-  } else if (mil) {
-    if (number >= 10) {
-      user_serial_transmit_character('0'); // 1 leading zero
-    } else {
-      bp_write_string("00");
-    }
-    bp_write_dec_word(number);
-  } else
-    bp_write_dec_word(number);
-}
-
-void print_decimal(const uint32_t value, const uint32_t denominator,
-                   const uint8_t digits) {
-  uint32_t number;
-  uint32_t divisor;
-  uint32_t current;
-  uint8_t digit;
-  bool first;
-
-  first = false;
-  number = value;
-  divisor = denominator;
+  uint8_t digits[DEC_DWORD_MAX_LENGTH];
+  uint8_t buffer[DEC_DWORD_MAX_LENGTH + (DEC_DWORD_MAX_LENGTH / 3)];
+  size_t count;
+  size_t index;
+  size_t length;
 
-  if (!value){
-      user_serial_transmit_character('0');
-      return;
-  }
+  count = bp_format_dec_dword(digits, value);
 
-  for (digit = 0; digit < digits; digit++) {
-    current = number / divisor;
-    if (first || (current > 0)) {
-      user_serial_transmit_character(current + '0');
-      number -= (current * divisor);
-      first = true;
+  /* Put a separator in front of every group of three digits but the first. */
+  length = 0;
+  for (index = 0; index < count; index++) {
+    if ((index > 0) && (((count - index) % 3) == 0)) {
+      buffer[length++] = ',';
     }
-
-    divisor /= 10;
+    buffer[length++] = digits[index];
   }
+
+  user_serial_write_buffer(buffer, length);
 }
 
 void bp_write_dec_dword(const uint32_t value) {
-  print_decimal(value, 10000000, 8);
+  uint8_t buffer[DEC_DWORD_MAX_LENGTH];
+
+  user_serial_write_buffer(buffer, bp_format_dec_dword(buffer, value));
+}
+
+void bp_write_dec_word(const uint16_t value) {
+  uint8_t buffer[5];
+
+  user_serial_write_buffer(buffer, bp_format_dec_word(buffer, value));
 }
 
-void bp_write_dec_word(const uint16_t value) { print_decimal(value, 10000, 5); }
+void bp_write_dec_byte(const uint8_t value) {
+  uint8_t buffer[3];
 
-void bp_write_dec_byte(const uint8_t value) { print_decimal(value, 100, 3); }
+  user_serial_write_buffer(buffer, bp_format_dec_word(buffer, value));
+}
 
 void bp_write_hex_byte(const uint8_t value) {
-  MSG_HEXADECIMAL_NUMBER_PREFIX;
-  user_serial_transmit_character(HEX_ASCII_TABLE[(value >> 4) & 0x0F]);
-  user_serial_transmit_character(HEX_ASCII_TABLE[value & 0x0F]);
+  uint8_t buffer[4];
+
+  user_serial_write_buffer(buffer, format_hex(buffer, value, 2, true));
 }
 
 void bp_write_hex_byte_to_ringbuffer(const uint8_t value) {
@@ -480,11 +601,9 @@ void bp_write_hex_byte_to_ringbuffer(const uint8_t value) {
 }
 
 void bp_write_hex_word(const uint16_t value) {
-  MSG_HEXADECIMAL_NUMBER_PREFIX;
-  user_serial_transmit_character(HEX_ASCII_TABLE[(value >> 12) & 0x0F]);
-  user_serial_transmit_character(HEX_ASCII_TABLE[(value >> 8) & 0x0F]);
-  user_serial_transmit_character(HEX_ASCII_TABLE[(value >> 4) & 0x0F]);
-  user_serial_transmit_character(HEX_ASCII_TABLE[value & 0x0F]);
+  uint8_t buffer[6];
+
+  user_serial_write_buffer(buffer, format_hex(buffer, value, 4, true));
 }
 
 void bp_write_voltage(const uint16_t adc) {
@@ -535,6 +654,98 @@ static uint16_t user_serial_ringbuffer_write;
  */
 static uint16_t user_serial_ringbuffer_read;
 
+/**
+ * @brief User-facing serial ring buffer storage, from the buffer arena.
+ */
+static uint8_t *user_serial_ringbuffer;
+
+/**
+ * @brief User-facing serial ring buffer size, in bytes.
+ */
+static uint16_t user_serial_ringbuffer_size;
+
+/**
+ * @brief Size of the user-facing serial port transmission ring, must be a
+ * power of two.
+ */
+#define USER_SERIAL_TRANSMIT_RING_SIZE 256
+
+/**
+ * @brief Mask to wrap transmission ring indices around.
+ */
+#define USER_SERIAL_TRANSMIT_RING_MASK (USER_SERIAL_TRANSMIT_RING_SIZE - 1)
+
+/**
+ * @brief Characters waiting to be moved into the UART1 transmission FIFO by
+ * the transmission interrupt handler.
+ */
+static uint8_t user_serial_transmit_ring[USER_SERIAL_TRANSMIT_RING_SIZE];
+
+/**
+ * @brief Transmission ring write index, only updated by the main loop.
+ */
+static volatile uint16_t user_serial_transmit_ring_head;
+
+/**
+ * @brief Transmission ring read index, only updated with the transmission
+ * interrupt masked or from the transmission interrupt handler.
+ */
+static volatile uint16_t user_serial_transmit_ring_tail;
+
+#if (BP_USER_SERIAL_RECEIVE_RING_SIZE & (BP_USER_SERIAL_RECEIVE_RING_SIZE - 1))
+#error "BP_USER_SERIAL_RECEIVE_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief Mask to wrap reception ring indices around.
+ */
+#define USER_SERIAL_RECEIVE_RING_MASK (BP_USER_SERIAL_RECEIVE_RING_SIZE - 1)
+
+/**
+ * @brief Characters moved out of the UART1 reception FIFO by the reception
+ * interrupt handler, waiting for user_serial_read_byte.
+ *
+ * This lets pasted scripts come in at full speed while the terminal is busy
+ * running the previous line.
+ */
+static uint8_t user_serial_receive_ring[BP_USER_SERIAL_RECEIVE_RING_SIZE];
+
+/**
+ * @brief Reception ring write index, only updated with the reception
+ * interrupt masked or from the reception interrupt handler.
+ */
+static volatile uint16_t user_serial_receive_ring_head;
+
+/**
+ * @brief Reception ring read index, only updated by the main loop.
+ */
+static volatile uint16_t user_serial_receive_ring_tail;
+
+/**
+ * @brief Set when characters were dropped because the reception ring was full.
+ */
+static volatile bool user_serial_receive_ring_overflow;
+
+/**
+ * @brief Moves as many characters as possible from the transmission ring into
+ * the UART1 transmission FIFO.
+ *
+ * Must be called either from the transmission interrupt handler or with the
+ * transmission interrupt masked.
+ *
+ * @return true if the transmission ring is now empty, false otherwise.
+ */
+static bool user_serial_transmit_ring_fill_fifo(void);
+
+/**
+ * @brief Moves every character waiting in the UART1 reception FIFO into
+ * either the block reception buffer or the reception ring.
+ *
+ * Must be called either from the reception interrupt handler or with the
+ * reception interrupt masked.
+ */
+static void user_serial_receive_fifo(void);
+
 #ifndef BP_ENABLE_UART_SUPPORT
 
 /**
@@ -598,17 +809,42 @@ void user_serial_initialise(void) {
    */
   U1STA = 0x0400;
 
+  /* Incoming characters are queued by the reception interrupt handler. */
   IFS0bits.U1RXIF = NO;
+  IEC0bits.U1RXIE = ON;
 }
 
-bool user_serial_transmit_done(void) { return U1STAbits.TRMT; }
+bool user_serial_transmit_done(void) {
+  return (user_serial_transmit_ring_tail == user_serial_transmit_ring_head) &&
+         U1STAbits.TRMT;
+}
+
+bool user_serial_ready_to_read(void) {
+  return (user_serial_receive_ring_head != user_serial_receive_ring_tail) ||
+         U1STAbits.URXDA;
+}
 
-bool user_serial_ready_to_read(void) { return U1STAbits.URXDA; }
+bool user_serial_ringbuffer_setup(void) {
+  /* The ringbuffer writes into UART1 directly, let queued output go first. */
+  user_serial_wait_transmission_done();
+
+  /* Take whatever the arena has left, clear of the caller's reservations. */
+  user_serial_ringbuffer_size = bp_buffer_arena_largest_free();
+  user_serial_ringbuffer = bp_buffer_arena_reserve(user_serial_ringbuffer_size);
+  if (user_serial_ringbuffer == NULL) {
+    return false;
+  }
 
-void user_serial_ringbuffer_setup(void) {
   user_serial_ringbuffer_read = 0;
   user_serial_ringbuffer_write = 1;
   bus_pirate_configuration.overflow = NO;
+
+  return true;
+}
+
+void user_serial_ringbuffer_release(void) {
+  bp_buffer_arena_release(user_serial_ringbuffer);
+  user_serial_ringbuffer = NULL;
 }
 
 void user_serial_ringbuffer_process(void) {
@@ -621,7 +857,7 @@ void user_serial_ringbuffer_process(void) {
   index = user_serial_ringbuffer_read + 1;
 
   /* Wrap around if needed. */
-  if (index == BP_TERMINAL_BUFFER_SIZE) {
+  if (index == user_serial_ringbuffer_size) {
     index = 0;
   }
 
@@ -632,8 +868,7 @@ void user_serial_ringbuffer_process(void) {
 
   /* Send character to port. */
   user_serial_ringbuffer_read = index;
-  U1TXREG =
-      bus_pirate_configuration.terminal_input[user_serial_ringbuffer_read];
+  U1TXREG = user_serial_ringbuffer[user_serial_ringbuffer_read];
 }
 
 void user_serial_ringbuffer_flush(void) {
@@ -643,7 +878,7 @@ void user_serial_ringbuffer_flush(void) {
     index = user_serial_ringbuffer_read + 1;
 
     /* Wrap around if needed. */
-    if (index == BP_TERMINAL_BUFFER_SIZE) {
+    if (index == user_serial_ringbuffer_size) {
       index = 0;
     }
 
@@ -655,8 +890,7 @@ void user_serial_ringbuffer_flush(void) {
     /* Send character. */
     if (U1STAbits.UTXBF == NO) {
       user_serial_ringbuffer_read = index;
-      U1TXREG =
-          bus_pirate_configuration.terminal_input[user_serial_ringbuffer_read];
+      U1TXREG = user_serial_ringbuffer[user_serial_ringbuffer_read];
     }
   }
 }
@@ -665,55 +899,251 @@ void user_serial_ringbuffer_append(const char character) {
   if (user_serial_ringbuffer_write == user_serial_ringbuffer_read) {
     BP_LEDMODE = LOW;
     bus_pirate_configuration.overflow = YES;
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_OVERFLOWS);
     return;
   }
 
-  bus_pirate_configuration.terminal_input[user_serial_ringbuffer_write] =
-      character;
+  user_serial_ringbuffer[user_serial_ringbuffer_write] = character;
   user_serial_ringbuffer_write++;
-  if (user_serial_ringbuffer_write == BP_TERMINAL_BUFFER_SIZE) {
+  if (user_serial_ringbuffer_write == user_serial_ringbuffer_size) {
     user_serial_ringbuffer_write = 0;
   }
 }
 
 uint8_t user_serial_read_byte(void) {
-  while (U1STAbits.URXDA == NO) {
+  uint16_t tail;
+  uint8_t value;
+
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_SERIAL_READ);
+  tail = user_serial_receive_ring_tail;
+
+  /*
+   * If the ring is empty, empty the FIFO by hand: this works even when called
+   * with the interrupt priority level above the reception interrupt's.
+   */
+  while (tail == user_serial_receive_ring_head) {
+    if (U1STAbits.URXDA == YES) {
+      bool enabled;
+
+      enabled = IEC0bits.U1RXIE;
+      IEC0bits.U1RXIE = OFF;
+      user_serial_receive_fifo();
+      IEC0bits.U1RXIE = enabled;
+    } else {
+      bp_yield();
+    }
+  }
+
+  value = user_serial_receive_ring[tail];
+  user_serial_receive_ring_tail = (tail + 1) & USER_SERIAL_RECEIVE_RING_MASK;
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_SERIAL_READ);
+
+  return value;
+}
+
+void user_serial_receive_fifo(void) {
+  uint16_t head;
+  uint16_t next;
+
+  head = user_serial_receive_ring_head;
+  while (U1STAbits.URXDA == YES) {
+    if (UART1RXRecvd != UART1RXToRecv) {
+      UART1RXBuf[UART1RXRecvd] = U1RXREG;
+      UART1RXRecvd++;
+      continue;
+    }
+
+    next = (head + 1) & USER_SERIAL_RECEIVE_RING_MASK;
+    if (next == user_serial_receive_ring_tail) {
+      /* The ring is full, the character is lost. */
+      (void)U1RXREG;
+      user_serial_receive_ring_overflow = YES;
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_OVERFLOWS);
+      continue;
+    }
+
+    user_serial_receive_ring[head] = U1RXREG;
+    head = next;
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_BYTES_IN);
   }
+  user_serial_receive_ring_head = head;
+  BP_TELEMETRY_HIGH_WATER(
+      BP_TELEMETRY_RECEIVE_RING_HIGH_WATER,
+      (head - user_serial_receive_ring_tail) & USER_SERIAL_RECEIVE_RING_MASK);
+}
+
+void user_serial_start_block_reception(uint8_t *buffer, const uint16_t length) {
+  uint16_t tail;
+
+  IEC0bits.U1RXIE = OFF;
+  UART1RXBuf = buffer;
+  UART1RXToRecv = length;
+  UART1RXRecvd = 0;
+
+  /* Whatever was queued up before the transfer started belongs to it. */
+  tail = user_serial_receive_ring_tail;
+  while ((UART1RXRecvd != UART1RXToRecv) &&
+         (tail != user_serial_receive_ring_head)) {
+    buffer[UART1RXRecvd] = user_serial_receive_ring[tail];
+    UART1RXRecvd++;
+    tail = (tail + 1) & USER_SERIAL_RECEIVE_RING_MASK;
+  }
+  user_serial_receive_ring_tail = tail;
 
-  return LO8(U1RXREG);
+  user_serial_receive_fifo();
+  IEC0bits.U1RXIE = ON;
+}
+
+void user_serial_stop_block_reception(void) {
+  IEC0bits.U1RXIE = OFF;
+  UART1RXToRecv = UART1RXRecvd;
+  IEC0bits.U1RXIE = ON;
+}
+
+bool user_serial_transmit_ring_fill_fifo(void) {
+  uint16_t tail;
+
+  tail = user_serial_transmit_ring_tail;
+  while ((tail != user_serial_transmit_ring_head) &&
+         (U1STAbits.UTXBF == NO)) {
+    U1TXREG = user_serial_transmit_ring[tail];
+    tail = (tail + 1) & USER_SERIAL_TRANSMIT_RING_MASK;
+  }
+  user_serial_transmit_ring_tail = tail;
+
+  return tail == user_serial_transmit_ring_head;
 }
 
 void user_serial_transmit_character(const char character) {
+  uint16_t next;
+
   /* Do not transmit if the board should be quiet. */
   if (bus_pirate_configuration.quiet) {
     return;
   }
 
-  /* Wait until transmission can take place. */
-  while (U1STAbits.UTXBF == ON) {
+  next = (user_serial_transmit_ring_head + 1) & USER_SERIAL_TRANSMIT_RING_MASK;
+
+  /*
+   * If the ring is full, drain it by hand: this works even when called with
+   * the interrupt priority level above the transmission interrupt's.
+   */
+  while (next == user_serial_transmit_ring_tail) {
+    if (UART1TXSent == UART1TXAvailable) {
+      IEC0bits.U1TXIE = OFF;
+      user_serial_transmit_ring_fill_fifo();
+      IEC0bits.U1TXIE = ON;
+    } else {
+      bp_yield();
+    }
   }
 
-  U1TXREG = character;
+  user_serial_transmit_ring[user_serial_transmit_ring_head] = character;
+  user_serial_transmit_ring_head = next;
+  BP_TELEMETRY_COUNT(BP_TELEMETRY_BYTES_OUT);
+  BP_TELEMETRY_HIGH_WATER(
+      BP_TELEMETRY_TRANSMIT_RING_HIGH_WATER,
+      (next - user_serial_transmit_ring_tail) & USER_SERIAL_TRANSMIT_RING_MASK);
+
+  /* Kick the handler if it went idle, unless a block transfer is running. */
+  if ((IEC0bits.U1TXIE == OFF) && (UART1TXSent == UART1TXAvailable)) {
+    IEC0bits.U1TXIE = ON;
+    IFS0bits.U1TXIF = ON;
+  }
+}
+
+void user_serial_write_buffer(const uint8_t *buffer, size_t length) {
+  /* Do not transmit if the board should be quiet. */
+  if (bus_pirate_configuration.quiet) {
+    return;
+  }
+
+  while (length > 0) {
+    uint16_t head;
+    uint16_t tail;
+    uint16_t chunk;
+
+    head = user_serial_transmit_ring_head;
+    tail = user_serial_transmit_ring_tail;
+
+    /* Free space up to either the end of the ring or the slot before tail. */
+    if (head >= tail) {
+      chunk = USER_SERIAL_TRANSMIT_RING_SIZE - head;
+      if (tail == 0) {
+        chunk--;
+      }
+    } else {
+      chunk = tail - head - 1;
+    }
+
+    if (chunk == 0) {
+      /* The ring is full, drain it by hand if the handler cannot run. */
+      if (UART1TXSent == UART1TXAvailable) {
+        IEC0bits.U1TXIE = OFF;
+        user_serial_transmit_ring_fill_fifo();
+        IEC0bits.U1TXIE = ON;
+      }
+      continue;
+    }
+
+    if (chunk > length) {
+      chunk = length;
+    }
+
+    memcpy(&user_serial_transmit_ring[head], buffer, chunk);
+    user_serial_transmit_ring_head =
+        (head + chunk) & USER_SERIAL_TRANSMIT_RING_MASK;
+    BP_TELEMETRY_ADD(BP_TELEMETRY_BYTES_OUT, chunk);
+    BP_TELEMETRY_HIGH_WATER(BP_TELEMETRY_TRANSMIT_RING_HIGH_WATER,
+                            (user_serial_transmit_ring_head - tail) &
+                                USER_SERIAL_TRANSMIT_RING_MASK);
+    buffer += chunk;
+    length -= chunk;
+
+    /* Kick the handler if it went idle, unless a block transfer is running. */
+    if ((IEC0bits.U1TXIE == OFF) && (UART1TXSent == UART1TXAvailable)) {
+      IEC0bits.U1TXIE = ON;
+      IFS0bits.U1TXIF = ON;
+    }
+  }
 }
 
 void user_serial_wait_transmission_done(void) {
+  /* Drain the ring by hand, the handler may not be able to run. */
+  while (user_serial_transmit_ring_tail != user_serial_transmit_ring_head) {
+    if (UART1TXSent == UART1TXAvailable) {
+      IEC0bits.U1TXIE = OFF;
+      user_serial_transmit_ring_fill_fifo();
+      IEC0bits.U1TXIE = ON;
+    }
+  }
+
   while (U1STAbits.TRMT == NO) {
   }
 }
 
-void user_serial_set_baud_rate(const uint16_t rate) { U1BRG = rate; }
+void user_serial_set_baud_rate(const uint16_t rate) {
+  /* Do not garble characters still waiting to be sent. */
+  user_serial_wait_transmission_done();
+  U1BRG = rate;
+}
 
-bool user_serial_check_overflow(void) { return U1STAbits.OERR; }
+bool user_serial_check_overflow(void) {
+  return U1STAbits.OERR || user_serial_receive_ring_overflow;
+}
 
-void user_serial_clear_overflow(void) { U1STAbits.OERR = NO; }
+void user_serial_clear_overflow(void) {
+  U1STAbits.OERR = NO;
+  user_serial_receive_ring_overflow = NO;
+}
 
 /* interrupt transfer related stuff */
-unsigned char __attribute__((section(".bss.filereg"))) * UART1RXBuf;
-unsigned int __attribute__((section(".bss.filereg"))) UART1RXToRecv;
-unsigned int __attribute__((section(".bss.filereg"))) UART1RXRecvd;
-unsigned char __attribute__((section(".bss.filereg"))) * UART1TXBuf;
-unsigned int __attribute__((section(".bss.filereg"))) UART1TXSent;
-unsigned int __attribute__((section(".bss.filereg"))) UART1TXAvailable;
+uint8_t __attribute__((section(".bss.filereg"))) * UART1RXBuf;
+uint16_t __attribute__((section(".bss.filereg"))) UART1RXToRecv;
+uint16_t __attribute__((section(".bss.filereg"))) UART1RXRecvd;
+const uint8_t __attribute__((section(".bss.filereg"))) * UART1TXBuf;
+uint16_t __attribute__((section(".bss.filereg"))) UART1TXSent;
+uint16_t __attribute__((section(".bss.filereg"))) UART1TXAvailable;
 
 void user_serial_process_transmission_interrupt() {
   /* Quit early if there is nothing to transmit. */
@@ -736,25 +1166,55 @@ void user_serial_process_transmission_interrupt() {
 }
 
 void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void) {
-  UART1RXBuf[UART1RXRecvd] = U1RXREG;
-  UART1RXRecvd++;
-
-  if (UART1RXRecvd == UART1RXToRecv) {
-    IEC0bits.U1RXIE = NO;
-  }
-
   IFS0bits.U1RXIF = OFF;
+  user_serial_receive_fifo();
 }
 
 void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void) {
-  UART1TXSent++;
-  if (UART1TXSent == UART1TXAvailable) {
-    IEC0bits.U1TXIE = NO;
-  } else {
-    U1TXREG = UART1TXBuf[UART1TXSent];
+  /* A block transfer is running, one interrupt per character. */
+  if (UART1TXSent != UART1TXAvailable) {
+    UART1TXSent++;
+    if (UART1TXSent != UART1TXAvailable) {
+      U1TXREG = UART1TXBuf[UART1TXSent];
+      IFS0bits.U1TXIF = OFF;
+      return;
+    }
   }
 
+  /* Serve the transmission ring, and stop once it is empty. */
   IFS0bits.U1TXIF = OFF;
+  if (user_serial_transmit_ring_fill_fifo()) {
+    IEC0bits.U1TXIE = NO;
+  }
+}
+
+/**
+ * @brief Holds the byte handed out by user_serial_borrow_input.
+ */
+static uint8_t user_serial_borrowed_byte;
+
+const uint8_t *user_serial_borrow_input(const size_t maximum
+                                        __attribute__((unused)),
+                                        size_t *length) {
+  user_serial_borrowed_byte = user_serial_read_byte();
+  *length = 1;
+  return &user_serial_borrowed_byte;
+}
+
+/**
+ * @brief Current flush policy. The UART sends every byte as soon as it can,
+ * so the setting is only kept for user_serial_set_flush_policy callers.
+ */
+static user_serial_flush_policy_t user_serial_flush_policy =
+    USER_SERIAL_FLUSH_ON_TIMEOUT;
+
+user_serial_flush_policy_t
+user_serial_set_flush_policy(const user_serial_flush_policy_t policy) {
+  user_serial_flush_policy_t previous;
+
+  previous = user_serial_flush_policy;
+  user_serial_flush_policy = policy;
+  return previous;
 }
 
 #endif /* BUSPIRATEV3 */
@@ -763,31 +1223,178 @@ void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void) {
 
 extern BDentry *CDC_Outbdp, *CDC_Inbdp;
 
+#ifdef BP_USB_VENDOR_INTERFACE
+
+/**
+ * @brief Whether the user-facing serial port is carried by the vendor bulk
+ * pipe rather than by the CDC interface.
+ */
+static bool user_serial_vendor_pipe = NO;
+
+bool user_serial_vendor_pipe_pending(void) {
+  return !user_serial_vendor_pipe && vendor_out_ready();
+}
+
+void user_serial_select_vendor_pipe(const bool enable) {
+  user_serial_flush_policy_t policy;
+
+  /* Let pending output out on the pipe it was meant for. */
+  user_serial_ringbuffer_flush();
+  policy = user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_TIMEOUT);
+  user_serial_vendor_pipe = enable;
+  user_serial_set_flush_policy(policy);
+}
+
+#endif /* BP_USB_VENDOR_INTERFACE */
+
 void user_serial_transmit_character(const char character) {
   if (bus_pirate_configuration.quiet) {
     return;
   }
 
+  BP_TELEMETRY_COUNT(BP_TELEMETRY_BYTES_OUT);
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    vendor_putc(character);
+    return;
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
   putc_cdc(character);
 }
 
+void user_serial_write_buffer(const uint8_t *buffer, size_t length) {
+  if (bus_pirate_configuration.quiet) {
+    return;
+  }
+
+  BP_TELEMETRY_ADD(BP_TELEMETRY_BYTES_OUT, length);
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    vendor_putbuffer(buffer, length);
+    return;
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  putbuffer_cdc(buffer, length);
+}
+
 void user_serial_ringbuffer_append(const char character) {
   user_serial_transmit_character(character);
 }
 
-bool user_serial_ready_to_read(void) { return cdc_Out_len || getOutReady(); }
+bool user_serial_ready_to_read(void) {
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    return vendor_out_ready();
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  return cdc_Out_len || getOutReady();
+}
+
+void user_serial_end_of_response(void) {
+  if (user_serial_ready_to_read()) {
+    return;
+  }
+
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    vendor_end_of_response();
+    return;
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  CDC_Flush_End_Of_Response();
+}
+
+uint8_t user_serial_read_byte(void) {
+  uint8_t value;
+
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_SERIAL_READ);
+  user_serial_end_of_response();
+  while (!user_serial_ready_to_read()) {
+    bp_yield();
+  }
+
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    value = vendor_getc();
+  } else {
+    value = getc_cdc();
+  }
+#else
+  value = getc_cdc();
+#endif /* BP_USB_VENDOR_INTERFACE */
+  BP_TELEMETRY_COUNT(BP_TELEMETRY_BYTES_IN);
+
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_SERIAL_READ);
+  return value;
+}
+
+const uint8_t *user_serial_borrow_input(const size_t maximum, size_t *length) {
+  BYTE borrowed;
+  BYTE wanted;
+  const uint8_t *data;
+
+  user_serial_end_of_response();
 
-uint8_t user_serial_read_byte(void) { return getc_cdc(); }
+  wanted = (maximum < CDC_BUFFER_SIZE) ? (BYTE)maximum : CDC_BUFFER_SIZE;
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    data = vendor_borrow(wanted, &borrowed);
+  } else {
+    data = borrow_cdc(wanted, &borrowed);
+  }
+#else
+  data = borrow_cdc(wanted, &borrowed);
+#endif /* BP_USB_VENDOR_INTERFACE */
+  BP_TELEMETRY_ADD(BP_TELEMETRY_BYTES_IN, borrowed);
+  *length = borrowed;
+  return data;
+}
+
+/* The CDC policy values match user_serial_flush_policy_t. */
+user_serial_flush_policy_t
+user_serial_set_flush_policy(const user_serial_flush_policy_t policy) {
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    return (user_serial_flush_policy_t)vendor_set_flush_policy((BYTE)policy);
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  return (user_serial_flush_policy_t)CDC_Set_Flush_Policy((BYTE)policy);
+}
+
+void user_serial_ringbuffer_flush(void) {
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    vendor_flush();
+    return;
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  CDC_Flush_In_Now();
+}
 
-void user_serial_ringbuffer_flush(void) { CDC_Flush_In_Now(); }
+bool user_serial_ringbuffer_setup(void) { return true; }
 
-void user_serial_ringbuffer_setup(void) {}
+void user_serial_ringbuffer_release(void) {}
 
 void user_serial_ringbuffer_process(void) {}
 
 void user_serial_initialise(void) {}
 
-void user_serial_wait_transmission_done(void) { WaitInReady(); }
+void user_serial_wait_transmission_done(void) {
+#ifdef BP_USB_VENDOR_INTERFACE
+  if (user_serial_vendor_pipe) {
+    vendor_wait_in_ready();
+    return;
+  }
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+  WaitInReady();
+}
 
 bool user_serial_check_overflow(void) { return NO; }
 
@@ -798,3 +1405,37 @@ void user_serial_set_baud_rate(const uint16_t rate __attribute__((unused))) {}
 bool user_serial_transmit_done(void) { return YES; }
 
 #endif /* BUSPIRATEV4 */
+
+void user_serial_write_stream(const uint8_t *buffer, size_t length) {
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+  if (isochronous_active()) {
+    BP_TELEMETRY_ADD(BP_TELEMETRY_BYTES_OUT, length);
+    isochronous_putbuffer(buffer, length);
+    return;
+  }
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
+
+  user_serial_write_buffer(buffer, length);
+}
+
+void bp_notify(const bp_notification_t event __attribute__((unused))) {
+#ifdef BUSPIRATEV4
+  switch (event) {
+  case BP_NOTIFICATION_OVERFLOW:
+    cdc_notify_serial_state(CDC_SERIAL_STATE_OVERRUN);
+    break;
+
+  case BP_NOTIFICATION_ERROR:
+    cdc_notify_serial_state(CDC_SERIAL_STATE_FRAMING);
+    break;
+
+  case BP_NOTIFICATION_TRIGGER:
+    cdc_notify_serial_state(CDC_SERIAL_STATE_RING_SIGNAL);
+    break;
+
+  case BP_NOTIFICATION_CAPTURE_COMPLETE:
+    cdc_notify_serial_state(CDC_SERIAL_STATE_PARITY);
+    break;
+  }
+#endif /* BUSPIRATEV4 */
+}
@@ -46,6 +46,12 @@
  */
 #define BP_FIRMWARE_STRING "Community Firmware v7.1 - goo.gl/gCzQnW "
 
+/**
+ * @brief Firmware version numbers, as BP_FIRMWARE_STRING, for binary mode.
+ */
+#define BP_FIRMWARE_VERSION_MAJOR 7
+#define BP_FIRMWARE_VERSION_MINOR 1
+
 /**
  * @brief Current mode configuration settings structure.
  *
@@ -162,6 +168,47 @@ void bp_adc_continuous_probe(void);
  */
 void bp_write_formatted_integer(const uint16_t value);
 
+/**
+ * @brief How many bytes bp_format_integer can write at most.
+ */
+#define BP_FORMATTED_INTEGER_MAX_LENGTH 21
+
+/**
+ * @brief Renders the given value into a buffer, exactly as
+ * bp_write_formatted_integer would print it.
+ *
+ * @param[out] buffer where to write the text, must be able to hold at least
+ * BP_FORMATTED_INTEGER_MAX_LENGTH bytes.
+ * @param[in] value the value to render.
+ *
+ * @return how many bytes were written.
+ */
+size_t bp_format_integer(uint8_t *buffer, const uint16_t value);
+
+/**
+ * @brief Renders the given value in base 10 into a buffer, without leading
+ * zeroes.
+ *
+ * @param[out] buffer where to write the text, must be able to hold at least 5
+ * bytes.
+ * @param[in] value the value to render.
+ *
+ * @return how many bytes were written.
+ */
+size_t bp_format_dec_word(uint8_t *buffer, const uint16_t value);
+
+/**
+ * @brief Renders the given 32-bits value in base 10 into a buffer, without
+ * leading zeroes.
+ *
+ * @param[out] buffer where to write the text, must be able to hold at least 10
+ * bytes.
+ * @param[in] value the value to render.
+ *
+ * @return how many bytes were written.
+ */
+size_t bp_format_dec_dword(uint8_t *buffer, const uint32_t value);
+
 /**
  * @brief Pauses execution for the given amount of milliseconds.
  *
@@ -176,6 +223,16 @@ void bp_write_formatted_integer(const uint16_t value);
  */
 #define bp_delay_us(microseconds) __delay_us(microseconds)
 
+/**
+ * @brief Pauses execution for the given amount of instruction cycles.
+ *
+ * Unlike bp_delay_us, this is cheap to call with a value computed at runtime.
+ * Very short delays are rounded up to the minimum __delay32 can do.
+ *
+ * @param[in] cycles the amount of instruction cycles to wait.
+ */
+#define bp_delay_cycles(cycles) __delay32(cycles)
+
 /**
  * @brief Writes the given buffer to the serial port.
  *
@@ -297,10 +354,29 @@ void bp_write_hex_byte_to_ringbuffer(const uint8_t value);
 extern uint8_t *UART1RXBuf;
 extern uint16_t UART1RXToRecv;
 extern uint16_t UART1RXRecvd;
-extern uint8_t *UART1TXBuf;
+extern const uint8_t *UART1TXBuf;
 extern uint16_t UART1TXSent;
 extern uint16_t UART1TXAvailable;
 
+/**
+ * @brief Makes the UART1 reception interrupt store the next incoming bytes
+ * straight into the given buffer, UART1RXRecvd counting how many arrived.
+ *
+ * Bytes already waiting in the reception ring are moved into the buffer
+ * first.  Once the buffer is full, incoming bytes go to the reception ring
+ * again.
+ *
+ * @param[in] buffer where to store the incoming bytes.
+ * @param[in] length how many bytes to store.
+ */
+void user_serial_start_block_reception(uint8_t *buffer, const uint16_t length);
+
+/**
+ * @brief Ends a block reception before its buffer is full, incoming bytes go
+ * to the reception ring again.
+ */
+void user_serial_stop_block_reception(void);
+
 #endif /* BUSPIRATEV3 */
 
 /**
@@ -321,9 +397,9 @@ void user_serial_initialise(void);
 bool user_serial_transmit_done(void);
 
 /**
- * @brief Checks whether the reception queue is full or not.
+ * @brief Checks whether there is incoming data waiting to be read.
  *
- * @return YES if the reception queue is not full, NO otherwise.
+ * @return YES if user_serial_read_byte would not block, NO otherwise.
  */
 bool user_serial_ready_to_read(void);
 
@@ -353,6 +429,78 @@ void user_serial_set_baud_rate(const uint16_t rate);
  */
 void user_serial_wait_transmission_done(void);
 
+/**
+ * @brief CPU priority level masking the servicing of the host link.
+ *
+ * On v4 that is the USB stack interrupt, on v3 the UART1 interrupts, which are
+ * left at their default priority.
+ */
+#ifdef BUSPIRATEV4
+#define BP_HOST_LINK_INTERRUPT_PRIORITY USB_INTERRUPT_PRIORITY
+#else
+#define BP_HOST_LINK_INTERRUPT_PRIORITY 4
+#endif /* BUSPIRATEV4 */
+
+/**
+ * @brief Masks the host link interrupts around a short timing critical section.
+ *
+ * Interrupts with a higher priority, such as the bus mode ones, still run.
+ * Keep the section in the tens of microseconds, the USB stack tolerates that.
+ *
+ * @param[out] saved where the current CPU priority level is saved, for
+ *                   BP_RESTORE_INTERRUPT_LEVEL.
+ */
+#define BP_MASK_HOST_LINK_INTERRUPTS(saved)                                    \
+  do {                                                                         \
+    (saved) = SRbits.IPL;                                                      \
+    if ((saved) < BP_HOST_LINK_INTERRUPT_PRIORITY) {                           \
+      SRbits.IPL = BP_HOST_LINK_INTERRUPT_PRIORITY;                            \
+    }                                                                          \
+  } while (0)
+
+/**
+ * @brief Restores the CPU priority level saved by BP_MASK_HOST_LINK_INTERRUPTS.
+ *
+ * @param[in] saved the saved CPU priority level.
+ */
+#define BP_RESTORE_INTERRUPT_LEVEL(saved) SRbits.IPL = (saved)
+
+/**
+ * @brief When partially filled output packets are sent to the host.
+ *
+ * Only meaningful on v4, where output is grouped in USB packets; on v3 the
+ * UART sends every byte as soon as it can.
+ */
+typedef enum {
+  /** A partial packet goes out after a short timeout (the default). */
+  USER_SERIAL_FLUSH_ON_TIMEOUT = 0,
+
+  /**
+   * Like USER_SERIAL_FLUSH_ON_TIMEOUT, and the output is also sent at once
+   * when user_serial_read_byte has to wait for the host, that is when a reply
+   * is complete.
+   */
+  USER_SERIAL_FLUSH_ON_RESPONSE,
+
+  /** Output is held until a packet is full, or a much longer timeout. */
+  USER_SERIAL_FLUSH_WHEN_FULL
+} user_serial_flush_policy_t;
+
+/**
+ * @brief Selects when output to the user-facing serial port is flushed.
+ *
+ * Command/response protocols want USER_SERIAL_FLUSH_ON_RESPONSE, streams want
+ * USER_SERIAL_FLUSH_ON_TIMEOUT, and bulk dumps USER_SERIAL_FLUSH_WHEN_FULL,
+ * restoring the previous policy once done.  Leaving
+ * USER_SERIAL_FLUSH_WHEN_FULL sends whatever output was held back.
+ *
+ * @param[in] policy the new flush policy.
+ *
+ * @return the previous flush policy.
+ */
+user_serial_flush_policy_t
+user_serial_set_flush_policy(const user_serial_flush_policy_t policy);
+
 /**
  * @brief Blocks execution until a byte arrives on the user-facing serial port
  * and returns said value.
@@ -361,6 +509,41 @@ void user_serial_wait_transmission_done(void);
  */
 uint8_t user_serial_read_byte(void);
 
+/**
+ * @brief Borrows incoming data straight from the user-facing serial port
+ * receive buffer, blocking until at least one byte is available.
+ *
+ * On v4 this hands out the pending part of the CDC OUT packet without copying
+ * it, on v3 one byte is returned at a time.  The bytes count as read, and stay
+ * valid until the next call reading from the serial port.
+ *
+ * @param[in]  maximum how many bytes the caller wants at most, must not be 0.
+ * @param[out] length  how many bytes were handed out.
+ *
+ * @return a pointer to the borrowed bytes.
+ */
+const uint8_t *user_serial_borrow_input(const size_t maximum, size_t *length);
+
+#ifdef BP_USB_VENDOR_INTERFACE
+
+/**
+ * @brief Returns whether the host sent data on the vendor bulk pipe while the
+ * user-facing serial port is still on the CDC interface.
+ *
+ * @return YES if binary mode should be entered on the vendor pipe.
+ */
+bool user_serial_vendor_pipe_pending(void);
+
+/**
+ * @brief Moves the user-facing serial port to the vendor bulk pipe or back to
+ * the CDC interface, flushing output still pending on the current one.
+ *
+ * @param[in] enable YES to use the vendor pipe, NO for the CDC interface.
+ */
+void user_serial_select_vendor_pipe(const bool enable);
+
+#endif /* BP_USB_VENDOR_INTERFACE */
+
 /**
  * @brief Writes the first available byte from the transmission queue into the
  * serial port transmission buffer register.
@@ -368,8 +551,65 @@ uint8_t user_serial_read_byte(void);
 void user_serial_process_transmission_interrupt(void);
 
 /**
- * @brief Writes the given character to the user-facing serial port, blocking
- * until the transmission completes.
+ * @brief Writes the given buffer to the user-facing serial port.
+ *
+ * On v3 the data is copied into the transmission ring in as few steps as
+ * possible, blocking only while the ring is full.  On v4 it is copied into the
+ * CDC IN buffers, each one being submitted as soon as it is full.
+ *
+ * @param[in] buffer the data to write.
+ * @param[in] length how many bytes to write.
+ */
+void user_serial_write_buffer(const uint8_t *buffer, size_t length);
+
+/**
+ * @brief Writes streamed capture data for the host.
+ *
+ * When BP_USB_ISOCHRONOUS_STREAM is set and the host has selected the
+ * streaming alternate setting, the data goes to the isochronous endpoint,
+ * otherwise this is the same as user_serial_write_buffer().
+ *
+ * @param[in] buffer the data to write.
+ * @param[in] length how many bytes to write.
+ */
+void user_serial_write_stream(const uint8_t *buffer, size_t length);
+
+/**
+ * Out of band events reported to the host, see bp_notify().
+ */
+typedef enum {
+  /** Data was lost, on the bus being watched or on the way to the host. */
+  BP_NOTIFICATION_OVERFLOW = 0,
+  /** A line error was seen on the bus, such as a bad UART frame. */
+  BP_NOTIFICATION_ERROR,
+  /** A capture trigger fired. */
+  BP_NOTIFICATION_TRIGGER,
+  /** A capture is done, and its data is about to be sent. */
+  BP_NOTIFICATION_CAPTURE_COMPLETE
+} bp_notification_t;
+
+/**
+ * @brief Reports an event to the host without touching the data stream.
+ *
+ * On v4 the event goes out as a CDC SERIAL_STATE notification on the
+ * interrupt endpoint, within a frame, so binary streams stay untouched. The
+ * events borrow bits that standard drivers count (TIOCGICOUNT on Linux):
+ * overflows are overruns, errors are framing errors, triggers are rings, and
+ * completed captures are parity errors.  v3 has no such channel, and drops
+ * the events.
+ *
+ * This only queues the event, and can be called from interrupt handlers.
+ *
+ * @param[in] event the event to report.
+ */
+void bp_notify(const bp_notification_t event);
+
+/**
+ * @brief Writes the given character to the user-facing serial port.
+ *
+ * On v3 the character is queued into a transmission ring drained by the UART1
+ * transmission interrupt handler, and the call only blocks if the ring is
+ * full.  On v4 it is appended to the CDC IN buffer.
  *
  * @param[in] character the character to write.
  */
@@ -379,6 +619,46 @@ void user_serial_transmit_character(const char character);
  * @}
  */
 
+#ifdef BP_CHANGE_NOTIFICATION_DISPATCH
+
+/**
+ * Change notification interrupt handler, called with the interrupt flag
+ * already cleared.
+ */
+typedef void (*bp_change_notification_handler_t)(void);
+
+/**
+ * @brief Routes the change notification interrupt to the given handler.
+ *
+ * Set it before enabling the interrupt, and clear it with NULL once the
+ * interrupt is disabled again.
+ *
+ * @param[in] handler the handler to call, or NULL for none.
+ */
+void bp_set_change_notification_handler(
+    const bp_change_notification_handler_t handler);
+
+#endif /* BP_CHANGE_NOTIFICATION_DISPATCH */
+
+#ifdef BP_ADC_INTERRUPT_DISPATCH
+
+/**
+ * ADC interrupt handler, called with the interrupt flag already cleared.
+ */
+typedef void (*bp_adc_interrupt_handler_t)(void);
+
+/**
+ * @brief Routes the ADC interrupt to the given handler.
+ *
+ * Set it before enabling the interrupt, and clear it with NULL once the
+ * interrupt is disabled again.
+ *
+ * @param[in] handler the handler to call, or NULL for none.
+ */
+void bp_set_adc_interrupt_handler(const bp_adc_interrupt_handler_t handler);
+
+#endif /* BP_ADC_INTERRUPT_DISPATCH */
+
 /**
  * @defgroup user_serial_ringbuffer User-facing serial port ringbuffer
  * functions.
@@ -387,8 +667,19 @@ void user_serial_transmit_character(const char character);
 
 /**
  * @brief Sets up the user-facing serial port ringbuffer.
+ *
+ * On v3 boards the ringbuffer is reserved from whatever the buffer arena has
+ * left, so anything the caller needs from the arena must be reserved first.
+ * Every successful setup must be matched by user_serial_ringbuffer_release().
+ *
+ * @return true if the ringbuffer is ready, false if the arena is full.
+ */
+bool user_serial_ringbuffer_setup(void);
+
+/**
+ * @brief Gives the ringbuffer memory back to the buffer arena.
  */
-void user_serial_ringbuffer_setup(void);
+void user_serial_ringbuffer_release(void);
 
 /**
  * @brief Flushes the user-facing serial port ringbuffer.
@@ -45,6 +45,27 @@
 #error "Invalid BASIC stack depth"
 #endif /* BP_BASIC_STACK_FRAMES_DEPTH <= 1*/
 
+#if BP_BASIC_LINE_INDEX_SIZE <= 0
+#error "Invalid BASIC line index size"
+#endif /* BP_BASIC_LINE_INDEX_SIZE <= 0 */
+
+#if (BP_BASIC_EXPRESSION_CACHE_SIZE <= 0) ||                                   \
+    (BP_BASIC_EXPRESSION_CACHE_SIZE & (BP_BASIC_EXPRESSION_CACHE_SIZE - 1))
+#error "Invalid BASIC expression cache size"
+#endif /* BP_BASIC_EXPRESSION_CACHE_SIZE */
+
+#if (BP_BASIC_BYTECODE_SPACE <= 0) || (BP_BASIC_BYTECODE_SPACE >= 0xFFFF)
+#error "Invalid BASIC bytecode space value"
+#endif /* BP_BASIC_BYTECODE_SPACE */
+
+#if BP_BASIC_EXPRESSION_STACK_DEPTH <= 1
+#error "Invalid BASIC expression stack depth"
+#endif /* BP_BASIC_EXPRESSION_STACK_DEPTH <= 1 */
+
+#if BP_BASIC_BUFFER_SIZE <= 0
+#error "Invalid BASIC buffer size"
+#endif /* BP_BASIC_BUFFER_SIZE <= 0 */
+
 /**
  * @brief How many variables the BASIC interpreter can handle.
  *
@@ -54,8 +75,11 @@
 
 #include "aux_pin.h"
 #include "base.h"
+#include "binary_io.h"
 #include "bitbang.h"
+#include "buffer_arena.h"
 #include "core.h"
+#include "onboard_eeprom.h"
 #include "proc_menu.h"
 
 #define INVALID_TOKEN 0x00
@@ -97,10 +121,11 @@
 
 #define TOK_MACRO 0xA0
 #define TOK_END 0xA1
+#define TOK_BUF 0xA2
 
 #define TOK_LEN 0xE0
 
-#define NUMTOKEN (TOK_END - TOKENS) + 1
+#define NUMTOKEN (TOK_BUF - TOKENS) + 1
 
 #define STAT_LET "LET"
 #define STAT_IF "IF"
@@ -137,6 +162,7 @@
 #define STAT_FREQ "FREQ"
 #define STAT_DUTY "DUTY"
 #define STAT_MACRO "MACRO"
+#define STAT_BUF "BUF"
 
 /**
  * @brief Status codes enumeration for the internal BASIC parser.
@@ -191,7 +217,12 @@ typedef enum {
   /**
    * One or more invalid `DATA` statements were found.
    */
-  STATUS_CODE_DATA_ERROR
+  STATUS_CODE_DATA_ERROR,
+
+  /**
+   * A `BUF` access went past the end of the buffer.
+   */
+  STATUS_CODE_BUFFER_ERROR
 } __attribute__((packed)) basic_status_code_t;
 
 /**
@@ -207,7 +238,7 @@ typedef enum {
 extern bus_pirate_configuration_t bus_pirate_configuration;
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
-extern bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT];
+extern const bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT];
 
 typedef struct {
   uint16_t from;
@@ -227,7 +258,12 @@ static uint16_t basic_current_stack_frame;
  */
 static uint16_t basic_data_read_pointer;
 
-static char *tokens[NUMTOKEN + 1] = {
+/**
+ * @brief Byte buffer for `BUF` accesses and bulk transfers.
+ */
+static uint8_t basic_buffer[BP_BASIC_BUFFER_SIZE];
+
+static const char *const tokens[NUMTOKEN + 1] = {
     STAT_LET,     // 0x80
     STAT_IF,      // 0x81
     STAT_THEN,    // 0x82
@@ -263,6 +299,7 @@ static char *tokens[NUMTOKEN + 1] = {
 
     STAT_MACRO, // 0xA0
     STAT_END,   // 0xA1
+    STAT_BUF,   // 0xA2
 };
 
 /**
@@ -270,6 +307,196 @@ static char *tokens[NUMTOKEN + 1] = {
  */
 static uint8_t basic_program_area[BP_BASIC_PROGRAM_SPACE] = {0};
 
+/**
+ * @brief Line offsets index for the program currently loaded.
+ */
+static struct {
+  /** Program offset of each indexed line, in line number order. */
+  uint16_t offsets[BP_BASIC_LINE_INDEX_SIZE];
+
+  /** How many entries of offsets are in use. */
+  uint16_t count;
+
+  /** Offset of the first line not in the index, or 0 if all lines are. */
+  uint16_t remainder;
+
+  /** Whether the index matches the program area contents. */
+  bool valid;
+} basic_line_index;
+
+/**
+ * @brief Marks the line index as stale, to be rebuilt on the next lookup.
+ *
+ * Must be called whenever the program area contents change.
+ */
+static inline void invalidate_line_index(void);
+
+/**
+ * @brief Rebuilds the line index from the program area contents.
+ */
+static void build_line_index(void);
+
+/**
+ * @brief Reads the line number of the line at the given program offset.
+ *
+ * @param[in] offset the program offset of the line length token.
+ *
+ * @return the line number.
+ */
+static inline uint16_t line_number_at(const uint16_t offset);
+
+/**
+ * @brief Walks the program from the given offset looking for a line number.
+ *
+ * @param[in] line the line number to obtain an offset for.
+ * @param[in] index the program offset to start from.
+ * @param[out] result the offset in program memory for the line in question.
+ *
+ * @return LINE_NUMBER_FOUND if a matching line was found in program memory.
+ * @return LINE_NUMBER_NOT_FOUND if it was not found.
+ */
+static bool scan_line_number(const uint16_t line, size_t index,
+                             uint16_t *result);
+
+/**
+ * @brief Compiled expression bytecode operations.
+ *
+ * Operands are pushed on the evaluation stack, operators pop two values and
+ * push the result, in the same order the text parser applies them.
+ */
+typedef enum {
+  /** End of the expression, the value on top of the stack is the result. */
+  OPCODE_END = 0,
+  /** Pushes the two bytes that follow, MSB first. */
+  OPCODE_CONSTANT,
+  /** Pushes the variable whose index follows. */
+  OPCODE_VARIABLE,
+  /** Pushes the result of the special token that follows. */
+  OPCODE_TOKEN,
+  /** Replaces the top of the stack with what sending it returns. */
+  OPCODE_SEND,
+  /** Replaces the top of the stack with that BASIC buffer entry. */
+  OPCODE_BUFFER,
+  OPCODE_MULTIPLY,
+  OPCODE_DIVIDE,
+  OPCODE_AND,
+  OPCODE_OR,
+  OPCODE_SUBTRACT,
+  OPCODE_ADD,
+  OPCODE_GREATER,
+  OPCODE_GREATER_OR_EQUAL,
+  OPCODE_LESS,
+  OPCODE_LESS_OR_EQUAL,
+  OPCODE_NOT_EQUAL,
+  OPCODE_EQUAL
+} __attribute__((packed)) basic_opcode_t;
+
+/**
+ * @brief Marks an expression cache slot as free.
+ */
+#define EXPRESSION_SLOT_FREE 0xFFFF
+
+/**
+ * @brief Marks an expression that could not be compiled.
+ */
+#define EXPRESSION_NOT_COMPILED 0xFFFF
+
+/**
+ * @brief Compiled expression cache entry.
+ */
+typedef struct {
+  /** Program offset the expression starts at, or EXPRESSION_SLOT_FREE. */
+  uint16_t source;
+  /** Program offset right after the expression. */
+  uint16_t end;
+  /** Bytecode offset, or EXPRESSION_NOT_COMPILED. */
+  uint16_t code;
+} basic_compiled_expression_t;
+
+/**
+ * @brief Compiled expressions for the program being run.
+ */
+static struct {
+  /** Hash table of compiled expressions, keyed by program offset. */
+  basic_compiled_expression_t expressions[BP_BASIC_EXPRESSION_CACHE_SIZE];
+
+  /** Bytecode storage. */
+  uint8_t code[BP_BASIC_BYTECODE_SPACE];
+
+  /** First free byte in code. */
+  uint16_t code_used;
+} basic_expression_cache;
+
+/**
+ * @brief Expression compiler state.
+ */
+static struct {
+  /** Program offset being compiled. */
+  uint16_t source;
+
+  /** Evaluation stack depth at this point of the expression. */
+  uint8_t depth;
+
+  /** Whether the expression still fits in the bytecode area and stack. */
+  bool fits;
+} basic_compiler;
+
+/**
+ * @brief Empties the compiled expressions cache.
+ */
+static void reset_expression_cache(void);
+
+/**
+ * @brief Finds the compiled version of the expression at the given program
+ * offset, compiling it if this is the first time it is seen.
+ *
+ * @param[in] source the program offset of the expression.
+ *
+ * @return the cache entry, or NULL if the cache is full.
+ */
+static const basic_compiled_expression_t *
+find_compiled_expression(const uint16_t source);
+
+/**
+ * @brief Appends a byte to the bytecode being compiled.
+ *
+ * @param[in] value the byte to append.
+ */
+static void emit_bytecode(const uint8_t value);
+
+/**
+ * @brief Compiles an operand, mirroring get_number_or_variable().
+ */
+static void compile_operand(void);
+
+/**
+ * @brief Compiles a chain of multiplicative and bitwise operations, mirroring
+ * get_multiplication_division_bitwise_ops().
+ */
+static void compile_term(void);
+
+/**
+ * @brief Compiles a full expression, mirroring parse_expression().
+ */
+static void compile_expression(void);
+
+/**
+ * @brief Runs compiled expression bytecode.
+ *
+ * @param[in] code the bytecode to run.
+ *
+ * @return the expression value.
+ */
+static int16_t run_expression(const uint8_t *code);
+
+/**
+ * @brief Evaluates the expression at the current program counter by parsing
+ * its text, for expressions that are not compiled.
+ *
+ * @return the expression value.
+ */
+static int16_t parse_expression(void);
+
 /**
  * @brief Scans the currently loaded program to find the token index of the
  * given line number.
@@ -292,7 +519,7 @@ static bool search_line_number(const uint16_t line, uint16_t *result);
  * the interface with the board hardware.
  *
  * Said tokens are `RECEIVE`, `SEND`, `AUX`, `DAT`, `BITREAD`, `PSU`,
- * `PULLUP`, and `ADC`.
+ * `PULLUP`, `ADC`, and `BUF`.
  *
  * @param[in] token the token identifier to handle.
  *
@@ -307,9 +534,41 @@ static bool search_line_number(const uint16_t line, uint16_t *result);
  * @see TOK_PSU
  * @see TOK_PULLUP
  * @see TOK_ADC
+ * @see TOK_BUF
  */
 static uint16_t handle_special_token(const uint8_t token);
 
+/**
+ * @brief Reads an entry of the BASIC buffer.
+ *
+ * @param[in] index the entry to read.
+ *
+ * @return the entry value, or 0 if the index is past the end of the buffer.
+ */
+static inline int16_t read_buffer_entry(const int16_t index);
+
+/**
+ * @brief Handles the bulk transfer form of `SEND` and `RECEIVE`, moving a
+ * block of the BASIC buffer through the current protocol.
+ *
+ * Expects the program counter to be on the `BUF` token, and leaves it after
+ * the length expression.
+ *
+ * @param[in] token TOK_SEND or TOK_RECEIVE.
+ *
+ * @return true if the transfer went through, false if the length is past the
+ * end of the buffer.
+ */
+static bool bulk_transfer(const uint8_t token);
+
+/**
+ * @brief Tells whether the program counter is on a `BUF,` bulk transfer
+ * marker.
+ *
+ * @return true if a bulk transfer follows, false otherwise.
+ */
+static inline bool bulk_transfer_follows(void);
+
 /**
  * @brief Checks whether the string at the BASIC parser current position matches
  * a valid token, and returns it if one is found.
@@ -343,16 +602,51 @@ static void list(void);
  *
  * @return YES if the string matches, NO otherwise.
  */
-static bool compare(char *pointer);
+static bool compare(const char *pointer);
 
 #ifdef BP_BASIC_I2C_FILESYSTEM
 static void directory(void);
 static void save(void);
 static void format(void);
 static void load(void);
-static void waiteeprom(void);
+
+/**
+ * @brief Reads the slot number following a `SAVE` or `LOAD` command.
+ *
+ * @return the EEPROM address of the slot, or -1 if the slot is not valid.
+ */
+static int16_t get_slot_address(void);
 #endif /* BP_BASIC_I2C_FILESYSTEM */
 
+/**
+ * @brief Replaces the program with an already tokenised image sent by the
+ * host, for the `UPLOAD` command.
+ *
+ * Once the command line is handled a success code is sent, and the host
+ * sends the image length and its CRC16 (CCITT polynomial, 0xFFFF initial
+ * value), both big endian.  A length that does not leave room for the
+ * terminating zero is refused with a failure code, otherwise a success code
+ * asks for the image itself.  The image is laid out as basic_program_area is,
+ * lines in ascending line number order each made of TOK_LEN plus the content
+ * length, the big endian line number and the content, and ends with line
+ * 65535.  A final result code tells whether the checksum and the layout were
+ * right, the program loaded so far is only replaced if they were.
+ *
+ * @return true if the program was replaced, false otherwise.
+ */
+static bool upload(void);
+
+/**
+ * @brief Checks that an uploaded image is laid out as the interpreter
+ * expects.
+ *
+ * @param[in] image the image to check.
+ * @param[in] length the image length in bytes.
+ *
+ * @return true if the image can be run, false otherwise.
+ */
+static bool upload_image_is_valid(const uint8_t *image, const uint16_t length);
+
 void handle_else_statement(void) {
   if (basic_program_area[basic_program_counter] != TOK_ELSE) {
     return;
@@ -364,8 +658,65 @@ void handle_else_statement(void) {
   }
 }
 
-bool search_line_number(const uint16_t line, uint16_t *result) {
+void invalidate_line_index(void) { basic_line_index.valid = false; }
+
+uint16_t line_number_at(const uint16_t offset) {
+  return (basic_program_area[offset + 1] << 8) + basic_program_area[offset + 2];
+}
+
+void build_line_index(void) {
   size_t index = 0;
+
+  basic_line_index.count = 0;
+  basic_line_index.remainder = 0;
+  while ((index < BP_BASIC_PROGRAM_SPACE) &&
+         (basic_program_area[index] > TOK_LEN)) {
+    if (basic_line_index.count == BP_BASIC_LINE_INDEX_SIZE) {
+      basic_line_index.remainder = index;
+      break;
+    }
+    basic_line_index.offsets[basic_line_index.count++] = index;
+    index += (basic_program_area[index] - TOK_LEN) + 3;
+  }
+  basic_line_index.valid = true;
+}
+
+bool search_line_number(const uint16_t line, uint16_t *result) {
+  uint16_t low;
+  uint16_t high;
+  uint16_t middle;
+  uint16_t current_line_number;
+
+  if (!basic_line_index.valid) {
+    build_line_index();
+  }
+
+  /* Lines are kept sorted by the editor, bisect the index. */
+  low = 0;
+  high = basic_line_index.count;
+  while (low < high) {
+    middle = (low + high) / 2;
+    current_line_number = line_number_at(basic_line_index.offsets[middle]);
+    if (current_line_number == line) {
+      *result = basic_line_index.offsets[middle];
+      return LINE_NUMBER_FOUND;
+    }
+    if (current_line_number < line) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  /* Only lines past the end of the index are left to look at. */
+  if ((basic_line_index.remainder == 0) || (low < basic_line_index.count)) {
+    return LINE_NUMBER_NOT_FOUND;
+  }
+
+  return scan_line_number(line, basic_line_index.remainder, result);
+}
+
+bool scan_line_number(const uint16_t line, size_t index, uint16_t *result) {
   uint8_t token_length;
   uint16_t current_line_number;
 
@@ -395,6 +746,9 @@ uint16_t handle_special_token(const uint8_t token) {
   case TOK_SEND:
     return enabled_protocols[bus_pirate_configuration.bus_mode].send(assign());
 
+  case TOK_BUF:
+    return read_buffer_entry(get_number_or_variable());
+
   case TOK_AUX:
     return bp_aux_pin_read();
 
@@ -423,6 +777,36 @@ uint16_t handle_special_token(const uint8_t token) {
   }
 }
 
+int16_t read_buffer_entry(const int16_t index) {
+  if ((index < 0) || (index >= BP_BASIC_BUFFER_SIZE)) {
+    return 0;
+  }
+  return basic_buffer[index];
+}
+
+bool bulk_transfer_follows(void) {
+  return (basic_program_area[basic_program_counter] == TOK_BUF) &&
+         (basic_program_area[basic_program_counter + 1] == ',');
+}
+
+bool bulk_transfer(const uint8_t token) {
+  int16_t length;
+
+  basic_program_counter += 2;
+  length = assign();
+  if ((length < 0) || (length > BP_BASIC_BUFFER_SIZE)) {
+    return false;
+  }
+
+  if (token == TOK_SEND) {
+    bp_protocol_send_buffer(basic_buffer, length);
+  } else {
+    bp_protocol_read_buffer(basic_buffer, length);
+  }
+
+  return true;
+}
+
 int16_t get_number_or_variable(void) {
   int16_t temp = 0;
 
@@ -475,12 +859,26 @@ int16_t get_multiplication_division_bitwise_ops(void) {
       break;
 
     default:
+      /* Leave the terminator to the caller. */
+      basic_program_counter--;
       return temp;
     }
   }
 }
 
 int16_t assign(void) {
+  const basic_compiled_expression_t *expression;
+
+  expression = find_compiled_expression(basic_program_counter);
+  if ((expression == NULL) || (expression->code == EXPRESSION_NOT_COMPILED)) {
+    return parse_expression();
+  }
+
+  basic_program_counter = expression->end;
+  return run_expression(&basic_expression_cache.code[expression->code]);
+}
+
+int16_t parse_expression(void) {
   int16_t temp = get_multiplication_division_bitwise_ops();
 
   for (;;) {
@@ -494,21 +892,21 @@ int16_t assign(void) {
       break;
 
     case '>':
-      if (basic_program_area[basic_program_counter + 1] == '=') {
-        temp = (temp >= get_multiplication_division_bitwise_ops());
+      if (basic_program_area[basic_program_counter] == '=') {
         basic_program_counter++;
+        temp = (temp >= get_multiplication_division_bitwise_ops());
       } else {
         temp = (temp > get_multiplication_division_bitwise_ops());
       }
       break;
 
     case '<':
-      if (basic_program_area[basic_program_counter + 1] == '>') {
+      if (basic_program_area[basic_program_counter] == '>') {
+        basic_program_counter++;
         temp = (temp != get_multiplication_division_bitwise_ops());
+      } else if (basic_program_area[basic_program_counter] == '=') {
         basic_program_counter++;
-      } else if (basic_program_area[basic_program_counter + 1] == '=') {
         temp = (temp <= get_multiplication_division_bitwise_ops());
-        basic_program_counter++;
       } else {
         temp = (temp < get_multiplication_division_bitwise_ops());
       }
@@ -519,11 +917,314 @@ int16_t assign(void) {
       break;
 
     default:
+      /* Leave the terminator to the caller. */
+      basic_program_counter--;
       return temp;
     }
   }
 }
 
+void reset_expression_cache(void) {
+  size_t index;
+
+  for (index = 0; index < BP_BASIC_EXPRESSION_CACHE_SIZE; index++) {
+    basic_expression_cache.expressions[index].source = EXPRESSION_SLOT_FREE;
+  }
+  basic_expression_cache.code_used = 0;
+}
+
+const basic_compiled_expression_t *
+find_compiled_expression(const uint16_t source) {
+  basic_compiled_expression_t *expression;
+  uint16_t slot;
+  uint16_t probes;
+  uint16_t code_start;
+
+  slot = (source ^ (source >> 5)) & (BP_BASIC_EXPRESSION_CACHE_SIZE - 1);
+  for (probes = 0; probes < BP_BASIC_EXPRESSION_CACHE_SIZE; probes++) {
+    expression = &basic_expression_cache.expressions[slot];
+    if (expression->source == source) {
+      return expression;
+    }
+    if (expression->source == EXPRESSION_SLOT_FREE) {
+      break;
+    }
+    slot = (slot + 1) & (BP_BASIC_EXPRESSION_CACHE_SIZE - 1);
+  }
+
+  if (probes == BP_BASIC_EXPRESSION_CACHE_SIZE) {
+    return NULL;
+  }
+
+  /* First time this one is seen, compile it. */
+  code_start = basic_expression_cache.code_used;
+  basic_compiler.source = source;
+  basic_compiler.depth = 0;
+  basic_compiler.fits = true;
+  compile_expression();
+  emit_bytecode(OPCODE_END);
+
+  expression->source = source;
+  expression->end = basic_compiler.source;
+  if (basic_compiler.fits) {
+    expression->code = code_start;
+  } else {
+    /* Keep the slot so the compiler is not tried again on this one. */
+    expression->code = EXPRESSION_NOT_COMPILED;
+    basic_expression_cache.code_used = code_start;
+  }
+
+  return expression;
+}
+
+void emit_bytecode(const uint8_t value) {
+  if (basic_expression_cache.code_used >= BP_BASIC_BYTECODE_SPACE) {
+    basic_compiler.fits = false;
+    return;
+  }
+  basic_expression_cache.code[basic_expression_cache.code_used++] = value;
+}
+
+void compile_operand(void) {
+  uint8_t token;
+  int16_t value;
+
+  token = basic_program_area[basic_compiler.source];
+
+  if (token == '(') {
+    basic_compiler.source++;
+    compile_expression();
+    if (basic_program_area[basic_compiler.source] == ')') {
+      basic_compiler.source++;
+    }
+    return;
+  }
+
+  if (basic_compiler.depth == BP_BASIC_EXPRESSION_STACK_DEPTH) {
+    basic_compiler.fits = false;
+    return;
+  }
+
+  if ((token >= 'A') && (token <= 'Z')) {
+    basic_compiler.source++;
+    emit_bytecode(OPCODE_VARIABLE);
+    emit_bytecode(token - 'A');
+    basic_compiler.depth++;
+    return;
+  }
+
+  if (token > TOKENS) {
+    basic_compiler.source++;
+    if (token == TOK_SEND) {
+      /* The value to send is an expression of its own. */
+      compile_expression();
+      emit_bytecode(OPCODE_SEND);
+      return;
+    }
+    if (token == TOK_BUF) {
+      compile_operand();
+      emit_bytecode(OPCODE_BUFFER);
+      return;
+    }
+    emit_bytecode(OPCODE_TOKEN);
+    emit_bytecode(token);
+    basic_compiler.depth++;
+    return;
+  }
+
+  value = 0;
+  while ((basic_program_area[basic_compiler.source] >= '0') &&
+         (basic_program_area[basic_compiler.source] <= '9')) {
+    value *= 10;
+    value += basic_program_area[basic_compiler.source] - '0';
+    basic_compiler.source++;
+  }
+  emit_bytecode(OPCODE_CONSTANT);
+  emit_bytecode((uint16_t)value >> 8);
+  emit_bytecode(value & 0xFF);
+  basic_compiler.depth++;
+}
+
+void compile_term(void) {
+  basic_opcode_t opcode;
+
+  compile_operand();
+
+  for (;;) {
+    switch (basic_program_area[basic_compiler.source]) {
+    case '*':
+      opcode = OPCODE_MULTIPLY;
+      break;
+
+    case '/':
+      opcode = OPCODE_DIVIDE;
+      break;
+
+    case '&':
+      opcode = OPCODE_AND;
+      break;
+
+    case '|':
+      opcode = OPCODE_OR;
+      break;
+
+    default:
+      return;
+    }
+
+    basic_compiler.source++;
+    compile_operand();
+    emit_bytecode(opcode);
+    basic_compiler.depth--;
+  }
+}
+
+void compile_expression(void) {
+  basic_opcode_t opcode;
+
+  compile_term();
+
+  for (;;) {
+    switch (basic_program_area[basic_compiler.source]) {
+    case '-':
+      opcode = OPCODE_SUBTRACT;
+      break;
+
+    case '+':
+      opcode = OPCODE_ADD;
+      break;
+
+    case '>':
+      if (basic_program_area[basic_compiler.source + 1] == '=') {
+        basic_compiler.source++;
+        opcode = OPCODE_GREATER_OR_EQUAL;
+      } else {
+        opcode = OPCODE_GREATER;
+      }
+      break;
+
+    case '<':
+      if (basic_program_area[basic_compiler.source + 1] == '>') {
+        basic_compiler.source++;
+        opcode = OPCODE_NOT_EQUAL;
+      } else if (basic_program_area[basic_compiler.source + 1] == '=') {
+        basic_compiler.source++;
+        opcode = OPCODE_LESS_OR_EQUAL;
+      } else {
+        opcode = OPCODE_LESS;
+      }
+      break;
+
+    case '=':
+      opcode = OPCODE_EQUAL;
+      break;
+
+    default:
+      return;
+    }
+
+    basic_compiler.source++;
+    compile_term();
+    emit_bytecode(opcode);
+    basic_compiler.depth--;
+  }
+}
+
+int16_t run_expression(const uint8_t *code) {
+  int16_t stack[BP_BASIC_EXPRESSION_STACK_DEPTH];
+  int16_t *top = stack;
+
+  for (;;) {
+    switch (*code++) {
+    case OPCODE_CONSTANT:
+      *top++ = (int16_t)((code[0] << 8) | code[1]);
+      code += 2;
+      break;
+
+    case OPCODE_VARIABLE:
+      *top++ = basic_variables[*code++];
+      break;
+
+    case OPCODE_TOKEN:
+      *top++ = handle_special_token(*code++);
+      break;
+
+    case OPCODE_SEND:
+      top[-1] =
+          enabled_protocols[bus_pirate_configuration.bus_mode].send(top[-1]);
+      break;
+
+    case OPCODE_BUFFER:
+      top[-1] = read_buffer_entry(top[-1]);
+      break;
+
+    case OPCODE_MULTIPLY:
+      top--;
+      top[-1] *= top[0];
+      break;
+
+    case OPCODE_DIVIDE:
+      top--;
+      top[-1] /= top[0];
+      break;
+
+    case OPCODE_AND:
+      top--;
+      top[-1] &= top[0];
+      break;
+
+    case OPCODE_OR:
+      top--;
+      top[-1] |= top[0];
+      break;
+
+    case OPCODE_SUBTRACT:
+      top--;
+      top[-1] -= top[0];
+      break;
+
+    case OPCODE_ADD:
+      top--;
+      top[-1] += top[0];
+      break;
+
+    case OPCODE_GREATER:
+      top--;
+      top[-1] = (top[-1] > top[0]);
+      break;
+
+    case OPCODE_GREATER_OR_EQUAL:
+      top--;
+      top[-1] = (top[-1] >= top[0]);
+      break;
+
+    case OPCODE_LESS:
+      top--;
+      top[-1] = (top[-1] < top[0]);
+      break;
+
+    case OPCODE_LESS_OR_EQUAL:
+      top--;
+      top[-1] = (top[-1] <= top[0]);
+      break;
+
+    case OPCODE_NOT_EQUAL:
+      top--;
+      top[-1] = (top[-1] != top[0]);
+      break;
+
+    case OPCODE_EQUAL:
+      top--;
+      top[-1] = (top[-1] == top[0]);
+      break;
+
+    case OPCODE_END:
+    default:
+      return top[-1];
+    }
+  }
+}
+
 void interpreter(void) {
   bool program_counter_updated = NO;
   basic_status_code_t status = STATUS_CODE_UNKNOWN;
@@ -543,6 +1244,9 @@ void interpreter(void) {
 
   memset((void *)&basic_variables, 0, sizeof(basic_variables));
 
+  /* The program may have been edited since the last run. */
+  reset_expression_cache();
+
   while (status == STATUS_CODE_UNKNOWN) {
     if (!ifstat) {
       if (basic_program_area[basic_program_counter] < TOK_LEN) {
@@ -831,10 +1535,49 @@ void interpreter(void) {
     case TOK_SEND:
       program_counter_updated = YES;
       basic_program_counter += 4;
-      enabled_protocols[bus_pirate_configuration.bus_mode].send((int)assign());
+      if (bulk_transfer_follows()) {
+        if (!bulk_transfer(TOK_SEND)) {
+          status = STATUS_CODE_BUFFER_ERROR;
+        }
+      } else {
+        enabled_protocols[bus_pirate_configuration.bus_mode].send(
+            (int)assign());
+      }
       handle_else_statement();
       break;
 
+    case TOK_RECEIVE:
+      program_counter_updated = YES;
+      basic_program_counter += 4;
+      if (!bulk_transfer_follows()) {
+        status = STATUS_CODE_SYNTAX_ERROR;
+      } else if (!bulk_transfer(TOK_RECEIVE)) {
+        status = STATUS_CODE_BUFFER_ERROR;
+      }
+      handle_else_statement();
+      break;
+
+    case TOK_BUF: {
+      int16_t index;
+
+      program_counter_updated = YES;
+      basic_program_counter += 4;
+      index = get_number_or_variable();
+      if (basic_program_area[basic_program_counter] != '=') {
+        status = STATUS_CODE_SYNTAX_ERROR;
+        break;
+      }
+      basic_program_counter++;
+      temp = assign();
+      if ((index < 0) || (index >= BP_BASIC_BUFFER_SIZE)) {
+        status = STATUS_CODE_BUFFER_ERROR;
+        break;
+      }
+      basic_buffer[index] = temp;
+      handle_else_statement();
+      break;
+    }
+
     case TOK_AUX:
       program_counter_updated = YES;
       basic_program_counter += 4;
@@ -1022,7 +1765,7 @@ void list(void) {
   BPMSG1050;
 }
 
-bool compare(char *pointer) {
+bool compare(const char *pointer) {
   int oldstart = cmdstart;
 
   while (*pointer) {
@@ -1082,6 +1825,9 @@ void bp_basic_enter_interactive_interpreter(void) {
     line[1] = temp >> 8;
     line[2] = temp & 0xFF;
 
+    /* Offsets move both when deleting and inserting. */
+    invalidate_line_index();
+
     if (search_line_number(temp, &pos)) {
       len = (basic_program_area[pos] - TOK_LEN) + 3;
       /* @TODO: replace this with a memmove. */
@@ -1153,7 +1899,7 @@ void bp_basic_enter_interactive_interpreter(void) {
     for (i = end; i >= pos; i--) {
       basic_program_area[i + temp] = basic_program_area[i];
     }
-    memcpy(&basic_program_area[pos + i], &line[i], temp);
+    memcpy(&basic_program_area[pos], line, temp);
   } else {
     if (compare("RUN")) {
       interpreter();
@@ -1162,6 +1908,12 @@ void bp_basic_enter_interactive_interpreter(void) {
       list();
     } else if (compare("EXIT")) {
       bus_pirate_configuration.basic = NO;
+    } else if (compare("UPLOAD")) {
+      consumewhitechars();
+      if (upload() && compare("RUN")) {
+        interpreter();
+        bpBR;
+      }
     }
 #ifdef BP_BASIC_I2C_FILESYSTEM
     else if (compare("FORMAT")) {
@@ -1192,184 +1944,134 @@ void bp_basic_enter_interactive_interpreter(void) {
   }
 }
 
-void bp_basic_initialize(void) {
-  basic_program_area[0] = TOK_LEN + 1;
-  basic_program_area[1] = 0xFF;
-  basic_program_area[2] = 0xFF;
-  basic_program_area[3] = TOK_END;
-  memset(&basic_program_area[4], 0x00, BP_BASIC_PROGRAM_SPACE - 4);
-}
-
-#ifdef BP_BASIC_I2C_FILESYSTEM
-
-// i2c eeprom interaction
-// need to incorperate it in bitbang or r2wire!
-// CvD: I stole most off it from bitbang.c/h
-
-#define BASSDA 1
-#define BASSCL 2
-#define BASI2CCLK 100
+bool upload_image_is_valid(const uint8_t *image, const uint16_t length) {
+  uint16_t offset;
+  uint16_t line;
+  uint16_t previous;
+  bool first;
 
-#define EEP24LC256
+  offset = 0;
+  line = 0;
+  previous = 0;
+  first = YES;
 
-#ifdef EEP24LC256
-
-#define I2CADDR 0xA0
-#define EEPROMSIZE 0x8000
-#define EEPROMPAGE 64
-
-#endif
-
-// globals
-int eeprom_lastprog;
-unsigned int eeprom_lastmem;
+  while (offset < length) {
+    if ((image[offset] <= TOK_LEN) || ((length - offset) < 3)) {
+      return NO;
+    }
 
-void HIZbbL(unsigned int pins, int delay) {
-  IOLAT &= (~pins);   // pins to 0
-  IODIR &= (~pins);   // direction to output
-  bp_delay_us(delay); // delay
-}
-void HIZbbH(unsigned int pins, int delay) {
-  IODIR |= pins;      // open collector output high
-  bp_delay_us(delay); // delay
-}
-unsigned char HIZbbR(unsigned int pin) {
-  IODIR |= pin; // pin as input
-  Nop();
-  Nop();
-  Nop();
-  if (IOPOR & pin)
-    return 1;
-  else
-    return 0; // clear all but pin bit and return result
-}
+    line = (image[offset + 1] << 8) | image[offset + 2];
+    if (!first && (line <= previous)) {
+      return NO;
+    }
 
-void basi2cstart(void) {
-  HIZbbH((BASSDA | BASSCL), BASI2CCLK); // both hi
-  HIZbbL(BASSDA, BASI2CCLK);            // data down
-  HIZbbL(BASSCL, BASI2CCLK);            // clk down
-  HIZbbH(BASSDA, BASI2CCLK);            // data up
-}
+    first = NO;
+    previous = line;
+    offset += (image[offset] - TOK_LEN) + 3;
+  }
 
-void basi2cstop(void) {
-  HIZbbL((BASSDA | BASSCL), BASI2CCLK);
-  HIZbbH(BASSCL, BASI2CCLK);
-  HIZbbH(BASSDA, BASI2CCLK);
+  /* Lines must not run past the end, and the last one is the END marker. */
+  return (offset == length) && !first && (line == 0xFFFF);
 }
 
-unsigned char basi2cread(int ack) {
-  int i;
-  unsigned char c;
-
-  c = 0;
-  HIZbbR(BASSDA);
+bool upload(void) {
+  uint8_t *image;
+  uint16_t length;
+  uint16_t checksum;
+  uint16_t crc;
+  uint16_t offset;
+  uint8_t bit;
+
+  REPORT_IO_SUCCESS();
+
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+  checksum = user_serial_read_byte() << 8;
+  checksum |= user_serial_read_byte();
+
+  /* The interpreter relies on a zero past the last line. */
+  image = (length < BP_BASIC_PROGRAM_SPACE) ? bp_buffer_arena_reserve(length)
+                                            : NULL;
+  if ((length == 0) || (image == NULL)) {
+    bp_buffer_arena_release(image);
+    REPORT_IO_FAILURE();
+    return NO;
+  }
 
-  for (i = 0; i < 8; i++) {
-    HIZbbL(BASSCL, BASI2CCLK / 5);
-    HIZbbH(BASSCL, BASI2CCLK);
-    c <<= 1;
-    c |= HIZbbR(BASSDA);
+  REPORT_IO_SUCCESS();
 
-    HIZbbL(BASSCL, BASI2CCLK);
+  crc = 0xFFFF;
+  for (offset = 0; offset < length; offset++) {
+    image[offset] = user_serial_read_byte();
+    crc ^= image[offset] << 8;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
   }
 
-  if (ack) {
-    HIZbbL(BASSDA, BASI2CCLK / 5);
+  if ((crc != checksum) || !upload_image_is_valid(image, length)) {
+    bp_buffer_arena_release(image);
+    REPORT_IO_FAILURE();
+    return NO;
   }
-  HIZbbH(BASSCL, BASI2CCLK);
-  HIZbbL(BASSCL, BASI2CCLK);
 
-  return c;
-}
+  invalidate_line_index();
+  memcpy(basic_program_area, image, length);
+  memset(&basic_program_area[length], 0x00, BP_BASIC_PROGRAM_SPACE - length);
+  bp_buffer_arena_release(image);
 
-int basi2cwrite(unsigned char c) {
-  int i;
-  unsigned char mask;
+  REPORT_IO_SUCCESS();
+  return YES;
+}
 
-  mask = 0x80;
+void bp_basic_initialize(void) {
+  invalidate_line_index();
+  basic_program_area[0] = TOK_LEN + 1;
+  basic_program_area[1] = 0xFF;
+  basic_program_area[2] = 0xFF;
+  basic_program_area[3] = TOK_END;
+  memset(&basic_program_area[4], 0x00, BP_BASIC_PROGRAM_SPACE - 4);
+}
 
-  for (i = 0; i < 8; i++) {
-    if (c & mask) {
-      HIZbbH(BASSDA, BASI2CCLK / 5);
-      // bpWstring("W1");
-    } else {
-      HIZbbL(BASSDA, BASI2CCLK / 5);
-      // bpWstring("W0");
-    }
-    HIZbbH(BASSCL, BASI2CCLK);
-    HIZbbL(BASSCL, BASI2CCLK);
-    mask >>= 1;
-  }
+#ifdef BP_BASIC_I2C_FILESYSTEM
 
-  HIZbbH(BASSCL, BASI2CCLK);
-  i = HIZbbR(BASSDA);
-  HIZbbL(BASSCL, BASI2CCLK);
+/**
+ * How many programs fit in the on-board EEPROM.
+ */
+#define BASIC_EEPROM_SLOTS (EEPROM_SIZE / BP_BASIC_PROGRAM_SPACE)
 
-  return (i ^ 0x01);
-}
+#if (BP_BASIC_PROGRAM_SPACE % EEPROM_PAGE_SIZE) != 0
+#error "BP_BASIC_PROGRAM_SPACE must be a multiple of the EEPROM page size"
+#endif /* (BP_BASIC_PROGRAM_SPACE % EEPROM_PAGE_SIZE) != 0 */
 
-int checkeeprom(void) { // just to be sure
-  basi2cstop();
-  basi2cstop();
-  basi2cstart();
-  if (!basi2cwrite(I2CADDR)) { // bpWline("No EEPROM");
-    BPMSG1053;
-    return 0;
-  }
-  basi2cwrite(0x00);
-  basi2cwrite(0x00);
-  basi2cstart();
-  if (basi2cread(1) == 0x00) // check for any data
-  {
-    bp_write_line("No EEPROM"); // if 0 prolly no pullup and eeprom (PROLLY!)
-    BPMSG1053;
-    return 0;
-  }
-  basi2cstop();
-  return 1;
-}
+#if BASIC_EEPROM_SLOTS == 0
+#error "BP_BASIC_PROGRAM_SPACE does not fit in the on-board EEPROM"
+#endif /* BASIC_EEPROM_SLOTS == 0 */
 
 void format(void) {
-  int i, j;
+  uint8_t page[EEPROM_PAGE_SIZE];
+  uint16_t address;
 
-  basi2cstop();
-  basi2cstart();
-  if (!basi2cwrite(I2CADDR)) { // bpWline("No EEPROM");
-    BPMSG1053;
-    return;
-  }
-  basi2cstop();
+  memset(page, 0xFF, sizeof(page));
 
   // bpWstring("Erasing");
   BPMSG1054;
-  for (i = 0; i < EEPROMSIZE; i += EEPROMPAGE) {
-    basi2cstart();
-    basi2cwrite(I2CADDR);
-    basi2cwrite((i >> 8));
-    basi2cwrite((i & 0x0FF));
-    for (j = 0; j < EEPROMPAGE; j++) {
-      basi2cwrite(0xFF);
+  for (address = 0; address < EEPROM_SIZE; address += EEPROM_PAGE_SIZE) {
+    if (!eeprom_write_page(address, page, sizeof(page))) {
+      bpBR;
+      // bpWline("No EEPROM");
+      BPMSG1053;
+      return;
+    }
+    if ((address % BP_BASIC_PROGRAM_SPACE) == 0) {
+      user_serial_transmit_character('.');
     }
-    basi2cstop();
-    user_serial_transmit_character('.');
-    waiteeprom();
   }
   // bpWline("done");
   BPMSG1055;
 }
 
-void waiteeprom(void) {
-  int wait;
-  wait = 1;
-  while (wait) {
-    basi2cstart();
-    wait = basi2cwrite(I2CADDR);
-    basi2cstop();
-  }
-}
-
-void save(void) {
-  int i, j;
+int16_t get_slot_address(void) {
   int slot;
 
   consumewhitechars();
@@ -1377,89 +2079,60 @@ void save(void) {
 
   if (slot == 0) { // bpWline("Syntax error");
     BPMSG1052;
-    return;
+    return -1;
   }
 
-  // bpWstring("Saving to slot ");
-  BPMSG1056;
   bp_write_dec_byte(slot);
   bpBR;
 
-  if (slot > (EEPROMSIZE / PGMSIZE)) { // bpWline("Invalid slot");
+  if (slot > BASIC_EEPROM_SLOTS) { // bpWline("Invalid slot");
     BPMSG1057;
-    return;
+    return -1;
   }
 
-  if (!checkeeprom()) {
+  return (slot - 1) * BP_BASIC_PROGRAM_SPACE;
+}
+
+void save(void) {
+  int16_t address;
+  uint16_t offset;
+
+  // bpWstring("Saving to slot ");
+  BPMSG1056;
+  address = get_slot_address();
+  if (address < 0) {
     return;
   }
 
-  slot *= PGMSIZE;
-
-  basi2cstop();
-  basi2cwrite(I2CADDR);
-  basi2cwrite(slot >> 8);
-  basi2cwrite(slot & 0x0FF);
-  basi2cstart();
-  basi2cwrite(I2CADDR + 1);
-
-  slot *= EEPROMPAGE;
-
-  for (i = 0; i < PGMSIZE;
-       i += EEPROMPAGE) // we assume that pgmsize is dividable by eeprompage
-  {
-    basi2cstart();
-    basi2cwrite(I2CADDR);
-    basi2cwrite((slot + i) >> 8);
-    basi2cwrite((slot + i) & 0x0FF);
-    for (j = 0; j < EEPROMPAGE; j++) {
-      basi2cwrite(basic_program_area[i + j]);
+  for (offset = 0; offset < BP_BASIC_PROGRAM_SPACE;
+       offset += EEPROM_PAGE_SIZE) {
+    if (!eeprom_write_page(address + offset, &basic_program_area[offset],
+                           EEPROM_PAGE_SIZE)) {
+      bpBR;
+      // bpWline("No EEPROM");
+      BPMSG1053;
+      return;
     }
-    basi2cstop();
     user_serial_transmit_character('.');
-    waiteeprom();
   }
+  bpBR;
 }
 
 void load(void) {
-  int i;
-  int slot;
-
-  consumewhitechars();
-  slot = getint();
-
-  if (slot == 0) { // bpWline("Syntax error");
-    BPMSG1052;
-    return;
-  }
+  int16_t address;
 
   // bpWstring("Loading from slot ");
   BPMSG1058;
-  bp_write_dec_byte(slot);
-  bpBR;
-
-  if (slot > (EEPROMSIZE / PGMSIZE)) { // bpWline("Invalid slot");
-    BPMSG1057;
+  address = get_slot_address();
+  if (address < 0) {
     return;
   }
 
-  if (!checkeeprom()) {
-    return;
-  }
-
-  slot *= PGMSIZE;
-
-  basi2cstop();
-  basi2cwrite(I2CADDR);
-  basi2cwrite(slot >> 8);
-  basi2cwrite(slot & 0x0FF);
-  basi2cstart();
-  basi2cwrite(I2CADDR + 1);
-
-  for (i = 0; i < PGMSIZE; i++) {
-    if (!(i % EEPROMPAGE))
-      user_serial_transmit_character('.'); // pure estetic
-    basic_program_area[i] = basi2cread(1);
+  invalidate_line_index();
+  if (!eeprom_read_block(address, basic_program_area,
+                         BP_BASIC_PROGRAM_SPACE)) {
+    // bpWline("No EEPROM");
+    BPMSG1053;
   }
 }
 
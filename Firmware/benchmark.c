@@ -0,0 +1,321 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "benchmark.h"
+
+#ifdef BP_ENABLE_BENCHMARK
+
+#include "base.h"
+#include "bitbang.h"
+#include "buffer_arena.h"
+
+#ifdef BP_ENABLE_SPI_SUPPORT
+#include "spi.h"
+#endif /* BP_ENABLE_SPI_SUPPORT */
+
+#ifdef BP_ENABLE_1WIRE_SUPPORT
+#include "1wire.h"
+#endif /* BP_ENABLE_1WIRE_SUPPORT */
+
+/**
+ * Timer ticks per microsecond, the timer runs at FCY.
+ */
+#define BENCHMARK_TICKS_PER_US (FCY / 1000000UL)
+
+/**
+ * SPI1CON1 SPRE and PPRE bits the SPI engines run at, 8MHz - Primary
+ * prescaler 1:1 / Secondary prescaler 2:1, the fastest spi_bus_speed entry.
+ */
+#define BENCHMARK_SPI_PRESCALERS 0b00011011
+
+extern mode_configuration_t mode_configuration;
+
+/**
+ * What every engine got.
+ */
+typedef struct {
+  /** Bytes moved per second, 0 if the engine was not run. */
+  uint32_t bytes_per_second;
+
+  /** Bytes read back differently from how they were sent. */
+  uint16_t mismatches;
+} benchmark_result_t;
+
+/**
+ * The pattern every engine sends.
+ *
+ * @param[in] index the byte offset in the run.
+ *
+ * @return the byte to send at that offset.
+ */
+static inline uint8_t benchmark_pattern(const uint16_t index) {
+  return LO8(index) ^ 0x5A;
+}
+
+/**
+ * Clears and starts Timer #4/#5 as a single 32 bits timer.
+ */
+static void benchmark_timer_start(void);
+
+/**
+ * Stops Timer #4/#5 and tells how long it ran.
+ *
+ * @return the timer value, in ticks.
+ */
+static uint32_t benchmark_timer_stop(void);
+
+/**
+ * Turns a run duration into a throughput figure.
+ *
+ * @param[in] ticks how long BP_BENCHMARK_BYTES bytes took, in timer ticks.
+ *
+ * @return the bytes moved per second.
+ */
+static uint32_t benchmark_bytes_per_second(const uint32_t ticks);
+
+/**
+ * Counts the bytes of a buffer not matching the pattern.
+ *
+ * @param[in] buffer the bytes read back, BP_BENCHMARK_BYTES of them.
+ *
+ * @return how many bytes differ from benchmark_pattern().
+ */
+static uint16_t benchmark_count_mismatches(const uint8_t *buffer);
+
+/**
+ * Sends a 16 bits value on the binary I/O channel, MSB first.
+ *
+ * @param[in] value the value to send.
+ */
+static void benchmark_send_word(const uint16_t value);
+
+#ifdef BP_ENABLE_SPI_SUPPORT
+
+/**
+ * Times the SPI1 engines, one byte at a time and through the FIFOs.
+ *
+ * @param[out] results the BP_BENCHMARK_ENGINES_COUNT engine results.
+ * @param[in,out] buffer BP_BENCHMARK_BYTES bytes of scratch space.
+ */
+static void benchmark_spi(benchmark_result_t *results, uint8_t *buffer);
+
+#endif /* BP_ENABLE_SPI_SUPPORT */
+
+/**
+ * Times the bit-banged 3-wire and 2-wire engines at their maximum speed.
+ *
+ * @param[out] results the BP_BENCHMARK_ENGINES_COUNT engine results.
+ */
+static void benchmark_bitbang(benchmark_result_t *results);
+
+#ifdef BP_ENABLE_1WIRE_SUPPORT
+
+/**
+ * Times the 1-Wire write slots.
+ *
+ * @param[out] results the BP_BENCHMARK_ENGINES_COUNT engine results.
+ * @param[in,out] buffer BP_BENCHMARK_BYTES bytes of scratch space.
+ */
+static void benchmark_1wire(benchmark_result_t *results, uint8_t *buffer);
+
+#endif /* BP_ENABLE_1WIRE_SUPPORT */
+
+void benchmark_timer_start(void) {
+
+  /*
+   * T4CON: TIMER4 CONTROL REGISTER
+   *
+   * MSB
+   * 1-0------0001-0-
+   * | |      |||| |
+   * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+   * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
+   * | |      |++------ TCKPS: Input prescaler 1:1 (one tick per cycle).
+   * | |      +-------- TGATE: Gated time accumulation is disabled.
+   * | +--------------- TSIDL  Continues module operation in Idle mode.
+   * +----------------- TON:   Starts 32-bit Timerx.
+   */
+  T4CON = 0;
+  TMR5HLD = 0;
+  TMR4 = 0;
+  PR5 = 0xFFFF;
+  PR4 = 0xFFFF;
+  T4CON = (ON << _T4CON_TON_POSITION) | (ON << _T4CON_T32_POSITION);
+}
+
+uint32_t benchmark_timer_stop(void) {
+  uint16_t low;
+
+  /* Reading TMR4 latches the upper half into TMR5HLD. */
+  low = TMR4;
+  T4CON = 0;
+  return ((uint32_t)TMR5HLD << 16) | low;
+}
+
+uint32_t benchmark_bytes_per_second(const uint32_t ticks) {
+  uint32_t microseconds;
+
+  /* BP_BENCHMARK_BYTES is small enough for this not to overflow. */
+  microseconds = ticks / BENCHMARK_TICKS_PER_US;
+  return (microseconds > 0)
+             ? (BP_BENCHMARK_BYTES * 1000000UL) / microseconds
+             : 0;
+}
+
+uint16_t benchmark_count_mismatches(const uint8_t *buffer) {
+  uint16_t index;
+  uint16_t mismatches;
+
+  mismatches = 0;
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    if (buffer[index] != benchmark_pattern(index)) {
+      mismatches++;
+    }
+  }
+
+  return mismatches;
+}
+
+void benchmark_send_word(const uint16_t value) {
+  user_serial_transmit_character(HI8(value));
+  user_serial_transmit_character(LO8(value));
+}
+
+#ifdef BP_ENABLE_SPI_SUPPORT
+
+void benchmark_spi(benchmark_result_t *results, uint8_t *buffer) {
+  uint16_t index;
+  uint32_t ticks;
+
+  mode_configuration.high_impedance = OFF;
+  spi_setup(BENCHMARK_SPI_PRESCALERS);
+
+  benchmark_timer_start();
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    buffer[index] = spi_write_byte(benchmark_pattern(index));
+  }
+  ticks = benchmark_timer_stop();
+  results[BP_BENCHMARK_ENGINE_SPI].bytes_per_second =
+      benchmark_bytes_per_second(ticks);
+  results[BP_BENCHMARK_ENGINE_SPI].mismatches =
+      benchmark_count_mismatches(buffer);
+
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    buffer[index] = benchmark_pattern(index);
+  }
+  benchmark_timer_start();
+  spi_transfer_buffer(buffer, buffer, BP_BENCHMARK_BYTES);
+  ticks = benchmark_timer_stop();
+  results[BP_BENCHMARK_ENGINE_SPI_FIFO].bytes_per_second =
+      benchmark_bytes_per_second(ticks);
+  results[BP_BENCHMARK_ENGINE_SPI_FIFO].mismatches =
+      benchmark_count_mismatches(buffer);
+
+  spi_disable_interface();
+}
+
+#endif /* BP_ENABLE_SPI_SUPPORT */
+
+void benchmark_bitbang(benchmark_result_t *results) {
+  uint16_t index;
+  uint16_t mismatches;
+  uint32_t ticks;
+
+  mode_configuration.high_impedance = OFF;
+  mode_configuration.numbits = 8;
+
+  /* The pattern is worked out on the fly, inside the timed loop. */
+  BP_MOSI_DIR = OUTPUT;
+  BP_CLK_DIR = OUTPUT;
+  BP_MISO_DIR = INPUT;
+  bitbang_setup(3, BITBANG_SPEED_MAXIMUM);
+  mismatches = 0;
+  benchmark_timer_start();
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    if (bitbang_read_with_write(benchmark_pattern(index)) !=
+        benchmark_pattern(index)) {
+      mismatches++;
+    }
+  }
+  ticks = benchmark_timer_stop();
+  results[BP_BENCHMARK_ENGINE_BITBANG_3WIRE].bytes_per_second =
+      benchmark_bytes_per_second(ticks);
+  results[BP_BENCHMARK_ENGINE_BITBANG_3WIRE].mismatches = mismatches;
+
+  bitbang_setup(2, BITBANG_SPEED_MAXIMUM);
+  benchmark_timer_start();
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    bitbang_write_value(benchmark_pattern(index));
+  }
+  ticks = benchmark_timer_stop();
+  results[BP_BENCHMARK_ENGINE_BITBANG_2WIRE].bytes_per_second =
+      benchmark_bytes_per_second(ticks);
+}
+
+#ifdef BP_ENABLE_1WIRE_SUPPORT
+
+void benchmark_1wire(benchmark_result_t *results, uint8_t *buffer) {
+  uint16_t index;
+  uint32_t ticks;
+
+  for (index = 0; index < BP_BENCHMARK_BYTES; index++) {
+    buffer[index] = benchmark_pattern(index);
+  }
+
+  mode_configuration.high_impedance = ON;
+  onewire_setup_execute();
+  benchmark_timer_start();
+  onewire_send_buffer(buffer, BP_BENCHMARK_BYTES);
+  ticks = benchmark_timer_stop();
+  results[BP_BENCHMARK_ENGINE_1WIRE].bytes_per_second =
+      benchmark_bytes_per_second(ticks);
+}
+
+#endif /* BP_ENABLE_1WIRE_SUPPORT */
+
+void bp_benchmark_send(void) {
+  benchmark_result_t results[BP_BENCHMARK_ENGINES_COUNT] = {{0}};
+  mode_configuration_t saved_configuration;
+  uint8_t *buffer;
+  size_t index;
+
+  saved_configuration = mode_configuration;
+  buffer = bp_buffer_arena_reserve(BP_BENCHMARK_BYTES);
+
+  if (buffer != NULL) {
+#ifdef BP_ENABLE_SPI_SUPPORT
+    benchmark_spi(results, buffer);
+#endif /* BP_ENABLE_SPI_SUPPORT */
+#ifdef BP_ENABLE_1WIRE_SUPPORT
+    benchmark_1wire(results, buffer);
+#endif /* BP_ENABLE_1WIRE_SUPPORT */
+    bp_buffer_arena_release(buffer);
+  }
+  benchmark_bitbang(results);
+
+  mode_configuration = saved_configuration;
+
+  user_serial_transmit_character(BP_BENCHMARK_ENGINES_COUNT);
+  benchmark_send_word(BP_BENCHMARK_BYTES);
+  for (index = 0; index < BP_BENCHMARK_ENGINES_COUNT; index++) {
+    benchmark_send_word(results[index].bytes_per_second >> 16);
+    benchmark_send_word(results[index].bytes_per_second & 0xFFFF);
+    benchmark_send_word(results[index].mismatches);
+  }
+}
+
+#endif /* BP_ENABLE_BENCHMARK */
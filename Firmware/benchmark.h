@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file benchmark.h
+ *
+ * @brief Bus engine throughput measured on the board itself, so kernel speed
+ * can be told apart from host link speed.
+ *
+ * Every engine clocks the same number of bytes out with nothing sent to the
+ * host meanwhile, timed with Timer #4/#5 running as a single 32 bits timer at
+ * FCY.  With MOSI jumpered to MISO the engines that read back also count the
+ * bytes that did not come back as sent.
+ */
+
+#ifndef BP_BENCHMARK_H
+#define BP_BENCHMARK_H
+
+#include <stdint.h>
+
+#include "configuration.h"
+
+/**
+ * Bus engines that get measured, in the order they are reported.
+ */
+typedef enum {
+  /** SPI1 peripheral, one byte at a time with spi_write_byte(). */
+  BP_BENCHMARK_ENGINE_SPI = 0,
+
+  /** SPI1 enhanced buffer FIFOs, with spi_transfer_buffer(). */
+  BP_BENCHMARK_ENGINE_SPI_FIFO,
+
+  /** Bit-banged 3-wire, MOSI out and MISO in, with bitbang_read_with_write().
+   */
+  BP_BENCHMARK_ENGINE_BITBANG_3WIRE,
+
+  /** Bit-banged 2-wire, MOSI as data, with bitbang_write_value(). */
+  BP_BENCHMARK_ENGINE_BITBANG_2WIRE,
+
+  /** 1-Wire write slots on MOSI, with onewire_send_buffer(). */
+  BP_BENCHMARK_ENGINE_1WIRE,
+
+  /** How many engines there are. */
+  BP_BENCHMARK_ENGINES_COUNT
+} bp_benchmark_engine_t;
+
+#ifdef BP_ENABLE_BENCHMARK
+
+/**
+ * Runs every engine over BP_BENCHMARK_BYTES bytes and sends the results on
+ * the binary I/O channel: the engines count, the bytes per run (two bytes,
+ * MSB first), then for every engine in bp_benchmark_engine_t order the bytes
+ * per second (four bytes, MSB first) and the loopback mismatches (two bytes,
+ * MSB first).  Engines left out of the build report zero for both, write-only
+ * engines always report zero mismatches.
+ *
+ * The mode configuration is put back once done, the pins are left as the
+ * last engine set them for the caller to bring back to a known state.
+ */
+void bp_benchmark_send(void);
+
+#endif /* BP_ENABLE_BENCHMARK */
+
+#endif /* !BP_BENCHMARK_H */
@@ -16,16 +16,26 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 
 /* Binary access modes for Bus Pirate scripting */
 
 #include "aux_pin.h"
 #include "base.h"
+#include "benchmark.h"
 #include "binary_io.h"
 #include "bitbang.h"
+#include "buffer_arena.h"
 #include "configuration.h"
 #include "core.h"
+#include "flight_recorder.h"
+#include "memory_usage.h"
+#include "pattern_generator.h"
+#include "profiling.h"
 #include "selftest.h"
+#include "servo.h"
+#include "telemetry.h"
+#include "timebase.h"
 
 #ifdef BP_ENABLE_SPI_SUPPORT
 #include "spi.h"
@@ -39,6 +49,10 @@
 #include "uart.h"
 #endif /* BP_ENABLE_UART_SUPPORT */
 
+#ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
+#include "iso7816.h"
+#endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
+
 #ifdef BP_ENABLE_1WIRE_SUPPORT
 #include "1wire.h"
 #endif /* BP_ENABLE_1WIRE_SUPPORT */
@@ -52,12 +66,23 @@
 #ifdef BP_JTAG_OPENOCD_SUPPORT
 #include "openocd.h"
 #endif /* BP_JTAG_OPENOCD_SUPPORT */
+#ifdef BP_JTAG_SWD_SUPPORT
+#include "swd.h"
+#endif /* BP_JTAG_SWD_SUPPORT */
 #endif /* BP_ENABLE_JTAG_SUPPORT */
 
 #ifdef BP_ENABLE_SMPS_SUPPORT
 #include "smps.h"
 #endif /* BP_ENABLE_SMPS_SUPPORT */
 
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+#include "adc_stream.h"
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+
+#ifdef BP_ENABLE_SUMP_SUPPORT
+#include "sump.h"
+#endif /* BP_ENABLE_SUMP_SUPPORT */
+
 extern mode_configuration_t mode_configuration;
 extern bus_pirate_configuration_t bus_pirate_configuration;
 
@@ -79,6 +104,7 @@ typedef enum {
   IO_COMMAND_GROUP_SET_PULLUP = 0b0101,
   IO_COMMAND_GROUP_SET_SPEED = 0b0110,
   IO_COMMAND_GROUP_CONFIGURATION = 0b1000,
+  IO_COMMAND_GROUP_SMART_CARD = 0b1001,
   IO_COMMAND_GROUP_PIC = 0b1010,
   IO_COMMAND_GROUP_SMPS = 0b1111
 } io_command_group;
@@ -97,7 +123,9 @@ typedef enum {
   IO_COMMAND_CLOCK_LOW,
   IO_COMMAND_CLOCK_HIGH,
   IO_COMMAND_DATA_LOW,
-  IO_COMMAND_DATA_HIGH
+  IO_COMMAND_DATA_HIGH,
+  IO_COMMAND_BULK_TRANSFER,
+  IO_COMMAND_TELEMETRY
 } wire_generic_command;
 
 typedef enum {
@@ -117,15 +145,34 @@ typedef enum {
   PIC_COMMAND_SET_MODE = 0xA0,
   PIC_COMMAND_WRITE = 0xA4,
   PIC_COMMAND_WRITE_AND_READ_BITS = 0xA5,
-  PIC_COMMAND_WRITE_AND_READ_COMMANDS = 0xA7
+  PIC_COMMAND_WRITE_AND_READ_COMMANDS = 0xA7,
+  PIC_COMMAND_STREAM = 0xA8
 } pic_command;
 
+/**
+ * Operations accepted by a PIC24 ICSP stream.
+ *
+ * @see handle_pic_command_stream
+ */
+typedef enum {
+  PIC_STREAM_END = 0x00,
+  PIC_STREAM_SIX,
+  PIC_STREAM_REGOUT,
+  PIC_STREAM_PROGRAM_ROW
+} pic_stream_operation;
+
 typedef enum {
   SMPS_COMMAND_GET_OUTPUT_VOLTAGE = 0xF0,
   SMPS_COMMAND_STOP = 0xF1,
   SMPS_COMMAND_START = 0xF2
 } smps_command;
 
+typedef enum {
+  SMART_CARD_COMMAND_ACTIVATE = 0x90,
+  SMART_CARD_COMMAND_EXCHANGE = 0x91,
+  SMART_CARD_COMMAND_DEACTIVATE = 0x92
+} smart_card_command;
+
 typedef enum {
   BITBANG_COMMAND_RESET = 0x00,
   BITBANG_COMMAND_SPI,
@@ -135,6 +182,7 @@ typedef enum {
   BITBANG_COMMAND_RAW_WIRE,
   BITBANG_COMMAND_OPENOCD,
   BITBANG_COMMAND_PIC,
+  BITBANG_COMMAND_SWD,
   BITBANG_COMMAND_RETURN_TO_TERMINAL = 0x0F,
   BITBANG_COMMAND_SHORT_SELF_TEST,
   BITBANG_COMMAND_FULL_SELF_TEST,
@@ -143,9 +191,116 @@ typedef enum {
   BITBANG_COMMAND_ADC_ONE_SHOT,
   BITBANG_COMMAND_ADC_CONTINUOUS,
   BITBANG_COMMAND_FREQUENCY_COUNT,
-  BITBANG_COMMAND_JTAG_XSVF = 0x18
+  BITBANG_COMMAND_ADC_STREAM,
+  BITBANG_COMMAND_JTAG_XSVF = 0x18,
+  BITBANG_COMMAND_ADC_SCAN_STREAM,
+  BITBANG_COMMAND_PERIOD_MEASURE,
+  BITBANG_COMMAND_PERIOD_STREAM,
+  BITBANG_COMMAND_FREQUENCY_MONITOR,
+  BITBANG_COMMAND_PWM_SEQUENCE,
+  BITBANG_COMMAND_SERVOS,
+  BITBANG_COMMAND_PATTERN_GENERATOR,
+  BITBANG_COMMAND_IDENTIFY = 0x20,
+  BITBANG_COMMAND_DESCRIBE,
+  BITBANG_COMMAND_PROFILING,
+  BITBANG_COMMAND_SELF_TEST_REPORT,
+  BITBANG_COMMAND_SMPS_STATUS,
+  BITBANG_COMMAND_KEEP_MODE_SETTINGS,
+  BITBANG_COMMAND_TIMEBASE,
+  BITBANG_COMMAND_FLIGHT_RECORDER,
+  BITBANG_COMMAND_TELEMETRY,
+  BITBANG_COMMAND_LINK_SPEED,
+  BITBANG_COMMAND_ADC_DECIMATE,
+  BITBANG_COMMAND_MEMORY_USAGE,
+  BITBANG_COMMAND_BENCHMARK
 } bitbang_command;
 
+/**
+ * Keep mode settings command flags.
+ *
+ * @see handle_keep_mode_settings
+ */
+#define KEEP_MODE_SETTINGS_ON 0x01
+
+/**
+ * Operations accepted by the USB timebase command.
+ *
+ * @see handle_timebase
+ */
+typedef enum {
+  TIMEBASE_READ = 0x00,
+  TIMEBASE_TRIGGER_OUT,
+  TIMEBASE_TRIGGER_IN_ARM,
+  TIMEBASE_TRIGGER_IN_DISARM,
+  TIMEBASE_TRIGGER_IN_READ
+} timebase_operation;
+
+/**
+ * Flight recorder command flags.
+ *
+ * @see handle_flight_recorder
+ */
+#define FLIGHT_RECORDER_CLEAR 0x01
+
+/**
+ * Host link rates accepted by the link speed command.
+ *
+ * @see handle_link_speed
+ */
+typedef enum {
+  LINK_SPEED_115200 = 0x00,
+  LINK_SPEED_250000,
+  LINK_SPEED_500000,
+  LINK_SPEED_1000000,
+  LINK_SPEED_2000000,
+  LINK_SPEED_COUNT
+} link_speed;
+
+#ifdef BUSPIRATEV3
+
+/**
+ * UART1 baud rate generator values for each link_speed, BRGH being set the
+ * rate is FCY / (4 * (U1BRG + 1)).
+ */
+static const uint16_t LINK_SPEED_BRG[LINK_SPEED_COUNT] = {
+    34, /* 114285 bps, like the terminal at 115200 bps */
+    15, /* 250000 bps */
+    7,  /* 500000 bps */
+    3,  /* 1000000 bps */
+    1   /* 2000000 bps */
+};
+
+/**
+ * How long the host has to confirm a new link speed, in polls.
+ */
+#define LINK_SPEED_CONFIRM_POLLS 2500
+
+/**
+ * Microseconds between two polls while waiting for the confirmation.
+ */
+#define LINK_SPEED_POLL_US 100
+
+#endif /* BUSPIRATEV3 */
+
+/**
+ * Pattern generator command flags.
+ *
+ * @see handle_pattern_generator
+ */
+#define PATTERN_FLAG_CAPTURE 0x01
+
+/**
+ * Operations accepted by the background frequency monitor command.
+ *
+ * @see handle_frequency_monitor
+ */
+typedef enum {
+  FREQUENCY_MONITOR_STOP = 0x00,
+  FREQUENCY_MONITOR_START,
+  FREQUENCY_MONITOR_READ,
+  FREQUENCY_MONITOR_READ_AND_RESET
+} frequency_monitor_operation;
+
 /**
  * Write and read bits payload for PIC24 SIX commands.
  *
@@ -159,6 +314,45 @@ static const uint8_t PIC24_WRITE_AND_READ_PAYLOAD[3 * 4] = {
 
 static const uint8_t PIC24_NOP_PAYLOAD[3] = {0};
 
+/* PIC24F instructions used by the device side row programming sequence. */
+
+#define PIC24_OPCODE_NOP 0x000000UL
+#define PIC24_OPCODE_GOTO_0x200 0x040200UL
+#define PIC24_OPCODE_MOV_LITERAL_W(literal, wn)                                \
+  (0x200000UL | ((uint32_t)(literal) << 4) | (wn))
+#define PIC24_OPCODE_MOV_W10_NVMCON 0x883B0AUL
+#define PIC24_OPCODE_MOV_W0_TBLPAG 0x880190UL
+#define PIC24_OPCODE_MOV_NVMCON_W2 0x803B02UL
+#define PIC24_OPCODE_MOV_W2_VISI 0x883C22UL
+#define PIC24_OPCODE_BSET_NVMCON_WR 0xA8E761UL
+#define PIC24_OPCODE_CLR_W6 0xEB0300UL
+#define PIC24_OPCODE_TBLWTL_W6P_W7 0xBB0BB6UL
+#define PIC24_OPCODE_TBLWTHB_W6P_W7P 0xBBDBB6UL
+#define PIC24_OPCODE_TBLWTHB_W6P_PW7 0xBBEBB6UL
+#define PIC24_OPCODE_TBLWTL_W6P_W7P 0xBB1BB6UL
+#define PIC24_OPCODE_TBLRDHB_W6_W7 0xBACB96UL
+#define PIC24_OPCODE_TBLRDL_W6P_W7 0xBA0BB6UL
+
+/** NVMCON value for a flash row write. */
+#define PIC24_NVMCON_ROW_WRITE 0x4001
+/** Address of the VISI register, used to read values back over REGOUT. */
+#define PIC24_VISI_ADDRESS 0x0784
+/** NVMCON write in progress bit. */
+#define PIC24_NVMCON_WR 0x8000
+
+/**
+ * How many times NVMCON is polled for the end of a row write before giving
+ * up. Each poll takes around 150us at the fastest bus speed, row writes take
+ * a couple of milliseconds.
+ */
+#define PIC24_ROW_WRITE_POLLS 1000
+
+/** Instruction words sent to the write latches per loading sequence. */
+#define PIC24_ROW_GROUP_WORDS 4
+
+/** Bytes per instruction word in a PIC_STREAM_PROGRAM_ROW payload. */
+#define PIC24_ROW_WORD_BYTES 3
+
 /**
  * @brief Raw wire command handler.
  *
@@ -187,6 +381,8 @@ static const uint8_t PIC24_NOP_PAYLOAD[3] = {0};
  * <tr><td><tt>0b0110xxxx</tt></td><td><tt>0x6x</tt></td><td>Set speed</td></tr>
  * <tr><td><tt>0b1000xxxx</tt></td><td><tt>0x8x</tt></td><td>Mode
  * configuration</td></tr>
+ * <tr><td><tt>0b1001xxxx</tt></td><td><tt>0x9x</tt></td><td>ISO 7816-3
+ * smart card</td></tr>
  * <tr><td><tt>0b1010xxxx</tt></td><td><tt>0xAx</tt></td><td>PIC
  * programming</td></tr>
  * <tr><td><tt>0b1111xxxx</tt></td><td><tt>0xFx</tt></td><td>SMPS</td></tr>
@@ -203,6 +399,7 @@ static const uint8_t PIC24_NOP_PAYLOAD[3] = {0};
  * @see handle_configuration
  * @see handle_pic_command
  * @see handle_smps_command
+ * @see handle_smart_card_command
  * @see io_command_group
  */
 static inline void binary_io_raw_wire_mode_handler(void);
@@ -242,6 +439,10 @@ static inline void binary_io_raw_wire_mode_handler(void);
  * <tr><td><tt>0b00001100</tt></td><td><tt>0x03</tt></td><td>Pull DATA
  * low.</td></tr> <tr><td><tt>0b00001101</tt></td><td><tt>0x03</tt></td><td>Set
  * DATA high.</td></tr>
+ * <tr><td><tt>0b00001110</tt></td><td><tt>0x0E</tt></td><td>Bulk byte
+ * transfer of up to BP_TERMINAL_BUFFER_SIZE bytes.</td></tr>
+ * <tr><td><tt>0b00001111</tt></td><td><tt>0x0F</tt></td><td>Telemetry
+ * counters, see bp_binary_io_send_telemetry.</td></tr>
  * </tbody>
  * </table>
  *
@@ -259,6 +460,29 @@ static inline bool
 handle_wire_generic_command(const wire_generic_command command);
 
 static inline void handle_bulk_byte_transfer(const uint8_t command);
+
+/**
+ * @brief Transfers a block of bytes given by the host in one go.
+ *
+ * The command byte is followed by the block length (two bytes, MSB first, from
+ * 1 to BP_TERMINAL_BUFFER_SIZE) and by the block itself.  The whole block is
+ * received first, then clocked out without talking to the host, so the bus
+ * runs at full speed instead of waiting on a serial round trip per byte.
+ *
+ * The reply is 0x01 followed, in 3-wire mode, by the bytes read back from the
+ * bus as a single block.  An invalid length is answered with 0x00.
+ */
+static void handle_bulk_transfer(void);
+
+/**
+ * @brief Reverses a value read from or written to the bus, for LSB first
+ * transfers.
+ *
+ * @param[in] value the value to reverse.
+ *
+ * @return the value with its lower mode_configuration.numbits bits reversed.
+ */
+static inline uint16_t reverse_bus_value(const uint16_t value);
 static inline void handle_bulk_clock_ticks_advance(const uint8_t command);
 static inline void handle_bulk_bit_transfer(const uint8_t command);
 static inline void handle_set_pullup(const uint8_t command);
@@ -269,13 +493,175 @@ static inline void handle_pic_command_write_and_read_commands(void);
 static inline void handle_pic_command_write_and_read_bits(void);
 static inline void handle_pic_command_write(void);
 static inline void handle_pic_command(const pic_command command);
+
+/**
+ * @brief Runs a stream of PIC24 ICSP operations as they come in.
+ *
+ * The command is answered with 0x01 if the current PIC mode is PIC24, 0x00
+ * otherwise.  Operations are then read one by one and executed straight away,
+ * so the host can keep sending without waiting for a reply in between:
+ *
+ * <table>
+ * <thead>
+ * <tr><th>Operation</th><th>Payload</th><th>Reply</th></tr>
+ * </thead>
+ * <tbody>
+ * <tr><td><tt>0x00</tt></td><td>none</td><td>0x01, ends the stream</td></tr>
+ * <tr><td><tt>0x01</tt></td><td>SIX opcode (3 bytes, MSB first), NOPs to
+ * append (1 byte)</td><td>none</td></tr>
+ * <tr><td><tt>0x02</tt></td><td>none</td><td>VISI (2 bytes, MSB first), a
+ * NOP follows the REGOUT</td></tr>
+ * <tr><td><tt>0x03</tt></td><td>see pic24_program_row()</td><td>0x01 if the
+ * row was written and read back fine, 0x00 otherwise</td></tr>
+ * </tbody>
+ * </table>
+ *
+ * An unknown operation is answered with 0x00 and ends the stream.
+ *
+ * Opcodes are sent in their natural bit order, the bit reversal that ICSP
+ * needs is done here.  There is no flow control on v3 boards' UART, so the
+ * host should wait for each row reply there before sending more.
+ */
+static void handle_pic_command_stream(void);
 static inline void handle_smps_command(const smps_command command);
 
+/**
+ * Talks to an asynchronous smart card with the ISO 7816-3 T=0 engine, RST on
+ * CS, CLK on CLK and I/O on MOSI.
+ *
+ * <table>
+ * <thead>
+ * <tr><th>Hexadecimal</th><th>Description</th></tr>
+ * </thead>
+ * <tbody>
+ * <tr><td><tt>0x90</tt></td><td>Activate the card.  Answered with 0x01, the
+ * ATR length and the ATR, or with 0x00 and the failure reason.</td></tr>
+ * <tr><td><tt>0x91</tt></td><td>Followed by the command APDU length (two
+ * bytes, MSB first) and the command APDU.  Answered with 0x01, the response
+ * length (two bytes, MSB first) and the response data with SW1 and SW2, or
+ * with 0x00 and the failure reason.</td></tr>
+ * <tr><td><tt>0x92</tt></td><td>Deactivate the card, answered with
+ * 0x01.</td></tr>
+ * </tbody>
+ * </table>
+ *
+ * Failure reasons are iso7816_result_t values.
+ *
+ * @param[in] command the command to process.
+ *
+ * @see iso7816_activate
+ * @see iso7816_t0_exchange
+ */
+static void handle_smart_card_command(const smart_card_command command);
+
 static inline void handle_setup_pwm(void);
 static inline void handle_clear_pwm(void);
 static inline void handle_read_adc_one_shot(void);
 static inline void handle_read_adc_continuously(void);
+
+/**
+ * @brief Starts a timer driven ADC block stream on the probe pin, or on the
+ * probe pin and the power rails.
+ *
+ * The command is followed by the sampling period in microseconds (two bytes,
+ * MSB first), and answered with 0x01 before the blocks start coming, or with
+ * 0x00 if the period is out of range or the buffer arena has no room for the
+ * blocks.  Any byte sent to the board stops the stream.
+ *
+ * @param[in] scan true to sample all inputs, false for the probe pin only.
+ *
+ * @see adc_stream_run
+ */
+static void handle_adc_stream(const bool scan);
+
+/**
+ * @brief Starts a timer driven ADC stream of block summaries, see
+ * adc_stream_decimate().
+ *
+ * The command is followed by the sampling period in microseconds (two bytes,
+ * MSB first), the samples per input in a block as a power of two, and a
+ * flags byte, ADC_DECIMATE_SCAN to sample the probe pin and the power rails
+ * or 0 for the probe pin only.  It is answered with 0x01 before the blocks
+ * start coming, or with 0x00 if anything is out of range or the buffer arena
+ * has no room for the blocks.  Any byte sent to the board stops the stream.
+ *
+ * @see adc_stream_decimate
+ */
+static void handle_adc_decimate(void);
 static inline void handle_frequency_measurement(void);
+
+/**
+ * Times a number of signal periods on the AUX pin with the input capture
+ * units.
+ *
+ * The command is followed by the number of periods to time (two bytes, MSB
+ * first), and answered with 0x00 if that is zero.  Otherwise 0x01 is sent,
+ * followed either by the measured length of the periods in FCY ticks (four
+ * bytes, MSB first), or by a stream of such measurements until any byte is
+ * sent to the board.
+ *
+ * @param[in] stream true to keep measuring, false for a single measurement.
+ *
+ * @see bp_measure_periods
+ * @see bp_stream_periods
+ */
+static void handle_period_measurement(const bool stream);
+
+/**
+ * Controls the background frequency monitor on the AUX pin.
+ *
+ * The command is followed by a frequency_monitor_operation byte.  Stop and
+ * start are answered with 0x01; the read operations with 0x01 followed by the
+ * bp_frequency_statistics_t fields in declaration order, four bytes each, MSB
+ * first.  Unknown operations get 0x00.
+ *
+ * @see bp_frequency_monitor_start
+ */
+static void handle_frequency_monitor(void);
+
+/**
+ * Uploads and starts a table driven PWM sequence on the AUX pin.
+ *
+ * The command is followed by the timer prescaler (one byte), the PWM period
+ * (two bytes), the PWM periods per step (two bytes), the sequence mode (one
+ * byte), the bursts count (two bytes), the number of steps (one byte) and
+ * then each step duty cycle (two bytes).  Multi-byte values are MSB first
+ * and use the same raw timer units as BITBANG_COMMAND_SETUP_PWM.  The reply
+ * is 0x01 once the sequence has started, or 0x00 if the description was not
+ * valid; BITBANG_COMMAND_CLEAR_PWM stops it.
+ *
+ * @see bp_pwm_sequence_start
+ */
+static void handle_pwm_sequence(void);
+
+/**
+ * Sets the pulse widths of the multi-channel servo controller.
+ *
+ * The command is followed by SERVO_CHANNELS pulse widths in microseconds (two
+ * bytes each, MSB first) for AUX, CS, MOSI, CLK and MISO in that order, zero
+ * turning an output off.  The reply is 0x01 once the widths are queued for
+ * the next frame, or 0x00 if any of them is out of range.  Turning all
+ * outputs off stops the controller.
+ *
+ * @see servo_controller_update
+ */
+static void handle_servos(void);
+
+/**
+ * Plays a host supplied buffer of pin states onto the IO pins.
+ *
+ * The command is followed by a flags byte (PATTERN_FLAG_CAPTURE to sample
+ * the pins as well), the step period in FCY cycles, the repeat count (zero
+ * to play until any byte is received) and the pattern length, all two bytes
+ * MSB first, and then the pattern itself in the same layout used by the pin
+ * state command.  Patterns can be up to BP_TERMINAL_BUFFER_SIZE bytes long,
+ * half that when capturing.  Once done 0x01 is sent, followed by the
+ * captured pin states if asked for; invalid parameters get 0x00 after the
+ * pattern has been skipped.
+ *
+ * @see pattern_generator_run
+ */
+static void handle_pattern_generator(void);
 static inline void handle_bitbang_command(const bitbang_command command);
 
 static void read_and_transmit_adc_measurement(void);
@@ -293,6 +679,31 @@ static void pic416_write(const uint8_t command, const uint8_t data_low,
 static void pic424_read(void);
 static void pic424_write(const uint8_t *payload, const size_t nops);
 
+/**
+ * @brief Sends a SIX command for the given PIC24 instruction.
+ *
+ * @param[in] opcode the 24 bits instruction, in its natural bit order.
+ * @param[in] nops how many NOPs to send after the instruction.
+ */
+static void pic24_send_six_opcode(const uint32_t opcode, const size_t nops);
+
+/**
+ * @brief Sends a REGOUT command and returns the VISI register contents.
+ */
+static uint16_t pic24_read_visi(void);
+
+/**
+ * @brief Programs one flash row over standard ICSP, then reads it back.
+ *
+ * The payload read from the host is the row word address (3 bytes, MSB first),
+ * the number of 4 words groups to write (1 byte, 16 for a 64 words row) and
+ * the words themselves, 3 bytes each in the same order as in an Intel HEX file
+ * (low, high, upper).
+ *
+ * @return true if the row was written and verified, false otherwise.
+ */
+static bool pic24_program_row(void);
+
 #define R3WMOSI_TRIS BP_MOSI_DIR
 #define R3WCLK_TRIS BP_CLK_DIR
 #define R3WMISO_TRIS BP_MISO_DIR
@@ -303,7 +714,178 @@ static void pic424_write(const uint8_t *payload, const size_t nops);
 #define R3WMISO BP_MISO
 #define R3WCS BP_CS
 
+/**
+ * Sends what firmware and board this is, and which binary modes it has.
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Content</th></tr>
+ * <tr><td>0</td><td>Length of what follows, 5 for now</td></tr>
+ * <tr><td>1</td><td>Firmware major version</td></tr>
+ * <tr><td>2</td><td>Firmware minor version</td></tr>
+ * <tr><td>3</td><td>Hardware version, 3 or 4</td></tr>
+ * <tr><td>4-5</td><td>BP_BINARY_IO_CAPABILITY_* flags, MSB first</td></tr>
+ * </table>
+ */
+static void send_identity(void);
+
+/**
+ * Largest describe command answer, length included.
+ */
+#define DESCRIBE_MAXIMUM_SIZE 64
+
+/**
+ * Sends the describe command entries, as listed in binary_io.h.
+ */
+static void send_description(void);
+
+/**
+ * Appends a describe entry.
+ *
+ * @param[in] output where the entry goes.
+ * @param[in] type the BP_BINARY_IO_DESCRIBE_* entry type.
+ * @param[in] value the entry value.
+ * @param[in] size the value size in bytes, 1 to 4.
+ *
+ * @return where the next entry goes.
+ */
+static uint8_t *describe_entry(uint8_t *output, const uint8_t type,
+                               const uint32_t value, const uint8_t size);
+
+/**
+ * The BP_BINARY_IO_CAPABILITY_* flags of this build.
+ */
+static uint16_t binary_io_capabilities(void);
+
 static void binary_io_self_test(bool jumper_test);
+
+/**
+ * Self-test report command option, also run the checks needing jumpers.
+ */
+#define SELF_TEST_REPORT_JUMPERS 0x01
+
+/**
+ * Runs the self-test without interaction and sends the results check by
+ * check, for production fixtures testing boards unattended.
+ *
+ * Takes an options byte, SELF_TEST_REPORT_JUMPERS or 0, and answers with
+ * 0x00 for unknown options or 0x01 followed by the performed and failed
+ * checks masks, as in selftest_report_t, each 32 bits MSB first.  The board
+ * stays in binary mode afterwards.
+ */
+static void binary_io_self_test_report(void);
+
+/**
+ * Sends the switched mode power supply regulation loop state, to monitor it
+ * while it runs.  SMPS_COMMAND_START has no room left for another command
+ * in its group, hence this living here.
+ *
+ * Answers with 0x00 if the build has no SMPS support, otherwise 0x01
+ * followed by what smps_status() sends.
+ */
+static void binary_io_smps_status(void);
+
+/**
+ * Makes switching between binary modes cheaper, for hosts that hop between
+ * modes many times in a row.
+ *
+ * Takes a flags byte, KEEP_MODE_SETTINGS_ON or 0, and answers with 0x01, or
+ * with 0x00 for unknown flags.  While on, power supplies and pull-ups are left
+ * as they are across mode switches, and SPI and I2C start with the settings
+ * they had when last left instead of the defaults, so their configuration
+ * commands need not be sent again.  Entering binary mode or going back to the
+ * terminal turns it off.
+ */
+static void handle_keep_mode_settings(void);
+
+/**
+ * Reads the USB start of frame timebase and drives the AUX shared trigger,
+ * to line up captures taken by several boards on the same host.
+ *
+ * The command is followed by a timebase_operation byte.  Timestamps are the
+ * frame number (four bytes) and the FCY ticks since that frame started (two
+ * bytes), MSB first; the low 11 bits of the frame number are the host's own,
+ * so boards read at about the same time tell apart the wraps in the upper
+ * bits.
+ *
+ * <table>
+ * <thead>
+ * <tr><th>Operation</th><th>Reply after 0x01</th></tr>
+ * </thead>
+ * <tbody>
+ * <tr><td><tt>0x00</tt></td><td>Current timestamp, then the ticks the last
+ * frame took (two bytes, MSB first)</td></tr>
+ * <tr><td><tt>0x01</tt></td><td>Timestamp of a 1us pulse sent on
+ * AUX</td></tr>
+ * <tr><td><tt>0x02</tt></td><td>None, AUX rising edges are timestamped from
+ * now on</td></tr>
+ * <tr><td><tt>0x03</tt></td><td>None, AUX is let go</td></tr>
+ * <tr><td><tt>0x04</tt></td><td>Rising edges seen since arming (two bytes,
+ * MSB first), then the timestamp of the last one, zero if none</td></tr>
+ * </tbody>
+ * </table>
+ *
+ * Answers with 0x00 on unknown operations, on builds without
+ * BP_ENABLE_USB_TIMEBASE, or while no start of frame has been seen yet.
+ * The trigger input stays armed across binary mode switches.
+ */
+static void handle_timebase(void);
+
+/**
+ * Sends the flight recorder ring, to see what the board did before a host
+ * session went wrong.
+ *
+ * Takes a flags byte, FLIGHT_RECORDER_CLEAR or 0, and answers with 0x01
+ * followed by what bp_flight_recorder_send() sends.  Unknown flags and builds
+ * without BP_ENABLE_FLIGHT_RECORDER get 0x00.  This command is itself the
+ * newest record of the dump.
+ */
+static void handle_flight_recorder(void);
+
+/**
+ * Switches the v3 host link to a faster rate, the FT232RL takes up to
+ * 3 Mbaud while the terminal tops at 115200 bps.
+ *
+ * Takes a link_speed byte and answers 0x00 on unknown rates and on v4, whose
+ * CDC link has no rate to speak of.  Otherwise the answer is 0x01, still at
+ * the old rate, after which the UART switches and waits for the host to send
+ * 0xAA then 0x55 at the new one.  If they come within 250ms they are
+ * answered with 0x01 at the new rate, else the old rate is set back and 0x00
+ * is sent with it, so a host that could not follow just goes back too.  The
+ * rate stays until the board returns to the terminal, which resets it.
+ */
+static void handle_link_speed(void);
+
+/**
+ * Sends the stack high-water mark and the buffer arena usage, to size buffers
+ * against the memory really left.
+ *
+ * Answers with 0x01 followed by what bp_memory_usage_send() sends, builds
+ * without BP_ENABLE_MEMORY_USAGE get 0x00.
+ */
+static void handle_memory_usage(void);
+
+/**
+ * Times the bus engines on the board without the host link in the loop, so
+ * regressions in the firmware kernels show up apart from host and USB
+ * variance.  MOSI should be jumpered to MISO for the loopback counts to mean
+ * anything.
+ *
+ * Answers with 0x01 followed by what bp_benchmark_send() sends, builds
+ * without BP_ENABLE_BENCHMARK get 0x00.  The pins are reset afterwards.
+ */
+static void handle_benchmark(void);
+
+#ifdef BP_ENABLE_USB_TIMEBASE
+
+/**
+ * Sends a timebase timestamp, frame first, MSB first.
+ *
+ * @param[in] timestamp the timestamp to send.
+ */
+static void send_timestamp(const bp_timestamp_t *timestamp);
+
+#endif /* BP_ENABLE_USB_TIMEBASE */
+
 static void reset_state(void);
 
 #define BINARY_IO_2_WIRES 0
@@ -312,7 +894,8 @@ static void reset_state(void);
 typedef struct {
   uint8_t wires : 1;
   uint8_t pic_mode : 2;
-  uint8_t reserved : 5;
+  uint8_t keep_mode_settings : 1;
+  uint8_t reserved : 4;
 } binary_io_state_t;
 
 static binary_io_state_t io_state = {0};
@@ -341,6 +924,7 @@ Commands:
 00000101 //enter raw wire mode
 00000110 // enter openOCD
 00000111 // pic programming mode
+00001000 // enter SWD
 00001111 //reset, return to user terminal
 00010000 //short self test
 00010001 //full self test with jumpers
@@ -351,22 +935,55 @@ Commands:
 // Added JM  Only with BP4
 00010101 // ADC ....
 00010110 // ADC Stop
+00010111 // ADC block stream
 00011000 // XSVF Player
+00011001 // ADC scan block stream (probe and power rails)
 // End added JM
+00011010 // AUX input capture period measurement
+00011011 // AUX input capture period stream
+00011100 // AUX background frequency monitor
+00011101 // AUX table driven PWM sequence
+00011110 // servo controller
+00011111 // pin pattern generator
 //
+00100000 // identify: versions and capabilities
+00100001 // describe: buffer sizes, clocks and fast paths
+00100010 // profiling counters, read and clear (BP_ENABLE_PROFILING builds)
+00100011 // self-test report
+00100100 // SMPS regulation loop state
+00100101 // keep power, pull-ups and SPI/I2C settings across mode switches
+00100110 // USB start of frame timebase and AUX shared trigger (BP4)
+00100111 // flight recorder dump (BP_ENABLE_FLIGHT_RECORDER builds)
+00101000 // throughput and error telemetry counters
+00101001 // host link speed switch (BP3)
+00101010 // decimated ADC block stream (BP_ENABLE_ADC_STREAM_SUPPORT builds)
+00101011 // stack and RAM usage report (BP_ENABLE_MEMORY_USAGE builds)
+00101100 // bus engine throughput benchmark (BP_ENABLE_BENCHMARK builds)
 010xxxxx //set input(1)/output(0) pin state (returns pin read)
  */
 
 void send_binary_io_mode_identifier(void) { MSG_BBIO_MODE_IDENTIFIER; }
 
-void enter_binary_bitbang_mode(void) {
+void enter_binary_bitbang_mode(const bool magic) {
+  size_t index;
+
   bp_enable_mode_led();
+  io_state.keep_mode_settings = OFF;
   reset_state();
+  user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_RESPONSE);
   send_binary_io_mode_identifier();
+  if (magic) {
+    for (index = 0; index < sizeof(BP_BINARY_IO_MAGIC) - 2; index++) {
+      REPORT_IO_FAILURE();
+    }
+    send_identity();
+  }
 
   for (;;) {
     uint8_t input_byte = user_serial_read_byte();
 
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_ROOT, input_byte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
     if ((input_byte & 0b10000000) == 0) {
       handle_bitbang_command((bitbang_command)input_byte);
     } else {
@@ -384,7 +1001,7 @@ void handle_bitbang_command(const bitbang_command command) {
   case BITBANG_COMMAND_SPI:
 #if defined(BP_ENABLE_SPI_SUPPORT)
     reset_state();
-    spi_enter_binary_io();
+    spi_enter_binary_io(io_state.keep_mode_settings);
 #endif /* BP_ENABLE_SPI_SUPPORT */
     reset_state();
     send_binary_io_mode_identifier();
@@ -393,7 +1010,7 @@ void handle_bitbang_command(const bitbang_command command) {
   case BITBANG_COMMAND_I2C:
 #if defined(BP_ENABLE_I2C_SUPPORT)
     reset_state();
-    binary_io_enter_i2c_mode();
+    binary_io_enter_i2c_mode(io_state.keep_mode_settings);
 #endif /* BP_ENABLE_I2C_SUPPORT */
     reset_state();
     send_binary_io_mode_identifier();
@@ -442,15 +1059,28 @@ void handle_bitbang_command(const bitbang_command command) {
     send_binary_io_mode_identifier();
     break;
 
+  case BITBANG_COMMAND_SWD:
+#if defined(BP_JTAG_SWD_SUPPORT)
+    reset_state();
+    swd_enter_binary_io();
+    reset_state();
+    send_binary_io_mode_identifier();
+#else
+    REPORT_IO_FAILURE();
+#endif /* BP_JTAG_SWD_SUPPORT */
+    break;
+
   case BITBANG_COMMAND_RETURN_TO_TERMINAL:
     REPORT_IO_SUCCESS();
     bp_disable_mode_led();
     user_serial_wait_transmission_done();
+    io_state.keep_mode_settings = OFF;
 #if defined(BUSPIRATEV4)
+    user_serial_set_flush_policy(USER_SERIAL_FLUSH_ON_TIMEOUT);
     reset_state();
     return;
 #else
-    __asm volatile("RESET");
+    Reset();
 #endif /* BUSPIRATEV4 */
     break;
 
@@ -462,6 +1092,46 @@ void handle_bitbang_command(const bitbang_command command) {
     binary_io_self_test(true);
     break;
 
+  case BITBANG_COMMAND_SELF_TEST_REPORT:
+    binary_io_self_test_report();
+    break;
+
+  case BITBANG_COMMAND_SMPS_STATUS:
+    binary_io_smps_status();
+    break;
+
+  case BITBANG_COMMAND_KEEP_MODE_SETTINGS:
+    handle_keep_mode_settings();
+    break;
+
+  case BITBANG_COMMAND_TIMEBASE:
+    handle_timebase();
+    break;
+
+  case BITBANG_COMMAND_FLIGHT_RECORDER:
+    handle_flight_recorder();
+    break;
+
+  case BITBANG_COMMAND_TELEMETRY:
+    bp_binary_io_send_telemetry();
+    break;
+
+  case BITBANG_COMMAND_LINK_SPEED:
+    handle_link_speed();
+    break;
+
+  case BITBANG_COMMAND_ADC_DECIMATE:
+    handle_adc_decimate();
+    break;
+
+  case BITBANG_COMMAND_MEMORY_USAGE:
+    handle_memory_usage();
+    break;
+
+  case BITBANG_COMMAND_BENCHMARK:
+    handle_benchmark();
+    break;
+
   case BITBANG_COMMAND_SETUP_PWM:
     handle_setup_pwm();
     break;
@@ -482,6 +1152,54 @@ void handle_bitbang_command(const bitbang_command command) {
     handle_frequency_measurement();
     break;
 
+  case BITBANG_COMMAND_PERIOD_MEASURE:
+    handle_period_measurement(false);
+    break;
+
+  case BITBANG_COMMAND_PERIOD_STREAM:
+    handle_period_measurement(true);
+    break;
+
+  case BITBANG_COMMAND_FREQUENCY_MONITOR:
+    handle_frequency_monitor();
+    break;
+
+  case BITBANG_COMMAND_PWM_SEQUENCE:
+    handle_pwm_sequence();
+    break;
+
+  case BITBANG_COMMAND_SERVOS:
+    handle_servos();
+    break;
+
+  case BITBANG_COMMAND_PATTERN_GENERATOR:
+    handle_pattern_generator();
+    break;
+
+  case BITBANG_COMMAND_IDENTIFY:
+    send_identity();
+    break;
+
+  case BITBANG_COMMAND_DESCRIBE:
+    send_description();
+    break;
+
+  case BITBANG_COMMAND_PROFILING:
+#ifdef BP_ENABLE_PROFILING
+    bp_profiling_send_report();
+#else
+    REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_PROFILING */
+    break;
+
+  case BITBANG_COMMAND_ADC_STREAM:
+    handle_adc_stream(false);
+    break;
+
+  case BITBANG_COMMAND_ADC_SCAN_STREAM:
+    handle_adc_stream(true);
+    break;
+
   case BITBANG_COMMAND_JTAG_XSVF:
 #ifdef BUSPIRATEV4
     bp_enable_voltage_regulator();
@@ -502,10 +1220,206 @@ void handle_bitbang_command(const bitbang_command command) {
   }
 }
 
+uint16_t binary_io_capabilities(void) {
+  uint16_t capabilities = 0;
+
+#ifdef BP_ENABLE_SPI_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_SPI;
+#endif /* BP_ENABLE_SPI_SUPPORT */
+#ifdef BP_ENABLE_I2C_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_I2C;
+#endif /* BP_ENABLE_I2C_SUPPORT */
+#ifdef BP_ENABLE_UART_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_UART;
+#endif /* BP_ENABLE_UART_SUPPORT */
+#ifdef BP_ENABLE_1WIRE_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_1WIRE;
+#endif /* BP_ENABLE_1WIRE_SUPPORT */
+#ifdef BP_JTAG_OPENOCD_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_OPENOCD;
+#endif /* BP_JTAG_OPENOCD_SUPPORT */
+#ifdef BP_ENABLE_PIC_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_PIC;
+#endif /* BP_ENABLE_PIC_SUPPORT */
+#ifdef BP_JTAG_SWD_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_SWD;
+#endif /* BP_JTAG_SWD_SUPPORT */
+#ifdef BUSPIRATEV4
+  capabilities |= BP_BINARY_IO_CAPABILITY_XSVF;
+#endif /* BUSPIRATEV4 */
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_ADC_STREAM;
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+#ifdef BP_ENABLE_SMPS_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_SMPS;
+#endif /* BP_ENABLE_SMPS_SUPPORT */
+#ifdef BP_ENABLE_SUMP_SUPPORT
+  capabilities |= BP_BINARY_IO_CAPABILITY_SUMP;
+#endif /* BP_ENABLE_SUMP_SUPPORT */
+#ifdef BP_USB_VENDOR_INTERFACE
+  capabilities |= BP_BINARY_IO_CAPABILITY_VENDOR_PIPE;
+#endif /* BP_USB_VENDOR_INTERFACE */
+#ifdef BP_ENABLE_PROFILING
+  capabilities |= BP_BINARY_IO_CAPABILITY_PROFILING;
+#endif /* BP_ENABLE_PROFILING */
+#ifdef BP_ENABLE_USB_TIMEBASE
+  capabilities |= BP_BINARY_IO_CAPABILITY_USB_TIMEBASE;
+#endif /* BP_ENABLE_USB_TIMEBASE */
+#ifdef BP_ENABLE_FLIGHT_RECORDER
+  capabilities |= BP_BINARY_IO_CAPABILITY_FLIGHT_RECORDER;
+#endif /* BP_ENABLE_FLIGHT_RECORDER */
+#ifdef BP_ENABLE_TELEMETRY
+  capabilities |= BP_BINARY_IO_CAPABILITY_TELEMETRY;
+#endif /* BP_ENABLE_TELEMETRY */
+
+  return capabilities;
+}
+
+void send_identity(void) {
+  uint16_t capabilities = binary_io_capabilities();
+
+  user_serial_transmit_character(5);
+  user_serial_transmit_character(BP_FIRMWARE_VERSION_MAJOR);
+  user_serial_transmit_character(BP_FIRMWARE_VERSION_MINOR);
+#ifdef BUSPIRATEV4
+  user_serial_transmit_character(4);
+#else
+  user_serial_transmit_character(3);
+#endif /* BUSPIRATEV4 */
+  user_serial_transmit_character(capabilities >> 8);
+  user_serial_transmit_character(capabilities & 0xFF);
+}
+
+uint8_t *describe_entry(uint8_t *output, const uint8_t type,
+                        const uint32_t value, const uint8_t size) {
+  uint8_t index;
+
+  *output++ = type;
+  *output++ = size;
+  for (index = size; index > 0; index--) {
+    *output++ = (value >> ((index - 1) * 8)) & 0xFF;
+  }
+  return output;
+}
+
+void send_description(void) {
+  uint8_t description[DESCRIBE_MAXIMUM_SIZE];
+  uint8_t *output;
+  uint16_t features = BP_BINARY_IO_FEATURE_KEEP_MODE_SETTINGS |
+                      BP_BINARY_IO_FEATURE_I2C_SMBUS;
+  uint16_t length;
+
+#ifdef BUSPIRATEV3
+  features |= BP_BINARY_IO_FEATURE_LINK_SPEED;
+#endif /* BUSPIRATEV3 */
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+  features |= BP_BINARY_IO_FEATURE_ADC_DECIMATE;
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+#ifdef BP_ENABLE_MEMORY_USAGE
+  features |= BP_BINARY_IO_FEATURE_MEMORY_USAGE;
+#endif /* BP_ENABLE_MEMORY_USAGE */
+#ifdef BP_ENABLE_COMPRESSED_READS
+  features |= BP_BINARY_IO_FEATURE_COMPRESSED_READS;
+#endif /* BP_ENABLE_COMPRESSED_READS */
+#ifdef BP_ENABLE_BENCHMARK
+  features |= BP_BINARY_IO_FEATURE_BENCHMARK;
+#endif /* BP_ENABLE_BENCHMARK */
+
+#ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
+  features |= BP_BINARY_IO_FEATURE_SPI_AVR_EXTENDED;
+#endif /* BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS */
+#ifdef BP_SPI_ENABLE_FLASH_ENGINE
+  features |= BP_BINARY_IO_FEATURE_SPI_FLASH_ENGINE |
+              BP_BINARY_IO_FEATURE_SPI_FLASH_GANG;
+#endif /* BP_SPI_ENABLE_FLASH_ENGINE */
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+  features |= BP_BINARY_IO_FEATURE_SPI_SNIFFER;
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
+#ifdef BP_I2C_USE_HW_BUS
+  features |= BP_BINARY_IO_FEATURE_I2C_HARDWARE;
+#endif /* BP_I2C_USE_HW_BUS */
+#ifdef BP_I2C_ENABLE_INTERRUPT_SNIFFER
+  features |= BP_BINARY_IO_FEATURE_I2C_SNIFFER;
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER */
+
+  /* The total length goes in front once known. */
+  output = description + 2;
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_BOARD,
+#ifdef BUSPIRATEV4
+                          (4UL << 16) |
+#else
+                          (3UL << 16) |
+#endif /* BUSPIRATEV4 */
+                              (BP_FIRMWARE_VERSION_MAJOR << 8) |
+                              BP_FIRMWARE_VERSION_MINOR,
+                          3);
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_CAPABILITIES,
+                          binary_io_capabilities(), 2);
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_FEATURES, features, 2);
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_TERMINAL_BUFFER,
+                          BP_TERMINAL_BUFFER_SIZE, 2);
+#ifdef BP_JTAG_OPENOCD_SUPPORT
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_OPENOCD_BITS,
+                          BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT, 2);
+#endif /* BP_JTAG_OPENOCD_SUPPORT */
+#ifdef BP_ENABLE_SUMP_SUPPORT
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_SUMP_MEMORY,
+                          BP_SUMP_SAMPLE_MEMORY_SIZE, 2);
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_SUMP_RATE,
+                          BP_SUMP_MAXIMUM_SAMPLE_RATE, 4);
+#endif /* BP_ENABLE_SUMP_SUPPORT */
+#ifdef BUSPIRATEV4
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_USB_PACKET,
+                          CDC_BUFFER_SIZE, 2);
+#else
+  output = describe_entry(output, BP_BINARY_IO_DESCRIBE_RECEIVE_BUFFER,
+                          BP_USER_SERIAL_RECEIVE_RING_SIZE, 2);
+#endif /* BUSPIRATEV4 */
+#ifdef BP_ENABLE_SPI_SUPPORT
+  output =
+      describe_entry(output, BP_BINARY_IO_DESCRIBE_SPI_CLOCK, 8000000UL, 4);
+#endif /* BP_ENABLE_SPI_SUPPORT */
+#ifdef BP_ENABLE_I2C_SUPPORT
+#ifdef BP_I2C_USE_HW_BUS
+  output =
+      describe_entry(output, BP_BINARY_IO_DESCRIBE_I2C_CLOCK, 1000000UL, 4);
+#else
+  output =
+      describe_entry(output, BP_BINARY_IO_DESCRIBE_I2C_CLOCK, 400000UL, 4);
+#endif /* BP_I2C_USE_HW_BUS */
+#endif /* BP_ENABLE_I2C_SUPPORT */
+
+  length = output - (description + 2);
+  description[0] = length >> 8;
+  description[1] = length & 0xFF;
+  user_serial_write_buffer(description, length + 2);
+}
+
 void reset_state(void) {
-  bp_disable_3v3_pullup();
+  bp_frequency_monitor_stop();
+  bp_pwm_sequence_stop();
+  servo_controller_stop();
   bitbang_pin_direction_set(0xFF);
-  bitbang_pin_state_set(0x00);
+  if (!io_state.keep_mode_settings) {
+    bp_disable_3v3_pullup();
+    bitbang_pin_state_set(0x00);
+  }
+#ifdef BP_ENABLE_UART_SUPPORT
+  uart_terminal_receive_stop();
+#endif /* BP_ENABLE_UART_SUPPORT */
+  bp_buffer_arena_release_all();
+}
+
+void handle_keep_mode_settings(void) {
+  uint8_t flags = user_serial_read_byte();
+
+  if (flags & ~KEEP_MODE_SETTINGS_ON) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  io_state.keep_mode_settings = (flags & KEEP_MODE_SETTINGS_ON) ? ON : OFF;
+  REPORT_IO_SUCCESS();
 }
 
 uint8_t bitbang_pin_direction_set(const uint8_t direction_mask) {
@@ -575,17 +1489,151 @@ void binary_io_self_test(const bool jumper_test) {
       }
     }
 
-    if (errors == 0) {
-      if (tick == 0) {
-        tick = 0xFFFF;
-        bp_toggle_mode_led();
-      }
+    if (errors == 0) {
+      if (tick == 0) {
+        tick = 0xFFFF;
+        bp_toggle_mode_led();
+      }
+
+      tick--;
+    }
+  }
+}
+
+void binary_io_self_test_report(void) {
+  const selftest_report_t *report;
+  uint8_t options = user_serial_read_byte();
+
+  if (options & ~SELF_TEST_REPORT_JUMPERS) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  perform_selftest(false, options & SELF_TEST_REPORT_JUMPERS);
+  report = selftest_last_report();
+  bp_set_mode_led_state(report->failed != 0);
+
+  REPORT_IO_SUCCESS();
+  user_serial_transmit_character(report->performed >> 24);
+  user_serial_transmit_character(report->performed >> 16);
+  user_serial_transmit_character(report->performed >> 8);
+  user_serial_transmit_character(report->performed);
+  user_serial_transmit_character(report->failed >> 24);
+  user_serial_transmit_character(report->failed >> 16);
+  user_serial_transmit_character(report->failed >> 8);
+  user_serial_transmit_character(report->failed);
+}
+
+void binary_io_smps_status(void) {
+#if defined(BP_ENABLE_SMPS_SUPPORT)
+  REPORT_IO_SUCCESS();
+  smps_status();
+#else
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_SMPS_SUPPORT */
+}
+
+void handle_timebase(void) {
+  uint8_t operation = user_serial_read_byte();
+
+#ifdef BP_ENABLE_USB_TIMEBASE
+  bp_timestamp_t timestamp;
+  uint16_t count;
+
+  if (!bp_timebase_locked()) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  switch (operation) {
+  case TIMEBASE_READ:
+    bp_timebase_now(&timestamp);
+    REPORT_IO_SUCCESS();
+    send_timestamp(&timestamp);
+    count = bp_timebase_ticks_per_frame();
+    user_serial_transmit_character(HI8(count));
+    user_serial_transmit_character(LO8(count));
+    break;
+
+  case TIMEBASE_TRIGGER_OUT:
+    bp_timebase_trigger_in(false);
+    bp_timebase_trigger_out(&timestamp);
+    REPORT_IO_SUCCESS();
+    send_timestamp(&timestamp);
+    break;
+
+  case TIMEBASE_TRIGGER_IN_ARM:
+  case TIMEBASE_TRIGGER_IN_DISARM:
+    bp_timebase_trigger_in(operation == TIMEBASE_TRIGGER_IN_ARM);
+    REPORT_IO_SUCCESS();
+    break;
+
+  case TIMEBASE_TRIGGER_IN_READ:
+    timestamp.frame = 0;
+    timestamp.ticks = 0;
+    count = bp_timebase_last_trigger(&timestamp);
+    REPORT_IO_SUCCESS();
+    user_serial_transmit_character(HI8(count));
+    user_serial_transmit_character(LO8(count));
+    send_timestamp(&timestamp);
+    break;
+
+  default:
+    REPORT_IO_FAILURE();
+    break;
+  }
+#else
+  (void)operation;
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_USB_TIMEBASE */
+}
+
+void handle_flight_recorder(void) {
+  uint8_t flags = user_serial_read_byte();
+
+#ifdef BP_ENABLE_FLIGHT_RECORDER
+  if (flags & ~FLIGHT_RECORDER_CLEAR) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  bp_flight_recorder_send(flags & FLIGHT_RECORDER_CLEAR);
+#else
+  (void)flags;
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_FLIGHT_RECORDER */
+}
+
+void handle_memory_usage(void) {
+#ifdef BP_ENABLE_MEMORY_USAGE
+  REPORT_IO_SUCCESS();
+  bp_memory_usage_send();
+#else
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_MEMORY_USAGE */
+}
+
+void handle_benchmark(void) {
+#ifdef BP_ENABLE_BENCHMARK
+  REPORT_IO_SUCCESS();
+  bp_benchmark_send();
+  reset_state();
+#else
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_BENCHMARK */
+}
+
+#ifdef BP_ENABLE_USB_TIMEBASE
 
-      tick--;
-    }
-  }
+void send_timestamp(const bp_timestamp_t *timestamp) {
+  bp_binary_io_write_uint32(timestamp->frame);
+  user_serial_transmit_character(HI8(timestamp->ticks));
+  user_serial_transmit_character(LO8(timestamp->ticks));
 }
 
+#endif /* BP_ENABLE_USB_TIMEBASE */
+
 void bp_binary_io_peripherals_set(unsigned char inByte) {
   bp_set_voltage_regulator_state((inByte & 0b00001000) == 0b00001000);
   bp_set_pullup_state((inByte & 0b00000100) == 0b00000100);
@@ -607,6 +1655,89 @@ void bp_binary_io_peripherals_set(unsigned char inByte) {
   }
 }
 
+uint32_t bp_binary_io_read_uint32(void) {
+  uint32_t value;
+
+  value = user_serial_read_byte();
+  value = (value << 8) | user_serial_read_byte();
+  value = (value << 8) | user_serial_read_byte();
+  value = (value << 8) | user_serial_read_byte();
+
+  return value;
+}
+
+void bp_binary_io_send_telemetry(void) {
+  uint8_t flags = user_serial_read_byte();
+
+#ifdef BP_ENABLE_TELEMETRY
+  if (flags & ~BP_BINARY_IO_TELEMETRY_CLEAR) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  bp_telemetry_send(flags & BP_BINARY_IO_TELEMETRY_CLEAR);
+#else
+  (void)flags;
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_TELEMETRY */
+}
+
+void handle_link_speed(void) {
+  uint8_t speed = user_serial_read_byte();
+
+#ifdef BUSPIRATEV3
+  uint16_t previous;
+  uint16_t polls;
+  bool armed;
+
+  if (speed >= LINK_SPEED_COUNT) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  previous = U1BRG;
+  user_serial_set_baud_rate(LINK_SPEED_BRG[speed]);
+
+  /* Whatever garbage came in while the host switched over is skipped. */
+  armed = false;
+  for (polls = 0; polls < LINK_SPEED_CONFIRM_POLLS; polls++) {
+    uint8_t value;
+
+    if (!user_serial_ready_to_read()) {
+      bp_delay_us(LINK_SPEED_POLL_US);
+      continue;
+    }
+
+    value = user_serial_read_byte();
+    if (armed && (value == 0x55)) {
+      user_serial_clear_overflow();
+      REPORT_IO_SUCCESS();
+      return;
+    }
+    armed = value == 0xAA;
+  }
+
+  user_serial_set_baud_rate(previous);
+  user_serial_clear_overflow();
+  REPORT_IO_FAILURE();
+#else
+  (void)speed;
+  REPORT_IO_FAILURE();
+#endif /* BUSPIRATEV3 */
+}
+
+void bp_binary_io_write_uint32(const uint32_t value) {
+  uint8_t buffer[4];
+
+  buffer[0] = (value >> 24) & 0xFF;
+  buffer[1] = (value >> 16) & 0xFF;
+  buffer[2] = (value >> 8) & 0xFF;
+  buffer[3] = value & 0xFF;
+  user_serial_write_buffer(buffer, sizeof(buffer));
+}
+
 #if defined(BUSPIRATEV4)
 
 // checks if voltage is present on VUEXTERN
@@ -677,6 +1808,8 @@ void binary_io_raw_wire_mode_handler(void) {
   while (keep_looping) {
     uint8_t input_byte = user_serial_read_byte();
 
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_RAW_WIRE, input_byte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
     switch ((io_command_group)(input_byte >> 4)) {
     case IO_COMMAND_GROUP_GENERIC:
       keep_looping =
@@ -719,11 +1852,19 @@ void binary_io_raw_wire_mode_handler(void) {
       handle_smps_command((smps_command)input_byte);
       break;
 
+    case IO_COMMAND_GROUP_SMART_CARD:
+      handle_smart_card_command((smart_card_command)input_byte);
+      break;
+
     default:
       REPORT_IO_FAILURE();
       break;
     }
   }
+
+#ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
+  iso7816_deactivate();
+#endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
 }
 
 void send_bits(const uint8_t value, const size_t count) {
@@ -806,6 +1947,146 @@ void pic424_write(const uint8_t *payload, const size_t nops) {
   }
 }
 
+void pic24_send_six_opcode(const uint32_t opcode, const size_t nops) {
+  uint8_t payload[3];
+
+  payload[0] = bp_reverse_byte(opcode & 0xFF);
+  payload[1] = bp_reverse_byte((opcode >> 8) & 0xFF);
+  payload[2] = bp_reverse_byte((opcode >> 16) & 0xFF);
+  pic424_write(payload, nops);
+}
+
+uint16_t pic24_read_visi(void) {
+  uint8_t low;
+
+  /* Send REGOUT command. */
+  bitbang_write_bit(HIGH);
+  bitbang_write_bit(LOW);
+  bitbang_write_bit(LOW);
+  bitbang_write_bit(LOW);
+
+  bitbang_write_value(0x00);
+
+  /* VISI comes out LSB first. */
+  low = bp_reverse_byte(bitbang_read_value());
+  return (bp_reverse_byte(bitbang_read_value()) << 8) | low;
+}
+
+bool pic24_program_row(void) {
+  uint8_t *row = bus_pirate_configuration.terminal_input;
+  uint32_t address;
+  size_t groups;
+  size_t length;
+  size_t offset;
+
+  address = (uint32_t)user_serial_read_byte() << 16;
+  address |= user_serial_read_byte() << 8;
+  address |= user_serial_read_byte();
+  groups = user_serial_read_byte();
+
+  length = groups * PIC24_ROW_GROUP_WORDS * PIC24_ROW_WORD_BYTES;
+  for (offset = 0; offset < length;) {
+    size_t available;
+    const uint8_t *data =
+        user_serial_borrow_input(length - offset, &available);
+
+    memcpy(&row[offset], data, available);
+    offset += available;
+  }
+
+  if (groups == 0) {
+    return false;
+  }
+
+  /* Exit the reset vector. */
+  pic24_send_six_opcode(PIC24_OPCODE_NOP, 0);
+  pic24_send_six_opcode(PIC24_OPCODE_GOTO_0x200, 1);
+
+  /* Arm a row write and point the table write latches at the row. */
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W(PIC24_NVMCON_ROW_WRITE, 10),
+                        0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_W10_NVMCON, 0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W((address >> 16) & 0xFF, 0),
+                        0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_W0_TBLPAG, 0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W(address & 0xFFFF, 7), 0);
+
+  /* Fill the latches four words at a time, packed in W0:W5. */
+  for (offset = 0; offset < length;
+       offset += PIC24_ROW_GROUP_WORDS * PIC24_ROW_WORD_BYTES) {
+    const uint8_t *words = &row[offset];
+
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[0] | (words[1] << 8), 0), 0);
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[2] | (words[5] << 8), 1), 0);
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[3] | (words[4] << 8), 2), 0);
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[6] | (words[7] << 8), 3), 0);
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[8] | (words[11] << 8), 4), 0);
+    pic24_send_six_opcode(
+        PIC24_OPCODE_MOV_LITERAL_W(words[9] | (words[10] << 8), 5), 0);
+
+    pic24_send_six_opcode(PIC24_OPCODE_CLR_W6, 1);
+    for (size_t pair = 0; pair < 2; pair++) {
+      pic24_send_six_opcode(PIC24_OPCODE_TBLWTL_W6P_W7, 2);
+      pic24_send_six_opcode(PIC24_OPCODE_TBLWTHB_W6P_W7P, 2);
+      pic24_send_six_opcode(PIC24_OPCODE_TBLWTHB_W6P_PW7, 2);
+      pic24_send_six_opcode(PIC24_OPCODE_TBLWTL_W6P_W7P, 2);
+    }
+  }
+
+  /* Start the write and wait for WR to clear. */
+  pic24_send_six_opcode(PIC24_OPCODE_BSET_NVMCON_WR, 2);
+  for (size_t polls = 0;; polls++) {
+    if (polls == PIC24_ROW_WRITE_POLLS) {
+      return false;
+    }
+
+    pic24_send_six_opcode(PIC24_OPCODE_GOTO_0x200, 1);
+    pic24_send_six_opcode(PIC24_OPCODE_MOV_NVMCON_W2, 0);
+    pic24_send_six_opcode(PIC24_OPCODE_MOV_W2_VISI, 1);
+    uint16_t nvmcon = pic24_read_visi();
+    pic24_send_nop_opcode();
+    if ((nvmcon & PIC24_NVMCON_WR) == 0) {
+      break;
+    }
+  }
+
+  /* Read the row back through VISI and compare. */
+  pic24_send_six_opcode(PIC24_OPCODE_GOTO_0x200, 1);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W((address >> 16) & 0xFF, 0),
+                        0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_W0_TBLPAG, 0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W(address & 0xFFFF, 6), 0);
+  pic24_send_six_opcode(PIC24_OPCODE_MOV_LITERAL_W(PIC24_VISI_ADDRESS, 7), 1);
+
+  for (offset = 0; offset < length; offset += PIC24_ROW_WORD_BYTES) {
+    uint16_t low;
+    uint16_t upper;
+
+    /* Byte reads only step W6 by one, so the word read moves it along. */
+    pic24_send_six_opcode(PIC24_OPCODE_TBLRDHB_W6_W7, 2);
+    upper = pic24_read_visi();
+    pic24_send_nop_opcode();
+    pic24_send_six_opcode(PIC24_OPCODE_TBLRDL_W6P_W7, 2);
+    low = pic24_read_visi();
+    pic24_send_nop_opcode();
+
+    /* Keep the PC away from the end of the executive/test area. */
+    pic24_send_six_opcode(PIC24_OPCODE_GOTO_0x200, 1);
+
+    if ((low != (row[offset] | (row[offset + 1] << 8))) ||
+        ((upper & 0xFF) != row[offset + 2])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void pic424_read(void) {
   /* Send REGOUT command. */
   bitbang_write_bit(HIGH);
@@ -858,10 +2139,7 @@ bool handle_wire_generic_command(const wire_generic_command command) {
     uint16_t value = (io_state.wires == BINARY_IO_2_WIRES)
                          ? bitbang_read_value()
                          : bitbang_read_with_write(0xFF);
-    if (mode_configuration.little_endian == YES) {
-      value = bp_reverse_integer(value, mode_configuration.numbits);
-    }
-    user_serial_transmit_character(value & 0xFF);
+    user_serial_transmit_character(reverse_bus_value(value) & 0xFF);
     break;
   }
 
@@ -898,6 +2176,14 @@ bool handle_wire_generic_command(const wire_generic_command command) {
     REPORT_IO_SUCCESS();
     break;
 
+  case IO_COMMAND_BULK_TRANSFER:
+    handle_bulk_transfer();
+    break;
+
+  case IO_COMMAND_TELEMETRY:
+    bp_binary_io_send_telemetry();
+    break;
+
   default:
     REPORT_IO_FAILURE();
     break;
@@ -906,27 +2192,74 @@ bool handle_wire_generic_command(const wire_generic_command command) {
   return true;
 }
 
+uint16_t reverse_bus_value(const uint16_t value) {
+  if (mode_configuration.little_endian != YES) {
+    return value;
+  }
+
+  return (mode_configuration.numbits == 8)
+             ? bp_reverse_byte(value)
+             : bp_reverse_integer(value, mode_configuration.numbits);
+}
+
 void handle_bulk_byte_transfer(const uint8_t command) {
   size_t bytes = (command & 0x0F) + 1;
   REPORT_IO_SUCCESS();
 
   for (size_t counter = 0; counter < bytes; counter++) {
-    uint16_t value = user_serial_read_byte();
-    if (mode_configuration.little_endian == YES) {
-      value = bp_reverse_integer(value, mode_configuration.numbits);
-    }
+    uint16_t value = reverse_bus_value(user_serial_read_byte());
 
     if (io_state.wires == BINARY_IO_2_WIRES) {
       bitbang_write_value(value & 0xFF);
       REPORT_IO_SUCCESS();
     } else {
-      value = bitbang_read_with_write(value & 0xFF);
-      if (mode_configuration.little_endian == YES) {
-        value = bp_reverse_integer(value, mode_configuration.numbits);
-      }
-      bitbang_write_value(value & 0xFF);
+      value = reverse_bus_value(bitbang_read_with_write(value & 0xFF));
+      user_serial_transmit_character(value & 0xFF);
+    }
+  }
+}
+
+void handle_bulk_transfer(void) {
+  uint8_t *buffer = bus_pirate_configuration.terminal_input;
+  size_t length;
+  size_t offset;
+
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+  if ((length == 0) || (length > BP_TERMINAL_BUFFER_SIZE)) {
+    /* Skip the payload so the next command is parsed correctly. */
+    while (length-- > 0) {
+      user_serial_read_byte();
+    }
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  for (offset = 0; offset < length;) {
+    size_t available;
+    const uint8_t *data =
+        user_serial_borrow_input(length - offset, &available);
+
+    memcpy(&buffer[offset], data, available);
+    offset += available;
+  }
+
+  if (io_state.wires == BINARY_IO_2_WIRES) {
+    for (offset = 0; offset < length; offset++) {
+      bitbang_write_value(reverse_bus_value(buffer[offset]) & 0xFF);
     }
+    REPORT_IO_SUCCESS();
+    return;
+  }
+
+  for (offset = 0; offset < length; offset++) {
+    buffer[offset] =
+        reverse_bus_value(
+            bitbang_read_with_write(reverse_bus_value(buffer[offset]) & 0xFF)) &
+        0xFF;
   }
+  REPORT_IO_SUCCESS();
+  user_serial_write_buffer(buffer, length);
 }
 
 void handle_bulk_clock_ticks_advance(const uint8_t command) {
@@ -1006,6 +2339,10 @@ void handle_pic_command(const pic_command command) {
     handle_pic_command_write_and_read_commands();
     break;
 
+  case PIC_COMMAND_STREAM:
+    handle_pic_command_stream();
+    break;
+
   default:
     REPORT_IO_FAILURE();
     break;
@@ -1175,6 +2512,54 @@ void handle_pic_command_write_and_read_commands(void) {
   }
 }
 
+void handle_pic_command_stream(void) {
+  if (io_state.pic_mode != PIC_MODE_424) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  REPORT_IO_SUCCESS();
+
+  for (;;) {
+    switch ((pic_stream_operation)user_serial_read_byte()) {
+    case PIC_STREAM_END:
+      REPORT_IO_SUCCESS();
+      return;
+
+    case PIC_STREAM_SIX: {
+      uint32_t opcode;
+
+      opcode = (uint32_t)user_serial_read_byte() << 16;
+      opcode |= user_serial_read_byte() << 8;
+      opcode |= user_serial_read_byte();
+      pic24_send_six_opcode(opcode, user_serial_read_byte());
+      break;
+    }
+
+    case PIC_STREAM_REGOUT: {
+      uint16_t value = pic24_read_visi();
+
+      user_serial_transmit_character(value >> 8);
+      user_serial_transmit_character(value & 0xFF);
+      pic24_send_nop_opcode();
+      break;
+    }
+
+    case PIC_STREAM_PROGRAM_ROW:
+      if (pic24_program_row()) {
+        REPORT_IO_SUCCESS();
+      } else {
+        REPORT_IO_FAILURE();
+      }
+      break;
+
+    default:
+      /* The rest of the stream cannot be parsed anymore. */
+      REPORT_IO_FAILURE();
+      return;
+    }
+  }
+}
+
 void handle_smps_command(const smps_command command) {
 #if defined(BP_ENABLE_SMPS_SUPPORT)
   switch (command) {
@@ -1206,7 +2591,81 @@ void handle_smps_command(const smps_command command) {
 #endif /* BP_ENABLE_SMPS_SUPPORT */
 }
 
+void handle_smart_card_command(const smart_card_command command) {
+#ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
+  switch (command) {
+  case SMART_CARD_COMMAND_ACTIVATE: {
+    uint8_t atr[ISO7816_ATR_MAXIMUM_LENGTH];
+    size_t length;
+    iso7816_result_t result = iso7816_activate(atr, &length);
+
+    if (result != ISO7816_OK) {
+      REPORT_IO_FAILURE();
+      user_serial_transmit_character(result);
+      break;
+    }
+    REPORT_IO_SUCCESS();
+    user_serial_transmit_character(length);
+    bp_write_buffer(atr, length);
+    break;
+  }
+
+  case SMART_CARD_COMMAND_EXCHANGE: {
+    uint8_t *apdu = bus_pirate_configuration.terminal_input;
+    uint8_t *response = apdu + ISO7816_COMMAND_MAXIMUM_LENGTH;
+    size_t length;
+    size_t response_length;
+    size_t index;
+    iso7816_result_t result;
+
+    length = user_serial_read_byte() << 8;
+    length |= user_serial_read_byte();
+    for (index = 0; index < length; index++) {
+      uint8_t value = user_serial_read_byte();
+
+      /* Oversized commands are drained, then refused. */
+      if (index < ISO7816_COMMAND_MAXIMUM_LENGTH) {
+        apdu[index] = value;
+      }
+    }
+
+    result = (length > ISO7816_COMMAND_MAXIMUM_LENGTH)
+                 ? ISO7816_INVALID_COMMAND
+                 : iso7816_t0_exchange(apdu, length, response,
+                                       ISO7816_RESPONSE_MAXIMUM_LENGTH,
+                                       &response_length);
+    if (result != ISO7816_OK) {
+      REPORT_IO_FAILURE();
+      user_serial_transmit_character(result);
+      break;
+    }
+    REPORT_IO_SUCCESS();
+    user_serial_transmit_character(response_length >> 8);
+    user_serial_transmit_character(response_length & 0xFF);
+    bp_write_buffer(response, response_length);
+    break;
+  }
+
+  case SMART_CARD_COMMAND_DEACTIVATE:
+    iso7816_deactivate();
+    REPORT_IO_SUCCESS();
+    break;
+
+  default:
+    REPORT_IO_FAILURE();
+    break;
+  }
+#else
+  (void)command;
+  REPORT_IO_FAILURE();
+#endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
+}
+
 void handle_clear_pwm(void) {
+  /* The monitor and sequence timers are stopped below as well. */
+  bp_frequency_monitor_stop();
+  bp_pwm_sequence_stop();
+
   /*
    * T2CON - TIMER 2 CONTROL REGISTER
    *
@@ -1283,16 +2742,212 @@ void handle_read_adc_continuously(void) {
   bp_disable_adc();
 }
 
+void handle_adc_stream(const bool scan) {
+  uint16_t period;
+
+  period = user_serial_read_byte() << 8;
+  period |= user_serial_read_byte();
+
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+  if ((period >= ADC_STREAM_MINIMUM_PERIOD) &&
+      (period <= ADC_STREAM_MAXIMUM_PERIOD)) {
+    adc_stream_run(period, scan);
+    return;
+  }
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+
+  REPORT_IO_FAILURE();
+}
+
+void handle_adc_decimate(void) {
+  uint16_t period;
+  uint8_t shift;
+  uint8_t flags;
+
+  period = user_serial_read_byte() << 8;
+  period |= user_serial_read_byte();
+  shift = user_serial_read_byte();
+  flags = user_serial_read_byte();
+
+#ifdef BP_ENABLE_ADC_STREAM_SUPPORT
+  if ((period >= ADC_STREAM_MINIMUM_PERIOD) &&
+      (period <= ADC_STREAM_MAXIMUM_PERIOD) &&
+      (shift >= ADC_DECIMATE_MINIMUM_SHIFT) &&
+      (shift <= ADC_DECIMATE_MAXIMUM_SHIFT) &&
+      ((flags & ~ADC_DECIMATE_SCAN) == 0)) {
+    adc_stream_decimate(period, flags & ADC_DECIMATE_SCAN, shift);
+    return;
+  }
+#else
+  (void)shift;
+  (void)flags;
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT */
+
+  REPORT_IO_FAILURE();
+}
+
 void handle_frequency_measurement(void) {
-  uint32_t frequency = bp_measure_frequency();
+  bp_binary_io_write_uint32(bp_measure_frequency());
+}
+
+void handle_period_measurement(const bool stream) {
+  uint16_t periods;
+
+  periods = user_serial_read_byte() << 8;
+  periods |= user_serial_read_byte();
+
+  if (periods == 0) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  if (stream) {
+    bp_stream_periods(periods);
+  } else {
+    bp_binary_io_write_uint32(bp_measure_periods(periods));
+  }
+}
+
+void handle_pwm_sequence(void) {
+  bp_pwm_sequence_t sequence;
+  uint8_t index;
+  uint8_t steps;
+
+  sequence.prescaler = user_serial_read_byte();
+  sequence.period = user_serial_read_byte() << 8;
+  sequence.period |= user_serial_read_byte();
+  sequence.step_periods = user_serial_read_byte() << 8;
+  sequence.step_periods |= user_serial_read_byte();
+  sequence.mode = (pwm_sequence_mode_t)user_serial_read_byte();
+  sequence.bursts = user_serial_read_byte() << 8;
+  sequence.bursts |= user_serial_read_byte();
+  sequence.steps = user_serial_read_byte();
+
+  /* Consume the whole table even if it does not fit, to stay in sync. */
+  steps = sequence.steps;
+  for (index = 0; index < steps; index++) {
+    uint16_t duty_cycle = user_serial_read_byte() << 8;
+    duty_cycle |= user_serial_read_byte();
+    if (index < PWM_SEQUENCE_MAXIMUM_STEPS) {
+      sequence.duty_cycles[index] = duty_cycle;
+    }
+  }
+
+  if (bp_pwm_sequence_start(&sequence)) {
+    REPORT_IO_SUCCESS();
+  } else {
+    REPORT_IO_FAILURE();
+  }
+}
+
+void handle_pattern_generator(void) {
+  uint8_t *buffer = bus_pirate_configuration.terminal_input;
+  uint8_t *capture;
+  uint16_t period;
+  uint16_t repeats;
+  size_t length;
+  size_t offset;
+  uint8_t flags;
+
+  flags = user_serial_read_byte();
+  period = user_serial_read_byte() << 8;
+  period |= user_serial_read_byte();
+  repeats = user_serial_read_byte() << 8;
+  repeats |= user_serial_read_byte();
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+
+  capture = (flags & PATTERN_FLAG_CAPTURE)
+                ? &buffer[BP_TERMINAL_BUFFER_SIZE / 2]
+                : NULL;
+  if ((length == 0) ||
+      (length > ((capture != NULL) ? (BP_TERMINAL_BUFFER_SIZE / 2)
+                                   : BP_TERMINAL_BUFFER_SIZE)) ||
+      (period < PATTERN_GENERATOR_MINIMUM_PERIOD)) {
+    /* Skip the payload so the next command is parsed correctly. */
+    while (length-- > 0) {
+      user_serial_read_byte();
+    }
+    REPORT_IO_FAILURE();
+    return;
+  }
 
-  user_serial_transmit_character((frequency >> 24) & 0xFF);
-  user_serial_transmit_character((frequency >> 16) & 0xFF);
-  user_serial_transmit_character((frequency >> 8) & 0xFF);
-  user_serial_transmit_character(frequency & 0xFF);
+  for (offset = 0; offset < length;) {
+    size_t available;
+    const uint8_t *data =
+        user_serial_borrow_input(length - offset, &available);
+
+    memcpy(&buffer[offset], data, available);
+    offset += available;
+  }
+
+  /* Both drive the same pins. */
+  servo_controller_stop();
+  pattern_generator_run(buffer, capture, length, period, repeats);
+
+  REPORT_IO_SUCCESS();
+  if (capture != NULL) {
+    user_serial_write_buffer(capture, length);
+  }
+}
+
+void handle_servos(void) {
+  uint16_t widths[SERVO_CHANNELS];
+  uint8_t index;
+
+  for (index = 0; index < SERVO_CHANNELS; index++) {
+    widths[index] = user_serial_read_byte() << 8;
+    widths[index] |= user_serial_read_byte();
+  }
+
+  if (servo_controller_update(widths)) {
+    REPORT_IO_SUCCESS();
+  } else {
+    REPORT_IO_FAILURE();
+  }
+}
+
+void handle_frequency_monitor(void) {
+  bp_frequency_statistics_t statistics;
+  uint8_t operation;
+
+  operation = user_serial_read_byte();
+  switch (operation) {
+  case FREQUENCY_MONITOR_STOP:
+    bp_frequency_monitor_stop();
+    REPORT_IO_SUCCESS();
+    break;
+
+  case FREQUENCY_MONITOR_START:
+    bp_frequency_monitor_start();
+    REPORT_IO_SUCCESS();
+    break;
+
+  case FREQUENCY_MONITOR_READ:
+  case FREQUENCY_MONITOR_READ_AND_RESET:
+    bp_frequency_monitor_read(&statistics,
+                              operation == FREQUENCY_MONITOR_READ_AND_RESET);
+    REPORT_IO_SUCCESS();
+    bp_binary_io_write_uint32(statistics.periods);
+    bp_binary_io_write_uint32(statistics.overruns);
+    bp_binary_io_write_uint32(statistics.last);
+    bp_binary_io_write_uint32(statistics.minimum);
+    bp_binary_io_write_uint32(statistics.maximum);
+    bp_binary_io_write_uint32(statistics.mean);
+    break;
+
+  default:
+    REPORT_IO_FAILURE();
+    break;
+  }
 }
 
 void handle_setup_pwm(void) {
+  /* The PWM generator takes over the AUX pin and the monitor timers. */
+  bp_frequency_monitor_stop();
+  bp_pwm_sequence_stop();
+
   /*
    * T2CON - TIMER 2 CONTROL REGISTER
    *
@@ -18,8 +18,11 @@
 #ifndef BP_BINARY_IO_H
 #define BP_BINARY_IO_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "flight_recorder.h"
+
 /**
  * Result code indicating a successful binary I/O operation.
  */
@@ -37,6 +40,7 @@
  */
 #define REPORT_IO_SUCCESS()                                                    \
   do {                                                                         \
+    BP_FLIGHT_RECORDER_STATUS(BP_BINARY_IO_RESULT_SUCCESS);                    \
     user_serial_transmit_character(BP_BINARY_IO_RESULT_SUCCESS);               \
   } while (0)
 
@@ -47,10 +51,112 @@
  */
 #define REPORT_IO_FAILURE()                                                    \
   do {                                                                         \
+    BP_FLIGHT_RECORDER_STATUS(BP_BINARY_IO_RESULT_FAILURE);                    \
     user_serial_transmit_character(BP_BINARY_IO_RESULT_FAILURE);               \
   } while (0)
 
-void enter_binary_bitbang_mode(void);
+/**
+ * Bytes that, right after a NUL, switch the terminal to binary mode at once
+ * rather than after twenty NULs.
+ *
+ * Binary mode takes them as two unknown commands, answered with a failure
+ * code each, and the identify command.  The terminal answers the same way,
+ * so a host sending NUL and these gets "BBIO1", 0x00, 0x00 and the identity
+ * block whether the Bus Pirate was in the terminal or already in binary mode.
+ */
+#define BP_BINARY_IO_MAGIC "\x0B\x0C\x20"
+
+/**
+ * Capability flags returned with the binary I/O identity, MSB first.
+ */
+#define BP_BINARY_IO_CAPABILITY_SPI 0x0001
+#define BP_BINARY_IO_CAPABILITY_I2C 0x0002
+#define BP_BINARY_IO_CAPABILITY_UART 0x0004
+#define BP_BINARY_IO_CAPABILITY_1WIRE 0x0008
+#define BP_BINARY_IO_CAPABILITY_OPENOCD 0x0010
+#define BP_BINARY_IO_CAPABILITY_PIC 0x0020
+#define BP_BINARY_IO_CAPABILITY_SWD 0x0040
+#define BP_BINARY_IO_CAPABILITY_XSVF 0x0080
+#define BP_BINARY_IO_CAPABILITY_ADC_STREAM 0x0100
+#define BP_BINARY_IO_CAPABILITY_SMPS 0x0200
+#define BP_BINARY_IO_CAPABILITY_SUMP 0x0400
+#define BP_BINARY_IO_CAPABILITY_VENDOR_PIPE 0x0800
+#define BP_BINARY_IO_CAPABILITY_PROFILING 0x1000
+#define BP_BINARY_IO_CAPABILITY_USB_TIMEBASE 0x2000
+#define BP_BINARY_IO_CAPABILITY_FLIGHT_RECORDER 0x4000
+#define BP_BINARY_IO_CAPABILITY_TELEMETRY 0x8000
+
+/**
+ * Optional fast paths, as returned with BP_BINARY_IO_DESCRIBE_FEATURES.
+ */
+#define BP_BINARY_IO_FEATURE_SPI_AVR_EXTENDED 0x0001
+#define BP_BINARY_IO_FEATURE_SPI_FLASH_ENGINE 0x0002
+#define BP_BINARY_IO_FEATURE_SPI_SNIFFER 0x0004
+#define BP_BINARY_IO_FEATURE_I2C_HARDWARE 0x0008
+#define BP_BINARY_IO_FEATURE_I2C_SNIFFER 0x0010
+#define BP_BINARY_IO_FEATURE_KEEP_MODE_SETTINGS 0x0020
+#define BP_BINARY_IO_FEATURE_LINK_SPEED 0x0040
+#define BP_BINARY_IO_FEATURE_ADC_DECIMATE 0x0080
+#define BP_BINARY_IO_FEATURE_I2C_SMBUS 0x0100
+#define BP_BINARY_IO_FEATURE_MEMORY_USAGE 0x0200
+#define BP_BINARY_IO_FEATURE_SPI_FLASH_GANG 0x0400
+#define BP_BINARY_IO_FEATURE_COMPRESSED_READS 0x0800
+#define BP_BINARY_IO_FEATURE_BENCHMARK 0x1000
+
+/**
+ * @name Describe command entries
+ *
+ * The describe command answers with a big endian 16 bits total length and
+ * then entries made of a type byte, a length byte and a big endian value.
+ * Hosts should skip the types they do not know, entries for features that are
+ * not built in are left out.
+ * @{
+ */
+
+/** Hardware version, firmware major and minor version, one byte each. */
+#define BP_BINARY_IO_DESCRIBE_BOARD 0x01
+
+/** BP_BINARY_IO_CAPABILITY_* flags, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_CAPABILITIES 0x02
+
+/** BP_BINARY_IO_FEATURE_* flags, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_FEATURES 0x03
+
+/**
+ * Largest write-then-read, bulk pattern or script payload, in bytes, 16 bits.
+ */
+#define BP_BINARY_IO_DESCRIBE_TERMINAL_BUFFER 0x10
+
+/** OpenOCD JTAG sequence limit, in bits, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_OPENOCD_BITS 0x11
+
+/** Logic analyser sample memory, in bytes, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_SUMP_MEMORY 0x12
+
+/** USB packet size, in bytes, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_USB_PACKET 0x13
+
+/** Serial input buffered while the firmware is busy, in bytes, 16 bits. */
+#define BP_BINARY_IO_DESCRIBE_RECEIVE_BUFFER 0x14
+
+/** Fastest SPI clock, in Hz, 32 bits. */
+#define BP_BINARY_IO_DESCRIBE_SPI_CLOCK 0x20
+
+/** Fastest I2C clock, in Hz, 32 bits. */
+#define BP_BINARY_IO_DESCRIBE_I2C_CLOCK 0x21
+
+/** Fastest logic analyser sample rate, in Hz, 32 bits. */
+#define BP_BINARY_IO_DESCRIBE_SUMP_RATE 0x22
+
+/** @} */
+
+/**
+ * Enters binary I/O mode, answering with the "BBIO1" identifier.
+ *
+ * @param[in] magic true if entered through BP_BINARY_IO_MAGIC, whose bytes
+ * are then answered as binary mode would have.
+ */
+void enter_binary_bitbang_mode(const bool magic);
 
 /**
  * Sets the direction of the various I/O pins.
@@ -108,6 +214,39 @@ uint8_t bitbang_pin_state_set(const uint8_t state_mask);
 
 void bp_binary_io_peripherals_set(uint8_t input_byte);
 
+/**
+ * Reads a big-endian 32-bits value from the binary I/O channel.
+ *
+ * Bytes are fetched one at a time in wire order, so the result does not depend
+ * on the evaluation order of the individual reads.
+ *
+ * @return the value read from the serial port.
+ */
+uint32_t bp_binary_io_read_uint32(void);
+
+/**
+ * Writes the given 32-bits value to the binary I/O channel, MSB first.
+ *
+ * @param[in] value the value to write.
+ */
+void bp_binary_io_write_uint32(const uint32_t value);
+
+/**
+ * Telemetry command flag, zero the counters once sent.
+ */
+#define BP_BINARY_IO_TELEMETRY_CLEAR 0x01
+
+/**
+ * Handles the telemetry command, which every binary mode takes under its own
+ * command byte so the counters can be read without leaving it.
+ *
+ * Reads a flags byte, BP_BINARY_IO_TELEMETRY_CLEAR or 0, and answers with
+ * 0x01 followed by the counter count and the bp_telemetry_counter_t counters,
+ * 32 bits each MSB first.  Unknown flags and builds without
+ * BP_ENABLE_TELEMETRY get 0x00.
+ */
+void bp_binary_io_send_telemetry(void);
+
 #ifdef BUSPIRATEV4
 bool bp_binary_io_pullup_control(uint8_t control_byte);
 #endif /* BUSPIRATEV4 */
@@ -23,6 +23,8 @@
 
 #include "bitbang.h"
 #include "base.h"
+#include "configuration.h"
+#include "profiling.h"
 
 /* Values are in microseconds. */
 
@@ -79,11 +81,184 @@ static uint16_t miso_pin;
  */
 static const bitbang_delays_t *delay_profile;
 
+/**
+ * How many microseconds to wait for a device to release CLK after it was set
+ * HIGH, or zero to disable clock stretching detection.
+ */
+static uint16_t clock_stretch_timeout = 0;
+
+/**
+ * Whether a device held CLK LOW for longer than the given timeout.
+ */
+static bool clock_stretch_timed_out = false;
+
+/**
+ * Sets the CLK pin HIGH, waits for any device stretching the clock to release
+ * it, then spins for the current delay profile's clock delay.
+ *
+ * Devices can only stretch the clock when the pins are in open collector mode,
+ * so no waiting is done otherwise.
+ */
+static void bitbang_release_clock(void);
+
+#ifdef BP_BITBANG_FAST_KERNELS
+
+/**
+ * Whether the current delay profile has no delays at all, as picked by
+ * bitbang_setup().  Only then the unrolled transfer kernels can be used.
+ */
+static bool fast_kernels_allowed = false;
+
+/**
+ * Checks whether the next transfer can go through the unrolled kernels.
+ *
+ * On top of the delay profile, this requires 8 bits words in MSB first order
+ * (LSB first values are reversed by the callers before reaching here) and no
+ * clock stretching detection, as those need the generic per bit path.
+ *
+ * @return true if bitbang_fast_*() can be used, false otherwise.
+ */
+static inline bool bitbang_use_fast_kernels(void);
+
+/* Pin state primitives for the two output stages. */
+
+#define BITBANG_FAST_HIGH_NORMAL(pins) IOLAT |= (pins)
+#define BITBANG_FAST_LOW_NORMAL(pins) IOLAT &= ~(pins)
+#define BITBANG_FAST_HIGH_OPEN_DRAIN(pins) IODIR |= (pins)
+#define BITBANG_FAST_LOW_OPEN_DRAIN(pins) IODIR &= ~(pins)
+
+/**
+ * Puts MOSI and CLK in a state where the BITBANG_FAST_* primitives above only
+ * need to touch one register: drivers on for normal outputs, latches low for
+ * open drain outputs.
+ */
+#define BITBANG_FAST_PREPARE_NORMAL() IODIR &= ~(MOSI | CLK)
+#define BITBANG_FAST_PREPARE_OPEN_DRAIN() IOLAT &= ~(MOSI | CLK)
+
+/**
+ * Clocks out one bit of the given value, MOSI is set before CLK goes HIGH.
+ */
+#define BITBANG_FAST_WRITE_BIT(stage, value, bit)                               \
+  do {                                                                         \
+    if ((value) & (1 << (bit))) {                                              \
+      BITBANG_FAST_HIGH_##stage(MOSI);                                         \
+    } else {                                                                   \
+      BITBANG_FAST_LOW_##stage(MOSI);                                          \
+    }                                                                          \
+    BITBANG_FAST_HIGH_##stage(CLK);                                            \
+    Nop();                                                                     \
+    BITBANG_FAST_LOW_##stage(CLK);                                             \
+  } while (0)
+
+/**
+ * Clocks out one bit of the given value and samples MISO while CLK is HIGH,
+ * after giving the input synchronizer time to catch up.
+ */
+#define BITBANG_FAST_TRANSFER_BIT(stage, value, input, bit)                     \
+  do {                                                                         \
+    if ((value) & (1 << (bit))) {                                              \
+      BITBANG_FAST_HIGH_##stage(MOSI);                                         \
+    } else {                                                                   \
+      BITBANG_FAST_LOW_##stage(MOSI);                                          \
+    }                                                                          \
+    BITBANG_FAST_HIGH_##stage(CLK);                                            \
+    Nop();                                                                     \
+    Nop();                                                                     \
+    if (IOPOR & MISO) {                                                        \
+      (input) |= 1 << (bit);                                                   \
+    }                                                                          \
+    BITBANG_FAST_LOW_##stage(CLK);                                             \
+  } while (0)
+
+/**
+ * Generates the unrolled 8 bits write and write/read kernels for one output
+ * stage.
+ */
+#define BITBANG_FAST_KERNELS(stage, suffix)                                     \
+  static void bitbang_fast_write_##suffix(const uint8_t value) {               \
+    BITBANG_FAST_PREPARE_##stage();                                            \
+    BITBANG_FAST_WRITE_BIT(stage, value, 7);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 6);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 5);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 4);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 3);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 2);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 1);                                   \
+    BITBANG_FAST_WRITE_BIT(stage, value, 0);                                   \
+  }                                                                            \
+                                                                               \
+  static uint8_t bitbang_fast_transfer_##suffix(const uint8_t value) {         \
+    uint8_t input = 0;                                                         \
+                                                                               \
+    BITBANG_FAST_PREPARE_##stage();                                            \
+    IODIR |= MISO;                                                             \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 7);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 6);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 5);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 4);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 3);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 2);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 1);                         \
+    BITBANG_FAST_TRANSFER_BIT(stage, value, input, 0);                         \
+    return input;                                                              \
+  }
+
+BITBANG_FAST_KERNELS(NORMAL, normal)
+BITBANG_FAST_KERNELS(OPEN_DRAIN, open_drain)
+
+bool bitbang_use_fast_kernels(void) {
+  return fast_kernels_allowed && (mode_configuration.numbits == 8) &&
+         !((clock_stretch_timeout > 0) &&
+           (mode_configuration.high_impedance == ON));
+}
+
+#endif /* BP_BITBANG_FAST_KERNELS */
+
+void bitbang_set_clock_stretch_timeout(const uint16_t timeout) {
+  clock_stretch_timeout = timeout;
+  clock_stretch_timed_out = false;
+}
+
+bool bitbang_clock_stretch_timed_out(void) {
+  bool timed_out;
+
+  timed_out = clock_stretch_timed_out;
+  clock_stretch_timed_out = false;
+  return timed_out;
+}
+
+void bitbang_release_clock(void) {
+  uint16_t remaining;
+
+  bitbang_set_pins_high(CLK, 0);
+
+  if ((clock_stretch_timeout > 0) &&
+      (mode_configuration.high_impedance == ON)) {
+    remaining = clock_stretch_timeout;
+    while ((IOPOR & CLK) == 0) {
+      if (remaining == 0) {
+        clock_stretch_timed_out = true;
+        break;
+      }
+      remaining--;
+      bp_delay_us(1);
+    }
+  }
+
+  if (delay_profile->clock > 0) {
+    bp_delay_us(delay_profile->clock);
+  }
+}
+
 void bitbang_setup(unsigned char bitbang_pins, const bp_bitbang_speed_t speed) {
   miso_pin = (bitbang_pins == 3) ? MISO : MOSI;
   delay_profile = &BITBANG_DELAYS[speed > DELAY_PROFILES_MAX_INDEX
                                       ? DELAY_PROFILES_MAX_INDEX
                                       : speed];
+#ifdef BP_BITBANG_FAST_KERNELS
+  fast_kernels_allowed =
+      (delay_profile->settle == 0) && (delay_profile->clock == 0);
+#endif /* BP_BITBANG_FAST_KERNELS */
 }
 
 bool bitbang_i2c_start(bp_bitbang_i2c_start_type_t type) {
@@ -96,7 +271,7 @@ bool bitbang_i2c_start(bp_bitbang_i2c_start_type_t type) {
     bitbang_set_pins_high(MOSI, delay_profile->clock);
 
     /* Set CLK high too. */
-    bitbang_set_pins_high(CLK, delay_profile->clock);
+    bitbang_release_clock();
   }
 
   /* Check whether lines are still high. */
@@ -121,7 +296,7 @@ void bitbang_i2c_stop(void) {
   bitbang_set_pins_low(MOSI + CLK, delay_profile->clock);
 
   /* Set CLK high. */
-  bitbang_set_pins_high(CLK, delay_profile->clock);
+  bitbang_release_clock();
 
   /* Set SDA high too. */
   bitbang_set_pins_high(MOSI, delay_profile->clock);
@@ -133,17 +308,30 @@ uint16_t bitbang_read_with_write(const uint16_t value) {
   uint16_t bit_index;
   uint16_t input;
 
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_BITBANG);
+
+#ifdef BP_BITBANG_FAST_KERNELS
+  if (bitbang_use_fast_kernels()) {
+    input = (mode_configuration.high_impedance == OFF)
+                ? bitbang_fast_transfer_normal(value)
+                : bitbang_fast_transfer_open_drain(value);
+    BP_PROFILING_EXIT(BP_PROFILING_REGION_BITBANG);
+    return input;
+  }
+#endif /* BP_BITBANG_FAST_KERNELS */
+
   bit_index = 1 << (mode_configuration.numbits - 1);
   temporary = value;
   input = 0;
   for (count = 0; count < mode_configuration.numbits; count++) {
     bitbang_set_pins(temporary & bit_index, MOSI, delay_profile->settle);
-    bitbang_set_pins_high(CLK, delay_profile->clock);
+    bitbang_release_clock();
     input = (input << 1) | bitbang_read_pin(MISO);
     temporary <<= 1;
     bitbang_set_pins_low(CLK, delay_profile->clock);
   }
 
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_BITBANG);
   return input;
 }
 
@@ -152,30 +340,49 @@ void bitbang_write_value(const uint16_t value) {
   uint16_t bit_index;
   size_t count;
 
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_BITBANG);
+
+#ifdef BP_BITBANG_FAST_KERNELS
+  if (bitbang_use_fast_kernels()) {
+    if (mode_configuration.high_impedance == OFF) {
+      bitbang_fast_write_normal(value);
+    } else {
+      bitbang_fast_write_open_drain(value);
+    }
+    BP_PROFILING_EXIT(BP_PROFILING_REGION_BITBANG);
+    return;
+  }
+#endif /* BP_BITBANG_FAST_KERNELS */
+
   bit_index = 1 << (mode_configuration.numbits - 1);
   temporary = value;
   for (count = 0; count < mode_configuration.numbits; count++) {
     bitbang_set_pins(temporary & bit_index, MOSI, delay_profile->settle);
-    bitbang_set_pins_high(CLK, delay_profile->clock);
+    bitbang_release_clock();
     bitbang_set_pins_low(CLK, delay_profile->clock);
     temporary <<= 1;
   }
+
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_BITBANG);
 }
 
 uint16_t bitbang_read_value(void) {
   size_t count;
   uint16_t value;
 
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_BITBANG);
+
   /* Setup for input. */
   bitbang_read_pin(MOSI);
   value = 0;
 
   for (count = 0; count < mode_configuration.numbits; count++) {
-    bitbang_set_pins_high(CLK, delay_profile->clock);
+    bitbang_release_clock();
     value = (value << 1) | bitbang_read_pin(MOSI);
     bitbang_set_pins_low(CLK, delay_profile->clock);
   }
 
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_BITBANG);
   return value;
 }
 
@@ -186,7 +393,7 @@ bool bitbang_read_bit(void) {
   bitbang_read_pin(miso_pin);
 
   /* Set CLK high. */
-  bitbang_set_pins_high(CLK, delay_profile->clock);
+  bitbang_release_clock();
 
   /* Read value. */
   bit_value = bitbang_read_pin(miso_pin);
@@ -202,7 +409,7 @@ void bitbang_write_bit(const bool state) {
   bitbang_set_pins(state, MOSI, delay_profile->settle);
 
   /* Clock the bit out. */
-  bitbang_set_pins_high(CLK, delay_profile->clock);
+  bitbang_release_clock();
   bitbang_set_pins_low(CLK, delay_profile->clock);
 }
 
@@ -210,7 +417,7 @@ void bitbang_advance_clock_ticks(const uint16_t ticks) {
   size_t tick;
 
   for (tick = 0; tick < ticks; tick++) {
-    bitbang_set_pins_high(CLK, delay_profile->clock);
+    bitbang_release_clock();
     bitbang_set_pins_low(CLK, delay_profile->clock);
   }
 }
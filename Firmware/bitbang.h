@@ -78,6 +78,30 @@ typedef enum {
  */
 void bitbang_setup(unsigned char pins, const bp_bitbang_speed_t speed);
 
+/**
+ * Sets how long to wait for devices stretching the clock.
+ *
+ * Whenever the CLK pin is set HIGH in open collector mode, the pin is read back
+ * until it actually goes HIGH or the timeout expires.  The timeout stays set
+ * across bitbang_setup calls, and also clears any pending timeout condition.
+ *
+ * @param[in] timeout how many microseconds to wait, or zero to disable clock
+ * stretching detection.
+ *
+ * @see bitbang_clock_stretch_timed_out
+ */
+void bitbang_set_clock_stretch_timeout(const uint16_t timeout);
+
+/**
+ * Reports whether a device held CLK LOW for longer than the timeout since the
+ * last call, and clears the condition.
+ *
+ * @return true if the clock stretching timeout expired, false otherwise.
+ *
+ * @see bitbang_set_clock_stretch_timeout
+ */
+bool bitbang_clock_stretch_timed_out(void);
+
 /**
  * Writes a value to the bus then reads a value back, used by 3-wire protocols.
  *
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate. This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+
+#include "buffer_arena.h"
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+#include <stdbool.h>
+
+#include "core.h"
+#endif /* BP_ENABLE_MEMORY_USAGE */
+
+#if (BP_TERMINAL_BUFFER_SIZE % BP_BUFFER_ARENA_BLOCK_SIZE) != 0
+#error "BP_TERMINAL_BUFFER_SIZE must be a multiple of the arena block size"
+#endif
+
+#if (BP_TERMINAL_BUFFER_SIZE & (BP_TERMINAL_BUFFER_SIZE - 1)) != 0
+#error "BP_TERMINAL_BUFFER_SIZE must be a power of two"
+#endif
+
+#if BP_BUFFER_ARENA_BLOCKS > 255
+#error "The arena cannot have more than 255 blocks"
+#endif
+
+uint8_t bp_buffer_arena_memory[BP_TERMINAL_BUFFER_SIZE]
+    __attribute__((section(".bss.end"), aligned(2)));
+
+/**
+ * Per block bookkeeping: the first block of a reservation holds how many
+ * blocks it is made of, the others BUFFER_ARENA_CONTINUED, free blocks 0.
+ */
+static uint8_t buffer_arena_blocks[BP_BUFFER_ARENA_BLOCKS];
+
+/**
+ * Marker for non-leading blocks of a reservation.
+ */
+#define BUFFER_ARENA_CONTINUED 0xFF
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+
+extern bus_pirate_configuration_t bus_pirate_configuration;
+
+/**
+ * Blocks reserved right now.
+ */
+static size_t buffer_arena_reserved_blocks = 0;
+
+/**
+ * Most blocks ever reserved at once, for each bus mode.
+ */
+static uint8_t buffer_arena_peak_blocks[ENABLED_PROTOCOLS_COUNT] = {0};
+
+#endif /* BP_ENABLE_MEMORY_USAGE */
+
+uint8_t *bp_buffer_arena_reserve(const size_t size) {
+  size_t needed;
+  size_t start;
+  size_t run;
+  size_t index;
+
+  needed = (size + BP_BUFFER_ARENA_BLOCK_SIZE - 1) / BP_BUFFER_ARENA_BLOCK_SIZE;
+  if ((needed == 0) || (needed > BP_BUFFER_ARENA_BLOCKS)) {
+    return NULL;
+  }
+
+  /* First fit, reservations are few and short lived. */
+  run = 0;
+  for (index = 0; index < BP_BUFFER_ARENA_BLOCKS; index++) {
+    if (buffer_arena_blocks[index] != 0) {
+      run = 0;
+      continue;
+    }
+
+    if (++run < needed) {
+      continue;
+    }
+
+    start = index + 1 - needed;
+    buffer_arena_blocks[start] = needed;
+    for (index = start + 1; index < start + needed; index++) {
+      buffer_arena_blocks[index] = BUFFER_ARENA_CONTINUED;
+    }
+#ifdef BP_ENABLE_MEMORY_USAGE
+    buffer_arena_reserved_blocks += needed;
+    if ((bus_pirate_configuration.bus_mode < ENABLED_PROTOCOLS_COUNT) &&
+        (buffer_arena_reserved_blocks >
+         buffer_arena_peak_blocks[bus_pirate_configuration.bus_mode])) {
+      buffer_arena_peak_blocks[bus_pirate_configuration.bus_mode] =
+          buffer_arena_reserved_blocks;
+    }
+#endif /* BP_ENABLE_MEMORY_USAGE */
+    return &bp_buffer_arena_memory[start * BP_BUFFER_ARENA_BLOCK_SIZE];
+  }
+
+  return NULL;
+}
+
+void bp_buffer_arena_release(const uint8_t *buffer) {
+  size_t start;
+  size_t blocks;
+  size_t index;
+
+  if (buffer == NULL) {
+    return;
+  }
+
+  /* The leading block holds the length, read it before clearing it. */
+  start = (buffer - bp_buffer_arena_memory) / BP_BUFFER_ARENA_BLOCK_SIZE;
+  blocks = buffer_arena_blocks[start];
+  for (index = start; index < start + blocks; index++) {
+    buffer_arena_blocks[index] = 0;
+  }
+#ifdef BP_ENABLE_MEMORY_USAGE
+  buffer_arena_reserved_blocks -= blocks;
+#endif /* BP_ENABLE_MEMORY_USAGE */
+}
+
+void bp_buffer_arena_release_all(void) {
+  size_t index;
+
+  for (index = 0; index < BP_BUFFER_ARENA_BLOCKS; index++) {
+    buffer_arena_blocks[index] = 0;
+  }
+#ifdef BP_ENABLE_MEMORY_USAGE
+  buffer_arena_reserved_blocks = 0;
+#endif /* BP_ENABLE_MEMORY_USAGE */
+}
+
+size_t bp_buffer_arena_largest_free(void) {
+  size_t largest;
+  size_t run;
+  size_t index;
+
+  largest = 0;
+  run = 0;
+  for (index = 0; index < BP_BUFFER_ARENA_BLOCKS; index++) {
+    run = (buffer_arena_blocks[index] == 0) ? run + 1 : 0;
+    if (run > largest) {
+      largest = run;
+    }
+  }
+
+  return largest * BP_BUFFER_ARENA_BLOCK_SIZE;
+}
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+
+size_t bp_buffer_arena_reserved(void) {
+  return buffer_arena_reserved_blocks * BP_BUFFER_ARENA_BLOCK_SIZE;
+}
+
+size_t bp_buffer_arena_peak(const size_t protocol) {
+  if (protocol >= ENABLED_PROTOCOLS_COUNT) {
+    return 0;
+  }
+
+  return buffer_arena_peak_blocks[protocol] * BP_BUFFER_ARENA_BLOCK_SIZE;
+}
+
+#endif /* BP_ENABLE_MEMORY_USAGE */
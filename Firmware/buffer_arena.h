@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef BP_BUFFER_ARENA_H
+#define BP_BUFFER_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "configuration.h"
+
+/**
+ * Number of blocks the arena is made of.
+ */
+#define BP_BUFFER_ARENA_BLOCKS                                                 \
+  (BP_TERMINAL_BUFFER_SIZE / BP_BUFFER_ARENA_BLOCK_SIZE)
+
+/**
+ * Memory behind bus_pirate_configuration.terminal_input.
+ *
+ * Code that uses the whole buffer for a single job, as most binary mode
+ * commands do for staging, may keep accessing it directly while nothing is
+ * reserved.  Code that splits it, or keeps part of it busy while something
+ * else runs, reserves its parts with bp_buffer_arena_reserve() instead.
+ */
+extern uint8_t bp_buffer_arena_memory[BP_TERMINAL_BUFFER_SIZE];
+
+/**
+ * Reserves contiguous memory from the arena, rounded up to whole blocks.
+ *
+ * Blocks are word aligned.
+ *
+ * @param[in] size how many bytes are needed.
+ *
+ * @return the reserved memory, or NULL if no free run of blocks is large
+ * enough.
+ */
+uint8_t *bp_buffer_arena_reserve(const size_t size);
+
+/**
+ * Gives back memory obtained from bp_buffer_arena_reserve().
+ *
+ * @param[in] buffer the reserved memory, NULL is ignored.
+ */
+void bp_buffer_arena_release(const uint8_t *buffer);
+
+/**
+ * Gives back everything that was reserved, when a mode exits or is reset.
+ */
+void bp_buffer_arena_release_all(void);
+
+/**
+ * Size of the largest reservation that would currently succeed, in bytes.
+ *
+ * @return the size of the largest free run of blocks.
+ */
+size_t bp_buffer_arena_largest_free(void);
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+
+/**
+ * How much of the arena is reserved right now.
+ *
+ * @return the size of all reserved blocks, in bytes.
+ */
+size_t bp_buffer_arena_reserved(void);
+
+/**
+ * The most that was ever reserved at once while the given protocol was the
+ * active bus mode.
+ *
+ * Binary mode resets the board to HiZ on entry, so reservations made by the
+ * binary modes all count under HiZ.
+ *
+ * @param[in] protocol a bus_pirate_available_protocols_t index.
+ *
+ * @return the peak reservation in bytes, 0 for an unknown protocol.
+ */
+size_t bp_buffer_arena_peak(const size_t protocol);
+
+#endif /* BP_ENABLE_MEMORY_USAGE */
+
+#endif /* !BP_BUFFER_ARENA_H */
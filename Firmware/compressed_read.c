@@ -0,0 +1,121 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "compressed_read.h"
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+
+#include "base.h"
+
+/**
+ * First repeat token, literal tokens are below it.
+ */
+#define COMPRESSED_READ_REPEAT_TOKEN 0x80
+
+/**
+ * Shortest run sent as a repeat token.
+ */
+#define COMPRESSED_READ_MINIMUM_RUN 3
+
+/**
+ * Longest run a single repeat token holds.
+ */
+#define COMPRESSED_READ_MAXIMUM_RUN (0x3F + COMPRESSED_READ_MINIMUM_RUN)
+
+/**
+ * Token stream encoder state.
+ */
+static struct {
+  /** Literal bytes waiting for their token. */
+  uint8_t literals[BP_COMPRESSED_READ_LITERALS];
+  /** How many bytes are in literals. */
+  uint8_t literal_count;
+  /** Byte the current run is made of. */
+  uint8_t run_value;
+  /** How many times run_value was seen in a row, 0 if none yet. */
+  uint8_t run_length;
+} compressed_read_state;
+
+/**
+ * Sends the pending literal bytes as one literal token.
+ */
+static void compressed_read_flush_literals(void);
+
+/**
+ * Sends the current run, as a repeat token if it is long enough or by adding
+ * it to the literal bytes otherwise.
+ */
+static void compressed_read_flush_run(void);
+
+void compressed_read_flush_literals(void) {
+  if (compressed_read_state.literal_count == 0) {
+    return;
+  }
+
+  user_serial_transmit_character(compressed_read_state.literal_count - 1);
+  bp_write_buffer(compressed_read_state.literals,
+                  compressed_read_state.literal_count);
+  compressed_read_state.literal_count = 0;
+}
+
+void compressed_read_flush_run(void) {
+  if (compressed_read_state.run_length >= COMPRESSED_READ_MINIMUM_RUN) {
+    compressed_read_flush_literals();
+    user_serial_transmit_character(
+        COMPRESSED_READ_REPEAT_TOKEN |
+        (compressed_read_state.run_length - COMPRESSED_READ_MINIMUM_RUN));
+    user_serial_transmit_character(compressed_read_state.run_value);
+  } else {
+    while (compressed_read_state.run_length > 0) {
+      if (compressed_read_state.literal_count == BP_COMPRESSED_READ_LITERALS) {
+        compressed_read_flush_literals();
+      }
+      compressed_read_state
+          .literals[compressed_read_state.literal_count++] =
+          compressed_read_state.run_value;
+      compressed_read_state.run_length--;
+    }
+  }
+
+  compressed_read_state.run_length = 0;
+}
+
+void bp_compressed_read_begin(void) {
+  compressed_read_state.literal_count = 0;
+  compressed_read_state.run_length = 0;
+}
+
+void bp_compressed_read_put(const uint8_t value) {
+  if ((compressed_read_state.run_length > 0) &&
+      (value == compressed_read_state.run_value)) {
+    if (++compressed_read_state.run_length == COMPRESSED_READ_MAXIMUM_RUN) {
+      compressed_read_flush_run();
+    }
+    return;
+  }
+
+  compressed_read_flush_run();
+  compressed_read_state.run_value = value;
+  compressed_read_state.run_length = 1;
+}
+
+void bp_compressed_read_end(void) {
+  compressed_read_flush_run();
+  compressed_read_flush_literals();
+}
+
+#endif /* BP_ENABLE_COMPRESSED_READS */
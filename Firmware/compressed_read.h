@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file compressed_read.h
+ *
+ * @brief Token stream encoder for bulk reads, so erased or padded memory
+ * regions do not cross the serial link byte by byte.
+ *
+ * The tokens are the same as for XSVZ streams (see jtag/ports.c), minus back
+ * references:
+ *
+ * <table>
+ * <tr><th>Token</th><th>Meaning</th></tr>
+ * <tr><td>0x00-0x7F</td><td>n+1 literal bytes follow</td></tr>
+ * <tr><td>0x80-0xBF</td><td>one byte follows, repeated (n & 0x3F)+3
+ * times</td></tr>
+ * </table>
+ *
+ * Only runs of three bytes or more are encoded as repeats, so the output is
+ * never longer than the input plus one byte per literal run.  The stream
+ * carries no length, the host decodes until it has the number of bytes it
+ * asked for.
+ */
+
+#ifndef BP_COMPRESSED_READ_H
+#define BP_COMPRESSED_READ_H
+
+#include <stdint.h>
+
+#include "configuration.h"
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+
+/**
+ * Starts a new token stream, discarding anything not sent yet.
+ */
+void bp_compressed_read_begin(void);
+
+/**
+ * Adds a byte read from the bus to the token stream, sending tokens to the
+ * serial port as they are complete.
+ *
+ * @param[in] value the byte to add.
+ */
+void bp_compressed_read_put(const uint8_t value);
+
+/**
+ * Sends whatever is still pending, ending the token stream.
+ */
+void bp_compressed_read_end(void);
+
+#endif /* BP_ENABLE_COMPRESSED_READS */
+
+#endif /* !BP_COMPRESSED_READ_H */
@@ -358,6 +358,27 @@
  */
 #define BP_1WIRE_DEVICE_DEV_ROSTER_SLOTS 10
 
+/**
+ * Generate 1-Wire time slots with the output compare and input capture
+ * hardware rather than with busy-wait delays.
+ *
+ * The LOW pulse is timed by OC4 and the line release is timestamped by IC3,
+ * with Timer 3 as time base, so interrupts no longer need to be masked while
+ * a slot is in progress.
+ */
+#define BP_1WIRE_HARDWARE_SLOT_TIMING
+
+/**
+ * Generate 1-Wire time slots with UART2 instead, one character per slot: 0xFF
+ * writes a 1 or reads a bit, 0x00 writes a 0, and a single slow character
+ * makes the reset pulse.  UART2 drives the data line as open drain and reads
+ * it back on the same pin, so whole bytes are queued in its FIFOs and the CPU
+ * only has to keep them topped up.
+ *
+ * This cannot be used along with BP_1WIRE_HARDWARE_SLOT_TIMING.
+ */
+#undef BP_1WIRE_UART_SLOT_TIMING
+
 /**
  * Lookup family ID and print that information when searching devices.
  */
@@ -379,6 +400,12 @@
 
 #ifdef BP_ENABLE_I2C_SUPPORT
 
+/**
+ * Enable the binary I/O I2C sniffer sending timestamped event records, captured
+ * by the change notification interrupt.
+ */
+#define BP_I2C_ENABLE_INTERRUPT_SNIFFER
+
 #ifdef BUSPIRATEV4
 
 /**
@@ -390,6 +417,16 @@
 
 #endif /* BUSPIRATEV4 */
 
+#ifdef BP_I2C_USE_HW_BUS
+
+/**
+ * Enable the binary I/O I2C slave emulator, answering as a register mapped
+ * device from the hardware I2C module slave interrupt.
+ */
+#define BP_I2C_ENABLE_SLAVE_EMULATION
+
+#endif /* BP_I2C_USE_HW_BUS */
+
 #endif /* BP_ENABLE_I2C_SUPPORT */
 
 /* BASIC interpreter module configuration definitions. */
@@ -440,6 +477,61 @@
  */
 #define BP_BASIC_STACK_FRAMES_DEPTH 10
 
+/**
+ * How many program lines the BASIC interpreter keeps an offset index for,
+ * to resolve GOTO and GOSUB targets with a binary search.
+ *
+ * Lines past the indexed ones are still found, by walking the program from
+ * the last indexed line.  Each index entry consumes 2 bytes of RAM.
+ */
+#ifdef BUSPIRATEV3
+#define BP_BASIC_LINE_INDEX_SIZE 16
+#else
+#define BP_BASIC_LINE_INDEX_SIZE 64
+#endif /* BUSPIRATEV3 */
+
+/**
+ * How many distinct expressions the BASIC interpreter keeps compiled while a
+ * program runs.  Must be a power of two.
+ *
+ * Expressions are compiled into bytecode the first time they are evaluated
+ * and run from there afterwards; past this count they are parsed from the
+ * program text every time.  Each entry consumes 6 bytes of RAM.
+ */
+#ifdef BUSPIRATEV3
+#define BP_BASIC_EXPRESSION_CACHE_SIZE 8
+#else
+#define BP_BASIC_EXPRESSION_CACHE_SIZE 32
+#endif /* BUSPIRATEV3 */
+
+/**
+ * Size of the bytecode area shared by all compiled BASIC expressions, in
+ * bytes.
+ */
+#ifdef BUSPIRATEV3
+#define BP_BASIC_BYTECODE_SPACE 96
+#else
+#define BP_BASIC_BYTECODE_SPACE 256
+#endif /* BUSPIRATEV3 */
+
+/**
+ * Evaluation stack depth for compiled BASIC expressions, in values.
+ *
+ * Expressions needing more than this are parsed from the program text
+ * instead.  Each value consumes 2 bytes of stack while evaluating.
+ */
+#define BP_BASIC_EXPRESSION_STACK_DEPTH 8
+
+/**
+ * Size of the BASIC byte buffer used by `BUF` and the bulk `SEND BUF,len` and
+ * `RECEIVE BUF,len` statements, in bytes.
+ */
+#ifdef BUSPIRATEV3
+#define BP_BASIC_BUFFER_SIZE 64
+#else
+#define BP_BASIC_BUFFER_SIZE 256
+#endif /* BUSPIRATEV3 */
+
 #endif /* BP_ENABLE_BASIC_SUPPORT */
 
 /* SPI module configuration definitions. */
@@ -452,8 +544,38 @@
  */
 #define BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
 
+/**
+ * Enable the SPI NOR flash binary sub-mode, which runs read, page program,
+ * sector erase, and verify loops on the device rather than from the host.
+ */
+#define BP_SPI_ENABLE_FLASH_ENGINE
+
+/**
+ * Capture sniffed binary mode SPI traffic from the SPI receive interrupt rather
+ * than by polling, so the capture rate does not depend on the serial port.
+ */
+#define BP_SPI_ENABLE_INTERRUPT_SNIFFER
+
+/**
+ * Enable the binary mode SPI flash emulator, answering READ, FAST_READ, RDID
+ * and RDSR as an SPI slave from an image uploaded into the terminal buffer.
+ */
+#define BP_SPI_ENABLE_FLASH_EMULATOR
+
 #endif /* BP_ENABLE_SPI_SUPPORT */
 
+/* Raw 3-Wire module configuration definitions. */
+
+#ifdef BP_ENABLE_RAW_3WIRE_SUPPORT
+
+/**
+ * Move 8 and 16 bits transfers through SPI1 rather than bit-banging them,
+ * whenever SPI1 can clock at the selected bus speed.
+ */
+#define BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+
+#endif /* BP_ENABLE_RAW_3WIRE_SUPPORT */
+
 /* SMPS module configuration definitions. */
 
 #ifdef BP_ENABLE_SMPS_SUPPORT
@@ -471,7 +593,8 @@
 #ifdef BP_ENABLE_JTAG_SUPPORT
 
 /**
- * Maximum number of bit sequences to handle in a single command set.
+ * Number of bit sequences a v3 TAP shift buffers at once.  Longer shifts, up
+ * to the 65535 the command allows, are streamed in segments of this size.
  */
 #define BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT 0x2000
 
@@ -500,6 +623,26 @@
  */
 #define BP_JTAG_XSVF_SUPPORT
 
+/**
+ * Enable the ARM Serial Wire Debug binary mode, running whole queues of
+ * SWD transactions on the device.
+ *
+ * This is not enabled on v3 boards due to taking up too much memory.
+ */
+#define BP_JTAG_SWD_SUPPORT
+
+#ifdef BP_JTAG_XSVF_SUPPORT
+
+/**
+ * Accept XSVF files packed by scripts/BPXSVFPlayer/xsvfz.py as well, unpacking
+ * them while they are played.  Plain XSVF files keep working.
+ *
+ * Costs 256 bytes of RAM for the back reference window.
+ */
+#define BP_JTAG_XSVF_COMPRESSION
+
+#endif /* BP_JTAG_XSVF_SUPPORT */
+
 #endif /* BUSPIRATEV4 */
 
 #endif /* BP_ENABLE_JTAG_SUPPORT */
@@ -514,6 +657,64 @@
 
 #endif /* BP_ENABLE_SMPS_SUPPORT */
 
+/* ADC configuration definitions. */
+
+/**
+ * Enable the timer driven ADC block streaming binary I/O command.
+ */
+#define BP_ENABLE_ADC_STREAM_SUPPORT
+
+/* USB configuration definitions. */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Expose a vendor specific bulk IN/OUT interface next to the CDC one.
+ *
+ * Binary I/O modes entered from that interface talk over its bulk endpoints,
+ * letting host tools use libusb without going through a tty.  This makes the
+ * board a composite device, so Windows needs its driver set up again.
+ */
+#undef BP_USB_VENDOR_INTERFACE
+
+/**
+ * Expose an isochronous IN endpoint for the ADC and SUMP streams.
+ *
+ * Once the host selects the second alternate setting of that interface, the
+ * streamed data goes out there with bandwidth reserved in every frame, and
+ * frame numbers and offsets in each packet so the host can tell gaps apart.
+ * Commands and replies stay on the serial port.  This makes the board a
+ * composite device, so Windows needs its driver set up again.
+ */
+#undef BP_USB_ISOCHRONOUS_STREAM
+
+/**
+ * Keep a timebase locked to the USB start of frame packets, so captures from
+ * several boards on the same host can be put on a single time axis.
+ *
+ * The sub-frame counter is IC9's own, which nothing else uses.  AUX becomes a
+ * shared trigger line only when asked to with the binary I/O timebase
+ * command.
+ */
+#define BP_ENABLE_USB_TIMEBASE
+
+#endif /* BUSPIRATEV4 */
+
+/* Bitbang engine configuration definitions. */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Use fully unrolled 8 bits MSB first transfer routines when the bitbang
+ * engine runs at its fastest speed, instead of the generic per bit loop.
+ *
+ * This speeds up raw 2-wire/3-wire and software I2C transfers, at the cost of
+ * a few hundred bytes of flash.
+ */
+#define BP_BITBANG_FAST_KERNELS
+
+#endif /* BUSPIRATEV4 */
+
 /* Module-agnostic configuration definitions. */
 
 /**
@@ -521,10 +722,10 @@
  */
 #define BP_ENABLE_COMMAND_HISTORY
 
-#ifdef BP_ENABLE_COMMAND_HISTORY
-
 /**
  * How many past entries the command history should keep track of.
+ *
+ * This also limits how far back the arrow keys can go.
  */
 #ifdef BUSPIRATEV3
 #define BP_COMMAND_HISTORY_LENGTH 7
@@ -532,8 +733,6 @@
 #define BP_COMMAND_HISTORY_LENGTH 15
 #endif /* BUSPIRATEV3 */
 
-#endif /* BP_ENABLE_COMMAND_HISTORY */
-
 /**
  * How many user-defined macros can be set.
  */
@@ -563,11 +762,166 @@
 #define BP_COMMAND_BUFFER_SIZE 256
 #endif /* BUSPIRATEV3 */
 
+/**
+ * How many bus operations a terminal command line can be compiled into before
+ * it is interpreted character by character instead.
+ */
+#ifdef BUSPIRATEV3
+#define BP_COMPILED_COMMAND_MAX_OPERATIONS 16
+#else
+#define BP_COMPILED_COMMAND_MAX_OPERATIONS 48
+#endif /* BUSPIRATEV3 */
+
+/**
+ * Size of the data memory region the linker script gives to the firmware, in
+ * bytes.
+ *
+ * This must match the LENGTH of the "data" region in p24FJ64GA002.gld or
+ * p24FJ256GB106.gld, rounded up to a whole kilobyte.  Buffers are sized from
+ * it at compile time, whilst the memory usage report reads the region size
+ * the firmware was really linked with from the __DATA_LENGTH symbol.
+ */
+#ifdef BUSPIRATEV3
+#define BP_DATA_MEMORY_SIZE 0x2000
+#else
+#define BP_DATA_MEMORY_SIZE 0x4000
+#endif /* BUSPIRATEV3 */
+
 /**
  * How big the serial terminal buffer can be, in bytes.
  *
- * @todo Make sure that no hard-coded buffer sizes are present.
+ * Half of the data memory goes to the buffer, which also sizes the SUMP sample
+ * memory, the SPI/I2C/1-Wire transfer limits and every buffer arena
+ * reservation.  It must be a power of two, as the UART rings split it in two
+ * wrapping halves.
+ */
+#define BP_TERMINAL_BUFFER_SIZE (BP_DATA_MEMORY_SIZE / 2)
+
+/**
+ * Granularity of buffer arena reservations, in bytes.
+ *
+ * BP_TERMINAL_BUFFER_SIZE must be a multiple of this.
+ */
+#define BP_BUFFER_ARENA_BLOCK_SIZE 256
+
+/**
+ * How many incoming characters the user-facing serial port can hold while the
+ * firmware is busy, must be a power of two.
+ *
+ * Only used on v3, where the UART1 reception FIFO is only four characters
+ * deep; on v4 the USB stack holds incoming data back on its own.
  */
-#define BP_TERMINAL_BUFFER_SIZE 4096
+#define BP_USER_SERIAL_RECEIVE_RING_SIZE 256
+
+/**
+ * Enable timing of firmware hot paths, readable with the binary I/O profiling
+ * command.
+ *
+ * Serial reads, SPI byte transfers, CDC packets, bitbang transfers and SUMP
+ * captures are timed against timer #2/#3 running freely at FCY.  Disabled by
+ * default, as the timer is taken over and every timed region costs a few
+ * cycles on entry and exit.
+ */
+#undef BP_ENABLE_PROFILING
+
+/**
+ * Keep a ring of the last binary mode commands and bus events, readable with
+ * the binary I/O flight recorder command.
+ *
+ * Each record takes 8 bytes and a few cycles to write, timestamps come from
+ * the USB timebase when there is one.
+ */
+#ifdef BUSPIRATEV4
+#define BP_ENABLE_FLIGHT_RECORDER
+#else
+#undef BP_ENABLE_FLIGHT_RECORDER
+#endif /* BUSPIRATEV4 */
+
+/**
+ * How many records the flight recorder keeps, must be a power of two.
+ */
+#ifdef BUSPIRATEV3
+#define BP_FLIGHT_RECORDER_RECORDS 32
+#else
+#define BP_FLIGHT_RECORDER_RECORDS 128
+#endif /* BUSPIRATEV3 */
+
+/**
+ * Count bytes moved to and from the host, serial ring levels and bus errors,
+ * readable from every binary mode with its telemetry command.
+ */
+#define BP_ENABLE_TELEMETRY
+
+/**
+ * Paint the stack at startup and keep the buffer arena reservation peaks, to
+ * report how much memory every mode really needs, from the binary I/O memory
+ * usage command and the terminal status information.
+ */
+#ifdef BUSPIRATEV4
+#define BP_ENABLE_MEMORY_USAGE
+#else
+#undef BP_ENABLE_MEMORY_USAGE
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Offer the binary I/O self-benchmark command, timing the SPI, bit-banged and
+ * 1-Wire engines on the board with no host link in the loop.
+ */
+#ifdef BUSPIRATEV4
+#define BP_ENABLE_BENCHMARK
+#else
+#undef BP_ENABLE_BENCHMARK
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Bytes every engine clocks during the self-benchmark, up to 4096.  They are
+ * taken from the buffer arena while it runs.
+ */
+#define BP_BENCHMARK_BYTES 1024
+
+/**
+ * Offer run length encoded responses for the bulk read commands of the SPI,
+ * SPI flash engine and I2C binary modes, see compressed_read.h.
+ */
+#define BP_ENABLE_COMPRESSED_READS
+
+/**
+ * Longest literal run the compressed read encoder buffers before sending it,
+ * up to 128.  Incompressible data grows by one byte every this many.
+ */
+#ifdef BUSPIRATEV3
+#define BP_COMPRESSED_READ_LITERALS 32
+#else
+#define BP_COMPRESSED_READ_LITERALS 128
+#endif /* BUSPIRATEV3 */
+
+/**
+ * How many background tasks can be registered at once, see
+ * bp_background_task_register().
+ */
+#define BP_BACKGROUND_TASKS 4
+
+#if defined(BP_I2C_ENABLE_INTERRUPT_SNIFFER) ||                               \
+    defined(BP_ENABLE_PC_AT_KEYBOARD_SUPPORT)
+
+/**
+ * The change notification interrupt is shared by the I2C sniffer and the
+ * PC-AT keyboard receiver, base.c owns the vector and calls whichever handler
+ * the active mode registered.
+ */
+#define BP_CHANGE_NOTIFICATION_DISPATCH
+
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER || BP_ENABLE_PC_AT_KEYBOARD_SUPPORT */
+
+#if defined(BP_ENABLE_ADC_STREAM_SUPPORT) || defined(BP_ENABLE_SMPS_SUPPORT)
+
+/**
+ * The ADC interrupt is shared by the ADC block streams and the SMPS
+ * regulation loop, base.c owns the vector and calls whichever handler is
+ * running.
+ */
+#define BP_ADC_INTERRUPT_DISPATCH
+
+#endif /* BP_ENABLE_ADC_STREAM_SUPPORT || BP_ENABLE_SMPS_SUPPORT */
 
 #endif /* !BP_CONFIGURATION_H */
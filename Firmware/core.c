@@ -149,7 +149,27 @@ static void silent_null_operation_callback(void);
 extern bus_pirate_configuration_t bus_pirate_configuration;
 extern mode_configuration_t mode_configuration;
 
-bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
+/**
+ * Tasks run by bp_yield(), in registration order.
+ */
+static bp_background_task_t background_tasks[BP_BACKGROUND_TASKS] = {NULL};
+
+/**
+ * How many entries of background_tasks are in use.
+ */
+static size_t background_tasks_count = 0;
+
+/**
+ * Set while bp_yield() runs the tasks, to keep it from running them again
+ * from inside one of them.
+ */
+static bool background_tasks_running = false;
+
+/*
+ * Never written to, being const keeps the table in program memory, read
+ * through PSV, instead of taking 48 bytes of RAM per protocol.
+ */
+const bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
     {.start = null_operation_callback,
      .start_with_read = null_operation_callback,
      .stop = null_operation_callback,
@@ -180,6 +200,8 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = null_operation_callback,
      .send = onewire_write,
      .read = onewire_read,
+     .send_buffer = onewire_send_buffer,
+     .read_buffer = onewire_read_buffer,
      .clock_high = null_operation_callback,
      .clock_low = null_operation_callback,
      .data_high = onewire_data_high,
@@ -205,6 +227,7 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = uart_stop,
      .send = uart_write,
      .read = uart_read,
+     .send_buffer = uart_send_buffer,
      .clock_high = null_operation_callback,
      .clock_low = null_operation_callback,
      .data_high = null_operation_callback,
@@ -230,6 +253,8 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = i2c_stop,
      .send = i2c_write,
      .read = i2c_read,
+     .send_buffer = i2c_send_buffer,
+     .read_buffer = i2c_read_buffer,
      .clock_high = null_operation_callback,
      .clock_low = null_operation_callback,
      .data_high = null_operation_callback,
@@ -255,6 +280,9 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = spi_stop,
      .send = spi_write,
      .read = spi_read,
+     .send_buffer = spi_send_buffer,
+     .read_buffer = spi_read_buffer,
+     .transfer_buffer = spi_transfer_buffer,
      .clock_high = null_operation_callback,
      .clock_low = null_operation_callback,
      .data_high = null_operation_callback,
@@ -280,6 +308,8 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = raw2wire_stop,
      .send = raw2wire_write,
      .read = raw2wire_read,
+     .send_buffer = raw2wire_send_buffer,
+     .read_buffer = raw2wire_read_buffer,
      .clock_high = raw_set_clock_high,
      .clock_low = raw_set_clock_low,
      .data_high = raw_set_data_high,
@@ -291,7 +321,7 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .run_macro = raw2wire_run_macro,
      .setup_prepare = raw2wire_setup_prepare,
      .setup_execute = raw2wire_setup_execute,
-     .cleanup = reset_mode_to_8_bits,
+     .cleanup = raw2wire_cleanup,
      .print_pins_state = raw2wire_print_pins_state,
      .print_settings = raw2wire_print_settings,
      .name = "2WIRE"}
@@ -305,6 +335,9 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .stop_from_read = raw3wire_stop,
      .send = raw3wire_write,
      .read = raw3wire_read,
+     .send_buffer = raw3wire_send_buffer,
+     .read_buffer = raw3wire_read_buffer,
+     .transfer_buffer = raw3wire_transfer_buffer,
      .clock_high = raw_set_clock_high,
      .clock_low = raw_set_clock_low,
      .data_high = raw_set_data_high,
@@ -341,7 +374,7 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .run_macro = pc_at_keyboard_run_macro,
      .setup_prepare = pc_at_keyboard_prepare,
      .setup_execute = pc_at_keyboard_execute,
-     .cleanup = reset_mode_to_8_bits,
+     .cleanup = pc_at_keyboard_cleanup,
      .print_pins_state = hiz_print_pins_state,
      .print_settings = empty_print_settings_implementation,
      .name = "KEYB"}
@@ -362,11 +395,11 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .data_state = null_data_read_callback,
      .clock_pulse = null_operation_callback,
      .read_bit = null_bit_read_callback,
-     .periodic_update = null_bit_read_callback,
+     .periodic_update = LCDperiodic,
      .run_macro = LCDmacro,
      .setup_prepare = LCDsetup,
      .setup_execute = LCDsetup_exc,
-     .cleanup = spi_disable_interface,
+     .cleanup = LCDcleanup,
      .print_pins_state = LCDpins,
      .print_settings = empty_print_settings_implementation,
      .name = "LCD"}
@@ -413,8 +446,8 @@ bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT] = {
      .clock_pulse = null_operation_callback,
      .read_bit = null_bit_read_callback,
      .periodic_update = null_bit_read_callback,
-     .run_macro = null_macro_callback,
-     .setup_prepare = silent_null_operation_callback,
+     .run_macro = dio_run_macro,
+     .setup_prepare = dio_setup_prepare,
      .setup_execute = silent_null_operation_callback,
      .cleanup = reset_mode_to_8_bits,
      .print_pins_state = hiz_print_pins_state,
@@ -463,9 +496,89 @@ void silent_null_operation_callback(void) {
 
 void hiz_print_pins_state(void) { MSG_SPI_PINS_STATE; }
 
+void bp_protocol_send_buffer(const uint8_t *buffer, const size_t length) {
+  const bus_pirate_protocol_t *protocol =
+      &enabled_protocols[bus_pirate_configuration.bus_mode];
+  size_t index;
+
+  if (protocol->send_buffer != NULL) {
+    protocol->send_buffer(buffer, length);
+    return;
+  }
+  for (index = 0; index < length; index++) {
+    protocol->send(buffer[index]);
+  }
+}
+
+void bp_protocol_read_buffer(uint8_t *buffer, const size_t length) {
+  const bus_pirate_protocol_t *protocol =
+      &enabled_protocols[bus_pirate_configuration.bus_mode];
+  size_t index;
+
+  if (protocol->read_buffer != NULL) {
+    protocol->read_buffer(buffer, length);
+    return;
+  }
+  for (index = 0; index < length; index++) {
+    buffer[index] = protocol->read();
+  }
+}
+
 void reset_mode_to_8_bits(void) {
   /* Sets the mode configuration to 8 bits. */
 
   mode_configuration.numbits = 8;
   mode_configuration.int16 = NO;
 }
+
+bool bp_background_task_register(const bp_background_task_t task) {
+  size_t index;
+
+  for (index = 0; index < background_tasks_count; index++) {
+    if (background_tasks[index] == task) {
+      return true;
+    }
+  }
+
+  if (background_tasks_count == BP_BACKGROUND_TASKS) {
+    return false;
+  }
+
+  background_tasks[background_tasks_count++] = task;
+  return true;
+}
+
+void bp_background_task_unregister(const bp_background_task_t task) {
+  size_t index;
+
+  for (index = 0; index < background_tasks_count; index++) {
+    if (background_tasks[index] == task) {
+      break;
+    }
+  }
+
+  if (index == background_tasks_count) {
+    return;
+  }
+
+  /* Keep the others in order. */
+  background_tasks_count--;
+  for (; index < background_tasks_count; index++) {
+    background_tasks[index] = background_tasks[index + 1];
+  }
+  background_tasks[background_tasks_count] = NULL;
+}
+
+void bp_yield(void) {
+  size_t index;
+
+  if (background_tasks_running) {
+    return;
+  }
+
+  background_tasks_running = true;
+  for (index = 0; index < background_tasks_count; index++) {
+    background_tasks[index]();
+  }
+  background_tasks_running = false;
+}
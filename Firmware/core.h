@@ -20,6 +20,7 @@
 
 #include "configuration.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -80,6 +81,44 @@ typedef struct {
    */
   uint16_t (*read)(void);
 
+  /**
+   * Send the given bytes to the bus, one after the other, optional.
+   *
+   * This must behave as calling send() on each byte would, messages
+   * included, minus the per-byte overhead of going through the protocol
+   * table.  Leave it NULL and generic code calls send() instead.
+   *
+   * @param[in] buffer the bytes to send.
+   * @param[in] length how many bytes to send.
+   */
+  void (*send_buffer)(const uint8_t *buffer, const size_t length);
+
+  /**
+   * Read the given number of bytes from the bus, optional.
+   *
+   * This must behave as calling read() for each byte would.  Leave it NULL
+   * and generic code calls read() instead.
+   *
+   * @param[out] buffer where to store the bytes read.
+   * @param[in]  length how many bytes to read.
+   */
+  void (*read_buffer)(uint8_t *buffer, const size_t length);
+
+  /**
+   * Send the given bytes to the bus and store what is clocked in at the same
+   * time, optional and for full duplex protocols only.
+   *
+   * This must not print anything.  Generic code only uses it when it has
+   * bytes to send and needs every byte read back, whatever the
+   * write_with_read setting is.
+   *
+   * @param[in]  output the bytes to send.
+   * @param[out] input  where to store the bytes read, may be output itself.
+   * @param[in]  length how many bytes to transfer.
+   */
+  void (*transfer_buffer)(const uint8_t *output, uint8_t *input,
+                          const size_t length);
+
   /**
    * Pull the clock line high, if one is present.
    */
@@ -243,7 +282,9 @@ typedef enum {
   /** Display numbers in base-2. */
   BIN,
   /** Display numbers as raw bytes. */
-  RAW
+  RAW,
+  /** Display numbers as a compact hexadecimal dump, 16 values per line. */
+  DUMP
 } __attribute__((packed)) bus_pirate_display_mode_t;
 
 typedef struct {
@@ -261,4 +302,57 @@ typedef struct {
 #endif /* BP_ENABLE_BASIC_SUPPORT */
 } bus_pirate_configuration_t;
 
+/**
+ * Sends the given bytes to the bus with the current protocol, through its
+ * send_buffer callback if it has one and one send() call per byte otherwise.
+ *
+ * @param[in] buffer the bytes to send.
+ * @param[in] length how many bytes to send.
+ */
+void bp_protocol_send_buffer(const uint8_t *buffer, const size_t length);
+
+/**
+ * Reads the given number of bytes from the bus with the current protocol,
+ * through its read_buffer callback if it has one and one read() call per
+ * byte otherwise.
+ *
+ * @param[out] buffer where to store the bytes read.
+ * @param[in]  length how many bytes to read.
+ */
+void bp_protocol_read_buffer(uint8_t *buffer, const size_t length);
+
+/**
+ * Background job, run from bp_yield() while the firmware waits.
+ *
+ * Tasks must be short and must not depend on being called at any given
+ * rate, as waits that are timing critical do not yield.
+ */
+typedef void (*bp_background_task_t)(void);
+
+/**
+ * Adds a task to those run by bp_yield().
+ *
+ * @param[in] task the task to add.
+ *
+ * @return true if the task was added or was already registered, false if
+ * there is no room for it.
+ */
+bool bp_background_task_register(const bp_background_task_t task);
+
+/**
+ * Removes a task added with bp_background_task_register(), unknown tasks are
+ * ignored.
+ *
+ * @param[in] task the task to remove.
+ */
+void bp_background_task_unregister(const bp_background_task_t task);
+
+/**
+ * Runs every registered background task once, to be called from wait loops.
+ *
+ * Calls made from within a background task return at once, so tasks may
+ * wait on something themselves.
+ */
+void bp_yield(void);
+
 #endif /* !BP_CORE_H */
@@ -27,9 +27,15 @@ ROMPTR const unsigned char cdc_device_descriptor[] = {
         USB_DEVICE_DESCRIPTOR_TYPE,                     // bDescriptorType
         0x00,                                           // bcdUSB (low byte)
         0x02,                                           // bcdUSB (high byte)
+#ifdef USB_COMPOSITE_DEVICE
+        0xEF,                                           // bDeviceClass (miscellaneous)
+        0x02,                                           // bDeviceSubClass (common class)
+        0x01,                                           // bDeviceProtocol (interface association)
+#else
         0x02,                                           // bDeviceClass
         0x00,                                           // bDeviceSubClass
         0x00,                                           // bDeviceProtocol
+#endif
         USB_EP0_BUFFER_SIZE,                            // bMaxPacketSize
 
         LOWB(USB_VID),                                  // idVendor (low byte)
@@ -44,7 +50,26 @@ ROMPTR const unsigned char cdc_device_descriptor[] = {
         USB_NUM_CONFIGURATIONS                          // bNumConfigurations 
 };
 
-#define USB_CONFIG_DESC_TOT_LENGTH (9+9+5+4+5+5+7+9+7+7)
+#define USB_CONFIG_DESC_CDC_LENGTH (9+5+4+5+5+7+9+7+7)
+#ifdef USB_COMPOSITE_DEVICE
+// The interface association grouping the CDC interfaces.
+#define USB_CONFIG_DESC_IAD_LENGTH 8
+#else
+#define USB_CONFIG_DESC_IAD_LENGTH 0
+#endif
+#ifdef BP_USB_VENDOR_INTERFACE
+// The vendor interface with its two endpoints.
+#define USB_CONFIG_DESC_VENDOR_LENGTH (9+7+7)
+#else
+#define USB_CONFIG_DESC_VENDOR_LENGTH 0
+#endif
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+// The streaming interface, alternate setting 1 having the endpoint.
+#define USB_CONFIG_DESC_ISOCHRONOUS_LENGTH (9+9+7)
+#else
+#define USB_CONFIG_DESC_ISOCHRONOUS_LENGTH 0
+#endif
+#define USB_CONFIG_DESC_TOT_LENGTH (9+USB_CONFIG_DESC_IAD_LENGTH+USB_CONFIG_DESC_CDC_LENGTH+USB_CONFIG_DESC_VENDOR_LENGTH+USB_CONFIG_DESC_ISOCHRONOUS_LENGTH)
 ROMPTR const unsigned char cdc_config_descriptor[] = {
         0x09,                                           // bLength
         USB_CONFIGURATION_DESCRIPTOR_TYPE,              // bDescriptorType
@@ -55,6 +80,17 @@ ROMPTR const unsigned char cdc_config_descriptor[] = {
         0x00,                                           // iConfiguration (0=none)
         0x80,                                           // bmAttributes (0x80 = bus powered)
         0x64,                                           // bMaxPower (in 2 mA units, 50=100 mA)
+#ifdef USB_COMPOSITE_DEVICE
+              // Interface association descriptor, groups the two CDC interfaces
+        0x08,                                           // bLength
+        0x0B,                                           // bDescriptorType (interface association)
+        0x00,                                           // bFirstInterface
+        0x02,                                           // bInterfaceCount
+        0x02,                                           // bFunctionClass 0x02=com interface
+        0x02,                                           // bFunctionSubClass 0x02=ACM
+        0x01,                                           // bFunctionProtocol 0x01=AT modem
+        0x00,                                           // iFunction (none)
+#endif
               //Interface0 descriptor starts here
         0x09,                                           // bLength (Interface0 descriptor starts here)
         USB_INTERFACE_DESCRIPTOR_TYPE,                  // bDescriptorType
@@ -121,7 +157,67 @@ ROMPTR const unsigned char cdc_config_descriptor[] = {
         0x02,                                           // bmAttributes (0x02=bulk)
         LOWB(CDC_BUFFER_SIZE),                          // wMaxPacketSize (low byte)
         HIGHB(CDC_BUFFER_SIZE),                         // wMaxPacketSize (high byte)
+#ifdef BP_USB_VENDOR_INTERFACE
+        0x00,                                           // bInterval
+                //Interface2 descriptor (vendor bulk pipe)
+        0x09,                                           // bLength (Interface2 descriptor)
+        USB_INTERFACE_DESCRIPTOR_TYPE,                  // bDescriptorType
+        0x02,                                           // bInterfaceNumber
+        0x00,                                           // bAlternateSetting
+        0x02,                                           // bNumEndpoints
+        0xFF,                                           // bInterfaceClass (vendor specific)
+        0x00,                                           // bInterfaceSubClass
+        0x00,                                           // bInterfaceProtocol
+        0x00,                                           // iInterface
+             // Vendor Endpoint 3 OUT descriptor (BULK)
+        0x07,                                           // bLength
+        USB_ENDPOINT_DESCRIPTOR_TYPE,                   // bDescriptorType
+        VENDOR_ENDPOINT,                                // bEndpointAddress
+        0x02,                                           // bmAttributes (0x02=bulk)
+        LOWB(VENDOR_BUFFER_SIZE),                       // wMaxPacketSize (low byte)
+        HIGHB(VENDOR_BUFFER_SIZE),                      // wMaxPacketSize (high byte)
+        0x00,                                           // bInterval
+             // Vendor Endpoint 3 IN descriptor (BULK)
+        0x07,                                           // bLength
+        USB_ENDPOINT_DESCRIPTOR_TYPE,                   // bDescriptorType
+        0x80 | VENDOR_ENDPOINT,                         // bEndpointAddress
+        0x02,                                           // bmAttributes (0x02=bulk)
+        LOWB(VENDOR_BUFFER_SIZE),                       // wMaxPacketSize (low byte)
+        HIGHB(VENDOR_BUFFER_SIZE),                      // wMaxPacketSize (high byte)
+#endif
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+        0x00,                                           // bInterval
+                //Streaming interface descriptor, alternate setting 0 (no bandwidth)
+        0x09,                                           // bLength
+        USB_INTERFACE_DESCRIPTOR_TYPE,                  // bDescriptorType
+        USB_ISOCHRONOUS_INTERFACE,                      // bInterfaceNumber
+        0x00,                                           // bAlternateSetting
+        0x00,                                           // bNumEndpoints
+        0xFF,                                           // bInterfaceClass (vendor specific)
+        0x00,                                           // bInterfaceSubClass
+        0x00,                                           // bInterfaceProtocol
+        0x00,                                           // iInterface
+                //Streaming interface descriptor, alternate setting 1 (streaming)
+        0x09,                                           // bLength
+        USB_INTERFACE_DESCRIPTOR_TYPE,                  // bDescriptorType
+        USB_ISOCHRONOUS_INTERFACE,                      // bInterfaceNumber
+        0x01,                                           // bAlternateSetting
+        0x01,                                           // bNumEndpoints
+        0xFF,                                           // bInterfaceClass (vendor specific)
+        0x00,                                           // bInterfaceSubClass
+        0x00,                                           // bInterfaceProtocol
+        0x00,                                           // iInterface
+             // Streaming Endpoint 4 IN descriptor (ISOCHRONOUS)
+        0x07,                                           // bLength
+        USB_ENDPOINT_DESCRIPTOR_TYPE,                   // bDescriptorType
+        0x80 | ISOCHRONOUS_ENDPOINT,                    // bEndpointAddress
+        0x05,                                           // bmAttributes (0x05=isochronous, asynchronous)
+        LOWB(ISOCHRONOUS_PACKET_SIZE),                  // wMaxPacketSize (low byte)
+        HIGHB(ISOCHRONOUS_PACKET_SIZE),                 // wMaxPacketSize (high byte)
+        0x01                                            // bInterval (every frame)
+#else
         0x00                                            // bInterval
+#endif
 };
 
 ROMPTR const unsigned char cdc_str_descs[] = {
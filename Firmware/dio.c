@@ -21,19 +21,203 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "pattern_generator.h"
+#include "proc_menu.h"
 
 /**
  * Bit #9 indicates whether it is to set the pin state or the pin direction.
  */
 #define DIO_PIN_SET_STATE_FLAG_MASK 0b0000000010000000
 
-unsigned int dio_read(void) {
+/**
+ * Bits of a pin state value mapping to the IO pins.
+ */
+#define DIO_PIN_STATE_MASK 0b00011111
+
+/**
+ * How many pin states can be recorded or sampled in one go.
+ */
+#define DIO_BUFFER_SIZE 128
+
+/**
+ * Pin states sampled when no count is given.
+ */
+#define DIO_DEFAULT_SAMPLES 16
+
+/**
+ * FCY cycles per microsecond, as step periods are given in microseconds.
+ */
+#define DIO_CYCLES_PER_US (FCY / 1000000UL)
+
+/**
+ * Step period range, in microseconds.
+ */
+#define DIO_MINIMUM_STEP_PERIOD                                                \
+  ((PATTERN_GENERATOR_MINIMUM_PERIOD + DIO_CYCLES_PER_US - 1) /                \
+   DIO_CYCLES_PER_US)
+#define DIO_MAXIMUM_STEP_PERIOD (0xFFFF / DIO_CYCLES_PER_US)
+
+/**
+ * Step period used when entering the mode, in microseconds.
+ */
+#define DIO_DEFAULT_STEP_PERIOD 100
+
+extern mode_configuration_t mode_configuration;
+
+typedef enum {
+  DIO_MACRO_MENU = 0,
+  DIO_MACRO_STEP_PERIOD,
+  DIO_MACRO_SAMPLE,
+  DIO_MACRO_RECORD,
+  DIO_MACRO_PLAY
+} dio_macro_t;
+
+/**
+ * Timed sampling and playback state.
+ */
+static struct {
+  /** Pin states written while recording. */
+  uint8_t recording[DIO_BUFFER_SIZE];
+
+  /** Pin states sampled by the last macro run. */
+  uint8_t samples[DIO_BUFFER_SIZE];
+
+  /** How many pin states were recorded. */
+  size_t recorded;
+
+  /** Time between pin states, in microseconds. */
+  uint16_t step_period;
+
+  /** Whether pin state writes are being recorded. */
+  bool recording_active;
+} dio_state = {.step_period = DIO_DEFAULT_STEP_PERIOD};
+
+/**
+ * Prints pin states sampled by the pattern generator, 16 per line.
+ *
+ * @param[in] count how many states to print.
+ */
+static void dio_print_samples(const size_t count);
+
+/**
+ * Reads the macro argument, the number after the closing parenthesis.
+ *
+ * @return the argument, or 0 if there was none.
+ */
+static uint16_t dio_macro_argument(void);
+
+uint16_t dio_read(void) {
 	return PORTB;
 }
 
-unsigned int dio_write(unsigned int value) {
-    return (value & DIO_PIN_SET_STATE_FLAG_MASK) ? bitbang_pin_state_set(value) :
-        bitbang_pin_direction_set(value);
+uint16_t dio_write(const uint16_t value) {
+  if ((value & DIO_PIN_SET_STATE_FLAG_MASK) && dio_state.recording_active) {
+    if (dio_state.recorded == DIO_BUFFER_SIZE) {
+      MSG_DIO_RECORDING_FULL;
+      mode_configuration.command_error = true;
+    } else {
+      dio_state.recording[dio_state.recorded++] = value & DIO_PIN_STATE_MASK;
+    }
+    return value;
+  }
+
+  return (value & DIO_PIN_SET_STATE_FLAG_MASK)
+             ? bitbang_pin_state_set(value)
+             : bitbang_pin_direction_set(value);
+}
+
+uint16_t dio_macro_argument(void) {
+  int argument;
+
+  cmdstart = (cmdstart + 1) & CMDLENMSK;
+  consumewhitechars();
+  argument = getint();
+  mode_configuration.command_error = false;
+
+  return (argument > 0) ? (uint16_t)argument : 0;
+}
+
+void dio_print_samples(const size_t count) {
+  size_t index;
+
+  for (index = 0; index < count; index++) {
+    bp_write_formatted_integer(dio_state.samples[index]);
+    if ((index % 16) == 15) {
+      bpBR;
+    } else {
+      bpSP;
+    }
+  }
+  if ((count % 16) != 0) {
+    bpBR;
+  }
+}
+
+void dio_run_macro(uint16_t macro) {
+  uint16_t argument = dio_macro_argument();
+
+  switch (macro) {
+  case DIO_MACRO_MENU:
+    MSG_DIO_MACRO_MENU;
+    break;
+
+  case DIO_MACRO_STEP_PERIOD:
+    if (argument != 0) {
+      if ((argument < DIO_MINIMUM_STEP_PERIOD) ||
+          (argument > DIO_MAXIMUM_STEP_PERIOD)) {
+        MSG_DIO_STEP_PERIOD_RANGE;
+        mode_configuration.command_error = true;
+        break;
+      }
+      dio_state.step_period = argument;
+    }
+    MSG_DIO_STEP_PERIOD;
+    bp_write_dec_word(dio_state.step_period);
+    bpBR;
+    break;
+
+  case DIO_MACRO_SAMPLE:
+    if (argument == 0) {
+      argument = DIO_DEFAULT_SAMPLES;
+    }
+    if (argument > DIO_BUFFER_SIZE) {
+      argument = DIO_BUFFER_SIZE;
+    }
+    pattern_generator_run(NULL, dio_state.samples, argument,
+                          dio_state.step_period * DIO_CYCLES_PER_US, 1);
+    dio_print_samples(argument);
+    break;
+
+  case DIO_MACRO_RECORD:
+    dio_state.recorded = 0;
+    dio_state.recording_active = true;
+    MSG_DIO_RECORDING;
+    break;
+
+  case DIO_MACRO_PLAY:
+    dio_state.recording_active = false;
+    if (dio_state.recorded == 0) {
+      MSG_DIO_NOTHING_RECORDED;
+      mode_configuration.command_error = true;
+      break;
+    }
+    /* The first pass is sampled, to see what inputs did meanwhile. */
+    pattern_generator_run(dio_state.recording, dio_state.samples,
+                          dio_state.recorded,
+                          dio_state.step_period * DIO_CYCLES_PER_US, argument);
+    dio_print_samples(dio_state.recorded);
+    break;
+
+  default:
+    MSG_UNKNOWN_MACRO_ERROR;
+    break;
+  }
+}
+
+void dio_setup_prepare(void) {
+  dio_state.recorded = 0;
+  dio_state.recording_active = false;
+  dio_state.step_period = DIO_DEFAULT_STEP_PERIOD;
 }
 
 #endif /* BP_ENABLE_DIO_SUPPORT */
\ No newline at end of file
@@ -19,6 +19,8 @@
 
 #include "configuration.h"
 
+#include <stdint.h>
+
 #ifdef BP_ENABLE_DIO_SUPPORT
 
 /**
@@ -26,7 +28,7 @@
  * 
  * @return the value being read.
  */
-unsigned int dio_read(void);
+uint16_t dio_read(void);
 
 /**
  * Writes a value to the device.
@@ -40,7 +42,24 @@ unsigned int dio_read(void);
  * @see binBBpinset
  * @see binBBpindirectionset
  */
-unsigned int dio_write(unsigned int value);
+uint16_t dio_write(const uint16_t value);
+
+/**
+ * Runs the given timed sampling macro.
+ *
+ * Pin states are sampled or played from the pattern generator timer, one
+ * every step period, in the binary I/O pin state layout (AUX, MOSI, CLK, MISO
+ * and CS in bits 4 to 0).  While recording, pin state writes are stored for
+ * playback instead of going out straight away.
+ *
+ * @param[in] macro the macro to run.
+ */
+void dio_run_macro(uint16_t macro);
+
+/**
+ * Stops any recording and goes back to the default step period.
+ */
+void dio_setup_prepare(void);
 
 #endif /* BP_ENABLE_DIO_SUPPORT */
 
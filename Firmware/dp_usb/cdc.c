@@ -20,6 +20,9 @@ or send a letter to
 
 #include <string.h>
 
+#include "../profiling.h"
+#include "../telemetry.h"
+
 enum stopbits {
     one = 0, oneandahalf = 1, two = 2
 };
@@ -51,18 +54,22 @@ BYTE cdc_Out_bufferB[CDC_BUFFER_SIZE];
 struct _cdc_ControlLineState cls;
 BYTE cdc_In_len; // total cdc In length
 volatile BYTE cdc_Out_len; // total cdc out length
-BYTE IsInBufferA;
-BYTE IsOutBufferA;
 BYTE *InPtr;
 BYTE *OutPtr;
 BYTE LineStateUpdated = 0;
 BYTE cdc_timeout_count = 0;
 BYTE ZLPpending = 0;
 BYTE lock = 0;
+BYTE cdc_flush_policy = CDC_FLUSH_ON_TIMEOUT;
 
-BDentry *CDC_Outbdp, *CDC_Inbdp;
+BDentry *CDC_Outbdp, *CDC_Inbdp; // Next BD to be handed out / filled
+BDentry *CDC_Out_heldbdp; // OUT BD being read through OutPtr, re-armed on the next getda_cdc()
+BDentry *CDC_Noticebdp; // Next notification BD to be armed
+volatile BYTE cdc_serial_state_pending = 0; // SERIAL_STATE bits not sent yet
 BYTE CDCFunctionError;
 
+extern volatile BYTE usb_device_state;
+
 volatile BYTE cdc_trf_state; // JTR don't see that it is really volatile in current context may be in future.
 
 void initCDC(void) {
@@ -99,36 +106,60 @@ void user_configured_init(void) {
     USB_UEP2 = USB_EP_INOUT;
 
     /* Configure buffer descriptors */
-#if USB_PP_BUF_MODE == 0
+#if USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG
     // JTR Setup CDC LINE_NOTICE EP (Interrupt IN)
     usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_EVEN)].BDCNT = 0;
     usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_EVEN)].BDADDR = cdc_acm_in_buffer;
-    usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_EVEN)].BDSTAT = DTS + DTSEN; // Set DTS => First packet inverts, ie. is Data0
+    usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_EVEN)].BDSTAT = DTSEN; // EVEN BD is always Data0
+    usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_ODD)].BDCNT = 0;
+    usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_ODD)].BDADDR = cdc_acm_in_buffer;
+    usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_ODD)].BDSTAT = DTS + DTSEN; // ODD BD is always Data1
+    CDC_Noticebdp = &usb_bdt[USB_CALC_BD(1, USB_DIR_IN, USB_PP_EVEN)];
+    cdc_serial_state_pending = 0;
 #else
-    // TODO: Implement Ping-Pong buffering setup.
-#error "PP Mode not implemented yet"
+#error "CDC needs USB_PP_BUF_MODE 3 (ping-pong on all but EP0)"
 #endif
 
     usb_register_class_setup_handler(cdc_setup);
     cdc_trf_state = 0;
-    CDC_Outbdp = &usb_bdt[USB_CALC_BD(2, USB_DIR_OUT, USB_PP_EVEN)];
-    CDC_Inbdp = &usb_bdt[USB_CALC_BD(2, USB_DIR_IN, USB_PP_EVEN)];
 
-    IsInBufferA = 0xFF;
+    // The SIE starts every endpoint on its EVEN BD after a ping-pong reset.
+    // Each BD owns one buffer for good, and since the SIE alternates BDs the
+    // EVEN BD always carries Data0 and the ODD BD Data1.
+    ResetPPbuffers();
+
+    CDC_Inbdp = &usb_bdt[USB_CALC_BD(2, USB_DIR_IN, USB_PP_EVEN)];
     InPtr = cdc_In_bufferA;
     cdc_In_len = 0;
-    CDC_Inbdp->BDADDR = &cdc_In_bufferA[0];
-    CDC_Inbdp->BDCNT = 0;
-    CDC_Inbdp->BDSTAT = DTS + DTSEN;
-
+    CDC_Inbdp[USB_PP_EVEN].BDADDR = &cdc_In_bufferA[0];
+    CDC_Inbdp[USB_PP_EVEN].BDCNT = 0;
+    CDC_Inbdp[USB_PP_EVEN].BDSTAT = DTSEN;
+    CDC_Inbdp[USB_PP_ODD].BDADDR = &cdc_In_bufferB[0];
+    CDC_Inbdp[USB_PP_ODD].BDCNT = 0;
+    CDC_Inbdp[USB_PP_ODD].BDSTAT = DTS + DTSEN;
+
+    // Arm both OUT BDs, so the host can send the next packet while the
+    // previous one is still being read.
+    CDC_Outbdp = &usb_bdt[USB_CALC_BD(2, USB_DIR_OUT, USB_PP_EVEN)];
+    CDC_Out_heldbdp = NULL;
     cdc_Out_len = 0;
-    IsOutBufferA = 0xFF;
     OutPtr = cdc_Out_bufferA;
-    CDC_Outbdp->BDCNT = CDC_BUFFER_SIZE;
-    CDC_Outbdp->BDADDR = &cdc_Out_bufferA[0];
-    CDC_Outbdp->BDSTAT = UOWN + DTSEN;
+    CDC_Outbdp[USB_PP_EVEN].BDCNT = CDC_BUFFER_SIZE;
+    CDC_Outbdp[USB_PP_EVEN].BDADDR = &cdc_Out_bufferA[0];
+    CDC_Outbdp[USB_PP_EVEN].BDSTAT = UOWN + DTSEN;
+    CDC_Outbdp[USB_PP_ODD].BDCNT = CDC_BUFFER_SIZE;
+    CDC_Outbdp[USB_PP_ODD].BDADDR = &cdc_Out_bufferB[0];
+    CDC_Outbdp[USB_PP_ODD].BDSTAT = UOWN + DTS + DTSEN;
+
+#ifdef BP_USB_VENDOR_INTERFACE
+    vendor_configured_init();
+#endif
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+    isochronous_configured_init();
+#endif
 }
 
+
 void cdc_setup(void) {
     BYTE *packet;
     size_t reply_len;
@@ -231,12 +262,28 @@ void cdc_set_control_line_state_status(void) {
     usb_unset_in_handler(0);
 }
 
+// Without USB_INTERRUPTS nothing else services EP0 while we spin, and the host
+// may well send a control request (SET_LINE_CODING...) before its next packet.
+#ifdef USB_INTERRUPTS
+#define CDC_SERVICE_WHILE_WAITING()
+#else
+#define CDC_SERVICE_WHILE_WAITING()     usb_handler()
+#endif
+
 void WaitOutReady(void) {
-    while (CDC_Outbdp->BDSTAT & UOWN) {};
+    while (CDC_Outbdp->BDSTAT & UOWN) {
+        CDC_SERVICE_WHILE_WAITING();
+    };
 }
 
 void WaitInReady(void) {
-    while (CDC_Inbdp->BDSTAT & UOWN) {};
+    // Both IN BDs may be queued, wait for the whole pipe to drain.
+    while (CDC_Inbdp->BDSTAT & UOWN) {
+        CDC_SERVICE_WHILE_WAITING();
+    };
+    while (USB_OTHER_PP_BD(CDC_Inbdp)->BDSTAT & UOWN) {
+        CDC_SERVICE_WHILE_WAITING();
+    };
 }
 
 /******************************************************************************/
@@ -255,19 +302,19 @@ BYTE getda_cdc(void) {
 
     CDCFunctionError = 0;
 
+    // The caller is done with the previous packet, give its BD back to the
+    // SIE with the same data toggle.
+    if (CDC_Out_heldbdp != NULL) {
+        CDC_Out_heldbdp->BDCNT = CDC_BUFFER_SIZE;
+        CDC_Out_heldbdp->BDSTAT = (CDC_Out_heldbdp->BDSTAT & DTS) | UOWN | DTSEN;
+    }
+
     WaitOutReady();
 
-    if ((IsOutBufferA & 1)) {
-        OutPtr = &cdc_Out_bufferA[0];
-        CDC_Outbdp->BDADDR = &cdc_Out_bufferB[0];
-    } else {
-        OutPtr = &cdc_Out_bufferB[0];
-        CDC_Outbdp->BDADDR = &cdc_Out_bufferA[0];
-    }
-    IsOutBufferA ^= 0xFF;
+    OutPtr = CDC_Outbdp->BDADDR;
     cdc_Out_len = CDC_Outbdp->BDCNT;
-    CDC_Outbdp->BDCNT = CDC_BUFFER_SIZE;
-    CDC_Outbdp->BDSTAT = ((CDC_Outbdp->BDSTAT ^ DTS) & DTS) | UOWN | DTSEN;
+    CDC_Out_heldbdp = CDC_Outbdp;
+    CDC_Outbdp = USB_OTHER_PP_BD(CDC_Outbdp);
 #ifndef USB_INTERRUPTS
     usb_handler();
 #endif
@@ -276,22 +323,25 @@ BYTE getda_cdc(void) {
 
 BYTE putda_cdc(BYTE count) {
 
+    BP_PROFILING_ENTER(BP_PROFILING_REGION_CDC_PUTDA);
     //    CDCFunctionError = 0;
-    //    WaitInReady();
-    while ((CDC_Inbdp->BDSTAT & UOWN));
-    if (IsInBufferA) {
-        CDC_Inbdp->BDADDR = cdc_In_bufferA;
-        InPtr = cdc_In_bufferB;
-    } else {
-        CDC_Inbdp->BDADDR = cdc_In_bufferB;
-        InPtr = cdc_In_bufferA;
-    }
+    // InPtr already points into this BD's buffer. Queue it behind the other
+    // BD, which the SIE may still be sending, so packets go out back to back.
     CDC_Inbdp->BDCNT = count;
-    CDC_Inbdp->BDSTAT = ((CDC_Inbdp->BDSTAT ^ DTS) & DTS) | UOWN | DTSEN;
-    IsInBufferA ^= 0xFF;
+    CDC_Inbdp->BDSTAT = (CDC_Inbdp->BDSTAT & DTS) | UOWN | DTSEN;
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_USB_IN_PACKETS);
+    if (count == 0) {
+        BP_TELEMETRY_COUNT(BP_TELEMETRY_USB_ZERO_LENGTH_PACKETS);
+    }
+
+    // Refill the other BD once the SIE has sent it.
+    CDC_Inbdp = USB_OTHER_PP_BD(CDC_Inbdp);
+    while ((CDC_Inbdp->BDSTAT & UOWN));
+    InPtr = CDC_Inbdp->BDADDR;
 #ifndef USB_INTERRUPTS
     usb_handler();
 #endif
+    BP_PROFILING_EXIT(BP_PROFILING_REGION_CDC_PUTDA);
     return 0; //CDCFunctionError;
 }
 
@@ -317,7 +367,10 @@ void CDC_Flush_In_Now(void) {
 /******************************************************************************/
 void CDCFlushOnTimeout(void) {
 
-    if (cdc_timeout_count >= CDC_FLUSH_MS) { // For timeout value see: cdc_config.h -> [hardware] -> CDC_FLUSH_MS
+    BYTE timeout;
+
+    timeout = (cdc_flush_policy == CDC_FLUSH_WHEN_FULL) ? CDC_COALESCE_FLUSH_MS : CDC_FLUSH_MS;
+    if (cdc_timeout_count >= timeout) { // For timeout value see: cdc_config.h -> [hardware] -> CDC_FLUSH_MS
 
         if (cdc_In_len > 0) {
             if ((lock == 0) && getInReady()) {
@@ -330,7 +383,7 @@ void CDCFlushOnTimeout(void) {
                 cdc_In_len = 0;
                 cdc_timeout_count = 0;
             }
-        } else if (ZLPpending) {
+        } else if (ZLPpending && (lock == 0)) {
             putda_cdc(0);
             ZLPpending = 0;
             cdc_timeout_count = 0;
@@ -340,6 +393,74 @@ void CDCFlushOnTimeout(void) {
     }
 }
 
+/******************************************************************************/
+// Selects when partially filled IN packets are sent, returning the previous
+// policy so callers can restore it. Leaving CDC_FLUSH_WHEN_FULL sends what it
+// was holding back.
+
+BYTE CDC_Set_Flush_Policy(BYTE policy) {
+    BYTE previous;
+
+    previous = cdc_flush_policy;
+    cdc_flush_policy = policy;
+    if ((previous == CDC_FLUSH_WHEN_FULL) && (policy != CDC_FLUSH_WHEN_FULL)) {
+        lock = 1;
+        CDC_Flush_In_Now();
+        lock = 0;
+    }
+    return previous;
+}
+
+/******************************************************************************/
+// Called once a reply is complete. In CDC_FLUSH_ON_RESPONSE mode this sends
+// any partial packet, and the ZLP ending a transfer, without waiting for the
+// SOF timeout.
+
+void CDC_Flush_End_Of_Response(void) {
+    if (cdc_flush_policy != CDC_FLUSH_ON_RESPONSE) {
+        return;
+    }
+
+    lock = 1; // Keeps CDCFlushOnTimeout() out while the buffer is handed over.
+    if (cdc_In_len > 0) {
+        CDC_Flush_In_Now();
+    }
+    if (ZLPpending) {
+        putda_cdc(0);
+        ZLPpending = 0;
+    }
+    lock = 0;
+    cdc_timeout_count = 0;
+}
+
+/******************************************************************************/
+// Copies a whole buffer into the CDC In buffers, submitting each one as soon
+// as it is full rather than going through putc_cdc() one byte at a time.
+void putbuffer_cdc(const BYTE *buffer, unsigned int length) {
+    BYTE chunk;
+
+    lock = 1; // Stops CDCFlushOnTimeout() from sending per chance it is on interrupts.
+    while (length > 0) {
+        chunk = CDC_BUFFER_SIZE - cdc_In_len;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(InPtr, buffer, chunk);
+        InPtr += chunk;
+        cdc_In_len += chunk;
+        buffer += chunk;
+        length -= chunk;
+        ZLPpending = 0;
+        if (cdc_In_len == CDC_BUFFER_SIZE) {
+            putda_cdc(cdc_In_len); // Stalls if both buffers are full, as putc_cdc() does.
+            cdc_In_len = 0;
+            ZLPpending = 1; // timeout handled in the SOF handler below.
+        }
+    }
+    lock = 0;
+    cdc_timeout_count = 0; //setup timer to throw data if the buffer doesn't fill
+}
+
 /******************************************************************************/
 void putc_cdc(BYTE c) {
     lock = 1; // Stops CDCFlushOnTimeout() from sending per chance it is on interrupts.
@@ -375,6 +496,27 @@ BYTE getc_cdc(void) { // Must be used only in double buffer mode.
     return c;
 }
 
+/******************************************************************************/
+// Hands out up to maximum bytes straight from the CDC OUT packet buffer,
+// waiting for a packet if none is pending. The bytes count as read, and stay
+// valid until the next call reading from the OUT endpoint, which is also when
+// getda_cdc() gives the packet buffer back to the SIE.
+
+BYTE *borrow_cdc(BYTE maximum, BYTE *length) { // Must be used only in double buffer mode.
+    BYTE *data;
+
+    if (cdc_Out_len == 0) {
+        do {
+            cdc_Out_len = getda_cdc();
+        } while (cdc_Out_len == 0); // Skip any ZLP
+    }
+    *length = (cdc_Out_len < maximum) ? cdc_Out_len : maximum;
+    data = OutPtr;
+    OutPtr += *length;
+    cdc_Out_len -= *length;
+    return data;
+}
+
 /******************************************************************************/
 // Checks to see if there is a byte available in the CDC buffer.
 // If so, it returns that byte at the dereferenced pointer *C
@@ -426,3 +568,46 @@ BYTE peek_getc_cdc(BYTE * c) { // Must be used only in double buffer mode.
     return 0;
 }
 
+
+/******************************************************************************/
+// Queues irregular SERIAL_STATE bits for the notification endpoint. Only ORs
+// them in, so it can be called from any interrupt handler; events raised
+// before the host collects the notification are merged into it.
+
+void cdc_notify_serial_state(BYTE state) {
+    cdc_serial_state_pending |= state;
+}
+
+/******************************************************************************/
+// SOF handler. Both notification BDs share cdc_acm_in_buffer, so a new
+// notification is only built once the host has collected the previous one.
+
+void cdc_serial_state_on_timeout(void) {
+    BYTE state;
+
+    if ((usb_device_state < CONFIGURED_STATE) || (cdc_serial_state_pending == 0)) {
+        return;
+    }
+
+    if (USB_OTHER_PP_BD(CDC_Noticebdp)->BDSTAT & UOWN) {
+        return;
+    }
+
+    state = cdc_serial_state_pending;
+    cdc_serial_state_pending &= ~state;
+
+    cdc_acm_in_buffer[0] = (USB_bmRequestType_D2H | USB_bmRequestType_Class | USB_bmRequestType_Interface);
+    cdc_acm_in_buffer[1] = CDC_SERIAL_STATE;
+    cdc_acm_in_buffer[2] = 0x00; // wValue
+    cdc_acm_in_buffer[3] = 0x00;
+    cdc_acm_in_buffer[4] = 0x00; // wIndex, the CDC control interface
+    cdc_acm_in_buffer[5] = 0x00;
+    cdc_acm_in_buffer[6] = 0x02; // wLength
+    cdc_acm_in_buffer[7] = 0x00;
+    cdc_acm_in_buffer[8] = state; // UART state bitmap
+    cdc_acm_in_buffer[9] = 0x00;
+
+    CDC_Noticebdp->BDCNT = CDC_NOTICE_BUFFER_SIZE;
+    CDC_Noticebdp->BDSTAT = (CDC_Noticebdp->BDSTAT & DTS) | UOWN | DTSEN;
+    CDC_Noticebdp = USB_OTHER_PP_BD(CDC_Noticebdp);
+}
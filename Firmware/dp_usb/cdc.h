@@ -29,14 +29,34 @@ BYTE getda_cdc(void);
 BYTE putda_cdc(BYTE count);
 void SendZLP(void);
 BYTE getc_cdc(void);
+BYTE *borrow_cdc(BYTE maximum, BYTE *length);
 void putc_cdc(BYTE c);
+void putbuffer_cdc(const BYTE *buffer, unsigned int length);
 void CDC_Flush_In_Now(void);
 void CDCFlushOnTimeout(void);
+BYTE CDC_Set_Flush_Policy(BYTE policy);
+void CDC_Flush_End_Of_Response(void);
 BYTE poll_getc_cdc(BYTE * c);
 BYTE peek_getc_cdc(BYTE * c);
 void initCDC(void);
+void cdc_notify_serial_state(BYTE state); // Interrupt safe, sent from the SOF handler.
+void cdc_serial_state_on_timeout(void); // SOF handler, sends queued SERIAL_STATE bits.
 
 
+// CDC IN flush policies, see CDC_Set_Flush_Policy()
+#define CDC_FLUSH_ON_TIMEOUT    0 // Partial packets go out after CDC_FLUSH_MS
+#define CDC_FLUSH_ON_RESPONSE   1 // Same, and CDC_Flush_End_Of_Response() sends them at once
+#define CDC_FLUSH_WHEN_FULL     2 // Partial packets wait CDC_COALESCE_FLUSH_MS
+
+// SERIAL_STATE notification UART state bits, see cdc_notify_serial_state()
+#define CDC_SERIAL_STATE_RX_CARRIER     0x01 // DCD
+#define CDC_SERIAL_STATE_TX_CARRIER     0x02 // DSR
+#define CDC_SERIAL_STATE_BREAK          0x04
+#define CDC_SERIAL_STATE_RING_SIGNAL    0x08
+#define CDC_SERIAL_STATE_FRAMING        0x10
+#define CDC_SERIAL_STATE_PARITY         0x20
+#define CDC_SERIAL_STATE_OVERRUN        0x40
+
 struct _cdc_ControlLineState {
     int DTR : 1;
     int RTS : 1;
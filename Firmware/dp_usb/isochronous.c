@@ -0,0 +1,160 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "../dp_usb/usb_stack_globals.h"    // USB stack only defines Not function related.
+
+#include <string.h>
+
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+
+#if USB_PP_BUF_MODE != ALL_BUT_EP0_PINGPONG
+#error "The isochronous pipe needs USB_PP_BUF_MODE 3 (ping-pong on all but EP0)"
+#endif
+
+// Isochronous endpoints must not handshake.
+#define ISOCHRONOUS_EP_IN               (USB_UEP_EPINEN | USB_UEP_EPCONDIS)
+
+extern volatile BYTE usb_device_state;
+
+#pragma udata usb_data3
+BYTE isochronous_bufferA[ISOCHRONOUS_PACKET_SIZE];
+BYTE isochronous_bufferB[ISOCHRONOUS_PACKET_SIZE];
+
+#pragma udata
+
+static BDentry *isochronous_fillbdp; // BD whose buffer is being filled
+static volatile unsigned int isochronous_fill_len; // Header included
+static unsigned int isochronous_offset; // Stream offset of the first byte being filled
+static volatile BYTE isochronous_alt = 0;
+static volatile BYTE isochronous_lock = 0;
+
+void isochronous_configured_init(void) {
+    // Both BDs own one buffer for good and are armed in turn, one per frame,
+    // so the SIE ping-pong pointer always points at the BD armed next. The
+    // caller has already reset the ping-pong pointers.
+    USB_UEP4 = USB_EP_NONE;
+    isochronous_alt = 0;
+
+    isochronous_fillbdp = &usb_bdt[USB_CALC_BD(ISOCHRONOUS_ENDPOINT, USB_DIR_IN, USB_PP_EVEN)];
+    isochronous_fillbdp[USB_PP_EVEN].BDADDR = &isochronous_bufferA[0];
+    isochronous_fillbdp[USB_PP_EVEN].BDCNT = 0;
+    isochronous_fillbdp[USB_PP_EVEN].BDSTAT = 0;
+    isochronous_fillbdp[USB_PP_ODD].BDADDR = &isochronous_bufferB[0];
+    isochronous_fillbdp[USB_PP_ODD].BDCNT = 0;
+    isochronous_fillbdp[USB_PP_ODD].BDSTAT = 0;
+    isochronous_fill_len = ISOCHRONOUS_HEADER_SIZE;
+    isochronous_offset = 0;
+}
+
+/******************************************************************************/
+// Called from the SET_INTERFACE handler. A packet still queued when the
+// endpoint is disabled stays with the SIE, keeping BDs and ping-pong pointer in
+// step, and goes out first when the host selects alternate setting 1 again.
+
+BYTE isochronous_set_alternate(BYTE alternate) {
+    if (alternate > 1u) {
+        return 0;
+    }
+
+    if (alternate && !isochronous_alt) {
+        isochronous_fill_len = ISOCHRONOUS_HEADER_SIZE;
+    }
+    USB_UEP4 = alternate ? ISOCHRONOUS_EP_IN : USB_EP_NONE;
+    isochronous_alt = alternate;
+    return 1;
+}
+
+/******************************************************************************/
+BYTE isochronous_alternate(void) {
+    return isochronous_alt;
+}
+
+/******************************************************************************/
+BYTE isochronous_active(void) {
+    return (usb_device_state >= CONFIGURED_STATE) && isochronous_alt;
+}
+
+/******************************************************************************/
+// Only waits when the packet being filled is full, which the SOF handler
+// either queues or drops within a frame.
+
+void isochronous_putbuffer(const BYTE *buffer, unsigned int length) {
+    unsigned int chunk;
+
+    while (length > 0) {
+        while (isochronous_fill_len == ISOCHRONOUS_PACKET_SIZE) {
+            if (!isochronous_alt) {
+                return; // The host went away, drop the rest.
+            }
+#ifndef USB_INTERRUPTS
+            usb_handler();
+#endif
+        }
+
+        isochronous_lock = 1; // Keeps isochronous_start_of_frame() out.
+        chunk = ISOCHRONOUS_PACKET_SIZE - isochronous_fill_len;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(isochronous_fillbdp->BDADDR + isochronous_fill_len, buffer, chunk);
+        isochronous_fill_len += chunk;
+        isochronous_lock = 0;
+        buffer += chunk;
+        length -= chunk;
+    }
+}
+
+/******************************************************************************/
+void isochronous_start_of_frame(void) {
+    BDentry *queuedbdp;
+    BYTE *packet;
+    unsigned int frame;
+
+    if ((usb_device_state < CONFIGURED_STATE) || !isochronous_alt || isochronous_lock) {
+        return;
+    }
+
+    if (isochronous_fill_len == ISOCHRONOUS_HEADER_SIZE) {
+        return; // Nothing to send.
+    }
+
+    queuedbdp = USB_OTHER_PP_BD(isochronous_fillbdp);
+    if (queuedbdp->BDSTAT & UOWN) {
+        // The host did not collect the last packet. Keep the producer going,
+        // the data it loses shows up as a gap in the offsets.
+        if (isochronous_fill_len == ISOCHRONOUS_PACKET_SIZE) {
+            isochronous_offset += ISOCHRONOUS_PACKET_SIZE - ISOCHRONOUS_HEADER_SIZE;
+            isochronous_fill_len = ISOCHRONOUS_HEADER_SIZE;
+        }
+        return;
+    }
+
+    frame = U1FRML | (U1FRMH << 8);
+    packet = isochronous_fillbdp->BDADDR;
+    packet[0] = LOWB(frame);
+    packet[1] = HIGHB(frame);
+    packet[2] = LOWB(isochronous_offset);
+    packet[3] = HIGHB(isochronous_offset);
+
+    isochronous_fillbdp->BDCNT = isochronous_fill_len;
+    isochronous_fillbdp->BDSTAT = UOWN; // Always Data0, no toggle on isochronous pipes.
+    isochronous_offset += isochronous_fill_len - ISOCHRONOUS_HEADER_SIZE;
+    isochronous_fillbdp = queuedbdp;
+    isochronous_fill_len = ISOCHRONOUS_HEADER_SIZE;
+}
+
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
@@ -0,0 +1,43 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __ISOCHRONOUS_H__
+#define __ISOCHRONOUS_H__
+
+// Isochronous IN pipe for streaming captures, exposed when
+// BP_USB_ISOCHRONOUS_STREAM is set. Alternate setting 0 of its interface has
+// no endpoint; selecting alternate setting 1 reserves the bandwidth and routes
+// the ADC and SUMP streams here instead of the serial port.
+//
+// The SOF handler queues at most one packet per frame. Each packet starts with
+// a header of two little endian words: the frame number it was queued in, and
+// the stream offset of its first data byte (low 16 bits). Data that could not
+// be queued in time is dropped but still counted in the offset, so the host
+// sees a gap whenever the offset does not follow on from the previous packet.
+
+#define ISOCHRONOUS_ENDPOINT            4u
+#define ISOCHRONOUS_PACKET_SIZE         256u
+#define ISOCHRONOUS_HEADER_SIZE         4u
+
+void isochronous_configured_init(void); // Called from user_configured_init().
+BYTE isochronous_set_alternate(BYTE alternate); // 0 if the setting does not exist.
+BYTE isochronous_alternate(void);
+BYTE isochronous_active(void);
+void isochronous_putbuffer(const BYTE *buffer, unsigned int length);
+void isochronous_start_of_frame(void); // SOF handler.
+
+#endif
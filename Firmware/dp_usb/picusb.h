@@ -97,6 +97,12 @@ entries common to both PIC families.
 #define USB_PP_EVEN     0
 #define USB_PP_ODD      1
 
+/* Values for USB_PP_BUF_MODE, as written to the ping-pong configuration bits */
+#define NO_PINGPONG             0
+#define EP0_OUT_PINGPONG        1
+#define FULL_PINGPONG           2
+#define ALL_BUT_EP0_PINGPONG    3
+
 
 /* PIC DEFINES SPECIFIC TO PIC18 */
 
@@ -264,6 +270,7 @@ typedef unsigned char usb_uep_t;
 #if USB_PP_BUF_MODE == NO_PINGPONG
 #define USB_USTAT2BD(X)                         ( (X)/4 )
 #define USB_CALC_BD(ep, dir, sync)              ( 2*(ep)+(dir) )
+#define USB_BDT_ENTRIES                         ( 2 + 2*MAX_EPNUM_USED )
 #elif USB_PP_BUF_MODE == 1
 #error "USB_PP_BUF_MODE outside scope."
 #define USB_USTAT2BD(X)                         ( ((X)>2)? (X)/4+1 : (X)/2 )
@@ -488,6 +495,16 @@ typedef unsigned int usb_uep_t; // JTR PIC24 fixup potentially ?? changed from c
 #if USB_PP_BUF_MODE == NO_PINGPONG
 #define USB_USTAT2BD(X)                         ( (X)/8 )  //JTR PIC24 fixups
 #define USB_CALC_BD(ep, dir, sync)              ( 2*(ep)+(dir) )
+#define USB_BDT_ENTRIES                         ( 2 + 2*MAX_EPNUM_USED )
+
+/*
+ * U1STAT holds ENDPT in bits 7:4, DIR in bit 3 and PPBI in bit 2. EP0 has a
+ * single BD per direction, every other endpoint an EVEN/ODD pair per direction.
+ */
+#elif USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG
+#define USB_USTAT2BD(X)                         ( ((X) >= 0x10)? (X)/4-2 : (X)/8 )
+#define USB_CALC_BD(ep, dir, sync)              ( ((ep)==0)? (dir) : 4*(ep)+2*(dir)+(sync)-2 )
+#define USB_BDT_ENTRIES                         ( 2 + 4*MAX_EPNUM_USED )
 
 // JTR TODO these values may need to be changed for the PIC24
 //#elif USB_PP_BUF_MODE == 1
@@ -496,9 +513,6 @@ typedef unsigned int usb_uep_t; // JTR PIC24 fixup potentially ?? changed from c
 //#elif USB_PP_BUF_MODE == 2              
 //#define USB_USTAT2BD(X)                       ( (X)/2 )
 //#define USB_CALC_BD(ep, dir, sync)            ( 4*(ep)+2*(dir)+(sync) )
-//#elif USB_PP_BUF_MODE == 3
-//#define USB_USTAT2BD(X)                       ( ((X)>4)? (X)/2-2 : (X)/4 )
-//#define USB_CALC_BD(ep, dir, sync)            ( ((ep)==0)? (dir) : 4*(ep)+2*(dir)+(sync)-2 )
 
 #else
 #error "USB_PP_BUF_MODE outside scope."
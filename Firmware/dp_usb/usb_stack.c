@@ -54,7 +54,7 @@ usb_ep_t endpoints[MAX_CHIP_EP]; // JTR change. MAX_CHIP_EP is the number of har
 
 #if defined(PIC_18F)
 #pragma udata usb_bdt
-BDentry usb_bdt[2 + 2 * MAX_EPNUM_USED]; // JTR changed index from 32 to variable
+BDentry usb_bdt[USB_BDT_ENTRIES]; // JTR changed index from 32 to variable
 #pragma udata usb_data
 //* Only claim buffer for ep 0 */
 #if USB_PP_BUF_MODE == 0
@@ -66,8 +66,8 @@ BYTE usb_ep0_in_buf[USB_EP0_BUFFER_SIZE];
 
 #elif defined(PIC_24F)
 #pragma udata usb_bdt
-BDentry usb_bdt[2 + 2 * MAX_EPNUM_USED] __attribute__((aligned(512))); // JTR changed index from 32 to variable TODO: Dynamic allocation reflecting number of used endpoints. (How to do counting in preprocessor?)
-#if USB_PP_BUF_MODE == 0
+BDentry usb_bdt[USB_BDT_ENTRIES] __attribute__((aligned(512))); // JTR changed index from 32 to variable TODO: Dynamic allocation reflecting number of used endpoints. (How to do counting in preprocessor?)
+#if (USB_PP_BUF_MODE == NO_PINGPONG) || (USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG)
 BYTE usb_ep0_out_buf[USB_EP0_BUFFER_SIZE];
 BYTE usb_ep0_in_buf[USB_EP0_BUFFER_SIZE];
 #else
@@ -146,7 +146,7 @@ void ClearUSBtoDefault(void) {
         USB_UEP[i] = 0;
     }
 
-    for (i = 0; i < (2 + 2 * MAX_EPNUM_USED); i++) {
+    for (i = 0; i < USB_BDT_ENTRIES; i++) {
         usb_bdt[i].BDSTAT = 0;
     }
 
@@ -169,7 +169,8 @@ void ClearUSBtoDefault(void) {
     usb_current_cfg = 0; // JTR formally usb_configured
     usb_addr_pending = 0x00;
 
-#if USB_PP_BUF_MODE == NO_PINGPONG
+    /* EP0 has a single BD per direction in both supported modes. */
+#if (USB_PP_BUF_MODE == NO_PINGPONG) || (USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG)
     usb_bdt[USB_CALC_BD(0, USB_DIR_OUT, USB_PP_EVEN)].BDCNT = USB_EP0_BUFFER_SIZE; // JTR endpoints[0].buffer_size; same thing done more obviously
     usb_bdt[USB_CALC_BD(0, USB_DIR_OUT, USB_PP_EVEN)].BDADDR = usb_ep0_out_buf; //endpoints[0].out_buffer;
     usb_bdt[USB_CALC_BD(0, USB_DIR_OUT, USB_PP_EVEN)].BDSTAT = UOWN + DTSEN;
@@ -418,11 +419,25 @@ void usb_handle_StandardInterfaceRequest(BDentry *bdp) {
             if (USB_NUM_INTERFACES > packet[USB_bInterface]) {
                 // TODO: Implement alternative interfaces, or move responsibility to class/vendor functions.
                 EP0_Inbdp->BDADDR[0] = 0;
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+                if (USB_ISOCHRONOUS_INTERFACE == packet[USB_bInterface])
+                    EP0_Inbdp->BDADDR[0] = isochronous_alternate();
+#endif
                 usb_ack_dat1(1);
             } else
                 usb_RequestError();
             break;
         case USB_REQUEST_SET_INTERFACE:
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+            // The streaming interface only reserves bandwidth in setting 1.
+            if (USB_ISOCHRONOUS_INTERFACE == packet[USB_bInterface]) {
+                if (isochronous_set_alternate(packet[USB_wValue]))
+                    usb_ack_dat1(0);
+                else
+                    usb_RequestError();
+                break;
+            }
+#endif
             if (USB_NUM_INTERFACES > packet[USB_bInterface] && 0u == packet[USB_wValue]) {
                 // TODO: Implement alternative interfaces...
                 usb_ack_dat1(0);
@@ -454,9 +469,13 @@ void usb_handle_StandardEndpointRequest(BDentry *bdp) {
             epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_EVEN)];
             if (epbd->BDSTAT &= ~BSTALL)
                 EP0_Inbdp->BDADDR[0] = 0x01; // EVEN BD is stall flag set?
-            //epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
-            //if (epbd->BDSTAT &= ~BSTALL)
-            //    rbdp->BDADDR[0] = 0x01; // ODD BD is stall flag set?
+#if USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG
+            if (epnum) {
+                epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
+                if (epbd->BDSTAT & BSTALL)
+                    EP0_Inbdp->BDADDR[0] = 0x01; // ODD BD is stall flag set?
+            }
+#endif
             usb_ack_dat1(2);
             break;
 
@@ -477,14 +496,16 @@ void usb_handle_StandardEndpointRequest(BDentry *bdp) {
             if (dir) epbd->BDSTAT |= DTS; // JTR added IN EP set DTS as it will be toggled to zero next transfer
             if (0 == dir) epbd->BDSTAT &= ~DTS; // JTR added
 
-            // JTR this pointless ATM. If ping-pong is enabled then you need to track PPBI
-            // and set up ODD and EVEN BDs in respect to this. See complicated system in
-            // microchip stack >= 2.8
-
-            //		epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
-            //		epbd->BDSTAT &= ~BSTALL;
-            //		if (dir) epbd->BDSTAT |= DTS;		// JTR added
-            //		if (0 == dir) epbd->BDSTAT &= ~DTS;	// JTR added
+#if USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG
+            // With ping-pong the EVEN BD always carries DATA0 and the ODD BD
+            // DATA1, and the class code keeps each BD's DTS fixed. Restore both.
+            if (epnum) {
+                epbd->BDSTAT &= ~(BSTALL | DTS);
+                epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
+                epbd->BDSTAT &= ~BSTALL;
+                epbd->BDSTAT |= DTS;
+            }
+#endif
 
 
             usb_ack_dat1(0);
@@ -496,8 +517,12 @@ void usb_handle_StandardEndpointRequest(BDentry *bdp) {
             dir = packet[USB_wIndex] >> 7;
             epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_EVEN)];
             epbd->BDSTAT |= BSTALL;
-            //epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
-            //epbd->BDSTAT |= BSTALL;
+#if USB_PP_BUF_MODE == ALL_BUT_EP0_PINGPONG
+            if (epnum) {
+                epbd = &usb_bdt[USB_CALC_BD(epnum, dir, USB_PP_ODD)];
+                epbd->BDSTAT |= BSTALL;
+            }
+#endif
             usb_ack_dat1(0);
             break;
         case USB_REQUEST_SYNCH_FRAME:
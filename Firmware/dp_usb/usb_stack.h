@@ -123,6 +123,10 @@ typedef struct USB_EP_TYPE {
 
 extern BDentry usb_bdt[];
 
+// The other BD of the EVEN/ODD pair bdp belongs to. Pairs start on an even
+// usb_bdt index for every endpoint but EP0 when ping-pong is enabled.
+#define USB_OTHER_PP_BD(bdp)    (&usb_bdt[((bdp) - usb_bdt) ^ USB_PP_ODD])
+
 typedef struct USB_DEVICE_REQUEST {
     BYTE bmRequestType;
     BYTE bRequest;
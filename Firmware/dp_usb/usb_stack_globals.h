@@ -9,6 +9,8 @@ typedef unsigned char BYTE;
 #include "../prj_usb_config.h" // from parent folder.
 #include "usb_stack.h"
 #include "cdc.h"
+#include "vendor.h"
+#include "isochronous.h"
 
 #include <string.h>
 
@@ -0,0 +1,277 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "../dp_usb/usb_stack_globals.h"    // USB stack only defines Not function related.
+
+#include <string.h>
+
+#ifdef BP_USB_VENDOR_INTERFACE
+
+#if USB_PP_BUF_MODE != ALL_BUT_EP0_PINGPONG
+#error "The vendor pipe needs USB_PP_BUF_MODE 3 (ping-pong on all but EP0)"
+#endif
+
+extern volatile BYTE usb_device_state;
+
+#pragma udata usb_data3
+BYTE vendor_In_bufferA[VENDOR_BUFFER_SIZE];
+BYTE vendor_In_bufferB[VENDOR_BUFFER_SIZE];
+BYTE vendor_Out_bufferA[VENDOR_BUFFER_SIZE];
+BYTE vendor_Out_bufferB[VENDOR_BUFFER_SIZE];
+
+#pragma udata
+
+static BDentry *vendor_Outbdp, *vendor_Inbdp; // Next BD to be handed out / filled
+static BDentry *vendor_Out_heldbdp; // OUT BD being read, re-armed on the next vendor_getda()
+static BYTE *vendor_InPtr;
+static BYTE *vendor_OutPtr;
+static BYTE vendor_In_len;
+static volatile BYTE vendor_Out_len;
+static BYTE vendor_timeout_count = 0;
+static BYTE vendor_ZLPpending = 0;
+static BYTE vendor_lock = 0;
+static BYTE vendor_flush_policy = CDC_FLUSH_ON_TIMEOUT;
+
+static BYTE vendor_getda(void);
+static void vendor_putda(BYTE count);
+static void vendor_wait_bd(BDentry *bdp);
+
+void vendor_configured_init(void) {
+    // Same layout as the CDC data endpoint: each BD owns one buffer, the EVEN
+    // BD always carries Data0 and the ODD BD Data1. The caller has already
+    // reset the ping-pong pointers.
+    USB_UEP3 = USB_EP_INOUT;
+
+    vendor_Inbdp = &usb_bdt[USB_CALC_BD(VENDOR_ENDPOINT, USB_DIR_IN, USB_PP_EVEN)];
+    vendor_InPtr = vendor_In_bufferA;
+    vendor_In_len = 0;
+    vendor_ZLPpending = 0;
+    vendor_Inbdp[USB_PP_EVEN].BDADDR = &vendor_In_bufferA[0];
+    vendor_Inbdp[USB_PP_EVEN].BDCNT = 0;
+    vendor_Inbdp[USB_PP_EVEN].BDSTAT = DTSEN;
+    vendor_Inbdp[USB_PP_ODD].BDADDR = &vendor_In_bufferB[0];
+    vendor_Inbdp[USB_PP_ODD].BDCNT = 0;
+    vendor_Inbdp[USB_PP_ODD].BDSTAT = DTS + DTSEN;
+
+    vendor_Outbdp = &usb_bdt[USB_CALC_BD(VENDOR_ENDPOINT, USB_DIR_OUT, USB_PP_EVEN)];
+    vendor_Out_heldbdp = NULL;
+    vendor_Out_len = 0;
+    vendor_OutPtr = vendor_Out_bufferA;
+    vendor_Outbdp[USB_PP_EVEN].BDCNT = VENDOR_BUFFER_SIZE;
+    vendor_Outbdp[USB_PP_EVEN].BDADDR = &vendor_Out_bufferA[0];
+    vendor_Outbdp[USB_PP_EVEN].BDSTAT = UOWN + DTSEN;
+    vendor_Outbdp[USB_PP_ODD].BDCNT = VENDOR_BUFFER_SIZE;
+    vendor_Outbdp[USB_PP_ODD].BDADDR = &vendor_Out_bufferB[0];
+    vendor_Outbdp[USB_PP_ODD].BDSTAT = UOWN + DTS + DTSEN;
+}
+
+/******************************************************************************/
+// As in cdc.c, the polled build must keep EP0 serviced while spinning.
+
+void vendor_wait_bd(BDentry *bdp) {
+    while (bdp->BDSTAT & UOWN) {
+#ifndef USB_INTERRUPTS
+        usb_handler();
+#endif
+    };
+}
+
+/******************************************************************************/
+BYTE vendor_out_ready(void) {
+    if (usb_device_state < CONFIGURED_STATE) {
+        return 0; // Nothing set up yet.
+    }
+    return vendor_Out_len || !(vendor_Outbdp->BDSTAT & UOWN);
+}
+
+/******************************************************************************/
+BYTE vendor_getda(void) {
+    // The caller is done with the previous packet, give it back to the SIE.
+    if (vendor_Out_heldbdp != NULL) {
+        vendor_Out_heldbdp->BDCNT = VENDOR_BUFFER_SIZE;
+        vendor_Out_heldbdp->BDSTAT = (vendor_Out_heldbdp->BDSTAT & DTS) | UOWN | DTSEN;
+    }
+
+    vendor_wait_bd(vendor_Outbdp);
+
+    vendor_OutPtr = vendor_Outbdp->BDADDR;
+    vendor_Out_len = vendor_Outbdp->BDCNT;
+    vendor_Out_heldbdp = vendor_Outbdp;
+    vendor_Outbdp = USB_OTHER_PP_BD(vendor_Outbdp);
+    return vendor_Out_len;
+}
+
+/******************************************************************************/
+BYTE vendor_getc(void) {
+    BYTE c;
+
+    if (vendor_Out_len == 0) {
+        do {
+            vendor_getda();
+        } while (vendor_Out_len == 0); // Skip any ZLP
+    }
+    c = *vendor_OutPtr;
+    vendor_OutPtr++;
+    vendor_Out_len--;
+    return c;
+}
+
+/******************************************************************************/
+// Same contract as borrow_cdc().
+
+BYTE *vendor_borrow(BYTE maximum, BYTE *length) {
+    BYTE *data;
+
+    if (vendor_Out_len == 0) {
+        do {
+            vendor_getda();
+        } while (vendor_Out_len == 0); // Skip any ZLP
+    }
+    *length = (vendor_Out_len < maximum) ? vendor_Out_len : maximum;
+    data = vendor_OutPtr;
+    vendor_OutPtr += *length;
+    vendor_Out_len -= *length;
+    return data;
+}
+
+/******************************************************************************/
+void vendor_putda(BYTE count) {
+    vendor_Inbdp->BDCNT = count;
+    vendor_Inbdp->BDSTAT = (vendor_Inbdp->BDSTAT & DTS) | UOWN | DTSEN;
+
+    vendor_Inbdp = USB_OTHER_PP_BD(vendor_Inbdp);
+    vendor_wait_bd(vendor_Inbdp);
+    vendor_InPtr = vendor_Inbdp->BDADDR;
+}
+
+/******************************************************************************/
+void vendor_putc(BYTE c) {
+    vendor_lock = 1; // Keeps vendor_flush_on_timeout() out.
+    *vendor_InPtr = c;
+    vendor_InPtr++;
+    vendor_In_len++;
+    vendor_ZLPpending = 0;
+    if (vendor_In_len == VENDOR_BUFFER_SIZE) {
+        vendor_putda(vendor_In_len);
+        vendor_In_len = 0;
+        vendor_ZLPpending = 1;
+    }
+    vendor_lock = 0;
+    vendor_timeout_count = 0;
+}
+
+/******************************************************************************/
+void vendor_putbuffer(const BYTE *buffer, unsigned int length) {
+    BYTE chunk;
+
+    vendor_lock = 1; // Keeps vendor_flush_on_timeout() out.
+    while (length > 0) {
+        chunk = VENDOR_BUFFER_SIZE - vendor_In_len;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(vendor_InPtr, buffer, chunk);
+        vendor_InPtr += chunk;
+        vendor_In_len += chunk;
+        buffer += chunk;
+        length -= chunk;
+        vendor_ZLPpending = 0;
+        if (vendor_In_len == VENDOR_BUFFER_SIZE) {
+            vendor_putda(vendor_In_len);
+            vendor_In_len = 0;
+            vendor_ZLPpending = 1;
+        }
+    }
+    vendor_lock = 0;
+    vendor_timeout_count = 0;
+}
+
+/******************************************************************************/
+void vendor_flush(void) {
+    vendor_lock = 1;
+    if (vendor_In_len > 0) {
+        vendor_putda(vendor_In_len);
+        vendor_ZLPpending = (vendor_In_len == VENDOR_BUFFER_SIZE);
+        vendor_In_len = 0;
+    }
+    vendor_lock = 0;
+    vendor_timeout_count = 0;
+}
+
+/******************************************************************************/
+void vendor_wait_in_ready(void) {
+    vendor_wait_bd(vendor_Inbdp);
+    vendor_wait_bd(USB_OTHER_PP_BD(vendor_Inbdp));
+}
+
+/******************************************************************************/
+BYTE vendor_set_flush_policy(BYTE policy) {
+    BYTE previous;
+
+    previous = vendor_flush_policy;
+    vendor_flush_policy = policy;
+    if ((previous == CDC_FLUSH_WHEN_FULL) && (policy != CDC_FLUSH_WHEN_FULL)) {
+        vendor_flush();
+    }
+    return previous;
+}
+
+/******************************************************************************/
+// A short packet (or a ZLP after a full one) ends the host's bulk transfer,
+// so this is what completes a libusb read waiting for the reply.
+
+void vendor_end_of_response(void) {
+    if (vendor_flush_policy != CDC_FLUSH_ON_RESPONSE) {
+        return;
+    }
+
+    vendor_flush();
+    vendor_lock = 1;
+    if (vendor_ZLPpending) {
+        vendor_putda(0);
+        vendor_ZLPpending = 0;
+    }
+    vendor_lock = 0;
+}
+
+/******************************************************************************/
+void vendor_flush_on_timeout(void) {
+    BYTE timeout;
+
+    if ((usb_device_state < CONFIGURED_STATE) || vendor_lock) {
+        return;
+    }
+
+    timeout = (vendor_flush_policy == CDC_FLUSH_WHEN_FULL) ? CDC_COALESCE_FLUSH_MS : CDC_FLUSH_MS;
+    if (vendor_timeout_count < timeout) {
+        vendor_timeout_count++;
+        return;
+    }
+
+    if ((vendor_In_len > 0) && !(vendor_Inbdp->BDSTAT & UOWN)) {
+        vendor_putda(vendor_In_len);
+        vendor_ZLPpending = (vendor_In_len == VENDOR_BUFFER_SIZE);
+        vendor_In_len = 0;
+        vendor_timeout_count = 0;
+    } else if ((vendor_In_len == 0) && vendor_ZLPpending) {
+        vendor_putda(0);
+        vendor_ZLPpending = 0;
+        vendor_timeout_count = 0;
+    }
+}
+
+#endif /* BP_USB_VENDOR_INTERFACE */
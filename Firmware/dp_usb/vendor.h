@@ -0,0 +1,44 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __VENDOR_H__
+#define __VENDOR_H__
+
+// Vendor specific bulk pipe, exposed next to the CDC interface when
+// BP_USB_VENDOR_INTERFACE is set. It carries raw binary mode traffic to host
+// tools talking to the device through libusb, with no tty layer in between.
+//
+// Packets are handled the same way as on the CDC data interface: both
+// directions use hardware ping-pong, IN packets go out when full or on a flush,
+// OUT packets are consumed in place.
+
+#define VENDOR_ENDPOINT                 3u
+#define VENDOR_BUFFER_SIZE              64u
+
+void vendor_configured_init(void); // Called from user_configured_init().
+BYTE vendor_out_ready(void);
+BYTE vendor_getc(void);
+BYTE *vendor_borrow(BYTE maximum, BYTE *length);
+void vendor_putc(BYTE c);
+void vendor_putbuffer(const BYTE *buffer, unsigned int length);
+void vendor_flush(void);
+void vendor_wait_in_ready(void);
+BYTE vendor_set_flush_policy(BYTE policy); // Takes the CDC_FLUSH_* values.
+void vendor_end_of_response(void);
+void vendor_flush_on_timeout(void); // SOF handler, as CDCFlushOnTimeout().
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "flight_recorder.h"
+
+#ifdef BP_ENABLE_FLIGHT_RECORDER
+
+#include "base.h"
+#include "timebase.h"
+
+#if (BP_FLIGHT_RECORDER_RECORDS & (BP_FLIGHT_RECORDER_RECORDS - 1)) != 0
+#error "BP_FLIGHT_RECORDER_RECORDS must be a power of two"
+#endif /* BP_FLIGHT_RECORDER_RECORDS & (BP_FLIGHT_RECORDER_RECORDS - 1) */
+
+/**
+ * One recorded operation.
+ */
+typedef struct {
+  /** A bp_flight_recorder_mode_t, possibly a bus event. */
+  uint8_t mode;
+
+  /** The command byte or the bus event. */
+  uint8_t operation;
+
+  /** A byte going with the operation. */
+  uint8_t data;
+
+  /** The outcome, or BP_FLIGHT_RECORDER_NO_STATUS. */
+  uint8_t status;
+
+  /** When the record was written. */
+  uint32_t timestamp;
+} bp_flight_record_t;
+
+static bp_flight_record_t flight_records[BP_FLIGHT_RECORDER_RECORDS];
+
+/**
+ * Records written since the last clear, the newest one is at this index
+ * minus one in the ring.
+ */
+static uint32_t flight_records_written;
+
+/**
+ * Where, in records written, the newest command record went.
+ */
+static uint32_t flight_records_last_command;
+
+void bp_flight_recorder_log(const uint8_t mode, const uint8_t operation,
+                            const uint8_t data, const uint8_t status) {
+  bp_flight_record_t *record;
+#ifdef BP_ENABLE_USB_TIMEBASE
+  bp_timestamp_t now;
+#endif /* BP_ENABLE_USB_TIMEBASE */
+
+  record = &flight_records[flight_records_written &
+                           (BP_FLIGHT_RECORDER_RECORDS - 1)];
+  record->mode = mode;
+  record->operation = operation;
+  record->data = data;
+  record->status = status;
+#ifdef BP_ENABLE_USB_TIMEBASE
+  bp_timebase_now(&now);
+  record->timestamp = ((uint32_t)now.frame << 16) | now.ticks;
+#else
+  record->timestamp = flight_records_written;
+#endif /* BP_ENABLE_USB_TIMEBASE */
+  if (!(mode & BP_FLIGHT_RECORDER_BUS_EVENT)) {
+    flight_records_last_command = flight_records_written;
+  }
+  flight_records_written++;
+}
+
+void bp_flight_recorder_set_status(const uint8_t status) {
+  /* The command record may be gone already, or cleared away. */
+  if ((flight_records_written > flight_records_last_command) &&
+      (flight_records_written - flight_records_last_command <=
+       BP_FLIGHT_RECORDER_RECORDS)) {
+    flight_records[flight_records_last_command &
+                   (BP_FLIGHT_RECORDER_RECORDS - 1)]
+        .status = status;
+  }
+}
+
+void bp_flight_recorder_send(const bool clear) {
+  const bp_flight_record_t *record;
+  uint32_t written;
+  uint16_t count;
+  uint16_t index;
+  uint8_t flags;
+
+  written = flight_records_written;
+  count = (written < BP_FLIGHT_RECORDER_RECORDS) ? written
+                                                 : BP_FLIGHT_RECORDER_RECORDS;
+  flags = 0;
+#ifdef BP_ENABLE_USB_TIMEBASE
+  if (bp_timebase_locked()) {
+    flags |= BP_FLIGHT_RECORDER_TIMESTAMP_USB_TIMEBASE;
+  }
+#endif /* BP_ENABLE_USB_TIMEBASE */
+
+  user_serial_transmit_character(sizeof(bp_flight_record_t));
+  user_serial_transmit_character(flags);
+  user_serial_transmit_character(written >> 24);
+  user_serial_transmit_character(written >> 16);
+  user_serial_transmit_character(written >> 8);
+  user_serial_transmit_character(written);
+  user_serial_transmit_character(HI8(count));
+  user_serial_transmit_character(LO8(count));
+
+  for (index = 0; index < count; index++) {
+    record = &flight_records[(written - count + index) &
+                             (BP_FLIGHT_RECORDER_RECORDS - 1)];
+    user_serial_transmit_character(record->mode);
+    user_serial_transmit_character(record->operation);
+    user_serial_transmit_character(record->data);
+    user_serial_transmit_character(record->status);
+    user_serial_transmit_character(record->timestamp >> 24);
+    user_serial_transmit_character(record->timestamp >> 16);
+    user_serial_transmit_character(record->timestamp >> 8);
+    user_serial_transmit_character(record->timestamp);
+  }
+
+  if (clear) {
+    flight_records_written = 0;
+    flight_records_last_command = 0;
+  }
+}
+
+#endif /* BP_ENABLE_FLIGHT_RECORDER */
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file flight_recorder.h
+ *
+ * @brief Ring of the last binary mode operations, for post-mortem debugging.
+ *
+ * Every command the binary mode dispatchers read is recorded along with the
+ * result code it was answered with, and a few bus level events (I2C bytes
+ * not acknowledged, 1-Wire resets with their outcome) are recorded on their
+ * own.  Only the newest BP_FLIGHT_RECORDER_RECORDS entries are kept,
+ * and they survive going back to the binary mode root, so a failing host
+ * session can be looked into after the fact.
+ */
+
+#ifndef BP_FLIGHT_RECORDER_H
+#define BP_FLIGHT_RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "configuration.h"
+
+/**
+ * Where a record comes from, the same numbers the binary mode root uses to
+ * enter each mode.
+ */
+typedef enum {
+  /** The binary mode root. */
+  BP_FLIGHT_RECORDER_MODE_ROOT = 0x00,
+
+  /** Binary SPI. */
+  BP_FLIGHT_RECORDER_MODE_SPI,
+
+  /** Binary I2C. */
+  BP_FLIGHT_RECORDER_MODE_I2C,
+
+  /** Binary UART. */
+  BP_FLIGHT_RECORDER_MODE_UART,
+
+  /** Binary 1-Wire. */
+  BP_FLIGHT_RECORDER_MODE_1WIRE,
+
+  /** Binary raw 2-wire/3-wire. */
+  BP_FLIGHT_RECORDER_MODE_RAW_WIRE
+} bp_flight_recorder_mode_t;
+
+/**
+ * Set in the mode of records describing a bus event rather than a command,
+ * their operation is then a bp_flight_recorder_event_t.
+ */
+#define BP_FLIGHT_RECORDER_BUS_EVENT 0x80
+
+/**
+ * Bus events recorded between commands.
+ */
+typedef enum {
+  /**
+   * An I2C byte went out and was not acknowledged, the data is the byte.
+   * Acknowledged bytes are not recorded, not to flush the ring on every bulk
+   * write.
+   */
+  BP_FLIGHT_RECORDER_EVENT_I2C_NACK = 0x00,
+
+  /** A 1-Wire reset, the status is an onewire_bus_reset_result_t. */
+  BP_FLIGHT_RECORDER_EVENT_1WIRE_RESET
+} bp_flight_recorder_event_t;
+
+/**
+ * Status of a command not answered with a result code (yet).
+ */
+#define BP_FLIGHT_RECORDER_NO_STATUS 0xFF
+
+/**
+ * Dump header flag: timestamps are the low 16 bits of the USB timebase frame
+ * followed by the sub-frame ticks, otherwise they are record numbers.
+ */
+#define BP_FLIGHT_RECORDER_TIMESTAMP_USB_TIMEBASE 0x01
+
+#ifdef BP_ENABLE_FLIGHT_RECORDER
+
+/**
+ * Adds a record, overwriting the oldest one when the ring is full.
+ *
+ * @param[in] mode a bp_flight_recorder_mode_t, possibly with
+ * BP_FLIGHT_RECORDER_BUS_EVENT set.
+ * @param[in] operation the command byte, or a bp_flight_recorder_event_t.
+ * @param[in] data a byte going with the operation, if any.
+ * @param[in] status the outcome, or BP_FLIGHT_RECORDER_NO_STATUS.
+ */
+void bp_flight_recorder_log(const uint8_t mode, const uint8_t operation,
+                            const uint8_t data, const uint8_t status);
+
+/**
+ * Sets the outcome of the newest command record, once it is known.  Bus
+ * events recorded after it are left alone.
+ *
+ * @param[in] status the result code sent back to the host.
+ */
+void bp_flight_recorder_set_status(const uint8_t status);
+
+/**
+ * Sends the whole ring, oldest record first.
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Content</th></tr>
+ * <tr><td>0</td><td>Record size, 8 for now</td></tr>
+ * <tr><td>1</td><td>BP_FLIGHT_RECORDER_TIMESTAMP_* flags</td></tr>
+ * <tr><td>2-5</td><td>Records written since the last clear, MSB first</td></tr>
+ * <tr><td>6-7</td><td>Records that follow, MSB first</td></tr>
+ * <tr><td>8+8n</td><td>Mode, operation, data and status, a byte each, then
+ * the timestamp, 32 bits MSB first</td></tr>
+ * </table>
+ *
+ * @param[in] clear true to empty the ring afterwards.
+ */
+void bp_flight_recorder_send(const bool clear);
+
+#define BP_FLIGHT_RECORDER_LOG(mode, operation, data, status)                  \
+  bp_flight_recorder_log((mode), (operation), (data), (status))
+
+#define BP_FLIGHT_RECORDER_STATUS(status) bp_flight_recorder_set_status(status)
+
+#else
+
+#define BP_FLIGHT_RECORDER_LOG(mode, operation, data, status)
+#define BP_FLIGHT_RECORDER_STATUS(status)
+
+#endif /* BP_ENABLE_FLIGHT_RECORDER */
+
+#endif /* !BP_FLIGHT_RECORDER_H */
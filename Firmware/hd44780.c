@@ -92,6 +92,16 @@
 #define CMD_SETDDRAMADDR        0b10000000 //40us
 //7bit display data RAM address
 
+//execution times from the datasheet, the busy flag can't be read back
+//through the 595 so these are waited out after each write instead
+#define HD44780_EXECUTION_DELAY_US 40 //all but clear and home
+#define HD44780_CLEAR_DELAY_US 1640 //clear display and return home
+
+//display data RAM, 1 line of 80 or 2 lines of 40 characters
+#define HD44780_DDRAM_SIZE 80
+#define HD44780_LINE_LENGTH 40
+#define HD44780_LINE2_ADDRESS 0x40
+
 //configuration structure
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
@@ -104,11 +114,29 @@ struct _HD44780_interface {
         //unsigned char dat; //8 data bits
 } HD44780;
 
+//shadow of the display RAM, characters are queued here and only the ones
+//that changed are sent by LCDflush(), in runs behind a single address set
+static struct {
+        unsigned char frame[HD44780_DDRAM_SIZE]; //display contents once flushed, by position
+        unsigned int dirty[(HD44780_DDRAM_SIZE+15)/16]; //one bit per position still to send
+        unsigned char cursor; //position the next character goes to
+        unsigned char pending:1; //any dirty bit set
+        unsigned char lines2:1; //2 line mode, the second line starts at 0x40
+        unsigned char address:1; //address counter points into display RAM at cursor
+        unsigned char increment:1; //entry mode increments the address
+        unsigned char unknown:1; //display was written around the frame, don't skip equal characters
+} LCDframe;
+
 static void HD44780_Reset(void); //reset the LCD to 4 bit mode
 static void HD44780_Init(unsigned char displaylines); //initialize LCD to 4bit mode with typical settings and X displaylines
 static void HD44780_WriteByte(unsigned char reg, unsigned char dat); //write a byte to LCD to register REG
 static void HD44780_WriteNibble(unsigned char reg, unsigned char dat);//write 4 bits to LCD to register REG
 static void HD44780_SPIwrite(unsigned char datout); //abstracts data output to PCF8574 IO expander over I2C bus
+static void HD44780_SendCommand(unsigned char cmd); //flush, write a command and track what it does to the display RAM
+static void HD44780_SendData(unsigned char c); //queue a character in the frame, or write it if the frame is out of step
+static void HD44780_FrameClear(void); //frame matches a display just cleared
+static unsigned char HD44780_Address(unsigned char pos); //frame position to display RAM address
+static unsigned char HD44780_Position(unsigned char address); //display RAM address to frame position
 
 /* 
  * Duplicate the minimum amount of SPI functionality if SPI support
@@ -122,11 +150,11 @@ static void HD44780_SPIwrite(unsigned char datout); //abstracts data output to P
 #define SPICLK_ODC              BP_CLK_ODC      
 #define SPICS_ODC               BP_CS_ODC       
 
+// SPI1 runs in enhanced buffer mode, as set up by spi.c and LCDsetup_exc
 unsigned char spi_write_byte(unsigned char c){
         SPI1BUF = c;
-        while(!IFS0bits.SPI1IF);
+        while(SPI1STATbits.SRXMPT);
         c=SPI1BUF;
-        IFS0bits.SPI1IF = 0;
         return c;
 }
 
@@ -149,10 +177,52 @@ void spi_disable_interface(void){
 
 unsigned int LCDwrite(unsigned int c)
 {       
-        HD44780_WriteByte(HD44780.RS, c);
+        if(HD44780.RS==HD44780_DATA){
+                HD44780_SendData(c);
+        }else{
+                HD44780_SendCommand(c);
+        }
         return 0x100;
 }
 
+//send the characters that changed since the last flush
+void LCDflush(void)
+{       unsigned char pos, address;
+
+        if(!LCDframe.pending) return;
+
+        address=HD44780_DDRAM_SIZE; //where the controller writes next, not known yet
+        for(pos=0; pos<HD44780_DDRAM_SIZE; pos++){
+                if(!(LCDframe.dirty[pos>>4] & (1u<<(pos&0x0F)))) continue;
+                if(address!=pos){ //skipped some, move the address counter
+                        HD44780_WriteByte(HD44780_COMMAND, CMD_SETDDRAMADDR | HD44780_Address(pos));
+                        bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                }
+                HD44780_WriteByte(HD44780_DATA, LCDframe.frame[pos]);
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                address=pos+1; //the controller follows the same order, line 1 runs into line 2
+                if(address==HD44780_DDRAM_SIZE) address=0;
+        }
+
+        if(address!=LCDframe.cursor){ //put the cursor back where the next character goes
+                HD44780_WriteByte(HD44780_COMMAND, CMD_SETDDRAMADDR | HD44780_Address(LCDframe.cursor));
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+        }
+
+        memset(LCDframe.dirty, 0, sizeof(LCDframe.dirty));
+        LCDframe.pending=0;
+}
+
+bool LCDperiodic(void)
+{       LCDflush(); //the command line is done, show what it wrote
+        return false;
+}
+
+void LCDcleanup(void)
+{       LCDflush();
+        spi_disable_interface();
+}
+
 void LCDstart(void)
 {       HD44780.RS=HD44780_COMMAND;
         //bpWline(OUMSG_LCD_COMMAND_MODE);
@@ -168,6 +238,7 @@ void LCDstop(void)
 void LCDsetup(void)
 {       
         mode_configuration.high_impedance=1;//yes, always HiZ
+        mode_configuration.periodicService=1;//flush the frame when idle
 }
 
 void LCDsetup_exc(void)
@@ -196,7 +267,7 @@ void LCDsetup_exc(void)
         //SPI1CON1bits.CKP=0;
         //SPI1CON1bits.CKE=1;           
         //SPI1CON1bits.SMP=0;
-	    SPI1CON2 = 0;
+	    SPI1CON2 = ON << _SPI1CON2_SPIBEN_POSITION; // enhanced buffer, spi_write_byte waits on SRXMPT
 	    SPI1STAT = 0;    // clear SPI
 	    SPI1STATbits.SPIEN = 1;
 
@@ -236,39 +307,38 @@ void LCDmacro(unsigned int c)
                         BPMSG1221;
                         break;          
                 case 3: //Clear LCD and return home
-                        HD44780_WriteByte(HD44780_COMMAND, CMD_CLEARDISPLAY);
-                        bp_delay_ms(15);//delay 15ms
+                        HD44780_SendCommand(CMD_CLEARDISPLAY);
                         //bpWline(OUMSG_LCD_MACRO_CLEAR);
                         BPMSG1222;
                         break;  
                 case 4: 
-                        HD44780_WriteByte(HD44780_COMMAND, CMD_SETDDRAMADDR | (unsigned char)input);
+                        HD44780_SendCommand(CMD_SETDDRAMADDR | (unsigned char)input);
                         //bpWline(OUMSG_LCD_MACRO_CURSOR);
                         BPMSG1223;
                         break;
                 case 6: //write numbers 
-                        HD44780_WriteByte(HD44780_COMMAND, CMD_CLEARDISPLAY);//Clear LCD and return home
-                        bp_delay_ms(15);//delay 15ms
+                        HD44780_SendCommand(CMD_CLEARDISPLAY);//Clear LCD and return home
                         c=0x30;
                         if(input==0) input=80;
                         for(i=0; i<input; i++){
                                 if(c>0x39) c=0x30;
-                                HD44780_WriteByte(HD44780_DATA, c);
+                                HD44780_SendData(c);
                                 user_serial_transmit_character(c);
                                 c++;
                         }
+                        LCDflush();
                         break;  
                 case 7://write characters                               
-                        HD44780_WriteByte(HD44780_COMMAND, CMD_CLEARDISPLAY); //Clear LCD and return home
-                        bp_delay_ms(15);//delay 15ms
+                        HD44780_SendCommand(CMD_CLEARDISPLAY); //Clear LCD and return home
                         c=0x21; //start character (!)
                         if(input==0) input=80;
                         for(i=0; i<input; i++){
                                 if(c>127)c=0x21;
-                                HD44780_WriteByte(HD44780_DATA, c);
+                                HD44780_SendData(c);
                                 user_serial_transmit_character(c);
                                 c++;
                         }
+                        LCDflush();
                         break;
 /*              case 8://terminal mode/pass through   //superseeded by send string command
                                 bpWline(OUMSG_LCD_MACRO_TEXT);
@@ -290,20 +360,16 @@ void LCDpins(void) {
 //displaylines=0 for single line displays, displaylines=1 for multiline displays
 void HD44780_Init(unsigned char displaylines){
         //Function set
-        HD44780_WriteByte(HD44780_COMMAND, (CMD_FUNCTIONSET + DATAWIDTH4 + FONT5X7 + displaylines)); //0x28, 0b101000
-        bp_delay_ms(15);//delay 15ms
+        HD44780_SendCommand(CMD_FUNCTIONSET + DATAWIDTH4 + FONT5X7 + displaylines); //0x28, 0b101000
         
         //Turn display off
-        HD44780_WriteByte(HD44780_COMMAND, CMD_DISPLAYCONTROL + DISPLAYOFF + CURSEROFF + BLINKOFF);//0x08, 0b1000
-        bp_delay_ms(15);//delay 15ms
+        HD44780_SendCommand(CMD_DISPLAYCONTROL + DISPLAYOFF + CURSEROFF + BLINKOFF);//0x08, 0b1000
         
         //Clear LCD and return home
-        HD44780_WriteByte(HD44780_COMMAND, CMD_CLEARDISPLAY);
-        bp_delay_ms(15);//delay 15ms
+        HD44780_SendCommand(CMD_CLEARDISPLAY);
         
         //Turn on display, turn off cursor and blink
-        HD44780_WriteByte(HD44780_COMMAND, CMD_DISPLAYCONTROL + DISPLAYON + CURSERON + BLINKOFF);   // 0x0f, 0b1111
-        bp_delay_ms(15);//delay 15ms
+        HD44780_SendCommand(CMD_DISPLAYCONTROL + DISPLAYON + CURSERON + BLINKOFF);   // 0x0f, 0b1111
 }
 
 //reset LCD to 4bit mode
@@ -325,6 +391,106 @@ void HD44780_Reset(void){
     //* Write 0x02 to the LCD to Enable Four Bit Mode 
         HD44780_WriteNibble(HD44780_COMMAND, 0x02);
         bp_delay_us(160);
+
+        //1 line, incrementing, contents and address unknown
+        memset(LCDframe.dirty, 0, sizeof(LCDframe.dirty));
+        LCDframe.pending=0;
+        LCDframe.lines2=0;
+        LCDframe.address=0;
+        LCDframe.increment=1;
+        LCDframe.unknown=1;
+}
+
+//display RAM address of frame position pos
+static unsigned char HD44780_Address(unsigned char pos){
+        if(LCDframe.lines2 && (pos>=HD44780_LINE_LENGTH)) return HD44780_LINE2_ADDRESS+pos-HD44780_LINE_LENGTH;
+        return pos;
+}
+
+//frame position of display RAM address, HD44780_DDRAM_SIZE if it is outside the display
+static unsigned char HD44780_Position(unsigned char address){
+        if(!LCDframe.lines2) return (address<HD44780_DDRAM_SIZE)?address:HD44780_DDRAM_SIZE;
+        if(address<HD44780_LINE_LENGTH) return address;
+        if((address>=HD44780_LINE2_ADDRESS)&&(address<HD44780_LINE2_ADDRESS+HD44780_LINE_LENGTH)) return address-HD44780_LINE2_ADDRESS+HD44780_LINE_LENGTH;
+        return HD44780_DDRAM_SIZE;
+}
+
+void HD44780_FrameClear(void){
+        memset(LCDframe.frame, ' ', sizeof(LCDframe.frame));
+        memset(LCDframe.dirty, 0, sizeof(LCDframe.dirty));
+        LCDframe.cursor=0;
+        LCDframe.pending=0;
+        LCDframe.address=1;
+        LCDframe.unknown=0;
+}
+
+void HD44780_SendData(unsigned char c){
+        unsigned char pos;
+
+        if(!(LCDframe.address && LCDframe.increment)){ //can't tell where it lands, write it now
+                HD44780_WriteByte(HD44780_DATA, c);
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                LCDframe.unknown=1;
+                return;
+        }
+
+        pos=LCDframe.cursor;
+        if((LCDframe.frame[pos]!=c)||LCDframe.unknown){
+                LCDframe.frame[pos]=c;
+                LCDframe.dirty[pos>>4] |= (1u<<(pos&0x0F));
+                LCDframe.pending=1;
+        }
+        if(++LCDframe.cursor==HD44780_DDRAM_SIZE) LCDframe.cursor=0;
+}
+
+void HD44780_SendCommand(unsigned char cmd){
+        unsigned char pos;
+
+        if(cmd==CMD_CLEARDISPLAY){ //what was queued is wiped anyway
+                LCDframe.pending=0;
+        }else{
+                LCDflush();
+        }
+
+        HD44780_WriteByte(HD44780_COMMAND, cmd);
+
+        if(cmd&CMD_SETDDRAMADDR){
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                pos=HD44780_Position(cmd & ~CMD_SETDDRAMADDR);
+                LCDframe.address=(pos<HD44780_DDRAM_SIZE);
+                if(LCDframe.address) LCDframe.cursor=pos;
+        }else if(cmd&CMD_SETCGRAMADDR){ //characters go to the character generator now
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                LCDframe.address=0;
+        }else if(cmd&CMD_FUNCTIONSET){
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                if(LCDframe.lines2!=((cmd&DISPLAYLINES2)!=0)){ //positions map to other addresses
+                        LCDframe.lines2=((cmd&DISPLAYLINES2)!=0);
+                        LCDframe.address=0;
+                        LCDframe.unknown=1;
+                }
+        }else if(cmd&CMD_CURSERDISPLAYSHIFT){
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                if(!(cmd&DISPLAYSHIFT)){ //a display shift leaves the addresses alone
+                        if(cmd&SHIFTRIGHT){
+                                if(++LCDframe.cursor==HD44780_DDRAM_SIZE) LCDframe.cursor=0;
+                        }else{
+                                LCDframe.cursor=(LCDframe.cursor?LCDframe.cursor:HD44780_DDRAM_SIZE)-1;
+                        }
+                }
+        }else if(cmd&CMD_DISPLAYCONTROL){
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+        }else if(cmd&CMD_ENTRYMODESET){
+                bp_delay_us(HD44780_EXECUTION_DELAY_US);
+                LCDframe.increment=((cmd&INCREMENT)!=0); //display shifts move the window, not the addresses
+        }else if(cmd&CMD_RETURNHOME){
+                bp_delay_us(HD44780_CLEAR_DELAY_US);
+                LCDframe.cursor=0;
+                LCDframe.address=1;
+        }else if(cmd==CMD_CLEARDISPLAY){
+                bp_delay_us(HD44780_CLEAR_DELAY_US);
+                HD44780_FrameClear();
+        }
 }
 
 //write byte dat to register reg
@@ -19,6 +19,8 @@
 
 #include "configuration.h"
 
+#include <stdbool.h>
+
 #ifdef BP_ENABLE_HD44780_SUPPORT
 
 unsigned int LCDread(void);
@@ -29,6 +31,9 @@ void LCDsetup(void);
 void LCDsetup_exc(void);
 void LCDmacro(unsigned int c);
 void LCDpins(void);
+void LCDflush(void);
+bool LCDperiodic(void);
+void LCDcleanup(void);
 
 #ifndef BP_ENABLE_SPI_SUPPORT
 void spi_disable_interface(void);
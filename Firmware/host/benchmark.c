@@ -0,0 +1,228 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/*
+ * Replays a command script against the firmware running on the host, so the
+ * parser and protocol code can be looked at with perf, cachegrind and the
+ * like.
+ *
+ * Usage: bp_benchmark [-n runs] [-o output] [-x] script
+ *
+ *  -n runs   how many times to replay the script, 1 by default.
+ *  -o output where the firmware output goes, - for stdout.  It is dropped
+ *            by default.
+ *  -x        the script is hexadecimal text: byte values separated by
+ *            blanks, optionally prefixed with 0x, with # comments.
+ *
+ * Other scripts are sent as they are, except for line feeds turned into
+ * carriage returns like a terminal sends when Enter is pressed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mock_hal.h"
+
+static void usage(const char *name) {
+  fprintf(stderr, "Usage: %s [-n runs] [-o output] [-x] script\n", name);
+  exit(EXIT_FAILURE);
+}
+
+static uint8_t *read_script(const char *path, size_t *length) {
+  FILE *handle;
+  uint8_t *script;
+  size_t size;
+  size_t read;
+
+  handle = fopen(path, "rb");
+  if (handle == NULL) {
+    fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  size = 0;
+  script = NULL;
+  do {
+    script = realloc(script, size + BUFSIZ);
+    if (script == NULL) {
+      fprintf(stderr, "Out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    read = fread(script + size, 1, BUFSIZ, handle);
+    size += read;
+  } while (read == BUFSIZ);
+
+  if (ferror(handle)) {
+    fprintf(stderr, "Cannot read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  fclose(handle);
+
+  *length = size;
+  return script;
+}
+
+static size_t parse_hex_script(uint8_t *script, const size_t length) {
+  size_t input;
+  size_t output;
+  char token[8];
+  size_t token_length;
+  char *end;
+  unsigned long value;
+
+  input = 0;
+  output = 0;
+  while (input < length) {
+    if (script[input] == '#') {
+      while ((input < length) && (script[input] != '\n')) {
+        input++;
+      }
+      continue;
+    }
+
+    if (isspace(script[input]) || (script[input] == ',')) {
+      input++;
+      continue;
+    }
+
+    token_length = 0;
+    while ((input < length) && !isspace(script[input]) &&
+           (script[input] != ',') && (script[input] != '#')) {
+      if (token_length == sizeof(token) - 1) {
+        fprintf(stderr, "Hexadecimal token too long at offset %zu\n", input);
+        exit(EXIT_FAILURE);
+      }
+      token[token_length++] = script[input++];
+    }
+    token[token_length] = '\0';
+
+    value = strtoul(token, &end, 16);
+    if ((*end != '\0') || (value > 0xFF)) {
+      fprintf(stderr, "Invalid byte \"%s\"\n", token);
+      exit(EXIT_FAILURE);
+    }
+    script[output++] = value;
+  }
+
+  return output;
+}
+
+int main(int argc, char *argv[]) {
+  const char *output_path;
+  uint8_t *script;
+  size_t length;
+  size_t index;
+  FILE *output;
+  bool hexadecimal;
+  unsigned long runs;
+  unsigned long run;
+  int option;
+  struct timespec start;
+  struct timespec end;
+  double elapsed;
+  bp_host_statistics_t statistics;
+  bp_host_statistics_t totals;
+
+  runs = 1;
+  output_path = NULL;
+  hexadecimal = false;
+  while ((option = getopt(argc, argv, "n:o:x")) != -1) {
+    switch (option) {
+    case 'n':
+      runs = strtoul(optarg, NULL, 10);
+      if (runs == 0) {
+        usage(argv[0]);
+      }
+      break;
+
+    case 'o':
+      output_path = optarg;
+      break;
+
+    case 'x':
+      hexadecimal = true;
+      break;
+
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if (optind != argc - 1) {
+    usage(argv[0]);
+  }
+
+  script = read_script(argv[optind], &length);
+  if (hexadecimal) {
+    length = parse_hex_script(script, length);
+  } else {
+    for (index = 0; index < length; index++) {
+      if (script[index] == '\n') {
+        script[index] = '\r';
+      }
+    }
+  }
+
+  output = NULL;
+  if (output_path != NULL) {
+    if (strcmp(output_path, "-") == 0) {
+      output = stdout;
+    } else {
+      output = fopen(output_path, "wb");
+      if (output == NULL) {
+        fprintf(stderr, "Cannot open %s: %s\n", output_path, strerror(errno));
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  memset(&totals, 0, sizeof(totals));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (run = 0; run < runs; run++) {
+    bp_host_run(script, length, output, &statistics);
+    totals.bytes_in += statistics.bytes_in;
+    totals.bytes_out += statistics.bytes_out;
+    totals.resets += statistics.resets;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if ((output != NULL) && (output != stdout)) {
+    fclose(output);
+  } else if (output == stdout) {
+    fflush(stdout);
+  }
+
+  elapsed = (end.tv_sec - start.tv_sec) +
+            (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+  fprintf(stderr,
+          "%lu run(s), %zu bytes in, %zu bytes out, %u reset(s)\n"
+          "%.6f s total, %.3f us per run\n",
+          runs, totals.bytes_in, totals.bytes_out, totals.resets, elapsed,
+          elapsed * 1000000.0 / runs);
+
+  free(script);
+  return EXIT_SUCCESS;
+}
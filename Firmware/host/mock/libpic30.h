@@ -0,0 +1,33 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file libpic30.h
+ *
+ * @brief Stand-in for the XC16 runtime header when building on the host.
+ *
+ * Busy waits take no time at all, benchmarks measure the code around them.
+ */
+
+#ifndef BP_HOST_LIBPIC30_H
+#define BP_HOST_LIBPIC30_H
+
+#define __delay32(cycles) ((void)(cycles))
+#define __delay_ms(milliseconds) ((void)(milliseconds))
+#define __delay_us(microseconds) ((void)(microseconds))
+
+#endif /* !BP_HOST_LIBPIC30_H */
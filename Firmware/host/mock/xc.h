@@ -0,0 +1,778 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file xc.h
+ *
+ * @brief Stand-in for the XC16 device header when building the v3 firmware
+ * on the host.
+ *
+ * Only the special function registers the firmware touches are declared.
+ * Plain registers are ordinary variables, the few the firmware waits on
+ * (UART1, SPI1 and the ADC) go through the accessors in mock_hal.c so they
+ * can answer like the hardware would.  Unlike on the chip the word and bits
+ * views of a register are separate variables, except for port B, TRISB and
+ * the accessor backed registers.
+ */
+
+#ifndef BP_HOST_XC_H
+#define BP_HOST_XC_H
+
+#include <stdint.h>
+
+#ifndef __PIC24FJ64GA002__
+#error "The host build only covers the v3 firmware"
+#endif /* !__PIC24FJ64GA002__ */
+
+#ifdef BP_HOST_DEFINE_REGISTERS
+#define BP_HOST_SFR volatile
+#else
+#define BP_HOST_SFR extern volatile
+#endif /* BP_HOST_DEFINE_REGISTERS */
+
+/* Attributes the host compiler does not know about. */
+
+#define interrupt unused
+#define no_auto_psv unused
+#define auto_psv unused
+#define shadow unused
+#define persistent unused
+#define address(where) unused
+#define space(where) unused
+
+/* Builtins. */
+
+#define Nop() ((void)0)
+#define ClrWdt() ((void)0)
+#define Reset() bp_host_reset()
+
+/**
+ * Set in program memory addresses pointing into host memory, the others are
+ * looked up in the emulated configuration space.
+ */
+#define BP_HOST_PROGRAM_SPACE (1UL << 62)
+
+/*
+ * Program memory arrays built by packstrings.py --host take four bytes per
+ * program word, which is two address units: a host byte address halved is a
+ * program memory address.
+ */
+#define __builtin_tbladdress(symbol)                                           \
+  ((((unsigned long)(uintptr_t)(symbol)) >> 1) | BP_HOST_PROGRAM_SPACE)
+#define __builtin_tblrdl(offset) bp_host_table_read_low(offset)
+#define __builtin_tblrdh(offset) bp_host_table_read_high(offset)
+
+void bp_host_reset(void) __attribute__((noreturn));
+uint16_t bp_host_table_read_low(const unsigned long offset);
+uint16_t bp_host_table_read_high(const unsigned long offset);
+
+/* Word registers. */
+
+BP_HOST_SFR uint16_t AD1CHS;
+BP_HOST_SFR uint16_t AD1CON2;
+BP_HOST_SFR uint16_t AD1CON3;
+BP_HOST_SFR uint16_t AD1CSSL;
+BP_HOST_SFR uint16_t AD1PCFG;
+BP_HOST_SFR uint16_t CNEN1;
+BP_HOST_SFR uint16_t CNEN2;
+BP_HOST_SFR uint16_t CNPU1;
+BP_HOST_SFR uint16_t CNPU2;
+BP_HOST_SFR uint16_t IC1BUF;
+BP_HOST_SFR uint16_t IC1CON;
+BP_HOST_SFR uint16_t IC2BUF;
+BP_HOST_SFR uint16_t IC2CON;
+BP_HOST_SFR uint16_t IC3BUF;
+BP_HOST_SFR uint16_t IC3CON;
+BP_HOST_SFR uint16_t IC4BUF;
+BP_HOST_SFR uint16_t IC4CON;
+BP_HOST_SFR uint16_t IC5BUF;
+BP_HOST_SFR uint16_t IC5CON;
+BP_HOST_SFR uint16_t OC3CON;
+BP_HOST_SFR uint16_t OC3R;
+BP_HOST_SFR uint16_t OC3RS;
+BP_HOST_SFR uint16_t OC4CON;
+BP_HOST_SFR uint16_t OC4R;
+BP_HOST_SFR uint16_t OC5CON;
+BP_HOST_SFR uint16_t OC5R;
+BP_HOST_SFR uint16_t OC5RS;
+BP_HOST_SFR uint16_t PR1;
+BP_HOST_SFR uint16_t PR2;
+BP_HOST_SFR uint16_t PR3;
+BP_HOST_SFR uint16_t PR4;
+BP_HOST_SFR uint16_t PR5;
+BP_HOST_SFR uint16_t SPI1CON1;
+BP_HOST_SFR uint16_t SPI1CON2;
+BP_HOST_SFR uint16_t SPI1STAT;
+BP_HOST_SFR uint16_t SPI2BUF;
+BP_HOST_SFR uint16_t SPI2CON1;
+BP_HOST_SFR uint16_t SPI2CON2;
+BP_HOST_SFR uint16_t SPI2STAT;
+BP_HOST_SFR uint16_t T1CON;
+BP_HOST_SFR uint16_t T2CON;
+BP_HOST_SFR uint16_t T3CON;
+BP_HOST_SFR uint16_t T4CON;
+BP_HOST_SFR uint16_t TBLPAG;
+BP_HOST_SFR uint16_t TMR1;
+BP_HOST_SFR uint16_t TMR2;
+BP_HOST_SFR uint16_t TMR3;
+BP_HOST_SFR uint16_t TMR3HLD;
+BP_HOST_SFR uint16_t TMR4;
+BP_HOST_SFR uint16_t TMR5HLD;
+BP_HOST_SFR uint16_t U1BRG;
+BP_HOST_SFR uint16_t U1MODE;
+BP_HOST_SFR uint16_t U1STA;
+BP_HOST_SFR uint16_t U1TXREG;
+BP_HOST_SFR uint16_t U2BRG;
+BP_HOST_SFR uint16_t U2MODE;
+BP_HOST_SFR uint16_t U2RXREG;
+BP_HOST_SFR uint16_t U2STA;
+BP_HOST_SFR uint16_t U2TXREG;
+
+/** ADC1BUF0 to ADC1BUFF, contiguous like on the chip. */
+BP_HOST_SFR uint16_t bp_host_adc_buffers[16];
+
+#define ADC1BUF0 bp_host_adc_buffers[0]
+#define ADC1BUF8 bp_host_adc_buffers[8]
+
+/* Bit positions and masks, from the PIC24FJ64GA002 datasheet. */
+
+#define _CNPU1_CN6PUE_MASK 0x0040
+#define _CNPU1_CN7PUE_MASK 0x0080
+
+#define _IC1CON_ICM_POSITION 0
+#define _IC1CON_ICM_MASK 0x0007
+#define _IC1CON_ICBNE_MASK 0x0008
+#define _IC1CON_ICOV_MASK 0x0010
+#define _IC1CON_ICTMR_POSITION 7
+#define _IC2CON_ICM_POSITION 0
+#define _IC2CON_ICI_POSITION 5
+#define _IC2CON_ICTMR_POSITION 7
+#define _IC2CON_ICSIDL_POSITION 13
+#define _IC3CON_ICM_POSITION 0
+#define _IC3CON_ICTMR_POSITION 7
+
+#define _OC3CON_OCM_POSITION 0
+#define _OC3CON_OCTSEL_POSITION 3
+#define _OC3CON_OCFLT_POSITION 4
+#define _OC3CON_OCSIDL_POSITION 13
+#define _OC4CON_OCM_POSITION 0
+#define _OC4CON_OCTSEL_POSITION 3
+#define _OC4CON_OCFLT_POSITION 4
+#define _OC4CON_OCSIDL_POSITION 13
+#define _OC5CON_OCM_POSITION 0
+#define _OC5CON_OCTSEL_POSITION 3
+#define _OC5CON_OCFLT_POSITION 4
+#define _OC5CON_OCSIDL_POSITION 13
+
+#define _SPI1CON1_PPRE_POSITION 0
+#define _SPI1CON1_MSTEN_POSITION 5
+#define _SPI1CON1_CKP_POSITION 6
+#define _SPI1CON1_CKE_POSITION 8
+#define _SPI1CON1_SMP_POSITION 9
+#define _SPI1CON1_MODE16_POSITION 10
+#define _SPI1CON2_SPIBEN_POSITION 0
+#define _SPI2CON1_PPRE_POSITION 0
+#define _SPI2CON1_CKP_POSITION 6
+#define _SPI2CON1_CKE_POSITION 8
+
+#define _T1CON_TCKPS_POSITION 4
+#define _T1CON_TON_POSITION 15
+#define _T2CON_TCS_POSITION 1
+#define _T2CON_T32_POSITION 3
+#define _T2CON_TCKPS_POSITION 4
+#define _T2CON_TCKPS0_POSITION 4
+#define _T2CON_TCKPS1_POSITION 5
+#define _T2CON_TON_POSITION 15
+#define _T3CON_TON_POSITION 15
+#define _T4CON_T32_POSITION 3
+#define _T4CON_TCKPS_POSITION 4
+#define _T4CON_TON_POSITION 15
+
+#define _U2MODE_STSEL_POSITION 0
+#define _U2MODE_PDSEL_POSITION 1
+#define _U2MODE_BRGH_POSITION 3
+#define _U2MODE_RXINV_POSITION 4
+#define _U2STA_UTXINV_POSITION 14
+
+/* Ports, the pins read back what was last latched. */
+
+typedef union {
+  uint16_t word;
+  struct {
+    uint16_t RA0 : 1;
+    uint16_t RA1 : 1;
+    uint16_t RA2 : 1;
+    uint16_t RA3 : 1;
+    uint16_t RA4 : 1;
+    uint16_t : 11;
+  } bits;
+} bp_host_port_a_t;
+
+typedef union {
+  uint16_t word;
+  struct {
+    uint16_t RB0 : 1;
+    uint16_t RB1 : 1;
+    uint16_t RB2 : 1;
+    uint16_t RB3 : 1;
+    uint16_t RB4 : 1;
+    uint16_t RB5 : 1;
+    uint16_t RB6 : 1;
+    uint16_t RB7 : 1;
+    uint16_t RB8 : 1;
+    uint16_t RB9 : 1;
+    uint16_t RB10 : 1;
+    uint16_t RB11 : 1;
+    uint16_t RB12 : 1;
+    uint16_t RB13 : 1;
+    uint16_t RB14 : 1;
+    uint16_t RB15 : 1;
+  } bits;
+} bp_host_port_b_t;
+
+typedef union {
+  uint16_t word;
+  struct {
+    uint16_t TRISA0 : 1;
+    uint16_t TRISA1 : 1;
+    uint16_t TRISA2 : 1;
+    uint16_t TRISA3 : 1;
+    uint16_t TRISA4 : 1;
+    uint16_t : 11;
+  } bits;
+} bp_host_tris_a_t;
+
+typedef union {
+  uint16_t word;
+  struct {
+    uint16_t TRISB0 : 1;
+    uint16_t TRISB1 : 1;
+    uint16_t TRISB2 : 1;
+    uint16_t TRISB3 : 1;
+    uint16_t TRISB4 : 1;
+    uint16_t TRISB5 : 1;
+    uint16_t TRISB6 : 1;
+    uint16_t TRISB7 : 1;
+    uint16_t TRISB8 : 1;
+    uint16_t TRISB9 : 1;
+    uint16_t TRISB10 : 1;
+    uint16_t TRISB11 : 1;
+    uint16_t TRISB12 : 1;
+    uint16_t TRISB13 : 1;
+    uint16_t TRISB14 : 1;
+    uint16_t TRISB15 : 1;
+  } bits;
+} bp_host_tris_b_t;
+
+BP_HOST_SFR bp_host_port_a_t bp_host_port_a;
+BP_HOST_SFR bp_host_port_b_t bp_host_port_b;
+BP_HOST_SFR bp_host_tris_a_t bp_host_tris_a;
+BP_HOST_SFR bp_host_tris_b_t bp_host_tris_b;
+
+#define PORTA bp_host_port_a.word
+#define PORTAbits bp_host_port_a.bits
+#define PORTB bp_host_port_b.word
+#define PORTBbits bp_host_port_b.bits
+#define LATB bp_host_port_b.word
+#define TRISA bp_host_tris_a.word
+#define TRISAbits bp_host_tris_a.bits
+#define TRISB bp_host_tris_b.word
+#define TRISBbits bp_host_tris_b.bits
+
+typedef struct {
+  uint16_t : 6;
+  uint16_t ODB6 : 1;
+  uint16_t ODB7 : 1;
+  uint16_t ODB8 : 1;
+  uint16_t ODB9 : 1;
+  uint16_t ODB10 : 1;
+  uint16_t : 5;
+} ODCBBITS;
+BP_HOST_SFR ODCBBITS ODCBbits;
+
+/* Bits views. */
+
+typedef struct {
+  uint16_t DONE : 1;
+  uint16_t SAMP : 1;
+  uint16_t ASAM : 1;
+  uint16_t : 2;
+  uint16_t SSRC : 3;
+  uint16_t FORM : 2;
+  uint16_t : 5;
+  uint16_t ADON : 1;
+} AD1CON1BITS;
+
+typedef struct {
+  uint16_t BUFM : 1;
+  uint16_t SMPI : 4;
+  uint16_t : 2;
+  uint16_t BUFS : 1;
+  uint16_t : 2;
+  uint16_t CSCNA : 1;
+  uint16_t : 5;
+} AD1CON2BITS;
+BP_HOST_SFR AD1CON2BITS AD1CON2bits;
+
+typedef struct {
+  uint16_t : 9;
+  uint16_t PCFG9 : 1;
+  uint16_t PCFG10 : 1;
+  uint16_t PCFG11 : 1;
+  uint16_t PCFG12 : 1;
+  uint16_t : 3;
+} AD1PCFGBITS;
+BP_HOST_SFR AD1PCFGBITS AD1PCFGbits;
+
+typedef struct {
+  uint16_t : 8;
+  uint16_t RCDIV0 : 1;
+  uint16_t RCDIV1 : 1;
+  uint16_t RCDIV2 : 1;
+  uint16_t : 5;
+} CLKDIVBITS;
+BP_HOST_SFR CLKDIVBITS CLKDIVbits;
+
+typedef struct {
+  uint16_t : 5;
+  uint16_t CN21IE : 1;
+  uint16_t CN22IE : 1;
+  uint16_t : 9;
+} CNEN2BITS;
+BP_HOST_SFR CNEN2BITS CNEN2bits;
+
+typedef struct {
+  uint16_t ICM : 3;
+  uint16_t ICBNE : 1;
+  uint16_t ICOV : 1;
+  uint16_t ICI : 2;
+  uint16_t ICTMR : 1;
+  uint16_t : 5;
+  uint16_t ICSIDL : 1;
+  uint16_t : 2;
+} ICxCONBITS;
+BP_HOST_SFR ICxCONBITS IC1CONbits;
+BP_HOST_SFR ICxCONBITS IC2CONbits;
+BP_HOST_SFR ICxCONBITS IC3CONbits;
+
+typedef struct {
+  uint16_t INT0IE : 1;
+  uint16_t IC1IE : 1;
+  uint16_t OC1IE : 1;
+  uint16_t T1IE : 1;
+  uint16_t : 1;
+  uint16_t IC2IE : 1;
+  uint16_t OC2IE : 1;
+  uint16_t T2IE : 1;
+  uint16_t T3IE : 1;
+  uint16_t SPF1IE : 1;
+  uint16_t SPI1IE : 1;
+  uint16_t U1RXIE : 1;
+  uint16_t U1TXIE : 1;
+  uint16_t AD1IE : 1;
+  uint16_t : 2;
+} IEC0BITS;
+BP_HOST_SFR IEC0BITS IEC0bits;
+
+typedef struct {
+  uint16_t INT0IF : 1;
+  uint16_t IC1IF : 1;
+  uint16_t OC1IF : 1;
+  uint16_t T1IF : 1;
+  uint16_t : 1;
+  uint16_t IC2IF : 1;
+  uint16_t OC2IF : 1;
+  uint16_t T2IF : 1;
+  uint16_t T3IF : 1;
+  uint16_t SPF1IF : 1;
+  uint16_t SPI1IF : 1;
+  uint16_t U1RXIF : 1;
+  uint16_t U1TXIF : 1;
+  uint16_t AD1IF : 1;
+  uint16_t : 2;
+} IFS0BITS;
+BP_HOST_SFR IFS0BITS IFS0bits;
+
+typedef struct {
+  uint16_t SI2C1IE : 1;
+  uint16_t MI2C1IE : 1;
+  uint16_t CMIE : 1;
+  uint16_t CNIE : 1;
+  uint16_t INT1IE : 1;
+  uint16_t : 2;
+  uint16_t OC3IE : 1;
+  uint16_t OC4IE : 1;
+  uint16_t T4IE : 1;
+  uint16_t T5IE : 1;
+  uint16_t : 1;
+  uint16_t INT2IE : 1;
+  uint16_t : 1;
+  uint16_t U2RXIE : 1;
+  uint16_t U2TXIE : 1;
+} IEC1BITS;
+BP_HOST_SFR IEC1BITS IEC1bits;
+
+typedef struct {
+  uint16_t SI2C1IF : 1;
+  uint16_t MI2C1IF : 1;
+  uint16_t CMIF : 1;
+  uint16_t CNIF : 1;
+  uint16_t INT1IF : 1;
+  uint16_t : 2;
+  uint16_t OC3IF : 1;
+  uint16_t OC4IF : 1;
+  uint16_t T4IF : 1;
+  uint16_t T5IF : 1;
+  uint16_t : 1;
+  uint16_t INT2IF : 1;
+  uint16_t : 1;
+  uint16_t U2RXIF : 1;
+  uint16_t U2TXIF : 1;
+} IFS1BITS;
+BP_HOST_SFR IFS1BITS IFS1bits;
+
+typedef struct {
+  uint16_t INT0IP : 3;
+  uint16_t : 1;
+  uint16_t IC1IP : 3;
+  uint16_t : 1;
+  uint16_t OC1IP : 3;
+  uint16_t : 1;
+  uint16_t T1IP : 3;
+  uint16_t : 1;
+} IPC0BITS;
+BP_HOST_SFR IPC0BITS IPC0bits;
+
+typedef struct {
+  uint16_t : 4;
+  uint16_t IC2IP : 3;
+  uint16_t : 1;
+  uint16_t OC2IP : 3;
+  uint16_t : 1;
+  uint16_t T2IP : 3;
+  uint16_t : 1;
+} IPC1BITS;
+BP_HOST_SFR IPC1BITS IPC1bits;
+
+typedef struct {
+  uint16_t T3IP : 3;
+  uint16_t : 1;
+  uint16_t SPF1IP : 3;
+  uint16_t : 1;
+  uint16_t SPI1IP : 3;
+  uint16_t : 1;
+  uint16_t U1RXIP : 3;
+  uint16_t : 1;
+} IPC2BITS;
+BP_HOST_SFR IPC2BITS IPC2bits;
+
+typedef struct {
+  uint16_t SI2C1IP : 3;
+  uint16_t : 1;
+  uint16_t MI2C1IP : 3;
+  uint16_t : 1;
+  uint16_t CMIP : 3;
+  uint16_t : 1;
+  uint16_t CNIP : 3;
+  uint16_t : 1;
+} IPC4BITS;
+BP_HOST_SFR IPC4BITS IPC4bits;
+
+typedef struct {
+  uint16_t : 4;
+  uint16_t OC3IP : 3;
+  uint16_t : 1;
+  uint16_t OC4IP : 3;
+  uint16_t : 1;
+  uint16_t T4IP : 3;
+  uint16_t : 1;
+} IPC6BITS;
+BP_HOST_SFR IPC6BITS IPC6bits;
+
+typedef struct {
+  uint16_t : 4;
+  uint16_t INT2IP : 3;
+  uint16_t : 1;
+  uint16_t U2RXIP : 3;
+  uint16_t : 1;
+  uint16_t U2TXIP : 3;
+  uint16_t : 1;
+} IPC7BITS;
+BP_HOST_SFR IPC7BITS IPC7bits;
+
+typedef struct {
+  uint16_t OSWEN : 1;
+  uint16_t SOSCEN : 1;
+  uint16_t : 3;
+  uint16_t LOCK : 1;
+  uint16_t : 10;
+} OSCCONBITS;
+BP_HOST_SFR OSCCONBITS OSCCONbits;
+
+/* Peripheral pin select, every field is five bits wide on this chip. */
+
+typedef struct {
+  uint16_t T2CKR : 5;
+  uint16_t : 3;
+  uint16_t T3CKR : 5;
+  uint16_t : 3;
+} RPINR3BITS;
+BP_HOST_SFR RPINR3BITS RPINR3bits;
+
+typedef struct {
+  uint16_t IC1R : 5;
+  uint16_t : 3;
+  uint16_t IC2R : 5;
+  uint16_t : 3;
+} RPINR7BITS;
+BP_HOST_SFR RPINR7BITS RPINR7bits;
+
+typedef struct {
+  uint16_t IC3R : 5;
+  uint16_t : 3;
+  uint16_t IC4R : 5;
+  uint16_t : 3;
+} RPINR8BITS;
+BP_HOST_SFR RPINR8BITS RPINR8bits;
+
+typedef struct {
+  uint16_t IC5R : 5;
+  uint16_t : 11;
+} RPINR9BITS;
+BP_HOST_SFR RPINR9BITS RPINR9bits;
+
+typedef struct {
+  uint16_t U1RXR : 5;
+  uint16_t : 3;
+  uint16_t U1CTSR : 5;
+  uint16_t : 3;
+} RPINR18BITS;
+BP_HOST_SFR RPINR18BITS RPINR18bits;
+
+typedef struct {
+  uint16_t U2RXR : 5;
+  uint16_t : 3;
+  uint16_t U2CTSR : 5;
+  uint16_t : 3;
+} RPINR19BITS;
+BP_HOST_SFR RPINR19BITS RPINR19bits;
+
+typedef struct {
+  uint16_t SDI1R : 5;
+  uint16_t : 3;
+  uint16_t SCK1R : 5;
+  uint16_t : 3;
+} RPINR20BITS;
+BP_HOST_SFR RPINR20BITS RPINR20bits;
+
+typedef struct {
+  uint16_t SS1R : 5;
+  uint16_t : 11;
+} RPINR21BITS;
+BP_HOST_SFR RPINR21BITS RPINR21bits;
+
+typedef struct {
+  uint16_t SDI2R : 5;
+  uint16_t : 3;
+  uint16_t SCK2R : 5;
+  uint16_t : 3;
+} RPINR22BITS;
+BP_HOST_SFR RPINR22BITS RPINR22bits;
+
+typedef struct {
+  uint16_t SS2R : 5;
+  uint16_t : 11;
+} RPINR23BITS;
+BP_HOST_SFR RPINR23BITS RPINR23bits;
+
+typedef struct {
+  uint16_t RP4R : 5;
+  uint16_t : 3;
+  uint16_t RP5R : 5;
+  uint16_t : 3;
+} RPOR2BITS;
+BP_HOST_SFR RPOR2BITS RPOR2bits;
+
+typedef struct {
+  uint16_t RP6R : 5;
+  uint16_t : 3;
+  uint16_t RP7R : 5;
+  uint16_t : 3;
+} RPOR3BITS;
+BP_HOST_SFR RPOR3BITS RPOR3bits;
+
+typedef struct {
+  uint16_t RP8R : 5;
+  uint16_t : 3;
+  uint16_t RP9R : 5;
+  uint16_t : 3;
+} RPOR4BITS;
+BP_HOST_SFR RPOR4BITS RPOR4bits;
+
+typedef struct {
+  uint16_t RP10R : 5;
+  uint16_t : 3;
+  uint16_t RP11R : 5;
+  uint16_t : 3;
+} RPOR5BITS;
+BP_HOST_SFR RPOR5BITS RPOR5bits;
+
+typedef struct {
+  uint16_t PPRE : 2;
+  uint16_t SPRE : 3;
+  uint16_t MSTEN : 1;
+  uint16_t CKP : 1;
+  uint16_t SSEN : 1;
+  uint16_t CKE : 1;
+  uint16_t SMP : 1;
+  uint16_t MODE16 : 1;
+  uint16_t DISSDO : 1;
+  uint16_t DISSCK : 1;
+  uint16_t : 3;
+} SPIxCON1BITS;
+BP_HOST_SFR SPIxCON1BITS SPI1CON1bits;
+BP_HOST_SFR SPIxCON1BITS SPI2CON1bits;
+
+typedef struct {
+  uint16_t SPIBEN : 1;
+  uint16_t SPIFE : 1;
+  uint16_t : 11;
+  uint16_t SPIFPOL : 1;
+  uint16_t SPIFSD : 1;
+  uint16_t FRMEN : 1;
+} SPIxCON2BITS;
+BP_HOST_SFR SPIxCON2BITS SPI1CON2bits;
+BP_HOST_SFR SPIxCON2BITS SPI2CON2bits;
+
+typedef struct {
+  uint16_t SPIRBF : 1;
+  uint16_t SPITBF : 1;
+  uint16_t SISEL : 3;
+  uint16_t SRXMPT : 1;
+  uint16_t SPIROV : 1;
+  uint16_t SRMPT : 1;
+  uint16_t SPIBEC : 3;
+  uint16_t : 2;
+  uint16_t SPISIDL : 1;
+  uint16_t : 1;
+  uint16_t SPIEN : 1;
+} SPIxSTATBITS;
+BP_HOST_SFR SPIxSTATBITS SPI2STATbits;
+
+typedef struct {
+  uint16_t C : 1;
+  uint16_t Z : 1;
+  uint16_t OV : 1;
+  uint16_t N : 1;
+  uint16_t RA : 1;
+  uint16_t IPL : 3;
+  uint16_t DC : 1;
+  uint16_t : 7;
+} SRBITS;
+BP_HOST_SFR SRBITS SRbits;
+
+typedef struct {
+  uint16_t : 1;
+  uint16_t TCS : 1;
+  uint16_t TSYNC : 1;
+  uint16_t T32 : 1;
+  uint16_t TCKPS : 2;
+  uint16_t TGATE : 1;
+  uint16_t : 6;
+  uint16_t TSIDL : 1;
+  uint16_t : 1;
+  uint16_t TON : 1;
+} TxCONBITS;
+BP_HOST_SFR TxCONBITS T1CONbits;
+BP_HOST_SFR TxCONBITS T3CONbits;
+BP_HOST_SFR TxCONBITS T4CONbits;
+
+/* TCKPS0 and TCKPS1 overlap TCKPS, as they do in the device header. */
+typedef union {
+  struct {
+    uint16_t : 1;
+    uint16_t TCS : 1;
+    uint16_t : 1;
+    uint16_t T32 : 1;
+    uint16_t TCKPS : 2;
+    uint16_t TGATE : 1;
+    uint16_t : 6;
+    uint16_t TSIDL : 1;
+    uint16_t : 1;
+    uint16_t TON : 1;
+  };
+  struct {
+    uint16_t : 4;
+    uint16_t TCKPS0 : 1;
+    uint16_t TCKPS1 : 1;
+    uint16_t : 10;
+  };
+} T2CONBITS;
+BP_HOST_SFR T2CONBITS T2CONbits;
+
+typedef struct {
+  uint16_t STSEL : 1;
+  uint16_t PDSEL : 2;
+  uint16_t BRGH : 1;
+  uint16_t RXINV : 1;
+  uint16_t ABAUD : 1;
+  uint16_t LPBACK : 1;
+  uint16_t WAKE : 1;
+  uint16_t UEN : 2;
+  uint16_t : 1;
+  uint16_t RTSMD : 1;
+  uint16_t IREN : 1;
+  uint16_t USIDL : 1;
+  uint16_t : 1;
+  uint16_t UARTEN : 1;
+} UxMODEBITS;
+BP_HOST_SFR UxMODEBITS U2MODEbits;
+
+typedef struct {
+  uint16_t URXDA : 1;
+  uint16_t OERR : 1;
+  uint16_t FERR : 1;
+  uint16_t PERR : 1;
+  uint16_t RIDLE : 1;
+  uint16_t ADDEN : 1;
+  uint16_t URXISEL : 2;
+  uint16_t TRMT : 1;
+  uint16_t UTXBF : 1;
+  uint16_t UTXEN : 1;
+  uint16_t UTXBRK : 1;
+  uint16_t : 1;
+  uint16_t UTXISEL0 : 1;
+  uint16_t UTXINV : 1;
+  uint16_t UTXISEL1 : 1;
+} UxSTABITS;
+BP_HOST_SFR UxSTABITS U2STAbits;
+
+/* Registers answering like the hardware, see mock_hal.c. */
+
+volatile UxSTABITS *bp_host_uart1_status(void);
+uint16_t bp_host_uart1_receive(void);
+volatile uint32_t *bp_host_spi1_buffer(void);
+volatile SPIxSTATBITS *bp_host_spi1_status(void);
+volatile AD1CON1BITS *bp_host_adc_control(void);
+
+#define U1STAbits (*bp_host_uart1_status())
+#define U1RXREG bp_host_uart1_receive()
+#define SPI1BUF (*bp_host_spi1_buffer())
+#define SPI1STATbits (*bp_host_spi1_status())
+#define AD1CON1bits (*bp_host_adc_control())
+
+#endif /* !BP_HOST_XC_H */
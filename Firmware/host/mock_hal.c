@@ -0,0 +1,405 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "mock_hal.h"
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define BP_HOST_DEFINE_REGISTERS
+#include "base.h"
+
+_Static_assert(sizeof(unsigned long) >= sizeof(void *),
+               "program memory addresses must hold a host pointer");
+
+/**
+ * U1TXREG holds this when nothing was written to it since the last look.
+ */
+#define NO_TRANSMISSION 0x8000
+
+/**
+ * Status reads in a row with neither input left nor output going out after
+ * which the firmware is considered done with the script.
+ */
+#define IDLE_POLLS 4096
+
+/**
+ * SPI1 enhanced buffer depth.
+ */
+#define SPI_FIFO_DEPTH 8
+
+/**
+ * Set in the SPI1BUF slot until the firmware writes to it.
+ */
+#define SPI_BUFFER_UNTOUCHED 0x10000UL
+
+/**
+ * PIC24FJ64GA002 device identifier.
+ */
+#define DEVICE_ID 0x0447
+
+/**
+ * Bootloader version reported by the emulated configuration space.
+ */
+#define BOOTLOADER_VERSION 0x0404
+
+/**
+ * ADC readings for the on-board supplies, 3.3V and 5V through the 1:2
+ * dividers.
+ */
+#define ADC_READING_3V3 512
+#define ADC_READING_5V0 776
+
+typedef enum {
+  /** The run just started. */
+  RUN_STARTED = 0,
+
+  /** The firmware reset itself. */
+  RUN_RESET,
+
+  /** The firmware is done with the script. */
+  RUN_FINISHED
+} run_event_t;
+
+void _U1TXInterrupt(void);
+
+static jmp_buf run_jump;
+static const uint8_t *run_script;
+static size_t run_script_length;
+static size_t run_script_position;
+static FILE *run_output;
+static bp_host_statistics_t run_statistics;
+
+/** Set while an emulated interrupt handler runs. */
+static bool in_interrupt;
+
+static UxSTABITS uart1_status;
+
+/** A script byte sits in U1RXREG. */
+static bool uart1_received;
+
+/** The next status read makes a script byte arrive. */
+static bool uart1_arriving;
+
+static unsigned int uart1_idle_polls;
+
+static uint32_t spi1_buffer;
+static bool spi1_accessed;
+static uint16_t spi1_fifo[SPI_FIFO_DEPTH];
+static size_t spi1_fifo_head;
+static size_t spi1_fifo_count;
+static SPIxSTATBITS spi1_status;
+
+static AD1CON1BITS adc_control;
+
+/**
+ * Brings the registers the firmware relies on back to their reset state.
+ */
+static void reset_registers(void);
+
+/**
+ * Moves a byte written to U1TXREG to the output, if any.
+ */
+static void uart1_capture_transmission(void);
+
+/**
+ * Accounts for the last SPI1BUF access, a read pops the FIFO and a write
+ * loops the value back into it.
+ */
+static void spi1_commit(void);
+
+void bp_host_run(const uint8_t *script, const size_t length, FILE *output,
+                 bp_host_statistics_t *statistics) {
+  run_script = script;
+  run_script_length = length;
+  run_script_position = 0;
+  run_output = output;
+  memset(&run_statistics, 0, sizeof(run_statistics));
+
+  switch (setjmp(run_jump)) {
+  case RUN_FINISHED:
+    *statistics = run_statistics;
+    return;
+
+  case RUN_RESET:
+  case RUN_STARTED:
+  default:
+    break;
+  }
+
+  reset_registers();
+  bp_firmware_main();
+  *statistics = run_statistics;
+}
+
+void bp_host_reset(void) {
+  uart1_capture_transmission();
+  run_statistics.resets++;
+  longjmp(run_jump, RUN_RESET);
+}
+
+void reset_registers(void) {
+  in_interrupt = false;
+  SRbits.IPL = 0;
+  memset((void *)&IEC0bits, 0, sizeof(IEC0bits));
+  memset((void *)&IEC1bits, 0, sizeof(IEC1bits));
+  memset((void *)&IFS0bits, 0, sizeof(IFS0bits));
+  memset((void *)&IFS1bits, 0, sizeof(IFS1bits));
+  OSCCONbits.LOCK = ON;
+
+  TRISA = 0x001F;
+  TRISB = 0xFFFF;
+
+  /* RB3 high and RB2 low, a v3b board. */
+  PORTB = 0x0008;
+
+  U1TXREG = NO_TRANSMISSION;
+  memset(&uart1_status, 0, sizeof(uart1_status));
+  uart1_received = false;
+  uart1_arriving = false;
+  uart1_idle_polls = 0;
+
+  spi1_accessed = false;
+  spi1_fifo_count = 0;
+  memset(&spi1_status, 0, sizeof(spi1_status));
+  SPI2STATbits.SRXMPT = YES;
+
+  memset(&adc_control, 0, sizeof(adc_control));
+}
+
+void uart1_capture_transmission(void) {
+  if (U1TXREG == NO_TRANSMISSION) {
+    return;
+  }
+
+  if (run_output != NULL) {
+    fputc(U1TXREG & 0xFF, run_output);
+  }
+  U1TXREG = NO_TRANSMISSION;
+  run_statistics.bytes_out++;
+  uart1_idle_polls = 0;
+}
+
+volatile UxSTABITS *bp_host_uart1_status(void) {
+  uart1_capture_transmission();
+
+  /*
+   * The transmission FIFO empties instantly, so the handler is due whenever
+   * it is enabled and the priority level lets it in.
+   */
+  if (!in_interrupt && IEC0bits.U1TXIE &&
+      (SRbits.IPL < BP_HOST_LINK_INTERRUPT_PRIORITY)) {
+    uint16_t interrupt_level;
+
+    in_interrupt = true;
+    interrupt_level = SRbits.IPL;
+    SRbits.IPL = BP_HOST_LINK_INTERRUPT_PRIORITY;
+    IFS0bits.U1TXIF = ON;
+    _U1TXInterrupt();
+    SRbits.IPL = interrupt_level;
+    in_interrupt = false;
+    uart1_capture_transmission();
+  }
+
+  /*
+   * Script bytes come in one at a time, each one after the firmware saw the
+   * reception register empty, like a slow enough sender would.
+   */
+  if (!uart1_received) {
+    if (run_script_position < run_script_length) {
+      if (uart1_arriving) {
+        uart1_received = true;
+        uart1_arriving = false;
+        uart1_idle_polls = 0;
+      } else {
+        uart1_arriving = true;
+      }
+    } else if (!in_interrupt && (++uart1_idle_polls >= IDLE_POLLS)) {
+      longjmp(run_jump, RUN_FINISHED);
+    }
+  }
+
+  uart1_status.URXDA = uart1_received;
+  uart1_status.UTXBF = NO;
+  uart1_status.TRMT = YES;
+
+  return &uart1_status;
+}
+
+uint16_t bp_host_uart1_receive(void) {
+  if (!uart1_received) {
+    return 0;
+  }
+
+  uart1_received = false;
+  run_statistics.bytes_in++;
+  return run_script[run_script_position++];
+}
+
+void spi1_commit(void) {
+  size_t depth;
+
+  if (!spi1_accessed) {
+    return;
+  }
+  spi1_accessed = false;
+
+  if (spi1_buffer & SPI_BUFFER_UNTOUCHED) {
+    if (spi1_fifo_count > 0) {
+      spi1_fifo_head = (spi1_fifo_head + 1) % SPI_FIFO_DEPTH;
+      spi1_fifo_count--;
+    }
+    return;
+  }
+
+  depth = SPI1CON2bits.SPIBEN ? SPI_FIFO_DEPTH : 1;
+  if (spi1_fifo_count == depth) {
+    spi1_status.SPIROV = ON;
+    return;
+  }
+
+  spi1_fifo[(spi1_fifo_head + spi1_fifo_count) % SPI_FIFO_DEPTH] =
+      spi1_buffer;
+  spi1_fifo_count++;
+}
+
+volatile uint32_t *bp_host_spi1_buffer(void) {
+  spi1_commit();
+  spi1_buffer = SPI_BUFFER_UNTOUCHED |
+                ((spi1_fifo_count > 0) ? spi1_fifo[spi1_fifo_head] : 0);
+  spi1_accessed = true;
+
+  return &spi1_buffer;
+}
+
+volatile SPIxSTATBITS *bp_host_spi1_status(void) {
+  size_t depth;
+
+  spi1_commit();
+  if (!spi1_status.SPIEN) {
+    spi1_fifo_count = 0;
+  }
+
+  depth = SPI1CON2bits.SPIBEN ? SPI_FIFO_DEPTH : 1;
+  spi1_status.SRXMPT = spi1_fifo_count == 0;
+  spi1_status.SPIRBF = spi1_fifo_count > 0;
+  spi1_status.SPITBF = spi1_fifo_count >= depth;
+
+  return &spi1_status;
+}
+
+volatile AD1CON1BITS *bp_host_adc_control(void) {
+  /* Conversions are over as soon as anyone looks. */
+  switch (AD1CHS & 0x1F) {
+  case BP_ADC_3V3:
+    ADC1BUF0 = ADC_READING_3V3;
+    break;
+
+  case BP_ADC_5V0:
+    ADC1BUF0 = ADC_READING_5V0;
+    break;
+
+  default:
+    ADC1BUF0 = 0;
+    break;
+  }
+  adc_control.DONE = ON;
+
+  return &adc_control;
+}
+
+/**
+ * Reads a program word, either from a host array laid out by packstrings.py
+ * or from the handful of configuration words the firmware asks for.
+ */
+static uint32_t table_read(const unsigned long offset) {
+  const uint8_t *word;
+
+  if (offset & BP_HOST_PROGRAM_SPACE) {
+    word = (const uint8_t *)(uintptr_t)((offset & ~(BP_HOST_PROGRAM_SPACE | 1))
+                                        << 1);
+    return word[0] | (word[1] << 8) | ((uint32_t)word[2] << 16);
+  }
+
+  if ((TBLPAG & 0xFF) == DEV_ADDR_UPPER) {
+    switch (offset & 0xFFFF) {
+    case DEV_ADDR_TYPE:
+      return DEVICE_ID;
+
+    case DEV_ADDR_REV:
+      return PIC_REV_B8;
+
+    default:
+      break;
+    }
+  }
+
+  if (((TBLPAG & 0xFF) == 0) && ((offset & 0xFFFF) == BL_ADDR_VER)) {
+    return BOOTLOADER_VERSION;
+  }
+
+  /* Erased flash. */
+  return 0x00FFFFFF;
+}
+
+uint16_t bp_host_table_read_low(const unsigned long offset) {
+  return table_read(offset) & 0xFFFF;
+}
+
+uint16_t bp_host_table_read_high(const unsigned long offset) {
+  return (table_read(offset) >> 16) & 0xFF;
+}
+
+/* C versions of the assembly routines, sampling whatever the pins hold. */
+
+void sump_capture_16mhz(uint16_t *buffer, uint16_t samples) {
+  while (samples-- > 0) {
+    *buffer++ = PORTB;
+  }
+}
+
+void sump_capture_4mhz(uint16_t *buffer, uint16_t samples) {
+  sump_capture_16mhz(buffer, samples);
+}
+
+void sump_capture_2mhz(uint16_t *buffer, uint16_t samples) {
+  sump_capture_16mhz(buffer, samples);
+}
+
+void spi_flash_dual_read_fast(uint8_t *buffer, uint16_t length) {
+  memset(buffer, 0xFF, length);
+}
+
+void xsvfShiftBytesFast(const unsigned char *tdi, unsigned char *tdo,
+                        unsigned int bytes) {
+  if (tdo != NULL) {
+    memcpy(tdo, tdi, bytes);
+  }
+}
+
+void xsvfTmsSequenceFast(unsigned int tms, unsigned int clocks) {
+  (void)tms;
+  (void)clocks;
+}
+
+void binOpenOCDTapShiftFast(unsigned char *in_buf, unsigned char *out_buf,
+                            unsigned int bits, unsigned int delay) {
+  (void)in_buf;
+  (void)delay;
+  memset(out_buf, 0, (bits + 7) / 8);
+}
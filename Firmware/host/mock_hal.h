@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file mock_hal.h
+ *
+ * @brief Runs the v3 firmware on the host, fed from a byte script.
+ *
+ * The script goes in through UART1 as if typed or sent by a host program,
+ * and whatever the firmware transmits on UART1 comes out of a stream.  A run
+ * ends once the script is consumed and the firmware keeps waiting for more.
+ */
+
+#ifndef BP_HOST_MOCK_HAL_H
+#define BP_HOST_MOCK_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * What happened during a run.
+ */
+typedef struct {
+  /** Script bytes the firmware read. */
+  size_t bytes_in;
+
+  /** Bytes the firmware transmitted. */
+  size_t bytes_out;
+
+  /** How many times the firmware reset itself. */
+  unsigned int resets;
+} bp_host_statistics_t;
+
+/**
+ * The firmware entry point, main.c is built with main renamed to this.
+ */
+int bp_firmware_main(void);
+
+/**
+ * Boots the firmware and feeds it a script until it is done with it.
+ *
+ * Firmware state kept in RAM carries over from one run to the next, as it
+ * would across a software reset on the board.
+ *
+ * @param[in] script the bytes to send to the firmware.
+ * @param[in] length how many bytes the script is made of.
+ * @param[in] output where transmitted bytes go, or NULL to drop them.
+ * @param[out] statistics filled with what happened during the run.
+ */
+void bp_host_run(const uint8_t *script, const size_t length, FILE *output,
+                 bp_host_statistics_t *statistics);
+
+#endif /* !BP_HOST_MOCK_HAL_H */
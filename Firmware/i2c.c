@@ -23,8 +23,11 @@
 #include "base.h"
 #include "binary_io.h"
 #include "bitbang.h"
+#include "buffer_arena.h"
+#include "compressed_read.h"
 #include "core.h"
 #include "proc_menu.h"
+#include "telemetry.h"
 
 #if defined(BUSPIRATEV4) && !defined(BP_I2C_USE_HW_BUS)
 #error "Bus Pirate v4 must be able to use the hardware I2C interface!"
@@ -88,6 +91,23 @@ typedef struct {
  */
 static i2c_state_t i2c_state = {0};
 
+/**
+ * Settings binary mode had when it was last left.
+ */
+static struct {
+  /** Clock stretch timeout, as given to bitbang_set_clock_stretch_timeout. */
+  uint16_t clock_stretch_timeout;
+
+  /** Bus speed index. */
+  uint8_t speed : 2;
+
+  /** I2C_TYPE_SOFTWARE or I2C_TYPE_HARDWARE. */
+  uint8_t mode : 1;
+
+  /** Binary mode was left at least once. */
+  uint8_t saved : 1;
+} i2c_binary_io_settings = {0};
+
 #define SCL BP_CLK
 #define SCL_TRIS BP_CLK_DIR
 #define SDA BP_MOSI
@@ -131,6 +151,11 @@ static void hardware_i2c_setup(void);
  */
 static void hardware_i2c_start(void);
 
+/**
+ * Sends a repeated start condition on the chosen hardware I2C interface.
+ */
+static void hardware_i2c_restart(void);
+
 /**
  * Sends a stop condition on the chosen hardware I2C interface.
  */
@@ -178,8 +203,12 @@ static uint8_t hardware_i2c_read(void);
  * @param[in] interactive_mode true if data is shown to a human via the serial
  *                             command interface, false if data is sent as part
  *                             of a binary I/O command stream.
+ *
+ * @return true if sniffing took place, false if there was no room for the
+ * serial port ringbuffer, in which case a failure code is sent in binary I/O
+ * mode.
  */
-static void i2c_sniffer(bool interactive_mode);
+static bool i2c_sniffer(bool interactive_mode);
 
 /**
  * Performs the bulk of the write-then-read I2C binary IO command.
@@ -188,206 +217,947 @@ static void i2c_sniffer(bool interactive_mode);
  */
 static bool i2c_write_then_read(void);
 
-uint16_t i2c_read(void) {
-  uint8_t value;
-
-  if (i2c_state.acknowledgment_pending) {
-    handle_pending_ack(I2C_ACK_BIT);
-    bpSP;
-    MSG_ACK;
-    bpSP;
-  }
+/**
+ * Binary I/O I2C mode command to set the software backend clock stretching
+ * timeout, followed by the timeout in microseconds as a big endian 16 bits
+ * value (zero disables clock stretching detection).
+ */
+#define I2C_BINARY_IO_COMMAND_SET_CLOCK_STRETCH_TIMEOUT 0x05
 
-  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-    value = bitbang_read_value();
-  } else {
-#ifdef BP_I2C_USE_HW_BUS
-    value = hardware_i2c_read();
-#else
-    value = 0;
-#endif /* BP_I2C_USE_HW_BUS */
-  }
-  i2c_state.acknowledgment_pending = true;
-  return value;
-}
+/**
+ * Binary I/O I2C mode command to select the bus backend, followed by either
+ * I2C_TYPE_SOFTWARE or I2C_TYPE_HARDWARE.
+ */
+#define I2C_BINARY_IO_COMMAND_SELECT_BACKEND 0x0A
 
-unsigned int i2c_write(unsigned int c) {
-  if (i2c_state.acknowledgment_pending) {
-    bpSP;
-    MSG_ACK;
-    bpSP;
-    handle_pending_ack(I2C_ACK_BIT);
-  }
+/**
+ * Binary I/O I2C mode command for a streamed write-then-read, with 32 bits
+ * lengths.
+ */
+#define I2C_BINARY_IO_COMMAND_STREAMING_WRITE_THEN_READ 0x0B
 
-  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-    bitbang_write_value(c);
-    c = bitbang_read_bit();
-  } else {
-#ifdef BP_I2C_USE_HW_BUS
-    hardware_i2c_write(c);
-    c = hardware_i2c_get_ack();
-#endif /* BP_I2C_USE_HW_BUS */
-  }
+/**
+ * How many bytes read from the bus are sent to the serial port at once, by the
+ * streamed write-then-read command.  This matches one CDC packet on v4.
+ */
+#define I2C_STREAMING_READ_CHUNK_SIZE 64
 
-  bpSP;
-  if (c == 0) {
-    MSG_ACK;
-    return 0x300; // bit 9=ack
-  }
+/**
+ * Performs a streamed write-then-read I2C binary IO command.
+ *
+ * The command payload is as follows:
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Size</th><th>Description</th></tr>
+ * <tr><td>0</td><td>4</td><td>Bytes to write, big endian</td></tr>
+ * <tr><td>4</td><td>4</td><td>Bytes to read, big endian</td></tr>
+ * <tr><td>8</td><td>N</td><td>Data to write, starting with the address</td></tr>
+ * </table>
+ *
+ * Unlike i2c_write_then_read, each byte is put on the bus as soon as it comes
+ * from the serial port and there is no size limit other than the length
+ * fields.  If a byte is not acknowledged the rest of the payload is still
+ * consumed but discarded, and a failure code is sent.  Otherwise a success
+ * code is sent once the read phase is set up, followed by the data read from
+ * the bus in chunks of I2C_STREAMING_READ_CHUNK_SIZE bytes, or as a compressed
+ * read token stream (see compressed_read.h) if compressed is set.  Reading
+ * without writing at least the address byte is reported as a failure before
+ * any data is consumed.
+ *
+ * @param[in] compressed true to send the data read as a token stream.
+ */
+static void i2c_streaming_write_then_read(const bool compressed);
 
-  MSG_NACK;
-  return 0x100; // bit 9=ack
-}
+#ifdef BP_ENABLE_COMPRESSED_READS
 
-void i2c_start(void) {
-  /* Reset the bus state if an acknowledgment is pending. */
+/**
+ * Binary I/O I2C mode command for a streamed write-then-read whose data is
+ * sent back compressed, with the same payload as
+ * I2C_BINARY_IO_COMMAND_STREAMING_WRITE_THEN_READ.
+ */
+#define I2C_BINARY_IO_COMMAND_COMPRESSED_STREAMING_WRITE_THEN_READ 0x28
 
-  if (i2c_state.acknowledgment_pending) {
-    MSG_NACK;
-    bpBR;
+#endif /* BP_ENABLE_COMPRESSED_READS */
 
-    handle_pending_ack(I2C_NACK_BIT);
-  }
+/**
+ * Binary I/O I2C mode command for programming I2C EEPROMs.
+ */
+#define I2C_BINARY_IO_COMMAND_EEPROM_PROGRAM 0x0C
 
-  /* Send a start signal on the bus. */
+/**
+ * How many times to poll an I2C EEPROM for an ACK after a page write, before
+ * giving up.  With a 10us pause between polls this is well over the 5-10ms
+ * write cycle time of common 24xx parts even at high bus speeds.
+ */
+#define I2C_EEPROM_ACK_POLL_ATTEMPTS 1000
 
-  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-    if (bitbang_i2c_start(BITBANG_I2C_START_ONE_SHOT)) {
-      /* There is a short or pull-ups are wrong. */
-      MSG_WARNING_HEADER;
-      MSG_WARNING_SHORT_OR_NO_PULLUP;
-      bpBR;
-    }
-  } else {
-#ifdef BP_I2C_USE_HW_BUS
-    hardware_i2c_start();
-#endif /* BP_I2C_USE_HW_BUS */
-  }
+/**
+ * Performs an I2C EEPROM programming binary IO command.
+ *
+ * The command payload is as follows:
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Size</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>Device write address</td></tr>
+ * <tr><td>1</td><td>1</td><td>Memory address width, 1 or 2 bytes</td></tr>
+ * <tr><td>2</td><td>2</td><td>Page size, big endian</td></tr>
+ * <tr><td>4</td><td>4</td><td>Memory address, big endian</td></tr>
+ * <tr><td>8</td><td>4</td><td>Bytes to write, big endian</td></tr>
+ * <tr><td>12</td><td>N</td><td>Data to write</td></tr>
+ * </table>
+ *
+ * Memory address bits past the address width are folded into bits 1 to 3 of
+ * the device address, as 24C04/08/16 (one byte) and 24CM01/02 (two bytes)
+ * parts expect.  A result code is sent once the parameters are checked, then
+ * one per page after the host sent that page's data and the chip acknowledged
+ * again after its write cycle.  Pages are aligned to the page size, so the
+ * first and last pages can be shorter.  On failure the rest of the current
+ * page is still consumed, and the host is expected to stop sending data.
+ */
+static void i2c_eeprom_program(void);
 
-  MSG_I2C_START_BIT;
-}
+/**
+ * Polls an I2C EEPROM with its device address until it acknowledges again,
+ * meaning its internal write cycle is over.
+ *
+ * @param[in] device_address the device write address.
+ *
+ * @return true if the chip acknowledged in time, false otherwise.
+ */
+static bool i2c_eeprom_wait_until_ready(const uint8_t device_address);
 
-void i2c_stop(void) {
-  if (i2c_state.acknowledgment_pending) {
-    MSG_NACK;
-    bpBR;
+/**
+ * Binary I/O I2C mode command for scanning the bus for devices.
+ */
+#define I2C_BINARY_IO_COMMAND_SCAN 0x0D
 
-    handle_pending_ack(I2C_NACK_BIT);
-  }
+/**
+ * Performs an I2C bus scan binary IO command.
+ *
+ * The command payload is the first and the last 7-bits address to probe.  Each
+ * address in that range is probed with a start condition, the address in
+ * write mode and a stop condition.  An invalid range is reported with a
+ * failure code, otherwise a success code is sent followed by a 16 bytes
+ * bitmap where bit N (LSB first) of byte M is set if address (M * 8) + N
+ * acknowledged.  Addresses outside the range are always reported as absent.
+ */
+static void i2c_scan(void);
 
-  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-    bitbang_i2c_stop();
-  } else {
-#ifdef BP_I2C_USE_HW_BUS
-    hardware_i2c_stop();
-#endif /* BP_I2C_USE_HW_BUS */
-  }
+/**
+ * Binary I/O I2C mode command for reading register blocks from several
+ * devices at once.
+ */
+#define I2C_BINARY_IO_COMMAND_BATCH_REGISTER_READ 0x20
 
-  MSG_I2C_STOP_BIT;
-}
+/**
+ * Size of a batch register read entry, in bytes.
+ */
+#define I2C_BATCH_ENTRY_SIZE 3
 
-void i2c_print_settings(void) {
-  BPMSG1068;
-#ifdef BP_I2C_USE_HW_BUS
-  bp_write_dec_byte(i2c_state.mode);
-#else
-  bp_write_dec_byte(0);
-#endif /* BP_I2C_USE_HW_BUS */
-  bpSP;
-  bp_write_dec_byte(mode_configuration.speed);
-  bp_write_line(" )");
-}
+/**
+ * Performs a batch register read binary IO command.
+ *
+ * The command payload is an entries count (1 to 255), followed by that many
+ * entries made of a 7-bits device address, a register number, and how many
+ * bytes to read from that register.  Each entry is performed as a register
+ * write followed by a read, all entries being chained with repeated starts
+ * and a single stop condition at the end.
+ *
+ * If the results would not fit in the terminal buffer a failure code is sent
+ * once all entries were received, otherwise a success code is sent followed by
+ * one block per entry, in the same order: a status byte (0x01 if the device
+ * acknowledged everything, 0x00 otherwise) and exactly the requested amount of
+ * bytes, set to 0xFF for failed entries.
+ */
+static void i2c_batch_register_read(void);
 
-void i2c_setup_prepare(void) {
-  int HW;
-  int speed;
+/**
+ * Binary I/O I2C mode command for an SMBus block write.
+ */
+#define I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_WRITE 0x25
 
-  HW = 0; // keep compiler happy if BP_USE_HW is not defined
+/**
+ * Binary I/O I2C mode command for an SMBus block read.
+ */
+#define I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_READ 0x26
 
-#ifdef BP_I2C_USE_HW_BUS
-  consumewhitechars();
-  HW = getint();
-#else
-  i2c_state.mode = I2C_TYPE_SOFTWARE;
-#endif /* BP_I2C_USE_HW_BUS */
+/**
+ * Binary I/O I2C mode command for an SMBus block write-block read process
+ * call.
+ */
+#define I2C_BINARY_IO_COMMAND_SMBUS_PROCESS_CALL 0x27
 
-  consumewhitechars();
-  speed = getint();
+/**
+ * SMBus transaction flag, append a PEC byte to what is written and check the
+ * one the device sends after what is read.
+ */
+#define I2C_SMBUS_FLAG_PEC 0x01
 
-#ifdef BP_I2C_USE_HW_BUS
-  if ((HW > 0) && (HW <= 2)) {
-    i2c_state.mode = HW - 1;
-  } else {
-    speed = 0;
-  }
-#endif /* BP_I2C_USE_HW_BUS */
+/**
+ * SMBus transaction status, no byte was left unacknowledged.
+ */
+#define I2C_SMBUS_STATUS_SUCCESS 0x01
 
-  if ((speed > 0) && (speed <= 4)) {
-    mode_configuration.speed = speed - 1;
-  } else {
-    speed = 0;
-  }
+/**
+ * SMBus transaction status, the device did not acknowledge a byte.
+ */
+#define I2C_SMBUS_STATUS_NACK 0x00
 
-  if (speed == 0) {
-    mode_configuration.command_error = NO;
+/**
+ * SMBus transaction status, the PEC byte sent by the device does not match
+ * the one computed over the transaction.
+ */
+#define I2C_SMBUS_STATUS_PEC_MISMATCH 0x02
 
-#ifdef BP_I2C_USE_HW_BUS
-    BPMSG1064;
-    i2c_state.mode = (getnumber(1, 1, 2, 0) - 1);
-#else
-    i2c_state.mode = I2C_TYPE_SOFTWARE;
-#endif /* BP_I2C_USE_HW_BUS */
+/**
+ * Offset in the terminal buffer where an SMBus transaction keeps the block
+ * read from the device, past the largest block that can be written.
+ */
+#define I2C_SMBUS_READ_BLOCK_OFFSET 256
 
-    if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-      MSG_SOFTWARE_MODE_SPEED_PROMPT;
-      mode_configuration.speed = (getnumber(1, 1, 4, 0) - 1);
-    } else {
-#if defined(BUSPIRATEV3) && !defined(BPV3_IS_REV_B4_OR_LATER)
-      if (bus_pirate_configuration.device_revision <= PIC_REV_A3) {
-        BPMSG1066;
-      }
-#endif /* BUSPIRATEV3 && !BPV3_IS_REV_B4_OR_LATER */
-      BPMSG1067;
-      mode_configuration.speed = (getnumber(1, 1, 3, 0) - 1);
-    }
-  } else {
-#if defined(BUSPIRATEV3) && !defined(BPV3_IS_REV_B4_OR_LATER)
-    if (bus_pirate_configuration.device_revision <= PIC_REV_A3) {
-      BPMSG1066;
-    }
-#endif /* BUSPIRATEV3 && !BPV3_IS_REV_B4_OR_LATER */
-    i2c_print_settings();
+/**
+ * Performs an SMBus block write, block read or process call binary IO command.
+ *
+ * The command payload is a 7-bits device address, the SMBus command code and
+ * a flags byte (I2C_SMBUS_FLAG_PEC, other bits must be zero).  Block writes
+ * and process calls follow it with a byte count (1 to 255) and that many data
+ * bytes; a zero count is reported with a failure code straight away.
+ *
+ * The whole transaction, byte count and PEC included, is carried out on the
+ * device, then a status code is sent (I2C_SMBUS_STATUS_*).  Block reads and
+ * process calls follow it with the byte count sent by the device (zero if the
+ * transaction failed before it) and the data bytes.  The PEC is computed over
+ * every byte on the bus, address bytes included, with a flash lookup table.
+ *
+ * @param[in] command the binary I/O command that started the transaction.
+ */
+static void i2c_smbus_transaction(const uint8_t command);
 
-    i2c_state.acknowledgment_pending = false;
-  }
+/**
+ * Writes a byte on the current binary I/O backend, updating the SMBus PEC.
+ *
+ * @param[in]     value the byte to write.
+ * @param[in,out] pec   the PEC value to update.
+ *
+ * @return true if the byte was acknowledged, false otherwise.
+ */
+static bool i2c_smbus_write(const uint8_t value, uint8_t *pec);
 
-  mode_configuration.high_impedance = ON;
-}
+/**
+ * Reads a byte from the current binary I/O backend, updating the SMBus PEC.
+ *
+ * @param[in]     last  true to NACK the byte, false to ACK it.
+ * @param[in,out] pec   the PEC value to update.
+ *
+ * @return the byte read from the bus.
+ */
+static uint8_t i2c_smbus_read(const bool last, uint8_t *pec);
 
-void i2c_setup_execute(void) {
-  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
-    SDA_TRIS = INPUT;
-    SCL_TRIS = INPUT;
-    SCL = LOW;
-    SDA = LOW;
-    bitbang_setup(2, mode_configuration.speed);
-  } else {
-#ifdef BP_I2C_USE_HW_BUS
-    hardware_i2c_setup();
-#endif /* BP_I2C_USE_HW_BUS */
-  }
-}
+#ifdef BP_I2C_ENABLE_INTERRUPT_SNIFFER
 
-void i2c_cleanup(void) {
-  /* Clear any pending ACK from previous use. */
-  i2c_state.acknowledgment_pending = false;
+/**
+ * Binary I/O I2C mode command for the timestamped event sniffer.
+ */
+#define I2C_BINARY_IO_COMMAND_TIMESTAMPED_SNIFFER 0x0E
 
-#ifdef BP_I2C_USE_HW_BUS
-  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+/**
+ * Binary I/O I2C mode command for the timestamped event sniffer, only
+ * capturing transactions whose address matches a filter.
+ *
+ * The command is followed by the 7 bits address to match and by the mask of
+ * the address bits to compare.
+ */
+#define I2C_BINARY_IO_COMMAND_FILTERED_SNIFFER 0x22
 
-#ifdef BUSPIRATEV4
+/**
+ * Binary I/O I2C mode command for the traffic statistics sniffer.
+ */
+#define I2C_BINARY_IO_COMMAND_TRAFFIC_STATISTICS 0x23
 
-    /* Disable external I2C module. */
+/**
+ * Binary I/O I2C mode command to read the telemetry counters.
+ *
+ * @see bp_binary_io_send_telemetry
+ */
+#define I2C_BINARY_IO_COMMAND_TELEMETRY 0x24
+
+/**
+ * Traffic statistics sub-command, stop counting.
+ */
+#define I2C_STATISTICS_COMMAND_STOP 0x00
+
+/**
+ * Traffic statistics sub-command, send the counters.
+ */
+#define I2C_STATISTICS_COMMAND_READ 0x01
+
+/**
+ * Traffic statistics sub-command, send the counters and zero them.
+ */
+#define I2C_STATISTICS_COMMAND_READ_AND_CLEAR 0x02
+
+/**
+ * How many addresses traffic statistics are kept for, one per 7 bits address.
+ */
+#define I2C_STATISTICS_ADDRESSES 128
+
+/**
+ * Traffic counters for a single address.
+ */
+typedef struct {
+
+  /** Address bytes seen after a start or repeated start. */
+  uint32_t transactions;
+
+  /** Bytes seen after the address byte, before the next start or stop. */
+  uint32_t bytes;
+
+  /** Bytes, address included, followed by a NACK. */
+  uint32_t naks;
+
+} i2c_traffic_counters_t;
+
+/**
+ * Size of the timestamped sniffer capture ring, must be a power of two and a
+ * multiple of I2C_SNIFFER_RECORD_SIZE.
+ */
+#define I2C_CAPTURE_RING_SIZE 512
+
+/**
+ * Mask to wrap indices into the timestamped sniffer capture ring.
+ */
+#define I2C_CAPTURE_RING_MASK (I2C_CAPTURE_RING_SIZE - 1)
+
+/**
+ * Size of a timestamped sniffer record, in bytes.
+ */
+#define I2C_SNIFFER_RECORD_SIZE 4
+
+/**
+ * Timestamped sniffer record types.
+ */
+typedef enum {
+  /** A start (or repeated start) condition was seen. */
+  I2C_SNIFFER_RECORD_START = 0,
+  /** A stop condition was seen. */
+  I2C_SNIFFER_RECORD_STOP,
+  /** A byte was seen, followed by an ACK. */
+  I2C_SNIFFER_RECORD_DATA_ACK,
+  /** A byte was seen, followed by a NACK. */
+  I2C_SNIFFER_RECORD_DATA_NACK,
+  /** Some events were dropped for lack of space, the data byte is unused. */
+  I2C_SNIFFER_RECORD_OVERFLOW
+} i2c_sniffer_record_type_t;
+
+/**
+ * Timestamped sniffer capture state.
+ *
+ * The change notification interrupt is the only producer, and the main loop
+ * is the only consumer.  Each side only ever writes its own index, so no
+ * locking is needed as 16 bits accesses are atomic.
+ */
+typedef struct {
+
+  /** Next slot to write, only updated by the interrupt handler. */
+  volatile uint16_t head;
+
+  /** Next slot to read, only updated by the main loop. */
+  volatile uint16_t tail;
+
+  /** Set by the interrupt handler when an event had to be dropped. */
+  volatile bool overflow;
+
+  /** Whether bits are being collected, between a start and a stop. */
+  bool collect_data;
+
+  /** How many bits of the current byte were seen so far. */
+  uint8_t data_bits;
+
+  /** The bits of the current byte seen so far. */
+  uint8_t data_value;
+
+  /** SDA line state when the previous interrupt fired. */
+  bool old_sda;
+
+  /** SCL line state when the previous interrupt fired. */
+  bool old_scl;
+
+  /** Timer value when the previous record was captured. */
+  uint16_t last_tick;
+
+  /** Whether transactions are filtered by address. */
+  bool filtering;
+
+  /** Address bits a transaction must have to be captured. */
+  uint8_t filter_address;
+
+  /** Which address bits are compared. */
+  uint8_t filter_mask;
+
+  /** Whether the byte being collected is the address after a start. */
+  bool awaiting_address;
+
+  /** Whether the current transaction is being captured. */
+  bool capturing;
+
+  /** Timer value of the start condition waiting for its address byte. */
+  uint16_t start_tick;
+
+  /** Per address counters while gathering statistics, NULL otherwise. */
+  i2c_traffic_counters_t *statistics;
+
+  /** Address of the transaction in progress, for statistics. */
+  uint8_t current_address;
+
+  /** Captured records, from the buffer arena while the sniffer runs. */
+  uint8_t *data;
+
+} i2c_capture_ring_t;
+
+/**
+ * The timestamped sniffer capture state.
+ */
+static i2c_capture_ring_t i2c_capture_ring;
+
+/**
+ * Runs the timestamped I2C sniffer until a byte comes from the serial port.
+ *
+ * Every event is sent as a I2C_SNIFFER_RECORD_SIZE bytes record: the record
+ * type, the data byte (or zero), and the amount of 0.5us ticks elapsed since
+ * the previous record (big endian, saturated to 0xFFFF).
+ *
+ * With a non-zero filter mask, a transaction is only captured when the
+ * masked bits of the address sent after its start condition match the
+ * filter address.  The start record then comes along with the address byte,
+ * with the timing of the start condition.  Each repeated start is filtered
+ * again, and a stop is only captured after a matching address.
+ *
+ * A failure code is sent if the capture ring and the serial port ringbuffer
+ * do not fit in the buffer arena, otherwise the caller answers once the bus is
+ * set up again.
+ *
+ * @param[in] filter_address the 7 bits address to match.
+ * @param[in] filter_mask    which address bits to compare, 0 to capture
+ *                           everything.
+ *
+ * @return true if sniffing took place, false if a failure code was sent.
+ *
+ * @see i2c_sniffer_record_type_t
+ */
+static bool i2c_timestamped_sniffer(const uint8_t filter_address,
+                                    const uint8_t filter_mask);
+
+/**
+ * Counts bus traffic per address until told to stop.
+ *
+ * Bus activity is decoded by the same change notification handler used by
+ * the timestamped sniffer, but nothing is recorded besides a set of
+ * i2c_traffic_counters_t for each 7 bits address.  A failure code is sent if
+ * the counters do not fit in the buffer arena, a success code otherwise.
+ *
+ * The host then drives the counting with I2C_STATISTICS_COMMAND_* bytes.
+ * Read requests are answered with a success code, how many addresses have
+ * been seen, and for each of them the address and its transactions, bytes
+ * and NACKs counters (big endian).  Addresses nobody talked to are left out.
+ * A stop request is answered by the caller once the bus is set up again.
+ *
+ * @return true if counting took place, false if a failure code was sent.
+ */
+static bool i2c_traffic_statistics(void);
+
+/**
+ * Sends the traffic counters of every address seen so far.
+ *
+ * @param[in] clear whether to zero the counters once sent.
+ */
+static void i2c_traffic_statistics_send(const bool clear);
+
+/**
+ * Updates the traffic counters after a whole byte was seen, called from the
+ * change notification interrupt.
+ *
+ * @param[in] nack whether the byte was followed by a NACK.
+ */
+static void i2c_traffic_statistics_count(const bool nack);
+
+/**
+ * Releases the bus lines and hooks the change notification handler up, with
+ * the capture state reset for the given address filter.
+ *
+ * @param[in] filter_address the 7 bits address to match.
+ * @param[in] filter_mask    which address bits to compare, 0 for none.
+ */
+static void i2c_sniffer_attach(const uint8_t filter_address,
+                               const uint8_t filter_mask);
+
+/**
+ * Unhooks the change notification handler.
+ */
+static void i2c_sniffer_detach(void);
+
+/**
+ * Appends a record to the timestamped sniffer capture ring, from the change
+ * notification interrupt handler.
+ *
+ * @param[in] type  the record type.
+ * @param[in] value the record data byte.
+ * @param[in] now   the timer value the record refers to.
+ */
+static void i2c_capture_ring_push(const i2c_sniffer_record_type_t type,
+                                  const uint8_t value, const uint16_t now);
+
+/**
+ * Samples SCL and SDA on every change and turns them into capture records,
+ * called from the change notification interrupt.
+ */
+static void i2c_sniffer_change_notification(void);
+
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER */
+
+#ifdef BP_I2C_ENABLE_SLAVE_EMULATION
+
+/**
+ * Binary I/O I2C mode command for the slave emulator.
+ */
+#define I2C_BINARY_IO_COMMAND_SLAVE_EMULATION 0x21
+
+/**
+ * Largest register map the slave emulator serves, in bytes.
+ */
+#define I2C_SLAVE_MAXIMUM_MAP_SIZE 256
+
+/**
+ * Size of the slave emulator event ring, must be a power of two and a
+ * multiple of I2C_SLAVE_EVENT_SIZE.
+ */
+#define I2C_SLAVE_EVENT_RING_SIZE 1024
+
+/**
+ * Mask to wrap indices into the slave emulator event ring.
+ */
+#define I2C_SLAVE_EVENT_RING_MASK (I2C_SLAVE_EVENT_RING_SIZE - 1)
+
+/**
+ * Size of a slave emulator event record, in bytes.
+ */
+#define I2C_SLAVE_EVENT_SIZE 4
+
+/**
+ * Slave emulator sub-command, stop emulating.
+ */
+#define I2C_SLAVE_COMMAND_STOP 0x00
+
+/**
+ * Slave emulator sub-command, send the events logged so far.
+ */
+#define I2C_SLAVE_COMMAND_DRAIN_EVENTS 0x01
+
+/**
+ * Slave emulator sub-command, send the register map as it is now.
+ */
+#define I2C_SLAVE_COMMAND_READ_MAP 0x02
+
+/**
+ * Slave emulator event record types.
+ */
+typedef enum {
+  /** The master addressed us for writing. */
+  I2C_SLAVE_EVENT_WRITE_SELECTED = 0,
+  /** The master addressed us for reading. */
+  I2C_SLAVE_EVENT_READ_SELECTED,
+  /** The first byte of a write moved the register pointer there. */
+  I2C_SLAVE_EVENT_POINTER,
+  /** The master wrote the data byte into the register. */
+  I2C_SLAVE_EVENT_WRITE,
+  /** The data byte of the register was sent to the master. */
+  I2C_SLAVE_EVENT_READ,
+  /** Some events were dropped for lack of space. */
+  I2C_SLAVE_EVENT_OVERFLOW
+} i2c_slave_event_type_t;
+
+#ifdef BUSPIRATEV4
+
+#define I2C_SLAVE_CON I2C3CONbits
+#define I2C_SLAVE_STAT I2C3STATbits
+#define I2C_SLAVE_ADD I2C3ADD
+#define I2C_SLAVE_MSK I2C3MSK
+#define I2C_SLAVE_RCV I2C3RCV
+#define I2C_SLAVE_TRN I2C3TRN
+#define I2C_SLAVE_INTERRUPT_FLAG IFS5bits.SI2C3IF
+#define I2C_SLAVE_INTERRUPT_ENABLE IEC5bits.SI2C3IE
+#define I2C_SLAVE_INTERRUPT_PRIORITY IPC21bits.SI2C3IP
+
+#else
+
+#define I2C_SLAVE_CON I2C1CONbits
+#define I2C_SLAVE_STAT I2C1STATbits
+#define I2C_SLAVE_ADD I2C1ADD
+#define I2C_SLAVE_MSK I2C1MSK
+#define I2C_SLAVE_RCV I2C1RCV
+#define I2C_SLAVE_TRN I2C1TRN
+#define I2C_SLAVE_INTERRUPT_FLAG IFS1bits.SI2C1IF
+#define I2C_SLAVE_INTERRUPT_ENABLE IEC1bits.SI2C1IE
+#define I2C_SLAVE_INTERRUPT_PRIORITY IPC4bits.SI2C1IP
+
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Slave emulator state.
+ *
+ * The slave interrupt is the only producer of events, and the main loop is
+ * the only consumer.  Each side only ever writes its own index, so no locking
+ * is needed as 16 bits accesses are atomic.
+ */
+static struct {
+
+  /** The register map, from the buffer arena. */
+  uint8_t *map;
+
+  /** Event records, from the buffer arena. */
+  uint8_t *events;
+
+  /** Next event slot to write, only updated by the interrupt handler. */
+  volatile uint16_t head;
+
+  /** Next event slot to read, only updated by the main loop. */
+  volatile uint16_t tail;
+
+  /** Set by the interrupt handler when an event had to be dropped. */
+  volatile bool overflow;
+
+  /** How many registers the map holds, the pointer wraps around past it. */
+  uint16_t size;
+
+  /** Register the next data byte is read from or written to. */
+  uint16_t pointer;
+
+  /** Whether the next byte written by the master sets the pointer. */
+  bool pointer_pending;
+
+  /** Address matches so far, tags events of the same transaction. */
+  uint8_t transaction;
+
+} i2c_slave;
+
+/**
+ * Runs the I2C slave emulator.
+ *
+ * The command is followed by the 7 bits slave address and the big endian
+ * register map size, at most I2C_SLAVE_MAXIMUM_MAP_SIZE.  If they are
+ * accepted a success byte is sent, then the map itself is read and another
+ * success byte is sent once the emulator listens on the bus.
+ *
+ * Like a typical sensor or EEPROM, the first byte of a write sets the
+ * register pointer, following bytes are stored there, and reads are served
+ * from there, with the pointer going up after every byte.  Each access is
+ * logged as a I2C_SLAVE_EVENT_SIZE bytes record: the event type, the
+ * register, the data byte, and the low byte of the transaction counter.
+ * The module gives no interrupt for stop conditions, so those are not
+ * logged.
+ *
+ * The host then drives the emulator with I2C_SLAVE_COMMAND_* bytes, which
+ * are answered with a success byte, followed by the big endian length and
+ * the records for I2C_SLAVE_COMMAND_DRAIN_EVENTS, or by the map for
+ * I2C_SLAVE_COMMAND_READ_MAP.
+ *
+ * @see i2c_slave_event_type_t
+ */
+static void i2c_slave_emulation(void);
+
+/**
+ * Appends a record to the slave emulator event ring, from the slave
+ * interrupt handler.
+ *
+ * @param[in] type     the event type.
+ * @param[in] reg      the register the event refers to.
+ * @param[in] value    the event data byte.
+ */
+static void i2c_slave_event_push(const i2c_slave_event_type_t type,
+                                 const uint8_t reg, const uint8_t value);
+
+#endif /* BP_I2C_ENABLE_SLAVE_EMULATION */
+
+/**
+ * Selects the I2C implementation to use for binary I/O commands, and sets it
+ * up with the current speed.
+ *
+ * When the hardware backend is in use, the speed set by the binary I/O speed
+ * command is an index into HARDWARE_I2C_BRG_SPEEDS (0 for 100 kHz, 1 for
+ * 400 kHz, 2 for 1 MHz) rather than a bitbang_setup speed.  Selecting the
+ * software backend brings the bit-banged speed back to its default.
+ *
+ * @param[in] mode either I2C_TYPE_SOFTWARE or I2C_TYPE_HARDWARE.
+ *
+ * @return true if the backend is available, false otherwise.
+ */
+static bool i2c_binary_io_select_backend(const uint8_t mode);
+
+/**
+ * Sets the binary I/O I2C speed up for the currently selected backend.
+ *
+ * @param[in] speed the speed index for the current backend.
+ *
+ * @return true if the speed is valid for the current backend, false otherwise.
+ */
+static bool i2c_binary_io_set_speed(const uint8_t speed);
+
+/**
+ * Sends a start or repeated start condition on the current binary I/O backend.
+ *
+ * @param[in] restart true for a repeated start, false for a start condition.
+ */
+static void i2c_binary_io_start(const bool restart);
+
+/**
+ * Sends a stop condition on the current binary I/O backend.
+ */
+static void i2c_binary_io_stop(void);
+
+/**
+ * Writes a byte on the current binary I/O backend.
+ *
+ * @param[in] value the byte to write.
+ *
+ * @return the ACK bit read after the byte.
+ *
+ * @see I2C_ACK_BIT
+ * @see I2C_NACK_BIT
+ */
+static bool i2c_binary_io_write(const uint8_t value);
+
+/**
+ * Reads a byte from the current binary I/O backend.
+ *
+ * @return the byte read from the bus.
+ */
+static uint8_t i2c_binary_io_read(void);
+
+/**
+ * Sends either an ACK or a NACK bit on the current binary I/O backend.
+ *
+ * @param[in] bus_bit false for sending an ACK, true for sending a NACK.
+ *
+ * @see I2C_ACK_BIT
+ * @see I2C_NACK_BIT
+ */
+static void i2c_binary_io_send_ack(const bool bus_bit);
+
+uint16_t i2c_read(void) {
+  uint8_t value;
+
+  if (i2c_state.acknowledgment_pending) {
+    handle_pending_ack(I2C_ACK_BIT);
+    bpSP;
+    MSG_ACK;
+    bpSP;
+  }
+
+  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+    value = bitbang_read_value();
+  } else {
+#ifdef BP_I2C_USE_HW_BUS
+    value = hardware_i2c_read();
+#else
+    value = 0;
+#endif /* BP_I2C_USE_HW_BUS */
+  }
+  i2c_state.acknowledgment_pending = true;
+  return value;
+}
+
+uint16_t i2c_write(uint16_t c) {
+  if (i2c_state.acknowledgment_pending) {
+    bpSP;
+    MSG_ACK;
+    bpSP;
+    handle_pending_ack(I2C_ACK_BIT);
+  }
+
+  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+    bitbang_write_value(c);
+    c = bitbang_read_bit();
+  } else {
+#ifdef BP_I2C_USE_HW_BUS
+    hardware_i2c_write(c);
+    c = hardware_i2c_get_ack();
+#endif /* BP_I2C_USE_HW_BUS */
+  }
+
+  bpSP;
+  if (c == 0) {
+    MSG_ACK;
+    return 0x300; // bit 9=ack
+  }
+
+  MSG_NACK;
+  return 0x100; // bit 9=ack
+}
+
+void i2c_send_buffer(const uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    i2c_write(buffer[index]);
+  }
+}
+
+void i2c_read_buffer(uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    buffer[index] = i2c_read();
+  }
+}
+
+void i2c_start(void) {
+  /* Reset the bus state if an acknowledgment is pending. */
+
+  if (i2c_state.acknowledgment_pending) {
+    MSG_NACK;
+    bpBR;
+
+    handle_pending_ack(I2C_NACK_BIT);
+  }
+
+  /* Send a start signal on the bus. */
+
+  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+    if (bitbang_i2c_start(BITBANG_I2C_START_ONE_SHOT)) {
+      /* There is a short or pull-ups are wrong. */
+      MSG_WARNING_HEADER;
+      MSG_WARNING_SHORT_OR_NO_PULLUP;
+      bpBR;
+    }
+  } else {
+#ifdef BP_I2C_USE_HW_BUS
+    hardware_i2c_start();
+#endif /* BP_I2C_USE_HW_BUS */
+  }
+
+  MSG_I2C_START_BIT;
+}
+
+void i2c_stop(void) {
+  if (i2c_state.acknowledgment_pending) {
+    MSG_NACK;
+    bpBR;
+
+    handle_pending_ack(I2C_NACK_BIT);
+  }
+
+  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+    bitbang_i2c_stop();
+  } else {
+#ifdef BP_I2C_USE_HW_BUS
+    hardware_i2c_stop();
+#endif /* BP_I2C_USE_HW_BUS */
+  }
+
+  MSG_I2C_STOP_BIT;
+}
+
+void i2c_print_settings(void) {
+  BPMSG1068;
+#ifdef BP_I2C_USE_HW_BUS
+  bp_write_dec_byte(i2c_state.mode);
+#else
+  bp_write_dec_byte(0);
+#endif /* BP_I2C_USE_HW_BUS */
+  bpSP;
+  bp_write_dec_byte(mode_configuration.speed);
+  bp_write_line(" )");
+}
+
+void i2c_setup_prepare(void) {
+  int HW;
+  int speed;
+
+  HW = 0; // keep compiler happy if BP_USE_HW is not defined
+
+#ifdef BP_I2C_USE_HW_BUS
+  consumewhitechars();
+  HW = getint();
+#else
+  i2c_state.mode = I2C_TYPE_SOFTWARE;
+#endif /* BP_I2C_USE_HW_BUS */
+
+  consumewhitechars();
+  speed = getint();
+
+#ifdef BP_I2C_USE_HW_BUS
+  if ((HW > 0) && (HW <= 2)) {
+    i2c_state.mode = HW - 1;
+  } else {
+    speed = 0;
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  if ((speed > 0) && (speed <= 4)) {
+    mode_configuration.speed = speed - 1;
+  } else {
+    speed = 0;
+  }
+
+  if (speed == 0) {
+    mode_configuration.command_error = NO;
+
+#ifdef BP_I2C_USE_HW_BUS
+    BPMSG1064;
+    i2c_state.mode = (getnumber(1, 1, 2, 0) - 1);
+#else
+    i2c_state.mode = I2C_TYPE_SOFTWARE;
+#endif /* BP_I2C_USE_HW_BUS */
+
+    if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+      MSG_SOFTWARE_MODE_SPEED_PROMPT;
+      mode_configuration.speed = (getnumber(1, 1, 4, 0) - 1);
+    } else {
+#if defined(BUSPIRATEV3) && !defined(BPV3_IS_REV_B4_OR_LATER)
+      if (bus_pirate_configuration.device_revision <= PIC_REV_A3) {
+        BPMSG1066;
+      }
+#endif /* BUSPIRATEV3 && !BPV3_IS_REV_B4_OR_LATER */
+      BPMSG1067;
+      mode_configuration.speed = (getnumber(1, 1, 3, 0) - 1);
+    }
+  } else {
+#if defined(BUSPIRATEV3) && !defined(BPV3_IS_REV_B4_OR_LATER)
+    if (bus_pirate_configuration.device_revision <= PIC_REV_A3) {
+      BPMSG1066;
+    }
+#endif /* BUSPIRATEV3 && !BPV3_IS_REV_B4_OR_LATER */
+    i2c_print_settings();
+
+    i2c_state.acknowledgment_pending = false;
+  }
+
+  mode_configuration.high_impedance = ON;
+}
+
+void i2c_setup_execute(void) {
+  if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
+    SDA_TRIS = INPUT;
+    SCL_TRIS = INPUT;
+    SCL = LOW;
+    SDA = LOW;
+    bitbang_setup(2, mode_configuration.speed);
+  } else {
+#ifdef BP_I2C_USE_HW_BUS
+    hardware_i2c_setup();
+#endif /* BP_I2C_USE_HW_BUS */
+  }
+}
+
+void i2c_cleanup(void) {
+  /* Clear any pending ACK from previous use. */
+  i2c_state.acknowledgment_pending = false;
+
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+
+#ifdef BUSPIRATEV4
+
+    /* Disable external I2C module. */
     I2C3CONbits.I2CEN = OFF;
 
     /* Disable EEPROM I2C module. */
@@ -403,7 +1173,7 @@ void i2c_cleanup(void) {
 #endif /* BP_I2C_USE_HW_BUS */
 }
 
-void i2c_macro(unsigned int c) {
+void i2c_macro(uint16_t c) {
   int i;
 
   switch (c) {
@@ -562,6 +1332,28 @@ void hardware_i2c_start(void) {
   }
 }
 
+void hardware_i2c_restart(void) {
+#if defined(BUSPIRATEV4)
+  if (!i2c_state.to_eeprom) {
+    /* Repeated start condition on the external v4 I2C bus. */
+    I2C3CONbits.RSEN = ON;
+    while (I2C3CONbits.RSEN == ON) {
+    }
+
+    return;
+  }
+#endif /* BUSPIRATEV4 */
+
+  /*
+   * Repeated start condition on the EEPROM v4 I2C bus or on the external v3
+   * I2C bus.
+   */
+  I2C1CONbits.RSEN = ON;
+
+  while (I2C1CONbits.RSEN == ON) {
+  }
+}
+
 void hardware_i2c_stop(void) {
 
 #if defined(BUSPIRATEV4)
@@ -796,7 +1588,7 @@ void hardware_i2c_setup(void) {
 
 #endif /* BP_I2C_USE_HW_BUS */
 
-void i2c_sniffer(bool interactive_mode) {
+bool i2c_sniffer(bool interactive_mode) {
   bool new_sda;
   bool old_sda;
   bool new_scl;
@@ -811,7 +1603,12 @@ void i2c_sniffer(bool interactive_mode) {
   data_value = 0;
 
   /* Setup UART ringbuffer. */
-  user_serial_ringbuffer_setup();
+  if (!user_serial_ringbuffer_setup()) {
+    if (!interactive_mode) {
+      REPORT_IO_FAILURE();
+    }
+    return false;
+  }
 
   SDA_TRIS = INPUT;
   SCL_TRIS = INPUT;
@@ -904,11 +1701,551 @@ void i2c_sniffer(bool interactive_mode) {
   BP_MOSI_CN = OFF;
   BP_CLK_CN = OFF;
 
+  user_serial_ringbuffer_release();
+
   if (interactive_mode) {
     bpBR;
   }
+
+  return true;
+}
+
+#ifdef BP_I2C_ENABLE_INTERRUPT_SNIFFER
+
+void i2c_sniffer_attach(const uint8_t filter_address,
+                        const uint8_t filter_mask) {
+  SDA_TRIS = INPUT;
+  SCL_TRIS = INPUT;
+  SCL = LOW;
+  SDA = LOW;
+
+  i2c_capture_ring.head = 0;
+  i2c_capture_ring.tail = 0;
+  i2c_capture_ring.overflow = false;
+  i2c_capture_ring.collect_data = false;
+  i2c_capture_ring.data_bits = 0;
+  i2c_capture_ring.data_value = 0;
+  i2c_capture_ring.old_sda = SDA;
+  i2c_capture_ring.old_scl = SCL;
+  i2c_capture_ring.last_tick = 0;
+  i2c_capture_ring.filtering = (filter_mask & 0x7F) != 0;
+  i2c_capture_ring.filter_address = filter_address & filter_mask & 0x7F;
+  i2c_capture_ring.filter_mask = filter_mask & 0x7F;
+  i2c_capture_ring.awaiting_address = false;
+  i2c_capture_ring.capturing = !i2c_capture_ring.filtering;
+  i2c_capture_ring.start_tick = 0;
+  i2c_capture_ring.current_address = 0;
+
+  /* Enable change notice on SCL and SDA, ahead of the USB interrupt. */
+  bp_set_change_notification_handler(i2c_sniffer_change_notification);
+  BP_MOSI_CN = ON;
+  BP_CLK_CN = ON;
+  IPC4bits.CNIP = 6;
+  IFS1bits.CNIF = OFF;
+  IEC1bits.CNIE = ON;
+}
+
+void i2c_sniffer_detach(void) {
+
+  /* Disable I2C pin change interrupts. */
+  IEC1bits.CNIE = OFF;
+  IPC4bits.CNIP = 0;
+  BP_MOSI_CN = OFF;
+  BP_CLK_CN = OFF;
+  IFS1bits.CNIF = OFF;
+  bp_set_change_notification_handler(NULL);
+}
+
+bool i2c_timestamped_sniffer(const uint8_t filter_address,
+                             const uint8_t filter_mask) {
+  uint16_t tail;
+
+  i2c_capture_ring.data = bp_buffer_arena_reserve(I2C_CAPTURE_RING_SIZE);
+  if (i2c_capture_ring.data == NULL) {
+    REPORT_IO_FAILURE();
+    return false;
+  }
+
+  /* The ringbuffer takes what is left of the arena, past the capture ring. */
+  if (!user_serial_ringbuffer_setup()) {
+    bp_buffer_arena_release(i2c_capture_ring.data);
+    i2c_capture_ring.data = NULL;
+    REPORT_IO_FAILURE();
+    return false;
+  }
+
+  /*
+   * T1CON - TIMER 1 CONTROL REGISTER
+   *
+   * MSB
+   * 1-0-------01-0-
+   * | |       || |
+   * | |       || +---- TCS:   Internal clock (Fosc/2).
+   * | |       ++------ TCKPS: 1:8 Prescaler (0.5us per tick).
+   * | +--------------- TSIDL: Continue module operation in idle mode.
+   * +----------------- TON:   Timer ON.
+   */
+  PR1 = 0xFFFF;
+  TMR1 = 0x0000;
+  IFS0bits.T1IF = OFF;
+  T1CON = (ON << _T1CON_TON_POSITION) | (0b01 << _T1CON_TCKPS_POSITION);
+
+  i2c_sniffer_attach(filter_address, filter_mask);
+
+  for (;;) {
+
+    /* Tell the host events were lost, if any. */
+    if (i2c_capture_ring.overflow) {
+      bp_notify(BP_NOTIFICATION_OVERFLOW);
+      IEC1bits.CNIE = OFF;
+      if (((i2c_capture_ring.tail - i2c_capture_ring.head - 1) &
+           I2C_CAPTURE_RING_MASK) >= I2C_SNIFFER_RECORD_SIZE) {
+        i2c_capture_ring_push(I2C_SNIFFER_RECORD_OVERFLOW, 0x00, TMR1);
+        i2c_capture_ring.overflow = false;
+      }
+      IEC1bits.CNIE = ON;
+    }
+
+    /* Hand captured records over to the serial port. */
+    tail = i2c_capture_ring.tail;
+    while (tail != i2c_capture_ring.head) {
+      user_serial_ringbuffer_append(i2c_capture_ring.data[tail]);
+      tail = (tail + 1) & I2C_CAPTURE_RING_MASK;
+    }
+    i2c_capture_ring.tail = tail;
+
+    if (bus_pirate_configuration.overflow == YES) {
+      break;
+    }
+
+    user_serial_ringbuffer_process();
+
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      user_serial_ringbuffer_flush();
+      break;
+    }
+  }
+
+  i2c_sniffer_detach();
+
+  T1CON = 0x0000;
+
+  user_serial_ringbuffer_release();
+  bp_buffer_arena_release(i2c_capture_ring.data);
+  i2c_capture_ring.data = NULL;
+
+  return true;
+}
+
+bool i2c_traffic_statistics(void) {
+  i2c_capture_ring.statistics = (i2c_traffic_counters_t *)
+      bp_buffer_arena_reserve(I2C_STATISTICS_ADDRESSES *
+                              sizeof(i2c_traffic_counters_t));
+  if (i2c_capture_ring.statistics == NULL) {
+    REPORT_IO_FAILURE();
+    return false;
+  }
+  memset(i2c_capture_ring.statistics, 0x00,
+         I2C_STATISTICS_ADDRESSES * sizeof(i2c_traffic_counters_t));
+
+  /* Starts are held until the address byte shows up, as for filtering. */
+  i2c_sniffer_attach(0x00, 0x7F);
+  REPORT_IO_SUCCESS();
+
+  for (;;) {
+    switch (user_serial_read_byte()) {
+    case I2C_STATISTICS_COMMAND_STOP:
+      break;
+
+    case I2C_STATISTICS_COMMAND_READ:
+      i2c_traffic_statistics_send(false);
+      continue;
+
+    case I2C_STATISTICS_COMMAND_READ_AND_CLEAR:
+      i2c_traffic_statistics_send(true);
+      continue;
+
+    default:
+      REPORT_IO_FAILURE();
+      continue;
+    }
+
+    break;
+  }
+
+  i2c_sniffer_detach();
+
+  bp_buffer_arena_release((uint8_t *)i2c_capture_ring.statistics);
+  i2c_capture_ring.statistics = NULL;
+
+  return true;
+}
+
+void i2c_traffic_statistics_send(const bool clear) {
+  uint8_t seen[I2C_STATISTICS_ADDRESSES / 8];
+  i2c_traffic_counters_t counters;
+  uint8_t address;
+  uint8_t count;
+
+  /* Only addresses seen now are sent, the count must match. */
+  memset(seen, 0x00, sizeof(seen));
+  count = 0;
+  for (address = 0; address < I2C_STATISTICS_ADDRESSES; address++) {
+    IEC1bits.CNIE = OFF;
+    if (i2c_capture_ring.statistics[address].transactions != 0) {
+      seen[address >> 3] |= 1 << (address & 0x07);
+      count++;
+    }
+    IEC1bits.CNIE = ON;
+  }
+
+  REPORT_IO_SUCCESS();
+  user_serial_transmit_character(count);
+
+  for (address = 0; address < I2C_STATISTICS_ADDRESSES; address++) {
+    if (!(seen[address >> 3] & (1 << (address & 0x07)))) {
+      continue;
+    }
+
+    IEC1bits.CNIE = OFF;
+    counters = i2c_capture_ring.statistics[address];
+    if (clear) {
+      memset(&i2c_capture_ring.statistics[address], 0x00,
+             sizeof(i2c_traffic_counters_t));
+    }
+    IEC1bits.CNIE = ON;
+
+    user_serial_transmit_character(address);
+    bp_binary_io_write_uint32(counters.transactions);
+    bp_binary_io_write_uint32(counters.bytes);
+    bp_binary_io_write_uint32(counters.naks);
+  }
+}
+
+void i2c_traffic_statistics_count(const bool nack) {
+  i2c_traffic_counters_t *counters;
+
+  if (i2c_capture_ring.awaiting_address) {
+    i2c_capture_ring.awaiting_address = false;
+    i2c_capture_ring.capturing = true;
+    i2c_capture_ring.current_address = i2c_capture_ring.data_value >> 1;
+    counters = &i2c_capture_ring.statistics[i2c_capture_ring.current_address];
+    counters->transactions++;
+  } else if (i2c_capture_ring.capturing) {
+    counters = &i2c_capture_ring.statistics[i2c_capture_ring.current_address];
+    counters->bytes++;
+  } else {
+    return;
+  }
+
+  if (nack) {
+    counters->naks++;
+  }
+}
+
+void i2c_capture_ring_push(const i2c_sniffer_record_type_t type,
+                           const uint8_t value, const uint16_t now) {
+  uint16_t head;
+  uint16_t delta;
+
+  if (((i2c_capture_ring.tail - i2c_capture_ring.head - 1) &
+       I2C_CAPTURE_RING_MASK) < I2C_SNIFFER_RECORD_SIZE) {
+    i2c_capture_ring.overflow = true;
+    return;
+  }
+
+  /* A wrap with the counter past the previous value is a full period. */
+  if (IFS0bits.T1IF && (now >= i2c_capture_ring.last_tick)) {
+    delta = 0xFFFF;
+  } else {
+    delta = now - i2c_capture_ring.last_tick;
+  }
+  IFS0bits.T1IF = OFF;
+  i2c_capture_ring.last_tick = now;
+
+  /* Records never straddle the end of the ring, as its size is a multiple. */
+  head = i2c_capture_ring.head;
+  i2c_capture_ring.data[head] = type;
+  i2c_capture_ring.data[head + 1] = value;
+  i2c_capture_ring.data[head + 2] = HI8(delta);
+  i2c_capture_ring.data[head + 3] = LO8(delta);
+  i2c_capture_ring.head = (head + I2C_SNIFFER_RECORD_SIZE) &
+                          I2C_CAPTURE_RING_MASK;
+}
+
+void i2c_sniffer_change_notification(void) {
+  bool new_sda;
+  bool new_scl;
+
+  new_sda = SDA;
+  new_scl = SCL;
+
+  if (i2c_capture_ring.collect_data && !i2c_capture_ring.old_scl && new_scl) {
+    /* Sample on SCL rising edge. */
+    if (i2c_capture_ring.data_bits < 8) {
+      i2c_capture_ring.data_value =
+          (i2c_capture_ring.data_value << 1) | new_sda;
+      i2c_capture_ring.data_bits++;
+    } else if (i2c_capture_ring.statistics != NULL) {
+      i2c_traffic_statistics_count(new_sda);
+      i2c_capture_ring.data_bits = 0;
+    } else {
+      if (i2c_capture_ring.awaiting_address) {
+        i2c_capture_ring.awaiting_address = false;
+        i2c_capture_ring.capturing =
+            (((i2c_capture_ring.data_value >> 1) &
+              i2c_capture_ring.filter_mask) == i2c_capture_ring.filter_address);
+        if (i2c_capture_ring.capturing) {
+          i2c_capture_ring_push(I2C_SNIFFER_RECORD_START, 0x00,
+                                i2c_capture_ring.start_tick);
+        }
+      }
+
+      /* SDA high is NACK, SDA low is ACK. */
+      if (i2c_capture_ring.capturing) {
+        i2c_capture_ring_push(new_sda ? I2C_SNIFFER_RECORD_DATA_NACK
+                                      : I2C_SNIFFER_RECORD_DATA_ACK,
+                              i2c_capture_ring.data_value, TMR1);
+      }
+      i2c_capture_ring.data_bits = 0;
+    }
+  } else if (i2c_capture_ring.old_scl && new_scl) {
+    /* Data transition while SCL is high. */
+    if (i2c_capture_ring.old_sda && !new_sda) {
+      i2c_capture_ring.collect_data = true;
+      i2c_capture_ring.data_bits = 0;
+      if (i2c_capture_ring.filtering) {
+        /* Hold the start back until the address is known. */
+        i2c_capture_ring.start_tick = TMR1;
+        i2c_capture_ring.awaiting_address = true;
+        i2c_capture_ring.capturing = false;
+      } else {
+        i2c_capture_ring_push(I2C_SNIFFER_RECORD_START, 0x00, TMR1);
+      }
+    } else if (!i2c_capture_ring.old_sda && new_sda) {
+      i2c_capture_ring.collect_data = false;
+      i2c_capture_ring.data_bits = 0;
+      i2c_capture_ring.awaiting_address = false;
+      if (i2c_capture_ring.capturing &&
+          (i2c_capture_ring.statistics == NULL)) {
+        i2c_capture_ring_push(I2C_SNIFFER_RECORD_STOP, 0x00, TMR1);
+      }
+      i2c_capture_ring.capturing = !i2c_capture_ring.filtering;
+    }
+  }
+
+  i2c_capture_ring.old_sda = new_sda;
+  i2c_capture_ring.old_scl = new_scl;
+}
+
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER */
+
+#ifdef BP_I2C_ENABLE_SLAVE_EMULATION
+
+void i2c_slave_emulation(void) {
+  uint16_t offset;
+  uint16_t head;
+  uint16_t length;
+  uint8_t address;
+
+  address = user_serial_read_byte();
+  i2c_slave.size = user_serial_read_byte() << 8;
+  i2c_slave.size |= user_serial_read_byte();
+
+  if ((address > 0x7F) || (i2c_slave.size == 0) ||
+      (i2c_slave.size > I2C_SLAVE_MAXIMUM_MAP_SIZE)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  i2c_slave.map = bp_buffer_arena_reserve(I2C_SLAVE_MAXIMUM_MAP_SIZE);
+  i2c_slave.events = bp_buffer_arena_reserve(I2C_SLAVE_EVENT_RING_SIZE);
+  if ((i2c_slave.map == NULL) || (i2c_slave.events == NULL)) {
+    bp_buffer_arena_release(i2c_slave.events);
+    bp_buffer_arena_release(i2c_slave.map);
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  for (offset = 0; offset < i2c_slave.size; offset++) {
+    i2c_slave.map[offset] = user_serial_read_byte();
+  }
+
+  i2c_slave.head = 0;
+  i2c_slave.tail = 0;
+  i2c_slave.overflow = false;
+  i2c_slave.pointer = 0;
+  i2c_slave.pointer_pending = false;
+  i2c_slave.transaction = 0;
+
+  i2c_cleanup();
+
+  /* 7-bits slave address, no address bits masked. */
+  I2C_SLAVE_ADD = address;
+  I2C_SLAVE_MSK = 0;
+  I2C_SLAVE_CON.A10M = OFF;
+  I2C_SLAVE_CON.SMEN = OFF;
+  I2C_SLAVE_CON.GCEN = OFF;
+
+  /* Hold SCL after received bytes too, until they are taken. */
+  I2C_SLAVE_CON.STREN = ON;
+  I2C_SLAVE_CON.SCLREL = ON;
+
+  /* Answer at bus speed, ahead of the USB interrupt. */
+  I2C_SLAVE_INTERRUPT_PRIORITY = 5;
+  I2C_SLAVE_INTERRUPT_FLAG = OFF;
+  I2C_SLAVE_INTERRUPT_ENABLE = ON;
+  I2C_SLAVE_CON.I2CEN = ON;
+
+  REPORT_IO_SUCCESS();
+
+  for (;;) {
+    switch (user_serial_read_byte()) {
+    case I2C_SLAVE_COMMAND_STOP:
+      break;
+
+    case I2C_SLAVE_COMMAND_DRAIN_EVENTS:
+      /* Tell the host events were lost, if any. */
+      if (i2c_slave.overflow) {
+        I2C_SLAVE_INTERRUPT_ENABLE = OFF;
+        if (((i2c_slave.tail - i2c_slave.head - 1) &
+             I2C_SLAVE_EVENT_RING_MASK) >= I2C_SLAVE_EVENT_SIZE) {
+          i2c_slave_event_push(I2C_SLAVE_EVENT_OVERFLOW, 0x00, 0x00);
+          i2c_slave.overflow = false;
+        }
+        I2C_SLAVE_INTERRUPT_ENABLE = ON;
+      }
+
+      /* Only what is there now, events logged meanwhile wait. */
+      head = i2c_slave.head;
+      length = (head - i2c_slave.tail) & I2C_SLAVE_EVENT_RING_MASK;
+      REPORT_IO_SUCCESS();
+      user_serial_transmit_character(HI8(length));
+      user_serial_transmit_character(LO8(length));
+      for (offset = i2c_slave.tail; offset != head;
+           offset = (offset + 1) & I2C_SLAVE_EVENT_RING_MASK) {
+        user_serial_transmit_character(i2c_slave.events[offset]);
+      }
+      i2c_slave.tail = head;
+      continue;
+
+    case I2C_SLAVE_COMMAND_READ_MAP:
+      REPORT_IO_SUCCESS();
+      bp_write_buffer(i2c_slave.map, i2c_slave.size);
+      continue;
+
+    default:
+      REPORT_IO_FAILURE();
+      continue;
+    }
+
+    break;
+  }
+
+  I2C_SLAVE_INTERRUPT_ENABLE = OFF;
+  I2C_SLAVE_INTERRUPT_FLAG = OFF;
+  I2C_SLAVE_INTERRUPT_PRIORITY = 0;
+  I2C_SLAVE_CON.I2CEN = OFF;
+  I2C_SLAVE_CON.STREN = OFF;
+  I2C_SLAVE_ADD = 0;
+
+  bp_buffer_arena_release(i2c_slave.events);
+  bp_buffer_arena_release(i2c_slave.map);
+  i2c_slave.events = NULL;
+  i2c_slave.map = NULL;
+
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    hardware_i2c_setup();
+  }
+
+  REPORT_IO_SUCCESS();
+}
+
+void i2c_slave_event_push(const i2c_slave_event_type_t type,
+                          const uint8_t reg, const uint8_t value) {
+  uint16_t head;
+
+  if (((i2c_slave.tail - i2c_slave.head - 1) & I2C_SLAVE_EVENT_RING_MASK) <
+      I2C_SLAVE_EVENT_SIZE) {
+    i2c_slave.overflow = true;
+    return;
+  }
+
+  /* Records never straddle the end of the ring, as its size is a multiple. */
+  head = i2c_slave.head;
+  i2c_slave.events[head] = type;
+  i2c_slave.events[head + 1] = reg;
+  i2c_slave.events[head + 2] = value;
+  i2c_slave.events[head + 3] = i2c_slave.transaction;
+  i2c_slave.head = (head + I2C_SLAVE_EVENT_SIZE) & I2C_SLAVE_EVENT_RING_MASK;
+}
+
+#ifdef BUSPIRATEV4
+void __attribute__((interrupt, no_auto_psv)) _SI2C3Interrupt(void) {
+#else
+void __attribute__((interrupt, no_auto_psv)) _SI2C1Interrupt(void) {
+#endif /* BUSPIRATEV4 */
+  uint8_t value;
+
+  I2C_SLAVE_INTERRUPT_FLAG = OFF;
+
+  if (I2C_SLAVE_STAT.D_A == OFF) {
+    /* Our address matched, the byte itself is of no use. */
+    (void)I2C_SLAVE_RCV;
+    i2c_slave.transaction++;
+
+    if (I2C_SLAVE_STAT.R_W == ON) {
+      value = i2c_slave.map[i2c_slave.pointer];
+      I2C_SLAVE_TRN = value;
+      I2C_SLAVE_CON.SCLREL = ON;
+      i2c_slave_event_push(I2C_SLAVE_EVENT_READ_SELECTED, i2c_slave.pointer,
+                           0x00);
+      i2c_slave_event_push(I2C_SLAVE_EVENT_READ, i2c_slave.pointer, value);
+      i2c_slave.pointer = (i2c_slave.pointer + 1) % i2c_slave.size;
+    } else {
+      I2C_SLAVE_CON.SCLREL = ON;
+      i2c_slave.pointer_pending = true;
+      i2c_slave_event_push(I2C_SLAVE_EVENT_WRITE_SELECTED, i2c_slave.pointer,
+                           0x00);
+    }
+    return;
+  }
+
+  if (I2C_SLAVE_STAT.R_W == ON) {
+    /* A NACK from the master ends the read, nothing else goes out. */
+    if (I2C_SLAVE_STAT.ACKSTAT == ON) {
+      return;
+    }
+    value = i2c_slave.map[i2c_slave.pointer];
+    I2C_SLAVE_TRN = value;
+    I2C_SLAVE_CON.SCLREL = ON;
+    i2c_slave_event_push(I2C_SLAVE_EVENT_READ, i2c_slave.pointer, value);
+    i2c_slave.pointer = (i2c_slave.pointer + 1) % i2c_slave.size;
+    return;
+  }
+
+  value = I2C_SLAVE_RCV;
+  I2C_SLAVE_CON.SCLREL = ON;
+  if (I2C_SLAVE_STAT.I2COV == ON) {
+    I2C_SLAVE_STAT.I2COV = OFF;
+  }
+
+  if (i2c_slave.pointer_pending) {
+    i2c_slave.pointer = value % i2c_slave.size;
+    i2c_slave.pointer_pending = false;
+    i2c_slave_event_push(I2C_SLAVE_EVENT_POINTER, i2c_slave.pointer, value);
+  } else {
+    i2c_slave.map[i2c_slave.pointer] = value;
+    i2c_slave_event_push(I2C_SLAVE_EVENT_WRITE, i2c_slave.pointer, value);
+    i2c_slave.pointer = (i2c_slave.pointer + 1) % i2c_slave.size;
+  }
 }
 
+#endif /* BP_I2C_ENABLE_SLAVE_EMULATION */
+
 void handle_pending_ack(const bool bus_bit) {
   if (i2c_state.mode == I2C_TYPE_SOFTWARE) {
     bitbang_write_bit(bus_bit);
@@ -927,16 +2264,28 @@ rawI2C mode:
 # 00000010 � I2C start bit
 # 00000011 � I2C stop bit
 # 00000100 - I2C read byte
+# 00000101 xxxxxxxx xxxxxxxx - Software backend clock stretch timeout, in us
 # 00000110 - ACK bit
 # 00000111 - NACK bit
 # 0001xxxx � Bulk transfer, send 1-16 bytes (0=1byte!)
+# 00100000 - Batch register read, chained with repeated starts
+# 00100001 - Slave emulation from a register map, with an event log
+# 00100010 xxxxxxxx xxxxxxxx - Timestamped sniffer, address and mask filter
+# 00100011 - Traffic statistics, per address transaction/byte/NACK counters
+# 00100100 - Telemetry counters, 1 byte flags
+# 00001010 xxxxxxxx - Select backend, 0 = software, 1 = hardware
+# 00001011 - Streamed write-then-read, 32 bits lengths
+# 00001100 - EEPROM page programming with ACK polling
+# 00001101 - Bus scan, returning a bitmap of acknowledging addresses
+# 00001110 - Timestamped binary sniffer
 # (0110)000x - Set I2C speed, 3 = 400khz 2=100khz 1=50khz 0=5khz
+#              (hardware backend: 2 = 1mhz 1 = 400khz 0 = 100khz)
 # (0111)000x - Read speed, (planned)
 # (0100)wxyz � Configure peripherals w=power, x=pullups, y=AUX, z=CS (was 0110)
 # (0101)wxyz � read peripherals (planned, not implemented)
  */
 
-void binary_io_enter_i2c_mode(void) {
+void binary_io_enter_i2c_mode(const bool restore_settings) {
   static unsigned char inByte, rawCommand, i;
   unsigned int fw, fr;
 
@@ -950,11 +2299,30 @@ void binary_io_enter_i2c_mode(void) {
 
   mode_configuration.high_impedance = ON;
   mode_configuration.little_endian = NO;
+  i2c_state.mode = I2C_TYPE_SOFTWARE;
+#ifdef BUSPIRATEV4
+  i2c_state.to_eeprom = false;
+#endif /* BUSPIRATEV4 */
   bitbang_setup(2, BITBANG_SPEED_MAXIMUM);
+  bitbang_set_clock_stretch_timeout(0);
+
+  if (restore_settings && i2c_binary_io_settings.saved) {
+    mode_configuration.speed = i2c_binary_io_settings.speed;
+    i2c_binary_io_select_backend(i2c_binary_io_settings.mode);
+    i2c_binary_io_set_speed(i2c_binary_io_settings.speed);
+    bitbang_set_clock_stretch_timeout(
+        i2c_binary_io_settings.clock_stretch_timeout);
+  } else {
+    i2c_binary_io_settings.mode = I2C_TYPE_SOFTWARE;
+    i2c_binary_io_settings.speed = BITBANG_SPEED_MAXIMUM;
+    i2c_binary_io_settings.clock_stretch_timeout = 0;
+  }
   MSG_I2C_MODE_IDENTIFIER;
 
   for (;;) {
     inByte = user_serial_read_byte();
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_I2C, inByte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
     // get command bits in a separate variable
     rawCommand = (inByte >> 4);
 
@@ -963,6 +2331,9 @@ void binary_io_enter_i2c_mode(void) {
       switch (inByte) {
 
       case 0:
+        i2c_binary_io_settings.saved = ON;
+        i2c_binary_io_select_backend(I2C_TYPE_SOFTWARE);
+        bitbang_set_clock_stretch_timeout(0);
         return;
 
       case 1: // 1 - id reply string
@@ -970,26 +2341,34 @@ void binary_io_enter_i2c_mode(void) {
         break;
 
       case 2: // I2C start bit
-        bitbang_i2c_start(BITBANG_I2C_START_ONE_SHOT);
+        i2c_binary_io_start(false);
         REPORT_IO_SUCCESS();
         break;
 
       case 3: // I2C stop bit
-        bitbang_i2c_stop();
+        i2c_binary_io_stop();
         REPORT_IO_SUCCESS();
         break;
 
       case 4: // I2C read byte
-        user_serial_transmit_character(bitbang_read_value());
+        user_serial_transmit_character(i2c_binary_io_read());
+        break;
+
+      case I2C_BINARY_IO_COMMAND_SET_CLOCK_STRETCH_TIMEOUT:
+        fw = user_serial_read_byte() << 8;
+        fw |= user_serial_read_byte();
+        bitbang_set_clock_stretch_timeout(fw);
+        i2c_binary_io_settings.clock_stretch_timeout = fw;
+        REPORT_IO_SUCCESS();
         break;
 
       case 6: // I2C send ACK
-        bitbang_write_bit(LOW);
+        i2c_binary_io_send_ack(I2C_ACK_BIT);
         REPORT_IO_SUCCESS();
         break;
 
       case 7: // I2C send NACK
-        bitbang_write_bit(HIGH);
+        i2c_binary_io_send_ack(I2C_NACK_BIT);
         REPORT_IO_SUCCESS();
         break;
 
@@ -1005,10 +2384,7 @@ void binary_io_enter_i2c_mode(void) {
         // inByte - used as extended commmand
         // fr - used as result
         // wait for subcommand byte
-        while (U1STAbits.URXDA == OFF) {
-        }
-
-        inByte = U1RXREG; // get byte
+        inByte = user_serial_read_byte(); // get byte
         // 0x00 - AUX/CS low
         // 0x01 - AUX/CS high
         // 0x02 - AUX/CS HiZ
@@ -1042,18 +2418,73 @@ void binary_io_enter_i2c_mode(void) {
           mode_configuration.alternate_aux = 1;
           break;
 
-        default:
-          fw = 0;
-          break;
-        }
+        default:
+          fw = 0;
+          break;
+        }
+
+        user_serial_transmit_character(fr); // result
+        break;
+
+      case I2C_BINARY_IO_COMMAND_SELECT_BACKEND:
+        if (i2c_binary_io_select_backend(user_serial_read_byte())) {
+          /* The software backend always starts at full speed. */
+          i2c_binary_io_settings.mode = i2c_state.mode;
+          i2c_binary_io_settings.speed = (i2c_state.mode == I2C_TYPE_SOFTWARE)
+                                             ? BITBANG_SPEED_MAXIMUM
+                                             : mode_configuration.speed;
+          REPORT_IO_SUCCESS();
+        } else {
+          REPORT_IO_FAILURE();
+        }
+        break;
+
+      case I2C_BINARY_IO_COMMAND_STREAMING_WRITE_THEN_READ:
+        i2c_streaming_write_then_read(false);
+        break;
+
+      case I2C_BINARY_IO_COMMAND_EEPROM_PROGRAM:
+        i2c_eeprom_program();
+        break;
+
+      case I2C_BINARY_IO_COMMAND_SCAN:
+        i2c_scan();
+        break;
+
+#ifdef BP_I2C_ENABLE_INTERRUPT_SNIFFER
+      case I2C_BINARY_IO_COMMAND_TIMESTAMPED_SNIFFER: {
+        bool sniffed;
 
-        user_serial_transmit_character(fr); // result
+        i2c_cleanup();
+        sniffed = i2c_timestamped_sniffer(0x00, 0x00);
+#ifdef BP_I2C_USE_HW_BUS
+        if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+          hardware_i2c_setup();
+        }
+#endif /* BP_I2C_USE_HW_BUS */
+        if (sniffed) {
+          REPORT_IO_SUCCESS();
+        }
         break;
+      }
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER */
 
-      case 0b1111:
-        i2c_sniffer(false);
-        REPORT_IO_SUCCESS();
+      case 0b1111: {
+        bool sniffed;
+
+        /* The sniffer needs the pins to be released by the I2C module. */
+        i2c_cleanup();
+        sniffed = i2c_sniffer(false);
+#ifdef BP_I2C_USE_HW_BUS
+        if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+          hardware_i2c_setup();
+        }
+#endif /* BP_I2C_USE_HW_BUS */
+        if (sniffed) {
+          REPORT_IO_SUCCESS();
+        }
         break;
+      }
 
       default:
         REPORT_IO_FAILURE();
@@ -1067,18 +2498,76 @@ void binary_io_enter_i2c_mode(void) {
       REPORT_IO_SUCCESS();
 
       for (i = 0; i < inByte; i++) {
-        bitbang_write_value(
-            user_serial_read_byte()); // JTR usb port //send byte
+        // send byte, then return ACK0 or NACK1
         user_serial_transmit_character(
-            bitbang_read_bit()); // return ACK0 or NACK1
+            i2c_binary_io_write(user_serial_read_byte()));
       }
 
       break;
 
-    case 0b0110:                // set speed
-      inByte &= 0b00000011;     // clear command portion
-      bitbang_setup(2, inByte); // set I2C speed
-      REPORT_IO_SUCCESS();
+    case 0b0010:
+      if (inByte == I2C_BINARY_IO_COMMAND_BATCH_REGISTER_READ) {
+        i2c_batch_register_read();
+      } else if ((inByte == I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_WRITE) ||
+                 (inByte == I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_READ) ||
+                 (inByte == I2C_BINARY_IO_COMMAND_SMBUS_PROCESS_CALL)) {
+        i2c_smbus_transaction(inByte);
+#ifdef BP_ENABLE_COMPRESSED_READS
+      } else if (inByte ==
+                 I2C_BINARY_IO_COMMAND_COMPRESSED_STREAMING_WRITE_THEN_READ) {
+        i2c_streaming_write_then_read(true);
+#endif /* BP_ENABLE_COMPRESSED_READS */
+#ifdef BP_I2C_ENABLE_SLAVE_EMULATION
+      } else if (inByte == I2C_BINARY_IO_COMMAND_SLAVE_EMULATION) {
+        i2c_slave_emulation();
+#endif /* BP_I2C_ENABLE_SLAVE_EMULATION */
+      } else if (inByte == I2C_BINARY_IO_COMMAND_TELEMETRY) {
+        bp_binary_io_send_telemetry();
+#ifdef BP_I2C_ENABLE_INTERRUPT_SNIFFER
+      } else if (inByte == I2C_BINARY_IO_COMMAND_FILTERED_SNIFFER) {
+        uint8_t filter_address;
+        uint8_t filter_mask;
+        bool sniffed;
+
+        filter_address = user_serial_read_byte();
+        filter_mask = user_serial_read_byte();
+        i2c_cleanup();
+        sniffed = i2c_timestamped_sniffer(filter_address, filter_mask);
+#ifdef BP_I2C_USE_HW_BUS
+        if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+          hardware_i2c_setup();
+        }
+#endif /* BP_I2C_USE_HW_BUS */
+        if (sniffed) {
+          REPORT_IO_SUCCESS();
+        }
+      } else if (inByte == I2C_BINARY_IO_COMMAND_TRAFFIC_STATISTICS) {
+        bool counted;
+
+        i2c_cleanup();
+        counted = i2c_traffic_statistics();
+#ifdef BP_I2C_USE_HW_BUS
+        if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+          hardware_i2c_setup();
+        }
+#endif /* BP_I2C_USE_HW_BUS */
+        if (counted) {
+          REPORT_IO_SUCCESS();
+        }
+#endif /* BP_I2C_ENABLE_INTERRUPT_SNIFFER */
+      } else {
+        REPORT_IO_FAILURE();
+      }
+      break;
+
+    case 0b0110:            // set speed
+      inByte &= 0b00000011; // clear command portion
+      if (i2c_binary_io_set_speed(inByte)) {
+        i2c_binary_io_settings.speed = inByte;
+        REPORT_IO_SUCCESS();
+      } else {
+        REPORT_IO_FAILURE();
+      }
       break;
 
     case 0b0100: // configure peripherals w=power, x=pullups, y=AUX, z=CS
@@ -1135,14 +2624,13 @@ bool i2c_write_then_read(void) {
 
   /* Signal write start. */
 
-  bitbang_i2c_start(BITBANG_I2C_START_ONE_SHOT);
+  i2c_binary_io_start(false);
 
   /* Write the payload to the I2C bus. */
 
   for (index = 0; index < bytes_to_write; index++) {
-    bitbang_write_value(bus_pirate_configuration.terminal_input[index]);
-
-    if (bitbang_read_bit() == HIGH) {
+    if (i2c_binary_io_write(bus_pirate_configuration.terminal_input[index]) ==
+        I2C_NACK_BIT) {
       /* No ACK read on the bus, bailing out. */
       return false;
     }
@@ -1152,13 +2640,11 @@ bool i2c_write_then_read(void) {
 
     /* Send a restart signal on the I2C bus. */
 
-    bitbang_i2c_start(BITBANG_I2C_RESTART);
+    i2c_binary_io_start(true);
 
     /* Send the I2C address. */
 
-    bitbang_write_value(i2c_address | 0x01);
-
-    if (bitbang_read_bit() == HIGH) {
+    if (i2c_binary_io_write(i2c_address | 0x01) == I2C_NACK_BIT) {
       /* No ACK read on the bus, bailing out. */
       return false;
     }
@@ -1171,16 +2657,17 @@ bool i2c_write_then_read(void) {
   for (index = 0; index < bytes_to_read; index++) {
     /* Read the byte from the I2C bus. */
 
-    bus_pirate_configuration.terminal_input[index] = bitbang_read_value();
+    bus_pirate_configuration.terminal_input[index] = i2c_binary_io_read();
 
     /* Report ACK or NACK depending on the length. */
 
-    bitbang_write_bit(index >= bytes_to_write ? HIGH : LOW);
+    i2c_binary_io_send_ack(index >= bytes_to_write ? I2C_NACK_BIT
+                                                   : I2C_ACK_BIT);
   }
 
   /* Stop the I2C bus operations. */
 
-  bitbang_i2c_stop();
+  i2c_binary_io_stop();
 
   /* Report operation status. */
 
@@ -1188,12 +2675,551 @@ bool i2c_write_then_read(void) {
 
   /* And send the I2C data over to the UART. */
 
-  for (index = 0; index < bytes_to_read; index++) {
-    user_serial_transmit_character(
-        bus_pirate_configuration.terminal_input[index]);
+  bp_write_buffer(bus_pirate_configuration.terminal_input, bytes_to_read);
+
+  return true;
+}
+
+void i2c_streaming_write_then_read(const bool compressed) {
+  uint32_t bytes_to_write;
+  uint32_t bytes_to_read;
+  uint8_t i2c_address;
+  uint8_t value;
+  uint16_t chunk;
+  bool address_only;
+  bool acknowledged;
+
+  bytes_to_write = bp_binary_io_read_uint32();
+  bytes_to_read = bp_binary_io_read_uint32();
+
+  if (bytes_to_write == 0) {
+    /* Nothing to do, or nowhere to read from. */
+    if (bytes_to_read > 0) {
+      REPORT_IO_FAILURE();
+    } else {
+      REPORT_IO_SUCCESS();
+    }
+    return;
+  }
+
+  address_only = (bytes_to_write == 1);
+
+  i2c_binary_io_start(false);
+  i2c_address = user_serial_read_byte();
+  acknowledged = (i2c_binary_io_write(i2c_address) == I2C_ACK_BIT);
+  bytes_to_write--;
+
+  /* Forward data from the serial port to the I2C bus as it arrives. */
+  while (bytes_to_write > 0) {
+    value = user_serial_read_byte();
+    if (acknowledged) {
+      acknowledged = (i2c_binary_io_write(value) == I2C_ACK_BIT);
+    }
+    bytes_to_write--;
+  }
+
+  if (acknowledged && (bytes_to_read > 0) && !address_only) {
+    /* More than the address was written, switch to reading. */
+    i2c_binary_io_start(true);
+    acknowledged = (i2c_binary_io_write(i2c_address | 0x01) == I2C_ACK_BIT);
+  }
+
+  if (!acknowledged) {
+    i2c_binary_io_stop();
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+  if (compressed) {
+    bp_compressed_read_begin();
+    while (bytes_to_read > 0) {
+      bytes_to_read--;
+      bp_compressed_read_put(i2c_binary_io_read());
+      i2c_binary_io_send_ack((bytes_to_read == 0) ? I2C_NACK_BIT
+                                                   : I2C_ACK_BIT);
+    }
+    bp_compressed_read_end();
+  }
+#else
+  (void)compressed;
+#endif /* BP_ENABLE_COMPRESSED_READS */
+
+  /* Forward data from the I2C bus to the serial port, one chunk at a time. */
+  while (bytes_to_read > 0) {
+    chunk = (bytes_to_read < I2C_STREAMING_READ_CHUNK_SIZE)
+                ? (uint16_t)bytes_to_read
+                : I2C_STREAMING_READ_CHUNK_SIZE;
+    bytes_to_read -= chunk;
+
+    for (value = 0; value < chunk; value++) {
+      bus_pirate_configuration.terminal_input[value] = i2c_binary_io_read();
+      i2c_binary_io_send_ack(((bytes_to_read == 0) && (value == (chunk - 1)))
+                                 ? I2C_NACK_BIT
+                                 : I2C_ACK_BIT);
+    }
+    bp_write_buffer(bus_pirate_configuration.terminal_input, chunk);
+  }
+
+  i2c_binary_io_stop();
+}
+
+void i2c_eeprom_program(void) {
+  uint8_t device_address;
+  uint8_t address_width;
+  uint16_t page_size;
+  uint32_t address;
+  uint32_t length;
+  uint32_t address_limit;
+  uint16_t chunk;
+  uint16_t offset;
+  uint8_t chip_address;
+  bool acknowledged;
+
+  device_address = user_serial_read_byte() & 0xFE;
+  address_width = user_serial_read_byte();
+  page_size = user_serial_read_byte() << 8;
+  page_size |= user_serial_read_byte();
+  address = bp_binary_io_read_uint32();
+  length = bp_binary_io_read_uint32();
+
+  /* Three more bits can be carried by the device address. */
+  address_limit = (address_width == 1) ? 0x00000800 : 0x00080000;
+
+  if (((address_width != 1) && (address_width != 2)) || (page_size == 0) ||
+      (address >= address_limit) || (length > (address_limit - address))) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  while (length > 0) {
+    chunk = page_size - (address % page_size);
+    if (length < chunk) {
+      chunk = length;
+    }
+
+    chip_address =
+        device_address | ((address >> ((address_width * 8) - 1)) & 0x0E);
+
+    i2c_binary_io_start(false);
+    acknowledged = (i2c_binary_io_write(chip_address) == I2C_ACK_BIT);
+    if (acknowledged && (address_width == 2)) {
+      acknowledged = (i2c_binary_io_write(address >> 8) == I2C_ACK_BIT);
+    }
+    if (acknowledged) {
+      acknowledged = (i2c_binary_io_write(address) == I2C_ACK_BIT);
+    }
+
+    /* Put the page data on the bus as it arrives. */
+    for (offset = 0; offset < chunk; offset++) {
+      uint8_t value;
+
+      value = user_serial_read_byte();
+      if (acknowledged) {
+        acknowledged = (i2c_binary_io_write(value) == I2C_ACK_BIT);
+      }
+    }
+
+    /* The write cycle starts with the stop condition. */
+    i2c_binary_io_stop();
+
+    if (!acknowledged || !i2c_eeprom_wait_until_ready(chip_address)) {
+      REPORT_IO_FAILURE();
+      return;
+    }
+
+    REPORT_IO_SUCCESS();
+    address += chunk;
+    length -= chunk;
+  }
+}
+
+bool i2c_eeprom_wait_until_ready(const uint8_t device_address) {
+  uint16_t attempts;
+  bool acknowledged;
+
+  for (attempts = 0; attempts < I2C_EEPROM_ACK_POLL_ATTEMPTS; attempts++) {
+    i2c_binary_io_start(false);
+    acknowledged = (i2c_binary_io_write(device_address) == I2C_ACK_BIT);
+    i2c_binary_io_stop();
+
+    if (acknowledged) {
+      return true;
+    }
+
+    bp_delay_us(10);
+  }
+
+  return false;
+}
+
+void i2c_scan(void) {
+  uint8_t bitmap[16];
+  uint8_t first;
+  uint8_t last;
+  uint8_t address;
+  bool acknowledged;
+
+  first = user_serial_read_byte();
+  last = user_serial_read_byte();
+
+  if ((first > last) || (last > 0x7F)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  memset(bitmap, 0, sizeof(bitmap));
+
+  address = first;
+  for (;;) {
+    i2c_binary_io_start(false);
+    acknowledged = (i2c_binary_io_write(address << 1) == I2C_ACK_BIT);
+    i2c_binary_io_stop();
+
+    if (acknowledged) {
+      bitmap[address >> 3] |= 1 << (address & 0x07);
+    }
+
+    if (address == last) {
+      break;
+    }
+    address++;
+  }
+
+  REPORT_IO_SUCCESS();
+  bp_write_buffer(bitmap, sizeof(bitmap));
+}
+
+void i2c_batch_register_read(void) {
+  uint8_t entries;
+  uint8_t entry;
+  uint8_t *descriptor;
+  uint8_t *results;
+  uint8_t *status;
+  uint8_t offset;
+  uint8_t length;
+  size_t results_size;
+  bool acknowledged;
+
+  entries = user_serial_read_byte();
+
+  /* The entries are kept at the start of the buffer, results follow them. */
+  results_size = 0;
+  descriptor = bus_pirate_configuration.terminal_input;
+  for (entry = 0; entry < entries; entry++) {
+    descriptor[0] = user_serial_read_byte() << 1;
+    descriptor[1] = user_serial_read_byte();
+    descriptor[2] = user_serial_read_byte();
+    results_size += 1 + descriptor[2];
+    descriptor += I2C_BATCH_ENTRY_SIZE;
+  }
+
+  results = descriptor;
+  if ((entries == 0) ||
+      (results_size > (BP_TERMINAL_BUFFER_SIZE -
+                       (entries * I2C_BATCH_ENTRY_SIZE)))) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  descriptor = bus_pirate_configuration.terminal_input;
+  for (entry = 0; entry < entries; entry++) {
+    length = descriptor[2];
+    status = results++;
+
+    i2c_binary_io_start(entry > 0);
+    acknowledged = (i2c_binary_io_write(descriptor[0]) == I2C_ACK_BIT);
+    if (acknowledged) {
+      acknowledged = (i2c_binary_io_write(descriptor[1]) == I2C_ACK_BIT);
+    }
+    if (acknowledged && (length > 0)) {
+      i2c_binary_io_start(true);
+      acknowledged =
+          (i2c_binary_io_write(descriptor[0] | 0x01) == I2C_ACK_BIT);
+    }
+
+    if (acknowledged) {
+      for (offset = 0; offset < length; offset++) {
+        results[offset] = i2c_binary_io_read();
+        i2c_binary_io_send_ack((offset == (length - 1)) ? I2C_NACK_BIT
+                                                        : I2C_ACK_BIT);
+      }
+    } else {
+      memset(results, 0xFF, length);
+    }
+
+    *status = acknowledged ? 0x01 : 0x00;
+    results += length;
+    descriptor += I2C_BATCH_ENTRY_SIZE;
+  }
+
+  i2c_binary_io_stop();
+
+  REPORT_IO_SUCCESS();
+  bp_write_buffer(bus_pirate_configuration.terminal_input +
+                      (entries * I2C_BATCH_ENTRY_SIZE),
+                  results_size);
+}
+
+/**
+ * SMBus PEC precalculated CRC-8 table, polynomial x^8 + x^2 + x + 1.
+ */
+static const uint8_t SMBUS_PEC_TABLE[] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31,
+    0x24, 0x23, 0x2A, 0x2D, 0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
+    0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D, 0xE0, 0xE7, 0xEE, 0xE9,
+    0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1,
+    0xB4, 0xB3, 0xBA, 0xBD, 0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
+    0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA, 0xB7, 0xB0, 0xB9, 0xBE,
+    0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16,
+    0x03, 0x04, 0x0D, 0x0A, 0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
+    0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A, 0x89, 0x8E, 0x87, 0x80,
+    0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8,
+    0xDD, 0xDA, 0xD3, 0xD4, 0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
+    0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44, 0x19, 0x1E, 0x17, 0x10,
+    0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F,
+    0x6A, 0x6D, 0x64, 0x63, 0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
+    0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13, 0xAE, 0xA9, 0xA0, 0xA7,
+    0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF,
+    0xFA, 0xFD, 0xF4, 0xF3};
+
+bool i2c_smbus_write(const uint8_t value, uint8_t *pec) {
+  *pec = SMBUS_PEC_TABLE[*pec ^ value];
+  return i2c_binary_io_write(value) == I2C_ACK_BIT;
+}
+
+uint8_t i2c_smbus_read(const bool last, uint8_t *pec) {
+  uint8_t value;
+
+  value = i2c_binary_io_read();
+  i2c_binary_io_send_ack(last ? I2C_NACK_BIT : I2C_ACK_BIT);
+  *pec = SMBUS_PEC_TABLE[*pec ^ value];
+  return value;
+}
+
+void i2c_smbus_transaction(const uint8_t command) {
+  uint8_t *written;
+  uint8_t *read;
+  uint8_t address;
+  uint8_t code;
+  uint8_t flags;
+  uint8_t write_count;
+  uint8_t read_count;
+  uint8_t index;
+  uint8_t pec;
+  uint8_t status;
+
+  address = user_serial_read_byte() << 1;
+  code = user_serial_read_byte();
+  flags = user_serial_read_byte();
+
+  written = bus_pirate_configuration.terminal_input;
+  read = bus_pirate_configuration.terminal_input + I2C_SMBUS_READ_BLOCK_OFFSET;
+  write_count = 0;
+  if (command != I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_READ) {
+    write_count = user_serial_read_byte();
+    if (write_count == 0) {
+      REPORT_IO_FAILURE();
+      return;
+    }
+    for (index = 0; index < write_count; index++) {
+      written[index] = user_serial_read_byte();
+    }
+  }
+
+  pec = 0x00;
+  read_count = 0;
+  status = I2C_SMBUS_STATUS_NACK;
+  i2c_binary_io_start(false);
+  if (!i2c_smbus_write(address, &pec) || !i2c_smbus_write(code, &pec)) {
+    goto stop;
+  }
+
+  if (write_count > 0) {
+    if (!i2c_smbus_write(write_count, &pec)) {
+      goto stop;
+    }
+    for (index = 0; index < write_count; index++) {
+      if (!i2c_smbus_write(written[index], &pec)) {
+        goto stop;
+      }
+    }
+  }
+
+  if (command == I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_WRITE) {
+    if ((flags & I2C_SMBUS_FLAG_PEC) && !i2c_smbus_write(pec, &pec)) {
+      goto stop;
+    }
+    status = I2C_SMBUS_STATUS_SUCCESS;
+    goto stop;
+  }
+
+  i2c_binary_io_start(true);
+  if (!i2c_smbus_write(address | 0x01, &pec)) {
+    goto stop;
+  }
+
+  /* The last byte on the bus, be it data or PEC, is not acknowledged. */
+  read_count = i2c_binary_io_read();
+  pec = SMBUS_PEC_TABLE[pec ^ read_count];
+  i2c_binary_io_send_ack(((read_count == 0) && !(flags & I2C_SMBUS_FLAG_PEC))
+                             ? I2C_NACK_BIT
+                             : I2C_ACK_BIT);
+  for (index = 0; index < read_count; index++) {
+    read[index] = i2c_smbus_read(
+        (index == (read_count - 1)) && !(flags & I2C_SMBUS_FLAG_PEC), &pec);
+  }
+  status = I2C_SMBUS_STATUS_SUCCESS;
+  if ((flags & I2C_SMBUS_FLAG_PEC) && (i2c_smbus_read(true, &pec) != 0x00)) {
+    /* Running the PEC byte itself through the CRC gives zero if it matches. */
+    status = I2C_SMBUS_STATUS_PEC_MISMATCH;
+  }
+
+stop:
+  i2c_binary_io_stop();
+
+  user_serial_transmit_character(status);
+  if (command != I2C_BINARY_IO_COMMAND_SMBUS_BLOCK_WRITE) {
+    user_serial_transmit_character(read_count);
+    bp_write_buffer(read, read_count);
+  }
+}
+
+bool i2c_binary_io_select_backend(const uint8_t mode) {
+  switch (mode) {
+  case I2C_TYPE_SOFTWARE:
+#ifdef BP_I2C_USE_HW_BUS
+    if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+      i2c_cleanup();
+    }
+#endif /* BP_I2C_USE_HW_BUS */
+    i2c_state.mode = I2C_TYPE_SOFTWARE;
+    SDA_TRIS = INPUT;
+    SCL_TRIS = INPUT;
+    SCL = LOW;
+    SDA = LOW;
+    bitbang_setup(2, BITBANG_SPEED_MAXIMUM);
+    return true;
+
+#ifdef BP_I2C_USE_HW_BUS
+  case I2C_TYPE_HARDWARE:
+    i2c_state.mode = I2C_TYPE_HARDWARE;
+    if (mode_configuration.speed >= sizeof(HARDWARE_I2C_BRG_SPEEDS)) {
+      mode_configuration.speed = 1;
+    }
+    hardware_i2c_setup();
+    return true;
+#endif /* BP_I2C_USE_HW_BUS */
+
+  default:
+    return false;
+  }
+}
+
+bool i2c_binary_io_set_speed(const uint8_t speed) {
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    if (speed >= sizeof(HARDWARE_I2C_BRG_SPEEDS)) {
+      return false;
+    }
+
+    /* The baud rate generator can only be changed while disabled. */
+    i2c_cleanup();
+    mode_configuration.speed = speed;
+    hardware_i2c_setup();
+    return true;
   }
+#endif /* BP_I2C_USE_HW_BUS */
 
+  mode_configuration.speed = speed;
+  bitbang_setup(2, speed);
   return true;
 }
 
+void i2c_binary_io_start(const bool restart) {
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    if (restart) {
+      hardware_i2c_restart();
+    } else {
+      hardware_i2c_start();
+    }
+    return;
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  bitbang_i2c_start(restart ? BITBANG_I2C_RESTART : BITBANG_I2C_START_ONE_SHOT);
+}
+
+void i2c_binary_io_stop(void) {
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    hardware_i2c_stop();
+    return;
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  bitbang_i2c_stop();
+}
+
+bool i2c_binary_io_write(const uint8_t value) {
+  bool nack;
+
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    hardware_i2c_write(value);
+    nack = hardware_i2c_get_ack();
+  } else {
+#endif /* BP_I2C_USE_HW_BUS */
+
+    bitbang_clock_stretch_timed_out();
+    bitbang_write_value(value);
+
+    /* A device stuck stretching the clock cannot have acknowledged anything. */
+    nack = bitbang_read_bit() || bitbang_clock_stretch_timed_out();
+
+#ifdef BP_I2C_USE_HW_BUS
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  if (nack) {
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_I2C_NACKS);
+    BP_FLIGHT_RECORDER_LOG(
+        BP_FLIGHT_RECORDER_MODE_I2C | BP_FLIGHT_RECORDER_BUS_EVENT,
+        BP_FLIGHT_RECORDER_EVENT_I2C_NACK, value, I2C_NACK_BIT);
+  }
+
+  return nack;
+}
+
+uint8_t i2c_binary_io_read(void) {
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    return hardware_i2c_read();
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  return bitbang_read_value();
+}
+
+void i2c_binary_io_send_ack(const bool bus_bit) {
+#ifdef BP_I2C_USE_HW_BUS
+  if (i2c_state.mode == I2C_TYPE_HARDWARE) {
+    hardware_i2c_send_ack(bus_bit);
+    return;
+  }
+#endif /* BP_I2C_USE_HW_BUS */
+
+  bitbang_write_bit(bus_bit);
+}
+
 #endif /* BP_ENABLE_I2C_SUPPORT */
@@ -22,6 +22,8 @@
 
 #ifdef BP_ENABLE_I2C_SUPPORT
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -51,11 +53,34 @@ void i2c_pins_state(void);
 
 uint16_t i2c_read(void);
 uint16_t i2c_write(const uint16_t value);
+
+/**
+ * Writes the given bytes as i2c_write would, ACK/NACK messages included.
+ *
+ * @param[in] buffer the bytes to write.
+ * @param[in] length how many bytes to write.
+ */
+void i2c_send_buffer(const uint8_t *buffer, const size_t length);
+
+/**
+ * Reads the given number of bytes as i2c_read would, acknowledging each byte
+ * but the last one, whose acknowledgment is left pending.
+ *
+ * @param[out] buffer where to store the bytes read.
+ * @param[in]  length how many bytes to read.
+ */
+void i2c_read_buffer(uint8_t *buffer, const size_t length);
 void i2c_setup_prepare(void);
 void i2c_setup_execute(void);
 void i2c_macro(const uint16_t macro);
 
-void binary_io_enter_i2c_mode(void);
+/**
+ * Start accepting binary I/O commands for I2C operations.
+ *
+ * @param[in] restore_settings true to start with the backend, speed and clock
+ * stretch timeout the mode had when it was last left, false for the defaults.
+ */
+void binary_io_enter_i2c_mode(const bool restore_settings);
 
 #endif /* BP_ENABLE_I2C_SUPPORT */
 
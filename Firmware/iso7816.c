@@ -0,0 +1,666 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "iso7816.h"
+
+#ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
+
+#include <stdbool.h>
+
+#include "base.h"
+
+/** The card clock runs at FCY / ISO7816_CLOCK_DIVISOR, 4MHz. */
+#define ISO7816_CLOCK_DIVISOR 4
+
+/** Elementary time unit in Timer 3 ticks, Fd = 372 and Dd = 1. */
+#define ISO7816_ETU (372 * ISO7816_CLOCK_DIVISOR)
+
+/** Where a bit is sampled, from the start of its ETU. */
+#define ISO7816_HALF_ETU (ISO7816_ETU / 2)
+
+/** How long RST is held low with the clock running, 800 card clocks. */
+#define ISO7816_RESET_DELAY_US 200
+
+/** TS must start within 40000 clocks from RST going high. */
+#define ISO7816_ATR_START_TIMEOUT_ETU 108
+
+/** Default work waiting time, 960 * WI with WI = 10. */
+#define ISO7816_WORK_WAITING_TIME_ETU 9600
+
+/** Minimum delay between the starts of two characters. */
+#define ISO7816_CHARACTER_GUARD_ETU 12
+
+/** Minimum delay between the starts of characters in opposite directions. */
+#define ISO7816_TURNAROUND_ETU 16
+
+/** How many times a character is repeated after a parity error. */
+#define ISO7816_RETRIES 4
+
+/** TS value with the direct convention, read as is. */
+#define ISO7816_TS_DIRECT 0x3B
+
+/** TS value with the inverse convention, as seen before decoding. */
+#define ISO7816_TS_INVERSE_RAW 0x03
+
+#define ISO7816_NULL_PROCEDURE_BYTE 0x60
+#define ISO7816_SW1_WRONG_LENGTH 0x6C
+#define ISO7816_SW1_MORE_DATA 0x61
+#define ISO7816_GET_RESPONSE_INS 0xC0
+
+#define ISO7816_IO BP_MOSI
+#define ISO7816_IO_TRIS BP_MOSI_DIR
+#define ISO7816_CLK BP_CLK
+#define ISO7816_CLK_TRIS BP_CLK_DIR
+#define ISO7816_CLK_RPOUT BP_CLK_RPOUT
+#define ISO7816_RST BP_CS
+#define ISO7816_RST_TRIS BP_CS_DIR
+
+/**
+ * Card session state.
+ */
+static struct {
+  /** Timer 3 value at the start of the last character on the line. */
+  uint16_t last_edge;
+
+  /** Minimum delay between characters sent to the card, in ETUs. */
+  uint16_t guard_etus;
+
+  /** The card is powered up and has answered to reset. */
+  bool active : 1;
+
+  /** The card uses the inverse convention. */
+  bool inverse : 1;
+
+  /** The last character on the line came from the card. */
+  bool last_received : 1;
+} iso7816_state = {0};
+
+/**
+ * Waits until Timer 3 reaches the given value, less than 32768 ticks away.
+ */
+static void wait_until(const uint16_t target);
+
+/**
+ * Waits until the given number of ETUs passed since a timestamp.
+ */
+static void wait_since(const uint16_t origin, const uint16_t etus);
+
+/**
+ * Waits for the falling edge of a start bit on I/O.
+ *
+ * @param[out] edge Timer 3 value when the edge was seen.
+ * @param[in] timeout_etus how long to wait.
+ *
+ * @return true if a start bit came before the timeout.
+ */
+static bool wait_start_bit(uint16_t *edge, const uint16_t timeout_etus);
+
+/**
+ * Receives a character, asking for a repetition when parity does not match.
+ *
+ * When no convention is known yet, TS is expected and the convention is set
+ * from it.
+ */
+static iso7816_result_t receive_character(uint8_t *value,
+                                          const uint16_t timeout_etus,
+                                          const bool initial);
+
+/**
+ * Sends a character, repeating it when the card signals a parity error.
+ */
+static iso7816_result_t send_character(const uint8_t value);
+
+/**
+ * Runs a single T=0 command, the five header bytes followed by the data
+ * transfer that procedure bytes ask for.
+ *
+ * @param[in] header CLA, INS, P1, P2 and P3.
+ * @param[in] data bytes to send, or NULL if P3 bytes are to be received.
+ * @param[out] received where received bytes go, room for P3 bytes needed.
+ * @param[out] received_length how many bytes were received.
+ * @param[out] status_words SW1 and SW2.
+ */
+static iso7816_result_t t0_command(const uint8_t *header, const uint8_t *data,
+                                   uint8_t *received, size_t *received_length,
+                                   uint8_t *status_words);
+
+/**
+ * Tells whether the nine line levels of a character have the parity the
+ * current convention wants.
+ */
+static inline bool parity_matches(const uint16_t levels);
+
+/**
+ * Receives the next ATR byte, adding it to the check byte computation.
+ *
+ * @param[in] result outcome so far, nothing is received unless ISO7816_OK.
+ * @param[out] atr the ATR being received.
+ * @param[in,out] received how many ATR bytes were received so far.
+ * @param[in,out] check running exclusive OR of the bytes after TS.
+ *
+ * @return the outcome so far.
+ */
+static iso7816_result_t next_atr_byte(const iso7816_result_t result,
+                                      uint8_t *atr, size_t *received,
+                                      uint8_t *check);
+
+/**
+ * Starts OC3 as a 4MHz square wave on CLK, Timer 2 as its time base and
+ * Timer 3 free running at FCY as the ETU time base.
+ */
+static void start_clocks(void);
+
+/**
+ * Stops the card clock and the timers.
+ */
+static void stop_clocks(void);
+
+void wait_until(const uint16_t target) {
+  while ((int16_t)(TMR3 - target) < 0) {
+  }
+}
+
+void wait_since(const uint16_t origin, const uint16_t etus) {
+  uint32_t remaining = (uint32_t)etus * ISO7816_ETU;
+  uint16_t last = origin;
+
+  for (;;) {
+    uint16_t now = TMR3;
+    uint16_t elapsed = now - last;
+
+    if (elapsed >= remaining) {
+      return;
+    }
+    remaining -= elapsed;
+    last = now;
+  }
+}
+
+bool wait_start_bit(uint16_t *edge, const uint16_t timeout_etus) {
+  uint32_t remaining = (uint32_t)timeout_etus * ISO7816_ETU;
+  uint16_t last = TMR3;
+
+  while (ISO7816_IO == HIGH) {
+    uint16_t now = TMR3;
+    uint16_t elapsed = now - last;
+
+    if (elapsed >= remaining) {
+      return false;
+    }
+    remaining -= elapsed;
+    last = now;
+  }
+
+  *edge = TMR3;
+  return true;
+}
+
+bool parity_matches(const uint16_t levels) {
+  uint16_t parity = levels;
+
+  parity ^= parity >> 8;
+  parity ^= parity >> 4;
+  parity ^= parity >> 2;
+  parity ^= parity >> 1;
+
+  /* Inverse convention inverts all levels, parity bit included. */
+  return (parity & 1) == (iso7816_state.inverse ? 1 : 0);
+}
+
+iso7816_result_t receive_character(uint8_t *value, const uint16_t timeout_etus,
+                                   const bool initial) {
+  uint8_t attempt = 0;
+
+  for (;;) {
+    uint16_t edge;
+    uint16_t levels = 0;
+    uint8_t bit;
+
+    if (!wait_start_bit(&edge, timeout_etus)) {
+      return ISO7816_TIMEOUT;
+    }
+
+    /* Start bit, eight data bits and parity, sampled mid ETU. */
+    for (bit = 0; bit < 10; bit++) {
+      wait_until(edge + (bit * ISO7816_ETU) + ISO7816_HALF_ETU);
+      if (ISO7816_IO == HIGH) {
+        levels |= 1 << bit;
+      }
+    }
+
+    if (levels & 1) {
+      /* Glitch, the line was back high in the middle of the start bit. */
+      continue;
+    }
+    levels >>= 1;
+
+    if (initial) {
+      if ((levels & 0xFF) == ISO7816_TS_DIRECT) {
+        iso7816_state.inverse = false;
+      } else if ((levels & 0xFF) == ISO7816_TS_INVERSE_RAW) {
+        iso7816_state.inverse = true;
+      } else {
+        return ISO7816_INVALID_ATR;
+      }
+    }
+
+    iso7816_state.last_edge = edge;
+    iso7816_state.last_received = true;
+
+    if (parity_matches(levels)) {
+      /* Let the parity bit end before looking for the next start bit. */
+      wait_until(edge + (10 * ISO7816_ETU) + ISO7816_HALF_ETU);
+      *value = iso7816_state.inverse ? bp_reverse_byte(~levels & 0xFF)
+                                     : (levels & 0xFF);
+      return ISO7816_OK;
+    }
+
+    /* Signal the error from 10.5 ETU for one ETU, the card repeats it. */
+    wait_until(edge + (10 * ISO7816_ETU) + ISO7816_HALF_ETU);
+    ISO7816_IO_TRIS = OUTPUT;
+    wait_until(edge + (11 * ISO7816_ETU) + ISO7816_HALF_ETU);
+    ISO7816_IO_TRIS = INPUT;
+
+    if (++attempt > ISO7816_RETRIES) {
+      return ISO7816_PARITY_ERROR;
+    }
+  }
+}
+
+iso7816_result_t send_character(const uint8_t value) {
+  uint16_t levels;
+  uint8_t attempt;
+
+  levels = iso7816_state.inverse ? bp_reverse_byte(~value) : value;
+  if (!parity_matches(levels)) {
+    levels |= 1 << 8;
+  }
+
+  for (attempt = 0; attempt <= ISO7816_RETRIES; attempt++) {
+    uint16_t edge;
+    uint8_t bit;
+
+    wait_since(iso7816_state.last_edge, iso7816_state.last_received
+                                            ? ISO7816_TURNAROUND_ETU
+                                            : iso7816_state.guard_etus);
+
+    edge = TMR3;
+    ISO7816_IO_TRIS = OUTPUT;
+    for (bit = 0; bit < 9; bit++) {
+      wait_until(edge + ((bit + 1) * ISO7816_ETU));
+      ISO7816_IO_TRIS = (levels & (1 << bit)) ? INPUT : OUTPUT;
+    }
+    wait_until(edge + (10 * ISO7816_ETU));
+    ISO7816_IO_TRIS = INPUT;
+
+    iso7816_state.last_edge = edge;
+    iso7816_state.last_received = false;
+
+    /* The card holds I/O low around 11 ETU if parity did not match. */
+    wait_until(edge + (11 * ISO7816_ETU));
+    if (ISO7816_IO == HIGH) {
+      return ISO7816_OK;
+    }
+
+    /* Repeat no earlier than two ETUs after the error signal. */
+    wait_until(edge + (13 * ISO7816_ETU));
+    iso7816_state.last_edge = edge + ISO7816_ETU;
+  }
+
+  return ISO7816_PARITY_ERROR;
+}
+
+void start_clocks(void) {
+  /*
+   * T2CON - TIMER 2 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------0000-0-
+   * | |      |||| |
+   * | |      |||| +--- TCS:   Internal clock (FOSC/2).
+   * | |      |||+----- T32:   Timer 2 and Timer 3 are separate timers.
+   * | |      |++------ TCKPS: 1:1 prescale value.
+   * | |      +-------- TGATE: Gated time accumulation disabled.
+   * | +--------------- TSIDL: Continue module operation in idle mode.
+   * +----------------- TON:   Timer 2 is off.
+   */
+  T2CON = 0x0000;
+  TMR2 = 0;
+  PR2 = ISO7816_CLOCK_DIVISOR - 1;
+
+  OC3R = ISO7816_CLOCK_DIVISOR / 2;
+  OC3RS = ISO7816_CLOCK_DIVISOR / 2;
+#if defined(BUSPIRATEV4)
+  OC3CON2 = 0x0000;
+  OC3CON = (0b110 << _OC3CON1_OCM_POSITION) | (OFF << _OC3CON1_OCTSEL_POSITION);
+#else
+  OC3CON = (0b110 << _OC3CON_OCM_POSITION) | (OFF << _OC3CON_OCTSEL_POSITION);
+#endif /* BUSPIRATEV4 */
+  ISO7816_CLK_RPOUT = OC3_IO;
+  ISO7816_CLK_TRIS = OUTPUT;
+
+  /*
+   * T3CON - TIMER 3 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------000--0-
+   * | |      |||  |
+   * | |      |||  +--- TCS:   Internal clock (FOSC/2).
+   * | |      |++------ TCKPS: 1:1 prescale value.
+   * | |      +-------- TGATE: Gated time accumulation disabled.
+   * | +--------------- TSIDL: Continue module operation in idle mode.
+   * +----------------- TON:   Timer 3 is off.
+   */
+  T3CON = 0x0000;
+  TMR3 = 0;
+  PR3 = 0xFFFF;
+
+  T2CONbits.TON = ON;
+  T3CONbits.TON = ON;
+}
+
+void stop_clocks(void) {
+  ISO7816_CLK_RPOUT = 0;
+  ISO7816_CLK = LOW;
+  OC3CON = 0x0000;
+  T2CON = 0x0000;
+  T3CON = 0x0000;
+}
+
+iso7816_result_t next_atr_byte(const iso7816_result_t result,
+                               uint8_t *atr, size_t *received,
+                               uint8_t *check) {
+  iso7816_result_t outcome;
+
+  if (result != ISO7816_OK) {
+    return result;
+  }
+  if (*received == ISO7816_ATR_MAXIMUM_LENGTH) {
+    return ISO7816_INVALID_ATR;
+  }
+
+  outcome = receive_character(&atr[*received], ISO7816_WORK_WAITING_TIME_ETU,
+                              false);
+  *check ^= atr[*received];
+  (*received)++;
+  return outcome;
+}
+
+iso7816_result_t iso7816_activate(uint8_t *atr, size_t *length) {
+  iso7816_result_t result;
+  uint8_t indicator;
+  uint8_t historical_bytes;
+  uint8_t check = 0;
+  bool check_byte = false;
+  size_t received = 0;
+  uint8_t interface_index = 1;
+  uint8_t interrupt_level;
+
+  iso7816_deactivate();
+  iso7816_state.guard_etus = ISO7816_CHARACTER_GUARD_ETU;
+  iso7816_state.inverse = false;
+
+  start_clocks();
+  bp_delay_us(ISO7816_RESET_DELAY_US);
+
+  /* Character timing is done by polling, nothing may get in the way. */
+  interrupt_level = SRbits.IPL;
+  SRbits.IPL = 7;
+
+  ISO7816_RST = HIGH;
+  result = receive_character(&atr[received++], ISO7816_ATR_START_TIMEOUT_ETU,
+                             true);
+
+  /* T0 carries the first interface bytes indicator and historical bytes. */
+  result = next_atr_byte(result, atr, &received, &check);
+  indicator = atr[received - 1] >> 4;
+  historical_bytes = atr[received - 1] & 0x0F;
+
+  while ((result == ISO7816_OK) && (indicator != 0)) {
+    /* TAi, TBi and TCi are kept in the ATR only, TC1 is the extra guard. */
+    if (indicator & 0b0001) {
+      result = next_atr_byte(result, atr, &received, &check);
+    }
+    if (indicator & 0b0010) {
+      result = next_atr_byte(result, atr, &received, &check);
+    }
+    if (indicator & 0b0100) {
+      result = next_atr_byte(result, atr, &received, &check);
+      if ((result == ISO7816_OK) && (interface_index == 1) &&
+          (atr[received - 1] != 0xFF)) {
+        iso7816_state.guard_etus += atr[received - 1];
+      }
+    }
+    if ((indicator & 0b1000) == 0) {
+      break;
+    }
+    result = next_atr_byte(result, atr, &received, &check);
+    if (result != ISO7816_OK) {
+      break;
+    }
+    indicator = atr[received - 1] >> 4;
+    /* Anything but T=0 offered means a check byte closes the ATR. */
+    if ((atr[received - 1] & 0x0F) != 0) {
+      check_byte = true;
+      if (interface_index == 1) {
+        result = ISO7816_INVALID_ATR;
+      }
+    }
+    interface_index++;
+  }
+
+  while ((result == ISO7816_OK) && (historical_bytes-- > 0)) {
+    result = next_atr_byte(result, atr, &received, &check);
+  }
+
+  if ((result == ISO7816_OK) && check_byte) {
+    result = next_atr_byte(result, atr, &received, &check);
+    if ((result == ISO7816_OK) && (check != 0)) {
+      result = ISO7816_INVALID_ATR;
+    }
+  }
+
+  SRbits.IPL = interrupt_level;
+
+  *length = received;
+  if (result != ISO7816_OK) {
+    iso7816_deactivate();
+    return result;
+  }
+
+  iso7816_state.active = true;
+  return ISO7816_OK;
+}
+
+void iso7816_deactivate(void) {
+  ISO7816_RST = LOW;
+  ISO7816_RST_TRIS = OUTPUT;
+  stop_clocks();
+  ISO7816_CLK_TRIS = OUTPUT;
+  ISO7816_IO = LOW;
+  ISO7816_IO_TRIS = INPUT;
+  iso7816_state.active = false;
+  iso7816_state.last_received = false;
+}
+
+iso7816_result_t t0_command(const uint8_t *header, const uint8_t *data,
+                            uint8_t *received, size_t *received_length,
+                            uint8_t *status_words) {
+  iso7816_result_t result = ISO7816_OK;
+  size_t length = header[4];
+  size_t transferred = 0;
+  uint8_t index;
+
+  /* P3 = 0 means 256 bytes when the card sends data. */
+  if ((data == NULL) && (length == 0)) {
+    length = 256;
+  }
+
+  for (index = 0; (index < 5) && (result == ISO7816_OK); index++) {
+    result = send_character(header[index]);
+  }
+
+  while (result == ISO7816_OK) {
+    uint8_t procedure;
+    size_t chunk;
+
+    result = receive_character(&procedure, ISO7816_WORK_WAITING_TIME_ETU,
+                               false);
+    if (result != ISO7816_OK) {
+      break;
+    }
+
+    if (procedure == ISO7816_NULL_PROCEDURE_BYTE) {
+      continue;
+    }
+
+    if (procedure == header[1]) {
+      chunk = length - transferred;
+    } else if ((procedure ^ 0xFF) == header[1]) {
+      chunk = 1;
+    } else if (((procedure & 0xF0) == 0x60) || ((procedure & 0xF0) == 0x90)) {
+      status_words[0] = procedure;
+      result = receive_character(&status_words[1],
+                                 ISO7816_WORK_WAITING_TIME_ETU, false);
+      break;
+    } else {
+      result = ISO7816_PROTOCOL_ERROR;
+      break;
+    }
+
+    if ((chunk == 0) || (transferred + chunk > length)) {
+      result = ISO7816_PROTOCOL_ERROR;
+      break;
+    }
+
+    while ((chunk-- > 0) && (result == ISO7816_OK)) {
+      if (data != NULL) {
+        result = send_character(data[transferred]);
+      } else {
+        result = receive_character(&received[transferred],
+                                   ISO7816_WORK_WAITING_TIME_ETU, false);
+      }
+      transferred++;
+    }
+  }
+
+  *received_length = (data == NULL) ? transferred : 0;
+  return result;
+}
+
+iso7816_result_t iso7816_t0_exchange(const uint8_t *command,
+                                     const size_t command_length,
+                                     uint8_t *response, const size_t capacity,
+                                     size_t *response_length) {
+  iso7816_result_t result;
+  uint8_t header[5];
+  uint8_t status_words[2];
+  const uint8_t *data = NULL;
+  size_t expected = 0;
+  size_t stored = 0;
+  size_t received;
+  uint8_t interrupt_level;
+
+  *response_length = 0;
+  if (!iso7816_state.active || (command_length < 4) || (capacity < 2)) {
+    return ISO7816_INVALID_COMMAND;
+  }
+
+  header[0] = command[0];
+  header[1] = command[1];
+  header[2] = command[2];
+  header[3] = command[3];
+  header[4] = 0;
+
+  if (command_length == 5) {
+    /* Case 2, Le only. */
+    header[4] = command[4];
+  } else if (command_length > 5) {
+    /* Cases 3 and 4, Lc and data, then Le for case 4. */
+    header[4] = command[4];
+    data = &command[5];
+    if (command_length == (size_t)(6 + command[4])) {
+      expected = (command[5 + command[4]] == 0) ? 256 : command[5 + command[4]];
+    } else if ((command_length != (size_t)(5 + command[4])) ||
+               (command[4] == 0)) {
+      return ISO7816_INVALID_COMMAND;
+    }
+  }
+
+  if ((data == NULL) && (command_length == 5) &&
+      (capacity - 2 < (header[4] == 0 ? 256 : header[4]))) {
+    return ISO7816_BUFFER_TOO_SMALL;
+  }
+
+  interrupt_level = SRbits.IPL;
+  SRbits.IPL = 7;
+
+  /* Case 1 sends P3 = 0, no data goes either way. */
+  result = t0_command(header, (command_length == 4) ? command : data,
+                      response, &received, status_words);
+  stored = received;
+
+  if ((result == ISO7816_OK) && (data == NULL) &&
+      (status_words[0] == ISO7816_SW1_WRONG_LENGTH) && (command_length == 5)) {
+    /* Wrong Le, send the command again with the length the card wants. */
+    header[4] = status_words[1];
+    if (capacity - 2 < (header[4] == 0 ? 256 : header[4])) {
+      result = ISO7816_BUFFER_TOO_SMALL;
+    } else {
+      result = t0_command(header, NULL, response, &received, status_words);
+      stored = received;
+    }
+  }
+
+  /* Collect the rest of the response, case 4 commands always end here. */
+  while ((result == ISO7816_OK) &&
+         (status_words[0] == ISO7816_SW1_MORE_DATA)) {
+    size_t available = (status_words[1] == 0) ? 256 : status_words[1];
+
+    if ((expected != 0) && (available > expected - stored)) {
+      available = expected - stored;
+    }
+    if (available > capacity - 2 - stored) {
+      result = ISO7816_BUFFER_TOO_SMALL;
+      break;
+    }
+    if (available == 0) {
+      break;
+    }
+
+    header[1] = ISO7816_GET_RESPONSE_INS;
+    header[2] = 0x00;
+    header[3] = 0x00;
+    header[4] = (uint8_t)available;
+    result = t0_command(header, NULL, &response[stored], &received,
+                        status_words);
+    stored += received;
+  }
+
+  SRbits.IPL = interrupt_level;
+
+  if (result != ISO7816_OK) {
+    return result;
+  }
+
+  response[stored++] = status_words[0];
+  response[stored++] = status_words[1];
+  *response_length = stored;
+  return ISO7816_OK;
+}
+
+#endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
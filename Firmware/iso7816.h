@@ -0,0 +1,114 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file iso7816.h
+ *
+ * @brief ISO 7816-3 asynchronous smart card interface, T=0 protocol.
+ *
+ * The card is wired to the Raw 2-Wire pins: RST on CS, CLK on CLK and I/O on
+ * MOSI.  I/O is driven as open drain, so the pull-up resistors must be on.
+ *
+ * The card clock is a 4MHz square wave coming from OC3 with Timer 2 as time
+ * base, so AUX PWM cannot run meanwhile.  Characters are timed against Timer 3
+ * at the default elementary time unit of 372 card clocks, with interrupts
+ * masked while an exchange is in progress.  No PPS exchange is made, so cards
+ * that only work at other F/D values are not supported.
+ */
+
+#ifndef BP_ISO7816_H
+#define BP_ISO7816_H
+
+#include "configuration.h"
+
+#ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Longest ATR allowed by ISO 7816-3, TS included. */
+#define ISO7816_ATR_MAXIMUM_LENGTH 33
+
+/** Longest T=0 command APDU: header, Lc, 255 bytes of data and Le. */
+#define ISO7816_COMMAND_MAXIMUM_LENGTH (4 + 1 + 255 + 1)
+
+/** Longest T=0 response APDU: 256 bytes of data, SW1 and SW2. */
+#define ISO7816_RESPONSE_MAXIMUM_LENGTH (256 + 2)
+
+/**
+ * Outcome of a card operation.
+ */
+typedef enum {
+  /** The operation completed. */
+  ISO7816_OK = 0,
+  /** The card did not answer within the waiting time. */
+  ISO7816_TIMEOUT,
+  /** A character kept failing its parity check after all retries. */
+  ISO7816_PARITY_ERROR,
+  /** The ATR is malformed, uses no T=0 or fails its check byte. */
+  ISO7816_INVALID_ATR,
+  /** The card sent a procedure byte that makes no sense at that point. */
+  ISO7816_PROTOCOL_ERROR,
+  /** The command APDU is malformed, or the card is not active. */
+  ISO7816_INVALID_COMMAND,
+  /** The response does not fit in the buffer given. */
+  ISO7816_BUFFER_TOO_SMALL
+} iso7816_result_t;
+
+/**
+ * Powers up the card clock, releases RST and reads the answer to reset.
+ *
+ * The convention and the extra guard time are taken from the ATR.
+ *
+ * @param[out] atr buffer of at least ISO7816_ATR_MAXIMUM_LENGTH bytes.
+ * @param[out] length how many ATR bytes were received.
+ *
+ * @return ISO7816_OK if a valid ATR offering T=0 was read.  The card is
+ * deactivated again otherwise.
+ */
+iso7816_result_t iso7816_activate(uint8_t *atr, size_t *length);
+
+/**
+ * Pulls RST low, stops the card clock and releases I/O.
+ */
+void iso7816_deactivate(void);
+
+/**
+ * Exchanges a command APDU with the card using T=0 transport.
+ *
+ * Procedure bytes are handled as they come: NULL bytes extend the waiting
+ * time, INS and its complement move the rest of the data or a single byte.
+ * SW1 0x6C makes the command be sent again with the length the card asked
+ * for, SW1 0x61 fetches the rest of the response with GET RESPONSE.
+ *
+ * @param[in] command command APDU, header and body as in ISO 7816-4 cases 1
+ * to 4, short lengths only.
+ * @param[in] command_length how many bytes the command APDU takes.
+ * @param[out] response buffer for response data followed by SW1 and SW2.
+ * @param[in] capacity size of the response buffer, at least 2.
+ * @param[out] response_length how many response bytes were stored.
+ *
+ * @return ISO7816_OK if the card answered with status words.
+ */
+iso7816_result_t iso7816_t0_exchange(const uint8_t *command,
+                                     const size_t command_length,
+                                     uint8_t *response, const size_t capacity,
+                                     size_t *response_length);
+
+#endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
+
+#endif /* !BP_ISO7816_H */
@@ -22,6 +22,10 @@
 #include <stdint.h>
 
 #include "base.h"
+#include "binary_io.h"
+#include "core.h"
+
+extern bus_pirate_configuration_t bus_pirate_configuration;
 
 #ifdef BP_JTAG_XSVF_SUPPORT
 
@@ -34,7 +38,7 @@
 #define XSVF_ERROR_MAXRETRIES 3 /* TDO mismatch after max retries */
 #define XSVF_ERROR_ILLEGALCMD 4
 #define XSVF_ERROR_ILLEGALSTATE 5
-#define XSVF_ERROR_DATAOVERFLOW 6 /* Data > lenVal MAX_LEN buffer size*/
+#define XSVF_ERROR_DATAOVERFLOW 6 /* Data > lenVal buffer size */
 /* Insert new errors here */
 #define XSVF_ERROR_LAST 7
 
@@ -48,6 +52,16 @@
 #define SHIFTIR 2
 #define SHIFTDR 3
 
+/*
+ * Scan queue operations, see jtag_run_queue().
+ */
+#define JTAG_QUEUE_GOTO_STATE 0x01
+#define JTAG_QUEUE_SHIFT_IR 0x02
+#define JTAG_QUEUE_SHIFT_DR 0x03
+#define JTAG_QUEUE_RUNTEST 0x04
+#define JTAG_QUEUE_CAPTURE 0x80
+#define JTAG_QUEUE_BYTES(bits) (((bits) >> 3) + (((bits)&7) ? 1 : 0))
+
 static void jtag_setup(void);
 static void jtag_set_state(const uint8_t new_state);
 static void jtag_leave_state(void);
@@ -62,6 +76,10 @@ static void jtag_clock_high(void);
 static void jtag_clock_ticks(size_t ticks);
 static void jtag_tms_high(void);
 static void jtag_tms_low(void);
+static bool jtag_check_queue(const uint8_t *queue, const size_t length);
+static void jtag_run_queue(void);
+static void jtag_shift(const uint8_t state, const uint8_t *tdi,
+                       const uint16_t bits, const bool capture);
 
 typedef struct {
   uint8_t state : 2;
@@ -124,22 +142,195 @@ void jtag(void) {
 
 #ifdef BP_JTAG_XSVF_SUPPORT
     case 3: {
+      uint8_t result;
+
       // data MUST be low when we start or we get error 3!
       jtag_data_low();
       jtag_clock_low();
       jtag_tms_low();
       xsvf_setup();
-      user_serial_transmit_character(xsvfExecute());
+      result = xsvfExecute();
+      xsvf_finish();
+      user_serial_transmit_character(result);
       break;
     }
 #endif /* BP_JTAG_XSVF_SUPPORT */
 
+    case 4: // run a scan queue
+      jtag_run_queue();
+      break;
+
+#ifdef BP_JTAG_XSVF_SUPPORT
+    case 5: // XSVF chunk size, MSB first, so the host can size its blocks
+      user_serial_transmit_character(XSVF_CHUNK_SIZE >> 8);
+      user_serial_transmit_character(XSVF_CHUNK_SIZE & 0xFF);
+      break;
+#endif /* BP_JTAG_XSVF_SUPPORT */
+
+    default:
+      break;
+    }
+  }
+}
+
+/*
+ * Scan queue: queue length (2 bytes, MSB first), then the queue itself, made
+ * of these operations:
+ *
+ *   0x01 state                  go to RESET (0), IDLE (1), SHIFTIR (2) or
+ *                               SHIFTDR (3)
+ *   0x02 bits(2) TDI            shift bits into IR, ending in IDLE
+ *   0x03 bits(2) TDI            shift bits into DR, ending in IDLE
+ *   0x04 clocks(2)              clock TCK in IDLE
+ *
+ * Counts are MSB first, TDI bytes LSB first.  Setting bit 7 of a shift
+ * operation captures TDO as well.  The whole queue is received and checked
+ * first: the answer is 0x00 if it does not fit or is malformed, otherwise
+ * 0x01 followed by the TDO bytes of every capturing shift, in queue order.
+ */
+
+bool jtag_check_queue(const uint8_t *queue, const size_t length) {
+  size_t offset = 0;
+
+  while (offset < length) {
+    uint8_t operation = queue[offset++];
+    uint16_t count;
+
+    if (operation == JTAG_QUEUE_GOTO_STATE) {
+      if ((offset >= length) || (queue[offset] > SHIFTDR)) {
+        return false;
+      }
+      offset++;
+      continue;
+    }
+
+    if (offset + 2 > length) {
+      return false;
+    }
+    count = (queue[offset] << 8) | queue[offset + 1];
+    offset += 2;
+
+    switch (operation & ~JTAG_QUEUE_CAPTURE) {
+    case JTAG_QUEUE_SHIFT_IR:
+    case JTAG_QUEUE_SHIFT_DR:
+      if ((count == 0) || ((length - offset) < JTAG_QUEUE_BYTES(count))) {
+        return false;
+      }
+      offset += JTAG_QUEUE_BYTES(count);
+      break;
+
+    case JTAG_QUEUE_RUNTEST:
+      if (operation & JTAG_QUEUE_CAPTURE) {
+        return false;
+      }
+      break;
+
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void jtag_run_queue(void) {
+  uint8_t *queue = bus_pirate_configuration.terminal_input;
+  size_t length;
+  size_t offset;
+
+  length = user_serial_read_byte() << 8;
+  length |= user_serial_read_byte();
+  if (length > BP_TERMINAL_BUFFER_SIZE) {
+    /* Too big, skip it. */
+    while (length-- > 0) {
+      user_serial_read_byte();
+    }
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  for (offset = 0; offset < length;) {
+    size_t available;
+    const uint8_t *data =
+        user_serial_borrow_input(length - offset, &available);
+
+    memcpy(&queue[offset], data, available);
+    offset += available;
+  }
+
+  if (!jtag_check_queue(queue, length)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  REPORT_IO_SUCCESS();
+
+  offset = 0;
+  while (offset < length) {
+    uint8_t operation = queue[offset++];
+    uint16_t count;
+
+    if (operation == JTAG_QUEUE_GOTO_STATE) {
+      jtag_leave_state();
+      if (queue[offset] != IDLE) {
+        jtag_set_state(queue[offset]);
+      }
+      offset++;
+      continue;
+    }
+
+    count = (queue[offset] << 8) | queue[offset + 1];
+    offset += 2;
+
+    switch (operation & ~JTAG_QUEUE_CAPTURE) {
+    case JTAG_QUEUE_SHIFT_IR:
+    case JTAG_QUEUE_SHIFT_DR:
+      jtag_shift(((operation & ~JTAG_QUEUE_CAPTURE) == JTAG_QUEUE_SHIFT_IR)
+                     ? SHIFTIR
+                     : SHIFTDR,
+                 &queue[offset], count, operation & JTAG_QUEUE_CAPTURE);
+      offset += JTAG_QUEUE_BYTES(count);
+      break;
+
+    case JTAG_QUEUE_RUNTEST:
+      jtag_leave_state();
+      jtag_tms_low();
+      jtag_clock_ticks(count);
+      break;
+
     default:
       break;
     }
   }
 }
 
+void jtag_shift(const uint8_t state, const uint8_t *tdi, const uint16_t bits,
+                const bool capture) {
+  uint16_t bit_index;
+  uint8_t tdo = 0;
+
+  jtag_leave_state();
+  jtag_set_state(state);
+
+  for (bit_index = 0; bit_index < bits; bit_index++) {
+    if (bit_index == bits - 1) {
+      /* The last bit also moves on to Exit1. */
+      jtag_tms_high();
+    }
+    tdo |= jtag_write_bit((tdi[bit_index / 8] >> (bit_index % 8)) & 1)
+           << (bit_index % 8);
+    if (capture && (((bit_index % 8) == 7) || (bit_index == bits - 1))) {
+      user_serial_transmit_character(tdo);
+      tdo = 0;
+    }
+  }
+
+  /* Exit1, Update, then Idle. */
+  jtag_clock_ticks(1);
+  jtag_tms_low();
+  jtag_clock_ticks(1);
+  jtag_settings.state = IDLE;
+}
+
 void jtag_leave_state(void) {
   switch (jtag_settings.state) {
   case IDLE:
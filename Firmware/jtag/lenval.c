@@ -61,32 +61,50 @@ short EqualLenVal( lenVal*  plvTdoExpected,
                    lenVal*  plvTdoCaptured,
                    lenVal*  plvTdoMask )
 {
-    short           sEqual;
-	short           sIndex;
-    unsigned char   ucByteVal1;
-    unsigned char   ucByteVal2;
-    unsigned char   ucByteMask;
-
-    sEqual  = 1;
-    sIndex  = plvTdoExpected->len;
+    const unsigned short*   pusExpected;
+    const unsigned short*   pusCaptured;
+    const unsigned short*   pusMask;
+    unsigned short          usDifference;
+    short                   sWords;
+    short                   sIndex;
+
+    /* The buffers are word aligned, so all but an odd last byte are
+       compared a word at a time; the byte order within a word does not
+       matter for equality. */
+    pusExpected = (const unsigned short*)plvTdoExpected->val;
+    pusCaptured = (const unsigned short*)plvTdoCaptured->val;
+    pusMask     = plvTdoMask ? (const unsigned short*)plvTdoMask->val : 0;
+    sWords      = plvTdoExpected->len >> 1;
+
+    for ( sIndex = 0; sIndex < sWords; ++sIndex )
+    {
+        usDifference    = pusExpected[ sIndex ] ^ pusCaptured[ sIndex ];
+        if ( pusMask )
+        {
+            usDifference    &= pusMask[ sIndex ];
+        }
+        if ( usDifference )
+        {
+            return( 0 );
+        }
+    }
 
-    while ( sEqual && sIndex-- )
+    if ( plvTdoExpected->len & 1 )
     {
-        ucByteVal1  = plvTdoExpected->val[ sIndex ];
-        ucByteVal2  = plvTdoCaptured->val[ sIndex ];
+        sIndex          = plvTdoExpected->len - 1;
+        usDifference    = plvTdoExpected->val[ sIndex ] ^
+                          plvTdoCaptured->val[ sIndex ];
         if ( plvTdoMask )
         {
-            ucByteMask  = plvTdoMask->val[ sIndex ];
-            ucByteVal1  &= ucByteMask;
-            ucByteVal2  &= ucByteMask;
+            usDifference    &= plvTdoMask->val[ sIndex ];
         }
-        if ( ucByteVal1 != ucByteVal2 )
+        if ( usDifference )
         {
-            sEqual  = 0;
+            return( 0 );
         }
     }
 
-	return( sEqual );
+	return( 1 );
 }
 
 
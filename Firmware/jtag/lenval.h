@@ -14,60 +14,22 @@
 /* the lenVal structure is a byte oriented type used to store an */
 /* arbitrary length binary value. As an example, the hex value   */
 /* 0x0e3d is represented as a lenVal with len=2 (since 2 bytes   */
-/* and val[0]=0e and val[1]=3d.  val[2-MAX_LEN] are undefined    */
-
-/* maximum length (in bytes) of value to read in        */
-/* this needs to be at least 4, and longer than the     */
-/* length of the longest SDR instruction.  If there is, */
-/* only 1 device in the chain, MAX_LEN must be at least */
-/* ceil(27/8) == 4.  For 6 devices in a chain, MAX_LEN  */
-/* must be 5, for 14 devices MAX_LEN must be 6, for 20  */
-/* devices MAX_LEN must be 7, etc..                     */
-/* You can safely set MAX_LEN to a smaller number if you*/
-/* know how many devices will be in your chain.         */
-/*  #define MAX_LEN (Actual #define is below this comment block)
-      This #define defines the maximum length (in bytes) of predefined
-      buffers in which the XSVF player stores the current shift data.
-      This length must be greater than the longest shift length (in bytes)
-      in the XSVF files that will be processed.  7000 is a very conservative
-      number.  The buffers are stored on the stack and if you have limited
-      stack space, you may decrease the MAX_LEN value.
-
-      How to find the "shift length" in bits?
-      Look at the ASCII version of the XSVF (generated with the -a option
-      for the SVF2XSVF translator) and search for the XSDRSIZE command
-      with the biggest parameter.  XSDRSIZE is equivalent to the SVF's
-      SDR length plus the lengths of applicable HDR and TDR commands.
-      Remember that the MAX_LEN is defined in bytes.  Therefore, the
-      minimum MAX_LEN = ceil( max( XSDRSIZE ) / 8 );
-
-      The following MAX_LEN values have been tested and provide relatively
-      good margin for the corresponding devices:
-
-        DEVICE       MAX_LEN   Resulting Shift Length Max (in bits)
-        ---------    -------   ----------------------------------------------
-        XC9500/XL/XV 32        256
-
-        CoolRunner/II 256      2048   - actual max 1 device = 1035 bits
-
-        FPGA         128       1024    - svf2xsvf -rlen 1024
-
-        XC18V00/XCF00
-                     1100      8800   - no blank check performed (default)
-                                      - actual max 1 device = 8192 bits verify
-                                      - max 1 device = 4096 bits program-only
-
-        XC18V00/XCF00 when using the optional Blank Check operation
-                     2500      20000  - required for blank check
-                                      - blank check max 1 device = 16384 bits
-*/
-
-#define MAX_LEN 50
-
+/* and val[0]=0e and val[1]=3d.  the rest of val is undefined     */
+
+/* minimum length (in bytes) of each lenVal buffer: XSDRSIZE and */
+/* XSIR2 read their lengths into lvTdi, so it must hold 4 bytes.  */
+#define MIN_LEN 4
+
+/* The buffers are not part of the structure: xsvfInfoInit() splits  */
+/* the largest free run of the buffer arena between all the lenVals  */
+/* of the player, so the longest shift that fits depends on what is  */
+/* free when the XSVF file starts, and is checked against each       */
+/* XSDRSIZE and XSIR as they come.  The buffers are word aligned and */
+/* have an even size, so they can be gone through a word at a time.  */
 typedef struct var_len_byte
 {
     short len;   /* number of chars in this value */
-    unsigned char val[MAX_LEN+1];  /* bytes of data */
+    unsigned char *val;  /* bytes of data */
 } lenVal;
 
 
@@ -52,6 +52,7 @@
 #include "micro.h"
 #include "lenval.h"
 #include "ports.h"
+#include "../buffer_arena.h"
 
 
 /*============================================================================
@@ -90,6 +91,29 @@
 #endif  /* XSVF_SUPPORT_ERRORCODES */
 
 
+/*****************************************************************************
+* Define:       XSVF_SUPPORT_FAST_SHIFT
+* Description:  Define this to shift whole TDI/TDO bytes with the port level
+*               loop in ports_asm.s instead of calling setPort() and
+*               readTDOBit() for every edge.  The last bits of a shift (the
+*               ones that may need TMS set) always go through the portable
+*               loop.
+*****************************************************************************/
+#ifndef XSVF_SUPPORT_FAST_SHIFT
+    #define XSVF_SUPPORT_FAST_SHIFT     1
+#endif
+
+/*****************************************************************************
+* Define:       XSVF_SUPPORT_TMS_PATHS
+* Description:  Define this to make TAP state changes in one go, looking the
+*               TMS sequence up in xsvf_tmsPaths and clocking it out with the
+*               port level loop in ports_asm.s, instead of walking the TAP
+*               state machine one setPort() TMS transition at a time.
+*****************************************************************************/
+#ifndef XSVF_SUPPORT_TMS_PATHS
+    #define XSVF_SUPPORT_TMS_PATHS      1
+#endif
+
 /*****************************************************************************
 * Define:       XSVF_MAIN
 * Description:  Define this to compile with a main function for standalone
@@ -139,16 +163,13 @@
 * Struct:       SXsvfInfo
 * Description:  This structure contains all of the data used during the
 *               execution of the XSVF.  Some data is persistent, predefined
-*               information (e.g. lRunTestTime).  The bulk of this struct's
-*               size is due to the lenVal structs (defined in lenval.h)
-*               which contain buffers for the active shift data.  The MAX_LEN
-*               #define in lenval.h defines the size of these buffers.
-*               These buffers must be large enough to store the longest
-*               shift data in your XSVF file.  For example:
-*                   MAX_LEN >= ( longest_shift_data_in_bits / 8 )
-*               Because the lenVal struct dominates the space usage of this
-*               struct, the rough size of this struct is:
-*                   sizeof( SXsvfInfo ) ~= MAX_LEN * 7 (number of lenVals)
+*               information (e.g. lRunTestTime).  The lenVal structs
+*               (defined in lenval.h) point to buffers for the active shift
+*               data, kept out of this struct and off the stack: they come
+*               from the buffer arena, XSVF_LENVAL_COUNT of sLenValBytes
+*               bytes each, and must be large enough to store the longest
+*               shift data in your XSVF file:
+*                   sLenValBytes >= ( longest_shift_data_in_bits / 8 )
 *               xsvfInitialize() contains initialization code for the data
 *               in this struct.
 *               xsvfCleanup() contains cleanup code for the data in this
@@ -174,6 +195,8 @@ typedef struct tagSXsvfInfo
     /* Shift Data Info and Buffers */
     long            lShiftLengthBits;   /* Len. current shift data in bits */
     short           sShiftLengthBytes;  /* Len. current shift data in bytes */
+    short           sLenValBytes;       /* Size of each lenVal buffer */
+    unsigned char*  pucLenValBuffers;   /* Arena memory behind the lenVals */
 
     lenVal          lvTdi;              /* Current TDI shift data */
     lenVal          lvTdoExpected;      /* Expected TDO shift data */
@@ -188,6 +211,16 @@ typedef struct tagSXsvfInfo
 #endif  /* XSVF_SUPPORT_COMPRESSION */
 } SXsvfInfo;
 
+/* Number of lenVal structs in SXsvfInfo */
+#ifdef  XSVF_SUPPORT_COMPRESSION
+    #define XSVF_LENVAL_COUNT   7
+#else
+    #define XSVF_LENVAL_COUNT   4
+#endif  /* XSVF_SUPPORT_COMPRESSION */
+
+/* Longest lenVal buffer, in bytes, the lengths being shorts */
+#define XSVF_LENVAL_MAXIMUM_BYTES   0x7FFE
+
 /* Declare pointer to functions that perform XSVF commands */
 typedef int (*TXsvfDoCmdFuncPtr)( SXsvfInfo* );
 
@@ -319,6 +352,135 @@ TXsvfDoCmdFuncPtr   xsvf_pfDoCmd[]  =
 /* Insert new command functions here */
 };
 
+#ifdef  XSVF_SUPPORT_TMS_PATHS
+/* TMS sequences for xsvfGotoTapState, indexed by [current][target] TAP  */
+/* state.  Bits go out LSB first, ucClocks of them.  They are the paths  */
+/* the state machine walk in xsvfGotoTapState takes, including the       */
+/* Pause -> Exit2 -> ... -> Pause round trip for a Pause target that is  */
+/* already the current state.  The illegal Exit2 targets are left empty, */
+/* xsvfGotoTapState traps them before looking anything up.  Targets go   */
+/* in state order, RESET to UPDATEIR, four per line.                     */
+const struct
+{
+    unsigned char   ucTms;
+    unsigned char   ucClocks;
+} xsvf_tmsPaths[ 16 ][ 16 ] =
+{
+    /* From RESET */
+    {
+        { 0x3F, 6 }, { 0x00, 1 }, { 0x02, 2 }, { 0x02, 3 },
+        { 0x02, 4 }, { 0x0A, 4 }, { 0x0A, 5 }, { 0x00, 0 },
+        { 0x1A, 5 }, { 0x06, 3 }, { 0x06, 4 }, { 0x06, 5 },
+        { 0x16, 5 }, { 0x16, 6 }, { 0x00, 0 }, { 0x36, 6 }
+    },
+    /* From RUNTEST */
+    {
+        { 0x3F, 6 }, { 0x00, 0 }, { 0x01, 1 }, { 0x01, 2 },
+        { 0x01, 3 }, { 0x05, 3 }, { 0x05, 4 }, { 0x00, 0 },
+        { 0x0D, 4 }, { 0x03, 2 }, { 0x03, 3 }, { 0x03, 4 },
+        { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 }, { 0x1B, 5 }
+    },
+    /* From SELECTDR */
+    {
+        { 0x3F, 6 }, { 0x06, 4 }, { 0x00, 0 }, { 0x00, 1 },
+        { 0x00, 2 }, { 0x02, 2 }, { 0x02, 3 }, { 0x00, 0 },
+        { 0x06, 3 }, { 0x01, 1 }, { 0x01, 2 }, { 0x01, 3 },
+        { 0x05, 3 }, { 0x05, 4 }, { 0x00, 0 }, { 0x0D, 4 }
+    },
+    /* From CAPTUREDR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x00, 0 },
+        { 0x00, 1 }, { 0x01, 1 }, { 0x01, 2 }, { 0x00, 0 },
+        { 0x03, 2 }, { 0x0F, 4 }, { 0x0F, 5 }, { 0x0F, 6 },
+        { 0x2F, 6 }, { 0x2F, 7 }, { 0x00, 0 }, { 0x6F, 7 }
+    },
+    /* From SHIFTDR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x07, 4 },
+        { 0x00, 0 }, { 0x01, 1 }, { 0x01, 2 }, { 0x00, 0 },
+        { 0x03, 2 }, { 0x0F, 4 }, { 0x0F, 5 }, { 0x0F, 6 },
+        { 0x2F, 6 }, { 0x2F, 7 }, { 0x00, 0 }, { 0x6F, 7 }
+    },
+    /* From EXIT1DR */
+    {
+        { 0x3F, 6 }, { 0x01, 2 }, { 0x03, 2 }, { 0x03, 3 },
+        { 0x03, 4 }, { 0x00, 0 }, { 0x00, 1 }, { 0x00, 0 },
+        { 0x01, 1 }, { 0x07, 3 }, { 0x07, 4 }, { 0x07, 5 },
+        { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 }, { 0x37, 6 }
+    },
+    /* From PAUSEDR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x07, 4 },
+        { 0x01, 2 }, { 0x17, 5 }, { 0x17, 6 }, { 0x01, 1 },
+        { 0x03, 2 }, { 0x0F, 4 }, { 0x0F, 5 }, { 0x0F, 6 },
+        { 0x2F, 6 }, { 0x2F, 7 }, { 0x00, 0 }, { 0x6F, 7 }
+    },
+    /* From EXIT2DR */
+    {
+        { 0x3F, 6 }, { 0x01, 2 }, { 0x03, 2 }, { 0x03, 3 },
+        { 0x00, 1 }, { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 },
+        { 0x01, 1 }, { 0x07, 3 }, { 0x07, 4 }, { 0x07, 5 },
+        { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 }, { 0x37, 6 }
+    },
+    /* From UPDATEDR */
+    {
+        { 0x3F, 6 }, { 0x00, 1 }, { 0x01, 1 }, { 0x01, 2 },
+        { 0x01, 3 }, { 0x05, 3 }, { 0x05, 4 }, { 0x00, 0 },
+        { 0x00, 0 }, { 0x03, 2 }, { 0x03, 3 }, { 0x03, 4 },
+        { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 }, { 0x1B, 5 }
+    },
+    /* From SELECTIR */
+    {
+        { 0x3F, 6 }, { 0x06, 4 }, { 0x0E, 4 }, { 0x0E, 5 },
+        { 0x0E, 6 }, { 0x2E, 6 }, { 0x2E, 7 }, { 0x00, 0 },
+        { 0x6E, 7 }, { 0x00, 0 }, { 0x00, 1 }, { 0x00, 2 },
+        { 0x02, 2 }, { 0x02, 3 }, { 0x00, 0 }, { 0x06, 3 }
+    },
+    /* From CAPTUREIR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x07, 4 },
+        { 0x07, 5 }, { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 },
+        { 0x37, 6 }, { 0x0F, 4 }, { 0x00, 0 }, { 0x00, 1 },
+        { 0x01, 1 }, { 0x01, 2 }, { 0x00, 0 }, { 0x03, 2 }
+    },
+    /* From SHIFTIR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x07, 4 },
+        { 0x07, 5 }, { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 },
+        { 0x37, 6 }, { 0x0F, 4 }, { 0x0F, 5 }, { 0x00, 0 },
+        { 0x01, 1 }, { 0x01, 2 }, { 0x00, 0 }, { 0x03, 2 }
+    },
+    /* From EXIT1IR */
+    {
+        { 0x3F, 6 }, { 0x01, 2 }, { 0x03, 2 }, { 0x03, 3 },
+        { 0x03, 4 }, { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 },
+        { 0x1B, 5 }, { 0x07, 3 }, { 0x07, 4 }, { 0x07, 5 },
+        { 0x00, 0 }, { 0x00, 1 }, { 0x00, 0 }, { 0x01, 1 }
+    },
+    /* From PAUSEIR */
+    {
+        { 0x3F, 6 }, { 0x03, 3 }, { 0x07, 3 }, { 0x07, 4 },
+        { 0x07, 5 }, { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 },
+        { 0x37, 6 }, { 0x0F, 4 }, { 0x0F, 5 }, { 0x01, 2 },
+        { 0x2F, 6 }, { 0x2F, 7 }, { 0x01, 1 }, { 0x03, 2 }
+    },
+    /* From EXIT2IR */
+    {
+        { 0x3F, 6 }, { 0x01, 2 }, { 0x03, 2 }, { 0x03, 3 },
+        { 0x03, 4 }, { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 },
+        { 0x1B, 5 }, { 0x07, 3 }, { 0x07, 4 }, { 0x00, 1 },
+        { 0x17, 5 }, { 0x17, 6 }, { 0x00, 0 }, { 0x01, 1 }
+    },
+    /* From UPDATEIR */
+    {
+        { 0x3F, 6 }, { 0x00, 1 }, { 0x01, 1 }, { 0x01, 2 },
+        { 0x01, 3 }, { 0x05, 3 }, { 0x05, 4 }, { 0x00, 0 },
+        { 0x0D, 4 }, { 0x03, 2 }, { 0x03, 3 }, { 0x03, 4 },
+        { 0x0B, 4 }, { 0x0B, 5 }, { 0x00, 0 }, { 0x00, 0 }
+    }
+};
+#endif  /* XSVF_SUPPORT_TMS_PATHS */
+
 /*============================================================================
 * Utility Functions
 ============================================================================*/
@@ -331,9 +493,51 @@ TXsvfDoCmdFuncPtr   xsvf_pfDoCmd[]  =
 *****************************************************************************/
 int xsvfInfoInit( SXsvfInfo* pXsvfInfo )
 {
+    lenVal*         plvLenVals[ XSVF_LENVAL_COUNT ];
+    size_t          uiLenValBytes;
+    unsigned char   i;
+
     XSVFDBG_PRINTF1( 4, "    sizeof( SXsvfInfo ) = %d bytes\n",
                      sizeof( SXsvfInfo ) );
 
+    /* Share the largest free run of the arena between the lenVals, the
+       even size keeps every buffer word aligned for EqualLenVal() */
+    uiLenValBytes   = ( bp_buffer_arena_largest_free() / XSVF_LENVAL_COUNT ) & ~1;
+    if ( uiLenValBytes > XSVF_LENVAL_MAXIMUM_BYTES )
+    {
+        uiLenValBytes   = XSVF_LENVAL_MAXIMUM_BYTES;
+    }
+    pXsvfInfo->pucLenValBuffers = 0;
+    if ( uiLenValBytes < MIN_LEN )
+    {
+        return( XSVF_ERROR_DATAOVERFLOW );
+    }
+    pXsvfInfo->pucLenValBuffers = bp_buffer_arena_reserve(
+        uiLenValBytes * XSVF_LENVAL_COUNT );
+    if ( !pXsvfInfo->pucLenValBuffers )
+    {
+        return( XSVF_ERROR_DATAOVERFLOW );
+    }
+    pXsvfInfo->sLenValBytes     = (short)uiLenValBytes;
+
+    plvLenVals[ 0 ] = &( pXsvfInfo->lvTdi );
+    plvLenVals[ 1 ] = &( pXsvfInfo->lvTdoExpected );
+    plvLenVals[ 2 ] = &( pXsvfInfo->lvTdoCaptured );
+    plvLenVals[ 3 ] = &( pXsvfInfo->lvTdoMask );
+#ifdef  XSVF_SUPPORT_COMPRESSION
+    plvLenVals[ 4 ] = &( pXsvfInfo->lvAddressMask );
+    plvLenVals[ 5 ] = &( pXsvfInfo->lvDataMask );
+    plvLenVals[ 6 ] = &( pXsvfInfo->lvNextData );
+#endif  /* XSVF_SUPPORT_COMPRESSION */
+    for ( i = 0; i < XSVF_LENVAL_COUNT; ++i )
+    {
+        plvLenVals[ i ]->len    = 0;
+        plvLenVals[ i ]->val    = pXsvfInfo->pucLenValBuffers +
+                                  ( i * uiLenValBytes );
+    }
+    XSVFDBG_PRINTF1( 4, "    lenVal buffers = %d bytes\n",
+                     pXsvfInfo->sLenValBytes );
+
     pXsvfInfo->ucComplete       = 0;
     pXsvfInfo->ucCommand        = XCOMPLETE;
     pXsvfInfo->lCommandCount    = 0;
@@ -357,6 +561,8 @@ int xsvfInfoInit( SXsvfInfo* pXsvfInfo )
 *****************************************************************************/
 void xsvfInfoCleanup( SXsvfInfo* pXsvfInfo )
 {
+    bp_buffer_arena_release( pXsvfInfo->pucLenValBuffers );
+    pXsvfInfo->pucLenValBuffers = 0;
 }
 
 /*****************************************************************************
@@ -428,6 +634,14 @@ int xsvfGotoTapState( unsigned char*   pucTapState,
     }
     else
     {
+#ifdef  XSVF_SUPPORT_TMS_PATHS
+        xsvfTmsSequenceFast(
+            xsvf_tmsPaths[ *pucTapState ][ ucTargetState ].ucTms,
+            xsvf_tmsPaths[ *pucTapState ][ ucTargetState ].ucClocks );
+        *pucTapState    = ucTargetState;
+        XSVFDBG_PRINTF1( 3, "   TAP State = %s\n",
+                         xsvf_pzTapState[ *pucTapState ] );
+#else
         if ( ucTargetState == *pucTapState )
         {
             /* Already in target state.  Do nothing except when in DRPAUSE
@@ -597,6 +811,7 @@ int xsvfGotoTapState( unsigned char*   pucTapState,
             XSVFDBG_PRINTF1( 3, "   TAP State = %s\n",
                              xsvf_pzTapState[ *pucTapState ] );
         }
+#endif  /* XSVF_SUPPORT_TMS_PATHS */
     }
 
     return( iErrorCode );
@@ -627,6 +842,9 @@ void xsvfShiftOnly( long    lNumBits,
     unsigned char   ucTdoByte;
     unsigned char   ucTdoBit;
     int             i;
+#ifdef  XSVF_SUPPORT_FAST_SHIFT
+    unsigned int    uiFastBytes;
+#endif  /* XSVF_SUPPORT_FAST_SHIFT */
 
     /* assert( ( ( lNumBits + 7 ) / 8 ) == plvTdi->len ); */
 
@@ -640,6 +858,22 @@ void xsvfShiftOnly( long    lNumBits,
 
     /* Shift LSB first.  val[N-1] == LSB.  val[0] == MSB. */
     pucTdi  = plvTdi->val + plvTdi->len;
+
+#ifdef  XSVF_SUPPORT_FAST_SHIFT
+    /* Leave 1 to 8 bits, including the exit one, to the loop below */
+    if ( lNumBits > 8 )
+    {
+        uiFastBytes = (unsigned int)( ( lNumBits - 1 ) >> 3 );
+        xsvfShiftBytesFast( pucTdi, pucTdo, uiFastBytes );
+        pucTdi      -= uiFastBytes;
+        if ( pucTdo )
+        {
+            pucTdo  -= uiFastBytes;
+        }
+        lNumBits    -= (long)uiFastBytes << 3;
+    }
+#endif  /* XSVF_SUPPORT_FAST_SHIFT */
+
     while ( lNumBits )
     {
         /* Process on a byte-basis */
@@ -1015,7 +1249,7 @@ int xsvfDoXSIR( SXsvfInfo* pXsvfInfo )
     XSVFDBG_PRINTF1( 3, "   XSIR length = %d\n",
                      ((unsigned int)ucShiftIrBits) );
 
-    if ( sShiftIrBytes > MAX_LEN )
+    if ( sShiftIrBytes > pXsvfInfo->sLenValBytes )
     {
         iErrorCode  = XSVF_ERROR_DATAOVERFLOW;
     }
@@ -1060,7 +1294,7 @@ int xsvfDoXSIR2( SXsvfInfo* pXsvfInfo )
     sShiftIrBytes   = xsvfGetAsNumBytes( lShiftIrBits );
     XSVFDBG_PRINTF1( 3, "   XSIR2 length = %d\n", lShiftIrBits);
 
-    if ( sShiftIrBytes > MAX_LEN )
+    if ( sShiftIrBytes > pXsvfInfo->sLenValBytes )
     {
         iErrorCode  = XSVF_ERROR_DATAOVERFLOW;
     }
@@ -1157,7 +1391,7 @@ int xsvfDoXSDRSIZE( SXsvfInfo* pXsvfInfo )
     pXsvfInfo->lShiftLengthBits = value( &(pXsvfInfo->lvTdi) );
     pXsvfInfo->sShiftLengthBytes= xsvfGetAsNumBytes( pXsvfInfo->lShiftLengthBits );
     XSVFDBG_PRINTF1( 3, "   XSDRSIZE = %ld\n", pXsvfInfo->lShiftLengthBits );
-    if ( pXsvfInfo->sShiftLengthBytes > MAX_LEN )
+    if ( pXsvfInfo->sShiftLengthBytes > pXsvfInfo->sLenValBytes )
     {
         iErrorCode  = XSVF_ERROR_DATAOVERFLOW;
         pXsvfInfo->iErrorCode   = iErrorCode;
@@ -29,7 +29,7 @@
 #define XSVF_ERROR_MAXRETRIES   3   /* TDO mismatch after max retries */
 #define XSVF_ERROR_ILLEGALCMD   4
 #define XSVF_ERROR_ILLEGALSTATE 5
-#define XSVF_ERROR_DATAOVERFLOW 6   /* Data > lenVal MAX_LEN buffer size*/
+#define XSVF_ERROR_DATAOVERFLOW 6   /* Data > lenVal buffer size */
 /* Insert new errors here */
 #define XSVF_ERROR_LAST         7
 
@@ -13,46 +13,249 @@
 
 #include "ports.h"
 #include "../jtag.h"
-#define MAX_BUFFER 4096
-static unsigned char buf[MAX_BUFFER]; //buffer to hold incoming bytes
+
+// The XSVF stream comes in chunks: we send 0xFF, the host answers with a
+// 16-bit byte count (MSB first) and that many bytes, a zero count marks the
+// end of the file. Two chunk buffers are used so the next chunk is already
+// on its way while xsvfRun() works on the current one.
+#define XSVF_CHUNK_HEADER 2
+
+static unsigned char buf[2][XSVF_CHUNK_HEADER + XSVF_CHUNK_SIZE]; //buffers to hold incoming bytes
 static unsigned int bufBytes=0, bufPointer=0;
+static unsigned char bufCurrent=0; //buffer being read by readByte()
+static unsigned char prefetchPending=0; //a chunk was requested into the other buffer
+static unsigned char streamEnded=0; //the host sent the empty chunk
+#ifdef BUSPIRATEV4
+static unsigned int prefetchReceived=0;
+#endif /* BUSPIRATEV4 */
+
+#ifdef BP_JTAG_XSVF_COMPRESSION
+// A compressed stream (see scripts/BPXSVFPlayer/xsvfz.py) starts with the
+// "XSVZ" magic, 'X' is not a valid XSVF command so plain files are told
+// apart by their first byte. What follows is a sequence of tokens:
+//
+//   0x00-0x7F  n+1 literal bytes follow
+//   0x80-0xBF  one byte follows, repeated (n & 0x3F)+3 times
+//   0xC0-0xFF  one byte d follows, copy (n & 0x3F)+3 bytes starting d+1
+//              bytes back in the decoded stream
+//
+// The chunk framing underneath is unchanged, tokens may span chunks.
+#define XSVZ_MAGIC "XSVZ"
+#define XSVZ_MAGIC_LENGTH 4
+#define XSVZ_LITERAL_LIMIT 0x80
+#define XSVZ_REPEAT_LIMIT 0xC0
+#define XSVZ_COUNT_MASK 0x3F
+#define XSVZ_MINIMUM_MATCH 3
+
+typedef enum {
+        XSVZ_STATE_UNKNOWN = 0, //nothing read yet
+        XSVZ_STATE_PLAIN, //uncompressed XSVF
+        XSVZ_STATE_COMPRESSED //token stream
+} xsvz_state_t;
+
+static xsvz_state_t codecState=XSVZ_STATE_UNKNOWN;
+static unsigned char codecToken; //token being expanded
+static unsigned char codecCount; //bytes left in the token
+static unsigned char codecValue; //repeated byte or back reference distance
+static unsigned char history[256]; //last decoded bytes, for back references
+static unsigned char historyPointer;
+#endif /* BP_JTAG_XSVF_COMPRESSION */
+
+static void prefetchStart(unsigned char index);
+static unsigned char prefetchDone(unsigned char index);
+static void prefetchWait(unsigned char index);
+static void readChunkByte(unsigned char *data);
 
 void xsvf_setup(void){
         bufBytes=0;
+        bufCurrent=0;
+        prefetchPending=0;
+        streamEnded=0;
+#ifdef BP_JTAG_XSVF_COMPRESSION
+        codecState=XSVZ_STATE_UNKNOWN;
+        codecCount=0;
+        historyPointer=0;
+#endif /* BP_JTAG_XSVF_COMPRESSION */
         JTAGTDI_TRIS=0;
         JTAGTCK_TRIS=0;
         JTAGTD0_TRIS=1;
         JTAGTMS_TRIS=0;
 }
 
+void xsvf_finish(void){
+        // Swallow a chunk still on its way, it must not end up being parsed
+        // as JTAG menu commands.
+        if(prefetchPending){
+                prefetchWait(bufCurrent^1);
+                prefetchPending=0;
+        }
+}
+
 void setPort(short p,short val){
     if (p==TMS) {JTAGTMS = (unsigned char) val;}//  bpDelayUS(10);}
     if (p==TDI) {JTAGTDI = (unsigned char) val;}//  bpDelayUS(10);}
     if (p==TCK) {JTAGTCK = (unsigned char) val;}//  bpDelayUS(50);}
 }
 
-void readByte(unsigned char *data){
-        unsigned int i;
-        unsigned char bh, bl;
+static unsigned int chunkLength(unsigned char index){
+        unsigned int length;
+
+        length=(buf[index][0]<<8)|buf[index][1];
+        return (length > XSVF_CHUNK_SIZE) ? XSVF_CHUNK_SIZE : length;
+}
+
+void prefetchStart(unsigned char index){
+#ifdef BUSPIRATEV3
+        // The RX interrupt fills the buffer from here on, see _U1RXInterrupt.
+        user_serial_start_block_reception(buf[index],
+                XSVF_CHUNK_HEADER + XSVF_CHUNK_SIZE);
+#else
+        prefetchReceived=0;
+#endif /* BUSPIRATEV3 */
+        user_serial_transmit_character(0xff);
+}
+
+#ifdef BUSPIRATEV4
+// Moves whatever the host already sent into the buffer, without waiting.
+static void prefetchPoll(unsigned char index){
+        unsigned int wanted;
+        const uint8_t *data;
+        size_t length;
+
+        while(user_serial_ready_to_read()){
+                wanted=XSVF_CHUNK_HEADER;
+                if(prefetchReceived>=XSVF_CHUNK_HEADER){
+                        wanted+=chunkLength(index);
+                }
+                if(prefetchReceived>=wanted){
+                        return;
+                }
+                data=user_serial_borrow_input(wanted-prefetchReceived, &length);
+                memcpy(&buf[index][prefetchReceived], data, length);
+                prefetchReceived+=length;
+        }
+}
+#endif /* BUSPIRATEV4 */
+
+unsigned char prefetchDone(unsigned char index){
+        unsigned int received;
+
+#ifdef BUSPIRATEV3
+        received=UART1RXRecvd;
+#else
+        prefetchPoll(index);
+        received=prefetchReceived;
+#endif /* BUSPIRATEV3 */
+        if(received<XSVF_CHUNK_HEADER){
+                return 0;
+        }
+        return received >= (XSVF_CHUNK_HEADER + chunkLength(index));
+}
 
+void prefetchWait(unsigned char index){
+        while(!prefetchDone(index)){
+        }
+#ifdef BUSPIRATEV3
+        // A short chunk leaves the block transfer running.
+        user_serial_stop_block_reception();
+#endif /* BUSPIRATEV3 */
+}
+
+void readChunkByte(unsigned char *data){
         if(bufBytes==0){
-                user_serial_transmit_character(0xff);
-       //--- while(U1STAbits.URXDA == 0);  //--- dont use it as already in UART1RX => dead lock
-                bh=user_serial_read_byte();//get up to 255 bytes each time
-                bl=user_serial_read_byte();//get up to 255 bytes each time
-                bufBytes=(bh<<8)|bl;
-                for(i=0; i<bufBytes; i++){
-           //---     while(U1STAbits.URXDA == 0); //--- dont use it otherwise dead lock
-                        buf[i]=user_serial_read_byte();
+                if(streamEnded){
+                        // Out of data, 0x00 is XCOMPLETE and ends the player.
+                        (*data)=0;
+                        return;
+                }
+                if(!prefetchPending){
+                        prefetchStart(bufCurrent^1);
                 }
-                bufPointer=0;
+                prefetchWait(bufCurrent^1);
+                prefetchPending=0;
+
+                bufCurrent^=1;
+                bufBytes=chunkLength(bufCurrent);
+                bufPointer=XSVF_CHUNK_HEADER;
+                if(bufBytes==0){
+                        streamEnded=1;
+                        (*data)=0;
+                        return;
+                }
+
+                // Ask for the next chunk right away.
+                prefetchStart(bufCurrent^1);
+                prefetchPending=1;
         }
+#ifdef BUSPIRATEV4
+        else if(prefetchPending){
+                prefetchPoll(bufCurrent^1);
+        }
+#endif /* BUSPIRATEV4 */
 
-        (*data)=buf[bufPointer];
+        (*data)=buf[bufCurrent][bufPointer];
         bufPointer++;
         bufBytes--;
 }
 
+#ifdef BP_JTAG_XSVF_COMPRESSION
+void readByte(unsigned char *data){
+        unsigned char i;
+
+        if(codecState==XSVZ_STATE_UNKNOWN){
+                codecState=XSVZ_STATE_PLAIN;
+                readChunkByte(data);
+                if((*data)!=XSVZ_MAGIC[0]){
+                        return;
+                }
+                for(i=1;i<XSVZ_MAGIC_LENGTH;i++){
+                        readChunkByte(data);
+                        if((*data)!=XSVZ_MAGIC[i]){
+                                // Hand the bogus 'X' back as an illegal command.
+                                (*data)=XSVZ_MAGIC[0];
+                                return;
+                        }
+                }
+                codecState=XSVZ_STATE_COMPRESSED;
+        }
+
+        if(codecState==XSVZ_STATE_PLAIN){
+                readChunkByte(data);
+                return;
+        }
+
+        if(codecCount==0){
+                readChunkByte(&codecToken);
+                if(codecToken<XSVZ_LITERAL_LIMIT){
+                        codecCount=codecToken+1;
+                }else{
+                        codecCount=(codecToken&XSVZ_COUNT_MASK)+XSVZ_MINIMUM_MATCH;
+                        readChunkByte(&codecValue);
+                }
+                if(streamEnded){
+                        // Truncated or finished, end the player.
+                        codecCount=0;
+                        (*data)=0;
+                        return;
+                }
+        }
+
+        if(codecToken<XSVZ_LITERAL_LIMIT){
+                readChunkByte(data);
+        }else if(codecToken<XSVZ_REPEAT_LIMIT){
+                (*data)=codecValue;
+        }else{
+                (*data)=history[(unsigned char)(historyPointer-codecValue-1)];
+        }
+        codecCount--;
+        history[historyPointer++]=(*data);
+}
+#else
+void readByte(unsigned char *data){
+        readChunkByte(data);
+}
+#endif /* BP_JTAG_XSVF_COMPRESSION */
+
 unsigned char readTDOBit(){return JTAGTDO;}
 
 void waitTime(long microsec){
@@ -10,15 +10,28 @@
 #define TMS (short) 1
 #define TDI (short) 2
 
+//the chunk buffers, the host may send up to XSVF_CHUNK_SIZE bytes per request
+#define XSVF_BUFFER_SIZE 4096
+#define XSVF_CHUNK_SIZE (XSVF_BUFFER_SIZE / 2)
+
 //setup the read buffer before starting
 void xsvf_setup(void);
 
+//drain the read buffers once the player is done
+void xsvf_finish(void);
+
 //setup the specified output pin p with val
 extern void setPort(short p, short val);
 
 //read TDO pin
 extern unsigned char readTDOBit();
 
+//shift whole bytes of a lenVal through TDI/TDO, see ports_asm.s
+extern void xsvfShiftBytesFast(const unsigned char *tdi, unsigned char *tdo,
+                               unsigned int bytes);
+//clock a TMS sequence out, LSB first, see ports_asm.s
+extern void xsvfTmsSequenceFast(unsigned int tms, unsigned int clocks);
+
 //read byte of xsvf
 extern void readByte(unsigned char *data);
 
@@ -0,0 +1,174 @@
+;
+; ports_asm.s
+;
+; Optimized whole byte shift loop for the XSVF player
+;
+; Written and maintained by the Bus Pirate project.
+;
+; Published in the public domain.
+; For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+;
+
+.ifdef __PIC24FJ64GA002__
+	.equ __24FJ64GA002, 1
+	.include "p24FJ64GA002.inc"
+
+;  Bus pirate v3 hardware
+.equ IOPOR, PORTB
+.equ IOLAT, LATB
+
+.equ JTAG_TDI_BIT, #0x0009	; MOSI, RB9
+.equ JTAG_TCK_BIT, #0x0008	; CLK,  RB8
+.equ JTAG_TDO_BIT, #0x0007	; MISO, RB7
+.equ JTAG_TMS_BIT, #0x0006	; CS,   RB6
+.endif ; __PIC24FJ64GA002__
+
+.ifdef __PIC24FJ256GB106__
+	.equ __24FJ256GB106, 1
+	.include "p24FJ256GB106.inc"
+
+;  Bus pirate v4 hardware
+.equ IOPOR, PORTD
+.equ IOLAT, LATD
+
+.equ JTAG_TDI_BIT, #0x0001	; MOSI, RD1
+.equ JTAG_TCK_BIT, #0x0002	; CLK,  RD2
+.equ JTAG_TDO_BIT, #0x0003	; MISO, RD3
+.equ JTAG_TMS_BIT, #0x0004	; CS,   RD4
+.endif ; __PIC24FJ256GB106__
+
+;
+; void xsvfShiftBytesFast(const unsigned char *tdi, unsigned char *tdo,
+;                         unsigned int bytes)
+;
+; Shifts bytes * 8 bits through the scan chain, with the same edge order as
+; xsvfShiftOnly(): set TDI, TCK low, sample TDO, TCK high.  Bytes are taken
+; backwards from the lenVal layout (val[len-1] goes out first), each byte LSB
+; first.  TMS is left untouched.
+;
+; Parameters:
+;  w0 : one past the first TDI byte to shift out
+;  w1 : one past where the first TDO byte goes, or NULL not to capture
+;  w2 : # of bytes
+;
+; Register usage:
+;
+;  w3 : TDI byte being shifted out
+;  w4 : TDO byte being assembled
+;  w5 : bit loop counter
+;  w6 : constant IOLAT
+;  w7 : constant IOPOR
+;  w8 : constant JTAG_TDI_BIT
+;
+
+	.text
+	.global _xsvfShiftBytesFast
+
+_xsvfShiftBytesFast:
+
+		; Nothing to do ?
+		cp0.w	w2			; if (bytes == 0)
+		bra	z, __done		;   return;
+
+		; Save registers
+		push.w	w8			; save w8
+
+		; Constants
+		mov.w	#IOLAT, w6		; w6 = &IOLAT;
+		mov.w	#IOPOR, w7		; w7 = &IOPOR;
+		mov.w	#JTAG_TDI_BIT, w8	; w8 = JTAG_TDI_BIT;
+
+		; Byte loop
+__loop_byte:					; do {
+		ze	[--w0], w3		;   w3 = *(--tdi);
+		mov.w	#8, w5			;   w5 = 8;
+
+		;   Bit loop
+__loop_bit:					;   do {
+
+		;     Set the new TDI value
+		lsr.w	w3, w3			;     C = w3 & 1; w3 >>= 1;
+		bsw.c	[w6], w8		;     IOLAT.TDI = C;
+
+		;     Set TCK low
+		bclr.w	[w6], #JTAG_TCK_BIT	;     IOLAT &= ~TCK;
+		nop				;     /* TDO changes on this edge, */
+		nop				;     /* let it through the input  */
+						;     /* synchronizer first.       */
+
+		;     Save the TDO value
+		btst.c	[w7], #JTAG_TDO_BIT	;     C = IOPOR.TDO;
+		rrc.b	w4, w4			;     w4 = (w4 >> 1) | (C << 7);
+
+		;     Set TCK high
+		bset.w	[w6], #JTAG_TCK_BIT	;     IOLAT |= TCK;
+
+		dec.w	w5, w5			;   } while (--w5 > 0);
+		bra	nz, __loop_bit
+
+		;   Save the TDO byte value
+		cp0.w	w1			;   if (tdo != NULL)
+		bra	z, 1f
+		mov.b	w4, [--w1]		;     *(--tdo) = w4;
+1:
+		dec.w	w2, w2			; } while (--bytes > 0);
+		bra	nz, __loop_byte
+
+		; Restore registers
+		pop.w	w8			; restore w8
+
+__done:
+		return
+;
+; void xsvfTmsSequenceFast(unsigned int tms, unsigned int clocks)
+;
+; Clocks a TMS sequence into the TAP, with the same edge order as
+; xsvfTmsTransition(): set TMS, TCK low, TCK high.  TMS values are taken
+; LSB first.  TDI is left untouched.
+;
+; Parameters:
+;  w0 : TMS values
+;  w1 : # of clocks, 16 at most
+;
+; Register usage:
+;
+;  w2 : constant IOLAT
+;  w3 : constant JTAG_TMS_BIT
+;
+
+	.global _xsvfTmsSequenceFast
+
+_xsvfTmsSequenceFast:
+
+		; Nothing to do ?
+		cp0.w	w1			; if (clocks == 0)
+		bra	z, __tms_done		;   return;
+
+		; Constants
+		mov.w	#IOLAT, w2		; w2 = &IOLAT;
+		mov.w	#JTAG_TMS_BIT, w3	; w3 = JTAG_TMS_BIT;
+
+		; Clock loop
+__loop_tms:					; do {
+
+		;   Set the new TMS value
+		lsr.w	w0, w0			;   C = w0 & 1; w0 >>= 1;
+		bsw.c	[w2], w3		;   IOLAT.TMS = C;
+
+		;   Set TCK low
+		bclr.w	[w2], #JTAG_TCK_BIT	;   IOLAT &= ~TCK;
+		nop				;   /* Same TCK low time as */
+		nop				;   /* xsvfShiftBytesFast.  */
+
+		;   Set TCK high
+		bset.w	[w2], #JTAG_TCK_BIT	;   IOLAT |= TCK;
+
+		dec.w	w1, w1			; } while (--clocks > 0);
+		bra	nz, __loop_tms
+
+__tms_done:
+		return
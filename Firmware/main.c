@@ -19,9 +19,13 @@
 
 #include "base.h"
 #include "basic.h"
+#include "buffer_arena.h"
 #include "core.h"
+#include "memory_usage.h"
 #include "proc_menu.h"
+#include "profiling.h"
 #include "selftest.h"
+#include "timebase.h"
 
 #ifdef BUSPIRATEV4
 
@@ -30,6 +34,11 @@
 void usb_suspend(void);
 extern volatile uint8_t usb_device_state;
 
+/**
+ * Start of frame handler, flushing pending IN data on every USB pipe.
+ */
+static void usb_start_of_frame(void);
+
 #endif /* BUSPIRATEV4 */
 
 /**
@@ -37,17 +46,11 @@ extern volatile uint8_t usb_device_state;
  */
 static void initialize_board(void);
 
-/**
- * Internal terminal buffer area.
- */
-static uint8_t bp_buffer[BP_TERMINAL_BUFFER_SIZE]
-    __attribute__((section(".bss.end")));
-
 /**
  * Global configuration data holder.
  */
-bus_pirate_configuration_t bus_pirate_configuration = {.terminal_input =
-                                                           bp_buffer};
+bus_pirate_configuration_t bus_pirate_configuration = {
+    .terminal_input = bp_buffer_arena_memory};
 
 /**
  * Mode-specific configuration data holder.
@@ -72,15 +75,19 @@ static uint32_t __attribute__((address(0x27FC), persistent)) firmware_signature;
 int main(void) {
   firmware_signature = FIRMWARE_SIGNATURE;
 
+#ifdef BP_ENABLE_MEMORY_USAGE
+  bp_memory_usage_paint_stack();
+#endif /* BP_ENABLE_MEMORY_USAGE */
+
   initialize_board();
   bp_enable_usb_led();
 
-#if defined(BUSPIRATEV4)
+#if defined(BUSPIRATEV4) && !defined(USB_INTERRUPTS)
+  /* Keep answering the host while modes wait on something else. */
+  bp_background_task_register(usb_handler);
+#endif /* BUSPIRATEV4 && !USB_INTERRUPTS */
 
-#ifdef USB_INTERRUPTS
-  EnableUsbPerifInterrupts(USB_TRN | USB_SOF | USB_UERR | USB_URST);
-  EnableUsbGlobalInterrupt();
-#endif /* USB_INTERRUPTS */
+#if defined(BUSPIRATEV4)
 
   /* Wait until the USB interface is configured. */
 
@@ -89,8 +96,11 @@ int main(void) {
     usb_handler();
 #endif /* !USB_INTERRUPTS */
   } while (usb_device_state < CONFIGURED_STATE);
-  
-  usb_register_sof_handler(CDCFlushOnTimeout);
+
+#ifdef BP_ENABLE_USB_TIMEBASE
+  bp_timebase_initialize();
+#endif /* BP_ENABLE_USB_TIMEBASE */
+  usb_register_sof_handler(usb_start_of_frame);
 
 #endif /* BUSPIRATEV4 */
 
@@ -156,10 +166,31 @@ void initialize_board(void) {
   /* Disable secondary oscillator. */
   OSCCONbits.SOSCEN = OFF;
 
-  /* Wait a bit. */
-  while (delay--) {
+  /* Wait for the PLL to lock, the USB module runs off it. */
+  while (!OSCCONbits.LOCK && delay--) {
   }
 
+#if defined(BUSPIRATEV4)
+
+  /*
+   * Start the USB-based serial port first, so the host enumerates the board
+   * while the rest of the initialization runs.
+   */
+
+  initCDC();
+  usb_init(cdc_device_descriptor, cdc_config_descriptor, cdc_str_descs,
+           USB_NUM_STRINGS);
+  usb_start();
+
+#ifdef USB_INTERRUPTS
+  IPC21bits.USB1IP = USB_INTERRUPT_PRIORITY;
+  ClearGlobalUsbInterruptFlag();
+  EnableUsbPerifInterrupts(USB_TRN | USB_SOF | USB_UERR | USB_URST);
+  EnableUsbGlobalInterrupt();
+#endif /* USB_INTERRUPTS */
+
+#endif /* BUSPIRATEV4 */
+
 /* Set up the UART port pins. */
 
 #ifdef BUSPIRATEV3
@@ -176,21 +207,15 @@ void initialize_board(void) {
   /* Start from a known, clear state. */
   bp_reset_board_state();
 
+#ifdef BP_ENABLE_PROFILING
+  bp_profiling_reset();
+#endif /* BP_ENABLE_PROFILING */
+
 #ifdef BUSPIRATEV3
   /* Initialize the internal UART port. */
   user_serial_initialise();
 #endif /* BUSPIRATEV3 */
 
-#if defined(BUSPIRATEV4)
-
-  /* Initialize the USB-based serial port. */
-
-  initCDC();
-  usb_init(cdc_device_descriptor, cdc_config_descriptor, cdc_str_descs,
-           USB_NUM_STRINGS);
-  usb_start();
-#endif /* BUSPIRATEV4 */
-
 #ifdef BUSPIRATEV3
   /* Turn pull-ups ON. */
   CNPU1 |= _CNPU1_CN6PUE_MASK | _CNPU1_CN7PUE_MASK;
@@ -234,17 +259,38 @@ void initialize_board(void) {
 
 void usb_suspend(void) {}
 
+void usb_start_of_frame(void) {
+#ifdef BP_ENABLE_USB_TIMEBASE
+  bp_timebase_start_of_frame();
+#endif /* BP_ENABLE_USB_TIMEBASE */
+  CDCFlushOnTimeout();
+  cdc_serial_state_on_timeout();
+#ifdef BP_USB_VENDOR_INTERFACE
+  vendor_flush_on_timeout();
+#endif /* BP_USB_VENDOR_INTERFACE */
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+  isochronous_start_of_frame();
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
+}
+
+#ifdef USB_INTERRUPTS
+
 #pragma interrupt _USB1Interrupt
 
 void __attribute__((interrupt, no_auto_psv)) _USB1Interrupt() {
 
+  /*
+   * Clear the USB Interrupt flag first, so events raised while they are being
+   * handled (more transactions queued in U1STAT) trigger another interrupt.
+   */
+  IFS5bits.USB1IF = OFF;
+
   /* Handle USB operation. */
   usb_handler();
-
-  /* Clear the USB Interrupt flag. */
-  IFS5bits.USB1IF = OFF;
 }
 
 #pragma code
 
+#endif /* USB_INTERRUPTS */
+
 #endif /* BUSPIRATEV4 */
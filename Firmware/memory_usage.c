@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "memory_usage.h"
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+
+#include "base.h"
+#include "buffer_arena.h"
+#include "core.h"
+
+/**
+ * What unused stack words hold.
+ */
+#define MEMORY_USAGE_STACK_PAINT 0xA55A
+
+/**
+ * Words above the stack pointer left unpainted, so nothing pushed while the
+ * pattern is being written gets overwritten.
+ */
+#define MEMORY_USAGE_STACK_GUARD 16
+
+extern const bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT];
+
+/**
+ * Start of the stack, set by the linker script.
+ */
+extern uint16_t _SP_init;
+
+/**
+ * Length of the data memory region, set by the linker script.  Only its
+ * address means anything.
+ */
+extern uint8_t _DATA_LENGTH;
+
+/**
+ * Sends a 16 bits value on the binary I/O channel, MSB first.
+ *
+ * @param[in] value the value to send.
+ */
+static void memory_usage_send_word(const uint16_t value);
+
+void bp_memory_usage_paint_stack(void) {
+  volatile uint16_t *word;
+  volatile uint16_t *limit;
+
+  word = (volatile uint16_t *)WREG15 + MEMORY_USAGE_STACK_GUARD;
+  limit = (volatile uint16_t *)SPLIM;
+  while (word <= limit) {
+    *word++ = MEMORY_USAGE_STACK_PAINT;
+  }
+}
+
+uint16_t bp_memory_usage_stack_size(void) {
+  return (uint16_t)(SPLIM + sizeof(uint16_t) - (uint16_t)&_SP_init);
+}
+
+uint16_t bp_memory_usage_stack_high_water(void) {
+  const volatile uint16_t *word;
+
+  /* From the limit down, the stack only ever grows upwards. */
+  word = (const volatile uint16_t *)SPLIM;
+  while ((word > (const volatile uint16_t *)&_SP_init) &&
+         (*word == MEMORY_USAGE_STACK_PAINT)) {
+    word--;
+  }
+
+  return (uint16_t)((uint16_t)(word + 1) - (uint16_t)&_SP_init);
+}
+
+uint16_t bp_memory_usage_data_size(void) {
+  return (uint16_t)&_DATA_LENGTH;
+}
+
+void memory_usage_send_word(const uint16_t value) {
+  user_serial_transmit_character(HI8(value));
+  user_serial_transmit_character(LO8(value));
+}
+
+void bp_memory_usage_send(void) {
+  size_t index;
+
+  memory_usage_send_word(bp_memory_usage_stack_size());
+  memory_usage_send_word(bp_memory_usage_stack_high_water());
+  memory_usage_send_word(bp_memory_usage_data_size());
+  memory_usage_send_word(BP_TERMINAL_BUFFER_SIZE);
+  memory_usage_send_word(bp_buffer_arena_reserved());
+  memory_usage_send_word(bp_buffer_arena_largest_free());
+  user_serial_transmit_character(ENABLED_PROTOCOLS_COUNT);
+  for (index = 0; index < ENABLED_PROTOCOLS_COUNT; index++) {
+    memory_usage_send_word(bp_buffer_arena_peak(index));
+  }
+}
+
+void bp_memory_usage_print(void) {
+  size_t index;
+
+  MSG_MEMORY_USAGE_STACK;
+  bp_write_dec_word(bp_memory_usage_stack_high_water());
+  user_serial_transmit_character('/');
+  bp_write_dec_word(bp_memory_usage_stack_size());
+  MSG_MEMORY_USAGE_BYTES;
+
+  MSG_MEMORY_USAGE_ARENA_PEAKS;
+  for (index = 0; index < ENABLED_PROTOCOLS_COUNT; index++) {
+    bpSP;
+    bp_write_string(enabled_protocols[index].name);
+    user_serial_transmit_character(':');
+    bp_write_dec_word(bp_buffer_arena_peak(index));
+  }
+  bpBR;
+}
+
+#endif /* BP_ENABLE_MEMORY_USAGE */
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file memory_usage.h
+ *
+ * @brief Stack and buffer arena high-water marks, to size buffers against the
+ * memory really left rather than by guesswork.
+ *
+ * The unused part of the stack is painted with a known pattern at startup,
+ * the deepest word no longer holding it tells how far the stack ever grew.
+ * The buffer arena keeps the most it ever had reserved under each mode.
+ */
+
+#ifndef BP_MEMORY_USAGE_H
+#define BP_MEMORY_USAGE_H
+
+#include <stdint.h>
+
+#include "configuration.h"
+
+#ifdef BP_ENABLE_MEMORY_USAGE
+
+/**
+ * Fills the stack above the current stack pointer with the paint pattern.
+ *
+ * Must be called once, as early as possible and from a shallow frame, since
+ * whatever is below the stack pointer at that time counts as used.
+ */
+void bp_memory_usage_paint_stack(void);
+
+/**
+ * Size of the stack, from its base to the stack pointer limit.
+ *
+ * @return the stack size in bytes.
+ */
+uint16_t bp_memory_usage_stack_size(void);
+
+/**
+ * Deepest the stack ever went since it was painted.
+ *
+ * @return how many bytes from the stack base have been written to.
+ */
+uint16_t bp_memory_usage_stack_high_water(void);
+
+/**
+ * Size of the data memory region, as laid out by the linker script rather
+ * than by BP_DATA_MEMORY_SIZE.
+ *
+ * @return the data memory size in bytes.
+ */
+uint16_t bp_memory_usage_data_size(void);
+
+/**
+ * Sends the stack and buffer arena figures on the binary I/O channel, every
+ * value two bytes MSB first: stack size, stack high-water mark, data memory
+ * size, arena size, bytes currently reserved and largest free run.  Those are followed by the
+ * protocol count and the arena peak of every protocol, in the order of
+ * enabled_protocols.
+ */
+void bp_memory_usage_send(void);
+
+/**
+ * Prints the stack and buffer arena figures on the terminal.
+ */
+void bp_memory_usage_print(void);
+
+#endif /* BP_ENABLE_MEMORY_USAGE */
+
+#endif /* !BP_MEMORY_USAGE_H */
@@ -19,6 +19,94 @@
 
 #include "base.h"
 
+#ifdef BP_MESSAGES_COMPRESSED
+
+/**
+ * Message bytes from this value up are dictionary codes, the ones below it are
+ * plain characters.
+ */
+#define MESSAGE_DICTIONARY_FIRST_CODE 0x80
+
+/**
+ * How many decoded characters are collected before being sent out.
+ */
+#define MESSAGE_OUTPUT_CHUNK_SIZE 32
+
+/*
+ * Messages are byte pair encoded by tools/packstrings/packstrings.py: each
+ * dictionary entry is a program word holding two symbols, either plain
+ * characters or other dictionary codes, in its lower 16 bits.
+ */
+
+void bp_message_write_buffer(unsigned long strptr) {
+  uint8_t tblpag_prev = TBLPAG;
+  uint8_t pending[BP_MESSAGE_DICTIONARY_DEPTH + 1];
+  uint8_t output[MESSAGE_OUTPUT_CHUNK_SIZE];
+  unsigned long entry;
+  size_t depth;
+  size_t length;
+  uint16_t pair;
+  uint8_t index = 0;
+  uint8_t symbol = '\0';
+
+  length = 0;
+
+  for (;;) {
+    TBLPAG = (strptr >> 16) & 0xFF;
+    switch (index) {
+    case 0:
+      symbol = LO8(__builtin_tblrdl(strptr));
+      index++;
+      break;
+
+    case 1:
+      symbol = HI8(__builtin_tblrdl(strptr));
+      index++;
+      break;
+
+    case 2:
+      symbol = LO8(__builtin_tblrdh(strptr));
+      strptr += 2;
+      index = 0;
+      break;
+    }
+
+    if (symbol == '\0') {
+      break;
+    }
+
+    /* Expand the symbol depth first, the second half of a pair waits. */
+    pending[0] = symbol;
+    depth = 1;
+    while (depth > 0) {
+      symbol = pending[--depth];
+      if (symbol < MESSAGE_DICTIONARY_FIRST_CODE) {
+        output[length++] = symbol;
+        if (length == sizeof(output)) {
+          user_serial_write_buffer(output, length);
+          length = 0;
+        }
+        continue;
+      }
+
+      entry = __builtin_tbladdress(bp_message_dictionary) +
+              ((symbol - MESSAGE_DICTIONARY_FIRST_CODE) << 1);
+      TBLPAG = (entry >> 16) & 0xFF;
+      pair = __builtin_tblrdl(entry);
+      pending[depth++] = HI8(pair);
+      pending[depth++] = LO8(pair);
+    }
+  }
+
+  if (length > 0) {
+    user_serial_write_buffer(output, length);
+  }
+
+  TBLPAG = tblpag_prev;
+}
+
+#else
+
 void bp_message_write_buffer(unsigned long strptr) {
   uint8_t tblpag_prev = TBLPAG;
   uint8_t index = 0;
@@ -52,6 +140,8 @@ void bp_message_write_buffer(unsigned long strptr) {
   TBLPAG = tblpag_prev;
 }
 
+#endif /* BP_MESSAGES_COMPRESSED */
+
 void bp_message_write_line(unsigned long strptr) {
   bp_message_write_buffer(strptr);
   bpBR;
@@ -2,169 +2,169 @@
 	.section .text.BPMSG1022, code
 	.global _BPMSG1022_str
 _BPMSG1022_str:
-	.pasciz "DS18S20 High Prec Dig Therm"
+	.pasciz "DS18S20 \357gh P\214c Di\264Th\207m"
 
 	; BPMSG1023
 	.section .text.BPMSG1023, code
 	.global _BPMSG1023_str
 _BPMSG1023_str:
-	.pasciz "DS18B20 Prog Res Dig Therm"
+	.pasciz "DS18B20 Pro\264\276\213Di\264Th\207m"
 
 	; BPMSG1024
 	.section .text.BPMSG1024, code
 	.global _BPMSG1024_str
 _BPMSG1024_str:
-	.pasciz "DS1822 Econo Dig Therm"
+	.pasciz "DS1822 Ec\222\211Di\264Th\207m"
 
 	; BPMSG1025
 	.section .text.BPMSG1025, code
 	.global _BPMSG1025_str
 _BPMSG1025_str:
-	.pasciz "DS2404 EconoRAM time Chip"
+	.pasciz "DS2404 Ec\222oRAM \246m\205C\256p"
 
 	; BPMSG1026
 	.section .text.BPMSG1026, code
 	.global _BPMSG1026_str
 _BPMSG1026_str:
-	.pasciz "DS2431 1K EEPROM"
+	.pasciz "DS2431 1K EEP\277"
 
 	; BPMSG1027
 	.section .text.BPMSG1027, code
 	.global _BPMSG1027_str
 _BPMSG1027_str:
-	.pasciz "Unknown device"
+	.pasciz "Unk\347wn \226v\332e"
 
 	; BPMSG1028
 	.section .text.BPMSG1028, code
 	.global _BPMSG1028_str
 _BPMSG1028_str:
-	.pasciz "PWM disabled"
+	.pasciz "PWM disabl\304"
 
 	; BPMSG1029
 	.section .text.BPMSG1029, code
 	.global _BPMSG1029_str
 _BPMSG1029_str:
-	.pasciz "1KHz-4,000KHz PWM"
+	.pasciz "1\275-4,\2350\275 PWM"
 
 	; BPMSG1030
 	.section .text.BPMSG1030, code
 	.global _BPMSG1030_str
 _BPMSG1030_str:
-	.pasciz "Frequency in KHz "
+	.pasciz "F\214qu\221c\237\334\275 "
 
 	; BPMSG1033
 	.section .text.BPMSG1033, code
 	.global _BPMSG1033_str
 _BPMSG1033_str:
-	.pasciz "Duty cycle in % "
+	.pasciz "D\305\237cyc\245\334% "
 
 	; BPMSG1034
 	.section .text.BPMSG1034, code
 	.global _BPMSG1034_str
 _BPMSG1034_str:
-	.pasciz "PWM active"
+	.pasciz "PWM \336e"
 
 	; BPMSG1037
 	.section .text.BPMSG1037, code
 	.global _BPMSG1037_str
 _BPMSG1037_str:
-	.pasciz "ERROR: PWM active, g to disable"
+	.pasciz "\313\241R\224PWM \336e\223\264\265disab\367"
 
 	; BPMSG1038
 	.section .text.BPMSG1038, code
 	.global _BPMSG1038_str
 _BPMSG1038_str:
-	.pasciz "AUX Frequency: "
+	.pasciz "\337 F\214qu\221cy\224"
 
 	; BPMSG1039
 	.section .text.BPMSG1039, code
 	.global _BPMSG1039_str
 _BPMSG1039_str:
-	.pasciz "AUX INPUT/HI-Z"
+	.pasciz "\337 \360\345T/HI-Z"
 
 	; BPMSG1040
 	.section .text.BPMSG1040, code
 	.global _BPMSG1040_str
 _BPMSG1040_str:
-	.pasciz "AUX HIGH"
+	.pasciz "\337 HIGH"
 
 	; BPMSG1041
 	.section .text.BPMSG1041, code
 	.global _BPMSG1041_str
 _BPMSG1041_str:
-	.pasciz "AUX LOW"
+	.pasciz "\337 LOW"
 
 	; BPMSG1047
 	.section .text.BPMSG1047, code
 	.global _BPMSG1047_str
 _BPMSG1047_str:
-	.pasciz "Error("
+	.pasciz "Err\215("
 
 	; BPMSG1048
 	.section .text.BPMSG1048, code
 	.global _BPMSG1048_str
 _BPMSG1048_str:
-	.pasciz ") @line:"
+	.pasciz "\236@l\210e:"
 
 	; BPMSG1049
 	.section .text.BPMSG1049, code
 	.global _BPMSG1049_str
 _BPMSG1049_str:
-	.pasciz " @pgmspace:"
+	.pasciz " @pgm\260\225e:"
 
 	; BPMSG1050
 	.section .text.BPMSG1050, code
 	.global _BPMSG1050_str
 _BPMSG1050_str:
-	.pasciz " bytes."
+	.pasciz " by\227s."
 
 	; BPMSG1051
 	.section .text.BPMSG1051, code
 	.global _BPMSG1051_str
 _BPMSG1051_str:
-	.pasciz "Too long!"
+	.pasciz "To\211l\222g!"
 
 	; BPMSG1052
 	.section .text.BPMSG1052, code
 	.global _BPMSG1052_str
 _BPMSG1052_str:
-	.pasciz "Syntax error"
+	.pasciz "Syntax \207r\215"
 
 	; BPMSG1064
 	.section .text.BPMSG1064, code
 	.global _BPMSG1064_str
 _BPMSG1064_str:
-	.pasciz "I2C mode:\r\n 1. Software\r\n 2. Hardware"
+	.pasciz "\361 \316\226\266Softwa\214\261H\232dwa\214"
 
 	; BPMSG1066
 	.section .text.BPMSG1066, code
 	.global _BPMSG1066_str
 _BPMSG1066_str:
-	.pasciz "WARNING: HARDWARE I2C is broken on this PIC! (REV A3)"
+	.pasciz "W\240N\360G\224H\240DW\240E \361 i\213brok\221 \222 t\256\213PIC!\206\244V A3)"
 
 	; BPMSG1067
 	.section .text.BPMSG1067, code
 	.global _BPMSG1067_str
 _BPMSG1067_str:
-	.pasciz "Set speed:\r\n 1. 100KHz\r\n 2. 400KHz\r\n 3. 1MHz"
+	.pasciz "\322\260e\304\2661\235\275\2614\235\275\2023\2031\344"
 
 	; BPMSG1068
 	.section .text.BPMSG1068, code
 	.global _BPMSG1068_str
 _BPMSG1068_str:
-	.pasciz "I2C (mod spd)=( "
+	.pasciz "\361\206\316\220\260d)=( "
 
 	; BPMSG1069
 	.section .text.BPMSG1069, code
 	.global _BPMSG1069_str
 _BPMSG1069_str:
-	.pasciz " 0.Macro menu\r\n 1.7bit address search\r\n 2.I2C sniffer"
+	.pasciz " \310\377\234.7b\315\254d\214s\213\257\232\346\230.\361 sni\331\207"
 
 	; BPMSG1070
 	.section .text.BPMSG1070, code
 	.global _BPMSG1070_str
 _BPMSG1070_str:
-	.pasciz "Searching I2C address space. Found devices at:"
+	.pasciz "\263\232\346\210\264\361 \254d\214s\213\260\225e\203Foun\220\226v\332e\213at:"
 
 	; BPMSG1084
 	.section .text.BPMSG1084, code
@@ -176,253 +176,253 @@ _BPMSG1084_str:
 	.section .text.BPMSG1085, code
 	.global _BPMSG1085_str
 _BPMSG1085_str:
-	.pasciz "Ready"
+	.pasciz "\276\254y"
 
 	; BPMSG1086
 	.section .text.BPMSG1086, code
 	.global _BPMSG1086_str
 _BPMSG1086_str:
-	.pasciz "a/A/@ controls AUX pin"
+	.pasciz "a/A/@ c\222\372\270\213\337\342\210"
 
 	; BPMSG1087
 	.section .text.BPMSG1087, code
 	.global _BPMSG1087_str
 _BPMSG1087_str:
-	.pasciz "a/A/@ controls CS pin"
+	.pasciz "a/A/@ c\222\372\270\213\312\342\210"
 
 	; BPMSG1088
 	.section .text.BPMSG1088, code
 	.global _BPMSG1088_str
 _BPMSG1088_str:
-	.pasciz "Command not used in this mode"
+	.pasciz "Co\370\233\220\347\204u\257\220\334t\256\213\316\226"
 
 	; BPMSG1089
 	.section .text.BPMSG1089, code
 	.global _BPMSG1089_str
 _BPMSG1089_str:
-	.pasciz "Pull-up resistors OFF"
+	.pasciz "P\252l-u\251\214\350\243\215\213OFF"
 
 	; BPMSG1091
 	.section .text.BPMSG1091, code
 	.global _BPMSG1091_str
 _BPMSG1091_str:
-	.pasciz "Pull-up resistors ON"
+	.pasciz "P\252l-u\251\214\350\243\215\213\364"
 
 	; BPMSG1092
 	.section .text.BPMSG1092, code
 	.global _BPMSG1092_str
 _BPMSG1092_str:
-	.pasciz "Self-test in HiZ mode only"
+	.pasciz "\263lf-\227s\204\334\357Z \316d\205\222ly"
 
 	; BPMSG1093
 	.section .text.BPMSG1093, code
 	.global _BPMSG1093_str
 _BPMSG1093_str:
-	.pasciz "RESET"
+	.pasciz "\244\365T"
 
 	; BPMSG1094
 	.section .text.BPMSG1094, code
 	.global _BPMSG1094_str
 _BPMSG1094_str:
-	.pasciz "BOOTLOADER"
+	.pasciz "BOOTLO\274\313"
 
 	; BPMSG1095
 	.section .text.BPMSG1095, code
 	.global _BPMSG1095_str
 _BPMSG1095_str:
-	.pasciz "AUX INPUT/HI-Z, READ: "
+	.pasciz "\337 \360\345T/HI-Z\223\244\274\224"
 
 	; BPMSG1096
 	.section .text.BPMSG1096, code
 	.global _BPMSG1096_str
 _BPMSG1096_str:
-	.pasciz "POWER SUPPLIES ON"
+	.pasciz "POW\313\300UPPLIES \364"
 
 	; BPMSG1097
 	.section .text.BPMSG1097, code
 	.global _BPMSG1097_str
 _BPMSG1097_str:
-	.pasciz "POWER SUPPLIES OFF"
+	.pasciz "POW\313\300UPPLIES OFF"
 
 	; BPMSG1098
 	.section .text.BPMSG1098, code
 	.global _BPMSG1098_str
 _BPMSG1098_str:
-	.pasciz "DATA STATE: "
+	.pasciz "\356A\300T\253E\224"
 
 	; BPMSG1099
 	.section .text.BPMSG1099, code
 	.global _BPMSG1099_str
 _BPMSG1099_str:
-	.pasciz "DELAY "
+	.pasciz "\355LAY "
 
 	; BPMSG1100
 	.section .text.BPMSG1100, code
 	.global _BPMSG1100_str
 _BPMSG1100_str:
-	.pasciz "us"
+	.pasciz "\351"
 
 	; BPMSG1101
 	.section .text.BPMSG1101, code
 	.global _BPMSG1101_str
 _BPMSG1101_str:
-	.pasciz "WRITE: "
+	.pasciz "WRITE\224"
 
 	; BPMSG1102
 	.section .text.BPMSG1102, code
 	.global _BPMSG1102_str
 _BPMSG1102_str:
-	.pasciz "READ: "
+	.pasciz "\244\274\224"
 
 	; BPMSG1103
 	.section .text.BPMSG1103, code
 	.global _BPMSG1103_str
 _BPMSG1103_str:
-	.pasciz "CLOCK, 1"
+	.pasciz "\311O\354\2231"
 
 	; BPMSG1104
 	.section .text.BPMSG1104, code
 	.global _BPMSG1104_str
 _BPMSG1104_str:
-	.pasciz "CLOCK, 0"
+	.pasciz "\311O\354\2230"
 
 	; BPMSG1105
 	.section .text.BPMSG1105, code
 	.global _BPMSG1105_str
 _BPMSG1105_str:
-	.pasciz "DATA OUTPUT, 1"
+	.pasciz "\356A OUT\345T\2231"
 
 	; BPMSG1106
 	.section .text.BPMSG1106, code
 	.global _BPMSG1106_str
 _BPMSG1106_str:
-	.pasciz "DATA OUTPUT, 0"
+	.pasciz "\356A OUT\345T\2230"
 
 	; BPMSG1107
 	.section .text.BPMSG1107, code
 	.global _BPMSG1107_str
 _BPMSG1107_str:
-	.pasciz " *pin is now HiZ"
+	.pasciz "\307p\334i\213\347w \357Z"
 
 	; BPMSG1108
 	.section .text.BPMSG1108, code
 	.global _BPMSG1108_str
 _BPMSG1108_str:
-	.pasciz "CLOCK TICKS: "
+	.pasciz "\311O\354 TI\354S\224"
 
 	; BPMSG1109
 	.section .text.BPMSG1109, code
 	.global _BPMSG1109_str
 _BPMSG1109_str:
-	.pasciz "READ BIT: "
+	.pasciz "\244\274 BIT\224"
 
 	; BPMSG1110
 	.section .text.BPMSG1110, code
 	.global _BPMSG1110_str
 _BPMSG1110_str:
-	.pasciz "Syntax error at char "
+	.pasciz "Syntax \207r\215 a\204\346\232 "
 
 	; BPMSG1111
 	.section .text.BPMSG1111, code
 	.global _BPMSG1111_str
 _BPMSG1111_str:
-	.pasciz "x. exit(without change)"
+	.pasciz "x\203\267\216(w\216hou\204\346\233ge)"
 
 	; BPMSG1112
 	.section .text.BPMSG1112, code
 	.global _BPMSG1112_str
 _BPMSG1112_str:
-	.pasciz "no mode change"
+	.pasciz "n\211\316d\205\346\233ge"
 
 	; BPMSG1114
 	.section .text.BPMSG1114, code
 	.global _BPMSG1114_str
 _BPMSG1114_str:
-	.pasciz "Nonexistent protocol!"
+	.pasciz "N\222\267i\243\221\204pr\371oc\270!"
 
 	; BPMSG1115
 	.section .text.BPMSG1115, code
 	.global _BPMSG1115_str
 _BPMSG1115_str:
-	.pasciz "x. exit"
+	.pasciz "x\203\267\216"
 
 	; BPMSG1117
 	.section .text.BPMSG1117, code
 	.global _BPMSG1117_str
 _BPMSG1117_str:
-	.pasciz "DEVID:"
+	.pasciz "\355VID:"
 
 	; BPMSG1118
 	.section .text.BPMSG1118, code
 	.global _BPMSG1118_str
 _BPMSG1118_str:
-	.pasciz "http://dangerousprototypes.com"
+	.pasciz "http://d\233g\207ou\260r\371\371ypes.com"
 
 	; BPMSG1119
 	.section .text.BPMSG1119, code
 	.global _BPMSG1119_str
 _BPMSG1119_str:
-	.pasciz "*----------*"
+	.pasciz "*\247\201*"
 
 	; BPMSG1120
 	.section .text.BPMSG1120, code
 	.global _BPMSG1120_str
 _BPMSG1120_str:
-	.pasciz "Open drain outputs (H=Hi-Z, L=GND)"
+	.pasciz "Op\221 dra\334o\305p\305s\206H=\357-Z\223L=G\363)"
 
 	; BPMSG1121
 	.section .text.BPMSG1121, code
 	.global _BPMSG1121_str
 _BPMSG1121_str:
-	.pasciz "Normal outputs (H=3.3v, L=GND)"
+	.pasciz "N\215m\255 o\305p\305s\206H=\3033v\223L=G\363)"
 
 	; BPMSG1123
 	.section .text.BPMSG1123, code
 	.global _BPMSG1123_str
 _BPMSG1123_str:
-	.pasciz "MSB set: MOST sig bit first"
+	.pasciz "MSB \257t\224\362S\326\350\264b\315fir\243"
 
 	; BPMSG1124
 	.section .text.BPMSG1124, code
 	.global _BPMSG1124_str
 _BPMSG1124_str:
-	.pasciz "LSB set: LEAST sig bit first"
+	.pasciz "LSB \257t\224LEAS\326\350\264b\315fir\243"
 
 	; BPMSG1126
 	.section .text.BPMSG1126, code
 	.global _BPMSG1126_str
 _BPMSG1126_str:
-	.pasciz " Bootloader v"
+	.pasciz " Bo\371\242\254\207 v"
 
 	; BPMSG1127
 	.section .text.BPMSG1127, code
 	.global _BPMSG1127_str
 _BPMSG1127_str:
-	.pasciz " 1. HEX\r\n 2. DEC\r\n 3. BIN\r\n 4. RAW"
+	.pasciz " 1\203HEX\261\355C\2023\203B\360\373\203RAW\2025\203DUMP"
 
 	; BPMSG1128
 	.section .text.BPMSG1128, code
 	.global _BPMSG1128_str
 _BPMSG1128_str:
-	.pasciz "Display format set"
+	.pasciz "Di\260la\237f\215ma\204\257t"
 
 	; BPMSG1133
 	.section .text.BPMSG1133, code
 	.global _BPMSG1133_str
 _BPMSG1133_str:
-	.pasciz "Set serial port speed: (bps)\r\n 1. 300\r\n 2. 1200\r\n 3. 2400\r\n 4. 4800\r\n 5. 9600\r\n 6. 19200\r\n 7. 38400\r\n 8. 57600\r\n 9. 115200\r\n10. BRG raw value"
+	.pasciz "\322s\207i\255\342\215\204\260e\304:\206bps)\2623\235\26112\235\2023\20324\235\373\20348\235\2025\20396\235\2026\203192\235\2027\203384\235\2028\203576\235\2029\2031152\235\3170\203BRG raw v\255ue"
 
 	; BPMSG1134
 	.section .text.BPMSG1134, code
 	.global _BPMSG1134_str
 _BPMSG1134_str:
-	.pasciz "Adjust your terminal"
+	.pasciz "Adj\351\204your t\207m\210\255"
 
 	; BPMSG1135
 	.section .text.BPMSG1135, code
 	.global _BPMSG1135_str
 _BPMSG1135_str:
-	.pasciz "Are you sure? "
+	.pasciz "Ar\205you su\214? "
 
 	; BPMSG1136
 	.section .text.BPMSG1136, code
@@ -440,49 +440,49 @@ _BPMSG1137_str:
 	.section .text.BPMSG1163, code
 	.global _BPMSG1163_str
 _BPMSG1163_str:
-	.pasciz "Disconnect any devices\r\nConnect (Vpu to +5V) and (ADC to +3.3V)"
+	.pasciz "Disc\222nec\204\233\237\226v\332es\200C\222nec\204(Vpu \265+5V\236\233d\206\274C \265+\3033V)"
 
 	; BPMSG1164
 	.section .text.BPMSG1164, code
 	.global _BPMSG1164_str
 _BPMSG1164_str:
-	.pasciz "Ctrl"
+	.pasciz "C\372l"
 
 	; BPMSG1165
 	.section .text.BPMSG1165, code
 	.global _BPMSG1165_str
 _BPMSG1165_str:
-	.pasciz "AUX"
+	.pasciz "\337"
 
 	; BPMSG1166
 	.section .text.BPMSG1166, code
 	.global _BPMSG1166_str
 _BPMSG1166_str:
-	.pasciz "MODE LED"
+	.pasciz "\362\355 LED"
 
 	; BPMSG1167
 	.section .text.BPMSG1167, code
 	.global _BPMSG1167_str
 _BPMSG1167_str:
-	.pasciz "PULLUP H"
+	.pasciz "\345LLUP H"
 
 	; BPMSG1168
 	.section .text.BPMSG1168, code
 	.global _BPMSG1168_str
 _BPMSG1168_str:
-	.pasciz "PULLUP L"
+	.pasciz "\345LLUP L"
 
 	; BPMSG1169
 	.section .text.BPMSG1169, code
 	.global _BPMSG1169_str
 _BPMSG1169_str:
-	.pasciz "VREG"
+	.pasciz "V\244G"
 
 	; BPMSG1170
 	.section .text.BPMSG1170, code
 	.global _BPMSG1170_str
 _BPMSG1170_str:
-	.pasciz "ADC and supply"
+	.pasciz "\274C \233\220supply"
 
 	; BPMSG1171
 	.section .text.BPMSG1171, code
@@ -494,79 +494,79 @@ _BPMSG1171_str:
 	.section .text.BPMSG1172, code
 	.global _BPMSG1172_str
 _BPMSG1172_str:
-	.pasciz "VPU"
+	.pasciz "V\345"
 
 	; BPMSG1173
 	.section .text.BPMSG1173, code
 	.global _BPMSG1173_str
 _BPMSG1173_str:
-	.pasciz "3.3V"
+	.pasciz "\3033V"
 
 	; BPMSG1174
 	.section .text.BPMSG1174, code
 	.global _BPMSG1174_str
 _BPMSG1174_str:
-	.pasciz "ADC"
+	.pasciz "\274C"
 
 	; BPMSG1175
 	.section .text.BPMSG1175, code
 	.global _BPMSG1175_str
 _BPMSG1175_str:
-	.pasciz "Bus high"
+	.pasciz "Bu\213\256gh"
 
 	; BPMSG1176
 	.section .text.BPMSG1176, code
 	.global _BPMSG1176_str
 _BPMSG1176_str:
-	.pasciz "Bus Hi-Z 0"
+	.pasciz "Bu\213\357-Z 0"
 
 	; BPMSG1177
 	.section .text.BPMSG1177, code
 	.global _BPMSG1177_str
 _BPMSG1177_str:
-	.pasciz "Bus Hi-Z 1"
+	.pasciz "Bu\213\357-Z 1"
 
 	; BPMSG1178
 	.section .text.BPMSG1178, code
 	.global _BPMSG1178_str
 _BPMSG1178_str:
-	.pasciz "MODE and VREG LEDs should be on!"
+	.pasciz "\362\355 \233\220V\244G LED\213sho\252\220b\205\222!"
 
 	; BPMSG1179
 	.section .text.BPMSG1179, code
 	.global _BPMSG1179_str
 _BPMSG1179_str:
-	.pasciz "Found "
+	.pasciz "Foun\220"
 
 	; BPMSG1180
 	.section .text.BPMSG1180, code
 	.global _BPMSG1180_str
 _BPMSG1180_str:
-	.pasciz " errors."
+	.pasciz " \207r\215s."
 
 	; BPMSG1181
 	.section .text.BPMSG1181, code
 	.global _BPMSG1181_str
 _BPMSG1181_str:
-	.pasciz "MOSI"
+	.pasciz "\362SI"
 
 	; BPMSG1182
 	.section .text.BPMSG1182, code
 	.global _BPMSG1182_str
 _BPMSG1182_str:
-	.pasciz "CLK"
+	.pasciz "\311K"
 
 	; BPMSG1183
 	.section .text.BPMSG1183, code
 	.global _BPMSG1183_str
 _BPMSG1183_str:
-	.pasciz "MISO"
+	.pasciz "M\375"
 
 	; BPMSG1184
 	.section .text.BPMSG1184, code
 	.global _BPMSG1184_str
 _BPMSG1184_str:
-	.pasciz "CS"
+	.pasciz "\312"
 
 	; BPMSG1185
 	.section .text.BPMSG1185, code
@@ -584,7 +584,7 @@ _BPMSG1186_str:
 	.section .text.BPMSG1194, code
 	.global _BPMSG1194_str
 _BPMSG1194_str:
-	.pasciz "-p "
+	.pasciz "-\251"
 
 	; BPMSG1195
 	.section .text.BPMSG1195, code
@@ -596,85 +596,85 @@ _BPMSG1195_str:
 	.section .text.BPMSG1196, code
 	.global _BPMSG1196_str
 _BPMSG1196_str:
-	.pasciz "*Bytes dropped*"
+	.pasciz "*By\227\213dropp\304*"
 
 	; BPMSG1197
 	.section .text.BPMSG1197, code
 	.global _BPMSG1197_str
 _BPMSG1197_str:
-	.pasciz "FAILED, NO DATA"
+	.pasciz "FAILED\223NO \356A"
 
 	; BPMSG1199
 	.section .text.BPMSG1199, code
 	.global _BPMSG1199_str
 _BPMSG1199_str:
-	.pasciz "Data bits and parity:\r\n 1. 8, NONE *default \r\n 2. 8, EVEN \r\n 3. 8, ODD \r\n 4. 9, NONE"
+	.pasciz "Data b\216\213\233\220p\232\216y\2668\223N\364E\307\226fa\252\204\2618\223EVEN \2023\2038\223ODD \373\2039\223N\364E"
 
 	; BPMSG1200
 	.section .text.BPMSG1200, code
 	.global _BPMSG1200_str
 _BPMSG1200_str:
-	.pasciz "Stop bits:\r\n 1. 1 *default\r\n 2. 2"
+	.pasciz "Sto\251b\216s\2661\307\226fa\252t\2612"
 
 	; BPMSG1201
 	.section .text.BPMSG1201, code
 	.global _BPMSG1201_str
 _BPMSG1201_str:
-	.pasciz "Receive polarity:\r\n 1. Idle 1 *default\r\n 2. Idle 0"
+	.pasciz "\276ceiv\205p\270\232\216y\266I\3301\307\226fa\252t\261I\3300"
 
 	; BPMSG1202
 	.section .text.BPMSG1202, code
 	.global _BPMSG1202_str
 _BPMSG1202_str:
-	.pasciz "UART (spd brg dbp sb rxp hiz)=( "
+	.pasciz "U\240T\206\260\220br\264db\251sb rx\251\256z)=( "
 
 	; BPMSG1203
 	.section .text.BPMSG1203, code
 	.global _BPMSG1203_str
 _BPMSG1203_str:
-	.pasciz " 0.Macro menu\r\n 1.Transparent bridge\r\n 2.Live monitor\r\n 3.Bridge with flow control\n\r 4.Auto Baud Detection"
+	.pasciz " \310\377\234.Tr\233\260a\214n\204bridge\230.Liv\205m\222\216\215\202\303Bridg\205w\216h f\321 c\222\372\270\n\r 4.Au\265Bau\220De\227c\246\222"
 
 	; BPMSG1204
 	.section .text.BPMSG1204, code
 	.global _BPMSG1204_str
 _BPMSG1204_str:
-	.pasciz "UART bridge"
+	.pasciz "U\240\326bridge"
 
 	; BPMSG1206
 	.section .text.BPMSG1206, code
 	.global _BPMSG1206_str
 _BPMSG1206_str:
-	.pasciz "Raw UART input"
+	.pasciz "Raw U\240\326\210p\305"
 
 	; BPMSG1207
 	.section .text.BPMSG1207, code
 	.global _BPMSG1207_str
 _BPMSG1207_str:
-	.pasciz "UART LIVE DISPLAY, } TO STOP"
+	.pasciz "U\240\326LIVE D\314PLAY\223} TO\300TOP"
 
 	; BPMSG1208
 	.section .text.BPMSG1208, code
 	.global _BPMSG1208_str
 _BPMSG1208_str:
-	.pasciz "LIVE DISPLAY STOPPED"
+	.pasciz "LIVE D\314PLAY\300TOPPED"
 
 	; BPMSG1209
 	.section .text.BPMSG1209, code
 	.global _BPMSG1209_str
 _BPMSG1209_str:
-	.pasciz "WARNING: pins not open drain (HiZ)"
+	.pasciz "W\240N\360G\224p\210\213\347\204op\221 dra\210\206\357Z)"
 
 	; BPMSG1210
 	.section .text.BPMSG1210, code
 	.global _BPMSG1210_str
 _BPMSG1210_str:
-	.pasciz " REVID:"
+	.pasciz " \244VID:"
 
 	; BPMSG1211
 	.section .text.BPMSG1211, code
 	.global _BPMSG1211_str
 _BPMSG1211_str:
-	.pasciz "\r\nInvalid choice, try again"
+	.pasciz "\200Inv\255i\220\346o\332e\223\372\237aga\210"
 
 	; BPMSG1212
 	.section .text.BPMSG1212, code
@@ -686,61 +686,61 @@ _BPMSG1212_str:
 	.section .text.BPMSG1213, code
 	.global _BPMSG1213_str
 _BPMSG1213_str:
-	.pasciz "RS LOW, COMMAND MODE"
+	.pasciz "RS LOW\223COMMA\363 \362\355"
 
 	; BPMSG1214
 	.section .text.BPMSG1214, code
 	.global _BPMSG1214_str
 _BPMSG1214_str:
-	.pasciz "RS HIGH, DATA MODE"
+	.pasciz "RS HIGH\223\356A \362\355"
 
 	; BPMSG1216
 	.section .text.BPMSG1216, code
 	.global _BPMSG1216_str
 _BPMSG1216_str:
-	.pasciz "This mode requires an adapter"
+	.pasciz "T\256\213\316d\205\214qui\214\213\233 \254apt\207"
 
 	; BPMSG1219
 	.section .text.BPMSG1219, code
 	.global _BPMSG1219_str
 _BPMSG1219_str:
-	.pasciz " 0.Macro menu\r\n 1.LCD Reset\r\n 2.Init LCD\r\n 3.Clear LCD\r\n 4.Cursor position ex:(4) 0\r\n 6.Write test numbers ex:(6) 80\r\n 7.Write test characters ex:(7) 80"
+	.pasciz " \310\377\234.LCD \276\257t\230.In\315LCD\202\303C\367\232 LCD\373.Curs\215\342os\216i\222 \267:(4\2360\2026.Wr\216\205\227s\204numb\207\213\267:(6\23680\2027.Wr\216\205\227s\204\346\232\225t\207\213\267:(7\23680"
 
 	; BPMSG1220
 	.section .text.BPMSG1220, code
 	.global _BPMSG1220_str
 _BPMSG1220_str:
-	.pasciz "Display lines:\r\n 1. 1 \r\n 2. Multiple"
+	.pasciz "Di\260la\237l\210es\2661 \261M\252\246p\367"
 
 	; BPMSG1221
 	.section .text.BPMSG1221, code
 	.global _BPMSG1221_str
 _BPMSG1221_str:
-	.pasciz "INIT"
+	.pasciz "\360IT"
 
 	; BPMSG1222
 	.section .text.BPMSG1222, code
 	.global _BPMSG1222_str
 _BPMSG1222_str:
-	.pasciz "CLEAR"
+	.pasciz "\311E\240"
 
 	; BPMSG1223
 	.section .text.BPMSG1223, code
 	.global _BPMSG1223_str
 _BPMSG1223_str:
-	.pasciz "CURSOR SET"
+	.pasciz "CURSOR\300ET"
 
 	; BPMSG1226
 	.section .text.BPMSG1226, code
 	.global _BPMSG1226_str
 _BPMSG1226_str:
-	.pasciz "Pinstates:"
+	.pasciz "P\210\243\327s:"
 
 	; BPMSG1227
 	.section .text.BPMSG1227, code
 	.global _BPMSG1227_str
 _BPMSG1227_str:
-	.pasciz "GND\t3.3V\t5.0V\tADC\tVPU\tAUX\t"
+	.pasciz "G\363\t\3033V\t5.0V\t\274C\tV\345\t\337\t"
 
 	; BPMSG1228
 	.section .text.BPMSG1228, code
@@ -752,79 +752,79 @@ _BPMSG1228_str:
 	.section .text.BPMSG1233, code
 	.global _BPMSG1233_str
 _BPMSG1233_str:
-	.pasciz "1.(BR)\t2.(RD)\t3.(OR)\t4.(YW)\t5.(GN)\t6.(BL)\t7.(PU)\t8.(GR)\t9.(WT)\t0.(Blk)"
+	.pasciz "1\352BR\2732\352RD\273\303(OR\2734\352YW\2735\352GN\2736\352BL\2737\352\345\2738\352GR\2739\352WT\273\310(Blk)"
 
 	; BPMSG1234
 	.section .text.BPMSG1234, code
 	.global _BPMSG1234_str
 _BPMSG1234_str:
-	.pasciz "GND\t"
+	.pasciz "G\363\t"
 
 	; BPMSG1245
 	.section .text.BPMSG1245, code
 	.global _BPMSG1245_str
 _BPMSG1245_str:
-	.pasciz " autorange "
+	.pasciz " a\305\215\233g\205"
 
 	; BPMSG1248
 	.section .text.BPMSG1248, code
 	.global _BPMSG1248_str
 _BPMSG1248_str:
-	.pasciz "Raw value for BRG (MIDI=127)"
+	.pasciz "Raw v\255u\205f\215 BRG\206MIDI=127)"
 
 	; BPMSG1251
 	.section .text.BPMSG1251, code
 	.global _BPMSG1251_str
 _BPMSG1251_str:
-	.pasciz "Space to continue"
+	.pasciz "Sp\225\205\265c\222t\210ue"
 
 	; BPMSG1252
 	.section .text.BPMSG1252, code
 	.global _BPMSG1252_str
 _BPMSG1252_str:
-	.pasciz "Number of bits read/write: "
+	.pasciz "Numb\207 of b\216\213\214\254/wr\216e\224"
 
 	; BPMSG1254
 	.section .text.BPMSG1254, code
 	.global _BPMSG1254_str
 _BPMSG1254_str:
-	.pasciz "Position in degrees"
+	.pasciz "Pos\216i\222 \334\226g\214es"
 
 	; BPMSG1255
 	.section .text.BPMSG1255, code
 	.global _BPMSG1255_str
 _BPMSG1255_str:
-	.pasciz "Servo active"
+	.pasciz "S\207v\211\336e"
 
 	; BPMSG1280
 	.section .text.BPMSG1280, code
 	.global _BPMSG1280_str
 _BPMSG1280_str:
-	.pasciz "Waiting activity..."
+	.pasciz "Wa\216\210\264\336\216y..."
 
 	; BPMSG1281
 	.section .text.BPMSG1281, code
 	.global _BPMSG1281_str
 _BPMSG1281_str:
-	.pasciz "** Early Exit!"
+	.pasciz "** E\232l\237Ex\216!"
 
 	; BPMSG1282
 	.section .text.BPMSG1282, code
 	.global _BPMSG1282_str
 _BPMSG1282_str:
-	.pasciz "**Baud>16m: BP Cannot measure > 16000000, Done."
+	.pasciz "**Baud>\302m\224BP C\233\347\204me\366ur\205> \302\235\235\235\223D\222e."
 
 	; BPMSG1283
 	.section .text.BPMSG1283, code
 	.global _BPMSG1283_str
 _BPMSG1283_str:
-	.pasciz "\n\rCalculated: \t"
+	.pasciz "\n\rC\255c\252\327d\224\t"
 
 	; BPMSG1284
 	.section .text.BPMSG1284, code
 	.global _BPMSG1284_str
 _BPMSG1284_str:
-	.pasciz "\n\rEstimated:  \t"
+	.pasciz "\n\rE\243im\327d\224 \t"
 
 	; BPMSG1285
 	.section .text.BPMSG1285, code
@@ -836,193 +836,193 @@ _BPMSG1285_str:
 	.section .text.HLP1000, code
 	.global _HLP1000_str
 _HLP1000_str:
-	.pasciz " General\t\t\t\t\tProtocol interaction"
+	.pasciz " G\221\207\255\217\335Pr\371oc\270 \210t\207\320\222"
 
 	; HLP1001
 	.section .text.HLP1001, code
 	.global _HLP1001_str
 _HLP1001_str:
-	.pasciz " ---------------------------------------------------------------------------"
+	.pasciz " \374\374\374\374\247\201-"
 
 	; HLP1002
 	.section .text.HLP1002, code
 	.global _HLP1002_str
 _HLP1002_str:
-	.pasciz " ?\tThis help\t\t\t(0)\tList current macros"
+	.pasciz " ?\tT\256\213help\335(0\273Lis\204cur\214n\204m\272os"
 
 	; HLP1003
 	.section .text.HLP1003, code
 	.global _HLP1003_str
 _HLP1003_str:
-	.pasciz " =X/|X\tConverts X/reverse X\t\t(x)\tMacro x"
+	.pasciz " =X/|X\tC\222v\207t\213X/\214v\207s\205X\217(x\273\325x"
 
 	; HLP1004
 	.section .text.HLP1004, code
 	.global _HLP1004_str
 _HLP1004_str:
-	.pasciz " ~\tSelftest\t\t\t[\tStart"
+	.pasciz " ~\t\263lf\227\243\335[\340t\232t"
 
 	; HLP1005
 	.section .text.HLP1005, code
 	.global _HLP1005_str
 _HLP1005_str:
-	.pasciz " #\tReset the BP   \t\t\t]\tStop"
+	.pasciz " #\t\276\257\204th\205BP\341 \335]\340top"
 
 	; HLP1006
 	.section .text.HLP1006, code
 	.global _HLP1006_str
 _HLP1006_str:
-	.pasciz " $\tJump to bootloader\t\t{\tStart with read"
+	.pasciz " $\tJum\251\265bo\371\242\254\207\217{\340t\232\204w\216h \214\254"
 
 	; HLP1007
 	.section .text.HLP1007, code
 	.global _HLP1007_str
 _HLP1007_str:
-	.pasciz " &/%\tDelay 1 us/ms\t\t\t}\tStop"
+	.pasciz " &/%\tDela\2371 \351/ms\335}\340top"
 
 	; HLP1008
 	.section .text.HLP1008, code
 	.global _HLP1008_str
 _HLP1008_str:
-	.pasciz " a/A/@\tAUXPIN (low/HI/READ)\t\t\"abc\"\tSend string"
+	.pasciz " a/A/@\t\337P\360\206\321/HI/\244\274)\217\"abc\"\340\221\220\243r\210g"
 
 	; HLP1009
 	.section .text.HLP1009, code
 	.global _HLP1009_str
 _HLP1009_str:
-	.pasciz " b\tSet baudrate\t\t\t123"
+	.pasciz " b\t\322baudr\327\335123"
 
 	; HLP1010
 	.section .text.HLP1010, code
 	.global _HLP1010_str
 _HLP1010_str:
-	.pasciz " c/C\tAUX assignment (aux/CS)\t\t0x123"
+	.pasciz " c/C\t\337 \366\350gn\333\204(aux/\312)\217\250123"
 
 	; HLP1011
 	.section .text.HLP1011, code
 	.global _HLP1011_str
 _HLP1011_str:
-	.pasciz " d/D\tMeasure ADC (once/CONT.)\t0b110\tSend value"
+	.pasciz " d/D\tMe\366ur\205\274C\206\222ce/C\364T.\2730b110\340\221\220v\255ue"
 
 	; HLP1012
 	.section .text.HLP1012, code
 	.global _HLP1012_str
 _HLP1012_str:
-	.pasciz " f\tMeasure frequency\t\tr\tRead"
+	.pasciz " f\tMe\366ur\205f\214qu\221cy\217r\t\276\254"
 
 	; HLP1013
 	.section .text.HLP1013, code
 	.global _HLP1013_str
 _HLP1013_str:
-	.pasciz " g/S\tGenerate PWM/Servo\t\t/\tCLK hi"
+	.pasciz " g/S\tG\221\207at\205PWM/S\207vo\217/\t\311K \256"
 
 	; HLP1014
 	.section .text.HLP1014, code
 	.global _HLP1014_str
 _HLP1014_str:
-	.pasciz " h\tCommandhistory\t\t\t\\\tCLK lo"
+	.pasciz " h\tCo\370\233d\256\243\215y\335\\\t\311K \242"
 
 	; HLP1015
 	.section .text.HLP1015, code
 	.global _HLP1015_str
 _HLP1015_str:
-	.pasciz " i\tVersioninfo/statusinfo\t\t^\tCLK tick"
+	.pasciz " i\tV\207\350\222\210fo/\243at\351\210fo\217^\t\311K \246ck"
 
 	; HLP1016
 	.section .text.HLP1016, code
 	.global _HLP1016_str
 _HLP1016_str:
-	.pasciz " l/L\tBitorder (msb/LSB)\t\t-\tDAT hi"
+	.pasciz " l/L\tB\216\215d\207\206msb/LSB)\217-\t\356 \256"
 
 	; HLP1017
 	.section .text.HLP1017, code
 	.global _HLP1017_str
 _HLP1017_str:
-	.pasciz " m\tChange mode\t\t\t_\tDAT lo"
+	.pasciz " m\tCh\233g\205\316\226\335_\t\356 \242"
 
 	; HLP1018
 	.section .text.HLP1018, code
 	.global _HLP1018_str
 _HLP1018_str:
-	.pasciz " o\tSet output type\t\t\t.\tDAT read"
+	.pasciz " o\t\322o\305pu\204type\335.\t\356 \214\254"
 
 	; HLP1019
 	.section .text.HLP1019, code
 	.global _HLP1019_str
 _HLP1019_str:
-	.pasciz " p/P\tPullup resistors (off/ON)\t!\tBit read"
+	.pasciz "\342/P\tP\252lu\251\214\350\243\215s\206o\331/\364\273!\tB\315\214\254"
 
 	; HLP1020
 	.section .text.HLP1020, code
 	.global _HLP1020_str
 _HLP1020_str:
-	.pasciz " s\tScript engine\t\t\t:\tRepeat e.g. r:10"
+	.pasciz " s\340crip\204\221g\210e\335:\t\276pea\204e.g\203r:10"
 
 	; HLP1021
 	.section .text.HLP1021, code
 	.global _HLP1021_str
 _HLP1021_str:
-	.pasciz " v\tShow volts/states\t\t.\tBits to read/write e.g. 0x55.2"
+	.pasciz " v\340how v\270ts/\243\327s\217.\tB\216\213\265\214\254/wr\216\205e.g\203\25055.2"
 
 	; HLP1022
 	.section .text.HLP1022, code
 	.global _HLP1022_str
 _HLP1022_str:
-	.pasciz " w/W\tPSU (off/ON)\t\t<x>/<x= >/<0>\tUsermacro x/assign x/list all"
+	.pasciz " w/W\tPSU\206o\331/\364)\217<x>/<x= >/<0>\tUs\207m\306x/\366\350gn x/lis\204\255l"
 
 	; MSG_1WIRE_ADDRESS_MACRO_HEADER
 	.section .text.MSG_1WIRE_ADDRESS_MACRO_HEADER, code
 	.global _MSG_1WIRE_ADDRESS_MACRO_HEADER_str
 _MSG_1WIRE_ADDRESS_MACRO_HEADER_str:
-	.pasciz "ADDRESS MACRO "
+	.pasciz "\274D\244SS MAC\241 "
 
 	; MSG_1WIRE_ALARM_MACRO_NAME
 	.section .text.MSG_1WIRE_ALARM_MACRO_NAME, code
 	.global _MSG_1WIRE_ALARM_MACRO_NAME_str
 _MSG_1WIRE_ALARM_MACRO_NAME_str:
-	.pasciz "ALARM SEARCH (0xEC)"
+	.pasciz "AL\240M\300E\240\343\271EC)"
 
 	; MSG_1WIRE_BUS_RESET
 	.section .text.MSG_1WIRE_BUS_RESET, code
 	.global _MSG_1WIRE_BUS_RESET_str
 _MSG_1WIRE_BUS_RESET_str:
-	.pasciz "BUS RESET "
+	.pasciz "BUS \244\365\326"
 
 	; MSG_1WIRE_LOOKUP_ID_HEADER
 	.section .text.MSG_1WIRE_LOOKUP_ID_HEADER, code
 	.global _MSG_1WIRE_LOOKUP_ID_HEADER_str
 _MSG_1WIRE_LOOKUP_ID_HEADER_str:
-	.pasciz "\r\n   *"
+	.pasciz "\202 \307"
 
 	; MSG_1WIRE_MACRO_LIST
 	.section .text.MSG_1WIRE_MACRO_LIST, code
 	.global _MSG_1WIRE_MACRO_LIST_str
 _MSG_1WIRE_MACRO_LIST_str:
-	.pasciz "1WIRE ROM COMMAND MACROs:\r\n 51.READ ROM (0x33) *for single device bus\r\n 85.MATCH ROM (0x55) *followed by 64bit address\r\n 204.SKIP ROM (0xCC) *followed by command\r\n 236.ALARM SEARCH (0xEC)\r\n 240.SEARCH ROM (0xF0)"
+	.pasciz "1WI\244\301 COMMA\363 MAC\241s:\20251.\244\274\32333\236*f\215 s\210g\245\226v\332\205b\351\2026\310OV\313DRIVE\300KIP\3233C\236*f\270\321e\220b\237co\370\233d\20285.M\253\343\32355\236*f\270\321e\220b\23764b\315\254d\214ss\23405.OV\313DRIVE M\253\343\32369\236*f\270\321e\220b\23764b\315\254d\214ss\23004.SKIP\323CC\236*f\270\321e\220b\237co\370\233d\23036.AL\240M\300E\240\343\271EC)\2304\310\365\240\343\323F0)"
 
 	; MSG_1WIRE_MACRO_MENU_HEADER
 	.section .text.MSG_1WIRE_MACRO_MENU_HEADER, code
 	.global _MSG_1WIRE_MACRO_MENU_HEADER_str
 _MSG_1WIRE_MACRO_MENU_HEADER_str:
-	.pasciz " 0.Macro menu"
+	.pasciz " \310\377"
 
 	; MSG_1WIRE_MACRO_TABLE_HEADER
 	.section .text.MSG_1WIRE_MACRO_TABLE_HEADER, code
 	.global _MSG_1WIRE_MACRO_TABLE_HEADER_str
 _MSG_1WIRE_MACRO_TABLE_HEADER_str:
-	.pasciz "Macro     1WIRE address"
+	.pasciz "\325\341\3411WI\244 \254d\214ss"
 
 	; MSG_1WIRE_MACRO_TABLE_TRAILER
 	.section .text.MSG_1WIRE_MACRO_TABLE_TRAILER, code
 	.global _MSG_1WIRE_MACRO_TABLE_TRAILER_str
 _MSG_1WIRE_MACRO_TABLE_TRAILER_str:
-	.pasciz "Device IDs are available by MACRO, see (0)."
+	.pasciz "Dev\332\205ID\213\232\205availab\245b\237MAC\241\223\257\205(0)."
 
 	; MSG_1WIRE_MATCH_ROM_MACRO_NAME
 	.section .text.MSG_1WIRE_MATCH_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_MATCH_ROM_MACRO_NAME_str
 _MSG_1WIRE_MATCH_ROM_MACRO_NAME_str:
-	.pasciz "MATCH ROM (0x55)"
+	.pasciz "M\253\343\32355)"
 
 	; MSG_1WIRE_MODE_IDENTIFIER
 	.section .text.MSG_1WIRE_MODE_IDENTIFIER, code
@@ -1034,19 +1034,31 @@ _MSG_1WIRE_MODE_IDENTIFIER_str:
 	.section .text.MSG_1WIRE_NEXT_CLOCK_ALERT, code
 	.global _MSG_1WIRE_NEXT_CLOCK_ALERT_str
 _MSG_1WIRE_NEXT_CLOCK_ALERT_str:
-	.pasciz " *next clock (^) will use this value"
+	.pasciz "\307n\267\204c\242ck\206^\236will \351\205t\256\213v\255ue"
 
 	; MSG_1WIRE_NO_DEVICE
 	.section .text.MSG_1WIRE_NO_DEVICE, code
 	.global _MSG_1WIRE_NO_DEVICE_str
 _MSG_1WIRE_NO_DEVICE_str:
-	.pasciz "No device, try (ALARM) SEARCH macro first"
+	.pasciz "N\211\226v\332e\223\372y\206AL\240M\236\365\240\343 m\306fir\243"
 
 	; MSG_1WIRE_NO_DEVICE_DETECTED
 	.section .text.MSG_1WIRE_NO_DEVICE_DETECTED, code
 	.global _MSG_1WIRE_NO_DEVICE_DETECTED_str
 _MSG_1WIRE_NO_DEVICE_DETECTED_str:
-	.pasciz "*No device detected "
+	.pasciz "*N\211\226v\332\205\226\227c\227\220"
+
+	; MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str:
+	.pasciz "OV\313DRIVE M\253\343\32369)"
+
+	; MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str:
+	.pasciz "OV\313DRIVE\300KIP\3233C)"
 
 	; MSG_1WIRE_PINS_STATE
 	.section .text.MSG_1WIRE_PINS_STATE, code
@@ -1058,49 +1070,49 @@ _MSG_1WIRE_PINS_STATE_str:
 	.section .text.MSG_1WIRE_READ_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_READ_ROM_MACRO_NAME_str
 _MSG_1WIRE_READ_ROM_MACRO_NAME_str:
-	.pasciz "READ ROM (0x33): "
+	.pasciz "\244\274\32333)\224"
 
 	; MSG_1WIRE_SEARCH_MACRO_NAME
 	.section .text.MSG_1WIRE_SEARCH_MACRO_NAME, code
 	.global _MSG_1WIRE_SEARCH_MACRO_NAME_str
 _MSG_1WIRE_SEARCH_MACRO_NAME_str:
-	.pasciz "SEARCH (0xF0)"
+	.pasciz "\365\240\343\271F0)"
 
 	; MSG_1WIRE_SKIP_ROM_MACRO_NAME
 	.section .text.MSG_1WIRE_SKIP_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_SKIP_ROM_MACRO_NAME_str
 _MSG_1WIRE_SKIP_ROM_MACRO_NAME_str:
-	.pasciz "SKIP ROM (0xCC)"
+	.pasciz "SKIP\323CC)"
 
 	; MSG_1WIRE_SPEED_PROMPT
 	.section .text.MSG_1WIRE_SPEED_PROMPT, code
 	.global _MSG_1WIRE_SPEED_PROMPT_str
 _MSG_1WIRE_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1. Standard (~16.3kbps) \r\n 2. Overdrive (~160kps)"
+	.pasciz "\322\260e\304\266St\233d\232d\206~\302.3kbps\236\261Ov\207driv\205(~\3020kps)"
 
 	; MSG_ACK
 	.section .text.MSG_ACK, code
 	.global _MSG_ACK_str
 _MSG_ACK_str:
-	.pasciz "ACK"
+	.pasciz "A\354"
 
 	; MSG_ADC_VOLTAGE_PROBE_HEADER
 	.section .text.MSG_ADC_VOLTAGE_PROBE_HEADER, code
 	.global _MSG_ADC_VOLTAGE_PROBE_HEADER_str
 _MSG_ADC_VOLTAGE_PROBE_HEADER_str:
-	.pasciz "VOLTAGE PROBE: "
+	.pasciz "VOLTAGE P\241BE\224"
 
 	; MSG_ADC_VOLTMETER_MODE
 	.section .text.MSG_ADC_VOLTMETER_MODE, code
 	.global _MSG_ADC_VOLTMETER_MODE_str
 _MSG_ADC_VOLTMETER_MODE_str:
-	.pasciz "VOLTMETER MODE"
+	.pasciz "VOLTMET\313 \362\355"
 
 	; MSG_ANY_KEY_TO_EXIT_PROMPT
 	.section .text.MSG_ANY_KEY_TO_EXIT_PROMPT, code
 	.global _MSG_ANY_KEY_TO_EXIT_PROMPT_str
 _MSG_ANY_KEY_TO_EXIT_PROMPT_str:
-	.pasciz "Any key to exit"
+	.pasciz "An\237ke\237\265\267\216"
 
 	; MSG_BASE_CONVERTER_EQUAL_SIGN
 	.section .text.MSG_BASE_CONVERTER_EQUAL_SIGN, code
@@ -1124,7 +1136,7 @@ _MSG_BINARY_NUMBER_PREFIX_str:
 	.section .text.MSG_CHIP_IDENTIFIER_CLONE, code
 	.global _MSG_CHIP_IDENTIFIER_CLONE_str
 _MSG_CHIP_IDENTIFIER_CLONE_str:
-	.pasciz " clone w/different PIC"
+	.pasciz " cl\222\205w/di\331\207\221\204PIC"
 
 	; MSG_CHIP_REVISION_A3
 	.section .text.MSG_CHIP_REVISION_A3, code
@@ -1154,7 +1166,7 @@ _MSG_CHIP_REVISION_B8_str:
 	.section .text.MSG_CHIP_REVISION_ID_BEGIN, code
 	.global _MSG_CHIP_REVISION_ID_BEGIN_str
 _MSG_CHIP_REVISION_ID_BEGIN_str:
-	.pasciz " (24FJ64GA00 "
+	.pasciz "\20624FJ64GA\235 "
 
 	; MSG_CHIP_REVISION_ID_END_2
 	.section .text.MSG_CHIP_REVISION_ID_END_2, code
@@ -1178,91 +1190,127 @@ _MSG_CHIP_REVISION_UNKNOWN_str:
 	.section .text.MSG_CLUTCH_DISENGAGED, code
 	.global _MSG_CLUTCH_DISENGAGED_str
 _MSG_CLUTCH_DISENGAGED_str:
-	.pasciz "Clutch disengaged!!!"
+	.pasciz "Cl\305\346 dis\221gag\304!!!"
 
 	; MSG_CLUTCH_ENGAGED
 	.section .text.MSG_CLUTCH_ENGAGED, code
 	.global _MSG_CLUTCH_ENGAGED_str
 _MSG_CLUTCH_ENGAGED_str:
-	.pasciz "Clutch engaged!!!"
+	.pasciz "Cl\305\346 \221gag\304!!!"
 
 	; MSG_COMMAND_HAS_NO_EFFECT
 	.section .text.MSG_COMMAND_HAS_NO_EFFECT, code
 	.global _MSG_COMMAND_HAS_NO_EFFECT_str
 _MSG_COMMAND_HAS_NO_EFFECT_str:
-	.pasciz "ERROR: command has no effect here"
+	.pasciz "\313\241R\224co\370\233\220ha\213n\211e\331ec\204h\207e"
+
+	; MSG_DIO_MACRO_MENU
+	.section .text.MSG_DIO_MACRO_MENU, code
+	.global _MSG_DIO_MACRO_MENU_str
+_MSG_DIO_MACRO_MENU_str:
+	.pasciz " \310\377\234.S\227\251p\207io\220\334u\213\267:(1\2361\235\230.Samp\245p\210\213\267:(2\236\302\202\303\276c\215\220p\334\243\327s\373.Pla\237\214c\215d\210\264\267:(4\2361\2230 un\246l a ke\237i\213p\214s\257d"
+
+	; MSG_DIO_NOTHING_RECORDED
+	.section .text.MSG_DIO_NOTHING_RECORDED, code
+	.global _MSG_DIO_NOTHING_RECORDED_str
+_MSG_DIO_NOTHING_RECORDED_str:
+	.pasciz "N\371h\210\264\214c\215\226d\223\243\232\204w\216h\2063)"
+
+	; MSG_DIO_RECORDING
+	.section .text.MSG_DIO_RECORDING, code
+	.global _MSG_DIO_RECORDING_str
+_MSG_DIO_RECORDING_str:
+	.pasciz "\276c\215d\210\264p\334\243\327s,\2064\236play\213them"
+
+	; MSG_DIO_RECORDING_FULL
+	.section .text.MSG_DIO_RECORDING_FULL, code
+	.global _MSG_DIO_RECORDING_FULL_str
+_MSG_DIO_RECORDING_FULL_str:
+	.pasciz "\276c\215d\210\264f\252l"
+
+	; MSG_DIO_STEP_PERIOD
+	.section .text.MSG_DIO_STEP_PERIOD, code
+	.global _MSG_DIO_STEP_PERIOD_str
+_MSG_DIO_STEP_PERIOD_str:
+	.pasciz "S\227\251p\207iod\206\351)\224"
+
+	; MSG_DIO_STEP_PERIOD_RANGE
+	.section .text.MSG_DIO_STEP_PERIOD_RANGE, code
+	.global _MSG_DIO_STEP_PERIOD_RANGE_str
+_MSG_DIO_STEP_PERIOD_RANGE_str:
+	.pasciz "S\227\251p\207io\220m\351\204b\2054-4095\351"
 
 	; MSG_FINISH_SETUP_PROMPT
 	.section .text.MSG_FINISH_SETUP_PROMPT, code
 	.global _MSG_FINISH_SETUP_PROMPT_str
 _MSG_FINISH_SETUP_PROMPT_str:
-	.pasciz "To finish setup, start up the power supplies with command 'W'"
+	.pasciz "T\211f\210ish \257tup\223\243\232\204u\251th\205pow\207 supplie\213w\216h co\370\233\220'W'"
 
 	; MSG_HEXADECIMAL_NUMBER_PREFIX
 	.section .text.MSG_HEXADECIMAL_NUMBER_PREFIX, code
 	.global _MSG_HEXADECIMAL_NUMBER_PREFIX_str
 _MSG_HEXADECIMAL_NUMBER_PREFIX_str:
-	.pasciz "0x"
+	.pasciz "\250"
 
 	; MSG_I2C_MODE_IDENTIFIER
 	.section .text.MSG_I2C_MODE_IDENTIFIER, code
 	.global _MSG_I2C_MODE_IDENTIFIER_str
 _MSG_I2C_MODE_IDENTIFIER_str:
-	.pasciz "I2C1"
+	.pasciz "\3611"
 
 	; MSG_I2C_PINS_STATE
 	.section .text.MSG_I2C_PINS_STATE, code
 	.global _MSG_I2C_PINS_STATE_str
 _MSG_I2C_PINS_STATE_str:
-	.pasciz "SCL\tSDA\t-\t-"
+	.pasciz "S\311\340DA\t-\t-"
 
 	; MSG_I2C_READ_ADDRESS_END
 	.section .text.MSG_I2C_READ_ADDRESS_END, code
 	.global _MSG_I2C_READ_ADDRESS_END_str
 _MSG_I2C_READ_ADDRESS_END_str:
-	.pasciz " R) "
+	.pasciz " R\236"
 
 	; MSG_I2C_START_BIT
 	.section .text.MSG_I2C_START_BIT, code
 	.global _MSG_I2C_START_BIT_str
 _MSG_I2C_START_BIT_str:
-	.pasciz "I2C START BIT"
+	.pasciz "\361\300T\240\326BIT"
 
 	; MSG_I2C_STOP_BIT
 	.section .text.MSG_I2C_STOP_BIT, code
 	.global _MSG_I2C_STOP_BIT_str
 _MSG_I2C_STOP_BIT_str:
-	.pasciz "I2C STOP BIT"
+	.pasciz "\361\300TOP BIT"
 
 	; MSG_I2C_WRITE_ADDRESS_END
 	.section .text.MSG_I2C_WRITE_ADDRESS_END, code
 	.global _MSG_I2C_WRITE_ADDRESS_END_str
 _MSG_I2C_WRITE_ADDRESS_END_str:
-	.pasciz " W) "
+	.pasciz " W\236"
 
 	; MSG_KEYBOARD_ERROR_NODATA
 	.section .text.MSG_KEYBOARD_ERROR_NODATA, code
 	.global _MSG_KEYBOARD_ERROR_NODATA_str
 _MSG_KEYBOARD_ERROR_NODATA_str:
-	.pasciz " NONE"
+	.pasciz " N\364E"
 
 	; MSG_KEYBOARD_ERROR_PARITY
 	.section .text.MSG_KEYBOARD_ERROR_PARITY, code
 	.global _MSG_KEYBOARD_ERROR_PARITY_str
 _MSG_KEYBOARD_ERROR_PARITY_str:
-	.pasciz " *parity error"
+	.pasciz "\307p\232\216\237\207r\215"
 
 	; MSG_KEYBOARD_ERROR_STARTBIT
 	.section .text.MSG_KEYBOARD_ERROR_STARTBIT, code
 	.global _MSG_KEYBOARD_ERROR_STARTBIT_str
 _MSG_KEYBOARD_ERROR_STARTBIT_str:
-	.pasciz " *startbit error"
+	.pasciz "\307\243\232tb\315\207r\215"
 
 	; MSG_KEYBOARD_ERROR_STOPBIT
 	.section .text.MSG_KEYBOARD_ERROR_STOPBIT, code
 	.global _MSG_KEYBOARD_ERROR_STOPBIT_str
 _MSG_KEYBOARD_ERROR_STOPBIT_str:
-	.pasciz " *stopbit error"
+	.pasciz "\307\243opb\315\207r\215"
 
 	; MSG_KEYBOARD_ERROR_TIMEOUT
 	.section .text.MSG_KEYBOARD_ERROR_TIMEOUT, code
@@ -1274,19 +1322,37 @@ _MSG_KEYBOARD_ERROR_TIMEOUT_str:
 	.section .text.MSG_KEYBOARD_ERROR_UNKNOWN, code
 	.global _MSG_KEYBOARD_ERROR_UNKNOWN_str
 _MSG_KEYBOARD_ERROR_UNKNOWN_str:
-	.pasciz " UNKNOWN ERROR"
+	.pasciz " UNKNOWN \313\241R"
 
 	; MSG_KEYBOARD_LIVE_INPUT_START
 	.section .text.MSG_KEYBOARD_LIVE_INPUT_START, code
 	.global _MSG_KEYBOARD_LIVE_INPUT_START_str
 _MSG_KEYBOARD_LIVE_INPUT_START_str:
-	.pasciz "Input monitor, any key exits"
+	.pasciz "Inpu\204m\222\216\215\223\233\237ke\237\267\216s"
 
 	; MSG_KEYBOARD_MACRO_MENU
 	.section .text.MSG_KEYBOARD_MACRO_MENU, code
 	.global _MSG_KEYBOARD_MACRO_MENU_str
 _MSG_KEYBOARD_MACRO_MENU_str:
-	.pasciz " 0. Macro menu\r\n 1. Live input monitor"
+	.pasciz " 0\203\377\262Liv\205\210pu\204m\222\216\215"
+
+	; MSG_MEMORY_USAGE_ARENA_PEAKS
+	.section .text.MSG_MEMORY_USAGE_ARENA_PEAKS, code
+	.global _MSG_MEMORY_USAGE_ARENA_PEAKS_str
+_MSG_MEMORY_USAGE_ARENA_PEAKS_str:
+	.pasciz "A\214na\342eaks:"
+
+	; MSG_MEMORY_USAGE_BYTES
+	.section .text.MSG_MEMORY_USAGE_BYTES, code
+	.global _MSG_MEMORY_USAGE_BYTES_str
+_MSG_MEMORY_USAGE_BYTES_str:
+	.pasciz " by\227s"
+
+	; MSG_MEMORY_USAGE_STACK
+	.section .text.MSG_MEMORY_USAGE_STACK, code
+	.global _MSG_MEMORY_USAGE_STACK_str
+_MSG_MEMORY_USAGE_STACK_str:
+	.pasciz "St\225k u\257d\224"
 
 	; MSG_MODE_HEADER_END
 	.section .text.MSG_MODE_HEADER_END, code
@@ -1298,13 +1364,13 @@ _MSG_MODE_HEADER_END_str:
 	.section .text.MSG_NACK, code
 	.global _MSG_NACK_str
 _MSG_NACK_str:
-	.pasciz "NACK"
+	.pasciz "NA\354"
 
 	; MSG_NO_VOLTAGE_ON_PULLUP_PIN
 	.section .text.MSG_NO_VOLTAGE_ON_PULLUP_PIN, code
 	.global _MSG_NO_VOLTAGE_ON_PULLUP_PIN_str
 _MSG_NO_VOLTAGE_ON_PULLUP_PIN_str:
-	.pasciz "Warning: no voltage on Vpullup pin"
+	.pasciz "W\232n\210g\224n\211v\270tag\205\222 Vp\252lu\251p\210"
 
 	; MSG_OPENOCD_MODE_IDENTIFIER
 	.section .text.MSG_OPENOCD_MODE_IDENTIFIER, code
@@ -1328,19 +1394,19 @@ _MSG_PIC_DEVICE_ID_str:
 	.section .text.MSG_PIC_EXIT_MODE, code
 	.global _MSG_PIC_EXIT_MODE_str
 _MSG_PIC_EXIT_MODE_str:
-	.pasciz "Please exit PIC programming mode"
+	.pasciz "P\367\366\205\267\315PIC\342rogra\370\210\264\316\226"
 
 	; MSG_PIC_MACRO_MENU
 	.section .text.MSG_PIC_MACRO_MENU, code
 	.global _MSG_PIC_MACRO_MENU_str
 _MSG_PIC_MACRO_MENU_str:
-	.pasciz "(1) get devID"
+	.pasciz "(1\236ge\204\226vID"
 
 	; MSG_PIC_MACRO_NOT_IMPLEMENTED
 	.section .text.MSG_PIC_MACRO_NOT_IMPLEMENTED, code
 	.global _MSG_PIC_MACRO_NOT_IMPLEMENTED_str
 _MSG_PIC_MACRO_NOT_IMPLEMENTED_str:
-	.pasciz "Not implemented (yet)"
+	.pasciz "No\204imp\367\333\227d\206yet)"
 
 	; MSG_PIC_MODE_COMMAND
 	.section .text.MSG_PIC_MODE_COMMAND, code
@@ -1358,7 +1424,7 @@ _MSG_PIC_MODE_DATA_str:
 	.section .text.MSG_PIC_MODE_HEADER, code
 	.global _MSG_PIC_MODE_HEADER_str
 _MSG_PIC_MODE_HEADER_str:
-	.pasciz "PIC(mod dly)=("
+	.pasciz "PIC(\316\220dly)=("
 
 	; MSG_PIC_MODE_IDENTIFIER
 	.section .text.MSG_PIC_MODE_IDENTIFIER, code
@@ -1370,13 +1436,13 @@ _MSG_PIC_MODE_IDENTIFIER_str:
 	.section .text.MSG_PIC_MODE_PROMPT, code
 	.global _MSG_PIC_MODE_PROMPT_str
 _MSG_PIC_MODE_PROMPT_str:
-	.pasciz "Commandmode?\r\n1. 6b/14b\r\n2. 4b/16b"
+	.pasciz "Co\370\233d\316\226?\317\2036b/14b\2002\2034b/\302b"
 
 	; MSG_PIC_NO_READ
 	.section .text.MSG_PIC_NO_READ, code
 	.global _MSG_PIC_NO_READ_str
 _MSG_PIC_NO_READ_str:
-	.pasciz "no read"
+	.pasciz "n\211\214\254"
 
 	; MSG_PIC_PINS_STATE
 	.section .text.MSG_PIC_PINS_STATE, code
@@ -1388,103 +1454,103 @@ _MSG_PIC_PINS_STATE_str:
 	.section .text.MSG_PIC_REVISION_ID, code
 	.global _MSG_PIC_REVISION_ID_str
 _MSG_PIC_REVISION_ID_str:
-	.pasciz " Rev = "
+	.pasciz " \276v = "
 
 	; MSG_PIC_UNKNOWN_MODE
 	.section .text.MSG_PIC_UNKNOWN_MODE, code
 	.global _MSG_PIC_UNKNOWN_MODE_str
 _MSG_PIC_UNKNOWN_MODE_str:
-	.pasciz "unknown mode"
+	.pasciz "unk\347wn \316\226"
 
 	; MSG_PIN_OUTPUT_TYPE_PROMPT
 	.section .text.MSG_PIN_OUTPUT_TYPE_PROMPT, code
 	.global _MSG_PIN_OUTPUT_TYPE_PROMPT_str
 _MSG_PIN_OUTPUT_TYPE_PROMPT_str:
-	.pasciz "Select output type:\r\n 1. Open drain (H=Hi-Z, L=GND)\r\n 2. Normal (H=3.3V, L=GND)"
+	.pasciz "\263\367c\204o\305pu\204type\266Op\221 dra\210\206H=\357-Z\223L=G\363)\261N\215m\255\206H=\3033V\223L=G\363)"
 
 	; MSG_PWM_FREQUENCY_TOO_LOW
 	.section .text.MSG_PWM_FREQUENCY_TOO_LOW, code
 	.global _MSG_PWM_FREQUENCY_TOO_LOW_str
 _MSG_PWM_FREQUENCY_TOO_LOW_str:
-	.pasciz "Frequencies < 1Hz are not supported."
+	.pasciz "F\214qu\221cie\213< 1\231 \232\205\347\204supp\215\227d."
 
 	; MSG_PWM_HZ_MARKER
 	.section .text.MSG_PWM_HZ_MARKER, code
 	.global _MSG_PWM_HZ_MARKER_str
 _MSG_PWM_HZ_MARKER_str:
-	.pasciz " Hz"
+	.pasciz " \231"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER_str
 _MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER_str:
-	.pasciz "Data units: "
+	.pasciz "Data un\216s\224"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION_str
 _MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION_str:
-	.pasciz "no indication"
+	.pasciz "n\211\210d\332a\246\222"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH_str
 _MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH_str:
-	.pasciz "Data unit length (bits): "
+	.pasciz "Data un\315l\221gth\206b\216s)\224"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE_str:
-	.pasciz "2 wire"
+	.pasciz "2 wi\214"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE_str:
-	.pasciz "3 wire"
+	.pasciz "3 wi\214"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_HEADER_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_HEADER_str:
-	.pasciz "Protocol: "
+	.pasciz "Pr\371oc\270\224"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL_str:
-	.pasciz "serial"
+	.pasciz "s\207i\255"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN_str:
-	.pasciz "unknown"
+	.pasciz "unk\347wn"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_HEADER_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_HEADER_str:
-	.pasciz "Read type: "
+	.pasciz "\276a\220type\224"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_TO_END
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_TO_END, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_TO_END_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_TO_END_str:
-	.pasciz "to end"
+	.pasciz "\265\221d"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH_str:
-	.pasciz "variable length"
+	.pasciz "v\232iab\245l\221gth"
 
 	; MSG_RAW2WIRE_ATR_REPLY_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_REPLY_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_REPLY_HEADER_str
 _MSG_RAW2WIRE_ATR_REPLY_HEADER_str:
-	.pasciz "ISO 7816-3 reply (uses current LSB setting): "
+	.pasciz "\375 78\302-3 \214ply\206u\257\213cur\214n\204LSB \257tt\210g)\224"
 
 	; MSG_RAW2WIRE_ATR_RFU
 	.section .text.MSG_RAW2WIRE_ATR_RFU, code
@@ -1496,7 +1562,7 @@ _MSG_RAW2WIRE_ATR_RFU_str:
 	.section .text.MSG_RAW2WIRE_ATR_TRIGGER_INFO, code
 	.global _MSG_RAW2WIRE_ATR_TRIGGER_INFO_str
 _MSG_RAW2WIRE_ATR_TRIGGER_INFO_str:
-	.pasciz "ISO 7816-3 ATR (RESET on CS)\r\nRESET HIGH, CLOCK TICK, RESET LOW"
+	.pasciz "\375 78\302-3 \253R\206\244\365\326\222 \312)\200\244\365\326HIGH\223\311O\354 TI\354\223\244\365\326LOW"
 
 	; MSG_RAW2WIRE_I2C_START
 	.section .text.MSG_RAW2WIRE_I2C_START, code
@@ -1514,25 +1580,43 @@ _MSG_RAW2WIRE_I2C_STOP_str:
 	.section .text.MSG_RAW2WIRE_MACRO_MENU, code
 	.global _MSG_RAW2WIRE_MACRO_MENU_str
 _MSG_RAW2WIRE_MACRO_MENU_str:
-	.pasciz " 0.Macro menu\r\n 1.ISO7816-3 ATR\r\n 2.ISO7816-3 parse only"
+	.pasciz " \310\377\234.\37578\302-3 \253R\230.\37578\302-3\342\232s\205\222ly\202\303\37578\302-3 T=0 \336\327\373.\37578\302-3 T=0 \226\336\327"
 
 	; MSG_RAW2WIRE_MODE_HEADER
 	.section .text.MSG_RAW2WIRE_MODE_HEADER, code
 	.global _MSG_RAW2WIRE_MODE_HEADER_str
 _MSG_RAW2WIRE_MODE_HEADER_str:
-	.pasciz "R2W (spd hiz)=( "
+	.pasciz "R2W\206\260\220\256z)=( "
+
+	; MSG_RAW2WIRE_T0_ATR
+	.section .text.MSG_RAW2WIRE_T0_ATR, code
+	.global _MSG_RAW2WIRE_T0_ATR_str
+_MSG_RAW2WIRE_T0_ATR_str:
+	.pasciz "\253R\224"
+
+	; MSG_RAW2WIRE_T0_DEACTIVATED
+	.section .text.MSG_RAW2WIRE_T0_DEACTIVATED, code
+	.global _MSG_RAW2WIRE_T0_DEACTIVATED_str
+_MSG_RAW2WIRE_T0_DEACTIVATED_str:
+	.pasciz "C\232\220\226\336\327d"
+
+	; MSG_RAW2WIRE_T0_NO_ANSWER
+	.section .text.MSG_RAW2WIRE_T0_NO_ANSWER, code
+	.global _MSG_RAW2WIRE_T0_NO_ANSWER_str
+_MSG_RAW2WIRE_T0_NO_ANSWER_str:
+	.pasciz "N\211v\255i\220T=0 \233sw\207 \265\214\257t"
 
 	; MSG_RAW3WIRE_MODE_HEADER
 	.section .text.MSG_RAW3WIRE_MODE_HEADER, code
 	.global _MSG_RAW3WIRE_MODE_HEADER_str
 _MSG_RAW3WIRE_MODE_HEADER_str:
-	.pasciz "R3W (spd csl hiz)=( "
+	.pasciz "R3W\206\260\220csl \256z)=( "
 
 	; MSG_RAW_BRG_VALUE_INPUT
 	.section .text.MSG_RAW_BRG_VALUE_INPUT, code
 	.global _MSG_RAW_BRG_VALUE_INPUT_str
 _MSG_RAW_BRG_VALUE_INPUT_str:
-	.pasciz "Enter raw value for BRG"
+	.pasciz "Ent\207 raw v\255u\205f\215 BRG"
 
 	; MSG_RAW_MODE_IDENTIFIER
 	.section .text.MSG_RAW_MODE_IDENTIFIER, code
@@ -1544,55 +1628,61 @@ _MSG_RAW_MODE_IDENTIFIER_str:
 	.section .text.MSG_SNIFFER_MESSAGE, code
 	.global _MSG_SNIFFER_MESSAGE_str
 _MSG_SNIFFER_MESSAGE_str:
-	.pasciz "Sniffer"
+	.pasciz "Sni\331\207"
 
 	; MSG_SOFTWARE_MODE_SPEED_PROMPT
 	.section .text.MSG_SOFTWARE_MODE_SPEED_PROMPT, code
 	.global _MSG_SOFTWARE_MODE_SPEED_PROMPT_str
 _MSG_SOFTWARE_MODE_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1. ~5KHz\r\n 2. ~50KHz\r\n 3. ~100KHz\r\n 4. ~400KHz"
+	.pasciz "\322\260e\304\266~5\275\261~50\275\2023\203~1\235\275\373\203~4\235\275"
 
 	; MSG_SPI_COULD_NOT_KEEP_UP
 	.section .text.MSG_SPI_COULD_NOT_KEEP_UP, code
 	.global _MSG_SPI_COULD_NOT_KEEP_UP_str
 _MSG_SPI_COULD_NOT_KEEP_UP_str:
-	.pasciz "Couldn't keep up"
+	.pasciz "Co\252dn'\204kee\251up"
 
 	; MSG_SPI_CS_DISABLED
 	.section .text.MSG_SPI_CS_DISABLED, code
 	.global _MSG_SPI_CS_DISABLED_str
 _MSG_SPI_CS_DISABLED_str:
-	.pasciz "CS DISABLED"
+	.pasciz "\312 D\314ABLED"
 
 	; MSG_SPI_CS_ENABLED
 	.section .text.MSG_SPI_CS_ENABLED, code
 	.global _MSG_SPI_CS_ENABLED_str
 _MSG_SPI_CS_ENABLED_str:
-	.pasciz "CS ENABLED"
+	.pasciz "\312 ENABLED"
 
 	; MSG_SPI_CS_MODE_PROMPT
 	.section .text.MSG_SPI_CS_MODE_PROMPT, code
 	.global _MSG_SPI_CS_MODE_PROMPT_str
 _MSG_SPI_CS_MODE_PROMPT_str:
-	.pasciz "CS:\r\n 1. CS\r\n 2. /CS *default"
+	.pasciz "\312\266\312\261/\312\307\226fa\252t"
 
 	; MSG_SPI_EDGE_PROMPT
 	.section .text.MSG_SPI_EDGE_PROMPT, code
 	.global _MSG_SPI_EDGE_PROMPT_str
 _MSG_SPI_EDGE_PROMPT_str:
-	.pasciz "Output clock edge:\r\n 1. Idle to active\r\n 2. Active to idle *default"
+	.pasciz "O\305pu\204c\242ck \304ge\266I\330\265\336e\261Ac\246v\205\265i\330*\226fa\252t"
+
+	; MSG_SPI_FLASH_MODE_IDENTIFIER
+	.section .text.MSG_SPI_FLASH_MODE_IDENTIFIER, code
+	.global _MSG_SPI_FLASH_MODE_IDENTIFIER_str
+_MSG_SPI_FLASH_MODE_IDENTIFIER_str:
+	.pasciz "FLS1"
 
 	; MSG_SPI_MACRO_MENU
 	.section .text.MSG_SPI_MACRO_MENU, code
 	.global _MSG_SPI_MACRO_MENU_str
 _MSG_SPI_MACRO_MENU_str:
-	.pasciz " 0.Macro menu\r\n 1.Sniff CS low\r\n 2.Sniff all traffic\r\n10.Set clock idle low\r\n11.Set clock idle high\r\n12.Set edge idle to active\r\n13.Set edge active to idle\r\n14.Sample phase on middle\r\n15.Sample phase on end"
+	.pasciz " \310\377\234.Sni\331 \312 \321\230.Sni\331 \255l \372a\331\332\317\310\322c\242ck i\330\321\3171.\322c\242ck i\330\256gh\3172.\322\304g\205i\330\265\336e\317\303\322\304g\205\336\205\265id\367\3174.Samp\245ph\366\205\222 midd\367\3175.Samp\245ph\366\205\222 \221d"
 
 	; MSG_SPI_MODE_HEADER_START
 	.section .text.MSG_SPI_MODE_HEADER_START, code
 	.global _MSG_SPI_MODE_HEADER_START_str
 _MSG_SPI_MODE_HEADER_START_str:
-	.pasciz "SPI (spd ckp ske smp csl hiz)=( "
+	.pasciz "SPI\206\260\220ck\251sk\205sm\251csl \256z)=( "
 
 	; MSG_SPI_MODE_IDENTIFIER
 	.section .text.MSG_SPI_MODE_IDENTIFIER, code
@@ -1604,31 +1694,37 @@ _MSG_SPI_MODE_IDENTIFIER_str:
 	.section .text.MSG_SPI_PINS_STATE, code
 	.global _MSG_SPI_PINS_STATE_str
 _MSG_SPI_PINS_STATE_str:
-	.pasciz "CLK\tMOSI\tCS\tMISO"
+	.pasciz "\311K\t\362SI\t\312\tM\375"
 
 	; MSG_SPI_POLARITY_PROMPT
 	.section .text.MSG_SPI_POLARITY_PROMPT, code
 	.global _MSG_SPI_POLARITY_PROMPT_str
 _MSG_SPI_POLARITY_PROMPT_str:
-	.pasciz "Clock polarity:\r\n 1. Idle low *default\r\n 2. Idle high"
+	.pasciz "C\242ck\342\270\232\216y\266I\330\321\307\226fa\252t\261I\330\256gh"
 
 	; MSG_SPI_SAMPLE_PROMPT
 	.section .text.MSG_SPI_SAMPLE_PROMPT, code
 	.global _MSG_SPI_SAMPLE_PROMPT_str
 _MSG_SPI_SAMPLE_PROMPT_str:
-	.pasciz "Input sample phase:\r\n 1. Middle *default\r\n 2. End"
+	.pasciz "Inpu\204samp\245pha\257\266Mid\330*\226fa\252t\261End"
 
 	; MSG_SPI_SPEED_PROMPT
 	.section .text.MSG_SPI_SPEED_PROMPT, code
 	.global _MSG_SPI_SPEED_PROMPT_str
 _MSG_SPI_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1.  30KHz\r\n 2. 125KHz\r\n 3. 250KHz\r\n 4.   1MHz\r\n 5.  50KHz\r\n 6. 1.3MHz\r\n 7.   2MHz\r\n 8. 2.6MHz\r\n 9. 3.2MHz\r\n10.   4MHz\r\n11. 5.3MHz\r\n12.   8MHz"
+	.pasciz "\322\260e\304\266 30\275\261125\275\2023\203250\275\373\203\3411\344\2025\203 50\275\2026\2031.3\344\2027\203\3412\344\2028\2032.6\344\2029\203\3032\344\3170\203\3414\344\3171\2035.3\344\3172\203\3418\344"
+
+	; MSG_SWD_MODE_IDENTIFIER
+	.section .text.MSG_SWD_MODE_IDENTIFIER, code
+	.global _MSG_SWD_MODE_IDENTIFIER_str
+_MSG_SWD_MODE_IDENTIFIER_str:
+	.pasciz "SWD1"
 
 	; MSG_UART_MODE_IDENTIFIER
 	.section .text.MSG_UART_MODE_IDENTIFIER, code
 	.global _MSG_UART_MODE_IDENTIFIER_str
 _MSG_UART_MODE_IDENTIFIER_str:
-	.pasciz "ART1"
+	.pasciz "\240T1"
 
 	; MSG_UART_PINS_STATE
 	.section .text.MSG_UART_PINS_STATE, code
@@ -1640,19 +1736,19 @@ _MSG_UART_PINS_STATE_str:
 	.section .text.MSG_UART_POSSIBLE_OVERFLOW, code
 	.global _MSG_UART_POSSIBLE_OVERFLOW_str
 _MSG_UART_POSSIBLE_OVERFLOW_str:
-	.pasciz "WARNING: Possible buffer overflow"
+	.pasciz "W\240N\360G\224Pos\350b\245bu\331\207 ov\207f\321"
 
 	; MSG_UART_RESET_TO_EXIT
 	.section .text.MSG_UART_RESET_TO_EXIT, code
 	.global _MSG_UART_RESET_TO_EXIT_str
 _MSG_UART_RESET_TO_EXIT_str:
-	.pasciz "Reset to exit"
+	.pasciz "\276\257\204\265\267\216"
 
 	; MSG_UNKNOWN_MACRO_ERROR
 	.section .text.MSG_UNKNOWN_MACRO_ERROR, code
 	.global _MSG_UNKNOWN_MACRO_ERROR_str
 _MSG_UNKNOWN_MACRO_ERROR_str:
-	.pasciz "Unknown macro, try ? or (0) for help"
+	.pasciz "Unk\347wn m\272o\223\372\237? \215\2060\236f\215 help"
 
 	; MSG_VOLTAGE_UNIT
 	.section .text.MSG_VOLTAGE_UNIT, code
@@ -1664,17 +1760,150 @@ _MSG_VOLTAGE_UNIT_str:
 	.section .text.MSG_VREG_TOO_LOW, code
 	.global _MSG_VREG_TOO_LOW_str
 _MSG_VREG_TOO_LOW_str:
-	.pasciz "VREG too low, is there a short?"
+	.pasciz "V\244G to\211\321\223i\213th\207\205a sh\215t?"
 
 	; MSG_WARNING_HEADER
 	.section .text.MSG_WARNING_HEADER, code
 	.global _MSG_WARNING_HEADER_str
 _MSG_WARNING_HEADER_str:
-	.pasciz "Warning: "
+	.pasciz "W\232n\210g\224"
 
 	; MSG_WARNING_SHORT_OR_NO_PULLUP
 	.section .text.MSG_WARNING_SHORT_OR_NO_PULLUP, code
 	.global _MSG_WARNING_SHORT_OR_NO_PULLUP_str
 _MSG_WARNING_SHORT_OR_NO_PULLUP_str:
-	.pasciz "*Short or no pull-up "
+	.pasciz "*Sh\215\204\215 n\211p\252l-u\251"
+
+	; Dictionary, one symbol pair per word
+	.section .text.bp_message_dictionary, code
+	.global _bp_message_dictionary
+_bp_message_dictionary:
+	.pword 0x0A0D	; 0x80 "\r\n"
+	.pword 0x2D2D	; 0x81 "--"
+	.pword 0x2080	; 0x82 "\r\n "
+	.pword 0x202E	; 0x83 ". "
+	.pword 0x2074	; 0x84 "t "
+	.pword 0x2065	; 0x85 "e "
+	.pword 0x2820	; 0x86 " ("
+	.pword 0x7265	; 0x87 "er"
+	.pword 0x6E69	; 0x88 "in"
+	.pword 0x206F	; 0x89 "o "
+	.pword 0x8181	; 0x8A "----"
+	.pword 0x2073	; 0x8B "s "
+	.pword 0x6572	; 0x8C "re"
+	.pword 0x726F	; 0x8D "or"
+	.pword 0x7469	; 0x8E "it"
+	.pword 0x0909	; 0x8F "\t\t"
+	.pword 0x2064	; 0x90 "d "
+	.pword 0x6E65	; 0x91 "en"
+	.pword 0x6E6F	; 0x92 "on"
+	.pword 0x202C	; 0x93 ", "
+	.pword 0x203A	; 0x94 ": "
+	.pword 0x6361	; 0x95 "ac"
+	.pword 0x6564	; 0x96 "de"
+	.pword 0x6574	; 0x97 "te"
+	.pword 0x3282	; 0x98 "\r\n 2"
+	.pword 0x7A48	; 0x99 "Hz"
+	.pword 0x7261	; 0x9A "ar"
+	.pword 0x6E61	; 0x9B "an"
+	.pword 0x3182	; 0x9C "\r\n 1"
+	.pword 0x3030	; 0x9D "00"
+	.pword 0x2029	; 0x9E ") "
+	.pword 0x2079	; 0x9F "y "
+	.pword 0x5241	; 0xA0 "AR"
+	.pword 0x4F52	; 0xA1 "RO"
+	.pword 0x6F6C	; 0xA2 "lo"
+	.pword 0x7473	; 0xA3 "st"
+	.pword 0x4552	; 0xA4 "RE"
+	.pword 0x856C	; 0xA5 "le "
+	.pword 0x6974	; 0xA6 "ti"
+	.pword 0x8A8A	; 0xA7 "--------"
+	.pword 0x7830	; 0xA8 "0x"
+	.pword 0x2070	; 0xA9 "p "
+	.pword 0x6C75	; 0xAA "ul"
+	.pword 0x5441	; 0xAB "AT"
+	.pword 0x6461	; 0xAC "ad"
+	.pword 0x6C61	; 0xAD "al"
+	.pword 0x6968	; 0xAE "hi"
+	.pword 0x6573	; 0xAF "se"
+	.pword 0x7073	; 0xB0 "sp"
+	.pword 0x8398	; 0xB1 "\r\n 2. "
+	.pword 0x839C	; 0xB2 "\r\n 1. "
+	.pword 0x6553	; 0xB3 "Se"
+	.pword 0x2067	; 0xB4 "g "
+	.pword 0x8974	; 0xB5 "to "
+	.pword 0xB23A	; 0xB6 ":\r\n 1. "
+	.pword 0x7865	; 0xB7 "ex"
+	.pword 0x6C6F	; 0xB8 "ol"
+	.pword 0xA886	; 0xB9 " (0x"
+	.pword 0x7295	; 0xBA "acr"
+	.pword 0x0929	; 0xBB ")\t"
+	.pword 0x4441	; 0xBC "AD"
+	.pword 0x994B	; 0xBD "KHz"
+	.pword 0x6552	; 0xBE "Re"
+	.pword 0x4DA1	; 0xBF "ROM"
+	.pword 0x5320	; 0xC0 " S"
+	.pword 0xBF20	; 0xC1 " ROM"
+	.pword 0x3631	; 0xC2 "16"
+	.pword 0x2E33	; 0xC3 "3."
+	.pword 0x6465	; 0xC4 "ed"
+	.pword 0x7475	; 0xC5 "ut"
+	.pword 0x89BA	; 0xC6 "acro "
+	.pword 0x2A20	; 0xC7 " *"
+	.pword 0x2E30	; 0xC8 "0."
+	.pword 0x4C43	; 0xC9 "CL"
+	.pword 0x5343	; 0xCA "CS"
+	.pword 0x5245	; 0xCB "ER"
+	.pword 0x5349	; 0xCC "IS"
+	.pword 0x8469	; 0xCD "it "
+	.pword 0x6F6D	; 0xCE "mo"
+	.pword 0x3180	; 0xCF "\r\n1"
+	.pword 0xA695	; 0xD0 "acti"
+	.pword 0x77A2	; 0xD1 "low"
+	.pword 0x84B3	; 0xD2 "Set "
+	.pword 0xB9C1	; 0xD3 " ROM (0x"
+	.pword 0x5541	; 0xD4 "AU"
+	.pword 0xC64D	; 0xD5 "Macro "
+	.pword 0x2054	; 0xD6 "T "
+	.pword 0x9761	; 0xD7 "ate"
+	.pword 0xA564	; 0xD8 "dle "
+	.pword 0x6666	; 0xD9 "ff"
+	.pword 0x6369	; 0xDA "ic"
+	.pword 0x916D	; 0xDB "men"
+	.pword 0x2088	; 0xDC "in "
+	.pword 0x098F	; 0xDD "\t\t\t"
+	.pword 0x76D0	; 0xDE "activ"
+	.pword 0x58D4	; 0xDF "AUX"
+	.pword 0x5309	; 0xE0 "\tS"
+	.pword 0x2020	; 0xE1 "  "
+	.pword 0x7020	; 0xE2 " p"
+	.pword 0x4843	; 0xE3 "CH"
+	.pword 0x994D	; 0xE4 "MHz"
+	.pword 0x5550	; 0xE5 "PU"
+	.pword 0x6863	; 0xE6 "ch"
+	.pword 0x6F6E	; 0xE7 "no"
+	.pword 0x6973	; 0xE8 "si"
+	.pword 0x7375	; 0xE9 "us"
+	.pword 0x282E	; 0xEA ".("
+	.pword 0x4332	; 0xEB "2C"
+	.pword 0x4B43	; 0xEC "CK"
+	.pword 0x4544	; 0xED "DE"
+	.pword 0xAB44	; 0xEE "DAT"
+	.pword 0x6948	; 0xEF "Hi"
+	.pword 0x4E49	; 0xF0 "IN"
+	.pword 0xEB49	; 0xF1 "I2C"
+	.pword 0x4F4D	; 0xF2 "MO"
+	.pword 0x444E	; 0xF3 "ND"
+	.pword 0x4E4F	; 0xF4 "ON"
+	.pword 0x4553	; 0xF5 "SE"
+	.pword 0x7361	; 0xF6 "as"
+	.pword 0x656C	; 0xF7 "le"
+	.pword 0x6D6D	; 0xF8 "mm"
+	.pword 0x746F	; 0xF9 "ot"
+	.pword 0x7274	; 0xFA "tr"
+	.pword 0x3482	; 0xFB "\r\n 4"
+	.pword 0xA7A7	; 0xFC "----------------"
+	.pword 0x4FCC	; 0xFD "ISO"
+	.pword 0xDBD5	; 0xFE "Macro men"
+	.pword 0x75FE	; 0xFF "Macro menu"
 
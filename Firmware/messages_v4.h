@@ -1,6 +1,10 @@
 #ifndef BP_MESSAGES_V4_H
 #define BP_MESSAGES_V4_H
 
+#define BP_MESSAGES_COMPRESSED
+#define BP_MESSAGE_DICTIONARY_DEPTH 5
+void bp_message_dictionary(void);
+
 void BPMSG1022_str(void);
 #define BPMSG1022 bp_message_write_buffer(__builtin_tbladdress(BPMSG1022_str))
 void BPMSG1023_str(void);
@@ -383,6 +387,10 @@ void MSG_1WIRE_NO_DEVICE_str(void);
 #define MSG_1WIRE_NO_DEVICE bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_NO_DEVICE_str))
 void MSG_1WIRE_NO_DEVICE_DETECTED_str(void);
 #define MSG_1WIRE_NO_DEVICE_DETECTED bp_message_write_buffer(__builtin_tbladdress(MSG_1WIRE_NO_DEVICE_DETECTED_str))
+void MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str(void);
+#define MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str))
+void MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str(void);
+#define MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str))
 void MSG_1WIRE_PINS_STATE_str(void);
 #define MSG_1WIRE_PINS_STATE bp_message_write_line(__builtin_tbladdress(MSG_1WIRE_PINS_STATE_str))
 void MSG_1WIRE_READ_ROM_MACRO_NAME_str(void);
@@ -425,6 +433,18 @@ void MSG_CLUTCH_ENGAGED_str(void);
 #define MSG_CLUTCH_ENGAGED bp_message_write_line(__builtin_tbladdress(MSG_CLUTCH_ENGAGED_str))
 void MSG_COMMAND_HAS_NO_EFFECT_str(void);
 #define MSG_COMMAND_HAS_NO_EFFECT bp_message_write_line(__builtin_tbladdress(MSG_COMMAND_HAS_NO_EFFECT_str))
+void MSG_DIO_MACRO_MENU_str(void);
+#define MSG_DIO_MACRO_MENU bp_message_write_line(__builtin_tbladdress(MSG_DIO_MACRO_MENU_str))
+void MSG_DIO_NOTHING_RECORDED_str(void);
+#define MSG_DIO_NOTHING_RECORDED bp_message_write_line(__builtin_tbladdress(MSG_DIO_NOTHING_RECORDED_str))
+void MSG_DIO_RECORDING_str(void);
+#define MSG_DIO_RECORDING bp_message_write_line(__builtin_tbladdress(MSG_DIO_RECORDING_str))
+void MSG_DIO_RECORDING_FULL_str(void);
+#define MSG_DIO_RECORDING_FULL bp_message_write_line(__builtin_tbladdress(MSG_DIO_RECORDING_FULL_str))
+void MSG_DIO_STEP_PERIOD_str(void);
+#define MSG_DIO_STEP_PERIOD bp_message_write_buffer(__builtin_tbladdress(MSG_DIO_STEP_PERIOD_str))
+void MSG_DIO_STEP_PERIOD_RANGE_str(void);
+#define MSG_DIO_STEP_PERIOD_RANGE bp_message_write_line(__builtin_tbladdress(MSG_DIO_STEP_PERIOD_RANGE_str))
 void MSG_FINISH_SETUP_PROMPT_str(void);
 #define MSG_FINISH_SETUP_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_FINISH_SETUP_PROMPT_str))
 void MSG_HEXADECIMAL_NUMBER_PREFIX_str(void);
@@ -457,6 +477,12 @@ void MSG_KEYBOARD_LIVE_INPUT_START_str(void);
 #define MSG_KEYBOARD_LIVE_INPUT_START bp_message_write_line(__builtin_tbladdress(MSG_KEYBOARD_LIVE_INPUT_START_str))
 void MSG_KEYBOARD_MACRO_MENU_str(void);
 #define MSG_KEYBOARD_MACRO_MENU bp_message_write_line(__builtin_tbladdress(MSG_KEYBOARD_MACRO_MENU_str))
+void MSG_MEMORY_USAGE_ARENA_PEAKS_str(void);
+#define MSG_MEMORY_USAGE_ARENA_PEAKS bp_message_write_buffer(__builtin_tbladdress(MSG_MEMORY_USAGE_ARENA_PEAKS_str))
+void MSG_MEMORY_USAGE_BYTES_str(void);
+#define MSG_MEMORY_USAGE_BYTES bp_message_write_line(__builtin_tbladdress(MSG_MEMORY_USAGE_BYTES_str))
+void MSG_MEMORY_USAGE_STACK_str(void);
+#define MSG_MEMORY_USAGE_STACK bp_message_write_buffer(__builtin_tbladdress(MSG_MEMORY_USAGE_STACK_str))
 void MSG_MODE_HEADER_END_str(void);
 #define MSG_MODE_HEADER_END bp_message_write_line(__builtin_tbladdress(MSG_MODE_HEADER_END_str))
 void MSG_NACK_str(void);
@@ -537,6 +563,12 @@ void MSG_RAW2WIRE_MACRO_MENU_str(void);
 #define MSG_RAW2WIRE_MACRO_MENU bp_message_write_buffer(__builtin_tbladdress(MSG_RAW2WIRE_MACRO_MENU_str))
 void MSG_RAW2WIRE_MODE_HEADER_str(void);
 #define MSG_RAW2WIRE_MODE_HEADER bp_message_write_buffer(__builtin_tbladdress(MSG_RAW2WIRE_MODE_HEADER_str))
+void MSG_RAW2WIRE_T0_ATR_str(void);
+#define MSG_RAW2WIRE_T0_ATR bp_message_write_buffer(__builtin_tbladdress(MSG_RAW2WIRE_T0_ATR_str))
+void MSG_RAW2WIRE_T0_DEACTIVATED_str(void);
+#define MSG_RAW2WIRE_T0_DEACTIVATED bp_message_write_line(__builtin_tbladdress(MSG_RAW2WIRE_T0_DEACTIVATED_str))
+void MSG_RAW2WIRE_T0_NO_ANSWER_str(void);
+#define MSG_RAW2WIRE_T0_NO_ANSWER bp_message_write_line(__builtin_tbladdress(MSG_RAW2WIRE_T0_NO_ANSWER_str))
 void MSG_RAW3WIRE_MODE_HEADER_str(void);
 #define MSG_RAW3WIRE_MODE_HEADER bp_message_write_buffer(__builtin_tbladdress(MSG_RAW3WIRE_MODE_HEADER_str))
 void MSG_RAW_BRG_VALUE_INPUT_str(void);
@@ -559,6 +591,8 @@ void MSG_SPI_CS_MODE_PROMPT_str(void);
 #define MSG_SPI_CS_MODE_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_CS_MODE_PROMPT_str))
 void MSG_SPI_EDGE_PROMPT_str(void);
 #define MSG_SPI_EDGE_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_EDGE_PROMPT_str))
+void MSG_SPI_FLASH_MODE_IDENTIFIER_str(void);
+#define MSG_SPI_FLASH_MODE_IDENTIFIER bp_message_write_buffer(__builtin_tbladdress(MSG_SPI_FLASH_MODE_IDENTIFIER_str))
 void MSG_SPI_MACRO_MENU_str(void);
 #define MSG_SPI_MACRO_MENU bp_message_write_line(__builtin_tbladdress(MSG_SPI_MACRO_MENU_str))
 void MSG_SPI_MODE_HEADER_START_str(void);
@@ -573,6 +607,8 @@ void MSG_SPI_SAMPLE_PROMPT_str(void);
 #define MSG_SPI_SAMPLE_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_SAMPLE_PROMPT_str))
 void MSG_SPI_SPEED_PROMPT_str(void);
 #define MSG_SPI_SPEED_PROMPT bp_message_write_line(__builtin_tbladdress(MSG_SPI_SPEED_PROMPT_str))
+void MSG_SWD_MODE_IDENTIFIER_str(void);
+#define MSG_SWD_MODE_IDENTIFIER bp_message_write_buffer(__builtin_tbladdress(MSG_SWD_MODE_IDENTIFIER_str))
 void MSG_UART_MODE_IDENTIFIER_str(void);
 #define MSG_UART_MODE_IDENTIFIER bp_message_write_buffer(__builtin_tbladdress(MSG_UART_MODE_IDENTIFIER_str))
 void MSG_UART_NORMAL_TO_EXIT_str(void);
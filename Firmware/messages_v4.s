@@ -2,199 +2,199 @@
 	.section .text.BPMSG1022, code
 	.global _BPMSG1022_str
 _BPMSG1022_str:
-	.pasciz "DS18S20 High Prec Dig Therm"
+	.pasciz "DS18S20 \375gh P\215c Di\251Th\212m"
 
 	; BPMSG1023
 	.section .text.BPMSG1023, code
 	.global _BPMSG1023_str
 _BPMSG1023_str:
-	.pasciz "DS18B20 Prog Res Dig Therm"
+	.pasciz "DS18B20 Pro\251\313\216Di\251Th\212m"
 
 	; BPMSG1024
 	.section .text.BPMSG1024, code
 	.global _BPMSG1024_str
 _BPMSG1024_str:
-	.pasciz "DS1822 Econo Dig Therm"
+	.pasciz "DS1822 E\356\211Di\251Th\212m"
 
 	; BPMSG1025
 	.section .text.BPMSG1025, code
 	.global _BPMSG1025_str
 _BPMSG1025_str:
-	.pasciz "DS2404 EconoRAM time Chip"
+	.pasciz "DS2404 E\356oRAM \240m\205C\272p"
 
 	; BPMSG1026
 	.section .text.BPMSG1026, code
 	.global _BPMSG1026_str
 _BPMSG1026_str:
-	.pasciz "DS2431 1K EEPROM"
+	.pasciz "DS2431 1K EEP\253"
 
 	; BPMSG1027
 	.section .text.BPMSG1027, code
 	.global _BPMSG1027_str
 _BPMSG1027_str:
-	.pasciz "Unknown device"
+	.pasciz "Unk\361wn \231v\341e"
 
 	; BPMSG1028
 	.section .text.BPMSG1028, code
 	.global _BPMSG1028_str
 _BPMSG1028_str:
-	.pasciz "PWM disabled"
+	.pasciz "PWM d\360\336l\261"
 
 	; BPMSG1029
 	.section .text.BPMSG1029, code
 	.global _BPMSG1029_str
 _BPMSG1029_str:
-	.pasciz "1KHz-4,000KHz PWM"
+	.pasciz "1\304-4,\2420\304 PWM"
 
 	; BPMSG1030
 	.section .text.BPMSG1030, code
 	.global _BPMSG1030_str
 _BPMSG1030_str:
-	.pasciz "Frequency in KHz "
+	.pasciz "F\215qu\224c\234\206 \304 "
 
 	; BPMSG1033
 	.section .text.BPMSG1033, code
 	.global _BPMSG1033_str
 _BPMSG1033_str:
-	.pasciz "Duty cycle in % "
+	.pasciz "Dut\234cyc\252\206 % "
 
 	; BPMSG1034
 	.section .text.BPMSG1034, code
 	.global _BPMSG1034_str
 _BPMSG1034_str:
-	.pasciz "PWM active"
+	.pasciz "PWM \346e"
 
 	; BPMSG1037
 	.section .text.BPMSG1037, code
 	.global _BPMSG1037_str
 _BPMSG1037_str:
-	.pasciz "ERROR: PWM active, g to disable"
+	.pasciz "\321\232R\230PWM \346e\222\251\266d\360\336\342"
 
 	; BPMSG1038
 	.section .text.BPMSG1038, code
 	.global _BPMSG1038_str
 _BPMSG1038_str:
-	.pasciz "AUX Frequency: "
+	.pasciz "\301 F\215qu\224cy\230"
 
 	; BPMSG1039
 	.section .text.BPMSG1039, code
 	.global _BPMSG1039_str
 _BPMSG1039_str:
-	.pasciz "AUX INPUT/HI-Z"
+	.pasciz "\301 INPUT/HI-Z"
 
 	; BPMSG1040
 	.section .text.BPMSG1040, code
 	.global _BPMSG1040_str
 _BPMSG1040_str:
-	.pasciz "AUX HIGH"
+	.pasciz "\301 HIGH"
 
 	; BPMSG1041
 	.section .text.BPMSG1041, code
 	.global _BPMSG1041_str
 _BPMSG1041_str:
-	.pasciz "AUX LOW"
+	.pasciz "\301\370OW"
 
 	; BPMSG1047
 	.section .text.BPMSG1047, code
 	.global _BPMSG1047_str
 _BPMSG1047_str:
-	.pasciz "Error("
+	.pasciz "Err\221("
 
 	; BPMSG1048
 	.section .text.BPMSG1048, code
 	.global _BPMSG1048_str
 _BPMSG1048_str:
-	.pasciz ") @line:"
+	.pasciz "\235@l\206e:"
 
 	; BPMSG1049
 	.section .text.BPMSG1049, code
 	.global _BPMSG1049_str
 _BPMSG1049_str:
-	.pasciz " @pgmspace:"
+	.pasciz " @pgm\265\225e:"
 
 	; BPMSG1050
 	.section .text.BPMSG1050, code
 	.global _BPMSG1050_str
 _BPMSG1050_str:
-	.pasciz " bytes."
+	.pasciz " by\226s."
 
 	; BPMSG1051
 	.section .text.BPMSG1051, code
 	.global _BPMSG1051_str
 _BPMSG1051_str:
-	.pasciz "Too long!"
+	.pasciz "To\211l\213g!"
 
 	; BPMSG1052
 	.section .text.BPMSG1052, code
 	.global _BPMSG1052_str
 _BPMSG1052_str:
-	.pasciz "Syntax error"
+	.pasciz "Syntax \212r\221"
 
 	; BPMSG1053
 	.section .text.BPMSG1053, code
 	.global _BPMSG1053_str
 _BPMSG1053_str:
-	.pasciz "No EEPROM"
+	.pasciz "N\211EEP\253"
 
 	; BPMSG1054
 	.section .text.BPMSG1054, code
 	.global _BPMSG1054_str
 _BPMSG1054_str:
-	.pasciz "Erasing"
+	.pasciz "Er\337\206g"
 
 	; BPMSG1055
 	.section .text.BPMSG1055, code
 	.global _BPMSG1055_str
 _BPMSG1055_str:
-	.pasciz "done"
+	.pasciz "d\213e"
 
 	; BPMSG1056
 	.section .text.BPMSG1056, code
 	.global _BPMSG1056_str
 _BPMSG1056_str:
-	.pasciz "Saving to slot "
+	.pasciz "Sav\331\266s\243\203"
 
 	; BPMSG1057
 	.section .text.BPMSG1057, code
 	.global _BPMSG1057_str
 _BPMSG1057_str:
-	.pasciz "Invalid slot"
+	.pasciz "Inv\247i\210s\243t"
 
 	; BPMSG1058
 	.section .text.BPMSG1058, code
 	.global _BPMSG1058_str
 _BPMSG1058_str:
-	.pasciz "Loading from slot "
+	.pasciz "Lo\260\331fr\326\302\243\203"
 
 	; BPMSG1064
 	.section .text.BPMSG1064, code
 	.global _BPMSG1064_str
 _BPMSG1064_str:
-	.pasciz "I2C mode:\r\n 1. Software\r\n 2. Hardware"
+	.pasciz "\376 \325\231\273Softwa\215\267H\223dwa\215"
 
 	; BPMSG1067
 	.section .text.BPMSG1067, code
 	.global _BPMSG1067_str
 _BPMSG1067_str:
-	.pasciz "Set speed:\r\n 1. 100KHz\r\n 2. 400KHz\r\n 3. 1MHz"
+	.pasciz "\315\265e\261\2731\242\304\2674\242\304\2013\2041\353"
 
 	; BPMSG1068
 	.section .text.BPMSG1068, code
 	.global _BPMSG1068_str
 _BPMSG1068_str:
-	.pasciz "I2C (mod spd)=( "
+	.pasciz "\376\207\325\210\265d)=( "
 
 	; BPMSG1069
 	.section .text.BPMSG1069, code
 	.global _BPMSG1069_str
 _BPMSG1069_str:
-	.pasciz " 0.Macro menu\r\n 1.7bit address search\r\n 2.I2C sniffer\r\n 3.Connect to on-board EEPROM\r\n 4.Enable Writing the on-board EEPROM"
+	.pasciz " \334\335\343u\237.7b\324\260d\345\216se\223\355\233.\376\302niff\212\201\303C\213nec\203\266\213-bo\223\210EEP\253\364.En\336\252Wr\217\331th\205\213-bo\223\210EEP\253"
 
 	; BPMSG1070
 	.section .text.BPMSG1070, code
 	.global _BPMSG1070_str
 _BPMSG1070_str:
-	.pasciz "Searching I2C address space. Found devices at:"
+	.pasciz "\257\223\355\331\376 \260d\345\216\265\225e\204F\327n\210\231v\341e\216at:"
 
 	; BPMSG1084
 	.section .text.BPMSG1084, code
@@ -206,247 +206,247 @@ _BPMSG1084_str:
 	.section .text.BPMSG1085, code
 	.global _BPMSG1085_str
 _BPMSG1085_str:
-	.pasciz "Ready"
+	.pasciz "\313\260y"
 
 	; BPMSG1086
 	.section .text.BPMSG1086, code
 	.global _BPMSG1086_str
 _BPMSG1086_str:
-	.pasciz "a/A/@ controls AUX pin"
+	.pasciz "a/A/@ \356\344\254\216\301 \330"
 
 	; BPMSG1087
 	.section .text.BPMSG1087, code
 	.global _BPMSG1087_str
 _BPMSG1087_str:
-	.pasciz "a/A/@ controls CS pin"
+	.pasciz "a/A/@ \356\344\254\216\320 \330"
 
 	; BPMSG1088
 	.section .text.BPMSG1088, code
 	.global _BPMSG1088_str
 _BPMSG1088_str:
-	.pasciz "Command not used in this mode"
+	.pasciz "C\326m\241\210\361\203\276e\210\206 t\272\216\325\231"
 
 	; BPMSG1089
 	.section .text.BPMSG1089, code
 	.global _BPMSG1089_str
 _BPMSG1089_str:
-	.pasciz "Pull-up resistors OFF"
+	.pasciz "P\350-\363\345i\244\221\216OFF"
 
 	; BPMSG1091
 	.section .text.BPMSG1091, code
 	.global _BPMSG1091_str
 _BPMSG1091_str:
-	.pasciz "Pull-up resistors ON"
+	.pasciz "P\350-\363\345i\244\221\216ON"
 
 	; BPMSG1092
 	.section .text.BPMSG1092, code
 	.global _BPMSG1092_str
 _BPMSG1092_str:
-	.pasciz "Self-test in HiZ mode only"
+	.pasciz "\257lf-\226s\203\206 \375Z \325d\205\213ly"
 
 	; BPMSG1093
 	.section .text.BPMSG1093, code
 	.global _BPMSG1093_str
 _BPMSG1093_str:
-	.pasciz "RESET"
+	.pasciz "\246\354T"
 
 	; BPMSG1094
 	.section .text.BPMSG1094, code
 	.global _BPMSG1094_str
 _BPMSG1094_str:
-	.pasciz "BOOTLOADER"
+	.pasciz "BOOTLO\274\321"
 
 	; BPMSG1095
 	.section .text.BPMSG1095, code
 	.global _BPMSG1095_str
 _BPMSG1095_str:
-	.pasciz "AUX INPUT/HI-Z, READ: "
+	.pasciz "\301 INPUT/HI-Z\222\246\274\230"
 
 	; BPMSG1096
 	.section .text.BPMSG1096, code
 	.global _BPMSG1096_str
 _BPMSG1096_str:
-	.pasciz "POWER SUPPLIES ON"
+	.pasciz "POW\321\307UPPLIES ON"
 
 	; BPMSG1097
 	.section .text.BPMSG1097, code
 	.global _BPMSG1097_str
 _BPMSG1097_str:
-	.pasciz "POWER SUPPLIES OFF"
+	.pasciz "POW\321\307UPPLIES OFF"
 
 	; BPMSG1098
 	.section .text.BPMSG1098, code
 	.global _BPMSG1098_str
 _BPMSG1098_str:
-	.pasciz "DATA STATE: "
+	.pasciz "\374A\307T\263E\230"
 
 	; BPMSG1099
 	.section .text.BPMSG1099, code
 	.global _BPMSG1099_str
 _BPMSG1099_str:
-	.pasciz "DELAY "
+	.pasciz "\373LAY "
 
 	; BPMSG1100
 	.section .text.BPMSG1100, code
 	.global _BPMSG1100_str
 _BPMSG1100_str:
-	.pasciz "us"
+	.pasciz "\276"
 
 	; BPMSG1101
 	.section .text.BPMSG1101, code
 	.global _BPMSG1101_str
 _BPMSG1101_str:
-	.pasciz "WRITE: "
+	.pasciz "WRITE\230"
 
 	; BPMSG1102
 	.section .text.BPMSG1102, code
 	.global _BPMSG1102_str
 _BPMSG1102_str:
-	.pasciz "READ: "
+	.pasciz "\246\274\230"
 
 	; BPMSG1103
 	.section .text.BPMSG1103, code
 	.global _BPMSG1103_str
 _BPMSG1103_str:
-	.pasciz "CLOCK, 1"
+	.pasciz "\312O\372\2221"
 
 	; BPMSG1104
 	.section .text.BPMSG1104, code
 	.global _BPMSG1104_str
 _BPMSG1104_str:
-	.pasciz "CLOCK, 0"
+	.pasciz "\312O\372\2220"
 
 	; BPMSG1105
 	.section .text.BPMSG1105, code
 	.global _BPMSG1105_str
 _BPMSG1105_str:
-	.pasciz "DATA OUTPUT, 1"
+	.pasciz "\374A OUTPUT\2221"
 
 	; BPMSG1106
 	.section .text.BPMSG1106, code
 	.global _BPMSG1106_str
 _BPMSG1106_str:
-	.pasciz "DATA OUTPUT, 0"
+	.pasciz "\374A OUTPUT\2220"
 
 	; BPMSG1107
 	.section .text.BPMSG1107, code
 	.global _BPMSG1107_str
 _BPMSG1107_str:
-	.pasciz " *pin is now HiZ"
+	.pasciz "\333\330 i\216\361w \375Z"
 
 	; BPMSG1108
 	.section .text.BPMSG1108, code
 	.global _BPMSG1108_str
 _BPMSG1108_str:
-	.pasciz "CLOCK TICKS: "
+	.pasciz "\312O\372 TI\372S\230"
 
 	; BPMSG1109
 	.section .text.BPMSG1109, code
 	.global _BPMSG1109_str
 _BPMSG1109_str:
-	.pasciz "READ BIT: "
+	.pasciz "\246\274 BIT\230"
 
 	; BPMSG1110
 	.section .text.BPMSG1110, code
 	.global _BPMSG1110_str
 _BPMSG1110_str:
-	.pasciz "Syntax error at char "
+	.pasciz "Syntax \212r\221 a\203\355\223 "
 
 	; BPMSG1111
 	.section .text.BPMSG1111, code
 	.global _BPMSG1111_str
 _BPMSG1111_str:
-	.pasciz "x. exit(without change)"
+	.pasciz "x\204\271\217(w\217h\327\203\355\241ge)"
 
 	; BPMSG1112
 	.section .text.BPMSG1112, code
 	.global _BPMSG1112_str
 _BPMSG1112_str:
-	.pasciz "no mode change"
+	.pasciz "n\211\325d\205\355\241ge"
 
 	; BPMSG1114
 	.section .text.BPMSG1114, code
 	.global _BPMSG1114_str
 _BPMSG1114_str:
-	.pasciz "Nonexistent protocol!"
+	.pasciz "N\213\271i\244\224\203pro\362c\254!"
 
 	; BPMSG1115
 	.section .text.BPMSG1115, code
 	.global _BPMSG1115_str
 _BPMSG1115_str:
-	.pasciz "x. exit"
+	.pasciz "x\204\271\217"
 
 	; BPMSG1117
 	.section .text.BPMSG1117, code
 	.global _BPMSG1117_str
 _BPMSG1117_str:
-	.pasciz "DEVID:"
+	.pasciz "\373VID:"
 
 	; BPMSG1118
 	.section .text.BPMSG1118, code
 	.global _BPMSG1118_str
 _BPMSG1118_str:
-	.pasciz "http://dangerousprototypes.com"
+	.pasciz "http://d\241g\212\327\265ro\362types.c\326"
 
 	; BPMSG1119
 	.section .text.BPMSG1119, code
 	.global _BPMSG1119_str
 _BPMSG1119_str:
-	.pasciz "*----------*"
+	.pasciz "*\255\202*"
 
 	; BPMSG1120
 	.section .text.BPMSG1120, code
 	.global _BPMSG1120_str
 _BPMSG1120_str:
-	.pasciz "Open drain outputs (H=Hi-Z, L=GND)"
+	.pasciz "Op\224 dra\206 \327t\275ts\207H=\375-Z\222L=GND)"
 
 	; BPMSG1121
 	.section .text.BPMSG1121, code
 	.global _BPMSG1121_str
 _BPMSG1121_str:
-	.pasciz "Normal outputs (H=3.3v, L=GND)"
+	.pasciz "N\221m\247 \327t\275ts\207H=\3033v\222L=GND)"
 
 	; BPMSG1123
 	.section .text.BPMSG1123, code
 	.global _BPMSG1123_str
 _BPMSG1123_str:
-	.pasciz "MSB set: MOST sig bit first"
+	.pasciz "MSB\302\357\230\377ST\302i\251b\324fir\244"
 
 	; BPMSG1124
 	.section .text.BPMSG1124, code
 	.global _BPMSG1124_str
 _BPMSG1124_str:
-	.pasciz "LSB set: LEAST sig bit first"
+	.pasciz "LSB\302\357\230LEAST\302i\251b\324fir\244"
 
 	; BPMSG1127
 	.section .text.BPMSG1127, code
 	.global _BPMSG1127_str
 _BPMSG1127_str:
-	.pasciz " 1. HEX\r\n 2. DEC\r\n 3. BIN\r\n 4. RAW"
+	.pasciz " 1\204HEX\267\373C\2013\204BIN\364\204RAW\2015\204DUMP"
 
 	; BPMSG1128
 	.section .text.BPMSG1128, code
 	.global _BPMSG1128_str
 _BPMSG1128_str:
-	.pasciz "Display format set"
+	.pasciz "Di\265la\234f\221ma\203s\357"
 
 	; BPMSG1133
 	.section .text.BPMSG1133, code
 	.global _BPMSG1133_str
 _BPMSG1133_str:
-	.pasciz "Set serial port speed: (bps)\r\n 1. 300\r\n 2. 1200\r\n 3. 2400\r\n 4. 4800\r\n 5. 9600\r\n 6. 19200\r\n 7. 38400\r\n 8. 57600\r\n 9. 115200\r\n10. Input Custom BAUD\r\n11. Auto-Baud Detection (Activity Required)"
+	.pasciz "\315s\212i\247 p\221\203\265e\261:\207bps)\2703\242\26712\242\2013\20424\242\364\20448\242\2015\20496\242\2016\204192\242\2017\204384\242\2018\204576\242\2019\2041152\242\3140\204In\275\203Cu\244\326 B\264D\3141\204Au\362-Bau\210De\226c\240\213\207Ac\305\217\234\313qui\215d)"
 
 	; BPMSG1134
 	.section .text.BPMSG1134, code
 	.global _BPMSG1134_str
 _BPMSG1134_str:
-	.pasciz "Adjust your terminal"
+	.pasciz "Adj\276\203y\327r t\212m\206\247"
 
 	; BPMSG1135
 	.section .text.BPMSG1135, code
 	.global _BPMSG1135_str
 _BPMSG1135_str:
-	.pasciz "Are you sure? "
+	.pasciz "Ar\205y\327\302u\215? "
 
 	; BPMSG1136
 	.section .text.BPMSG1136, code
@@ -464,25 +464,25 @@ _BPMSG1137_str:
 	.section .text.BPMSG1163, code
 	.global _BPMSG1163_str
 _BPMSG1163_str:
-	.pasciz "Disconnect any devices\r\nConnect (ADC to +3.3V)"
+	.pasciz "D\360\356nec\203\241\234\231v\341es\200C\213nec\203(\274C \266+\3033V)"
 
 	; BPMSG1164
 	.section .text.BPMSG1164, code
 	.global _BPMSG1164_str
 _BPMSG1164_str:
-	.pasciz "Ctrl"
+	.pasciz "C\344l"
 
 	; BPMSG1165
 	.section .text.BPMSG1165, code
 	.global _BPMSG1165_str
 _BPMSG1165_str:
-	.pasciz "AUX"
+	.pasciz "\301"
 
 	; BPMSG1166
 	.section .text.BPMSG1166, code
 	.global _BPMSG1166_str
 _BPMSG1166_str:
-	.pasciz "MODE LED"
+	.pasciz "\377\373\370ED"
 
 	; BPMSG1167
 	.section .text.BPMSG1167, code
@@ -494,19 +494,19 @@ _BPMSG1167_str:
 	.section .text.BPMSG1168, code
 	.global _BPMSG1168_str
 _BPMSG1168_str:
-	.pasciz "PULLUP L"
+	.pasciz "PULLUP\370"
 
 	; BPMSG1169
 	.section .text.BPMSG1169, code
 	.global _BPMSG1169_str
 _BPMSG1169_str:
-	.pasciz "VREG"
+	.pasciz "V\246G"
 
 	; BPMSG1170
 	.section .text.BPMSG1170, code
 	.global _BPMSG1170_str
 _BPMSG1170_str:
-	.pasciz "ADC and supply"
+	.pasciz "\274C \241\210supply"
 
 	; BPMSG1171
 	.section .text.BPMSG1171, code
@@ -524,73 +524,73 @@ _BPMSG1172_str:
 	.section .text.BPMSG1173, code
 	.global _BPMSG1173_str
 _BPMSG1173_str:
-	.pasciz "3.3V"
+	.pasciz "\3033V"
 
 	; BPMSG1174
 	.section .text.BPMSG1174, code
 	.global _BPMSG1174_str
 _BPMSG1174_str:
-	.pasciz "ADC"
+	.pasciz "\274C"
 
 	; BPMSG1175
 	.section .text.BPMSG1175, code
 	.global _BPMSG1175_str
 _BPMSG1175_str:
-	.pasciz "Bus high"
+	.pasciz "Bu\216\272gh"
 
 	; BPMSG1176
 	.section .text.BPMSG1176, code
 	.global _BPMSG1176_str
 _BPMSG1176_str:
-	.pasciz "Bus Hi-Z 0"
+	.pasciz "Bu\216\375-Z 0"
 
 	; BPMSG1177
 	.section .text.BPMSG1177, code
 	.global _BPMSG1177_str
 _BPMSG1177_str:
-	.pasciz "Bus Hi-Z 1"
+	.pasciz "Bu\216\375-Z 1"
 
 	; BPMSG1178
 	.section .text.BPMSG1178, code
 	.global _BPMSG1178_str
 _BPMSG1178_str:
-	.pasciz "MODE, VREG, and USB LEDs should be on!"
+	.pasciz "\377\373\222V\246G\222\241\210USB\370ED\216sho\245\210b\205\213!"
 
 	; BPMSG1179
 	.section .text.BPMSG1179, code
 	.global _BPMSG1179_str
 _BPMSG1179_str:
-	.pasciz "Found "
+	.pasciz "F\327n\210"
 
 	; BPMSG1180
 	.section .text.BPMSG1180, code
 	.global _BPMSG1180_str
 _BPMSG1180_str:
-	.pasciz " errors."
+	.pasciz " \212r\221s."
 
 	; BPMSG1181
 	.section .text.BPMSG1181, code
 	.global _BPMSG1181_str
 _BPMSG1181_str:
-	.pasciz "MOSI"
+	.pasciz "\377SI"
 
 	; BPMSG1182
 	.section .text.BPMSG1182, code
 	.global _BPMSG1182_str
 _BPMSG1182_str:
-	.pasciz "CLK"
+	.pasciz "\312K"
 
 	; BPMSG1183
 	.section .text.BPMSG1183, code
 	.global _BPMSG1183_str
 _BPMSG1183_str:
-	.pasciz "MISO"
+	.pasciz "M\322O"
 
 	; BPMSG1184
 	.section .text.BPMSG1184, code
 	.global _BPMSG1184_str
 _BPMSG1184_str:
-	.pasciz "CS"
+	.pasciz "\320"
 
 	; BPMSG1185
 	.section .text.BPMSG1185, code
@@ -608,7 +608,7 @@ _BPMSG1186_str:
 	.section .text.BPMSG1194, code
 	.global _BPMSG1194_str
 _BPMSG1194_str:
-	.pasciz "-p "
+	.pasciz "-\250"
 
 	; BPMSG1195
 	.section .text.BPMSG1195, code
@@ -620,85 +620,85 @@ _BPMSG1195_str:
 	.section .text.BPMSG1196, code
 	.global _BPMSG1196_str
 _BPMSG1196_str:
-	.pasciz "*Bytes dropped*"
+	.pasciz "*By\226\216dropp\261*"
 
 	; BPMSG1197
 	.section .text.BPMSG1197, code
 	.global _BPMSG1197_str
 _BPMSG1197_str:
-	.pasciz "FAILED, NO DATA"
+	.pasciz "FAILED\222NO \374A"
 
 	; BPMSG1199
 	.section .text.BPMSG1199, code
 	.global _BPMSG1199_str
 _BPMSG1199_str:
-	.pasciz "Data bits and parity:\r\n 1. 8, NONE *default \r\n 2. 8, EVEN \r\n 3. 8, ODD \r\n 4. 9, NONE"
+	.pasciz "Data b\217\216\241\210p\223\217y\2738\222NONE\333\231fa\245\203\2678\222EVEN \2013\2048\222ODD \364\2049\222NONE"
 
 	; BPMSG1200
 	.section .text.BPMSG1200, code
 	.global _BPMSG1200_str
 _BPMSG1200_str:
-	.pasciz "Stop bits:\r\n 1. 1 *default\r\n 2. 2"
+	.pasciz "S\362\250b\217s\2731\333\231fa\245t\2672"
 
 	; BPMSG1201
 	.section .text.BPMSG1201, code
 	.global _BPMSG1201_str
 _BPMSG1201_str:
-	.pasciz "Receive polarity:\r\n 1. Idle 1 *default\r\n 2. Idle 0"
+	.pasciz "\313ceiv\205p\254\223\217y\273I\3401\333\231fa\245t\267I\3400"
 
 	; BPMSG1202
 	.section .text.BPMSG1202, code
 	.global _BPMSG1202_str
 _BPMSG1202_str:
-	.pasciz "UART (spd brg dbp sb rxp hiz)=( "
+	.pasciz "U\262T\207\265\210br\251db\250sb rx\250\272z)=( "
 
 	; BPMSG1203
 	.section .text.BPMSG1203, code
 	.global _BPMSG1203_str
 _BPMSG1203_str:
-	.pasciz " 0.Macro menu\r\n 1.Transparent bridge\r\n 2.Live monitor\r\n 3.Bridge with flow control\n\r 4.Auto Baud Detection (Activity Needed)"
+	.pasciz " \334\335\343u\237.Tr\241\265a\215n\203bridge\233.Liv\205m\213\217\221\201\303Bridg\205w\217h f\347 \356\344\254\n\r 4.Au\266Bau\210De\226c\240\213\207Ac\305\217\234Nee\231d)"
 
 	; BPMSG1204
 	.section .text.BPMSG1204, code
 	.global _BPMSG1204_str
 _BPMSG1204_str:
-	.pasciz "UART bridge"
+	.pasciz "U\262T bridge"
 
 	; BPMSG1206
 	.section .text.BPMSG1206, code
 	.global _BPMSG1206_str
 _BPMSG1206_str:
-	.pasciz "Raw UART input"
+	.pasciz "Raw U\262T \206\275t"
 
 	; BPMSG1207
 	.section .text.BPMSG1207, code
 	.global _BPMSG1207_str
 _BPMSG1207_str:
-	.pasciz "UART LIVE DISPLAY, } TO STOP"
+	.pasciz "U\262T\370IVE D\322PLAY\222} TO\307TOP"
 
 	; BPMSG1208
 	.section .text.BPMSG1208, code
 	.global _BPMSG1208_str
 _BPMSG1208_str:
-	.pasciz "LIVE DISPLAY STOPPED"
+	.pasciz "LIVE D\322PLAY\307TOPPED"
 
 	; BPMSG1209
 	.section .text.BPMSG1209, code
 	.global _BPMSG1209_str
 _BPMSG1209_str:
-	.pasciz "WARNING: pins not open drain (HiZ)"
+	.pasciz "W\262NING\230\330\216\361\203op\224 dra\206\207\375Z)"
 
 	; BPMSG1210
 	.section .text.BPMSG1210, code
 	.global _BPMSG1210_str
 _BPMSG1210_str:
-	.pasciz " REVID:"
+	.pasciz " \246VID:"
 
 	; BPMSG1211
 	.section .text.BPMSG1211, code
 	.global _BPMSG1211_str
 _BPMSG1211_str:
-	.pasciz "\r\nInvalid choice, try again"
+	.pasciz "\200Inv\247i\210\355o\341e\222\344\234aga\206"
 
 	; BPMSG1212
 	.section .text.BPMSG1212, code
@@ -710,31 +710,31 @@ _BPMSG1212_str:
 	.section .text.BPMSG1213, code
 	.global _BPMSG1213_str
 _BPMSG1213_str:
-	.pasciz "RS LOW, COMMAND MODE"
+	.pasciz "RS\370OW\222COMMAND \377\373"
 
 	; BPMSG1214
 	.section .text.BPMSG1214, code
 	.global _BPMSG1214_str
 _BPMSG1214_str:
-	.pasciz "RS HIGH, DATA MODE"
+	.pasciz "RS HIGH\222\374A \377\373"
 
 	; BPMSG1216
 	.section .text.BPMSG1216, code
 	.global _BPMSG1216_str
 _BPMSG1216_str:
-	.pasciz "This mode requires an adapter"
+	.pasciz "T\272\216\325d\205\215qui\215\216\241 \260apt\212"
 
 	; BPMSG1219
 	.section .text.BPMSG1219, code
 	.global _BPMSG1219_str
 _BPMSG1219_str:
-	.pasciz " 0.Macro menu\r\n 1.LCD Reset\r\n 2.Init LCD\r\n 3.Clear LCD\r\n 4.Cursor position ex:(4) 0\r\n 6.Write test numbers ex:(6) 80\r\n 7.Write test characters ex:(7) 80"
+	.pasciz " \334\335\343u\237.LCD \313s\357\233.In\324LCD\201\303C\342\223\370CD\364.Curs\221 pos\217i\213 \271:(4\2350\2016.Wr\217\205\226s\203numb\212\216\271:(6\23580\2017.Wr\217\205\226s\203\355\223\225t\212\216\271:(7\23580"
 
 	; BPMSG1220
 	.section .text.BPMSG1220, code
 	.global _BPMSG1220_str
 _BPMSG1220_str:
-	.pasciz "Display lines:\r\n 1. 1 \r\n 2. Multiple"
+	.pasciz "Di\265la\234l\206es\2731 \267M\245\240p\342"
 
 	; BPMSG1221
 	.section .text.BPMSG1221, code
@@ -746,19 +746,19 @@ _BPMSG1221_str:
 	.section .text.BPMSG1222, code
 	.global _BPMSG1222_str
 _BPMSG1222_str:
-	.pasciz "CLEAR"
+	.pasciz "\312E\262"
 
 	; BPMSG1223
 	.section .text.BPMSG1223, code
 	.global _BPMSG1223_str
 _BPMSG1223_str:
-	.pasciz "CURSOR SET"
+	.pasciz "CURSOR\307ET"
 
 	; BPMSG1226
 	.section .text.BPMSG1226, code
 	.global _BPMSG1226_str
 _BPMSG1226_str:
-	.pasciz "Pinstates:"
+	.pasciz "P\206\244\323s:"
 
 	; BPMSG1228
 	.section .text.BPMSG1228, code
@@ -776,73 +776,73 @@ _BPMSG1234_str:
 	.section .text.BPMSG1245, code
 	.global _BPMSG1245_str
 _BPMSG1245_str:
-	.pasciz " autorange "
+	.pasciz " aut\221\241g\205"
 
 	; BPMSG1248
 	.section .text.BPMSG1248, code
 	.global _BPMSG1248_str
 _BPMSG1248_str:
-	.pasciz "Input a custom BAUD rate:"
+	.pasciz "In\275\203a cu\244\326 B\264D r\323:"
 
 	; BPMSG1251
 	.section .text.BPMSG1251, code
 	.global _BPMSG1251_str
 _BPMSG1251_str:
-	.pasciz "Space to continue"
+	.pasciz "Sp\225\205\266\356t\206ue"
 
 	; BPMSG1252
 	.section .text.BPMSG1252, code
 	.global _BPMSG1252_str
 _BPMSG1252_str:
-	.pasciz "Number of bits read/write: "
+	.pasciz "Numb\212 of b\217\216\215\260/wr\217e\230"
 
 	; BPMSG1254
 	.section .text.BPMSG1254, code
 	.global _BPMSG1254_str
 _BPMSG1254_str:
-	.pasciz "Position in degrees"
+	.pasciz "Pos\217i\213 \206 \231g\215es"
 
 	; BPMSG1255
 	.section .text.BPMSG1255, code
 	.global _BPMSG1255_str
 _BPMSG1255_str:
-	.pasciz "Servo active"
+	.pasciz "S\212v\211\346e"
 
 	; BPMSG1256
 	.section .text.BPMSG1256, code
 	.global _BPMSG1256_str
 _BPMSG1256_str:
-	.pasciz "#12    \t#11    \t#10    \t#09   \t#08   \t#07   \t#06   \t#05   \t#04   \t#03   \t#02   \t#01   "
+	.pasciz "#12\220\220\31711\220\220\31710\220\220\3679\365\3678\365\3677\365\3676\365\3675\365\3674\365\3673\365\3672\365\3671\365"
 
 	; BPMSG1257
 	.section .text.BPMSG1257, code
 	.global _BPMSG1257_str
 _BPMSG1257_str:
-	.pasciz "GND\t5.0V\t3.3V\tVPU\tADC\tAUX2\tAUX1\tAUX\t"
+	.pasciz "GND\t5.0V\t\3033V\tVPU\t\274C\t\3012\t\3011\t\301\t"
 
 	; BPMSG1263
 	.section .text.BPMSG1263, code
 	.global _BPMSG1263_str
 _BPMSG1263_str:
-	.pasciz "a/A/@ controls AUX1 pin"
+	.pasciz "a/A/@ \356\344\254\216\3011 \330"
 
 	; BPMSG1264
 	.section .text.BPMSG1264, code
 	.global _BPMSG1264_str
 _BPMSG1264_str:
-	.pasciz "a/A/@ controls AUX2 pin"
+	.pasciz "a/A/@ \356\344\254\216\3012 \330"
 
 	; BPMSG1265
 	.section .text.BPMSG1265, code
 	.global _BPMSG1265_str
 _BPMSG1265_str:
-	.pasciz "EEPROM"
+	.pasciz "EEP\253"
 
 	; BPMSG1266
 	.section .text.BPMSG1266, code
 	.global _BPMSG1266_str
 _BPMSG1266_str:
-	.pasciz "SCL"
+	.pasciz "S\312"
 
 	; BPMSG1267
 	.section .text.BPMSG1267, code
@@ -860,67 +860,67 @@ _BPMSG1268_str:
 	.section .text.BPMSG1269, code
 	.global _BPMSG1269_str
 _BPMSG1269_str:
-	.pasciz "READ&WRITE"
+	.pasciz "\246\274&WRITE"
 
 	; BPMSG1270
 	.section .text.BPMSG1270, code
 	.global _BPMSG1270_str
 _BPMSG1270_str:
-	.pasciz "Vusb"
+	.pasciz "V\276b"
 
 	; BPMSG1271
 	.section .text.BPMSG1271, code
 	.global _BPMSG1271_str
 _BPMSG1271_str:
-	.pasciz "Select Vpu (Pullup) Source:\r\n 1) External (or None)\r\n 2) Onboard 3.3v\r\n 3) Onboard 5.0v"
+	.pasciz "\257\342c\203V\275\207P\350up\235S\327rce:\237\235Ext\212n\247\207\221 N\213e)\233\235Onbo\223\210\3033v\2013\235Onbo\223\2105.0v"
 
 	; BPMSG1272
 	.section .text.BPMSG1272, code
 	.global _BPMSG1272_str
 _BPMSG1272_str:
-	.pasciz " on-board pullup voltage "
+	.pasciz " \213-bo\223\210p\350\363v\254tag\205"
 
 	; BPMSG1273
 	.section .text.BPMSG1273, code
 	.global _BPMSG1273_str
 _BPMSG1273_str:
-	.pasciz "enabled"
+	.pasciz "\224\336l\261"
 
 	; BPMSG1274
 	.section .text.BPMSG1274, code
 	.global _BPMSG1274_str
 _BPMSG1274_str:
-	.pasciz "disabled"
+	.pasciz "d\360\336l\261"
 
 	; BPMSG1280
 	.section .text.BPMSG1280, code
 	.global _BPMSG1280_str
 _BPMSG1280_str:
-	.pasciz "Waiting activity..."
+	.pasciz "Wa\217\331\346\217y..."
 
 	; BPMSG1281
 	.section .text.BPMSG1281, code
 	.global _BPMSG1281_str
 _BPMSG1281_str:
-	.pasciz "** Early Exit!"
+	.pasciz "** E\223l\234Ex\217!"
 
 	; BPMSG1282
 	.section .text.BPMSG1282, code
 	.global _BPMSG1282_str
 _BPMSG1282_str:
-	.pasciz "** Baud>16m: The BP cannot measure above 16000000, Done."
+	.pasciz "** Baud>\311m\230Th\205BP c\241\361\203me\337ur\205\336ov\205\311\242\242\242\222D\213e."
 
 	; BPMSG1283
 	.section .text.BPMSG1283, code
 	.global _BPMSG1283_str
 _BPMSG1283_str:
-	.pasciz "\n\rCalculated: \t"
+	.pasciz "\n\rC\247c\245\323d\230\t"
 
 	; BPMSG1284
 	.section .text.BPMSG1284, code
 	.global _BPMSG1284_str
 _BPMSG1284_str:
-	.pasciz "\n\rEstimated:  \t"
+	.pasciz "\n\rEs\240m\323d:\220\t"
 
 	; BPMSG1285
 	.section .text.BPMSG1285, code
@@ -932,193 +932,193 @@ _BPMSG1285_str:
 	.section .text.HLP1000, code
 	.global _HLP1000_str
 _HLP1000_str:
-	.pasciz "General\t\t\t\t\tProtocol interaction"
+	.pasciz "G\224\212\247\227\366Pro\362c\254 \206t\212\225\240\213"
 
 	; HLP1001
 	.section .text.HLP1001, code
 	.global _HLP1001_str
 _HLP1001_str:
-	.pasciz "---------------------------------------------------------------------------"
+	.pasciz "\255\255\255\255\255\255\255\255\255\202-"
 
 	; HLP1002
 	.section .text.HLP1002, code
 	.global _HLP1002_str
 _HLP1002_str:
-	.pasciz "?\tThis help\t\t\t(0)\tList current macros"
+	.pasciz "?\tT\272\216help\366(0)\tL\360\203cur\215n\203m\300os"
 
 	; HLP1003
 	.section .text.HLP1003, code
 	.global _HLP1003_str
 _HLP1003_str:
-	.pasciz "=X/|X\tConverts X/reverse X\t\t(x)\tMacro x"
+	.pasciz "=X/|X\tC\213v\212t\216X/\215v\212s\205X\227(x)\t\335x"
 
 	; HLP1004
 	.section .text.HLP1004, code
 	.global _HLP1004_str
 _HLP1004_str:
-	.pasciz "~\tSelftest\t\t\t[\tStart"
+	.pasciz "~\t\257lf\226\244\366[\306t\223t"
 
 	; HLP1005
 	.section .text.HLP1005, code
 	.global _HLP1005_str
 _HLP1005_str:
-	.pasciz "o\tSet output type\t\t\t]\tStop"
+	.pasciz "o\t\315\327t\275\203type\366]\306\362p"
 
 	; HLP1006
 	.section .text.HLP1006, code
 	.global _HLP1006_str
 _HLP1006_str:
-	.pasciz "$\tJump to bootloader\t\t{\tStart with read"
+	.pasciz "$\tJum\250\266boot\243\260\212\227{\306t\223\203w\217h \215\260"
 
 	; HLP1007
 	.section .text.HLP1007, code
 	.global _HLP1007_str
 _HLP1007_str:
-	.pasciz "&/%\tDelay 1 us/ms\t\t\t}\tStop"
+	.pasciz "&/%\tDela\2341 \276/ms\366}\306\362p"
 
 	; HLP1008
 	.section .text.HLP1008, code
 	.global _HLP1008_str
 _HLP1008_str:
-	.pasciz "a/A/@\tAUXPIN (low/HI/READ)\t\t\"abc\"\tSend string"
+	.pasciz "a/A/@\t\301PIN\207\347/HI/\246\274)\227\"\336c\"\306\224\210\244r\206g"
 
 	; HLP1009
 	.section .text.HLP1009, code
 	.global _HLP1009_str
 _HLP1009_str:
-	.pasciz "b\tSet baudrate\t\t\t123\tSend integer value"
+	.pasciz "b\t\315baudr\323\366123\306\224\210\206\226g\212 v\247ue"
 
 	; HLP1010
 	.section .text.HLP1010, code
 	.global _HLP1010_str
 _HLP1010_str:
-	.pasciz "c/C/k/K\tAUX assignment (A0/CS/A1/A2)\t0x123\tSend hex value"
+	.pasciz "c/C/k/K\t\301 \337sign\343\203(A0/\320/A1/A2)\t\256123\306\224\210h\271 v\247ue"
 
 	; HLP1011
 	.section .text.HLP1011, code
 	.global _HLP1011_str
 _HLP1011_str:
-	.pasciz "d/D\tMeasure ADC (once/CONT.)\t0b110\tSend binary value"
+	.pasciz "d/D\tMe\337ur\205\274C\207\213ce/CONT.)\t0b110\306\224\210b\206\223\234v\247ue"
 
 	; HLP1012
 	.section .text.HLP1012, code
 	.global _HLP1012_str
 _HLP1012_str:
-	.pasciz "f\tMeasure frequency\t\tr\tRead"
+	.pasciz "f\tMe\337ur\205f\215qu\224cy\227r\t\313\260"
 
 	; HLP1013
 	.section .text.HLP1013, code
 	.global _HLP1013_str
 _HLP1013_str:
-	.pasciz "g/S\tGenerate PWM/Servo\t\t/\tCLK hi"
+	.pasciz "g/S\tG\224\212at\205PWM/S\212vo\227/\t\312K \272"
 
 	; HLP1014
 	.section .text.HLP1014, code
 	.global _HLP1014_str
 _HLP1014_str:
-	.pasciz "h\tCommandhistory\t\t\t\\\tCLK lo"
+	.pasciz "h\tC\326m\241d\272\244\221y\366\\\t\312K \243"
 
 	; HLP1015
 	.section .text.HLP1015, code
 	.global _HLP1015_str
 _HLP1015_str:
-	.pasciz "i\tVersioninfo/statusinfo\t\t^\tCLK tick"
+	.pasciz "i\tV\212si\213\206fo/\244at\276\206fo\227^\t\312K \240ck"
 
 	; HLP1016
 	.section .text.HLP1016, code
 	.global _HLP1016_str
 _HLP1016_str:
-	.pasciz "l/L\tBitorder (msb/LSB)\t\t-\tDAT hi"
+	.pasciz "l/L\tB\217\221d\212\207msb/LSB)\227\351\374 \272"
 
 	; HLP1017
 	.section .text.HLP1017, code
 	.global _HLP1017_str
 _HLP1017_str:
-	.pasciz "m\tChange mode\t\t\t_\tDAT lo"
+	.pasciz "m\tCh\241g\205\325\231\366_\t\374 \243"
 
 	; HLP1018
 	.section .text.HLP1018, code
 	.global _HLP1018_str
 _HLP1018_str:
-	.pasciz "e\tSet Pullup Method\t\t.\tDAT read"
+	.pasciz "e\t\315P\350\363M\357hod\227.\t\374 \215\260"
 
 	; HLP1019
 	.section .text.HLP1019, code
 	.global _HLP1019_str
 _HLP1019_str:
-	.pasciz "p/P\tPullup resistors (off/ON)\t!\tBit read"
+	.pasciz "p/P\tP\350\363\345i\244\221s\207off/ON)\t!\tB\324\215\260"
 
 	; HLP1020
 	.section .text.HLP1020, code
 	.global _HLP1020_str
 _HLP1020_str:
-	.pasciz "s\tScript engine\t\t\t:\tRepeat e.g. r:10"
+	.pasciz "s\306crip\203\224g\206e\366:\t\313pea\203e.g\204r:10"
 
 	; HLP1021
 	.section .text.HLP1021, code
 	.global _HLP1021_str
 _HLP1021_str:
-	.pasciz "v\tShow volts/states\t\t;\tBits to read/write e.g. 0x55;2"
+	.pasciz "v\306how v\254ts/\244\323s\227;\tB\217\216\266\215\260/wr\217\205e.g\204\25655;2"
 
 	; HLP1022
 	.section .text.HLP1022, code
 	.global _HLP1022_str
 _HLP1022_str:
-	.pasciz "w/W\tPSU (off/ON)\t\t<x>/<x= >/<0>\tUsermacro x/assign x/list all"
+	.pasciz "w/W\tPSU\207off/ON)\227<x>/<x= >/<0>\tUs\212m\316x/\337sign x/l\360\203\247l"
 
 	; MSG_1WIRE_ADDRESS_MACRO_HEADER
 	.section .text.MSG_1WIRE_ADDRESS_MACRO_HEADER, code
 	.global _MSG_1WIRE_ADDRESS_MACRO_HEADER_str
 _MSG_1WIRE_ADDRESS_MACRO_HEADER_str:
-	.pasciz "ADDRESS MACRO "
+	.pasciz "\274D\246SS MAC\232 "
 
 	; MSG_1WIRE_ALARM_MACRO_NAME
 	.section .text.MSG_1WIRE_ALARM_MACRO_NAME, code
 	.global _MSG_1WIRE_ALARM_MACRO_NAME_str
 _MSG_1WIRE_ALARM_MACRO_NAME_str:
-	.pasciz "ALARM SEARCH (0xEC)"
+	.pasciz "AL\262M\307E\262\352\277EC)"
 
 	; MSG_1WIRE_BUS_RESET
 	.section .text.MSG_1WIRE_BUS_RESET, code
 	.global _MSG_1WIRE_BUS_RESET_str
 _MSG_1WIRE_BUS_RESET_str:
-	.pasciz "BUS RESET "
+	.pasciz "BUS \246\354T "
 
 	; MSG_1WIRE_LOOKUP_ID_HEADER
 	.section .text.MSG_1WIRE_LOOKUP_ID_HEADER, code
 	.global _MSG_1WIRE_LOOKUP_ID_HEADER_str
 _MSG_1WIRE_LOOKUP_ID_HEADER_str:
-	.pasciz "\r\n   *"
+	.pasciz "\201\220*"
 
 	; MSG_1WIRE_MACRO_LIST
 	.section .text.MSG_1WIRE_MACRO_LIST, code
 	.global _MSG_1WIRE_MACRO_LIST_str
 _MSG_1WIRE_MACRO_LIST_str:
-	.pasciz "1WIRE ROM COMMAND MACROs:\r\n 51.READ ROM (0x33) *for single device bus\r\n 85.MATCH ROM (0x55) *followed by 64bit address\r\n 204.SKIP ROM (0xCC) *followed by command\r\n 236.ALARM SEARCH (0xEC)\r\n 240.SEARCH ROM (0xF0)"
+	.pasciz "1WI\246\310 COMMAND MAC\232s:\20151.\246\274\33233\235*f\221\302\206g\252\231v\341\205b\276\2016\334OV\321DRIVE\307KIP\3323C\235*f\254\347e\210b\234c\326m\241d\20185.M\263\352\33255\235*f\254\347e\210b\23464b\324\260d\345s\23705.OV\321DRIVE M\263\352\33269\235*f\254\347e\210b\23464b\324\260d\345s\23304.SKIP\332CC\235*f\254\347e\210b\234c\326m\241d\23336.AL\262M\307E\262\352\277EC)\2334\334\354\262\352\332F0)"
 
 	; MSG_1WIRE_MACRO_MENU_HEADER
 	.section .text.MSG_1WIRE_MACRO_MENU_HEADER, code
 	.global _MSG_1WIRE_MACRO_MENU_HEADER_str
 _MSG_1WIRE_MACRO_MENU_HEADER_str:
-	.pasciz " 0.Macro menu"
+	.pasciz " \334\335\343u"
 
 	; MSG_1WIRE_MACRO_TABLE_HEADER
 	.section .text.MSG_1WIRE_MACRO_TABLE_HEADER, code
 	.global _MSG_1WIRE_MACRO_TABLE_HEADER_str
 _MSG_1WIRE_MACRO_TABLE_HEADER_str:
-	.pasciz "Macro     1WIRE address"
+	.pasciz "\335\220\2201WI\246 \260d\345s"
 
 	; MSG_1WIRE_MACRO_TABLE_TRAILER
 	.section .text.MSG_1WIRE_MACRO_TABLE_TRAILER, code
 	.global _MSG_1WIRE_MACRO_TABLE_TRAILER_str
 _MSG_1WIRE_MACRO_TABLE_TRAILER_str:
-	.pasciz "Device IDs are available by MACRO, see (0)."
+	.pasciz "Dev\341\205ID\216\223\205avail\336\252b\234MAC\232\222se\205(0)."
 
 	; MSG_1WIRE_MATCH_ROM_MACRO_NAME
 	.section .text.MSG_1WIRE_MATCH_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_MATCH_ROM_MACRO_NAME_str
 _MSG_1WIRE_MATCH_ROM_MACRO_NAME_str:
-	.pasciz "MATCH ROM (0x55)"
+	.pasciz "M\263\352\33255)"
 
 	; MSG_1WIRE_MODE_IDENTIFIER
 	.section .text.MSG_1WIRE_MODE_IDENTIFIER, code
@@ -1130,73 +1130,85 @@ _MSG_1WIRE_MODE_IDENTIFIER_str:
 	.section .text.MSG_1WIRE_NEXT_CLOCK_ALERT, code
 	.global _MSG_1WIRE_NEXT_CLOCK_ALERT_str
 _MSG_1WIRE_NEXT_CLOCK_ALERT_str:
-	.pasciz " *next clock (^) will use this value"
+	.pasciz "\333n\271\203c\243ck\207^\235will \276\205t\272\216v\247ue"
 
 	; MSG_1WIRE_NO_DEVICE
 	.section .text.MSG_1WIRE_NO_DEVICE, code
 	.global _MSG_1WIRE_NO_DEVICE_str
 _MSG_1WIRE_NO_DEVICE_str:
-	.pasciz "No device, try (ALARM) SEARCH macro first"
+	.pasciz "N\211\231v\341e\222\344y\207AL\262M\235\354\262\352 m\316fir\244"
 
 	; MSG_1WIRE_NO_DEVICE_DETECTED
 	.section .text.MSG_1WIRE_NO_DEVICE_DETECTED, code
 	.global _MSG_1WIRE_NO_DEVICE_DETECTED_str
 _MSG_1WIRE_NO_DEVICE_DETECTED_str:
-	.pasciz "*No device detected "
+	.pasciz "*N\211\231v\341\205\231\226c\226\210"
+
+	; MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_MATCH_ROM_MACRO_NAME_str:
+	.pasciz "OV\321DRIVE M\263\352\33269)"
+
+	; MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME
+	.section .text.MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME, code
+	.global _MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str
+_MSG_1WIRE_OVERDRIVE_SKIP_ROM_MACRO_NAME_str:
+	.pasciz "OV\321DRIVE\307KIP\3323C)"
 
 	; MSG_1WIRE_PINS_STATE
 	.section .text.MSG_1WIRE_PINS_STATE, code
 	.global _MSG_1WIRE_PINS_STATE_str
 _MSG_1WIRE_PINS_STATE_str:
-	.pasciz "-\t-\t-\tOWD"
+	.pasciz "\351\351\351OWD"
 
 	; MSG_1WIRE_READ_ROM_MACRO_NAME
 	.section .text.MSG_1WIRE_READ_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_READ_ROM_MACRO_NAME_str
 _MSG_1WIRE_READ_ROM_MACRO_NAME_str:
-	.pasciz "READ ROM (0x33): "
+	.pasciz "\246\274\33233)\230"
 
 	; MSG_1WIRE_SEARCH_MACRO_NAME
 	.section .text.MSG_1WIRE_SEARCH_MACRO_NAME, code
 	.global _MSG_1WIRE_SEARCH_MACRO_NAME_str
 _MSG_1WIRE_SEARCH_MACRO_NAME_str:
-	.pasciz "SEARCH (0xF0)"
+	.pasciz "\354\262\352\277F0)"
 
 	; MSG_1WIRE_SKIP_ROM_MACRO_NAME
 	.section .text.MSG_1WIRE_SKIP_ROM_MACRO_NAME, code
 	.global _MSG_1WIRE_SKIP_ROM_MACRO_NAME_str
 _MSG_1WIRE_SKIP_ROM_MACRO_NAME_str:
-	.pasciz "SKIP ROM (0xCC)"
+	.pasciz "SKIP\332CC)"
 
 	; MSG_1WIRE_SPEED_PROMPT
 	.section .text.MSG_1WIRE_SPEED_PROMPT, code
 	.global _MSG_1WIRE_SPEED_PROMPT_str
 _MSG_1WIRE_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1. Standard (~16.3kbps) \r\n 2. Overdrive (~160kps)"
+	.pasciz "\315\265e\261\273St\241d\223d\207~\311.3kbps\235\267Ov\212driv\205(~\3110kps)"
 
 	; MSG_ACK
 	.section .text.MSG_ACK, code
 	.global _MSG_ACK_str
 _MSG_ACK_str:
-	.pasciz "ACK"
+	.pasciz "A\372"
 
 	; MSG_ADC_VOLTAGE_PROBE_HEADER
 	.section .text.MSG_ADC_VOLTAGE_PROBE_HEADER, code
 	.global _MSG_ADC_VOLTAGE_PROBE_HEADER_str
 _MSG_ADC_VOLTAGE_PROBE_HEADER_str:
-	.pasciz "VOLTAGE PROBE: "
+	.pasciz "VOLTAGE P\232BE\230"
 
 	; MSG_ADC_VOLTMETER_MODE
 	.section .text.MSG_ADC_VOLTMETER_MODE, code
 	.global _MSG_ADC_VOLTMETER_MODE_str
 _MSG_ADC_VOLTMETER_MODE_str:
-	.pasciz "VOLTMETER MODE"
+	.pasciz "VOLTMET\321 \377\373"
 
 	; MSG_ANY_KEY_TO_EXIT_PROMPT
 	.section .text.MSG_ANY_KEY_TO_EXIT_PROMPT, code
 	.global _MSG_ANY_KEY_TO_EXIT_PROMPT_str
 _MSG_ANY_KEY_TO_EXIT_PROMPT_str:
-	.pasciz "Any key to exit"
+	.pasciz "An\234ke\234\266\271\217"
 
 	; MSG_BASE_CONVERTER_EQUAL_SIGN
 	.section .text.MSG_BASE_CONVERTER_EQUAL_SIGN, code
@@ -1208,7 +1220,7 @@ _MSG_BASE_CONVERTER_EQUAL_SIGN_str:
 	.section .text.MSG_BAUD_DETECTION_SELECTED, code
 	.global _MSG_BAUD_DETECTION_SELECTED_str
 _MSG_BAUD_DETECTION_SELECTED_str:
-	.pasciz "Baud detection selected.."
+	.pasciz "Bau\210\231\226c\240\213\302e\342c\226d.."
 
 	; MSG_BBIO_MODE_IDENTIFIER
 	.section .text.MSG_BBIO_MODE_IDENTIFIER, code
@@ -1226,7 +1238,7 @@ _MSG_BINARY_NUMBER_PREFIX_str:
 	.section .text.MSG_CFG0_FIELD, code
 	.global _MSG_CFG0_FIELD_str
 _MSG_CFG0_FIELD_str:
-	.pasciz "CFG0: "
+	.pasciz "CFG0\230"
 
 	; MSG_CHIP_REVISION_A3
 	.section .text.MSG_CHIP_REVISION_A3, code
@@ -1244,7 +1256,7 @@ _MSG_CHIP_REVISION_A5_str:
 	.section .text.MSG_CHIP_REVISION_ID_BEGIN, code
 	.global _MSG_CHIP_REVISION_ID_BEGIN_str
 _MSG_CHIP_REVISION_ID_BEGIN_str:
-	.pasciz " (24FJ256GB106 "
+	.pasciz "\20724FJ256GB106 "
 
 	; MSG_CHIP_REVISION_UNKNOWN
 	.section .text.MSG_CHIP_REVISION_UNKNOWN, code
@@ -1256,67 +1268,103 @@ _MSG_CHIP_REVISION_UNKNOWN_str:
 	.section .text.MSG_CLUTCH_DISENGAGED, code
 	.global _MSG_CLUTCH_DISENGAGED_str
 _MSG_CLUTCH_DISENGAGED_str:
-	.pasciz "Clutch disengaged!!!"
+	.pasciz "Clut\355 d\360\224gag\261!!!"
 
 	; MSG_CLUTCH_ENGAGED
 	.section .text.MSG_CLUTCH_ENGAGED, code
 	.global _MSG_CLUTCH_ENGAGED_str
 _MSG_CLUTCH_ENGAGED_str:
-	.pasciz "Clutch engaged!!!"
+	.pasciz "Clut\355 \224gag\261!!!"
 
 	; MSG_COMMAND_HAS_NO_EFFECT
 	.section .text.MSG_COMMAND_HAS_NO_EFFECT, code
 	.global _MSG_COMMAND_HAS_NO_EFFECT_str
 _MSG_COMMAND_HAS_NO_EFFECT_str:
-	.pasciz "ERROR: command has no effect here"
+	.pasciz "\321\232R\230c\326m\241\210ha\216n\211effec\203h\212e"
+
+	; MSG_DIO_MACRO_MENU
+	.section .text.MSG_DIO_MACRO_MENU, code
+	.global _MSG_DIO_MACRO_MENU_str
+_MSG_DIO_MACRO_MENU_str:
+	.pasciz " \334\335\343u\237.S\226\250p\212io\210\206 u\216\271:(1\2351\242\233.Samp\252\330\216\271:(2\235\311\201\303\313c\221\210\330 \244\323s\364.Pla\234\215c\221d\331\271:(4\2351\2220 un\240l a ke\234i\216p\345s\261"
+
+	; MSG_DIO_NOTHING_RECORDED
+	.section .text.MSG_DIO_NOTHING_RECORDED, code
+	.global _MSG_DIO_NOTHING_RECORDED_str
+_MSG_DIO_NOTHING_RECORDED_str:
+	.pasciz "Noth\331\215c\221\231d\222\244\223\203w\217h\2073)"
+
+	; MSG_DIO_RECORDING
+	.section .text.MSG_DIO_RECORDING, code
+	.global _MSG_DIO_RECORDING_str
+_MSG_DIO_RECORDING_str:
+	.pasciz "\313c\221d\331\330 \244\323s,\2074\235play\216them"
+
+	; MSG_DIO_RECORDING_FULL
+	.section .text.MSG_DIO_RECORDING_FULL, code
+	.global _MSG_DIO_RECORDING_FULL_str
+_MSG_DIO_RECORDING_FULL_str:
+	.pasciz "\313c\221d\331f\350"
+
+	; MSG_DIO_STEP_PERIOD
+	.section .text.MSG_DIO_STEP_PERIOD, code
+	.global _MSG_DIO_STEP_PERIOD_str
+_MSG_DIO_STEP_PERIOD_str:
+	.pasciz "S\226\250p\212iod\207\276)\230"
+
+	; MSG_DIO_STEP_PERIOD_RANGE
+	.section .text.MSG_DIO_STEP_PERIOD_RANGE, code
+	.global _MSG_DIO_STEP_PERIOD_RANGE_str
+_MSG_DIO_STEP_PERIOD_RANGE_str:
+	.pasciz "S\226\250p\212io\210m\276\203b\2054-4095\276"
 
 	; MSG_FINISH_SETUP_PROMPT
 	.section .text.MSG_FINISH_SETUP_PROMPT, code
 	.global _MSG_FINISH_SETUP_PROMPT_str
 _MSG_FINISH_SETUP_PROMPT_str:
-	.pasciz "To finish setup, start up the power supplies with command 'W'"
+	.pasciz "T\211f\206\360h\302\357up\222\244\223\203\363th\205pow\212\302upplie\216w\217h c\326m\241\210'W'"
 
 	; MSG_HEXADECIMAL_NUMBER_PREFIX
 	.section .text.MSG_HEXADECIMAL_NUMBER_PREFIX, code
 	.global _MSG_HEXADECIMAL_NUMBER_PREFIX_str
 _MSG_HEXADECIMAL_NUMBER_PREFIX_str:
-	.pasciz "0x"
+	.pasciz "\256"
 
 	; MSG_I2C_MODE_IDENTIFIER
 	.section .text.MSG_I2C_MODE_IDENTIFIER, code
 	.global _MSG_I2C_MODE_IDENTIFIER_str
 _MSG_I2C_MODE_IDENTIFIER_str:
-	.pasciz "I2C1"
+	.pasciz "\3761"
 
 	; MSG_I2C_PINS_STATE
 	.section .text.MSG_I2C_PINS_STATE, code
 	.global _MSG_I2C_PINS_STATE_str
 _MSG_I2C_PINS_STATE_str:
-	.pasciz "-\t-\tSCL\tSDA"
+	.pasciz "\351-\306\312\306DA"
 
 	; MSG_I2C_READ_ADDRESS_END
 	.section .text.MSG_I2C_READ_ADDRESS_END, code
 	.global _MSG_I2C_READ_ADDRESS_END_str
 _MSG_I2C_READ_ADDRESS_END_str:
-	.pasciz " R) "
+	.pasciz " R\235"
 
 	; MSG_I2C_START_BIT
 	.section .text.MSG_I2C_START_BIT, code
 	.global _MSG_I2C_START_BIT_str
 _MSG_I2C_START_BIT_str:
-	.pasciz "I2C START BIT"
+	.pasciz "\376\307T\262T BIT"
 
 	; MSG_I2C_STOP_BIT
 	.section .text.MSG_I2C_STOP_BIT, code
 	.global _MSG_I2C_STOP_BIT_str
 _MSG_I2C_STOP_BIT_str:
-	.pasciz "I2C STOP BIT"
+	.pasciz "\376\307TOP BIT"
 
 	; MSG_I2C_WRITE_ADDRESS_END
 	.section .text.MSG_I2C_WRITE_ADDRESS_END, code
 	.global _MSG_I2C_WRITE_ADDRESS_END_str
 _MSG_I2C_WRITE_ADDRESS_END_str:
-	.pasciz " W) "
+	.pasciz " W\235"
 
 	; MSG_KEYBOARD_ERROR_NODATA
 	.section .text.MSG_KEYBOARD_ERROR_NODATA, code
@@ -1328,19 +1376,19 @@ _MSG_KEYBOARD_ERROR_NODATA_str:
 	.section .text.MSG_KEYBOARD_ERROR_PARITY, code
 	.global _MSG_KEYBOARD_ERROR_PARITY_str
 _MSG_KEYBOARD_ERROR_PARITY_str:
-	.pasciz " *parity error"
+	.pasciz "\333p\223\217\234\212r\221"
 
 	; MSG_KEYBOARD_ERROR_STARTBIT
 	.section .text.MSG_KEYBOARD_ERROR_STARTBIT, code
 	.global _MSG_KEYBOARD_ERROR_STARTBIT_str
 _MSG_KEYBOARD_ERROR_STARTBIT_str:
-	.pasciz " *startbit error"
+	.pasciz "\333\244\223tb\324\212r\221"
 
 	; MSG_KEYBOARD_ERROR_STOPBIT
 	.section .text.MSG_KEYBOARD_ERROR_STOPBIT, code
 	.global _MSG_KEYBOARD_ERROR_STOPBIT_str
 _MSG_KEYBOARD_ERROR_STOPBIT_str:
-	.pasciz " *stopbit error"
+	.pasciz "\333\244opb\324\212r\221"
 
 	; MSG_KEYBOARD_ERROR_TIMEOUT
 	.section .text.MSG_KEYBOARD_ERROR_TIMEOUT, code
@@ -1352,19 +1400,37 @@ _MSG_KEYBOARD_ERROR_TIMEOUT_str:
 	.section .text.MSG_KEYBOARD_ERROR_UNKNOWN, code
 	.global _MSG_KEYBOARD_ERROR_UNKNOWN_str
 _MSG_KEYBOARD_ERROR_UNKNOWN_str:
-	.pasciz " UNKNOWN ERROR"
+	.pasciz " UNKNOWN \321\232R"
 
 	; MSG_KEYBOARD_LIVE_INPUT_START
 	.section .text.MSG_KEYBOARD_LIVE_INPUT_START, code
 	.global _MSG_KEYBOARD_LIVE_INPUT_START_str
 _MSG_KEYBOARD_LIVE_INPUT_START_str:
-	.pasciz "Input monitor, any key exits"
+	.pasciz "In\275\203m\213\217\221\222\241\234ke\234\271\217s"
 
 	; MSG_KEYBOARD_MACRO_MENU
 	.section .text.MSG_KEYBOARD_MACRO_MENU, code
 	.global _MSG_KEYBOARD_MACRO_MENU_str
 _MSG_KEYBOARD_MACRO_MENU_str:
-	.pasciz " 0. Macro menu\r\n 1. Live input monitor"
+	.pasciz " 0\204\335\343u\270Liv\205\206\275\203m\213\217\221"
+
+	; MSG_MEMORY_USAGE_ARENA_PEAKS
+	.section .text.MSG_MEMORY_USAGE_ARENA_PEAKS, code
+	.global _MSG_MEMORY_USAGE_ARENA_PEAKS_str
+_MSG_MEMORY_USAGE_ARENA_PEAKS_str:
+	.pasciz "A\215na peaks:"
+
+	; MSG_MEMORY_USAGE_BYTES
+	.section .text.MSG_MEMORY_USAGE_BYTES, code
+	.global _MSG_MEMORY_USAGE_BYTES_str
+_MSG_MEMORY_USAGE_BYTES_str:
+	.pasciz " by\226s"
+
+	; MSG_MEMORY_USAGE_STACK
+	.section .text.MSG_MEMORY_USAGE_STACK, code
+	.global _MSG_MEMORY_USAGE_STACK_str
+_MSG_MEMORY_USAGE_STACK_str:
+	.pasciz "St\225k \276\261\230"
 
 	; MSG_MODE_HEADER_END
 	.section .text.MSG_MODE_HEADER_END, code
@@ -1376,19 +1442,19 @@ _MSG_MODE_HEADER_END_str:
 	.section .text.MSG_NACK, code
 	.global _MSG_NACK_str
 _MSG_NACK_str:
-	.pasciz "NACK"
+	.pasciz "NA\372"
 
 	; MSG_NO_VOLTAGE_ON_PULLUP_PIN
 	.section .text.MSG_NO_VOLTAGE_ON_PULLUP_PIN, code
 	.global _MSG_NO_VOLTAGE_ON_PULLUP_PIN_str
 _MSG_NO_VOLTAGE_ON_PULLUP_PIN_str:
-	.pasciz "Warning: no voltage on Vpullup pin"
+	.pasciz "W\223n\206g\230n\211v\254tag\205\213 Vp\350\363\330"
 
 	; MSG_ONBOARD_I2C_EEPROM_WRITE_PROTECT_DISABLED
 	.section .text.MSG_ONBOARD_I2C_EEPROM_WRITE_PROTECT_DISABLED, code
 	.global _MSG_ONBOARD_I2C_EEPROM_WRITE_PROTECT_DISABLED_str
 _MSG_ONBOARD_I2C_EEPROM_WRITE_PROTECT_DISABLED_str:
-	.pasciz "On-board EEPROM write protect disabled"
+	.pasciz "On-bo\223\210EEP\253 wr\217\205pro\226c\203d\360\336l\261"
 
 	; MSG_OPENOCD_MODE_IDENTIFIER
 	.section .text.MSG_OPENOCD_MODE_IDENTIFIER, code
@@ -1412,19 +1478,19 @@ _MSG_PIC_DEVICE_ID_str:
 	.section .text.MSG_PIC_EXIT_MODE, code
 	.global _MSG_PIC_EXIT_MODE_str
 _MSG_PIC_EXIT_MODE_str:
-	.pasciz "Please exit PIC programming mode"
+	.pasciz "P\342\337\205\271\324PIC programm\331\325\231"
 
 	; MSG_PIC_MACRO_MENU
 	.section .text.MSG_PIC_MACRO_MENU, code
 	.global _MSG_PIC_MACRO_MENU_str
 _MSG_PIC_MACRO_MENU_str:
-	.pasciz "(1) get devID"
+	.pasciz "(1\235ge\203\231vID"
 
 	; MSG_PIC_MACRO_NOT_IMPLEMENTED
 	.section .text.MSG_PIC_MACRO_NOT_IMPLEMENTED, code
 	.global _MSG_PIC_MACRO_NOT_IMPLEMENTED_str
 _MSG_PIC_MACRO_NOT_IMPLEMENTED_str:
-	.pasciz "Not implemented (yet)"
+	.pasciz "No\203imp\342\343\226d\207y\357)"
 
 	; MSG_PIC_MODE_COMMAND
 	.section .text.MSG_PIC_MODE_COMMAND, code
@@ -1442,7 +1508,7 @@ _MSG_PIC_MODE_DATA_str:
 	.section .text.MSG_PIC_MODE_HEADER, code
 	.global _MSG_PIC_MODE_HEADER_str
 _MSG_PIC_MODE_HEADER_str:
-	.pasciz "PIC(mod dly)=("
+	.pasciz "PIC(\325\210dly)=("
 
 	; MSG_PIC_MODE_IDENTIFIER
 	.section .text.MSG_PIC_MODE_IDENTIFIER, code
@@ -1454,121 +1520,121 @@ _MSG_PIC_MODE_IDENTIFIER_str:
 	.section .text.MSG_PIC_MODE_PROMPT, code
 	.global _MSG_PIC_MODE_PROMPT_str
 _MSG_PIC_MODE_PROMPT_str:
-	.pasciz "Commandmode?\r\n1. 6b/14b\r\n2. 4b/16b"
+	.pasciz "C\326m\241d\325\231?\314\2046b/14b\2002\2044b/\311b"
 
 	; MSG_PIC_NO_READ
 	.section .text.MSG_PIC_NO_READ, code
 	.global _MSG_PIC_NO_READ_str
 _MSG_PIC_NO_READ_str:
-	.pasciz "no read"
+	.pasciz "n\211\215\260"
 
 	; MSG_PIC_PINS_STATE
 	.section .text.MSG_PIC_PINS_STATE, code
 	.global _MSG_PIC_PINS_STATE_str
 _MSG_PIC_PINS_STATE_str:
-	.pasciz "-\t-\tPGC\tPGD"
+	.pasciz "\351\351PGC\tPGD"
 
 	; MSG_PIC_REVISION_ID
 	.section .text.MSG_PIC_REVISION_ID, code
 	.global _MSG_PIC_REVISION_ID_str
 _MSG_PIC_REVISION_ID_str:
-	.pasciz " Rev = "
+	.pasciz " \313v = "
 
 	; MSG_PIC_UNKNOWN_MODE
 	.section .text.MSG_PIC_UNKNOWN_MODE, code
 	.global _MSG_PIC_UNKNOWN_MODE_str
 _MSG_PIC_UNKNOWN_MODE_str:
-	.pasciz "unknown mode"
+	.pasciz "unk\361wn \325\231"
 
 	; MSG_PIN_OUTPUT_TYPE_PROMPT
 	.section .text.MSG_PIN_OUTPUT_TYPE_PROMPT, code
 	.global _MSG_PIN_OUTPUT_TYPE_PROMPT_str
 _MSG_PIN_OUTPUT_TYPE_PROMPT_str:
-	.pasciz "Select output type:\r\n 1. Open drain (H=Hi-Z, L=GND)\r\n 2. Normal (H=3.3V, L=GND)"
+	.pasciz "\257\342c\203\327t\275\203type\273Op\224 dra\206\207H=\375-Z\222L=GND)\267N\221m\247\207H=\3033V\222L=GND)"
 
 	; MSG_PWM_FREQUENCY_TOO_LOW
 	.section .text.MSG_PWM_FREQUENCY_TOO_LOW, code
 	.global _MSG_PWM_FREQUENCY_TOO_LOW_str
 _MSG_PWM_FREQUENCY_TOO_LOW_str:
-	.pasciz "Frequencies < 1Hz are not supported."
+	.pasciz "F\215qu\224cie\216< 1\236 \223\205\361\203supp\221\226d."
 
 	; MSG_PWM_HZ_MARKER
 	.section .text.MSG_PWM_HZ_MARKER, code
 	.global _MSG_PWM_HZ_MARKER_str
 _MSG_PWM_HZ_MARKER_str:
-	.pasciz " Hz"
+	.pasciz " \236"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER_str
 _MSG_RAW2WIRE_ATR_DATA_UNITS_HEADER_str:
-	.pasciz "Data units: "
+	.pasciz "Data un\217s\230"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION_str
 _MSG_RAW2WIRE_ATR_DATA_UNITS_NO_INDICATION_str:
-	.pasciz "no indication"
+	.pasciz "n\211\206d\341a\240\213"
 
 	; MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH
 	.section .text.MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH, code
 	.global _MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH_str
 _MSG_RAW2WIRE_ATR_DATA_UNIT_LENGTH_str:
-	.pasciz "Data unit length (bits): "
+	.pasciz "Data un\324l\224gth\207b\217s)\230"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_2WIRE_str:
-	.pasciz "2 wire"
+	.pasciz "2 wi\215"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_3WIRE_str:
-	.pasciz "3 wire"
+	.pasciz "3 wi\215"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_HEADER_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_HEADER_str:
-	.pasciz "Protocol: "
+	.pasciz "Pro\362c\254\230"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_SERIAL_str:
-	.pasciz "serial"
+	.pasciz "s\212i\247"
 
 	; MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN
 	.section .text.MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN, code
 	.global _MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN_str
 _MSG_RAW2WIRE_ATR_PROTOCOL_UNKNOWN_str:
-	.pasciz "unknown"
+	.pasciz "unk\361wn"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_HEADER_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_HEADER_str:
-	.pasciz "Read type: "
+	.pasciz "\313a\210type\230"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_TO_END
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_TO_END, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_TO_END_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_TO_END_str:
-	.pasciz "to end"
+	.pasciz "\266\224d"
 
 	; MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH
 	.section .text.MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH, code
 	.global _MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH_str
 _MSG_RAW2WIRE_ATR_READ_TYPE_VARIABLE_LENGTH_str:
-	.pasciz "variable length"
+	.pasciz "v\223i\336\252l\224gth"
 
 	; MSG_RAW2WIRE_ATR_REPLY_HEADER
 	.section .text.MSG_RAW2WIRE_ATR_REPLY_HEADER, code
 	.global _MSG_RAW2WIRE_ATR_REPLY_HEADER_str
 _MSG_RAW2WIRE_ATR_REPLY_HEADER_str:
-	.pasciz "ISO 7816-3 reply (uses current LSB setting): "
+	.pasciz "\322O 78\311-3 \215ply\207\276e\216cur\215n\203LSB\302\357t\206g)\230"
 
 	; MSG_RAW2WIRE_ATR_RFU
 	.section .text.MSG_RAW2WIRE_ATR_RFU, code
@@ -1580,7 +1646,7 @@ _MSG_RAW2WIRE_ATR_RFU_str:
 	.section .text.MSG_RAW2WIRE_ATR_TRIGGER_INFO, code
 	.global _MSG_RAW2WIRE_ATR_TRIGGER_INFO_str
 _MSG_RAW2WIRE_ATR_TRIGGER_INFO_str:
-	.pasciz "ISO 7816-3 ATR (RESET on CS)\r\nRESET HIGH, CLOCK TICK, RESET LOW"
+	.pasciz "\322O 78\311-3 \263R\207\246\354T \213 \320)\200\246\354T HIGH\222\312O\372 TI\372\222\246\354T\370OW"
 
 	; MSG_RAW2WIRE_I2C_START
 	.section .text.MSG_RAW2WIRE_I2C_START, code
@@ -1598,25 +1664,43 @@ _MSG_RAW2WIRE_I2C_STOP_str:
 	.section .text.MSG_RAW2WIRE_MACRO_MENU, code
 	.global _MSG_RAW2WIRE_MACRO_MENU_str
 _MSG_RAW2WIRE_MACRO_MENU_str:
-	.pasciz " 0.Macro menu\r\n 1.ISO7816-3 ATR\r\n 2.ISO7816-3 parse only"
+	.pasciz " \334\335\343u\237.\322O78\311-3 \263R\233.\322O78\311-3 p\223s\205\213ly\201\303\322O78\311-3 T=0 \346\323\364.\322O78\311-3 T=0 \231\346\323"
 
 	; MSG_RAW2WIRE_MODE_HEADER
 	.section .text.MSG_RAW2WIRE_MODE_HEADER, code
 	.global _MSG_RAW2WIRE_MODE_HEADER_str
 _MSG_RAW2WIRE_MODE_HEADER_str:
-	.pasciz "R2W (spd hiz)=( "
+	.pasciz "R2W\207\265\210\272z)=( "
+
+	; MSG_RAW2WIRE_T0_ATR
+	.section .text.MSG_RAW2WIRE_T0_ATR, code
+	.global _MSG_RAW2WIRE_T0_ATR_str
+_MSG_RAW2WIRE_T0_ATR_str:
+	.pasciz "\263R\230"
+
+	; MSG_RAW2WIRE_T0_DEACTIVATED
+	.section .text.MSG_RAW2WIRE_T0_DEACTIVATED, code
+	.global _MSG_RAW2WIRE_T0_DEACTIVATED_str
+_MSG_RAW2WIRE_T0_DEACTIVATED_str:
+	.pasciz "C\223\210\231\346\323d"
+
+	; MSG_RAW2WIRE_T0_NO_ANSWER
+	.section .text.MSG_RAW2WIRE_T0_NO_ANSWER, code
+	.global _MSG_RAW2WIRE_T0_NO_ANSWER_str
+_MSG_RAW2WIRE_T0_NO_ANSWER_str:
+	.pasciz "N\211v\247i\210T=0 \241sw\212 \266\345\357"
 
 	; MSG_RAW3WIRE_MODE_HEADER
 	.section .text.MSG_RAW3WIRE_MODE_HEADER, code
 	.global _MSG_RAW3WIRE_MODE_HEADER_str
 _MSG_RAW3WIRE_MODE_HEADER_str:
-	.pasciz "R3W (spd csl hiz)=( "
+	.pasciz "R3W\207\265\210csl \272z)=( "
 
 	; MSG_RAW_BRG_VALUE_INPUT
 	.section .text.MSG_RAW_BRG_VALUE_INPUT, code
 	.global _MSG_RAW_BRG_VALUE_INPUT_str
 _MSG_RAW_BRG_VALUE_INPUT_str:
-	.pasciz "Enter raw value for BRG"
+	.pasciz "Ent\212 raw v\247u\205f\221 BRG"
 
 	; MSG_RAW_MODE_IDENTIFIER
 	.section .text.MSG_RAW_MODE_IDENTIFIER, code
@@ -1628,61 +1712,67 @@ _MSG_RAW_MODE_IDENTIFIER_str:
 	.section .text.MSG_RESET_MESSAGE, code
 	.global _MSG_RESET_MESSAGE_str
 _MSG_RESET_MESSAGE_str:
-	.pasciz "RESET"
+	.pasciz "\246\354T"
 
 	; MSG_SNIFFER_MESSAGE
 	.section .text.MSG_SNIFFER_MESSAGE, code
 	.global _MSG_SNIFFER_MESSAGE_str
 _MSG_SNIFFER_MESSAGE_str:
-	.pasciz "Sniffer"
+	.pasciz "Sniff\212"
 
 	; MSG_SOFTWARE_MODE_SPEED_PROMPT
 	.section .text.MSG_SOFTWARE_MODE_SPEED_PROMPT, code
 	.global _MSG_SOFTWARE_MODE_SPEED_PROMPT_str
 _MSG_SOFTWARE_MODE_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1. ~5KHz\r\n 2. ~50KHz\r\n 3. ~100KHz\r\n 4. ~400KHz"
+	.pasciz "\315\265e\261\273~5\304\267~50\304\2013\204~1\242\304\364\204~4\242\304"
 
 	; MSG_SPI_COULD_NOT_KEEP_UP
 	.section .text.MSG_SPI_COULD_NOT_KEEP_UP, code
 	.global _MSG_SPI_COULD_NOT_KEEP_UP_str
 _MSG_SPI_COULD_NOT_KEEP_UP_str:
-	.pasciz "Couldn't keep up"
+	.pasciz "Co\245dn'\203kee\250up"
 
 	; MSG_SPI_CS_DISABLED
 	.section .text.MSG_SPI_CS_DISABLED, code
 	.global _MSG_SPI_CS_DISABLED_str
 _MSG_SPI_CS_DISABLED_str:
-	.pasciz "CS DISABLED"
+	.pasciz "\320 D\322ABLED"
 
 	; MSG_SPI_CS_ENABLED
 	.section .text.MSG_SPI_CS_ENABLED, code
 	.global _MSG_SPI_CS_ENABLED_str
 _MSG_SPI_CS_ENABLED_str:
-	.pasciz "CS ENABLED"
+	.pasciz "\320 ENABLED"
 
 	; MSG_SPI_CS_MODE_PROMPT
 	.section .text.MSG_SPI_CS_MODE_PROMPT, code
 	.global _MSG_SPI_CS_MODE_PROMPT_str
 _MSG_SPI_CS_MODE_PROMPT_str:
-	.pasciz "CS:\r\n 1. CS\r\n 2. /CS *default"
+	.pasciz "\320\273\320\267/\320\333\231fa\245t"
 
 	; MSG_SPI_EDGE_PROMPT
 	.section .text.MSG_SPI_EDGE_PROMPT, code
 	.global _MSG_SPI_EDGE_PROMPT_str
 _MSG_SPI_EDGE_PROMPT_str:
-	.pasciz "Output clock edge:\r\n 1. Idle to active\r\n 2. Active to idle *default"
+	.pasciz "Out\275\203c\243ck \261ge\273I\340\266\346e\267Ac\305\205\266i\340*\231fa\245t"
+
+	; MSG_SPI_FLASH_MODE_IDENTIFIER
+	.section .text.MSG_SPI_FLASH_MODE_IDENTIFIER, code
+	.global _MSG_SPI_FLASH_MODE_IDENTIFIER_str
+_MSG_SPI_FLASH_MODE_IDENTIFIER_str:
+	.pasciz "FLS1"
 
 	; MSG_SPI_MACRO_MENU
 	.section .text.MSG_SPI_MACRO_MENU, code
 	.global _MSG_SPI_MACRO_MENU_str
 _MSG_SPI_MACRO_MENU_str:
-	.pasciz " 0.Macro menu\r\n 1.Sniff CS low\r\n 2.Sniff all traffic\r\n10.Set clock idle low\r\n11.Set clock idle high\r\n12.Set edge idle to active\r\n13.Set edge active to idle\r\n14.Sample phase on middle\r\n15.Sample phase on end"
+	.pasciz " \334\335\343u\237.Sniff \320 \347\233.Sniff \247l \344aff\341\314\334\315c\243ck i\340\347\3141.\315c\243ck i\340\272gh\3142.\315\261g\205i\340\266\346e\314\303\315\261g\205\346\205\266id\342\3144.Samp\252ph\337\205\213 midd\342\3145.Samp\252ph\337\205\213 \224d"
 
 	; MSG_SPI_MODE_HEADER_START
 	.section .text.MSG_SPI_MODE_HEADER_START, code
 	.global _MSG_SPI_MODE_HEADER_START_str
 _MSG_SPI_MODE_HEADER_START_str:
-	.pasciz "SPI (spd ckp ske smp csl hiz)=( "
+	.pasciz "SPI\207\265\210ck\250sk\205sm\250csl \272z)=( "
 
 	; MSG_SPI_MODE_IDENTIFIER
 	.section .text.MSG_SPI_MODE_IDENTIFIER, code
@@ -1694,55 +1784,61 @@ _MSG_SPI_MODE_IDENTIFIER_str:
 	.section .text.MSG_SPI_PINS_STATE, code
 	.global _MSG_SPI_PINS_STATE_str
 _MSG_SPI_PINS_STATE_str:
-	.pasciz "CS\tMISO\tCLK\tMOSI"
+	.pasciz "\320\tM\322O\t\312K\t\377SI"
 
 	; MSG_SPI_POLARITY_PROMPT
 	.section .text.MSG_SPI_POLARITY_PROMPT, code
 	.global _MSG_SPI_POLARITY_PROMPT_str
 _MSG_SPI_POLARITY_PROMPT_str:
-	.pasciz "Clock polarity:\r\n 1. Idle low *default\r\n 2. Idle high"
+	.pasciz "C\243ck p\254\223\217y\273I\340\347\333\231fa\245t\267I\340\272gh"
 
 	; MSG_SPI_SAMPLE_PROMPT
 	.section .text.MSG_SPI_SAMPLE_PROMPT, code
 	.global _MSG_SPI_SAMPLE_PROMPT_str
 _MSG_SPI_SAMPLE_PROMPT_str:
-	.pasciz "Input sample phase:\r\n 1. Middle *default\r\n 2. End"
+	.pasciz "In\275\203samp\252ph\337e\273Mid\340*\231fa\245t\267End"
 
 	; MSG_SPI_SPEED_PROMPT
 	.section .text.MSG_SPI_SPEED_PROMPT, code
 	.global _MSG_SPI_SPEED_PROMPT_str
 _MSG_SPI_SPEED_PROMPT_str:
-	.pasciz "Set speed:\r\n 1.  30KHz\r\n 2. 125KHz\r\n 3. 250KHz\r\n 4.   1MHz\r\n 5.  50KHz\r\n 6. 1.3MHz\r\n 7.   2MHz\r\n 8. 2.6MHz\r\n 9. 3.2MHz\r\n10.   4MHz\r\n11. 5.3MHz\r\n12.   8MHz"
+	.pasciz "\315\265e\261\273 30\304\267125\304\2013\204250\304\364\204\2201\353\2015\204 50\304\2016\2041.3\353\2017\204\2202\353\2018\2042.6\353\2019\204\3032\353\3140\204\2204\353\3141\2045.3\353\3142\204\2208\353"
+
+	; MSG_SWD_MODE_IDENTIFIER
+	.section .text.MSG_SWD_MODE_IDENTIFIER, code
+	.global _MSG_SWD_MODE_IDENTIFIER_str
+_MSG_SWD_MODE_IDENTIFIER_str:
+	.pasciz "SWD1"
 
 	; MSG_UART_MODE_IDENTIFIER
 	.section .text.MSG_UART_MODE_IDENTIFIER, code
 	.global _MSG_UART_MODE_IDENTIFIER_str
 _MSG_UART_MODE_IDENTIFIER_str:
-	.pasciz "ART1"
+	.pasciz "\262T1"
 
 	; MSG_UART_NORMAL_TO_EXIT
 	.section .text.MSG_UART_NORMAL_TO_EXIT, code
 	.global _MSG_UART_NORMAL_TO_EXIT_str
 _MSG_UART_NORMAL_TO_EXIT_str:
-	.pasciz "Normal to exit"
+	.pasciz "N\221m\247 \266\271\217"
 
 	; MSG_UART_PINS_STATE
 	.section .text.MSG_UART_PINS_STATE, code
 	.global _MSG_UART_PINS_STATE_str
 _MSG_UART_PINS_STATE_str:
-	.pasciz "-\tRxD\t-\tTxD"
+	.pasciz "\351RxD\t\351TxD"
 
 	; MSG_UNKNOWN_MACRO_ERROR
 	.section .text.MSG_UNKNOWN_MACRO_ERROR, code
 	.global _MSG_UNKNOWN_MACRO_ERROR_str
 _MSG_UNKNOWN_MACRO_ERROR_str:
-	.pasciz "Unknown macro, try ? or (0) for help"
+	.pasciz "Unk\361wn m\300o\222\344\234? \221\2070\235f\221 help"
 
 	; MSG_USING_ONBOARD_I2C_EEPROM
 	.section .text.MSG_USING_ONBOARD_I2C_EEPROM, code
 	.global _MSG_USING_ONBOARD_I2C_EEPROM_str
 _MSG_USING_ONBOARD_I2C_EEPROM_str:
-	.pasciz "Now using on-board EEPROM I2C interface"
+	.pasciz "Now \276\331\213-bo\223\210EEP\253 \376 \206t\212f\225e"
 
 	; MSG_VOLTAGE_UNIT
 	.section .text.MSG_VOLTAGE_UNIT, code
@@ -1754,37 +1850,37 @@ _MSG_VOLTAGE_UNIT_str:
 	.section .text.MSG_VOLTAGE_VPULLUP_ALREADY_PRESENT, code
 	.global _MSG_VOLTAGE_VPULLUP_ALREADY_PRESENT_str
 _MSG_VOLTAGE_VPULLUP_ALREADY_PRESENT_str:
-	.pasciz "Warning: already a voltage on Vpullup pin"
+	.pasciz "W\223n\206g\230\247\215\260\234a v\254tag\205\213 Vp\350\363\330"
 
 	; MSG_VPU_3V3_MARKER
 	.section .text.MSG_VPU_3V3_MARKER, code
 	.global _MSG_VPU_3V3_MARKER_str
 _MSG_VPU_3V3_MARKER_str:
-	.pasciz "Vpu=3V3, "
+	.pasciz "V\275=3V3\222"
 
 	; MSG_VPU_5V_MARKER
 	.section .text.MSG_VPU_5V_MARKER, code
 	.global _MSG_VPU_5V_MARKER_str
 _MSG_VPU_5V_MARKER_str:
-	.pasciz "Vpu=5V, "
+	.pasciz "V\275=5V\222"
 
 	; MSG_VREG_TOO_LOW
 	.section .text.MSG_VREG_TOO_LOW, code
 	.global _MSG_VREG_TOO_LOW_str
 _MSG_VREG_TOO_LOW_str:
-	.pasciz "VREG too low, is there a short?"
+	.pasciz "V\246G \362\211\347\222i\216th\212\205a\302h\221t?"
 
 	; MSG_WARNING_HEADER
 	.section .text.MSG_WARNING_HEADER, code
 	.global _MSG_WARNING_HEADER_str
 _MSG_WARNING_HEADER_str:
-	.pasciz "Warning: "
+	.pasciz "W\223n\206g\230"
 
 	; MSG_WARNING_SHORT_OR_NO_PULLUP
 	.section .text.MSG_WARNING_SHORT_OR_NO_PULLUP, code
 	.global _MSG_WARNING_SHORT_OR_NO_PULLUP_str
 _MSG_WARNING_SHORT_OR_NO_PULLUP_str:
-	.pasciz "*Short or no pull-up "
+	.pasciz "*Sh\221\203\221 n\211p\350-\363"
 
 	; MSG_XSV1_MODE_IDENTIFIER
 	.section .text.MSG_XSV1_MODE_IDENTIFIER, code
@@ -1792,3 +1888,136 @@ _MSG_WARNING_SHORT_OR_NO_PULLUP_str:
 _MSG_XSV1_MODE_IDENTIFIER_str:
 	.pasciz "XSV1"
 
+	; Dictionary, one symbol pair per word
+	.section .text.bp_message_dictionary, code
+	.global _bp_message_dictionary
+_bp_message_dictionary:
+	.pword 0x0A0D	; 0x80 "\r\n"
+	.pword 0x2080	; 0x81 "\r\n "
+	.pword 0x2D2D	; 0x82 "--"
+	.pword 0x2074	; 0x83 "t "
+	.pword 0x202E	; 0x84 ". "
+	.pword 0x2065	; 0x85 "e "
+	.pword 0x6E69	; 0x86 "in"
+	.pword 0x2820	; 0x87 " ("
+	.pword 0x2064	; 0x88 "d "
+	.pword 0x206F	; 0x89 "o "
+	.pword 0x7265	; 0x8A "er"
+	.pword 0x6E6F	; 0x8B "on"
+	.pword 0x8282	; 0x8C "----"
+	.pword 0x6572	; 0x8D "re"
+	.pword 0x2073	; 0x8E "s "
+	.pword 0x7469	; 0x8F "it"
+	.pword 0x2020	; 0x90 "  "
+	.pword 0x726F	; 0x91 "or"
+	.pword 0x202C	; 0x92 ", "
+	.pword 0x7261	; 0x93 "ar"
+	.pword 0x6E65	; 0x94 "en"
+	.pword 0x6361	; 0x95 "ac"
+	.pword 0x6574	; 0x96 "te"
+	.pword 0x0909	; 0x97 "\t\t"
+	.pword 0x203A	; 0x98 ": "
+	.pword 0x6564	; 0x99 "de"
+	.pword 0x4F52	; 0x9A "RO"
+	.pword 0x3281	; 0x9B "\r\n 2"
+	.pword 0x2079	; 0x9C "y "
+	.pword 0x2029	; 0x9D ") "
+	.pword 0x7A48	; 0x9E "Hz"
+	.pword 0x3181	; 0x9F "\r\n 1"
+	.pword 0x6974	; 0xA0 "ti"
+	.pword 0x6E61	; 0xA1 "an"
+	.pword 0x3030	; 0xA2 "00"
+	.pword 0x6F6C	; 0xA3 "lo"
+	.pword 0x7473	; 0xA4 "st"
+	.pword 0x6C75	; 0xA5 "ul"
+	.pword 0x4552	; 0xA6 "RE"
+	.pword 0x6C61	; 0xA7 "al"
+	.pword 0x2070	; 0xA8 "p "
+	.pword 0x2067	; 0xA9 "g "
+	.pword 0x856C	; 0xAA "le "
+	.pword 0x4D9A	; 0xAB "ROM"
+	.pword 0x6C6F	; 0xAC "ol"
+	.pword 0x8C8C	; 0xAD "--------"
+	.pword 0x7830	; 0xAE "0x"
+	.pword 0x6553	; 0xAF "Se"
+	.pword 0x6461	; 0xB0 "ad"
+	.pword 0x6465	; 0xB1 "ed"
+	.pword 0x5241	; 0xB2 "AR"
+	.pword 0x5441	; 0xB3 "AT"
+	.pword 0x5541	; 0xB4 "AU"
+	.pword 0x7073	; 0xB5 "sp"
+	.pword 0x8974	; 0xB6 "to "
+	.pword 0x849B	; 0xB7 "\r\n 2. "
+	.pword 0x849F	; 0xB8 "\r\n 1. "
+	.pword 0x7865	; 0xB9 "ex"
+	.pword 0x6968	; 0xBA "hi"
+	.pword 0xB83A	; 0xBB ":\r\n 1. "
+	.pword 0x4441	; 0xBC "AD"
+	.pword 0x7570	; 0xBD "pu"
+	.pword 0x7375	; 0xBE "us"
+	.pword 0xAE87	; 0xBF " (0x"
+	.pword 0x7295	; 0xC0 "acr"
+	.pword 0x58B4	; 0xC1 "AUX"
+	.pword 0x7320	; 0xC2 " s"
+	.pword 0x2E33	; 0xC3 "3."
+	.pword 0x9E4B	; 0xC4 "KHz"
+	.pword 0x76A0	; 0xC5 "tiv"
+	.pword 0x5309	; 0xC6 "\tS"
+	.pword 0x5320	; 0xC7 " S"
+	.pword 0xAB20	; 0xC8 " ROM"
+	.pword 0x3631	; 0xC9 "16"
+	.pword 0x4C43	; 0xCA "CL"
+	.pword 0x6552	; 0xCB "Re"
+	.pword 0x3180	; 0xCC "\r\n1"
+	.pword 0x83AF	; 0xCD "Set "
+	.pword 0x89C0	; 0xCE "acro "
+	.pword 0x2309	; 0xCF "\t#"
+	.pword 0x5343	; 0xD0 "CS"
+	.pword 0x5245	; 0xD1 "ER"
+	.pword 0x5349	; 0xD2 "IS"
+	.pword 0x9661	; 0xD3 "ate"
+	.pword 0x8369	; 0xD4 "it "
+	.pword 0x6F6D	; 0xD5 "mo"
+	.pword 0x6D6F	; 0xD6 "om"
+	.pword 0x756F	; 0xD7 "ou"
+	.pword 0x8670	; 0xD8 "pin"
+	.pword 0xA986	; 0xD9 "ing "
+	.pword 0xBFC8	; 0xDA " ROM (0x"
+	.pword 0x2A20	; 0xDB " *"
+	.pword 0x2E30	; 0xDC "0."
+	.pword 0xCE4D	; 0xDD "Macro "
+	.pword 0x6261	; 0xDE "ab"
+	.pword 0x7361	; 0xDF "as"
+	.pword 0xAA64	; 0xE0 "dle "
+	.pword 0x6369	; 0xE1 "ic"
+	.pword 0x656C	; 0xE2 "le"
+	.pword 0x946D	; 0xE3 "men"
+	.pword 0x7274	; 0xE4 "tr"
+	.pword 0x738D	; 0xE5 "res"
+	.pword 0xC595	; 0xE6 "activ"
+	.pword 0x77A3	; 0xE7 "low"
+	.pword 0x6CA5	; 0xE8 "ull"
+	.pword 0x092D	; 0xE9 "-\t"
+	.pword 0x4843	; 0xEA "CH"
+	.pword 0x9E4D	; 0xEB "MHz"
+	.pword 0x4553	; 0xEC "SE"
+	.pword 0x6863	; 0xED "ch"
+	.pword 0x8B63	; 0xEE "con"
+	.pword 0x7465	; 0xEF "et"
+	.pword 0x7369	; 0xF0 "is"
+	.pword 0x6F6E	; 0xF1 "no"
+	.pword 0x6F74	; 0xF2 "to"
+	.pword 0xA875	; 0xF3 "up "
+	.pword 0x3481	; 0xF4 "\r\n 4"
+	.pword 0x2090	; 0xF5 "   "
+	.pword 0x0997	; 0xF6 "\t\t\t"
+	.pword 0x30CF	; 0xF7 "\t#0"
+	.pword 0x4C20	; 0xF8 " L"
+	.pword 0x4332	; 0xF9 "2C"
+	.pword 0x4B43	; 0xFA "CK"
+	.pword 0x4544	; 0xFB "DE"
+	.pword 0xB344	; 0xFC "DAT"
+	.pword 0x6948	; 0xFD "Hi"
+	.pword 0xF949	; 0xFE "I2C"
+	.pword 0x4F4D	; 0xFF "MO"
+
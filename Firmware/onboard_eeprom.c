@@ -22,13 +22,19 @@
 
 #ifdef BUSPIRATEV4
 
-/**
- * How many milliseconds to wait after a I2C flash write.
- */
-#define I2C_WRITE_DELAY_TIME 10
+#include <string.h>
 
 #include "base.h"
 
+/**
+ * How many times to poll the EEPROM for an acknowledge after a page write
+ * before giving up.
+ *
+ * Each poll takes about 25us at 400kHz, so this is well past the 5ms maximum
+ * write cycle time of the chip.
+ */
+#define EEPROM_WRITE_POLL_ATTEMPTS 1000
+
 /**
  * On-board EEPROM I2C address for write operations.
  *
@@ -133,33 +139,25 @@ static void eeprom_start(void);
 static void eeprom_stop(void);
 
 /**
- * Reads a byte from the on-board EEPROM at the given address.
+ * Starts a write transaction addressed at the given EEPROM location.
  *
- * @warning This function can only read bytes located in the first 64 kilobytes
- *          of the chip in use - keep in mind that the Bus Pirate v4 ships with
- *          a 8 kilobytes I2C flash chip.  Reading past the 8 kilobyte mark will
- *          yield an undefined condition.
  * @warning The operation will be performed synchronously.
  *
- * @param[in] address the address to read the byte from.
- * @return the byte read from the EEPROM.
+ * @param[in] address the address the transaction refers to.
+ *
+ * @return true if the EEPROM acknowledged every byte, false otherwise.
  */
-static uint8_t eeprom_read_byte(uint16_t address);
+static bool eeprom_select_address(uint16_t address);
 
 /**
- * Writes a byte on the on-board EEPROM at the given address.
+ * Waits for the EEPROM to finish its internal write cycle, by sending it
+ * write requests until one of them is acknowledged.
  *
- * @warning This function can only write bytes located in the first 64 kilobytes
- *          of the chip in use - keep in mind that the Bus Pirate v4 ships with
- *          a 8 kilobytes I2C flash chip.  Writing past the 8 kilobyte mark will
- *          yield an undefined condition.
  * @warning The operation will be performed synchronously.
  *
- * @param[in] value the byte to write.
- * @param[in] address the address to write the byte to.
- * @return the byte read from the EEPROM.
+ * @return true if the EEPROM became ready, false if it never answered.
  */
-static bool eeprom_write_byte(uint8_t value, uint16_t address);
+static bool eeprom_wait_for_write(void);
 
 void eeprom_initialize(void) {
 
@@ -183,9 +181,75 @@ void eeprom_initialize(void) {
 }
 
 bool eeprom_test(void) {
+  uint8_t original[EEPROM_PAGE_SIZE];
+  uint8_t pattern[EEPROM_PAGE_SIZE];
+  uint8_t readback[EEPROM_PAGE_SIZE];
+  size_t index;
+  bool result;
+
+  /* Keep the first page around, it may hold a saved BASIC program. */
+  if (!eeprom_read_block(0, original, sizeof(original))) {
+    return false;
+  }
+
+  /* Write a pattern that toggles every bit of the original contents. */
+  for (index = 0; index < sizeof(pattern); index++) {
+    pattern[index] = ~original[index] ^ (uint8_t)index;
+  }
+  result = eeprom_write_page(0, pattern, sizeof(pattern)) &&
+           eeprom_read_block(0, readback, sizeof(readback)) &&
+           (memcmp(pattern, readback, sizeof(pattern)) == 0);
+
+  /* Put the first page back as it was. */
+  return eeprom_write_page(0, original, sizeof(original)) && result;
+}
+
+bool eeprom_read_block(uint16_t address, uint8_t *buffer, size_t length) {
+  if ((length == 0) || (address >= EEPROM_SIZE) ||
+      (length > (EEPROM_SIZE - address))) {
+    return false;
+  }
+
+  /* Set up I2C access to the EEPROM. */
+  eeprom_i2c_setup();
+
+  /* Send a dummy write to the bus with the requested read address. */
+  if (!eeprom_select_address(address)) {
+    eeprom_stop();
+    return false;
+  }
+
+  /* Restart data transmission on the bus and send a read request. */
+  eeprom_start();
+  eeprom_i2c_write(EEPROM_I2C_READ_ADDRESS);
+
+  /* The EEPROM keeps sending bytes for as long as they get ACKed. */
+  while (length > 1) {
+    *buffer++ = eeprom_i2c_read();
+    eeprom_i2c_send_ack(EEPROM_I2C_ACK);
+    length--;
+  }
+  *buffer = eeprom_i2c_read();
+
+  /* Return a NACK for acknowledgment of the last byte. */
+  eeprom_i2c_send_ack(EEPROM_I2C_NACK);
+
+  /* Stop data transmission on the bus. */
+  eeprom_stop();
+
+  return true;
+}
+
+bool eeprom_write_page(uint16_t address, const uint8_t *buffer,
+                       size_t length) {
   bool result;
   bool write_protection;
 
+  if ((length == 0) || (address >= EEPROM_SIZE) ||
+      (((address % EEPROM_PAGE_SIZE) + length) > EEPROM_PAGE_SIZE)) {
+    return false;
+  }
+
   /* Set up I2C access to the EEPROM. */
   eeprom_i2c_setup();
 
@@ -195,19 +259,21 @@ bool eeprom_test(void) {
   /* Enable writing to the EEPROM. */
   BP_EE_WP = LOW;
 
-  /* Write 0xFF (the default value) to offset 0. */
-  eeprom_write_byte(0xFF, 0);
-  bp_delay_ms(I2C_WRITE_DELAY_TIME);
-
-  /* Write 0x10 to offset 0. */
-  eeprom_write_byte(0x10, 0);
-  bp_delay_ms(I2C_WRITE_DELAY_TIME);
+  /* Send the target address and the bytes to write to the bus. */
+  result = eeprom_select_address(address);
+  while (result && (length > 0)) {
+    eeprom_i2c_write(*buffer++);
+    result = (eeprom_i2c_get_ack() == EEPROM_I2C_ACK);
+    length--;
+  }
 
-  /* Checks if writing 0x10 actually succeeded. */
-  result = (eeprom_read_byte(0) == 0x10);
+  /* Stop data transmission on the bus, this starts the write cycle. */
+  eeprom_stop();
 
-  /* Set offset 0 to the appropriate value. */
-  eeprom_write_byte(0xFF, 0);
+  /* Wait until the EEPROM is done writing the page. */
+  if (result) {
+    result = eeprom_wait_for_write();
+  }
 
   /* Restore the old write protection flag state. */
   BP_EE_WP = write_protection;
@@ -301,56 +367,38 @@ void eeprom_i2c_setup(void) {
   I2C1CONbits.I2CEN = ON;
 }
 
-uint8_t eeprom_read_byte(uint16_t address) {
-  uint8_t byte;
-
-  /* Start data transmission on the bus. */
-  eeprom_start();
-
-  /* Send a dummy write to the bus with the requested read address. */
-  eeprom_i2c_write(EEPROM_I2C_WRITE_ADDRESS);
-  eeprom_i2c_write(address >> 8);
-  eeprom_i2c_write(address);
-
-  /* Start data transmission on the bus. */
-  eeprom_start();
-
-  /* Send to the bus a read request. */
-  eeprom_i2c_write(EEPROM_I2C_READ_ADDRESS);
-
-  /* Read the byte from the EEPROM. */
-  byte = eeprom_i2c_read();
-
-  /* Return a NACK for acknowledgment. */
-  eeprom_i2c_send_ack(EEPROM_I2C_NACK);
-
-  /* Stop data transmission on the bus. */
-  eeprom_stop();
-
-  return byte;
-}
-
-bool eeprom_write_byte(uint8_t value, uint16_t address) {
-  bool result;
+bool eeprom_select_address(uint16_t address) {
 
   /* Start data transmission on the bus. */
   eeprom_start();
 
   /* Send a write request containing the target address to the bus. */
   eeprom_i2c_write(EEPROM_I2C_WRITE_ADDRESS);
+  if (eeprom_i2c_get_ack() != EEPROM_I2C_ACK) {
+    return false;
+  }
   eeprom_i2c_write(address >> 8);
   eeprom_i2c_write(address);
 
-  /* Send the byte to write to the bus. */
-  eeprom_i2c_write(value);
-
-  /* Read the acknowledgment result from the operation. */
-  result = eeprom_i2c_get_ack();
+  return eeprom_i2c_get_ack() == EEPROM_I2C_ACK;
+}
 
-  /* Stop data transmission on the bus. */
-  eeprom_stop();
+bool eeprom_wait_for_write(void) {
+  uint16_t attempts;
+  bool acknowledged;
+
+  /* The EEPROM does not acknowledge its address until the write is over. */
+  for (attempts = 0; attempts < EEPROM_WRITE_POLL_ATTEMPTS; attempts++) {
+    eeprom_start();
+    eeprom_i2c_write(EEPROM_I2C_WRITE_ADDRESS);
+    acknowledged = (eeprom_i2c_get_ack() == EEPROM_I2C_ACK);
+    eeprom_stop();
+    if (acknowledged) {
+      return true;
+    }
+  }
 
-  return result;
+  return false;
 }
 
 #endif /* BUSPIRATEV4 */
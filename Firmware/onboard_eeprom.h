@@ -23,6 +23,18 @@
 #ifdef BUSPIRATEV4
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * On-board EEPROM size, in bytes.
+ */
+#define EEPROM_SIZE 8192
+
+/**
+ * On-board EEPROM write page size, in bytes.
+ */
+#define EEPROM_PAGE_SIZE 32
 
 /**
  * Initializes the I/O port for communication with the on-board EEPROM.
@@ -36,6 +48,41 @@ void eeprom_initialize(void);
  */
 bool eeprom_test(void);
 
+/**
+ * Reads a block of consecutive bytes from the on-board EEPROM, in a single
+ * sequential read transaction.
+ *
+ * @warning The operation will be performed synchronously.
+ *
+ * @param[in] address the address to start reading from.
+ * @param[out] buffer where to store the bytes read.
+ * @param[in] length how many bytes to read.
+ *
+ * @return true if the EEPROM acknowledged the request, false otherwise.
+ */
+bool eeprom_read_block(uint16_t address, uint8_t *buffer, size_t length);
+
+/**
+ * Writes up to a page worth of bytes to the on-board EEPROM, and waits for the
+ * chip to finish its write cycle by polling for an acknowledge.
+ *
+ * The write protection line is lowered for the duration of the write and then
+ * restored to its previous state.
+ *
+ * @warning The bytes to write must not cross a EEPROM_PAGE_SIZE boundary, as
+ *          the chip would wrap around to the start of the page otherwise.
+ * @warning The operation will be performed synchronously.
+ *
+ * @param[in] address the address to start writing to.
+ * @param[in] buffer the bytes to write.
+ * @param[in] length how many bytes to write.
+ *
+ * @return true if the page was written, false if the parameters are out of
+ *         range or the EEPROM did not respond.
+ */
+bool eeprom_write_page(uint16_t address, const uint8_t *buffer,
+                       size_t length);
+
 #endif /* BUSPIRATEV4 */
 
 #endif /* !BP_ONBOARD_EEPROM_H */
\ No newline at end of file
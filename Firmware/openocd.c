@@ -21,11 +21,16 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "buffer_arena.h"
 #include "core.h"
 
 extern mode_configuration_t mode_configuration;
 extern bus_pirate_configuration_t bus_pirate_configuration;
 
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif /* !min */
+
 // tris registers
 #define OOCD_TDO_TRIS BP_MISO_DIR
 #define OOCD_TMS_TRIS BP_CS_DIR
@@ -62,6 +67,12 @@ extern bus_pirate_configuration_t bus_pirate_configuration;
 #define OOCD_TRST_ODC BP_AUX1
 #endif /* BUSPIRATEV3 */
 
+#ifdef BUSPIRATEV4
+// returned clock for adaptive clocking, on the spare AUX2 pin
+#define OOCD_RTCK BP_AUX2
+#define OOCD_RTCK_TRIS BP_AUX2_DIR
+#endif /* BUSPIRATEV4 */
+
 #define CMD_UNKNOWN 0x00
 #define CMD_PORT_MODE 0x01
 #define CMD_FEATURE 0x02
@@ -71,13 +82,24 @@ extern bus_pirate_configuration_t bus_pirate_configuration;
 #define CMD_ENTER_OOCD 0x06 // this is the same as in binIO
 #define CMD_UART_SPEED 0x07
 #define CMD_JTAG_SPEED 0x08
+#define CMD_JTAG_CLOCK 0x09
+
+// longest answer sent back, the CMD_READ_ADCS one
+#define OOCD_ANSWER_MAX_LENGTH 10
 
 static void binOpenOCDPinMode(unsigned char mode);
 static void binOpenOCDHandleFeature(unsigned char feat, unsigned char action);
 static void binOpenOCDAnswer(unsigned char *buf, unsigned int len);
+static void binOpenOCDTapShiftFailed(unsigned char *buf, unsigned int bytes);
+static void binOpenOCDSelectClock(unsigned char *buf, unsigned char index);
+#ifdef BUSPIRATEV3
 extern void binOpenOCDTapShiftFast(unsigned char *in_buf,
                                    unsigned char *out_buf, unsigned int bits,
                                    unsigned int delay);
+#else
+extern void binOpenOCDTapShiftBlock(const uint8_t *in_buf, uint8_t *out_buf,
+                                    unsigned int bits, unsigned int delay);
+#endif /* BUSPIRATEV3 */
 
 enum {
   FEATURE_LED = 0x01,
@@ -97,13 +119,75 @@ enum {
 
 static unsigned int openocd_jtag_delay;
 
+/**
+ * Instruction cycles taken by one TAP shift bit with no delay, in both
+ * binOpenOCDTapShiftFast and binOpenOCDTapShiftBlock.  Each unit of delay
+ * adds two cycles, one per clock half period.
+ */
+#define OOCD_TCK_CYCLES_PER_BIT 15
+
+/**
+ * Delay giving the closest TCK frequency not above the one wanted (or the
+ * fastest clock available).
+ */
+#define OOCD_TCK_DELAY(frequency)                                              \
+  ((FCY / (frequency) > OOCD_TCK_CYCLES_PER_BIT)                               \
+       ? (((FCY / (frequency)) - OOCD_TCK_CYCLES_PER_BIT + 1) / 2)             \
+       : 0)
+
+/**
+ * CMD_JTAG_CLOCK frequency table, fastest first.
+ */
+static const uint16_t OPENOCD_JTAG_CLOCK_DELAYS[] = {
+    OOCD_TCK_DELAY(1000000), OOCD_TCK_DELAY(500000), OOCD_TCK_DELAY(250000),
+    OOCD_TCK_DELAY(100000),  OOCD_TCK_DELAY(50000),  OOCD_TCK_DELAY(20000),
+    OOCD_TCK_DELAY(10000),   OOCD_TCK_DELAY(5000)};
+
+#define OOCD_JTAG_CLOCKS                                                       \
+  (sizeof(OPENOCD_JTAG_CLOCK_DELAYS) / sizeof(OPENOCD_JTAG_CLOCK_DELAYS[0]))
+
+/**
+ * CMD_JTAG_CLOCK index selecting adaptive clocking.
+ */
+#define OOCD_JTAG_CLOCK_ADAPTIVE 0xFF
+
+#ifdef BUSPIRATEV4
+
+/**
+ * How long to wait for RTCK to follow TCK, in polling loops (about 20ms), so
+ * a target not driving RTCK slows the shift down instead of hanging it.
+ */
+#define OOCD_RTCK_TIMEOUT 0xFFFF
+
+/** TCK waits for RTCK instead of following openocd_jtag_delay. */
+static bool openocd_jtag_adaptive;
+
+static void binOpenOCDTapShiftAdaptive(const uint8_t *in_buf, uint8_t *out_buf,
+                                       unsigned int bits);
+static void binOpenOCDWaitRtck(const bool level);
+
+#endif /* BUSPIRATEV4 */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * TAP shift block size, one CDC packet.  A block of TDI/TMS pairs holds
+ * 256 bits and yields 32 TDO bytes, so every other block fills an IN packet.
+ */
+#define OOCD_TAP_BLOCK_SIZE 64
+
+#endif /* BUSPIRATEV4 */
+
 void binOpenOCD(void) {
-  uint8_t *buf = bus_pirate_configuration.terminal_input;
+  uint8_t buf[OOCD_ANSWER_MAX_LENGTH];
   unsigned int i, j;
   unsigned char inByte;
   unsigned char inByte2;
 
   openocd_jtag_delay = 1;
+#ifdef BUSPIRATEV4
+  openocd_jtag_adaptive = false;
+#endif /* BUSPIRATEV4 */
 
   MSG_OPENOCD_MODE_IDENTIFIER;
 
@@ -180,6 +264,12 @@ void binOpenOCD(void) {
       inByte = user_serial_read_byte();
       inByte2 = user_serial_read_byte();
       openocd_jtag_delay = (inByte << 8) | inByte2;
+#ifdef BUSPIRATEV4
+      openocd_jtag_adaptive = false;
+#endif /* BUSPIRATEV4 */
+      break;
+    case CMD_JTAG_CLOCK:
+      binOpenOCDSelectClock(buf, user_serial_read_byte());
       break;
     case CMD_UART_SPEED:
       inByte = user_serial_read_byte();
@@ -202,103 +292,128 @@ void binOpenOCD(void) {
       binOpenOCDAnswer(buf, 2);
       break;
     case CMD_TAP_SHIFT: {
+#ifdef BUSPIRATEV3
+      uint8_t *tdo;
+#else
+      uint8_t *tap_input;
+      uint8_t *tap_output;
+#endif /* BUSPIRATEV3 */
+
       inByte = user_serial_read_byte();
       inByte2 = user_serial_read_byte();
 
-#if defined(BUSPIRATEV3)
-
-      IFS0bits.U1RXIF = 0; // reset the RX flag
+      j = (inByte << 8) | inByte2; // number of bit sequences
 
+#ifdef BUSPIRATEV3
+      // long shifts go through the buffers one segment at a time
+      // TDI/TMS pairs come in two bits per sequence, TDO goes out one bit
+      UART1RXBuf = bp_buffer_arena_reserve(
+          2 * (BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT / 8));
+      tdo = bp_buffer_arena_reserve(BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT / 8);
+      if ((UART1RXBuf == NULL) || (tdo == NULL)) {
+        bp_buffer_arena_release(tdo);
+        bp_buffer_arena_release(UART1RXBuf);
+        UART1RXBuf = NULL;
+        binOpenOCDTapShiftFailed(buf, 2 * ((j >> 3) + ((j & 7) ? 1 : 0)));
+        return;
+      }
+      UART1TXBuf = tdo;
+#else
+      // arena blocks are word aligned, as binOpenOCDTapShiftBlock needs
+      tap_input = bp_buffer_arena_reserve(2 * OOCD_TAP_BLOCK_SIZE);
+      if (tap_input == NULL) {
+        binOpenOCDTapShiftFailed(buf,
+                                 (j > 0) ? 2 * ((j >> 3) + ((j & 7) ? 1 : 0))
+                                         : 2);
+        return;
+      }
+      tap_output = tap_input + OOCD_TAP_BLOCK_SIZE;
 #endif /* BUSPIRATEV3 */
 
-      j = (inByte << 8) | inByte2; // number of bit sequences
-
-      j = min(j, BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT);
       buf[0] = CMD_TAP_SHIFT;
       buf[1] = inByte;
       buf[2] = inByte2;
       binOpenOCDAnswer(buf, 3);
 
 #if defined(BUSPIRATEV3)
-      i = (j + 7) / 8; // number of bytes used
-
-      // prepare the interrupt transfer
-      UART1RXBuf = (unsigned char *)bus_pirate_configuration.terminal_input;
-      UART1RXToRecv = 2 * i;
-      UART1RXRecvd = 0;
-
-      UART1TXBuf =
-          (unsigned char *)(bus_pirate_configuration.terminal_input +
-                            2100); // 2048 bytes + 3 command header + to be sure
-      UART1TXSent = 0;
-      UART1TXAvailable = 0;
-
-      // enable RX interrupt
-      IEC0bits.U1RXIE = 1;
-
-      binOpenOCDTapShiftFast(UART1RXBuf, UART1TXBuf, j, openocd_jtag_delay);
-
-#else
-
-      int16_t bit_sequences = (int16_t)(j & 0x7FFF);
+      // let the answer above go out before starting the block transfer
+      user_serial_wait_transmission_done();
 
       do {
-        /* Read TDI and TMS. */
+        unsigned int bits = min(j, BP_JTAG_OPENOCD_BIT_SEQUENCES_LIMIT);
+
+        i = (bits + 7) / 8; // number of bytes used
 
-        uint16_t tdi_data_out = user_serial_read_byte();
-        uint16_t tms_data_out = user_serial_read_byte();
-        tdi_data_out = tdi_data_out |
-                       ((bit_sequences > 8) ? user_serial_read_byte() : 0) << 8;
-        tms_data_out = tms_data_out |
-                       ((bit_sequences > 8) ? user_serial_read_byte() : 0) << 8;
+        // prepare the interrupt transfer, the previous segment's input is
+        // all consumed so the RX buffer can be refilled right away
+        user_serial_start_block_reception(UART1RXBuf, 2 * i);
 
-        /* Clock TDI and TMS out, while reading TDO in. */
+        // the previous segment's TDO must be out before its buffer is reused
+        while (UART1TXSent != UART1TXAvailable) {
+        }
+        UART1TXSent = 0;
+        UART1TXAvailable = 0;
 
-        size_t bits_to_process = min(16, bit_sequences);
-        size_t counter;
-        uint16_t tdo_data_in = 0;
+        binOpenOCDTapShiftFast(UART1RXBuf, tdo, bits, openocd_jtag_delay);
+        j -= bits;
+      } while (j > 0);
 
-        for (counter = 0; counter < bits_to_process; counter++) {
-#ifdef BP_JTAG_OPENOCD_DELAY
-          __asm volatile("\t repeat %0 \n"
-                         "\t nop       \n"
-                         :
-                         : "r"(openocd_jtag_delay));
-#endif /* BP_JTAG_OPENOCD_DELAY */
+      // the last segment's TDO is still going out from the buffer
+      while (UART1TXSent != UART1TXAvailable) {
+      }
+      bp_buffer_arena_release(tdo);
+      bp_buffer_arena_release(UART1RXBuf);
 
-          /* Clear TCK. */
-          OOCD_CLK = LOW;
+#else
 
-          /* Output TMS and TDI. */
-          OOCD_TDI = (tdi_data_out & 0x0001) ? HIGH : LOW;
-          tdi_data_out >>= 1;
-          OOCD_TMS = (tms_data_out & 0x0001) ? HIGH : LOW;
-          tms_data_out >>= 1;
+      /* TDI/TMS pairs are staged one CDC packet at a time, shifted by
+         binOpenOCDTapShiftBlock, and TDO goes back a full packet at a time. */
+      /* A zero length shift still reads one TDI/TMS pair below. */
+      size_t bytes_left = (j > 0) ? 2 * ((j >> 3) + ((j & 7) ? 1 : 0)) : 2;
+      size_t output_length = 0;
+      unsigned int delay;
 
 #ifdef BP_JTAG_OPENOCD_DELAY
-          __asm volatile("\t repeat %0 \n"
-                         "\t nop       \n"
-                         :
-                         : "r"(openocd_jtag_delay));
+      delay = openocd_jtag_delay;
+#else
+      delay = 0;
 #endif /* BP_JTAG_OPENOCD_DELAY */
 
-          /* Set TCK. */
-          OOCD_CLK = HIGH;
-
-          /* Sample TDO. */
-          tdo_data_in = (OOCD_TDO << 15) | (tdo_data_in >> 1);
+      do {
+        size_t wanted = min(bytes_left, OOCD_TAP_BLOCK_SIZE);
+        size_t staged;
+        size_t available;
+        unsigned int bits;
+
+        for (staged = 0; staged < wanted; staged += available) {
+          const uint8_t *input =
+              user_serial_borrow_input(wanted - staged, &available);
+          memcpy(&tap_input[staged], input, available);
+        }
+        bytes_left -= wanted;
+
+        bits = min(j, wanted * 4);
+        if (bits > 0) {
+          if (openocd_jtag_adaptive) {
+            binOpenOCDTapShiftAdaptive(tap_input, &tap_output[output_length],
+                                       bits);
+          } else {
+            binOpenOCDTapShiftBlock(tap_input, &tap_output[output_length], bits,
+                                    delay);
+          }
+          output_length += (bits + 7) / 8;
+          j -= bits;
+        } else {
+          tap_output[output_length++] = 0x00;
         }
 
-        /* Report TDO. */
-
-        tdo_data_in >>= 15 - (bits_to_process - 1);
-        user_serial_transmit_character(tdo_data_in & 0xFF);
-        if (bits_to_process > 8) {
-          user_serial_transmit_character((tdo_data_in >> 8) & 0xFF);
+        if ((output_length == OOCD_TAP_BLOCK_SIZE) || (bytes_left == 0)) {
+          binOpenOCDAnswer(tap_output, output_length);
+          output_length = 0;
         }
+      } while (bytes_left > 0);
 
-        bit_sequences -= 16;
-      } while (bit_sequences > 0);
+      bp_buffer_arena_release(tap_input);
 
 #endif /* BUSPIRATEV4 */
 
@@ -353,12 +468,113 @@ static void binOpenOCDPinMode(unsigned char mode) {
 }
 
 static void binOpenOCDAnswer(unsigned char *buf, unsigned int len) {
-  unsigned int i;
-  for (i = 0; i < len; i++) {
-    user_serial_transmit_character(buf[i]);
+  user_serial_write_buffer(buf, len);
+}
+
+/*
+ * A TAP shift that could not get its buffers drops the TDI/TMS pairs the host
+ * already sent and answers with the unknown command code, the caller then
+ * leaves OpenOCD mode.
+ */
+static void binOpenOCDTapShiftFailed(unsigned char *buf, unsigned int bytes) {
+  for (; bytes > 0; bytes--) {
+    user_serial_read_byte();
   }
+
+  buf[0] = 0x00;
+  binOpenOCDAnswer(buf, 1);
 }
 
+/*
+ * CMD_JTAG_CLOCK takes an index in OPENOCD_JTAG_CLOCK_DELAYS (or
+ * OOCD_JTAG_CLOCK_ADAPTIVE, v4 only) and answers with the command, the index,
+ * and the resulting TCK frequency in Hz (4 bytes, MSB first, 0 for adaptive
+ * clocking).  An index out of range gets the unknown command answer.
+ */
+static void binOpenOCDSelectClock(unsigned char *buf, unsigned char index) {
+  uint32_t frequency = 0;
+  unsigned int delay;
+
+#ifdef BUSPIRATEV4
+  if (index == OOCD_JTAG_CLOCK_ADAPTIVE) {
+    OOCD_RTCK_TRIS = INPUT;
+    openocd_jtag_adaptive = true;
+  } else
+#endif /* BUSPIRATEV4 */
+  if (index < OOCD_JTAG_CLOCKS) {
+    openocd_jtag_delay = OPENOCD_JTAG_CLOCK_DELAYS[index];
+#ifdef BUSPIRATEV4
+    openocd_jtag_adaptive = false;
+#ifndef BP_JTAG_OPENOCD_DELAY
+    /* The delay is not applied at all in this configuration. */
+    delay = 0;
+#else
+    delay = openocd_jtag_delay;
+#endif /* !BP_JTAG_OPENOCD_DELAY */
+#else
+    delay = openocd_jtag_delay;
+#endif /* BUSPIRATEV4 */
+    frequency = FCY / ((2UL * delay) + OOCD_TCK_CYCLES_PER_BIT);
+  } else {
+    buf[0] = 0x00; // unknown command
+    binOpenOCDAnswer(buf, 1);
+    return;
+  }
+
+  buf[0] = CMD_JTAG_CLOCK;
+  buf[1] = index;
+  buf[2] = (unsigned char)(frequency >> 24);
+  buf[3] = (unsigned char)(frequency >> 16);
+  buf[4] = (unsigned char)(frequency >> 8);
+  buf[5] = (unsigned char)frequency;
+  binOpenOCDAnswer(buf, 6);
+}
+
+#ifdef BUSPIRATEV4
+
+/*
+ * Same buffer layout and edge order as binOpenOCDTapShiftBlock, but every TCK
+ * edge waits for the target to echo it on RTCK.
+ */
+static void binOpenOCDTapShiftAdaptive(const uint8_t *in_buf, uint8_t *out_buf,
+                                       unsigned int bits) {
+  unsigned int bit;
+  uint8_t tdo = 0;
+
+  for (bit = 0; bit < bits; bit++) {
+    const uint8_t *pair = &in_buf[(bit / 8) * 2];
+    uint8_t shift = bit % 8;
+
+    /* Clear TCK. */
+    OOCD_CLK = LOW;
+    binOpenOCDWaitRtck(LOW);
+
+    /* Output TMS and TDI. */
+    OOCD_TDI = (pair[0] >> shift) & 1;
+    OOCD_TMS = (pair[1] >> shift) & 1;
+
+    /* Set TCK. */
+    OOCD_CLK = HIGH;
+    binOpenOCDWaitRtck(HIGH);
+
+    /* Sample TDO. */
+    tdo |= OOCD_TDO << shift;
+    if ((shift == 7) || (bit == bits - 1)) {
+      out_buf[bit / 8] = tdo;
+      tdo = 0;
+    }
+  }
+}
+
+static void binOpenOCDWaitRtck(const bool level) {
+  uint16_t timeout = OOCD_RTCK_TIMEOUT;
+
+  while ((OOCD_RTCK != level) && (--timeout > 0)) {
+  }
+}
+
+#endif /* BUSPIRATEV4 */
+
 static void binOpenOCDHandleFeature(unsigned char feat, unsigned char action) {
   switch (feat) {
   case FEATURE_LED:
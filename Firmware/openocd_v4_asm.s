@@ -0,0 +1,175 @@
+;
+; openocd_v4_asm.s
+;
+; Optimized TAP shift loop for the OpenOCD mode on Bus Pirate v4
+;
+; Written and maintained by the Bus Pirate project, after the Bus Pirate v3
+; version in openocd_asm.s by Sylvain Munaut <tnt@246tNt.com>.
+;
+; Published in the public domain.
+; For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+;
+
+.ifdef __PIC24FJ64GA002__
+	.error "This is only for Bus Pirate v4"
+.endif ; __PIC24FJ64GA002__
+
+.ifdef __PIC24FJ256GB106__
+	.equ __24FJ256GB106, 1
+	.include "p24FJ256GB106.inc"
+.endif ; __PIC24FJ256GB106__
+
+;
+; Hardware configuration
+;
+
+;  Bus pirate v4 hardware
+.equ IOPOR, PORTD
+.equ IOLAT, LATD
+
+.equ BP_MOSI_BIT, #0x0001	; RD1
+.equ BP_CLK_BIT, #0x0002	; RD2
+.equ BP_MISO_BIT, #0x0003	; RD3
+.equ BP_CS_BIT, #0x0004		; RD4
+
+;  Pin usage by OpenOCD
+.equ OOCD_TDO_BIT, BP_MISO_BIT
+.equ OOCD_TMS_BIT, BP_CS_BIT
+.equ OOCD_CLK_BIT, BP_CLK_BIT
+.equ OOCD_TDI_BIT, BP_MOSI_BIT
+
+;
+; void binOpenOCDTapShiftBlock(const void *in_buf, void *out_buf,
+;                              unsigned int bits, unsigned int delay)
+;
+; Same shift loop as binOpenOCDTapShiftFast, over a block that is already in
+; memory: the caller moves the TDI/TMS pairs in and the TDO bytes out.
+;
+; Parameters:
+;  w0 : input buffer, word aligned, TDI/TMS byte pairs (4 bytes per 16 bits,
+;       read in full even for a partial last group)
+;  w1 : output buffer, word aligned, TDO bytes (2 bytes per 16 bits, written
+;       in full even for a partial last group)
+;  w2 : # of bits, must not be 0
+;  w3 : delay
+;
+; Register usage:
+;
+;  w0  : #bits processed in the inner loop (-1)
+;  w1  : bit loop counter in the inner loop
+;  w2  : TDI data out
+;  w3  : TMS data out
+;  w4  : TDO data in
+;
+;  w5  : constant IOPOR
+;  w6  : #bits_left - 1
+;  w7  : src ptr
+;  w8  : dst ptr
+;
+;  w9 :  constant IOLAT
+;  w10 : constant OOCD_TDI_BIT
+;  w11 : constant OOCD_TMS_BIT
+;  w12 : delay loop
+;
+
+	.text
+	.global _binOpenOCDTapShiftBlock
+
+_binOpenOCDTapShiftBlock:
+
+		; Save registers
+		push.d	w8			; save w8,w9
+		push.d	w10			; save w10,w11
+		push.w	w12			; save 12
+
+		; Save parameters
+		dec.w	w2, w6			; w6 = w2 - 1;
+		mov.w	w0, w7			; w7  = w0;
+		mov.w	w1, w8			; w8  = w1;
+		mov.w	w3, w12			; w12 = w3;
+
+		; Constants
+		mov.w	#IOPOR, w5		; w5 = IOPOR;
+		mov.w	#IOLAT, w9		; w9 = IOLAT;
+		mov.w	#OOCD_TDI_BIT, w10	; w10 = OOCD_TDI_BIT;
+		mov.w	#OOCD_TMS_BIT, w11	; w11 = OOCD_TMS_BIT;
+
+		; Outer (word) loop
+__loop_word:					; do {
+
+		;   Fetch and organize 2x16 bits
+		mov.w	[w7++], w2		;   w2 = *((uint16_t*)w7++);
+		mov.w	[w7++], w3		;   w3 = *((uint16_t*)w7++);
+
+			; If memory had bytes 0xAA 0xBB 0xCC 0xDD,
+			; we now have:
+			;   w2 = 0xBBAA;
+			;   w3 = 0xDDCC;
+			;
+			; and we want:
+			;   w2 = 0xCCAA;	/* TDI bits (lsb out first) */
+			;   w3 = 0xDDBB;	/* TMS bits (lsb out first) */
+		swap.w	w2			;   w2 = swap_bytes(w2);
+		xor.w	w2, w3, w4		;   w4 = w2 ^ w3;
+		and.w	#0xff, w4		;   w4 &= 0xff;
+		xor.w	w2, w4, w2		;   w2 = w2 ^ w4;
+		xor.w	w3, w4, w3		;   w3 = w3 ^ w4;
+		swap.w	w2			;   w2 = swap_bytes(w2);
+
+		;   Compute how much bits to process
+		mov.w	#15, w0			;   w0 = min(15, w6)
+		cpsgt.w	w6, w0
+		mov.w	w6, w0
+
+		;   Inner (bit) loop
+		mov	w0, w1			;   w1 = w0;
+__loop_bit:					;   do {
+
+		;     Delay loop
+		repeat	w12
+		nop
+
+		;     Clear TCK
+		bclr.w	[w9], #OOCD_CLK_BIT
+
+		;     Output TMS & TDI
+		rrc.w	w2, w2
+		bsw.c	[w9], w10
+		rrc.w	w3, w3
+		bsw.c	[w9], w11
+
+		;     Delay loop
+		repeat	w12
+		nop
+
+		;     Set TCK
+		bset.w	[w9], #OOCD_CLK_BIT
+
+		;     Sample TDO
+		btst.c	[w5], #OOCD_TDO_BIT
+		rrc.w	w4, w4
+
+		;     Inner (bit) loop branch condition
+		dec.w	w1, w1			;   } while (--w1 >= 0);
+		bra	c, __loop_bit
+
+		;   Fix & Store the result
+		subr	w0, #15, w1		;   w1 = 15 - w0;
+		lsr	w4, w1, w4		;   w4 >>= w1;
+
+		mov.w	w4, [w8++]		;   *((uint16_t*)w8++) = w4;
+
+		;   Outer (word) loop branch condition
+		sub.w	w6, #16, w6		;   w6 -= 16;
+		bra	c, __loop_word		; } while (w6>=0);
+
+		; Restore registers
+		pop.w	w12			; restore w12
+		pop.d	w10			; restore w10,w11
+		pop.d	w8			; restore w8,w9
+
+		return
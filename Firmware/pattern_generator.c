@@ -0,0 +1,147 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "pattern_generator.h"
+
+#include "base.h"
+
+/**
+ * All the port bits the pattern generator drives.
+ */
+#define PATTERN_OUTPUTS (AUX | MOSI | CLK | MISO | CS)
+
+/**
+ * Priority of the timer #3 interrupt, above the host link so steps are not
+ * delayed by USB or UART servicing.
+ */
+#define PATTERN_INTERRUPT_PRIORITY 5
+
+/**
+ * Playback state, shared with the timer #3 interrupt handler.
+ */
+static struct {
+  /** Pin states being played. */
+  const uint8_t *pattern;
+
+  /** Where sampled pin states go, NULL once the first pass is over. */
+  uint8_t *volatile capture;
+
+  /** How many pin states the pattern holds. */
+  size_t length;
+
+  /** Pin state going out next. */
+  size_t index;
+
+  /** Passes left, unless playing forever. */
+  uint16_t repeats_left;
+
+  /** Whether to play until told to stop. */
+  bool forever;
+
+  /** Set by the interrupt handler once the last pass is over. */
+  volatile bool done;
+
+  /** Port bits for each of the 32 possible pin state values. */
+  uint16_t port_values[32];
+} pattern_state;
+
+void pattern_generator_run(const uint8_t *pattern, uint8_t *capture,
+                           const size_t length, const uint16_t period,
+                           const uint16_t repeats) {
+  uint8_t index;
+
+  for (index = 0; index < 32; index++) {
+    pattern_state.port_values[index] = ((index & 0b00010000) ? AUX : 0) |
+                                       ((index & 0b00001000) ? MOSI : 0) |
+                                       ((index & 0b00000100) ? CLK : 0) |
+                                       ((index & 0b00000010) ? MISO : 0) |
+                                       ((index & 0b00000001) ? CS : 0);
+  }
+
+  pattern_state.pattern = pattern;
+  pattern_state.capture = capture;
+  pattern_state.length = length;
+  pattern_state.index = 0;
+  pattern_state.repeats_left = repeats;
+  pattern_state.forever = (repeats == PATTERN_GENERATOR_FOREVER);
+  pattern_state.done = false;
+
+  /*
+   * T3CON - TIMER 3 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------00---0-
+   * | |      ||   |
+   * | |      ||   +---- TCS:   Internal clock (Fosc/2).
+   * | |      ++-------- TCKPS: 1:1 Prescaler.
+   * | +---------------- TSIDL: Continue module operation in idle mode.
+   * +------------------ TON:   Timer OFF.
+   */
+  T3CON = 0x0000;
+  TMR3 = 0;
+  PR3 = period - 1;
+
+  IFS0bits.T3IF = OFF;
+  IPC2bits.T3IP = PATTERN_INTERRUPT_PRIORITY;
+  IEC0bits.T3IE = ON;
+  T3CONbits.TON = ON;
+
+  while (!pattern_state.done) {
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      break;
+    }
+  }
+
+  T3CON = 0x0000;
+  IEC0bits.T3IE = OFF;
+  IFS0bits.T3IF = OFF;
+  IPC2bits.T3IP = 0;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T3Interrupt(void) {
+  uint16_t port;
+
+  IFS0bits.T3IF = OFF;
+
+  if (pattern_state.capture != NULL) {
+    port = IOPOR;
+    pattern_state.capture[pattern_state.index] =
+        ((port & AUX) ? 0b00010000 : 0) | ((port & MOSI) ? 0b00001000 : 0) |
+        ((port & CLK) ? 0b00000100 : 0) | ((port & MISO) ? 0b00000010 : 0) |
+        ((port & CS) ? 0b00000001 : 0);
+  }
+
+  if (pattern_state.pattern != NULL) {
+    IOLAT = (IOLAT & ~PATTERN_OUTPUTS) |
+            pattern_state
+                .port_values[pattern_state.pattern[pattern_state.index] & 0x1F];
+  }
+
+  if (++pattern_state.index < pattern_state.length) {
+    return;
+  }
+
+  /* End of a pass. */
+  pattern_state.index = 0;
+  pattern_state.capture = NULL;
+  if (!pattern_state.forever && (--pattern_state.repeats_left == 0)) {
+    T3CONbits.TON = OFF;
+    IEC0bits.T3IE = OFF;
+    pattern_state.done = true;
+  }
+}
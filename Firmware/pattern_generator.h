@@ -0,0 +1,60 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef BP_PATTERN_GENERATOR_H
+#define BP_PATTERN_GENERATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Shortest step period accepted by pattern_generator_run(), in FCY cycles
+ * (4us), leaving the CPU some time between timer interrupts.
+ */
+#define PATTERN_GENERATOR_MINIMUM_PERIOD 64
+
+/**
+ * Repeat count value that plays the pattern until a byte is received.
+ */
+#define PATTERN_GENERATOR_FOREVER 0
+
+/**
+ * Plays a buffer of pin states onto the IO pins from a timer interrupt.
+ *
+ * Each pattern byte uses the binary I/O pin state layout (AUX, MOSI, CLK,
+ * MISO and CS in bits 4 to 0); only the output latches are written, so pins
+ * set as inputs are left alone and can be captured instead.  When capturing,
+ * the pins are sampled right before each new state goes out, during the
+ * first pass only.  Any byte received from the host stops the playback early.
+ * Without a pattern the pins are only sampled, at the same pace.
+ *
+ * @param[in] pattern the pin states to play, or NULL to leave the output
+ * latches alone.
+ * @param[out] capture where to store the sampled pin states, or NULL not to
+ * capture anything.  Must hold length bytes.
+ * @param[in] length how many pin states the pattern holds, at least 1.
+ * @param[in] period time between pin states, in FCY cycles, no shorter than
+ * PATTERN_GENERATOR_MINIMUM_PERIOD.
+ * @param[in] repeats how many times to play the pattern, or
+ * PATTERN_GENERATOR_FOREVER.
+ */
+void pattern_generator_run(const uint8_t *pattern, uint8_t *capture,
+                           const size_t length, const uint16_t period,
+                           const uint16_t repeats);
+
+#endif /* BP_PATTERN_GENERATOR_H */
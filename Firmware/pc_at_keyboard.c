@@ -33,6 +33,30 @@
 #define KEYBOARD_WRITE_SUCCESS false
 #define KEYBOARD_WRITE_TIMEOUT true
 
+/**
+ * How many received scancodes are held until read, must be a power of two.
+ *
+ * Keyboards send at most a few bytes per key, this covers a burst of typing
+ * while the firmware is busy printing.
+ */
+#define KEYBOARD_FIFO_SIZE 32
+
+/**
+ * Mask to wrap indices into the scancode FIFO.
+ */
+#define KEYBOARD_FIFO_MASK (KEYBOARD_FIFO_SIZE - 1)
+
+/**
+ * Bits in a frame: start bit, eight data bits LSB first, odd parity and stop
+ * bit.
+ */
+#define KEYBOARD_FRAME_BITS 11
+
+/**
+ * How many times a read looks for a scancode, 5us apart, before giving up.
+ */
+#define KEYBOARD_READ_POLLS 255
+
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
 
@@ -62,10 +86,49 @@ typedef enum {
   KEYBOARD_SCANCODE_READ_NO_DATA = 0xFF
 } keyboard_scancode_read_result_t;
 
+/**
+ * Scancode receiver state, shared with the change notification interrupt.
+ */
+static struct {
+  /** Received scancodes, with their keyboard_scancode_read_result_t above. */
+  volatile uint16_t fifo[KEYBOARD_FIFO_SIZE];
+
+  /** Where the interrupt handler stores the next scancode. */
+  volatile uint8_t head;
+
+  /** Next scancode to read. */
+  volatile uint8_t tail;
+
+  /** Frame bits received so far, the first one in bit 0. */
+  volatile uint16_t frame;
+
+  /** How many frame bits were received so far. */
+  volatile uint8_t bits;
+
+  /** Clock line level at the previous change. */
+  bool clock;
+} keyboard_receiver;
+
 static keyboard_read_result_t read_bit(void);
 static bool keyboard_wait_clock_change(const bool expected);
-static keyboard_scancode_read_result_t read_scancode(uint8_t *output);
 static keyboard_scancode_read_result_t read_byte(uint8_t *output);
+
+/**
+ * Releases the bus and starts receiving frames in the background.
+ */
+static void keyboard_receiver_start(void);
+
+/**
+ * Stops receiving frames in the background, once the bus has to be driven.
+ */
+static void keyboard_receiver_stop(void);
+
+/**
+ * Clocks frame bits in on the clock falling edges, and queues each complete
+ * frame.  Called from the change notification interrupt.
+ */
+static void keyboard_change_notification(void);
+
 static keyboard_write_byte_result_t write_byte(const uint8_t value);
 static bool write_bit(const bool value);
 static void handle_scancode(const keyboard_scancode_read_result_t result);
@@ -73,10 +136,18 @@ static void handle_scancode(const keyboard_scancode_read_result_t result);
 void pc_at_keyboard_prepare(void) { mode_configuration.high_impedance = ON; }
 
 void pc_at_keyboard_execute(void) {
-  KBDIO_TRIS = INPUT;
-  KBCLK_TRIS = OUTPUT;
   KBCLK = LOW;
   KBDIO = LOW;
+  keyboard_receiver.head = 0;
+  keyboard_receiver.tail = 0;
+  keyboard_receiver_start();
+}
+
+void pc_at_keyboard_cleanup(void) {
+  keyboard_receiver_stop();
+  KBCLK_TRIS = INPUT;
+  mode_configuration.numbits = 8;
+  mode_configuration.int16 = NO;
 }
 
 uint16_t pc_at_keyboard_read(void) {
@@ -86,7 +157,14 @@ uint16_t pc_at_keyboard_read(void) {
 }
 
 uint16_t pc_at_keyboard_send(const uint16_t value) {
-  switch (write_byte(value)) {
+  keyboard_write_byte_result_t result;
+
+  /* The keyboard answer comes in through the receiver afterwards. */
+  keyboard_receiver_stop();
+  result = write_byte(value);
+  keyboard_receiver_start();
+
+  switch (result) {
   case 0:
     MSG_ACK;
     break;
@@ -181,81 +259,111 @@ keyboard_read_result_t read_bit(void) {
   return result;
 }
 
-keyboard_scancode_read_result_t read_scancode(uint8_t *output) {
-  uint8_t scancode = 0;
-  uint8_t parity = 0;
-  uint8_t bit_index;
-  keyboard_read_result_t read;
-
-  if (KBDIO != LOW) {
-    return KEYBOARD_SCANCODE_READ_START_BIT_ERROR;
-  }
+void keyboard_receiver_start(void) {
+  KBDIO_TRIS = INPUT;
+  KBCLK_TRIS = INPUT;
+  keyboard_receiver.frame = 0;
+  keyboard_receiver.bits = 0;
+  keyboard_receiver.clock = KBCLK;
+
+  /* Frame bits are only 30us apart, stay ahead of the USB interrupt. */
+  bp_set_change_notification_handler(keyboard_change_notification);
+  BP_CLK_CN = ON;
+  IPC4bits.CNIP = 6;
+  IFS1bits.CNIF = OFF;
+  IEC1bits.CNIE = ON;
+}
 
-  if (keyboard_wait_clock_change(HIGH) == KEYBOARD_CLOCK_DID_NOT_CHANGE) {
-    return KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR;
-  }
+void keyboard_receiver_stop(void) {
+  IEC1bits.CNIE = OFF;
+  IPC4bits.CNIP = 0;
+  BP_CLK_CN = OFF;
+  IFS1bits.CNIF = OFF;
+  bp_set_change_notification_handler(NULL);
+}
 
-  for (bit_index = 0; bit_index < 8; bit_index++) {
-    scancode >>= 1;
-    switch (read_bit()) {
-    case KEYBOARD_READ_HIGH:
-      scancode |= 0b10000000;
-      parity ^= 1;
-      break;
+void keyboard_change_notification(void) {
+  bool clock = KBCLK;
+  bool data = KBDIO;
+  uint8_t scancode;
+  uint8_t parity;
+  uint8_t next;
+  keyboard_scancode_read_result_t result;
 
-    case KEYBOARD_READ_TIMEOUT:
-      return KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR;
+  if (clock == keyboard_receiver.clock) {
+    /* Some other pin changed. */
+    return;
+  }
+  keyboard_receiver.clock = clock;
 
-    default:
-      break;
-    }
+  /* The keyboard sets DATA up while the clock is high. */
+  if (clock != LOW) {
+    return;
   }
 
-  read = read_bit();
-  if (read == KEYBOARD_READ_TIMEOUT) {
-    return KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR;
+  if ((keyboard_receiver.bits == 0) && (data != LOW)) {
+    /* Not a start bit, wait for one. */
+    return;
   }
 
-  if ((uint8_t)read == parity) {
-    return KEYBOARD_SCANCODE_READ_PARITY_ERROR;
+  keyboard_receiver.frame |= (uint16_t)data << keyboard_receiver.bits;
+  if (++keyboard_receiver.bits < KEYBOARD_FRAME_BITS) {
+    return;
   }
 
-  read = read_bit();
-  if (read == KEYBOARD_READ_TIMEOUT) {
-    return KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR;
+  scancode = (keyboard_receiver.frame >> 1) & 0xFF;
+  parity = (keyboard_receiver.frame >> 9) & 0x01;
+  for (next = scancode; next != 0; next >>= 1) {
+    parity ^= next & 0x01;
   }
 
-  KBCLK_TRIS = OUTPUT;
-  if (read != KEYBOARD_READ_HIGH) {
-    return KEYBOARD_SCANCODE_READ_STOP_BIT_ERROR;
+  if (parity == 0) {
+    result = KEYBOARD_SCANCODE_READ_PARITY_ERROR;
+  } else if ((keyboard_receiver.frame & (1 << 10)) == 0) {
+    result = KEYBOARD_SCANCODE_READ_STOP_BIT_ERROR;
+  } else {
+    result = KEYBOARD_SCANCODE_READ_SUCCESS;
   }
+  keyboard_receiver.frame = 0;
+  keyboard_receiver.bits = 0;
 
-  *output = scancode;
-  return KEYBOARD_SCANCODE_READ_SUCCESS;
+  next = (keyboard_receiver.head + 1) & KEYBOARD_FIFO_MASK;
+  if (next == keyboard_receiver.tail) {
+    /* Nobody is reading, keep the oldest scancodes. */
+    return;
+  }
+  keyboard_receiver.fifo[keyboard_receiver.head] =
+      ((uint16_t)result << 8) | scancode;
+  keyboard_receiver.head = next;
 }
 
 keyboard_scancode_read_result_t read_byte(uint8_t *result) {
   uint8_t counter;
-  keyboard_scancode_read_result_t read = KEYBOARD_SCANCODE_READ_NO_DATA;
-
-  KBDIO_TRIS = INPUT;
-  KBCLK_TRIS = INPUT;
-
-  for (counter = 0; counter < 255; counter++) {
-    if (KBCLK == LOW) {
-      read = read_scancode(result);
-      if ((read == KEYBOARD_SCANCODE_READ_SUCCESS) ||
-          (read == KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR)) {
-        break;
-      }
+  uint8_t bits = keyboard_receiver.bits;
+  uint16_t entry;
+
+  for (counter = 0; counter < KEYBOARD_READ_POLLS; counter++) {
+    if (keyboard_receiver.tail != keyboard_receiver.head) {
+      entry = keyboard_receiver.fifo[keyboard_receiver.tail];
+      keyboard_receiver.tail =
+          (keyboard_receiver.tail + 1) & KEYBOARD_FIFO_MASK;
+      *result = entry & 0xFF;
+      return (keyboard_scancode_read_result_t)(entry >> 8);
     }
 
     bp_delay_us(5);
   }
 
-  KBCLK_TRIS = OUTPUT;
+  if ((bits != 0) && (bits == keyboard_receiver.bits)) {
+    /* A frame stalled half way, drop it and resynchronise. */
+    IEC1bits.CNIE = OFF;
+    keyboard_receiver.frame = 0;
+    keyboard_receiver.bits = 0;
+    IEC1bits.CNIE = ON;
+    return KEYBOARD_SCANCODE_READ_TIMEOUT_ERROR;
+  }
 
-  return read;
+  return KEYBOARD_SCANCODE_READ_NO_DATA;
 }
 
 bool write_bit(const bool value) {
@@ -327,9 +435,6 @@ keyboard_write_byte_result_t write_byte(const uint8_t value) {
     return KEYBOARD_WRITE_BYTE_TIMEOUT;
   }
 
-  KBCLK_TRIS = OUTPUT;
-  KBCLK = LOW;
-
   return (result == KEYBOARD_READ_LOW) ? KEYBOARD_WRITE_BYTE_ACK
                                        : KEYBOARD_WRITE_BYTE_NACK;
 }
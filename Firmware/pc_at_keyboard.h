@@ -26,6 +26,7 @@
 
 void pc_at_keyboard_prepare(void);
 void pc_at_keyboard_execute(void);
+void pc_at_keyboard_cleanup(void);
 uint16_t pc_at_keyboard_read(void);
 uint16_t pc_at_keyboard_send(const uint16_t value);
 void pc_at_keyboard_run_macro(const uint16_t macro);
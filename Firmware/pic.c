@@ -194,7 +194,7 @@ uint16_t read_bits(const uint8_t bits) {
   return data;
 }
 
-unsigned int pic_read(void) {
+uint16_t pic_read(void) {
   if (mode_info.mode == PIC_MODE_COMMAND) {
     MSG_PIC_NO_READ;
     return 0;
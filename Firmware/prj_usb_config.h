@@ -1,25 +1,52 @@
 #ifndef PRJ_USB_PROFILE_H
 #define PRJ_USB_PROFILE_H
 
+#include "configuration.h"
+
 
 
 #define CLOCK_FREQ 32000000
 #define BAUDCLOCK_FREQ 16000000 
 #define UART_BAUD_setup(x)  U1BRG = x 
 #define CDC_FLUSH_MS 4 // how many ms timeout before cdc in to host is sent
+#define CDC_COALESCE_FLUSH_MS 100 // same, when coalescing until the buffer is full
 
 #define USB_INTERRUPTS 1
+/* Kept below the bus mode interrupts, which must not be delayed by the stack.
+ * Timing critical loops raise the CPU priority to this level to mask it. */
+#define USB_INTERRUPT_PRIORITY 3
 
 #define USB_VID (0x4d8)
 #define USB_PID (0xFB00)  // BPv4
 #define USB_DEV 0x0002
 
 #define USB_NUM_CONFIGURATIONS          1u
-#define USB_NUM_INTERFACES              2u
-#define USB_NUM_ENDPOINTS               3u
 
+#ifdef BP_USB_VENDOR_INTERFACE
+/* CDC control, CDC data and the vendor bulk pipe on EP3. */
+#define USB_VENDOR_INTERFACES           1u
+#define USB_VENDOR_ENDPOINTS            2u
+#else
+#define USB_VENDOR_INTERFACES           0u
+#define USB_VENDOR_ENDPOINTS            0u
+#endif /* BP_USB_VENDOR_INTERFACE */
+
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+/* The streaming pipe on EP4 comes after any vendor interface. */
+#define USB_ISOCHRONOUS_INTERFACE       (2u + USB_VENDOR_INTERFACES)
+#define USB_NUM_INTERFACES              (3u + USB_VENDOR_INTERFACES)
+#define USB_NUM_ENDPOINTS               (4u + USB_VENDOR_ENDPOINTS)
+#define MAX_EPNUM_USED                  4u
+#else
+#define USB_NUM_INTERFACES              (2u + USB_VENDOR_INTERFACES)
+#define USB_NUM_ENDPOINTS               (3u + USB_VENDOR_ENDPOINTS)
+#define MAX_EPNUM_USED                  (2u + USB_VENDOR_INTERFACES)
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
 
-#define MAX_EPNUM_USED                  2u
+#if defined(BP_USB_VENDOR_INTERFACE) || defined(BP_USB_ISOCHRONOUS_STREAM)
+/* More than the CDC function, grouped by an interface association. */
+#define USB_COMPOSITE_DEVICE
+#endif
 
 #define USB_BUS_POWERED 1
 #define USB_INTERNAL_TRANSCIEVER 1
@@ -34,7 +61,7 @@
  * 2 - PingPong on all EP
  * 3 - PingPong on all except EP0
  */
-#define USB_PP_BUF_MODE 0
+#define USB_PP_BUF_MODE 3
 #define USB_EP0_BUFFER_SIZE 8u
 #define CDC_BUFFER_SIZE 64u
 #define CDC_NOTICE_BUFFER_SIZE 10u
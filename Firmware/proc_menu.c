@@ -25,6 +25,7 @@
 #include "basic.h"
 #include "binary_io.h"
 #include "core.h"
+#include "memory_usage.h"
 #include "proc_menu.h" //need our public versionInfo() function
 #include "selftest.h"
 #include "sump.h"
@@ -32,7 +33,7 @@
 extern bus_pirate_configuration_t bus_pirate_configuration;
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
-extern bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT];
+extern const bus_pirate_protocol_t enabled_protocols[ENABLED_PROTOCOLS_COUNT];
 
 #ifdef BUSPIRATEV4
 static bool __attribute__((address(0x47FA), persistent)) skip_pgc_pgd_check;
@@ -46,8 +47,149 @@ extern volatile BYTE cdc_Out_len;
 
 static const uint8_t READ_DISPLAY_BASE[] = {'x', 'd', 'b', 'w'};
 
+/**
+ * How many values a repeated read takes from the bus before formatting them.
+ */
+#define READ_BATCH_VALUES 16
+
+/**
+ * How many values go on each line in DUMP display mode.
+ */
+#define DUMP_VALUES_PER_LINE 16
+
+/**
+ * Longest text a single read value can turn into: the value itself, a `;16`
+ * bits count suffix and a separator.
+ */
+#define READ_VALUE_MAX_LENGTH (BP_FORMATTED_INTEGER_MAX_LENGTH + 4)
+
+/**
+ * Bus operations a terminal command line can be compiled into.
+ */
+typedef enum {
+  /** `[` - Start. */
+  OPERATION_START = 0,
+  /** `{` - Start with read. */
+  OPERATION_START_WITH_READ,
+  /** `]` - Stop. */
+  OPERATION_STOP,
+  /** `}` - Stop from read. */
+  OPERATION_STOP_FROM_READ,
+  /** A number - Write a value. */
+  OPERATION_WRITE,
+  /** `r` - Read a value. */
+  OPERATION_READ,
+  /** `/` - Clock line high. */
+  OPERATION_CLOCK_HIGH,
+  /** `\` - Clock line low. */
+  OPERATION_CLOCK_LOW,
+  /** `-` - Data line high. */
+  OPERATION_DATA_HIGH,
+  /** `_` - Data line low. */
+  OPERATION_DATA_LOW,
+  /** `.` - Data line state read. */
+  OPERATION_DATA_STATE,
+  /** `^` - Clock pulse. */
+  OPERATION_CLOCK_PULSE,
+  /** `!` - Bit read. */
+  OPERATION_READ_BIT,
+  /** `a` - AUX low. */
+  OPERATION_AUX_LOW,
+  /** `A` - AUX high. */
+  OPERATION_AUX_HIGH,
+  /** `@` - AUX read. */
+  OPERATION_AUX_READ,
+  /** `&` - Microseconds delay. */
+  OPERATION_DELAY_US,
+  /** `%` - Milliseconds delay. */
+  OPERATION_DELAY_MS
+} __attribute__((packed)) operation_type_t;
+
+/**
+ * A single compiled bus operation, with its modifiers already parsed.
+ */
+typedef struct {
+  /** What to do. */
+  operation_type_t type;
+
+  /** The `;` bits count modifier, or 0 if none was given. */
+  uint8_t numbits;
+
+  /** Display mode override plus one for reads, or 0 for the default one. */
+  uint8_t display;
+
+  /** The value to write, for OPERATION_WRITE. */
+  uint16_t value;
+
+  /** The `:` repeat modifier, 1 if none was given. */
+  uint16_t repeat;
+} compiled_operation_t;
+
+/**
+ * The current command line, compiled into bus operations.
+ */
+static struct {
+  /** Compiled operations, in execution order. */
+  compiled_operation_t operations[BP_COMPILED_COMMAND_MAX_OPERATIONS];
+
+  /** How many operations are in use. */
+  size_t count;
+} compiled_command;
+
 static uint8_t change_read_display(void);
 
+/**
+ * Parses the bus operation starting at the current command buffer position.
+ *
+ * The command buffer position is left on the last character belonging to the
+ * operation, like the other parsing helpers do.
+ *
+ * @param[out] operation the operation to fill.
+ *
+ * @return true if a bus operation was parsed, false if the character is not a
+ *         bus operation or its modifiers are malformed.
+ */
+static bool compile_operation(compiled_operation_t *operation);
+
+/**
+ * Runs a compiled bus operation.
+ *
+ * @param[in] operation the operation to run.
+ */
+static void execute_operation(const compiled_operation_t *operation);
+
+/**
+ * Compiles the whole command line into compiled_command.
+ *
+ * @return true if the line only holds bus operations and they all fit,
+ *         false if the line has to be interpreted instead.  The command
+ *         buffer position is left untouched in that case.
+ */
+static bool compile_command_line(void);
+
+/**
+ * Reads the given number of values from the bus and prints them.
+ *
+ * Values are read in batches of READ_BATCH_VALUES and only formatted and sent
+ * out once the whole batch is in, so the bus is not held up by the output of
+ * each single value.
+ *
+ * @param[in] count how many values to read.
+ */
+static void read_values(uint16_t count);
+
+/**
+ * Writes the same byte to the bus the given number of times and prints it.
+ *
+ * Bytes go out in batches of READ_BATCH_VALUES through the protocol's
+ * transfer_buffer callback, which must be available; the text printed is the
+ * same a byte-by-byte write would produce.
+ *
+ * @param[in] value the byte to write.
+ * @param[in] count how many times to write it.
+ */
+static void write_values(const uint8_t value, uint16_t count);
+
 static void set_display_mode(void);
 static void set_baud_rate(void);
 static void print_status_info(void);
@@ -101,21 +243,97 @@ unsigned int cmdstart;
 static char user_macros[BP_USER_MACROS_COUNT][BP_USER_MACRO_MAX_LENGTH];
 static int user_macro;
 
+/**
+ * Where the last command lines start in cmdbuf, oldest first.
+ *
+ * Lines follow each other in cmdbuf, so new lines overwrite the oldest ones
+ * first; any that got overwritten are dropped from the front when a new line
+ * is stored or when the history is looked at.
+ */
+static struct {
+  /** Line start offsets, as a ring. */
+  uint16_t starts[BP_COMMAND_HISTORY_LENGTH];
+
+  /** Ring index of the oldest line. */
+  uint8_t oldest;
+
+  /** How many lines are stored. */
+  uint8_t count;
+} command_history;
+
+/**
+ * Drops the history lines that start in the given cmdbuf range.
+ *
+ * @param[in] start the first offset that got written to.
+ * @param[in] end one past the last offset that got written to.
+ */
+static void forget_overwritten_history(const uint16_t start,
+                                       const uint16_t end);
+
+/**
+ * Stores a new command line in the history.
+ *
+ * @param[in] start where the line starts in cmdbuf.
+ * @param[in] end one past the line NUL terminator.
+ */
+static void add_history_entry(const uint16_t start, const uint16_t end);
+
+/**
+ * Gets where a history line starts in cmdbuf.
+ *
+ * @param[in] back how many lines to go back, 1 being the newest line.
+ *
+ * @return the offset in cmdbuf of the line.
+ */
+static uint16_t history_entry(const uint8_t back);
+
+/**
+ * Replaces the command line being edited with a line from the history.
+ *
+ * @param[in] start where the history line starts in cmdbuf.
+ */
+static void recall_history_entry(const uint16_t start);
+
+/**
+ * Clears the current terminal line and prints the command prompt again.
+ */
+static void redraw_prompt(void);
+
+/**
+ * How many pasted characters are echoed back at once.
+ */
+#define SCRIPT_ECHO_CHUNK_SIZE 32
+
+/**
+ * Appends a run of printable characters already waiting on the serial port to
+ * the end of the command line, echoing them back in chunks.
+ *
+ * This is the terminal script mode: when lines come in faster than anybody
+ * could type, such as with a pasted or piped script, plain characters skip
+ * the line editor so the terminal keeps up with the incoming lines queued
+ * while the previous one was running.
+ *
+ * @param[in] character the character that was just read.
+ *
+ * @return the first character read that was not appended, or -1 if no more
+ * input is waiting.
+ */
+static int append_script_characters(unsigned char character);
+
 void serviceuser(void) {
   int cmd, stop;
   int newstart;
   int oldstart;
-  unsigned int sendw, received;
+  unsigned int sendw;
   int repeat;
   unsigned char c;
   int temp;
-  int temp2;
   int binmodecnt;
-  int numbits;
-  unsigned int tmpcmdend, histcnt, tmphistcnt;
-  unsigned char oldDmode; // temporarily holds the default display mode, while a
-                          // different display read is performed
-  unsigned char newDmode;
+  int binmagic;
+  unsigned int tmpcmdend, histcnt;
+  bool after_carriage_return;
+  compiled_operation_t operation;
+  size_t index;
 
   // init
   cmd = 0;
@@ -123,20 +341,16 @@ void serviceuser(void) {
   cmdend = 0;
   tmpcmdend = cmdend;
   histcnt = 0;
-  tmphistcnt = 0;
   bus_pirate_configuration.bus_mode = BP_HIZ;
-  temp2 = 0;
   mode_configuration.command_error = NO;
   binmodecnt = 0;
+  binmagic = -1;
+  after_carriage_return = NO;
 
   stop = 0;
   newstart = 0;
   oldstart = 0;
 
-  oldDmode = 0; // temporarily holds the default display mode, while a different
-                // display read is performed
-  newDmode = 0;
-
   memset(user_macros, 0, sizeof(user_macros));
   user_macro = 0;
 
@@ -166,6 +380,15 @@ void serviceuser(void) {
       while (!user_serial_ready_to_read()) // as long as there is no user input
                                            // poll periodicservice
       {
+        bp_yield();
+#ifdef BP_USB_VENDOR_INTERFACE
+        /* Anything sent on the vendor pipe starts binary mode there. */
+        if (user_serial_vendor_pipe_pending()) {
+          user_serial_select_vendor_pipe(YES);
+          enter_binary_bitbang_mode(NO);
+          user_serial_select_vendor_pipe(NO);
+        }
+#endif /* BP_USB_VENDOR_INTERFACE */
         if (mode_configuration.periodicService == 1) {
           if (enabled_protocols[bus_pirate_configuration.bus_mode]
                   .periodic_update()) // did we print something?
@@ -191,6 +414,39 @@ void serviceuser(void) {
         c = user_serial_read_byte(); // no error, process byte
       }
 
+      /* Rest of the binary mode magic sequence, see BP_BINARY_IO_MAGIC. */
+      if ((binmagic >= 0) && (c == (uint8_t)BP_BINARY_IO_MAGIC[binmagic])) {
+        binmagic++;
+        if (BP_BINARY_IO_MAGIC[binmagic] != '\0') {
+          continue;
+        }
+        binmagic = -1;
+        binmodecnt = 0;
+        enter_binary_bitbang_mode(YES);
+#ifdef BUSPIRATEV4
+        goto bpv4reset;
+#else
+        continue;
+#endif /* BUSPIRATEV4 */
+      }
+      binmagic = -1;
+
+      /* CR+LF line endings, as pasted scripts have, end a single line. */
+      if (after_carriage_return && (c == 0x0A)) {
+        after_carriage_return = NO;
+        continue;
+      }
+
+      if ((cmdend == tmpcmdend) && user_serial_ready_to_read()) {
+        temp = append_script_characters(c);
+        tmpcmdend = cmdend; // resync
+        if (temp < 0) {
+          continue;
+        }
+        c = temp;
+      }
+      after_carriage_return = (c == 0x0D);
+
       switch (c) {
       case 0x08:                   // backspace(^H)
         if (tmpcmdend != cmdstart) // not at begining?
@@ -306,124 +562,37 @@ void serviceuser(void) {
         }
         break;
       up:
-      case 0x10:        // ^P (up arrow)
-        tmphistcnt = 0; // reset counter
-        for (temp = (cmdstart - 1) & CMDLENMSK; temp != cmdend;
-             temp = (temp - 1) & CMDLENMSK) {
-          if (!cmdbuf[temp] &&
-              cmdbuf[(temp - 1) &
-                     CMDLENMSK]) { // found previous entry, temp is old cmdend
-            tmphistcnt++;
-            if (tmphistcnt > histcnt) {
-              histcnt++;
-              if (cmdstart != cmdend) { // clear partially entered cmd line
-                while (cmdend != cmdstart) {
-                  cmdbuf[cmdend] = 0x00;
-                  cmdend = (cmdend - 1) & CMDLENMSK;
-                }
-                cmdbuf[cmdend] = 0x00;
-              }
-              repeat = (temp - 1) & CMDLENMSK;
-              while (repeat != cmdend) {
-                if (!cmdbuf[repeat]) {
-                  temp2 = (repeat + 1) & CMDLENMSK;
-                  /* start of old cmd */
-                  break;
-                }
-                repeat = (repeat - 1) & CMDLENMSK;
-              }
-              bp_write_string("\x1B[2K\x0D"); // clear line, CR
-              bp_write_string(
-                  enabled_protocols[bus_pirate_configuration.bus_mode].name);
-#ifdef BP_ENABLE_BASIC_SUPPORT
-              if (bus_pirate_configuration.basic) {
-                BPMSG1084;
-              }
-#endif /* BP_ENABLE_BASIC_SUPPORT */
-              bp_write_string(">");
-              for (repeat = temp2; repeat != temp;
-                   repeat = (repeat + 1) & CMDLENMSK) {
-                user_serial_transmit_character(cmdbuf[repeat]);
-                cmdbuf[cmdend] = cmdbuf[repeat];
-                cmdend = (cmdend + 1) & CMDLENMSK;
-              }
-              cmdbuf[cmdend] = 0x00;
-              tmpcmdend = cmdend; // resync
-              break;
-            }
-          }
-        }
-        if (temp == cmdend)
+      case 0x10: // ^P (up arrow)
+        forget_overwritten_history(cmdstart, (cmdend + 1) & CMDLENMSK);
+        if (histcnt < command_history.count) {
+          histcnt++;
+          recall_history_entry(history_entry(histcnt));
+          tmpcmdend = cmdend; // resync
+        } else {
           user_serial_transmit_character(BELL); // beep, top
+        }
         break;
       down:
-      case 0x0E:        // ^N (down arrow)
-        tmphistcnt = 0; // reset counter
-        for (temp = (cmdstart - 1) & CMDLENMSK; temp != cmdend;
-             temp = (temp - 1) & CMDLENMSK) {
-          if (!cmdbuf[temp] &&
-              cmdbuf[(temp - 1) &
-                     CMDLENMSK]) { // found previous entry, temp is old cmdend
-            tmphistcnt++;
-            if (tmphistcnt == (histcnt - 1)) {
-              histcnt--;
-              if (cmdstart != cmdend) { // clear partially entered cmd line
-                while (cmdend != cmdstart) {
-                  cmdbuf[cmdend] = 0x00;
-                  cmdend = (cmdend - 1) & CMDLENMSK;
-                }
-                cmdbuf[cmdend] = 0x00;
-              }
-              repeat = (temp - 1) & CMDLENMSK;
-              while (repeat != cmdend) {
-                if (!cmdbuf[repeat]) {
-                  temp2 = (repeat + 1) & CMDLENMSK;
-                  /* start of old cmd */
-                  break;
-                }
-                repeat = (repeat - 1) & CMDLENMSK;
-              }
-              bp_write_string("\x1B[2K\x0D"); // clear line, CR
-              bp_write_string(
-                  enabled_protocols[bus_pirate_configuration.bus_mode].name);
-#ifdef BP_ENABLE_BASIC_SUPPORT
-              if (bus_pirate_configuration.basic) {
-                BPMSG1084;
-              }
-#endif /* BP_ENABLE_BASIC_SUPPORT */
-              bp_write_string(">");
-              for (repeat = temp2; repeat != temp;
-                   repeat = (repeat + 1) & CMDLENMSK) {
-                user_serial_transmit_character(cmdbuf[repeat]);
-                cmdbuf[cmdend] = cmdbuf[repeat];
-                cmdend = (cmdend + 1) & CMDLENMSK;
-              }
-              cmdbuf[cmdend] = 0x00;
-              tmpcmdend = cmdend; // resync
-              break;
-            }
-          }
+      case 0x0E: // ^N (down arrow)
+        forget_overwritten_history(cmdstart, (cmdend + 1) & CMDLENMSK);
+        if (histcnt > command_history.count) {
+          histcnt = command_history.count;
         }
-        if (temp == cmdend) {
-          if (histcnt == 1) {
-            bp_write_string("\x1B[2K\x0D"); // clear line, CR
-            bp_write_string(
-                enabled_protocols[bus_pirate_configuration.bus_mode].name);
-#ifdef BP_ENABLE_BASIC_SUPPORT
-            if (bus_pirate_configuration.basic) {
-              BPMSG1084;
-            }
-#endif /* BP_ENABLE_BASIC_SUPPORT */
-            bp_write_string(">");
-            while (cmdend != cmdstart) {
-              cmdbuf[cmdend] = 0x00;
-              cmdend = (cmdend - 1) & CMDLENMSK;
-            }
+        if (histcnt > 1) {
+          histcnt--;
+          recall_history_entry(history_entry(histcnt));
+          tmpcmdend = cmdend; // resync
+        } else if (histcnt == 1) {
+          redraw_prompt();
+          while (cmdend != cmdstart) {
             cmdbuf[cmdend] = 0x00;
-            tmpcmdend = cmdend; // resync
-            histcnt = 0;
-          } else
-            user_serial_transmit_character(BELL); // beep, top
+            cmdend = (cmdend - 1) & CMDLENMSK;
+          }
+          cmdbuf[cmdend] = 0x00;
+          tmpcmdend = cmdend; // resync
+          histcnt = 0;
+        } else {
+          user_serial_transmit_character(BELL); // beep, top
         }
         break;
       home:
@@ -457,12 +626,14 @@ void serviceuser(void) {
         cmdbuf[cmdend] = 0x00; // use to find history
         cmdend = (cmdend + 1) & CMDLENMSK;
         tmpcmdend = cmdend; // resync
+        add_history_entry(cmdstart, cmdend);
         bpBR;
         break;
       case 0x00:
+        binmagic = 0;
         binmodecnt++;
         if (binmodecnt == 20) {
-          enter_binary_bitbang_mode();
+          enter_binary_bitbang_mode(NO);
 #ifdef BUSPIRATEV4
           binmodecnt = 0; // no reset, cleanup manually
           goto bpv4reset; // versionInfo(); //and simulate reset for dependent
@@ -525,9 +696,18 @@ void serviceuser(void) {
     }
 #endif /* BP_ENABLE_BASIC_SUPPORT */
 
-    oldDmode = 0; // temporarily holds the default display mode, while a
-                  // different display read is performed
-    newDmode = 0;
+    /*
+     * Plain bus sequences are parsed once up front, so repeat counts and
+     * long sequences recalled from the history or from user macros run
+     * without going through the parser again.
+     */
+    if (!stop && compile_command_line()) {
+      for (index = 0; index < compiled_command.count; index++) {
+        execute_operation(&compiled_command.operations[index]);
+      }
+      stop = 1;
+    }
+
     while (!stop) {
       c = cmdbuf[cmdstart];
 
@@ -672,7 +852,7 @@ void serviceuser(void) {
 #else
         BPMSG1093;
         user_serial_wait_transmission_done(); // wait until TX finishes
-        __asm volatile("RESET");
+        Reset();
 #endif /* BUSPIRATEV4 */
         break;
       case '$':
@@ -684,28 +864,14 @@ void serviceuser(void) {
           bp_reset_board_state(); // turn off nasty things, cleanup first
                                   // needed?
           user_serial_wait_transmission_done(); // wait until TX finishes
-          __asm volatile("RESET");
+          Reset();
         }
         break;
-      case 'a':
-        // bpWline("-AUX low");
-        repeat = getrepeat() + 1;
-        while (--repeat)
-          bp_aux_pin_set_low();
-        break;
-      case 'A':
-        // bpWline("-AUX hi");
-        repeat = getrepeat() + 1;
-        while (--repeat)
-          bp_aux_pin_set_high();
-        break;
-      case '@':
-        // bpWline("-Aux read");
-        repeat = getrepeat() + 1;
-        while (--repeat) { // bpWstring(OUMSG_AUX_INPUT_READ);
-          BPMSG1095;
-          echo_state(bp_aux_pin_read());
-          bpBR;
+      case 'a': // bpWline("-AUX low");
+      case 'A': // bpWline("-AUX hi");
+      case '@': // bpWline("-Aux read");
+        if (compile_operation(&operation)) {
+          execute_operation(&operation);
         }
         break;
       case 'W': // bpWline("-PSU on");	//enable any active power supplies
@@ -764,20 +930,10 @@ void serviceuser(void) {
         bp_adc_continuous_probe();
         break;
       case '&': // bpWline("-delay 1ms");
-        repeat = getrepeat();
-        // bpWstring(OUMSG_PS_DELAY);
-        BPMSG1099;
-        bp_write_dec_word(repeat);
-        // bpWline(OUMSG_PS_DELAY_US);
-        BPMSG1100;
-        bp_delay_us(repeat);
-        break;
       case '%':
-        repeat = getrepeat();
-        BPMSG1099;
-        bp_write_dec_word(repeat);
-        BPMSG1212;
-        bp_delay_ms(repeat);
+        if (compile_operation(&operation)) {
+          execute_operation(&operation);
+        }
         break;
 #ifdef BP_ENABLE_BASIC_SUPPORT
       case 's': // bpWline("Listing:");
@@ -889,17 +1045,9 @@ void serviceuser(void) {
         }
         break;
       case '[': // bpWline("-Start");
-        enabled_protocols[bus_pirate_configuration.bus_mode].start();
-        break;
       case '{': // bpWline("-StartR");
-        enabled_protocols[bus_pirate_configuration.bus_mode].start_with_read();
-        break;
       case ']': // bpWline("-Stop");
-        enabled_protocols[bus_pirate_configuration.bus_mode].stop();
-        break;
       case '}': // bpWline("-StopR");
-        enabled_protocols[bus_pirate_configuration.bus_mode].stop_from_read();
-        break;
       case '0':
       case '1':
       case '2':
@@ -910,145 +1058,17 @@ void serviceuser(void) {
       case '7':
       case '8':
       case '9': // bpWline("-Send");
-        // bpWmessage(MSG_WRITE);
-        BPMSG1101;
-        sendw = getint();
-        cmdstart--;
-        cmdstart &= CMDLENMSK;
-        repeat = getrepeat() + 1;
-        numbits = getnumbits();
-        if (numbits) {
-          mode_configuration.numbits = numbits;
-          if (numbits > 8)
-            mode_configuration.int16 = 1;
-          else
-            mode_configuration.int16 = 0;
-        }
-        while (--repeat) {
-          bp_write_formatted_integer(sendw);
-          if (((mode_configuration.int16 == 0) &&
-               (mode_configuration.numbits != 8)) ||
-              ((mode_configuration.int16 == 1) &&
-               (mode_configuration.numbits != 16))) {
-            user_serial_transmit_character(';');
-            bp_write_dec_byte(mode_configuration.numbits);
-          }
-          if (mode_configuration.little_endian == YES) {
-            sendw = bp_reverse_integer(sendw, mode_configuration.numbits);
-          }
-          received =
-              enabled_protocols[bus_pirate_configuration.bus_mode].send(sendw);
-          bpSP;
-          if (mode_configuration.write_with_read) { // bpWmessage(MSG_READ);
-            BPMSG1102;
-            if (mode_configuration.little_endian == YES) {
-              received =
-                  bp_reverse_integer(received, mode_configuration.numbits);
-            }
-            bp_write_formatted_integer(received);
-            bpSP;
-          }
-        }
-        bpBR;
-        break;
       case 'r': // bpWline("-Read");
-        // bpWmessage(MSG_READ);
-        BPMSG1102;
-        // newDmode = 0;
-        newDmode = change_read_display();
-        repeat = getrepeat() + 1;
-        numbits = getnumbits();
-        if (numbits) {
-          mode_configuration.numbits = numbits;
-          if (numbits > 8)
-            mode_configuration.int16 = 1;
-          else
-            mode_configuration.int16 = 0;
-        }
-        if (newDmode) {
-          oldDmode = bus_pirate_configuration.display_mode;
-          bus_pirate_configuration.display_mode = newDmode - 1;
-        }
-        while (--repeat) {
-          received =
-              enabled_protocols[bus_pirate_configuration.bus_mode].read();
-          if (mode_configuration.little_endian == YES) {
-            received = bp_reverse_integer(received, mode_configuration.numbits);
-          }
-          bp_write_formatted_integer(received);
-          if (((mode_configuration.int16 == 0) &&
-               (mode_configuration.numbits != 8)) ||
-              ((mode_configuration.int16 == 1) &&
-               (mode_configuration.numbits != 16))) {
-            user_serial_transmit_character(';');
-            bp_write_dec_byte(mode_configuration.numbits);
-          }
-          bpSP;
-        }
-        if (newDmode) {
-          bus_pirate_configuration.display_mode = oldDmode;
-          newDmode = 0;
-        }
-        bpBR;
-        break;
       case '/': // bpWline("-CLK hi");
-        // repeat=getrepeat()+1;
-        // while(--repeat)
-        //{	//bpWmessage(MSG_BIT_CLKH);
-        BPMSG1103;
-        enabled_protocols[bus_pirate_configuration.bus_mode].clock_high();
-        //}
-        break;
       case '\\': // bpWline("-CLK lo");
-        // repeat=getrepeat()+1;
-        // while(--repeat)
-        //{	//bpWmessage(MSG_BIT_CLKL);
-        BPMSG1104;
-        enabled_protocols[bus_pirate_configuration.bus_mode].clock_low();
-        //}
-        break;
       case '-': // bpWline("-DAT hi");
-        // repeat=getrepeat()+1;
-        // while(--repeat)
-        //{	//bpWmessage(MSG_BIT_DATH);
-        BPMSG1105;
-        enabled_protocols[bus_pirate_configuration.bus_mode].data_high();
-        //}
-        break;
       case '_': // bpWline("-DAT lo");
-        // repeat=getrepeat()+1;
-        // while(--repeat)
-        //{	//bpWmessage(MSG_BIT_DATL);
-        BPMSG1106;
-        enabled_protocols[bus_pirate_configuration.bus_mode].data_low();
-        //}
-        break;
       case '.': // bpWline("-DAT state read");
-        // repeat=getrepeat()+1;
-        BPMSG1098;
-        echo_state(
-            enabled_protocols[bus_pirate_configuration.bus_mode].data_state());
-        break;
       case '^': // bpWline("-CLK pulse");
-        repeat = getrepeat();
-        BPMSG1108;
-        bp_write_formatted_integer(repeat);
-        repeat++;
-        while (--repeat) { // bpWmessage(MSG_BIT_CLK);
-          enabled_protocols[bus_pirate_configuration.bus_mode].clock_pulse();
-        }
-        bpBR;
-        break;
       case '!': // bpWline("-bit read");
-        repeat = getrepeat() + 1;
-        BPMSG1109;
-        while (--repeat) {
-          echo_state(
-              enabled_protocols[bus_pirate_configuration.bus_mode].read_bit());
-          bpSP;
+        if (compile_operation(&operation)) {
+          execute_operation(&operation);
         }
-        // bpWmessage(MSG_BIT_NOWINPUT);
-        BPMSG1107;
         break;
         // white char/delimeters
       case 0x00:
@@ -1086,6 +1106,396 @@ void serviceuser(void) {
   } // while(1)
 } // serviceuser(void)
 
+bool compile_operation(compiled_operation_t *operation) {
+  operation->numbits = 0;
+  operation->display = 0;
+  operation->value = 0;
+  operation->repeat = 1;
+
+  switch (cmdbuf[cmdstart]) {
+  case '[':
+    operation->type = OPERATION_START;
+    return true;
+  case '{':
+    operation->type = OPERATION_START_WITH_READ;
+    return true;
+  case ']':
+    operation->type = OPERATION_STOP;
+    return true;
+  case '}':
+    operation->type = OPERATION_STOP_FROM_READ;
+    return true;
+  case '/':
+    operation->type = OPERATION_CLOCK_HIGH;
+    return true;
+  case '\\':
+    operation->type = OPERATION_CLOCK_LOW;
+    return true;
+  case '-':
+    operation->type = OPERATION_DATA_HIGH;
+    return true;
+  case '_':
+    operation->type = OPERATION_DATA_LOW;
+    return true;
+  case '.':
+    operation->type = OPERATION_DATA_STATE;
+    return true;
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9':
+    operation->type = OPERATION_WRITE;
+    operation->value = getint();
+    cmdstart = (cmdstart - 1) & CMDLENMSK;
+    operation->repeat = getrepeat();
+    operation->numbits = getnumbits();
+    break;
+  case 'r':
+    operation->type = OPERATION_READ;
+    operation->display = change_read_display();
+    operation->repeat = getrepeat();
+    operation->numbits = getnumbits();
+    break;
+  case '^':
+    operation->type = OPERATION_CLOCK_PULSE;
+    operation->repeat = getrepeat();
+    break;
+  case '!':
+    operation->type = OPERATION_READ_BIT;
+    operation->repeat = getrepeat();
+    break;
+  case 'a':
+    operation->type = OPERATION_AUX_LOW;
+    operation->repeat = getrepeat();
+    break;
+  case 'A':
+    operation->type = OPERATION_AUX_HIGH;
+    operation->repeat = getrepeat();
+    break;
+  case '@':
+    operation->type = OPERATION_AUX_READ;
+    operation->repeat = getrepeat();
+    break;
+  case '&':
+    operation->type = OPERATION_DELAY_US;
+    operation->repeat = getrepeat();
+    break;
+  case '%':
+    operation->type = OPERATION_DELAY_MS;
+    operation->repeat = getrepeat();
+    break;
+  default:
+    return false;
+  }
+
+  return mode_configuration.command_error == NO;
+}
+
+void execute_operation(const compiled_operation_t *operation) {
+  unsigned int value;
+  unsigned int received;
+  uint16_t repeat;
+  bus_pirate_display_mode_t display_mode;
+
+  if (operation->numbits) {
+    mode_configuration.numbits = operation->numbits;
+    mode_configuration.int16 = (operation->numbits > 8) ? 1 : 0;
+  }
+
+  switch (operation->type) {
+  case OPERATION_START:
+    enabled_protocols[bus_pirate_configuration.bus_mode].start();
+    break;
+
+  case OPERATION_START_WITH_READ:
+    enabled_protocols[bus_pirate_configuration.bus_mode].start_with_read();
+    break;
+
+  case OPERATION_STOP:
+    enabled_protocols[bus_pirate_configuration.bus_mode].stop();
+    break;
+
+  case OPERATION_STOP_FROM_READ:
+    enabled_protocols[bus_pirate_configuration.bus_mode].stop_from_read();
+    break;
+
+  case OPERATION_WRITE:
+    // bpWmessage(MSG_WRITE);
+    BPMSG1101;
+    value = operation->value;
+    if ((operation->repeat > 1) &&
+        (enabled_protocols[bus_pirate_configuration.bus_mode]
+             .transfer_buffer != NULL) &&
+        (mode_configuration.int16 == NO) && (mode_configuration.numbits == 8) &&
+        (mode_configuration.little_endian == NO)) {
+      write_values(value, operation->repeat);
+      bpBR;
+      break;
+    }
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      bp_write_formatted_integer(value);
+      if (((mode_configuration.int16 == 0) &&
+           (mode_configuration.numbits != 8)) ||
+          ((mode_configuration.int16 == 1) &&
+           (mode_configuration.numbits != 16))) {
+        user_serial_transmit_character(';');
+        bp_write_dec_byte(mode_configuration.numbits);
+      }
+      if (mode_configuration.little_endian == YES) {
+        value = bp_reverse_integer(value, mode_configuration.numbits);
+      }
+      received =
+          enabled_protocols[bus_pirate_configuration.bus_mode].send(value);
+      bpSP;
+      if (mode_configuration.write_with_read) { // bpWmessage(MSG_READ);
+        BPMSG1102;
+        if (mode_configuration.little_endian == YES) {
+          received = bp_reverse_integer(received, mode_configuration.numbits);
+        }
+        bp_write_formatted_integer(received);
+        bpSP;
+      }
+    }
+    bpBR;
+    break;
+
+  case OPERATION_READ:
+    // bpWmessage(MSG_READ);
+    BPMSG1102;
+    display_mode = bus_pirate_configuration.display_mode;
+    if (operation->display) {
+      bus_pirate_configuration.display_mode = operation->display - 1;
+    }
+    read_values(operation->repeat);
+    bus_pirate_configuration.display_mode = display_mode;
+    break;
+
+  case OPERATION_CLOCK_HIGH:
+    // bpWmessage(MSG_BIT_CLKH);
+    BPMSG1103;
+    enabled_protocols[bus_pirate_configuration.bus_mode].clock_high();
+    break;
+
+  case OPERATION_CLOCK_LOW:
+    // bpWmessage(MSG_BIT_CLKL);
+    BPMSG1104;
+    enabled_protocols[bus_pirate_configuration.bus_mode].clock_low();
+    break;
+
+  case OPERATION_DATA_HIGH:
+    // bpWmessage(MSG_BIT_DATH);
+    BPMSG1105;
+    enabled_protocols[bus_pirate_configuration.bus_mode].data_high();
+    break;
+
+  case OPERATION_DATA_LOW:
+    // bpWmessage(MSG_BIT_DATL);
+    BPMSG1106;
+    enabled_protocols[bus_pirate_configuration.bus_mode].data_low();
+    break;
+
+  case OPERATION_DATA_STATE:
+    BPMSG1098;
+    echo_state(
+        enabled_protocols[bus_pirate_configuration.bus_mode].data_state());
+    break;
+
+  case OPERATION_CLOCK_PULSE:
+    BPMSG1108;
+    bp_write_formatted_integer(operation->repeat);
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      enabled_protocols[bus_pirate_configuration.bus_mode].clock_pulse();
+    }
+    bpBR;
+    break;
+
+  case OPERATION_READ_BIT:
+    BPMSG1109;
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      echo_state(
+          enabled_protocols[bus_pirate_configuration.bus_mode].read_bit());
+      bpSP;
+    }
+    // bpWmessage(MSG_BIT_NOWINPUT);
+    BPMSG1107;
+    break;
+
+  case OPERATION_AUX_LOW:
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      bp_aux_pin_set_low();
+    }
+    break;
+
+  case OPERATION_AUX_HIGH:
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      bp_aux_pin_set_high();
+    }
+    break;
+
+  case OPERATION_AUX_READ:
+    for (repeat = operation->repeat; repeat > 0; repeat--) {
+      // bpWstring(OUMSG_AUX_INPUT_READ);
+      BPMSG1095;
+      echo_state(bp_aux_pin_read());
+      bpBR;
+    }
+    break;
+
+  case OPERATION_DELAY_US:
+    // bpWstring(OUMSG_PS_DELAY);
+    BPMSG1099;
+    bp_write_dec_word(operation->repeat);
+    // bpWline(OUMSG_PS_DELAY_US);
+    BPMSG1100;
+    bp_delay_us(operation->repeat);
+    break;
+
+  case OPERATION_DELAY_MS:
+    BPMSG1099;
+    bp_write_dec_word(operation->repeat);
+    BPMSG1212;
+    bp_delay_ms(operation->repeat);
+    break;
+  }
+}
+
+void read_values(uint16_t count) {
+  uint8_t text[READ_VALUE_MAX_LENGTH];
+  uint16_t values[READ_BATCH_VALUES];
+  uint8_t bytes[READ_BATCH_VALUES];
+  size_t batch;
+  size_t index;
+  size_t length;
+  uint8_t column;
+  bool dump;
+  bool suffix;
+  bool native;
+
+  /* Byte sized values can be read by the protocol in one go. */
+  native = (mode_configuration.int16 == NO) &&
+           (enabled_protocols[bus_pirate_configuration.bus_mode].read_buffer !=
+            NULL);
+  dump = (bus_pirate_configuration.display_mode == DUMP);
+  suffix = !dump && (((mode_configuration.int16 == 0) &&
+                      (mode_configuration.numbits != 8)) ||
+                     ((mode_configuration.int16 == 1) &&
+                      (mode_configuration.numbits != 16)));
+  column = 0;
+
+  if (dump && (count > 0)) {
+    /* The dump starts on a line of its own. */
+    bpBR;
+  }
+
+  while (count > 0) {
+    batch = (count < READ_BATCH_VALUES) ? count : READ_BATCH_VALUES;
+
+    if (native) {
+      enabled_protocols[bus_pirate_configuration.bus_mode].read_buffer(bytes,
+                                                                     batch);
+    }
+    for (index = 0; index < batch; index++) {
+      values[index] =
+          native ? bytes[index]
+                 : enabled_protocols[bus_pirate_configuration.bus_mode].read();
+      if (mode_configuration.little_endian == YES) {
+        values[index] =
+            bp_reverse_integer(values[index], mode_configuration.numbits);
+      }
+    }
+
+    for (index = 0; index < batch; index++) {
+      length = bp_format_integer(text, values[index]);
+      if (suffix) {
+        text[length++] = ';';
+        length += bp_format_dec_word(&text[length], mode_configuration.numbits);
+      }
+      if (dump && (++column == DUMP_VALUES_PER_LINE)) {
+        text[length++] = 0x0D;
+        text[length++] = 0x0A;
+        column = 0;
+      } else {
+        text[length++] = ' ';
+      }
+      user_serial_write_buffer(text, length);
+    }
+
+    count -= batch;
+  }
+
+  if (!dump || (column != 0)) {
+    bpBR;
+  }
+}
+
+void write_values(const uint8_t value, uint16_t count) {
+  uint8_t output[READ_BATCH_VALUES];
+  uint8_t input[READ_BATCH_VALUES];
+  size_t batch;
+  size_t index;
+
+  for (index = 0; index < READ_BATCH_VALUES; index++) {
+    output[index] = value;
+  }
+
+  while (count > 0) {
+    batch = (count < READ_BATCH_VALUES) ? count : READ_BATCH_VALUES;
+
+    enabled_protocols[bus_pirate_configuration.bus_mode].transfer_buffer(
+        output, input, batch);
+    for (index = 0; index < batch; index++) {
+      bp_write_formatted_integer(value);
+      bpSP;
+      if (mode_configuration.write_with_read) {
+        BPMSG1102;
+        bp_write_formatted_integer(input[index]);
+        bpSP;
+      }
+    }
+
+    count -= batch;
+  }
+}
+
+bool compile_command_line(void) {
+  unsigned int start;
+
+  start = cmdstart;
+  compiled_command.count = 0;
+
+  do {
+    switch (cmdbuf[cmdstart]) {
+    case 0x00:
+    case 0x0D:
+    case 0x0A:
+    case ' ':
+    case ',':
+      break;
+
+    default:
+      if ((compiled_command.count == BP_COMPILED_COMMAND_MAX_OPERATIONS) ||
+          !compile_operation(
+              &compiled_command.operations[compiled_command.count])) {
+        /* Let the interpreter handle it, and report any error. */
+        mode_configuration.command_error = NO;
+        cmdstart = start;
+        return false;
+      }
+      compiled_command.count++;
+      break;
+    }
+    cmdstart = (cmdstart + 1) & CMDLENMSK;
+  } while (cmdstart != cmdend);
+
+  return true;
+}
+
 int getint(void) // get int from user (accept decimal, hex (0x) or binairy (0b)
 {
   int i;
@@ -1262,42 +1672,120 @@ void changemode(void) {
   cmdstart = (cmdend - 1) & CMDLENMSK;
 }
 
+void forget_overwritten_history(const uint16_t start, const uint16_t end) {
+  const uint16_t length = (end - start) & CMDLENMSK;
+
+  while ((command_history.count > 0) &&
+         (((command_history.starts[command_history.oldest] - start) &
+           CMDLENMSK) < length)) {
+    command_history.oldest =
+        (command_history.oldest + 1) % BP_COMMAND_HISTORY_LENGTH;
+    command_history.count--;
+  }
+}
+
+void add_history_entry(const uint16_t start, const uint16_t end) {
+  forget_overwritten_history(start, end);
+
+  if (cmdbuf[start] == 0x00) {
+    /* Empty lines are not worth recalling. */
+    return;
+  }
+
+  if (command_history.count == BP_COMMAND_HISTORY_LENGTH) {
+    command_history.oldest =
+        (command_history.oldest + 1) % BP_COMMAND_HISTORY_LENGTH;
+    command_history.count--;
+  }
+  command_history.starts[(command_history.oldest + command_history.count) %
+                         BP_COMMAND_HISTORY_LENGTH] = start;
+  command_history.count++;
+}
+
+uint16_t history_entry(const uint8_t back) {
+  return command_history.starts[(command_history.oldest +
+                                 command_history.count - back) %
+                                BP_COMMAND_HISTORY_LENGTH];
+}
+
+void redraw_prompt(void) {
+  bp_write_string("\x1B[2K\x0D"); // clear line, CR
+  bp_write_string(enabled_protocols[bus_pirate_configuration.bus_mode].name);
+#ifdef BP_ENABLE_BASIC_SUPPORT
+  if (bus_pirate_configuration.basic) {
+    BPMSG1084;
+  }
+#endif /* BP_ENABLE_BASIC_SUPPORT */
+  bp_write_string(">");
+}
+
+void recall_history_entry(const uint16_t start) {
+  uint16_t index;
+
+  /* Clear the partially entered command line. */
+  while (cmdend != cmdstart) {
+    cmdbuf[cmdend] = 0x00;
+    cmdend = (cmdend - 1) & CMDLENMSK;
+  }
+  cmdbuf[cmdend] = 0x00;
+
+  redraw_prompt();
+  for (index = start; cmdbuf[index]; index = (index + 1) & CMDLENMSK) {
+    user_serial_transmit_character(cmdbuf[index]);
+    cmdbuf[cmdend] = cmdbuf[index];
+    cmdend = (cmdend + 1) & CMDLENMSK;
+  }
+  cmdbuf[cmdend] = 0x00;
+}
+
+int append_script_characters(unsigned char character) {
+  uint8_t echo[SCRIPT_ECHO_CHUNK_SIZE];
+  size_t length;
+
+  length = 0;
+  while ((character >= 0x20) && (character < 0x7F) &&
+         (((cmdend + 1) & CMDLENMSK) != cmdstart)) {
+    cmdbuf[cmdend] = character;
+    cmdend = (cmdend + 1) & CMDLENMSK;
+    echo[length++] = character;
+    if (length == sizeof(echo)) {
+      user_serial_write_buffer(echo, length);
+      length = 0;
+    }
+
+    if (!user_serial_ready_to_read()) {
+      cmdbuf[cmdend] = 0x00; // add end marker
+      user_serial_write_buffer(echo, length);
+      return -1;
+    }
+    character = user_serial_read_byte();
+  }
+
+  cmdbuf[cmdend] = 0x00; // add end marker
+  user_serial_write_buffer(echo, length);
+  return character;
+}
+
 #ifdef BP_ENABLE_COMMAND_HISTORY
 
 int cmdhistory(void) {
-  int i, j, k;
+  uint16_t start;
+  int i, j;
 
-  int historypos[BP_COMMAND_HISTORY_LENGTH];
+  forget_overwritten_history(cmdstart, cmdend);
 
-  i = 1;
-  j = (cmdstart - 1) & CMDLENMSK;
-
-  while (j != cmdstart) // scroll through the whole buffer
-  {
-    if ((cmdbuf[j] == 0x00) && (cmdbuf[(j + 1) & CMDLENMSK] !=
-                                0x00)) // did we find an end? is it not empty?
-    {
-      bp_write_dec_byte(i);
-      bp_write_string(". ");
-      k = 1;
-      while (cmdbuf[((j + k) & CMDLENMSK)]) {
-        user_serial_transmit_character(
-            cmdbuf[((j + k) & CMDLENMSK)]); // print it
-        k++;
-      }
-      historypos[i] = (j + 1) & CMDLENMSK;
-      i++;
-      if (i == BP_COMMAND_HISTORY_LENGTH)
-        break;
-      bpBR;
+  for (i = 1; i <= command_history.count; i++) {
+    bp_write_dec_byte(i);
+    bp_write_string(". ");
+    for (j = history_entry(i); cmdbuf[j]; j = (j + 1) & CMDLENMSK) {
+      user_serial_transmit_character(cmdbuf[j]); // print it
     }
-    j = (j - 1) & CMDLENMSK;
+    bpBR;
   }
 
-  bpBR;
   BPMSG1115;
 
-  j = getnumber(0, 1, i, 1);
+  j = getnumber(0, 1, command_history.count, 1);
 
   if (j == -1 || !j) // x is -1, default is 0
   {
@@ -1305,17 +1793,20 @@ int cmdhistory(void) {
     return 1;
   }
 
+  start = cmdend;
   i = 0;
-  while (cmdbuf[(historypos[j] + i) &
+  while (cmdbuf[(history_entry(j) + i) &
                 CMDLENMSK]) // copy it to the end of the ringbuffer
   {
-    cmdbuf[(cmdend + i) & CMDLENMSK] = cmdbuf[(historypos[j] + i) & CMDLENMSK];
+    cmdbuf[(cmdend + i) & CMDLENMSK] =
+        cmdbuf[(history_entry(j) + i) & CMDLENMSK];
     i++;
   }
   cmdstart = (cmdend - 1) &
              CMDLENMSK; // start will be increased before parsing in main loop
   cmdend = (cmdstart + i + 2) & CMDLENMSK;
   cmdbuf[(cmdend - 1) & CMDLENMSK] = 0x00;
+  add_history_entry(start, cmdend);
 
   return 0;
 }
@@ -1629,6 +2120,9 @@ void print_version_info(void) {
 #endif /* BUSPIRATEV4 */
 
   bp_write_line(")");
+#ifdef BP_ENABLE_MEMORY_USAGE
+  bp_memory_usage_print();
+#endif /* BP_ENABLE_MEMORY_USAGE */
   BPMSG1118;
 }
 
@@ -1830,12 +2324,12 @@ void set_display_mode(void) {
   consumewhitechars();
   int mode = getint();
 
-  if ((mode > 0) && (mode <= 4)) {
+  if ((mode > 0) && (mode <= (DUMP + 1))) {
     bus_pirate_configuration.display_mode = mode - 1;
   } else {
     mode_configuration.command_error = NO;
     BPMSG1127;
-    bus_pirate_configuration.display_mode = getnumber(1, 1, 4, 0) - 1;
+    bus_pirate_configuration.display_mode = getnumber(1, 1, DUMP + 1, 0) - 1;
   }
   BPMSG1128;
 }
@@ -1960,10 +2454,10 @@ void convert_value(const bool reversed) {
   if (reversed) {
     value = bp_reverse_integer(value, mode_configuration.numbits);
   }
-  bp_write_hex_byte(reversed);
+  bp_write_hex_byte(value);
   MSG_BASE_CONVERTER_EQUAL_SIGN;
-  bp_write_dec_byte(reversed);
+  bp_write_dec_byte(value);
   MSG_BASE_CONVERTER_EQUAL_SIGN;
-  bp_write_bin_byte(reversed);
+  bp_write_bin_byte(value);
   bpBR;
 }
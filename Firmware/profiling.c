@@ -0,0 +1,111 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate. This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+
+#include "profiling.h"
+
+#ifdef BP_ENABLE_PROFILING
+
+#include "base.h"
+
+/**
+ * Counters kept for each region.
+ */
+typedef struct {
+  /** How many times the region was left. */
+  uint32_t passes;
+
+  /** Time spent in the region, in timer ticks. */
+  uint32_t total;
+
+  /** Longest single pass, in timer ticks. */
+  uint32_t longest;
+} bp_profiling_counters_t;
+
+uint32_t bp_profiling_entered[BP_PROFILING_REGIONS_COUNT];
+
+static bp_profiling_counters_t
+    bp_profiling_counters[BP_PROFILING_REGIONS_COUNT];
+
+/**
+ * Sends a 32 bits value, MSB first.
+ *
+ * @param[in] value the value to send.
+ */
+static void bp_profiling_send_dword(const uint32_t value);
+
+void bp_profiling_reset(void) {
+  memset(bp_profiling_counters, 0, sizeof(bp_profiling_counters));
+
+  /*
+   * T2CON: TIMER2 CONTROL REGISTER
+   *
+   * MSB
+   * 1-0------0001-0-
+   * | |      |||| |
+   * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+   * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
+   * | |      |++------ TCKPS: Input prescaler 1:1 (one tick per cycle).
+   * | |      +-------- TGATE: Gated time accumulation is disabled.
+   * | +--------------- TSIDL  Continues module operation in Idle mode.
+   * +----------------- TON:   Starts 32-bit Timerx.
+   */
+  T2CON = 0;
+  TMR3HLD = 0;
+  TMR2 = 0;
+  PR3 = 0xFFFF;
+  PR2 = 0xFFFF;
+  T2CON = (ON << _T2CON_TON_POSITION) | (1 << _T2CON_T32_POSITION);
+}
+
+void bp_profiling_account(const bp_profiling_region_t region,
+                          const uint32_t ticks) {
+  bp_profiling_counters_t *counters;
+
+  counters = &bp_profiling_counters[region];
+  counters->passes++;
+  counters->total += ticks;
+  if (ticks > counters->longest) {
+    counters->longest = ticks;
+  }
+}
+
+void bp_profiling_send_dword(const uint32_t value) {
+  user_serial_transmit_character(value >> 24);
+  user_serial_transmit_character((value >> 16) & 0xFF);
+  user_serial_transmit_character((value >> 8) & 0xFF);
+  user_serial_transmit_character(value & 0xFF);
+}
+
+void bp_profiling_send_report(void) {
+  bp_profiling_counters_t snapshot[BP_PROFILING_REGIONS_COUNT];
+  size_t index;
+
+  /* Sending the report goes through the serial port regions too. */
+  memcpy(snapshot, bp_profiling_counters, sizeof(snapshot));
+  bp_profiling_reset();
+
+  user_serial_transmit_character(BP_PROFILING_REGIONS_COUNT);
+  user_serial_transmit_character(BP_PROFILING_TICKS_PER_US);
+  for (index = 0; index < BP_PROFILING_REGIONS_COUNT; index++) {
+    bp_profiling_send_dword(snapshot[index].passes);
+    bp_profiling_send_dword(snapshot[index].total);
+    bp_profiling_send_dword(snapshot[index].longest);
+  }
+}
+
+#endif /* BP_ENABLE_PROFILING */
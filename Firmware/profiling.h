@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef BP_PROFILING_H
+#define BP_PROFILING_H
+
+#include <stdint.h>
+
+#include <xc.h>
+
+#include "configuration.h"
+
+/**
+ * Firmware regions that can be timed.
+ */
+typedef enum {
+  /** Waiting for and reading one byte from the user-facing serial port. */
+  BP_PROFILING_REGION_SERIAL_READ = 0,
+
+  /** Clocking one byte through the SPI peripheral. */
+  BP_PROFILING_REGION_SPI_WRITE,
+
+  /** Handing one CDC packet to the USB SIE, v4 only. */
+  BP_PROFILING_REGION_CDC_PUTDA,
+
+  /** Clocking one value through the bitbang engine. */
+  BP_PROFILING_REGION_BITBANG,
+
+  /** One SUMP acquisition, from the first sample to the last. */
+  BP_PROFILING_REGION_SUMP_CAPTURE,
+
+  /** How many regions there are. */
+  BP_PROFILING_REGIONS_COUNT
+} bp_profiling_region_t;
+
+#ifdef BP_ENABLE_PROFILING
+
+/**
+ * Timer ticks per microsecond, the timer runs at FCY.
+ */
+#define BP_PROFILING_TICKS_PER_US (FCY / 1000000UL)
+
+/**
+ * When each region was last entered, in timer ticks.
+ */
+extern uint32_t bp_profiling_entered[BP_PROFILING_REGIONS_COUNT];
+
+/**
+ * Clears all counters and restarts the free-running timer.
+ *
+ * Timer #2/#3 are taken over as a single 32 bits timer.  Commands that use
+ * them on their own (PWM, frequency measurement, UART timestamps, ADC streams,
+ * 1-Wire and the pattern generator) make the timings taken meanwhile
+ * meaningless; resetting the counters afterwards brings the timer back.
+ */
+void bp_profiling_reset(void);
+
+/**
+ * Reads the free-running timer.
+ *
+ * @return the current timer value, in ticks.
+ */
+static inline uint32_t bp_profiling_timestamp(void) {
+  uint16_t low;
+
+  /* Reading TMR2 latches the upper half into TMR3HLD. */
+  low = TMR2;
+  return ((uint32_t)TMR3HLD << 16) | low;
+}
+
+/**
+ * Adds one pass through a region to its counters.
+ *
+ * @param[in] region the region being left.
+ * @param[in] ticks how long the region took.
+ */
+void bp_profiling_account(const bp_profiling_region_t region,
+                          const uint32_t ticks);
+
+/**
+ * Sends the counters of every region and clears them.
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Content</th></tr>
+ * <tr><td>0</td><td>Number of regions</td></tr>
+ * <tr><td>1</td><td>Timer ticks per microsecond</td></tr>
+ * <tr><td>2+12n</td><td>Region n passes, MSB first</td></tr>
+ * <tr><td>6+12n</td><td>Region n total ticks, MSB first</td></tr>
+ * <tr><td>10+12n</td><td>Region n longest pass in ticks, MSB first</td></tr>
+ * </table>
+ *
+ * Regions are in bp_profiling_region_t order.
+ */
+void bp_profiling_send_report(void);
+
+/**
+ * Marks the start of a timed region.
+ */
+#define BP_PROFILING_ENTER(region)                                             \
+  bp_profiling_entered[(region)] = bp_profiling_timestamp()
+
+/**
+ * Marks the end of a timed region.
+ */
+#define BP_PROFILING_EXIT(region)                                              \
+  bp_profiling_account((region), bp_profiling_timestamp() -                    \
+                                     bp_profiling_entered[(region)])
+
+#else
+
+#define BP_PROFILING_ENTER(region)
+#define BP_PROFILING_EXIT(region)
+
+#endif /* BP_ENABLE_PROFILING */
+
+#endif /* !BP_PROFILING_H */
@@ -22,6 +22,7 @@
 #include "aux_pin.h"
 #include "base.h"
 #include "bitbang.h"
+#include "iso7816.h"
 #include "proc_menu.h"
 
 #define R2WCLK_TRIS BP_CLK_DIR
@@ -35,7 +36,9 @@
 typedef enum {
   RAW2WIRE_MACRO_MENU = 0,
   RAW2WIRE_MACRO_ISO_7816_3_ATR,
-  RAW2WIRE_MACRO_ISO_7816_3_ATR_PARSE
+  RAW2WIRE_MACRO_ISO_7816_3_ATR_PARSE,
+  RAW2WIRE_MACRO_ISO_7816_3_T0_ACTIVATE,
+  RAW2WIRE_MACRO_ISO_7816_3_T0_DEACTIVATE
 } raw2wire_macro_identifier_t;
 
 extern mode_configuration_t mode_configuration;
@@ -59,6 +62,11 @@ static void read_atr_header(void);
  */
 static void trigger_atr(void);
 
+/**
+ * Activates an asynchronous ISO 7816-3 card and prints its ATR.
+ */
+static void activate_t0_card(void);
+
 uint16_t raw2wire_read(void) { return bitbang_read_value(); }
 
 uint16_t raw2wire_write(const uint16_t value) {
@@ -66,6 +74,22 @@ uint16_t raw2wire_write(const uint16_t value) {
   return 0x100;
 }
 
+void raw2wire_send_buffer(const uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    bitbang_write_value(buffer[index]);
+  }
+}
+
+void raw2wire_read_buffer(uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    buffer[index] = bitbang_read_value();
+  }
+}
+
 void raw2wire_start(void) {
   bitbang_i2c_start(BITBANG_I2C_START_ONE_SHOT);
   MSG_RAW2WIRE_I2C_START;
@@ -131,14 +155,47 @@ void raw2wire_run_macro(const uint16_t macro_id) {
     read_atr_header();
     break;
 
+  case RAW2WIRE_MACRO_ISO_7816_3_T0_ACTIVATE:
+    activate_t0_card();
+    break;
+
+  case RAW2WIRE_MACRO_ISO_7816_3_T0_DEACTIVATE:
+    iso7816_deactivate();
+    MSG_RAW2WIRE_T0_DEACTIVATED;
+    break;
+
   default:
     MSG_UNKNOWN_MACRO_ERROR;
     break;
   }
 }
 
+void raw2wire_cleanup(void) {
+  iso7816_deactivate();
+  mode_configuration.numbits = 8;
+  mode_configuration.int16 = NO;
+}
+
 void raw2wire_print_pins_state(void) { MSG_I2C_PINS_STATE; }
 
+void activate_t0_card(void) {
+  uint8_t atr[ISO7816_ATR_MAXIMUM_LENGTH];
+  size_t length;
+
+  if (iso7816_activate(atr, &length) != ISO7816_OK) {
+    MSG_RAW2WIRE_T0_NO_ANSWER;
+    mode_configuration.command_error = YES;
+    return;
+  }
+
+  MSG_RAW2WIRE_T0_ATR;
+  for (size_t index = 0; index < length; index++) {
+    bp_write_hex_byte(atr[index]);
+    bpSP;
+  }
+  bpBR;
+}
+
 void trigger_atr(void) {
   MSG_RAW2WIRE_ATR_TRIGGER_INFO;
 
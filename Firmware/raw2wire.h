@@ -23,18 +23,26 @@
 #ifdef BP_ENABLE_RAW_2WIRE_SUPPORT
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 void raw2wire_start(void);
 void raw2wire_stop(void);
 uint16_t raw2wire_write(const uint16_t value);
 uint16_t raw2wire_read(void);
+void raw2wire_send_buffer(const uint8_t *buffer, const size_t length);
+void raw2wire_read_buffer(uint8_t *buffer, const size_t length);
 void raw2wire_run_macro(const uint16_t macro_id);
 void raw2wire_setup_execute(void);
 void raw2wire_setup_prepare(void);
 void raw2wire_print_pins_state(void);
 void raw2wire_print_settings(void);
 
+/**
+ * Deactivates any smart card and puts the mode back to 8 bits.
+ */
+void raw2wire_cleanup(void);
+
 #endif /* BP_ENABLE_RAW_2WIRE_SUPPORT */
 
 #endif /* !BP_RAW2WIRE_H */
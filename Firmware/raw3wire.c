@@ -28,6 +28,8 @@
 #define R3WMOSI_TRIS BP_MOSI_DIR
 #define R3WCLK_TRIS BP_CLK_DIR
 #define R3WMISO_TRIS BP_MISO_DIR
+#define R3WMOSI_ODC BP_MOSI_ODC
+#define R3WCLK_ODC BP_CLK_ODC
 
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
@@ -47,15 +49,241 @@ static bool cs_line = LOW;
 static void setup_raw3wire(const bool write_with_read,
                            const bool cs_line_state);
 
-uint16_t raw3wire_read(void) { return bitbang_read_with_write(0xFF); }
+#ifdef BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+
+/**
+ * Marks a bus speed SPI1 cannot clock at.
+ */
+#define RAW3WIRE_NO_HARDWARE_SPI 0xFF
+
+/**
+ * SPI1CON1 SPRE and PPRE bits for each bus speed, the fastest SPI1 clock not
+ * above the nominal bit-bang one: 50kHz, 83kHz and 333kHz.  SPI1 cannot go
+ * down to 5kHz.
+ */
+static const uint8_t RAW3WIRE_SPI_PRESCALERS[] = {
+    RAW3WIRE_NO_HARDWARE_SPI,
+    0b00001100, /*  50 kHz - Primary prescaler 64:1 / Secondary prescaler 5:1 */
+    0b00010100, /*  83 kHz - Primary prescaler 64:1 / Secondary prescaler 3:1 */
+    0b00010101  /* 333 kHz - Primary prescaler 16:1 / Secondary prescaler 3:1 */
+};
+
+/**
+ * Tells whether the current transfers can go through SPI1.
+ *
+ * Only whole 8 or 16 bits words can, LSB first words are already reversed by
+ * the time they get here.  SPI1 samples MISO on the rising edge with CLK idle
+ * low and MOSI changing on the falling edge, as bitbang_read_with_write does.
+ *
+ * @return true if SPI1 is to be used, false to bit-bang.
+ */
+static bool raw3wire_use_hardware_spi(void);
+
+/**
+ * Hands MOSI and CLK over to SPI1 and enables it for the current word size
+ * and bus speed, with open drain outputs in high impedance mode.
+ */
+static void raw3wire_hardware_spi_begin(void);
+
+/**
+ * Gives MOSI and CLK back to the port latches, as they were before
+ * raw3wire_hardware_spi_begin(), and disables SPI1.
+ */
+static void raw3wire_hardware_spi_end(void);
+
+/**
+ * Exchanges one word through SPI1, which must have been enabled with
+ * raw3wire_hardware_spi_begin().
+ *
+ * @param[in] value the word to send.
+ *
+ * @return the word read.
+ */
+static uint16_t raw3wire_hardware_spi_transfer(const uint16_t value);
+
+/**
+ * MOSI and CLK directions to restore once SPI1 is done.
+ */
+static struct {
+  bool mosi;
+  bool clock;
+} raw3wire_saved_directions;
+
+#endif /* BP_RAW3WIRE_ENABLE_HARDWARE_SPI */
+
+/**
+ * Gets ready for a run of transfers, through SPI1 if it can take them.
+ *
+ * @return true if SPI1 was enabled, to be passed on to raw3wire_transfer_word
+ *         and raw3wire_transfer_end.
+ */
+static bool raw3wire_transfer_begin(void);
+
+/**
+ * Exchanges one word, either through SPI1 or by bit-banging.
+ *
+ * @param[in] hardware what raw3wire_transfer_begin returned.
+ * @param[in] value the word to send.
+ *
+ * @return the word read.
+ */
+static uint16_t raw3wire_transfer_word(const bool hardware,
+                                       const uint16_t value);
+
+/**
+ * Ends a run of transfers started by raw3wire_transfer_begin.
+ *
+ * @param[in] hardware what raw3wire_transfer_begin returned.
+ */
+static void raw3wire_transfer_end(const bool hardware);
+
+#ifdef BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+
+bool raw3wire_use_hardware_spi(void) {
+  return ((mode_configuration.numbits == 8) ||
+          (mode_configuration.numbits == 16)) &&
+         (mode_configuration.speed < sizeof(RAW3WIRE_SPI_PRESCALERS)) &&
+         (RAW3WIRE_SPI_PRESCALERS[mode_configuration.speed] !=
+          RAW3WIRE_NO_HARDWARE_SPI);
+}
+
+void raw3wire_hardware_spi_begin(void) {
+  raw3wire_saved_directions.mosi = R3WMOSI_TRIS;
+  raw3wire_saved_directions.clock = R3WCLK_TRIS;
+
+  SPI1STATbits.SPIEN = OFF;
+
+  R3WMOSI_ODC = mode_configuration.high_impedance;
+  R3WCLK_ODC = mode_configuration.high_impedance;
+  RPINR20bits.SDI1R = BP_MISO_RPIN;
+  BP_MOSI_RPOUT = SDO1_IO;
+  BP_CLK_RPOUT = SCK1OUT_IO;
+  R3WMOSI_TRIS = OUTPUT;
+  R3WCLK_TRIS = OUTPUT;
+
+  /* Master, clock idle low, output changing on the falling edge. */
+  SPI1CON1 = (RAW3WIRE_SPI_PRESCALERS[mode_configuration.speed]
+              << _SPI1CON1_PPRE_POSITION) |
+             (ON << _SPI1CON1_MSTEN_POSITION) |
+             (ON << _SPI1CON1_CKE_POSITION) |
+             ((mode_configuration.numbits == 16) << _SPI1CON1_MODE16_POSITION);
+  SPI1CON2 = 0x0000;
+  SPI1STAT = 0x0000;
+  SPI1STATbits.SPIEN = ON;
+}
+
+void raw3wire_hardware_spi_end(void) {
+  SPI1STATbits.SPIEN = OFF;
+
+  RPINR20bits.SDI1R = 0b11111;
+  BP_MOSI_RPOUT = 0b00000;
+  BP_CLK_RPOUT = 0b00000;
+  R3WMOSI_TRIS = raw3wire_saved_directions.mosi;
+  R3WCLK_TRIS = raw3wire_saved_directions.clock;
+  R3WMOSI_ODC = OFF;
+  R3WCLK_ODC = OFF;
+}
+
+uint16_t raw3wire_hardware_spi_transfer(const uint16_t value) {
+  SPI1STATbits.SPIROV = NO;
+  SPI1BUF = value;
+  while (SPI1STATbits.SPIRBF == NO) {
+  }
+  return SPI1BUF;
+}
+
+#endif /* BP_RAW3WIRE_ENABLE_HARDWARE_SPI */
+
+bool raw3wire_transfer_begin(void) {
+#ifdef BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+  if (raw3wire_use_hardware_spi()) {
+    raw3wire_hardware_spi_begin();
+    return true;
+  }
+#endif /* BP_RAW3WIRE_ENABLE_HARDWARE_SPI */
+
+  return false;
+}
+
+uint16_t raw3wire_transfer_word(const bool hardware, const uint16_t value) {
+#ifdef BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+  if (hardware) {
+    return raw3wire_hardware_spi_transfer(value);
+  }
+#else
+  (void)hardware;
+#endif /* BP_RAW3WIRE_ENABLE_HARDWARE_SPI */
+
+  return bitbang_read_with_write(value);
+}
+
+void raw3wire_transfer_end(const bool hardware) {
+#ifdef BP_RAW3WIRE_ENABLE_HARDWARE_SPI
+  if (hardware) {
+    raw3wire_hardware_spi_end();
+  }
+#else
+  (void)hardware;
+#endif /* BP_RAW3WIRE_ENABLE_HARDWARE_SPI */
+}
+
+uint16_t raw3wire_read(void) {
+  bool hardware;
+  uint16_t read;
+
+  hardware = raw3wire_transfer_begin();
+  read = raw3wire_transfer_word(hardware, 0xFF);
+  raw3wire_transfer_end(hardware);
+
+  return read;
+}
 
 uint16_t raw3wire_write(const uint16_t value) {
+  bool hardware;
   uint16_t read;
 
-  read = bitbang_read_with_write(value);
+  hardware = raw3wire_transfer_begin();
+  read = raw3wire_transfer_word(hardware, value);
+  raw3wire_transfer_end(hardware);
+
   return mode_configuration.write_with_read ? read : 0;
 }
 
+void raw3wire_send_buffer(const uint8_t *buffer, const size_t length) {
+  bool hardware;
+  size_t index;
+
+  hardware = raw3wire_transfer_begin();
+  for (index = 0; index < length; index++) {
+    raw3wire_transfer_word(hardware, buffer[index]);
+  }
+  raw3wire_transfer_end(hardware);
+}
+
+void raw3wire_read_buffer(uint8_t *buffer, const size_t length) {
+  bool hardware;
+  size_t index;
+
+  hardware = raw3wire_transfer_begin();
+  for (index = 0; index < length; index++) {
+    buffer[index] = raw3wire_transfer_word(hardware, 0xFF);
+  }
+  raw3wire_transfer_end(hardware);
+}
+
+void raw3wire_transfer_buffer(const uint8_t *output, uint8_t *input,
+                              const size_t length) {
+  bool hardware;
+  size_t index;
+
+  hardware = raw3wire_transfer_begin();
+  for (index = 0; index < length; index++) {
+    input[index] = raw3wire_transfer_word(hardware, output[index]);
+  }
+  raw3wire_transfer_end(hardware);
+}
+
+
 void raw3wire_start_with_read(void) {
   setup_raw3wire(YES, !cs_line);
   MSG_SPI_CS_ENABLED;
@@ -23,10 +23,15 @@
 #ifdef BP_ENABLE_RAW_3WIRE_SUPPORT
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 uint16_t raw3wire_read(void);
 uint16_t raw3wire_write(const uint16_t value);
+void raw3wire_send_buffer(const uint8_t *buffer, const size_t length);
+void raw3wire_read_buffer(uint8_t *buffer, const size_t length);
+void raw3wire_transfer_buffer(const uint8_t *output, uint8_t *input,
+                              const size_t length);
 void raw3wire_start_with_read(void);
 void raw3wire_start(void);
 void raw3wire_stop(void);
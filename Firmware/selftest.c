@@ -24,53 +24,79 @@
 #include "core.h"
 
 /**
- * How many milliseconds to wait before reading all pins once set.
+ * How many milliseconds pins may take to settle once set, at most.
  */
 #define PIN_STATE_TEST_DELAY 100
 
 /**
- * How many milliseconds to wait before reading power pins status once set.
+ * How many milliseconds power rails may take to settle once set, at most.
  */
 #define PWR_STATE_TEST_DELAY 2
 
+/**
+ * How many microseconds to wait between two readings of a settling value.
+ *
+ * Checks read their value again until it is right or the delay above is
+ * up, so a healthy board only waits as long as it actually takes to settle.
+ */
+#define SETTLE_POLL_INTERVAL 20
+
+/**
+ * How many readings fit within the given settling delay, in milliseconds.
+ */
+#define SETTLE_POLLS(delay) ((delay) * (1000 / SETTLE_POLL_INTERVAL))
+
 /**
  * Checks whether the given test value matches the expected result, and prints
  * the result to the serial port.
  *
  * If the values do not match, the internal error counter gets incremented by
- * one.
+ * one and the check is marked as failed in the report.
  *
+ * @param[in] check the check being performed.
  * @param[in] obtained the value obtained by the test procedure.
  * @param[in] expected the value that was meant to be obtained.
  */
-void check_result(bool obtained, bool expected);
+void check_result(selftest_check_t check, bool obtained, bool expected);
 
 /**
- * Checks whether all pins are actually set to the same given state.
+ * Checks whether all pins are actually set to the same given state, once
+ * they settled or PIN_STATE_TEST_DELAY milliseconds went by.
  *
  * @todo Check AUX pin too on v3
  * @todo Check AUX1/AUX2 pins too on v4
  *
+ * @param[in] check the first of the four pin checks being performed.
  * @param[in] state the pin state to check pins against.
  */
-void perform_pins_state_test(bool state);
+void perform_pins_state_test(selftest_check_t check, bool state);
 
 /**
  * Takes an ADC measurement and checks whether the result is within the set
- * threshold range.
+ * threshold range, measuring again until it is or the delay is up.
  *
+ * @param[in] check the check being performed.
  * @param[in] channel the channel to read from.
  * @param[in] minimum_threshold the minimum acceptable value.
  * @param[in] maximum_threshold the maximum acceptable value.
+ * @param[in] settle_delay how many milliseconds the value may take to get
+ *                         within range.
  */
-void perform_adc_test(unsigned int channel, unsigned int minimum_threshold,
-                      unsigned int maximum_threshold);
+void perform_adc_test(selftest_check_t check, unsigned int channel,
+                      unsigned int minimum_threshold,
+                      unsigned int maximum_threshold,
+                      unsigned int settle_delay);
 
 /**
  * Detected errors counter.
  */
 static uint8_t errors;
 
+/**
+ * Check by check results of the current or last run.
+ */
+static selftest_report_t report;
+
 /**
  * Board configuration information.
  */
@@ -79,6 +105,8 @@ extern bus_pirate_configuration_t bus_pirate_configuration;
 uint8_t perform_selftest(bool show_progress, bool jumper_test) {
 
   errors = 0;
+  report.performed = 0;
+  report.failed = 0;
   if (!show_progress) {
     bus_pirate_configuration.quiet = true;
   }
@@ -104,7 +132,7 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   BP_AUX0 = HIGH;
   BP_AUX0_DIR = OUTPUT;
   BPMSG1165;
-  check_result(BP_AUX0, HIGH);
+  check_result(SELFTEST_CHECK_AUX0, BP_AUX0, HIGH);
   BP_AUX0 = LOW;
   BP_AUX0_DIR = INPUT;
 
@@ -113,27 +141,26 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   BP_LEDMODE = HIGH;
   BP_LEDMODE_DIR = OUTPUT;
   BPMSG1166;
-  check_result(BP_LEDMODE, HIGH);
+  check_result(SELFTEST_CHECK_MODE_LED, BP_LEDMODE, HIGH);
   BP_LEDMODE = LOW;
 
   /* Check whether the pull-up line goes HIGH when requested. */
 
   bp_enable_pullup();
   BPMSG1167;
-  check_result(BP_PULLUP, HIGH);
+  check_result(SELFTEST_CHECK_PULLUP_ON, BP_PULLUP, HIGH);
 
   /* Check whether the pull-up line goes LOW when requested. */
 
   bp_disable_pullup();
   BPMSG1168;
-  check_result(BP_PULLUP, LOW);
+  check_result(SELFTEST_CHECK_PULLUP_OFF, BP_PULLUP, LOW);
 
   /* Check whether the regulated voltage line goes HIGH when requested. */
 
   bp_enable_voltage_regulator();
-  bp_delay_ms(PWR_STATE_TEST_DELAY);
   BPMSG1169;
-  check_result(BP_VREGEN, HIGH);
+  check_result(SELFTEST_CHECK_VREG, BP_VREGEN, HIGH);
 
 #ifdef BUSPIRATEV4
 
@@ -143,20 +170,20 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
 
   /* Check the I2C flash clock line. */
   BPMSG1266;
-  check_result(BP_EE_SCL, HIGH);
+  check_result(SELFTEST_CHECK_EEPROM_SCL, BP_EE_SCL, HIGH);
 
   /* Check the I2C flash data line. */
   BPMSG1267;
-  check_result(BP_EE_SDA, HIGH);
+  check_result(SELFTEST_CHECK_EEPROM_SDA, BP_EE_SDA, HIGH);
 
   /* Check the I2C flash WRITE PROTECT line. */
   BPMSG1268;
-  check_result(BP_EE_WP, HIGH);
+  check_result(SELFTEST_CHECK_EEPROM_WP, BP_EE_WP, HIGH);
 
   /* Performs a more complete EEPROM test. */
 
   BPMSG1269;
-  check_result(eeprom_test(), true);
+  check_result(SELFTEST_CHECK_EEPROM, eeprom_test(), true);
 
 #endif /* BUSPIRATEV4 */
 
@@ -172,14 +199,16 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   /* Check whether the voltage coming in from the USB port is within range. */
 
   BPMSG1270;
-  perform_adc_test(BP_ADC_USB, V5L, V5H);
+  perform_adc_test(SELFTEST_CHECK_ADC_USB, BP_ADC_USB, V5L, V5H,
+                   PWR_STATE_TEST_DELAY);
 
 #endif /* BUSPIRATEV4 */
 
   /* Check whether the +5v rail output is within range. */
 
   BPMSG1171;
-  perform_adc_test(BP_ADC_5V0, V5L, V5H);
+  perform_adc_test(SELFTEST_CHECK_ADC_5V0, BP_ADC_5V0, V5L, V5H,
+                   PWR_STATE_TEST_DELAY);
 
 #ifdef BUSPIRATEV4
 
@@ -189,8 +218,8 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   BPMSG1171;
   bpSP;
   BPMSG1172;
-  bp_delay_ms(PWR_STATE_TEST_DELAY);
-  perform_adc_test(BP_ADC_VPU, V5L, V5H);
+  perform_adc_test(SELFTEST_CHECK_ADC_5V0_PULLUP, BP_ADC_VPU, V5L, V5H,
+                   PWR_STATE_TEST_DELAY);
   bp_disable_5v0_pullup();
 
   if (jumper_test) {
@@ -202,7 +231,8 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
      */
 
     BPMSG1174;
-    perform_adc_test(BP_ADC_PROBE, V33L, V33H);
+    perform_adc_test(SELFTEST_CHECK_ADC_PROBE, BP_ADC_PROBE, V33L, V33H,
+                     PWR_STATE_TEST_DELAY);
   }
 
   /*
@@ -211,7 +241,8 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
    */
 
   BPMSG1173;
-  perform_adc_test(BP_ADC_3V3, V33L, V33H);
+  perform_adc_test(SELFTEST_CHECK_ADC_3V3, BP_ADC_3V3, V33L, V33H,
+                   PWR_STATE_TEST_DELAY);
 
   /* Test the +3.3v pull-up line. */
 
@@ -219,8 +250,8 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   BPMSG1173;
   bpSP;
   BPMSG1172;
-  bp_delay_ms(PWR_STATE_TEST_DELAY);
-  perform_adc_test(BP_ADC_VPU, V33L, V33H);
+  perform_adc_test(SELFTEST_CHECK_ADC_3V3_PULLUP, BP_ADC_VPU, V33L, V33H,
+                   PWR_STATE_TEST_DELAY);
   bp_disable_3v3_pullup();
 
 #elif defined(BUSPIRATEV3)
@@ -234,13 +265,15 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
      */
 
     BPMSG1172;
-    perform_adc_test(BP_ADC_VPU, V5L, V5H);
+    perform_adc_test(SELFTEST_CHECK_ADC_5V0_PULLUP, BP_ADC_VPU, V5L, V5H,
+                     PWR_STATE_TEST_DELAY);
   }
 
   /* Check whether the +3.3v rail output is within range. */
 
   BPMSG1173;
-  perform_adc_test(BP_ADC_3V3, V33L, V33H);
+  perform_adc_test(SELFTEST_CHECK_ADC_3V3, BP_ADC_3V3, V33L, V33H,
+                   PWR_STATE_TEST_DELAY);
 
   if (jumper_test) {
 
@@ -251,7 +284,8 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
      */
 
     BPMSG1174;
-    perform_adc_test(BP_ADC_PROBE, V33L, V33H);
+    perform_adc_test(SELFTEST_CHECK_ADC_PROBE, BP_ADC_PROBE, V33L, V33H,
+                     PWR_STATE_TEST_DELAY);
   }
 
 #endif /* BUSPIRATEV4 || BUSPIRATEV3 */
@@ -267,8 +301,7 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   BPMSG1175;
   IODIR &= ~ALLIO;
   IOLAT |= ALLIO;
-  bp_delay_ms(PIN_STATE_TEST_DELAY);
-  perform_pins_state_test(HIGH);
+  perform_pins_state_test(SELFTEST_CHECK_PINS_HIGH, HIGH);
 
   /*
    * Pull all I/O pins LOW with pull-ups active and check the pins state
@@ -281,8 +314,7 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
     bp_enable_3v3_pullup();
     bp_enable_pullup();
   }
-  bp_delay_ms(PIN_STATE_TEST_DELAY);
-  perform_pins_state_test(LOW);
+  perform_pins_state_test(SELFTEST_CHECK_PINS_LOW, LOW);
 
   if (jumper_test) {
     /*
@@ -294,8 +326,7 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
 
     BPMSG1177;
     IODIR |= ALLIO;
-    bp_delay_ms(PIN_STATE_TEST_DELAY);
-    perform_pins_state_test(HIGH);
+    perform_pins_state_test(SELFTEST_CHECK_PINS_PULLED_UP, HIGH);
     bp_disable_3v3_pullup();
   }
 
@@ -327,44 +358,67 @@ uint8_t perform_selftest(bool show_progress, bool jumper_test) {
   return errors;
 }
 
-void perform_adc_test(unsigned int channel, unsigned int minimum_threshold,
-                      unsigned int maximum_threshold) {
+const selftest_report_t *selftest_last_report(void) { return &report; }
+
+void perform_adc_test(selftest_check_t check, unsigned int channel,
+                      unsigned int minimum_threshold,
+                      unsigned int maximum_threshold,
+                      unsigned int settle_delay) {
 
   unsigned int measurement;
+  unsigned int polls = SETTLE_POLLS(settle_delay);
 
   user_serial_transmit_character('(');
   measurement = bp_read_adc(channel);
+  while (((measurement <= minimum_threshold) ||
+          (measurement >= maximum_threshold)) &&
+         (polls > 0)) {
+    bp_delay_us(SETTLE_POLL_INTERVAL);
+    measurement = bp_read_adc(channel);
+    polls--;
+  }
   bp_write_voltage(measurement);
   user_serial_transmit_character(')');
   check_result(
+      check,
       ((measurement > minimum_threshold) && (measurement < maximum_threshold)),
       true);
 }
 
-void perform_pins_state_test(bool state) {
+void perform_pins_state_test(selftest_check_t check, bool state) {
+  unsigned int polls = SETTLE_POLLS(PIN_STATE_TEST_DELAY);
+
+  while (((BP_MOSI != state) || (BP_CLK != state) || (BP_MISO != state) ||
+          (BP_CS != state)) &&
+         (polls > 0)) {
+    bp_delay_us(SETTLE_POLL_INTERVAL);
+    polls--;
+  }
 
   /* Check MOSI pin state. */
   BPMSG1181;
-  check_result(BP_MOSI, state);
+  check_result(check, BP_MOSI, state);
 
   /* Check CLK pin state. */
   BPMSG1182;
-  check_result(BP_CLK, state);
+  check_result(check + 1, BP_CLK, state);
 
   /* Check MISO pin state. */
   BPMSG1183;
-  check_result(BP_MISO, state);
+  check_result(check + 2, BP_MISO, state);
 
   /* Check CS pin state. */
   BPMSG1184;
-  check_result(BP_CS, state);
+  check_result(check + 3, BP_CS, state);
 }
 
-void check_result(bool obtained, bool expected) {
+void check_result(selftest_check_t check, bool obtained, bool expected) {
+  report.performed |= 1UL << check;
   if (obtained == expected) {
     BPMSG1185;
   } else {
     BPMSG1186;
+    report.failed |= 1UL << check;
     errors++;
   }
 }
@@ -21,6 +21,46 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * Self-test checks, as bit positions in selftest_report_t masks.
+ *
+ * The pin checks take four bits each, for MOSI, CLK, MISO and CS in this
+ * order.
+ */
+typedef enum {
+  SELFTEST_CHECK_AUX0 = 0,
+  SELFTEST_CHECK_MODE_LED,
+  SELFTEST_CHECK_PULLUP_ON,
+  SELFTEST_CHECK_PULLUP_OFF,
+  SELFTEST_CHECK_VREG,
+  SELFTEST_CHECK_EEPROM_SCL,
+  SELFTEST_CHECK_EEPROM_SDA,
+  SELFTEST_CHECK_EEPROM_WP,
+  SELFTEST_CHECK_EEPROM,
+  SELFTEST_CHECK_ADC_USB,
+  SELFTEST_CHECK_ADC_5V0,
+  SELFTEST_CHECK_ADC_5V0_PULLUP,
+  SELFTEST_CHECK_ADC_PROBE,
+  SELFTEST_CHECK_ADC_3V3,
+  SELFTEST_CHECK_ADC_3V3_PULLUP,
+  SELFTEST_CHECK_PINS_HIGH,
+  SELFTEST_CHECK_PINS_LOW = SELFTEST_CHECK_PINS_HIGH + 4,
+  SELFTEST_CHECK_PINS_PULLED_UP = SELFTEST_CHECK_PINS_LOW + 4,
+  SELFTEST_CHECK_COUNT = SELFTEST_CHECK_PINS_PULLED_UP + 4
+} selftest_check_t;
+
+/**
+ * Which checks the last self-test run went through, and which of them
+ * failed.
+ */
+typedef struct {
+  /** One bit per selftest_check_t, set if the check was performed. */
+  uint32_t performed;
+
+  /** One bit per selftest_check_t, set if the check failed. */
+  uint32_t failed;
+} selftest_report_t;
+
 /**
  * Performs the board self-test procedure.
  *
@@ -33,4 +73,11 @@
  */
 uint8_t perform_selftest(bool show_progress, bool jumper_test);
 
+/**
+ * Gets the results of the last self-test run, check by check.
+ *
+ * @return the report of the last perform_selftest() call.
+ */
+const selftest_report_t *selftest_last_report(void);
+
 #endif /* !BP_SELFTEST_H */
\ No newline at end of file
@@ -0,0 +1,260 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "servo.h"
+
+#include "base.h"
+
+/**
+ * Timer #1 ticks per microsecond, with a 1:8 prescaler.
+ */
+#define SERVO_TICKS_PER_US ((FCY / 8) / 1000000UL)
+
+/**
+ * Servo frame length, in timer #1 ticks (20ms).
+ */
+#define SERVO_FRAME_TICKS (20000 * SERVO_TICKS_PER_US)
+
+/**
+ * Closest two falling edges can be, in timer #1 ticks (10us).  This has to
+ * stay above the worst case interrupt latency, as the next edge is set up
+ * from the interrupt handler of the previous one.
+ */
+#define SERVO_MINIMUM_EDGE_GAP (10 * SERVO_TICKS_PER_US)
+
+/**
+ * Priority of the timer #1 interrupt, above the host link so edges are not
+ * delayed by USB or UART servicing.
+ */
+#define SERVO_INTERRUPT_PRIORITY 5
+
+/**
+ * Port bit for each servo_channel_t entry.
+ */
+static const uint16_t SERVO_CHANNEL_PINS[SERVO_CHANNELS] = {AUX, CS, MOSI, CLK,
+                                                            MISO};
+
+/**
+ * All the port bits used as servo outputs.
+ */
+#define SERVO_OUTPUTS (AUX | CS | MOSI | CLK | MISO)
+
+/**
+ * A frame worth of output edges.
+ *
+ * Event 0 brings the active outputs high, the following events bring the
+ * outputs in their mask low.  Each event delay is how long to wait before the
+ * next one, the last delay closing the frame.
+ */
+typedef struct {
+  /** Outputs each event acts on. */
+  uint16_t masks[SERVO_CHANNELS + 1];
+
+  /** Timer #1 ticks from each event to the next. */
+  uint16_t delays[SERVO_CHANNELS + 1];
+
+  /** How many events are in use. */
+  uint8_t events;
+} servo_schedule_t;
+
+/**
+ * Controller state, shared with the timer #1 interrupt handler.
+ */
+static struct {
+  /** Double buffered schedules, one played and one being updated. */
+  servo_schedule_t schedules[2];
+
+  /** Index of the schedule being played. */
+  volatile uint8_t active;
+
+  /** Whether the other schedule is ready to take over at the next frame. */
+  volatile bool pending;
+
+  /** Event the interrupt handler is going to act on next. */
+  volatile uint8_t event;
+
+  /** Whether timer #1 is running the schedule. */
+  bool running;
+} servo_state;
+
+/**
+ * Turns pulse widths into a sorted edge schedule.
+ *
+ * @param[in] widths the pulse widths, as given to servo_controller_update().
+ * @param[out] schedule the schedule to fill.
+ */
+static void build_schedule(const uint16_t *widths, servo_schedule_t *schedule);
+
+void build_schedule(const uint16_t *widths, servo_schedule_t *schedule) {
+  uint16_t ticks[SERVO_CHANNELS];
+  uint16_t pins[SERVO_CHANNELS];
+  uint16_t previous;
+  uint8_t count;
+  uint8_t index;
+  uint8_t slot;
+
+  /* Insertion sort of the active outputs by pulse length. */
+  count = 0;
+  for (index = 0; index < SERVO_CHANNELS; index++) {
+    if (widths[index] == SERVO_PULSE_OFF) {
+      continue;
+    }
+    slot = count;
+    while ((slot > 0) &&
+           (ticks[slot - 1] > widths[index] * SERVO_TICKS_PER_US)) {
+      ticks[slot] = ticks[slot - 1];
+      pins[slot] = pins[slot - 1];
+      slot--;
+    }
+    ticks[slot] = widths[index] * SERVO_TICKS_PER_US;
+    pins[slot] = SERVO_CHANNEL_PINS[index];
+    count++;
+  }
+
+  schedule->masks[0] = 0;
+  for (index = 0; index < count; index++) {
+    schedule->masks[0] |= pins[index];
+  }
+
+  /* One falling edge per distinct pulse length, close ones merged. */
+  schedule->events = 1;
+  previous = 0;
+  for (index = 0; index < count; index++) {
+    if ((schedule->events > 1) &&
+        ((ticks[index] - previous) < SERVO_MINIMUM_EDGE_GAP)) {
+      schedule->masks[schedule->events - 1] |= pins[index];
+      continue;
+    }
+    schedule->delays[schedule->events - 1] = ticks[index] - previous;
+    schedule->masks[schedule->events] = pins[index];
+    schedule->events++;
+    previous = ticks[index];
+  }
+  schedule->delays[schedule->events - 1] = SERVO_FRAME_TICKS - previous;
+}
+
+bool servo_controller_update(const uint16_t *widths) {
+  servo_schedule_t *schedule;
+  uint8_t index;
+  bool active;
+
+  active = false;
+  for (index = 0; index < SERVO_CHANNELS; index++) {
+    if (widths[index] == SERVO_PULSE_OFF) {
+      continue;
+    }
+    if ((widths[index] < SERVO_MINIMUM_PULSE) ||
+        (widths[index] > SERVO_MAXIMUM_PULSE)) {
+      return false;
+    }
+    active = true;
+  }
+
+  if (!active) {
+    servo_controller_stop();
+    return true;
+  }
+
+  if (!servo_state.running) {
+    build_schedule(widths, &servo_state.schedules[0]);
+    servo_state.active = 0;
+    servo_state.pending = false;
+    servo_state.event = 0;
+
+    IOLAT &= ~SERVO_OUTPUTS;
+    IODIR &= ~SERVO_OUTPUTS;
+
+    /*
+     * T1CON - TIMER 1 CONTROL REGISTER
+     *
+     * MSB
+     * 0-0-------01--0-
+     * | |       ||  |
+     * | |       ||  +--- TCS:   Internal clock (Fosc/2).
+     * | |       ++------ TCKPS: 1:8 Prescaler.
+     * | +--------------- TSIDL: Continue module operation in idle mode.
+     * +----------------- TON:   Timer OFF.
+     */
+    T1CON = 0b01 << _T1CON_TCKPS_POSITION;
+    TMR1 = 0;
+
+    /* The first interrupt starts the first frame right away. */
+    PR1 = 1;
+    IFS0bits.T1IF = OFF;
+    IPC0bits.T1IP = SERVO_INTERRUPT_PRIORITY;
+    IEC0bits.T1IE = ON;
+    servo_state.running = true;
+    T1CONbits.TON = ON;
+    return true;
+  }
+
+  /* Wait for the previous update to be picked up before reusing its slot. */
+  while (servo_state.pending) {
+  }
+
+  schedule = &servo_state.schedules[servo_state.active ^ 1];
+  build_schedule(widths, schedule);
+  servo_state.pending = true;
+
+  return true;
+}
+
+void servo_controller_stop(void) {
+  if (!servo_state.running) {
+    return;
+  }
+
+  T1CON = 0x0000;
+  IEC0bits.T1IE = OFF;
+  IFS0bits.T1IF = OFF;
+  IPC0bits.T1IP = 0;
+  servo_state.running = false;
+  servo_state.pending = false;
+
+  IOLAT &= ~SERVO_OUTPUTS;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T1Interrupt(void) {
+  const servo_schedule_t *schedule;
+  uint8_t event;
+
+  IFS0bits.T1IF = OFF;
+
+  event = servo_state.event;
+  if (event == 0) {
+    /* Frame start, switch to the updated schedule if there is one. */
+    if (servo_state.pending) {
+      servo_state.active ^= 1;
+      servo_state.pending = false;
+    }
+    schedule = &servo_state.schedules[servo_state.active];
+    IOLAT |= schedule->masks[0];
+  } else {
+    schedule = &servo_state.schedules[servo_state.active];
+    IOLAT &= ~schedule->masks[event];
+  }
+
+  /* The timer restarted from zero on the match that got us here. */
+  PR1 = schedule->delays[event] - 1;
+  if (TMR1 >= PR1) {
+    /* Running late, have the next event fire right away. */
+    TMR1 = PR1 - 1;
+  }
+
+  event++;
+  servo_state.event = (event == schedule->events) ? 0 : event;
+}
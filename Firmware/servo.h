@@ -0,0 +1,80 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef BP_SERVO_H
+#define BP_SERVO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * How many servo outputs the controller drives.
+ */
+#define SERVO_CHANNELS 5
+
+/**
+ * Shortest servo pulse accepted, in microseconds.
+ */
+#define SERVO_MINIMUM_PULSE 500
+
+/**
+ * Longest servo pulse accepted, in microseconds.
+ */
+#define SERVO_MAXIMUM_PULSE 2500
+
+/**
+ * Pulse width value that turns a servo output off.
+ */
+#define SERVO_PULSE_OFF 0
+
+/**
+ * Servo outputs, in the order the pulse widths are given in.
+ */
+typedef enum {
+  SERVO_CHANNEL_AUX = 0,
+  SERVO_CHANNEL_CS,
+  SERVO_CHANNEL_MOSI,
+  SERVO_CHANNEL_CLK,
+  SERVO_CHANNEL_MISO
+} servo_channel_t;
+
+/**
+ * Sets the pulse widths of all servo outputs at once.
+ *
+ * Every 20ms frame all active outputs go high together, and timer #1 then
+ * walks a schedule of falling edges sorted by pulse width.  The new widths
+ * take effect at the start of the next frame, so all outputs change in the
+ * same frame.  The controller is started by the first call with at least one
+ * active output, and stopped when none are left.
+ *
+ * Pulses ending less than 10us apart share the earliest falling edge, which
+ * is well under a degree of travel.
+ *
+ * @param[in] widths SERVO_CHANNELS pulse widths in microseconds, ordered as
+ * servo_channel_t, each either SERVO_PULSE_OFF or between SERVO_MINIMUM_PULSE
+ * and SERVO_MAXIMUM_PULSE inclusive.
+ *
+ * @return true if the widths were applied, false if any was out of range.
+ */
+bool servo_controller_update(const uint16_t *widths);
+
+/**
+ * Stops the servo controller, if it is running, bringing all its outputs low.
+ */
+void servo_controller_stop(void);
+
+#endif /* BP_SERVO_H */
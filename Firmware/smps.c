@@ -21,44 +21,181 @@
 
 #ifdef BUSPIRATEV4
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "base.h"
 
+/**
+ * How many times per second the regulation loop runs.
+ */
+#define SMPS_CONTROL_RATE_HZ 10000UL
+
+/**
+ * Timer #3 ticks per control period, with a 1:8 prescaler.
+ */
+#define SMPS_CONTROL_PERIOD_TICKS ((FCY / 8) / SMPS_CONTROL_RATE_HZ)
+
+/**
+ * PWM period, 125kHz off the system clock.
+ */
+#define SMPS_PWM_PERIOD 0x7F
+
+/**
+ * Highest duty cycle the loop may ask for, what the feed forward formula
+ * gives for the highest voltage that can be requested.
+ */
+#define SMPS_DUTY_MAX 112
+
+/**
+ * Fractional bits of the controller terms, the duty cycle is the integer
+ * part.
+ */
+#define SMPS_PI_SHIFT 8
+
+/**
+ * Proportional gain, duty steps per ADC count of error in Q8 (1/8).
+ */
+#define SMPS_PI_KP 32
+
+/**
+ * Integral gain, duty steps per ADC count of error and control period in Q8
+ * (1/64).
+ */
+#define SMPS_PI_KI 4
+
+/**
+ * ADC counts the setpoint moves towards the target each control period
+ * while soft-starting, about 100ms for the whole range.
+ */
+#define SMPS_SOFT_START_STEP 1
+
+/**
+ * ADC counts above the setpoint at which switching stops right away,
+ * whatever the controller output.
+ */
+#define SMPS_OVERVOLTAGE_MARGIN 32
+
 /**
  * Switched power mode supply module state data holder.
+ *
+ * Everything but voltage_out is owned by the ADC interrupt once the loop is
+ * running.
  */
 typedef struct {
   /**
-   * The requested output voltage from the power supply.
+   * The requested output voltage from the power supply, in ADC counts.
    */
   uint16_t voltage_out;
 
+  /**
+   * The setpoint the loop regulates to, ramping up to voltage_out.
+   */
+  volatile uint16_t voltage_setpoint;
+
   /**
    * The last voltage output reading coming in from the power supply adapter
    * module.
    */
-  uint16_t voltage_reading;
+  volatile uint16_t voltage_reading;
 
   /**
-   * The requested PWM duty cycle for performing the mode switching.
+   * Integral term of the controller, in duty cycle steps with SMPS_PI_SHIFT
+   * fractional bits.
    */
-  uint8_t pwm_duty_cycle;
-} __attribute__((packed)) smps_state_t;
+  int32_t integral;
+
+  /**
+   * The PWM duty cycle currently applied.
+   */
+  volatile uint8_t pwm_duty_cycle;
+
+  /**
+   * Whether the setpoint still has to be taken from the first reading.
+   */
+  volatile bool starting;
+} smps_state_t;
 
 /**
  * The switched mode power supply module state.
  */
 static smps_state_t smps_state = {0};
 
-void smps_start(unsigned int requested_voltage) {
+/**
+ * Runs one step of the regulation loop on a fresh reading.
+ *
+ * @param[in] reading the output voltage, in ADC counts.
+ */
+static void smps_regulate(const uint16_t reading);
+
+/**
+ * ADC interrupt handler, registered while the regulation loop runs.
+ */
+static void smps_interrupt(void);
+
+void smps_regulate(const uint16_t reading) {
+  uint16_t setpoint;
+  int16_t error;
+  int32_t duty;
+
+  smps_state.voltage_reading = reading;
+
+  /* Soft start from wherever the output sits before switching. */
+  if (smps_state.starting) {
+    smps_state.starting = false;
+    smps_state.voltage_setpoint =
+        (reading < smps_state.voltage_out) ? reading : smps_state.voltage_out;
+  }
+  setpoint = smps_state.voltage_setpoint;
+  if (setpoint < smps_state.voltage_out) {
+    setpoint += SMPS_SOFT_START_STEP;
+    if (setpoint > smps_state.voltage_out) {
+      setpoint = smps_state.voltage_out;
+    }
+    smps_state.voltage_setpoint = setpoint;
+  }
+
+  /* Turn PWM off if it goes out of spec. */
+  if (reading > setpoint + SMPS_OVERVOLTAGE_MARGIN) {
+    smps_state.integral = 0;
+    smps_state.pwm_duty_cycle = 0;
+    OC5R = 0;
+    return;
+  }
+
+  error = (int16_t)setpoint - (int16_t)reading;
+  duty = smps_state.integral + (int32_t)error * SMPS_PI_KP;
+
+  /* Only integrate while the output is not clamped the same way. */
+  if (duty > ((int32_t)SMPS_DUTY_MAX << SMPS_PI_SHIFT)) {
+    duty = (int32_t)SMPS_DUTY_MAX << SMPS_PI_SHIFT;
+    if (error < 0) {
+      smps_state.integral += (int32_t)error * SMPS_PI_KI;
+    }
+  } else if (duty < 0) {
+    duty = 0;
+    if (error > 0) {
+      smps_state.integral += (int32_t)error * SMPS_PI_KI;
+    }
+  } else {
+    smps_state.integral += (int32_t)error * SMPS_PI_KI;
+  }
+
+  /* Clamped to SMPS_DUTY_MAX above, fits in the duty cycle register. */
+  smps_state.pwm_duty_cycle = (uint8_t)(duty >> SMPS_PI_SHIFT);
+  OC5R = smps_state.pwm_duty_cycle;
+}
 
-  /* Get a 7-bits duty cycle value for switching operations. */
-  smps_state.pwm_duty_cycle = 128 - (64000 / requested_voltage);
+void smps_start(unsigned int requested_voltage) {
 
   /* Rescale the voltage to something appropriate for the ADC to compare
    * against. */
   smps_state.voltage_out = requested_voltage * 45 / 58;
+  smps_state.voltage_setpoint = 0;
+  smps_state.voltage_reading = 0;
+  smps_state.integral = 0;
+  smps_state.pwm_duty_cycle = 0;
+  smps_state.starting = true;
 
   /* Assign the AUX pin to Output Compare 5 */
   BP_AUX1_RPOUT = OC5_IO;
@@ -66,20 +203,40 @@ void smps_start(unsigned int requested_voltage) {
   /* Set the ADC to read from the ADC pin. */
   AD1CHS = BP_ADC_PROBE;
 
+  /*
+   * T3CON - TIMER 3 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------01---0-
+   * | |      ||   |
+   * | |      ||   +---- TCS:   Internal clock (Fosc/2).
+   * | |      ++-------- TCKPS: 1:8 Prescaler.
+   * | +---------------- TSIDL: Continue module operation in idle mode.
+   * +------------------ TON:   Timer OFF.
+   */
+  T3CON = 0x0010;
+  TMR3 = 0;
+  PR3 = SMPS_CONTROL_PERIOD_TICKS - 1;
+
+  /* One conversion per interrupt, into ADC1BUF0. */
+  AD1CON2 = 0x0000;
+
+  /* Conversions are started by timer #3, sampling restarts right after. */
+  AD1CON1bits.SSRC = 0b010;
+  AD1CON1bits.ASAM = ON;
+
   /* Clear ADC interrupt flag. */
   IFS0bits.AD1IF = OFF;
 
   /* Enable ADC interrupt. */
+  bp_set_adc_interrupt_handler(smps_interrupt);
   IEC0bits.AD1IE = ON;
 
-  /* Enable auto sampling. */
-  AD1CON1bits.ASAM = ON;
-
-  /* Set the duty cycle for the PWM. */
-  OC5R = smps_state.pwm_duty_cycle;
+  /* Start with the switch open, the loop takes it from there. */
+  OC5R = 0;
 
   /* Set the time period for the PWM (currently 125kHz). */
-  OC5RS = 0x7F;
+  OC5RS = SMPS_PWM_PERIOD;
 
   /*
    * Set the output comparator as its synchronization source to enter PWM mode
@@ -116,18 +273,28 @@ void smps_start(unsigned int requested_voltage) {
   OC5CON1 = 0x1C06;
 
   /* Turn ADC on. */
-  AD1CON1bits.ADON = ON;
+  bp_enable_adc();
+
+  /* Start the control loop. */
+  T3CONbits.TON = ON;
 }
 
 void smps_stop(void) {
+  /* Stop the control loop. */
+  T3CON = 0x0000;
+
   /* Turn the ADC off. */
-  AD1CON1bits.ADON = OFF;
+  bp_disable_adc();
 
   /* Disable ADC interrupts. */
   IEC0bits.AD1IE = OFF;
+  IFS0bits.AD1IF = OFF;
+  bp_set_adc_interrupt_handler(NULL);
 
-  /* Disable auto sampling. */
+  /* Put the ADC back as bp_reset_board_state() leaves it. */
   AD1CON1bits.ASAM = OFF;
+  AD1CON1bits.SSRC = 0b111;
+  AD1CON2 = 0x0000;
 
   /* Set 0% as the PWM duty cycle. */
   OC5R = 0;
@@ -170,6 +337,10 @@ void smps_stop(void) {
 
   /* Free the AUX pin from the Output Comparator unit #5. */
   BP_AUX1_RPOUT = NULL_IO;
+
+  smps_state.voltage_out = 0;
+  smps_state.voltage_setpoint = 0;
+  smps_state.pwm_duty_cycle = 0;
 }
 
 void smps_adc(void) {
@@ -180,16 +351,28 @@ void smps_adc(void) {
   user_serial_transmit_character(smps_state.voltage_reading);
 }
 
-void __attribute__((interrupt, no_auto_psv)) _ADC1Interrupt() {
-
-  /* Clear ADC interrupt flag. */
-  IFS0bits.AD1IF = OFF;
+void smps_status(void) {
+  uint16_t setpoint;
+  uint16_t reading;
+  uint8_t duty_cycle;
 
-  /* Read data from the ADC. */
-  smps_state.voltage_reading = ADC1BUF0;
+  /* Take a consistent snapshot, the interrupt updates all three. */
+  IEC0bits.AD1IE = OFF;
+  setpoint = smps_state.voltage_setpoint;
+  reading = smps_state.voltage_reading;
+  duty_cycle = smps_state.pwm_duty_cycle;
+  IEC0bits.AD1IE = (smps_state.voltage_out != 0) ? ON : OFF;
+
+  user_serial_transmit_character(setpoint >> 8);
+  user_serial_transmit_character(setpoint);
+  user_serial_transmit_character(reading >> 8);
+  user_serial_transmit_character(reading);
+  user_serial_transmit_character(duty_cycle);
+}
 
-  /* Turn PWM off if it goes out of spec. */
-  OC5R = (ADC1BUF0 > smps_state.voltage_out) ? 0 : smps_state.pwm_duty_cycle;
+void smps_interrupt(void) {
+  /* Timer #3 paces the conversions, so this runs at SMPS_CONTROL_RATE_HZ. */
+  smps_regulate(ADC1BUF0);
 }
 
 #endif /* BUSPIRATEV4 */
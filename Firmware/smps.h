@@ -28,6 +28,10 @@
  * Enables operation of a connected switched mode power supply board connected
  * to the Bus Pirate v4.
  *
+ * The output is regulated from the ADC interrupt, with conversions paced by
+ * timer #3 so the loop runs at a fixed rate whatever the main loop does.
+ * The setpoint ramps up from the input voltage to soft-start the supply.
+ *
  * @param[in] requested_voltage The voltage that should be output by the
  * external board.
  */
@@ -44,6 +48,14 @@ void smps_stop(void);
  */
 void smps_adc(void);
 
+/**
+ * Outputs the regulation loop state to the serial port: the current
+ * setpoint and the last output voltage reading, both in ADC counts as
+ * big-endian 16-bits integers, followed by the PWM duty cycle out of 127.
+ * All zeroes while the supply is stopped.
+ */
+void smps_status(void);
+
 #endif /* BUSPIRATEV4 */
 
 #endif /* BP_ENABLE_SMPS_SUPPORT */
@@ -21,8 +21,16 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "buffer_arena.h"
+#include "compressed_read.h"
 #include "core.h"
 #include "proc_menu.h"
+#include "profiling.h"
+#include "telemetry.h"
+
+#ifdef BP_SPI_ENABLE_FLASH_ENGINE
+#include "spi_flash.h"
+#endif /* BP_SPI_ENABLE_FLASH_ENGINE */
 
 /* Pin assignments. */
 
@@ -46,6 +54,7 @@ extern bus_pirate_configuration_t bus_pirate_configuration;
 typedef enum {
   SPI_COMMAND_BASE = 0,
   SPI_COMMAND_READ_DATA,
+  SPI_COMMAND_TELEMETRY,
   SPI_COMMAND_CONFIGURE_PERIPHERALS = 4,
   SPI_COMMAND_SET_PULLUPS,
   SPI_COMMAND_SET_SPEED,
@@ -60,8 +69,15 @@ typedef enum {
   SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS,
   SPI_BASE_COMMAND_WRITE_AND_READ_WITHOUT_CS,
   SPI_BASE_COMMAND_EXTENDED_AVR_COMMAND,
+  SPI_BASE_COMMAND_STREAMING_WRITE_AND_READ,
+  SPI_BASE_COMMAND_FLASH_ENGINE,
+  SPI_BASE_COMMAND_RUN_SCRIPT,
+  SPI_BASE_COMMAND_EMULATE_FLASH,
+  SPI_BASE_COMMAND_SET_WORD_SIZE,
+  SPI_BASE_COMMAND_TRAFFIC_STATISTICS = 12,
   SPI_BASE_COMMAND_SNIFF_ALL_TRAFFIC = 13,
-  SPI_BASE_COMMAND_SNIFF_WHEN_CS_LOW
+  SPI_BASE_COMMAND_SNIFF_WHEN_CS_LOW = 14,
+  SPI_BASE_COMMAND_SNIFF_FRAMED = 15
 } spi_base_command_t;
 
 typedef enum {
@@ -116,6 +132,11 @@ typedef enum {
  */
 #define SPI_TRANSITION_FROM_ACTIVE_TO_IDLE 1
 
+/**
+ * How many bytes the SPI enhanced buffer FIFOs can hold.
+ */
+#define SPI_FIFO_DEPTH 8
+
 /**
  * Set up the SPI interfaces to operate in slave mode.
  */
@@ -126,10 +147,20 @@ static void spi_slave_enable(void);
  */
 static void spi_slave_disable(void);
 
+/**
+ * Adds the SPI slaves showing a receive overflow to the telemetry counters,
+ * and tells the host data was lost.  The caller clears SPIROV.
+ */
+static inline void spi_telemetry_count_overruns(void);
+
 /**
  * Sniffs data coming through the SPI bus.
  *
  * @param[in] trigger       flag indicating what triggers data sniffing.
+ * In binary mode a success code is sent before any data, or a failure code if
+ * there is no room for the serial port ringbuffer.
+ *
+ * @param[in] trigger       flag indicating what triggers data sniffing.
  * @param[in] terminal_mode whether data is meant to be seen by the user via the
  *                          serial port interface.
  *
@@ -138,497 +169,2096 @@ static void spi_slave_disable(void);
  */
 static void spi_sniffer(bool trigger, bool terminal_mode);
 
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+
 /**
- * Engages the CS line.
+ * Size of the interrupt-driven sniffer capture ring, must be a power of two.
+ */
+#define SPI_CAPTURE_RING_SIZE 512
+
+/**
+ * Mask to wrap indices into the interrupt-driven sniffer capture ring.
+ */
+#define SPI_CAPTURE_RING_MASK (SPI_CAPTURE_RING_SIZE - 1)
+
+/**
+ * Interrupt-driven sniffer capture ring.
  *
- * @param[in] write_with_read flag indicating if data writes will have a
- *                            subsequent read operation or not.
+ * The SPI1 receive interrupt is the only producer, and the main loop is the
+ * only consumer.  Each side only ever writes its own index, so no locking is
+ * needed as 16 bits accesses are atomic.
  */
-static void engage_spi_cs(bool write_with_read);
+typedef struct {
 
-#ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
+  /** Next slot to write, only updated by the interrupt handler. */
+  volatile uint16_t head;
+
+  /** Next slot to read, only updated by the main loop. */
+  volatile uint16_t tail;
+
+  /** Whether a CS frame start marker has been emitted and not closed yet. */
+  volatile bool frame_open;
+
+  /** Set when captured data had to be dropped for lack of space. */
+  volatile bool overflow;
+
+  /**
+   * Captured data, already in the binary sniffer output format.  Taken from
+   * the buffer arena for as long as the sniffer runs.
+   */
+  uint8_t *data;
+
+} spi_capture_ring_t;
 
 /**
- * Extended AVR Binary I/O command for no operations.
+ * The interrupt-driven sniffer capture ring.
  */
-#define BINARY_IO_SPI_AVR_COMMAND_NOOP 0
+static spi_capture_ring_t spi_capture_ring;
 
 /**
- * Extended AVR Binary I/O command for obtaining the protocol version.
+ * Sniffs data coming through the SPI bus using the SPI1 receive interrupt,
+ * sending out the same format used by the binary mode polling sniffer.  Falls
+ * back to the polling sniffer if there is no room for the capture ring.  A
+ * success code is sent before any data, or a failure code if there is no room
+ * for the serial port ringbuffer past the capture ring.
+ *
+ * @param[in] trigger flag indicating what triggers data sniffing.
+ *
+ * @see SPI_SNIFF_ON_CS_LOW
+ * @see SPI_SNIFF_ALWAYS
  */
-#define BINARY_IO_SPI_AVR_COMMAND_VERSION 1
+static void spi_interrupt_sniffer(bool trigger);
 
 /**
- * Extended AVR Binary I/O command for performing a bulk read.
+ * Moves every byte pair waiting in the SPI receive FIFOs into the capture
+ * ring.  Must be called either from the interrupt handler or with the SPI1
+ * interrupt disabled.
  */
-#define BINARY_IO_SPI_AVR_COMMAND_BULK_READ 2
+static void spi_capture_fifo(void);
 
 /**
- * Extended AVR Binary I/O protocol version.
+ * Appends a byte to the capture ring.  The caller must have checked there is
+ * enough room for it.
+ *
+ * @param[in] value the byte to append.
  */
-#define BINARY_IO_SPI_AVR_SUPPORT_VERSION 0x0001
+static inline void spi_capture_ring_push(const uint8_t value);
 
-#define AVR_FETCH_LOW_BYTE_COMMAND 0x20
-#define AVR_FETCH_HIGH_BYTE_COMMAND 0x28
+/**
+ * Traffic statistics sub-command, stop counting.
+ */
+#define SPI_STATISTICS_COMMAND_STOP 0x00
 
 /**
- * Handle an incoming extended binary I/O AVR SPI command.
+ * Traffic statistics sub-command, send the counters.
  */
-static void handle_extended_avr_command(void);
+#define SPI_STATISTICS_COMMAND_READ 0x01
 
-#endif /* BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS */
+/**
+ * Traffic statistics sub-command, send the counters and zero them.
+ */
+#define SPI_STATISTICS_COMMAND_READ_AND_CLEAR 0x02
 
 /**
- * SPI protocol state structure.
+ * Traffic statistics reply flag set if a receive overrun made some frames be
+ * left out since the previous read.
+ */
+#define SPI_STATISTICS_FLAG_OVERRUN 0x01
+
+/**
+ * How many opcodes traffic statistics are kept for, one per first byte value.
+ */
+#define SPI_STATISTICS_OPCODES 256
+
+/**
+ * Traffic counters for frames starting with a given opcode.
  */
 typedef struct {
 
-  /**
-   * Clock polarity.
-   *
-   * @see SPI_CLOCK_IDLE_LOW
-   * @see SPI_CLOCK_IDLE_HIGH
-   */
-  uint8_t clock_polarity : 1;
+  /** CS frames whose first MOSI byte was the opcode. */
+  uint32_t frames;
 
-  /**
-   * Clock edge.
-   *
-   * @see SPI_TRANSITION_FROM_IDLE_TO_ACTIVE
-   * @see SPI_TRANSITION_FROM_ACTIVE_TO_IDLE
-   */
-  uint8_t clock_edge : 1;
+  /** Bytes clocked in those frames, the opcode included. */
+  uint32_t bytes;
 
-  /**
-   * Data sample timing.
-   *
-   * @see SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE
-   * @see SPI_SAMPLING_ON_DATA_OUTPUT_END
-   */
-  uint8_t data_sample_timing : 1;
+} spi_traffic_counters_t;
 
-  /** CS line state. */
-  uint8_t cs_line_state : 1;
+/**
+ * Traffic statistics state.
+ *
+ * The counters are only updated by the SPI1 receive interrupt, and by the
+ * main loop with that interrupt disabled.
+ */
+static struct {
 
-} spi_state_t;
+  /** Per opcode counters while gathering statistics, NULL otherwise. */
+  spi_traffic_counters_t *counters;
+
+  /** Whether the first byte of the current CS frame was seen. */
+  volatile bool frame_open;
+
+  /** Whether the rest of the current CS frame is to be ignored. */
+  volatile bool discarding;
+
+  /** Set when a receive overrun happened since the previous read. */
+  bool overrun;
+
+  /** First MOSI byte of the current CS frame. */
+  uint8_t opcode;
+
+} spi_statistics;
 
 /**
- * The SPI protocol state.
+ * Counts bus traffic per opcode until told to stop.
+ *
+ * Both SPI modules listen as slaves with CS enabled, as for the sniffers,
+ * and the SPI1 receive interrupt updates a set of spi_traffic_counters_t for
+ * each possible first byte of a CS frame.  A failure code is sent if the
+ * counters do not fit in the buffer arena, a success code otherwise.
+ *
+ * The host then drives the counting with SPI_STATISTICS_COMMAND_* bytes.
+ * Read requests are answered with a success code, the
+ * SPI_STATISTICS_FLAG_* bits, how many opcodes have been seen (big endian),
+ * and for each of them the opcode and its frames and bytes counters (big
+ * endian).  Opcodes never seen are left out.  A stop request is answered
+ * with a success code once the bus is set up again.
+ *
+ * Frame ends are noticed by polling CS, which goes on while replies are
+ * sent.  A frame with an overrun is left out from the overrun onwards.
  */
-static spi_state_t spi_state = {0};
+static void spi_traffic_statistics(void);
 
 /**
- * Available SPI bus speeds.
+ * Sends the traffic counters of every opcode seen so far.
+ *
+ * @param[in] clear whether to zero the counters once sent.
  */
-static const uint8_t spi_bus_speed[] = {
-    0b00000000, /*  31 kHz - Primary prescaler 64:1 / Secondary prescaler 8:1 */
-    0b00011000, /* 125 kHz - Primary prescaler 64:1 / Secondary prescaler 2:1 */
-    0b00011100, /* 250 kHz - Primary prescaler 64:1 / Secondary prescaler 1:1 */
-    0b00011101, /*   1 MHz - Primary prescaler 16:1 / Secondary prescaler 1:1 */
-    0b00001100, /*  50 kHz - Primary prescaler 64:1 / Secondary prescaler 5:1 */
-    0b00010110, /* 1.3 MHz - Primary prescaler  4:1 / Secondary prescaler 3:1 */
-    0b00011010, /*   2 MHz - Primary prescaler  4:1 / Secondary prescaler 2:1 */
-    0b00001011, /* 2.6 MHz - Primary prescaler  1:1 / Secondary prescaler 6:1 */
-    0b00001111, /* 3.2 MHz - Primary prescaler  1:1 / Secondary prescaler 5:1 */
-    0b00011110, /*   4 MHz - Primary prescaler  4:1 / Secondary prescaler 1:1 */
-    0b00010111, /* 5.3 MHz - Primary prescaler  1:1 / Secondary prescaler 3:1 */
-    0b00011011  /*   8 MHz - Primary prescaler  1:1 / Secondary prescaler 2:1 */
-};
+static void spi_traffic_statistics_send(const bool clear);
 
-void engage_spi_cs(bool write_with_read) {
-  mode_configuration.write_with_read = write_with_read;
-  SPICS = !spi_state.cs_line_state;
-  if (spi_state.cs_line_state) {
-    user_serial_transmit_character('/');
-  }
-  MSG_SPI_CS_ENABLED;
-}
+/**
+ * Sends a byte to the serial port, keeping track of frame ends and overruns
+ * while waiting to do so.
+ *
+ * @param[in] value the byte to send.
+ */
+static void spi_traffic_statistics_transmit(const uint8_t value);
 
-inline void spi_start_with_read(void) { engage_spi_cs(ON); }
+/**
+ * Closes the current frame if CS went high, and recovers from receive
+ * overruns.
+ */
+static void spi_traffic_statistics_service(void);
 
-inline void spi_start(void) { engage_spi_cs(OFF); }
+/**
+ * Counts every byte pair waiting in the SPI receive FIFOs.  Must be called
+ * either from the interrupt handler or with the SPI1 interrupt disabled.
+ */
+static void spi_traffic_statistics_fifo(void);
 
-void spi_stop(void) {
-  SPICS = spi_state.cs_line_state;
-  if (spi_state.cs_line_state) {
-    user_serial_transmit_character('/');
-  }
-  MSG_SPI_CS_DISABLED;
-}
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
 
-inline uint16_t spi_read(void) { return spi_write_byte(0xFF); }
+/**
+ * Framed sniffer option flag asking to only sniff data when the CS line is low.
+ */
+#define SPI_SNIFFER_OPTION_CS_LOW_ONLY 0b00000001
 
-uint16_t spi_write(const uint16_t value) {
-  uint8_t data;
+/**
+ * Framed sniffer option flag asking to only record CS frames whose first MOSI
+ * byte matches an opcode filter.  The opcode and the mask of the opcode bits
+ * to compare follow the options byte.
+ */
+#define SPI_SNIFFER_OPTION_OPCODE_FILTER 0b00000010
 
-  data = spi_write_byte(value);
-  return mode_configuration.write_with_read ? data : 0;
-}
+/**
+ * Mask for all the options accepted by the framed sniffer.
+ */
+#define SPI_SNIFFER_OPTIONS_MASK                                               \
+  (SPI_SNIFFER_OPTION_CS_LOW_ONLY | SPI_SNIFFER_OPTION_OPCODE_FILTER)
 
-void spi_print_settings(void) {
-  MSG_SPI_MODE_HEADER_START;
-  bp_write_dec_byte(mode_configuration.speed + 1);
-  bpSP;
-  bp_write_dec_byte(spi_state.clock_polarity);
-  bpSP;
-  bp_write_dec_byte(spi_state.clock_edge);
-  bpSP;
-  bp_write_dec_byte(spi_state.data_sample_timing);
-  bpSP;
-  bp_write_dec_byte(spi_state.cs_line_state);
-  bpSP;
-  bp_write_dec_byte(mode_configuration.high_impedance);
-  MSG_MODE_HEADER_END;
-}
+/**
+ * Framed sniffer record flag, the CS line went low before this byte pair.
+ */
+#define SPI_SNIFFER_RECORD_CS_ASSERTED 0x8000
 
-void spi_setup_prepare(void) {
-  bool user_prompt;
-  int spi_speed;
-  int spi_clock_polarity;
-  int spi_clock_edge;
-  int spi_data_sampling;
-  int spi_enabled;
-  int spi_cs_line_state;
+/**
+ * Framed sniffer record flag, the CS line went high.  No data follows.
+ */
+#define SPI_SNIFFER_RECORD_CS_RELEASED 0x4000
 
-  consumewhitechars();
-  spi_speed = getint();
-  consumewhitechars();
-  spi_clock_polarity = getint();
-  consumewhitechars();
-  spi_clock_edge = getint();
-  consumewhitechars();
-  spi_data_sampling = getint();
-  consumewhitechars();
-  spi_cs_line_state = getint();
-  consumewhitechars();
-  spi_enabled = getint();
+/**
+ * Framed sniffer record flag, the previous byte pair was seen again as many
+ * times as indicated by the record data.
+ */
+#define SPI_SNIFFER_RECORD_REPEAT 0x2000
 
-  user_prompt = !(((spi_speed > 0) && (spi_speed <= 4)) &&
-                  ((spi_clock_polarity > 0) && (spi_clock_polarity <= 2)) &&
-                  ((spi_clock_edge > 0) && (spi_clock_edge <= 2)) &&
-                  ((spi_data_sampling > 0) && (spi_data_sampling <= 2)) &&
-                  ((spi_cs_line_state > 0) && (spi_cs_line_state <= 2)) &&
-                  ((spi_enabled > 0) && (spi_enabled <= 2)));
+/**
+ * Mask for the timestamp delta bits in a framed sniffer record header.
+ */
+#define SPI_SNIFFER_RECORD_DELTA_MASK 0x1FFF
 
-  if (user_prompt) {
-    mode_configuration.command_error = NO;
+/**
+ * Sniffs data coming through the SPI bus, sending compact fixed-size records.
+ *
+ * Every record is four bytes long: a big endian header followed by two data
+ * bytes.  The header carries the SPI_SNIFFER_RECORD_* flags and, in its lower
+ * 13 bits, the amount of 4us ticks elapsed since the previous record (or
+ * since the sniffer started), saturated to SPI_SNIFFER_RECORD_DELTA_MASK.
+ *
+ * <table>
+ * <tr><th>Flags</th><th>Data</th></tr>
+ * <tr><td>None or CS_ASSERTED</td><td>MOSI byte, MISO byte</td></tr>
+ * <tr><td>REPEAT</td><td>Repeat count, big endian</td></tr>
+ * <tr><td>CS_RELEASED</td><td>0x00, 0x00</td></tr>
+ * </table>
+ *
+ * Repeated byte pairs within the same CS frame are coalesced in a single
+ * REPEAT record, whose timestamp refers to the last repetition seen.  The
+ * sniffer stops when any byte is received from the serial port or when data
+ * could not be moved out fast enough.
+ *
+ * A success code is sent before the first record, or a failure code if there
+ * is no room for the serial port ringbuffer.
+ *
+ * When filtering by opcode, frames whose first MOSI byte does not match are
+ * left out entirely, CS_RELEASED record included, and so is any data seen
+ * while CS is high.  Timestamp deltas still count from the previous record
+ * that was sent.
+ *
+ * @param[in] options     SPI_SNIFFER_OPTION_* flags.
+ * @param[in] opcode      the first MOSI byte a frame must have, if filtering.
+ * @param[in] opcode_mask which opcode bits to compare, if filtering.
+ */
+static void spi_framed_sniffer(const uint8_t options, const uint8_t opcode,
+                               const uint8_t opcode_mask);
 
-    MSG_SPI_SPEED_PROMPT;
-    mode_configuration.speed = getnumber(1, 1, 12, 0) - 1;
+/**
+ * Appends a framed sniffer record to the serial port ringbuffer.
+ *
+ * @param[in] header the record header.
+ * @param[in] first  the first data byte.
+ * @param[in] second the second data byte.
+ */
+static void spi_framed_sniffer_append(const uint16_t header,
+                                      const uint8_t first,
+                                      const uint8_t second);
 
-    MSG_SPI_POLARITY_PROMPT;
-    spi_state.clock_polarity = getnumber(1, 1, 2, 0) - 1;
+/**
+ * Returns the amount of timer ticks elapsed since the previous call, saturated
+ * to SPI_SNIFFER_RECORD_DELTA_MASK.
+ *
+ * @param[in,out] last_tick the timer value at the time of the previous call.
+ *
+ * @return the saturated amount of ticks elapsed.
+ */
+static uint16_t spi_framed_sniffer_delta(uint16_t *last_tick);
 
-    MSG_SPI_EDGE_PROMPT;
-    spi_state.clock_edge = getnumber(2, 1, 2, 0) - 1;
+#ifdef BP_SPI_ENABLE_FLASH_EMULATOR
 
-    MSG_SPI_SAMPLE_PROMPT;
-    spi_state.data_sample_timing = getnumber(1, 1, 2, 0) - 1;
+/**
+ * Flash emulator command byte, read data.
+ */
+#define SPI_FLASH_EMULATOR_READ 0x03
 
-    MSG_SPI_CS_MODE_PROMPT;
-    spi_state.cs_line_state = getnumber(2, 1, 2, 0) - 1;
+/**
+ * Flash emulator command byte, read data with a dummy byte after the address.
+ */
+#define SPI_FLASH_EMULATOR_FAST_READ 0x0B
 
-    MSG_PIN_OUTPUT_TYPE_PROMPT;
-    mode_configuration.high_impedance = ~(getnumber(1, 1, 2, 0) - 1);
-  } else {
-    mode_configuration.speed = spi_speed - 1;
-    spi_state.clock_polarity = spi_clock_polarity - 1;
-    spi_state.clock_edge = spi_clock_edge - 1;
-    spi_state.data_sample_timing = spi_data_sampling - 1;
-    spi_state.cs_line_state = (spi_cs_line_state - 1);
-    mode_configuration.high_impedance = ~(spi_enabled - 1);
-    spi_print_settings();
-  }
+/**
+ * Flash emulator command byte, read the JEDEC identifier.
+ */
+#define SPI_FLASH_EMULATOR_READ_ID 0x9F
 
-  mode_configuration.write_with_read = OFF;
-}
+/**
+ * Flash emulator command byte, read the status register.
+ */
+#define SPI_FLASH_EMULATOR_READ_STATUS 0x05
 
-void spi_setup_execute(void) {
-  /* Setup speed. */
-  spi_setup(spi_bus_speed[mode_configuration.speed]);
+/**
+ * What the flash emulator expects next within the current CS frame.
+ */
+typedef enum {
+  /** The command byte. */
+  SPI_FLASH_EMULATOR_STATE_COMMAND = 0,
+  /** Address bytes of a READ or FAST_READ command. */
+  SPI_FLASH_EMULATOR_STATE_ADDRESS,
+  /** Clocking out image data. */
+  SPI_FLASH_EMULATOR_STATE_DATA,
+  /** Clocking out the JEDEC identifier. */
+  SPI_FLASH_EMULATOR_STATE_IDENTIFIER,
+  /** Clocking out the status register. */
+  SPI_FLASH_EMULATOR_STATE_STATUS,
+  /** An unsupported command, the rest of the frame is ignored. */
+  SPI_FLASH_EMULATOR_STATE_IGNORE
+} spi_flash_emulator_state_t;
 
-  /* Setup CS line state. */
-  SPICS = spi_state.cs_line_state;
-}
+/**
+ * Flash emulator state, shared between the SPI1 interrupt handler and the
+ * main loop.  The main loop only touches it with the SPI1 interrupt disabled.
+ */
+static struct {
 
-inline void spi_cleanup(void) { spi_disable_interface(); }
+  /** The memory image being served. */
+  const uint8_t *image;
 
-void spi_run_macro(const uint16_t macro) {
+  /** How many bytes the image holds, addresses wrap around past it. */
+  uint16_t size;
+
+  /** Next image offset to queue for transmission. */
+  uint16_t offset;
+
+  /** Address bytes received so far, the top byte is dropped. */
+  uint32_t address;
+
+  /** Address bytes still expected. */
+  uint8_t address_bytes_left;
+
+  /** Next JEDEC identifier byte to queue for transmission. */
+  uint8_t identifier_index;
+
+  /** JEDEC identifier, manufacturer first. */
+  uint8_t identifier[3];
+
+  /** Where the current CS frame is at. */
+  volatile spi_flash_emulator_state_t state;
+
+  /** How many supported commands were served. */
+  volatile uint16_t commands;
+
+  /** Whether the SPI1 interrupt belongs to the emulator. */
+  volatile bool active;
+
+} spi_flash_emulator;
+
+/**
+ * Handles an incoming flash emulator binary I/O command.
+ *
+ * The command is followed by the three JEDEC identifier bytes and the
+ * big endian image length, at most BP_TERMINAL_BUFFER_SIZE bytes.  If the
+ * length is accepted a success byte is sent, then the image data is read and
+ * another success byte is sent once the emulator is listening.  Any byte
+ * received from the serial port stops the emulator, which then answers with a
+ * success byte and the big endian amount of commands it served.
+ *
+ * The response to a command is queued from the SPI1 interrupt handler right
+ * after its last header byte is received, so the master must leave about
+ * 3us between that byte and the first response byte.  FAST_READ gets that
+ * time from its dummy byte.  Data after the first byte is kept queued ahead
+ * in the enhanced buffer, so it can be clocked back to back.
+ */
+static void handle_flash_emulator(void);
+
+/**
+ * Takes the flash emulator bytes waiting in the receive FIFO and tops up the
+ * transmit FIFO with the response.  Must be called either from the interrupt
+ * handler or with the SPI1 interrupt disabled.
+ */
+static void spi_flash_emulator_service(void);
+
+/**
+ * Gets the flash emulator ready for a new CS frame, flushing anything still
+ * queued in the SPI1 FIFOs.  Must be called with the SPI1 interrupt disabled.
+ */
+static void spi_flash_emulator_reset_frame(void);
+
+#endif /* BP_SPI_ENABLE_FLASH_EMULATOR */
+
+/**
+ * Word size command flag asking for 16 bits words on the bus.
+ */
+#define SPI_WORD_SIZE_FLAG_16_BITS 0b00000001
+
+/**
+ * Mask for all the flags accepted by the word size command.
+ */
+#define SPI_WORD_SIZE_FLAGS_MASK SPI_WORD_SIZE_FLAG_16_BITS
+
+/**
+ * Exchanges a buffer over the bus as 16 bits words, most significant byte
+ * first, with MODE16 set on the peripheral.  Words are kept in flight like
+ * spi_transfer_buffer does with bytes.
+ *
+ * @param[in]  output the bytes to send, or NULL to send 0xFF bytes.
+ * @param[out] input  where to store the bytes read, or NULL to drop them.
+ * @param[in]  length how many bytes to exchange, must be even.
+ */
+static void spi_transfer_words(const uint8_t *output, uint8_t *input,
+                               const size_t length);
+
+/**
+ * Tells whether a binary I/O base command can run while bulk transfers move
+ * 16 bits words.  Commands that go through spi_write_byte() would put a
+ * whole word on the bus for every byte, so they are refused instead.
+ *
+ * @param[in] command the base command byte.
+ *
+ * @return true if the command is safe to run.
+ */
+static bool spi_base_command_takes_words(const uint8_t command);
+
+/**
+ * Engages the CS line.
+ *
+ * @param[in] write_with_read flag indicating if data writes will have a
+ *                            subsequent read operation or not.
+ */
+static void engage_spi_cs(bool write_with_read);
+
+/**
+ * Streaming write-then-read flag asking for the CS line to be asserted for the
+ * whole duration of the transfer.
+ */
+#define SPI_STREAMING_FLAG_ASSERT_CS 0b00000001
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+
+/**
+ * Streaming write-then-read flag asking for the data read from the bus to be
+ * sent as a compressed read token stream, see compressed_read.h.
+ */
+#define SPI_STREAMING_FLAG_COMPRESS 0b00000010
+
+/**
+ * Mask for all the flags accepted by the streaming write-then-read command.
+ */
+#define SPI_STREAMING_FLAGS_MASK                                               \
+  (SPI_STREAMING_FLAG_ASSERT_CS | SPI_STREAMING_FLAG_COMPRESS)
+
+#else
+
+/**
+ * Mask for all the flags accepted by the streaming write-then-read command.
+ */
+#define SPI_STREAMING_FLAGS_MASK SPI_STREAMING_FLAG_ASSERT_CS
+
+#endif /* BP_ENABLE_COMPRESSED_READS */
+
+/**
+ * Handle an incoming streaming write-then-read binary I/O command.
+ *
+ * Unlike SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS, data is not staged in
+ * bus_pirate_configuration.terminal_input first: every byte coming from the
+ * serial port is put on the bus as soon as it arrives, and every byte read from
+ * the bus is handed over to the serial port right away.  This lets the serial
+ * port hardware FIFO (or the CDC IN endpoint buffer on v4) drain while the next
+ * byte is being clocked, and removes any upper bound on the transfer size
+ * other than the 32 bits length fields.
+ *
+ * The command payload is as follows:
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Size</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>Flags (SPI_STREAMING_FLAG_ASSERT_CS,
+ * SPI_STREAMING_FLAG_COMPRESS)</td></tr>
+ * <tr><td>1</td><td>4</td><td>Bytes to write, big endian</td></tr>
+ * <tr><td>5</td><td>4</td><td>Bytes to read, big endian</td></tr>
+ * <tr><td>9</td><td>N</td><td>Data to write</td></tr>
+ * </table>
+ *
+ * A success code is sent once all the bytes to write were put on the bus, and
+ * it is followed by the data read from the bus, as a compressed read token
+ * stream if asked for.  Invalid flags are reported with a failure code
+ * before any data is consumed.
+ */
+static void handle_streaming_write_then_read(void);
+
+/**
+ * Size of each ping-pong buffer used by the write-then-read commands.
+ */
+#define SPI_PING_PONG_HALF_SIZE (BP_TERMINAL_BUFFER_SIZE / 2)
+
+#ifdef BUSPIRATEV3
+
+/**
+ * Writes data coming from the serial port to the SPI bus, using two buffer
+ * arena reservations as ping-pong buffers.
+ *
+ * While one half is being clocked out through the SPI transmission FIFO, the
+ * other half is filled with whatever the serial port received in the meantime,
+ * so the serial and SPI transfers overlap instead of happening one after the
+ * other.  Data read from the bus is discarded.
+ *
+ * If the buffers cannot be reserved the data is read and dropped, so the
+ * command stream stays in step.
+ *
+ * @param[in] bytes_to_write how many bytes to move from the serial port to the
+ *                           SPI bus.
+ *
+ * @return true if the data went to the bus, false if it was dropped.
+ */
+static bool spi_write_from_serial_double_buffered(uint16_t bytes_to_write);
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Writes data coming from the serial port to the SPI bus, clocking it out
+ * straight from the USB packet buffers.
+ *
+ * The CDC OUT endpoint already alternates between two packet buffers, so the
+ * next packet arrives while the current one is on the bus, without copying
+ * anything into bus_pirate_configuration.terminal_input.  Data read from the
+ * bus is discarded.
+ *
+ * @param[in] bytes_to_write how many bytes to move from the serial port to the
+ *                           SPI bus.
+ */
+static void spi_write_from_serial_zero_copy(uint16_t bytes_to_write);
+
+#endif /* BUSPIRATEV4 */
+
+/**
+ * SPI script opcodes.
+ *
+ * <table>
+ * <tr><th>Opcode</th><th>Arguments</th><th>Action</th></tr>
+ * <tr><td>0x00 - End</td><td>-</td><td>Stops the script</td></tr>
+ * <tr><td>0x01 - CS low</td><td>-</td><td>Asserts the CS line</td></tr>
+ * <tr><td>0x02 - CS high</td><td>-</td><td>Releases the CS line</td></tr>
+ * <tr><td>0x03 - Write</td><td>count (1 byte), data</td><td>Writes the given
+ * bytes, discarding what is read</td></tr>
+ * <tr><td>0x04 - Read</td><td>count (1 byte)</td><td>Writes 0xFF bytes and
+ * appends what is read to the results</td></tr>
+ * <tr><td>0x05 - Transfer</td><td>count (1 byte), data</td><td>Writes the
+ * given bytes and appends what is read to the results</td></tr>
+ * <tr><td>0x06 - Delay</td><td>microseconds (2 bytes)</td><td>Waits for the
+ * given time</td></tr>
+ * <tr><td>0x07 - Poll</td><td>mask, value, timeout in milliseconds (2
+ * bytes)</td><td>Reads bytes until one matches value once masked, failing the
+ * script on timeout</td></tr>
+ * <tr><td>0x08 - Loop</td><td>offset (2 bytes), count (1 byte)</td><td>Jumps
+ * back to the given script offset, count more times</td></tr>
+ * </table>
+ *
+ * Multi-byte arguments are sent MSB first.  Loops cannot be nested.
+ */
+typedef enum {
+  SPI_SCRIPT_OPCODE_END = 0,
+  SPI_SCRIPT_OPCODE_CS_LOW,
+  SPI_SCRIPT_OPCODE_CS_HIGH,
+  SPI_SCRIPT_OPCODE_WRITE,
+  SPI_SCRIPT_OPCODE_READ,
+  SPI_SCRIPT_OPCODE_TRANSFER,
+  SPI_SCRIPT_OPCODE_DELAY,
+  SPI_SCRIPT_OPCODE_POLL,
+  SPI_SCRIPT_OPCODE_LOOP
+} spi_script_opcode_t;
+
+/**
+ * Maximum SPI script size, the other half of the buffer holds the results.
+ */
+#define SPI_SCRIPT_MAXIMUM_SIZE (BP_TERMINAL_BUFFER_SIZE / 2)
+
+/**
+ * Handle an incoming SPI script binary I/O command.
+ *
+ * The command payload is the script length (2 bytes, MSB first) followed by
+ * the script itself.  Oversized scripts are reported with a failure code
+ * before any data is consumed.  Otherwise, once the script has run, a result
+ * code is sent followed by the results length (2 bytes, MSB first) and the
+ * results gathered by read and transfer operations up to that point.  A
+ * script failing, either because of a malformed opcode, a poll timeout, or
+ * results not fitting, also releases the CS line.
+ */
+static void handle_run_script(void);
+
+/**
+ * Runs the given SPI script.
+ *
+ * @param[in]  script         the script to run.
+ * @param[in]  script_length  the script size in bytes.
+ * @param[out] results        where to store the bytes read.
+ * @param[out] results_length how many result bytes were stored.
+ *
+ * @return true if the script ran to completion, false otherwise.
+ */
+static bool spi_run_script(const uint8_t *script, const uint16_t script_length,
+                           uint8_t *results, uint16_t *results_length);
+
+#ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
+
+/**
+ * Extended AVR Binary I/O command for no operations.
+ */
+#define BINARY_IO_SPI_AVR_COMMAND_NOOP 0
+
+/**
+ * Extended AVR Binary I/O command for obtaining the protocol version.
+ */
+#define BINARY_IO_SPI_AVR_COMMAND_VERSION 1
+
+/**
+ * Extended AVR Binary I/O command for performing a bulk read.
+ *
+ * Followed by the flash word address and the number of bytes to read, both
+ * 32 bits MSB first.  Addresses past 64K words are reached with the Load
+ * Extended Address instruction.
+ */
+#define BINARY_IO_SPI_AVR_COMMAND_BULK_READ 2
+
+/**
+ * Extended AVR Binary I/O command for loading and writing a flash page.
+ *
+ * Followed by the page word address (32 bits MSB first) and the number of
+ * bytes to write (16 bits MSB first, even, up to AVR_PAGE_MAXIMUM_LENGTH).
+ * Answered with 0x01 if these are accepted, then the data bytes are sent,
+ * and answered again with 0x01 once the part reports it is ready, or with
+ * 0x00 if it stays busy.
+ */
+#define BINARY_IO_SPI_AVR_COMMAND_BULK_WRITE_PAGE 3
+
+/**
+ * Extended AVR Binary I/O protocol version.
+ */
+#define BINARY_IO_SPI_AVR_SUPPORT_VERSION 0x0002
+
+#define AVR_FETCH_LOW_BYTE_COMMAND 0x20
+#define AVR_FETCH_HIGH_BYTE_COMMAND 0x28
+#define AVR_LOAD_PAGE_LOW_BYTE_COMMAND 0x40
+#define AVR_LOAD_PAGE_HIGH_BYTE_COMMAND 0x48
+#define AVR_WRITE_PAGE_COMMAND 0x4C
+#define AVR_LOAD_EXTENDED_ADDRESS_COMMAND 0x4D
+#define AVR_POLL_READY_COMMAND 0xF0
+
+/** Every AVR serial programming instruction is four bytes long. */
+#define AVR_INSTRUCTION_LENGTH 4
+
+/** Highest flash word address reachable with Load Extended Address. */
+#define AVR_MAXIMUM_WORD_ADDRESS 0xFFFFFFUL
+
+/** Bytes fetched per SPI burst by the bulk read. */
+#define AVR_READ_CHUNK_LENGTH 64
+
+/** Largest page the bulk page write takes, 256 words. */
+#define AVR_PAGE_MAXIMUM_LENGTH 512
+
+/**
+ * How many times RDY/BSY is polled after a page write before giving up.  A
+ * poll takes around 110us, page writes take up to 4.5ms.
+ */
+#define AVR_WRITE_POLLS 500
+
+/**
+ * Handle an incoming extended binary I/O AVR SPI command.
+ */
+static void handle_extended_avr_command(void);
+
+/**
+ * Reads flash bytes with the instructions pipelined through the SPI FIFO and
+ * sends them in blocks.
+ */
+static void avr_bulk_read(uint32_t address, uint32_t length);
+
+/**
+ * Loads a flash page from the serial port, writes it and waits for the part
+ * to be ready again.
+ */
+static void avr_bulk_write_page(const uint32_t address, const uint16_t length);
+
+/**
+ * Issues Load Extended Address if the given word address is in a different
+ * 64K words bank than the last one selected.
+ */
+static void avr_select_bank(const uint32_t address);
+
+/**
+ * Extended address byte last sent to the part.
+ */
+static uint8_t avr_extended_address = 0;
+
+#endif /* BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS */
+
+/**
+ * SPI protocol state structure.
+ */
+typedef struct {
+
+  /**
+   * Clock polarity.
+   *
+   * @see SPI_CLOCK_IDLE_LOW
+   * @see SPI_CLOCK_IDLE_HIGH
+   */
+  uint8_t clock_polarity : 1;
+
+  /**
+   * Clock edge.
+   *
+   * @see SPI_TRANSITION_FROM_IDLE_TO_ACTIVE
+   * @see SPI_TRANSITION_FROM_ACTIVE_TO_IDLE
+   */
+  uint8_t clock_edge : 1;
+
+  /**
+   * Data sample timing.
+   *
+   * @see SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE
+   * @see SPI_SAMPLING_ON_DATA_OUTPUT_END
+   */
+  uint8_t data_sample_timing : 1;
+
+  /** CS line state. */
+  uint8_t cs_line_state : 1;
+
+  /** Binary bulk transfers move 16 bits words, MODE16 is set. */
+  uint8_t word_transfers : 1;
+
+} spi_state_t;
+
+/**
+ * The SPI protocol state.
+ */
+static spi_state_t spi_state = {0};
+
+/**
+ * Settings binary mode had when it was last left.
+ */
+static struct {
+  /** SPI bus format. */
+  spi_state_t state;
+
+  /** Index into spi_bus_speed. */
+  uint8_t speed : 4;
+
+  /** Outputs are open drain. */
+  uint8_t high_impedance : 1;
+
+  /** Binary mode was left at least once. */
+  uint8_t saved : 1;
+} spi_binary_io_settings = {0};
+
+/**
+ * Available SPI bus speeds.
+ */
+static const uint8_t spi_bus_speed[] = {
+    0b00000000, /*  31 kHz - Primary prescaler 64:1 / Secondary prescaler 8:1 */
+    0b00011000, /* 125 kHz - Primary prescaler 64:1 / Secondary prescaler 2:1 */
+    0b00011100, /* 250 kHz - Primary prescaler 64:1 / Secondary prescaler 1:1 */
+    0b00011101, /*   1 MHz - Primary prescaler 16:1 / Secondary prescaler 1:1 */
+    0b00001100, /*  50 kHz - Primary prescaler 64:1 / Secondary prescaler 5:1 */
+    0b00010110, /* 1.3 MHz - Primary prescaler  4:1 / Secondary prescaler 3:1 */
+    0b00011010, /*   2 MHz - Primary prescaler  4:1 / Secondary prescaler 2:1 */
+    0b00001011, /* 2.6 MHz - Primary prescaler  1:1 / Secondary prescaler 6:1 */
+    0b00001111, /* 3.2 MHz - Primary prescaler  1:1 / Secondary prescaler 5:1 */
+    0b00011110, /*   4 MHz - Primary prescaler  4:1 / Secondary prescaler 1:1 */
+    0b00010111, /* 5.3 MHz - Primary prescaler  1:1 / Secondary prescaler 3:1 */
+    0b00011011  /*   8 MHz - Primary prescaler  1:1 / Secondary prescaler 2:1 */
+};
+
+void engage_spi_cs(bool write_with_read) {
+  mode_configuration.write_with_read = write_with_read;
+  SPICS = !spi_state.cs_line_state;
+  if (spi_state.cs_line_state) {
+    user_serial_transmit_character('/');
+  }
+  MSG_SPI_CS_ENABLED;
+}
+
+inline void spi_start_with_read(void) { engage_spi_cs(ON); }
+
+inline void spi_start(void) { engage_spi_cs(OFF); }
+
+void spi_stop(void) {
+  SPICS = spi_state.cs_line_state;
+  if (spi_state.cs_line_state) {
+    user_serial_transmit_character('/');
+  }
+  MSG_SPI_CS_DISABLED;
+}
+
+inline uint16_t spi_read(void) { return spi_write_byte(0xFF); }
+
+uint16_t spi_write(const uint16_t value) {
+  uint8_t data;
+
+  data = spi_write_byte(value);
+  return mode_configuration.write_with_read ? data : 0;
+}
+
+void spi_send_buffer(const uint8_t *buffer, const size_t length) {
+  spi_transfer_buffer(buffer, NULL, length);
+}
+
+void spi_read_buffer(uint8_t *buffer, const size_t length) {
+  spi_transfer_buffer(NULL, buffer, length);
+}
+
+void spi_print_settings(void) {
+  MSG_SPI_MODE_HEADER_START;
+  bp_write_dec_byte(mode_configuration.speed + 1);
+  bpSP;
+  bp_write_dec_byte(spi_state.clock_polarity);
+  bpSP;
+  bp_write_dec_byte(spi_state.clock_edge);
+  bpSP;
+  bp_write_dec_byte(spi_state.data_sample_timing);
+  bpSP;
+  bp_write_dec_byte(spi_state.cs_line_state);
+  bpSP;
+  bp_write_dec_byte(mode_configuration.high_impedance);
+  MSG_MODE_HEADER_END;
+}
+
+void spi_setup_prepare(void) {
+  bool user_prompt;
+  int spi_speed;
+  int spi_clock_polarity;
+  int spi_clock_edge;
+  int spi_data_sampling;
+  int spi_enabled;
+  int spi_cs_line_state;
+
+  consumewhitechars();
+  spi_speed = getint();
+  consumewhitechars();
+  spi_clock_polarity = getint();
+  consumewhitechars();
+  spi_clock_edge = getint();
+  consumewhitechars();
+  spi_data_sampling = getint();
+  consumewhitechars();
+  spi_cs_line_state = getint();
+  consumewhitechars();
+  spi_enabled = getint();
+
+  user_prompt = !(((spi_speed > 0) && (spi_speed <= 4)) &&
+                  ((spi_clock_polarity > 0) && (spi_clock_polarity <= 2)) &&
+                  ((spi_clock_edge > 0) && (spi_clock_edge <= 2)) &&
+                  ((spi_data_sampling > 0) && (spi_data_sampling <= 2)) &&
+                  ((spi_cs_line_state > 0) && (spi_cs_line_state <= 2)) &&
+                  ((spi_enabled > 0) && (spi_enabled <= 2)));
+
+  if (user_prompt) {
+    mode_configuration.command_error = NO;
+
+    MSG_SPI_SPEED_PROMPT;
+    mode_configuration.speed = getnumber(1, 1, 12, 0) - 1;
+
+    MSG_SPI_POLARITY_PROMPT;
+    spi_state.clock_polarity = getnumber(1, 1, 2, 0) - 1;
+
+    MSG_SPI_EDGE_PROMPT;
+    spi_state.clock_edge = getnumber(2, 1, 2, 0) - 1;
+
+    MSG_SPI_SAMPLE_PROMPT;
+    spi_state.data_sample_timing = getnumber(1, 1, 2, 0) - 1;
+
+    MSG_SPI_CS_MODE_PROMPT;
+    spi_state.cs_line_state = getnumber(2, 1, 2, 0) - 1;
+
+    MSG_PIN_OUTPUT_TYPE_PROMPT;
+    mode_configuration.high_impedance = ~(getnumber(1, 1, 2, 0) - 1);
+  } else {
+    mode_configuration.speed = spi_speed - 1;
+    spi_state.clock_polarity = spi_clock_polarity - 1;
+    spi_state.clock_edge = spi_clock_edge - 1;
+    spi_state.data_sample_timing = spi_data_sampling - 1;
+    spi_state.cs_line_state = (spi_cs_line_state - 1);
+    mode_configuration.high_impedance = ~(spi_enabled - 1);
+    spi_print_settings();
+  }
+
+  mode_configuration.write_with_read = OFF;
+}
+
+void spi_setup_execute(void) {
+  /* Setup speed. */
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+
+  /* Setup CS line state. */
+  SPICS = spi_state.cs_line_state;
+}
+
+inline void spi_cleanup(void) { spi_disable_interface(); }
+
+void spi_run_macro(const uint16_t macro) {
 
   switch (macro) {
   case SPI_MACRO_MENU:
     MSG_SPI_MACRO_MENU;
     break;
 
-  case SPI_MACRO_SNIFF_ON_CS_LOW:
-    MSG_SNIFFER_MESSAGE;
-    MSG_ANY_KEY_TO_EXIT_PROMPT;
-    spi_sniffer(SPI_SNIFF_ON_CS_LOW, true);
-    break;
+  case SPI_MACRO_SNIFF_ON_CS_LOW:
+    MSG_SNIFFER_MESSAGE;
+    MSG_ANY_KEY_TO_EXIT_PROMPT;
+    spi_sniffer(SPI_SNIFF_ON_CS_LOW, true);
+    break;
+
+  case SPI_MACRO_SNIFF_ALL_TRAFFIC:
+    MSG_SNIFFER_MESSAGE;
+    MSG_ANY_KEY_TO_EXIT_PROMPT;
+    spi_sniffer(SPI_SNIFF_ALWAYS, true);
+    break;
+
+  case SPI_MACRO_CLOCK_IDLE_LOW:
+    spi_state.clock_polarity = SPI_CLOCK_IDLE_LOW;
+    goto cleanup;
+
+  case SPI_MACRO_CLOCK_IDLE_HIGH:
+    spi_state.clock_polarity = SPI_CLOCK_IDLE_HIGH;
+    goto cleanup;
+
+  case SPI_MACRO_EDGE_IDLE_TO_ACTIVE:
+    spi_state.clock_edge = SPI_TRANSITION_FROM_IDLE_TO_ACTIVE;
+    goto cleanup;
+
+  case SPI_MACRO_EDGE_ACTIVE_TO_IDLE:
+    spi_state.clock_edge = SPI_TRANSITION_FROM_ACTIVE_TO_IDLE;
+    goto cleanup;
+
+  case SPI_MACRO_SAMPLING_ON_MIDDLE:
+    spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE;
+    goto cleanup;
+
+  case SPI_MACRO_SAMPLING_ON_END:
+    spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_END;
+
+  cleanup:
+    SPI1CON1bits.CKP = spi_state.clock_polarity;
+    SPI1CON1bits.CKE = spi_state.clock_edge;
+    SPI1CON1bits.SMP = spi_state.data_sample_timing;
+    spi_print_settings();
+    break;
+
+  default:
+    MSG_UNKNOWN_MACRO_ERROR;
+    break;
+  }
+}
+
+void spi_print_pins_state(void) { MSG_SPI_PINS_STATE; }
+
+void spi_setup(const uint8_t spi_speed) {
+  /* Disable interface. */
+  SPI1STATbits.SPIEN = OFF;
+
+  /* Set SPI to open drain if high impedance is on. */
+  if (mode_configuration.high_impedance == ON) {
+    SPIMOSI_ODC = ON;
+    SPICLK_ODC = ON;
+    SPICS_ODC = ON;
+  } else {
+    SPIMOSI_ODC = OFF;
+    SPICLK_ODC = OFF;
+    SPICS_ODC = OFF;
+  }
+
+  /* Assign pins routing. */
+
+  RPINR20bits.SDI1R = BP_MISO_RPIN;
+  BP_MOSI_RPOUT = SDO1_IO;
+  BP_CLK_RPOUT = SCK1OUT_IO;
+  SPICS = HIGH;
+  SPICS_TRIS = OUTPUT;
+  SPICLK_TRIS = OUTPUT;
+  SPIMISO_TRIS = INPUT;
+  SPIMOSI_TRIS = OUTPUT;
+
+  /*
+   * MSB
+   * ---000xx0x1xxxxx
+   *    |||||||||||||
+   *    |||||||||||++--- PPRE:   Primary prescale bits.
+   *    ||||||||+++----- SPRE:   Secondary prescale bits.
+   *    |||||||+-------- MSTEN:  Master mode.
+   *    ||||||+--------- CKP:    Clock idle LOW.
+   *    |||||+---------- SSEN:   Pin controlled by port function.
+   *    ||||+----------- CKE:    Transition happens from idle to active.
+   *    |||+------------ SMP:    Flag indicating when the data is sampled.
+   *    ||+------------- MODE16: Word-wide for binary 16 bits transfers.
+   *    |+-------------- DISSDO: SDO1 pin is controlled by the module.
+   *    +--------------- DISSCK: Internal SPI clock is enabled.
+   */
+  SPI1CON1 =
+      (MASKBOTTOM8(spi_speed, 5) << _SPI1CON1_PPRE_POSITION) |
+      (ON << _SPI1CON1_MSTEN_POSITION) |
+      (MASKBOTTOM8(spi_state.clock_polarity, 1) << _SPI1CON1_CKP_POSITION) |
+      (MASKBOTTOM8(spi_state.clock_edge, 1) << _SPI1CON1_CKE_POSITION) |
+      (MASKBOTTOM8(spi_state.data_sample_timing, 1) << _SPI1CON1_SMP_POSITION) |
+      (MASKBOTTOM8(spi_state.word_transfers, 1) << _SPI1CON1_MODE16_POSITION);
+
+  /*
+   * MSB
+   * 000-----------01
+   * |||           ||
+   * |||           |+--- SPIBEN: Enhanced buffer mode enabled.
+   * |||           +---- FRMDLY: Frame sync pulse precedes first bit clock.
+   * ||+---------------- FRMPOL: Frame sync pulse is active low.
+   * |+----------------- SPIFSD: Frame sync pulse output.
+   * +------------------ FRMEN:  Framed SPI1 support disabled.
+   */
+  SPI1CON2 = ON << _SPI1CON2_SPIBEN_POSITION;
+
+  /*
+   * MSB
+   * 0-0------0----??
+   * | |      |
+   * | |      +--------- SPIROV:  Overflow flag cleared.
+   * | +---------------- SPISIDL: Continue module operation in idle mode.
+   * +------------------ SPIEN:   Module disabled.
+   */
+  SPI1STAT = 0x0000;
+
+  /* Enable the interface. */
+  SPI1STATbits.SPIEN = ON;
+}
+
+void spi_disable_interface(void) {
+
+  /* Disable interface. */
+  SPI1STATbits.SPIEN = OFF;
+
+  /* Deassign pins. */
+  RPINR20bits.SDI1R = 0b11111;
+  BP_MOSI_RPOUT = 0b00000;
+  BP_CLK_RPOUT = 0b00000;
+
+  /* Disable open drain. */
+  SPIMOSI_ODC = OFF;
+  SPICLK_ODC = OFF;
+  SPICS_ODC = OFF;
+}
+
+uint8_t spi_write_byte(const uint8_t value) {
+  uint8_t input;
+
+  BP_PROFILING_ENTER(BP_PROFILING_REGION_SPI_WRITE);
+
+  /* Put the value on the bus. */
+  SPI1BUF = value;
+
+  /* Wait until a byte has been read. */
+  while (SPI1STATbits.SRXMPT == YES) {
+  }
+
+  /* Get the byte read from the bus. */
+  input = SPI1BUF;
+
+  BP_PROFILING_EXIT(BP_PROFILING_REGION_SPI_WRITE);
+  return input;
+}
+
+void spi_transfer_buffer(const uint8_t *output, uint8_t *input,
+                         const size_t length) {
+  size_t sent;
+  size_t received;
+  uint8_t value;
+
+  sent = 0;
+  received = 0;
+
+  while (received < length) {
+
+    /*
+     * Keep the transmission FIFO topped up, without having more bytes in
+     * flight than the reception FIFO can hold.
+     */
+    while ((sent < length) && (SPI1STATbits.SPITBF == NO) &&
+           ((sent - received) < SPI_FIFO_DEPTH)) {
+      SPI1BUF = (output != NULL) ? output[sent] : 0xFF;
+      sent++;
+    }
+
+    /* Drain whatever has been clocked in so far. */
+    while (SPI1STATbits.SRXMPT == NO) {
+      value = SPI1BUF;
+      if (input != NULL) {
+        input[received] = value;
+      }
+      received++;
+    }
+  }
+}
+
+void spi_transfer_words(const uint8_t *output, uint8_t *input,
+                        const size_t length) {
+  size_t sent;
+  size_t received;
+  uint16_t value;
+
+  sent = 0;
+  received = 0;
+
+  while (received < length) {
+
+    /* The FIFOs hold as many words as they hold bytes. */
+    while ((sent < length) && (SPI1STATbits.SPITBF == NO) &&
+           ((sent - received) < (SPI_FIFO_DEPTH * 2))) {
+      SPI1BUF = (output != NULL) ? ((output[sent] << 8) | output[sent + 1])
+                                 : 0xFFFF;
+      sent += 2;
+    }
 
-  case SPI_MACRO_SNIFF_ALL_TRAFFIC:
-    MSG_SNIFFER_MESSAGE;
-    MSG_ANY_KEY_TO_EXIT_PROMPT;
-    spi_sniffer(SPI_SNIFF_ALWAYS, true);
-    break;
+    while (SPI1STATbits.SRXMPT == NO) {
+      value = SPI1BUF;
+      if (input != NULL) {
+        input[received] = HI8(value);
+        input[received + 1] = LO8(value);
+      }
+      received += 2;
+    }
+  }
+}
 
-  case SPI_MACRO_CLOCK_IDLE_LOW:
-    spi_state.clock_polarity = SPI_CLOCK_IDLE_LOW;
-    goto cleanup;
+bool spi_base_command_takes_words(const uint8_t command) {
+  switch (command) {
+  case SPI_BASE_COMMAND_EXIT:
+  case SPI_BASE_COMMAND_SEND_IDENTIFIER:
+  case SPI_BASE_COMMAND_CS_LOW:
+  case SPI_BASE_COMMAND_CS_HIGH:
+  case SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS:
+  case SPI_BASE_COMMAND_WRITE_AND_READ_WITHOUT_CS:
+  case SPI_BASE_COMMAND_SET_WORD_SIZE:
+    return true;
 
-  case SPI_MACRO_CLOCK_IDLE_HIGH:
-    spi_state.clock_polarity = SPI_CLOCK_IDLE_HIGH;
-    goto cleanup;
+  default:
+    /* The sniffers and the flash emulator rebuild the peripheral setup. */
+    return (command == SPI_BASE_COMMAND_EMULATE_FLASH) ||
+           (command >= SPI_BASE_COMMAND_TRAFFIC_STATISTICS);
+  }
+}
 
-  case SPI_MACRO_EDGE_IDLE_TO_ACTIVE:
-    spi_state.clock_edge = SPI_TRANSITION_FROM_IDLE_TO_ACTIVE;
-    goto cleanup;
+#ifdef BUSPIRATEV3
+
+bool spi_write_from_serial_double_buffered(uint16_t bytes_to_write) {
+  uint8_t *filling;
+  uint8_t *draining;
+  uint16_t filled;
+  uint16_t to_drain;
+  uint16_t sent;
+  uint16_t received;
+
+  filling = bp_buffer_arena_reserve(SPI_PING_PONG_HALF_SIZE);
+  draining = bp_buffer_arena_reserve(SPI_PING_PONG_HALF_SIZE);
+  if ((filling == NULL) || (draining == NULL)) {
+    bp_buffer_arena_release(draining);
+    bp_buffer_arena_release(filling);
+    for (; bytes_to_write > 0; bytes_to_write--) {
+      user_serial_read_byte();
+    }
+    return false;
+  }
+  filled = 0;
+  to_drain = 0;
+  sent = 0;
+  received = 0;
+
+  while ((bytes_to_write > 0) || (filled > 0) || (received < to_drain)) {
+
+    /* Fill the idle half with whatever came from the serial port. */
+    if ((bytes_to_write > 0) && (filled < SPI_PING_PONG_HALF_SIZE) &&
+        user_serial_ready_to_read()) {
+      filling[filled++] = user_serial_read_byte();
+      bytes_to_write--;
+    }
+
+    /* Keep the transmission FIFO busy with the other half. */
+    if ((sent < to_drain) && (SPI1STATbits.SPITBF == NO) &&
+        ((sent - received) < SPI_FIFO_DEPTH)) {
+      SPI1BUF = draining[sent++];
+    }
+    while (SPI1STATbits.SRXMPT == NO) {
+      (void)SPI1BUF;
+      received++;
+    }
+
+    /* Swap halves once the bus is done and there is something new to send. */
+    if ((received == to_drain) && (filled > 0) &&
+        ((filled == SPI_PING_PONG_HALF_SIZE) || (bytes_to_write == 0) ||
+         !user_serial_ready_to_read())) {
+      uint8_t *swap;
+
+      swap = draining;
+      draining = filling;
+      filling = swap;
+      to_drain = filled;
+      filled = 0;
+      sent = 0;
+      received = 0;
+    }
+  }
+
+  bp_buffer_arena_release(filling);
+  bp_buffer_arena_release(draining);
+
+  return true;
+}
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+void spi_write_from_serial_zero_copy(uint16_t bytes_to_write) {
+  const uint8_t *data;
+  size_t length;
+  size_t sent;
+  size_t received;
+
+  while (bytes_to_write > 0) {
+    data = user_serial_borrow_input(bytes_to_write, &length);
+    bytes_to_write -= length;
+
+    /* Keep the transmission FIFO busy until the packet is on the bus. */
+    sent = 0;
+    received = 0;
+    while (received < length) {
+      if ((sent < length) && (SPI1STATbits.SPITBF == NO) &&
+          ((sent - received) < SPI_FIFO_DEPTH)) {
+        SPI1BUF = data[sent++];
+      }
+      while (SPI1STATbits.SRXMPT == NO) {
+        (void)SPI1BUF;
+        received++;
+      }
+    }
+  }
+}
+
+#endif /* BUSPIRATEV4 */
+
+void spi_sniffer(bool trigger, bool terminal_mode) {
+  bool last_cs_line_state;
+
+restart:
+
+  last_cs_line_state = HIGH;
+
+  if (!user_serial_ringbuffer_setup()) {
+    if (!terminal_mode) {
+      REPORT_IO_FAILURE();
+    }
+    return;
+  }
+  if (!terminal_mode) {
+    /* The ringbuffer writes into UART1 directly, the code must go first. */
+    REPORT_IO_SUCCESS();
+    user_serial_wait_transmission_done();
+  }
+  spi_disable_interface();
+  spi_slave_enable();
+
+  if (trigger == SPI_SNIFF_ON_CS_LOW) {
+    SPI1CON1bits.SSEN = ON;
+    SPI2CON1bits.SSEN = ON;
+  }
+
+  SPI1STATbits.SPIEN = ON;
+  SPI2STATbits.SPIEN = ON;
+
+  for (;;) {
+
+    /* Detect a CS line state change. */
+    if ((last_cs_line_state == LOW) && (SPICS == HIGH)) {
+      user_serial_ringbuffer_append(']');
+      last_cs_line_state = HIGH;
+    }
+
+    /* Is there any data to read? */
+    if ((SPI1STATbits.SRXMPT == NO) && (SPI2STATbits.SRXMPT == NO)) {
+      uint8_t data;
+
+      data = SPI1BUF;
+
+      if (last_cs_line_state == HIGH) {
+        user_serial_ringbuffer_append('[');
+        last_cs_line_state = LOW;
+      }
+
+      if (terminal_mode) {
+        bp_write_hex_byte_to_ringbuffer(data);
+      } else {
+        user_serial_ringbuffer_append('\\');
+        user_serial_ringbuffer_append(data);
+      }
+
+      data = SPI2BUF;
+
+      if (terminal_mode) {
+        user_serial_ringbuffer_append('(');
+        bp_write_hex_byte_to_ringbuffer(data);
+        user_serial_ringbuffer_append(')');
+      } else {
+        user_serial_ringbuffer_append(data);
+      }
+    }
+
+    /* Check for overflows. */
+    if ((SPI1STATbits.SPIROV == ON) || (SPI2STATbits.SPIROV == ON) ||
+        (bus_pirate_configuration.overflow == YES)) {
+
+      /* Was the overflow coming from the serial port? */
+      if (bus_pirate_configuration.overflow == NO) {
+        user_serial_ringbuffer_flush();
+      }
+      spi_telemetry_count_overruns();
+
+      /*
+       * MSB
+       * 0-0------0----??
+       * | |      |
+       * | |      +--------- SPIROV:  Overflow flag cleared.
+       * | +---------------- SPISIDL: Continue module operation in idle mode.
+       * +------------------ SPIEN:   Module disabled.
+       */
+      SPI1STAT = 0x0000;
+
+      /*
+       * MSB
+       * 0-0------0----??
+       * | |      |
+       * | |      +--------- SPIROV:  Overflow flag cleared.
+       * | +---------------- SPISIDL: Continue module operation in idle mode.
+       * +------------------ SPIEN:   Module disabled.
+       */
+      SPI2STAT = 0x0000;
+
+      if (terminal_mode) {
+        MSG_SPI_COULD_NOT_KEEP_UP;
+        user_serial_ringbuffer_release();
+        goto restart;
+      }
+
+      BP_LEDMODE = OFF;
+      break;
+    }
+
+    user_serial_ringbuffer_process();
+
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+
+      if (terminal_mode) {
+        bpBR;
+      }
+      break;
+    }
+  }
+
+  user_serial_ringbuffer_release();
+
+  spi_slave_disable();
+
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+}
+
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+
+void spi_interrupt_sniffer(bool trigger) {
+  uint16_t tail;
+
+  spi_capture_ring.data = bp_buffer_arena_reserve(SPI_CAPTURE_RING_SIZE);
+  if (spi_capture_ring.data == NULL) {
+    spi_sniffer(trigger, false);
+    return;
+  }
+
+  spi_capture_ring.head = 0;
+  spi_capture_ring.tail = 0;
+  spi_capture_ring.frame_open = false;
+  spi_capture_ring.overflow = false;
+
+  /* The ringbuffer takes what is left of the arena, past the capture ring. */
+  if (!user_serial_ringbuffer_setup()) {
+    bp_buffer_arena_release(spi_capture_ring.data);
+    spi_capture_ring.data = NULL;
+    REPORT_IO_FAILURE();
+    return;
+  }
+  REPORT_IO_SUCCESS();
+  user_serial_wait_transmission_done();
+  spi_disable_interface();
+  spi_slave_enable();
+
+  if (trigger == SPI_SNIFF_ON_CS_LOW) {
+    SPI1CON1bits.SSEN = ON;
+    SPI2CON1bits.SSEN = ON;
+  }
+
+  /* Interrupt as soon as data is available, ahead of the USB interrupt. */
+  SPI1STATbits.SISEL = 0b001;
+  IPC2bits.SPI1IP = 5;
+  IFS0bits.SPI1IF = OFF;
+  IEC0bits.SPI1IE = ON;
+
+  SPI1STATbits.SPIEN = ON;
+  SPI2STATbits.SPIEN = ON;
+
+  for (;;) {
+
+    /* Close the current frame, after whatever is still in the FIFOs. */
+    if (spi_capture_ring.frame_open && (SPICS == HIGH)) {
+      IEC0bits.SPI1IE = OFF;
+      spi_capture_fifo();
+      if (((spi_capture_ring.tail - spi_capture_ring.head - 1) &
+           SPI_CAPTURE_RING_MASK) > 0) {
+        spi_capture_ring_push(']');
+        spi_capture_ring.frame_open = false;
+      } else {
+        spi_capture_ring.overflow = true;
+      }
+      IEC0bits.SPI1IE = ON;
+    }
+
+    /* Hand captured data over to the serial port. */
+    tail = spi_capture_ring.tail;
+    while (tail != spi_capture_ring.head) {
+      user_serial_ringbuffer_append(spi_capture_ring.data[tail]);
+      tail = (tail + 1) & SPI_CAPTURE_RING_MASK;
+    }
+    spi_capture_ring.tail = tail;
+
+    /* Check for overflows. */
+    if ((SPI1STATbits.SPIROV == ON) || (SPI2STATbits.SPIROV == ON) ||
+        spi_capture_ring.overflow ||
+        (bus_pirate_configuration.overflow == YES)) {
+      IEC0bits.SPI1IE = OFF;
+
+      /* Was the overflow coming from the serial port? */
+      if (bus_pirate_configuration.overflow == NO) {
+        user_serial_ringbuffer_flush();
+      }
+      spi_telemetry_count_overruns();
+
+      SPI1STAT = 0x0000;
+      SPI2STAT = 0x0000;
+      BP_LEDMODE = OFF;
+      break;
+    }
+
+    user_serial_ringbuffer_process();
+
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      break;
+    }
+  }
+
+  IEC0bits.SPI1IE = OFF;
+  IFS0bits.SPI1IF = OFF;
+
+  user_serial_ringbuffer_release();
+  bp_buffer_arena_release(spi_capture_ring.data);
+  spi_capture_ring.data = NULL;
+
+  spi_slave_disable();
+
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+}
+
+void spi_capture_ring_push(const uint8_t value) {
+  uint16_t head;
+
+  head = spi_capture_ring.head;
+  spi_capture_ring.data[head] = value;
+  spi_capture_ring.head = (head + 1) & SPI_CAPTURE_RING_MASK;
+}
+
+void spi_capture_fifo(void) {
+  uint8_t mosi;
+  uint8_t miso;
+  uint16_t free_slots;
+
+  while (SPI1STATbits.SRXMPT == NO) {
+
+    /* Both modules are clocked by the same edge, SPI2 cannot lag behind. */
+    while (SPI2STATbits.SRXMPT == YES) {
+    }
+
+    mosi = SPI1BUF;
+    miso = SPI2BUF;
+
+    free_slots =
+        (spi_capture_ring.tail - spi_capture_ring.head - 1) &
+        SPI_CAPTURE_RING_MASK;
+    if (free_slots < (spi_capture_ring.frame_open ? 3 : 4)) {
+      spi_capture_ring.overflow = true;
+      continue;
+    }
+
+    if (!spi_capture_ring.frame_open) {
+      spi_capture_ring_push('[');
+      spi_capture_ring.frame_open = true;
+    }
+    spi_capture_ring_push('\\');
+    spi_capture_ring_push(mosi);
+    spi_capture_ring_push(miso);
+  }
+}
+
+void spi_traffic_statistics(void) {
+  spi_statistics.counters = (spi_traffic_counters_t *)bp_buffer_arena_reserve(
+      SPI_STATISTICS_OPCODES * sizeof(spi_traffic_counters_t));
+  if (spi_statistics.counters == NULL) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  memset(spi_statistics.counters, 0x00,
+         SPI_STATISTICS_OPCODES * sizeof(spi_traffic_counters_t));
+  spi_statistics.frame_open = false;
+  spi_statistics.discarding = false;
+  spi_statistics.overrun = false;
+  spi_statistics.opcode = 0x00;
+
+  spi_disable_interface();
+  spi_slave_enable();
+  SPI1CON1bits.SSEN = ON;
+  SPI2CON1bits.SSEN = ON;
+
+  /* Interrupt as soon as data is available, ahead of the USB interrupt. */
+  SPI1STATbits.SISEL = 0b001;
+  IPC2bits.SPI1IP = 5;
+  IFS0bits.SPI1IF = OFF;
+  IEC0bits.SPI1IE = ON;
+
+  SPI1STATbits.SPIEN = ON;
+  SPI2STATbits.SPIEN = ON;
+
+  REPORT_IO_SUCCESS();
+
+  for (;;) {
+    while (!user_serial_ready_to_read()) {
+      spi_traffic_statistics_service();
+    }
 
-  case SPI_MACRO_EDGE_ACTIVE_TO_IDLE:
-    spi_state.clock_edge = SPI_TRANSITION_FROM_ACTIVE_TO_IDLE;
-    goto cleanup;
+    switch (user_serial_read_byte()) {
+    case SPI_STATISTICS_COMMAND_STOP:
+      break;
 
-  case SPI_MACRO_SAMPLING_ON_MIDDLE:
-    spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE;
-    goto cleanup;
+    case SPI_STATISTICS_COMMAND_READ:
+      spi_traffic_statistics_send(false);
+      continue;
 
-  case SPI_MACRO_SAMPLING_ON_END:
-    spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_END;
+    case SPI_STATISTICS_COMMAND_READ_AND_CLEAR:
+      spi_traffic_statistics_send(true);
+      continue;
 
-  cleanup:
-    SPI1CON1bits.CKP = spi_state.clock_polarity;
-    SPI1CON1bits.CKE = spi_state.clock_edge;
-    SPI1CON1bits.SMP = spi_state.data_sample_timing;
-    spi_print_settings();
-    break;
+    default:
+      REPORT_IO_FAILURE();
+      continue;
+    }
 
-  default:
-    MSG_UNKNOWN_MACRO_ERROR;
     break;
   }
-}
 
-void spi_print_pins_state(void) { MSG_SPI_PINS_STATE; }
+  IEC0bits.SPI1IE = OFF;
+  IFS0bits.SPI1IF = OFF;
 
-void spi_setup(const uint8_t spi_speed) {
-  /* Disable interface. */
-  SPI1STATbits.SPIEN = OFF;
+  spi_slave_disable();
 
-  /* Set SPI to open drain if high impedance is on. */
-  if (mode_configuration.high_impedance == ON) {
-    SPIMOSI_ODC = ON;
-    SPICLK_ODC = ON;
-    SPICS_ODC = ON;
-  } else {
-    SPIMOSI_ODC = OFF;
-    SPICLK_ODC = OFF;
-    SPICS_ODC = OFF;
-  }
+  bp_buffer_arena_release((uint8_t *)spi_statistics.counters);
+  spi_statistics.counters = NULL;
 
-  /* Assign pins routing. */
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+  REPORT_IO_SUCCESS();
+}
 
-  RPINR20bits.SDI1R = BP_MISO_RPIN;
-  BP_MOSI_RPOUT = SDO1_IO;
-  BP_CLK_RPOUT = SCK1OUT_IO;
-  SPICS = HIGH;
-  SPICS_TRIS = OUTPUT;
-  SPICLK_TRIS = OUTPUT;
-  SPIMISO_TRIS = INPUT;
-  SPIMOSI_TRIS = OUTPUT;
+void spi_traffic_statistics_send(const bool clear) {
+  uint8_t seen[SPI_STATISTICS_OPCODES / 8];
+  spi_traffic_counters_t counters;
+  uint16_t opcode;
+  uint16_t count;
+  uint8_t flags;
+
+  /* Only opcodes seen now are sent, the count must match. */
+  memset(seen, 0x00, sizeof(seen));
+  count = 0;
+  for (opcode = 0; opcode < SPI_STATISTICS_OPCODES; opcode++) {
+    IEC0bits.SPI1IE = OFF;
+    if (spi_statistics.counters[opcode].frames != 0) {
+      seen[opcode >> 3] |= 1 << (opcode & 0x07);
+      count++;
+    }
+    IEC0bits.SPI1IE = ON;
+  }
 
-  /*
-   * MSB
-   * ---000xx0x1xxxxx
-   *    |||||||||||||
-   *    |||||||||||++--- PPRE:   Primary prescale bits.
-   *    ||||||||+++----- SPRE:   Secondary prescale bits.
-   *    |||||||+-------- MSTEN:  Master mode.
-   *    ||||||+--------- CKP:    Clock idle LOW.
-   *    |||||+---------- SSEN:   Pin controlled by port function.
-   *    ||||+----------- CKE:    Transition happens from idle to active.
-   *    |||+------------ SMP:    Flag indicating when the data is sampled.
-   *    ||+------------- MODE16: Communication is byte-wide.
-   *    |+-------------- DISSDO: SDO1 pin is controlled by the module.
-   *    +--------------- DISSCK: Internal SPI clock is enabled.
-   */
-  SPI1CON1 =
-      (MASKBOTTOM8(spi_speed, 5) << _SPI1CON1_PPRE_POSITION) |
-      (ON << _SPI1CON1_MSTEN_POSITION) |
-      (MASKBOTTOM8(spi_state.clock_polarity, 1) << _SPI1CON1_CKP_POSITION) |
-      (MASKBOTTOM8(spi_state.clock_edge, 1) << _SPI1CON1_CKE_POSITION) |
-      (MASKBOTTOM8(spi_state.data_sample_timing, 1) << _SPI1CON1_SMP_POSITION);
+  flags = spi_statistics.overrun ? SPI_STATISTICS_FLAG_OVERRUN : 0x00;
+  spi_statistics.overrun = false;
 
-  /*
-   * MSB
-   * 000-----------0-
-   * |||           |
-   * |||           +---- FRMDLY: Frame sync pulse precedes first bit clock.
-   * ||+---------------- FRMPOL: Frame sync pulse is active low.
-   * |+----------------- SPIFSD: Frame sync pulse output.
-   * +------------------ FRMEN:  Framed SPI1 support disabled.
-   */
-  SPI1CON2 = 0x0000;
+  REPORT_IO_SUCCESS();
+  spi_traffic_statistics_transmit(flags);
+  spi_traffic_statistics_transmit(HI8(count));
+  spi_traffic_statistics_transmit(LO8(count));
 
-  /*
-   * MSB
-   * 0-0------0----??
-   * | |      |
-   * | |      +--------- SPIROV:  Overflow flag cleared.
-   * | +---------------- SPISIDL: Continue module operation in idle mode.
-   * +------------------ SPIEN:   Module disabled.
-   */
-  SPI1STAT = 0x0000;
+  for (opcode = 0; opcode < SPI_STATISTICS_OPCODES; opcode++) {
+    if (!(seen[opcode >> 3] & (1 << (opcode & 0x07)))) {
+      continue;
+    }
 
-  /* Enable the interface. */
-  SPI1STATbits.SPIEN = ON;
+    IEC0bits.SPI1IE = OFF;
+    counters = spi_statistics.counters[opcode];
+    if (clear) {
+      memset(&spi_statistics.counters[opcode], 0x00,
+             sizeof(spi_traffic_counters_t));
+    }
+    IEC0bits.SPI1IE = ON;
+
+    spi_traffic_statistics_transmit(opcode);
+    spi_traffic_statistics_transmit(HI8(HI16(counters.frames)));
+    spi_traffic_statistics_transmit(LO8(HI16(counters.frames)));
+    spi_traffic_statistics_transmit(HI8(LO16(counters.frames)));
+    spi_traffic_statistics_transmit(LO8(LO16(counters.frames)));
+    spi_traffic_statistics_transmit(HI8(HI16(counters.bytes)));
+    spi_traffic_statistics_transmit(LO8(HI16(counters.bytes)));
+    spi_traffic_statistics_transmit(HI8(LO16(counters.bytes)));
+    spi_traffic_statistics_transmit(LO8(LO16(counters.bytes)));
+  }
 }
 
-void spi_disable_interface(void) {
-
-  /* Disable interface. */
-  SPI1STATbits.SPIEN = OFF;
+void spi_traffic_statistics_transmit(const uint8_t value) {
+  spi_traffic_statistics_service();
+  user_serial_transmit_character(value);
+}
 
-  /* Deassign pins. */
-  RPINR20bits.SDI1R = 0b11111;
-  BP_MOSI_RPOUT = 0b00000;
-  BP_CLK_RPOUT = 0b00000;
+void spi_traffic_statistics_service(void) {
+  if ((SPI1STATbits.SPIROV == ON) || (SPI2STATbits.SPIROV == ON)) {
+    IEC0bits.SPI1IE = OFF;
+    spi_telemetry_count_overruns();
+    spi_traffic_statistics_fifo();
+    SPI1STATbits.SPIROV = OFF;
+    SPI2STATbits.SPIROV = OFF;
+    spi_statistics.frame_open = true;
+    spi_statistics.discarding = true;
+    spi_statistics.overrun = true;
+    IEC0bits.SPI1IE = ON;
+  }
 
-  /* Disable open drain. */
-  SPIMOSI_ODC = OFF;
-  SPICLK_ODC = OFF;
-  SPICS_ODC = OFF;
+  /* Close the current frame, after whatever is still in the FIFOs. */
+  if (spi_statistics.frame_open && (SPICS == HIGH)) {
+    IEC0bits.SPI1IE = OFF;
+    spi_traffic_statistics_fifo();
+    spi_statistics.frame_open = false;
+    spi_statistics.discarding = false;
+    IEC0bits.SPI1IE = ON;
+  }
 }
 
-uint8_t spi_write_byte(const uint8_t value) {
-  uint8_t result;
+void spi_traffic_statistics_fifo(void) {
+  uint8_t mosi;
 
-  /* Put the value on the bus. */
-  SPI1BUF = value;
+  while (SPI1STATbits.SRXMPT == NO) {
 
-  /* Wait until a byte has been read. */
-  while (!IFS0bits.SPI1IF) {
-  }
+    /* Both modules are clocked by the same edge, SPI2 cannot lag behind. */
+    while (SPI2STATbits.SRXMPT == YES) {
+    }
 
-  /* Get the byte read from the bus. */
-  result = SPI1BUF;
+    mosi = SPI1BUF;
+    (void)SPI2BUF;
 
-  /* Free the SPI interface. */
-  IFS0bits.SPI1IF = OFF;
+    if (spi_statistics.discarding) {
+      continue;
+    }
 
-  return result;
+    if (!spi_statistics.frame_open) {
+      spi_statistics.frame_open = true;
+      spi_statistics.opcode = mosi;
+      spi_statistics.counters[mosi].frames++;
+    }
+    spi_statistics.counters[spi_statistics.opcode].bytes++;
+  }
 }
 
-void spi_sniffer(bool trigger, bool terminal_mode) {
-  bool last_cs_line_state;
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
 
-restart:
+#if defined(BP_SPI_ENABLE_INTERRUPT_SNIFFER) ||                                \
+    defined(BP_SPI_ENABLE_FLASH_EMULATOR)
 
-  last_cs_line_state = HIGH;
+void __attribute__((interrupt, no_auto_psv)) _SPI1Interrupt(void) {
 
-  user_serial_ringbuffer_setup();
+  /* Clear the flag first, so data arriving meanwhile raises it again. */
+  IFS0bits.SPI1IF = OFF;
+
+#ifdef BP_SPI_ENABLE_FLASH_EMULATOR
+  if (spi_flash_emulator.active) {
+    spi_flash_emulator_service();
+    return;
+  }
+#endif /* BP_SPI_ENABLE_FLASH_EMULATOR */
+
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+  if (spi_statistics.counters != NULL) {
+    spi_traffic_statistics_fifo();
+    return;
+  }
+
+  spi_capture_fifo();
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
+}
+
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER || BP_SPI_ENABLE_FLASH_EMULATOR */
+
+void spi_framed_sniffer(const uint8_t options, const uint8_t opcode,
+                        const uint8_t opcode_mask) {
+  bool cs_asserted;
+  bool pending_start;
+  bool have_pair;
+  bool filtering;
+  bool dropping;
+  uint16_t last_tick;
+  uint16_t repeat_delta;
+  uint16_t repeat_count;
+  uint8_t last_mosi;
+  uint8_t last_miso;
+  uint8_t mosi;
+  uint8_t miso;
+
+  cs_asserted = false;
+  pending_start = false;
+  have_pair = false;
+  repeat_delta = 0;
+  repeat_count = 0;
+  last_mosi = 0;
+  last_miso = 0;
+  filtering = (options & SPI_SNIFFER_OPTION_OPCODE_FILTER) != 0;
+  dropping = filtering;
+
+  if (!user_serial_ringbuffer_setup()) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+  /* The ringbuffer writes into UART1 directly, the code must go first. */
+  REPORT_IO_SUCCESS();
+  user_serial_wait_transmission_done();
   spi_disable_interface();
   spi_slave_enable();
 
-  if (trigger == SPI_SNIFF_ON_CS_LOW) {
+  if (options & SPI_SNIFFER_OPTION_CS_LOW_ONLY) {
     SPI1CON1bits.SSEN = ON;
     SPI2CON1bits.SSEN = ON;
   }
 
+  /*
+   * T1CON - TIMER 1 CONTROL REGISTER
+   *
+   * MSB
+   * 1-0-------10-0-
+   * | |       || |
+   * | |       || +---- TCS:   Internal clock (Fosc/2).
+   * | |       ++------ TCKPS: 1:64 Prescaler (4us per tick).
+   * | +--------------- TSIDL: Continue module operation in idle mode.
+   * +----------------- TON:   Timer ON.
+   */
+  PR1 = 0xFFFF;
+  TMR1 = 0x0000;
+  IFS0bits.T1IF = OFF;
+  T1CON = (ON << _T1CON_TON_POSITION) | (0b10 << _T1CON_TCKPS_POSITION);
+  last_tick = 0;
+
   SPI1STATbits.SPIEN = ON;
   SPI2STATbits.SPIEN = ON;
 
   for (;;) {
 
-    /* Detect a CS line state change. */
-    if ((last_cs_line_state == LOW) && (SPICS == HIGH)) {
-      user_serial_ringbuffer_append(']');
-      last_cs_line_state = HIGH;
+    /* Detect CS line state changes. */
+    if ((cs_asserted == false) && (SPICS == LOW)) {
+      cs_asserted = true;
+      pending_start = true;
+    } else if ((cs_asserted == true) && (SPICS == HIGH)) {
+      cs_asserted = false;
+
+      /* Frames left out, or with no data at all, are not closed either. */
+      if (!filtering || (!dropping && !pending_start)) {
+        if (repeat_count > 0) {
+          spi_framed_sniffer_append(SPI_SNIFFER_RECORD_REPEAT | repeat_delta,
+                                    repeat_count >> 8, repeat_count & 0xFF);
+          repeat_count = 0;
+        }
+        spi_framed_sniffer_append(SPI_SNIFFER_RECORD_CS_RELEASED |
+                                      spi_framed_sniffer_delta(&last_tick),
+                                  0x00, 0x00);
+      }
+      pending_start = false;
+      have_pair = false;
+      dropping = filtering;
     }
 
     /* Is there any data to read? */
     if ((SPI1STATbits.SRXMPT == NO) && (SPI2STATbits.SRXMPT == NO)) {
-      uint8_t data;
+      mosi = SPI1BUF;
+      miso = SPI2BUF;
 
-      data = SPI1BUF;
-
-      if (last_cs_line_state == HIGH) {
-        user_serial_ringbuffer_append('[');
-        last_cs_line_state = LOW;
-      }
-
-      if (terminal_mode) {
-        bp_write_hex_byte_to_ringbuffer(data);
-      } else {
-        user_serial_ringbuffer_append('\\');
-        user_serial_ringbuffer_append(data);
+      if (filtering && pending_start) {
+        dropping = (mosi & opcode_mask) != (opcode & opcode_mask);
+        if (dropping) {
+          pending_start = false;
+        }
       }
 
-      data = SPI2BUF;
-
-      if (terminal_mode) {
-        user_serial_ringbuffer_append('(');
-        bp_write_hex_byte_to_ringbuffer(data);
-        user_serial_ringbuffer_append(')');
+      if (dropping) {
+        /* Left out by the opcode filter. */
+      } else if (!pending_start && have_pair && (mosi == last_mosi) &&
+                 (miso == last_miso) && (repeat_count < 0xFFFF)) {
+        /* Only the most recent repetition timing is kept. */
+        repeat_delta = ((repeat_count == 0) ? 0 : repeat_delta) +
+                       spi_framed_sniffer_delta(&last_tick);
+        if (repeat_delta > SPI_SNIFFER_RECORD_DELTA_MASK) {
+          repeat_delta = SPI_SNIFFER_RECORD_DELTA_MASK;
+        }
+        repeat_count++;
       } else {
-        user_serial_ringbuffer_append(data);
+        if (repeat_count > 0) {
+          spi_framed_sniffer_append(SPI_SNIFFER_RECORD_REPEAT | repeat_delta,
+                                    repeat_count >> 8, repeat_count & 0xFF);
+          repeat_count = 0;
+        }
+        spi_framed_sniffer_append(
+            (pending_start ? SPI_SNIFFER_RECORD_CS_ASSERTED : 0x0000) |
+                spi_framed_sniffer_delta(&last_tick),
+            mosi, miso);
+        pending_start = false;
+        have_pair = true;
+        last_mosi = mosi;
+        last_miso = miso;
       }
     }
 
-    /* Check for overflows. */
+    /* Give up on overflows, records cannot be dropped silently. */
     if ((SPI1STATbits.SPIROV == ON) || (SPI2STATbits.SPIROV == ON) ||
         (bus_pirate_configuration.overflow == YES)) {
-
-      /* Was the overflow coming from the serial port? */
       if (bus_pirate_configuration.overflow == NO) {
         user_serial_ringbuffer_flush();
       }
+      spi_telemetry_count_overruns();
+      SPI1STAT = 0x0000;
+      SPI2STAT = 0x0000;
+      BP_LEDMODE = OFF;
+      break;
+    }
+
+    user_serial_ringbuffer_process();
+
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      if (repeat_count > 0) {
+        spi_framed_sniffer_append(SPI_SNIFFER_RECORD_REPEAT | repeat_delta,
+                                  repeat_count >> 8, repeat_count & 0xFF);
+      }
+      user_serial_ringbuffer_flush();
+      break;
+    }
+  }
+
+  T1CON = 0x0000;
+
+  user_serial_ringbuffer_release();
+
+  spi_slave_disable();
+
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+}
+
+void spi_framed_sniffer_append(const uint16_t header, const uint8_t first,
+                               const uint8_t second) {
+  user_serial_ringbuffer_append(header >> 8);
+  user_serial_ringbuffer_append(header & 0xFF);
+  user_serial_ringbuffer_append(first);
+  user_serial_ringbuffer_append(second);
+}
+
+uint16_t spi_framed_sniffer_delta(uint16_t *last_tick) {
+  uint16_t now;
+  uint16_t delta;
+  bool wrapped;
+
+  now = TMR1;
+  wrapped = IFS0bits.T1IF;
+  IFS0bits.T1IF = OFF;
+
+  /* A wrap with the counter past the previous value is a full period. */
+  if (wrapped && (now >= *last_tick)) {
+    delta = SPI_SNIFFER_RECORD_DELTA_MASK;
+  } else {
+    delta = now - *last_tick;
+    if (delta > SPI_SNIFFER_RECORD_DELTA_MASK) {
+      delta = SPI_SNIFFER_RECORD_DELTA_MASK;
+    }
+  }
+
+  *last_tick = now;
+  return delta;
+}
+
+#ifdef BP_SPI_ENABLE_FLASH_EMULATOR
+
+void handle_flash_emulator(void) {
+  uint16_t size;
+  uint16_t offset;
+  bool frame_open;
+
+  spi_flash_emulator.identifier[0] = user_serial_read_byte();
+  spi_flash_emulator.identifier[1] = user_serial_read_byte();
+  spi_flash_emulator.identifier[2] = user_serial_read_byte();
+  size = user_serial_read_byte() << 8;
+  size |= user_serial_read_byte();
+
+  if ((size == 0) || (size > BP_TERMINAL_BUFFER_SIZE)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  for (offset = 0; offset < size; offset++) {
+    bus_pirate_configuration.terminal_input[offset] = user_serial_read_byte();
+  }
+
+  spi_flash_emulator.image = bus_pirate_configuration.terminal_input;
+  spi_flash_emulator.size = size;
+  spi_flash_emulator.commands = 0;
+
+  spi_disable_interface();
+  spi_slave_enable();
+
+  /* Only talk while selected, MISO is driven by SDO1. */
+  SPI1CON1bits.SSEN = ON;
+  SPI1CON1bits.DISSDO = OFF;
+  BP_MISO_ODC = mode_configuration.high_impedance ? ON : OFF;
+  BP_MISO_RPOUT = SDO1_IO;
+  SPIMISO_TRIS = OUTPUT;
+
+  /* Interrupt as soon as data is available, ahead of the USB interrupt. */
+  SPI1STATbits.SISEL = 0b001;
+  IPC2bits.SPI1IP = 5;
+  spi_flash_emulator_reset_frame();
+  frame_open = false;
+  spi_flash_emulator.active = true;
+  IFS0bits.SPI1IF = OFF;
+  IEC0bits.SPI1IE = ON;
+
+  REPORT_IO_SUCCESS();
+
+  for (;;) {
+
+    /* A new command starts with every CS frame. */
+    if (SPICS == LOW) {
+      frame_open = true;
+    } else if (frame_open) {
+      IEC0bits.SPI1IE = OFF;
+      spi_flash_emulator_reset_frame();
+      IEC0bits.SPI1IE = ON;
+      frame_open = false;
+    }
+
+    if (user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      break;
+    }
+  }
+
+  IEC0bits.SPI1IE = OFF;
+  IFS0bits.SPI1IF = OFF;
+  spi_flash_emulator.active = false;
+
+  SPIMISO_TRIS = INPUT;
+  BP_MISO_RPOUT = 0b00000;
+  BP_MISO_ODC = OFF;
+  spi_slave_disable();
+
+  REPORT_IO_SUCCESS();
+  user_serial_transmit_character(HI8(spi_flash_emulator.commands));
+  user_serial_transmit_character(LO8(spi_flash_emulator.commands));
+
+  spi_setup(spi_bus_speed[mode_configuration.speed]);
+}
+
+void spi_flash_emulator_reset_frame(void) {
+
+  /* Turning the module off empties both FIFOs. */
+  SPI1STATbits.SPIEN = OFF;
+  SPI1STATbits.SPIROV = OFF;
+  spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_COMMAND;
+  SPI1STATbits.SPIEN = ON;
+}
+
+void spi_flash_emulator_service(void) {
+  uint8_t value;
+
+  while (SPI1STATbits.SRXMPT == NO) {
+    value = SPI1BUF;
+
+    switch (spi_flash_emulator.state) {
+    case SPI_FLASH_EMULATOR_STATE_COMMAND:
+      switch (value) {
+      case SPI_FLASH_EMULATOR_READ:
+      case SPI_FLASH_EMULATOR_FAST_READ:
+        spi_flash_emulator.address = 0;
+        spi_flash_emulator.address_bytes_left = 3;
+        spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_ADDRESS;
+        break;
 
-      /*
-       * MSB
-       * 0-0------0----??
-       * | |      |
-       * | |      +--------- SPIROV:  Overflow flag cleared.
-       * | +---------------- SPISIDL: Continue module operation in idle mode.
-       * +------------------ SPIEN:   Module disabled.
-       */
-      SPI1STAT = 0x0000;
+      case SPI_FLASH_EMULATOR_READ_ID:
+        spi_flash_emulator.identifier_index = 0;
+        spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_IDENTIFIER;
+        spi_flash_emulator.commands++;
+        break;
 
-      /*
-       * MSB
-       * 0-0------0----??
-       * | |      |
-       * | |      +--------- SPIROV:  Overflow flag cleared.
-       * | +---------------- SPISIDL: Continue module operation in idle mode.
-       * +------------------ SPIEN:   Module disabled.
-       */
-      SPI2STAT = 0x0000;
+      case SPI_FLASH_EMULATOR_READ_STATUS:
+        spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_STATUS;
+        spi_flash_emulator.commands++;
+        break;
 
-      if (terminal_mode) {
-        MSG_SPI_COULD_NOT_KEEP_UP;
-        goto restart;
+      default:
+        spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_IGNORE;
+        break;
       }
+      break;
 
-      BP_LEDMODE = OFF;
+    case SPI_FLASH_EMULATOR_STATE_ADDRESS:
+      spi_flash_emulator.address = (spi_flash_emulator.address << 8) | value;
+      if (--spi_flash_emulator.address_bytes_left == 0) {
+        spi_flash_emulator.offset =
+            spi_flash_emulator.address % spi_flash_emulator.size;
+        spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_DATA;
+        spi_flash_emulator.commands++;
+      }
+      break;
+
+    default:
+      /* Whatever the master clocks in while we answer is of no use. */
       break;
     }
+  }
 
-    user_serial_ringbuffer_process();
+  /* Keep the transmit FIFO full, so the master can clock back to back. */
+  switch (spi_flash_emulator.state) {
+  case SPI_FLASH_EMULATOR_STATE_DATA:
+    while (SPI1STATbits.SPITBF == NO) {
+      SPI1BUF = spi_flash_emulator.image[spi_flash_emulator.offset];
+      if (++spi_flash_emulator.offset == spi_flash_emulator.size) {
+        spi_flash_emulator.offset = 0;
+      }
+    }
+    break;
 
-    if (user_serial_ready_to_read()) {
-      user_serial_read_byte();
+  case SPI_FLASH_EMULATOR_STATE_IDENTIFIER:
+    while ((SPI1STATbits.SPITBF == NO) &&
+           (spi_flash_emulator.identifier_index <
+            sizeof(spi_flash_emulator.identifier))) {
+      SPI1BUF = spi_flash_emulator
+                    .identifier[spi_flash_emulator.identifier_index++];
+    }
+    break;
 
-      if (terminal_mode) {
-        bpBR;
-      }
-      break;
+  case SPI_FLASH_EMULATOR_STATE_STATUS:
+    /* Never busy and never write enabled, as nothing can be written. */
+    while (SPI1STATbits.SPITBF == NO) {
+      SPI1BUF = 0x00;
     }
-  }
+    break;
 
-  spi_slave_disable();
+  default:
+    break;
+  }
 
-  spi_setup(spi_bus_speed[mode_configuration.speed]);
+  /* Losing data would make every following byte meaningless. */
+  if (SPI1STATbits.SPIROV == ON) {
+    SPI1STATbits.SPIROV = OFF;
+    spi_flash_emulator.state = SPI_FLASH_EMULATOR_STATE_IGNORE;
+  }
 }
 
+#endif /* BP_SPI_ENABLE_FLASH_EMULATOR */
+
 void spi_slave_enable(void) {
 
   /* Assign slave SPI pin directions. */
@@ -754,6 +2384,16 @@ void spi_slave_enable(void) {
   SPI2CON2bits.SPIBEN = ON;
 }
 
+void spi_telemetry_count_overruns(void) {
+  if (SPI1STATbits.SPIROV == ON) {
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_SPI_OVERRUNS);
+  }
+  if (SPI2STATbits.SPIROV == ON) {
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_SPI_OVERRUNS);
+  }
+  bp_notify(BP_NOTIFICATION_OVERFLOW);
+}
+
 void spi_slave_disable(void) {
 
   /* Turn the modules off. */
@@ -773,29 +2413,75 @@ void spi_slave_disable(void) {
   RPINR22bits.SCK2R = 0b11111;
 }
 
-void spi_enter_binary_io(void) {
+void spi_enter_binary_io(const bool restore_settings) {
   uint8_t input_byte;
   uint8_t command;
 
-  mode_configuration.speed = 1;
-  spi_state.clock_polarity = SPI_CLOCK_IDLE_LOW;
-  spi_state.clock_edge = SPI_TRANSITION_FROM_ACTIVE_TO_IDLE;
-  spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE;
-  mode_configuration.high_impedance = ON;
+  if (restore_settings && spi_binary_io_settings.saved) {
+    mode_configuration.speed = spi_binary_io_settings.speed;
+    spi_state.clock_polarity = spi_binary_io_settings.state.clock_polarity;
+    spi_state.clock_edge = spi_binary_io_settings.state.clock_edge;
+    spi_state.data_sample_timing =
+        spi_binary_io_settings.state.data_sample_timing;
+    spi_state.word_transfers = spi_binary_io_settings.state.word_transfers;
+    mode_configuration.high_impedance = spi_binary_io_settings.high_impedance;
+  } else {
+    mode_configuration.speed = 1;
+    spi_state.clock_polarity = SPI_CLOCK_IDLE_LOW;
+    spi_state.clock_edge = SPI_TRANSITION_FROM_ACTIVE_TO_IDLE;
+    spi_state.data_sample_timing = SPI_SAMPLING_ON_DATA_OUTPUT_MIDDLE;
+    spi_state.word_transfers = OFF;
+    mode_configuration.high_impedance = ON;
+  }
+#ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
+  /* Parts come out of reset with the extended address cleared. */
+  avr_extended_address = 0;
+#endif /* BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS */
   spi_setup(spi_bus_speed[mode_configuration.speed]);
   MSG_SPI_MODE_IDENTIFIER;
 
   for (;;) {
     input_byte = user_serial_read_byte();
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_SPI, input_byte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
     command = input_byte >> 4;
 
     switch (command) {
     case SPI_COMMAND_BASE:
+      if (spi_state.word_transfers &&
+          !spi_base_command_takes_words(input_byte)) {
+        REPORT_IO_FAILURE();
+        break;
+      }
+
       switch (input_byte) {
       case SPI_BASE_COMMAND_EXIT:
+        spi_binary_io_settings.state = spi_state;
+        spi_binary_io_settings.speed = mode_configuration.speed;
+        spi_binary_io_settings.high_impedance =
+            mode_configuration.high_impedance ? ON : OFF;
+        spi_binary_io_settings.saved = ON;
+        /* Terminal mode transfers are always byte-wide. */
+        spi_state.word_transfers = OFF;
         spi_disable_interface();
         return;
 
+      case SPI_BASE_COMMAND_SET_WORD_SIZE: {
+        uint8_t flags;
+
+        flags = user_serial_read_byte();
+        if (flags & ~SPI_WORD_SIZE_FLAGS_MASK) {
+          REPORT_IO_FAILURE();
+          break;
+        }
+
+        spi_state.word_transfers =
+            (flags & SPI_WORD_SIZE_FLAG_16_BITS) ? ON : OFF;
+        spi_setup(spi_bus_speed[mode_configuration.speed]);
+        REPORT_IO_SUCCESS();
+        break;
+      }
+
       case SPI_BASE_COMMAND_SEND_IDENTIFIER:
         MSG_SPI_MODE_IDENTIFIER;
         break;
@@ -811,20 +2497,53 @@ void spi_enter_binary_io(void) {
         break;
 
       case SPI_BASE_COMMAND_SNIFF_ALL_TRAFFIC:
-        REPORT_IO_SUCCESS();
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+        spi_interrupt_sniffer(SPI_SNIFF_ALWAYS);
+#else
         spi_sniffer(SPI_SNIFF_ALWAYS, false);
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
         break;
 
       case SPI_BASE_COMMAND_SNIFF_WHEN_CS_LOW:
-        REPORT_IO_SUCCESS();
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+        spi_interrupt_sniffer(SPI_SNIFF_ON_CS_LOW);
+#else
         spi_sniffer(SPI_SNIFF_ON_CS_LOW, false);
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
         break;
 
+#ifdef BP_SPI_ENABLE_INTERRUPT_SNIFFER
+      case SPI_BASE_COMMAND_TRAFFIC_STATISTICS:
+        spi_traffic_statistics();
+        break;
+#endif /* BP_SPI_ENABLE_INTERRUPT_SNIFFER */
+
+      case SPI_BASE_COMMAND_SNIFF_FRAMED: {
+        uint8_t options;
+
+        uint8_t opcode;
+        uint8_t opcode_mask;
+
+        options = user_serial_read_byte();
+        opcode = 0x00;
+        opcode_mask = 0x00;
+        if (options & SPI_SNIFFER_OPTION_OPCODE_FILTER) {
+          opcode = user_serial_read_byte();
+          opcode_mask = user_serial_read_byte();
+        }
+        if (options & ~SPI_SNIFFER_OPTIONS_MASK) {
+          REPORT_IO_FAILURE();
+          break;
+        }
+
+        spi_framed_sniffer(options, opcode, opcode_mask);
+        break;
+      }
+
       case SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS:
       case SPI_BASE_COMMAND_WRITE_AND_READ_WITHOUT_CS: {
         uint16_t bytes_to_write;
         uint16_t bytes_to_read;
-        uint16_t offset;
 
         /* How many bytes to send to the bus. */
         bytes_to_write =
@@ -841,10 +2560,36 @@ void spi_enter_binary_io(void) {
           break;
         }
 
-        /* Read data buffer from the serial port. */
-        for (offset = 0; offset < bytes_to_write; offset++) {
-          bus_pirate_configuration.terminal_input[offset] =
-              user_serial_read_byte();
+        if (spi_state.word_transfers) {
+          uint16_t offset;
+
+          /* Only whole words can go on the bus. */
+          if ((bytes_to_write | bytes_to_read) & 1) {
+            REPORT_IO_FAILURE();
+            break;
+          }
+
+          for (offset = 0; offset < bytes_to_write; offset++) {
+            bus_pirate_configuration.terminal_input[offset] =
+                user_serial_read_byte();
+          }
+
+          if (input_byte == SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS) {
+            SPICS = LOW;
+          }
+          spi_transfer_words(bus_pirate_configuration.terminal_input, NULL,
+                             bytes_to_write);
+          bp_delay_us(1);
+          spi_transfer_words(NULL, bus_pirate_configuration.terminal_input,
+                             bytes_to_read);
+          if (input_byte == SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS) {
+            SPICS = HIGH;
+          }
+
+          REPORT_IO_SUCCESS();
+          bp_write_buffer(bus_pirate_configuration.terminal_input,
+                          bytes_to_read);
+          break;
         }
 
         /* Update the CS line if needed. */
@@ -852,19 +2597,25 @@ void spi_enter_binary_io(void) {
           SPICS = LOW;
         }
 
-        /* Writes data to the SPI bus. */
-        for (offset = 0; offset < bytes_to_write; offset++) {
-          spi_write_byte(bus_pirate_configuration.terminal_input[offset]);
+        /* Writes data to the SPI bus as it comes from the serial port. */
+#ifdef BUSPIRATEV4
+        spi_write_from_serial_zero_copy(bytes_to_write);
+#else
+        if (!spi_write_from_serial_double_buffered(bytes_to_write)) {
+          if (input_byte == SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS) {
+            SPICS = HIGH;
+          }
+          REPORT_IO_FAILURE();
+          break;
         }
+#endif /* BUSPIRATEV4 */
 
         /* Wait for the bus to settle. */
         bp_delay_us(1);
 
         /* Read data from the SPI bus. */
-        for (offset = 0; offset < bytes_to_read; offset++) {
-          bus_pirate_configuration.terminal_input[offset] =
-              spi_write_byte(0xFF);
-        }
+        spi_transfer_buffer(NULL, bus_pirate_configuration.terminal_input,
+                            bytes_to_read);
 
         /* Update the CS line if needed. */
         if (input_byte == SPI_BASE_COMMAND_WRITE_AND_READ_WITH_CS) {
@@ -875,14 +2626,27 @@ void spi_enter_binary_io(void) {
         REPORT_IO_SUCCESS();
 
         /* Output read data to the serial port. */
-        for (offset = 0; offset < bytes_to_read; offset++) {
-          user_serial_transmit_character(
-              bus_pirate_configuration.terminal_input[offset]);
-        }
+        bp_write_buffer(bus_pirate_configuration.terminal_input, bytes_to_read);
 
         break;
       }
 
+      case SPI_BASE_COMMAND_STREAMING_WRITE_AND_READ:
+        handle_streaming_write_then_read();
+        break;
+
+      case SPI_BASE_COMMAND_RUN_SCRIPT:
+        handle_run_script();
+        break;
+
+#ifdef BP_SPI_ENABLE_FLASH_EMULATOR
+
+      case SPI_BASE_COMMAND_EMULATE_FLASH:
+        handle_flash_emulator();
+        break;
+
+#endif /* BP_SPI_ENABLE_FLASH_EMULATOR */
+
 #ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
 
       case SPI_BASE_COMMAND_EXTENDED_AVR_COMMAND:
@@ -891,6 +2655,15 @@ void spi_enter_binary_io(void) {
 
 #endif /* BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS */
 
+#ifdef BP_SPI_ENABLE_FLASH_ENGINE
+
+      case SPI_BASE_COMMAND_FLASH_ENGINE:
+        spi_flash_enter_binary_io();
+        MSG_SPI_MODE_IDENTIFIER;
+        break;
+
+#endif /* BP_SPI_ENABLE_FLASH_ENGINE */
+
       default:
         REPORT_IO_FAILURE();
         break;
@@ -903,13 +2676,36 @@ void spi_enter_binary_io(void) {
       uint8_t count;
 
       bytes_to_read = (input_byte & 0x0F) + 1;
+      if (spi_state.word_transfers && (bytes_to_read & 1)) {
+        REPORT_IO_FAILURE();
+        break;
+      }
       REPORT_IO_SUCCESS();
       for (count = 0; count < bytes_to_read; count++) {
-        user_serial_transmit_character(spi_write_byte(user_serial_read_byte()));
+        bus_pirate_configuration.terminal_input[count] =
+            user_serial_read_byte();
+      }
+      if (spi_state.word_transfers) {
+        spi_transfer_words(bus_pirate_configuration.terminal_input,
+                           bus_pirate_configuration.terminal_input,
+                           bytes_to_read);
+      } else {
+        spi_transfer_buffer(bus_pirate_configuration.terminal_input,
+                            bus_pirate_configuration.terminal_input,
+                            bytes_to_read);
       }
+      bp_write_buffer(bus_pirate_configuration.terminal_input, bytes_to_read);
       break;
     }
 
+    case SPI_COMMAND_TELEMETRY:
+      if (input_byte & 0x0F) {
+        REPORT_IO_FAILURE();
+        break;
+      }
+      bp_binary_io_send_telemetry();
+      break;
+
     case SPI_COMMAND_CONFIGURE_PERIPHERALS:
       bp_binary_io_peripherals_set(input_byte);
       REPORT_IO_SUCCESS();
@@ -963,8 +2759,337 @@ void spi_enter_binary_io(void) {
   }
 }
 
+void handle_streaming_write_then_read(void) {
+  uint8_t flags;
+  uint32_t bytes_to_write;
+  uint32_t bytes_to_read;
+
+  flags = user_serial_read_byte();
+  bytes_to_write = bp_binary_io_read_uint32();
+  bytes_to_read = bp_binary_io_read_uint32();
+
+  if (flags & ~SPI_STREAMING_FLAGS_MASK) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  if (flags & SPI_STREAMING_FLAG_ASSERT_CS) {
+    SPICS = LOW;
+  }
+
+  /* Forward data from the serial port to the SPI bus as it arrives. */
+  while (bytes_to_write > 0) {
+    spi_write_byte(user_serial_read_byte());
+    bytes_to_write--;
+  }
+
+  /* Wait for the bus to settle. */
+  bp_delay_us(1);
+
+  REPORT_IO_SUCCESS();
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+  if (flags & SPI_STREAMING_FLAG_COMPRESS) {
+    bp_compressed_read_begin();
+    while (bytes_to_read > 0) {
+      bp_compressed_read_put(spi_write_byte(0xFF));
+      bytes_to_read--;
+    }
+    bp_compressed_read_end();
+  }
+#endif /* BP_ENABLE_COMPRESSED_READS */
+
+  /* Forward data from the SPI bus to the serial port as it is clocked in. */
+  while (bytes_to_read > 0) {
+    user_serial_transmit_character(spi_write_byte(0xFF));
+    bytes_to_read--;
+  }
+
+  if (flags & SPI_STREAMING_FLAG_ASSERT_CS) {
+    SPICS = HIGH;
+  }
+}
+
+void handle_run_script(void) {
+  uint16_t script_length;
+  uint16_t results_length;
+  uint16_t offset;
+  uint8_t *script;
+  uint8_t *results;
+  bool success;
+
+  script_length = user_serial_read_byte() << 8;
+  script_length |= user_serial_read_byte();
+
+  if (script_length > SPI_SCRIPT_MAXIMUM_SIZE) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  script = bp_buffer_arena_reserve(SPI_SCRIPT_MAXIMUM_SIZE);
+  results = bp_buffer_arena_reserve(SPI_SCRIPT_MAXIMUM_SIZE);
+  if ((script == NULL) || (results == NULL)) {
+    bp_buffer_arena_release(results);
+    bp_buffer_arena_release(script);
+
+    /* The script has nowhere to go, drop it to stay in step. */
+    for (offset = 0; offset < script_length; offset++) {
+      user_serial_read_byte();
+    }
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  for (offset = 0; offset < script_length; offset++) {
+    script[offset] = user_serial_read_byte();
+  }
+
+  success = spi_run_script(script, script_length, results, &results_length);
+  if (success) {
+    REPORT_IO_SUCCESS();
+  } else {
+    SPICS = HIGH;
+    REPORT_IO_FAILURE();
+  }
+
+  user_serial_transmit_character(HI8(results_length));
+  user_serial_transmit_character(LO8(results_length));
+  bp_write_buffer(results, results_length);
+
+  bp_buffer_arena_release(results);
+  bp_buffer_arena_release(script);
+}
+
+bool spi_run_script(const uint8_t *script, const uint16_t script_length,
+                    uint8_t *results, uint16_t *results_length) {
+  uint16_t pc;
+  uint16_t loops_left;
+  bool in_loop;
+
+  pc = 0;
+  loops_left = 0;
+  in_loop = false;
+  *results_length = 0;
+
+  while (pc < script_length) {
+    switch ((spi_script_opcode_t)script[pc++]) {
+    case SPI_SCRIPT_OPCODE_END:
+      return true;
+
+    case SPI_SCRIPT_OPCODE_CS_LOW:
+      SPICS = LOW;
+      break;
+
+    case SPI_SCRIPT_OPCODE_CS_HIGH:
+      SPICS = HIGH;
+      break;
+
+    case SPI_SCRIPT_OPCODE_WRITE:
+    case SPI_SCRIPT_OPCODE_TRANSFER: {
+      uint8_t opcode;
+      uint8_t count;
+
+      opcode = script[pc - 1];
+      if (pc >= script_length) {
+        return false;
+      }
+      count = script[pc++];
+      if (count > (script_length - pc)) {
+        return false;
+      }
+
+      if (opcode == SPI_SCRIPT_OPCODE_WRITE) {
+        spi_transfer_buffer(script + pc, NULL, count);
+      } else {
+        if (count > (SPI_SCRIPT_MAXIMUM_SIZE - *results_length)) {
+          return false;
+        }
+        spi_transfer_buffer(script + pc, results + *results_length, count);
+        *results_length += count;
+      }
+      pc += count;
+      break;
+    }
+
+    case SPI_SCRIPT_OPCODE_READ: {
+      uint8_t count;
+
+      if (pc >= script_length) {
+        return false;
+      }
+      count = script[pc++];
+      if (count > (SPI_SCRIPT_MAXIMUM_SIZE - *results_length)) {
+        return false;
+      }
+      spi_transfer_buffer(NULL, results + *results_length, count);
+      *results_length += count;
+      break;
+    }
+
+    case SPI_SCRIPT_OPCODE_DELAY: {
+      uint16_t microseconds;
+
+      if ((script_length - pc) < 2) {
+        return false;
+      }
+      microseconds = (script[pc] << 8) | script[pc + 1];
+      pc += 2;
+      bp_delay_us(microseconds);
+      break;
+    }
+
+    case SPI_SCRIPT_OPCODE_POLL: {
+      uint8_t mask;
+      uint8_t value;
+      uint32_t polls;
+
+      if ((script_length - pc) < 4) {
+        return false;
+      }
+      mask = script[pc];
+      value = script[pc + 1];
+      /* Poll every 10us. */
+      polls = (uint32_t)((script[pc + 2] << 8) | script[pc + 3]) * 100;
+      pc += 4;
+
+      while ((spi_write_byte(0xFF) & mask) != value) {
+        if (polls == 0) {
+          return false;
+        }
+        bp_delay_us(10);
+        polls--;
+      }
+      break;
+    }
+
+    case SPI_SCRIPT_OPCODE_LOOP: {
+      uint16_t target;
+      uint8_t count;
+
+      if ((script_length - pc) < 3) {
+        return false;
+      }
+      target = (script[pc] << 8) | script[pc + 1];
+      count = script[pc + 2];
+      pc += 3;
+      if (target >= pc) {
+        return false;
+      }
+
+      if (!in_loop) {
+        in_loop = true;
+        loops_left = count;
+      }
+      if (loops_left > 0) {
+        loops_left--;
+        pc = target;
+      } else {
+        in_loop = false;
+      }
+      break;
+    }
+
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
 #ifdef BP_SPI_ENABLE_AVR_EXTENDED_COMMANDS
 
+void avr_select_bank(const uint32_t address) {
+  uint8_t bank = (address >> 16) & 0xFF;
+
+  if (bank == avr_extended_address) {
+    return;
+  }
+
+  spi_write_byte(AVR_LOAD_EXTENDED_ADDRESS_COMMAND);
+  spi_write_byte(0x00);
+  spi_write_byte(bank);
+  spi_write_byte(0x00);
+  avr_extended_address = bank;
+}
+
+void avr_bulk_read(uint32_t address, uint32_t length) {
+  uint8_t *buffer = bus_pirate_configuration.terminal_input;
+
+  while (length > 0) {
+    uint16_t chunk;
+    uint16_t index;
+
+    avr_select_bank(address);
+
+    /* Bursts stop at bank boundaries, so the right bank is selected. */
+    chunk = AVR_READ_CHUNK_LENGTH;
+    if (length < chunk) {
+      chunk = length;
+    }
+    if ((0x10000UL - (address & 0xFFFF)) * 2 < chunk) {
+      chunk = (0x10000UL - (address & 0xFFFF)) * 2;
+    }
+
+    for (index = 0; index < chunk; index++) {
+      uint16_t word = (address + (index / 2)) & 0xFFFF;
+      uint8_t *instruction = &buffer[index * AVR_INSTRUCTION_LENGTH];
+
+      instruction[0] = (index & 1) ? AVR_FETCH_HIGH_BYTE_COMMAND
+                                   : AVR_FETCH_LOW_BYTE_COMMAND;
+      instruction[1] = HI8(word);
+      instruction[2] = LO8(word);
+      instruction[3] = 0x00;
+    }
+    spi_transfer_buffer(buffer, buffer, chunk * AVR_INSTRUCTION_LENGTH);
+
+    /* The data byte is the last one clocked in for each fetch. */
+    for (index = 0; index < chunk; index++) {
+      buffer[index] = buffer[(index * AVR_INSTRUCTION_LENGTH) + 3];
+    }
+    bp_write_buffer(buffer, chunk);
+
+    address += chunk / 2;
+    length -= chunk;
+  }
+}
+
+void avr_bulk_write_page(const uint32_t address, const uint16_t length) {
+  uint8_t *buffer = bus_pirate_configuration.terminal_input;
+  uint16_t index;
+  uint16_t polls;
+
+  for (index = 0; index < length; index++) {
+    uint8_t *instruction = &buffer[index * AVR_INSTRUCTION_LENGTH];
+
+    instruction[0] = (index & 1) ? AVR_LOAD_PAGE_HIGH_BYTE_COMMAND
+                                 : AVR_LOAD_PAGE_LOW_BYTE_COMMAND;
+    instruction[1] = 0x00;
+    instruction[2] = LO8(address + (index / 2));
+    instruction[3] = user_serial_read_byte();
+  }
+  spi_transfer_buffer(buffer, NULL, length * AVR_INSTRUCTION_LENGTH);
+
+  avr_select_bank(address);
+  spi_write_byte(AVR_WRITE_PAGE_COMMAND);
+  spi_write_byte(HI8(address));
+  spi_write_byte(LO8(address));
+  spi_write_byte(0x00);
+
+  for (polls = 0; polls < AVR_WRITE_POLLS; polls++) {
+    bp_delay_us(100);
+    spi_write_byte(AVR_POLL_READY_COMMAND);
+    spi_write_byte(0x00);
+    spi_write_byte(0x00);
+    if ((spi_write_byte(0x00) & 0x01) == 0) {
+      REPORT_IO_SUCCESS();
+      return;
+    }
+  }
+
+  REPORT_IO_FAILURE();
+}
+
 void handle_extended_avr_command(void) {
   uint8_t command;
 
@@ -987,44 +3112,38 @@ void handle_extended_avr_command(void) {
     uint32_t address;
     uint32_t length;
 
-    address = (uint32_t)((((uint32_t)user_serial_read_byte()) << 24) |
-                         (((uint32_t)user_serial_read_byte()) << 16) |
-                         (((uint32_t)user_serial_read_byte()) << 8) |
-                         user_serial_read_byte());
-    length = (uint32_t)((((uint32_t)user_serial_read_byte()) << 24) |
-                        (((uint32_t)user_serial_read_byte()) << 16) |
-                        (((uint32_t)user_serial_read_byte()) << 8) |
-                        user_serial_read_byte());
+    address = bp_binary_io_read_uint32();
+    length = bp_binary_io_read_uint32();
 
-    /* @todo: avoid (address + length) integer overflow. */
-
-    if ((address > 0xFFFF) || (length > 0xFFFF) ||
-        ((address + length) > 0xFFFF)) {
+    /* Checked one at a time so their sum cannot overflow. */
+    if ((address > AVR_MAXIMUM_WORD_ADDRESS) ||
+        (length > ((AVR_MAXIMUM_WORD_ADDRESS + 1) * 2)) ||
+        ((address + ((length + 1) / 2)) > (AVR_MAXIMUM_WORD_ADDRESS + 1))) {
       REPORT_IO_FAILURE();
       return;
     }
 
     REPORT_IO_SUCCESS();
-    while (length > 0) {
-      /* Fetch low byte from word. */
-      spi_write_byte(AVR_FETCH_LOW_BYTE_COMMAND);
-      spi_write_byte((address >> 8) & 0xFF);
-      spi_write_byte(address & 0xFF);
-      user_serial_transmit_character(spi_write_byte(0x00));
-      length--;
-
-      if (length > 0) {
-        /* Fetch high byte from word. */
-        spi_write_byte(AVR_FETCH_HIGH_BYTE_COMMAND);
-        spi_write_byte((address >> 8) & 0xFF);
-        spi_write_byte(address & 0xFF);
-        user_serial_transmit_character(spi_write_byte(0x00));
-        length--;
-      }
+    avr_bulk_read(address, length);
+    break;
+  }
+
+  case BINARY_IO_SPI_AVR_COMMAND_BULK_WRITE_PAGE: {
+    uint32_t address;
+    uint16_t length;
 
-      address++;
+    address = bp_binary_io_read_uint32();
+    length = user_serial_read_byte() << 8;
+    length |= user_serial_read_byte();
+
+    if ((address > AVR_MAXIMUM_WORD_ADDRESS) || (length == 0) ||
+        (length & 1) || (length > AVR_PAGE_MAXIMUM_LENGTH)) {
+      REPORT_IO_FAILURE();
+      return;
     }
 
+    REPORT_IO_SUCCESS();
+    avr_bulk_write_page(address, length);
     break;
   }
 
@@ -22,12 +22,17 @@
 
 #ifdef BP_ENABLE_SPI_SUPPORT
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
  * Start accepting binary I/O commands for SPI operations.
+ *
+ * @param[in] restore_settings true to start with the speed and bus settings
+ * the mode had when it was last left, false for the defaults.
  */
-void spi_enter_binary_io(void);
+void spi_enter_binary_io(const bool restore_settings);
 
 /**
  * Writes the given byte on the SPI bus.
@@ -38,11 +43,41 @@ void spi_enter_binary_io(void);
  */
 uint8_t spi_write_byte(const uint8_t value);
 
+/**
+ * Performs a bulk transfer on the SPI bus, using the enhanced buffer FIFOs to
+ * keep the clock running without gaps between bytes.
+ *
+ * The same buffer can be used for both output and input, as every byte is
+ * clocked out before the byte read in its place is stored.
+ *
+ * @param[in]  output the bytes to write, or NULL to write 0xFF bytes.
+ * @param[out] input  where to store the bytes read, or NULL to discard them.
+ * @param[in]  length how many bytes to transfer.
+ */
+void spi_transfer_buffer(const uint8_t *output, uint8_t *input,
+                         const size_t length);
+
 void spi_start(void);
 void spi_start_with_read(void);
 void spi_stop(void);
 uint16_t spi_read(void);
 uint16_t spi_write(const uint16_t value);
+
+/**
+ * Sends the given bytes with spi_transfer_buffer, discarding what is read.
+ *
+ * @param[in] buffer the bytes to send.
+ * @param[in] length how many bytes to send.
+ */
+void spi_send_buffer(const uint8_t *buffer, const size_t length);
+
+/**
+ * Reads the given number of bytes with spi_transfer_buffer, sending 0xFF.
+ *
+ * @param[out] buffer where to store the bytes read.
+ * @param[in]  length how many bytes to read.
+ */
+void spi_read_buffer(uint8_t *buffer, const size_t length);
 void spi_setup_prepare(void);
 void spi_setup_execute(void);
 void spi_cleanup(void);
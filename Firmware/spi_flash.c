@@ -0,0 +1,1383 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate. This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "spi_flash.h"
+
+#ifdef BP_SPI_ENABLE_FLASH_ENGINE
+
+#include <string.h>
+
+#include "base.h"
+#include "binary_io.h"
+#include "compressed_read.h"
+#include "core.h"
+#include "spi.h"
+
+extern bus_pirate_configuration_t bus_pirate_configuration;
+
+/**
+ * SPI NOR flash engine commands.
+ *
+ * <table>
+ * <tr><th>Command</th><th>Payload</th><th>Response</th></tr>
+ * <tr><td>0x00 - Exit</td><td>-</td><td>"SPI1"</td></tr>
+ * <tr><td>0x01 - Identify</td><td>-</td><td>"FLS1"</td></tr>
+ * <tr><td>0x02 - Configure</td><td>address width (3 or 4), page size (2 bytes),
+ * read opcode, read dummy bytes, program opcode, erase opcode</td>
+ * <td>Result code</td></tr>
+ * <tr><td>0x03 - Read</td><td>address (4 bytes), length (4 bytes)</td>
+ * <td>Result code, then data</td></tr>
+ * <tr><td>0x04 - Program</td><td>address (4 bytes), length (4 bytes)</td>
+ * <td>Result code, then one result code per page after the host sends that
+ * page's data</td></tr>
+ * <tr><td>0x05 - Erase sector</td><td>address (4 bytes)</td><td>Result code
+ * once the chip is no longer busy</td></tr>
+ * <tr><td>0x06 - Verify</td><td>address (4 bytes), length (4 bytes)</td>
+ * <td>Result code, then one result code per page after the host sends that
+ * page's expected data</td></tr>
+ * <tr><td>0x07 - Read status</td><td>-</td><td>Status register</td></tr>
+ * <tr><td>0x08 - Checksum</td><td>address (4 bytes), length (4 bytes), block
+ * size (4 bytes, 0 for the whole range)</td><td>Result code, then one CRC32
+ * (4 bytes) per block</td></tr>
+ * <tr><td>0x09 - Dual output read</td><td>address (4 bytes), length (4
+ * bytes)</td><td>Result code, then data</td></tr>
+ * <tr><td>0x0A - SFDP probe</td><td>-</td><td>Result code, then flags,
+ * density in bytes (4 bytes), address width, page size (2 bytes), read
+ * opcode, read dummy bytes, dual output read opcode, dual output read dummy
+ * bytes, program opcode, then size as a power of two and opcode for each of
+ * the four erase types</td></tr>
+ * <tr><td>0x0B - Erase range</td><td>address (4 bytes), length (4
+ * bytes)</td><td>Result code, then the size of each erase as a power of two
+ * once it completes, then a final result code</td></tr>
+ * <tr><td>0x0C - Blank check</td><td>address (4 bytes), length (4 bytes),
+ * block size (4 bytes)</td><td>Result code, then a bitmap with one bit per
+ * block</td></tr>
+ * <tr><td>0x0D - Select chips</td><td>chip select mask</td><td>Result
+ * code</td></tr>
+ * <tr><td>0x0E - Failed chips</td><td>-</td><td>Mask of the chips that
+ * failed since the last select or failed chips command</td></tr>
+ * <tr><td>0x0F - Compressed read</td><td>address (4 bytes), length (4
+ * bytes)</td><td>Result code, then the data as a compressed read token
+ * stream</td></tr>
+ * </table>
+ *
+ * All multi-byte values are sent MSB first.  Pages follow the configured page
+ * size and are aligned to it, so the first and last pages of a transfer can be
+ * shorter than the page size.  Once a page fails to program, the rest of the
+ * announced data is still read, page by page, but each page is only answered
+ * with a failure code, so the host never has its data taken for commands.
+ * Checksum blocks instead start at the given
+ * address and only the last block can be shorter than the block size; the
+ * CRC32 used is the same as zlib's.  Dual output reads use SPI mode 0 and
+ * the 0x3B opcode with 8 dummy clocks unless a probe picked otherwise.
+ *
+ * The SFDP probe reads the chip's JESD216 basic flash parameter table and
+ * replaces the current configuration with what it advertises: FAST_READ for
+ * single line reads, its 1-1-2 read for dual output reads, its erase types,
+ * its page size, and 4-byte addressing for parts larger than 16MiB, either
+ * through the 4-byte instruction table or by entering 4-byte mode.  Bit 0 of
+ * the flags tells whether dual output reads can be used, erase types not
+ * present are reported with a zero size.  If the chip has no SFDP support the
+ * configuration is left alone and a failure is reported.
+ *
+ * Range erases must start and end on a boundary of the smallest erase type,
+ * and use the largest erase type that is aligned and fits the remaining
+ * length at each step.  Erase sizes are at least 256 bytes, so they can never
+ * be mistaken for the final result code.  Until a probe is run only 4KiB erases
+ * with opcode 0x20 are known.
+ *
+ * Blank check blocks are laid out like checksum blocks, but the block size
+ * cannot be zero.  A bitmap bit is set when every byte of its block reads as
+ * 0xFF, so the host can skip erasing it.  Block 0 is bit 0 of the first byte,
+ * and the unused bits of the last byte are clear.  Reading a block stops at
+ * the first byte that is not 0xFF.
+ *
+ * Several identical chips can be programmed at once, each with its own chip
+ * select line: bit 0 of the chip select mask is CS, bit 1 is AUX, and on v4
+ * bits 2 and 3 are AUX1 and AUX2, which then follow the CS output type.
+ * Write enables, programs and erases, including the 4-byte mode switch of a
+ * probe, go to all selected chips at once.  Status polls and verifies go to
+ * each of them in turn, and a chip that times out or does not match fails the
+ * command and is added to the failed chips mask, so the host can tell which
+ * socket to set aside.  Everything else only reads from the selected chip with
+ * the lowest bit, since MISO cannot be shared.  Only CS is selected when the
+ * engine starts, and AUX lines go back to inputs when it exits.
+ *
+ * Compressed reads are plain reads whose data goes through the encoder in
+ * compressed_read.h, the host decodes tokens until it has length bytes.  They
+ * are refused when the firmware is built without BP_ENABLE_COMPRESSED_READS.
+ */
+typedef enum {
+  SPI_FLASH_COMMAND_EXIT = 0,
+  SPI_FLASH_COMMAND_SEND_IDENTIFIER,
+  SPI_FLASH_COMMAND_CONFIGURE,
+  SPI_FLASH_COMMAND_READ,
+  SPI_FLASH_COMMAND_PROGRAM,
+  SPI_FLASH_COMMAND_ERASE,
+  SPI_FLASH_COMMAND_VERIFY,
+  SPI_FLASH_COMMAND_READ_STATUS,
+  SPI_FLASH_COMMAND_CHECKSUM,
+  SPI_FLASH_COMMAND_DUAL_READ,
+  SPI_FLASH_COMMAND_SFDP_PROBE,
+  SPI_FLASH_COMMAND_ERASE_RANGE,
+  SPI_FLASH_COMMAND_BLANK_CHECK,
+  SPI_FLASH_COMMAND_SELECT_CHIPS,
+  SPI_FLASH_COMMAND_FAILED_CHIPS,
+  SPI_FLASH_COMMAND_COMPRESSED_READ
+} spi_flash_command_t;
+
+/**
+ * JEDEC write enable opcode.
+ */
+#define SPI_FLASH_OPCODE_WRITE_ENABLE 0x06
+
+/**
+ * JEDEC dual output fast read opcode.
+ */
+#define SPI_FLASH_OPCODE_DUAL_OUTPUT_READ 0x3B
+
+/**
+ * JEDEC read status register opcode.
+ */
+#define SPI_FLASH_OPCODE_READ_STATUS 0x05
+
+/**
+ * JEDEC read SFDP opcode.
+ */
+#define SPI_FLASH_OPCODE_READ_SFDP 0x5A
+
+/**
+ * JEDEC FAST_READ opcode.
+ */
+#define SPI_FLASH_OPCODE_FAST_READ 0x0B
+
+/**
+ * JEDEC enter 4-byte address mode opcode.
+ */
+#define SPI_FLASH_OPCODE_ENTER_4_BYTE_MODE 0xB7
+
+/**
+ * SFDP header signature, "SFDP" read as a little endian word.
+ */
+#define SPI_FLASH_SFDP_SIGNATURE 0x50444653
+
+/**
+ * SFDP parameter ID of the JESD216 basic flash parameter table.
+ */
+#define SPI_FLASH_SFDP_BASIC_TABLE_ID 0xFF00
+
+/**
+ * SFDP parameter ID of the JESD216B 4-byte address instruction table.
+ */
+#define SPI_FLASH_SFDP_4_BYTE_TABLE_ID 0xFF84
+
+/**
+ * How many erase types an SFDP basic flash parameter table can describe.
+ */
+#define SPI_FLASH_ERASE_TYPES 4
+
+/**
+ * Probe result flag telling dual output reads can be used.
+ */
+#define SPI_FLASH_PROBE_FLAG_DUAL_READ 0b00000001
+
+/**
+ * Status register bit indicating a write or erase operation in progress.
+ */
+#define SPI_FLASH_STATUS_WRITE_IN_PROGRESS 0b00000001
+
+/**
+ * How long to wait for a page program operation to complete, in milliseconds.
+ */
+#define SPI_FLASH_PROGRAM_TIMEOUT_MS 20
+
+/**
+ * How long to wait for a sector erase operation to complete, in milliseconds.
+ */
+#define SPI_FLASH_ERASE_TIMEOUT_MS 5000
+
+/**
+ * Maximum number of dummy bytes that can follow a read command.
+ */
+#define SPI_FLASH_MAXIMUM_DUMMY_BYTES 8
+
+/**
+ * How many bytes are read at once when blank checking.
+ */
+#define SPI_FLASH_BLANK_CHECK_CHUNK_SIZE 256
+
+/**
+ * Chip select mask bit of the CS line.
+ */
+#define SPI_FLASH_CHIP_CS 0b00000001
+
+/**
+ * Chip select mask bit of the AUX line.
+ */
+#define SPI_FLASH_CHIP_AUX 0b00000010
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Chip select mask bit of the AUX1 line.
+ */
+#define SPI_FLASH_CHIP_AUX1 0b00000100
+
+/**
+ * Chip select mask bit of the AUX2 line.
+ */
+#define SPI_FLASH_CHIP_AUX2 0b00001000
+
+/**
+ * Chip select lines there are.
+ */
+#define SPI_FLASH_CHIPS_MASK 0b00001111
+
+#else
+
+/**
+ * Chip select lines there are.
+ */
+#define SPI_FLASH_CHIPS_MASK 0b00000011
+
+#endif /* BUSPIRATEV4 */
+
+/**
+ * CRC32 lookup table, one entry per nibble to keep the flash footprint small.
+ */
+static const uint32_t CRC32_NIBBLE_TABLE[] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+/**
+ * SPI NOR flash engine state.
+ */
+typedef struct {
+
+  /** Program page size, in bytes. */
+  uint16_t page_size;
+
+  /** How many address bytes to send, either 3 or 4. */
+  uint8_t address_bytes;
+
+  /** Opcode used to read data. */
+  uint8_t read_opcode;
+
+  /** How many dummy bytes to clock after the address when reading. */
+  uint8_t read_dummy_bytes;
+
+  /** Opcode used to program a page. */
+  uint8_t program_opcode;
+
+  /** Opcode used to erase a sector. */
+  uint8_t erase_opcode;
+
+  /** Opcode used for dual output reads. */
+  uint8_t dual_read_opcode;
+
+  /** How many dummy bytes to clock after the address for dual output reads. */
+  uint8_t dual_read_dummy_bytes;
+
+  /** Erase types usable for range erases. */
+  struct {
+
+    /** Erase size as a power of two, 0 if this erase type is not present. */
+    uint8_t size_shift;
+
+    /** Opcode used to erase a block of this size. */
+    uint8_t opcode;
+
+  } erase_types[SPI_FLASH_ERASE_TYPES];
+
+  /** Chip select lines in use, as a mask. */
+  uint8_t chips;
+
+  /** Chips that timed out or failed a verify, as a mask. */
+  uint8_t failed_chips;
+
+} spi_flash_state_t;
+
+/**
+ * The SPI NOR flash engine state.
+ */
+static spi_flash_state_t spi_flash_state;
+
+/**
+ * Drives the chip select lines of the given chips low.
+ *
+ * @param[in] chips the chips to select, as a mask.
+ */
+static void spi_flash_select(const uint8_t chips);
+
+/**
+ * Drives the chip select lines of all chips in use high.
+ */
+static void spi_flash_deselect(void);
+
+/**
+ * Picks the chip that commands reading data back talk to.
+ *
+ * @return the lowest chip select mask bit in use.
+ */
+static inline uint8_t spi_flash_lead_chip(void);
+
+/**
+ * Makes the chip select lines in the given mask outputs at the CS output
+ * type, and lets the AUX lines left out go back to inputs.
+ *
+ * @param[in] chips the chips to use from now on, as a mask.
+ */
+static void spi_flash_set_chips(const uint8_t chips);
+
+/**
+ * Selects the given chips and sends the given opcode followed by the given
+ * address, using as many address bytes as configured.
+ *
+ * @param[in] chips   the chips to select, as a mask.
+ * @param[in] opcode  the opcode to send.
+ * @param[in] address the address to send.
+ */
+static void spi_flash_begin_command(const uint8_t chips, const uint8_t opcode,
+                                    const uint32_t address);
+
+/**
+ * Sends a write enable command to all chips in use.
+ */
+static void spi_flash_write_enable(void);
+
+/**
+ * Polls the status register of each chip in use in turn, until its write in
+ * progress bit clears.  Chips that do not are added to the failed chips.
+ *
+ * @param[in] timeout_ms how long to wait at most for each chip, in
+ * milliseconds.
+ *
+ * @return true if all chips became ready in time, false otherwise.
+ */
+static bool spi_flash_wait_until_ready(const uint16_t timeout_ms);
+
+/**
+ * Tells whether the given chip holds the page staged in the terminal buffer.
+ *
+ * @param[in] chip    the chip to read from, as a mask bit.
+ * @param[in] address the starting address.
+ * @param[in] length  how many bytes to compare.
+ *
+ * @return true if every byte matches, false otherwise.
+ */
+static bool spi_flash_page_matches(const uint8_t chip, const uint32_t address,
+                                   const uint16_t length);
+
+/**
+ * Reads an address and a length from the serial port, checking whether the
+ * range fits in the configured address space.
+ *
+ * @param[out] address where to store the address read from the serial port.
+ * @param[out] length  where to store the length read from the serial port.
+ *
+ * @return true if the range is valid, false otherwise.
+ */
+static bool spi_flash_read_range(uint32_t *address, uint32_t *length);
+
+/**
+ * Returns how many bytes can be handled starting at the given address without
+ * crossing a page boundary.
+ *
+ * @param[in] address the starting address.
+ * @param[in] length  how many bytes are still left to handle.
+ *
+ * @return the amount of bytes to handle in the current page.
+ */
+static uint16_t spi_flash_page_chunk(const uint32_t address,
+                                     const uint32_t length);
+
+/**
+ * Reads the given amount of bytes from the chip, starting at the given
+ * address, and returns their CRC32.
+ *
+ * @param[in] address the starting address.
+ * @param[in] length  how many bytes to read.
+ *
+ * @return the CRC32 of the bytes read.
+ */
+static uint32_t spi_flash_checksum_block(const uint32_t address,
+                                         uint32_t length);
+
+/**
+ * Clocks in the given amount of bytes from the chip using both the MOSI and
+ * MISO lines as inputs, two bits per clock.  The clock line must be idle low
+ * and controlled by its latch, with MOSI set as an input.
+ *
+ * Implemented in spi_flash_asm.s.
+ *
+ * @param[out] buffer where to store the bytes read.
+ * @param[in]  length how many bytes to read.
+ */
+extern void spi_flash_dual_read_fast(uint8_t *buffer, uint16_t length);
+
+/**
+ * Tells whether the given amount of bytes starting at the given address all
+ * read as 0xFF.
+ *
+ * @param[in] address the starting address.
+ * @param[in] length  how many bytes to check.
+ *
+ * @return true if the whole range is blank, false otherwise.
+ */
+static bool spi_flash_block_is_blank(const uint32_t address, uint32_t length);
+
+/**
+ * Reads a little endian word from the chip's SFDP area.
+ *
+ * @param[in] address the SFDP address to read from.
+ *
+ * @return the word read.
+ */
+static uint32_t spi_flash_sfdp_read_word(const uint32_t address);
+
+/**
+ * Looks for the given parameter table in the chip's SFDP headers, keeping the
+ * last one listed if there is more than one.
+ *
+ * @param[in]  header_count how many parameter headers there are.
+ * @param[in]  identifier   the parameter ID to look for.
+ * @param[out] address      where to store the table address.
+ * @param[out] length       where to store the table length, in words.
+ *
+ * @return true if the table was found, false otherwise.
+ */
+static bool spi_flash_sfdp_find_table(const uint8_t header_count,
+                                      const uint16_t identifier,
+                                      uint32_t *address, uint8_t *length);
+
+static void handle_configure(void);
+static void handle_read(const bool compressed);
+static void handle_program(void);
+static void handle_erase(void);
+static void handle_verify(void);
+static void handle_checksum(void);
+static void handle_dual_read(void);
+static void handle_sfdp_probe(void);
+static void handle_erase_range(void);
+static void handle_blank_check(void);
+static void handle_select_chips(void);
+
+void spi_flash_enter_binary_io(void) {
+  spi_flash_state.page_size = 256;
+  spi_flash_state.address_bytes = 3;
+  spi_flash_state.read_opcode = 0x03;
+  spi_flash_state.read_dummy_bytes = 0;
+  spi_flash_state.program_opcode = 0x02;
+  spi_flash_state.erase_opcode = 0x20;
+  spi_flash_state.dual_read_opcode = SPI_FLASH_OPCODE_DUAL_OUTPUT_READ;
+  spi_flash_state.dual_read_dummy_bytes = 1;
+  memset(spi_flash_state.erase_types, 0, sizeof(spi_flash_state.erase_types));
+  spi_flash_state.erase_types[0].size_shift = 12;
+  spi_flash_state.erase_types[0].opcode = 0x20;
+  spi_flash_state.chips = SPI_FLASH_CHIP_CS;
+  spi_flash_state.failed_chips = 0;
+
+  BP_CS = HIGH;
+  MSG_SPI_FLASH_MODE_IDENTIFIER;
+
+  for (;;) {
+    switch ((spi_flash_command_t)user_serial_read_byte()) {
+    case SPI_FLASH_COMMAND_EXIT:
+      spi_flash_set_chips(SPI_FLASH_CHIP_CS);
+      BP_CS = HIGH;
+      return;
+
+    case SPI_FLASH_COMMAND_SEND_IDENTIFIER:
+      MSG_SPI_FLASH_MODE_IDENTIFIER;
+      break;
+
+    case SPI_FLASH_COMMAND_CONFIGURE:
+      handle_configure();
+      break;
+
+    case SPI_FLASH_COMMAND_READ:
+      handle_read(false);
+      break;
+
+#ifdef BP_ENABLE_COMPRESSED_READS
+    case SPI_FLASH_COMMAND_COMPRESSED_READ:
+      handle_read(true);
+      break;
+#endif /* BP_ENABLE_COMPRESSED_READS */
+
+    case SPI_FLASH_COMMAND_PROGRAM:
+      handle_program();
+      break;
+
+    case SPI_FLASH_COMMAND_ERASE:
+      handle_erase();
+      break;
+
+    case SPI_FLASH_COMMAND_VERIFY:
+      handle_verify();
+      break;
+
+    case SPI_FLASH_COMMAND_READ_STATUS:
+      spi_flash_select(spi_flash_lead_chip());
+      spi_write_byte(SPI_FLASH_OPCODE_READ_STATUS);
+      user_serial_transmit_character(spi_write_byte(0xFF));
+      spi_flash_deselect();
+      break;
+
+    case SPI_FLASH_COMMAND_CHECKSUM:
+      handle_checksum();
+      break;
+
+    case SPI_FLASH_COMMAND_DUAL_READ:
+      handle_dual_read();
+      break;
+
+    case SPI_FLASH_COMMAND_SFDP_PROBE:
+      handle_sfdp_probe();
+      break;
+
+    case SPI_FLASH_COMMAND_ERASE_RANGE:
+      handle_erase_range();
+      break;
+
+    case SPI_FLASH_COMMAND_BLANK_CHECK:
+      handle_blank_check();
+      break;
+
+    case SPI_FLASH_COMMAND_SELECT_CHIPS:
+      handle_select_chips();
+      break;
+
+    case SPI_FLASH_COMMAND_FAILED_CHIPS:
+      user_serial_transmit_character(spi_flash_state.failed_chips);
+      spi_flash_state.failed_chips = 0;
+      break;
+
+    default:
+      REPORT_IO_FAILURE();
+      break;
+    }
+  }
+}
+
+void spi_flash_select(const uint8_t chips) {
+  if (chips & SPI_FLASH_CHIP_CS) {
+    BP_CS = LOW;
+  }
+  if (chips & SPI_FLASH_CHIP_AUX) {
+    BP_AUX0 = LOW;
+  }
+#ifdef BUSPIRATEV4
+  if (chips & SPI_FLASH_CHIP_AUX1) {
+    BP_AUX1 = LOW;
+  }
+  if (chips & SPI_FLASH_CHIP_AUX2) {
+    BP_AUX2 = LOW;
+  }
+#endif /* BUSPIRATEV4 */
+}
+
+void spi_flash_deselect(void) {
+  BP_CS = HIGH;
+  if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX) {
+    BP_AUX0 = HIGH;
+  }
+#ifdef BUSPIRATEV4
+  if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX1) {
+    BP_AUX1 = HIGH;
+  }
+  if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX2) {
+    BP_AUX2 = HIGH;
+  }
+#endif /* BUSPIRATEV4 */
+}
+
+uint8_t spi_flash_lead_chip(void) {
+  return spi_flash_state.chips & (uint8_t)(~spi_flash_state.chips + 1);
+}
+
+void spi_flash_set_chips(const uint8_t chips) {
+  if (chips & SPI_FLASH_CHIP_AUX) {
+    BP_AUX0 = HIGH;
+    BP_AUX0_ODC = BP_CS_ODC;
+    BP_AUX0_DIR = OUTPUT;
+  } else if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX) {
+    BP_AUX0_DIR = INPUT;
+    BP_AUX0_ODC = OFF;
+  }
+#ifdef BUSPIRATEV4
+  if (chips & SPI_FLASH_CHIP_AUX1) {
+    BP_AUX1 = HIGH;
+    BP_AUX1_ODC = BP_CS_ODC;
+    BP_AUX1_DIR = OUTPUT;
+  } else if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX1) {
+    BP_AUX1_DIR = INPUT;
+    BP_AUX1_ODC = OFF;
+  }
+  if (chips & SPI_FLASH_CHIP_AUX2) {
+    BP_AUX2 = HIGH;
+    BP_AUX2_ODC = BP_CS_ODC;
+    BP_AUX2_DIR = OUTPUT;
+  } else if (spi_flash_state.chips & SPI_FLASH_CHIP_AUX2) {
+    BP_AUX2_DIR = INPUT;
+    BP_AUX2_ODC = OFF;
+  }
+#endif /* BUSPIRATEV4 */
+  spi_flash_state.chips = chips;
+}
+
+void spi_flash_begin_command(const uint8_t chips, const uint8_t opcode,
+                             const uint32_t address) {
+  spi_flash_select(chips);
+  spi_write_byte(opcode);
+  if (spi_flash_state.address_bytes == 4) {
+    spi_write_byte((address >> 24) & 0xFF);
+  }
+  spi_write_byte((address >> 16) & 0xFF);
+  spi_write_byte((address >> 8) & 0xFF);
+  spi_write_byte(address & 0xFF);
+}
+
+void spi_flash_write_enable(void) {
+  spi_flash_select(spi_flash_state.chips);
+  spi_write_byte(SPI_FLASH_OPCODE_WRITE_ENABLE);
+  spi_flash_deselect();
+}
+
+bool spi_flash_wait_until_ready(const uint16_t timeout_ms) {
+  uint32_t polls;
+  uint8_t chip;
+  bool ready;
+  bool all_ready;
+
+  all_ready = true;
+
+  /* The chips are busy side by side, so by the time the first one is done
+   * the others should be close. */
+  for (chip = SPI_FLASH_CHIP_CS; chip & SPI_FLASH_CHIPS_MASK; chip <<= 1) {
+    if ((spi_flash_state.chips & chip) == 0) {
+      continue;
+    }
+
+    /* Poll every 10us. */
+    polls = (uint32_t)timeout_ms * 100;
+    ready = false;
+
+    spi_flash_select(chip);
+    spi_write_byte(SPI_FLASH_OPCODE_READ_STATUS);
+    while (polls > 0) {
+      if ((spi_write_byte(0xFF) & SPI_FLASH_STATUS_WRITE_IN_PROGRESS) == 0) {
+        ready = true;
+        break;
+      }
+      bp_delay_us(10);
+      polls--;
+    }
+    spi_flash_deselect();
+
+    if (!ready) {
+      spi_flash_state.failed_chips |= chip;
+      all_ready = false;
+    }
+  }
+
+  return all_ready;
+}
+
+bool spi_flash_read_range(uint32_t *address, uint32_t *length) {
+  uint32_t limit;
+
+  *address = bp_binary_io_read_uint32();
+  *length = bp_binary_io_read_uint32();
+
+  if (spi_flash_state.address_bytes == 4) {
+    return (*length == 0) || ((*length - 1) <= (0xFFFFFFFF - *address));
+  }
+
+  limit = 0x01000000;
+  return (*address < limit) && (*length <= (limit - *address));
+}
+
+uint16_t spi_flash_page_chunk(const uint32_t address, const uint32_t length) {
+  uint16_t chunk;
+
+  chunk = spi_flash_state.page_size - (address % spi_flash_state.page_size);
+  return (length < chunk) ? (uint16_t)length : chunk;
+}
+
+void handle_configure(void) {
+  uint8_t address_bytes;
+  uint16_t page_size;
+  uint8_t read_opcode;
+  uint8_t read_dummy_bytes;
+  uint8_t program_opcode;
+  uint8_t erase_opcode;
+
+  address_bytes = user_serial_read_byte();
+  page_size = user_serial_read_byte();
+  page_size = (page_size << 8) | user_serial_read_byte();
+  read_opcode = user_serial_read_byte();
+  read_dummy_bytes = user_serial_read_byte();
+  program_opcode = user_serial_read_byte();
+  erase_opcode = user_serial_read_byte();
+
+  if (((address_bytes != 3) && (address_bytes != 4)) || (page_size == 0) ||
+      (page_size > BP_TERMINAL_BUFFER_SIZE) ||
+      (read_dummy_bytes > SPI_FLASH_MAXIMUM_DUMMY_BYTES)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  spi_flash_state.address_bytes = address_bytes;
+  spi_flash_state.page_size = page_size;
+  spi_flash_state.read_opcode = read_opcode;
+  spi_flash_state.read_dummy_bytes = read_dummy_bytes;
+  spi_flash_state.program_opcode = program_opcode;
+  spi_flash_state.erase_opcode = erase_opcode;
+  REPORT_IO_SUCCESS();
+}
+
+void handle_read(const bool compressed) {
+  uint32_t address;
+  uint32_t length;
+  uint8_t dummy;
+  user_serial_flush_policy_t flush_policy;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  /* Only send full packets while the data is being clocked in. */
+  flush_policy = user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
+  spi_flash_begin_command(spi_flash_lead_chip(), spi_flash_state.read_opcode,
+                          address);
+  for (dummy = 0; dummy < spi_flash_state.read_dummy_bytes; dummy++) {
+    spi_write_byte(0xFF);
+  }
+#ifdef BP_ENABLE_COMPRESSED_READS
+  if (compressed) {
+    bp_compressed_read_begin();
+    while (length > 0) {
+      bp_compressed_read_put(spi_write_byte(0xFF));
+      length--;
+    }
+    bp_compressed_read_end();
+  }
+#else
+  (void)compressed;
+#endif /* BP_ENABLE_COMPRESSED_READS */
+  while (length > 0) {
+    user_serial_transmit_character(spi_write_byte(0xFF));
+    length--;
+  }
+  spi_flash_deselect();
+
+  user_serial_set_flush_policy(flush_policy);
+}
+
+void handle_program(void) {
+  uint32_t address;
+  uint32_t length;
+  uint16_t chunk;
+  uint16_t offset;
+  bool failed;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  failed = false;
+  while (length > 0) {
+    chunk = spi_flash_page_chunk(address, length);
+
+    /* Stage the whole page first, the chip is not clocked meanwhile. */
+    for (offset = 0; offset < chunk; offset++) {
+      bus_pirate_configuration.terminal_input[offset] = user_serial_read_byte();
+    }
+
+    /*
+     * The host may already be streaming the following pages, so after a
+     * failure they are still read in full but no longer programmed.
+     */
+    if (!failed) {
+      spi_flash_write_enable();
+      spi_flash_begin_command(spi_flash_state.chips,
+                              spi_flash_state.program_opcode, address);
+      spi_transfer_buffer(bus_pirate_configuration.terminal_input, NULL,
+                          chunk);
+      spi_flash_deselect();
+
+      failed = !spi_flash_wait_until_ready(SPI_FLASH_PROGRAM_TIMEOUT_MS);
+    }
+
+    if (failed) {
+      REPORT_IO_FAILURE();
+    } else {
+      REPORT_IO_SUCCESS();
+    }
+    address += chunk;
+    length -= chunk;
+  }
+}
+
+void handle_erase(void) {
+  uint32_t address;
+
+  address = bp_binary_io_read_uint32();
+  if ((spi_flash_state.address_bytes == 3) && (address > 0x00FFFFFF)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  spi_flash_write_enable();
+  spi_flash_begin_command(spi_flash_state.chips, spi_flash_state.erase_opcode,
+                          address);
+  spi_flash_deselect();
+
+  if (spi_flash_wait_until_ready(SPI_FLASH_ERASE_TIMEOUT_MS)) {
+    REPORT_IO_SUCCESS();
+  } else {
+    REPORT_IO_FAILURE();
+  }
+}
+
+void handle_verify(void) {
+  uint32_t address;
+  uint32_t length;
+  uint16_t chunk;
+  uint16_t offset;
+  uint8_t chip;
+  bool matches;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  while (length > 0) {
+    chunk = spi_flash_page_chunk(address, length);
+
+    for (offset = 0; offset < chunk; offset++) {
+      bus_pirate_configuration.terminal_input[offset] = user_serial_read_byte();
+    }
+
+    matches = true;
+    for (chip = SPI_FLASH_CHIP_CS; chip & SPI_FLASH_CHIPS_MASK; chip <<= 1) {
+      if ((spi_flash_state.chips & chip) &&
+          !spi_flash_page_matches(chip, address, chunk)) {
+        spi_flash_state.failed_chips |= chip;
+        matches = false;
+      }
+    }
+
+    if (matches) {
+      REPORT_IO_SUCCESS();
+    } else {
+      REPORT_IO_FAILURE();
+    }
+
+    address += chunk;
+    length -= chunk;
+  }
+}
+
+bool spi_flash_page_matches(const uint8_t chip, const uint32_t address,
+                            const uint16_t length) {
+  uint16_t offset;
+  uint8_t dummy;
+  bool matches;
+
+  spi_flash_begin_command(chip, spi_flash_state.read_opcode, address);
+  for (dummy = 0; dummy < spi_flash_state.read_dummy_bytes; dummy++) {
+    spi_write_byte(0xFF);
+  }
+  matches = true;
+  for (offset = 0; offset < length; offset++) {
+    if (spi_write_byte(0xFF) !=
+        bus_pirate_configuration.terminal_input[offset]) {
+      matches = false;
+    }
+  }
+  spi_flash_deselect();
+
+  return matches;
+}
+
+uint32_t spi_flash_checksum_block(const uint32_t address, uint32_t length) {
+  uint32_t crc;
+  uint8_t dummy;
+
+  crc = 0xFFFFFFFF;
+
+  spi_flash_begin_command(spi_flash_lead_chip(), spi_flash_state.read_opcode,
+                          address);
+  for (dummy = 0; dummy < spi_flash_state.read_dummy_bytes; dummy++) {
+    spi_write_byte(0xFF);
+  }
+  while (length > 0) {
+    crc ^= spi_write_byte(0xFF);
+    crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    length--;
+  }
+  spi_flash_deselect();
+
+  return ~crc;
+}
+
+void handle_checksum(void) {
+  uint32_t address;
+  uint32_t length;
+  uint32_t block_size;
+  uint32_t chunk;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    /* Still consume the block size so the host stays in sync. */
+    bp_binary_io_read_uint32();
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  block_size = bp_binary_io_read_uint32();
+  if (block_size == 0) {
+    block_size = length;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  do {
+    chunk = (length < block_size) ? length : block_size;
+    bp_binary_io_write_uint32(spi_flash_checksum_block(address, chunk));
+    address += chunk;
+    length -= chunk;
+  } while (length > 0);
+}
+
+void handle_dual_read(void) {
+  uint32_t address;
+  uint32_t length;
+  uint16_t chunk;
+  uint8_t dummy;
+  user_serial_flush_policy_t flush_policy;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+  flush_policy = user_serial_set_flush_policy(USER_SERIAL_FLUSH_WHEN_FULL);
+
+  /* Opcode, address and dummy clocks still go out on a single line. */
+  spi_flash_begin_command(spi_flash_lead_chip(),
+                          spi_flash_state.dual_read_opcode, address);
+  for (dummy = 0; dummy < spi_flash_state.dual_read_dummy_bytes; dummy++) {
+    spi_write_byte(0xFF);
+  }
+
+  /* Take the clock and MOSI pins away from the SPI module. */
+  IOLAT &= ~CLK;
+  BP_CLK_RPOUT = 0b00000;
+  BP_MOSI_RPOUT = 0b00000;
+  BP_MOSI_DIR = INPUT;
+
+  while (length > 0) {
+    chunk = (length < BP_TERMINAL_BUFFER_SIZE) ? (uint16_t)length
+                                               : BP_TERMINAL_BUFFER_SIZE;
+    spi_flash_dual_read_fast(bus_pirate_configuration.terminal_input, chunk);
+    bp_write_buffer(bus_pirate_configuration.terminal_input, chunk);
+    length -= chunk;
+  }
+
+  spi_flash_deselect();
+
+  /* Give the pins back to the SPI module. */
+  BP_MOSI_DIR = OUTPUT;
+  BP_MOSI_RPOUT = SDO1_IO;
+  BP_CLK_RPOUT = SCK1OUT_IO;
+
+  user_serial_set_flush_policy(flush_policy);
+}
+
+uint32_t spi_flash_sfdp_read_word(const uint32_t address) {
+  uint32_t word;
+
+  /* SFDP is always read with 3 address bytes and 8 dummy clocks. */
+  spi_flash_select(spi_flash_lead_chip());
+  spi_write_byte(SPI_FLASH_OPCODE_READ_SFDP);
+  spi_write_byte((address >> 16) & 0xFF);
+  spi_write_byte((address >> 8) & 0xFF);
+  spi_write_byte(address & 0xFF);
+  spi_write_byte(0xFF);
+  word = spi_write_byte(0xFF);
+  word |= (uint32_t)spi_write_byte(0xFF) << 8;
+  word |= (uint32_t)spi_write_byte(0xFF) << 16;
+  word |= (uint32_t)spi_write_byte(0xFF) << 24;
+  spi_flash_deselect();
+
+  return word;
+}
+
+bool spi_flash_sfdp_find_table(const uint8_t header_count,
+                               const uint16_t identifier, uint32_t *address,
+                               uint8_t *length) {
+  uint16_t header;
+  uint32_t first_word;
+  uint32_t second_word;
+  bool found;
+
+  found = false;
+
+  /* Parameter headers are two words each and follow the SFDP header. */
+  for (header = 0; header <= header_count; header++) {
+    first_word = spi_flash_sfdp_read_word(8 + (header * 8));
+    second_word = spi_flash_sfdp_read_word(12 + (header * 8));
+    if ((uint16_t)((first_word & 0xFF) | ((second_word >> 16) & 0xFF00)) ==
+        identifier) {
+      *address = second_word & 0x00FFFFFF;
+      *length = first_word >> 24;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+void handle_sfdp_probe(void) {
+  uint32_t header;
+  uint32_t table;
+  uint8_t table_length;
+  uint32_t instructions_table;
+  uint8_t instructions_length;
+  uint32_t features;
+  uint32_t density;
+  uint32_t capacity;
+  uint32_t word;
+  uint32_t instructions;
+  uint32_t erase_opcodes;
+  uint16_t page_size;
+  uint8_t dual_clocks;
+  uint8_t flags;
+  uint8_t index;
+  uint8_t shift;
+
+  if (spi_flash_sfdp_read_word(0) != SPI_FLASH_SFDP_SIGNATURE) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  header = spi_flash_sfdp_read_word(4);
+  if (!spi_flash_sfdp_find_table((header >> 16) & 0xFF,
+                                 SPI_FLASH_SFDP_BASIC_TABLE_ID, &table,
+                                 &table_length) ||
+      (table_length < 9)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  features = spi_flash_sfdp_read_word(table);
+  density = spi_flash_sfdp_read_word(table + 4);
+
+  /* Density is given in bits, either as the highest bit address or as a
+   * power of two for parts of 4Gbit and up. */
+  if (density & 0x80000000) {
+    density &= 0x7FFFFFFF;
+    capacity = (density >= 35)
+                   ? 0xFFFFFFFF
+                   : ((uint32_t)1 << ((density > 3) ? (density - 3) : 0));
+  } else {
+    capacity = (density >> 3) + 1;
+  }
+
+  flags = 0;
+  spi_flash_state.address_bytes = 3;
+  spi_flash_state.read_opcode = SPI_FLASH_OPCODE_FAST_READ;
+  spi_flash_state.read_dummy_bytes = 1;
+  spi_flash_state.program_opcode = 0x02;
+  spi_flash_state.dual_read_opcode = SPI_FLASH_OPCODE_DUAL_OUTPUT_READ;
+  spi_flash_state.dual_read_dummy_bytes = 1;
+
+  /* Dummy and mode clocks have to add up to whole bytes, as they are sent
+   * through the SPI module before switching to dual line input. */
+  if (features & 0x00010000) {
+    word = spi_flash_sfdp_read_word(table + 12);
+    dual_clocks = ((word >> 16) & 0x1F) + ((word >> 21) & 0x07);
+    if ((dual_clocks % 8) == 0) {
+      spi_flash_state.dual_read_opcode = word >> 24;
+      spi_flash_state.dual_read_dummy_bytes = dual_clocks / 8;
+      flags |= SPI_FLASH_PROBE_FLAG_DUAL_READ;
+    }
+  }
+
+  /* Write granularity is either single bytes or a page of 64 bytes or more,
+   * with the actual page size only given from JESD216A onwards. */
+  page_size = (features & 0x00000004) ? 256 : 1;
+  if (table_length >= 11) {
+    shift = (spi_flash_sfdp_read_word(table + 40) >> 4) & 0x0F;
+    if ((features & 0x00000004) &&
+        (((uint32_t)1 << shift) <= BP_TERMINAL_BUFFER_SIZE)) {
+      page_size = (uint16_t)1 << shift;
+    }
+  }
+  spi_flash_state.page_size = page_size;
+
+  for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+    if ((index % 2) == 0) {
+      word = spi_flash_sfdp_read_word(table + 28 + (index * 2));
+    }
+    shift = (word >> ((index % 2) * 16)) & 0xFF;
+    spi_flash_state.erase_types[index].size_shift = (shift >= 8) ? shift : 0;
+    spi_flash_state.erase_types[index].opcode =
+        (word >> (((index % 2) * 16) + 8)) & 0xFF;
+  }
+
+  if ((capacity > 0x01000000) || ((features & 0x00060000) == 0x00040000)) {
+    if (spi_flash_sfdp_find_table((header >> 16) & 0xFF,
+                                  SPI_FLASH_SFDP_4_BYTE_TABLE_ID,
+                                  &instructions_table, &instructions_length) &&
+        (instructions_length >= 2)) {
+
+      /* Dedicated 4-byte opcodes, the chip stays in 3-byte mode. */
+      instructions = spi_flash_sfdp_read_word(instructions_table);
+      erase_opcodes = spi_flash_sfdp_read_word(instructions_table + 4);
+      spi_flash_state.address_bytes = 4;
+      if (instructions & 0x00000002) {
+        spi_flash_state.read_opcode = 0x0C;
+      } else {
+        spi_flash_state.read_opcode = 0x13;
+        spi_flash_state.read_dummy_bytes = 0;
+      }
+      if (instructions & 0x00000004) {
+        spi_flash_state.dual_read_opcode = 0x3C;
+      } else {
+        flags &= ~SPI_FLASH_PROBE_FLAG_DUAL_READ;
+      }
+      spi_flash_state.program_opcode = 0x12;
+      for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+        if (instructions & (0x00000200 << index)) {
+          spi_flash_state.erase_types[index].opcode =
+              (erase_opcodes >> (index * 8)) & 0xFF;
+        } else {
+          spi_flash_state.erase_types[index].size_shift = 0;
+        }
+      }
+    } else {
+      /* Otherwise switch the whole chip to 4-byte addressing, if it says
+       * how. */
+      word = (table_length >= 16) ? spi_flash_sfdp_read_word(table + 60) : 0;
+      if ((features & 0x00060000) == 0x00040000) {
+        spi_flash_state.address_bytes = 4;
+      } else if (word & 0x03000000) {
+        if (word & 0x02000000) {
+          spi_flash_write_enable();
+        }
+        spi_flash_select(spi_flash_state.chips);
+        spi_write_byte(SPI_FLASH_OPCODE_ENTER_4_BYTE_MODE);
+        spi_flash_deselect();
+        spi_flash_state.address_bytes = 4;
+      } else if (word & 0x40000000) {
+        spi_flash_state.address_bytes = 4;
+      }
+    }
+  }
+
+  /* Single sector erases use the smallest erase type there is. */
+  shift = 0xFF;
+  for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+    if ((spi_flash_state.erase_types[index].size_shift != 0) &&
+        (spi_flash_state.erase_types[index].size_shift < shift)) {
+      shift = spi_flash_state.erase_types[index].size_shift;
+      spi_flash_state.erase_opcode = spi_flash_state.erase_types[index].opcode;
+    }
+  }
+
+  REPORT_IO_SUCCESS();
+  user_serial_transmit_character(flags);
+  bp_binary_io_write_uint32(capacity);
+  user_serial_transmit_character(spi_flash_state.address_bytes);
+  user_serial_transmit_character(spi_flash_state.page_size >> 8);
+  user_serial_transmit_character(spi_flash_state.page_size & 0xFF);
+  user_serial_transmit_character(spi_flash_state.read_opcode);
+  user_serial_transmit_character(spi_flash_state.read_dummy_bytes);
+  user_serial_transmit_character(spi_flash_state.dual_read_opcode);
+  user_serial_transmit_character(spi_flash_state.dual_read_dummy_bytes);
+  user_serial_transmit_character(spi_flash_state.program_opcode);
+  for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+    user_serial_transmit_character(
+        spi_flash_state.erase_types[index].size_shift);
+    user_serial_transmit_character(spi_flash_state.erase_types[index].opcode);
+  }
+}
+
+void handle_erase_range(void) {
+  uint32_t address;
+  uint32_t length;
+  uint32_t mask;
+  uint8_t index;
+  uint8_t best;
+  uint8_t smallest;
+  uint8_t shift;
+
+  smallest = 0xFF;
+  for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+    shift = spi_flash_state.erase_types[index].size_shift;
+    if ((shift != 0) && (shift < smallest)) {
+      smallest = shift;
+    }
+  }
+
+  mask = (smallest < 32) ? (((uint32_t)1 << smallest) - 1) : 0xFFFFFFFF;
+  if (!spi_flash_read_range(&address, &length) || (smallest == 0xFF) ||
+      (address & mask) || (length & mask)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  while (length > 0) {
+    best = SPI_FLASH_ERASE_TYPES;
+    for (index = 0; index < SPI_FLASH_ERASE_TYPES; index++) {
+      shift = spi_flash_state.erase_types[index].size_shift;
+      if ((shift == 0) || (shift >= 32)) {
+        continue;
+      }
+      mask = ((uint32_t)1 << shift) - 1;
+      if (((address & mask) == 0) && (length > mask) &&
+          ((best == SPI_FLASH_ERASE_TYPES) ||
+           (shift > spi_flash_state.erase_types[best].size_shift))) {
+        best = index;
+      }
+    }
+
+    spi_flash_write_enable();
+    spi_flash_begin_command(spi_flash_state.chips,
+                            spi_flash_state.erase_types[best].opcode, address);
+    spi_flash_deselect();
+
+    if (!spi_flash_wait_until_ready(SPI_FLASH_ERASE_TIMEOUT_MS)) {
+      REPORT_IO_FAILURE();
+      return;
+    }
+
+    shift = spi_flash_state.erase_types[best].size_shift;
+    user_serial_transmit_character(shift);
+    address += (uint32_t)1 << shift;
+    length -= (uint32_t)1 << shift;
+  }
+
+  REPORT_IO_SUCCESS();
+}
+
+bool spi_flash_block_is_blank(const uint32_t address, uint32_t length) {
+  uint16_t chunk;
+  uint16_t offset;
+  uint8_t dummy;
+  bool blank;
+
+  blank = true;
+
+  spi_flash_begin_command(spi_flash_lead_chip(), spi_flash_state.read_opcode,
+                          address);
+  for (dummy = 0; dummy < spi_flash_state.read_dummy_bytes; dummy++) {
+    spi_write_byte(0xFF);
+  }
+  while (blank && (length > 0)) {
+    chunk = (length < SPI_FLASH_BLANK_CHECK_CHUNK_SIZE)
+                ? (uint16_t)length
+                : SPI_FLASH_BLANK_CHECK_CHUNK_SIZE;
+    spi_transfer_buffer(NULL, bus_pirate_configuration.terminal_input, chunk);
+    for (offset = 0; offset < chunk; offset++) {
+      if (bus_pirate_configuration.terminal_input[offset] != 0xFF) {
+        blank = false;
+        break;
+      }
+    }
+    length -= chunk;
+  }
+  spi_flash_deselect();
+
+  return blank;
+}
+
+void handle_blank_check(void) {
+  uint32_t address;
+  uint32_t length;
+  uint32_t block_size;
+  uint32_t chunk;
+  uint8_t bitmap;
+  uint8_t bit;
+
+  if (!spi_flash_read_range(&address, &length)) {
+    /* Still consume the block size so the host stays in sync. */
+    bp_binary_io_read_uint32();
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  block_size = bp_binary_io_read_uint32();
+  if (block_size == 0) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  REPORT_IO_SUCCESS();
+
+  bitmap = 0;
+  bit = 0;
+  while (length > 0) {
+    chunk = (length < block_size) ? length : block_size;
+    if (spi_flash_block_is_blank(address, chunk)) {
+      bitmap |= 1 << bit;
+    }
+    address += chunk;
+    length -= chunk;
+
+    bit++;
+    if ((bit == 8) || (length == 0)) {
+      user_serial_transmit_character(bitmap);
+      bitmap = 0;
+      bit = 0;
+    }
+  }
+}
+
+void handle_select_chips(void) {
+  uint8_t chips;
+
+  chips = user_serial_read_byte();
+  if ((chips == 0) || (chips & ~SPI_FLASH_CHIPS_MASK)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  spi_flash_set_chips(chips);
+  spi_flash_state.failed_chips = 0;
+  REPORT_IO_SUCCESS();
+}
+
+#endif /* BP_SPI_ENABLE_FLASH_ENGINE */
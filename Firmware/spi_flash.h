@@ -0,0 +1,35 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef BP_SPI_FLASH_H
+#define BP_SPI_FLASH_H
+
+#include "configuration.h"
+
+#ifdef BP_SPI_ENABLE_FLASH_ENGINE
+
+/**
+ * Start accepting binary I/O commands for the SPI NOR flash engine.
+ *
+ * The SPI peripheral must already be set up by spi_enter_binary_io, and is left
+ * in the same state when the engine exits.
+ */
+void spi_flash_enter_binary_io(void);
+
+#endif /* BP_SPI_ENABLE_FLASH_ENGINE */
+
+#endif /* !BP_SPI_FLASH_H */
@@ -0,0 +1,107 @@
+;
+; spi_flash_asm.s
+;
+; Optimized dual output read loop for the SPI NOR flash engine
+;
+; Written and maintained by the Bus Pirate project.
+;
+; Published in the public domain.
+; For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+;
+
+.ifdef __PIC24FJ64GA002__
+	.equ __24FJ64GA002, 1
+	.include "p24FJ64GA002.inc"
+
+;  Bus pirate v3 hardware
+.equ IOPOR, PORTB
+.equ IOLAT, LATB
+
+.equ SPI_IO0_BIT, #0x0009	; MOSI, RB9
+.equ SPI_CLK_BIT, #0x0008	; CLK,  RB8
+.equ SPI_IO1_BIT, #0x0007	; MISO, RB7
+.endif ; __PIC24FJ64GA002__
+
+.ifdef __PIC24FJ256GB106__
+	.equ __24FJ256GB106, 1
+	.include "p24FJ256GB106.inc"
+
+;  Bus pirate v4 hardware
+.equ IOPOR, PORTD
+.equ IOLAT, LATD
+
+.equ SPI_IO0_BIT, #0x0001	; MOSI, RD1
+.equ SPI_CLK_BIT, #0x0002	; CLK,  RD2
+.equ SPI_IO1_BIT, #0x0003	; MISO, RD3
+.endif ; __PIC24FJ256GB106__
+
+;
+; void spi_flash_dual_read_fast(uint8_t *buffer, uint16_t length)
+;
+; Clocks in length bytes, two bits per clock (IO1 first), in SPI mode 0.
+; The clock line must be low and driven by its latch, with both the IO0 and
+; IO1 lines set as inputs.
+;
+; Parameters:
+;  w0 : output buffer
+;  w1 : # of bytes
+;
+; Register usage:
+;
+;  w2 : byte being assembled
+;  w3 : bit pair loop counter
+;  w4 : sampled port value
+;  w5 : constant IOLAT
+;  w6 : constant IOPOR
+;
+
+	.text
+	.global _spi_flash_dual_read_fast
+
+_spi_flash_dual_read_fast:
+
+		; Nothing to do ?
+		cp0.w	w1			; if (length == 0)
+		bra	z, __done		;   return;
+
+		; Constants
+		mov.w	#IOLAT, w5		; w5 = &IOLAT;
+		mov.w	#IOPOR, w6		; w6 = &IOPOR;
+
+		; Byte loop
+__loop_byte:					; do {
+		clr.w	w2			;   w2 = 0;
+		mov.w	#4, w3			;   w3 = 4;
+
+		;   Bit pair loop
+__loop_pair:					;   do {
+
+		;     Rising edge, the chip already drives the next pair
+		bset.w	[w5], #SPI_CLK_BIT	;     IOLAT |= CLK;
+		sl.w	w2, #2, w2		;     w2 <<= 2;
+		mov.w	[w6], w4		;     w4 = IOPOR;
+
+		;     Falling edge, the chip shifts out the next pair
+		bclr.w	[w5], #SPI_CLK_BIT	;     IOLAT &= ~CLK;
+
+		;     Merge the sampled bits
+		btsc.w	w4, #SPI_IO1_BIT	;     if (w4 & IO1)
+		bset.w	w2, #1			;       w2 |= 0b10;
+		btsc.w	w4, #SPI_IO0_BIT	;     if (w4 & IO0)
+		bset.w	w2, #0			;       w2 |= 0b01;
+
+		dec.w	w3, w3			;   } while (--w3 > 0);
+		bra	nz, __loop_pair
+
+		;   Store the byte
+		mov.b	w2, [w0++]		;   *buffer++ = w2;
+
+		dec.w	w1, w1			; } while (--length > 0);
+		bra	nz, __loop_byte
+
+__done:
+		return
@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "sump.h"
 
@@ -25,6 +26,7 @@
 
 #include "base.h"
 #include "core.h"
+#include "profiling.h"
 #include "uart.h"
 
 /*
@@ -34,8 +36,6 @@
  *
  * @TODO: Add commands 0x0F, 0x9E, 0x9F from the extended SUMP protocol?
  * @TODO: Add "Set trigger configuration" command (0xC2, 0xC6, 0xCA, 0xCE).
- * @TODO: Check why samples are sent out backwards.
- * @TODO: Implement continuous sampling.
  * @TODO: Remove sump_command_t.left and turn the structure into two separate
  *        fields.
  */
@@ -111,9 +111,71 @@
  *
  * It will stop transmitting captured data. This command is being used for
  * XON/XOFF flow control.
+ *
+ * The Bus Pirate does not pause uploads, it takes this command as a request
+ * to stop a capture in progress and upload the samples taken so far.  Any
+ * other byte aborts the capture instead, and is handled as a command.
  */
 #define SUMP_XOFF 0x13
 
+/**
+ * Arms the trigger for a streaming capture (Bus Pirate extension).
+ *
+ * Once the trigger fires, one byte per sample is sent to the host as it is
+ * taken, until the host sends any byte.  Samples only hold the probes bits, so
+ * a SUMP_STREAM_OVERRUN byte can end the stream when samples had to be
+ * dropped.  The sample rate must be low enough for the serial link to keep up.
+ */
+#define SUMP_RUN_STREAMING 0x0A
+
+/**
+ * Arms the trigger for a packed streaming capture (Bus Pirate extension).
+ *
+ * Works like SUMP_RUN_STREAMING, but only the four lowest probes are kept and
+ * two samples are sent per byte, the oldest one in the lower nibble.  All byte
+ * values are valid samples, so the stream silently ends when samples had to be
+ * dropped.
+ */
+#define SUMP_RUN_STREAMING_PACKED 0x0B
+
+/**
+ * Arms the trigger for an edge timestamp capture (Bus Pirate extension).
+ *
+ * Instead of sampling at a fixed rate, every edge on every probe is
+ * timestamped at instruction clock resolution by the input capture units,
+ * until the sample memory is full, SUMP_EDGES_SPAN_PERIODS elapsed or the
+ * host sends any byte.
+ *
+ * The capture is then sent as a SUMP_EDGES_HEADER_SIZE bytes header: the
+ * amount of records (2 bytes), the probes state when the capture began, the
+ * SUMP_EDGES_END_* reason it ended and the capture length in instruction
+ * cycles (4 bytes).  Each record follows as a big endian 32 bits word, the
+ * probe number in the top three bits (SUMP_EDGES_CHANNEL_SHIFT) and the
+ * timestamp in the bottom SUMP_EDGES_TIMESTAMP_MASK bits.  Records with
+ * SUMP_EDGES_LOST set are not edges, they mean that a burst of edges on that
+ * probe was too fast to be captured, and hold in bit 0 the level the line
+ * had when capture resumed.  Multi-byte fields are big endian.
+ */
+#define SUMP_RUN_EDGES 0x0C
+
+/**
+ * Arms the trigger for a bitstream capture of the MISO probe (Bus Pirate
+ * extension).
+ *
+ * SPI1 runs as a master with its clock going nowhere, and shifts in MISO
+ * once per SCK period, eight samples per byte of sample memory.  This gets
+ * eight times the samples of a regular capture and up to 8MHz on a single
+ * probe, enough for fast UARTs or PWM edges.  The sample rate is the fastest
+ * SPI clock not above the SUMP_DIV one, from FCY / 2 down to FCY / 512.
+ *
+ * Once the trigger fires the sample memory is filled as set with SUMP_CNT,
+ * then a SUMP_BITSTREAM_HEADER_SIZE bytes header is sent: the probe number,
+ * the sample period in instruction cycles (2 bytes) and how many bytes of
+ * samples follow (2 bytes).  Bytes go oldest first, and within each byte the
+ * oldest sample is bit 7.  Multi-byte fields are big endian.
+ */
+#define SUMP_RUN_BITSTREAM 0x0D
+
 /**
  * Set Divider.
  *
@@ -176,6 +238,44 @@
  */
 #define SUMP_FLAGS 0x82
 
+/**
+ * Run length encoding flag, in the second byte of a SUMP_FLAGS command.
+ *
+ * When set, repeated samples are stored as a count instead, with the count
+ * having its most significant bit set.
+ *
+ * @see SUMP_RLE_COUNT_FLAG
+ */
+#define SUMP_FLAGS_RLE 0x01
+
+/**
+ * Channel groups disable bits, in the first byte of a SUMP_FLAGS command.
+ *
+ * A disabled group is left out of the uploaded samples, and every enabled
+ * group takes one byte per sample.  Only the first group holds probes, the
+ * others are always sent as zero.
+ */
+#define SUMP_FLAGS_CHANNEL_GROUPS_MASK 0x3C
+
+/**
+ * Position of the first channel group disable bit.
+ */
+#define SUMP_FLAGS_CHANNEL_GROUPS_SHIFT 2
+
+/**
+ * Oldest first upload flag, in the second byte of a SUMP_FLAGS command (Bus
+ * Pirate extension).
+ *
+ * The protocol sends the newest sample first, this flag reverses that order
+ * for host software reading the samples straight into a buffer.
+ */
+#define SUMP_FLAGS_OLDEST_FIRST 0x80
+
+/**
+ * How many channel groups the protocol has.
+ */
+#define SUMP_CHANNEL_GROUPS 4
+
 /**
  * Set Trigger Values.
  *
@@ -206,6 +306,41 @@
  */
 #define SUMP_TRIG_VALS 0xC1
 
+/**
+ * Set trigger configuration.
+ *
+ * Sets up how the trigger stage behaves: how many samples to wait once it
+ * matched, which trigger level arms it, which channel to look at in serial
+ * mode, whether the serial mode is used, and whether a match starts the
+ * capture (the trigger level goes up by one otherwise).
+ *
+ *          LSB              MSB LSB    MSB
+ * 1100xx10 XXXXXXXXXXXXXXXX YY??ZZZZ Z?SC????
+ *          |||||||||||||||| ||  |||| | ||
+ *          |||||||||||||||| ||  |||| | |+------ Start (1: Start capture)
+ *          |||||||||||||||| ||  |||| | +------- Serial (1: Serial mode)
+ *          |||||||||||||||| ||  ++++-+--------- Channel
+ *          |||||||||||||||| ++----------------- Level
+ *          ++++++++++++++++-------------------- Delay
+ */
+#define SUMP_TRIG_CONFIG 0xC2
+
+/**
+ * Mask to apply to a command to check whether it is a trigger command.
+ */
+#define SUMP_TRIG_COMMAND_MASK 0xF0
+
+/**
+ * Mask to apply to a trigger command to get what it sets (SUMP_TRIG,
+ * SUMP_TRIG_VALS, SUMP_TRIG_CONFIG).
+ */
+#define SUMP_TRIG_TYPE_MASK 0xC3
+
+/**
+ * How many trigger stages are available.
+ */
+#define SUMP_TRIGGER_STAGES 4
+
 /**
  * Not used, key means end of metadata.
  */
@@ -262,25 +397,231 @@
 #define SUMP_METADATA_PROTOCOL_SHORT_VERSION 0x41
 
 /**
- * Default timer period value for polling probes.
+ * Marks a stored sample as a run length count, when run length encoding is on.
+ *
+ * A count byte holds how many more times the sample before it was seen, in its
+ * lower seven bits.  Longer runs are stored as consecutive count bytes.
  */
-#define BP_DEFAULT_TIMER_PERIOD 0x00000640
+#define SUMP_RLE_COUNT_FLAG 0x80
+
+/**
+ * The longest run a single count byte can hold.
+ */
+#define SUMP_RLE_MAXIMUM_COUNT 0x7F
+
+/**
+ * Bits holding the probes state in a sample.
+ */
+#define SUMP_SAMPLE_PROBES_MASK ((1 << BP_SUMP_PROBES_COUNT) - 1)
+
+/**
+ * Sent at the end of a streaming capture if the serial link could not keep up.
+ */
+#define SUMP_STREAM_OVERRUN 0x80
 
 /**
- * How much memory is allocated for samples, in bytes.
+ * How many samples to take between checks for the host stopping a streaming
+ * capture.  Must be a power of two.
  */
-#define BP_SUMP_SAMPLE_MEMORY_SIZE BP_TERMINAL_BUFFER_SIZE
+#define SUMP_STREAM_POLL_INTERVAL 64
 
 /**
- * The highest sample rate for the Bus Pirate to sample data at, in Hz.
+ * How many bytes are sent to the host at once, one CDC packet.
  */
-#define BP_SUMP_MAXIMUM_SAMPLE_RATE 1000000
+#define SUMP_TRANSPORT_BLOCK_SIZE 64
+
+/**
+ * Size of the header sent before edge timestamp records.
+ */
+#define SUMP_EDGES_HEADER_SIZE 8
+
+/**
+ * Size of an edge timestamp record.
+ */
+#define SUMP_EDGES_RECORD_SIZE 4
+
+/**
+ * Position of the probe number in an edge timestamp record.
+ */
+#define SUMP_EDGES_CHANNEL_SHIFT 29
+
+/**
+ * Edge timestamp record flag for edges that could not be captured.
+ */
+#define SUMP_EDGES_LOST 0x10000000
+
+/**
+ * Edge timestamp record bits holding the timestamp.
+ */
+#define SUMP_EDGES_TIMESTAMP_MASK 0x0FFFFFFF
+
+/**
+ * How many Timer #2 periods an edge timestamp capture can last, as many as
+ * the record timestamp can hold (about 16.7 seconds).
+ */
+#define SUMP_EDGES_SPAN_PERIODS ((SUMP_EDGES_TIMESTAMP_MASK >> 16) + 1)
+
+/**
+ * How many polls of the input capture units go by between checks for the
+ * host stopping an edge timestamp capture.  Must be a power of two.
+ */
+#define SUMP_EDGES_POLL_INTERVAL 64
+
+/**
+ * Edge timestamp capture end reason, the sample memory is full.
+ */
+#define SUMP_EDGES_END_MEMORY_FULL 0x00
+
+/**
+ * Edge timestamp capture end reason, the timestamps would wrap around.
+ */
+#define SUMP_EDGES_END_SPAN_ELAPSED 0x01
+
+/**
+ * Edge timestamp capture end reason, the host sent a byte.
+ */
+#define SUMP_EDGES_END_STOPPED 0x02
+
+/**
+ * Size of the header sent before a bitstream capture.
+ */
+#define SUMP_BITSTREAM_HEADER_SIZE 5
+
+/**
+ * Slowest SPI clock a bitstream capture runs at, in instruction cycles per
+ * sample, with both SPI1 prescalers at their largest.
+ */
+#define SUMP_BITSTREAM_MAXIMUM_PERIOD (64 * 8)
+
+/**
+ * How many bytes can be in flight in the SPI1 FIFOs during a bitstream
+ * capture.
+ */
+#define SUMP_BITSTREAM_FIFO_DEPTH 8
+
+#ifdef BUSPIRATEV3
+
+/**
+ * Port the probes are on, RB6 (CS) to RB10 (AUX).
+ */
+#define SUMP_PROBES_PORT PORTB
+
+/**
+ * Position of the first probe in SUMP_PROBES_PORT.
+ */
+#define SUMP_PROBES_SHIFT 6
+
+/**
+ * Remappable pins of the probes, in probe order.
+ */
+#define SUMP_PROBES_RPIN                                                       \
+  { BP_CS_RPIN, BP_MISO_RPIN, BP_CLK_RPIN, BP_MOSI_RPIN, BP_AUX_RPIN }
+
+/**
+ * Turns a SUMP_PROBES_PORT word into a sample, with the first probe in bit 0.
+ */
+#define SUMP_PROBES_FROM_PORT(port)                                            \
+  ((uint8_t)(((port) >> SUMP_PROBES_SHIFT) & SUMP_SAMPLE_PROBES_MASK))
 
 /**
  * How many probes the Bus Pirate can use.
  */
 #define BP_SUMP_PROBES_COUNT 5
 
+/**
+ * Input capture control register bit set while the capture buffer is not
+ * empty.
+ */
+#define SUMP_EDGES_BUFFER_NOT_EMPTY _IC1CON_ICBNE_MASK
+
+/**
+ * Input capture control register bit set when captures were lost.
+ */
+#define SUMP_EDGES_OVERFLOW _IC1CON_ICOV_MASK
+
+/**
+ * Input capture control register mode bits.
+ */
+#define SUMP_EDGES_MODE_MASK _IC1CON_ICM_MASK
+
+/**
+ * Probe a bitstream capture samples, MISO.
+ */
+#define SUMP_BITSTREAM_PROBE 1
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Port the probes are on, RD1 (MOSI) to RD5 (AUX0), RD8 (AUX1) and RD0
+ * (AUX2).
+ */
+#define SUMP_PROBES_PORT PORTD
+
+/**
+ * Remappable pins of the probes, in probe order.
+ */
+#define SUMP_PROBES_RPIN                                                       \
+  {                                                                            \
+    BP_MOSI_RPIN, BP_CLK_RPIN, BP_MISO_RPIN, BP_CS_RPIN, BP_AUX0_RPIN,         \
+        BP_AUX1_RPIN, BP_AUX2_RPIN                                             \
+  }
+
+/**
+ * Turns a SUMP_PROBES_PORT word into a sample, with the first probe in bit 0.
+ *
+ * RD1 to RD5 go in bits 0 to 4 as on earlier firmware, AUX1 and AUX2 follow
+ * them in bits 5 and 6.  Bit 7 stays clear for run length encoding counts.
+ */
+#define SUMP_PROBES_FROM_PORT(port)                                            \
+  ((uint8_t)((((port) >> 1) & 0x1F) | (((port) >> 3) & 0x20) |                 \
+             (((port) << 6) & 0x40)))
+
+/**
+ * How many probes the Bus Pirate can use.
+ */
+#define BP_SUMP_PROBES_COUNT 7
+
+/**
+ * Input capture control register bit set while the capture buffer is not
+ * empty.
+ */
+#define SUMP_EDGES_BUFFER_NOT_EMPTY _IC1CON1_ICBNE_MASK
+
+/**
+ * Input capture control register bit set when captures were lost.
+ */
+#define SUMP_EDGES_OVERFLOW _IC1CON1_ICOV_MASK
+
+/**
+ * Input capture control register mode bits.
+ */
+#define SUMP_EDGES_MODE_MASK _IC1CON1_ICM_MASK
+
+/**
+ * Probe a bitstream capture samples, MISO.
+ */
+#define SUMP_BITSTREAM_PROBE 2
+
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Reads the probes state, with the first probe in bit 0.
+ */
+#define SUMP_READ_PROBES() sump_read_probes()
+
+/**
+ * Default timer period value for polling probes.
+ */
+#define BP_DEFAULT_TIMER_PERIOD 0x00000640
+
+/**
+ * How many samples the fixed period capture loops can store, as they take a
+ * full port word per sample.
+ */
+#define BP_SUMP_FAST_SAMPLE_MEMORY_SIZE (BP_SUMP_SAMPLE_MEMORY_SIZE / 2)
+
 /**
  * SUMP protocol version the Bus Pirate supports.
  */
@@ -301,7 +642,7 @@ static const uint8_t SUMP_METADATA[] = {
 #error "Invalid or unknown Bus Pirate version!"
 #endif /* BUSPIRATEV4 || BUSPIRATEV3 */
 
-    /* Sample memory (4096 bytes). */
+    /* Sample memory, as big as the terminal buffer. */
 
     SUMP_METADATA_SAMPLE_MEMORY_AVAILABLE,
     (uint8_t)((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE >> 24),
@@ -309,7 +650,7 @@ static const uint8_t SUMP_METADATA[] = {
     (uint8_t)(((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE >> 8) & 0xFF),
     (uint8_t)((uint32_t)BP_SUMP_SAMPLE_MEMORY_SIZE & 0xFF),
 
-    /* Sample rate (1MHz). */
+    /* Sample rate (16MHz). */
 
     SUMP_METADATA_MAXIMUM_SAMPLE_RATE,
     (uint8_t)((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE >> 24),
@@ -317,7 +658,14 @@ static const uint8_t SUMP_METADATA[] = {
     (uint8_t)(((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE >> 8) & 0xFF),
     (uint8_t)((uint32_t)BP_SUMP_MAXIMUM_SAMPLE_RATE & 0xFF),
 
-    /* Number of probes (5). */
+    /*
+     * Ancillary version, the metadata keys have no capability flags so the
+     * run length encoding support is advertised here.
+     */
+
+    SUMP_METADATA_ANCILLARY_VERSION, 'R', 'L', 'E', '\0',
+
+    /* Number of probes (5 on v3, 7 on v4). */
 
     SUMP_METADATA_USABLE_PROBES_SHORT_NUMBER, BP_SUMP_PROBES_COUNT,
 
@@ -346,7 +694,16 @@ typedef enum {
   SAMPLER_IDLE = 0,
 
   /** Sampler is either ready for acquisition or is currently acquiring. */
-  SAMPLER_ARMED
+  SAMPLER_ARMED,
+
+  /** Sampler is either ready for streaming or is currently streaming. */
+  SAMPLER_STREAMING,
+
+  /** Sampler is either ready for or is currently timestamping edges. */
+  SAMPLER_EDGES,
+
+  /** Sampler is either ready for or is currently shifting in MISO. */
+  SAMPLER_BITSTREAM
 } sump_sampler_state_t;
 
 /**
@@ -385,6 +742,47 @@ typedef struct {
   uint8_t count;
 } __attribute__((packed)) sump_command_t;
 
+/**
+ * Trigger stage configuration.
+ */
+typedef struct {
+  /** Which bits have to match. */
+  uint32_t mask;
+
+  /** The values the bits in the mask have to match. */
+  uint32_t values;
+
+  /** How many samples to wait after the stage matched. */
+  uint16_t delay;
+
+  /** The trigger level the stage is armed at. */
+  uint8_t level;
+
+  /** The channel to follow in serial mode. */
+  uint8_t channel;
+
+  /** Whether the stage matches the channel history rather than a sample. */
+  bool serial;
+
+  /** Whether a match starts the capture. */
+  bool start;
+} sump_trigger_stage_t;
+
+/**
+ * The trigger stages configuration.
+ */
+static sump_trigger_stage_t trigger_stages[SUMP_TRIGGER_STAGES];
+
+/**
+ * The last 32 samples of each stage channel, the newest in bit 0.
+ */
+static uint32_t trigger_serial_history[SUMP_TRIGGER_STAGES];
+
+/**
+ * The current trigger level.
+ */
+static uint8_t trigger_level;
+
 /**
  * The current state of the sampler.
  */
@@ -400,6 +798,81 @@ static sump_analyzer_command_state_t command_processor_state = RX_COMMAND_IDLE;
  */
 static unsigned int samples_to_acquire;
 
+/**
+ * How many samples should be acquired after the trigger fired, at most
+ * samples_to_acquire.
+ */
+static unsigned int samples_after_trigger;
+
+/**
+ * The requested sample period, in instruction cycles rounded to the nearest
+ * integer.
+ */
+static uint32_t sample_period_cycles;
+
+/**
+ * Whether streamed samples should be packed two per byte.
+ */
+static bool stream_packed = false;
+
+/**
+ * Which channel groups are left out of uploads, bit N set for group N.
+ */
+static uint8_t disabled_channel_groups = 0;
+
+/**
+ * Whether samples are uploaded oldest first.
+ */
+static bool upload_oldest_first = false;
+
+#ifdef BUSPIRATEV3
+
+/**
+ * Transport blocks, one is filled while the other one is being sent by the
+ * UART transmission interrupt.
+ */
+static uint8_t transport_blocks[2][SUMP_TRANSPORT_BLOCK_SIZE];
+
+/**
+ * The transport block currently being filled.
+ */
+static uint8_t transport_block_index;
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+extern BYTE *InPtr;
+extern BYTE ZLPpending;
+
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+
+/**
+ * Whether the current transfer goes to the isochronous endpoint.
+ */
+static bool transport_isochronous = false;
+
+/**
+ * Transport block for isochronous streams, copied into the endpoint packets.
+ */
+static uint8_t transport_block[SUMP_TRANSPORT_BLOCK_SIZE];
+
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
+
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Whether samples should be stored with run length encoding.
+ */
+static bool run_length_encoding = false;
+
+/**
+ * Reads SUMP_PROBES_PORT once and turns it into a sample.
+ *
+ * @return the probes state, with the first probe in bit 0.
+ */
+static inline uint8_t sump_read_probes(void);
+
 /**
  * Acquires data from the probes and sends it out to the controlling software.
  *
@@ -416,22 +889,300 @@ static unsigned int samples_to_acquire;
 static bool sump_acquire_samples(void);
 
 /**
- * Resets the device to start another buffer acquisition.
+ * How a timer driven capture ended.
  */
-static void sump_reset(void);
+typedef enum {
+  /** All requested samples were taken. */
+  SUMP_CAPTURE_COMPLETE = 0,
+
+  /** The host sent SUMP_XOFF, what was taken so far is to be uploaded. */
+  SUMP_CAPTURE_STOPPED,
+
+  /** The host sent another byte, kept in sump_interrupting_command. */
+  SUMP_CAPTURE_INTERRUPTED
+} sump_capture_result_t;
 
 /**
- * Processes the given byte as a part of a SUMP command.
- *
- * @param[in] input_byte the byte to process.
- * @return true if a SUMP_RESET command was received, false otherwise.
+ * The byte that interrupted the last timer driven capture.
  */
-static bool sump_handle_command_byte(uint8_t input_byte);
+static uint8_t sump_interrupting_command;
 
-void enter_sump_mode(void) {
+/**
+ * How many samples to take between checks for incoming host data, in the
+ * timer driven capture loops.  Must be a power of two.
+ */
+#define SUMP_CAPTURE_POLL_INTERVAL 256
 
-  /* Set probing channels to INPUT mode. */
-  IODIR |= AUX + MOSI + CLK + MISO + CS;
+/**
+ * Reads the byte the host sent during a capture.
+ *
+ * @return SUMP_CAPTURE_STOPPED for SUMP_XOFF, SUMP_CAPTURE_INTERRUPTED
+ * otherwise.
+ */
+static sump_capture_result_t sump_capture_interrupt(void);
+
+/**
+ * Captures samples into the terminal buffer with run length encoding, until
+ * samples_to_acquire bytes were stored.
+ *
+ * Timer #4 must already be running.  If the capture is stopped early,
+ * samples_to_acquire is set to how many bytes were stored.
+ *
+ * @return how the capture ended.
+ */
+static sump_capture_result_t sump_acquire_run_length_encoded_samples(void);
+
+/**
+ * Captures samples into the terminal buffer, used as a ring of
+ * samples_to_acquire bytes, until samples_after_trigger samples were taken
+ * after the trigger fired.
+ *
+ * The samples taken before the trigger are kept as long as they fit in the
+ * ring, so history is available when the read count is bigger than the delay
+ * count.  Timer #4 must already be running.  If the capture is stopped before
+ * the ring was filled once, samples_to_acquire is set to how many samples were
+ * taken.
+ *
+ * @param[out] oldest where to store the offset of the oldest sample.
+ *
+ * @return how the capture ended.
+ */
+static sump_capture_result_t sump_acquire_pretrigger_samples(size_t *oldest);
+
+/**
+ * Captures samples into the terminal buffer with a fixed period loop, if one
+ * matches the requested sample rate.
+ *
+ * The capture starts right away, with interrupts disabled.  If more samples
+ * were requested than what fits in BP_SUMP_FAST_SAMPLE_MEMORY_SIZE (or half
+ * of it at 8MHz, as those are decimated from a 16MHz capture), the samples
+ * before the first one are reported as holding its value.
+ *
+ * @return true if samples were captured, false if the timer driven loop has to
+ * be used instead.
+ */
+static bool sump_acquire_fast_samples(void);
+
+/**
+ * Checks whether a fixed period loop matches the requested sample rate.
+ *
+ * @return true if sump_acquire_fast_samples will capture samples, false
+ * otherwise.
+ */
+static bool sump_fast_capture_available(void);
+
+/**
+ * Captures samples at 16MHz, one cycle per sample.
+ *
+ * @param[out] buffer where to store raw port words.
+ * @param[in] samples how many samples to take, at most 16384.
+ */
+extern void sump_capture_16mhz(uint16_t *buffer, uint16_t samples);
+
+/**
+ * Captures samples at 4MHz, four cycles per sample.
+ *
+ * @param[out] buffer where to store raw port words.
+ * @param[in] samples how many samples to take.
+ */
+extern void sump_capture_4mhz(uint16_t *buffer, uint16_t samples);
+
+/**
+ * Captures samples at 2MHz, eight cycles per sample.
+ *
+ * @param[out] buffer where to store raw port words.
+ * @param[in] samples how many samples to take.
+ */
+extern void sump_capture_2mhz(uint16_t *buffer, uint16_t samples);
+
+/**
+ * Sends samples to the host as they are taken, until the host sends a byte or
+ * the serial link cannot keep up.
+ *
+ * Timer #4 must already be set up and the trigger must have fired.
+ */
+static void sump_stream_samples(void);
+
+/**
+ * Input capture unit registers used for an edge timestamp capture.
+ */
+typedef struct {
+  /** The control register, ICxCON or ICxCON1. */
+  volatile uint16_t *control;
+
+  /** The capture buffer register. */
+  volatile uint16_t *buffer;
+} sump_edges_unit_t;
+
+/**
+ * Input capture units timestamping the probes, in probe order.
+ */
+static const sump_edges_unit_t SUMP_EDGES_UNITS[BP_SUMP_PROBES_COUNT] = {
+#ifdef BUSPIRATEV4
+    {&IC1CON1, &IC1BUF}, {&IC2CON1, &IC2BUF}, {&IC3CON1, &IC3BUF},
+    {&IC4CON1, &IC4BUF}, {&IC5CON1, &IC5BUF}, {&IC6CON1, &IC6BUF},
+    {&IC7CON1, &IC7BUF}
+#else
+    {&IC1CON, &IC1BUF}, {&IC2CON, &IC2BUF}, {&IC3CON, &IC3BUF},
+    {&IC4CON, &IC4BUF}, {&IC5CON, &IC5BUF}
+#endif /* BUSPIRATEV4 */
+};
+
+/**
+ * Timestamps every edge on the probes into the terminal buffer, then sends
+ * the records to the host as described for SUMP_RUN_EDGES.
+ *
+ * The input capture units are polled, as the rest of the sampler does: each
+ * of them holds up to four edges, so a burst of edges on one probe can only
+ * be shorter than that if the loop keeps up.  Timer #2 runs freely at FCY
+ * and its periods are counted in software, which assumes the loop never
+ * stalls for half a period.
+ */
+static void sump_capture_edges(void);
+
+/**
+ * Routes the probes to the input capture units and sets them up to capture
+ * every edge against Timer #2, or tears all of that down again.
+ *
+ * @param[in] enable true to set the units up, false to release them.
+ */
+static void sump_edges_setup(const bool enable);
+
+/**
+ * Appends an edge timestamp record to the terminal buffer.
+ *
+ * @param[in,out] offset where to store the record, moved past it.
+ * @param[in] record the record to store.
+ */
+static inline void sump_edges_store(size_t *offset, const uint32_t record);
+
+/**
+ * Shifts MISO into the terminal buffer with SPI1, then sends the header and
+ * the samples to the host as described for SUMP_RUN_BITSTREAM.
+ *
+ * The enhanced buffer FIFOs are kept topped up with interrupts disabled, so
+ * SCK runs back to back for the whole capture.  SCK and SDO are not routed to
+ * any pin, and SPI1 is released again once done.
+ */
+static void sump_capture_bitstream(void);
+
+/**
+ * Picks the SPI1 prescalers for the bitstream capture sample period.
+ *
+ * @param[out] period the sample period picked, in instruction cycles.
+ *
+ * @return the SPRE and PPRE bits of SPI1CON1 for that period.
+ */
+static uint8_t sump_bitstream_prescalers(uint16_t *period);
+
+/**
+ * Stores a trigger stage setting from a fully received trigger command.
+ *
+ * @param[in] command the command bytes.
+ */
+static void sump_handle_trigger_command(const uint8_t *command);
+
+/**
+ * Checks whether any trigger stage has to be evaluated on samples.
+ *
+ * @return true if a stage has a non-empty mask, false if the capture should
+ * start right away.
+ */
+static bool sump_trigger_stages_in_use(void);
+
+/**
+ * Enables change notification on the given probes, for the first trigger stage
+ * to fire on.
+ *
+ * @param[in] probes the probes to watch, the first probe in bit 0.
+ */
+static void sump_change_trigger_enable(const uint8_t probes);
+
+/**
+ * Disables change notification on all probes.
+ */
+static void sump_change_trigger_disable(void);
+
+/**
+ * Checks whether change notification is enabled on any probe.
+ *
+ * @return true if a probe change fires the trigger, false otherwise.
+ */
+static bool sump_change_trigger_enabled(void);
+
+/**
+ * Runs the trigger stages state machine on the given sample.
+ *
+ * @param[in] sample the sample just taken.
+ * @param[out] delay where to store the matching start stage's delay.
+ *
+ * @return true if a start stage matched, false otherwise.
+ */
+static bool sump_trigger_evaluate(const uint8_t sample, uint16_t *delay);
+
+/**
+ * Sends the captured samples to the host, in the requested order and with one
+ * byte per enabled channel group.
+ *
+ * @param[in] oldest the offset of the oldest sample in the terminal buffer.
+ */
+static void sump_upload_samples(const size_t oldest);
+
+/**
+ * Gets the first block to fill with data for the host.
+ *
+ * Both captured sample uploads and streaming captures go through these
+ * transport functions.  On v4 the blocks are the CDC IN endpoint buffers
+ * themselves, so nothing gets copied, and on v3 the blocks are sent by the
+ * UART transmission interrupt while the next one is being filled.  Streams
+ * go to the isochronous endpoint instead if the host has selected it.
+ *
+ * @param[in] stream true for a streaming capture, false for an upload.
+ *
+ * @return a buffer of SUMP_TRANSPORT_BLOCK_SIZE bytes.
+ */
+static uint8_t *sump_transport_begin(const bool stream);
+
+/**
+ * Sends a block to the host, and gets the next block to fill.
+ *
+ * This returns as soon as the block is queued, only waiting for the previous
+ * block to be sent out if it has not been yet.
+ *
+ * @param[in] block the block to send.
+ * @param[in] length how many bytes of the block to send.
+ *
+ * @return a buffer of SUMP_TRANSPORT_BLOCK_SIZE bytes.
+ */
+static uint8_t *sump_transport_send(const uint8_t *block,
+                                    const size_t length);
+
+/**
+ * Waits for all blocks to be sent out.
+ */
+static void sump_transport_end(void);
+
+/**
+ * Resets the device to start another buffer acquisition.
+ */
+static void sump_reset(void);
+
+/**
+ * Processes the given byte as a part of a SUMP command.
+ *
+ * @param[in] input_byte the byte to process.
+ * @return true if a SUMP_RESET command was received, false otherwise.
+ */
+static bool sump_handle_command_byte(uint8_t input_byte);
+
+void enter_sump_mode(void) {
+
+  /* Set probing channels to INPUT mode. */
+  IODIR |= AUX + MOSI + CLK + MISO + CS;
+#ifdef BUSPIRATEV4
+  BP_AUX1_DIR = INPUT;
+  BP_AUX2_DIR = INPUT;
+#endif /* BUSPIRATEV4 */
 
   /* Reset the analyzer state. */
   sump_reset();
@@ -474,8 +1225,10 @@ void sump_reset(void) {
   CNPU2 = 0;
 
   /* Disable change notification for all pins. */
-  CNEN1 = 0;
-  CNEN2 = 0;
+  sump_change_trigger_disable();
+
+  /* Clear trigger stages. */
+  memset(trigger_stages, 0, sizeof(trigger_stages));
 
   /* Stop timer #4. */
   T4CON = 0;
@@ -486,9 +1239,16 @@ void sump_reset(void) {
   /* Setup timer periods. */
   PR5 = HI16(BP_DEFAULT_TIMER_PERIOD);
   PR4 = LO16(BP_DEFAULT_TIMER_PERIOD);
+  sample_period_cycles = BP_DEFAULT_TIMER_PERIOD;
 
-  /* Default to acquire a full buffer. */
+  /* Default to acquire a full buffer, all of it after the trigger. */
   samples_to_acquire = BP_SUMP_SAMPLE_MEMORY_SIZE;
+  samples_after_trigger = BP_SUMP_SAMPLE_MEMORY_SIZE;
+
+  /* Store raw samples by default, and upload them as the protocol says. */
+  run_length_encoding = false;
+  disabled_channel_groups = 0;
+  upload_oldest_first = false;
 
   /* Initialize the sampler. */
   sampler_state = SAMPLER_IDLE;
@@ -500,9 +1260,10 @@ bool sump_handle_command_byte(unsigned char input_byte) {
    * The command storage buffer.
    *
    * No need to clear it first, as it will be properly initialized upon
-   * receiving a long (5 bytes) command.
+   * receiving a long (5 bytes) command.  It has to persist across calls, as
+   * long commands arrive one byte at a time.
    */
-  sump_command_t command_buffer = {.bytes = {0}, .count = 0, .left = 0};
+  static sump_command_t command_buffer = {.bytes = {0}, .count = 0, .left = 0};
 
   switch (command_processor_state) {
 
@@ -522,6 +1283,10 @@ bool sump_handle_command_byte(unsigned char input_byte) {
 
     /* Arm the sampler. */
     case SUMP_RUN:
+    case SUMP_RUN_STREAMING:
+    case SUMP_RUN_STREAMING_PACKED:
+    case SUMP_RUN_EDGES:
+    case SUMP_RUN_BITSTREAM:
       /* Turn the LED on. */
       BP_LEDMODE = ON;
 
@@ -547,7 +1312,16 @@ bool sump_handle_command_byte(unsigned char input_byte) {
       IPC4bits.CNIP = 1;
 
       /* Update sampler state. */
-      sampler_state = SAMPLER_ARMED;
+      stream_packed = (input_byte == SUMP_RUN_STREAMING_PACKED);
+      if (input_byte == SUMP_RUN) {
+        sampler_state = SAMPLER_ARMED;
+      } else if (input_byte == SUMP_RUN_EDGES) {
+        sampler_state = SAMPLER_EDGES;
+      } else if (input_byte == SUMP_RUN_BITSTREAM) {
+        sampler_state = SAMPLER_BITSTREAM;
+      } else {
+        sampler_state = SAMPLER_STREAMING;
+      }
       break;
 
     /* Send device description. */
@@ -557,8 +1331,19 @@ bool sump_handle_command_byte(unsigned char input_byte) {
 
     /* Start/Stop data flow. */
     case SUMP_XON:
+      break;
+
     case SUMP_XOFF:
-      /* Stop and resume are not supported yet. */
+      /*
+       * A capture in progress is stopped by its own loop.  Getting here
+       * means nothing was sampled yet, so just disarm the sampler.
+       */
+      if (sampler_state != SAMPLER_IDLE) {
+        sump_change_trigger_disable();
+        T4CON = OFF;
+        BP_LEDMODE = OFF;
+        sampler_state = SAMPLER_IDLE;
+      }
       break;
 
     /* It must be a long command then. */
@@ -597,37 +1382,14 @@ bool sump_handle_command_byte(unsigned char input_byte) {
   case RX_COMMAND_PROCESS:
     switch (command_buffer.bytes[0]) {
     /* Set triggers. */
-    case SUMP_TRIG:
-
-      /* Set a trigger on the AUX pin. */
-      if (command_buffer.bytes[1] & 0b00010000) {
-        CNEN2 |= 0b0000000000000001;
-      }
-
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00001000) {
-        CNEN2 |= 0b0000000000100000;
-      }
-
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000100) {
-        CNEN2 |= 0b0000000001000000;
-      }
-
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000010) {
-        CNEN2 |= 0b0000000010000000;
-      }
-
-      /* Set a trigger on the ??? pin. */
-      if (command_buffer.bytes[1] & 0b00000001) {
-        CNEN2 |= 0b0000000100000000;
-      }
-
-      break;
-
     case SUMP_FLAGS:
-      /* @TODO: Fill this? */
+      /* @TODO: Handle the other flags? */
+      run_length_encoding = (command_buffer.bytes[2] & SUMP_FLAGS_RLE) != 0;
+      upload_oldest_first =
+          (command_buffer.bytes[2] & SUMP_FLAGS_OLDEST_FIRST) != 0;
+      disabled_channel_groups =
+          (command_buffer.bytes[1] & SUMP_FLAGS_CHANNEL_GROUPS_MASK) >>
+          SUMP_FLAGS_CHANNEL_GROUPS_SHIFT;
       break;
 
     /* Read requested samples buffer size. */
@@ -639,6 +1401,14 @@ bool sump_handle_command_byte(unsigned char input_byte) {
       if (samples_to_acquire > BP_SUMP_SAMPLE_MEMORY_SIZE) {
         samples_to_acquire = BP_SUMP_SAMPLE_MEMORY_SIZE;
       }
+
+      samples_after_trigger =
+          (((command_buffer.bytes[4] << 8) + command_buffer.bytes[3]) + 1) * 4;
+
+      /* There is no point in capturing more than what is read back. */
+      if (samples_after_trigger > samples_to_acquire) {
+        samples_after_trigger = samples_to_acquire;
+      }
       break;
 
     case SUMP_DIV: {
@@ -649,9 +1419,13 @@ bool sump_handle_command_byte(unsigned char input_byte) {
        * own 100MHz frequency range to the internal 16MIPs
        * range.
        */
-      period = (((((uint32_t)command_buffer.bytes[3] << 16) +
-                  ((uint32_t)command_buffer.bytes[2] << 8) +
-                  (uint32_t)command_buffer.bytes[1]) + 1) * 4) / 25;
+      period = ((((uint32_t)command_buffer.bytes[3] << 16) +
+                 ((uint32_t)command_buffer.bytes[2] << 8) +
+                 (uint32_t)command_buffer.bytes[1]) + 1) * 4;
+
+      /* The fixed period loops are picked by exact cycle counts. */
+      sample_period_cycles = (period + 12) / 25;
+      period /= 25;
 
       /* Round down if needed. */
       if (period > 0x10) {
@@ -666,6 +1440,12 @@ bool sump_handle_command_byte(unsigned char input_byte) {
 
       break;
     }
+
+    default:
+      if ((command_buffer.bytes[0] & SUMP_TRIG_COMMAND_MASK) == SUMP_TRIG) {
+        sump_handle_trigger_command(command_buffer.bytes);
+      }
+      break;
     }
 
     command_processor_state = RX_COMMAND_IDLE;
@@ -680,14 +1460,25 @@ bool sump_acquire_samples(void) {
 
   /* Can start sampling. */
   case SAMPLER_ARMED: {
+    sump_capture_result_t result;
     size_t offset;
+    size_t oldest;
 
-    /* Skip if no interrupt and no trigger set. */
-    if (!IFS1bits.CNIF && CNEN2) {
+    /*
+     * Skip if no interrupt and no trigger set, unless samples are taken
+     * while waiting for the trigger.  Run length encoded captures have no
+     * fixed sample period to keep history with, and the fixed period loops
+     * have no spare cycles to look for the trigger.
+     */
+    if (!IFS1bits.CNIF && sump_change_trigger_enabled() &&
+        (run_length_encoding || sump_fast_capture_available())) {
       break;
     }
 
     /* Take samples. */
+    if (IFS1bits.CNIF) {
+      bp_notify(BP_NOTIFICATION_TRIGGER);
+    }
 
     /* Start timer #4. */
     T4CONbits.TON = ON;
@@ -695,28 +1486,60 @@ bool sump_acquire_samples(void) {
     /* Clear timer #4 interrupt flag. */
     IFS1bits.T5IF = OFF;
 
-    /* Capture samples into the terminal buffer. */
-    for (offset = 0; offset < samples_to_acquire; offset++) {
-      bus_pirate_configuration.terminal_input[offset] = PORTB >> 6;
-
-      /* Wait for timer4 interrupt to trigger. */
-      while (IFS1bits.T5IF == OFF) {
+    BP_PROFILING_ENTER(BP_PROFILING_REGION_SUMP_CAPTURE);
+    oldest = 0;
+    result = SUMP_CAPTURE_COMPLETE;
+
+    if (!run_length_encoding && sump_acquire_fast_samples()) {
+      /* Samples are already in place. */
+    } else if (!run_length_encoding && sump_trigger_stages_in_use()) {
+      result = sump_acquire_pretrigger_samples(&oldest);
+    } else if (run_length_encoding) {
+      result = sump_acquire_run_length_encoded_samples();
+    } else {
+      /* Capture samples into the terminal buffer. */
+      for (offset = 0; offset < samples_to_acquire; offset++) {
+        bus_pirate_configuration.terminal_input[offset] = SUMP_READ_PROBES();
+
+        if (((offset & (SUMP_CAPTURE_POLL_INTERVAL - 1)) == 0) &&
+            user_serial_ready_to_read()) {
+          result = sump_capture_interrupt();
+          if (result == SUMP_CAPTURE_STOPPED) {
+            samples_to_acquire = offset + 1;
+          }
+          break;
+        }
+
+        /* Wait for timer4 interrupt to trigger. */
+        while (IFS1bits.T5IF == OFF) {
+        }
+
+        /* Clear timer #4 interrupt flag. */
+        IFS1bits.T5IF = OFF;
       }
+    }
 
-      /* Clear timer #4 interrupt flag. */
-      IFS1bits.T5IF = OFF;
+    if (result == SUMP_CAPTURE_INTERRUPTED) {
+      /*
+       * Let the host command through.  If the sampler is still armed
+       * afterwards the capture starts over, waiting for the trigger again.
+       */
+      T4CONbits.TON = OFF;
+      IFS1bits.CNIF = OFF;
+      BP_PROFILING_EXIT(BP_PROFILING_REGION_SUMP_CAPTURE);
+      return sump_handle_command_byte(sump_interrupting_command);
     }
 
-    /* Disable change notification for pins 16 to 31. */
-    CNEN2 = 0;
+    /* Disable change notification on the probes. */
+    sump_change_trigger_disable();
 
     /* Stop timer #4. */
     T4CON = OFF;
+    BP_PROFILING_EXIT(BP_PROFILING_REGION_SUMP_CAPTURE);
 
     /* Write captured samples out. */
-    for (offset = samples_to_acquire; offset > 0; offset--) {
-      user_serial_transmit_character(bus_pirate_configuration.terminal_input[offset - 1]);
-    }
+    bp_notify(BP_NOTIFICATION_CAPTURE_COMPLETE);
+    sump_upload_samples(oldest);
 
     /* Reset the analyzer state. */
     sump_reset();
@@ -725,6 +1548,51 @@ bool sump_acquire_samples(void) {
     return true;
   }
 
+  case SAMPLER_STREAMING:
+    /* Skip if no interrupt and no trigger set. */
+    if (!IFS1bits.CNIF && sump_change_trigger_enabled()) {
+      break;
+    }
+
+    if (IFS1bits.CNIF) {
+      bp_notify(BP_NOTIFICATION_TRIGGER);
+    }
+    sump_stream_samples();
+    bp_notify(BP_NOTIFICATION_CAPTURE_COMPLETE);
+
+    /* Disable change notification on the probes. */
+    sump_change_trigger_disable();
+
+    /* Reset the analyzer state. */
+    sump_reset();
+
+    /* Acquisition complete. */
+    return true;
+
+  case SAMPLER_EDGES:
+  case SAMPLER_BITSTREAM:
+    /* Skip if no interrupt and no trigger set. */
+    if (!IFS1bits.CNIF && sump_change_trigger_enabled()) {
+      break;
+    }
+
+    /* Disable change notification on the probes. */
+    sump_change_trigger_disable();
+
+    BP_PROFILING_ENTER(BP_PROFILING_REGION_SUMP_CAPTURE);
+    if (sampler_state == SAMPLER_EDGES) {
+      sump_capture_edges();
+    } else {
+      sump_capture_bitstream();
+    }
+    BP_PROFILING_EXIT(BP_PROFILING_REGION_SUMP_CAPTURE);
+
+    /* Reset the analyzer state. */
+    sump_reset();
+
+    /* Acquisition complete. */
+    return true;
+
   case SAMPLER_IDLE:
   default:
     /* Nothing to do. */
@@ -735,4 +1603,893 @@ bool sump_acquire_samples(void) {
   return false;
 }
 
+sump_capture_result_t sump_capture_interrupt(void) {
+  sump_interrupting_command = user_serial_read_byte();
+  return (sump_interrupting_command == SUMP_XOFF) ? SUMP_CAPTURE_STOPPED
+                                                  : SUMP_CAPTURE_INTERRUPTED;
+}
+
+sump_capture_result_t sump_acquire_pretrigger_samples(size_t *oldest) {
+  sump_capture_result_t result;
+  size_t offset;
+  unsigned int remaining;
+  unsigned int poll;
+  uint16_t delay;
+  uint8_t sample;
+  bool triggered;
+  bool wrapped;
+
+  offset = 0;
+  remaining = samples_after_trigger;
+  poll = 0;
+  triggered = false;
+  wrapped = false;
+  result = SUMP_CAPTURE_COMPLETE;
+  trigger_level = 0;
+  memset(trigger_serial_history, 0, sizeof(trigger_serial_history));
+
+  for (;;) {
+    sample = SUMP_READ_PROBES();
+    bus_pirate_configuration.terminal_input[offset] = sample;
+    offset++;
+    if (offset == samples_to_acquire) {
+      offset = 0;
+      wrapped = true;
+    }
+
+    if (triggered) {
+      if (--remaining == 0) {
+        break;
+      }
+    } else if (sump_trigger_evaluate(sample, &delay)) {
+      /* The sample just taken is the first one after the trigger. */
+      triggered = true;
+      bp_notify(BP_NOTIFICATION_TRIGGER);
+      remaining += delay;
+      if (--remaining == 0) {
+        break;
+      }
+    }
+
+    poll = (poll + 1) & (SUMP_CAPTURE_POLL_INTERVAL - 1);
+    if ((poll == 0) && user_serial_ready_to_read()) {
+      result = sump_capture_interrupt();
+      if (result == SUMP_CAPTURE_INTERRUPTED) {
+        return result;
+      }
+      if (!wrapped) {
+        /* Only the slots before offset hold samples of this capture. */
+        samples_to_acquire = offset;
+        offset = 0;
+      }
+      break;
+    }
+
+    /* Wait for timer4 interrupt to trigger. */
+    while (IFS1bits.T5IF == OFF) {
+    }
+
+    /* Clear timer #4 interrupt flag. */
+    IFS1bits.T5IF = OFF;
+  }
+
+  /* The next slot to be written holds the oldest sample. */
+  *oldest = offset;
+  return result;
+}
+
+void sump_handle_trigger_command(const uint8_t *command) {
+  sump_trigger_stage_t *stage;
+
+  stage = &trigger_stages[(command[0] >> 2) & (SUMP_TRIGGER_STAGES - 1)];
+
+  switch (command[0] & SUMP_TRIG_TYPE_MASK) {
+  case SUMP_TRIG:
+    stage->mask = ((uint32_t)command[4] << 24) |
+                  ((uint32_t)command[3] << 16) |
+                  ((uint32_t)command[2] << 8) | command[1];
+
+    /* Only the first stage can fire a change notification. */
+    if (stage != &trigger_stages[0]) {
+      break;
+    }
+
+    sump_change_trigger_enable(command[1]);
+    break;
+
+  case SUMP_TRIG_VALS:
+    stage->values = ((uint32_t)command[4] << 24) |
+                    ((uint32_t)command[3] << 16) |
+                    ((uint32_t)command[2] << 8) | command[1];
+    break;
+
+  case SUMP_TRIG_CONFIG:
+    stage->delay = (command[2] << 8) | command[1];
+    stage->level = command[3] & 0x03;
+    stage->channel = ((command[3] >> 4) | (command[4] << 4)) & 0x1F;
+    stage->serial = (command[4] & 0b00000100) != 0;
+    stage->start = (command[4] & 0b00001000) != 0;
+    break;
+
+  default:
+    break;
+  }
+}
+
+#ifdef BUSPIRATEV3
+
+void sump_change_trigger_enable(const uint8_t probes) {
+  /* Set a trigger on the AUX pin. */
+  if (probes & 0b00010000) {
+    CNEN2 |= 0b0000000000000001;
+  }
+
+  /* Set a trigger on the MOSI pin. */
+  if (probes & 0b00001000) {
+    CNEN2 |= 0b0000000000100000;
+  }
+
+  /* Set a trigger on the CLK pin. */
+  if (probes & 0b00000100) {
+    CNEN2 |= 0b0000000001000000;
+  }
+
+  /* Set a trigger on the MISO pin. */
+  if (probes & 0b00000010) {
+    CNEN2 |= 0b0000000010000000;
+  }
+
+  /* Set a trigger on the CS pin. */
+  if (probes & 0b00000001) {
+    CNEN2 |= 0b0000000100000000;
+  }
+}
+
+void sump_change_trigger_disable(void) {
+  CNEN1 = 0;
+  CNEN2 = 0;
+}
+
+bool sump_change_trigger_enabled(void) { return CNEN2 != 0; }
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+/**
+ * Change notification enable bits for the probes in CNEN1 (CS and AUX0).
+ */
+#define SUMP_CNEN1_PROBES_MASK 0b0110000000000000
+
+/**
+ * Change notification enable bits for the probes in CNEN4 (AUX2, MOSI, CLK
+ * and MISO).
+ */
+#define SUMP_CNEN4_PROBES_MASK 0b0000000000011110
+
+void sump_change_trigger_enable(const uint8_t probes) {
+  /*
+   * AUX1 has no change notification input, leave the trigger to be evaluated
+   * on samples rather than firing on the other probes alone.
+   */
+  if (probes & 0b00100000) {
+    return;
+  }
+
+  /* Set a trigger on the AUX2 pin. */
+  if (probes & 0b01000000) {
+    CNEN4 |= 0b0000000000000010;
+  }
+
+  /* Set a trigger on the AUX0 pin. */
+  if (probes & 0b00010000) {
+    CNEN1 |= 0b0100000000000000;
+  }
+
+  /* Set a trigger on the CS pin. */
+  if (probes & 0b00001000) {
+    CNEN1 |= 0b0010000000000000;
+  }
+
+  /* Set a trigger on the MISO pin. */
+  if (probes & 0b00000100) {
+    CNEN4 |= 0b0000000000010000;
+  }
+
+  /* Set a trigger on the CLK pin. */
+  if (probes & 0b00000010) {
+    CNEN4 |= 0b0000000000001000;
+  }
+
+  /* Set a trigger on the MOSI pin. */
+  if (probes & 0b00000001) {
+    CNEN4 |= 0b0000000000000100;
+  }
+}
+
+void sump_change_trigger_disable(void) {
+  /* Leave change notification alone on pins that are not probes. */
+  CNEN1 &= ~SUMP_CNEN1_PROBES_MASK;
+  CNEN4 &= ~SUMP_CNEN4_PROBES_MASK;
+}
+
+bool sump_change_trigger_enabled(void) {
+  return ((CNEN1 & SUMP_CNEN1_PROBES_MASK) != 0) ||
+         ((CNEN4 & SUMP_CNEN4_PROBES_MASK) != 0);
+}
+
+#endif /* BUSPIRATEV4 */
+
+bool sump_trigger_stages_in_use(void) {
+  size_t index;
+
+  for (index = 0; index < SUMP_TRIGGER_STAGES; index++) {
+    if (trigger_stages[index].mask != 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool sump_trigger_evaluate(const uint8_t sample, uint16_t *delay) {
+  size_t index;
+  uint32_t word;
+  const sump_trigger_stage_t *stage;
+  bool advanced;
+
+  advanced = false;
+  for (index = 0; index < SUMP_TRIGGER_STAGES; index++) {
+    stage = &trigger_stages[index];
+
+    if (stage->serial) {
+      trigger_serial_history[index] = (trigger_serial_history[index] << 1) |
+                                      ((sample >> stage->channel) & 0x01);
+      word = trigger_serial_history[index];
+    } else {
+      word = sample;
+    }
+
+    /*
+     * Skip stages that are unused or not armed yet, the serial history still
+     * has to be kept up to date.
+     */
+    if (advanced || ((stage->mask == 0) && !stage->start) ||
+        (stage->level != trigger_level)) {
+      continue;
+    }
+
+    if (((word ^ stage->values) & stage->mask) == 0) {
+      if (stage->start) {
+        *delay = stage->delay;
+        return true;
+      }
+
+      /* Arm the next level, which will be looked at from the next sample. */
+      trigger_level++;
+      advanced = true;
+    }
+  }
+
+  return false;
+}
+
+void sump_upload_samples(const size_t oldest) {
+  uint8_t *block;
+  size_t fill;
+  size_t count;
+  size_t index;
+  uint8_t group;
+
+  block = sump_transport_begin(false);
+  fill = 0;
+
+  for (count = 0; count < samples_to_acquire; count++) {
+    index = upload_oldest_first ? (oldest + count)
+                                : (oldest + samples_to_acquire - 1 - count);
+    if (index >= samples_to_acquire) {
+      index -= samples_to_acquire;
+    }
+
+    for (group = 0; group < SUMP_CHANNEL_GROUPS; group++) {
+      if (disabled_channel_groups & (1 << group)) {
+        continue;
+      }
+
+      block[fill++] =
+          (group == 0) ? bus_pirate_configuration.terminal_input[index] : 0;
+      if (fill == SUMP_TRANSPORT_BLOCK_SIZE) {
+        block = sump_transport_send(block, fill);
+        fill = 0;
+      }
+    }
+  }
+
+  if (fill > 0) {
+    sump_transport_send(block, fill);
+  }
+
+  sump_transport_end();
+}
+
+#ifdef BUSPIRATEV3
+
+uint8_t *sump_transport_begin(const bool stream __attribute__((unused))) {
+  /* Block transfers must not interleave with the transmission ring. */
+  user_serial_wait_transmission_done();
+
+  UART1TXSent = 0;
+  UART1TXAvailable = 0;
+  transport_block_index = 0;
+  return transport_blocks[0];
+}
+
+uint8_t *sump_transport_send(const uint8_t *block, const size_t length) {
+  /* Wait for the other block to be sent out. */
+  while (UART1TXSent != UART1TXAvailable) {
+  }
+
+  UART1TXBuf = block;
+  UART1TXSent = 0;
+  UART1TXAvailable = length;
+  user_serial_process_transmission_interrupt();
+
+  transport_block_index ^= 1;
+  return transport_blocks[transport_block_index];
+}
+
+void sump_transport_end(void) {
+  while (UART1TXSent != UART1TXAvailable) {
+  }
+
+  user_serial_wait_transmission_done();
+}
+
+#endif /* BUSPIRATEV3 */
+
+#ifdef BUSPIRATEV4
+
+uint8_t *sump_transport_begin(const bool stream __attribute__((unused))) {
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+  transport_isochronous = stream && isochronous_active();
+  if (transport_isochronous) {
+    return transport_block;
+  }
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
+
+  /* Start from an empty endpoint buffer. */
+  CDC_Flush_In_Now();
+  return InPtr;
+}
+
+uint8_t *sump_transport_send(const uint8_t *block, const size_t length) {
+#ifdef BP_USB_ISOCHRONOUS_STREAM
+  if (transport_isochronous) {
+    /* Copied into the packet being filled, the block can be reused. */
+    isochronous_putbuffer(block, length);
+    return transport_block;
+  }
+#endif /* BP_USB_ISOCHRONOUS_STREAM */
+
+  /* This switches InPtr to the other endpoint buffer. */
+  putda_cdc(length);
+
+  /* Let the SOF handler close the transfer if the packet was full. */
+  ZLPpending = (length == CDC_BUFFER_SIZE);
+  return InPtr;
+}
+
+void sump_transport_end(void) {}
+
+#endif /* BUSPIRATEV4 */
+
+void sump_stream_samples(void) {
+  uint8_t *block;
+  size_t fill;
+  uint8_t sample;
+  bool half;
+  unsigned int poll;
+
+  block = sump_transport_begin(true);
+  fill = 0;
+  half = false;
+  poll = 0;
+
+  /* Start timer #4. */
+  T4CONbits.TON = ON;
+
+  /* Clear timer #4 interrupt flag. */
+  IFS1bits.T5IF = OFF;
+
+  for (;;) {
+
+    /* Wait for timer4 interrupt to trigger. */
+    while (IFS1bits.T5IF == OFF) {
+    }
+
+    /* Clear timer #4 interrupt flag. */
+    IFS1bits.T5IF = OFF;
+
+    sample = SUMP_READ_PROBES() & SUMP_SAMPLE_PROBES_MASK;
+
+    if (!stream_packed) {
+      block[fill++] = sample;
+    } else if (half) {
+      block[fill++] |= sample << 4;
+      half = false;
+    } else {
+      block[fill] = sample & 0x0F;
+      half = true;
+    }
+
+    if (fill == SUMP_TRANSPORT_BLOCK_SIZE) {
+      block = sump_transport_send(block, fill);
+      fill = 0;
+    }
+
+    /* A full period went by while queueing the sample. */
+    if (IFS1bits.T5IF) {
+      if (!stream_packed) {
+        block[fill++] = SUMP_STREAM_OVERRUN;
+      }
+      bp_notify(BP_NOTIFICATION_OVERFLOW);
+      break;
+    }
+
+    poll = (poll + 1) & (SUMP_STREAM_POLL_INTERVAL - 1);
+    if ((poll == 0) && user_serial_ready_to_read()) {
+      /* Any byte stops the stream. */
+      user_serial_read_byte();
+      break;
+    }
+  }
+
+  /* Stop timer #4. */
+  T4CON = OFF;
+
+  if (fill > 0) {
+    sump_transport_send(block, fill);
+  }
+  sump_transport_end();
+}
+
+void sump_edges_setup(const bool enable) {
+  static const uint8_t PROBES_RPIN[BP_SUMP_PROBES_COUNT] = SUMP_PROBES_RPIN;
+  uint8_t channel;
+
+  /* Free running 16 bits Timer2, clocked at FCY. */
+  T2CON = 0x0000;
+  TMR2 = 0x0000;
+  PR2 = 0xFFFF;
+  IFS0bits.T2IF = OFF;
+
+  for (channel = 0; channel < BP_SUMP_PROBES_COUNT; channel++) {
+    *SUMP_EDGES_UNITS[channel].control = 0x0000;
+  }
+
+#ifdef BUSPIRATEV4
+  IC1CON2 = 0x0000;
+  IC2CON2 = 0x0000;
+  IC3CON2 = 0x0000;
+  IC4CON2 = 0x0000;
+  IC5CON2 = 0x0000;
+  IC6CON2 = 0x0000;
+  IC7CON2 = 0x0000;
+#endif /* BUSPIRATEV4 */
+
+  if (!enable) {
+    /* Neuter the input capture units. */
+    RPINR7bits.IC1R = 0b011111;
+    RPINR7bits.IC2R = 0b011111;
+    RPINR8bits.IC3R = 0b011111;
+    RPINR8bits.IC4R = 0b011111;
+    RPINR9bits.IC5R = 0b011111;
+#ifdef BUSPIRATEV4
+    RPINR9bits.IC6R = 0b011111;
+    RPINR10bits.IC7R = 0b011111;
+#endif /* BUSPIRATEV4 */
+    return;
+  }
+
+  RPINR7bits.IC1R = PROBES_RPIN[0];
+  RPINR7bits.IC2R = PROBES_RPIN[1];
+  RPINR8bits.IC3R = PROBES_RPIN[2];
+  RPINR8bits.IC4R = PROBES_RPIN[3];
+  RPINR9bits.IC5R = PROBES_RPIN[4];
+#ifdef BUSPIRATEV4
+  RPINR9bits.IC6R = PROBES_RPIN[5];
+  RPINR10bits.IC7R = PROBES_RPIN[6];
+#endif /* BUSPIRATEV4 */
+
+#ifdef BUSPIRATEV4
+  /*
+   * ICxCON2: synchronise with Timer2, so all units count together.
+   * ICxCON1: capture every edge, use Timer2.
+   */
+  IC1CON2 = 0b01100 << _IC1CON2_SYNCSEL_POSITION;
+  IC2CON2 = 0b01100 << _IC2CON2_SYNCSEL_POSITION;
+  IC3CON2 = 0b01100 << _IC3CON2_SYNCSEL_POSITION;
+  IC4CON2 = 0b01100 << _IC4CON2_SYNCSEL_POSITION;
+  IC5CON2 = 0b01100 << _IC5CON2_SYNCSEL_POSITION;
+  IC6CON2 = 0b01100 << _IC6CON2_SYNCSEL_POSITION;
+  IC7CON2 = 0b01100 << _IC7CON2_SYNCSEL_POSITION;
+  for (channel = 0; channel < BP_SUMP_PROBES_COUNT; channel++) {
+    *SUMP_EDGES_UNITS[channel].control =
+        (0b001 << _IC1CON1_ICM_POSITION) | (0b001 << _IC1CON1_ICTSEL_POSITION);
+  }
+  IC1TMR = 0x0000;
+  IC2TMR = 0x0000;
+  IC3TMR = 0x0000;
+  IC4TMR = 0x0000;
+  IC5TMR = 0x0000;
+  IC6TMR = 0x0000;
+  IC7TMR = 0x0000;
+#else
+  /* ICxCON: capture every edge, TMR2 contents are captured on event. */
+  for (channel = 0; channel < BP_SUMP_PROBES_COUNT; channel++) {
+    *SUMP_EDGES_UNITS[channel].control =
+        (0b001 << _IC1CON_ICM_POSITION) | (ON << _IC1CON_ICTMR_POSITION);
+  }
+#endif /* BUSPIRATEV4 */
+}
+
+uint8_t sump_read_probes(void) {
+  const uint16_t port = SUMP_PROBES_PORT;
+
+  return SUMP_PROBES_FROM_PORT(port);
+}
+
+void sump_edges_store(size_t *offset, const uint32_t record) {
+  bus_pirate_configuration.terminal_input[*offset] = HI8(HI16(record));
+  bus_pirate_configuration.terminal_input[*offset + 1] = LO8(HI16(record));
+  bus_pirate_configuration.terminal_input[*offset + 2] = HI8(LO16(record));
+  bus_pirate_configuration.terminal_input[*offset + 3] = LO8(LO16(record));
+  *offset += SUMP_EDGES_RECORD_SIZE;
+}
+
+void sump_capture_edges(void) {
+  const sump_edges_unit_t *unit;
+  size_t offset;
+  size_t capacity;
+  uint32_t now;
+  uint16_t period;
+  uint16_t status;
+  uint16_t value;
+  uint8_t channel;
+  uint8_t initial;
+  uint8_t reason;
+  unsigned int poll;
+
+  capacity = samples_to_acquire -
+             (samples_to_acquire % SUMP_EDGES_RECORD_SIZE);
+  offset = 0;
+  period = 0;
+  poll = 0;
+
+  sump_edges_setup(true);
+
+  /* Flush whatever was captured while setting things up. */
+  for (channel = 0; channel < BP_SUMP_PROBES_COUNT; channel++) {
+    while (*SUMP_EDGES_UNITS[channel].control & SUMP_EDGES_BUFFER_NOT_EMPTY) {
+      (void)*SUMP_EDGES_UNITS[channel].buffer;
+    }
+  }
+
+  initial = SUMP_READ_PROBES() & SUMP_SAMPLE_PROBES_MASK;
+  T2CONbits.TON = ON;
+
+  for (;;) {
+    for (channel = 0; channel < BP_SUMP_PROBES_COUNT; channel++) {
+      unit = &SUMP_EDGES_UNITS[channel];
+      status = *unit->control;
+
+      while ((*unit->control & SUMP_EDGES_BUFFER_NOT_EMPTY) &&
+             (offset < capacity)) {
+        value = *unit->buffer;
+
+        /* A capture right after a rollover not counted yet is a new period. */
+        now = ((uint32_t)((IFS0bits.T2IF && (value < 0x8000)) ? period + 1
+                                                              : period)
+               << 16) |
+              value;
+        sump_edges_store(&offset,
+                         ((uint32_t)channel << SUMP_EDGES_CHANNEL_SHIFT) |
+                             (now & SUMP_EDGES_TIMESTAMP_MASK));
+      }
+
+      /* The unit stops capturing on overflows, restart it. */
+      if ((status & SUMP_EDGES_OVERFLOW) && (offset < capacity)) {
+        while (*unit->control & SUMP_EDGES_BUFFER_NOT_EMPTY) {
+          (void)*unit->buffer;
+        }
+        status = *unit->control;
+        *unit->control = status & ~SUMP_EDGES_MODE_MASK;
+        *unit->control = status & ~SUMP_EDGES_OVERFLOW;
+
+        value = TMR2;
+        now = ((uint32_t)((IFS0bits.T2IF && (value < 0x8000)) ? period + 1
+                                                              : period)
+               << 16) |
+              value;
+        sump_edges_store(
+            &offset, ((uint32_t)channel << SUMP_EDGES_CHANNEL_SHIFT) |
+                         SUMP_EDGES_LOST |
+                         (now & SUMP_EDGES_TIMESTAMP_MASK & ~1UL) |
+                         ((SUMP_READ_PROBES() >> channel) & 0x01));
+      }
+    }
+
+    if (offset >= capacity) {
+      reason = SUMP_EDGES_END_MEMORY_FULL;
+      break;
+    }
+
+    if (IFS0bits.T2IF) {
+      IFS0bits.T2IF = OFF;
+      if (++period == SUMP_EDGES_SPAN_PERIODS) {
+        reason = SUMP_EDGES_END_SPAN_ELAPSED;
+        break;
+      }
+    }
+
+    poll = (poll + 1) & (SUMP_EDGES_POLL_INTERVAL - 1);
+    if ((poll == 0) && user_serial_ready_to_read()) {
+      /* Any byte stops the capture. */
+      user_serial_read_byte();
+      reason = SUMP_EDGES_END_STOPPED;
+      break;
+    }
+  }
+
+  value = TMR2;
+  if (IFS0bits.T2IF && (value < 0x8000)) {
+    period++;
+  }
+  now = ((uint32_t)period << 16) | value;
+  if (reason == SUMP_EDGES_END_SPAN_ELAPSED) {
+    now = SUMP_EDGES_TIMESTAMP_MASK;
+  }
+
+  sump_edges_setup(false);
+
+  user_serial_transmit_character(HI8(offset / SUMP_EDGES_RECORD_SIZE));
+  user_serial_transmit_character(LO8(offset / SUMP_EDGES_RECORD_SIZE));
+  user_serial_transmit_character(initial);
+  user_serial_transmit_character(reason);
+  user_serial_transmit_character(HI8(HI16(now)));
+  user_serial_transmit_character(LO8(HI16(now)));
+  user_serial_transmit_character(HI8(LO16(now)));
+  user_serial_transmit_character(LO8(LO16(now)));
+  bp_write_buffer(bus_pirate_configuration.terminal_input, offset);
+}
+
+uint8_t sump_bitstream_prescalers(uint16_t *period) {
+  static const uint8_t primary_ratios[] = {64, 16, 4, 1};
+  uint16_t wanted;
+  uint16_t candidate;
+  uint8_t primary;
+  uint8_t secondary;
+  uint8_t prescalers;
+
+  wanted = (sample_period_cycles > SUMP_BITSTREAM_MAXIMUM_PERIOD)
+               ? SUMP_BITSTREAM_MAXIMUM_PERIOD
+               : (uint16_t)sample_period_cycles;
+  *period = SUMP_BITSTREAM_MAXIMUM_PERIOD;
+  prescalers = 0;
+
+  /* PPRE counts down from 64:1 and SPRE from 8:1, both 1:1 is invalid. */
+  for (primary = 0; primary < sizeof(primary_ratios); primary++) {
+    for (secondary = 1; secondary <= 8; secondary++) {
+      candidate = primary_ratios[primary] * secondary;
+      if ((candidate < 2) || (candidate < wanted) || (candidate >= *period)) {
+        continue;
+      }
+      *period = candidate;
+      prescalers = ((8 - secondary) << 2) | primary;
+    }
+  }
+
+  return prescalers;
+}
+
+void sump_capture_bitstream(void) {
+  size_t sent;
+  size_t received;
+  uint16_t period;
+  uint16_t interrupt_priority;
+
+  /* SPI1 shifts MISO in as a master, with no clock or data going out. */
+  SPI1STATbits.SPIEN = OFF;
+  RPINR20bits.SDI1R = BP_MISO_RPIN;
+  SPI1CON1 = (sump_bitstream_prescalers(&period) << _SPI1CON1_PPRE_POSITION) |
+             (ON << _SPI1CON1_MSTEN_POSITION);
+  SPI1CON2 = ON << _SPI1CON2_SPIBEN_POSITION;
+  SPI1STAT = 0x0000;
+  SPI1STATbits.SPIEN = ON;
+
+  sent = 0;
+  received = 0;
+
+  /* Nothing must let the transmission FIFO run dry. */
+  interrupt_priority = SRbits.IPL;
+  SRbits.IPL = 7;
+
+  while (received < samples_to_acquire) {
+    if ((sent < samples_to_acquire) && (SPI1STATbits.SPITBF == NO) &&
+        ((sent - received) < SUMP_BITSTREAM_FIFO_DEPTH)) {
+      SPI1BUF = 0x00;
+      sent++;
+    }
+
+    if (SPI1STATbits.SRXMPT == NO) {
+      bus_pirate_configuration.terminal_input[received++] = SPI1BUF;
+    }
+  }
+
+  SRbits.IPL = interrupt_priority;
+
+  SPI1STATbits.SPIEN = OFF;
+  RPINR20bits.SDI1R = 0b11111;
+
+  user_serial_transmit_character(SUMP_BITSTREAM_PROBE);
+  user_serial_transmit_character(HI8(period));
+  user_serial_transmit_character(LO8(period));
+  user_serial_transmit_character(HI8(samples_to_acquire));
+  user_serial_transmit_character(LO8(samples_to_acquire));
+  bp_write_buffer(bus_pirate_configuration.terminal_input, samples_to_acquire);
+}
+
+bool sump_fast_capture_available(void) {
+  switch (sample_period_cycles) {
+  case 0:
+  case 1:
+  case 2:
+  case 4:
+  case 8:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+bool sump_acquire_fast_samples(void) {
+  uint16_t *words;
+  uint16_t samples;
+  uint16_t stride;
+  uint16_t offset;
+  uint16_t interrupt_priority;
+
+  stride = 1;
+  samples = (samples_to_acquire > BP_SUMP_FAST_SAMPLE_MEMORY_SIZE)
+                ? BP_SUMP_FAST_SAMPLE_MEMORY_SIZE
+                : samples_to_acquire;
+  words = (uint16_t *)bus_pirate_configuration.terminal_input;
+
+  /* Nothing must get in the way of the capture loop timing. */
+  interrupt_priority = SRbits.IPL;
+
+  switch (sample_period_cycles) {
+  case 0:
+  case 1:
+    SRbits.IPL = 7;
+    sump_capture_16mhz(words, samples);
+    break;
+
+  case 2:
+    /* Keep every other sample of a 16MHz capture. */
+    if (samples > (BP_SUMP_FAST_SAMPLE_MEMORY_SIZE / 2)) {
+      samples = BP_SUMP_FAST_SAMPLE_MEMORY_SIZE / 2;
+    }
+    stride = 2;
+    SRbits.IPL = 7;
+    sump_capture_16mhz(words, samples * 2);
+    break;
+
+  case 4:
+    SRbits.IPL = 7;
+    sump_capture_4mhz(words, samples);
+    break;
+
+  case 8:
+    SRbits.IPL = 7;
+    sump_capture_2mhz(words, samples);
+    break;
+
+  default:
+    return false;
+  }
+
+  SRbits.IPL = interrupt_priority;
+
+  /* Pack samples as bytes, this never overwrites words not yet read. */
+  for (offset = 0; offset < samples; offset++) {
+    bus_pirate_configuration.terminal_input[offset] =
+        SUMP_PROBES_FROM_PORT(words[offset * stride]);
+  }
+
+  /* Newest samples go at the end of the buffer, pad the oldest ones. */
+  if (samples < samples_to_acquire) {
+    memmove(bus_pirate_configuration.terminal_input +
+                (samples_to_acquire - samples),
+            bus_pirate_configuration.terminal_input, samples);
+    memset(bus_pirate_configuration.terminal_input,
+           bus_pirate_configuration.terminal_input[samples_to_acquire -
+                                                   samples],
+           samples_to_acquire - samples);
+  }
+
+  return true;
+}
+
+sump_capture_result_t sump_acquire_run_length_encoded_samples(void) {
+  sump_capture_result_t result;
+  size_t offset;
+  unsigned int poll;
+  uint8_t previous;
+  uint8_t sample;
+  uint8_t run;
+
+  /* The first sample is always stored as is. */
+  previous = SUMP_READ_PROBES() & ~SUMP_RLE_COUNT_FLAG;
+  bus_pirate_configuration.terminal_input[0] = previous;
+  offset = 1;
+  run = 0;
+  poll = 0;
+
+  while (offset < samples_to_acquire) {
+
+    /* Wait for timer4 interrupt to trigger. */
+    while (IFS1bits.T5IF == OFF) {
+    }
+
+    /* Clear timer #4 interrupt flag. */
+    IFS1bits.T5IF = OFF;
+
+    poll = (poll + 1) & (SUMP_CAPTURE_POLL_INTERVAL - 1);
+    if ((poll == 0) && user_serial_ready_to_read()) {
+      result = sump_capture_interrupt();
+      if (result == SUMP_CAPTURE_STOPPED) {
+        /* Close the current run, there is always room left for it. */
+        if (run > 0) {
+          bus_pirate_configuration.terminal_input[offset++] =
+              SUMP_RLE_COUNT_FLAG | run;
+        }
+        samples_to_acquire = offset;
+      }
+      return result;
+    }
+
+    sample = SUMP_READ_PROBES() & ~SUMP_RLE_COUNT_FLAG;
+
+    if (sample == previous) {
+      if (run < SUMP_RLE_MAXIMUM_COUNT) {
+        run++;
+        continue;
+      }
+
+      /* Count byte is full, store it and start a new one. */
+      bus_pirate_configuration.terminal_input[offset++] =
+          SUMP_RLE_COUNT_FLAG | run;
+      run = 1;
+      continue;
+    }
+
+    /* Close the previous run, if any. */
+    if (run > 0) {
+      bus_pirate_configuration.terminal_input[offset++] =
+          SUMP_RLE_COUNT_FLAG | run;
+      run = 0;
+      if (offset == samples_to_acquire) {
+        break;
+      }
+    }
+
+    bus_pirate_configuration.terminal_input[offset++] = sample;
+    previous = sample;
+  }
+
+  return SUMP_CAPTURE_COMPLETE;
+}
+
 #endif /* BP_ENABLE_SUMP_SUPPORT */
\ No newline at end of file
@@ -22,6 +22,19 @@
 
 #ifdef BP_ENABLE_SUMP_SUPPORT
 
+/**
+ * How much memory is allocated for samples, in bytes.
+ */
+#define BP_SUMP_SAMPLE_MEMORY_SIZE BP_TERMINAL_BUFFER_SIZE
+
+/**
+ * The highest sample rate for the Bus Pirate to sample data at, in Hz.
+ *
+ * This is reached by sump_capture_16mhz, the timer driven loop only goes up to
+ * 1MHz.
+ */
+#define BP_SUMP_MAXIMUM_SAMPLE_RATE 16000000
+
 /**
  * Enters into SUMP acquisition mode.
  */
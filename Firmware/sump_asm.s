@@ -0,0 +1,100 @@
+;
+; sump_asm.s
+;
+; Fixed period capture loops for the SUMP logic analyzer mode
+;
+; Written and maintained by the Bus Pirate project.
+;
+; Published in the public domain.
+; For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+;
+; This program is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+;
+
+.ifdef __PIC24FJ64GA002__
+	.equ __24FJ64GA002, 1
+	.include "p24FJ64GA002.inc"
+
+;  Bus pirate v3 hardware, probes on RB6 to RB10
+.equ IOPOR, PORTB
+.endif ; __PIC24FJ64GA002__
+
+.ifdef __PIC24FJ256GB106__
+	.equ __24FJ256GB106, 1
+	.include "p24FJ256GB106.inc"
+
+;  Bus pirate v4 hardware, probes on RD1 to RD5
+.equ IOPOR, PORTD
+.endif ; __PIC24FJ256GB106__
+
+;
+; All loops store one raw port word per sample, and the caller is expected to
+; have interrupts disabled so the sample period stays exact.  Periods are given
+; in instruction cycles (16 MIPS).
+;
+; Parameters:
+;  w0 : output buffer, word aligned
+;  w1 : # of samples, non zero
+;
+; Register usage:
+;
+;  w2 : constant IOPOR
+;
+
+	.text
+	.global _sump_capture_16mhz
+	.global _sump_capture_4mhz
+	.global _sump_capture_2mhz
+
+;
+; void sump_capture_16mhz(uint16_t *buffer, uint16_t samples)
+;
+; One cycle per sample, up to 16384 samples.
+;
+
+_sump_capture_16mhz:
+
+		mov.w	#IOPOR, w2		; w2 = &IOPOR;
+		dec.w	w1, w1			; w1--;
+		repeat	w1			; do {
+		mov.w	[w2], [w0++]		;   *buffer++ = IOPOR;
+						; } while (w1-- > 0);
+		return
+
+;
+; void sump_capture_4mhz(uint16_t *buffer, uint16_t samples)
+;
+; Four cycles per sample.
+;
+
+_sump_capture_4mhz:
+
+		mov.w	#IOPOR, w2		; w2 = &IOPOR;
+
+__loop_4mhz:					; do {
+		mov.w	[w2], [w0++]		;   *buffer++ = IOPOR;	(1)
+		dec.w	w1, w1			; } while (--w1 > 0);	(1)
+		bra	nz, __loop_4mhz		;			(2)
+
+		return
+
+;
+; void sump_capture_2mhz(uint16_t *buffer, uint16_t samples)
+;
+; Eight cycles per sample.
+;
+
+_sump_capture_2mhz:
+
+		mov.w	#IOPOR, w2		; w2 = &IOPOR;
+
+__loop_2mhz:					; do {
+		mov.w	[w2], [w0++]		;   *buffer++ = IOPOR;	(1)
+		repeat	#2			;			(1)
+		nop				;   Pad.		(3)
+		dec.w	w1, w1			; } while (--w1 > 0);	(1)
+		bra	nz, __loop_2mhz		;			(2)
+
+		return
@@ -0,0 +1,435 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate. This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "swd.h"
+
+#ifdef BP_JTAG_SWD_SUPPORT
+
+#include "base.h"
+#include "binary_io.h"
+
+/**
+ * Serial Wire Debug binary mode commands.
+ *
+ * <table>
+ * <tr><th>Command</th><th>Payload</th><th>Response</th></tr>
+ * <tr><td>0x00 - Exit</td><td>-</td><td>"BBIO1"</td></tr>
+ * <tr><td>0x01 - Identify</td><td>-</td><td>"SWD1"</td></tr>
+ * <tr><td>0x02 - Configure</td><td>flags, clock delay (2 bytes), idle cycles,
+ * WAIT retries (2 bytes)</td><td>Result code</td></tr>
+ * <tr><td>0x03 - Line reset</td><td>-</td><td>Result code</td></tr>
+ * <tr><td>0x04 - JTAG to SWD</td><td>-</td><td>Result code</td></tr>
+ * <tr><td>0x05 - Sequence</td><td>bit count (2 bytes), bits</td><td>Result
+ * code</td></tr>
+ * <tr><td>0x06 - Transaction queue</td><td>transaction count (2 bytes), then
+ * per transaction a request byte, followed by the data (4 bytes) for
+ * writes</td><td>Per transaction a status byte, followed by the data (4 bytes)
+ * for reads</td></tr>
+ * <tr><td>0x07 - Target reset</td><td>0 to assert, 1 to release</td>
+ * <td>Result code</td></tr>
+ * </table>
+ *
+ * Counts, the clock delay and the WAIT retries are sent MSB first; sequence
+ * bits, transaction data and SWD packets themselves go LSB first.
+ *
+ * Configuration flags: bit 0 turns the power supplies on, bit 1 the pull-up
+ * resistors, and bit 2 makes the outputs open drain.  The clock delay adds
+ * that many instruction cycles to each clock half period, idle cycles are
+ * clocked with SWDIO low after every transaction.
+ *
+ * Only bits 1 to 4 (APnDP, RnW, A[2:3]) of a request byte are used, the
+ * device fills in the start, parity, stop and park bits.  A transaction
+ * answering WAIT is sent again, up to the configured number of retries.  The
+ * status byte holds the last ACK in bits 0 to 2 (0b001 is OK), bit 3 is set if
+ * the read data parity was wrong.  Once a transaction does not end with an OK
+ * ACK, the rest of the queue is still read but not run, and each transaction
+ * is answered with SWD_STATUS_SKIPPED, so the reply length only depends on
+ * the queue.  Reads not ending with a clean OK return zeroed data.  AP reads return the result of the
+ * previous AP read, as usual for SWD.
+ */
+typedef enum {
+  SWD_COMMAND_EXIT = 0,
+  SWD_COMMAND_SEND_IDENTIFIER,
+  SWD_COMMAND_CONFIGURE,
+  SWD_COMMAND_LINE_RESET,
+  SWD_COMMAND_JTAG_TO_SWD,
+  SWD_COMMAND_SEQUENCE,
+  SWD_COMMAND_QUEUE,
+  SWD_COMMAND_TARGET_RESET
+} swd_command_t;
+
+#define SWD_SWCLK BP_CLK
+#define SWD_SWCLK_DIR BP_CLK_DIR
+#define SWD_SWCLK_ODC BP_CLK_ODC
+#define SWD_SWDIO BP_MOSI
+#define SWD_SWDIO_DIR BP_MOSI_DIR
+#define SWD_SWDIO_ODC BP_MOSI_ODC
+#define SWD_NRESET BP_AUX0
+#define SWD_NRESET_DIR BP_AUX0_DIR
+
+#define SWD_CONFIGURE_POWER 0b00000001
+#define SWD_CONFIGURE_PULLUPS 0b00000010
+#define SWD_CONFIGURE_OPEN_DRAIN 0b00000100
+
+#define SWD_REQUEST_START 0b00000001
+#define SWD_REQUEST_READ 0b00000100
+#define SWD_REQUEST_FIELDS 0b00011110
+#define SWD_REQUEST_PARITY 0b00100000
+#define SWD_REQUEST_PARK 0b10000000
+
+#define SWD_ACK_OK 0b001
+#define SWD_ACK_WAIT 0b010
+#define SWD_ACK_FAULT 0b100
+
+#define SWD_STATUS_PARITY_ERROR 0b00001000
+#define SWD_STATUS_SKIPPED 0b10000000
+
+/**
+ * Clock cycles with SWDIO high for a line reset, at least 50 are needed.
+ */
+#define SWD_LINE_RESET_CYCLES 56
+
+/**
+ * The 16 bits sequence switching a SWJ-DP from JTAG to SWD, sent LSB first.
+ */
+#define SWD_JTAG_TO_SWD_SEQUENCE 0xE79E
+
+#define SWD_DEFAULT_IDLE_CYCLES 2
+#define SWD_DEFAULT_WAIT_RETRIES 100
+
+typedef struct {
+  /** Extra instruction cycles per clock half period. */
+  uint16_t delay;
+
+  /** How many times a transaction is sent again when answered WAIT. */
+  uint16_t wait_retries;
+
+  /** Clock cycles with SWDIO low after each transaction. */
+  uint8_t idle_cycles;
+} swd_state_t;
+
+static swd_state_t swd_state;
+
+/**
+ * Waits for one clock half period.
+ */
+static void swd_delay(void);
+
+/**
+ * Drives bits out on SWDIO, LSB first.
+ *
+ * @param[in] value the bits to send.
+ * @param[in] count how many bits to send, up to 32.
+ */
+static void swd_write_bits(uint32_t value, uint8_t count);
+
+/**
+ * Samples bits from SWDIO, LSB first.  SWDIO must be an input.
+ *
+ * @param[in] count how many bits to read, up to 32.
+ *
+ * @return the bits read.
+ */
+static uint32_t swd_read_bits(const uint8_t count);
+
+/**
+ * Clocks the turnaround cycle handing SWDIO from the target back to the
+ * Bus Pirate.
+ */
+static void swd_take_line(void);
+
+/**
+ * Computes the even parity bit of a 32 bits value.
+ *
+ * @param[in] value the value to compute the parity of.
+ *
+ * @return 1 if value has an odd number of bits set, 0 otherwise.
+ */
+static uint8_t swd_parity(uint32_t value);
+
+/**
+ * Runs a single request/ACK/data/parity transaction, retrying it on WAIT.
+ *
+ * @param[in]     request the request byte, only SWD_REQUEST_FIELDS are used.
+ * @param[in,out] data    the data to write, or where to store the data read.
+ *
+ * @return the last ACK received, with SWD_STATUS_PARITY_ERROR set if needed.
+ */
+static uint8_t swd_transaction(const uint8_t request, uint32_t *data);
+
+/**
+ * Sends a line reset followed by two idle cycles.
+ */
+static void swd_line_reset(void);
+
+/**
+ * Handles SWD_COMMAND_CONFIGURE.
+ */
+static void swd_configure(void);
+
+/**
+ * Handles SWD_COMMAND_SEQUENCE.
+ */
+static void swd_send_sequence(void);
+
+/**
+ * Handles SWD_COMMAND_QUEUE.
+ */
+static void swd_run_queue(void);
+
+void swd_enter_binary_io(void) {
+  swd_state.delay = 0;
+  swd_state.wait_retries = SWD_DEFAULT_WAIT_RETRIES;
+  swd_state.idle_cycles = SWD_DEFAULT_IDLE_CYCLES;
+
+  SWD_SWCLK_ODC = OFF;
+  SWD_SWDIO_ODC = OFF;
+  SWD_SWCLK = HIGH;
+  SWD_SWDIO = HIGH;
+  SWD_SWCLK_DIR = OUTPUT;
+  SWD_SWDIO_DIR = OUTPUT;
+  SWD_NRESET = LOW;
+  SWD_NRESET_DIR = INPUT;
+
+  MSG_SWD_MODE_IDENTIFIER;
+
+  for (;;) {
+    switch ((swd_command_t)user_serial_read_byte()) {
+    case SWD_COMMAND_EXIT:
+      SWD_SWCLK_ODC = OFF;
+      SWD_SWDIO_ODC = OFF;
+      return;
+
+    case SWD_COMMAND_SEND_IDENTIFIER:
+      MSG_SWD_MODE_IDENTIFIER;
+      break;
+
+    case SWD_COMMAND_CONFIGURE:
+      swd_configure();
+      break;
+
+    case SWD_COMMAND_LINE_RESET:
+      swd_line_reset();
+      REPORT_IO_SUCCESS();
+      break;
+
+    case SWD_COMMAND_JTAG_TO_SWD:
+      swd_line_reset();
+      swd_write_bits(SWD_JTAG_TO_SWD_SEQUENCE, 16);
+      swd_line_reset();
+      REPORT_IO_SUCCESS();
+      break;
+
+    case SWD_COMMAND_SEQUENCE:
+      swd_send_sequence();
+      break;
+
+    case SWD_COMMAND_QUEUE:
+      swd_run_queue();
+      break;
+
+    case SWD_COMMAND_TARGET_RESET:
+      /* Released means high impedance, nRESET has its own pull-up. */
+      SWD_NRESET_DIR = user_serial_read_byte() ? INPUT : OUTPUT;
+      REPORT_IO_SUCCESS();
+      break;
+
+    default:
+      REPORT_IO_FAILURE();
+      break;
+    }
+  }
+}
+
+void swd_delay(void) {
+  if (swd_state.delay > 0) {
+    __asm volatile("\t repeat %0 \n"
+                   "\t nop       \n"
+                   :
+                   : "r"(swd_state.delay - 1));
+  }
+}
+
+void swd_write_bits(uint32_t value, uint8_t count) {
+  while (count-- > 0) {
+    SWD_SWDIO = (value & 1) ? HIGH : LOW;
+    value >>= 1;
+    SWD_SWCLK = LOW;
+    swd_delay();
+    SWD_SWCLK = HIGH;
+    swd_delay();
+  }
+}
+
+uint32_t swd_read_bits(const uint8_t count) {
+  uint32_t value = 0;
+  uint8_t index;
+
+  for (index = 0; index < count; index++) {
+    SWD_SWCLK = LOW;
+    swd_delay();
+    value >>= 1;
+    if (SWD_SWDIO) {
+      value |= 0x80000000;
+    }
+    SWD_SWCLK = HIGH;
+    swd_delay();
+  }
+
+  return (count > 0) ? value >> (32 - count) : 0;
+}
+
+void swd_take_line(void) {
+  swd_read_bits(1);
+  SWD_SWDIO = LOW;
+  SWD_SWDIO_DIR = OUTPUT;
+}
+
+uint8_t swd_parity(uint32_t value) {
+  value ^= value >> 16;
+  value ^= value >> 8;
+  value ^= value >> 4;
+  return (0x6996 >> (value & 0x0F)) & 1;
+}
+
+uint8_t swd_transaction(const uint8_t request, uint32_t *data) {
+  uint8_t header;
+  uint8_t ack;
+  uint16_t retries;
+
+  header = (request & SWD_REQUEST_FIELDS) | SWD_REQUEST_START | SWD_REQUEST_PARK;
+  if (swd_parity(request & SWD_REQUEST_FIELDS)) {
+    header |= SWD_REQUEST_PARITY;
+  }
+
+  for (retries = 0;; retries++) {
+    swd_write_bits(header, 8);
+
+    /* Turnaround, then the target drives the ACK. */
+    SWD_SWDIO_DIR = INPUT;
+    swd_read_bits(1);
+    ack = (uint8_t)swd_read_bits(3);
+
+    if (ack == SWD_ACK_OK) {
+      if (header & SWD_REQUEST_READ) {
+        *data = swd_read_bits(32);
+        if (swd_read_bits(1) != swd_parity(*data)) {
+          ack |= SWD_STATUS_PARITY_ERROR;
+        }
+        swd_take_line();
+      } else {
+        swd_take_line();
+        swd_write_bits(*data, 32);
+        swd_write_bits(swd_parity(*data), 1);
+      }
+      break;
+    }
+
+    /* WAIT, FAULT, or no answer at all: there is no data phase. */
+    swd_take_line();
+    if ((ack != SWD_ACK_WAIT) || (retries >= swd_state.wait_retries)) {
+      break;
+    }
+  }
+
+  swd_write_bits(0, swd_state.idle_cycles);
+  return ack;
+}
+
+void swd_line_reset(void) {
+  uint8_t cycles;
+
+  for (cycles = 0; cycles < SWD_LINE_RESET_CYCLES; cycles += 8) {
+    swd_write_bits(0xFF, 8);
+  }
+  swd_write_bits(0, 2);
+}
+
+void swd_configure(void) {
+  uint8_t flags;
+
+  flags = user_serial_read_byte();
+  swd_state.delay = user_serial_read_byte() << 8;
+  swd_state.delay |= user_serial_read_byte();
+  swd_state.idle_cycles = user_serial_read_byte();
+  swd_state.wait_retries = user_serial_read_byte() << 8;
+  swd_state.wait_retries |= user_serial_read_byte();
+
+  bp_set_voltage_regulator_state((flags & SWD_CONFIGURE_POWER) ? ON : OFF);
+  bp_set_pullup_state((flags & SWD_CONFIGURE_PULLUPS) ? ON : OFF);
+  SWD_SWCLK_ODC = (flags & SWD_CONFIGURE_OPEN_DRAIN) ? ON : OFF;
+  SWD_SWDIO_ODC = (flags & SWD_CONFIGURE_OPEN_DRAIN) ? ON : OFF;
+
+  REPORT_IO_SUCCESS();
+}
+
+void swd_send_sequence(void) {
+  uint16_t bits;
+
+  bits = user_serial_read_byte() << 8;
+  bits |= user_serial_read_byte();
+
+  while (bits > 0) {
+    uint8_t chunk = (bits < 8) ? (uint8_t)bits : 8;
+
+    swd_write_bits(user_serial_read_byte(), chunk);
+    bits -= chunk;
+  }
+
+  REPORT_IO_SUCCESS();
+}
+
+void swd_run_queue(void) {
+  uint16_t count;
+  bool failed = false;
+
+  count = user_serial_read_byte() << 8;
+  count |= user_serial_read_byte();
+
+  while (count-- > 0) {
+    uint8_t request;
+    uint8_t status;
+    uint32_t data = 0;
+    uint8_t index;
+
+    request = user_serial_read_byte();
+    if (!(request & SWD_REQUEST_READ)) {
+      for (index = 0; index < 32; index += 8) {
+        data |= (uint32_t)user_serial_read_byte() << index;
+      }
+    }
+
+    if (failed) {
+      status = SWD_STATUS_SKIPPED;
+    } else {
+      status = swd_transaction(request, &data);
+      failed = (status != SWD_ACK_OK);
+    }
+
+    user_serial_transmit_character(status);
+    if (request & SWD_REQUEST_READ) {
+      if (status != SWD_ACK_OK) {
+        data = 0;
+      }
+      for (index = 0; index < 32; index += 8) {
+        user_serial_transmit_character((uint8_t)(data >> index));
+      }
+    }
+  }
+}
+
+#endif /* BP_JTAG_SWD_SUPPORT */
@@ -0,0 +1,34 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef BP_SWD_H
+#define BP_SWD_H
+
+#include "configuration.h"
+
+#ifdef BP_JTAG_SWD_SUPPORT
+
+/**
+ * Start accepting binary I/O commands for ARM Serial Wire Debug.
+ *
+ * SWCLK is on CLK, SWDIO on MOSI, and the target reset line on AUX.
+ */
+void swd_enter_binary_io(void);
+
+#endif /* BP_JTAG_SWD_SUPPORT */
+
+#endif /* !BP_SWD_H */
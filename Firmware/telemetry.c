@@ -0,0 +1,49 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "telemetry.h"
+
+#ifdef BP_ENABLE_TELEMETRY
+
+#include "base.h"
+
+volatile uint32_t bp_telemetry_counters[BP_TELEMETRY_COUNTERS];
+
+void bp_telemetry_send(const bool clear) {
+  uint32_t snapshot[BP_TELEMETRY_COUNTERS];
+  uint16_t interrupt_level;
+  size_t index;
+
+  BP_MASK_HOST_LINK_INTERRUPTS(interrupt_level);
+  for (index = 0; index < BP_TELEMETRY_COUNTERS; index++) {
+    snapshot[index] = bp_telemetry_counters[index];
+    if (clear) {
+      bp_telemetry_counters[index] = 0;
+    }
+  }
+  BP_RESTORE_INTERRUPT_LEVEL(interrupt_level);
+
+  user_serial_transmit_character(BP_TELEMETRY_COUNTERS);
+  for (index = 0; index < BP_TELEMETRY_COUNTERS; index++) {
+    user_serial_transmit_character(snapshot[index] >> 24);
+    user_serial_transmit_character(snapshot[index] >> 16);
+    user_serial_transmit_character(snapshot[index] >> 8);
+    user_serial_transmit_character(snapshot[index]);
+  }
+}
+
+#endif /* BP_ENABLE_TELEMETRY */
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file telemetry.h
+ *
+ * @brief Throughput and error counters kept by the serial and bus layers.
+ *
+ * They tell apart a session limited by the host link from one limited by the
+ * bus, and can be read from every binary mode without leaving it.
+ */
+
+#ifndef BP_TELEMETRY_H
+#define BP_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "configuration.h"
+
+/**
+ * Available counters, in the order they are sent.
+ */
+typedef enum {
+  /** Bytes read from the host. */
+  BP_TELEMETRY_BYTES_IN = 0,
+
+  /** Bytes queued for the host. */
+  BP_TELEMETRY_BYTES_OUT,
+
+  /** CDC IN packets handed to the USB SIE, v4 only. */
+  BP_TELEMETRY_USB_IN_PACKETS,
+
+  /** Zero length CDC IN packets among those, v4 only. */
+  BP_TELEMETRY_USB_ZERO_LENGTH_PACKETS,
+
+  /** Most bytes ever waiting in the host transmission ring, v3 only. */
+  BP_TELEMETRY_TRANSMIT_RING_HIGH_WATER,
+
+  /** Most bytes ever waiting in the host reception ring, v3 only. */
+  BP_TELEMETRY_RECEIVE_RING_HIGH_WATER,
+
+  /** Most bytes ever waiting in the binary UART bridge reception ring. */
+  BP_TELEMETRY_UART_RING_HIGH_WATER,
+
+  /** Bytes dropped because a serial ring was full. */
+  BP_TELEMETRY_OVERFLOWS,
+
+  /** SPI receive overflows (SPIROV) seen. */
+  BP_TELEMETRY_SPI_OVERRUNS,
+
+  /** Bus UART receive overruns (OERR) seen. */
+  BP_TELEMETRY_UART_OVERRUNS,
+
+  /** I2C bytes written in binary mode that were not acknowledged. */
+  BP_TELEMETRY_I2C_NACKS,
+
+  /** How many counters there are. */
+  BP_TELEMETRY_COUNTERS
+} bp_telemetry_counter_t;
+
+#ifdef BP_ENABLE_TELEMETRY
+
+/**
+ * The counters themselves, use the macros below to update them.
+ */
+extern volatile uint32_t bp_telemetry_counters[BP_TELEMETRY_COUNTERS];
+
+/**
+ * Sends every counter, MSB first, after a byte with how many there are.
+ *
+ * The counters are copied with the host link interrupts masked, and before
+ * anything is sent, so the report does not count itself.
+ *
+ * @param[in] clear true to zero the counters once copied.
+ */
+void bp_telemetry_send(const bool clear);
+
+#define BP_TELEMETRY_ADD(counter, amount)                                      \
+  bp_telemetry_counters[(counter)] += (amount)
+
+#define BP_TELEMETRY_COUNT(counter) bp_telemetry_counters[(counter)]++
+
+#define BP_TELEMETRY_HIGH_WATER(counter, level)                                \
+  do {                                                                         \
+    if ((uint32_t)(level) > bp_telemetry_counters[(counter)]) {                \
+      bp_telemetry_counters[(counter)] = (level);                              \
+    }                                                                          \
+  } while (0)
+
+#else
+
+#define BP_TELEMETRY_ADD(counter, amount)
+#define BP_TELEMETRY_COUNT(counter)
+#define BP_TELEMETRY_HIGH_WATER(counter, level)
+
+#endif /* BP_ENABLE_TELEMETRY */
+
+#endif /* !BP_TELEMETRY_H */
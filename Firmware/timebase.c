@@ -0,0 +1,232 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#include "timebase.h"
+
+#ifdef BP_ENABLE_USB_TIMEBASE
+
+#include "base.h"
+
+/**
+ * Start of frame packets carry an 11 bits frame number.
+ */
+#define FRAME_NUMBER_MASK 0x07FF
+
+/**
+ * Nominal sub-frame counter ticks in a 1ms frame.
+ */
+#define NOMINAL_TICKS_PER_FRAME ((uint16_t)(FCY / 1000UL))
+
+/**
+ * Peripheral pin select input value that leaves IC9 unconnected.
+ */
+#define IC9_UNCONNECTED 0b111111
+
+/**
+ * Timebase state, updated by the start of frame handler.
+ */
+typedef struct {
+  /** Extended frame number of the last start of frame. */
+  uint32_t frame;
+
+  /** IC9 counter value latched at the last start of frame. */
+  uint16_t frame_start;
+
+  /** IC9 counter ticks the last whole frame took. */
+  uint16_t ticks_per_frame;
+
+  /** Host frame number of the last start of frame. */
+  uint16_t frame_number;
+
+  /** Bumped on every update, for lock-free readers. */
+  uint8_t sequence;
+
+  /** Set once a start of frame has been seen. */
+  bool locked;
+
+  /** Rising edges seen on AUX since the trigger input was armed. */
+  uint16_t trigger_count;
+
+  /** When the last rising edge on AUX came in. */
+  bp_timestamp_t trigger;
+} bp_timebase_state_t;
+
+static volatile bp_timebase_state_t timebase;
+
+void bp_timebase_initialize(void) {
+  memset((void *)&timebase, 0, sizeof(timebase));
+  timebase.ticks_per_frame = NOMINAL_TICKS_PER_FRAME;
+
+  IEC5bits.IC9IE = OFF;
+  IFS5bits.IC9IF = OFF;
+  RPINR15bits.IC9R = IC9_UNCONNECTED;
+
+  /*
+   * IC9CON2: INPUT CAPTURE 9 CONTROL REGISTER 2
+   *
+   * No synchronisation source, the counter rolls over at 0xFFFF on its own.
+   */
+  IC9CON2 = 0x0000;
+
+  /*
+   * IC9CON1: INPUT CAPTURE 9 CONTROL REGISTER 1
+   *
+   * MSB
+   * --0111---00--011
+   *   ||||   ||  |||
+   *   ||||   ||  +++--- ICM:    Capture every rising edge.
+   *   ||||   ++-------- ICI:    Interrupt on every capture event.
+   *   |+++------------- ICTSEL: System clock (FOSC/2).
+   *   +---------------- ICSIDL: Continue in CPU Idle mode.
+   *
+   * The counter only runs while a capture mode is selected, with no pin
+   * routed to the module it counts without ever capturing.
+   */
+  IC9CON1 =
+      (0b111 << _IC9CON1_ICTSEL_POSITION) | (0b011 << _IC9CON1_ICM_POSITION);
+  IC9TMR = 0x0000;
+
+  IPC23bits.IC9IP = USB_INTERRUPT_PRIORITY;
+}
+
+void bp_timebase_start_of_frame(void) {
+  uint16_t now;
+  uint16_t number;
+  uint16_t elapsed;
+
+  now = IC9TMR;
+  number = ((U1FRMH << 8) | U1FRML) & FRAME_NUMBER_MASK;
+
+  if (!timebase.locked) {
+    /*
+     * Starting from the host numbering keeps the low 11 bits the same on
+     * every board, the upper bits only differ by whole wraps.
+     */
+    timebase.frame = number;
+    timebase.locked = true;
+  } else {
+    elapsed = (number - timebase.frame_number) & FRAME_NUMBER_MASK;
+    if (elapsed == 1) {
+      timebase.ticks_per_frame = now - timebase.frame_start;
+    }
+    timebase.frame += elapsed;
+  }
+
+  timebase.frame_number = number;
+  timebase.frame_start = now;
+  timebase.sequence++;
+}
+
+bool bp_timebase_locked(void) { return timebase.locked; }
+
+void bp_timebase_now(bp_timestamp_t *timestamp) {
+  uint8_t sequence;
+  uint16_t now;
+
+  do {
+    sequence = timebase.sequence;
+    now = IC9TMR;
+    timestamp->frame = timebase.frame;
+    timestamp->ticks = now - timebase.frame_start;
+  } while (sequence != timebase.sequence);
+}
+
+uint16_t bp_timebase_ticks_per_frame(void) { return timebase.ticks_per_frame; }
+
+void bp_timebase_trigger_out(bp_timestamp_t *timestamp) {
+  uint16_t interrupt_level;
+
+  BP_AUX0 = LOW;
+  BP_AUX0_DIR = OUTPUT;
+
+  /* Nothing may come between taking the timestamp and raising the line. */
+  interrupt_level = SRbits.IPL;
+  SRbits.IPL = 7;
+  bp_timebase_now(timestamp);
+  BP_AUX0 = HIGH;
+  SRbits.IPL = interrupt_level;
+
+  bp_delay_us(1);
+  BP_AUX0 = LOW;
+}
+
+void bp_timebase_trigger_in(const bool armed) {
+  uint16_t discarded;
+
+  IEC5bits.IC9IE = OFF;
+  RPINR15bits.IC9R = IC9_UNCONNECTED;
+
+  while (IC9CON1bits.ICBNE) {
+    discarded = IC9BUF;
+  }
+  (void)discarded;
+  IFS5bits.IC9IF = OFF;
+
+  if (armed) {
+    timebase.trigger_count = 0;
+    BP_AUX0_DIR = INPUT;
+    RPINR15bits.IC9R = BP_AUX_RPIN;
+    IEC5bits.IC9IE = ON;
+  }
+}
+
+uint16_t bp_timebase_last_trigger(bp_timestamp_t *timestamp) {
+  uint16_t count;
+
+  IEC5bits.IC9IE = OFF;
+  count = timebase.trigger_count;
+  if (count > 0) {
+    timestamp->frame = timebase.trigger.frame;
+    timestamp->ticks = timebase.trigger.ticks;
+  }
+  if (RPINR15bits.IC9R == BP_AUX_RPIN) {
+    IEC5bits.IC9IE = ON;
+  }
+
+  return count;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _IC9Interrupt(void) {
+  uint16_t captured;
+  int16_t ticks;
+  uint32_t frame;
+
+  IFS5bits.IC9IF = OFF;
+
+  /*
+   * This runs at the USB interrupt priority, so the frame state cannot move
+   * underneath.  An edge captured before the start of frame that was latched
+   * last belongs to the frame before it.
+   */
+  while (IC9CON1bits.ICBNE) {
+    captured = IC9BUF;
+    ticks = (int16_t)(captured - timebase.frame_start);
+    frame = timebase.frame;
+    if (ticks < 0) {
+      frame--;
+      ticks += timebase.ticks_per_frame;
+    }
+
+    timebase.trigger.frame = frame;
+    timebase.trigger.ticks = ticks;
+    if (timebase.trigger_count < 0xFFFF) {
+      timebase.trigger_count++;
+    }
+  }
+}
+
+#endif /* BP_ENABLE_USB_TIMEBASE */
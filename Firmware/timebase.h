@@ -0,0 +1,125 @@
+/*
+ * This file is part of the Bus Pirate project
+ * (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project.
+ *
+ * To the extent possible under law, the project has waived all copyright and
+ * related or neighboring rights to Bus Pirate.  This work is published from
+ * United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/**
+ * @file timebase.h
+ *
+ * @brief Device timebase locked to the USB start of frame, v4 only.
+ *
+ * The host controller sends a start of frame packet carrying an 11 bits frame
+ * number every millisecond, and every device on the same bus sees the same
+ * numbers.  The frame number is extended to 32 bits here, and the time since
+ * the last start of frame is kept by the free-running counter of IC9 at FCY.
+ * Timestamps taken on boards plugged to the same host can then be put on a
+ * single time axis, the residual error being the start of frame interrupt
+ * latency.
+ *
+ * The counter ticks between two frames are measured as well, so the host can
+ * scale sub-frame ticks to the host clock instead of trusting the board
+ * oscillator.
+ *
+ * AUX can be used as a shared trigger line: one board pulses it and records
+ * when, the other ones timestamp its rising edges with IC9 captures.
+ */
+
+#ifndef BP_TIMEBASE_H
+#define BP_TIMEBASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "configuration.h"
+
+#ifdef BP_ENABLE_USB_TIMEBASE
+
+/**
+ * A point in time on the USB timebase.
+ */
+typedef struct {
+  /** Frames since the timebase started, following the host numbering. */
+  uint32_t frame;
+
+  /** Counter ticks since that frame started, at FCY. */
+  uint16_t ticks;
+} bp_timestamp_t;
+
+/**
+ * Starts the sub-frame counter, before the start of frame handler is
+ * registered.
+ */
+void bp_timebase_initialize(void);
+
+/**
+ * Advances the timebase, called from the start of frame handler.
+ */
+void bp_timebase_start_of_frame(void);
+
+/**
+ * Tells whether start of frame packets have been seen yet.
+ *
+ * @return true if timestamps are locked to the host frame numbering.
+ */
+bool bp_timebase_locked(void);
+
+/**
+ * Reads the timebase.
+ *
+ * Can be called with interrupts enabled, an update coming in meanwhile makes
+ * the read be done again.
+ *
+ * @param[out] timestamp where the current time goes.
+ */
+void bp_timebase_now(bp_timestamp_t *timestamp);
+
+/**
+ * Counter ticks the last whole frame took.
+ *
+ * @return the frame length in FCY ticks, nominally FCY / 1000.
+ */
+uint16_t bp_timebase_ticks_per_frame(void);
+
+/**
+ * Drives AUX high for a microsecond, then low again.
+ *
+ * AUX is left as an output driven low.
+ *
+ * @param[out] timestamp when the rising edge was sent.
+ */
+void bp_timebase_trigger_out(bp_timestamp_t *timestamp);
+
+/**
+ * Starts or stops timestamping AUX rising edges.
+ *
+ * AUX is made an input while armed.  Arming clears the trigger count.
+ *
+ * @param[in] armed true to timestamp edges, false to let AUX go.
+ */
+void bp_timebase_trigger_in(const bool armed);
+
+/**
+ * Reads what the trigger input saw since it was armed.
+ *
+ * @param[out] timestamp when the last rising edge came in, left untouched
+ * if there was none.
+ *
+ * @return how many rising edges came in, saturating at 0xFFFF.
+ */
+uint16_t bp_timebase_last_trigger(bp_timestamp_t *timestamp);
+
+#endif /* BP_ENABLE_USB_TIMEBASE */
+
+#endif /* !BP_TIMEBASE_H */
@@ -21,13 +21,17 @@
 
 #include "base.h"
 #include "binary_io.h"
+#include "buffer_arena.h"
+#include "core.h"
 #include "proc_menu.h"
+#include "telemetry.h"
 #include "uart2.h"
 
 extern mode_configuration_t mode_configuration;
 extern command_t last_command;
+extern bus_pirate_configuration_t bus_pirate_configuration;
 
-#define UART_COMMON_BAUD_RATES_COUNT 15
+#define UART_COMMON_BAUD_RATES_COUNT 19
 #define UART_BAUD_RATE_CALCULATION_SAMPLES 25
 #define UART_MACRO_MENU 0
 #define UART_MACRO_TRANSPARENT_BRIDGE 1
@@ -40,6 +44,7 @@ typedef struct {
   uint8_t stop_bits : 1;
   uint8_t receive_polarity : 1;
   uint8_t echo_uart : 1;
+  uint8_t flow_control : 1;
 #ifdef BUSPIRATEV4
   uint8_t autobaud : 1;
 #endif /* BUSPIRATEV4 */
@@ -48,8 +53,9 @@ typedef struct {
 static UARTSettings uart_settings = {0};
 
 static const uint32_t UART_COMMON_BAUD_RATES[] = {
-    0,     300,   600,   1200,  2400,  4800,   9600,   14400,
-    19200, 28800, 38400, 56000, 57600, 115200, 128000, 256000};
+    0,      300,    600,    1200,   2400,   4800,   9600,
+    14400,  19200,  28800,  38400,  56000,  57600,  115200,
+    128000, 230400, 256000, 460800, 921600};
 
 const uint16_t UART_BRG_SPEED[] = {
     13332, /* 300 bps */
@@ -84,600 +90,2396 @@ static uint32_t uart_get_closest_common_rate(const uint32_t baud_rate);
  */
 static uint32_t uart_get_baud_rate(const bool quiet);
 
+/**
+ * Size of each UART2 ring buffer, must be a power of two.
+ *
+ * Both rings are reserved from the buffer arena while interrupts are running.
+ */
+#define UART_RING_SIZE (BP_TERMINAL_BUFFER_SIZE / 2)
+
+/**
+ * Mask to wrap ring buffer indices around.
+ */
+#define UART_RING_MASK (UART_RING_SIZE - 1)
+
+/**
+ * Interrupt priority for the UART2 handlers.
+ */
+#define UART_INTERRUPT_PRIORITY 5
+
+/**
+ * A parity error was detected on at least one received byte.
+ */
+#define UART_RECEIVE_ERROR_PARITY 0x01
+
+/**
+ * A framing error was detected on at least one received byte.
+ */
+#define UART_RECEIVE_ERROR_FRAMING 0x02
+
+/**
+ * The UART2 hardware FIFO overflowed, some bytes were lost.
+ */
+#define UART_RECEIVE_ERROR_OVERRUN 0x04
+
+/**
+ * The receive ring buffer overflowed, some bytes were lost.
+ */
+#define UART_RECEIVE_ERROR_RING_OVERFLOW 0x08
+
+/**
+ * Binary I/O command to stream UART2 reception to the host in blocks.
+ *
+ * @see uart_binary_io_stream_receive
+ */
+#define UART_BINARY_IO_STREAM_RECEIVE 0x04
+
+/**
+ * Stream flag to prepend a timestamp to every block.
+ */
+#define UART_STREAM_FLAG_TIMESTAMP 0x01
+
+/**
+ * Mask for all the flags accepted by the streaming receive command.
+ */
+#define UART_STREAM_FLAGS_MASK UART_STREAM_FLAG_TIMESTAMP
+
+/**
+ * Maximum number of data bytes in a single stream block.
+ */
+#define UART_STREAM_BLOCK_SIZE 64
+
+/**
+ * How many 0.5us timer ticks a partially filled block can wait for more data
+ * before being sent anyway (1ms).
+ */
+#define UART_STREAM_IDLE_TICKS 2000
+
+/**
+ * Binary I/O command to turn RTS/CTS hardware flow control on or off.
+ *
+ * @see uart_binary_io_flow_control
+ */
+#define UART_BINARY_IO_FLOW_CONTROL 0x08
+
+/**
+ * Flow control flag to use RTS on CLK and CTS on CS, both active low.
+ */
+#define UART_FLOW_CONTROL_FLAG_RTS_CTS 0x01
+
+/**
+ * Mask for all the flags accepted by the flow control command.
+ */
+#define UART_FLOW_CONTROL_FLAGS_MASK UART_FLOW_CONTROL_FLAG_RTS_CTS
+
+/**
+ * Receive ring fill level at which RTS is deasserted.
+ */
+#define UART_RING_HIGH_WATERMARK (UART_RING_SIZE - (UART_RING_SIZE / 4))
+
+/**
+ * Receive ring fill level below which RTS is asserted again.
+ */
+#define UART_RING_LOW_WATERMARK (UART_RING_SIZE / 4)
+
+/**
+ * A single direction ring buffer for UART2 data.
+ */
+typedef struct {
+
+  /** The backing storage, UART_RING_SIZE bytes long. */
+  uint8_t *buffer;
+
+  /** Next slot to write. */
+  volatile uint16_t head;
+
+  /** Next slot to read. */
+  volatile uint16_t tail;
+} uart_ring_t;
+
+/**
+ * Bytes received by UART2, filled by the RX interrupt handler and drained
+ * towards the serial port by the main loop.
+ */
+static uart_ring_t uart_receive_ring;
+
+/**
+ * Bytes coming from the serial port, filled by the bridge loop and drained
+ * into UART2 by the TX interrupt handler.
+ */
+static uart_ring_t uart_transmit_ring;
+
+/**
+ * UART_RECEIVE_ERROR_* bits set by the RX interrupt handler since the last
+ * time they were cleared.
+ */
+static volatile uint8_t uart_receive_errors;
+
+/**
+ * Sets up both UART2 rings and starts interrupt driven reception.
+ *
+ * Transmission interrupts are armed later, when there is something to send.
+ * The rings fill the whole arena, which nothing else in UART mode holds on to.
+ *
+ * @return true if both rings were reserved and reception was started, false
+ * if nothing was started.
+ */
+static bool uart_interrupts_start(void);
+
+/**
+ * Stops interrupt driven reception and transmission on UART2, and gives the
+ * rings back to the buffer arena.
+ */
+static void uart_interrupts_stop(void);
+
+/**
+ * Reserves the receive ring and starts interrupt driven reception on UART2.
+ *
+ * @return true if reception was started, false if the ring could not be
+ * reserved.
+ */
+static bool uart_receive_interrupt_start(void);
+
+/**
+ * Stops interrupt driven reception on UART2, and gives the receive ring back
+ * to the buffer arena.
+ */
+static void uart_receive_interrupt_stop(void);
+
+/**
+ * How many received values go on each line of the terminal live display.
+ */
+#define UART_TERMINAL_VALUES_PER_LINE 16
+
+/**
+ * Whether UART2 reception is buffered in the receive ring for the terminal
+ * live display, between a start and a stop command.
+ */
+static bool uart_terminal_receiving = false;
+
+/**
+ * Starts buffering UART2 reception for the terminal live display, if it is
+ * not running yet.  If the receive ring cannot be reserved reception stays
+ * polled.
+ */
+static void uart_terminal_receive_start(void);
+
+/**
+ * Takes the next byte received while the terminal live display is on, from
+ * the receive ring or straight from UART2 if the ring is not in use.
+ *
+ * @param[out] value where to store the byte.
+ *
+ * @return true if a byte was available, false otherwise.
+ */
+static bool uart_terminal_receive_pop(uint8_t *value);
+
+/**
+ * Prints the messages for the given UART_RECEIVE_ERROR_* bits.
+ *
+ * @param[in] errors the error bits to report.
+ */
+static void uart_terminal_print_errors(const uint8_t errors);
+
+/**
+ * Moves as much data as possible from the receive ring to the serial port,
+ * without blocking.
+ */
+static void uart_receive_ring_drain(void);
+
+/**
+ * Asserts RTS again once the receive ring went below its low watermark, if
+ * flow control is on.  Meant to be called after taking data from the ring.
+ */
+static void uart_receive_ring_resume(void);
+
+/**
+ * Hands the CS and CLK pins to UART2 as CTS and RTS if flow control is on,
+ * or gives them back otherwise.  Must be called after every uart2_setup call,
+ * as the latter resets the UART2 pin configuration.
+ *
+ * CTS is always handled by UART2, which holds transmission while it is high.
+ * RTS is driven by UART2 itself while reception is polled, so it follows the
+ * four bytes hardware FIFO, and by the RX interrupt handler against the
+ * receive ring watermarks while the rings are in use.
+ */
+static void uart_flow_control_apply(void);
+
+/**
+ * Handles an incoming UART_BINARY_IO_FLOW_CONTROL binary I/O command.
+ *
+ * The command is followed by a flags byte (UART_FLOW_CONTROL_FLAG_RTS_CTS),
+ * and is acknowledged with a success code, or with a failure code if unknown
+ * flags were set.  The setting stays until changed or until the mode is left.
+ */
+static void uart_binary_io_flow_control(void);
+
+/**
+ * Runs the UART2 to serial port transparent bridge.
+ *
+ * Both directions are buffered: UART2 is serviced by its RX and TX interrupt
+ * handlers, so incoming bursts no longer need the other side to be ready
+ * within the four bytes of the UART2 hardware FIFO.  On v4 the bridge stops
+ * when the button is pressed, on v3 it never returns.
+ *
+ * The rings must have been set up with uart_interrupts_start() beforehand,
+ * they are given back when the bridge stops.
+ *
+ * @param[in] flow_control true if the flow control lines should be relayed
+ *                         between the FTDI chip and the bus (v3 only).
+ */
+static void uart_run_bridge(const bool flow_control);
+
+/**
+ * Handles an incoming UART_BINARY_IO_STREAM_RECEIVE binary I/O command.
+ *
+ * The command is followed by a flags byte (UART_STREAM_FLAG_TIMESTAMP), and
+ * is acknowledged with a success code, or with a failure code if unknown
+ * flags were set.  From then on everything UART2 receives is buffered by the
+ * RX interrupt handler and sent to the host in blocks:
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Size</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>Data length, up to UART_STREAM_BLOCK_SIZE</td></tr>
+ * <tr><td>1</td><td>1</td><td>UART_RECEIVE_ERROR_* bits seen since the
+ *                             previous block</td></tr>
+ * <tr><td>2</td><td>4</td><td>Timer value in 0.5us ticks when the block was
+ *                             sent, big endian (only if requested)</td></tr>
+ * <tr><td>2 or 6</td><td>N</td><td>Data</td></tr>
+ * </table>
+ *
+ * A block is sent when it is full, or when its data has been waiting for
+ * UART_STREAM_IDLE_TICKS.  A block with no data and some error bits set
+ * reports errors alone.  Any byte coming from the host stops the stream: the
+ * ring is drained and a block with no data and no error bits marks the end.
+ */
+static void uart_binary_io_stream_receive(void);
+
+/**
+ * Sends a single stream block to the host.
+ *
+ * @param[in] length    how many bytes to take from the receive ring.
+ * @param[in] errors    the UART_RECEIVE_ERROR_* bits for the block.
+ * @param[in] timestamp true if the block should carry a timestamp.
+ */
+static void uart_stream_send_block(const uint16_t length, const uint8_t errors,
+                                   const bool timestamp);
+
+/**
+ * Starts the 32 bits timestamp timer formed by Timer2 and Timer3 from zero.
+ */
+static void uart_timestamp_start(void);
+
+/**
+ * Reads the 32 bits timestamp timer formed by Timer2 and Timer3.
+ *
+ * @return the timer value, in 0.5us ticks.
+ */
+static uint32_t uart_timestamp_read(void);
+
+/**
+ * Binary I/O command to detect the baud rate of the data being received and
+ * reconfigure UART2 accordingly.
+ *
+ * @see uart_binary_io_detect_baud_rate
+ */
+#define UART_BINARY_IO_DETECT_BAUD_RATE 0x05
+
+/**
+ * How many edge to edge intervals are collected for a baud rate measurement.
+ */
+#define UART_AUTOBAUD_INTERVALS 64
+
+/**
+ * Intervals shorter than this many instruction cycles are considered glitches
+ * (faster than 2Mbps).
+ */
+#define UART_AUTOBAUD_MINIMUM_TICKS 8
+
+/**
+ * The longest run of identical bits in a UART frame, used to discard the idle
+ * time between characters from the measurement.
+ */
+#define UART_AUTOBAUD_MAXIMUM_BITS 10
+
+/**
+ * How far apart, in percent, the measured and the closest common baud rate can
+ * be for the latter to be used.
+ */
+#define UART_AUTOBAUD_TOLERANCE_PERCENT 4
+
+/**
+ * Binary I/O command to sniff both directions of a UART link.
+ *
+ * @see uart_binary_io_sniffer
+ */
+#define UART_BINARY_IO_SNIFFER 0x06
+
+/**
+ * Size of a sniffer record, in bytes.
+ */
+#define UART_SNIFFER_RECORD_SIZE 6
+
+/**
+ * Sniffer record flag set for bytes seen on MOSI, clear for bytes seen on
+ * MISO.
+ */
+#define UART_SNIFFER_FLAG_MOSI 0x01
+
+/**
+ * Sniffer record flag set if the byte had a framing error.
+ */
+#define UART_SNIFFER_FLAG_FRAMING_ERROR 0x02
+
+/**
+ * Sniffer record flag set if the byte had a parity error.
+ */
+#define UART_SNIFFER_FLAG_PARITY_ERROR 0x04
+
+/**
+ * Sniffer record flag holding the ninth data bit, in 9 bits mode.
+ */
+#define UART_SNIFFER_FLAG_NINTH_BIT 0x08
+
+/**
+ * Sniffer record flag set if some bytes were lost before this one.
+ */
+#define UART_SNIFFER_FLAG_OVERFLOW 0x10
+
+/**
+ * Sniffer record flag marking the end of the capture.
+ */
+#define UART_SNIFFER_FLAG_END 0x80
+
+/**
+ * Interrupt priority for the sniffer handlers, ahead of the USB interrupt.
+ */
+#define UART_SNIFFER_INTERRUPT_PRIORITY 6
+
+/**
+ * State of the software receiver used by the sniffer on MOSI.
+ */
+typedef struct {
+
+  /** Timer4 ticks per bit. */
+  uint16_t bit_ticks;
+
+  /** Data bits plus parity, if any. */
+  uint8_t frame_bits;
+
+  /** Bits of the current frame sampled so far. */
+  uint8_t bit_index;
+
+  /** The bits of the current frame sampled so far, LSB first. */
+  uint16_t value;
+
+  /** Whether the line idles low. */
+  bool inverted;
+} uart_soft_receiver_t;
+
+/**
+ * The MOSI software receiver state.
+ */
+static uart_soft_receiver_t uart_soft_receiver;
+
+/**
+ * Whether the UART2 RX interrupt handler should produce sniffer records
+ * instead of raw bytes.
+ */
+static bool uart_sniffing;
+
+/**
+ * Set when a sniffer record could not fit in the receive ring.
+ */
+static bool uart_sniffer_overflow;
+
+/**
+ * Binary I/O command to sniff both directions of a UART link, starting once a
+ * byte pattern is seen.
+ *
+ * @see uart_binary_io_triggered_sniffer
+ */
+#define UART_BINARY_IO_TRIGGERED_SNIFFER 0x0A
+
+/**
+ * Binary I/O command to read the telemetry counters.
+ *
+ * @see bp_binary_io_send_telemetry
+ */
+#define UART_BINARY_IO_TELEMETRY 0x0B
+
+/**
+ * Triggered sniffer line flag to look for the pattern on MISO.
+ */
+#define UART_SNIFFER_TRIGGER_LINE_MISO 0x01
+
+/**
+ * Triggered sniffer line flag to look for the pattern on MOSI.
+ */
+#define UART_SNIFFER_TRIGGER_LINE_MOSI 0x02
+
+/**
+ * Maximum length of a triggered sniffer pattern, one bit of matcher state per
+ * pattern byte.
+ */
+#define UART_SNIFFER_TRIGGER_MAXIMUM_LENGTH 8
+
+/**
+ * State of the triggered sniffer pattern matcher.
+ */
+typedef struct {
+
+  /** The pattern to look for. */
+  uint8_t pattern[UART_SNIFFER_TRIGGER_MAXIMUM_LENGTH];
+
+  /** How many pattern bytes there are. */
+  uint8_t length;
+
+  /** UART_SNIFFER_TRIGGER_LINE_* bits of the lines to look at. */
+  uint8_t lines;
+
+  /** Shift-and matcher state for MISO and MOSI, in this order. */
+  uint8_t progress[2];
+
+  /** Whether records are still held back waiting for the pattern. */
+  bool armed;
+} uart_sniffer_trigger_t;
+
+/**
+ * The triggered sniffer pattern matcher.
+ */
+static uart_sniffer_trigger_t uart_sniffer_trigger;
+
+/**
+ * Handles an incoming UART_BINARY_IO_SNIFFER binary I/O command.
+ *
+ * MISO is received by UART2, and MOSI by a software receiver made of the
+ * second input capture unit (start bit edge) and Timer4 (bit sampling), both
+ * with the current UART settings.  MOSI is turned into an input for the whole
+ * capture.  The software receiver is interrupt driven and keeps up to about
+ * 115200bps.
+ *
+ * A success code is sent first.  Every byte seen on either line becomes a
+ * UART_SNIFFER_RECORD_SIZE bytes record: the UART_SNIFFER_FLAG_* bits, the
+ * data byte, and the 0.5us timer value when its stop bit was seen (big
+ * endian).  Any byte coming from the host stops the capture, which then ends
+ * with a record carrying UART_SNIFFER_FLAG_END.
+ */
+static void uart_binary_io_sniffer(void);
+
+/**
+ * Handles an incoming UART_BINARY_IO_TRIGGERED_SNIFFER binary I/O command.
+ *
+ * The command is followed by the UART_SNIFFER_TRIGGER_LINE_* bits of the lines
+ * to look at, the pattern length (1 to UART_SNIFFER_TRIGGER_MAXIMUM_LENGTH)
+ * and the pattern bytes, and is answered with a failure code if any of those
+ * is not valid.  The capture then works like uart_binary_io_sniffer, except
+ * that no record is sent until the whole pattern is seen in a row on one of
+ * the chosen lines.  The first record sent is the one for the byte completing
+ * the pattern; errors and ninth bits are not taken into account for matching.
+ */
+static void uart_binary_io_triggered_sniffer(void);
+
+/**
+ * Sets both receivers up, runs a sniffer capture until a byte comes from the
+ * host and puts everything back.
+ */
+static void uart_sniffer_run(void);
+
+/**
+ * Feeds a received byte to the triggered sniffer pattern matcher.
+ *
+ * @param[in] flags the UART_SNIFFER_FLAG_* bits for the byte.
+ * @param[in] value the received byte.
+ *
+ * @return true if the byte completes the pattern, false otherwise.
+ */
+static bool uart_sniffer_trigger_match(const uint8_t flags,
+                                       const uint8_t value);
+
+/**
+ * Appends a record to the receive ring, from interrupt handlers.
+ *
+ * @param[in] flags the UART_SNIFFER_FLAG_* bits for the record.
+ * @param[in] value the record data byte.
+ */
+static void uart_sniffer_push(uint8_t flags, const uint8_t value);
+
+/**
+ * Computes the parity of the given byte.
+ *
+ * @param[in] value the byte to compute the parity for.
+ *
+ * @return true if an odd number of bits is set, false otherwise.
+ */
+static bool uart_odd_parity(uint8_t value);
+
+#ifdef BUSPIRATEV4
+#define UART_IC1_BUFFER_NOT_EMPTY IC1CON1bits.ICBNE
+#define UART_IC2_BUFFER_NOT_EMPTY IC2CON1bits.ICBNE
+#else
+#define UART_IC1_BUFFER_NOT_EMPTY IC1CONbits.ICBNE
+#define UART_IC2_BUFFER_NOT_EMPTY IC2CONbits.ICBNE
+#endif /* BUSPIRATEV4 */
+
+/**
+ * Measures the baud rate of the data on the UART RX pin, using the first input
+ * capture unit to timestamp every edge with instruction cycle resolution.
+ *
+ * The shortest interval between edges is taken as a first estimate of the bit
+ * time, and is then refined by averaging all the intervals that are a small
+ * integer multiple of it.
+ *
+ * @return the measured baud rate, or 0 if a byte came from the serial port
+ *         before enough edges were seen.
+ */
+static uint32_t uart_measure_baud_rate(void);
+
+/**
+ * Handles an incoming UART_BINARY_IO_DETECT_BAUD_RATE binary I/O command.
+ *
+ * The baud rate is measured on the RX pin, snapped to the closest common rate
+ * if one is within UART_AUTOBAUD_TOLERANCE_PERCENT, and UART2 is set up for
+ * it.  If the measurement succeeded, a success code is sent, followed by the
+ * measured rate (4 bytes), the rate UART2 was set up for (4 bytes) and the new
+ * value of U2BRG (2 bytes), all big endian.  Sending any byte while waiting
+ * for activity aborts the measurement, and is answered with a failure code.
+ *
+ * @param[in] current_brg the baud rate generator value in use.
+ *
+ * @return the baud rate generator value UART2 is now set up with.
+ */
+static uint16_t uart_binary_io_detect_baud_rate(const uint16_t current_brg);
+
+/**
+ * Binary I/O command to only forward received lines matching some patterns.
+ *
+ * @see uart_binary_io_watch
+ */
+#define UART_BINARY_IO_WATCH 0x09
+
+/**
+ * Maximum number of patterns a watch can look for.
+ */
+#define UART_WATCH_MAXIMUM_PATTERNS 8
+
+/**
+ * Maximum length of all watch patterns put together, one bit of matcher state
+ * per pattern byte.
+ */
+#define UART_WATCH_MAXIMUM_PATTERN_BYTES 32
+
+/**
+ * Maximum number of context lines kept before a matching line.
+ */
+#define UART_WATCH_MAXIMUM_CONTEXT_LINES 8
+
+/**
+ * Handles an incoming UART_BINARY_IO_WATCH binary I/O command.
+ *
+ * The command is followed by the number of patterns (1 to
+ * UART_WATCH_MAXIMUM_PATTERNS), how many context lines to send before a
+ * matching line (up to UART_WATCH_MAXIMUM_CONTEXT_LINES), how many to send
+ * after it, and then by each pattern as a length byte followed by that many
+ * bytes.  Patterns cannot be empty and cannot be longer than
+ * UART_WATCH_MAXIMUM_PATTERN_BYTES all together.  The command is acknowledged
+ * with a success code, or with a failure code if any of the above does not
+ * hold, once all patterns have been read.
+ *
+ * UART2 reception is then buffered by the RX interrupt handler and split in
+ * lines ending with '\n'.  Patterns are looked for within each line with a
+ * shift-and matcher, and only matching lines and their context are sent, in
+ * records:
+ *
+ * <table>
+ * <tr><th>Offset</th><th>Size</th><th>Description</th></tr>
+ * <tr><td>0</td><td>1</td><td>Bitmask of the patterns found in the line, 0
+ *                             for context lines</td></tr>
+ * <tr><td>1</td><td>1</td><td>UART_RECEIVE_ERROR_* bits seen since the
+ *                             previous record</td></tr>
+ * <tr><td>2</td><td>2</td><td>Line length, big endian</td></tr>
+ * <tr><td>4</td><td>N</td><td>Line data, '\n' included</td></tr>
+ * </table>
+ *
+ * Lines longer than the history buffer only have their end sent, and context
+ * lines that no longer fit in it are dropped.  Any byte coming from the host
+ * stops the watch, which then ends with a record of length 0.
+ */
+static void uart_binary_io_watch(void);
+
+/**
+ * Sends a single watch record to the host, taking the line data out of the
+ * watch history ring.
+ *
+ * @param[in] history      the history ring storage.
+ * @param[in] history_size the history ring size, in bytes.
+ * @param[in] end          where the line ends in the history ring, exclusive.
+ * @param[in] length       the line length, at most history_size.
+ * @param[in] patterns     the patterns bitmask for the record.
+ */
+static void uart_watch_send_line(const uint8_t *history,
+                                 const uint16_t history_size, uint16_t end,
+                                 const uint16_t length, const uint8_t patterns);
+
 uint16_t uart_read(void) {
+  if (uart_terminal_receiving) {
+    uint8_t errors;
+    uint8_t value;
+
+    IEC1bits.U2RXIE = OFF;
+    errors = uart_receive_errors;
+    uart_receive_errors = 0;
+    IEC1bits.U2RXIE = ON;
+    uart_terminal_print_errors(errors);
+
+    if (uart_terminal_receive_pop(&value)) {
+      return value;
+    }
+
+    BPMSG1197;
+    return 0;
+  }
+
   if (uart2_rx_ready()) {
     uint16_t character;
 
-    /* Parity error? */
-    if (U2STAbits.PERR) {
-      BPMSG1194;
+    /* Parity error? */
+    if (U2STAbits.PERR) {
+      BPMSG1194;
+    }
+
+    /* Framing error? */
+    if (U2STAbits.FERR) {
+      BPMSG1195;
+    }
+
+    character = uart2_rx();
+
+    /* Overrun error? */
+    if (U2STAbits.OERR) {
+      BPMSG1196;
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_UART_OVERRUNS);
+
+      /* Clear overrun flag. */
+      U2STAbits.OERR = OFF;
+    }
+
+    return character;
+  }
+
+  BPMSG1197;
+  return 0;
+}
+
+inline uint16_t uart_write(const uint16_t character) {
+  uart2_tx(character);
+  return 0;
+}
+
+void uart_send_buffer(const uint8_t *buffer, const size_t length) {
+  size_t index;
+
+  for (index = 0; index < length; index++) {
+    uart2_tx(buffer[index]);
+  }
+}
+
+void UARTsettings(void) {
+  BPMSG1202;
+  bp_write_dec_byte(mode_configuration.speed);
+  bpSP;
+  bp_write_dec_word((mode_configuration.speed == 9)
+                        ? U2BRG
+                        : UART_BRG_SPEED[mode_configuration.speed]);
+  bpSP;
+  bp_write_dec_byte(uart_settings.databits_parity);
+  bpSP;
+  bp_write_dec_byte(uart_settings.stop_bits);
+  bpSP;
+  bp_write_dec_byte(uart_settings.receive_polarity);
+  bpSP;
+  bp_write_dec_byte(mode_configuration.high_impedance);
+  MSG_MODE_HEADER_END;
+}
+
+void uart_setup_prepare(void) {
+  int speed, dbp, sb, rxp, output, brg = 0;
+  // autobaud detection; multi uses
+  unsigned long abd = 0;
+
+#ifdef BUSPIRATEV4
+  uart_settings.autobaud = OFF;
+#endif /* BUSPIRATEV4 */
+
+  consumewhitechars();
+  speed = getint();
+  if (speed == 10) // weird this is totaly ignored later as the Speed == 0 check
+                   // later skips the calculation I added it below..
+  {
+    consumewhitechars();
+    brg = getint();
+  }
+  consumewhitechars();
+  dbp = getint();
+  consumewhitechars();
+  sb = getint();
+  consumewhitechars();
+  rxp = getint();
+  consumewhitechars();
+  output = getint();
+
+  if ((speed > 0) && (speed <= 10)) {
+    mode_configuration.speed = speed - 1;
+  } else {
+    speed = 0; // when speed is 0 we ask the user
+  }
+
+  if ((dbp > 0) && (dbp <= 4)) {
+    uart_settings.databits_parity = dbp - 1;
+  } else {
+    speed = 0; // when speed is 0 we ask the user
+  }
+
+  if ((sb > 0) && (sb <= 2)) {
+    uart_settings.stop_bits = sb - 1;
+  } else {
+    speed = 0; // when speed is 0 we ask the user
+  }
+
+  if ((rxp > 0) && (rxp <= 2)) {
+    uart_settings.receive_polarity = rxp - 1;
+  } else {
+    speed = 0; // when speed is 0 we ask the user
+  }
+
+  if ((output > 0) && (output <= 2)) {
+    mode_configuration.high_impedance = ~(output - 1);
+  } else {
+    speed = 0; // when speed is 0 we ask the user
+  }
+
+  if (speed == 0) {
+    mode_configuration.command_error = NO;
+
+    BPMSG1133;
+
+#if defined(BUSPIRATEV4)
+    // BPv4 Mode; has custom BAUD entry and auto-baud detection
+
+    mode_configuration.speed = getnumber(1, 1, 11, 0) - 1; // get user reply
+
+    if (mode_configuration.speed == 10) {
+      mode_configuration.speed = 8; // Set to 115200 for now
+      abd = 1;                      // trigger to run baud detection
+      uart_settings.autobaud = ON;
+      MSG_BAUD_DETECTION_SELECTED;
+    }
+
+    if (mode_configuration.speed == 9) {
+      BPMSG1248;                           // say input custom BAUD rate
+      abd = getlong(115200, 1, 999999, 0); // get the baud rate from user
+      abd = (((32000000 / abd) / 8) - 1);  // calculate BRG
+      brg = abd;                           // set BRG
+      abd = 0; // set abd to 0; so 'Auto Baud Detection' routine isnt ran below
+      // hack hack hakc
+      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
+                   // use it to start UART2setup..
+    }
+#else
+    // Normal mode; input BRG and no autobaud detection
+    mode_configuration.speed = getnumber(1, 1, 10, 0) - 1; // get user reply
+
+    if (mode_configuration.speed == 9) {
+      BPMSG1248;
+      brg = getnumber(34, 1, 32767, 0);
+      // hack hack hack
+      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
+                   // use it to start UART2setup..
+    }
+#endif /* BUSPIRATEV4 */
+
+    BPMSG1199;
+    uart_settings.databits_parity = getnumber(1, 1, 4, 0) - 1;
+
+    BPMSG1200;
+    uart_settings.stop_bits = getnumber(1, 1, 2, 0) - 1;
+
+    BPMSG1201;
+    uart_settings.receive_polarity = getnumber(1, 1, 2, 0) - 1;
+
+    MSG_PIN_OUTPUT_TYPE_PROMPT;
+    mode_configuration.high_impedance = ~(getnumber(1, 1, 2, 0) - 1);
+  } else {
+    if (mode_configuration.speed == 9) {
+      abd = brg;
+      abd = (((32000000 / abd) / 8) - 1); // calculate BRG
+      brg = abd;                          // set BRG
+      abd = 0; // set abd to 0; so 'Auto Baud Detection' routine isnt ran below
+      // hack hack hakc
+      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
+                   // use it to start UART2setup..
+    }
+    UARTsettings();
+  }
+}
+
+void uart_setup_execute(void) {
+  uart2_setup(mode_configuration.speed == 9
+                  ? U2BRG
+                  : UART_BRG_SPEED[mode_configuration.speed],
+              mode_configuration.high_impedance, uart_settings.receive_polarity,
+              uart_settings.databits_parity, uart_settings.stop_bits);
+
+  if (uart_settings.databits_parity == 3) {
+    mode_configuration.numbits = 9;
+  }
+
+  uart2_enable();
+
+#ifdef BUSPIRATEV4
+  unsigned long abd;
+  int brg;
+  if (uart_settings.autobaud == ON) {
+    uart2_disable();
+    bpBR;
+    abd = uart_get_closest_common_rate(uart_get_baud_rate(false));
+    bpBR;
+
+    if (abd == 0) {
+      uart2_setup(UART_BRG_SPEED[8], mode_configuration.high_impedance,
+                  uart_settings.receive_polarity, uart_settings.databits_parity,
+                  uart_settings.stop_bits);
+    } else {
+      mode_configuration.speed = 9;
+      abd = (((32000000 / abd) / 8) - 1);
+      brg = abd;
+      uart2_setup(brg, mode_configuration.high_impedance,
+                  uart_settings.receive_polarity, uart_settings.databits_parity,
+                  uart_settings.stop_bits);
+    }
+    uart2_enable();
+  }
+#else
+  if (U2BRG < U1BRG) {
+    MSG_UART_POSSIBLE_OVERFLOW;
+  }
+#endif /* BUSPIRATEV4 */
+}
+
+void uart_cleanup(void) {
+  uart_terminal_receive_stop();
+  uart2_disable();
+}
+
+void uart_run_macro(const uint16_t macro) {
+  /* Macros drive UART2 on their own, the live display resumes afterwards. */
+  uart_terminal_receive_stop();
+
+  switch (macro) {
+  case UART_MACRO_MENU:
+    BPMSG1203;
+    break;
+
+  case UART_MACRO_BRIDGE_WITH_FLOW_CONTROL:
+#ifdef BUSPIRATEV3
+    /* FTDI CTS and RTS setup. */
+    FTDI_CTS_DIR = OUTPUT;
+    FTDI_RTS_DIR = INPUT;
+
+    /* External CTS and RTS setup. */
+    BP_CS_DIR = INPUT;
+    BP_CLK_DIR = OUTPUT;
+#else
+/* Do nothing for v4? */
+#endif /* BUSPIRATEV3 */
+
+  /* Intentional fall-through. */
+
+  case UART_MACRO_TRANSPARENT_BRIDGE:
+    BPMSG1204;
+#ifdef BUSPIRATEV4
+    MSG_UART_NORMAL_TO_EXIT;
+#else
+    MSG_UART_RESET_TO_EXIT;
+#endif /* BUSPIRATEV4 */
+
+    if (!agree()) {
+      break;
+    }
+
+    if (uart_interrupts_start()) {
+      uart_run_bridge(macro == UART_MACRO_BRIDGE_WITH_FLOW_CONTROL);
+    }
+    break;
+
+  case UART_MACRO_RAW_UART:
+    BPMSG1206;
+    MSG_ANY_KEY_TO_EXIT_PROMPT;
+#ifdef BUSPIRATEV3
+    user_serial_wait_transmission_done();
+#endif /* BUSPIRATEV3 */
+
+    U2STAbits.OERR = OFF;
+    for (;;) {
+#ifdef BUSPIRATEV4
+      if (BP_BUTTON_ISDOWN()) {
+        break;
+      }
+
+      if (uart2_rx_ready()) {
+        user_serial_transmit_character(uart2_rx());
+      }
+#else
+      if ((U2STAbits.URXDA == ON) && (U1STAbits.UTXBF == OFF)) {
+        U1TXREG = U2RXREG;
+      }
+#endif /* BUSPIRATEV4 */
+
+      if (user_serial_ready_to_read()) {
+        volatile uint16_t dummy;
+
+        dummy = user_serial_read_byte();
+        break;
+      }
+    }
+    break;
+
+  case UART_MACRO_AUTO_BAUD_RATE_DETECTION:
+    uart2_disable();
+    uart_get_baud_rate(false);
+    uart2_enable();
+#ifdef BUSPIRATEV3
+    if (U2BRG < U1BRG) {
+      MSG_UART_POSSIBLE_OVERFLOW;
+    }
+#endif /* BUSPIRATEV3 */
+    break;
+
+  default:
+    MSG_UNKNOWN_MACRO_ERROR;
+    break;
+  }
+}
+
+void uart_start(void) {
+  /* Clear overrun flag. */
+  U2STAbits.OERR = OFF;
+
+  /* Enable UART echo on the console, buffering reception in between. */
+  uart_settings.echo_uart = ON;
+  uart_terminal_receive_start();
+
+  /* Start periodic service calls. */
+  mode_configuration.periodicService = ON;
+
+  BPMSG1207;
+}
+
+void uart_stop(void) {
+  /* Show what came in before the stop, then disable UART echo. */
+  uart_periodic_callback();
+  uart_settings.echo_uart = OFF;
+  uart_terminal_receive_stop();
+
+  /* Stop periodic service calls. */
+  mode_configuration.periodicService = OFF;
+
+  BPMSG1208;
+}
+
+bool uart_periodic_callback(void) {
+  uint16_t available;
+  uint8_t column;
+  uint8_t errors;
+  uint8_t value;
+
+  if (!uart_settings.echo_uart) {
+    if (!uart2_rx_ready()) {
+      return false;
+    }
+
+    /* Clear RX queue. */
+    while (uart2_rx_ready()) {
+      uart2_rx();
+    }
+    return true;
+  }
+
+  if (!uart_terminal_receiving) {
+    uart_terminal_receive_start();
+  }
+
+  if (uart_terminal_receiving) {
+    IEC1bits.U2RXIE = OFF;
+    errors = uart_receive_errors;
+    uart_receive_errors = 0;
+    IEC1bits.U2RXIE = ON;
+
+    /*
+     * Only what is in the ring now gets printed, so the prompt comes back
+     * even if the target keeps sending.
+     */
+    available =
+        (uart_receive_ring.head - uart_receive_ring.tail) & UART_RING_MASK;
+  } else {
+    errors = 0;
+    available = uart2_rx_ready() ? UART_TERMINAL_VALUES_PER_LINE : 0;
+  }
+
+  if ((available == 0) && (errors == 0)) {
+    return false;
+  }
+
+  bpBR;
+  BPMSG1102;
+  uart_terminal_print_errors(errors);
+  column = 0;
+  while ((available > 0) && uart_terminal_receive_pop(&value)) {
+    if (column == UART_TERMINAL_VALUES_PER_LINE) {
+      bpBR;
+      BPMSG1102;
+      column = 0;
+    }
+    bp_write_formatted_integer(value);
+    bpSP;
+    column++;
+    available--;
+  }
+  bpBR;
+
+  return true;
+}
+
+void uart_terminal_receive_start(void) {
+  if (!uart_terminal_receiving) {
+    uart_terminal_receiving = uart_receive_interrupt_start();
+  }
+}
+
+void uart_terminal_receive_stop(void) {
+  if (uart_terminal_receiving) {
+    uart_receive_interrupt_stop();
+    uart_terminal_receiving = false;
+  }
+}
+
+bool uart_terminal_receive_pop(uint8_t *value) {
+  if (!uart_terminal_receiving) {
+    if (!uart2_rx_ready()) {
+      return false;
+    }
+    uart_terminal_print_errors((U2STAbits.PERR ? UART_RECEIVE_ERROR_PARITY : 0) |
+                               (U2STAbits.FERR ? UART_RECEIVE_ERROR_FRAMING
+                                               : 0));
+    *value = uart2_rx();
+    if (U2STAbits.OERR) {
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_UART_OVERRUNS);
+
+      /* Clear overrun flag. */
+      U2STAbits.OERR = OFF;
+      BPMSG1196;
+    }
+    return true;
+  }
+
+  if (uart_receive_ring.tail == uart_receive_ring.head) {
+    return false;
+  }
+
+  *value = uart_receive_ring.buffer[uart_receive_ring.tail];
+  uart_receive_ring.tail = (uart_receive_ring.tail + 1) & UART_RING_MASK;
+  uart_receive_ring_resume();
+  return true;
+}
+
+void uart_terminal_print_errors(const uint8_t errors) {
+  if (errors & UART_RECEIVE_ERROR_PARITY) {
+    BPMSG1194;
+  }
+
+  if (errors & UART_RECEIVE_ERROR_FRAMING) {
+    BPMSG1195;
+  }
+
+  /* Bytes were lost, in the UART2 FIFO or in the ring. */
+  if (errors & (UART_RECEIVE_ERROR_OVERRUN | UART_RECEIVE_ERROR_RING_OVERFLOW)) {
+    BPMSG1196;
+  }
+}
+
+inline void uart_pins_state(void) { MSG_UART_PINS_STATE; }
+
+uint32_t uart_get_closest_common_rate(const uint32_t baud_rate) {
+  size_t counter;
+
+  for (counter = 1; counter < UART_COMMON_BAUD_RATES_COUNT; counter++) {
+    if (baud_rate < UART_COMMON_BAUD_RATES[counter]) {
+      uint32_t lower;
+      uint32_t upper;
+
+      lower = UART_COMMON_BAUD_RATES[counter - 1];
+      upper = UART_COMMON_BAUD_RATES[counter];
+
+      return (baud_rate > lower + (upper - lower) / 2) ? upper : lower;
     }
+  }
 
-    /* Framing error? */
-    if (U2STAbits.FERR) {
-      BPMSG1195;
+  return 0;
+}
+
+uint32_t uart_get_baud_rate(const bool quiet) {
+  size_t samples;
+  uint32_t current_sample;
+  uint32_t bit_sample;
+
+  BP_MISO = LOW;
+  BP_MISO_DIR = INPUT;
+  bit_sample = 0;
+
+  if (!quiet) {
+    BPMSG1280;
+  }
+
+  /* Wait for the UART to stabilise. */
+  while ((BP_MISO == HIGH) && !user_serial_ready_to_read()) {
+    Nop();
+  }
+
+  /* Key pressed during detection, bailing out. */
+  if (user_serial_ready_to_read()) {
+    /* Clear RX queue. */
+    user_serial_read_byte();
+
+    /* Stop timers. */
+
+    /* Clear timer 5 holding register. */
+    TMR5HLD = 0;
+
+    /*
+     * T4CON: TIMER4 CONTROL REGISTER
+     *
+     * MSB
+     * 0-0------0001-0-
+     * | |      |||| |
+     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+     * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
+     * | |      |++------ TCKPS: Input prescaler 1:1.
+     * | |      +-------- TGATE: Gated time accumulation is disabled.
+     * | +--------------- TSIDL  Continues module operation in Idle mode.
+     * +----------------- TON:   Stops 16-bit Timerx.
+     */
+    T4CON = 1 << _T4CON_T32_POSITION;
+
+    /* Clear timer 4 register. */
+    TMR4 = 0;
+
+    /* Clear timer 3 holding register. */
+    TMR3HLD = 0;
+
+    /*
+     * T2CON: TIMER2 CONTROL REGISTER
+     *
+     * MSB
+     * 0-0------0001-0-
+     * | |      |||| |
+     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+     * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
+     * | |      |++------ TCKPS: Input prescaler 1:1.
+     * | |      +-------- TGATE: Gated time accumulation is disabled.
+     * | +--------------- TSIDL  Continues module operation in Idle mode.
+     * +----------------- TON:   Stops 16-bit Timerx.
+     */
+    T2CON = 1 << _T2CON_T32_POSITION;
+
+    /* Clear timer 2 register. */
+    TMR2 = 0;
+
+    if (!quiet) {
+      BPMSG1281;
     }
 
-    character = uart2_rx();
+    return 0;
+  }
 
-    /* Overrun error? */
-    if (U2STAbits.OERR) {
-      BPMSG1196;
+  for (samples = 0; samples < UART_BAUD_RATE_CALCULATION_SAMPLES; samples++) {
 
-      /* Clear overrun flag. */
-      U2STAbits.OERR = OFF;
+    /* Wait for activity. */
+    while (BP_MISO == LOW) {
     }
 
-    return character;
+    /* Start counting. */
+    T4CONbits.TON = ON;
+    T2CONbits.TON = ON;
+
+    /* Wait for line to go down. */
+    while (BP_MISO == HIGH) {
+    }
+
+    /* Stop counting. */
+    T2CONbits.TON = OFF;
+    T4CONbits.TON = OFF;
+
+    /* Neuter Timer2. */
+    RPINR3bits.T2CKR = 0b011111;
+
+    /* Stop timers. */
+
+    /*
+     * T4CON: TIMER4 CONTROL REGISTER
+     *
+     * MSB
+     * 0-0------0000-0-
+     * | |      |||| |
+     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+     * | |      |||+----- T32:   Timerx and Timery act as 2 16-bit timers.
+     * | |      |++------ TCKPS: Input prescaler 1:1.
+     * | |      +-------- TGATE: Gated time accumulation is disabled.
+     * | +--------------- TSIDL  Continues module operation in Idle mode.
+     * +----------------- TON:   Stops 16-bit Timerx.
+     */
+    T4CON = 0;
+
+    /*
+     * T2CON: TIMER2 CONTROL REGISTER
+     *
+     * MSB
+     * 0-0------0000-0-
+     * | |      |||| |
+     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+     * | |      |||+----- T32:   Timerx and Timery act as 2 16-bit timers.
+     * | |      |++------ TCKPS: Input prescaler 1:1.
+     * | |      +-------- TGATE: Gated time accumulation is disabled.
+     * | +--------------- TSIDL  Continues module operation in Idle mode.
+     * +----------------- TON:   Stops 16-bit Timerx.
+     */
+    T2CON = 0;
+
+    /* Get the smallest timing value after the first one. */
+
+    current_sample = ((uint32_t)TMR3HLD << 16) | TMR2;
+    if ((samples > 0) && ((bit_sample == 0) || (bit_sample > current_sample))) {
+      bit_sample = current_sample;
+    }
   }
 
-  BPMSG1197;
-  return 0;
+  /* Neuter Timer2. */
+  RPINR3bits.T2CKR = 0b011111;
+
+  /* Clear timer 2 register. */
+  TMR2 = 0;
+
+  /* Clear timer 3 holding register. */
+  TMR3HLD = 0;
+
+  bit_sample = FCY / bit_sample;
+
+  if (!quiet) {
+    if (bit_sample > 150000) {
+      BPMSG1282;
+    } else {
+      BPMSG1283;
+      bp_write_dec_dword(bit_sample);
+      BPMSG1285;
+      BPMSG1284;
+      bp_write_dec_dword(uart_get_closest_common_rate(bit_sample));
+      BPMSG1285;
+    }
+  }
+
+  return bit_sample;
 }
 
-inline uint16_t uart_write(const uint16_t character) {
-  uart2_tx(character);
-  return 0;
+bool uart_interrupts_start(void) {
+#ifdef BUSPIRATEV3
+  /* UART1 is fed directly from now on, let queued output go first. */
+  user_serial_wait_transmission_done();
+#endif /* BUSPIRATEV3 */
+
+  uart_terminal_receive_stop();
+
+  uart_transmit_ring.buffer = bp_buffer_arena_reserve(UART_RING_SIZE);
+  if (uart_transmit_ring.buffer == NULL) {
+    return false;
+  }
+  uart_transmit_ring.head = 0;
+  uart_transmit_ring.tail = 0;
+  IPC7bits.U2TXIP = UART_INTERRUPT_PRIORITY;
+  IFS1bits.U2TXIF = OFF;
+  IEC1bits.U2TXIE = OFF;
+
+  if (!uart_receive_interrupt_start()) {
+    bp_buffer_arena_release(uart_transmit_ring.buffer);
+    uart_transmit_ring.buffer = NULL;
+    return false;
+  }
+
+  return true;
 }
 
-void UARTsettings(void) {
-  BPMSG1202;
-  bp_write_dec_byte(mode_configuration.speed);
-  bpSP;
-  bp_write_dec_word((mode_configuration.speed == 9)
-                        ? U2BRG
-                        : UART_BRG_SPEED[mode_configuration.speed]);
-  bpSP;
-  bp_write_dec_byte(uart_settings.databits_parity);
-  bpSP;
-  bp_write_dec_byte(uart_settings.stop_bits);
-  bpSP;
-  bp_write_dec_byte(uart_settings.receive_polarity);
-  bpSP;
-  bp_write_dec_byte(mode_configuration.high_impedance);
-  MSG_MODE_HEADER_END;
+bool uart_receive_interrupt_start(void) {
+  uart_receive_ring.buffer = bp_buffer_arena_reserve(UART_RING_SIZE);
+  if (uart_receive_ring.buffer == NULL) {
+    return false;
+  }
+  uart_receive_ring.head = 0;
+  uart_receive_ring.tail = 0;
+  uart_receive_errors = 0;
+
+  /* RTS follows the ring from now on, and there is plenty of room. */
+  if (uart_settings.flow_control) {
+    BP_CLK = LOW;
+    BP_CLK_RPOUT = NULL_IO;
+  }
+
+  /* Clear overrun flag. */
+  U2STAbits.OERR = OFF;
+
+  IPC7bits.U2RXIP = UART_INTERRUPT_PRIORITY;
+  IFS1bits.U2RXIF = OFF;
+  IEC1bits.U2RXIE = ON;
+  return true;
 }
 
-void uart_setup_prepare(void) {
-  int speed, dbp, sb, rxp, output, brg = 0;
-  // autobaud detection; multi uses
-  unsigned long abd = 0;
+void uart_interrupts_stop(void) {
+  IEC1bits.U2TXIE = OFF;
+  IFS1bits.U2TXIF = OFF;
+  IPC7bits.U2TXIP = 0;
+  bp_buffer_arena_release(uart_transmit_ring.buffer);
+  uart_transmit_ring.buffer = NULL;
 
-#ifdef BUSPIRATEV4
-  uart_settings.autobaud = OFF;
-#endif /* BUSPIRATEV4 */
+  uart_receive_interrupt_stop();
+}
 
-  consumewhitechars();
-  speed = getint();
-  if (speed == 10) // weird this is totaly ignored later as the Speed == 0 check
-                   // later skips the calculation I added it below..
-  {
-    consumewhitechars();
-    brg = getint();
-  }
-  consumewhitechars();
-  dbp = getint();
-  consumewhitechars();
-  sb = getint();
-  consumewhitechars();
-  rxp = getint();
-  consumewhitechars();
-  output = getint();
+void uart_receive_interrupt_stop(void) {
+  IEC1bits.U2RXIE = OFF;
+  IFS1bits.U2RXIF = OFF;
+  IPC7bits.U2RXIP = 0;
 
-  if ((speed > 0) && (speed <= 10)) {
-    mode_configuration.speed = speed - 1;
-  } else {
-    speed = 0; // when speed is 0 we ask the user
+  if (uart_settings.flow_control) {
+    BP_CLK_RPOUT = U2RTS_IO;
   }
 
-  if ((dbp > 0) && (dbp <= 4)) {
-    uart_settings.databits_parity = dbp - 1;
-  } else {
-    speed = 0; // when speed is 0 we ask the user
+  bp_buffer_arena_release(uart_receive_ring.buffer);
+  uart_receive_ring.buffer = NULL;
+}
+
+void uart_receive_ring_drain(void) {
+#ifdef BUSPIRATEV4
+  if (uart_receive_ring.tail != uart_receive_ring.head) {
+    user_serial_transmit_character(
+        uart_receive_ring.buffer[uart_receive_ring.tail]);
+    uart_receive_ring.tail = (uart_receive_ring.tail + 1) & UART_RING_MASK;
+  }
+#else
+  /* Fill the UART1 FIFO as much as possible. */
+  while ((uart_receive_ring.tail != uart_receive_ring.head) &&
+         (U1STAbits.UTXBF == OFF)) {
+    U1TXREG = uart_receive_ring.buffer[uart_receive_ring.tail];
+    uart_receive_ring.tail = (uart_receive_ring.tail + 1) & UART_RING_MASK;
   }
+#endif /* BUSPIRATEV4 */
 
-  if ((sb > 0) && (sb <= 2)) {
-    uart_settings.stop_bits = sb - 1;
-  } else {
-    speed = 0; // when speed is 0 we ask the user
+  uart_receive_ring_resume();
+}
+
+void uart_receive_ring_resume(void) {
+  if (uart_settings.flow_control && BP_CLK &&
+      (((uart_receive_ring.head - uart_receive_ring.tail) & UART_RING_MASK) <
+       UART_RING_LOW_WATERMARK)) {
+    BP_CLK = LOW;
   }
+}
 
-  if ((rxp > 0) && (rxp <= 2)) {
-    uart_settings.receive_polarity = rxp - 1;
+void uart_flow_control_apply(void) {
+  if (uart_settings.flow_control) {
+    /* CTS is an input on CS, RTS an output on CLK, asserted when low. */
+    BP_CS_DIR = INPUT;
+    RPINR19bits.U2CTSR = BP_CS_RPIN;
+    BP_CLK_ODC = mode_configuration.high_impedance;
+    BP_CLK_DIR = OUTPUT;
+    BP_CLK_RPOUT = U2RTS_IO;
+    U2MODEbits.UEN = 0b10;
   } else {
-    speed = 0; // when speed is 0 we ask the user
+    U2MODEbits.UEN = 0b00;
+    BP_CLK_RPOUT = NULL_IO;
+    RPINR19bits.U2CTSR = 0b11111;
+    BP_CLK_ODC = OFF;
   }
+}
 
-  if ((output > 0) && (output <= 2)) {
-    mode_configuration.high_impedance = ~(output - 1);
-  } else {
-    speed = 0; // when speed is 0 we ask the user
+void uart_binary_io_flow_control(void) {
+  uint8_t flags;
+
+  flags = user_serial_read_byte();
+  if (flags & ~UART_FLOW_CONTROL_FLAGS_MASK) {
+    REPORT_IO_FAILURE();
+    return;
   }
 
-  if (speed == 0) {
-    mode_configuration.command_error = NO;
+  uart_settings.flow_control = (flags & UART_FLOW_CONTROL_FLAG_RTS_CTS) != 0;
+  uart_flow_control_apply();
+  REPORT_IO_SUCCESS();
+}
 
-    BPMSG1133;
+void uart_run_bridge(const bool flow_control) {
+  for (;;) {
+    uint16_t next;
 
-#if defined(BUSPIRATEV4)
-    // BPv4 Mode; has custom BAUD entry and auto-baud detection
+#ifdef BUSPIRATEV4
+    if (BP_BUTTON_ISDOWN()) {
+      break;
+    }
+#endif /* BUSPIRATEV4 */
 
-    mode_configuration.speed = getnumber(1, 1, 11, 0) - 1; // get user reply
+    /* UART2 -> serial port. */
+    uart_receive_ring_drain();
 
-    if (mode_configuration.speed == 10) {
-      mode_configuration.speed = 8; // Set to 115200 for now
-      abd = 1;                      // trigger to run baud detection
-      uart_settings.autobaud = ON;
-      MSG_BAUD_DETECTION_SELECTED;
+    /* Serial port -> UART2, if there is room left in the ring. */
+    next = (uart_transmit_ring.head + 1) & UART_RING_MASK;
+    if ((next != uart_transmit_ring.tail) && user_serial_ready_to_read()) {
+      uart_transmit_ring.buffer[uart_transmit_ring.head] =
+          user_serial_read_byte();
+      uart_transmit_ring.head = next;
+
+      /* Forcing the flag lets the handler pick up the new byte right away. */
+      IEC1bits.U2TXIE = ON;
+      IFS1bits.U2TXIF = ON;
     }
 
-    if (mode_configuration.speed == 9) {
-      BPMSG1248;                           // say input custom BAUD rate
-      abd = getlong(115200, 1, 999999, 0); // get the baud rate from user
-      abd = (((32000000 / abd) / 8) - 1);  // calculate BRG
-      brg = abd;                           // set BRG
-      abd = 0; // set abd to 0; so 'Auto Baud Detection' routine isnt ran below
-      // hack hack hakc
-      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
-                   // use it to start UART2setup..
+#ifdef BUSPIRATEV3
+    if (U1STAbits.OERR) {
+      U1STAbits.OERR = OFF;
+      BP_LEDMODE = LOW;
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_OVERFLOWS);
     }
-#else
-    // Normal mode; input BRG and no autobaud detection
-    mode_configuration.speed = getnumber(1, 1, 10, 0) - 1; // get user reply
+#endif /* BUSPIRATEV3 */
 
-    if (mode_configuration.speed == 9) {
-      BPMSG1248;
-      brg = getnumber(34, 1, 32767, 0);
-      // hack hack hack
-      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
-                   // use it to start UART2setup..
+    if (uart_receive_errors &
+        (UART_RECEIVE_ERROR_OVERRUN | UART_RECEIVE_ERROR_RING_OVERFLOW)) {
+      uart_receive_errors = 0;
+      BP_LEDMODE = LOW;
     }
-#endif /* BUSPIRATEV4 */
 
-    BPMSG1199;
-    uart_settings.databits_parity = getnumber(1, 1, 4, 0) - 1;
+#ifdef BUSPIRATEV3
+    if (flow_control) {
+      /* Relay flow control bits. */
+      BP_CLK = FTDI_RTS;
+      FTDI_CTS = BP_CS;
+    }
+#endif /* BUSPIRATEV3 */
+  }
 
-    BPMSG1200;
-    uart_settings.stop_bits = getnumber(1, 1, 2, 0) - 1;
+  uart_interrupts_stop();
+}
 
-    BPMSG1201;
-    uart_settings.receive_polarity = getnumber(1, 1, 2, 0) - 1;
+void uart_timestamp_start(void) {
+  /*
+   * T2CON: TIMER2 CONTROL REGISTER
+   *
+   * MSB
+   * 1-0------0011-0-
+   * | |      |||| |
+   * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+   * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
+   * | |      |++------ TCKPS: Input prescaler 1:8 (0.5us per tick).
+   * | |      +-------- TGATE: Gated time accumulation is disabled.
+   * | +--------------- TSIDL  Continues module operation in Idle mode.
+   * +----------------- TON:   Starts 32-bit Timerx.
+   */
+  T2CON = 0;
+  TMR3HLD = 0;
+  TMR2 = 0;
+  PR3 = 0xFFFF;
+  PR2 = 0xFFFF;
+  T2CON = (ON << _T2CON_TON_POSITION) | (1 << _T2CON_T32_POSITION) |
+          (0b01 << _T2CON_TCKPS_POSITION);
+}
 
-    MSG_PIN_OUTPUT_TYPE_PROMPT;
-    mode_configuration.high_impedance = ~(getnumber(1, 1, 2, 0) - 1);
-  } else {
-    if (mode_configuration.speed == 9) {
-      abd = brg;
-      abd = (((32000000 / abd) / 8) - 1); // calculate BRG
-      brg = abd;                          // set BRG
-      abd = 0; // set abd to 0; so 'Auto Baud Detection' routine isnt ran below
-      // hack hack hakc
-      U2BRG = brg; // passing the brg variable to U2BRG so the UARTsetup_exc can
-                   // use it to start UART2setup..
-    }
-    UARTsettings();
+uint32_t uart_timestamp_read(void) {
+  uint16_t low;
+
+  /* Reading TMR2 latches the upper half into TMR3HLD. */
+  low = TMR2;
+  return ((uint32_t)TMR3HLD << 16) | low;
+}
+
+void uart_stream_send_block(const uint16_t length, const uint8_t errors,
+                            const bool timestamp) {
+  uint8_t *block;
+  uint16_t offset;
+  uint16_t index;
+
+  /* The transmit ring is not used while streaming, stage the block there. */
+  block = uart_transmit_ring.buffer;
+  block[0] = length;
+  block[1] = errors;
+  offset = 2;
+
+  if (timestamp) {
+    uint32_t ticks;
+
+    ticks = uart_timestamp_read();
+    block[2] = HI8(HI16(ticks));
+    block[3] = LO8(HI16(ticks));
+    block[4] = HI8(LO16(ticks));
+    block[5] = LO8(LO16(ticks));
+    offset = 6;
+  }
+
+  for (index = 0; index < length; index++) {
+    block[offset++] = uart_receive_ring.buffer[uart_receive_ring.tail];
+    uart_receive_ring.tail = (uart_receive_ring.tail + 1) & UART_RING_MASK;
   }
+  uart_receive_ring_resume();
+
+  bp_write_buffer(block, offset);
 }
 
-void uart_setup_execute(void) {
-  uart2_setup(mode_configuration.speed == 9
-                  ? U2BRG
-                  : UART_BRG_SPEED[mode_configuration.speed],
-              mode_configuration.high_impedance, uart_settings.receive_polarity,
-              uart_settings.databits_parity, uart_settings.stop_bits);
+void uart_binary_io_stream_receive(void) {
+  uint8_t flags;
+  bool timestamp;
+  bool stopping;
+  uint32_t pending_since;
 
-  if (uart_settings.databits_parity == 3) {
-    mode_configuration.numbits = 9;
+  flags = user_serial_read_byte();
+  if (flags & ~UART_STREAM_FLAGS_MASK) {
+    REPORT_IO_FAILURE();
+    return;
   }
+  timestamp = (flags & UART_STREAM_FLAG_TIMESTAMP) != 0;
 
-  uart2_enable();
+  uart_timestamp_start();
+  if (!uart_interrupts_start()) {
+    T2CON = 0;
+    REPORT_IO_FAILURE();
+    return;
+  }
+  REPORT_IO_SUCCESS();
 
-#ifdef BUSPIRATEV4
-  unsigned long abd;
-  int brg;
-  if (uart_settings.autobaud == ON) {
-    uart2_disable();
-    bpBR;
-    abd = uart_get_closest_common_rate(uart_get_baud_rate(false));
-    bpBR;
+  stopping = false;
+  pending_since = 0;
 
-    if (abd == 0) {
-      uart2_setup(UART_BRG_SPEED[8], mode_configuration.high_impedance,
-                  uart_settings.receive_polarity, uart_settings.databits_parity,
-                  uart_settings.stop_bits);
-    } else {
-      mode_configuration.speed = 9;
-      abd = (((32000000 / abd) / 8) - 1);
-      brg = abd;
-      uart2_setup(brg, mode_configuration.high_impedance,
-                  uart_settings.receive_polarity, uart_settings.databits_parity,
-                  uart_settings.stop_bits);
+  for (;;) {
+    uint16_t available;
+    uint8_t errors;
+
+    if (!stopping && user_serial_ready_to_read()) {
+      user_serial_read_byte();
+      stopping = true;
+    }
+
+    /* Take the error bits atomically with respect to the RX handler. */
+    IEC1bits.U2RXIE = OFF;
+    errors = uart_receive_errors;
+    uart_receive_errors = 0;
+    IEC1bits.U2RXIE = ON;
+
+    available = (uart_receive_ring.head - uart_receive_ring.tail) &
+                UART_RING_MASK;
+
+    if (available == 0) {
+      if (errors != 0) {
+        uart_stream_send_block(0, errors, timestamp);
+      }
+      if (stopping) {
+        break;
+      }
+      pending_since = uart_timestamp_read();
+      continue;
+    }
+
+    if ((available >= UART_STREAM_BLOCK_SIZE) || stopping ||
+        ((uart_timestamp_read() - pending_since) >=
+         UART_STREAM_IDLE_TICKS)) {
+      uart_stream_send_block((available > UART_STREAM_BLOCK_SIZE)
+                                 ? UART_STREAM_BLOCK_SIZE
+                                 : available,
+                             errors, timestamp);
+      pending_since = uart_timestamp_read();
+    } else if (errors != 0) {
+      /* Keep the errors for the block that is still being filled. */
+      IEC1bits.U2RXIE = OFF;
+      uart_receive_errors |= errors;
+      IEC1bits.U2RXIE = ON;
     }
-    uart2_enable();
   }
-#else
-  if (U2BRG < U1BRG) {
-    MSG_UART_POSSIBLE_OVERFLOW;
+
+  uart_interrupts_stop();
+  T2CON = 0;
+
+  /* End of stream marker. */
+  uart_stream_send_block(0, 0, timestamp);
+}
+
+void uart_watch_send_line(const uint8_t *history, const uint16_t history_size,
+                          uint16_t end, const uint16_t length,
+                          const uint8_t patterns) {
+  uint16_t index;
+  uint8_t errors;
+
+  IEC1bits.U2RXIE = OFF;
+  errors = uart_receive_errors;
+  uart_receive_errors = 0;
+  IEC1bits.U2RXIE = ON;
+
+  user_serial_transmit_character(patterns);
+  user_serial_transmit_character(errors);
+  user_serial_transmit_character(HI8(length));
+  user_serial_transmit_character(LO8(length));
+
+  index = (end >= length) ? end - length : end + history_size - length;
+  while (index != end) {
+    user_serial_transmit_character(history[index]);
+    index = (index + 1 < history_size) ? index + 1 : 0;
   }
-#endif /* BUSPIRATEV4 */
 }
 
-inline void uart_cleanup(void) { uart2_disable(); }
+void uart_binary_io_watch(void) {
+  uint8_t pattern_count;
+  uint8_t context_before;
+  uint8_t context_after;
+  uint8_t pattern_lengths[UART_WATCH_MAXIMUM_PATTERNS];
+  uint8_t pattern_bytes[UART_WATCH_MAXIMUM_PATTERN_BYTES];
+  uint16_t context_lengths[UART_WATCH_MAXIMUM_CONTEXT_LINES];
+  uint32_t pattern_ends[UART_WATCH_MAXIMUM_PATTERNS];
+  uint32_t *masks;
+  uint32_t starts;
+  uint32_t finals;
+  uint32_t state;
+  uint8_t *history;
+  uint16_t history_size;
+  uint16_t history_head;
+  uint16_t line_length;
+  uint16_t total;
+  uint8_t kept_lines;
+  uint8_t after_left;
+  uint8_t matched;
+  uint8_t index;
+  uint8_t length;
+  uint16_t used;
+  uint16_t offset;
+  bool valid;
+
+  pattern_count = user_serial_read_byte();
+  context_before = user_serial_read_byte();
+  context_after = user_serial_read_byte();
+  if ((pattern_count == 0) || (pattern_count > UART_WATCH_MAXIMUM_PATTERNS) ||
+      (context_before > UART_WATCH_MAXIMUM_CONTEXT_LINES)) {
+    REPORT_IO_FAILURE();
+    return;
+  }
 
-void uart_run_macro(const uint16_t macro) {
-  switch (macro) {
-  case UART_MACRO_MENU:
-    BPMSG1203;
-    break;
+  /* Every pattern is read even if invalid, to stay in sync with the host. */
+  valid = true;
+  used = 0;
+  for (index = 0; index < pattern_count; index++) {
+    length = user_serial_read_byte();
+    pattern_lengths[index] = length;
+    if (length == 0) {
+      valid = false;
+    }
+    for (offset = 0; offset < length; offset++) {
+      if (used < UART_WATCH_MAXIMUM_PATTERN_BYTES) {
+        pattern_bytes[used] = user_serial_read_byte();
+      } else {
+        user_serial_read_byte();
+        valid = false;
+      }
+      used++;
+    }
+  }
+  if (!valid || !uart_interrupts_start()) {
+    REPORT_IO_FAILURE();
+    return;
+  }
 
-  case UART_MACRO_BRIDGE_WITH_FLOW_CONTROL:
-#ifdef BUSPIRATEV3
-    /* FTDI CTS and RTS setup. */
-    FTDI_CTS_DIR = OUTPUT;
-    FTDI_RTS_DIR = INPUT;
+  /*
+   * The transmit ring is not used while watching: it holds the per byte
+   * matcher masks first, and the history of received lines after them.
+   */
+  masks = (uint32_t *)uart_transmit_ring.buffer;
+  history = uart_transmit_ring.buffer + (256 * sizeof(uint32_t));
+  history_size = UART_RING_SIZE - (256 * sizeof(uint32_t));
+
+  /*
+   * Patterns are laid out one after the other in the matcher state, bit N of
+   * a byte mask being set if pattern byte N is that byte.
+   */
+  memset(masks, 0, 256 * sizeof(uint32_t));
+  starts = 0;
+  finals = 0;
+  used = 0;
+  for (index = 0; index < pattern_count; index++) {
+    starts |= (uint32_t)1 << used;
+    for (offset = 0; offset < pattern_lengths[index]; offset++) {
+      masks[pattern_bytes[used]] |= (uint32_t)1 << used;
+      used++;
+    }
+    pattern_ends[index] = (uint32_t)1 << (used - 1);
+    finals |= pattern_ends[index];
+  }
 
-    /* External CTS and RTS setup. */
-    BP_CS_DIR = INPUT;
-    BP_CLK_DIR = OUTPUT;
-#else
-/* Do nothing for v4? */
-#endif /* BUSPIRATEV3 */
+  REPORT_IO_SUCCESS();
 
-  /* Intentional fall-through. */
+  state = 0;
+  matched = 0;
+  history_head = 0;
+  line_length = 0;
+  kept_lines = 0;
+  after_left = 0;
 
-  case UART_MACRO_TRANSPARENT_BRIDGE:
-    BPMSG1204;
-#ifdef BUSPIRATEV4
-    MSG_UART_NORMAL_TO_EXIT;
-#else
-    MSG_UART_RESET_TO_EXIT;
-#endif /* BUSPIRATEV4 */
+  while (!user_serial_ready_to_read()) {
+    uint8_t value;
 
-    if (!agree()) {
-      break;
+    if (uart_receive_ring.tail == uart_receive_ring.head) {
+      continue;
     }
 
-    /* Make terminal speed match target speed to avoid overruns? */
+    value = uart_receive_ring.buffer[uart_receive_ring.tail];
+    uart_receive_ring.tail = (uart_receive_ring.tail + 1) & UART_RING_MASK;
+    uart_receive_ring_resume();
 
-    /* Clear overrun flag. */
-    U2STAbits.OERR = OFF;
+    history[history_head] = value;
+    history_head = (history_head + 1 < history_size) ? history_head + 1 : 0;
+    if (line_length < history_size) {
+      line_length++;
+    }
 
-    for (;;) {
-#ifdef BUSPIRATEV4
-      if (BP_BUTTON_ISDOWN()) {
-        break;
+    state = ((state << 1) | starts) & masks[value];
+    if (state & finals) {
+      for (index = 0; index < pattern_count; index++) {
+        if (state & pattern_ends[index]) {
+          matched |= 1 << index;
+        }
       }
+    }
 
-      if (U2STAbits.URXDA == ON) {
-        user_serial_transmit_character(U2RXREG);
-      }
-#else
-      if ((U2STAbits.URXDA == ON) && (U1STAbits.UTXBF == OFF)) {
-        U1TXREG = U2RXREG;
-      }
-#endif /* BUSPIRATEV4 */
+    if (value != '\n') {
+      continue;
+    }
 
-      if (user_serial_ready_to_read() && (U2STAbits.UTXBF == OFF)) {
-        U2TXREG = user_serial_read_byte();
+    if (matched != 0) {
+      /* Send the context lines still in the history, oldest first. */
+      total = line_length;
+      index = 0;
+      while ((index < kept_lines) &&
+             ((history_size - total) >= context_lengths[index])) {
+        total += context_lengths[index];
+        index++;
       }
-
-#ifdef BUSPIRATEV3
-      if (U2STAbits.OERR || U1STAbits.OERR) {
-        U2STAbits.OERR = OFF;
-        U1STAbits.OERR = OFF;
-        BP_LEDMODE = LOW;
+      while (index > 0) {
+        index--;
+        total -= context_lengths[index];
+        uart_watch_send_line(history, history_size,
+                             (history_head + history_size - total) %
+                                 history_size,
+                             context_lengths[index], 0);
       }
-#else
-      if (U2STAbits.OERR) {
-        U2STAbits.OERR = OFF;
-        BP_LEDMODE = LOW;
+      uart_watch_send_line(history, history_size, history_head, line_length,
+                           matched);
+      kept_lines = 0;
+      after_left = context_after;
+    } else if (after_left > 0) {
+      uart_watch_send_line(history, history_size, history_head, line_length,
+                           0);
+      after_left--;
+    } else if (context_before > 0) {
+      /* Most recent line first. */
+      if (kept_lines < context_before) {
+        kept_lines++;
       }
-#endif /* BUSPIRATEV3 */
-
-#ifdef BUSPIRATEV3
-      if (macro == UART_MACRO_BRIDGE_WITH_FLOW_CONTROL) {
-        /* Relay flow control bits. */
-        BP_CLK = FTDI_RTS;
-        FTDI_CTS = BP_CS;
+      for (index = kept_lines - 1; index > 0; index--) {
+        context_lengths[index] = context_lengths[index - 1];
       }
-#endif /* BUSPIRATEV3 */
+      context_lengths[0] = line_length;
     }
-    break;
 
-  case UART_MACRO_RAW_UART:
-    BPMSG1206;
-    MSG_ANY_KEY_TO_EXIT_PROMPT;
+    state = 0;
+    matched = 0;
+    line_length = 0;
+  }
+
+  user_serial_read_byte();
+  uart_interrupts_stop();
+
+  /* End of watch marker. */
+  user_serial_transmit_character(0);
+  user_serial_transmit_character(0);
+  user_serial_transmit_character(0);
+  user_serial_transmit_character(0);
+}
+
+uint32_t uart_measure_baud_rate(void) {
+  uint16_t intervals[UART_AUTOBAUD_INTERVALS];
+  size_t collected;
+  size_t index;
+  uint16_t previous;
+  uint16_t shortest;
+  uint32_t total_ticks;
+  uint16_t total_bits;
+  bool aborted;
+
+  /* Free running 16 bits Timer2, clocked at FCY. */
+  T2CON = 0x0000;
+  TMR2 = 0x0000;
+  PR2 = 0xFFFF;
+  IFS0bits.T2IF = OFF;
+
+  /* Assign input capture pin. */
+  RPINR7bits.IC1R = BP_MISO_RPIN;
 
-    U2STAbits.OERR = OFF;
-    for (;;) {
 #ifdef BUSPIRATEV4
-      if (BP_BUTTON_ISDOWN()) {
-        break;
-      }
 
-      if (uart2_rx_ready()) {
-        user_serial_transmit_character(uart2_rx());
-      }
+  /*
+   * IC1CON2
+   *
+   * MSB
+   * -------000-01100
+   *        ||| |||||
+   *        ||| +++++-- SYNCSEL:  Synchronise with Timer2.
+   *        ||+-------- TRIGSTAT: Timer source has not been triggered.
+   *        |+--------- ICTRIG:   Synchronize input capture with SYNCSEL source.
+   *        +---------- IC32:     Do not cascade input capture units.
+   */
+  IC1CON2 = 0b01100 << _IC1CON2_SYNCSEL_POSITION;
+
+  /*
+   * IC1CON1
+   *
+   * MSB
+   * --0001---00--001
+   *   ||||   ||  |||
+   *   ||||   ||  +++-- ICM:    Capture every edge.
+   *   ||||   ++------- ICI:    Interrupt on every capture event.
+   *   |+++------------ ICTSEL: Use Timer2.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle mode.
+   */
+  IC1CON1 = (0b001 << _IC1CON1_ICM_POSITION) |
+            (0b001 << _IC1CON1_ICTSEL_POSITION);
+
 #else
-      if ((U2STAbits.URXDA == ON) && (U1STAbits.UTXBF == OFF)) {
-        U1TXREG = U2RXREG;
-      }
+
+  /*
+   * IC1CON
+   *
+   * MSB
+   * --0-----100--001
+   *   |     |||  |||
+   *   |     |||  +++-- ICM:    Capture every edge.
+   *   |     |++------- ICI:    Interrupt on every capture event.
+   *   |     +--------- ICTMR:  TMR2 contents are captured on event.
+   *   +--------------- ICSIDL: Input capture continues on CPU idle.
+   */
+  IC1CON = (0b001 << _IC1CON_ICM_POSITION) | (ON << _IC1CON_ICTMR_POSITION);
+
 #endif /* BUSPIRATEV4 */
 
-      if (user_serial_ready_to_read()) {
-        volatile uint16_t dummy;
+  T2CONbits.TON = ON;
 
-        dummy = user_serial_read_byte();
+  /* Flush IC1. */
+  while (UART_IC1_BUFFER_NOT_EMPTY == ON) {
+    previous = IC1BUF;
+  }
+
+  aborted = false;
+  collected = 0;
+  previous = 0;
+  index = 0;
+  while (collected < UART_AUTOBAUD_INTERVALS) {
+    uint16_t current;
+
+    if (UART_IC1_BUFFER_NOT_EMPTY == OFF) {
+      if (user_serial_ready_to_read()) {
+        user_serial_read_byte();
+        aborted = true;
         break;
       }
+      continue;
     }
-    break;
 
-  case UART_MACRO_AUTO_BAUD_RATE_DETECTION:
-    uart2_disable();
-    uart_get_baud_rate(false);
-    uart2_enable();
-#ifdef BUSPIRATEV3
-    if (U2BRG < U1BRG) {
-      MSG_UART_POSSIBLE_OVERFLOW;
+    current = IC1BUF;
+
+    /*
+     * Skip the first edge, and any interval during which Timer2 rolled over
+     * as it may be longer than what 16 bits can hold.
+     */
+    if ((index > 0) && (IFS0bits.T2IF == OFF)) {
+      intervals[collected++] = current - previous;
     }
-#endif /* BUSPIRATEV3 */
-    break;
+    IFS0bits.T2IF = OFF;
+    previous = current;
+    index++;
+  }
 
-  default:
-    MSG_UNKNOWN_MACRO_ERROR;
-    break;
+  /* Stop the input capture unit and the timer. */
+#ifdef BUSPIRATEV4
+  IC1CON1 = 0x0000;
+  IC1CON2 = 0x0000;
+#else
+  IC1CON = 0x0000;
+#endif /* BUSPIRATEV4 */
+  T2CON = 0x0000;
+  TMR2 = 0x0000;
+
+  /* Neuter IC1. */
+  RPINR7bits.IC1R = 0b011111;
+
+  if (aborted) {
+    return 0;
+  }
+
+  shortest = 0xFFFF;
+  for (index = 0; index < collected; index++) {
+    if ((intervals[index] >= UART_AUTOBAUD_MINIMUM_TICKS) &&
+        (intervals[index] < shortest)) {
+      shortest = intervals[index];
+    }
+  }
+
+  if (shortest == 0xFFFF) {
+    return 0;
+  }
+
+  /* Average the bit time over every interval that spans a few bits. */
+  total_ticks = 0;
+  total_bits = 0;
+  for (index = 0; index < collected; index++) {
+    uint16_t bits;
+
+    if (intervals[index] < UART_AUTOBAUD_MINIMUM_TICKS) {
+      continue;
+    }
+
+    bits = (intervals[index] + (shortest / 2)) / shortest;
+    if (bits <= UART_AUTOBAUD_MAXIMUM_BITS) {
+      total_ticks += intervals[index];
+      total_bits += bits;
+    }
   }
+
+  /* FCY * 16 still fits in 32 bits, keeping four fractional bits. */
+  return (FCY * 16) / ((total_ticks * 16) / total_bits);
 }
 
-void uart_start(void) {
-  /* Clear overrun flag. */
-  U2STAbits.OERR = OFF;
+uint16_t uart_binary_io_detect_baud_rate(const uint16_t current_brg) {
+  uint32_t measured;
+  uint32_t common;
+  uint32_t selected;
+  uint32_t difference;
+  uint16_t brg;
+
+  measured = uart_measure_baud_rate();
+  if (measured == 0) {
+    REPORT_IO_FAILURE();
+    return current_brg;
+  }
 
-  /* Enable UART echo on the console. */
-  uart_settings.echo_uart = ON;
+  selected = measured;
+  common = uart_get_closest_common_rate(measured);
+  if (common != 0) {
+    difference = (common > measured) ? common - measured : measured - common;
+    if ((difference * 100) <= (common * UART_AUTOBAUD_TOLERANCE_PERCENT)) {
+      selected = common;
+    }
+  }
 
-  /* Start periodic service calls. */
-  mode_configuration.periodicService = ON;
+  /* High speed mode: baud rate = FCY / (4 * (U2BRG + 1)). */
+  brg = (uint16_t)((((FCY / 4) + (selected / 2)) / selected) - 1);
+  mode_configuration.speed = 9;
 
-  BPMSG1207;
-}
+  uart2_disable();
+  uart2_setup(brg, mode_configuration.high_impedance,
+              uart_settings.receive_polarity, uart_settings.databits_parity,
+              uart_settings.stop_bits);
+  uart2_enable();
+  uart_flow_control_apply();
 
-void uart_stop(void) {
-  /* Disable UART echo on the console. */
-  uart_settings.echo_uart = OFF;
+  REPORT_IO_SUCCESS();
+  bp_binary_io_write_uint32(measured);
+  bp_binary_io_write_uint32(selected);
+  user_serial_transmit_character(HI8(brg));
+  user_serial_transmit_character(LO8(brg));
 
-  /* Stop periodic service calls. */
-  mode_configuration.periodicService = OFF;
+  return brg;
+}
 
-  BPMSG1208;
+bool uart_odd_parity(uint8_t value) {
+  value ^= value >> 4;
+  value ^= value >> 2;
+  value ^= value >> 1;
+
+  return (value & 1) != 0;
 }
 
-bool uart_periodic_callback(void) {
-  bool handled;
+bool uart_sniffer_trigger_match(const uint8_t flags, const uint8_t value) {
+  uint8_t line;
+  uint8_t state;
+  uint8_t index;
 
-  handled = false;
-  while (uart2_rx_ready()) {
-    handled = true;
+  line = (flags & UART_SNIFFER_FLAG_MOSI) ? 1 : 0;
+  if (!(uart_sniffer_trigger.lines & (line ? UART_SNIFFER_TRIGGER_LINE_MOSI
+                                           : UART_SNIFFER_TRIGGER_LINE_MISO))) {
+    return false;
+  }
 
-    if (!uart_settings.echo_uart) {
-      /* Clear RX queue. */
-      uart2_rx();
-      continue;
+  /* Bit N is set while the last N + 1 bytes match the pattern start. */
+  state = (uart_sniffer_trigger.progress[line] << 1) | 1;
+  for (index = 0; index < uart_sniffer_trigger.length; index++) {
+    if (uart_sniffer_trigger.pattern[index] != value) {
+      state &= ~(1 << index);
     }
+  }
+  uart_sniffer_trigger.progress[line] = state;
 
-    bpBR;
-    BPMSG1102;
+  return (state & (1 << (uart_sniffer_trigger.length - 1))) != 0;
+}
 
-    /* Parity error? */
-    if (U2STAbits.PERR) {
-      BPMSG1194;
-    }
+void uart_sniffer_push(uint8_t flags, const uint8_t value) {
+  uint32_t timestamp;
+  uint16_t head;
 
-    /* Framing error? */
-    if (U2STAbits.FERR) {
-      BPMSG1195;
+  if (uart_sniffer_trigger.armed && !(flags & UART_SNIFFER_FLAG_END)) {
+    if (!uart_sniffer_trigger_match(flags, value)) {
+      return;
     }
+    uart_sniffer_trigger.armed = false;
+  }
 
-    bp_write_formatted_integer(uart2_rx());
+  if (((uart_receive_ring.tail - uart_receive_ring.head - 1) &
+       UART_RING_MASK) < UART_SNIFFER_RECORD_SIZE) {
+    uart_sniffer_overflow = true;
+    return;
+  }
 
-    /* Overrun error? */
-    if (U2STAbits.OERR) {
+  if (uart_sniffer_overflow) {
+    flags |= UART_SNIFFER_FLAG_OVERFLOW;
+    uart_sniffer_overflow = false;
+  }
 
-      /* Clear overrun flag. */
-      U2STAbits.OERR = OFF;
+  timestamp = uart_timestamp_read();
+
+  head = uart_receive_ring.head;
+  uart_receive_ring.buffer[head] = flags;
+  head = (head + 1) & UART_RING_MASK;
+  uart_receive_ring.buffer[head] = value;
+  head = (head + 1) & UART_RING_MASK;
+  uart_receive_ring.buffer[head] = HI8(HI16(timestamp));
+  head = (head + 1) & UART_RING_MASK;
+  uart_receive_ring.buffer[head] = LO8(HI16(timestamp));
+  head = (head + 1) & UART_RING_MASK;
+  uart_receive_ring.buffer[head] = HI8(LO16(timestamp));
+  head = (head + 1) & UART_RING_MASK;
+  uart_receive_ring.buffer[head] = LO8(LO16(timestamp));
+  uart_receive_ring.head = (head + 1) & UART_RING_MASK;
+}
 
-      BPMSG1196;
-    }
+void uart_binary_io_sniffer(void) {
+  uart_sniffer_trigger.armed = false;
+  uart_sniffer_run();
+}
 
-    bpBR;
+void uart_binary_io_triggered_sniffer(void) {
+  uint8_t index;
+
+  uart_sniffer_trigger.lines = user_serial_read_byte();
+  uart_sniffer_trigger.length = user_serial_read_byte();
+  if ((uart_sniffer_trigger.length == 0) ||
+      (uart_sniffer_trigger.length > UART_SNIFFER_TRIGGER_MAXIMUM_LENGTH) ||
+      (uart_sniffer_trigger.lines == 0) ||
+      (uart_sniffer_trigger.lines & ~(UART_SNIFFER_TRIGGER_LINE_MISO |
+                                      UART_SNIFFER_TRIGGER_LINE_MOSI))) {
+    REPORT_IO_FAILURE();
+    return;
+  }
+
+  for (index = 0; index < uart_sniffer_trigger.length; index++) {
+    uart_sniffer_trigger.pattern[index] = user_serial_read_byte();
   }
+  uart_sniffer_trigger.progress[0] = 0;
+  uart_sniffer_trigger.progress[1] = 0;
+  uart_sniffer_trigger.armed = true;
 
-  return handled;
+  uart_sniffer_run();
 }
 
-inline void uart_pins_state(void) { MSG_UART_PINS_STATE; }
+void uart_sniffer_run(void) {
+  uint32_t bit_ticks;
+
+  /* UART2 runs in high speed mode, 4 * (U2BRG + 1) cycles per bit. */
+  bit_ticks = ((uint32_t)U2BRG + 1) * 4;
+
+  /*
+   * T4CON: TIMER4 CONTROL REGISTER
+   *
+   * MSB
+   * 0-0------0xx0-0-
+   * | |      |||| |
+   * | |      |||| +--- TCS:   Internal clock (FOSC/2)
+   * | |      |||+----- T32:   Timer4 and Timer5 act as 2 16-bit timers.
+   * | |      |++------ TCKPS: Input prescaler 1:1, or 1:8 for slow rates.
+   * | |      +-------- TGATE: Gated time accumulation is disabled.
+   * | +--------------- TSIDL  Continues module operation in Idle mode.
+   * +----------------- TON:   Timer is started on the start bit edge.
+   */
+  T4CON = 0;
+  if (((bit_ticks * 3) / 2) > 0xFFFF) {
+    T4CON = 0b01 << _T4CON_TCKPS_POSITION;
+    bit_ticks /= 8;
+  }
 
-uint32_t uart_get_closest_common_rate(const uint32_t baud_rate) {
-  size_t counter;
+  uart_soft_receiver.bit_ticks = bit_ticks;
 
-  for (counter = 1; counter < UART_COMMON_BAUD_RATES_COUNT; counter++) {
-    if (baud_rate < UART_COMMON_BAUD_RATES[counter]) {
-      uint32_t lower;
-      uint32_t upper;
+  /* Eight data bits, followed by either a parity bit or a ninth data bit. */
+  uart_soft_receiver.frame_bits = (uart_settings.databits_parity == 0) ? 8 : 9;
+  uart_soft_receiver.inverted = uart_settings.receive_polarity;
+  uart_sniffing = true;
+  uart_sniffer_overflow = false;
 
-      lower = UART_COMMON_BAUD_RATES[counter - 1];
-      upper = UART_COMMON_BAUD_RATES[counter];
+  /* Stop driving MOSI, it becomes the second receiver input. */
+  BP_MOSI_RPOUT = OFF;
+  BP_MOSI_DIR = INPUT;
+  RPINR7bits.IC2R = BP_MOSI_RPIN;
 
-      return (baud_rate > lower + (upper - lower) / 2) ? upper : lower;
-    }
+  uart_timestamp_start();
+  if (!uart_interrupts_start()) {
+    uart_sniffing = false;
+    T2CON = 0;
+
+    /* Give MOSI back to UART2. */
+    RPINR7bits.IC2R = 0b011111;
+    BP_MOSI_RPOUT = U2TX_IO;
+    BP_MOSI_DIR = OUTPUT;
+    REPORT_IO_FAILURE();
+    return;
   }
+  IPC7bits.U2RXIP = UART_SNIFFER_INTERRUPT_PRIORITY;
 
-  return 0;
-}
+  /* The start bit is a falling edge, or a rising edge if inverted. */
+#ifdef BUSPIRATEV4
+  IC2CON2 = 0x0000;
+  IC2CON1 = ((uart_soft_receiver.inverted ? 0b011 : 0b010)
+             << _IC2CON1_ICM_POSITION) |
+            (0b111 << _IC2CON1_ICTSEL_POSITION);
+#else
+  IC2CON = (uart_soft_receiver.inverted ? 0b011 : 0b010)
+           << _IC2CON_ICM_POSITION;
+#endif /* BUSPIRATEV4 */
 
-uint32_t uart_get_baud_rate(const bool quiet) {
-  size_t samples;
-  uint32_t current_sample;
-  uint32_t bit_sample;
+  IPC6bits.T4IP = UART_SNIFFER_INTERRUPT_PRIORITY;
+  IPC1bits.IC2IP = UART_SNIFFER_INTERRUPT_PRIORITY;
+  IFS1bits.T4IF = OFF;
+  IEC1bits.T4IE = ON;
+  while (UART_IC2_BUFFER_NOT_EMPTY == ON) {
+    (void)IC2BUF;
+  }
+  IFS0bits.IC2IF = OFF;
+  IEC0bits.IC2IE = ON;
 
-  BP_MISO = LOW;
-  BP_MISO_DIR = INPUT;
-  bit_sample = 0;
+  REPORT_IO_SUCCESS();
 
-  if (!quiet) {
-    BPMSG1280;
+  while (!user_serial_ready_to_read()) {
+    uart_receive_ring_drain();
   }
+  user_serial_read_byte();
+
+  /* Stop both receivers. */
+  IEC0bits.IC2IE = OFF;
+  IEC1bits.T4IE = OFF;
+  IFS0bits.IC2IF = OFF;
+  IFS1bits.T4IF = OFF;
+  IPC1bits.IC2IP = 0;
+  IPC6bits.T4IP = 0;
+  T4CON = 0;
+#ifdef BUSPIRATEV4
+  IC2CON1 = 0x0000;
+#else
+  IC2CON = 0x0000;
+#endif /* BUSPIRATEV4 */
+  IEC1bits.U2RXIE = OFF;
 
-  /* Wait for the UART to stabilise. */
-  while ((BP_MISO == HIGH) && (U1STAbits.URXDA == OFF)) {
-    Nop();
+  /* The rings are only released once everything went out. */
+  uart_sniffer_push(UART_SNIFFER_FLAG_END, 0x00);
+  while (uart_receive_ring.tail != uart_receive_ring.head) {
+    uart_receive_ring_drain();
   }
+  uart_interrupts_stop();
 
-  /* Key pressed during detection, bailing out. */
-  if (U1STAbits.URXDA == ON) {
-    volatile uint16_t dummy;
+  uart_sniffing = false;
+  T2CON = 0;
 
-    /* Clear RX queue. */
-    dummy = U1RXREG;
+  /* Give MOSI back to UART2. */
+  RPINR7bits.IC2R = 0b011111;
+  BP_MOSI_RPOUT = U2TX_IO;
+  BP_MOSI_DIR = OUTPUT;
+}
 
-    /* Stop timers. */
+void __attribute__((interrupt, no_auto_psv)) _IC2Interrupt(void) {
 
-    /* Clear timer 5 holding register. */
-    TMR5HLD = 0;
+  /* A start bit began, sample the first data bit one and a half bits later. */
+  T4CONbits.TON = OFF;
+  TMR4 = 0;
+  PR4 = uart_soft_receiver.bit_ticks + (uart_soft_receiver.bit_ticks / 2) - 1;
+  uart_soft_receiver.bit_index = 0;
+  uart_soft_receiver.value = 0;
+  IFS1bits.T4IF = OFF;
+  T4CONbits.TON = ON;
 
-    /*
-     * T4CON: TIMER4 CONTROL REGISTER
-     *
-     * MSB
-     * 0-0------0001-0-
-     * | |      |||| |
-     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
-     * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
-     * | |      |++------ TCKPS: Input prescaler 1:1.
-     * | |      +-------- TGATE: Gated time accumulation is disabled.
-     * | +--------------- TSIDL  Continues module operation in Idle mode.
-     * +----------------- TON:   Stops 16-bit Timerx.
-     */
-    T4CON = 1 << _T4CON_T32_POSITION;
+  /* Ignore edges until the frame is over. */
+  IEC0bits.IC2IE = OFF;
+  IFS0bits.IC2IF = OFF;
+}
 
-    /* Clear timer 4 register. */
-    TMR4 = 0;
+void __attribute__((interrupt, no_auto_psv)) _T4Interrupt(void) {
+  bool level;
 
-    /* Clear timer 3 holding register. */
-    TMR3HLD = 0;
+  IFS1bits.T4IF = OFF;
 
-    /*
-     * T2CON: TIMER2 CONTROL REGISTER
-     *
-     * MSB
-     * 0-0------0001-0-
-     * | |      |||| |
-     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
-     * | |      |||+----- T32:   Timerx and Timery form a single 32-bit timer.
-     * | |      |++------ TCKPS: Input prescaler 1:1.
-     * | |      +-------- TGATE: Gated time accumulation is disabled.
-     * | +--------------- TSIDL  Continues module operation in Idle mode.
-     * +----------------- TON:   Stops 16-bit Timerx.
-     */
-    T2CON = 1 << _T2CON_T32_POSITION;
+  level = (BP_MOSI == HIGH) != uart_soft_receiver.inverted;
 
-    /* Clear timer 2 register. */
-    TMR2 = 0;
+  if (uart_soft_receiver.bit_index == 0) {
+    PR4 = uart_soft_receiver.bit_ticks - 1;
+  }
 
-    if (!quiet) {
-      BPMSG1281;
+  if (uart_soft_receiver.bit_index < uart_soft_receiver.frame_bits) {
+    if (level) {
+      uart_soft_receiver.value |= 1 << uart_soft_receiver.bit_index;
     }
-
-    return 0;
+    uart_soft_receiver.bit_index++;
+    return;
   }
 
-  for (samples = 0; samples < UART_BAUD_RATE_CALCULATION_SAMPLES; samples++) {
+  /* This is the stop bit. */
+  T4CONbits.TON = OFF;
 
-    /* Wait for activity. */
-    while (BP_MISO == LOW) {
+  {
+    uint8_t flags;
+    uint8_t data;
+
+    flags = UART_SNIFFER_FLAG_MOSI;
+    data = LO8(uart_soft_receiver.value);
+
+    if (!level) {
+      flags |= UART_SNIFFER_FLAG_FRAMING_ERROR;
     }
 
-    /* Start counting. */
-    T4CONbits.TON = ON;
-    T2CONbits.TON = ON;
+    switch (uart_settings.databits_parity) {
+    case 0b01:
+      /* Even parity, the parity bit makes the count of set bits even. */
+      if (uart_odd_parity(data) != ((uart_soft_receiver.value >> 8) & 1)) {
+        flags |= UART_SNIFFER_FLAG_PARITY_ERROR;
+      }
+      break;
 
-    /* Wait for line to go down. */
-    while (BP_MISO == HIGH) {
+    case 0b10:
+      /* Odd parity, the parity bit makes the count of set bits odd. */
+      if (uart_odd_parity(data) == ((uart_soft_receiver.value >> 8) & 1)) {
+        flags |= UART_SNIFFER_FLAG_PARITY_ERROR;
+      }
+      break;
+
+    case 0b11:
+      if (uart_soft_receiver.value & 0x100) {
+        flags |= UART_SNIFFER_FLAG_NINTH_BIT;
+      }
+      break;
+
+    default:
+      break;
     }
 
-    /* Stop counting. */
-    T2CONbits.TON = OFF;
-    T4CONbits.TON = OFF;
+    uart_sniffer_push(flags, data);
+  }
 
-    /* Neuter Timer2. */
-    RPINR3bits.T2CKR = 0b011111;
+  /* Wait for the next start bit. */
+  while (UART_IC2_BUFFER_NOT_EMPTY == ON) {
+    (void)IC2BUF;
+  }
+  IFS0bits.IC2IF = OFF;
+  IEC0bits.IC2IE = ON;
+}
 
-    /* Stop timers. */
+void __attribute__((interrupt, no_auto_psv)) _U2RXInterrupt(void) {
+  IFS1bits.U2RXIF = OFF;
 
-    /*
-     * T4CON: TIMER4 CONTROL REGISTER
-     *
-     * MSB
-     * 0-0------0000-0-
-     * | |      |||| |
-     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
-     * | |      |||+----- T32:   Timerx and Timery act as 2 16-bit timers.
-     * | |      |++------ TCKPS: Input prescaler 1:1.
-     * | |      +-------- TGATE: Gated time accumulation is disabled.
-     * | +--------------- TSIDL  Continues module operation in Idle mode.
-     * +----------------- TON:   Stops 16-bit Timerx.
-     */
-    T4CON = 0;
+  while (U2STAbits.URXDA == ON) {
+    uint8_t value;
+    uint16_t next;
 
-    /*
-     * T2CON: TIMER2 CONTROL REGISTER
-     *
-     * MSB
-     * 0-0------0000-0-
-     * | |      |||| |
-     * | |      |||| +--- TCS:   Internal clock (FOSC/2)
-     * | |      |||+----- T32:   Timerx and Timery act as 2 16-bit timers.
-     * | |      |++------ TCKPS: Input prescaler 1:1.
-     * | |      +-------- TGATE: Gated time accumulation is disabled.
-     * | +--------------- TSIDL  Continues module operation in Idle mode.
-     * +----------------- TON:   Stops 16-bit Timerx.
-     */
-    T2CON = 0;
+    if (uart_sniffing) {
+      uint8_t flags;
+      uint16_t word;
 
-    /* Get the smallest timing value after the first one. */
+      flags = 0;
+      if (U2STAbits.PERR) {
+        flags |= UART_SNIFFER_FLAG_PARITY_ERROR;
+        bp_notify(BP_NOTIFICATION_ERROR);
+      }
+      if (U2STAbits.FERR) {
+        flags |= UART_SNIFFER_FLAG_FRAMING_ERROR;
+        bp_notify(BP_NOTIFICATION_ERROR);
+      }
+      word = U2RXREG;
+      if (word & 0x100) {
+        flags |= UART_SNIFFER_FLAG_NINTH_BIT;
+      }
+      uart_sniffer_push(flags, LO8(word));
+      continue;
+    }
 
-    current_sample = ((uint32_t)TMR3HLD << 16) | TMR2;
-    if ((samples > 0) && ((bit_sample == 0) || (bit_sample > current_sample))) {
-      bit_sample = current_sample;
+    /* Error bits refer to the byte at the top of the FIFO. */
+    if (U2STAbits.PERR) {
+      uart_receive_errors |= UART_RECEIVE_ERROR_PARITY;
+      bp_notify(BP_NOTIFICATION_ERROR);
+    }
+    if (U2STAbits.FERR) {
+      uart_receive_errors |= UART_RECEIVE_ERROR_FRAMING;
+      bp_notify(BP_NOTIFICATION_ERROR);
     }
-  }
 
-  /* Neuter Timer2. */
-  RPINR3bits.T2CKR = 0b011111;
+    value = U2RXREG;
+    next = (uart_receive_ring.head + 1) & UART_RING_MASK;
+    if (next == uart_receive_ring.tail) {
+      uart_receive_errors |= UART_RECEIVE_ERROR_RING_OVERFLOW;
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_OVERFLOWS);
+      bp_notify(BP_NOTIFICATION_OVERFLOW);
+      continue;
+    }
 
-  /* Clear timer 2 register. */
-  TMR2 = 0;
+    uart_receive_ring.buffer[uart_receive_ring.head] = value;
+    uart_receive_ring.head = next;
+    BP_TELEMETRY_HIGH_WATER(BP_TELEMETRY_UART_RING_HIGH_WATER,
+                            (next - uart_receive_ring.tail) & UART_RING_MASK);
 
-  /* Clear timer 3 holding register. */
-  TMR3HLD = 0;
+    /* Ask the other side to pause well before the ring fills up. */
+    if (uart_settings.flow_control &&
+        (((next - uart_receive_ring.tail) & UART_RING_MASK) >=
+         UART_RING_HIGH_WATERMARK)) {
+      BP_CLK = HIGH;
+    }
+  }
 
-  bit_sample = FCY / bit_sample;
+  /* The FIFO is empty now, clearing the flag cannot drop anything else. */
+  if (U2STAbits.OERR) {
+    U2STAbits.OERR = OFF;
+    BP_TELEMETRY_COUNT(BP_TELEMETRY_UART_OVERRUNS);
+    bp_notify(BP_NOTIFICATION_OVERFLOW);
+    uart_receive_errors |= UART_RECEIVE_ERROR_OVERRUN;
+    uart_sniffer_overflow = true;
+  }
+}
 
-  if (!quiet) {
-    if (bit_sample > 150000) {
-      BPMSG1282;
-    } else {
-      BPMSG1283;
-      bp_write_dec_dword(bit_sample);
-      BPMSG1285;
-      BPMSG1284;
-      bp_write_dec_dword(uart_get_closest_common_rate(bit_sample));
-      BPMSG1285;
-    }
+void __attribute__((interrupt, no_auto_psv)) _U2TXInterrupt(void) {
+  IFS1bits.U2TXIF = OFF;
+
+  while ((U2STAbits.UTXBF == OFF) &&
+         (uart_transmit_ring.tail != uart_transmit_ring.head)) {
+    U2TXREG = uart_transmit_ring.buffer[uart_transmit_ring.tail];
+    uart_transmit_ring.tail = (uart_transmit_ring.tail + 1) & UART_RING_MASK;
   }
 
-  return bit_sample;
+  if (uart_transmit_ring.tail == uart_transmit_ring.head) {
+    IEC1bits.U2TXIE = OFF;
+  }
 }
 
 /*
@@ -692,7 +2494,16 @@ peripheral settings
 # 00000001 � mode version string (ART1)
 # 00000010 � UART start echo uart RX
 # 00000011 � UART stop echo uart RX
+# 00000100 - UART RX streaming in blocks, 1 byte flags (any byte to stop)
+# 00000101 - UART baud rate detection, sets U2BRG and reports the rates
+# 00000110 - UART sniffer, timestamped records for MISO and MOSI (any byte to
+stop)
 # 00000111 - UART speed manual config, 2 bytes (BRGH, BRGL)
+# 00001000 - UART RTS/CTS flow control, 1 byte flags (RTS on CLK, CTS on CS)
+# 00001001 - UART watch, only send lines matching some patterns (any byte to
+stop)
+# 00001010 - UART sniffer starting on a byte pattern (any byte to stop)
+# 00001011 - telemetry counters, 1 byte flags
 # 00001111 - bridge mode (reset to exit)
 # 0001xxxx � Bulk transfer, send 1-16 bytes (0=1byte!)
 # 0100wxyz � Set peripheral w=power, x=pullups, y=AUX, z=CS
@@ -714,6 +2525,7 @@ void binUART(void) {
   mode_configuration.high_impedance = ON;
   brg_value = UART_BRG_SPEED[0]; // start at 300bps
   uart_settings.echo_uart = OFF;
+  uart_settings.flow_control = OFF;
   uart2_setup(brg_value, mode_configuration.high_impedance,
               uart_settings.receive_polarity, uart_settings.databits_parity,
               uart_settings.stop_bits);
@@ -730,19 +2542,26 @@ void binUART(void) {
         uart2_rx();
       }
     }
-    
-    U2STAbits.OERR = OFF;
+
+    if (U2STAbits.OERR) {
+      BP_TELEMETRY_COUNT(BP_TELEMETRY_UART_OVERRUNS);
+      U2STAbits.OERR = OFF;
+    }
 
     if (!user_serial_ready_to_read()) {
       continue;
     }
 
     input_byte = user_serial_read_byte();
+    BP_FLIGHT_RECORDER_LOG(BP_FLIGHT_RECORDER_MODE_UART, input_byte, 0,
+                           BP_FLIGHT_RECORDER_NO_STATUS);
 
     switch (input_byte & 0xF0) {
     case 0:
       switch (input_byte) {
       case 0:
+        uart_settings.flow_control = OFF;
+        uart_flow_control_apply();
         uart2_disable();
         return;
 
@@ -760,6 +2579,34 @@ void binUART(void) {
         uart_settings.echo_uart = OFF;
         REPORT_IO_SUCCESS();
         break;
+
+      case UART_BINARY_IO_STREAM_RECEIVE:
+        uart_binary_io_stream_receive();
+        break;
+
+      case UART_BINARY_IO_DETECT_BAUD_RATE:
+        brg_value = uart_binary_io_detect_baud_rate(brg_value);
+        break;
+
+      case UART_BINARY_IO_SNIFFER:
+        uart_binary_io_sniffer();
+        break;
+
+      case UART_BINARY_IO_FLOW_CONTROL:
+        uart_binary_io_flow_control();
+        break;
+
+      case UART_BINARY_IO_WATCH:
+        uart_binary_io_watch();
+        break;
+
+      case UART_BINARY_IO_TRIGGERED_SNIFFER:
+        uart_binary_io_triggered_sniffer();
+        break;
+
+      case UART_BINARY_IO_TELEMETRY:
+        bp_binary_io_send_telemetry();
+        break;
         
       case 7:
         REPORT_IO_SUCCESS();
@@ -771,28 +2618,17 @@ void binUART(void) {
                     uart_settings.receive_polarity,
                     uart_settings.databits_parity, uart_settings.stop_bits);
         uart2_enable();
+        uart_flow_control_apply();
         REPORT_IO_SUCCESS();
         break;
         
       case 15:
-        REPORT_IO_SUCCESS();
-        U2STAbits.OERR = OFF;
-        for (;;) {
-
-#ifdef BUSPIRATEV4
-          if (U2STAbits.URXDA == ON) {
-            user_serial_transmit_character(U2RXREG);
-          }
-#else
-          if ((U2STAbits.URXDA == 1) && (U1STAbits.UTXBF == 0)) {
-            U1TXREG = U2RXREG;
-          }
-#endif /* BUSPIRATEV4 */
-          
-          if (user_serial_ready_to_read() && (U2STAbits.UTXBF == 0)) {
-            U2TXREG = user_serial_read_byte();
-          }
+        if (!uart_interrupts_start()) {
+          REPORT_IO_FAILURE();
+          break;
         }
+        REPORT_IO_SUCCESS();
+        uart_run_bridge(false);
         break;
         
       default:
@@ -837,6 +2673,7 @@ void binUART(void) {
                   uart_settings.receive_polarity, uart_settings.databits_parity,
                   uart_settings.stop_bits);
       uart2_enable();
+      uart_flow_control_apply();
       REPORT_IO_SUCCESS();
       break;
       
@@ -866,6 +2703,7 @@ void binUART(void) {
                   uart_settings.receive_polarity, uart_settings.databits_parity,
                   uart_settings.stop_bits);
       uart2_enable();
+      uart_flow_control_apply();
       REPORT_IO_SUCCESS();
       break;
 
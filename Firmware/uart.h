@@ -23,6 +23,7 @@
 #ifdef BP_ENABLE_UART_SUPPORT
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 void uartProcess(void);
@@ -44,11 +45,29 @@ uint16_t uart_read(void);
  */
 uint16_t uart_write(const uint16_t value);
 
+/**
+ * Writes the given bytes to the UART.
+ *
+ * @param[in] buffer the bytes to write.
+ * @param[in] length how many bytes to write.
+ */
+void uart_send_buffer(const uint8_t *buffer, const size_t length);
+
 /**
  * Cleans up the state of the UART module once its operations are done.
  */
 void uart_cleanup(void);
 
+/**
+ * Stops buffering UART2 reception for the terminal live display, if it was
+ * running, and gives its ring back to the buffer arena.
+ *
+ * Must be called before the buffer arena is released as a whole, as the RX
+ * interrupt handler would otherwise keep writing into memory it no longer
+ * owns.
+ */
+void uart_terminal_receive_stop(void);
+
 /**
  * Starts UART operations.
  */
@@ -14,23 +14,9 @@
 
 #include "serial.h"
 #include "buspirate.h"
+#include "xsvfplay.h"
 
 
-#define  JTAG_RESET        0x01
-#define  JTAG_CHAIN_SCAN   0x02
-#define  XSVF_PLAYER       0x03
-
-
-#define XSVF_ERROR_NONE            0x00
-#define XSVF_ERROR_UNKNOWN         0x01
-#define XSVF_ERROR_TDOMISMATCH     0x02
-#define XSVF_ERROR_MAXRETRIES      0x03
-#define XSVF_ERROR_ILLEGALCMD      0x04
-#define XSVF_ERROR_ILLEGALSTATE    0x05
-#define XSVF_ERROR_DATAOVERFLOW    0x06
-#define XSVF_ERROR_LAST            0x07
-#define XSVF_READY_FOR_DATA        0xFF
-
 #ifndef WIN32
 //#define usleep(x) Sleep(x);
 #define Sleep(x) usleep(x);
@@ -44,11 +30,8 @@ HANDLE dumphandle;
 #endif
 
 int modem =FALSE;
-int cnt=0;
-uint8_t *bin_buf;
-uint32_t bin_buf_size;
 #define FREE(x) if(x) free(x);
-#define MAX_BUFFER 4096  //255 bytes
+#define MAX_BUFFER 2048  //chain scan reply buffer
 
 //http://www.whereisian.com/files/j-xsvf_002.swf
 
@@ -81,31 +64,16 @@ int main(int argc, char** argv)
 	int opt;
 	uint8_t buffer[MAX_BUFFER]={0};
 	uint8_t temp[2]={0};  // command buffer
-//	struct stat stbuf;
 	int fd,timeout_counter;
-	int res,c, nparam_bytechunks, bytePointer, readSize;
-	long fileSize;
-	FILE *XSVF;
-//	int  xsvf;
-    int timer_out=0;
+	int res,c,chunk;
+	int result=-1;
+	struct xsvf_image image;
 	char *param_port = NULL;
 	char *param_speed = NULL;
 	char *param_XSVF=NULL;
-	char *param_bytechunks=NULL;
 	int  jtag_reset=FALSE;
     int  chainscan=FALSE;
 
-    const char *XSVF_ERROR[]={  "XSVF_ERROR_NONE",
-                                "XSVF_ERROR_UNKNOWN",
-                                "XSVF_ERROR_TDOMISMATCH",
-                                "XSVF_ERROR_MAXRETRIES",
-                                "XSVF_ERROR_ILLEGALCMD",
-                                "XSVF_ERROR_ILLEGALSTATE",
-                                "XSVF_ERROR_DATAOVERFLOW",
-                                "XSVF_ERROR_LAST",
-                                "XSVF_READY_FOR_DATA",
-                                 0 };
-
 	printf("-----------------------------------------------------------------------------\n");
 	printf("\n");
 	printf(" BusPirate XSVF Player V.01\n");
@@ -169,8 +137,6 @@ int main(int argc, char** argv)
 		exit(-1);
 	}
 
-    nparam_bytechunks=MAX_BUFFER;
-
 	if (param_speed==NULL) {
 		param_speed=strdup("115200");  //default is 115200kbps
 	}
@@ -225,147 +191,31 @@ int main(int argc, char** argv)
 		}
 	}
 
-   if (param_XSVF !=NULL) {
-		//open the XSVF file
-            XSVF = fopen(param_XSVF, "rb");
-            if (XSVF == NULL) {
-                printf(" Error opening file\n");
-            }
-            fseek(XSVF, 0, SEEK_END);
-            fileSize = ftell(XSVF);
-            fseek(XSVF, 0, SEEK_SET);
-            printf(" File is %lu bytes, ",fileSize);
-
-            bin_buf = (uint8_t*)malloc(fileSize);
-            if (bin_buf == NULL) {
-               printf(" Error allocating %ld bytes of memory\n", (long)fileSize);
-               return -1;
-            }
-            memset(bin_buf, 0, fileSize);
-
-            res = fread(bin_buf, sizeof(uint8_t), fileSize, XSVF);
-            if (res <= 0) {
-                printf(" Error reading file %s \n", param_XSVF);
-            }
-            printf(" Read %i bytes\n",res);
-
-            fclose(XSVF);
-
-
-	} else {
+	if (param_XSVF == NULL) {
 		printf(" No file specified. Need an input xsvf file \n");
 		exit(-1);
 	}
+	if (xsvf_map(param_XSVF, &image) < 0) {
+		printf(" Error opening file %s \n", param_XSVF);
+		exit(-1);
+	}
+	printf(" File is %ld bytes\n", image.size);
 	printf(" Opening Bus Pirate on %s at %sbps, using XSVF file %s \n", param_port, param_speed,param_XSVF);
 
+	chunk = xsvf_chunk_size(fd);
+	printf(" Sending the file in chunks of %i bytes\n", chunk);
+
 	// Enter XSVF Player Mode
-	//Open the port and send 0x03 to enter XSVF player mode
+	// Send 0x03, then answer 0xFF data requests until a result code comes back
 	printf(" Entering XSVF Player Mode\n");
-	temp[0]=0x03;
-	serial_write( fd, (char *)temp, 1 );
-
-	// Wait for 0xFF, if <0xFF then it is finished or error codes (see below)
-    bytePointer=0; //where we are in the byte buffer array
-    readSize=MAX_BUFFER; //hack this to be a full chunk
-    cnt=0;
-    printf(" Waiting for first data request...");
-	while(1) {
-
-            //wait for reply before sending the next chunks
-			timeout_counter=0;
-			timer_out=0;   // 0 if ok, else -1 if exit
-			while(1) {
-				res= serial_read(fd, (char *)buffer, sizeof(buffer));
-				if(res>0){
-                    printf("ok\n");
-				  // wait for 0xFF and send data, or error
-					if ((buffer[0]!=XSVF_READY_FOR_DATA) || (fileSize==0)) {
-					    c=buffer[0];
-					    if (c==0xFF)
-					         c=8;
-                        printf(" End of operation reply: %s \n",XSVF_ERROR[c]);
-                        switch (buffer[0]) {
-                            case  XSVF_ERROR_NONE :
-                                printf(" Success!\n");
-                                break;
-                            case XSVF_ERROR_UNKNOWN:
-                             printf(" Unknown error: XSVF_ERROR_UNKNOWN \n");
-                                break;
-                            case XSVF_ERROR_TDOMISMATCH:
-                             printf(" Device did not respond as expected: XSVF_ERROR_TDOMISMATCH \n");
-                                break;
-                            case XSVF_ERROR_MAXRETRIES:
-                             printf(" Device did not respond: XSVF_ERROR_MAXRETRIES \n");
-                                break;
-                            case XSVF_ERROR_ILLEGALCMD :
-                             printf(" Unknown XSVF command: XSVF_ERROR_ILLEGALCMD \n");
-                                break;
-                            case XSVF_ERROR_ILLEGALSTATE:
-                             printf(" Unknown JTAG state: XSVF_ERROR_ILLEGALSTATE \n");
-                                break;
-                            case XSVF_ERROR_DATAOVERFLOW :
-                             printf(" Error, data overflow: XSVF_ERROR_DATAOVERFLOW \n");
-                                break;
-                            case XSVF_ERROR_LAST:
-                             printf(" Some other error I don't remember, probably isn't active: XSVF_ERROR_LAST \n");
-                                break;
-                            case XSVF_READY_FOR_DATA:
-                                if (fileSize==0) {
-                                    printf(" End of file reached. \n");
-                                } else {
-									printf(" Programmer says more data: XSVF_READY_FOR_DATA \n");
-                                }
-                                break;
-                            default:
-                             printf(" Unknown error\n ");
-
-                         }
-
-                     }
-                     break; //break loop and send data
-				}else{
-					printf("\n Waiting for reply...");
-				//	Sleep(1);
-					timeout_counter++;
-					if(timeout_counter > 4){
-						printf("\n No reply.... Quitting.\n ");
-						timeout_counter=0;
-						timer_out=-1;
-						break;
-					}
-				}
-			}
-            if (fileSize==0) {
-			       break;
-			}
-
-            if (timer_out==-1)
-                break;
-            //send data
-            if(fileSize<MAX_BUFFER){
-                readSize=fileSize;
-            }
-			//send to bp
-			temp[0]=(readSize>>8);
-			temp[1]=readSize;
-			cnt=cnt+readSize;
-
-			printf(" Sending %i Bytes (%04X)...",readSize, cnt);
-			serial_write( fd, (char *)temp,2 );
-			serial_write( fd, (char *) &bin_buf[bytePointer],readSize );
-			bytePointer=bytePointer+readSize;//start 1 chunk in next itme
-			fileSize=fileSize-readSize; //deincrement the remaining byte count
-
-	}
+	result = xsvf_play(fd, &image, chunk);
+	xsvf_print_result(result);
 
     printf(" Thank you for playing! :-)\n\n");
-#ifdef WIN32
-    fclose(XSVF);
+	xsvf_unmap(&image);
+	serial_close(fd);
 	FREE(param_port);
- 	FREE(param_speed);
-    FREE(param_bytechunks);
-    FREE(param_XSVF);
-    FREE( bin_buf);
-#endif
-    return 0;
+	FREE(param_speed);
+	FREE(param_XSVF);
+	return (result == XSVF_ERROR_NONE) ? 0 : -1;
  }  //end main()
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "serial.h"
+#include "xsvfplay.h"
+
+#define XSVF_QUERY_TIMEOUT 100 //ms, old firmware does not answer the size query
+
+static const char *XSVF_ERROR[] = {
+	"XSVF_ERROR_NONE",
+	"XSVF_ERROR_UNKNOWN",
+	"XSVF_ERROR_TDOMISMATCH",
+	"XSVF_ERROR_MAXRETRIES",
+	"XSVF_ERROR_ILLEGALCMD",
+	"XSVF_ERROR_ILLEGALSTATE",
+	"XSVF_ERROR_DATAOVERFLOW",
+	"XSVF_ERROR_LAST",
+	"XSVF_READY_FOR_DATA",
+};
+
+int xsvf_map(const char *path, struct xsvf_image *image)
+{
+	image->data = NULL;
+	image->size = 0;
+#ifdef WIN32
+	image->mapping = NULL;
+	image->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (image->file == INVALID_HANDLE_VALUE)
+		return -1;
+	image->size = (long)GetFileSize(image->file, NULL);
+	if (image->size == 0)
+		return 0;
+	image->mapping = CreateFileMapping(image->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (image->mapping == NULL) {
+		xsvf_unmap(image);
+		return -1;
+	}
+	image->data = (const uint8_t *)MapViewOfFile(image->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (image->data == NULL) {
+		xsvf_unmap(image);
+		return -1;
+	}
+#else
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+	image->size = (long)st.st_size;
+	if (image->size == 0) {
+		close(fd);
+		return 0;
+	}
+	data = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return -1;
+	// the file goes out front to back exactly once
+	madvise(data, image->size, MADV_SEQUENTIAL);
+	image->data = (const uint8_t *)data;
+#endif
+	return 0;
+}
+
+void xsvf_unmap(struct xsvf_image *image)
+{
+#ifdef WIN32
+	if (image->data != NULL)
+		UnmapViewOfFile((LPCVOID)image->data);
+	if (image->mapping != NULL)
+		CloseHandle(image->mapping);
+	if (image->file != INVALID_HANDLE_VALUE)
+		CloseHandle(image->file);
+	image->mapping = NULL;
+	image->file = INVALID_HANDLE_VALUE;
+#else
+	if (image->data != NULL)
+		munmap((void *)image->data, image->size);
+#endif
+	image->data = NULL;
+	image->size = 0;
+}
+
+/*
+ * Ask the firmware how large a chunk it takes. Firmware from before the
+ * query ignores it, then the chunk size it was built with is assumed.
+ */
+int xsvf_chunk_size(int fd)
+{
+	uint8_t reply[2];
+	char cmd = XSVF_CHUNK_SIZE_QUERY;
+	int chunk;
+#ifndef WIN32
+	struct timeval timeout;
+	fd_set readable;
+#endif
+
+	serial_write(fd, &cmd, 1);
+#ifndef WIN32
+	// serial_read() waits SERIAL_READ_TIMEOUT per empty read
+	FD_ZERO(&readable);
+	FD_SET(fd, &readable);
+	timeout.tv_sec = 0;
+	timeout.tv_usec = XSVF_QUERY_TIMEOUT * 1000;
+	if (select(fd + 1, &readable, NULL, NULL, &timeout) <= 0)
+		return XSVF_CHUNK_DEFAULT;
+#endif
+	if (serial_read(fd, (char *)reply, sizeof(reply)) != sizeof(reply))
+		return XSVF_CHUNK_DEFAULT;
+
+	chunk = (reply[0] << 8) | reply[1];
+	if (chunk == 0)
+		return XSVF_CHUNK_DEFAULT;
+	return chunk;
+}
+
+/*
+ * Play the image and return the result code the firmware ends with, or -1
+ * if it stopped answering. The next chunk is staged in the send buffer
+ * while the firmware works on the current one, so each request is answered
+ * by a single write as soon as it comes in.
+ */
+int xsvf_play(int fd, const struct xsvf_image *image, int chunk)
+{
+	uint8_t *block;
+	uint8_t reply;
+	long offset = 0;
+	int length, retries = 0;
+	int sent_end = 0;
+	char cmd = XSVF_PLAYER;
+
+	if (chunk > XSVF_CHUNK_MAX)
+		chunk = XSVF_CHUNK_MAX;
+	block = (uint8_t *)malloc(XSVF_CHUNK_HEADER + chunk);
+	if (block == NULL) {
+		printf(" Error allocating %i bytes of memory\n", XSVF_CHUNK_HEADER + chunk);
+		return -1;
+	}
+
+	length = (image->size < chunk) ? (int)image->size : chunk;
+	block[0] = length >> 8;
+	block[1] = length;
+	if (length > 0)
+		memcpy(&block[XSVF_CHUNK_HEADER], image->data, length);
+
+	serial_write(fd, &cmd, 1);
+	printf(" Waiting for first data request...\n");
+
+	for (;;) {
+		// one byte at a time, a data request can come right before the result
+		if (serial_read(fd, (char *)&reply, 1) <= 0) {
+			if (++retries >= XSVF_REPLY_RETRIES) {
+				printf("\n No reply.... Quitting.\n");
+				free(block);
+				return -1;
+			}
+			printf("\n Waiting for reply...");
+			continue;
+		}
+		retries = 0;
+
+		// a request after the empty chunk is a result of its own
+		if (reply != XSVF_READY_FOR_DATA || sent_end)
+			break;
+
+		serial_write(fd, (char *)block, XSVF_CHUNK_HEADER + length);
+		offset += length;
+		if (length == 0) {
+			sent_end = 1;
+			printf("\n End of file reached, waiting for result...\n");
+			continue;
+		}
+		printf("\r Sent %ld of %ld bytes", offset, image->size);
+		fflush(stdout);
+
+		length = (image->size - offset < chunk) ? (int)(image->size - offset) : chunk;
+		block[0] = length >> 8;
+		block[1] = length;
+		if (length > 0)
+			memcpy(&block[XSVF_CHUNK_HEADER], &image->data[offset], length);
+	}
+
+	free(block);
+	return reply;
+}
+
+void xsvf_print_result(int result)
+{
+	int c;
+
+	if (result < 0)
+		return;
+	if (result > XSVF_ERROR_LAST && result != XSVF_READY_FOR_DATA) {
+		printf(" Unknown error\n ");
+		return;
+	}
+	c = (result == XSVF_READY_FOR_DATA) ? 8 : result;
+	printf(" End of operation reply: %s \n", XSVF_ERROR[c]);
+	switch (result) {
+		case XSVF_ERROR_NONE:
+			printf(" Success!\n");
+			break;
+		case XSVF_ERROR_UNKNOWN:
+			printf(" Unknown error: XSVF_ERROR_UNKNOWN \n");
+			break;
+		case XSVF_ERROR_TDOMISMATCH:
+			printf(" Device did not respond as expected: XSVF_ERROR_TDOMISMATCH \n");
+			break;
+		case XSVF_ERROR_MAXRETRIES:
+			printf(" Device did not respond: XSVF_ERROR_MAXRETRIES \n");
+			break;
+		case XSVF_ERROR_ILLEGALCMD:
+			printf(" Unknown XSVF command: XSVF_ERROR_ILLEGALCMD \n");
+			break;
+		case XSVF_ERROR_ILLEGALSTATE:
+			printf(" Unknown JTAG state: XSVF_ERROR_ILLEGALSTATE \n");
+			break;
+		case XSVF_ERROR_DATAOVERFLOW:
+			printf(" Error, data overflow: XSVF_ERROR_DATAOVERFLOW \n");
+			break;
+		case XSVF_ERROR_LAST:
+			printf(" Some other error I don't remember, probably isn't active: XSVF_ERROR_LAST \n");
+			break;
+		case XSVF_READY_FOR_DATA:
+			printf(" Programmer says more data: XSVF_READY_FOR_DATA \n");
+			break;
+		default:
+			printf(" Unknown error\n ");
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+/*
+ * XSVF player core, shared by BPXSVFPlayer and BP4_XSVFplayer_Win
+ *
+ * The firmware asks for the file in chunks: it sends 0xFF, we answer with
+ * a 16-bit byte count (MSB first) and that many bytes, a zero count marks
+ * the end of the file. It double buffers, so the next request comes as soon
+ * as a chunk starts playing and is answered straight from the mapped file.
+ */
+#ifndef XSVFPLAY_H_
+#define XSVFPLAY_H_
+
+#include <stdint.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#define JTAG_RESET            0x01
+#define JTAG_CHAIN_SCAN       0x02
+#define XSVF_PLAYER           0x03
+#define XSVF_CHUNK_SIZE_QUERY 0x05
+
+#define XSVF_ERROR_NONE            0x00
+#define XSVF_ERROR_UNKNOWN         0x01
+#define XSVF_ERROR_TDOMISMATCH     0x02
+#define XSVF_ERROR_MAXRETRIES      0x03
+#define XSVF_ERROR_ILLEGALCMD      0x04
+#define XSVF_ERROR_ILLEGALSTATE    0x05
+#define XSVF_ERROR_DATAOVERFLOW    0x06
+#define XSVF_ERROR_LAST            0x07
+#define XSVF_READY_FOR_DATA        0xFF
+
+#define XSVF_CHUNK_HEADER  2
+#define XSVF_CHUNK_DEFAULT 2048   //what firmware without the size query takes
+#define XSVF_CHUNK_MAX     0xFFFF //largest count the header can carry
+#define XSVF_REPLY_RETRIES 5      //empty reads before giving up on the player
+
+struct xsvf_image {
+	const uint8_t *data;
+	long size;
+#ifdef WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+int xsvf_map(const char *path, struct xsvf_image *image);
+void xsvf_unmap(struct xsvf_image *image);
+int xsvf_chunk_size(int fd);
+int xsvf_play(int fd, const struct xsvf_image *image, int chunk);
+void xsvf_print_result(int result);
+
+#endif
@@ -0,0 +1,146 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+XSVF packer for the Bus Pirate XSVF player.
+
+Turns an .xsvf file made by SVF2XSVF into a smaller .xsvz file, which the
+firmware unpacks on the fly while playing it (BP_JTAG_XSVF_COMPRESSION).
+The player host program sends it exactly like a plain XSVF file.
+
+Bitstreams are mostly long runs of 0x00/0xFF and repeated TDO masks, so a
+simple run length / back reference scheme already shrinks them several times
+without needing more than a 256 byte window on the device.
+
+Format: the "XSVZ" magic, then tokens:
+
+	0x00-0x7F  n+1 literal bytes follow
+	0x80-0xBF  one byte follows, repeated (n & 0x3F)+3 times
+	0xC0-0xFF  one byte d follows, copy (n & 0x3F)+3 bytes starting d+1
+	           bytes back in the decoded stream (copies may overlap)
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import optparse
+import sys
+
+MAGIC = b"XSVZ"
+
+LITERAL_MAXIMUM = 0x80
+MINIMUM_MATCH = 3
+MAXIMUM_MATCH = 0x3F + MINIMUM_MATCH
+WINDOW = 256
+
+REPEAT_TOKEN = 0x80
+COPY_TOKEN = 0xC0
+
+def run_length(data, position):
+	limit = min(len(data), position + MAXIMUM_MATCH)
+	end = position + 1
+	while end < limit and data[end] == data[position]:
+		end += 1
+	return end - position
+
+def best_copy(data, position):
+	"""Longest match in the window, as (length, distance)."""
+	best = (0, 0)
+	limit = min(len(data) - position, MAXIMUM_MATCH)
+	for distance in range(1, min(position, WINDOW) + 1):
+		start = position - distance
+		length = 0
+		while length < limit and data[start + length] == data[position + length]:
+			length += 1
+		if length > best[0]:
+			best = (length, distance)
+			if length == limit:
+				break
+	return best
+
+def compress(data):
+	output = bytearray(MAGIC)
+	literals = bytearray()
+
+	def flush_literals():
+		while literals:
+			chunk = literals[:LITERAL_MAXIMUM]
+			output.append(len(chunk) - 1)
+			output.extend(chunk)
+			del literals[:LITERAL_MAXIMUM]
+
+	position = 0
+	while position < len(data):
+		run = run_length(data, position)
+		(copy, distance) = best_copy(data, position)
+		if run >= MINIMUM_MATCH and run >= copy:
+			flush_literals()
+			output.append(REPEAT_TOKEN | (run - MINIMUM_MATCH))
+			output.append(data[position])
+			position += run
+		elif copy >= MINIMUM_MATCH:
+			flush_literals()
+			output.append(COPY_TOKEN | (copy - MINIMUM_MATCH))
+			output.append(distance - 1)
+			position += copy
+		else:
+			literals.append(data[position])
+			position += 1
+	flush_literals()
+	return bytes(output)
+
+def decompress(data):
+	if not data.startswith(MAGIC):
+		raise ValueError("missing %r magic" % MAGIC)
+	output = bytearray()
+	position = len(MAGIC)
+	while position < len(data):
+		token = data[position]
+		position += 1
+		if token < REPEAT_TOKEN:
+			output.extend(data[position:position + token + 1])
+			position += token + 1
+		elif token < COPY_TOKEN:
+			output.extend(bytes([data[position]]) * ((token & 0x3F) + MINIMUM_MATCH))
+			position += 1
+		else:
+			start = len(output) - data[position] - 1
+			for i in range((token & 0x3F) + MINIMUM_MATCH):
+				output.append(output[start + i])
+			position += 1
+	return bytes(output)
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options] input output", version="%prog 1.0")
+
+	parser.add_option("-d", "--decompress",
+						dest="decompress", default=False, action="store_true",
+						help="Unpack an .xsvz file back to plain XSVF")
+
+	(options, args) = parser.parse_args()
+	if len(args) != 2:
+		parser.error("expected an input and an output file")
+	return (options, args)
+
+if __name__ == '__main__':
+	(options, (source, destination)) = parse_prog_args()
+
+	with open(source, "rb") as f:
+		data = f.read()
+
+	if options.decompress:
+		result = decompress(data)
+	else:
+		result = compress(data)
+		if decompress(result) != data:
+			print("internal error: packed data does not unpack back", file=sys.stderr)
+			sys.exit(1)
+		print("%d -> %d bytes (%.1f%%)" % (len(data), len(result),
+			100.0 * len(result) / len(data) if data else 100.0))
+
+	with open(destination, "wb") as f:
+		f.write(result)
@@ -242,6 +242,36 @@ namespace BusPirateLibCS
             port.WriteByte(b);
         }
 
+        public void Read(byte[] buffer, int offset, int count)
+        {
+            port.Read(buffer, offset, count);
+        }
+
+        public void ExpectRead(byte[] expect)
+        {
+            port.ExpectRead(expect);
+        }
+
+        public void Write(byte[] buffer, int offset, int count)
+        {
+            port.Write(buffer, offset, count);
+        }
+
+        public void BeginBatch()
+        {
+            port.BeginBatch();
+        }
+
+        public void EndBatch()
+        {
+            port.EndBatch();
+        }
+
+        public void Flush()
+        {
+            port.Flush();
+        }
+
         #endregion
 
         #region IDisposable Members
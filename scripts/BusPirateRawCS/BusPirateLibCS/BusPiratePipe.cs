@@ -12,6 +12,18 @@ namespace BusPirateLibCS
         void ExpectReadText(string s);
         void WriteByte(byte b);
 
+        void Read(byte[] buffer, int offset, int count);
+        void ExpectRead(byte[] expect);
+        void Write(byte[] buffer, int offset, int count);
+
+        /// <summary>
+        /// Holds writes back until the matching EndBatch, a read or Flush, so a
+        /// sequence of commands goes out in one serial write. Batches nest.
+        /// </summary>
+        void BeginBatch();
+        void EndBatch();
+        void Flush();
+
         void EnterExclusiveMode();
         void ExitExclusiveMode();
         bool IsInExclusiveMode();
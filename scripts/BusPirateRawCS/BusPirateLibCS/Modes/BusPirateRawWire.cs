@@ -108,15 +108,56 @@ namespace BusPirateLibCS.Modes
             if (data.Length > 16 || data.Length < 1)
                 throw new ArgumentOutOfRangeException("data", "Number of bytes must be between 1 and 16");
 
-            root.WriteByte((byte)(0x10 | (data.Length - 1)));
-            root.ExpectReadByte(0x01);
-            foreach (var b in data)
+            var command = new byte[data.Length + 1];
+            var acks = new byte[data.Length + 1];
+            command[0] = (byte)(0x10 | (data.Length - 1));
+            Array.Copy(data, 0, command, 1, data.Length);
+            for (int i = 0; i < acks.Length; i++)
+                acks[i] = 0x01;
+            root.ExpectRead(acks);
+            root.Write(command, 0, command.Length);
+        }
+
+        /// <summary>
+        /// Writes any number of bytes as a batch of bulk transfers
+        /// </summary>
+        public void WriteBytes(byte[] data)
+        {
+            BeginBatch();
+            try
             {
-                root.WriteByte(b);
-                root.ExpectReadByte(0x01);
+                for (int offset = 0; offset < data.Length; offset += 16)
+                {
+                    var chunk = new byte[Math.Min(16, data.Length - offset)];
+                    Array.Copy(data, offset, chunk, 0, chunk.Length);
+                    WriteBulk(chunk);
+                }
+            }
+            finally
+            {
+                EndBatch();
             }
         }
 
+        /// <summary>
+        /// Commands given until the matching EndBatch go out in one serial
+        /// write; reads and Flush send what was held back so far.
+        /// </summary>
+        public void BeginBatch()
+        {
+            root.BeginBatch();
+        }
+
+        public void EndBatch()
+        {
+            root.EndBatch();
+        }
+
+        public void Flush()
+        {
+            root.Flush();
+        }
+
         public bool Power
         {
             get
@@ -206,6 +247,84 @@ namespace BusPirateLibCS.Modes
 
 
 
+        public enum PicMode : byte
+        {
+            PIC416 = 1,
+            PIC424 = 2,
+            PIC614 = 3,
+        }
+
+        public void SetPicMode(PicMode mode)
+        {
+            root.Write(new byte[] { 0xA0, (byte)mode }, 0, 2);
+            root.ExpectReadByte(0x01);
+        }
+
+        /// <summary>
+        /// Starts a stream of PIC24 ICSP operations, run by the firmware as they
+        /// arrive. Needs PicMode.PIC424 and MSB first bit order.
+        /// </summary>
+        public void BeginPic24Stream()
+        {
+            root.WriteByte(0xA8);
+            root.ExpectReadByte(0x01);
+        }
+
+        public void EndPic24Stream()
+        {
+            root.WriteByte(0x00);
+            root.ExpectReadByte(0x01);
+        }
+
+        /// <summary>
+        /// Queues a SIX with its opcode in natural bit order, then nops NOPs
+        /// </summary>
+        public void Pic24Six(int opcode, int nops)
+        {
+            root.Write(new byte[] { 0x01, (byte)(opcode >> 16), (byte)(opcode >> 8), (byte)opcode, (byte)nops }, 0, 5);
+        }
+
+        /// <summary>
+        /// Queues a REGOUT, its VISI value is fetched with ReadVisi
+        /// </summary>
+        public void Pic24Regout()
+        {
+            root.WriteByte(0x02);
+        }
+
+        /// <summary>
+        /// Reads the answers to the last count queued REGOUTs
+        /// </summary>
+        public int[] ReadVisi(int count)
+        {
+            var buffer = new byte[count * 2];
+            root.Read(buffer, 0, buffer.Length);
+            var values = new int[count];
+            for (int i = 0; i < count; i++)
+                values[i] = (buffer[i * 2] << 8) | buffer[i * 2 + 1];
+            return values;
+        }
+
+        /// <summary>
+        /// Writes one flash row and has the firmware read it back.
+        /// </summary>
+        /// <param name="address">Row address in program memory</param>
+        /// <param name="row">Instructions as 3 bytes each, low byte first</param>
+        /// <param name="groups">Row length in groups of 4 instructions</param>
+        /// <returns>true if the row reads back as written</returns>
+        public bool Pic24ProgramRow(int address, byte[] row, int offset, int groups)
+        {
+            var command = new byte[5 + groups * 12];
+            command[0] = 0x03;
+            command[1] = (byte)(address >> 16);
+            command[2] = (byte)(address >> 8);
+            command[3] = (byte)address;
+            command[4] = (byte)groups;
+            Array.Copy(row, offset, command, 5, groups * 12);
+            root.Write(command, 0, command.Length);
+            return root.ReadByte() == 0x01;
+        }
+
         #region IDisposable Members
 
         public void Dispose()
@@ -223,10 +342,18 @@ namespace BusPirateLibCS.Modes
 
         public void WriteBits(int bits, int number)
         {
-            for (int i = 0; i < number; i++)
+            BeginBatch();
+            try
+            {
+                for (int i = 0; i < number; i++)
+                {
+                    int j = lsbFirst ? i : number - i - 1;
+                    WriteBit((byte)((bits >> j) & 0x01));
+                }
+            }
+            finally
             {
-                int j = lsbFirst ? i : number - i - 1;
-                WriteBit((byte)((bits >> j) & 0x01));
+                EndBatch();
             }
         }
     }
@@ -43,6 +43,45 @@ namespace BusPirateLibCS.Util
         {
             myPort.Close();
             expected.Clear();
+            pending.SetLength(0);
+            batchDepth = 0;
+        }
+
+        /// <summary>
+        /// Bytes written while batching, sent in one go by Flush
+        /// </summary>
+        private MemoryStream pending = new MemoryStream();
+
+        /// <summary>
+        /// Nesting level of BeginBatch calls
+        /// </summary>
+        private int batchDepth = 0;
+
+        /// <summary>
+        /// Batches are sent anyway once they grow this large
+        /// </summary>
+        private const int MAX_PENDING = 4096;
+
+        public void BeginBatch()
+        {
+            batchDepth++;
+        }
+
+        public void EndBatch()
+        {
+            if (batchDepth == 0)
+                throw new InvalidOperationException("Not in a batch");
+            batchDepth--;
+            if (batchDepth == 0)
+                Flush();
+        }
+
+        public void Flush()
+        {
+            if (pending.Length == 0)
+                return;
+            myPort.Write(pending.GetBuffer(), 0, (int)pending.Length);
+            pending.SetLength(0);
         }
 
         /// <summary>
@@ -92,12 +131,19 @@ namespace BusPirateLibCS.Util
 
         public void WriteByte(byte b)
         {
-            myPort.Write(new byte[] { b }, 0, 1);
+            Write(new byte[] { b }, 0, 1);
         }
 
         public void Write(byte[] buffer, int offset, int count)
         {
-            myPort.Write(buffer, offset, count);
+            if (batchDepth == 0)
+            {
+                myPort.Write(buffer, offset, count);
+                return;
+            }
+            pending.Write(buffer, offset, count);
+            if (pending.Length >= MAX_PENDING)
+                Flush();
         }
 
         private const int MAGIC_WAIT_CONSTANT = 0xbadf00d;
@@ -111,8 +157,11 @@ namespace BusPirateLibCS.Util
 
         public void Read(byte[] buffer, int offset, int length)
         {
-            
-            expected.Enqueue(MAGIC_WAIT_CONSTANT);
+            // Whatever is being read is the answer to something still held back.
+            Flush();
+
+            lock (expectedLock)
+                expected.Enqueue(MAGIC_WAIT_CONSTANT);
             while (expected.Peek() != MAGIC_WAIT_CONSTANT)
                 sleep();
 
@@ -120,7 +169,7 @@ namespace BusPirateLibCS.Util
             try
             {
                 int read = 0;
-                while (read < length - offset)
+                while (read < length)
                 {
                     if (read > 0) sleep();
                     read += myPort.Read(buffer, offset + read, length - read);
@@ -132,7 +181,8 @@ namespace BusPirateLibCS.Util
             }
             finally
             {
-                expected.Dequeue();
+                lock (expectedLock)
+                    expected.Dequeue();
             }
         }
 
@@ -156,16 +206,19 @@ namespace BusPirateLibCS.Util
 
         public void ExpectReadByte(byte b)
         {
-            
-            expected.Enqueue(b);
+            lock (expectedLock)
+                expected.Enqueue(b);
         }
 
 
         public void ExpectRead(byte[] expect)
         {
-            foreach (var b in expect)
+            lock (expectedLock)
             {
-                expected.Enqueue(b);
+                foreach (var b in expect)
+                {
+                    expected.Enqueue(b);
+                }
             }
         }
 
@@ -0,0 +1,201 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Ports;
+using System.Linq;
+using System.Text;
+using BusPirateLibCS.Modes;
+
+namespace BusPiratePICProgrammer
+{
+	/// <summary>
+	/// PIC24F programmer built on the firmware's streamed ICSP (raw wire PIC
+	/// command 0xA8). Rows are written and read back by the firmware in one
+	/// transfer each, reads are queued a row at a time. MCLR is on CS.
+	/// </summary>
+	/// <remarks>
+	/// Code is passed in hex file layout: 4 bytes per instruction, low byte
+	/// first, the fourth (phantom) byte ignored. Addresses are program memory
+	/// addresses, half the hex file byte address.
+	/// </remarks>
+	public class PIC24Programmer : PicProgrammer
+	{
+		private const int ICSP_KEY = 0x4D434851;
+
+		private const int ROW_INSTRUCTIONS = 64;
+		private const int ROW_ADDRESSES = ROW_INSTRUCTIONS * 2;
+		private const int WRITE_POLLS = 1000;
+
+		private const int OPCODE_NOP = 0x000000;
+		private const int OPCODE_GOTO_0x200 = 0x040200;
+		private const int OPCODE_MOV_W10_NVMCON = 0x883B0A;
+		private const int OPCODE_MOV_W0_TBLPAG = 0x880190;
+		private const int OPCODE_MOV_NVMCON_W2 = 0x803B02;
+		private const int OPCODE_MOV_W2_VISI = 0x883C22;
+		private const int OPCODE_TBLWTL_W0_PW0 = 0xBB0800;
+		private const int OPCODE_BSET_NVMCON_WR = 0xA8E761;
+		private const int OPCODE_TBLRDHB_W6_W7 = 0xBACB96;
+		private const int OPCODE_TBLRDL_W6P_W7 = 0xBA0BB6;
+
+		private const int NVMCON_ERASE_ALL = 0x404F;
+		private const int NVMCON_WR = 0x8000;
+		private const int VISI_ADDRESS = 0x0784;
+
+		public PIC24Programmer(SerialPort sp)
+			: base(sp, true)
+		{
+			// The firmware reverses SIX opcodes itself.
+			hw.ConfigProtocol(false, false, false);
+			hw.SetPicMode(RawWire.PicMode.PIC424);
+		}
+
+		private static int movLiteral(int literal, int w)
+		{
+			return 0x200000 | ((literal & 0xFFFF) << 4) | w;
+		}
+
+		private void enterIcsp()
+		{
+			Program = true;
+			// MCLR pulse, then the key while it is low.
+			hw.CS = false;
+			DelayMs(1);
+			hw.WriteBits(ICSP_KEY, 32);
+			DelayMs(1);
+			hw.CS = true;
+			DelayMs(25);
+			// The first SIX after entry takes 5 extra clocks.
+			hw.WriteBits(0, 5);
+			hw.BeginPic24Stream();
+			hw.Pic24Six(OPCODE_NOP, 0);
+			hw.Pic24Six(OPCODE_GOTO_0x200, 1);
+		}
+
+		private void exitIcsp()
+		{
+			hw.EndPic24Stream();
+			Program = false;
+		}
+
+		private void waitWriteDone()
+		{
+			for (int polls = 0; polls < WRITE_POLLS; polls++)
+			{
+				hw.Pic24Six(OPCODE_GOTO_0x200, 1);
+				hw.Pic24Six(OPCODE_MOV_NVMCON_W2, 0);
+				hw.Pic24Six(OPCODE_MOV_W2_VISI, 1);
+				hw.Pic24Regout();
+				if ((hw.ReadVisi(1)[0] & NVMCON_WR) == 0)
+					return;
+			}
+			throw new IOException("Flash write did not complete");
+		}
+
+		public override void bulkErase()
+		{
+			enterIcsp();
+
+			hw.Pic24Six(movLiteral(NVMCON_ERASE_ALL, 10), 0);
+			hw.Pic24Six(OPCODE_MOV_W10_NVMCON, 0);
+			hw.Pic24Six(movLiteral(0, 0), 0);
+			hw.Pic24Six(OPCODE_MOV_W0_TBLPAG, 0);
+			hw.Pic24Six(movLiteral(0, 0), 0);
+			hw.Pic24Six(OPCODE_TBLWTL_W0_PW0, 2);
+			hw.Pic24Six(OPCODE_BSET_NVMCON_WR, 2);
+			waitWriteDone();
+
+			exitIcsp();
+		}
+
+		public override void writeCode(int address, byte[] data, int offset, int length)
+		{
+			int end = address + (length / 4) * 2;
+			var row = new byte[ROW_INSTRUCTIONS * 3];
+
+			enterIcsp();
+
+			for (int rowAddress = address - address % ROW_ADDRESSES; rowAddress < end; rowAddress += ROW_ADDRESSES)
+			{
+				// Words outside the data are written erased, which leaves them as they are.
+				for (int i = 0; i < row.Length; i++)
+					row[i] = 0xFF;
+				for (int i = 0; i < ROW_INSTRUCTIONS; i++)
+				{
+					int pc = rowAddress + i * 2;
+					if (pc < address || pc >= end)
+						continue;
+					int source = offset + (pc - address) * 2;
+					row[i * 3] = data[source];
+					row[i * 3 + 1] = data[source + 1];
+					row[i * 3 + 2] = data[source + 2];
+				}
+
+				if (!hw.Pic24ProgramRow(rowAddress, row, 0, ROW_INSTRUCTIONS / 4))
+				{
+					exitIcsp();
+					throw new IOException(String.Format("Row at {0:X6} failed to verify", rowAddress));
+				}
+			}
+
+			exitIcsp();
+		}
+
+		public override void writeConfig(int address, byte[] data, int offset, int length)
+		{
+			// Configuration words are the last words of program memory.
+			writeCode(address, data, offset, length);
+		}
+
+		public override void readCode(int address, byte[] data, int offset, int length)
+		{
+			int end = address + (length / 4) * 2;
+
+			enterIcsp();
+
+			// One row at a time, so TBLPAG stays valid over each chunk.
+			for (int chunk = address; chunk < end; )
+			{
+				int chunkEnd = Math.Min(end, chunk - chunk % ROW_ADDRESSES + ROW_ADDRESSES);
+				int count = (chunkEnd - chunk) / 2;
+
+				hw.Pic24Six(OPCODE_GOTO_0x200, 1);
+				hw.Pic24Six(movLiteral(chunk >> 16, 0), 0);
+				hw.Pic24Six(OPCODE_MOV_W0_TBLPAG, 0);
+				hw.Pic24Six(movLiteral(chunk, 6), 0);
+				hw.Pic24Six(movLiteral(VISI_ADDRESS, 7), 1);
+				for (int i = 0; i < count; i++)
+				{
+					// Upper byte first, the word read steps W6 to the next instruction.
+					hw.Pic24Six(OPCODE_TBLRDHB_W6_W7, 2);
+					hw.Pic24Regout();
+					hw.Pic24Six(OPCODE_TBLRDL_W6P_W7, 2);
+					hw.Pic24Regout();
+					hw.Pic24Six(OPCODE_GOTO_0x200, 1);
+				}
+
+				var visi = hw.ReadVisi(count * 2);
+				for (int i = 0; i < count; i++)
+				{
+					int target = offset + (chunk - address) * 2 + i * 4;
+					data[target] = (byte)visi[i * 2 + 1];
+					data[target + 1] = (byte)(visi[i * 2 + 1] >> 8);
+					data[target + 2] = (byte)visi[i * 2];
+					data[target + 3] = 0;
+				}
+				chunk = chunkEnd;
+			}
+
+			exitIcsp();
+		}
+
+		public override void writeData(int address, byte[] data, int offset, int length)
+		{
+			throw new NotSupportedException("PIC24F parts have no data EEPROM");
+		}
+
+		public override void readData(int address, byte[] data, int offset, int length)
+		{
+			throw new NotSupportedException("PIC24F parts have no data EEPROM");
+		}
+	}
+}
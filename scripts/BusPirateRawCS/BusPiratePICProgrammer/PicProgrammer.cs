@@ -36,8 +36,14 @@ namespace BusPiratePICProgrammer
 		{
 			set
 			{
+				// A whole programming operation goes out in as few writes as its
+				// reads allow.
+				if (value && !program)
+					hw.BeginBatch();
 				if (lvp) hw.CS = value;
 				hw.AUX = value;
+				if (!value && program)
+					hw.EndBatch();
 				program = value;
 			}
 			get
@@ -49,6 +55,8 @@ namespace BusPiratePICProgrammer
 
 		public void DelayMs(int time)
 		{
+			// The delay counts from the commands before it reaching the chip.
+			hw.Flush();
 			Thread.Sleep(time);
 		}
 
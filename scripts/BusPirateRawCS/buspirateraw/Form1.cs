@@ -27,6 +27,7 @@ namespace buspirateraw
         {
 			pp = new PIC16Programmer(serialPort1, false);
 			//pp = new DsPICProgrammer(serialPort1);
+			//pp = new PIC24Programmer(serialPort1);
 
 
             
@@ -0,0 +1,334 @@
+#!/usr/bin/env python
+# encoding: utf-8
+# BPscope v 2.0
+# Based on BPscope v 1.2 by hwmayer (hwmayer.blogspot.com)
+#    This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Uses the binary I/O ADC block stream (command 0x17) instead of the one
+# sample at a time continuous ADC command, so samples are evenly spaced and
+# come in as fast as the link allows.  A background thread does large reads
+# and unpacks whole blocks into a ring buffer; the display only looks at the
+# newest part of the ring, so redraws never hold up the serial reads.
+#
+# USAGE:
+# f - trigger on falling slope
+# r - trigger on rising slope
+# s - trigger off
+# key_up 		- trigger level++
+# key_down 	- trigger level--
+# 9 - time scale++ (zoom out)
+# 0 - time scale-- (zoom in)
+# q - QUIT
+#
+# "pygame", "numpy" and "pyserial" are needed to run this script.
+
+import optparse
+import sys
+import threading
+import time
+
+import numpy
+import pygame
+import serial
+
+NO_SYNC = 0
+RISING_SLOPE = 1
+FALLING_SLOPE = 2
+
+BBIO_RESET = b"\x00"
+BBIO_IDENTIFIER = b"BBIO1"
+BBIO_EXIT_TO_TERMINAL = b"\x0F"
+BBIO_ADC_STREAM = 0x17
+
+REPORT_IO_SUCCESS = b"\x01"
+
+# Firmware side block layout, see adc_stream.h.
+BLOCK_SAMPLES = 64
+BLOCK_SIZE = 1 + (BLOCK_SAMPLES // 4) * 5
+STATUS_OVERRUN = 0x01
+
+RES_X = 640
+RES_Y = 480
+MAX_VOLTAGE = 6
+OFFSET = 10
+TRIGGER_LEV_RES = 0.05
+DEFAULT_TRIGGER_LEV = 1.0
+DEFAULT_TRIGGER_MODE = NO_SYNC
+FRAMES_PER_SECOND = 30
+
+ADC_FULL_SCALE = 1024.0
+ADC_VOLTAGE_SCALE = 6.6
+
+# About ten seconds of samples at the fastest rates.
+RING_CAPACITY = 1 << 21
+
+HIGH_BITS_SHIFTS = numpy.array([0, 2, 4, 6], dtype=numpy.uint8)
+
+class ScopeError(Exception):
+	pass
+
+def unpack_blocks(data):
+	"""Turns whole stream blocks into (overruns, samples)."""
+	blocks = numpy.frombuffer(data, dtype=numpy.uint8).reshape(-1, BLOCK_SIZE)
+	overruns = int(numpy.count_nonzero(blocks[:, 0] & STATUS_OVERRUN))
+	groups = blocks[:, 1:].reshape(-1, 5)
+	low = groups[:, :4].astype(numpy.uint16)
+	high = (groups[:, 4:5] >> HIGH_BITS_SHIFTS) & 0x03
+	return overruns, (low | (high.astype(numpy.uint16) << 8)).reshape(-1)
+
+class SampleRing:
+	"""Fixed size sample history, written by the reader thread."""
+
+	def __init__(self, capacity):
+		self.data = numpy.zeros(capacity, dtype=numpy.uint16)
+		self.capacity = capacity
+		self.total = 0
+		self.lock = threading.Lock()
+
+	def extend(self, samples):
+		with self.lock:
+			count = len(samples)
+			if count > self.capacity:
+				samples = samples[-self.capacity:]
+				self.total += count - self.capacity
+				count = self.capacity
+			start = self.total % self.capacity
+			first = min(count, self.capacity - start)
+			self.data[start:start + first] = samples[:first]
+			self.data[:count - first] = samples[first:]
+			self.total += count
+
+	def latest(self, count):
+		"""Returns up to count of the newest samples, oldest first."""
+		with self.lock:
+			count = min(count, self.total, self.capacity)
+			end = self.total % self.capacity
+			start = end - count
+			if start >= 0:
+				return self.data[start:end].copy()
+			return numpy.concatenate((self.data[start:], self.data[:end]))
+
+class StreamReader(threading.Thread):
+	def __init__(self, port, ring):
+		threading.Thread.__init__(self)
+		self.daemon = True
+		self.port = port
+		self.ring = ring
+		self.overruns = 0
+		self.running = True
+
+	def run(self):
+		pending = bytearray()
+		while self.running:
+			data = self.port.read(max(self.port.in_waiting, BLOCK_SIZE * 16))
+			if not data:
+				continue
+			pending.extend(data)
+			whole = (len(pending) // BLOCK_SIZE) * BLOCK_SIZE
+			if whole == 0:
+				continue
+			(overruns, samples) = unpack_blocks(bytes(pending[:whole]))
+			del pending[:whole]
+			self.overruns += overruns
+			self.ring.extend(samples)
+
+class BusPirate:
+	def __init__(self, device, speed):
+		self.port = serial.Serial(device, speed, timeout=0.05)
+
+	def enter_bbio(self):
+		self.port.reset_input_buffer()
+		for attempt in range(25):
+			self.port.write(BBIO_RESET)
+			time.sleep(0.01)
+			if self.port.in_waiting >= len(BBIO_IDENTIFIER):
+				break
+		data = self.port.read(self.port.in_waiting or len(BBIO_IDENTIFIER))
+		if not data.endswith(BBIO_IDENTIFIER):
+			raise ScopeError("could not enter binary mode, got %r" % data)
+
+	def start_stream(self, period):
+		self.port.write(bytes([BBIO_ADC_STREAM, period >> 8, period & 0xFF]))
+		self.port.timeout = 1
+		reply = self.port.read(1)
+		self.port.timeout = 0.05
+		if reply != REPORT_IO_SUCCESS:
+			raise ScopeError("stream refused, sampling period out of range?")
+
+	def stop_stream(self):
+		self.port.write(BBIO_RESET)
+		time.sleep(0.1)
+		self.port.reset_input_buffer()
+
+	def exit_to_terminal(self):
+		self.port.write(BBIO_RESET)
+		self.port.write(BBIO_EXIT_TO_TERMINAL)
+		time.sleep(0.1)
+		self.port.reset_input_buffer()
+
+def to_voltage(samples):
+	return samples * (ADC_VOLTAGE_SCALE / ADC_FULL_SCALE)
+
+def find_trigger(voltage, level, mode, width):
+	"""Index of the newest edge that still leaves width samples after it."""
+	usable = voltage[:len(voltage) - width + 1]
+	if mode == NO_SYNC or len(usable) < 2:
+		return None
+	before = usable[:-1]
+	after = usable[1:]
+	if mode == RISING_SLOPE:
+		edges = numpy.nonzero((before < level) & (after >= level))[0]
+	else:
+		edges = numpy.nonzero((before > level) & (after <= level))[0]
+	if len(edges) == 0:
+		return None
+	return int(edges[-1]) + 1
+
+def decimate(voltage, columns):
+	"""Per column (minimum, maximum), so narrow spikes stay visible."""
+	per_column = len(voltage) // columns
+	shaped = voltage[:per_column * columns].reshape(columns, per_column)
+	return shaped.min(axis=1), shaped.max(axis=1)
+
+def to_y(voltage):
+	return RES_Y - voltage * (RES_Y / MAX_VOLTAGE) - OFFSET
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options]", version="%prog 2.0")
+
+	parser.add_option("-d", "--device",
+						dest="device", default="/dev/ttyUSB0",
+						help="Serial port the Bus Pirate is on")
+	parser.add_option("-s", "--speed",
+						dest="speed", default=115200, type="int",
+						help="Serial port speed")
+	parser.add_option("-p", "--period",
+						dest="period", default=110, type="int",
+						help="Sampling period in microseconds (4-32767); 110 is about "
+						"what a 115200 bps UART link keeps up with")
+
+	(options, args) = parser.parse_args()
+	if not 4 <= options.period <= 32767:
+		parser.error("the sampling period must be between 4 and 32767 microseconds")
+	return options
+
+def main():
+	options = parse_prog_args()
+	rate = 1000000.0 / options.period
+
+	bp = BusPirate(options.device, options.speed)
+	bp.enter_bbio()
+	bp.start_stream(options.period)
+
+	ring = SampleRing(RING_CAPACITY)
+	reader = StreamReader(bp.port, ring)
+	reader.start()
+
+	pygame.init()
+	window = pygame.display.set_mode((RES_X, RES_Y))
+	font = pygame.font.Font(None, 19)
+	clock = pygame.time.Clock()
+	background = (0, 0, 0)
+	line = (0, 255, 0)
+	trig_color = (100, 100, 0)
+	text_color = (255, 255, 255)
+
+	time_div = 1
+	trigger_level = DEFAULT_TRIGGER_LEV
+	trig_mode = DEFAULT_TRIGGER_MODE
+	frozen = None
+
+	try:
+		while True:
+			width = RES_X * time_div
+
+			# Look back far enough to find an edge even for slow signals.
+			voltage = to_voltage(ring.latest(width * 4).astype(numpy.float32))
+			if len(voltage) >= width:
+				trigger = find_trigger(voltage, trigger_level, trig_mode, width)
+				if trigger is not None:
+					frozen = voltage[trigger:trigger + width]
+				elif trig_mode == NO_SYNC or frozen is None or len(frozen) != width:
+					frozen = voltage[-width:]
+
+			window.fill(background)
+			if frozen is not None and len(frozen) == width:
+				(low, high) = decimate(frozen, RES_X)
+				if time_div == 1:
+					points = [(x, to_y(v)) for (x, v) in enumerate(low)]
+					pygame.draw.lines(window, line, False, points)
+				else:
+					for x in range(RES_X):
+						pygame.draw.line(window, line, (x, to_y(low[x])), (x, to_y(high[x])))
+				maxv = float(frozen.max())
+				minv = float(frozen.min())
+			else:
+				maxv = minv = 0.0
+
+			trig_y = to_y(trigger_level)
+			pygame.draw.line(window, trig_color, (0, trig_y), (RES_X, trig_y))
+
+			labels = [
+				"Max: %f V" % maxv,
+				"Min: %f V" % minv,
+				"Timescale: %f s" % (width / rate),
+				"Rate: %d S/s, overruns: %d" % (rate, reader.overruns),
+			]
+			for (index, label) in enumerate(labels):
+				window.blit(font.render(label, 1, text_color), (10, 10 + index * 20))
+
+			pygame.display.flip()
+			clock.tick(FRAMES_PER_SECOND)
+
+			for event in pygame.event.get():
+				if event.type == pygame.QUIT:
+					return
+				elif event.type == pygame.KEYDOWN:
+					if event.key == pygame.K_0:
+						if width * 2 * 4 <= RING_CAPACITY:
+							print("timescale x 2")
+							time_div = time_div * 2
+					elif event.key == pygame.K_9:
+						if time_div >= 2:
+							print("timescale / 2")
+							time_div = time_div // 2
+					elif event.key == pygame.K_s:
+						print("Trigger off, no sync")
+						trig_mode = NO_SYNC
+					elif event.key == pygame.K_f:
+						print("Trigger set to falling slope")
+						trig_mode = FALLING_SLOPE
+					elif event.key == pygame.K_r:
+						print("Trigger set to rising slope")
+						trig_mode = RISING_SLOPE
+					elif event.key == pygame.K_UP:
+						trigger_level += TRIGGER_LEV_RES
+						print("Trigger level: %f" % trigger_level)
+					elif event.key == pygame.K_DOWN:
+						trigger_level -= TRIGGER_LEV_RES
+						print("Trigger level: %f" % trigger_level)
+					elif event.key == pygame.K_q:
+						return
+	finally:
+		reader.running = False
+		reader.join()
+		bp.stop_stream()
+		bp.exit_to_terminal()
+
+if __name__ == '__main__':
+	try:
+		main()
+	except ScopeError as error:
+		print("error: %s" % error, file=sys.stderr)
+		sys.exit(1)
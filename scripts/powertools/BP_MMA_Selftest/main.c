@@ -235,15 +235,10 @@ int main(int argc, char** argv)
 		//
 		//Start self-test
 
-		// Set CS high
-		i=0x03;
+		// Set CS high, then low
 		printf(" CS High : 0x03....\n");
-		BP_WriteToPirate(fd,&i);
-
-		// Set CS low
-		i=0x02;
 		printf(" CS Low : 0x02....\n\n");
-		BP_WriteToPirate(fd,&i);
+		BP_WriteToPirateBatch(fd,"\x03\x02",2);
 
 		//  Send 0x1A
 		printf(" Sending  0x1A....\n");
@@ -251,7 +246,6 @@ int main(int argc, char** argv)
 		buffer[1]=0x1a; //command to MMA7455
 		buffer[2]=0xff; //read one byte
 		serial_write(fd, buffer, 3);
-		Sleep(1);
 		// Read one byte
 		res = serial_read(fd, buffer, 3);
 		if (res!=0) {
@@ -1,322 +1,446 @@
- #include <stdio.h>
- #include <stdlib.h>
- #include <unistd.h>
- #include <string.h>
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+/*
+ * SPI sniffer host side, for the framed binary sniffer (SPI mode command
+ * 0x0F).  The board sends 4 byte records: a big endian header holding the
+ * CS asserted/released and repeat flags plus a 13 bit delta in 4us ticks,
+ * then either a MOSI/MISO byte pair or a repeat count.
+ *
+ * Records are parsed straight out of the serial read-ahead buffer through
+ * a table indexed by the header flags.  Each CS frame can be written to a
+ * pcapng file as one packet on a LINKTYPE_USER0 interface, its data being
+ * the MOSI/MISO pairs in bus order and its timestamp the CS assertion time.
+ * Only a summary is printed, once a second, unless -v is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifdef WIN32
 #include <conio.h>
- #include <windef.h>
-
-#else
-//#include <curses.h>
+#include <windef.h>
 #endif
 
-#include "..\framework\buspirate.h"
-#include "..\framework\serial.h"
+#include "../framework/buspirate.h"
+#include "../framework/serial.h"
+
+int modem = FALSE;
+int verbose = 0;
+int disable_comport = 0;
+int dumphandle;
+char *dumpfile;
+
+#define SNIFF_FRAMED            0x0F
+#define SNIFF_OPTION_CS_LOW     0x01
+
+#define RECORD_SIZE             4
+#define RECORD_CS_ASSERTED      0x8000
+#define RECORD_CS_RELEASED      0x4000
+#define RECORD_REPEAT           0x2000
+#define RECORD_DELTA_MASK       0x1FFF
+#define RECORD_FLAGS_SHIFT      13
+#define TICK_US                 4
+
+/* Longest packet written, longer frames are split over several. */
+#define FRAME_MAX               65536
+
+#define PCAPNG_SHB              0x0A0D0D0A
+#define PCAPNG_IDB              0x00000001
+#define PCAPNG_EPB              0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define LINKTYPE_USER0          147
+
+static struct {
+	uint64_t now;			/* us since the sniffer started */
+	uint64_t frame_start;
+	uint8_t frame[FRAME_MAX];
+	uint32_t frame_length;
+	int in_frame;
+	uint8_t last_pair[2];
+
+	unsigned long frames;
+	unsigned long pairs;
+	unsigned long repeated;
+	unsigned long errors;
+	unsigned long long bytes;
+
+	FILE *capture;
+} sniffer;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int signal)
+{
+	(void)signal;
+	stop_requested = 1;
+}
+
+static void pcapng_write_u32(uint32_t value)
+{
+	fwrite(&value, sizeof(value), 1, sniffer.capture);
+}
+
+static void pcapng_start(void)
+{
+	uint16_t idb[2] = { LINKTYPE_USER0, 0 };
+	int64_t section_length = -1;
+	uint16_t version[2] = { 1, 0 };
+
+	pcapng_write_u32(PCAPNG_SHB);
+	pcapng_write_u32(28);
+	pcapng_write_u32(PCAPNG_BYTE_ORDER_MAGIC);
+	fwrite(version, sizeof(version), 1, sniffer.capture);
+	fwrite(&section_length, sizeof(section_length), 1, sniffer.capture);
+	pcapng_write_u32(28);
+
+	pcapng_write_u32(PCAPNG_IDB);
+	pcapng_write_u32(20);
+	fwrite(idb, sizeof(idb), 1, sniffer.capture);
+	pcapng_write_u32(FRAME_MAX);
+	pcapng_write_u32(20);
+}
+
+static void pcapng_packet(uint64_t timestamp, const uint8_t *data, uint32_t length)
+{
+	static const uint8_t padding[3] = { 0 };
+	uint32_t padded = (length + 3) & ~3U;
+	uint32_t block_length = 32 + padded;
+
+	pcapng_write_u32(PCAPNG_EPB);
+	pcapng_write_u32(block_length);
+	pcapng_write_u32(0);
+	/* Default if_tsresol, microseconds. */
+	pcapng_write_u32((uint32_t)(timestamp >> 32));
+	pcapng_write_u32((uint32_t)timestamp);
+	pcapng_write_u32(length);
+	pcapng_write_u32(length);
+	fwrite(data, 1, length, sniffer.capture);
+	fwrite(padding, 1, padded - length, sniffer.capture);
+	pcapng_write_u32(block_length);
+}
+
+static void frame_flush(void)
+{
+	if (sniffer.frame_length > 0 && sniffer.capture != NULL)
+		pcapng_packet(sniffer.frame_start, sniffer.frame, sniffer.frame_length);
+	sniffer.frame_length = 0;
+	sniffer.frame_start = sniffer.now;
+}
+
+static void frame_append(const uint8_t *pair)
+{
+	if (!sniffer.in_frame) {
+		/* Sniffing all traffic, data can come outside of CS frames. */
+		sniffer.in_frame = 1;
+		sniffer.frame_start = sniffer.now;
+	}
+	if (sniffer.frame_length == FRAME_MAX)
+		frame_flush();
+	sniffer.frame[sniffer.frame_length++] = pair[0];
+	sniffer.frame[sniffer.frame_length++] = pair[1];
+	sniffer.last_pair[0] = pair[0];
+	sniffer.last_pair[1] = pair[1];
+	sniffer.pairs++;
+}
+
+static void on_data(const uint8_t *data)
+{
+	frame_append(data);
+	if (verbose)
+		printf("0x%02X(0x%02X)", data[0], data[1]);
+}
+
+static void on_start(const uint8_t *data)
+{
+	if (sniffer.in_frame)
+		frame_flush();
+	sniffer.in_frame = 1;
+	sniffer.frame_start = sniffer.now;
+	if (verbose)
+		printf("[");
+	on_data(data);
+}
+
+static void on_repeat(const uint8_t *data)
+{
+	unsigned int count = (data[0] << 8) | data[1];
+	uint8_t pair[2];
+	unsigned int i;
+
+	pair[0] = sniffer.last_pair[0];
+	pair[1] = sniffer.last_pair[1];
+	for (i = 0; i < count; i++)
+		frame_append(pair);
+	sniffer.repeated += count;
+	if (verbose)
+		printf(" x%u ", count);
+}
+
+static void on_release(const uint8_t *data)
+{
+	(void)data;
+	frame_flush();
+	sniffer.in_frame = 0;
+	sniffer.frames++;
+	if (verbose)
+		printf("]\n");
+}
+
+static void on_invalid(const uint8_t *data)
+{
+	(void)data;
+	sniffer.errors++;
+}
+
+/* Indexed by the three header flags: CS asserted, CS released, repeat. */
+static void (*const record_handlers[8])(const uint8_t *data) = {
+	on_data,	/* ---  */
+	on_repeat,	/* --R  */
+	on_release,	/* -E-  */
+	on_invalid,	/* -ER  */
+	on_start,	/* A--  */
+	on_invalid,	/* A-R  */
+	on_invalid,	/* AE-  */
+	on_invalid,	/* AER  */
+};
+
+static void parse_record(const uint8_t *record)
+{
+	uint16_t header = (record[0] << 8) | record[1];
+
+	sniffer.now += (uint64_t)(header & RECORD_DELTA_MASK) * TICK_US;
+	record_handlers[header >> RECORD_FLAGS_SHIFT](record + 2);
+}
+
+/* Records may straddle reads, the split one is kept here. */
+static void parse_block(const uint8_t *data, int length)
+{
+	static uint8_t partial[RECORD_SIZE];
+	static int partial_length = 0;
+
+	sniffer.bytes += length;
+
+	if (partial_length > 0) {
+		while (partial_length < RECORD_SIZE && length > 0) {
+			partial[partial_length++] = *data++;
+			length--;
+		}
+		if (partial_length < RECORD_SIZE)
+			return;
+		parse_record(partial);
+		partial_length = 0;
+	}
+
+	while (length >= RECORD_SIZE) {
+		parse_record(data);
+		data += RECORD_SIZE;
+		length -= RECORD_SIZE;
+	}
 
- int modem =FALSE;   //set this to TRUE of testing a MODEM
- int verbose = 0;
+	memcpy(partial, data, length);
+	partial_length = length;
+}
 
-int disable_comport = 0;   //1 to say yes, disable comport, any value to enable port default is 0 meaning port is enable.
- int dumphandle;     // use by dump file when using the -d dumfile.txt parameter
- char *dumpfile;
+static void print_summary(double seconds, unsigned long long bytes)
+{
+	fprintf(stderr, "\r %lu frames, %lu byte pairs (%lu repeated), %lu errors, %.1f KB/s   ",
+		sniffer.frames, sniffer.pairs, sniffer.repeated, sniffer.errors,
+		seconds > 0 ? bytes / seconds / 1024.0 : 0.0);
+	fflush(stderr);
+}
 
-#define SPI 0x01
-#ifndef WIN32
-#define usleep(x) Sleep(x);
+static int keypress(void)
+{
+#ifdef WIN32
+	if (kbhit()) {
+		getch();
+		return 1;
+	}
 #endif
+	return 0;
+}
 
 int print_usage(char * appname)
-	{
-		//print usage
-		printf("\n");
-//	    printf("-----------------------------------------------------------------------------\n");
-		printf("\n");
-	    printf(" Help Menu\n");
-        printf(" Usage:              \n");
-		printf("   %s  -d device -e 1 -p 0 \n ",appname);
-		printf("\n");
-		printf("   Example Usage:   %s COM1 -s Speed -e 1 -p 0 -r 1\n",appname);
-		printf("\n");
-		printf("           Where: -d device is port e.g.  COM1  \n");
-		printf("                  -s Speed is port Speed  default is 115200 \n");
-		printf("                  -e ClockEdge is 0 or 1  default is 1 \n");
-		printf("                  -p Polarity  is 0 or 1  default is 0 \n");
-		printf("                  -r RawData  is 0 or 1  default is 0 \n");
-		printf("\n");
-
-        printf("\n");
-
-        printf("-----------------------------------------------------------------------------\n");
-
-
-		return 0;
+{
+	printf("\n");
+	printf(" Help Menu\n");
+	printf(" Usage:\n");
+	printf("   %s -d device [-s speed] [-e edge] [-p polarity] [-a] [-w file] [-v]\n", appname);
+	printf("\n");
+	printf("   Example Usage:   %s -d COM1 -w capture.pcapng\n", appname);
+	printf("\n");
+	printf("           Where: -d device is port e.g.  COM1 or /dev/ttyUSB0\n");
+	printf("                  -s speed is port speed, default is 115200\n");
+	printf("                  -e clock edge is 0 or 1, default is 1\n");
+	printf("                  -p polarity is 0 or 1, default is 0\n");
+	printf("                  -a sniffs all traffic, not only while CS is low\n");
+	printf("                  -w file writes CS frames to a pcapng capture\n");
+	printf("                  -v prints every frame as it comes\n");
+	printf("\n");
+	printf(" Stop with Ctrl-C (or any key on Windows).\n");
+	printf("-----------------------------------------------------------------------------\n");
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	int opt;
+	int fd;
+	int res;
+	char command[2];
+	char config;
+	const char *data;
+	char *param_port = NULL;
+	char *param_capture = NULL;
+	int speed = 115200;
+	int clock_edge = 1;
+	int polarity = 0;
+	int all_traffic = 0;
+	time_t started, last_summary;
+	unsigned long long summary_bytes = 0;
+
+	printf("-----------------------------------------------------------------------------\n");
+	printf("\n");
+	printf(" Bus Pirate binary mode SPI SNIFFER utility v0.4 (CC-0)\n");
+	printf(" http://dangerousprototypes.com\n");
+	printf("\n");
+	printf("-----------------------------------------------------------------------------\n");
+
+	while ((opt = getopt(argc, argv, "d:s:e:p:aw:v")) != -1) {
+		switch (opt) {
+		case 'd':
+			param_port = optarg;
+			break;
+		case 's':
+			speed = atoi(optarg);
+			break;
+		case 'e':
+			clock_edge = atoi(optarg);
+			break;
+		case 'p':
+			polarity = atoi(optarg);
+			break;
+		case 'a':
+			all_traffic = 1;
+			break;
+		case 'w':
+			param_capture = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			print_usage(argv[0]);
+			exit(-1);
+		}
 	}
 
- int main(int argc, char** argv)
- {
-  int opt;
-
-   char buffer[256] = {0}, i;
-   int fd;
-   int res,c;
-
-
-   int new_state,state=0;
-   char *param_port = NULL;
-   char *param_speed = NULL;
-   char *param_polarity=NULL;
-   char *param_clockedge=NULL;
-   char *param_rawdata=NULL;
-
- //  int clock_edge;
- // int polarity;
-  //default speed
-
-    printf("-----------------------------------------------------------------------------\n");
-    printf("\n");
-    printf(" Bus Pirate binary mode SPI SNIFFER utility v0.3 (CC-0)\n");
-    printf(" http://dangerousprototypes.com\n");
-    printf("\n");
-    printf("-----------------------------------------------------------------------------\n");
-
- //p == port
- // p=polarity
- // e=clock edge
-
- if (argc <= 1)  {
-
-
+	if (param_port == NULL) {
+		printf(" No serial port set\n");
 		print_usage(argv[0]);
-    	exit(-1);
-
- 	}
-
-
-while ((opt = getopt(argc, argv, "ms:p:e:d:r:")) != -1) {
-        // printf("%c  \n",opt);
-
+		exit(-1);
+	}
 
-		switch (opt) {
-			case 'd':  // device   eg. com1 com12 etc
-				if ( param_port != NULL){
-					printf("Device/PORT error!\n");
-					exit(-1);
-                }
- 				param_port = strdup(optarg);
-                break;
-
-			case 'e':      // clock edge
- 				if (param_clockedge != NULL) {
-					printf("Clock Edge should be 0 or 1\n");
-					exit(-1);
-				}
- 				param_clockedge = strdup(optarg);
-
-				break;
-            case 'p':
-				if (param_polarity != NULL) {
-					printf("Polarity must be 0 or 1\n");
-					exit(-1);
-				}
- 				param_polarity = strdup(optarg);
- 				break;
-			case 's':
-				if (param_speed != NULL) {
-					printf("Speed should be set: eg  115200 \n");
-					exit(-1);
-				}
- 				param_speed = strdup(optarg);
-
-				break;
-			case 'r':      // raw data
-				if (param_rawdata != NULL) {
-					printf("Raw Data should be 0 or 1\n");
-					exit(-1);
-				}
-				param_rawdata = strdup(optarg);
-				break;
-		case 'm':    //modem debugging for testing
-                    modem =TRUE;   // enable modem mode
- 				break;
-
-			default:
-				printf(" Invalid argument %c", opt);
-				print_usage(argv[0]);
-				exit(-1);
-			    break;
+	if (param_capture != NULL) {
+		sniffer.capture = fopen(param_capture, "wb");
+		if (sniffer.capture == NULL) {
+			fprintf(stderr, " Cannot create %s\n", param_capture);
+			return -1;
 		}
+		pcapng_start();
+	}
 
+	printf(" Opening Bus Pirate on %s at %ibps...\n", param_port, speed);
+	fd = serial_open(param_port);
+	if (fd < 0) {
+		fprintf(stderr, " Error opening serial port\n");
+		return -1;
+	}
+	serial_setup(fd, (speed_t)speed);
 
+	fprintf(stderr, " Configuring Bus Pirate...\n");
+	if (BP_EnableBinary(fd) != BBIO) {
+		fprintf(stderr, " Buspirate cannot switch to binary mode :( \n");
+		return -1;
+	}
+	if (BP_EnableMode(fd, SPI) != SPI) {
+		fprintf(stderr, " Buspirate cannot switch to SPI mode :( \n");
+		return -1;
+	}
 
- }
- //   printf(" Press escape to exit \n");
- //   printf("\n");
-     //param_port=strdup("COM3");
-     //Set default if NULL
-     if (param_port==NULL){
-        printf(" No serial port set\n");
-		print_usage(argv[0]);
- 		exit(-1);
-     }
-
-     if (param_clockedge==NULL)
-           param_clockedge=strdup("1");
-
-
-     if (param_polarity==NULL)
-           param_polarity=strdup("0");
+	//1000wxyz - SPI config, w=HiZ/3.3v, x=CKP idle, y=CKE edge, z=SMP sample
+	config = 0x80;
+	if (clock_edge)
+		config |= 0x02;
+	if (polarity)
+		config |= 0x04;
+	if (BP_WriteToPirate(fd, &config) != 0) {
+		fprintf(stderr, " Buspirate did not take the SPI settings\n");
+		return -1;
+	}
 
-     if (param_speed==NULL)
-           param_speed=strdup("115200");
+	command[0] = SNIFF_FRAMED;
+	command[1] = all_traffic ? 0 : SNIFF_OPTION_CS_LOW;
+	serial_write(fd, command, 2);
+	if (serial_read(fd, command, 1) != 1 || command[0] != 0x01) {
+		fprintf(stderr, " Buspirate firmware has no framed SPI sniffer\n");
+		return -1;
+	}
+	fprintf(stderr, " Sniffing%s...\n", all_traffic ? " all traffic" : " while CS is low");
 
-    if (param_rawdata==NULL)
-         param_rawdata=strdup("0");
+	signal(SIGINT, on_signal);
+	started = last_summary = time(NULL);
 
-    printf("\n Parameters used:\n");
-   printf(" Device = %s,  Speed = %s, Clock Edge= %s, Polarity= %s RawData= %s \n\n",param_port,param_speed,param_clockedge,param_polarity,param_rawdata);
+	while (!stop_requested && !keypress()) {
+		time_t now;
 
+		res = serial_borrow(fd, &data);
+		if (res < 0)
+			break;
+		parse_block((const uint8_t *)data, res);
 
- //
-     // Open serial port
-     //
+		now = time(NULL);
+		if (now != last_summary) {
+			print_summary(difftime(now, last_summary), sniffer.bytes - summary_bytes);
+			summary_bytes = sniffer.bytes;
+			last_summary = now;
+		}
+	}
 
-    printf(" Opening Bus Pirate on %s at %sbps...\n", param_port, param_speed);
+	/* Any byte stops the sniffer, which then sends what it still holds. */
+	serial_write(fd, "\x00", 1);
+	while ((res = serial_borrow(fd, &data)) > 0)
+		parse_block((const uint8_t *)data, res);
+	if (sniffer.in_frame)
+		frame_flush();
 
- 	fd = serial_open(param_port);
-	if (fd < 0) {
-		fprintf(stderr, " Error opening serial port\n");
-		return -1;
+	print_summary(difftime(time(NULL), started), sniffer.bytes);
+	fprintf(stderr, "\n");
 
- 	}
-
-     //
- 	// Enter binary mode, then enter a protocol mode
-	//
-
- 	serial_setup(fd,(speed_t) atoi(param_speed));
-
- 	printf(" Starting SPI sniffer...\n");
-
- 	if (modem==TRUE){    // connected to modem for testing response	{
-
-              serial_write( fd, "ATI3\x0D\0",5 );
-	          Sleep(1);
- 	          res= serial_read(fd, buffer, sizeof(buffer));
- 	          printf("\n %s\n",buffer);
-              serial_write( fd, "ATI4\x0D\0",5 );
-	          Sleep(1);
- 	          res= serial_read(fd, buffer, sizeof(buffer));
- 	          printf("\n %s\n",buffer);
-               serial_write( fd, "ATI7\x0D\0",5 );
-	          Sleep(1);
- 	          res= serial_read(fd, buffer, sizeof(buffer));
- 	          printf("\n %s\n",buffer);
- 	}
-
-    fprintf(stderr, " Configuring Bus Pirate...\n");
-  	      //BP_EnableMode(fd, SPI); //enter BBIO then SPI
-  	if(BP_EnableBinary(fd)!=BBIO){
-             fprintf(stderr, " Buspirate cannot switch to binary mode :( \n");
-             fprintf(stderr, " Exiting...\n");
-             return -1;
-   	 }
-    if(BP_EnableMode(fd , SPI)!=SPI){
-             fprintf(stderr, " Buspirate cannot switch to SPI mode :( \n");
-             fprintf(stderr, " Exiting...\n");
-             return -1;
-     }
-
-     //configure according to user settings
-     //1000wxyz - SPI config, w=HiZ/3.3v, x=CKP idle, y=CKE edge, z=SMP sample
-    printf(" Setting Clockedge/Polarity ......");
-    i=0x80;
-    if(strncmp(param_clockedge, "1", 1)==0){
-        printf(" CKE=1");
-        i|=0x02;
-    }
-
-
-    if(strncmp(param_polarity, "1", 1)==0){
-        printf(" CKP=1");
-        i|=0x04;
-    }
-
-
-    if (BP_WriteToPirate(fd, &i)==0)
-         printf("OK\n");
-    else
-         printf("WARNING.. Not Good\n");
-
-     //start the sniffer
-    serial_write( fd, "\x0E", 1);
-     //
-     // Done with setup
-     //
- 	 while(1){
-         Sleep(1);
-         res= serial_read(fd, buffer, 100);
-         if(res>0){
-             for(c=0; c<res; c++){
-                 printf("%02X ", (uint8_t)buffer[c]);
-             if(strncmp(param_rawdata, "1", 1)==0)
-                      printf("%02X ", (uint8_t)buffer[c]);
-	         else {
-		         switch(state) {
-		    	           default:
-
-                           case 0:	// waiting CS active
-                                if (buffer[c]==0x5B) {
-                                    printf("[");
-                                    new_state=1;
-                                } else {
-                                    printf("Sync\n");
-                                    new_state=0;
-                                }
-                                break;
-
-                           case 1:	// check for data or CS inactive
-                                if (buffer[c]==0x5C) {
-                                    new_state=2;
-                                } else
-                                    if (buffer[c]==0x5D) {
-                                        printf("]\n");
-                                        new_state=0;
-                                    } else {
-                                        printf("Sync\n");
-                                        new_state=0;
-                                        }
-                                break;
-
-                            case 2:	// MPI
-                                 printf("0x%02X(", (uint8_t) buffer[c]);
-                                 new_state=3;
-                                 break;
-
-                            case 3:	// MPO
-                                printf("0x%02X)", (uint8_t) buffer[c]);
-                                new_state=1;
-                                break;
-                            }
-                state=new_state;
-                }
-             }
-         }  //   if(res>0)
+	//back to BBIO, then to the terminal
+	serial_write(fd, "\x00\x0F", 2);
+	serial_close(fd);
 
-#ifdef WIN32
-         if(kbhit()){
-            c = getch();
-                 break;
-             }
- #endif
-         }  //end while(1)
-
-
- #define FREE(x) if(x) free(x);
-
-	FREE(param_port);
- 	FREE(param_speed);
-    FREE(param_polarity);
-    FREE(param_clockedge);
-    return 0;
- }  //end main()
+	if (sniffer.capture != NULL)
+		fclose(sniffer.capture);
+	return 0;
+}
@@ -32,7 +32,6 @@ uint32_t BP_WriteToPirate(int fd, char * val) {
 
 
     serial_write(fd, val, 1);
-    Sleep(1);
     res = serial_read(fd, &ret, 1);
 
 	if( ret != '\x01') {
@@ -55,12 +54,33 @@ uint32_t BP_WriteToPirateNoCheck(int fd, char * val) {
 
 
     serial_write(fd, val, 1);
-    Sleep(1);
     res = serial_read(fd, &ret, 1);
 
 	return 0;
 }
 
+//sends count one byte commands in one write, then checks every reply is 0x01
+uint32_t BP_WriteToPirateBatch(int fd, char * val, int count) {
+	char ret[SERIAL_WRITE_BATCH];
+	int res, i;
+
+	if (count > SERIAL_WRITE_BATCH)
+		return -1;
+
+	serial_write(fd, val, count);
+	res = serial_read(fd, ret, count);
+	if (modem==TRUE)
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		if (i >= res || ret[i] != '\x01') {
+			printf(" ERROR: BusPirate reply %i of %i was not 0x01 \n", i + 1, count);
+			return -1;
+		}
+	}
+	return 0;
+}
+
 int BP_EnableBinary(int fd)   // should return BBIO if ok, ERR if not
 {
 	int ret;
@@ -21,3 +21,4 @@ uint32_t BP_WriteToPirate(int , char *);
 int BP_EnableBinary(int);
 int BP_EnableMode(int , char );
 uint32_t BP_WriteToPirateNoCheck(int fd, char * val);
+uint32_t BP_WriteToPirateBatch(int fd, char * val, int count);
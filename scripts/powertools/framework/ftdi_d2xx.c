@@ -0,0 +1,185 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifdef BP_FTDI_D2XX
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+#include "ftd2xx.h"
+
+#include "ftdi_d2xx.h"
+
+static FT_HANDLE handle;
+
+/* Signalled by the driver whenever a byte arrives. */
+#ifdef WIN32
+static HANDLE received;
+#else
+static EVENT_HANDLE received;
+static int received_ready;
+#endif
+
+int ftdi_d2xx_open(const char *serial_number)
+{
+	FT_STATUS status;
+
+	if (serial_number != NULL && *serial_number != '\0')
+		status = FT_OpenEx((PVOID)serial_number, FT_OPEN_BY_SERIAL_NUMBER, &handle);
+	else
+		status = FT_Open(0, &handle);
+	if (status != FT_OK) {
+		fprintf(stderr, "No FTDI device found, or the VCP driver still holds it.");
+		handle = NULL;
+		return -1;
+	}
+
+	/* Small replies go out after 2ms instead of 16ms, large ones in one go. */
+	if (FT_SetLatencyTimer(handle, FTDI_D2XX_LATENCY_TIMER) != FT_OK ||
+	    FT_SetUSBParameters(handle, FTDI_D2XX_IN_TRANSFER, FTDI_D2XX_OUT_TRANSFER) != FT_OK ||
+	    FT_SetDataCharacteristics(handle, FT_BITS_8, FT_STOP_BITS_1, FT_PARITY_NONE) != FT_OK ||
+	    FT_SetFlowControl(handle, FT_FLOW_NONE, 0, 0) != FT_OK ||
+	    FT_SetTimeouts(handle, FTDI_D2XX_READ_TIMEOUT, FTDI_D2XX_READ_TIMEOUT) != FT_OK) {
+		fprintf(stderr, "Could not configure the FTDI device.");
+		ftdi_d2xx_close();
+		return -1;
+	}
+
+#ifdef WIN32
+	received = CreateEvent(NULL, FALSE, FALSE, NULL);
+	status = FT_SetEventNotification(handle, FT_EVENT_RXCHAR, (PVOID)received);
+#else
+	pthread_mutex_init(&received.eMutex, NULL);
+	pthread_cond_init(&received.eCondVar, NULL);
+	received_ready = 1;
+	status = FT_SetEventNotification(handle, FT_EVENT_RXCHAR, (PVOID)&received);
+#endif
+	if (status != FT_OK) {
+		fprintf(stderr, "Could not set up FTDI receive events.");
+		ftdi_d2xx_close();
+		return -1;
+	}
+
+	FT_Purge(handle, FT_PURGE_RX | FT_PURGE_TX);
+	return SERIAL_FTDI_D2XX_FD;
+}
+
+int ftdi_d2xx_setup(long speed)
+{
+	if (FT_SetBaudRate(handle, speed) != FT_OK)
+		return -1;
+	FT_Purge(handle, FT_PURGE_RX);
+	return 0;
+}
+
+int ftdi_d2xx_write(const char *buf, int size)
+{
+	DWORD written = 0;
+
+	if (FT_Write(handle, (LPVOID)buf, size, &written) != FT_OK ||
+	    (int)written != size) {
+		fprintf(stderr, "Error sending data");
+		return -1;
+	}
+	return written;
+}
+
+/*
+ * Waits for the receive event until something is queued or
+ * FTDI_D2XX_READ_TIMEOUT runs out. Returns the number of bytes queued.
+ */
+static DWORD wait_for_data(void)
+{
+	DWORD queued = 0;
+#ifdef WIN32
+	if (FT_GetQueueStatus(handle, &queued) == FT_OK && queued == 0) {
+		WaitForSingleObject(received, FTDI_D2XX_READ_TIMEOUT);
+		FT_GetQueueStatus(handle, &queued);
+	}
+#else
+	struct timeval now;
+	struct timespec until;
+	int ret = 0;
+
+	gettimeofday(&now, NULL);
+	until.tv_sec = now.tv_sec + FTDI_D2XX_READ_TIMEOUT / 1000;
+	until.tv_nsec = (now.tv_usec + (FTDI_D2XX_READ_TIMEOUT % 1000) * 1000) * 1000;
+	if (until.tv_nsec >= 1000000000) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+
+	/* The driver signals with the mutex held, so nothing is missed between
+	   looking at the queue and waiting. */
+	pthread_mutex_lock(&received.eMutex);
+	while (FT_GetQueueStatus(handle, &queued) == FT_OK && queued == 0 &&
+	       ret != ETIMEDOUT)
+		ret = pthread_cond_timedwait(&received.eCondVar, &received.eMutex, &until);
+	pthread_mutex_unlock(&received.eMutex);
+#endif
+	return queued;
+}
+
+/*
+ * Hands out whatever arrived, at most size bytes, waiting for the first one
+ * if needed. Returns the number of bytes read, 0 on timeout, or -1.
+ */
+int ftdi_d2xx_receive(char *buf, int size)
+{
+	DWORD queued, got = 0;
+
+	queued = wait_for_data();
+	if (queued == 0)
+		return 0;
+	if (queued > (DWORD)size)
+		queued = size;
+	if (FT_Read(handle, buf, queued, &got) != FT_OK)
+		return -1;
+	return got;
+}
+
+int ftdi_d2xx_close(void)
+{
+	if (handle != NULL) {
+		FT_SetEventNotification(handle, 0, NULL);
+		FT_Close(handle);
+		handle = NULL;
+	}
+#ifdef WIN32
+	if (received != NULL) {
+		CloseHandle(received);
+		received = NULL;
+	}
+#else
+	if (received_ready) {
+		pthread_cond_destroy(&received.eCondVar);
+		pthread_mutex_destroy(&received.eMutex);
+		received_ready = 0;
+	}
+#endif
+	return 0;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+/*
+ * FTDI D2XX transport for the v3 FT232RL
+ *
+ * Through the virtual COM port driver the FT232RL holds every reply shorter
+ * than a USB packet back until its 16ms latency timer runs out, which is
+ * what most binary mode round trips wait on. Going through D2XX instead
+ * lets the timer be set to FTDI_D2XX_LATENCY_TIMER, asks for large USB
+ * transfers, and wakes readers up on the driver's receive event instead of
+ * polling. Build with -DBP_FTDI_D2XX and -lftd2xx, then open the port
+ * "ftdi:" (first FTDI device found) or "ftdi:<serial number>"; the serial_*
+ * calls route to this file on their own.
+ *
+ * The VCP driver has to let go of the device first, on Linux that means
+ * unloading ftdi_sio.
+ */
+#ifndef FTDI_D2XX_H_
+#define FTDI_D2XX_H_
+
+/* Handle serial_open() returns for the D2XX device, never a valid fd. */
+#define SERIAL_FTDI_D2XX_FD       0x7FFFFFFE
+
+/* Milliseconds the FT232RL waits before sending a short packet, 1 to 255. */
+#define FTDI_D2XX_LATENCY_TIMER   2
+
+/* USB request sizes asked from the driver, multiples of 64 bytes. */
+#define FTDI_D2XX_IN_TRANSFER     65536
+#define FTDI_D2XX_OUT_TRANSFER    4096
+
+/* Milliseconds without data before a read gives up, like serial_read(). */
+#define FTDI_D2XX_READ_TIMEOUT    1000
+
+int ftdi_d2xx_open(const char *serial_number);
+int ftdi_d2xx_setup(long speed);
+int ftdi_d2xx_write(const char *buf, int size);
+int ftdi_d2xx_receive(char *buf, int size);
+int ftdi_d2xx_close(void);
+
+#endif
@@ -28,9 +28,32 @@
 #include <string.h>
 
 #include "serial.h"
+#ifdef BP_USB_BULK
+#include "usb_bulk.h"
+#endif
+#ifdef BP_FTDI_D2XX
+#include "ftdi_d2xx.h"
+#endif
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#endif
 extern int disable_comport;
 extern char *dumpfile;
+#ifdef WIN32
 extern HANDLE dumphandle;
+#endif
+
+/*
+ * Whatever the driver had on hand beyond what the caller asked for, so
+ * short replies read back to back cost one system call instead of one each.
+ */
+static struct {
+	int fd;
+	int head;
+	int tail;
+	char data[SERIAL_READ_AHEAD];
+} read_ahead = { -1, 0, 0 };
 /*
 #ifdef WIN32
 	int write(int fd, const void* buf, int len)
@@ -127,6 +150,14 @@ extern HANDLE dumphandle;
 */
 int serial_setup(int fd, speed_t speed)
 {
+#ifdef BP_USB_BULK
+	if (fd == SERIAL_USB_BULK_FD)
+		return 0;
+#endif
+#ifdef BP_FTDI_D2XX
+	if (fd == SERIAL_FTDI_D2XX_FD)
+		return ftdi_d2xx_setup(speed);
+#endif
 #ifdef WIN32
 	COMMTIMEOUTS timeouts;
 	DCB dcb = {0};
@@ -144,9 +175,10 @@ int serial_setup(int fd, speed_t speed)
 	}
 
 
-	timeouts.ReadIntervalTimeout = 100;
-	timeouts.ReadTotalTimeoutMultiplier = 10;
-	timeouts.ReadTotalTimeoutConstant = 100;
+	/* Return as soon as anything is there, or after SERIAL_READ_TIMEOUT. */
+	timeouts.ReadIntervalTimeout = MAXDWORD;
+	timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+	timeouts.ReadTotalTimeoutConstant = SERIAL_READ_TIMEOUT;
 	timeouts.WriteTotalTimeoutMultiplier = 10;
 	timeouts.WriteTotalTimeoutConstant = 100;
 
@@ -171,10 +203,22 @@ int serial_setup(int fd, speed_t speed)
 	t_opt.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
 	t_opt.c_iflag &= ~(IXON | IXOFF | IXANY);
 	t_opt.c_oflag &= ~OPOST;
+	/* Reads never block, serial_fill() waits in select() instead. */
 	t_opt.c_cc[VMIN] = 0;
-	t_opt.c_cc[VTIME] = 10;
+	t_opt.c_cc[VTIME] = 0;
 	tcflush(fd, TCIFLUSH);
 	tcsetattr(fd, TCSANOW, &t_opt);
+#ifdef __linux__
+	{
+		/* FTDI and friends otherwise hold small replies back for up to 16ms. */
+		struct serial_struct serinfo;
+
+		if (ioctl(fd, TIOCGSERIAL, &serinfo) == 0) {
+			serinfo.flags |= ASYNC_LOW_LATENCY;
+			ioctl(fd, TIOCSSERIAL, &serinfo);
+		}
+	}
+#endif
 #endif
 	return 0;
 }
@@ -182,6 +226,14 @@ int serial_setup(int fd, speed_t speed)
 int serial_write(int fd, char *buf, int size)
 {
 	int ret = 0;
+#ifdef BP_USB_BULK
+	if (fd == SERIAL_USB_BULK_FD)
+		return usb_bulk_write(buf, size);
+#endif
+#ifdef BP_FTDI_D2XX
+	if (fd == SERIAL_FTDI_D2XX_FD)
+		return ftdi_d2xx_write(buf, size);
+#endif
 #ifdef WIN32
 	HANDLE hCom = (HANDLE)fd;
 	int res = 0;
@@ -216,45 +268,164 @@ int serial_write(int fd, char *buf, int size)
 
 }
 
-int serial_read(int fd, char *buf, int size)
+/*
+ * Sends several buffers as few writes as possible, so a burst of commands
+ * goes out in one USB packet instead of one each. Returns the number of
+ * bytes written, or -1.
+ */
+int serial_writev(int fd, const struct serial_chunk *chunks, int count)
 {
-	int len = 0;
-	int ret = 0;
-#ifndef WIN32
-	int timeout = 0;
+	char batch[SERIAL_WRITE_BATCH];
+	int used = 0;
+	int total = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		const char *data = chunks[i].data;
+		int left = chunks[i].size;
+
+		while (left > 0) {
+			int part = SERIAL_WRITE_BATCH - used;
+
+			if (part > left)
+				part = left;
+			memcpy(batch + used, data, part);
+			used += part;
+			data += part;
+			left -= part;
+
+			if (used == SERIAL_WRITE_BATCH) {
+				if (serial_write(fd, batch, used) != used)
+					return -1;
+				total += used;
+				used = 0;
+			}
+		}
+	}
+
+	if (used > 0) {
+		if (serial_write(fd, batch, used) != used)
+			return -1;
+		total += used;
+	}
+	return total;
+}
+
+/*
+ * Refills the read ahead buffer with whatever arrives first, waiting up to
+ * SERIAL_READ_TIMEOUT. Returns the number of bytes read, 0 on timeout.
+ */
+static int serial_fill(int fd)
+{
+#ifdef BP_FTDI_D2XX
+	if (fd == SERIAL_FTDI_D2XX_FD) {
+		int got = ftdi_d2xx_receive(read_ahead.data, SERIAL_READ_AHEAD);
+
+		if (got > 0) {
+			read_ahead.head = 0;
+			read_ahead.tail = got;
+		}
+		return got;
+	}
 #endif
 #ifdef WIN32
 	HANDLE hCom = (HANDLE)fd;
 	unsigned long bread = 0;
 
-	ret = ReadFile(hCom, buf, size, &bread, NULL);
+	if (ReadFile(hCom, read_ahead.data, SERIAL_READ_AHEAD, &bread, NULL) == FALSE)
+		return -1;
+	read_ahead.head = 0;
+	read_ahead.tail = bread;
+	return bread;
+#else
+	fd_set fds;
+	struct timeval tv;
+	int ret;
 
-	if( ret == FALSE || ret==-1 || bread<1) {
-		len= -1;
-	} else {
-		len=bread;
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	tv.tv_sec = SERIAL_READ_TIMEOUT / 1000;
+	tv.tv_usec = (SERIAL_READ_TIMEOUT % 1000) * 1000;
+
+	ret = select(fd + 1, &fds, NULL, NULL, &tv);
+	if (ret <= 0)
+		return ret;
+
+	ret = read(fd, read_ahead.data, SERIAL_READ_AHEAD);
+	if (ret < 0)
+		return -1;
+	read_ahead.head = 0;
+	read_ahead.tail = ret;
+	return ret;
+#endif
+}
+
+/*
+ * Hands out whatever is buffered without copying it, waiting up to
+ * SERIAL_READ_TIMEOUT if nothing is. The data stays valid until the next
+ * read on fd. Returns the number of bytes, 0 on timeout, or -1.
+ */
+int serial_borrow(int fd, const char **data)
+{
+	int ret;
+
+	if (read_ahead.fd != fd) {
+		read_ahead.fd = fd;
+		read_ahead.head = read_ahead.tail = 0;
 	}
 
-#else
-	while (len < size) {
-		ret = read(fd, buf+len, size-len);
-		if (ret == -1){
-			//printf("ret -1");
-			return -1;
-		}
+	if (read_ahead.head == read_ahead.tail) {
+#ifdef BP_USB_BULK
+		if (fd == SERIAL_USB_BULK_FD) {
+			read_ahead.head = 0;
+			read_ahead.tail = 0;
+			ret = usb_bulk_read(read_ahead.data, USB_BULK_PACKET_SIZE);
+			if (ret > 0)
+				read_ahead.tail = ret;
+		} else
+#endif
+		ret = serial_fill(fd);
+		if (ret <= 0)
+			return ret;
+	}
 
-		if (ret == 0) {
-			timeout++;
+	*data = read_ahead.data + read_ahead.head;
+	ret = read_ahead.tail - read_ahead.head;
+	read_ahead.head = read_ahead.tail;
+	return ret;
+}
 
-			if (timeout >= 10)
-				break;
+int serial_read(int fd, char *buf, int size)
+{
+	int len = 0;
+	int ret = 0;
+#ifdef BP_USB_BULK
+	if (fd == SERIAL_USB_BULK_FD)
+		return usb_bulk_read(buf, size);
+#endif
+	if (read_ahead.fd != fd) {
+		read_ahead.fd = fd;
+		read_ahead.head = read_ahead.tail = 0;
+	}
+
+	while (len < size) {
+		int part;
 
-			continue;
+		if (read_ahead.head == read_ahead.tail) {
+			ret = serial_fill(fd);
+			if (ret < 0)
+				return (len > 0) ? len : -1;
+			if (ret == 0)
+				break;
 		}
 
-		len += ret;
+		part = read_ahead.tail - read_ahead.head;
+		if (part > size - len)
+			part = size - len;
+		memcpy(buf + len, read_ahead.data + read_ahead.head, part);
+		read_ahead.head += part;
+		len += part;
 	}
-#endif
 	//printf("should have read = %i actual size = %i \n", size, len);
 	//fprintf(stderr, "should have read = %d actual size = %d \n", size, len);
 	//buspirate_print_buffer(buf, len);
@@ -265,6 +436,16 @@ return len;
 int serial_open(char *port)
 {
 	int fd;
+#ifdef BP_USB_BULK
+	/* "usb:" or "usb:<serial number>" picks the v4 vendor bulk pipe. */
+	if (strncmp(port, "usb:", 4) == 0)
+		return usb_bulk_open(port + 4);
+#endif
+#ifdef BP_FTDI_D2XX
+	/* "ftdi:" or "ftdi:<serial number>" goes through D2XX, v3 only. */
+	if (strncmp(port, "ftdi:", 5) == 0)
+		return ftdi_d2xx_open(port + 5);
+#endif
 #ifdef WIN32
 	static char full_path[32] = {0};
 
@@ -303,6 +484,16 @@ int serial_open(char *port)
 
 int serial_close(int fd)
 {
+	if (read_ahead.fd == fd)
+		read_ahead.fd = -1;
+#ifdef BP_USB_BULK
+	if (fd == SERIAL_USB_BULK_FD)
+		return usb_bulk_close();
+#endif
+#ifdef BP_FTDI_D2XX
+	if (fd == SERIAL_FTDI_D2XX_FD)
+		return ftdi_d2xx_close();
+#endif
 #ifdef WIN32
 	HANDLE hCom = (HANDLE)fd;
 
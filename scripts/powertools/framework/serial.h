@@ -79,9 +79,23 @@ typedef long speed_t;
 
 #endif
 
+/* How long serial_read waits for more data before returning short, in ms. */
+#define SERIAL_READ_TIMEOUT 1000
+/* Bytes the driver is asked for at once, the rest is kept for the next read. */
+#define SERIAL_READ_AHEAD 4096
+/* Largest single write serial_writev gathers its chunks into. */
+#define SERIAL_WRITE_BATCH 4096
+
+struct serial_chunk {
+	const char *data;
+	int size;
+};
+
 int serial_setup(int fd, speed_t speed);
 int serial_write(int fd, char *buf, int size);
+int serial_writev(int fd, const struct serial_chunk *chunks, int count);
 int serial_read(int fd, char *buf, int size);
+int serial_borrow(int fd, const char **data);
 int serial_open(char *port);
 int serial_close(int fd);
 
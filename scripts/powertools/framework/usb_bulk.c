@@ -0,0 +1,295 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifdef BP_USB_BULK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libusb-1.0/libusb.h>
+
+#include "usb_bulk.h"
+
+/* Received data not handed to usb_bulk_read() yet, a ring as large as
+   every IN transfer filled up at once, plus what was already waiting. */
+#define USB_BULK_RING_SIZE (2 * USB_BULK_TRANSFERS * USB_BULK_TRANSFER_SIZE)
+
+static libusb_context *context;
+static libusb_device_handle *handle;
+
+static struct libusb_transfer *in_transfers[USB_BULK_TRANSFERS];
+static struct libusb_transfer *out_transfers[USB_BULK_TRANSFERS];
+static int in_held[USB_BULK_TRANSFERS];
+static int out_busy[USB_BULK_TRANSFERS];
+static int in_flight;
+static int failed;
+
+static unsigned char ring[USB_BULK_RING_SIZE];
+static int ring_head, ring_count;
+
+static void in_done(struct libusb_transfer *transfer)
+{
+	int i, first;
+
+	if (transfer->status != LIBUSB_TRANSFER_COMPLETED &&
+	    transfer->status != LIBUSB_TRANSFER_TIMED_OUT) {
+		in_flight--;
+		if (transfer->status != LIBUSB_TRANSFER_CANCELLED)
+			failed = 1;
+		return;
+	}
+
+	if (transfer->actual_length > USB_BULK_RING_SIZE - ring_count) {
+		/* Nobody is reading, hold the data back instead of losing it. */
+		in_held[(int)(long)transfer->user_data] = 1;
+		in_flight--;
+		return;
+	}
+
+	for (i = 0; i < transfer->actual_length; i += first) {
+		int tail = (ring_head + ring_count) % USB_BULK_RING_SIZE;
+
+		first = transfer->actual_length - i;
+		if (first > USB_BULK_RING_SIZE - tail)
+			first = USB_BULK_RING_SIZE - tail;
+		memcpy(&ring[tail], &transfer->buffer[i], first);
+		ring_count += first;
+	}
+
+	if (libusb_submit_transfer(transfer) != 0) {
+		in_flight--;
+		failed = 1;
+	}
+}
+
+static void out_done(struct libusb_transfer *transfer)
+{
+	if (transfer->status != LIBUSB_TRANSFER_COMPLETED ||
+	    transfer->actual_length != transfer->length)
+		failed = 1;
+	out_busy[(int)(long)transfer->user_data] = 0;
+}
+
+static void resume_reads(void)
+{
+	int i;
+
+	/* Transfers held back by a full ring store their data and go out
+	   again once there is room for it. */
+	for (i = 0; i < USB_BULK_TRANSFERS; i++) {
+		if (!in_held[i] ||
+		    in_transfers[i]->actual_length > USB_BULK_RING_SIZE - ring_count)
+			continue;
+		in_held[i] = 0;
+		in_flight++;
+		in_done(in_transfers[i]);
+	}
+}
+
+static int handle_events(int milliseconds)
+{
+	struct timeval tv;
+
+	tv.tv_sec = milliseconds / 1000;
+	tv.tv_usec = (milliseconds % 1000) * 1000;
+	return libusb_handle_events_timeout_completed(context, &tv, NULL);
+}
+
+static int open_device(const char *serial_number)
+{
+	libusb_device **list;
+	ssize_t count, i;
+	int found = 0;
+
+	count = libusb_get_device_list(context, &list);
+	for (i = 0; i < count && !found; i++) {
+		struct libusb_device_descriptor descriptor;
+		unsigned char text[64];
+
+		if (libusb_get_device_descriptor(list[i], &descriptor) != 0 ||
+		    descriptor.idVendor != USB_BULK_VID ||
+		    descriptor.idProduct != USB_BULK_PID)
+			continue;
+		if (libusb_open(list[i], &handle) != 0)
+			continue;
+		if (serial_number == NULL || *serial_number == '\0' ||
+		    (libusb_get_string_descriptor_ascii(handle, descriptor.iSerialNumber,
+			    text, sizeof(text)) > 0 &&
+		     strcmp((char *)text, serial_number) == 0)) {
+			found = 1;
+		} else {
+			libusb_close(handle);
+			handle = NULL;
+		}
+	}
+	if (count >= 0)
+		libusb_free_device_list(list, 1);
+	return found;
+}
+
+int usb_bulk_open(const char *serial_number)
+{
+	int i;
+
+	if (libusb_init(&context) != 0)
+		return -1;
+
+	if (!open_device(serial_number)) {
+		fprintf(stderr, "No Bus Pirate with a vendor bulk interface found.");
+		libusb_exit(context);
+		return -1;
+	}
+	if (libusb_claim_interface(handle, USB_BULK_INTERFACE) != 0) {
+		fprintf(stderr, "Could not claim the vendor bulk interface.");
+		usb_bulk_close();
+		return -1;
+	}
+
+	ring_head = 0;
+	ring_count = 0;
+	in_flight = 0;
+	failed = 0;
+	for (i = 0; i < USB_BULK_TRANSFERS; i++) {
+		unsigned char *buffer = malloc(USB_BULK_TRANSFER_SIZE);
+
+		in_transfers[i] = libusb_alloc_transfer(0);
+		libusb_fill_bulk_transfer(in_transfers[i], handle, USB_BULK_ENDPOINT_IN,
+			buffer, USB_BULK_TRANSFER_SIZE, in_done, (void *)(long)i, 0);
+		in_held[i] = 0;
+		if (libusb_submit_transfer(in_transfers[i]) == 0)
+			in_flight++;
+
+		out_transfers[i] = libusb_alloc_transfer(0);
+		libusb_fill_bulk_transfer(out_transfers[i], handle, USB_BULK_ENDPOINT_OUT,
+			malloc(USB_BULK_TRANSFER_SIZE), 0, out_done, (void *)(long)i, 0);
+		out_busy[i] = 0;
+	}
+	if (in_flight == 0) {
+		usb_bulk_close();
+		return -1;
+	}
+	return SERIAL_USB_BULK_FD;
+}
+
+int usb_bulk_write(const char *buf, int size)
+{
+	int sent = 0, i, busy;
+
+	while (sent < size && !failed) {
+		for (i = 0; i < USB_BULK_TRANSFERS && sent < size; i++) {
+			int chunk = size - sent;
+
+			if (out_busy[i])
+				continue;
+			if (chunk > USB_BULK_TRANSFER_SIZE)
+				chunk = USB_BULK_TRANSFER_SIZE;
+			memcpy(out_transfers[i]->buffer, &buf[sent], chunk);
+			out_transfers[i]->length = chunk;
+			out_busy[i] = 1;
+			if (libusb_submit_transfer(out_transfers[i]) != 0) {
+				out_busy[i] = 0;
+				failed = 1;
+				break;
+			}
+			sent += chunk;
+		}
+		if (sent < size)
+			handle_events(USB_BULK_READ_TIMEOUT);
+	}
+
+	/* serial_write() returns once the data left, keep that promise. */
+	do {
+		busy = 0;
+		for (i = 0; i < USB_BULK_TRANSFERS; i++)
+			busy |= out_busy[i];
+		if (busy)
+			handle_events(USB_BULK_READ_TIMEOUT);
+	} while (busy && !failed);
+
+	if (failed) {
+		fprintf(stderr, "Error sending data");
+		return -1;
+	}
+	return sent;
+}
+
+int usb_bulk_read(char *buf, int size)
+{
+	int len = 0;
+	int idle = 0;
+
+	while (len < size) {
+		int first;
+
+		if (ring_count == 0) {
+			if (failed && in_flight == 0)
+				return len ? len : -1;
+			if (idle >= USB_BULK_READ_TIMEOUT / 100)
+				break;
+			handle_events(100);
+			if (ring_count == 0)
+				idle++;
+			continue;
+		}
+
+		first = ring_count;
+		if (first > size - len)
+			first = size - len;
+		if (first > USB_BULK_RING_SIZE - ring_head)
+			first = USB_BULK_RING_SIZE - ring_head;
+		memcpy(&buf[len], &ring[ring_head], first);
+		ring_head = (ring_head + first) % USB_BULK_RING_SIZE;
+		ring_count -= first;
+		len += first;
+		idle = 0;
+		resume_reads();
+	}
+	return len;
+}
+
+int usb_bulk_close(void)
+{
+	int i;
+
+	if (handle != NULL) {
+		for (i = 0; i < USB_BULK_TRANSFERS; i++)
+			if (in_transfers[i] != NULL)
+				libusb_cancel_transfer(in_transfers[i]);
+		while (in_flight > 0 && handle_events(100) == 0)
+			;
+		for (i = 0; i < USB_BULK_TRANSFERS; i++) {
+			if (in_transfers[i] != NULL) {
+				free(in_transfers[i]->buffer);
+				libusb_free_transfer(in_transfers[i]);
+				in_transfers[i] = NULL;
+			}
+			if (out_transfers[i] != NULL) {
+				free(out_transfers[i]->buffer);
+				libusb_free_transfer(out_transfers[i]);
+				out_transfers[i] = NULL;
+			}
+		}
+		libusb_release_interface(handle, USB_BULK_INTERFACE);
+		libusb_close(handle);
+		handle = NULL;
+	}
+	libusb_exit(context);
+	context = NULL;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * This file is part of the Bus Pirate project (http://code.google.com/p/the-bus-pirate/).
+ *
+ * Written and maintained by the Bus Pirate project and http://dangerousprototypes.com
+ *
+ * To the extent possible under law, the project has
+ * waived all copyright and related or neighboring rights to Bus Pirate. This
+ * work is published from United States.
+ *
+ * For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+/*
+ * libusb transport for the v4 vendor bulk interface
+ *
+ * Firmware built with BP_USB_VENDOR_INTERFACE exposes a vendor specific
+ * bulk pipe next to the CDC one, carrying the same binary mode traffic
+ * without a tty in the way. Build with -DBP_USB_BULK and -lusb-1.0, then
+ * open the port "usb:" (first board found) or "usb:<serial number>"; the
+ * serial_* calls route to this file on their own.
+ *
+ * Several IN transfers are kept queued all the time so the host controller
+ * polls the endpoint every frame, and writes are split over several OUT
+ * transfers in flight, which is what gets the pipe near full speed USB
+ * bulk rates.
+ */
+#ifndef USB_BULK_H_
+#define USB_BULK_H_
+
+/* Handle serial_open() returns for the bulk pipe, never a valid fd. */
+#define SERIAL_USB_BULK_FD     0x7FFFFFFF
+
+#define USB_BULK_VID           0x04D8
+#define USB_BULK_PID           0xFB00
+#define USB_BULK_INTERFACE     2
+#define USB_BULK_ENDPOINT_OUT  0x03
+#define USB_BULK_ENDPOINT_IN   0x83
+#define USB_BULK_PACKET_SIZE   64
+
+/* Transfers queued in each direction, and the size of each. */
+#define USB_BULK_TRANSFERS     8
+#define USB_BULK_TRANSFER_SIZE 4096
+
+/* Milliseconds without data before a read gives up, like serial_read(). */
+#define USB_BULK_READ_TIMEOUT  1000
+
+int usb_bulk_open(const char *serial_number);
+int usb_bulk_write(const char *buf, int size);
+int usb_bulk_read(char *buf, int size);
+int usb_bulk_close(void);
+
+#endif
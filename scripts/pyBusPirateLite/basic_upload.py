@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Uploads a BASIC listing to the interpreter in one transfer.
+
+The listing is tokenised here by pyBusPirateLite.BASIC and sent with the
+interpreter UPLOAD command, checksum included, then run if asked to.  The
+Bus Pirate has to be at the terminal prompt, in the mode the program uses.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import optparse
+import sys
+
+import serial
+
+from pyBusPirateLite.BASIC import BASIC, BASICError, tokenise
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options] program.bas", version="%prog 1.0")
+
+	parser.add_option("-d", "--device",
+						dest="device", default="/dev/ttyUSB0",
+						help="Serial port the Bus Pirate is on [default: %default]", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-r", "--run",
+						dest="run", default=False, action="store_true",
+						help="Run the program once uploaded")
+	parser.add_option("-t", "--timeout",
+						dest="timeout", default=10,
+						help="Seconds to wait for the program to end [default: %default]", type="float")
+
+	(options, args) = parser.parse_args()
+	if len(args) != 1:
+		parser.error("one BASIC listing expected")
+	return (options, args[0])
+
+if __name__ == '__main__':
+	(options, filename) = parse_prog_args()
+
+	try:
+		with open(filename) as listing:
+			image = tokenise(listing.read())
+		print("%d bytes tokenised" % len(image), file=sys.stderr)
+		basic = BASIC(options.device, options.baud_rate)
+		output = basic.upload(image, options.run, options.timeout)
+		basic.close()
+	except (BASICError, IOError, serial.SerialException) as ex:
+		print("Error: %s" % ex, file=sys.stderr)
+		sys.exit(1)
+	except KeyboardInterrupt:
+		sys.exit(1)
+
+	sys.stdout.write(output.decode("ascii", "replace"))
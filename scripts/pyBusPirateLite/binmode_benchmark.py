@@ -0,0 +1,335 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Binary mode throughput and latency benchmark.
+
+Measures how many payload bytes per second each binary mode sustains, and
+how long a single command round trip takes, against a loopback fixture (or
+nothing at all: the SPI, I2C, UART, 1-Wire and OpenOCD commands used here do
+not need a target to answer).
+
+Results are printed as one JSON object per benchmark, so runs against two
+firmware builds can be diffed or fed to a tracking script.
+
+The startup benchmark is not run by default, as it restarts the board: it
+measures the time from reset to the first binary mode handshake, either
+resetting the board from the terminal (v3) or waiting for it to be
+power-cycled or replugged by hand or by the fixture (v4, where '#' does not
+restart the board and the serial device node goes away).
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import json
+import optparse
+import os
+import sys
+import time
+
+import serial
+
+BBIO_RESET = b"\x00"
+BBIO_IDENTIFIER = b"BBIO1"
+BBIO_EXIT_TO_TERMINAL = b"\x0F"
+
+REPORT_IO_SUCCESS = b"\x01"
+
+STARTUP_POLL_INTERVAL = 0.001
+STARTUP_TIMEOUT = 30.0
+
+class BenchmarkError(Exception):
+	pass
+
+class BusPirate:
+	def __init__(self, device, speed, timeout):
+		self.port = serial.Serial(device, speed, timeout=timeout)
+
+	def expect(self, data, what):
+		received = self.port.read(len(data))
+		if received != data:
+			raise BenchmarkError("%s: expected %r, got %r" % (what, data, received))
+
+	def read_exactly(self, count, what):
+		received = self.port.read(count)
+		if len(received) != count:
+			raise BenchmarkError("%s: expected %d bytes, got %d" % (what, count, len(received)))
+		return received
+
+	def enter_bbio(self):
+		self.port.reset_input_buffer()
+		for attempt in range(25):
+			self.port.write(BBIO_RESET)
+			time.sleep(0.01)
+			if self.port.in_waiting >= len(BBIO_IDENTIFIER):
+				break
+		data = self.port.read(self.port.in_waiting or len(BBIO_IDENTIFIER))
+		if not data.endswith(BBIO_IDENTIFIER):
+			raise BenchmarkError("could not enter binary mode, got %r" % data)
+
+	def enter_mode(self, command, identifier):
+		self.port.write(bytes([command]))
+		self.expect(identifier, "entering mode")
+
+	def leave_mode(self):
+		self.port.write(BBIO_RESET)
+		self.expect(BBIO_IDENTIFIER, "leaving mode")
+
+	def exit_to_terminal(self):
+		self.port.write(BBIO_RESET)
+		self.port.write(BBIO_EXIT_TO_TERMINAL)
+		time.sleep(0.1)
+		self.port.reset_input_buffer()
+
+def percentile(samples, fraction):
+	ordered = sorted(samples)
+	index = min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))
+	return ordered[index]
+
+def measure(transaction, payload_size, iterations):
+	"""Run transaction() iterations times, returning per-call timings."""
+	timings = []
+	started = time.perf_counter()
+	for i in range(iterations):
+		before = time.perf_counter()
+		transaction()
+		timings.append(time.perf_counter() - before)
+	elapsed = time.perf_counter() - started
+	return {
+		"payload_bytes": payload_size,
+		"iterations": iterations,
+		"elapsed_s": round(elapsed, 6),
+		"bytes_per_second": round((payload_size * iterations) / elapsed, 1) if elapsed > 0 else None,
+		"latency_p50_ms": round(percentile(timings, 0.50) * 1000, 3),
+		"latency_p99_ms": round(percentile(timings, 0.99) * 1000, 3),
+	}
+
+def bulk_transfer(bp, size):
+	"""0x1x bulk transfer, shared by the SPI, I2C, UART and 1-Wire modes.
+
+	All of them answer with a success code, then one byte per byte sent.
+	"""
+	command = bytes([0x10 | (size - 1)]) + bytes(range(size))
+	def transaction():
+		bp.port.write(command)
+		bp.expect(REPORT_IO_SUCCESS, "bulk transfer")
+		bp.read_exactly(size, "bulk transfer data")
+	return transaction
+
+def spi_write_then_read(bp, size):
+	"""0x05 write-then-read without CS, writing and reading size bytes."""
+	command = bytes([0x05, size >> 8, size & 0xFF, size >> 8, size & 0xFF]) + bytes(size)
+	def transaction():
+		bp.port.write(command)
+		bp.expect(REPORT_IO_SUCCESS, "write-then-read")
+		bp.read_exactly(size, "write-then-read data")
+	return transaction
+
+def openocd_tap_shift(bp, bits):
+	"""0x05 TAP shift, sending TDI/TMS byte pairs and reading TDO back."""
+	size = (bits + 7) // 8
+	command = bytes([0x05, bits >> 8, bits & 0xFF]) + bytes(2 * size)
+	def transaction():
+		bp.port.write(command)
+		bp.expect(bytes([0x05, bits >> 8, bits & 0xFF]), "TAP shift")
+		bp.read_exactly(size, "TAP shift data")
+	return transaction
+
+def wait_for_handshake(device, speed, timeout, deadline):
+	"""Keep opening the port and sending resets until the board answers.
+
+	Returns the open port and when the handshake came back.
+	"""
+	port = None
+	received = b""
+	while time.perf_counter() < deadline:
+		if port is None:
+			try:
+				port = serial.Serial(device, speed, timeout=0)
+			except serial.SerialException:
+				time.sleep(STARTUP_POLL_INTERVAL)
+				continue
+		try:
+			port.write(BBIO_RESET)
+			time.sleep(STARTUP_POLL_INTERVAL)
+			received = (received + port.read(port.in_waiting))[-len(BBIO_IDENTIFIER):]
+		except serial.SerialException:
+			# gone again while enumerating
+			port.close()
+			port = None
+			continue
+		if received == BBIO_IDENTIFIER:
+			answered = time.perf_counter()
+			port.timeout = timeout
+			return (port, answered)
+	if port is not None:
+		port.close()
+	raise BenchmarkError("no binary mode handshake within %.0fs of startup" % STARTUP_TIMEOUT)
+
+def wait_for_replug(device):
+	"""When the device node comes back after going away."""
+	deadline = time.perf_counter() + STARTUP_TIMEOUT
+	print("Power-cycle or replug the board on %s" % device, file=sys.stderr)
+	while os.path.exists(device):
+		if time.perf_counter() > deadline:
+			raise BenchmarkError("%s never went away" % device)
+		time.sleep(STARTUP_POLL_INTERVAL)
+	while not os.path.exists(device):
+		if time.perf_counter() > deadline:
+			raise BenchmarkError("%s never came back" % device)
+		time.sleep(STARTUP_POLL_INTERVAL)
+	return time.perf_counter()
+
+def benchmark_startup(bp, options):
+	timings = []
+	for cycle in range(options.startup_cycles):
+		if options.startup == "replug":
+			bp.port.close()
+			started = wait_for_replug(options.dev_name)
+		else:
+			bp.exit_to_terminal()
+			bp.port.write(b"#\r")
+			bp.port.flush()
+			started = time.perf_counter()
+			bp.port.close()
+		(port, answered) = wait_for_handshake(options.dev_name, options.baud_rate,
+			bp.port.timeout, started + STARTUP_TIMEOUT)
+		bp.port = port
+		timings.append(answered - started)
+	return [("time_to_first_command", {
+		"iterations": len(timings),
+		"trigger": options.startup,
+		"latency_p50_ms": round(percentile(timings, 0.50) * 1000, 3),
+		"latency_max_ms": round(max(timings) * 1000, 3),
+	})]
+
+def benchmark_spi(bp, options):
+	bp.enter_mode(0x01, b"SPI1")
+	bp.port.write(bytes([0x60 | 0b111]))	# 8MHz
+	bp.expect(REPORT_IO_SUCCESS, "SPI speed")
+	results = [
+		("bulk_1", measure(bulk_transfer(bp, 1), 1, options.latency_iterations)),
+		("bulk_16", measure(bulk_transfer(bp, 16), 16, options.iterations)),
+		("write_then_read_4096", measure(spi_write_then_read(bp, 4096), 8192, max(1, options.iterations // 16))),
+	]
+	bp.leave_mode()
+	return results
+
+def benchmark_i2c(bp, options):
+	bp.enter_mode(0x02, b"I2C1")
+	bp.port.write(bytes([0x60 | 0x03]))	# 400kHz
+	bp.expect(REPORT_IO_SUCCESS, "I2C speed")
+	results = [
+		("bulk_1", measure(bulk_transfer(bp, 1), 1, options.latency_iterations)),
+		("bulk_16", measure(bulk_transfer(bp, 16), 16, options.iterations)),
+	]
+	bp.leave_mode()
+	return results
+
+def benchmark_uart(bp, options):
+	bp.enter_mode(0x03, b"ART1")
+	bp.port.write(bytes([0x60 | 0b1001]))	# 115200bps
+	bp.expect(REPORT_IO_SUCCESS, "UART speed")
+	results = [
+		("bulk_1", measure(bulk_transfer(bp, 1), 1, options.latency_iterations)),
+		("bulk_16", measure(bulk_transfer(bp, 16), 16, options.iterations)),
+	]
+	bp.leave_mode()
+	return results
+
+def benchmark_1wire(bp, options):
+	bp.enter_mode(0x04, b"1W01")
+	results = [
+		("bulk_1", measure(bulk_transfer(bp, 1), 1, options.latency_iterations)),
+		("bulk_16", measure(bulk_transfer(bp, 16), 16, options.iterations)),
+	]
+	bp.leave_mode()
+	return results
+
+def benchmark_openocd(bp, options):
+	bp.enter_mode(0x06, b"OCD1")
+	results = [
+		("tap_shift_8", measure(openocd_tap_shift(bp, 8), 1, options.latency_iterations)),
+		("tap_shift_8192", measure(openocd_tap_shift(bp, 8192), 1024, max(1, options.iterations // 16))),
+		("tap_shift_65528", measure(openocd_tap_shift(bp, 65528), 8191, max(1, options.iterations // 128))),
+	]
+	bp.leave_mode()
+	return results
+
+BENCHMARKS = {
+	"spi": benchmark_spi,
+	"i2c": benchmark_i2c,
+	"uart": benchmark_uart,
+	"1wire": benchmark_1wire,
+	"openocd": benchmark_openocd,
+	"startup": benchmark_startup,
+}
+
+DEFAULT_MODES = [mode for mode in sorted(BENCHMARKS) if mode != "startup"]
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options]", version="%prog 1.0")
+
+	parser.add_option("-d", "--dev",
+						dest="dev_name", default="/dev/ttyUSB0",
+						help="The device to connect to", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-m", "--modes",
+						dest="modes", default=",".join(DEFAULT_MODES),
+						help="Comma separated modes to benchmark [default: %default]", type="string")
+	parser.add_option("-n", "--iterations",
+						dest="iterations", default=256,
+						help="Iterations for throughput benchmarks [default: %default]", type="int")
+	parser.add_option("-l", "--latency-iterations",
+						dest="latency_iterations", default=1000,
+						help="Iterations for latency benchmarks [default: %default]", type="int")
+	parser.add_option("-s", "--startup",
+						dest="startup", default="reset", choices=["reset", "replug"],
+						help="How the startup benchmark restarts the board, reset from the terminal or replug [default: %default]")
+	parser.add_option("-c", "--startup-cycles",
+						dest="startup_cycles", default=5,
+						help="Restarts for the startup benchmark [default: %default]", type="int")
+	parser.add_option("-t", "--label",
+						dest="label", default="",
+						help="Free form label (e.g. firmware build) added to every result", type="string")
+
+	(options, args) = parser.parse_args()
+	for mode in options.modes.split(","):
+		if mode not in BENCHMARKS:
+			parser.error("unknown mode %r" % mode)
+	return options
+
+if __name__ == '__main__':
+	options = parse_prog_args()
+
+	try:
+		bp = BusPirate(options.dev_name, options.baud_rate, 2)
+	except serial.SerialException as ex:
+		print(ex, file=sys.stderr)
+		sys.exit(1)
+
+	failed = False
+	try:
+		for mode in options.modes.split(","):
+			bp.enter_bbio()
+			try:
+				results = BENCHMARKS[mode](bp, options)
+			except BenchmarkError as ex:
+				print(json.dumps({"label": options.label, "mode": mode, "error": str(ex)}))
+				failed = True
+				continue
+			for (name, result) in results:
+				result.update({"label": options.label, "mode": mode, "benchmark": name})
+				print(json.dumps(result, sort_keys=True))
+				sys.stdout.flush()
+	finally:
+		bp.exit_to_terminal()
+
+	sys.exit(1 if failed else 0)
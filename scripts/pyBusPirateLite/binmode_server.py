@@ -0,0 +1,208 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Network bridge that runs batched binary mode command scripts next to the board.
+
+Tunnelling the serial port over the network costs one round trip per command.
+This daemon keeps the port open locally and takes whole scripts instead: a
+client sends one JSON request per line, the daemon plays every step of it
+against the board back to back, and sends all the answers in one JSON reply
+line.  A batch costs a single network round trip however many bus
+transactions it holds.
+
+A request looks like
+
+	{"id": 1, "steps": [{"write": "00", "read": 5, "expect": "4242494f31"},
+		{"write": "01", "read": 4}, {"write": "1103aabbcc", "read": 4}]}
+
+"write" is sent as is (hexadecimal), then exactly "read" bytes are waited for.
+When "expect" is there and the answer differs, the batch stops at that step.
+With "pipeline": true every write goes out at once and the answers are split
+afterwards, which is only safe as long as the whole batch fits in the
+firmware's receive buffer.  The reply is
+
+	{"id": 1, "ok": true, "results": ["4242494f31", "53504931", "01..."],
+		"elapsed_ms": 1.234}
+
+with "error" and "step" instead of "ok": true when a step timed out or did not
+match.  Clients are served one batch at a time, in the order they arrive, so a
+batch never sees another client's bytes in between its own.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import binascii
+import json
+import optparse
+import socket
+import socketserver
+import sys
+import threading
+import time
+
+import serial
+
+# Largest request line accepted, in bytes.
+MAX_REQUEST = 1 << 20
+
+class BatchError(Exception):
+	def __init__(self, step, message):
+		Exception.__init__(self, message)
+		self.step = step
+
+class Board(object):
+	"""The serial port, shared by every client under a lock."""
+
+	def __init__(self, dev_name, baud_rate, timeout):
+		self.port = serial.Serial(dev_name, baud_rate, timeout=timeout)
+		self.lock = threading.Lock()
+		self.batches = 0
+
+	def run(self, steps, pipeline, results):
+		"""Plays a batch, adding the answer of every step played to results."""
+		with self.lock:
+			self.batches += 1
+			# whatever a previous batch left behind is not ours
+			self.port.reset_input_buffer()
+			if pipeline:
+				self.port.write(b"".join(step[0] for step in steps))
+				self.port.flush()
+				answer = self.port.read(sum(step[1] for step in steps))
+				offset = 0
+				for (index, (_, count, expect)) in enumerate(steps):
+					data = answer[offset:offset + count]
+					offset += count
+					results.append(data)
+					self.check(index, data, count, expect)
+			else:
+				for (index, (data, count, expect)) in enumerate(steps):
+					if data:
+						self.port.write(data)
+					received = self.port.read(count) if count else b""
+					results.append(received)
+					self.check(index, received, count, expect)
+
+	@staticmethod
+	def check(index, data, count, expect):
+		if len(data) != count:
+			raise BatchError(index, "timeout, %d of %d bytes" % (len(data), count))
+		if expect is not None and data != expect:
+			raise BatchError(index, "unexpected answer")
+
+def parse_steps(request):
+	steps = []
+	for step in request.get("steps", []):
+		data = binascii.unhexlify(step.get("write", ""))
+		count = int(step.get("read", 0))
+		expect = step.get("expect")
+		if expect is not None:
+			expect = binascii.unhexlify(expect)
+		steps.append((data, count, expect))
+	return steps
+
+def hexlify(data):
+	return binascii.hexlify(data).decode("ascii")
+
+class BatchHandler(socketserver.StreamRequestHandler):
+	def handle(self):
+		# replies are single lines, send them right away
+		self.connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+		while True:
+			line = self.rfile.readline(MAX_REQUEST)
+			if not line:
+				return
+			if not line.strip():
+				continue
+			reply = self.server.run_request(line)
+			self.wfile.write((json.dumps(reply, sort_keys=True) + "\n").encode("ascii"))
+			self.wfile.flush()
+
+class BatchServer(socketserver.ThreadingMixIn, socketserver.TCPServer):
+	allow_reuse_address = True
+	daemon_threads = True
+
+	def __init__(self, address, board, verbose):
+		socketserver.TCPServer.__init__(self, address, BatchHandler)
+		self.board = board
+		self.verbose = verbose
+
+	def run_request(self, line):
+		reply = {}
+		results = []
+		started = time.perf_counter()
+		try:
+			request = json.loads(line.decode("utf-8"))
+			reply["id"] = request.get("id")
+			steps = parse_steps(request)
+			self.board.run(steps, bool(request.get("pipeline", False)), results)
+			reply["ok"] = True
+		except BatchError as ex:
+			reply["ok"] = False
+			reply["step"] = ex.step
+			reply["error"] = str(ex)
+		except (ValueError, TypeError, AttributeError, binascii.Error) as ex:
+			reply["ok"] = False
+			reply["error"] = "bad request: %s" % ex
+		except serial.SerialException as ex:
+			reply["ok"] = False
+			reply["error"] = "serial port: %s" % ex
+		reply["results"] = [hexlify(result) for result in results]
+		reply["elapsed_ms"] = round((time.perf_counter() - started) * 1000, 3)
+		if self.verbose:
+			print(json.dumps(reply, sort_keys=True), file=sys.stderr)
+		return reply
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options]", version="%prog 1.0")
+
+	parser.add_option("-d", "--dev",
+						dest="dev_name", default="/dev/ttyUSB0",
+						help="The device to connect to", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-l", "--listen",
+						dest="listen", default="127.0.0.1",
+						help="Address to listen on [default: %default]", type="string")
+	parser.add_option("-p", "--port",
+						dest="port", default=5757,
+						help="TCP port to listen on [default: %default]", type="int")
+	parser.add_option("-w", "--timeout",
+						dest="timeout", default=1.0,
+						help="Seconds to wait for an answer [default: %default]", type="float")
+	parser.add_option("-v", "--verbose",
+						dest="verbose", default=False, action="store_true",
+						help="Print every reply on stderr")
+
+	(options, args) = parser.parse_args()
+	if args:
+		parser.error("no arguments expected")
+	return options
+
+if __name__ == '__main__':
+	options = parse_prog_args()
+
+	try:
+		board = Board(options.dev_name, options.baud_rate, options.timeout)
+		server = BatchServer((options.listen, options.port), board, options.verbose)
+	except (serial.SerialException, OSError) as ex:
+		print(ex, file=sys.stderr)
+		sys.exit(1)
+
+	print("Serving %s on %s:%d" % (options.dev_name, options.listen, options.port),
+		file=sys.stderr)
+	try:
+		server.serve_forever()
+	except KeyboardInterrupt:
+		pass
+	finally:
+		server.server_close()
+		board.port.close()
+	print("%d batches served" % board.batches, file=sys.stderr)
+	sys.exit(0)
@@ -0,0 +1,252 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Binary mode session recorder and replayer.
+
+"record" sits between a host application and the board: it opens a pseudo
+terminal for the application to use instead of the serial port, forwards
+everything both ways, and writes every chunk of bytes with when it went
+through to a session file.  POSIX hosts only.
+
+"replay" sends a recorded session to a board the way the application did,
+one command at a time, and checks every answer against the recorded one.
+A command is everything the application sent before the board started
+answering, and its answer everything the board sent before the application
+sent something again.  Per command latencies (from the last byte sent to the
+last byte of the answer) are grouped by the first byte of the command and
+reported as one JSON object per group, followed by a summary, the same way
+binmode_benchmark.py does.
+
+The board must be in the state it was in when the recording started, usually
+the terminal right after being plugged in.  Answers that change from run to
+run (ADC readings, counters) can be told apart with --ignore-mismatches.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import binascii
+import json
+import optparse
+import os
+import select
+import sys
+import time
+import tty
+
+import serial
+
+SESSION_FORMAT = "bp-session"
+SESSION_VERSION = 1
+
+# Chunk directions, as seen from the board.
+TO_BOARD = "in"
+FROM_BOARD = "out"
+
+CHUNK_SIZE = 4096
+
+class SessionError(Exception):
+	pass
+
+def percentile(samples, fraction):
+	ordered = sorted(samples)
+	index = min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))
+	return ordered[index]
+
+def write_chunk(handle, started, direction, data):
+	handle.write(json.dumps({
+		"t": round(time.perf_counter() - started, 6),
+		"dir": direction,
+		"data": binascii.hexlify(data).decode("ascii"),
+	}) + "\n")
+
+def record(options, output):
+	port = serial.Serial(options.dev_name, options.baud_rate, timeout=0)
+	(master, slave) = os.openpty()
+	tty.setraw(slave)
+	print("Point the application at %s, Ctrl-C to stop recording" % os.ttyname(slave),
+		file=sys.stderr)
+
+	output.write(json.dumps({
+		"format": SESSION_FORMAT,
+		"version": SESSION_VERSION,
+		"baud": options.baud_rate,
+		"recorded": time.strftime("%Y-%m-%dT%H:%M:%S"),
+		"label": options.label,
+	}) + "\n")
+
+	started = time.perf_counter()
+	chunks = 0
+	try:
+		while True:
+			(readable, _, _) = select.select([master, port.fileno()], [], [])
+			if master in readable:
+				try:
+					data = os.read(master, CHUNK_SIZE)
+				except OSError:
+					# the application closed its end
+					data = b""
+				if data:
+					port.write(data)
+					write_chunk(output, started, TO_BOARD, data)
+					chunks += 1
+			if port.fileno() in readable:
+				data = port.read(port.in_waiting or 1)
+				if data:
+					os.write(master, data)
+					write_chunk(output, started, FROM_BOARD, data)
+					chunks += 1
+	except KeyboardInterrupt:
+		pass
+	finally:
+		port.close()
+		os.close(master)
+		os.close(slave)
+	print("%d chunks recorded in %.1fs" % (chunks, time.perf_counter() - started),
+		file=sys.stderr)
+
+def load_session(handle):
+	"""Read a session file, returning its header and its commands.
+
+	Each command is (sent, expected, think) where think is how long the
+	application waited after the previous answer before sending it.
+	"""
+	header = json.loads(handle.readline())
+	if header.get("format") != SESSION_FORMAT or header.get("version") != SESSION_VERSION:
+		raise SessionError("not a version %d session file" % SESSION_VERSION)
+
+	commands = []
+	sent = b""
+	expected = b""
+	first_sent = 0.0
+	last_answer = 0.0
+	for line in handle:
+		if not line.strip():
+			continue
+		chunk = json.loads(line)
+		data = binascii.unhexlify(chunk["data"])
+		if chunk["dir"] == TO_BOARD:
+			if expected:
+				commands.append((sent, expected, first_sent))
+				sent = b""
+				expected = b""
+			if not sent:
+				first_sent = max(0.0, chunk["t"] - last_answer)
+			sent += data
+		else:
+			expected += data
+			last_answer = chunk["t"]
+	if sent or expected:
+		commands.append((sent, expected, first_sent))
+	return (header, commands)
+
+def replay(options, session):
+	(header, commands) = load_session(session)
+	port = serial.Serial(options.dev_name, options.baud_rate, timeout=options.timeout)
+	port.reset_input_buffer()
+
+	latencies = {}
+	mismatches = []
+	started = time.perf_counter()
+	try:
+		for (index, (sent, expected, think)) in enumerate(commands):
+			if options.keep_timing and think > 0:
+				time.sleep(think)
+			if sent:
+				port.write(sent)
+				port.flush()
+			before = time.perf_counter()
+			received = port.read(len(expected)) if expected else b""
+			elapsed = time.perf_counter() - before
+			if received != expected:
+				mismatches.append({
+					"command": index,
+					"sent": binascii.hexlify(sent[:32]).decode("ascii"),
+					"expected": binascii.hexlify(expected[:32]).decode("ascii"),
+					"received": binascii.hexlify(received[:32]).decode("ascii"),
+				})
+				if len(received) != len(expected):
+					# out of step, any later answer would be compared wrongly
+					break
+			if sent and expected:
+				latencies.setdefault("%02X" % sent[0], []).append(elapsed)
+	finally:
+		port.close()
+	wall = time.perf_counter() - started
+
+	for key in sorted(latencies):
+		timings = latencies[key]
+		print(json.dumps({
+			"label": options.label,
+			"command": key,
+			"count": len(timings),
+			"latency_p50_ms": round(percentile(timings, 0.50) * 1000, 3),
+			"latency_p90_ms": round(percentile(timings, 0.90) * 1000, 3),
+			"latency_p99_ms": round(percentile(timings, 0.99) * 1000, 3),
+			"latency_max_ms": round(max(timings) * 1000, 3),
+			"latency_total_ms": round(sum(timings) * 1000, 3),
+		}, sort_keys=True))
+	for mismatch in mismatches[:options.show_mismatches]:
+		print(json.dumps(dict(mismatch, label=options.label), sort_keys=True), file=sys.stderr)
+	print(json.dumps({
+		"label": options.label,
+		"recorded_label": header.get("label", ""),
+		"commands": len(commands),
+		"bytes_sent": sum(len(sent) for (sent, _, _) in commands),
+		"bytes_expected": sum(len(expected) for (_, expected, _) in commands),
+		"mismatches": len(mismatches),
+		"wall_time_s": round(wall, 6),
+		"paced": options.keep_timing,
+	}, sort_keys=True))
+	sys.stdout.flush()
+	return not mismatches or options.ignore_mismatches
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options] record|replay SESSION",
+		version="%prog 1.0")
+
+	parser.add_option("-d", "--dev",
+						dest="dev_name", default="/dev/ttyUSB0",
+						help="The device to connect to", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-t", "--label",
+						dest="label", default="",
+						help="Free form label (e.g. firmware build) added to the session or results", type="string")
+	parser.add_option("-p", "--keep-timing",
+						dest="keep_timing", default=False, action="store_true",
+						help="Wait as long as the application did between an answer and the next command")
+	parser.add_option("-w", "--timeout",
+						dest="timeout", default=2.0,
+						help="Seconds to wait for an answer [default: %default]", type="float")
+	parser.add_option("-i", "--ignore-mismatches",
+						dest="ignore_mismatches", default=False, action="store_true",
+						help="Do not fail when answers differ from the recorded ones")
+	parser.add_option("-m", "--show-mismatches",
+						dest="show_mismatches", default=10,
+						help="How many mismatches to print [default: %default]", type="int")
+
+	(options, args) = parser.parse_args()
+	if len(args) != 2 or args[0] not in ("record", "replay"):
+		parser.error("expected record or replay, and a session file")
+	return (options, args[0], args[1])
+
+if __name__ == '__main__':
+	(options, action, path) = parse_prog_args()
+
+	try:
+		if action == "record":
+			with open(path, "w") as output:
+				record(options, output)
+			sys.exit(0)
+		with open(path, "r") as session:
+			sys.exit(0 if replay(options, session) else 1)
+	except (serial.SerialException, SessionError, OSError, ValueError) as ex:
+		print(ex, file=sys.stderr)
+		sys.exit(1)
@@ -25,10 +25,13 @@ inary1WIRE mode:
 # 00000000 - reset to BBIO
 # 00000001 – mode version string (1W01)
 # 00000010 – 1wire reset
+# 00000011 - Overdrive Skip ROM (0x3c), then switch to overdrive speed
 # 00000100 - read byte
+# 00000101 - Overdrive Match ROM (0x69) + 8 ROM bytes, then switch to overdrive speed
 # 00001000 - ROM search macro (0xf0)
 # 00001001 - ALARM search macro (0xec)
 # 0001xxxx – Bulk transfer, send 1-16 bytes (0=1byte!)
+# 001000xx - Configure speed, 00=standard 01=overdrive
 # 0100wxyz – Configure peripherals w=power, x=pullups, y=AUX, z=CS (
 # 0101wxyz – read peripherals (planned, not implemented)
 """
@@ -44,23 +47,45 @@ class _1WIRE(BBIO):
 		self.timeout(0.1)
 		return self.response(1)
 
+	def overdrive_skip_rom(self):
+		self.port.write("\x03")
+		self.timeout(0.1)
+		return self.response(1)
+
+	def overdrive_match_rom(self, rom):
+		self.port.write("\x05")
+		self.port.write(rom)
+		self.timeout(0.1)
+		return self.response(1)
+
+	def standard_speed(self):
+		self.port.write("\x20")
+		self.timeout(0.1)
+		return self.response(1)
+
 	def read_byte(self):
 		self.port.write("\x04")
 		self.timeout(0.1)
 		return self.response(1)
 
 	def rom_search(self):
-		self.port.write("\x08")
-		self.timeout(0.1)
-		self.__group_response()
+		"""Runs the search ROM macro, returns the 8 bytes ROM of every device
+		found on the bus."""
+		self.port.write(b"\x08")
+		return self.__group_response()
 
 	def alarm_search(self):
-		self.port.write("\x09")
-		self.timeout(0.1)
-		self.__group_response()
+		"""Same as rom_search(), for the devices with an alarm set."""
+		self.port.write(b"\x09")
+		return self.__group_response()
 
 	def __group_response(self):
-		EOD = [0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff]
-		while (data = self.port.read(8)) != EOD:
-			print data
+		# A success code, then the ROMs as they are found, then 8x 0xFF.
+		EOD = bytearray([0xff] * 8)
+		roms = []
+		if not self.expect_success(): return roms
+		rom = bytearray(8)
+		while self.read_into(memoryview(rom)) == len(rom) and rom != EOD:
+			roms.append(bytearray(rom))
+		return roms
 
@@ -0,0 +1,369 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+asyncio binary mode client.
+
+The same binary mode commands as BBIO, SPI and I2C, as coroutines over a
+non-blocking serial port, so one event loop can drive a whole rack of Bus
+Pirates without a thread per board:
+
+	async def probe(path):
+		spi = await AsyncSPI.open(path)
+		await spi.enter_SPI()
+		jedec = await spi.transfer(b"\\x9F", 3)
+		spi.close()
+		return jedec
+
+	results = asyncio.run(asyncio.gather(*[probe(p) for p in paths]))
+
+Every board has a lock, commands issued concurrently on the same board
+run one after another instead of interleaving on the wire; commands on
+different boards overlap freely.  The port is a POSIX tty opened with
+O_NONBLOCK and watched with loop.add_reader(), pyserial is not used, so
+this runs on Linux and macOS only and not over the v4 bulk pipe.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import asyncio
+import errno
+import os
+import termios
+
+from .BitBang import DESCRIBE_TERMINAL_BUFFER, MIN_TERMINAL_BUFFER
+
+# Largest read from the tty in one go, a full v4 buffer.
+READ_CHUNK = 4096
+
+class AsyncPortError(Exception):
+	pass
+
+class AsyncPort(object):
+	"""Raw tty with awaitable reads and writes.  Whatever arrives is kept
+	until asked for, read() returns fewer bytes than asked only when the
+	timeout runs out, like a pyserial port."""
+	def __init__(self, path, speed=115200, timeout=1, loop=None):
+		self.loop = loop or asyncio.get_running_loop()
+		self.timeout = timeout
+		self.received = bytearray()
+		self.waiter = None
+		self.error = None
+		self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+		try:
+			self.configure(speed)
+		except (termios.error, AttributeError):
+			os.close(self.fd)
+			raise AsyncPortError("%s: can't set up the port at %d baud" % (path, speed))
+		self.loop.add_reader(self.fd, self.readable)
+
+	def configure(self, speed):
+		baud = getattr(termios, "B%d" % speed)
+		attributes = termios.tcgetattr(self.fd)
+		attributes[0] = 0                                       # iflag
+		attributes[1] = 0                                       # oflag
+		attributes[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+		attributes[3] = 0                                       # lflag
+		attributes[4] = attributes[5] = baud
+		attributes[6][termios.VMIN] = 0
+		attributes[6][termios.VTIME] = 0
+		termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+		termios.tcflush(self.fd, termios.TCIOFLUSH)
+
+	def readable(self):
+		while True:
+			try:
+				data = os.read(self.fd, READ_CHUNK)
+			except OSError as ex:
+				if ex.errno in (errno.EAGAIN, errno.EWOULDBLOCK): break
+				# The board went away, wake the reader up with the error.
+				self.error = ex
+				self.loop.remove_reader(self.fd)
+				break
+			if not data: break
+			self.received.extend(data)
+		if self.waiter is not None and not self.waiter.done():
+			self.waiter.set_result(None)
+
+	async def wait_readable(self, timeout):
+		"""Waits until something new arrived, returns False on timeout."""
+		if self.error is not None: return False
+		self.waiter = self.loop.create_future()
+		try:
+			await asyncio.wait_for(self.waiter, timeout)
+			return True
+		except asyncio.TimeoutError:
+			return False
+		finally:
+			self.waiter = None
+
+	async def read(self, size=1):
+		"""Up to size bytes, fewer if the timeout runs out first."""
+		deadline = self.loop.time() + self.timeout
+		while len(self.received) < size:
+			if self.error is not None:
+				raise AsyncPortError(os.strerror(self.error.errno))
+			remaining = deadline - self.loop.time()
+			if remaining <= 0 or not await self.wait_readable(remaining): break
+		data = bytes(self.received[:size])
+		del self.received[:size]
+		return data
+
+	async def write(self, data):
+		view = memoryview(data)
+		while len(view):
+			try:
+				view = view[os.write(self.fd, view):]
+				continue
+			except OSError as ex:
+				if ex.errno not in (errno.EAGAIN, errno.EWOULDBLOCK): raise
+			# The tty buffer is full, wait for it to drain a bit.
+			ready = self.loop.create_future()
+			self.loop.add_writer(self.fd, ready.set_result, None)
+			try:
+				await ready
+			finally:
+				self.loop.remove_writer(self.fd)
+
+	def flush_input(self):
+		termios.tcflush(self.fd, termios.TCIFLUSH)
+		del self.received[:]
+
+	def close(self):
+		if self.fd is None: return
+		self.loop.remove_reader(self.fd)
+		os.close(self.fd)
+		self.fd = None
+
+class AsyncBBIO(object):
+	"""Bitbang mode and mode entry, as BBIO.  Use open() from a coroutine,
+	the port is bound to the running event loop."""
+	def __init__(self, port):
+		self.port = port
+		self.lock = asyncio.Lock()
+		self.identity = None
+		self.limits = {}
+
+	@classmethod
+	async def open(cls, path="/dev/bus_pirate", speed=115200, timeout=1):
+		"""Opens the port and enters binary mode, raises AsyncPortError if
+		the board does not answer."""
+		bbio = cls(AsyncPort(path, speed, timeout))
+		if not await bbio.BBmode():
+			bbio.close()
+			raise AsyncPortError("%s: no binary mode answer" % path)
+		return bbio
+
+	async def command(self, data, reply_length):
+		"""Sends data and reads reply_length bytes back, with the board to
+		itself in between."""
+		async with self.lock:
+			await self.port.write(data)
+			return await self.port.read(reply_length)
+
+	async def BBmode(self):
+		async with self.lock:
+			self.port.flush_input()
+			await self.port.write(b"\x00\x0B\x0C\x20")
+			if await self.port.read(5) == b"BBIO1":
+				await self.port.read(2)
+				self.identity = await self.read_identity()
+				if self.identity:
+					self.limits = await self.describe()
+					return 1
+			self.port.flush_input()
+			for i in range(20):
+				await self.port.write(b"\x00")
+				if await self.port.wait_readable(0.01): break
+			if await self.port.read(5) == b"BBIO1": return 1
+			return 0
+
+	async def read_identity(self):
+		length = await self.port.read(1)
+		if len(length) != 1 or length[0] < 5: return None
+		data = await self.port.read(length[0])
+		if len(data) != length[0]: return None
+		return (data[0], data[1], data[2], (data[3] << 8) | data[4])
+
+	async def describe(self):
+		await self.port.write(b"\x21")
+		header = await self.port.read(2)
+		if len(header) != 2 or header == b"\x00\x00": return {}
+		data = await self.port.read((header[0] << 8) | header[1])
+		entries = {}
+		while len(data) >= 2:
+			value = 0
+			for byte in data[2:2 + data[1]]: value = (value << 8) | byte
+			entries[data[0]] = value
+			data = data[2 + data[1]:]
+		return entries
+
+	async def identify(self):
+		async with self.lock:
+			await self.port.write(b"\x20")
+			self.identity = await self.read_identity()
+			return self.identity
+
+	def terminal_buffer_size(self):
+		return self.limits.get(DESCRIBE_TERMINAL_BUFFER, MIN_TERMINAL_BUFFER)
+
+	async def enter_mode(self, command, identifier):
+		return int(await self.command(command, 4) == identifier)
+
+	async def enter_SPI(self):
+		return await self.enter_mode(b"\x01", b"SPI1")
+
+	async def enter_I2C(self):
+		return await self.enter_mode(b"\x02", b"I2C1")
+
+	async def enter_UART(self):
+		return await self.enter_mode(b"\x03", b"ART1")
+
+	async def enter_1wire(self):
+		return await self.enter_mode(b"\x04", b"1W01")
+
+	async def enter_rawwire(self):
+		return await self.enter_mode(b"\x05", b"RAW1")
+
+	async def reset(self):
+		"""Leaves the current mode for bitbang mode."""
+		return int(await self.command(b"\x00", 5) == b"BBIO1")
+
+	async def resetBP(self):
+		await self.reset()
+		async with self.lock:
+			await self.port.write(b"\x0F")
+			await asyncio.sleep(0.1)
+			self.port.flush_input()
+		return 1
+
+	async def raw_cfg_pins(self, config):
+		return await self.command(bytes([0x40 | config]), 1)
+
+	async def raw_set_pins(self, pins):
+		return await self.command(bytes([0x80 | pins]), 1)
+
+	async def ADC_measure(self):
+		return await self.command(b"\x14", 2)
+
+	""" General Commands for Higher-Level Modes """
+	async def expect_success(self, data):
+		return await self.command(data, 1) == b"\x01"
+
+	async def bulk_trans(self, byte_count=1, byte_string=None):
+		reply = await self.command(bytes([0x10 | (byte_count - 1)]) +
+			bytes(byte_string[:byte_count]), byte_count + 1)
+		return reply[1:]
+
+	async def cfg_pins(self, pins=0):
+		return await self.expect_success(bytes([0x40 | pins]))
+
+	async def read_pins(self):
+		return await self.command(b"\x50", 1)
+
+	async def set_speed(self, speed=0):
+		return await self.expect_success(bytes([0x60 | speed]))
+
+	def close(self):
+		self.port.close()
+
+class AsyncSPI(AsyncBBIO):
+	async def CS_Low(self):
+		return await self.expect_success(b"\x02")
+
+	async def CS_High(self):
+		return await self.expect_success(b"\x03")
+
+	async def cfg_spi(self, spi_cfg):
+		return await self.expect_success(bytes([0x80 | spi_cfg]))
+
+	async def set_word_size(self, bits):
+		return await self.expect_success(bytes([0x0B, 0x01 if bits == 16 else 0x00]))
+
+	async def transfer(self, write=b"", read_len=0, cs=True):
+		"""As SPI.transfer(): writes write, then reads read_len bytes, with
+		CS low throughout if cs.  Transfers larger than the firmware buffer
+		are split and keep the board locked until done.  Returns a
+		bytearray, or None if the firmware refused."""
+		view = memoryview(write)
+		result = bytearray()
+		limit = self.terminal_buffer_size()
+		async with self.lock:
+			if len(view) <= limit and read_len <= limit:
+				if not await self.write_then_read(0x04 if cs else 0x05, view, read_len, result):
+					return None
+				return result
+			if cs:
+				await self.port.write(b"\x02")
+				if await self.port.read(1) != b"\x01": return None
+			ok = True
+			for offset in range(0, len(view), limit):
+				ok = ok and await self.write_then_read(0x05, view[offset:offset + limit], 0, result)
+			for offset in range(0, read_len, limit):
+				ok = ok and await self.write_then_read(0x05, view[:0],
+					min(limit, read_len - offset), result)
+			if cs:
+				await self.port.write(b"\x03")
+				ok = await self.port.read(1) == b"\x01" and ok
+			if ok: return result
+			return None
+
+	async def write_then_read(self, command, write, read_len, result):
+		"""One write-then-read command, the caller holds the lock."""
+		await self.port.write(bytes([command, len(write) >> 8, len(write) & 0xFF,
+			read_len >> 8, read_len & 0xFF]) + bytes(write))
+		if await self.port.read(1) != b"\x01": return False
+		data = await self.port.read(read_len)
+		result.extend(data)
+		return len(data) == read_len
+
+class AsyncI2C(AsyncBBIO):
+	async def send_start_bit(self):
+		return await self.expect_success(b"\x02")
+
+	async def send_stop_bit(self):
+		return await self.expect_success(b"\x03")
+
+	async def read_byte(self):
+		return await self.command(b"\x04", 1)
+
+	async def send_ack(self):
+		return await self.expect_success(b"\x06")
+
+	async def send_nack(self):
+		return await self.expect_success(b"\x07")
+
+	async def transfer(self, address, write=b"", read_len=0):
+		"""As I2C.transfer(): writes write to the 7 bits address, then
+		reads read_len bytes after a repeated start.  Returns a bytearray,
+		or None if the device did not acknowledge."""
+		view = memoryview(write)
+		device = (address << 1) | (0x01 if len(view) == 0 and read_len else 0x00)
+		write_len = len(view) + 1
+		limit = self.terminal_buffer_size()
+		if write_len <= limit and read_len <= limit:
+			header = bytearray([0x08, write_len >> 8, write_len & 0xFF,
+				read_len >> 8, read_len & 0xFF])
+		else:
+			header = bytearray([0x0B])
+			for value in (write_len, read_len):
+				header.extend([(value >> 24) & 0xFF, (value >> 16) & 0xFF,
+					(value >> 8) & 0xFF, value & 0xFF])
+		header.append(device)
+		async with self.lock:
+			await self.port.write(bytes(header) + bytes(view))
+			if await self.port.read(1) != b"\x01": return None
+			data = await self.port.read(read_len)
+			if len(data) != read_len: return None
+			return bytearray(data)
+
+async def open_all(paths, cls=AsyncBBIO, speed=115200, timeout=1):
+	"""Opens every board in paths at once.  Returns them in the same order,
+	with the AsyncPortError in place of each board that did not open."""
+	return await asyncio.gather(*[cls.open(path, speed, timeout) for path in paths],
+		return_exceptions=True)
@@ -0,0 +1,154 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Tokeniser and uploader for the BASIC interpreter.
+
+tokenise() turns a BASIC listing into the image basic.c keeps in its program
+area, with the same token table and the same rules the interactive
+interpreter applies to each line: upper case, keywords matched in table
+order, blanks dropped outside strings and the rest of a REM line kept as is.
+upload() sends that image with the UPLOAD command in a single transfer, so
+programs no longer go through the terminal line editor one line at a time.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import binascii
+import re
+import time
+
+import serial
+
+# Keywords in the order of tokens[] in basic.c, starting from TOKENS.
+TOKENS = 0x80
+KEYWORDS = ["LET", "IF", "THEN", "ELSE", "GOTO", "GOSUB", "RETURN", "REM",
+	"PRINT", "INPUT", "FOR", "TO", "NEXT", "READ", "DATA", "STARTR", "START",
+	"STOPR", "STOP", "SEND", "RECEIVE", "CLK", "DAT", "BITREAD", "ADC",
+	"AUXPIN", "PSU", "PULLUP", "DELAY", "AUX", "FREQ", "DUTY", "MACRO", "END",
+	"BUF"]
+TOK_REM = TOKENS + KEYWORDS.index("REM")
+TOK_END = TOKENS + KEYWORDS.index("END")
+TOK_LEN = 0xE0
+
+# Longest line content a TOK_LEN header can tell, and the last line number,
+# kept for the END marker line.
+MAXIMUM_LINE_LENGTH = 0xFF - TOK_LEN
+LAST_LINE = 0xFFFF
+
+# Size of basic_program_area, BP_BASIC_PROGRAM_SPACE in configuration.h.
+PROGRAM_SPACE = 1024
+
+BASIC_READY = b"Ready"
+
+class BASICError(Exception):
+	pass
+
+def tokenise_line(text):
+	"""Content bytes of one line, its number left out."""
+	text = text.upper()
+	content = bytearray()
+	in_string = False
+	index = 0
+	while index < len(text):
+		if not in_string:
+			while index < len(text) and text[index] in " \t":
+				index += 1
+			if index == len(text):
+				break
+			keyword = next((word for word in KEYWORDS if text.startswith(word, index)), None)
+			if keyword is not None:
+				token = TOKENS + KEYWORDS.index(keyword)
+				content.append(token)
+				index += len(keyword)
+				if token == TOK_REM:
+					in_string = True
+				continue
+		if text[index] == '"':
+			in_string = not in_string
+		content.extend(text[index].encode("ascii"))
+		index += 1
+	return content
+
+def tokenise(listing):
+	"""The program area image for a BASIC listing, one numbered line per
+	text line.  A later line with the same number replaces an earlier one,
+	as it would when typed in."""
+	lines = {}
+	for (number, text) in enumerate(listing.splitlines(), 1):
+		if not text.strip():
+			continue
+		match = re.match(r"\s*(\d+)\s?(.*)$", text)
+		if not match:
+			raise BASICError("line %d: no line number" % number)
+		line = int(match.group(1))
+		if line >= LAST_LINE:
+			raise BASICError("line %d: line numbers stop at %d" % (number, LAST_LINE - 1))
+		content = tokenise_line(match.group(2))
+		if len(content) > MAXIMUM_LINE_LENGTH:
+			raise BASICError("line %d: longer than %d bytes once tokenised"
+				% (number, MAXIMUM_LINE_LENGTH))
+		if content:
+			lines[line] = content
+		else:
+			lines.pop(line, None)
+	image = bytearray()
+	for line in sorted(lines):
+		content = lines[line]
+		image.extend([TOK_LEN + len(content), line >> 8, line & 0xFF])
+		image.extend(content)
+	image.extend([TOK_LEN + 1, LAST_LINE >> 8, LAST_LINE & 0xFF, TOK_END])
+	if len(image) >= PROGRAM_SPACE:
+		raise BASICError("%d bytes do not fit in the %d bytes program area"
+			% (len(image), PROGRAM_SPACE))
+	return bytes(image)
+
+def checksum(image):
+	"""CRC16 the firmware checks the image against."""
+	return binascii.crc_hqx(bytes(image), 0xFFFF)
+
+class BASIC(object):
+	def __init__(self, p="/dev/bus_pirate", s=115200, t=1):
+		self.port = serial.Serial(p, s, timeout=t)
+
+	def read_until(self, marker, timeout):
+		data = b""
+		deadline = time.time() + timeout
+		while not data.endswith(marker) and time.time() < deadline:
+			more = self.port.read(1)
+			if more:
+				data += more
+		return data
+
+	def upload(self, image, run=False, timeout=10):
+		"""Enters the interpreter from the terminal, replaces the program with
+		image and runs it if asked to.  Returns what the program printed,
+		empty if it was not run."""
+		self.port.reset_input_buffer()
+		self.port.write(b"s\r")
+		if not self.read_until(BASIC_READY, self.port.timeout).endswith(BASIC_READY):
+			raise BASICError("the terminal did not start the interpreter")
+		self.port.write(b"UPLOAD RUN\r" if run else b"UPLOAD\r")
+		# the command line echo is plain text, the first result code follows
+		if not self.read_until(b"\x01", self.port.timeout).endswith(b"\x01"):
+			raise BASICError("no UPLOAD command, the firmware is too old")
+		crc = checksum(image)
+		self.port.write(bytes(bytearray([len(image) >> 8, len(image) & 0xFF,
+			crc >> 8, crc & 0xFF])))
+		if self.port.read(1) != b"\x01":
+			raise BASICError("the firmware refused a %d bytes image" % len(image))
+		self.port.write(bytes(image))
+		if self.port.read(1) != b"\x01":
+			raise BASICError("the image was damaged on the way")
+		output = self.read_until(BASIC_READY, timeout)
+		self.port.write(b"EXIT\r")
+		self.read_until(BASIC_READY, self.port.timeout)
+		return output[:-len(BASIC_READY)] if output.endswith(BASIC_READY) else output
+
+	def close(self):
+		self.port.close()
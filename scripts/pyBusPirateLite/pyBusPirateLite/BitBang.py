@@ -43,19 +43,195 @@ class BBIOPins:
 	PULLUP = 0x20;
 	POWER = 0x40;
 
+# Describe command entry with the terminal buffer size, see binary_io.h.
+DESCRIBE_TERMINAL_BUFFER = 0x10
+
+# Terminal buffer of the smallest board, assumed when the firmware can't
+# describe itself.
+MIN_TERMINAL_BUFFER = 4096
+
+# USB frame numbers wrap at 11 bits, the timebase only agrees on those.
+TIMEBASE_FRAME_WRAP = 0x800
+
+def timebase_seconds(frame, ticks, ticks_per_frame):
+	"""Turns a timebase timestamp into seconds of host frame time."""
+	return (frame + ticks / float(ticks_per_frame)) * 0.001
+
+def timebase_frame_offset(reference, other):
+	"""Frames to add to the timestamps of a board so they line up with
+	those of the reference board, from the frame numbers both boards
+	returned when read at about the same time (within a second)."""
+	difference = reference - other
+	return ((difference + TIMEBASE_FRAME_WRAP // 2) // TIMEBASE_FRAME_WRAP) * TIMEBASE_FRAME_WRAP
+
+class BatchError(Exception):
+	pass
+
+class BatchReply(object):
+	"""Stands in for the value of a command queued between begin_batch()
+	and commit(), value is filled in by commit()."""
+	def __init__(self, byte_count, return_data, convert):
+		self.byte_count = byte_count
+		self.return_data = return_data
+		self.convert = convert
+		self.value = None
+
+class BatchedPort(object):
+	"""Collects what the mode classes write until the batch is committed.
+	Anything that has to look at the port on its own, instead of going
+	through BBIO.response(), can't be part of a batch."""
+	def __init__(self, port):
+		self.port = port
+		self.pending = []
+
+	def write(self, data):
+		self.pending.append(data)
+
+	def read(self, size=1):
+		raise BatchError("this command can't be batched, commit() first")
+
+	def __getattr__(self, name):
+		raise BatchError("port.%s can't be used in a batch, commit() first" % name)
+
 class BBIO:
 	def __init__(self, p="/dev/bus_pirate", s=115200, t=1):
-		self.port = serial.Serial(p, s, timeout=t)
+		if p.startswith("usb:"):
+			# v4 vendor bulk pipe, see USBBulk.py; needs python-libusb1.
+			from .USBBulk import USBBulkPort
+			self.port = USBBulkPort(p[4:], timeout=t)
+		else:
+			self.port = serial.Serial(p, s, timeout=t)
+		self.identity = None
+		self.limits = {}
+		self.batch = None
+
+	def begin_batch(self):
+		"""Queues the commands that follow instead of sending them one at a
+		time.  Each returns a BatchReply, commit() then sends them all in one
+		write, reads every reply in one read and fills the replies in."""
+		if self.batch is not None: raise BatchError("already batching")
+		self.batch = []
+		self.port = BatchedPort(self.port)
+
+	def commit(self):
+		"""Sends the batch, returns the values of its commands in order."""
+		if self.batch is None: raise BatchError("not batching")
+		batch = self.batch
+		pending = self.port.pending
+		self.port = self.port.port
+		self.batch = None
+		if pending: self.port.write(pending[0][:0].join(pending))
+		data = self.port.read(sum([reply.byte_count for reply in batch]))
+		for reply in batch:
+			reply.value = self.decode(data[:reply.byte_count], reply.byte_count,
+				reply.return_data, reply.convert)
+			data = data[reply.byte_count:]
+		return [reply.value for reply in batch]
 	
 	def BBmode(self):
-		self.port.flushInput();		
+		self.port.flushInput();
+		# One round trip on firmware that knows the magic sequence, the
+		# reply is the same from the terminal and from binary mode.
+		self.port.write("\x00\x0B\x0C\x20");
+		if self.response(5, True) == "BBIO1":
+			self.response(2, True)
+			self.identity = self.read_identity()
+			if self.identity:
+				self.limits = self.describe()
+				return 1
+		self.port.flushInput();
 		for i in range(20):
 			self.port.write("\x00");
-			r,w,e = select.select([self.port], [], [], 0.01);
-			if (r): break;
+			if self.wait_for_input(0.01): break;
 		if self.response(5) == "BBIO1": return 1
 		else: return 0
 
+	def identify(self):
+		self.port.write("\x20")
+		self.identity = self.read_identity()
+		return self.identity
+
+	def describe(self):
+		"""{entry type: value} as described in the firmware binary_io.h,
+		empty if the firmware does not know the command."""
+		self.port.write("\x21")
+		header = self.port.read(2)
+		if len(header) != 2 or header == "\x00\x00": return {}
+		data = [ord(c) for c in self.port.read((ord(header[0]) << 8) | ord(header[1]))]
+		entries = {}
+		while len(data) >= 2:
+			value = 0
+			for byte in data[2:2 + data[1]]: value = (value << 8) | byte
+			entries[data[0]] = value
+			data = data[2 + data[1]:]
+		return entries
+
+	def profile(self):
+		"""Reads and clears the firmware profiling counters, as a list of
+		(passes, total microseconds, longest microseconds) in the region
+		order of profiling.h, or None if profiling is not built in."""
+		self.port.write("\x22")
+		header = self.port.read(1)
+		if len(header) != 1 or header == "\x00": return None
+		ticks = ord(self.port.read(1))
+		data = [ord(c) for c in self.port.read(ord(header) * 12)]
+		regions = []
+		for offset in range(0, len(data) - 11, 12):
+			counters = []
+			for index in range(offset, offset + 12, 4):
+				counters.append((data[index] << 24) | (data[index + 1] << 16) |
+					(data[index + 2] << 8) | data[index + 3])
+			regions.append((counters[0], counters[1] / float(ticks),
+				counters[2] / float(ticks)))
+		return regions
+
+	def terminal_buffer_size(self):
+		"""Largest payload a write-then-read command takes in one go."""
+		return self.limits.get(DESCRIBE_TERMINAL_BUFFER, MIN_TERMINAL_BUFFER)
+
+	def read_into(self, view):
+		"""Fills the memoryview view from the port, returns how many bytes
+		came in before the port timed out."""
+		done = 0
+		while done < len(view):
+			count = self.port.readinto(view[done:])
+			if not count: break
+			done += count
+		return done
+
+	def read_compressed_into(self, view):
+		"""Fills the memoryview view by decoding a compressed read token
+		stream from the port, see the firmware compressed_read.h.  Returns
+		how many bytes were decoded before the port timed out."""
+		done = 0
+		while done < len(view):
+			token = bytearray(self.port.read(1))
+			if len(token) != 1: break
+			token = token[0]
+			if token < 0x80:
+				data = bytearray(self.port.read(token + 1))
+				complete = len(data) == token + 1
+			else:
+				value = bytearray(self.port.read(1))
+				complete = len(value) == 1
+				data = value * ((token & 0x3F) + 3)
+			data = data[:len(view) - done]
+			view[done:done + len(data)] = data
+			done += len(data)
+			if not complete: break
+		return done
+
+	def expect_success(self):
+		return self.port.read(1) == b"\x01"
+
+	def read_identity(self):
+		"""(firmware major, minor, hardware version, capability flags), or
+		None if the firmware is too old to say."""
+		length = self.port.read(1)
+		if len(length) != 1 or ord(length) < 5: return None
+		data = [ord(c) for c in self.port.read(ord(length))]
+		return (data[0], data[1], data[2], (data[3] << 8) | data[4])
+
 	def reset(self):
 		self.port.write("\x00")
 		self.timeout(0.1)
@@ -85,6 +261,12 @@ class BBIO:
 		if self.response(4) == "1W01": return 1
 		else: return 0
 		
+	def enter_OpenOCD(self):
+		self.port.write("\x06")
+		self.timeout(0.1)
+		if self.response(4) == "OCD1": return 1
+		else: return 0
+
 	def enter_rawwire(self):
 		self.port.write("\x05")
 		self.timeout(0.1)
@@ -109,14 +291,31 @@ class BBIO:
 		self.timeout(0.1)
 		return self.response(1)
 
+	def wait_for_input(self, timeout):
+		if hasattr(self.port, "wait_readable"):
+			return self.port.wait_readable(timeout)
+		r,w,e = select.select([self.port], [], [], timeout)
+		return bool(r)
+
 	def timeout(self, timeout=0.1):
+		# Replies are framed by length when batching, nothing to wait for.
+		if self.batch is not None: return
 		select.select([], [], [], timeout)
 
-	def response(self, byte_count=1, return_data=False):
+	def response(self, byte_count=1, return_data=False, convert=None):
+		if self.batch is not None:
+			reply = BatchReply(byte_count, return_data, convert)
+			self.batch.append(reply)
+			return reply
 		data = self.port.read(byte_count)
+		return self.decode(data, byte_count, return_data, convert)
+
+	def decode(self, data, byte_count, return_data, convert):
 		if byte_count == 1 and return_data == False:
 			if data == chr(0x01): return 1
 			else: return 0
+		elif convert:
+			return convert(data)
 		else:
 			return data
 
@@ -131,6 +330,174 @@ class BBIO:
 		self.timeout(0.1)
 		return self.response(1, True)
 
+	def selftest_report(self, jumpers=False):
+		"""Runs the self-test and returns the (performed, failed) check
+		masks, bits as in selftest.h, or None if the firmware does not
+		know the command.  Stays in binary mode."""
+		self.port.write("\x23" + ("\x01" if jumpers else "\x00"))
+		if self.port.read(1) != "\x01": return None
+		data = [ord(c) for c in self.port.read(8)]
+		if len(data) != 8: return None
+		masks = []
+		for offset in (0, 4):
+			masks.append((data[offset] << 24) | (data[offset + 1] << 16) |
+				(data[offset + 2] << 8) | data[offset + 3])
+		return tuple(masks)
+
+	def smps_status(self):
+		"""Returns the v4 SMPS regulation loop state as (setpoint, measured,
+		duty), the voltages in ADC counts and the duty cycle out of 127,
+		or None if the firmware was built without SMPS support."""
+		self.port.write("\x24")
+		if self.port.read(1) != "\x01": return None
+		data = [ord(c) for c in self.port.read(5)]
+		if len(data) != 5: return None
+		return ((data[0] << 8) | data[1], (data[2] << 8) | data[3], data[4])
+
+	def keep_mode_settings(self, keep=True):
+		"""While on, switching modes leaves power and pull-ups alone and
+		SPI and I2C come back with the settings they had when last left.
+		Returns False if the firmware does not know the command."""
+		self.port.write("\x25")
+		self.port.write(chr(0x01 if keep else 0x00))
+		return self.port.read(1) == "\x01"
+
+	def read_timestamp(self):
+		data = [ord(c) for c in self.port.read(6)]
+		if len(data) != 6: return None
+		return ((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3],
+			(data[4] << 8) | data[5])
+
+	def read_timebase(self):
+		"""Returns the v4 USB start of frame timebase as (frame, ticks,
+		ticks per frame), or None if the firmware has no timebase or the
+		host sent no start of frame yet."""
+		self.port.write("\x26\x00")
+		if self.port.read(1) != "\x01": return None
+		timestamp = self.read_timestamp()
+		data = [ord(c) for c in self.port.read(2)]
+		if timestamp is None or len(data) != 2: return None
+		return timestamp + ((data[0] << 8) | data[1],)
+
+	def trigger_out(self):
+		"""Pulses AUX and returns when, as (frame, ticks), or None."""
+		self.port.write("\x26\x01")
+		if self.port.read(1) != "\x01": return None
+		return self.read_timestamp()
+
+	def trigger_in(self, armed=True):
+		"""Starts or stops timestamping AUX rising edges."""
+		self.port.write("\x26" + ("\x02" if armed else "\x03"))
+		return self.port.read(1) == "\x01"
+
+	def flight_recorder(self, clear=False):
+		"""Returns (records written, timebase timestamps, records) from the
+		flight recorder, each record being (mode, operation, data, status,
+		timestamp) oldest first, or None if it is not built in.  Records
+		written is larger than the number of records once the ring wrapped."""
+		self.port.write("\x27" + ("\x01" if clear else "\x00"))
+		if self.port.read(1) != "\x01": return None
+		header = [ord(c) for c in self.port.read(8)]
+		if len(header) != 8: return None
+		size = header[0]
+		written = (header[2] << 24) | (header[3] << 16) | (header[4] << 8) | header[5]
+		count = (header[6] << 8) | header[7]
+		data = [ord(c) for c in self.port.read(count * size)]
+		records = []
+		for offset in range(0, len(data) - size + 1, size):
+			records.append(tuple(data[offset:offset + 4]) +
+				((data[offset + 4] << 24) | (data[offset + 5] << 16) |
+				(data[offset + 6] << 8) | data[offset + 7],))
+		return (written, bool(header[1] & 0x01), records)
+
+	TELEMETRY_COUNTERS = ("bytes_in", "bytes_out", "usb_in_packets",
+		"usb_zero_length_packets", "transmit_ring_high_water",
+		"receive_ring_high_water", "uart_ring_high_water", "overflows",
+		"spi_overruns", "uart_overruns", "i2c_nacks")
+
+	def telemetry(self, command="\x28", clear=False):
+		"""Returns a dict of the telemetry counters, or None if they are
+		not built in.  Every binary mode has its own command byte for this:
+		0x28 at the root, 0x20 in SPI, 0x24 in I2C, 0x0B in UART, 0x0C in
+		1-Wire and 0x0F in raw wire."""
+		self.port.write(command + ("\x01" if clear else "\x00"))
+		if self.port.read(1) != "\x01": return None
+		count = ord(self.port.read(1))
+		data = [ord(c) for c in self.port.read(count * 4)]
+		counters = {}
+		for index in range(len(data) / 4):
+			name = self.TELEMETRY_COUNTERS[index] if index < len(self.TELEMETRY_COUNTERS) else index
+			counters[name] = ((data[index * 4] << 24) | (data[index * 4 + 1] << 16) |
+				(data[index * 4 + 2] << 8) | data[index * 4 + 3])
+		return counters
+
+	LINK_SPEEDS = (115200, 250000, 500000, 1000000, 2000000)
+
+	def link_speed(self, speed):
+		"""Moves the v3 host link to speed, one of LINK_SPEEDS, and the port
+		along with it.  Returns False, with both back at the old rate, if
+		the firmware does not know the command or the new rate did not
+		work out.  Returning to the terminal goes back to the old rate."""
+		if speed not in self.LINK_SPEEDS: return False
+		self.port.write("\x29" + chr(self.LINK_SPEEDS.index(speed)))
+		if self.port.read(1) != "\x01": return False
+		previous = self.port.baudrate
+		self.port.baudrate = speed
+		self.port.write("\xAA\x55")
+		if self.port.read(1) == "\x01": return True
+		self.port.baudrate = previous
+		self.port.read(1)
+		return False
+
+	def memory_usage(self):
+		"""Returns a dict of the stack and buffer arena figures in bytes,
+		the arena peaks being listed per protocol in the order the
+		firmware enables them, or None if they are not built in."""
+		self.port.write("\x2B")
+		if self.port.read(1) != "\x01": return None
+		data = [ord(c) for c in self.port.read(13)]
+		if len(data) != 13: return None
+		words = [(data[index] << 8) | data[index + 1] for index in range(0, 12, 2)]
+		peaks = [ord(c) for c in self.port.read(data[12] * 2)]
+		return {"stack_size": words[0], "stack_high_water": words[1],
+			"data_size": words[2], "arena_size": words[3],
+			"arena_reserved": words[4], "arena_largest_free": words[5],
+			"arena_peaks": [(peaks[index] << 8) | peaks[index + 1]
+				for index in range(0, len(peaks) - 1, 2)]}
+
+	BENCHMARK_ENGINES = ("spi", "spi_fifo", "bitbang_3wire", "bitbang_2wire",
+		"1wire")
+
+	def benchmark(self):
+		"""Times the bus engines on the board, with no host link in the
+		loop, and returns (bytes per run, dict of engine name to (bytes per
+		second, loopback mismatches)), or None if it is not built in.
+		Mismatches only mean something with MOSI jumpered to MISO; engines
+		left out of the build get (0, 0).  The run takes about a second,
+		mostly spent in the 1-Wire slots."""
+		self.port.write("\x2C")
+		if self.port.read(1) != "\x01": return None
+		header = [ord(c) for c in self.port.read(3)]
+		if len(header) != 3: return None
+		data = [ord(c) for c in self.port.read(header[0] * 6)]
+		results = {}
+		for index in range(len(data) / 6):
+			name = self.BENCHMARK_ENGINES[index] if index < len(self.BENCHMARK_ENGINES) else index
+			entry = data[index * 6:index * 6 + 6]
+			results[name] = (((entry[0] << 24) | (entry[1] << 16) |
+				(entry[2] << 8) | entry[3]), (entry[4] << 8) | entry[5])
+		return ((header[1] << 8) | header[2], results)
+
+	def read_trigger(self):
+		"""Returns (edges seen since arming, (frame, ticks) of the last
+		one), or None."""
+		self.port.write("\x26\x04")
+		if self.port.read(1) != "\x01": return None
+		data = [ord(c) for c in self.port.read(2)]
+		timestamp = self.read_timestamp()
+		if len(data) != 2 or timestamp is None: return None
+		return ((data[0] << 8) | data[1], timestamp)
+
 	""" PWM """
 	def setup_PWM(self, prescaler, dutycycle, period):
 		self.port.write("\x12")
@@ -166,8 +533,7 @@ class BBIO:
 		for i in range(byte_count):
 			self.port.write(chr(byte_string[i]))
 			#self.timeout(0.1)
-		data = self.response(byte_count+1, True)
-		return data[1:]
+		return self.response(byte_count+1, True, lambda data: data[1:])
 
 	def cfg_pins(self, pins=0):
 		self.port.write(chr(0x40 | pins))
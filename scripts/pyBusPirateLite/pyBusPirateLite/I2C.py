@@ -64,3 +64,126 @@ class I2C(BBIO):
 		#self.timeout(0.1)
 		return self.response()
 
+	def transfer(self, address, write=b"", read_len=0, compressed=False):
+		"""Writes write to the 7 bits device address, then reads read_len
+		bytes after a repeated start, ACKing all but the last one.  Uses the
+		write-then-read command when it fits the firmware buffer and the
+		streamed one otherwise.  If compressed, the streamed command is
+		always used and the firmware run length encodes what it reads,
+		which suits EEPROM dumps full of 0xFF.  write is sent from a
+		memoryview without copies.  Returns the bytes read as a bytearray,
+		or None if the device did not acknowledge."""
+		view = memoryview(write)
+		result = bytearray(read_len)
+		# Reading alone addresses the device in read mode straight away.
+		device = (address << 1) | (0x01 if len(view) == 0 and read_len else 0x00)
+		write_len = len(view) + 1
+		limit = self.terminal_buffer_size()
+		if write_len <= limit and read_len <= limit and not compressed:
+			header = bytearray([0x08, write_len >> 8, write_len & 0xFF,
+				read_len >> 8, read_len & 0xFF])
+		else:
+			header = bytearray([0x28 if compressed else 0x0B])
+			for value in (write_len, read_len):
+				header.extend([(value >> 24) & 0xFF, (value >> 16) & 0xFF,
+					(value >> 8) & 0xFF, value & 0xFF])
+		header.append(device)
+		self.port.write(header)
+		if len(view): self.port.write(view)
+		if not self.expect_success(): return None
+		read = self.read_compressed_into if compressed else self.read_into
+		if read(memoryview(result)) != read_len: return None
+		return result
+
+	def _smbus(self, command, address, code, data, pec):
+		header = bytearray([command, address, code, 0x01 if pec else 0x00])
+		if data is not None:
+			if not 0 < len(data) < 256: raise ValueError("1 to 255 bytes")
+			header.append(len(data))
+			header.extend(data)
+		self.port.write(header)
+		status = self.port.read(1)
+		if len(status) != 1: return None
+		status = bytearray(status)[0]
+		if command == 0x25: return status
+		count = self.port.read(1)
+		if len(count) != 1: return None
+		block = bytearray(bytearray(count)[0])
+		if self.read_into(memoryview(block)) != len(block): return None
+		return status, block
+
+	def smbus_block_write(self, address, code, data, pec=False):
+		"""SMBus block write of data (1 to 255 bytes) to the 7 bits
+		address, with the byte count and optional PEC added by the
+		firmware.  Returns 0x01 on success, 0x00 on a NACK or None if the
+		firmware did not answer."""
+		return self._smbus(0x25, address, code, data, pec)
+
+	def smbus_block_read(self, address, code, pec=False):
+		"""SMBus block read from the 7 bits address, as a (status, block)
+		tuple; status is 0x01 on success, 0x00 on a NACK and 0x02 if the
+		PEC did not match.  None if the firmware did not answer."""
+		return self._smbus(0x26, address, code, None, pec)
+
+	def smbus_process_call(self, address, code, data, pec=False):
+		"""SMBus block write-block read process call, answered like
+		smbus_block_read."""
+		return self._smbus(0x27, address, code, data, pec)
+
+	def emulate_slave(self, address, registers):
+		"""Makes the Bus Pirate answer on the bus as the 7 bits address,
+		serving reads and writes from registers (up to 256 bytes).  The
+		first byte of a write sets the register pointer.  Returns True once
+		the emulator is listening."""
+		self.port.write(bytes([0x21, address, len(registers) >> 8, len(registers) & 0xFF]))
+		if not self.expect_success(): return False
+		self.port.write(bytes(registers))
+		return self.expect_success()
+
+	def slave_events(self):
+		"""Drains the emulator event log, as a list of (type, register,
+		value, transaction) tuples, or None if the firmware did not answer."""
+		self.port.write(b"\x01")
+		if not self.expect_success(): return None
+		length = self.port.read(2)
+		if len(length) != 2: return None
+		data = bytearray((length[0] << 8) | length[1])
+		if self.read_into(memoryview(data)) != len(data): return None
+		return [tuple(data[i:i + 4]) for i in range(0, len(data), 4)]
+
+	def slave_registers(self, size):
+		"""The emulated register map as the master left it."""
+		self.port.write(b"\x02")
+		if not self.expect_success(): return None
+		data = bytearray(size)
+		if self.read_into(memoryview(data)) != size: return None
+		return data
+
+	def stop_slave(self):
+		self.port.write(b"\x00")
+		return self.expect_success()
+
+	def start_statistics(self):
+		"""Starts counting transactions, bytes and NACKs per address.
+		Returns True once counting."""
+		self.port.write(b"\x23")
+		return self.expect_success()
+
+	def read_statistics(self, clear=False):
+		"""The counters as a {address: (transactions, bytes, naks)} dict,
+		zeroed after reading if clear is set, or None if the firmware did
+		not answer."""
+		self.port.write(b"\x02" if clear else b"\x01")
+		if not self.expect_success(): return None
+		count = self.port.read(1)
+		if len(count) != 1: return None
+		data = bytearray(count[0] * 13)
+		if self.read_into(memoryview(data)) != len(data): return None
+		return dict((data[i], (int.from_bytes(data[i + 1:i + 5], "big"),
+			int.from_bytes(data[i + 5:i + 9], "big"),
+			int.from_bytes(data[i + 9:i + 13], "big")))
+			for i in range(0, len(data), 13))
+
+	def stop_statistics(self):
+		self.port.write(b"\x00")
+		return self.expect_success()
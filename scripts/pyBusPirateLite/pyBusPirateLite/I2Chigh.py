@@ -26,9 +26,75 @@ class I2Chigh(I2C):
     """High level I2C transactions"""
     def __init__(self, port, speed, t=1):
         I2C.__init__(self, port, speed, t);
+        self.shadowed = {}
+        self.shadow = {}
+        self.pending = None
+
+    """ Register shadow cache """
+    def shadow_registers(self, i2caddr, volatile=()):
+        """ Keeps a copy of the byte registers of device i2caddr: get_byte
+        answers from it, set_byte skips writes of the value a register
+        already holds.  Registers the device changes on its own (status,
+        data, counters) must be listed in volatile, they are always read. """
+        self.shadowed[i2caddr] = frozenset(volatile)
+
+    def unshadow_registers(self, i2caddr):
+        self.shadowed.pop(i2caddr, None)
+        self.invalidate(i2caddr)
+
+    def invalidate(self, i2caddr, addr=None):
+        """ Forgets what the shadow holds for register addr, or for all the
+        registers of the device, after it was changed behind our back. """
+        for key in list(self.shadow.keys()):
+            if key[0] == i2caddr and (addr is None or key[1] == addr):
+                del self.shadow[key]
+
+    def is_shadowed(self, i2caddr, addr):
+        return i2caddr in self.shadowed and addr not in self.shadowed[i2caddr]
+
+    """ Write coalescing """
+    def begin_writes(self):
+        """ Queues set_byte writes until flush_writes().  Writes to
+        consecutive registers of the same device, in the order given, go
+        out as one auto-increment burst with the write-then-read command,
+        so the device must advance its register pointer on writes. """
+        self.pending = []
+
+    def flush_writes(self):
+        """ Sends the queued writes and stops queueing. """
+        if self.pending is None: return
+        try:
+            self.write_pending()
+        finally:
+            self.pending = None
+
+    def write_pending(self):
+        pending = self.pending
+        self.pending = []
+        runs = []
+        for (i2caddr, addr, value) in pending:
+            if runs and runs[-1][0] == i2caddr and runs[-1][1] + len(runs[-1][2]) == addr:
+                runs[-1][2].append(value)
+            else:
+                runs.append((i2caddr, addr, [value]))
+        for (i2caddr, addr, values) in runs:
+            if self.transfer(i2caddr, bytearray([addr] + values)) is None:
+                self.invalidate(i2caddr)
+                raise IOError("I2C command on address 0x%02x not acknowledged!" % (i2caddr))
+
+    def update_byte(self, i2caddr, addr, mask, value):
+        """ Sets the bits of mask in register addr to those of value, with
+        one read at most (none if the register is shadowed) and no write
+        if nothing changes. """
+        old = self.get_byte(i2caddr, addr)
+        self.set_byte(i2caddr, addr, (old & ~mask) | (value & mask))
 
     def get_byte(self, i2caddr, addr):
         """ Read one byte from address addr """
+        if (i2caddr, addr) in self.shadow:
+            return self.shadow[(i2caddr, addr)]
+        if self.pending:
+            self.write_pending()
         self.send_start_bit();
         stat = self.bulk_trans(2, [i2caddr<<1, addr]);
         self.send_start_bit();
@@ -38,19 +104,36 @@ class I2Chigh(I2C):
         self.send_stop_bit();
         if stat.find(chr(0x01)) != -1:
             raise IOError, "I2C command on address 0x%02x not acknowledged!"%(i2caddr);
+        if self.is_shadowed(i2caddr, addr):
+            self.shadow[(i2caddr, addr)] = ord(r)
         return ord(r);
 
     def set_byte(self, i2caddr, addr, value):
         """ Write one byte to address addr """
+        shadowed = self.is_shadowed(i2caddr, addr)
+        if shadowed and self.shadow.get((i2caddr, addr)) == value:
+            return
+        if self.pending is not None:
+            self.pending.append((i2caddr, addr, value))
+            if shadowed:
+                self.shadow[(i2caddr, addr)] = value
+            return
+        self.shadow.pop((i2caddr, addr), None)
         self.send_start_bit();
         stat = self.bulk_trans(3, [i2caddr<<1, addr, value]);
         self.send_stop_bit();
         if stat.find(chr(0x01)) != -1:
             raise IOError, "I2C command on address 0x%02x not acknowledged!"%(i2caddr);
+        if shadowed:
+            self.shadow[(i2caddr, addr)] = value
 
 
     def command(self, i2caddr, cmd):
         """ Writes one byte command to slave """
+        if self.pending:
+            self.write_pending()
+        # A command may reset or reload any register.
+        self.invalidate(i2caddr)
         self.send_start_bit();
         stat = self.bulk_trans(2, [i2caddr<<1, cmd]);
         self.send_stop_bit();
@@ -61,6 +144,10 @@ class I2Chigh(I2C):
         """ Writes two byte value (big-endian) to address addr """
         vh = value/256;
         vl = value%256;
+        if self.pending:
+            self.write_pending()
+        self.invalidate(i2caddr, addr)
+        self.invalidate(i2caddr, addr + 1)
         self.send_start_bit();
         stat = self.bulk_trans(4, [i2caddr<<1, addr, vh, vl]);
         self.send_stop_bit();
@@ -70,6 +157,8 @@ class I2Chigh(I2C):
 
     def get_word(self, i2caddr, addr):
         """ Reads two byte value (big-endian) from address addr """
+        if self.pending:
+            self.write_pending()
         self.send_start_bit();
         stat = self.bulk_trans(2, [i2caddr<<1, addr]);
         self.send_start_bit();
@@ -0,0 +1,343 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+SVF player for the binary JTAG mode scan queue.
+
+SVF statements are compiled straight into the operations jtag_run_queue()
+in jtag.c takes, so no SVF2XSVF conversion is needed.  Consecutive
+statements are packed into queues as large as the firmware terminal buffer,
+redundant state changes are left out, and the next queue is sent while the
+device still runs the current one, so a file goes out in a few large
+transfers instead of one XSVF byte at a time.
+
+The queue always goes through Exit1 and Update to Run-Test/Idle after a
+shift, so ENDIR, ENDDR and the RUNTEST states can only be IDLE.  RUNTEST
+times are waited for on the host once the queue got there, the TAP
+sitting in Run-Test/Idle meanwhile.  TRST and FREQUENCY are ignored, there
+is no TRST line and TCK runs as fast as the firmware bit-bangs it.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import collections
+import re
+import time
+
+import serial
+
+BITBANG_RESET = 0x00
+BITBANG_JTAG = 0x18
+BITBANG_DESCRIBE = 0x21
+BITBANG_IDENTIFIER = b"BBIO1"
+JTAG_IDENTIFIER = b"XSV1"
+
+# Binary I/O describe entry with the terminal buffer size, see binary_io.h.
+DESCRIBE_TERMINAL_BUFFER = 0x10
+DEFAULT_QUEUE_SIZE = 1024
+
+JTAG_COMMAND_RUN_QUEUE = 0x04
+
+# Scan queue operations, see jtag.c.
+QUEUE_GOTO_STATE = 0x01
+QUEUE_SHIFT_IR = 0x02
+QUEUE_SHIFT_DR = 0x03
+QUEUE_RUNTEST = 0x04
+QUEUE_CAPTURE = 0x80
+QUEUE_MAXIMUM_COUNT = 0xFFFF
+
+STATE_RESET = 0
+STATE_IDLE = 1
+
+class SVFError(Exception):
+	pass
+
+def svf_statements(text):
+	"""(line, words) for each statement, comments dropped and parenthesised
+	values kept as single words without their spaces."""
+	line = 1
+	start = None
+	current = []
+	for number, raw in enumerate(text.splitlines(), 1):
+		raw = re.split(r"!|//", raw, 1)[0]
+		for part in re.split(r"(;)", raw):
+			if part == ";":
+				words = re.findall(r"\([^)]*\)|[^\s()]+", " ".join(current))
+				if words:
+					yield (start, [re.sub(r"\s+", "", word) for word in words])
+				current = []
+				start = None
+			elif part.strip():
+				if start is None:
+					start = number
+				current.append(part)
+	if "".join(current).strip():
+		raise SVFError("line %d: statement not terminated" % start)
+
+def hex_value(word, bits, line):
+	if not (word.startswith("(") and word.endswith(")")):
+		raise SVFError("line %d: expected a parenthesised value, got %s" % (line, word))
+	try:
+		value = int(word[1:-1] or "0", 16)
+	except ValueError:
+		raise SVFError("line %d: bad hex value %s" % (line, word))
+	if value >> bits:
+		raise SVFError("line %d: value %s is wider than %d bits" % (line, word, bits))
+	return value
+
+class Scan(object):
+	"""What a HIR/TIR/HDR/TDR/SIR/SDR statement last set, TDI and MASK are
+	kept from one statement to the next as long as the length stays.  Pads
+	without TDI are all ones or all zeros, as tdi_default says."""
+	def __init__(self, tdi_default=None):
+		self.bits = 0
+		self.tdi_default = tdi_default
+		self.tdi = 0
+		self.mask = 0
+
+	def update(self, words, line):
+		bits = int(words[1])
+		fields = dict(zip(words[2::2], words[3::2]))
+		if bits != self.bits:
+			if bits and "TDI" not in fields and self.tdi_default is None:
+				raise SVFError("line %d: %s changes length without TDI" % (line, words[0]))
+			self.bits = bits
+			self.tdi = ((1 << bits) - 1) if self.tdi_default else 0
+			self.mask = (1 << bits) - 1
+		if "TDI" in fields:
+			self.tdi = hex_value(fields["TDI"], bits, line)
+		if "MASK" in fields:
+			self.mask = hex_value(fields["MASK"], bits, line)
+		# TDO is only compared for the statement that gives it.
+		tdo = hex_value(fields["TDO"], bits, line) if "TDO" in fields else None
+		return tdo
+
+class Queue(object):
+	"""One scan queue: the operations, the TDO bytes it answers with and
+	what they are checked against, and how long to wait once it ran."""
+	def __init__(self):
+		self.operations = bytearray()
+		self.reply_length = 0
+		self.checks = []
+		self.delay = 0.0
+
+class SVFCompiler(object):
+	def __init__(self, queue_size):
+		# the queue plus its command byte and length must fit in the buffer
+		self.queue_size = queue_size
+		self.state = None
+		self.header = {"IR": Scan(1), "DR": Scan(0)}
+		self.trailer = {"IR": Scan(1), "DR": Scan(0)}
+		self.scan = {"IR": Scan(), "DR": Scan()}
+		self.queues = []
+		self.current = Queue()
+
+	def append(self, operation):
+		if len(operation) > self.queue_size:
+			raise SVFError("a %d bytes operation does not fit in a %d bytes queue"
+				% (len(operation), self.queue_size))
+		if len(self.current.operations) + len(operation) > self.queue_size:
+			self.flush()
+		self.current.operations += operation
+
+	def flush(self):
+		if self.current.operations or self.current.delay:
+			self.queues.append(self.current)
+		self.current = Queue()
+
+	def goto(self, state):
+		if state == self.state:
+			return
+		self.append(bytearray([QUEUE_GOTO_STATE, state]))
+		self.state = state
+
+	def runtest(self, clocks):
+		while clocks > 0:
+			count = min(clocks, QUEUE_MAXIMUM_COUNT)
+			self.append(bytearray([QUEUE_RUNTEST, count >> 8, count & 0xFF]))
+			clocks -= count
+		self.state = STATE_IDLE
+
+	def shift(self, register, words, line):
+		tdo = self.scan[register].update(words, line)
+		scan = self.scan[register]
+		header = self.header[register]
+		trailer = self.trailer[register]
+		bits = header.bits + scan.bits + trailer.bits
+		if bits == 0:
+			return
+		if bits > QUEUE_MAXIMUM_COUNT:
+			raise SVFError("line %d: %d bits are more than a queue shift takes" % (line, bits))
+
+		# The header goes out first, least significant bit first.
+		tdi = (header.tdi | (scan.tdi << header.bits) |
+			(trailer.tdi << (header.bits + scan.bits)))
+		size = (bits + 7) // 8
+		operation = QUEUE_SHIFT_IR if register == "IR" else QUEUE_SHIFT_DR
+		if tdo is not None:
+			operation |= QUEUE_CAPTURE
+		data = bytearray(size)
+		for index in range(size):
+			data[index] = (tdi >> (index * 8)) & 0xFF
+		entry = bytearray([operation, bits >> 8, bits & 0xFF]) + data
+
+		self.append(entry)
+		if tdo is not None:
+			self.current.checks.append((line, self.current.reply_length, size,
+				tdo << header.bits, scan.mask << header.bits))
+			self.current.reply_length += size
+		self.state = STATE_IDLE
+
+	def statement(self, line, words):
+		command = words[0].upper()
+		words = [command] + [word.upper() for word in words[1:]]
+		if command in ("SIR", "SDR"):
+			self.shift(command[1:], words, line)
+		elif command in ("HIR", "HDR"):
+			self.header[command[1:]].update(words, line)
+		elif command in ("TIR", "TDR"):
+			self.trailer[command[1:]].update(words, line)
+		elif command in ("ENDIR", "ENDDR"):
+			if words[1:] != ["IDLE"]:
+				raise SVFError("line %d: %s %s, the scan queue always ends in IDLE"
+					% (line, command, " ".join(words[1:])))
+		elif command == "STATE":
+			path = words[1:]
+			if not path or path[-1] not in ("RESET", "IDLE") or \
+					any(state not in ("RESET", "IDLE") for state in path):
+				raise SVFError("line %d: STATE %s, only RESET and IDLE are supported"
+					% (line, " ".join(path)))
+			if "RESET" in path:
+				self.goto(STATE_RESET)
+			if path[-1] == "IDLE":
+				self.goto(STATE_IDLE)
+		elif command == "RUNTEST":
+			self.runtest_statement(words[1:], line)
+		elif command in ("TRST", "FREQUENCY"):
+			pass
+		else:
+			raise SVFError("line %d: %s is not supported" % (line, command))
+
+	def runtest_statement(self, words, line):
+		clocks = 0
+		delay = 0.0
+		if words and words[0] in ("IDLE", "RESET", "DRPAUSE", "IRPAUSE"):
+			if words[0] != "IDLE":
+				raise SVFError("line %d: RUNTEST %s, only IDLE is supported" % (line, words[0]))
+			words = words[1:]
+		if len(words) >= 2 and words[1] == "TCK":
+			clocks = int(float(words[0]))
+			words = words[2:]
+		elif len(words) >= 2 and words[1] == "SCK":
+			raise SVFError("line %d: RUNTEST on SCK is not supported" % line)
+		if len(words) >= 2 and words[1] == "SEC":
+			delay = float(words[0])
+			words = words[2:]
+		if len(words) >= 3 and words[0] == "MAXIMUM":
+			words = words[3:]
+		if len(words) >= 2 and words[0] == "ENDSTATE":
+			if words[1] != "IDLE":
+				raise SVFError("line %d: RUNTEST ENDSTATE %s, only IDLE is supported"
+					% (line, words[1]))
+			words = words[2:]
+		if words:
+			raise SVFError("line %d: cannot make sense of RUNTEST %s" % (line, " ".join(words)))
+
+		if clocks or delay:
+			self.goto(STATE_IDLE)
+		self.runtest(clocks)
+		if delay:
+			# waited for on the host, once everything before has been clocked
+			self.current.delay += delay
+			self.flush()
+
+def compile_svf(text, queue_size=DEFAULT_QUEUE_SIZE):
+	"""The scan queues making up the SVF file text, each at most queue_size
+	bytes long."""
+	compiler = SVFCompiler(queue_size)
+	for (line, words) in svf_statements(text):
+		compiler.statement(line, words)
+	compiler.flush()
+	return compiler.queues
+
+class JTAG(object):
+	def __init__(self, p="/dev/bus_pirate", s=115200, t=1):
+		self.port = serial.Serial(p, s, timeout=t)
+		self.queue_size = DEFAULT_QUEUE_SIZE
+
+	def enter(self):
+		"""Enters binary mode, sizes queues from the terminal buffer and
+		switches to the binary JTAG mode.  The firmware stays there until
+		it is reset."""
+		self.port.reset_input_buffer()
+		for attempt in range(20):
+			self.port.write(bytes(bytearray([BITBANG_RESET])))
+			if self.port.read(len(BITBANG_IDENTIFIER)) == BITBANG_IDENTIFIER:
+				break
+		else:
+			raise SVFError("could not enter binary mode")
+		time.sleep(0.05)
+		self.port.reset_input_buffer()
+
+		self.port.write(bytes(bytearray([BITBANG_DESCRIBE])))
+		header = bytearray(self.port.read(2))
+		if len(header) == 2 and header != bytearray(2):
+			data = bytearray(self.port.read((header[0] << 8) | header[1]))
+			while len(data) >= 2:
+				value = 0
+				for byte in data[2:2 + data[1]]:
+					value = (value << 8) | byte
+				if data[0] == DESCRIBE_TERMINAL_BUFFER:
+					self.queue_size = value - 3
+				data = data[2 + data[1]:]
+		else:
+			self.port.reset_input_buffer()
+
+		self.port.write(bytes(bytearray([BITBANG_JTAG])))
+		if self.port.read(len(JTAG_IDENTIFIER)) != JTAG_IDENTIFIER:
+			raise SVFError("no binary JTAG mode, it needs a v4")
+
+	def send(self, queue):
+		length = len(queue.operations)
+		self.port.write(bytes(bytearray([JTAG_COMMAND_RUN_QUEUE, length >> 8, length & 0xFF])
+			+ queue.operations))
+
+	def receive(self, queue):
+		if bytearray(self.port.read(1)) != bytearray([0x01]):
+			raise SVFError("the firmware refused a queue")
+		reply = bytearray(self.port.read(queue.reply_length))
+		if len(reply) != queue.reply_length:
+			raise SVFError("timed out waiting for TDO")
+		for (line, offset, size, expected, mask) in queue.checks:
+			value = 0
+			for index in range(size):
+				value |= reply[offset + index] << (index * 8)
+			if (value ^ expected) & mask:
+				raise SVFError("line %d: TDO mismatch, read %X expected %X mask %X"
+					% (line, value & mask, expected & mask, mask))
+
+	def play(self, queues, depth=2, progress=None):
+		"""Runs the queues, at most depth of them sent ahead of the one the
+		device answered last.  Queues ending in a wait are answered before
+		the wait starts and before anything else is sent."""
+		pending = collections.deque()
+		for (index, queue) in enumerate(queues):
+			if queue.operations:
+				self.send(queue)
+				pending.append(queue)
+			while pending and (queue.delay or len(pending) >= depth):
+				self.receive(pending.popleft())
+			if queue.delay:
+				time.sleep(queue.delay)
+			if progress:
+				progress(index + 1, len(queues))
+		while pending:
+			self.receive(pending.popleft())
+
+	def close(self):
+		self.port.close()
@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+OpenOCD binary mode, the protocol the OpenOCD buspirate driver speaks.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+from .BitBang import BBIO
+
+class OpenOCDPortMode:
+	HIZ = 0
+	JTAG = 1
+	JTAG_OD = 2
+
+# Bits per TAP shift command.  The count field is 16 bits, this keeps each
+# command at a few USB packets each way.
+TAP_SHIFT_CHUNK_BITS = 0x2000
+
+class OpenOCD(BBIO):
+	def __init__(self, port, speed):
+		BBIO.__init__(self, port, speed)
+
+	def port_mode(self, mode):
+		self.port.write(bytearray([0x01, mode]))
+
+	def feature(self, feature, value):
+		self.port.write(bytearray([0x02, feature, value]))
+
+	def tap_shift(self, tdi, tms, bits):
+		"""Clocks bits TDI/TMS bit pairs out, LSB first, and returns the TDO
+		bits as a bytearray.  tdi and tms hold (bits + 7) / 8 bytes each and
+		are read through memoryviews without copies.  Long shifts are split
+		in several commands.  Returns None if the firmware answer is off."""
+		tdi = memoryview(tdi)
+		tms = memoryview(tms)
+		result = bytearray((bits + 7) // 8)
+		view = memoryview(result)
+		for first in range(0, bits, TAP_SHIFT_CHUNK_BITS):
+			count = min(bits - first, TAP_SHIFT_CHUNK_BITS)
+			start = first // 8
+			end = start + (count + 7) // 8
+			pairs = bytearray(2 * (end - start))
+			pairs[0::2] = tdi[start:end]
+			pairs[1::2] = tms[start:end]
+			header = bytearray([0x05, count >> 8, count & 0xFF])
+			self.port.write(header + pairs)
+			if bytearray(self.port.read(3)) != header: return None
+			if self.read_into(view[start:end]) != end - start: return None
+		return result
@@ -56,6 +56,9 @@ class RAW_WIRE_COMMANDS:
 	CFG_PERIPHERALS = "\x40"
 	SET_SPEED	= "\x60"
 	CFG_MODE	= "\x80"
+	CARD_ACTIVATE	= "\x90"
+	CARD_APDU	= "\x91"
+	CARD_DEACTIVATE	= "\x92"
 	
 
 class RAW_WIRE(BBIO):
@@ -158,4 +161,33 @@ class RAW_WIRE(BBIO):
 	def cfg_raw_wire(self, raw_wire_cfg):
 		return self.command( chr(0x80 | raw_wire_cfg ), 1)
 
+	# 10010000 – ISO 7816-3 card activation, RST on CS, CLK on CLK, I/O on MOSI
 
+	def card_activate(self):
+		"""Powers up an asynchronous smart card and returns its ATR, or
+		None if it gave no valid T=0 answer to reset."""
+		self.port.write(RAW_WIRE_COMMANDS.CARD_ACTIVATE)
+		if self.port.read(1) != "\x01":
+			self.port.read(1)
+			return None
+		length = ord(self.port.read(1))
+		return self.port.read(length)
+
+	# 10010001 – ISO 7816-3 T=0 APDU exchange
+
+	def card_apdu(self, apdu):
+		"""Sends a command APDU and returns the response data with SW1 and
+		SW2 at the end, or None if the exchange failed."""
+		self.port.write(RAW_WIRE_COMMANDS.CARD_APDU)
+		self.port.write(chr(len(apdu) >> 8) + chr(len(apdu) & 0xFF))
+		self.port.write(apdu)
+		if self.port.read(1) != "\x01":
+			self.port.read(1)
+			return None
+		data = self.port.read(2)
+		return self.port.read((ord(data[0]) << 8) | ord(data[1]))
+
+	# 10010010 – ISO 7816-3 card deactivation
+
+	def card_deactivate(self):
+		return self.command(RAW_WIRE_COMMANDS.CARD_DEACTIVATE, 1)
@@ -78,3 +78,110 @@ class SPI(BBIO):
 		self.timeout(0.1)
 		return self.response(1, True)
 
+	def set_word_size(self, bits):
+		"""Makes bulk and write-then-read transfers move 16 bits words when
+		bits is 16, or bytes when it is 8.  In 16 bits mode lengths must be
+		even and byte-only commands are refused."""
+		self.port.write(bytes([0x0B, 0x01 if bits == 16 else 0x00]))
+		return self.expect_success()
+
+	def transfer(self, write=b"", read_len=0, cs=True):
+		"""Writes write to the bus, then clocks in read_len bytes, with the
+		firmware's write-then-read command.  write can be anything with the
+		buffer interface, it is sent from a memoryview without copies.  If
+		cs, CS is low for the whole transfer.  Transfers larger than the
+		firmware buffer are split, with CS held low in between.  Returns the
+		bytes read as a bytearray, or None if the firmware refused."""
+		view = memoryview(write)
+		result = bytearray(read_len)
+		limit = self.terminal_buffer_size()
+		if len(view) <= limit and read_len <= limit:
+			if not self.write_then_read(0x04 if cs else 0x05, view, memoryview(result)):
+				return None
+			return result
+		if cs:
+			self.port.write(b"\x02")
+			if not self.expect_success(): return None
+		read_view = memoryview(result)
+		ok = True
+		for offset in range(0, len(view), limit):
+			ok = ok and self.write_then_read(0x05, view[offset:offset + limit], read_view[:0])
+		for offset in range(0, read_len, limit):
+			ok = ok and self.write_then_read(0x05, view[:0], read_view[offset:offset + limit])
+		if cs:
+			self.port.write(b"\x03")
+			ok = self.expect_success() and ok
+		if ok: return result
+		return None
+
+	def write_then_read(self, command, write, read):
+		"""One write-then-read command, reading into the memoryview read."""
+		self.port.write(bytes([command, len(write) >> 8, len(write) & 0xFF,
+			len(read) >> 8, len(read) & 0xFF]))
+		if len(write): self.port.write(write)
+		if not self.expect_success(): return False
+		return self.read_into(read) == len(read)
+
+	def stream_transfer(self, write=b"", read_len=0, cs=True, compressed=False):
+		"""Like transfer, but with the streaming write-then-read command and
+		no size limit.  If compressed, the firmware run length encodes what
+		it reads and it is decoded here, which makes erased flash and
+		padding come in much faster.  Returns the bytes read as a
+		bytearray, or None if the firmware refused."""
+		view = memoryview(write)
+		result = bytearray(read_len)
+		header = bytearray([0x07, (0x01 if cs else 0x00) | (0x02 if compressed else 0x00)])
+		for value in (len(view), read_len):
+			header.extend([(value >> 24) & 0xFF, (value >> 16) & 0xFF,
+				(value >> 8) & 0xFF, value & 0xFF])
+		self.port.write(header)
+		if len(view): self.port.write(view)
+		if not self.expect_success(): return None
+		read = self.read_compressed_into if compressed else self.read_into
+		if read(memoryview(result)) != read_len: return None
+		return result
+
+	def emulate_flash(self, image, jedec_id=b"\xEF\x40\x13"):
+		"""Uploads image and makes the Bus Pirate answer READ, FAST_READ,
+		RDID and RDSR as an SPI flash, with MISO driven while CS is low.
+		image must fit in the firmware buffer, addresses wrap around past
+		its end.  Returns True once the emulator is listening."""
+		self.port.write(b"\x0A" + bytes(jedec_id[:3]) +
+			bytes([len(image) >> 8, len(image) & 0xFF]))
+		if not self.expect_success(): return False
+		self.port.write(bytes(image))
+		return self.expect_success()
+
+	def stop_flash_emulation(self):
+		"""Stops the flash emulator, returns how many commands it served or
+		None if the firmware did not answer."""
+		self.port.write(b"\x00")
+		if not self.expect_success(): return None
+		served = self.port.read(2)
+		if len(served) != 2: return None
+		return (served[0] << 8) | served[1]
+
+	def start_statistics(self):
+		"""Starts counting frames and bytes per first MOSI byte of each CS
+		frame.  Returns True once counting."""
+		self.port.write(b"\x0C")
+		return self.expect_success()
+
+	def read_statistics(self, clear=False):
+		"""(overrun, {opcode: (frames, bytes)}), zeroed after reading if
+		clear is set, or None if the firmware did not answer.  overrun is
+		True if some frames were left out since the previous read."""
+		self.port.write(b"\x02" if clear else b"\x01")
+		if not self.expect_success(): return None
+		header = self.port.read(3)
+		if len(header) != 3: return None
+		data = bytearray(((header[1] << 8) | header[2]) * 9)
+		if self.read_into(memoryview(data)) != len(data): return None
+		return (bool(header[0] & 0x01),
+			dict((data[i], (int.from_bytes(data[i + 1:i + 5], "big"),
+				int.from_bytes(data[i + 5:i + 9], "big")))
+				for i in range(0, len(data), 9)))
+
+	def stop_statistics(self):
+		self.port.write(b"\x00")
+		return self.expect_success()
@@ -0,0 +1,429 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+SUMP logic analyser client.
+
+Speaks the SUMP protocol as sump.c implements it: identification, metadata,
+the parallel trigger stages, the sample rate divider, read and delay counts,
+run length encoding, and the Bus Pirate streaming and MISO bitstream
+extensions.  Samples come
+back as numpy arrays of one byte per sample, the probes in the low bits, and
+are decoded with vectorised operations only, so long captures and streams
+can be analysed in the same process at the rate they arrive.  write_vcd()
+turns them into a Value Change Dump for GTKWave or PulseView.
+
+The firmware goes back to the terminal after every capture, capture() and
+stream() enter SUMP mode again on their own.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import time
+
+import numpy
+import serial
+
+SUMP_RESET = 0x00
+SUMP_RUN = 0x01
+SUMP_ID = 0x02
+SUMP_DESC = 0x04
+SUMP_XOFF = 0x13
+SUMP_RUN_STREAMING = 0x0A
+SUMP_RUN_STREAMING_PACKED = 0x0B
+SUMP_RUN_BITSTREAM = 0x0D
+SUMP_DIV = 0x80
+SUMP_CNT = 0x81
+SUMP_FLAGS = 0x82
+SUMP_TRIG = 0xC0
+SUMP_TRIG_VALS = 0xC1
+SUMP_TRIG_CONFIG = 0xC2
+
+SUMP_DEVICE_ID = b"1ALS"
+
+FLAGS_RLE = 0x01
+FLAGS_OLDEST_FIRST = 0x80
+CHANNEL_GROUPS = 4
+CHANNEL_GROUPS_SHIFT = 2
+
+TRIGGER_STAGES = 4
+TRIGGER_START = 0x08
+
+RLE_COUNT_FLAG = 0x80
+RLE_COUNT_MASK = 0x7F
+STREAM_OVERRUN = 0x80
+BITSTREAM_HEADER_SIZE = 5
+PROBES_MASK = 0x7F
+
+# The divider counts in periods of the 100MHz SUMP reference clock, the
+# firmware turns it into instruction cycles.
+SUMP_CLOCK = 100000000
+FCY = 16000000
+
+METADATA_END = 0x00
+METADATA_STRINGS = {0x01: "device name", 0x02: "fpga version", 0x03: "ancillary version"}
+METADATA_WORDS = {0x20: "probes", 0x21: "sample memory", 0x22: "dynamic memory",
+	0x23: "maximum sample rate", 0x24: "protocol version"}
+METADATA_BYTES = {0x40: "probes", 0x41: "protocol version"}
+
+# Probe order as in SUMP samples, see SUMP_PROBES_RPIN in sump.c.
+PROBES = {
+	"v3": ["CS", "MISO", "CLK", "MOSI", "AUX"],
+	"v4": ["MOSI", "CLK", "MISO", "CS", "AUX", "AUX1", "AUX2"],
+}
+
+class SUMPError(Exception):
+	pass
+
+def divider_for_rate(rate):
+	"""SUMP_DIV value that gets closest to rate samples per second."""
+	return max(0, int(round(float(SUMP_CLOCK) / rate)) - 1)
+
+def rate_for_divider(divider):
+	"""Sample rate the firmware actually runs at for a SUMP_DIV value."""
+	cycles = max(1, ((divider + 1) * 4 + 12) // 25)
+	return float(FCY) / cycles
+
+def first_group(data, groups=1):
+	"""Keeps the byte of the first channel group out of every sample."""
+	samples = numpy.frombuffer(bytes(data), dtype=numpy.uint8)
+	if groups > 1:
+		samples = samples[:len(samples) - len(samples) % groups].reshape(-1, groups)[:, 0]
+	return samples
+
+def decode_rle(data):
+	"""
+	Expands a run length encoded capture.  A count byte repeats the sample
+	before it as many more times as its low seven bits say, and long runs
+	take several count bytes in a row.
+	"""
+	raw = numpy.frombuffer(bytes(data), dtype=numpy.uint8)
+	counts = (raw & RLE_COUNT_FLAG) != 0
+	# every byte belongs to the last plain sample at or before it
+	owner = numpy.cumsum(~counts) - 1
+	leading = owner < 0
+	if leading.any():
+		# counts of a sample that was not uploaded, nothing to repeat
+		counts = counts[~leading]
+		owner = owner[~leading]
+		raw = raw[~leading]
+	values = raw[~counts]
+	repeats = numpy.bincount(owner[counts], weights=raw[counts] & RLE_COUNT_MASK,
+		minlength=len(values)).astype(numpy.int64) + 1
+	return numpy.repeat(values, repeats)
+
+def unpack_packed(data):
+	"""Splits a packed stream, two samples per byte, the oldest in the low nibble."""
+	raw = numpy.frombuffer(bytes(data), dtype=numpy.uint8)
+	samples = numpy.empty(len(raw) * 2, dtype=numpy.uint8)
+	samples[0::2] = raw & 0x0F
+	samples[1::2] = raw >> 4
+	return samples
+
+def unpack_bitstream(data, probe=0):
+	"""Expands a bitstream capture into one sample per bit, oldest first,
+	with the level in the probe bit as regular samples have it."""
+	raw = numpy.frombuffer(bytes(data), dtype=numpy.uint8)
+	return (numpy.unpackbits(raw) << probe).astype(numpy.uint8)
+
+def probe_levels(samples, probes=5):
+	"""One column of 0 and 1 per probe, one row per sample."""
+	samples = numpy.asarray(samples, dtype=numpy.uint8)
+	return (samples[:, None] >> numpy.arange(probes, dtype=numpy.uint8)) & 1
+
+def write_vcd(output, samples, rate, names, version="Bus Pirate SUMP capture"):
+	"""
+	Writes samples taken rate times per second as a Value Change Dump.  Only
+	the samples where a probe changed are visited, so long idle stretches
+	cost nothing.
+	"""
+	samples = numpy.asarray(samples, dtype=numpy.uint8)
+	identifiers = [chr(ord("!") + probe) for probe in range(len(names))]
+	period = 1e12 / rate
+
+	output.write("$date %s $end\n" % time.strftime("%Y-%m-%d %H:%M:%S"))
+	output.write("$version %s $end\n" % version)
+	output.write("$timescale 1ps $end\n")
+	output.write("$scope module bus_pirate $end\n")
+	for (identifier, name) in zip(identifiers, names):
+		output.write("$var wire 1 %s %s $end\n" % (identifier, name))
+	output.write("$upscope $end\n$enddefinitions $end\n")
+	if len(samples) == 0:
+		return
+
+	output.write("#0\n$dumpvars\n")
+	for (probe, identifier) in enumerate(identifiers):
+		output.write("%d%s\n" % ((samples[0] >> probe) & 1, identifier))
+	output.write("$end\n")
+
+	changes = numpy.flatnonzero(samples[1:] != samples[:-1]) + 1
+	toggled = samples[changes] ^ samples[changes - 1]
+	times = numpy.round(changes * period).astype(numpy.int64)
+	for (index, flips, timestamp) in zip(changes.tolist(), toggled.tolist(), times.tolist()):
+		output.write("#%d\n" % timestamp)
+		for (probe, identifier) in enumerate(identifiers):
+			if flips & (1 << probe):
+				output.write("%d%s\n" % ((samples[index] >> probe) & 1, identifier))
+	output.write("#%d\n" % int(round(len(samples) * period)))
+
+class SUMP(object):
+	def __init__(self, p="/dev/bus_pirate", s=115200, t=1):
+		self.port = serial.Serial(p, s, timeout=t)
+		self.active = False
+		self.divider = divider_for_rate(1000000)
+		self.read_count = 4096
+		self.delay_count = 4096
+		self.rle = False
+		self.triggers = [None] * TRIGGER_STAGES
+		self.memory = None
+
+	def send(self, command, data=None):
+		if data is None:
+			self.port.write(bytes(bytearray([command])))
+		else:
+			# long commands carry four bytes, least significant first
+			self.port.write(bytes(bytearray([command, data & 0xFF, (data >> 8) & 0xFF,
+				(data >> 16) & 0xFF, (data >> 24) & 0xFF])))
+
+	def enter(self):
+		"""Enters SUMP mode from the terminal, or starts it over."""
+		self.port.reset_input_buffer()
+		if self.active:
+			# a reset drops back to the terminal, which starts counting afresh
+			self.reset()
+		# the terminal takes five zeros and SUMP_ID as the way in
+		self.port.write(bytes(bytearray([SUMP_RESET] * 5 + [SUMP_ID])))
+		reply = self.port.read(len(SUMP_DEVICE_ID))
+		deadline = time.time() + self.port.timeout
+		while not reply.endswith(SUMP_DEVICE_ID) and time.time() < deadline:
+			more = self.port.read(1)
+			if not more:
+				break
+			reply += more
+		if not reply.endswith(SUMP_DEVICE_ID):
+			raise SUMPError("could not enter SUMP mode, got %r" % reply)
+		self.active = True
+
+	def reset(self):
+		"""Leaves SUMP mode, back to the terminal."""
+		self.send(SUMP_RESET)
+		self.active = False
+
+	def identify(self):
+		if not self.active:
+			self.enter()
+		self.send(SUMP_ID)
+		return self.port.read(len(SUMP_DEVICE_ID))
+
+	def metadata(self):
+		"""The SUMP_DESC keys, by name."""
+		if not self.active:
+			self.enter()
+		self.send(SUMP_DESC)
+		result = {}
+		while True:
+			key = self.port.read(1)
+			if not key:
+				raise SUMPError("metadata cut short")
+			key = bytearray(key)[0]
+			if key == METADATA_END:
+				return result
+			if key in METADATA_STRINGS or (key < 0x20):
+				value = b""
+				while True:
+					char = self.port.read(1)
+					if not char or char == b"\x00":
+						break
+					value += char
+				result[METADATA_STRINGS.get(key, key)] = value.decode("utf-8", "replace")
+			elif key < 0x40:
+				value = bytearray(self.port.read(4))
+				if len(value) != 4:
+					raise SUMPError("metadata cut short")
+				result[METADATA_WORDS.get(key, key)] = ((value[0] << 24) | (value[1] << 16) |
+					(value[2] << 8) | value[3])
+			else:
+				value = bytearray(self.port.read(1))
+				if len(value) != 1:
+					raise SUMPError("metadata cut short")
+				result[METADATA_BYTES.get(key, key)] = value[0]
+
+	def set_rate(self, rate):
+		"""Picks the divider for rate, returns the rate actually used."""
+		self.divider = divider_for_rate(rate)
+		return self.rate()
+
+	def rate(self):
+		return rate_for_divider(self.divider)
+
+	def set_samples(self, samples, after_trigger=None):
+		"""How many samples to read back, and how many of those follow the trigger."""
+		if after_trigger is None:
+			after_trigger = samples
+		self.read_count = samples
+		self.delay_count = min(after_trigger, samples)
+
+	def set_rle(self, enable):
+		self.rle = enable
+
+	def set_trigger(self, mask, values, stage=0, delay=0, level=0, start=True):
+		"""Parallel trigger: fires when the probes in mask take their bits in values."""
+		self.triggers[stage] = (mask, values, delay, level, start)
+
+	def clear_triggers(self):
+		self.triggers = [None] * TRIGGER_STAGES
+
+	def configure(self):
+		self.send(SUMP_DIV, self.divider)
+		# both counts are in units of four samples, minus one
+		self.send(SUMP_CNT, ((max(self.read_count, 4) // 4 - 1) & 0xFFFF) |
+			(((max(self.delay_count, 4) // 4 - 1) & 0xFFFF) << 16))
+		groups = (0x0E << CHANNEL_GROUPS_SHIFT)
+		flags = FLAGS_OLDEST_FIRST | (FLAGS_RLE if self.rle else 0)
+		self.send(SUMP_FLAGS, groups | (flags << 8))
+		# entering SUMP mode cleared the stages, only the ones in use are sent
+		for (stage, trigger) in enumerate(self.triggers):
+			if trigger is None:
+				continue
+			(mask, values, delay, level, start) = trigger
+			self.send(SUMP_TRIG | (stage << 2), mask)
+			self.send(SUMP_TRIG_VALS | (stage << 2), values)
+			self.send(SUMP_TRIG_CONFIG | (stage << 2), (delay & 0xFFFF) |
+				((level & 0x03) << 16) | ((TRIGGER_START if start else 0) << 24))
+
+	def capture(self, timeout=None, partial=False):
+		"""
+		Runs a buffered capture and returns its samples, oldest first.  Waits
+		for the trigger for timeout seconds, or forever.  With partial set, a
+		timeout or Ctrl-C stops the capture instead and returns the samples
+		taken so far, which can be none at all.
+		"""
+		self.enter()
+		if self.memory is None:
+			self.memory = self.metadata().get("sample memory", 0)
+		self.configure()
+		self.send(SUMP_RUN)
+		wanted = max(self.read_count, 4) // 4 * 4
+		if self.memory:
+			# the firmware clamps the count to its sample memory
+			wanted = min(wanted, self.memory)
+		saved = self.port.timeout
+		self.port.timeout = timeout
+		stopped = False
+		try:
+			first = self.port.read(1)
+		except KeyboardInterrupt:
+			if not partial:
+				# disarm, or the next command is taken for probe data
+				self.reset()
+				raise
+			first = b""
+		finally:
+			self.port.timeout = saved
+		if not first and partial:
+			# the capture ends at once and uploads what it holds
+			self.port.write(bytes(bytearray([SUMP_XOFF])))
+			stopped = True
+		elif not first:
+			self.reset()
+			raise SUMPError("the trigger did not fire")
+		data = first + self.port.read(wanted - len(first))
+		# an upload ends SUMP mode, an empty stop only disarmed the sampler
+		self.active = stopped and not data
+		if len(data) != wanted and not stopped:
+			raise SUMPError("expected %d bytes of samples, got %d" % (wanted, len(data)))
+		if self.rle:
+			return decode_rle(data)
+		return first_group(data) & PROBES_MASK
+
+	def capture_bitstream(self, timeout=None):
+		"""
+		Runs a bitstream capture of the MISO probe, eight samples per byte
+		of sample memory, at the fastest SPI clock not above the rate set.
+		Waits for the trigger for timeout seconds, or forever.  Returns the
+		samples oldest first, MISO in its probe bit, and the rate used.
+		"""
+		self.enter()
+		self.configure()
+		self.send(SUMP_RUN_BITSTREAM)
+		saved = self.port.timeout
+		self.port.timeout = timeout
+		try:
+			first = self.port.read(1)
+		except KeyboardInterrupt:
+			self.reset()
+			raise
+		finally:
+			self.port.timeout = saved
+		if not first:
+			self.reset()
+			raise SUMPError("the trigger did not fire")
+		header = bytearray(first + self.port.read(BITSTREAM_HEADER_SIZE - 1))
+		self.active = False
+		if len(header) != BITSTREAM_HEADER_SIZE:
+			raise SUMPError("bitstream header cut short")
+		period = (header[1] << 8) | header[2]
+		length = (header[3] << 8) | header[4]
+		data = self.port.read(length)
+		if len(data) != length:
+			raise SUMPError("expected %d bytes of samples, got %d" % (length, len(data)))
+		return (unpack_bitstream(data, header[0]), float(FCY) / period)
+
+	def stream(self, samples=None, seconds=None, packed=False, chunk=4096):
+		"""
+		Streams samples as they are taken, yielding them in numpy arrays of
+		about chunk samples, until samples were received, seconds went by or
+		the generator is closed.  The rate must be low enough for the link.
+		"""
+		self.enter()
+		self.configure()
+		self.send(SUMP_RUN_STREAMING_PACKED if packed else SUMP_RUN_STREAMING)
+		self.active = False
+		per_byte = 2 if packed else 1
+		received = 0
+		started = time.time()
+		stopped = False
+		try:
+			while samples is None or received < samples:
+				if seconds is not None and time.time() - started >= seconds:
+					break
+				pending = self.port.in_waiting
+				data = self.port.read(max(1, min(pending, chunk // per_byte)))
+				if not data:
+					continue
+				if packed:
+					decoded = unpack_packed(data)
+				else:
+					decoded = first_group(data)
+					overrun = numpy.flatnonzero(decoded & STREAM_OVERRUN)
+					if len(overrun):
+						decoded = decoded[:overrun[0]]
+						stopped = True
+				if samples is not None:
+					decoded = decoded[:samples - received]
+				received += len(decoded)
+				if len(decoded):
+					yield decoded
+				if stopped:
+					raise SUMPError("the link could not keep up, %d samples received" % received)
+		finally:
+			if not stopped:
+				# any byte ends the stream, then the last block drains
+				self.port.write(bytes(bytearray([SUMP_RESET])))
+				while self.port.read(4096):
+					pass
+
+	def stream_all(self, samples=None, seconds=None, packed=False):
+		"""stream(), in a single array."""
+		chunks = list(self.stream(samples, seconds, packed))
+		if not chunks:
+			return numpy.zeros(0, dtype=numpy.uint8)
+		return numpy.concatenate(chunks)
+
+	def close(self):
+		self.port.close()
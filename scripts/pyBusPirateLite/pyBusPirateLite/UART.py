@@ -79,6 +79,40 @@ class UART(BBIO):
 		self.timeout(0.1)
 		return self.response(1, True)
 		
+	def set_flow_control(self, enabled):
+		"""Turns RTS (on CLK) and CTS (on CS) flow control on or off."""
+		self.port.write("\x08")
+		self.port.write(chr(0x01 if enabled else 0x00))
+		self.timeout(0.1)
+		return self.response(1, True)
+
+	def start_watch(self, patterns, before=0, after=0):
+		"""Only forwards received lines containing any of the given patterns,
+		with up to before/after context lines around them."""
+		self.port.write("\x09")
+		self.port.write(chr(len(patterns)) + chr(before) + chr(after))
+		for pattern in patterns:
+			self.port.write(chr(len(pattern)) + pattern)
+		self.timeout(0.1)
+		return self.response(1, True)
+
+	def read_watch_line(self):
+		"""Returns (patterns bitmask, receive errors, line) for the next line
+		sent by the watch, the line being empty once the watch stopped."""
+		header = self.port.read(4)
+		length = (ord(header[2]) << 8) | ord(header[3])
+		return (ord(header[0]), ord(header[1]), self.port.read(length))
+
+	def stop_watch(self):
+		"""Stops the watch, returns the lines still pending."""
+		self.port.write("\x00")
+		lines = []
+		while True:
+			line = self.read_watch_line()
+			if len(line[2]) == 0:
+				return lines
+			lines.append(line)
+
 	def enter_bridge_mode(self):
 		self.port.write("\x0F")
 		self.timeout(0.1)
@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+libusb transport for the v4 vendor bulk interface.
+
+Firmware built with BP_USB_VENDOR_INTERFACE exposes a vendor specific bulk
+pipe next to the CDC one, carrying the same binary mode traffic without a
+tty in the way.  Pass "usb:" (first board found) or "usb:<serial number>"
+as the port to any mode class to use it.  Needs python-libusb1.
+
+Several IN transfers are kept queued all the time so the host controller
+polls the endpoint every frame, and writes are split over several OUT
+transfers in flight, which is what gets the pipe near full speed USB bulk
+rates.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import time
+
+import usb1
+
+VID = 0x04D8
+PID = 0xFB00
+INTERFACE = 2
+ENDPOINT_OUT = 0x03
+ENDPOINT_IN = 0x83
+
+# Transfers queued in each direction, and the size of each.
+TRANSFERS = 8
+TRANSFER_SIZE = 4096
+
+class USBBulkError(Exception):
+	pass
+
+class USBBulkPort(object):
+	"""The subset of pyserial's Serial the mode classes use."""
+
+	def __init__(self, serial_number="", timeout=1):
+		self.timeout = timeout
+		self.context = usb1.USBContext()
+		self.handle = None
+		for device in self.context.getDeviceIterator(skip_on_error=True):
+			if device.getVendorID() != VID or device.getProductID() != PID:
+				continue
+			if serial_number and device.getSerialNumber() != serial_number:
+				continue
+			self.handle = device.open()
+			break
+		if self.handle is None:
+			raise USBBulkError("no Bus Pirate with a vendor bulk interface found")
+		self.handle.claimInterface(INTERFACE)
+
+		self.received = bytearray()
+		self.failed = None
+		self.in_transfers = []
+		for i in range(TRANSFERS):
+			transfer = self.handle.getTransfer()
+			transfer.setBulk(ENDPOINT_IN, TRANSFER_SIZE, callback=self.in_done)
+			transfer.submit()
+			self.in_transfers.append(transfer)
+		self.out_idle = []
+		for i in range(TRANSFERS):
+			transfer = self.handle.getTransfer()
+			transfer.setBulk(ENDPOINT_OUT, TRANSFER_SIZE, callback=self.out_done)
+			self.out_idle.append(transfer)
+
+	def in_done(self, transfer):
+		status = transfer.getStatus()
+		if status == usb1.TRANSFER_COMPLETED:
+			self.received.extend(transfer.getBuffer()[:transfer.getActualLength()])
+			transfer.submit()
+		elif status != usb1.TRANSFER_CANCELLED:
+			self.failed = "IN transfer failed with status %d" % status
+
+	def out_done(self, transfer):
+		if transfer.getStatus() != usb1.TRANSFER_COMPLETED:
+			self.failed = "OUT transfer failed with status %d" % transfer.getStatus()
+		self.out_idle.append(transfer)
+
+	def handle_events(self, timeout):
+		self.context.handleEventsTimeout(timeout)
+		if self.failed: raise USBBulkError(self.failed)
+
+	def write(self, data):
+		view = memoryview(data)
+		for offset in range(0, len(view), TRANSFER_SIZE):
+			while not self.out_idle:
+				self.handle_events(self.timeout)
+			transfer = self.out_idle.pop()
+			transfer.setBulk(ENDPOINT_OUT, view[offset:offset + TRANSFER_SIZE].tobytes(),
+				callback=self.out_done)
+			transfer.submit()
+		# Like pyserial, return once the data is on its way out.
+		while len(self.out_idle) < TRANSFERS:
+			self.handle_events(self.timeout)
+		return len(view)
+
+	def read(self, size=1):
+		data = bytearray(size)
+		return bytes(data[:self.readinto(memoryview(data))])
+
+	def readinto(self, view):
+		deadline = time.time() + self.timeout
+		while len(self.received) < len(view):
+			left = deadline - time.time()
+			if left <= 0: break
+			self.handle_events(min(left, 0.1))
+		count = min(len(view), len(self.received))
+		view[:count] = self.received[:count]
+		del self.received[:count]
+		return count
+
+	def wait_readable(self, timeout):
+		if not self.received: self.handle_events(timeout)
+		return len(self.received) > 0
+
+	@property
+	def in_waiting(self):
+		self.handle_events(0)
+		return len(self.received)
+
+	inWaiting = lambda self: self.in_waiting
+
+	def reset_input_buffer(self):
+		self.handle_events(0)
+		del self.received[:]
+
+	flushInput = reset_input_buffer
+
+	def close(self):
+		for transfer in self.in_transfers:
+			try: transfer.cancel()
+			except usb1.USBError: pass
+		while any(transfer.isSubmitted() for transfer in self.in_transfers):
+			self.context.handleEventsTimeout(0.1)
+		self.handle.releaseInterface(INTERFACE)
+		self.handle.close()
+		self.context.close()
@@ -0,0 +1,173 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Production self-test runner.
+
+Runs the binary mode self-test report command on many boards at once, one
+thread per serial port, and writes one CSV row per board with the checks
+that failed.  Meant for incoming inspection fixtures where a batch of boards
+is plugged in and tested unattended.
+
+A board passes when every check it performed passed.  Checks needing
+jumpers (+5V to VPU and +3.3V to ADC) are only run with --jumpers.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import csv
+import glob
+import optparse
+import sys
+import threading
+import time
+
+import serial
+
+BBIO_RESET = b"\x00"
+BBIO_IDENTIFIER = b"BBIO1"
+BBIO_EXIT_TO_TERMINAL = b"\x0F"
+BBIO_SELF_TEST_REPORT = b"\x23"
+
+SELF_TEST_REPORT_JUMPERS = 0x01
+
+REPORT_IO_SUCCESS = b"\x01"
+
+# Bit positions of the report masks, see selftest_check_t in selftest.h.
+CHECKS = ["aux0", "mode_led", "pullup_on", "pullup_off", "vreg",
+	"eeprom_scl", "eeprom_sda", "eeprom_wp", "eeprom",
+	"adc_usb", "adc_5v0", "adc_5v0_pullup", "adc_probe", "adc_3v3",
+	"adc_3v3_pullup"]
+for state in ("high", "low", "pulled_up"):
+	CHECKS += ["%s_%s" % (pin, state) for pin in ("mosi", "clk", "miso", "cs")]
+
+FIELDS = ["port", "result", "seconds", "performed", "failed", "failed_checks", "error"]
+
+class SelfTestError(Exception):
+	pass
+
+class BusPirate:
+	def __init__(self, device, speed, timeout):
+		self.port = serial.Serial(device, speed, timeout=timeout)
+
+	def read_exactly(self, count, what):
+		received = self.port.read(count)
+		if len(received) != count:
+			raise SelfTestError("%s: expected %d bytes, got %d" % (what, count, len(received)))
+		return received
+
+	def enter_bbio(self):
+		self.port.reset_input_buffer()
+		for attempt in range(25):
+			self.port.write(BBIO_RESET)
+			time.sleep(0.01)
+			if self.port.in_waiting >= len(BBIO_IDENTIFIER):
+				break
+		data = self.port.read(self.port.in_waiting or len(BBIO_IDENTIFIER))
+		if not data.endswith(BBIO_IDENTIFIER):
+			raise SelfTestError("could not enter binary mode, got %r" % data)
+
+	def self_test_report(self, jumpers):
+		"""(performed, failed) check masks."""
+		options = SELF_TEST_REPORT_JUMPERS if jumpers else 0
+		self.port.write(BBIO_SELF_TEST_REPORT + bytes([options]))
+		status = self.read_exactly(1, "self-test report")
+		if status != REPORT_IO_SUCCESS:
+			raise SelfTestError("self-test report not supported by this firmware")
+		data = self.read_exactly(8, "self-test report")
+		return (int.from_bytes(data[0:4], "big"), int.from_bytes(data[4:8], "big"))
+
+	def exit_to_terminal(self):
+		self.port.write(BBIO_RESET)
+		self.port.write(BBIO_EXIT_TO_TERMINAL)
+		time.sleep(0.1)
+		self.port.reset_input_buffer()
+		self.port.close()
+
+def check_names(mask):
+	return [name for (bit, name) in enumerate(CHECKS) if mask & (1 << bit)]
+
+def test_board(device, options):
+	row = {"port": device, "result": "error", "seconds": "", "performed": "",
+		"failed": "", "failed_checks": "", "error": ""}
+	try:
+		bp = BusPirate(device, options.baud_rate, options.timeout)
+	except serial.SerialException as ex:
+		row["error"] = str(ex)
+		return row
+
+	try:
+		bp.enter_bbio()
+		started = time.perf_counter()
+		(performed, failed) = bp.self_test_report(options.jumpers)
+		row["seconds"] = "%.3f" % (time.perf_counter() - started)
+		row["performed"] = "%08X" % performed
+		row["failed"] = "%08X" % failed
+		row["failed_checks"] = " ".join(check_names(failed))
+		row["result"] = "fail" if failed else "pass"
+	except (SelfTestError, serial.SerialException) as ex:
+		row["error"] = str(ex)
+	finally:
+		try:
+			bp.exit_to_terminal()
+		except serial.SerialException:
+			pass
+	return row
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options] device...", version="%prog 1.0")
+
+	parser.add_option("-g", "--glob",
+						dest="pattern", default="",
+						help="Also test every device matching this pattern, e.g. /dev/ttyUSB*", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-j", "--jumpers",
+						dest="jumpers", default=False, action="store_true",
+						help="Run the checks needing the +5V/VPU and +3.3V/ADC jumpers")
+	parser.add_option("-t", "--timeout",
+						dest="timeout", default=5.0,
+						help="Seconds to wait for a board to answer [default: %default]", type="float")
+	parser.add_option("-o", "--output",
+						dest="output", default="-",
+						help="CSV file to write, - for standard output [default: %default]", type="string")
+
+	(options, args) = parser.parse_args()
+	devices = list(args)
+	if options.pattern:
+		devices += sorted(glob.glob(options.pattern))
+	devices = sorted(set(devices), key=devices.index)
+	if not devices:
+		parser.error("no device given")
+	return (options, devices)
+
+if __name__ == '__main__':
+	(options, devices) = parse_prog_args()
+
+	rows = {}
+	def run(device):
+		rows[device] = test_board(device, options)
+
+	threads = [threading.Thread(target=run, args=(device,)) for device in devices]
+	for thread in threads:
+		thread.start()
+	for thread in threads:
+		thread.join()
+
+	output = sys.stdout if options.output == "-" else open(options.output, "w", newline="")
+	writer = csv.DictWriter(output, fieldnames=FIELDS)
+	writer.writeheader()
+	for device in devices:
+		writer.writerow(rows[device])
+	if output is not sys.stdout:
+		output.close()
+
+	passed = sum(1 for row in rows.values() if row["result"] == "pass")
+	print("%d of %d boards passed" % (passed, len(devices)), file=sys.stderr)
+	sys.exit(0 if passed == len(devices) else 1)
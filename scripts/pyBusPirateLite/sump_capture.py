@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Logic analyser capture to VCD or numpy.
+
+Runs a buffered or streaming SUMP capture through pyBusPirateLite.SUMP and
+writes it as a Value Change Dump, or as a .npy array of one byte per sample
+when the output file name ends in .npy.  A buffered capture holds as many
+samples as the sample memory and can run up to the maximum sample rate;
+streaming (-s) lasts as long as asked for, at a rate the serial link keeps up
+with.  A bitstream capture (-B) only samples MISO, but holds eight times as
+many samples and runs up to 8MHz.  Ctrl-C stops a buffered capture early,
+keeping what was sampled.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import optparse
+import sys
+
+import numpy
+import serial
+
+from pyBusPirateLite.SUMP import SUMP, SUMPError, PROBES, write_vcd
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options]", version="%prog 1.0")
+
+	parser.add_option("-d", "--device",
+						dest="device", default="/dev/ttyUSB0",
+						help="Serial port the Bus Pirate is on [default: %default]", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-H", "--hardware",
+						dest="hardware", default="v4", choices=sorted(PROBES.keys()),
+						help="Board version, sets the probe names [default: %default]")
+	parser.add_option("-r", "--rate",
+						dest="rate", default=1000000,
+						help="Samples per second [default: %default]", type="int")
+	parser.add_option("-n", "--samples",
+						dest="samples", default=4096,
+						help="Samples to capture [default: %default]", type="int")
+	parser.add_option("-a", "--after",
+						dest="after", default=None,
+						help="Samples after the trigger [default: all of them]", type="int")
+	parser.add_option("-m", "--trigger-mask",
+						dest="mask", default=0,
+						help="Probes the trigger looks at, as a bit mask [default: none]", type="int")
+	parser.add_option("-v", "--trigger-values",
+						dest="values", default=0,
+						help="Levels the trigger waits for on those probes [default: %default]", type="int")
+	parser.add_option("-R", "--rle",
+						dest="rle", default=False, action="store_true",
+						help="Run length encode the capture")
+	parser.add_option("-s", "--stream",
+						dest="seconds", default=None,
+						help="Stream for this many seconds instead", type="float")
+	parser.add_option("-P", "--packed",
+						dest="packed", default=False, action="store_true",
+						help="Stream the four lowest probes only, two samples per byte")
+	parser.add_option("-B", "--bitstream",
+						dest="bitstream", default=False, action="store_true",
+						help="Shift in MISO only, -n then counts bytes of eight samples")
+	parser.add_option("-o", "--output",
+						dest="output", default="-",
+						help="VCD or .npy file to write, - for standard output [default: %default]", type="string")
+
+	(options, args) = parser.parse_args()
+	if args:
+		parser.error("unexpected arguments")
+	return options
+
+if __name__ == '__main__':
+	options = parse_prog_args()
+
+	try:
+		sump = SUMP(options.device, options.baud_rate)
+		rate = sump.set_rate(options.rate)
+		sump.set_samples(options.samples, options.after)
+		sump.set_rle(options.rle)
+		if options.mask:
+			sump.set_trigger(options.mask, options.values)
+		if options.bitstream:
+			print("Capturing MISO, waiting for the trigger...", file=sys.stderr)
+			(samples, rate) = sump.capture_bitstream()
+		elif options.seconds is not None:
+			print("Streaming at %.0f samples/s..." % rate, file=sys.stderr)
+			samples = sump.stream_all(seconds=options.seconds, packed=options.packed)
+		else:
+			print("Capturing at %.0f samples/s, waiting for the trigger..." % rate, file=sys.stderr)
+			samples = sump.capture(partial=True)
+		sump.close()
+	except (SUMPError, serial.SerialException) as ex:
+		print("Error: %s" % ex, file=sys.stderr)
+		sys.exit(1)
+	except KeyboardInterrupt:
+		sys.exit(1)
+
+	print("%d samples, %.6f s" % (len(samples), len(samples) / rate), file=sys.stderr)
+	if options.output.endswith(".npy"):
+		numpy.save(options.output, samples)
+		sys.exit(0)
+	output = sys.stdout if options.output == "-" else open(options.output, "w")
+	write_vcd(output, samples, rate, PROBES[options.hardware])
+	if output is not sys.stdout:
+		output.close()
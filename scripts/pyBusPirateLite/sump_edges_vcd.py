@@ -0,0 +1,167 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Edge timestamp capture to VCD.
+
+Runs the SUMP edge timestamp capture (SUMP_RUN_EDGES, a Bus Pirate
+extension) and writes the probes waveform as a Value Change Dump, which
+GTKWave, PulseView and most simulators can open.  Every edge is timestamped
+by the input capture units at instruction clock resolution (62.5ns), so
+sparse signals can be captured for up to about 16 seconds no matter how
+short their pulses are.
+
+The capture ends when the sample memory is full, when the timestamps would
+wrap around, or when Ctrl-C is pressed.  Bursts of edges too fast for the
+firmware to keep up with are counted, and the line level is picked up again
+from where capturing resumed.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import optparse
+import sys
+import time
+
+import serial
+
+SUMP_RESET = b"\x00"
+SUMP_ID = b"\x02"
+SUMP_RUN_EDGES = b"\x0C"
+SUMP_DEVICE_ID = b"1ALS"
+
+HEADER_SIZE = 8
+RECORD_SIZE = 4
+CHANNEL_SHIFT = 29
+LOST = 0x10000000
+TIMESTAMP_MASK = 0x0FFFFFFF
+
+FCY = 16000000
+
+# One instruction cycle is 62.5ns, VCD only takes powers of ten as units.
+PICOSECONDS_PER_CYCLE = 1000000000000 // FCY
+
+END_REASONS = ["sample memory full", "maximum capture length reached", "stopped"]
+
+# Probe order as in SUMP samples, see SUMP_PROBES_RPIN in sump.c.
+PROBES = {
+	"v3": ["CS", "MISO", "CLK", "MOSI", "AUX"],
+	"v4": ["MOSI", "CLK", "MISO", "CS", "AUX", "AUX1", "AUX2"],
+}
+
+class CaptureError(Exception):
+	pass
+
+def read_exactly(port, count, what):
+	received = port.read(count)
+	if len(received) != count:
+		raise CaptureError("%s: expected %d bytes, got %d" % (what, count, len(received)))
+	return received
+
+def enter_sump(port):
+	port.reset_input_buffer()
+	port.write(SUMP_RESET * 5 + SUMP_ID)
+	time.sleep(0.1)
+	data = port.read(port.in_waiting or len(SUMP_DEVICE_ID))
+	if not data.endswith(SUMP_DEVICE_ID):
+		raise CaptureError("could not enter SUMP mode, got %r" % data)
+
+def capture(port):
+	"""(initial levels, end reason, length in cycles, records)."""
+	port.write(SUMP_RUN_EDGES)
+	port.timeout = None
+	try:
+		header = read_exactly(port, HEADER_SIZE, "capture header")
+	except KeyboardInterrupt:
+		port.write(SUMP_RESET)
+		header = read_exactly(port, HEADER_SIZE, "capture header")
+	count = (header[0] << 8) | header[1]
+	data = read_exactly(port, count * RECORD_SIZE, "edge records")
+	records = [int.from_bytes(data[i:i + RECORD_SIZE], "big")
+		for i in range(0, len(data), RECORD_SIZE)]
+	return (header[2], header[3], int.from_bytes(header[4:8], "big"), records)
+
+def write_vcd(output, names, initial, length, records):
+	identifiers = [chr(ord("!") + probe) for probe in range(len(names))]
+	levels = [(initial >> probe) & 1 for probe in range(len(names))]
+
+	output.write("$date %s $end\n" % time.strftime("%Y-%m-%d %H:%M:%S"))
+	output.write("$version Bus Pirate SUMP edge capture $end\n")
+	output.write("$timescale 1ps $end\n")
+	output.write("$scope module bus_pirate $end\n")
+	for (identifier, name) in zip(identifiers, names):
+		output.write("$var wire 1 %s %s $end\n" % (identifier, name))
+	output.write("$upscope $end\n$enddefinitions $end\n")
+
+	output.write("#0\n$dumpvars\n")
+	for (identifier, level) in zip(identifiers, levels):
+		output.write("%d%s\n" % (level, identifier))
+	output.write("$end\n")
+
+	# Records come per probe in bursts, put them back in time order.
+	events = sorted((record & TIMESTAMP_MASK, index, record >> CHANNEL_SHIFT, record)
+		for (index, record) in enumerate(records))
+	last = None
+	for (timestamp, index, probe, record) in events:
+		if probe >= len(names):
+			continue
+		if timestamp != last:
+			output.write("#%d\n" % (timestamp * PICOSECONDS_PER_CYCLE))
+			last = timestamp
+		if record & LOST:
+			# Edges were missed, the record holds the level the line had then.
+			levels[probe] = record & 1
+		else:
+			levels[probe] ^= 1
+		output.write("%d%s\n" % (levels[probe], identifiers[probe]))
+	output.write("#%d\n" % (length * PICOSECONDS_PER_CYCLE))
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options]", version="%prog 1.0")
+
+	parser.add_option("-d", "--device",
+						dest="device", default="/dev/ttyUSB0",
+						help="Serial port the Bus Pirate is on [default: %default]", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-H", "--hardware",
+						dest="hardware", default="v4", choices=sorted(PROBES.keys()),
+						help="Board version, sets the probe names [default: %default]")
+	parser.add_option("-o", "--output",
+						dest="output", default="-",
+						help="VCD file to write, - for standard output [default: %default]", type="string")
+
+	(options, args) = parser.parse_args()
+	if args:
+		parser.error("unexpected arguments")
+	return options
+
+if __name__ == '__main__':
+	options = parse_prog_args()
+
+	try:
+		port = serial.Serial(options.device, options.baud_rate, timeout=1)
+		enter_sump(port)
+		print("Capturing, press Ctrl-C to stop...", file=sys.stderr)
+		(initial, reason, length, records) = capture(port)
+		port.close()
+	except (CaptureError, serial.SerialException) as ex:
+		print("Error: %s" % ex, file=sys.stderr)
+		sys.exit(1)
+
+	lost = sum(1 for record in records if record & LOST)
+	print("%d edges in %.6f s, %s" % (len(records) - lost, float(length) / FCY,
+		END_REASONS[reason] if reason < len(END_REASONS) else "unknown end"), file=sys.stderr)
+	if lost:
+		print("%d bursts of edges were too fast to capture" % lost, file=sys.stderr)
+
+	output = sys.stdout if options.output == "-" else open(options.output, "w")
+	write_vcd(output, PROBES[options.hardware], initial, length, records)
+	if output is not sys.stdout:
+		output.close()
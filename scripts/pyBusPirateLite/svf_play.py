@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# encoding: utf-8
+"""
+Plays an SVF file through the binary JTAG mode.
+
+The file is compiled into scan queues by pyBusPirateLite.JTAG and streamed
+to the Bus Pirate as is, with no conversion to XSVF beforehand.  Any TDO
+mismatch stops the run and reports the SVF line it came from.  The binary
+JTAG mode is only there on v4 and has no way out, reset the board once done.
+
+Written and maintained by the Bus Pirate project.
+
+To the extent possible under law, the project has waived all copyright and
+related or neighboring rights to Bus Pirate.  This work is published from
+United States.
+
+For details see: http://creativecommons.org/publicdomain/zero/1.0/.
+"""
+
+import optparse
+import sys
+import time
+
+import serial
+
+from pyBusPirateLite.JTAG import JTAG, SVFError, compile_svf
+
+def parse_prog_args():
+	parser = optparse.OptionParser(usage="%prog [options] file.svf", version="%prog 1.0")
+
+	parser.add_option("-d", "--device",
+						dest="device", default="/dev/ttyUSB0",
+						help="Serial port the Bus Pirate is on [default: %default]", type="string")
+	parser.add_option("-b", "--baud",
+						dest="baud_rate", default=115200,
+						help="Serial port speed [default: %default]", type="int")
+	parser.add_option("-p", "--pipeline",
+						dest="depth", default=2,
+						help="Queues sent ahead of the device [default: %default]", type="int")
+	parser.add_option("-c", "--check",
+						dest="check", default=False, action="store_true",
+						help="Only compile the file and print the queue statistics")
+
+	(options, args) = parser.parse_args()
+	if len(args) != 1:
+		parser.error("one SVF file expected")
+	if options.depth < 1:
+		parser.error("the pipeline must be at least one queue deep")
+	return (options, args[0])
+
+def progress(done, total):
+	sys.stderr.write("\r%d/%d queues" % (done, total))
+	sys.stderr.flush()
+
+if __name__ == '__main__':
+	(options, filename) = parse_prog_args()
+
+	try:
+		with open(filename) as svf:
+			text = svf.read()
+		jtag = None
+		if not options.check:
+			jtag = JTAG(options.device, options.baud_rate)
+			jtag.enter()
+			queues = compile_svf(text, jtag.queue_size)
+		else:
+			queues = compile_svf(text)
+		size = sum(len(queue.operations) for queue in queues)
+		print("%d queues, %d bytes" % (len(queues), size), file=sys.stderr)
+		if jtag:
+			start = time.time()
+			jtag.play(queues, options.depth, progress)
+			print("\nDone in %.2f s" % (time.time() - start), file=sys.stderr)
+			jtag.close()
+	except (SVFError, IOError, serial.SerialException) as ex:
+		print("\nError: %s" % ex, file=sys.stderr)
+		sys.exit(1)
+	except KeyboardInterrupt:
+		sys.exit(1)
@@ -41,6 +41,81 @@ def get_messages(handle):
     return read_lines
 
 
+# Bytes from this value up are dictionary codes, below it plain characters.
+FIRST_DICTIONARY_CODE = 0x80
+DICTIONARY_SIZE = 0x100 - FIRST_DICTIONARY_CODE
+
+# Longest expansion chain allowed, this sizes the decoder stack.
+MAXIMUM_DICTIONARY_DEPTH = 8
+
+# Each dictionary entry takes a whole 24-bits program word, so a pair must
+# show up at least this many times (saving a byte each time) to pay off.
+MINIMUM_PAIR_OCCURRENCES = 4
+
+
+def compress_messages(messages):
+    """Byte pair encodes the messages against a shared dictionary.
+
+    Returns the encoded messages, the dictionary as a list of symbol pairs,
+    and the deepest nesting level used by any dictionary entry.
+    """
+
+    encoded = [list(message.encode('ascii')) for message in messages]
+    depths = [0] * FIRST_DICTIONARY_CODE
+    dictionary = []
+
+    while len(dictionary) < DICTIONARY_SIZE:
+        counts = {}
+        for symbols in encoded:
+            for pair in zip(symbols, symbols[1:]):
+                counts[pair] = counts.get(pair, 0) + 1
+
+        candidates = sorted(((-count, pair) for pair, count in counts.items()
+                             if max(depths[pair[0]], depths[pair[1]]) <
+                             MAXIMUM_DICTIONARY_DEPTH))
+        if not candidates or -candidates[0][0] < MINIMUM_PAIR_OCCURRENCES:
+            break
+
+        first, second = candidates[0][1]
+        code = FIRST_DICTIONARY_CODE + len(dictionary)
+        dictionary.append((first, second))
+        depths.append(max(depths[first], depths[second]) + 1)
+
+        for index, symbols in enumerate(encoded):
+            replaced = []
+            position = 0
+            while position < len(symbols):
+                if (position + 1 < len(symbols) and
+                        symbols[position] == first and
+                        symbols[position + 1] == second):
+                    replaced.append(code)
+                    position += 2
+                else:
+                    replaced.append(symbols[position])
+                    position += 1
+            encoded[index] = replaced
+
+    return encoded, dictionary, max(depths)
+
+
+def expand_symbol(symbol, dictionary):
+    if symbol < FIRST_DICTIONARY_CODE:
+        return chr(symbol)
+    first, second = dictionary[symbol - FIRST_DICTIONARY_CODE]
+    return expand_symbol(first, dictionary) + expand_symbol(second, dictionary)
+
+
+def escape_string(data):
+    return data.replace('\\', '\\\\').replace('\n', '\\n').replace(
+        '\r', '\\r').replace('"', '\\"').replace('\t', '\\t')
+
+
+def escape_symbols(symbols):
+    return ''.join(escape_string(chr(symbol))
+                   if symbol < FIRST_DICTIONARY_CODE else '\\%03o' % symbol
+                   for symbol in symbols)
+
+
 parser = argparse.ArgumentParser(
     description='Pack Bus Pirate strings into something that can be '
                 'included by the firmware.')
@@ -51,20 +126,92 @@ parser.add_argument('outbase', metavar='OUTPUT', type=str,
 parser.add_argument('guard', metavar='GUARD', type=str,
                     help='an additional marker to put in the C header '
                          '#include guard block')
+parser.add_argument('--plain', action='store_true',
+                    help='store the strings as they are, without the '
+                         'dictionary compression')
+parser.add_argument('--host', action='store_true',
+                    help='also write the strings as C arrays laid out like '
+                         'program memory, for the host build')
 
 args = parser.parse_args()
-lines = get_messages(args.source)
+lines = sorted(get_messages(args.source))
+
+if args.plain:
+    encoded = None
+else:
+    encoded, dictionary, depth = compress_messages([row[2] for row in lines])
+    for symbols, row in zip(encoded, lines):
+        if ''.join(expand_symbol(symbol, dictionary)
+                   for symbol in symbols) != row[2]:
+            raise Exception('%s does not decompress back' % row[0])
 
 with open(args.outbase + '.s', 'w') as assembly_output:
-    for row in sorted(lines):
+    for index, row in enumerate(lines):
         assembly_output.write('\t; %s\n' % row[0])
         assembly_output.write('\t.section .text.%s, code\n' % row[0])
         assembly_output.write('\t.global _%s_str\n' % row[0])
         assembly_output.write('_%s_str:\n' % row[0])
-        data = row[2].replace('\\', '\\\\').replace('\n', '\\n').replace(
-            '\r', '\\r').replace('"', '\\"').replace('\t', '\\t')
+        if encoded is None:
+            data = escape_string(row[2])
+        else:
+            data = escape_symbols(encoded[index])
         assembly_output.write('\t.pasciz "%s"\n\n' % data)
 
+    if encoded is not None:
+        assembly_output.write('\t; Dictionary, one symbol pair per word\n')
+        assembly_output.write('\t.section .text.bp_message_dictionary, '
+                              'code\n')
+        assembly_output.write('\t.global _bp_message_dictionary\n')
+        assembly_output.write('_bp_message_dictionary:\n')
+        for code, (first, second) in enumerate(dictionary):
+            assembly_output.write(
+                '\t.pword 0x%02X%02X\t; 0x%02X "%s"\n' %
+                (second, first, code + FIRST_DICTIONARY_CODE,
+                 escape_string(expand_symbol(code + FIRST_DICTIONARY_CODE,
+                                             dictionary))))
+        assembly_output.write('\n')
+
+
+def host_words(data):
+    """Lays bytes out the way the host build reads program memory.
+
+    Each 24-bits program word takes four bytes, the last one being the phantom
+    byte that always reads as zero, just like .pasciz and .pword fill them.
+    """
+
+    data = list(data)
+    data += [0] * (-len(data) % 3)
+    return [byte for index in range(0, len(data), 3)
+            for byte in data[index:index + 3] + [0]]
+
+
+def host_array(name, data):
+    return 'const uint8_t %s[] __attribute__((aligned(4))) = {\n%s};\n\n' % (
+        name, ''.join('    %s,\n' % ', '.join('0x%02X' % byte
+                                              for byte in data[index:index + 8])
+                      for index in range(0, len(data), 8)))
+
+
+if args.host:
+    with open(args.outbase + '_host.c', 'w') as host_output:
+        host_output.write('/* Generated by packstrings.py, do not edit. */\n\n')
+        host_output.write('#include <stdint.h>\n\n')
+        for index, row in enumerate(lines):
+            if encoded is None:
+                data = list(row[2].encode('ascii'))
+            else:
+                data = encoded[index]
+            host_output.write('/* %s */\n' % escape_string(row[2]).replace(
+                '*/', '* /'))
+            host_output.write(host_array('%s_str' % row[0],
+                                         host_words(data + [0])))
+
+        if encoded is not None:
+            host_output.write(host_array(
+                'bp_message_dictionary',
+                host_words([byte for first, second in dictionary
+                            for byte in (first, second, 0)])))
+
 offset = 0
 BUFFER_WRITE_CALL = 'bp_message_write_buffer'
 LINE_WRITE_CALL = 'bp_message_write_line'
@@ -73,7 +220,12 @@ with open(args.outbase + '.h', 'w') as header_output:
     header_output.write('#ifndef BP_MESSAGES_%s_H\n' % args.guard.upper())
     header_output.write('#define BP_MESSAGES_%s_H\n\n' % args.guard.upper())
 
-    for row in sorted(lines):
+    if encoded is not None:
+        header_output.write('#define BP_MESSAGES_COMPRESSED\n')
+        header_output.write('#define BP_MESSAGE_DICTIONARY_DEPTH %d\n' % depth)
+        header_output.write('void bp_message_dictionary(void);\n\n')
+
+    for row in lines:
         call = BUFFER_WRITE_CALL if row[1] == '0' else LINE_WRITE_CALL
         header_output.write('void %s_str(void);\n' % row[0])
         header_output.write('#define %s %s(__builtin_tbladdress(%s_str))\n' %
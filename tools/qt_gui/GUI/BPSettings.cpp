@@ -4,6 +4,7 @@
 #include "BPSettings.h"
 #include "Events.h"
 #include "BinMode.h"
+#include "PortDiscovery.h"
 
 BPSettingsGui::BPSettingsGui(MainWidgetFrame *parent) : QWidget(parent)
 {
@@ -44,6 +45,13 @@ BPSettingsGui::BPSettingsGui(MainWidgetFrame *parent) : QWidget(parent)
 	s_port = new QLineEdit(parent->cfg->serial_port_name);
 	s_port->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 
+	QLabel *s_found_label = new QLabel("Bus Pirates Found: ");
+	s_found = new QComboBox;
+	s_found->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	s_find = new QPushButton("Find Bus Pirates");
+	s_find->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	discovery = new PortDiscovery(parent->cfg, this);
+
 	s_baud = new QComboBox;
 	s_baud->addItems(baud_list);
 	s_baud->setCurrentIndex(s_baud->findText(usable_baud_rate->key(parent->cfg->baud_rate)));
@@ -73,9 +81,15 @@ BPSettingsGui::BPSettingsGui(MainWidgetFrame *parent) : QWidget(parent)
 
 	connect(open, SIGNAL(clicked()), this, SLOT(openPort()));
 	connect(close, SIGNAL(clicked()), this, SLOT(closePort()));
+	connect(s_find, SIGNAL(clicked()), this, SLOT(findPorts()));
+	connect(s_found, SIGNAL(activated(const QString &)), this, SLOT(foundPortChosen(const QString &)));
+	connect(discovery, SIGNAL(finished(QStringList)), this, SLOT(portsFound(QStringList)));
 
 	vlayout->addWidget(s_port_label);
 	vlayout->addWidget(s_port);
+	vlayout->addWidget(s_found_label);
+	vlayout->addWidget(s_found);
+	vlayout->addWidget(s_find);
 	vlayout->addWidget(s_baud_label);
 	vlayout->addWidget(s_baud);
 	vlayout->addWidget(s_databits_label);
@@ -141,6 +155,44 @@ BPSettingsGui::BPSettingsGui(MainWidgetFrame *parent) : QWidget(parent)
 	m_layout->addLayout(vlayout2);
 	setLayout(m_layout);
 	//setupBusPirate();
+
+	/* Known devices come from the cache, so this costs nothing unless
+	   a new adapter was plugged in. */
+	discovery->start(true);
+}
+
+void BPSettingsGui::findPorts()
+{
+	/* Ask every board again, the cache may be stale. */
+	if (parent->bp->is_open() || discovery->is_running())
+		return;
+	s_find->setEnabled(false);
+	discovery->start(false);
+}
+
+void BPSettingsGui::portsFound(QStringList bus_pirates)
+{
+	QString qmsg = QString("Found %1 Bus Pirate(s)").arg(bus_pirates.size());
+
+	s_find->setEnabled(true);
+	s_found->clear();
+	s_found->addItems(bus_pirates);
+	s_found->setCurrentIndex(s_found->findText(s_port->text()));
+	/* Only a port that is gone is replaced, one typed in by hand may be
+	   an adapter the discovery does not know. */
+	if (!bus_pirates.isEmpty() && !bus_pirates.contains(s_port->text()) &&
+	    !discovery->present_ports().contains(s_port->text()) &&
+	    !QFileInfo(s_port->text()).exists())
+	{
+		s_port->setText(bus_pirates.first());
+		s_found->setCurrentIndex(0);
+	}
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg));
+}
+
+void BPSettingsGui::foundPortChosen(const QString &name)
+{
+	s_port->setText(name);
 }
 
 
@@ -194,9 +246,7 @@ void BPSettingsGui::resetBBIO()
 
 void BPSettingsGui::getBuffer()
 {
-	parent->bp->serial->flush();
 	parent->bp->dumpBuffer();
-	parent->bp->serial->flush();
 }
 
 BPSettingsGui::~BPSettingsGui()
@@ -219,12 +269,7 @@ void BPSettingsGui::SaveSettings()
 void BPSettingsGui::setConfigSettings()
 {
 	qDebug() << "set Port Settings";
-	parent->bp->serial->setPortName(s_port->text());
-	parent->bp->serial->setBaudRate((BaudRateType)usable_baud_rate->value(s_baud->currentText(), BAUD115200)); //BAUD115200
-	parent->bp->serial->setDataBits((DataBitsType)s_databits->currentIndex());  //DATA_8
-	parent->bp->serial->setStopBits((StopBitsType)s_stopbits->currentIndex());  //STOP_1
-	parent->bp->serial->setParity((ParityType)s_parity->currentIndex());      //PAR_NONE
-	parent->bp->serial->setFlowControl((FlowType)s_flow->currentIndex());      //FLOW_OFF
+	parent->bp->port_configure();
 }
 
 void BPSettingsGui::openPort()
@@ -5,6 +5,7 @@
 
 class BinMode;
 class MainWidgetFrame;
+class PortDiscovery;
 
 class BPSettings : public QSettings
 {
@@ -69,6 +70,9 @@ public:
 	~BPSettingsGui();
 	void CreateBaudMap(void);
 	QLineEdit *s_port;
+	QComboBox *s_found;
+	QPushButton *s_find;
+	PortDiscovery *discovery;
 	QComboBox *s_baud;
 	QComboBox *s_databits;
 	QComboBox *s_stopbits;
@@ -92,6 +96,9 @@ private slots:
 	void resetBBIO();
 	void setupBusPirate();
 	void getBuffer();
+	void findPorts();
+	void portsFound(QStringList bus_pirates);
+	void foundPortChosen(const QString &name);
 };
 
 #endif
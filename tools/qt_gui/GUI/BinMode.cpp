@@ -1,3 +1,4 @@
+
 #include <QtWidgets>
 #include "qextserialport/qextserialport.h"
 #include "Events.h"
@@ -8,61 +9,158 @@
 BinMode::BinMode(MainWidgetFrame *parent) : QWidget(parent)
 {
 	this->parent = parent;
-	serial = new QextSerialPort("/dev/bus_pirate", QextSerialPort::Polling);
+	next_id = 0;
+	protocol = PROTOCOL_BBIO;
+	worker = new BinModeWorker;
+	worker->moveToThread(&worker_thread);
+	connect(&worker_thread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+	connect(worker, SIGNAL(replied(quint32, QByteArray, bool)), this, SLOT(replied(quint32, QByteArray, bool)));
+	worker_thread.start();
 }
 
 BinMode::~BinMode()
 {
 	port_close();
+	worker_thread.quit();
+	worker_thread.wait();
 }
 
 QByteArray BinMode::dumpBuffer()
 {
 	QByteArray resp;
 	qDebug() << "Dump Buffers";
-	do {
-		serial->flush();
-		resp = serial->readAll();
-		serial->flush();
-		qDebug() << resp.data();
-	} while (!resp.isEmpty());
+	resp = transact(QByteArray(), REPLY_UNTIL_IDLE);
+	qDebug() << resp.data();
 	return resp;
 }
 
 /* Port Manipulation */
 bool BinMode::port_open()
 {
+	bool ret = false;
 	qDebug() << "port_open" << parent->settings->s_port->text();
-	serial->setPortName(parent->settings->s_port->text());
-	serial->setBaudRate((BaudRateType)parent->settings->usable_baud_rate->value(parent->settings->s_baud->currentText(), BAUD115200)); //BAUD115200
-	serial->setDataBits((DataBitsType)parent->settings->s_databits->currentIndex());  //DATA_8
-	serial->setStopBits((StopBitsType)parent->settings->s_stopbits->currentIndex());  //STOP_1
-	serial->setParity((ParityType)parent->settings->s_parity->currentIndex());      //PAR_NONE
-	serial->setFlowControl((FlowType)parent->settings->s_flow->currentIndex());      //FLOW_OFF
-	serial->setTimeout(100);
-	bool ret = serial->open(QIODevice::ReadWrite);
-	serial->flush();
-	qDebug() << "Serial Port Closed:" << serial->portName() << "is open-" << serial->isOpen();
+	QMetaObject::invokeMethod(worker, "port_open", Qt::BlockingQueuedConnection,
+		Q_RETURN_ARG(bool, ret),
+		Q_ARG(QString, parent->settings->s_port->text()),
+		Q_ARG(int, parent->settings->usable_baud_rate->value(parent->settings->s_baud->currentText(), BAUD115200)), //BAUD115200
+		Q_ARG(int, parent->settings->s_databits->currentIndex()),  //DATA_8
+		Q_ARG(int, parent->settings->s_stopbits->currentIndex()),  //STOP_1
+		Q_ARG(int, parent->settings->s_parity->currentIndex()),    //PAR_NONE
+		Q_ARG(int, parent->settings->s_flow->currentIndex()));     //FLOW_OFF
 	return ret;
 }
 
+void BinMode::port_configure()
+{
+	QMetaObject::invokeMethod(worker, "port_configure", Qt::BlockingQueuedConnection,
+		Q_ARG(QString, parent->settings->s_port->text()),
+		Q_ARG(int, parent->settings->usable_baud_rate->value(parent->settings->s_baud->currentText(), BAUD115200)),
+		Q_ARG(int, parent->settings->s_databits->currentIndex()),
+		Q_ARG(int, parent->settings->s_stopbits->currentIndex()),
+		Q_ARG(int, parent->settings->s_parity->currentIndex()),
+		Q_ARG(int, parent->settings->s_flow->currentIndex()));
+}
+
 void BinMode::port_close()
 {
-	serial->flush();
-	serial->close();
-	qDebug() << "Serial Port Closed:" << serial->portName() << "is open-" << serial->isOpen();
+	QMetaObject::invokeMethod(worker, "port_close", Qt::BlockingQueuedConnection);
+}
+
+bool BinMode::is_open()
+{
+	bool ret = false;
+	QMetaObject::invokeMethod(worker, "is_open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, ret));
+	return ret;
+}
+
+/* Request Queue */
+quint32 BinMode::submit(const QByteArray &data, int reply_length, int timeout)
+{
+	quint32 id = next_id++;
+	QMetaObject::invokeMethod(worker, "submit", Qt::QueuedConnection,
+		Q_ARG(quint32, id), Q_ARG(QByteArray, data),
+		Q_ARG(int, reply_length), Q_ARG(int, timeout));
+	return id;
+}
+
+void BinMode::replied(quint32 id, QByteArray reply, bool complete)
+{
+	if (awaited.remove(id))
+		finished.insert(id, qMakePair(reply, complete));
+	emit reply_ready(id, reply, complete);
+}
+
+QByteArray BinMode::wait(quint32 id)
+{
+	QEventLoop loop;
+	connect(this, SIGNAL(reply_ready(quint32, QByteArray, bool)), &loop, SLOT(quit()));
+	while (!finished.contains(id))
+		loop.exec();
+	return finished.take(id).first;
+}
+
+QByteArray BinMode::transact(const QByteArray &data, int reply_length, int timeout)
+{
+	quint32 id = next_id;
+	awaited.insert(id);
+	submit(data, reply_length, timeout);
+	return wait(id);
+}
+
+QList<QByteArray> BinMode::transact_all(const QList<QByteArray> &requests, int reply_length, int timeout)
+{
+	QList<quint32> ids;
+	QList<QByteArray> replies;
+	int i;
+
+	/* Queue everything first so the worker keeps the link busy. */
+	for (i = 0; i < requests.size(); i++) {
+		awaited.insert(next_id);
+		ids.append(submit(requests.at(i), reply_length, timeout));
+	}
+	for (i = 0; i < ids.size(); i++)
+		replies.append(wait(ids.at(i)));
+	return replies;
+}
+
+QByteArray BinMode::exchange(const QByteArray &data, int timeout)
+{
+	return collect(post(data, timeout));
+}
+
+quint32 BinMode::post(const QByteArray &data, int timeout)
+{
+	int reply_length = BinModeFrame::reply_length(protocol, data);
+
+	/* Track the mode as the firmware will see it once this is sent, so
+	   requests queued behind it are framed for the right command set. */
+	awaited.insert(next_id);
+	protocol = BinModeFrame::next_protocol(protocol, data);
+	return submit(data, reply_length, timeout);
+}
+
+QByteArray BinMode::collect(quint32 id)
+{
+	return wait(id);
+}
+
+QList<QByteArray> BinMode::exchange_all(const QList<QByteArray> &requests, int timeout)
+{
+	QList<quint32> ids;
+	QList<QByteArray> replies;
+	int i;
+
+	for (i = 0; i < requests.size(); i++)
+		ids.append(post(requests.at(i), timeout));
+	for (i = 0; i < ids.size(); i++)
+		replies.append(collect(ids.at(i)));
+	return replies;
 }
 
 QByteArray BinMode::command(unsigned short command)
 {
 	char data = (command);
-	QByteArray res;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
-	return res;
+	return transact(QByteArray(&data, 1), REPLY_UNTIL_IDLE);
 }
 
 /* BBIO */
@@ -71,12 +169,9 @@ int BinMode::enter_mode_bbio(void)
 	int ret=0;
 	QByteArray res;
 	if (reset_bbio()) return ret;
-	serial->flush();
-	serial->write("\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 20);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = transact(QByteArray(20, '\x00'), REPLY_UNTIL_IDLE);
 	if (res.contains("BBIO")) ret = 1;
+	protocol = PROTOCOL_BBIO;
 	if (ret) qDebug() << "BBIO Ready!";
 	return ret;
 }
@@ -86,11 +181,7 @@ int BinMode::reset_bbio(void)
 	QByteArray version_string;
 	int ret = 0;
 
-	serial->flush();
-	serial->write("\x00", 1);
-	serial->flush();
-	version_string = serial->readAll();
-	serial->flush();
+	version_string = exchange(QByteArray(1, '\x00'));
 	if (version_string.contains("BBIO")) ret = 1;
 	qDebug() << "BBIO - text:" << version_string;
 	return ret;
@@ -98,14 +189,10 @@ int BinMode::reset_bbio(void)
 
 QByteArray BinMode::reset_hardware(void)
 {
-	QByteArray buspirate_info, resp;
-	serial->flush();
-	serial->write("\x0F", 1);
-	serial->flush();
-	serial->read(1);
-	serial->flush();
-	buspirate_info = serial->readAll();
-	serial->flush();
+	QByteArray buspirate_info;
+	buspirate_info = transact(QByteArray(1, '\x0F'), REPLY_UNTIL_IDLE);
+	/* Drop the command acknowledgement in front of the version banner. */
+	buspirate_info.remove(0, 1);
 	qDebug() << "reset BP:" << buspirate_info;
 	return buspirate_info;
 }
@@ -113,11 +200,7 @@ QByteArray BinMode::reset_hardware(void)
 QByteArray BinMode::reset_user_terminal(void)
 {
 	QByteArray resp;
-	serial->flush();
-	serial->write("\n\n\n\n\n\n\n\n\n\n#\n", 12);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
+	resp = transact(QByteArray("\n\n\n\n\n\n\n\n\n\n#\n", 12), REPLY_UNTIL_IDLE);
 	qDebug() << "reset user term:" << resp;
 	return resp;
 }
@@ -127,11 +210,7 @@ int BinMode::enter_mode_spi(void)
 {
 	QByteArray version_string;
 	int ret = 0;
-	serial->flush();
-	serial->write("\x01", 1);
-	serial->flush();
-	version_string = serial->readAll();
-	serial->flush();
+	version_string = exchange(QByteArray(1, '\x01'));
 	if (version_string.contains("SPI")) ret = 1;
 	qDebug() << "SPI - text: " << version_string;
 	return ret;
@@ -141,11 +220,7 @@ int BinMode::enter_mode_i2c(void)
 {
 	int ret = 0;
 	QByteArray version_string;
-	serial->flush();
-	serial->write("\x02", 1);
-	serial->flush();
-	version_string = serial->readAll();
-	serial->flush();
+	version_string = exchange(QByteArray(1, '\x02'));
 	if (version_string.contains("I2C")) ret = 1;
 	qDebug() << "I2C text: " << version_string;
 	return ret;
@@ -155,11 +230,7 @@ int BinMode::enter_mode_uart(void)
 {
 	int ret = 0;
 	QByteArray version_string;
-	serial->flush();
-	serial->write("\x03", 1);
-	serial->flush();
-	version_string = serial->readAll();
-	serial->flush();
+	version_string = exchange(QByteArray(1, '\x03'));
 	if (version_string.contains("ART")) ret = 1;
 	qDebug() << "UART text: " << version_string;
 	return ret;
@@ -169,27 +240,31 @@ int BinMode::enter_mode_onewire(void)
 {
 	int ret = 0;
 	QByteArray version_string;
-	serial->flush();
-	serial->write("\x04", 1);
-	serial->flush();
-	version_string = serial->readAll();
-	serial->flush();
+	version_string = exchange(QByteArray(1, '\x04'));
 	if (version_string.contains("1W")) ret = 1;
 	qDebug() << "1Wire text: " << version_string;
 	return ret;
 }
 
+int BinMode::enter_mode_jtag(void)
+{
+	int ret = 0;
+	QByteArray version_string;
+	version_string = exchange(QByteArray(1, '\x18'));
+	if (version_string.contains("XSV")) ret = 1;
+	/* The v3 refuses with a single 0x00 and stays in bitbang mode. */
+	else protocol = PROTOCOL_BBIO;
+	qDebug() << "JTAG text: " << version_string;
+	return ret;
+}
+
 /* BBIO Pin Settings */
 int BinMode::raw_set_io(unsigned short pins)
 {
 	int ret = 0;
 	char data = (0x40|pins);
 	QByteArray resp;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
+	resp = exchange(QByteArray(&data, 1));
 	if (resp.contains("\x01")) ret = 1;
 	qDebug() << "raw set io:" << data;
 	return ret;
@@ -200,11 +275,7 @@ int BinMode::raw_set_pins(unsigned short pins)
 	int ret = 0;
 	char data = (0x80|pins);
 	QByteArray resp;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
+	resp = exchange(QByteArray(&data, 1));
 	if (resp.contains("\x01")) ret = 1;
 	qDebug() << "raw set pins:" << data;
 	return ret;
@@ -213,56 +284,30 @@ int BinMode::raw_set_pins(unsigned short pins)
 /* Self Test Methods */
 QByteArray BinMode::test_mode_short(void)
 {
-	QByteArray resp;
-	serial->flush();
-	serial->write("\x10", 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
-	return resp;
+	return exchange(QByteArray(1, '\x10'), SELF_TEST_TIMEOUT);
 }
 
 QByteArray BinMode::test_mode_long(void)
 {
-	QByteArray resp;
-	serial->flush();
-	serial->write("\x11", 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
-	return resp;
+	return exchange(QByteArray(1, '\x11'), SELF_TEST_TIMEOUT);
 }
 
 /* Common Interfaces Methods */
 QByteArray BinMode::bbio_mode_version(void)
 {
-	QByteArray resp;
-	serial->flush();
-	serial->write("\x01", 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
-	return resp;
+	return exchange(QByteArray(1, '\x01'));
 }
 
 QByteArray BinMode::bbio_bulk_trans(QByteArray data, unsigned short size)
 {
-	int i = 0;
-	QByteArray cmd_response;
-	QByteArray data_response;
-	char cmd_data = (0x10|(size-1));
-	serial->flush();
-	serial->write(&cmd_data, 1);
-	serial->flush();
-	cmd_response = serial->readAll();
-	serial->flush();
-	serial->write(data, size);
-	serial->flush();
-	data_response = serial->readAll();
-	serial->flush();
-	if (cmd_response.contains("\x01")) return data_response;
-	qDebug() << "bulk trans:" << data_response.toHex();
-	return data_response;
+	QByteArray request;
+	QByteArray response;
+	request.append((char)(0x10|(size-1)));
+	request.append(data.leftJustified(size, '\0', true));
+	response = exchange(request);
+	if (!response.startsWith("\x01"))
+		qDebug() << "bulk trans:" << response.toHex();
+	return response;
 }
 
 int BinMode::bbio_speed_set(unsigned short speed)
@@ -270,50 +315,29 @@ int BinMode::bbio_speed_set(unsigned short speed)
 	char data = (0x60|speed);
 	QByteArray res;
 	int ret = 0;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(&data, 1));
 	if (res.contains("\x01")) ret=1;
 	return ret;
 }
 
 QByteArray BinMode::bbio_speed_read(void)
 {
-	QByteArray res;
-	serial->flush();
-	serial->write("\x70");
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
-	return res;
+	return exchange(QByteArray(1, '\x70'));
 }
 
 int BinMode::bbio_peripherial_set(unsigned short pins)
 {
 	char data = (0x40|pins);
 	int ret = 0;
-	bool Ok;
 	QByteArray res;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(&data, 1));
 	if (res.contains("\x01")) ret=1;
 	return ret;
 }
 
 QByteArray BinMode::bbio_peripherial_read(void)
 {
-	QByteArray res;
-	serial->flush();
-	serial->write("\x50");
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
-	return res;
+	return exchange(QByteArray(1, '\x50'));
 }
 
 /* SPI methods */
@@ -321,11 +345,7 @@ int BinMode::spi_cs_low(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x02", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x02'));
 	if (res.contains("\x01")) ret = 1;
 	return ret;
 }
@@ -334,11 +354,7 @@ int BinMode::spi_cs_high(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x03", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x03'));
 	if (res.contains("\x01")) ret=1;
 	return ret;
 }
@@ -348,25 +364,15 @@ int BinMode::spi_nibble_high(unsigned short nibble)
 	int ret = 0;
 	QByteArray resp;
 	char nib = (0x30|nibble);
-	serial->flush();
-	serial->write(&nib, 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
+	resp = exchange(QByteArray(&nib, 1));
 	if (resp.contains("\x01")) ret = 1;
 	return ret;
 }
 
 QByteArray BinMode::spi_nibble_low(unsigned short nibble)
 {
-	QByteArray ret;
 	char nib = (0x20|nibble);
-	serial->flush();
-	serial->write(&nib, 1);
-	serial->flush();
-	ret = serial->readAll();
-	serial->flush();
-	return ret;
+	return exchange(QByteArray(&nib, 1));
 }
 
 int BinMode::spi_configure_set(unsigned short spi_cfg)
@@ -374,24 +380,32 @@ int BinMode::spi_configure_set(unsigned short spi_cfg)
 	char data = (0x80|spi_cfg);
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write(&data, 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(&data, 1));
 	if (res.contains("\x01")) ret=1;
 	return ret;
 }
 
 QByteArray BinMode::spi_configure_read(void)
 {
-	QByteArray resp;
-	serial->flush();
-	serial->write("\x90", 1);
-	serial->flush();
-	resp = serial->readAll();
-	serial->flush();
-	return resp;
+	return exchange(QByteArray(1, '\x90'));
+}
+
+QByteArray BinMode::spi_write_then_read_request(QByteArray data, unsigned short read_count)
+{
+	QByteArray request;
+	request.append('\x04');
+	request.append((char)(data.size() >> 8));
+	request.append((char)(data.size() & 0xFF));
+	request.append((char)(read_count >> 8));
+	request.append((char)(read_count & 0xFF));
+	request.append(data);
+	return request;
+}
+
+QByteArray BinMode::spi_write_then_read(QByteArray data, unsigned short read_count)
+{
+	/* CS is taken low for the transfer by the firmware itself. */
+	return exchange(spi_write_then_read_request(data, read_count));
 }
 
 /* I2C Methods */
@@ -399,11 +413,7 @@ int BinMode::i2c_start(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x02", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x02'));
 	if (res.contains("\x01")) ret = 1;
 	return ret;
 }
@@ -412,35 +422,21 @@ int BinMode::i2c_stop(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x03", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x03'));
 	if (res.contains("\x01")) ret = 1;
 	return ret;
 }
 
 QByteArray BinMode::i2c_byte_read(void)
 {
-	QByteArray res;
-	serial->flush();
-	serial->write("\x04", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
-	return res;
+	return exchange(QByteArray(1, '\x04'));
 }
 
 int BinMode::i2c_ack_send(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x05", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x06'));
 	if (res.contains("\x01")) ret = 1;
 	return ret;
 }
@@ -449,12 +445,54 @@ int BinMode::i2c_nack_send(void)
 {
 	int ret = 0;
 	QByteArray res;
-	serial->flush();
-	serial->write("\x06", 1);
-	serial->flush();
-	res = serial->readAll();
-	serial->flush();
+	res = exchange(QByteArray(1, '\x07'));
 	if (res.contains("\x01")) ret = 1;
 	return ret;
 }
 
+QByteArray BinMode::i2c_write_then_read(QByteArray data, unsigned short read_count)
+{
+	QByteArray request;
+	request.append('\x08');
+	request.append((char)(data.size() >> 8));
+	request.append((char)(data.size() & 0xFF));
+	request.append((char)(read_count >> 8));
+	request.append((char)(read_count & 0xFF));
+	request.append(data);
+	return exchange(request);
+}
+
+int BinMode::i2c_eeprom_program(unsigned short device, unsigned short address_width,
+	unsigned short page_size, quint32 address, quint32 length)
+{
+	QByteArray request;
+	int i;
+
+	request.append('\x0C');
+	request.append((char)device);
+	request.append((char)address_width);
+	request.append((char)(page_size >> 8));
+	request.append((char)(page_size & 0xFF));
+	for (i = 24; i >= 0; i -= 8)
+		request.append((char)(address >> i));
+	for (i = 24; i >= 0; i -= 8)
+		request.append((char)(length >> i));
+	/* The pages that follow are raw data, not commands, so they are sent
+	   with their reply length spelled out instead of framed. */
+	return transact(request, 1).startsWith("\x01");
+}
+
+int BinMode::i2c_eeprom_program_page(QByteArray data)
+{
+	return transact(data, 1, EEPROM_PAGE_TIMEOUT).startsWith("\x01");
+}
+
+/* JTAG Methods */
+int BinMode::jtag_xsvf_chunk_size(void)
+{
+	QByteArray reply = exchange(QByteArray(1, '\x05'));
+	/* Firmware from before the query does not answer it. */
+	if (reply.size() != 2)
+		return 0;
+	return ((unsigned char)reply.at(0) << 8) | (unsigned char)reply.at(1);
+}
@@ -1,7 +1,13 @@
 #ifndef __BINMODE_H
 #define __BINMODE_H
 
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QThread>
 #include "qextserialport/qextserialport.h"
+#include "BinModeWorker.h"
+#include "BinModeFrame.h"
 
 #define     WREN         0x06 // A:0 U:0 D:0
 #define     WRDI         0x04 // A:0 U:0 D:0
@@ -16,14 +22,41 @@
 #define     DP           0xB9 // A:0 U:0 D:0
 #define     RDP          0xAB // A:0 U:0 D:0
 
+/* Milliseconds of silence before an answer is given up on. */
+#define REPLY_TIMEOUT       100
+#define SELF_TEST_TIMEOUT   2000
+/* An EEPROM page write, the firmware may poll the chip for its ACK for
+   over 100ms at 100kHz before giving up. */
+#define EEPROM_PAGE_TIMEOUT 250
+
 class MainWidgetFrame;
 class BinMode : public QWidget
 {
+Q_OBJECT
 public:
 	/* Construct */
 	BinMode(MainWidgetFrame *ss);
 	~BinMode();
 	
+	/* Request Queue: the port lives on a worker thread, these wait for
+	   the answer while still running the GUI event loop.  The bytes are
+	   sent as they are, without framing or tracking the mode. */
+	QByteArray transact(const QByteArray &data, int reply_length, int timeout = REPLY_TIMEOUT);
+	QList<QByteArray> transact_all(const QList<QByteArray> &requests, int reply_length, int timeout = REPLY_TIMEOUT);
+
+	/* Same, with the reply length taken from the command set of the
+	   current mode, see BinModeFrame. */
+	QByteArray exchange(const QByteArray &data, int timeout = REPLY_TIMEOUT);
+	QList<QByteArray> exchange_all(const QList<QByteArray> &requests, int timeout = REPLY_TIMEOUT);
+
+	/* Split form of exchange(), so more requests can be queued before
+	   the first answer is collected. */
+	quint32    post(const QByteArray &data, int timeout = REPLY_TIMEOUT);
+	QByteArray collect(quint32 id);
+
+	/* Asynchronous form, the answer comes with reply_ready(). */
+	quint32    submit(const QByteArray &data, int reply_length, int timeout = REPLY_TIMEOUT);
+
 	/* Command Method */
 	QByteArray command(unsigned short command);
 	
@@ -41,6 +74,7 @@ public:
 	int        enter_mode_i2c(void);
 	int        enter_mode_uart(void);
 	int        enter_mode_onewire(void);
+	int        enter_mode_jtag(void);
 
 	/* BBIO pin settings */
 	int        raw_set_io(unsigned short pins);
@@ -65,6 +99,8 @@ public:
 	QByteArray spi_nibble_low(unsigned short nibble);
 	int        spi_configure_set(unsigned short spi_cfg);
 	QByteArray spi_configure_read(void);
+	QByteArray spi_write_then_read(QByteArray data, unsigned short read_count);
+	static QByteArray spi_write_then_read_request(QByteArray data, unsigned short read_count);
 
 	/* I2C */
 	int        i2c_start(void);
@@ -72,14 +108,34 @@ public:
 	QByteArray i2c_byte_read(void);
 	int        i2c_ack_send(void);
 	int        i2c_nack_send(void);
+	QByteArray i2c_write_then_read(QByteArray data, unsigned short read_count);
+	int        i2c_eeprom_program(unsigned short device, unsigned short address_width,
+	                              unsigned short page_size, quint32 address, quint32 length);
+	int        i2c_eeprom_program_page(QByteArray data);
+
+	/* JTAG */
+	int        jtag_xsvf_chunk_size(void);
 
-	/* Serial Port Access */
-	QextSerialPort *serial;
 	MainWidgetFrame *parent;
+signals:
+	void       reply_ready(quint32 id, QByteArray reply, bool complete);
 public slots:
 	/* Port Manipulation */
 	bool       port_open(void);
+	void       port_configure(void);
 	void       port_close(void);
+	bool       is_open(void);
+private slots:
+	void       replied(quint32 id, QByteArray reply, bool complete);
+private:
+	QByteArray wait(quint32 id);
+
+	QThread        worker_thread;
+	BinModeWorker *worker;
+	quint32        next_id;
+	BinModeProtocol protocol;
+	QSet<quint32>  awaited;
+	QHash<quint32, QPair<QByteArray, bool> > finished;
 };
 
 #endif
@@ -0,0 +1,179 @@
+#include "BinModeWorker.h"
+#include "BinModeFrame.h"
+
+/* Every mode answers its reset with "BBIO1" and its identifier with a
+   four character version string, such as "SPI1". */
+#define RESET_REPLY_LENGTH      5
+#define IDENTIFIER_REPLY_LENGTH 4
+
+int BinModeFrame::word_at(const QByteArray &request, int offset)
+{
+	return ((unsigned char)request.at(offset) << 8) | (unsigned char)request.at(offset + 1);
+}
+
+bool BinModeFrame::frame(BinModeProtocol protocol, const QByteArray &request, int offset,
+	int *command_length, int *reply_length)
+{
+	unsigned char command = request.at(offset);
+	int available = request.size() - offset;
+
+	*command_length = 1;
+	*reply_length = 1;
+
+	if (protocol == PROTOCOL_JTAG) {
+		/* The JTAG mode has no way back, not even through 0x00, and
+		   only its reset and the XSVF chunk size query have fixed
+		   answers. */
+		if (command == 0x01) {
+			*reply_length = 0;
+			return true;
+		}
+		if (command == 0x05) {
+			*reply_length = 2;
+			return true;
+		}
+		return false;
+	}
+
+	if (command == 0x00) {
+		*reply_length = RESET_REPLY_LENGTH;
+		return true;
+	}
+
+	switch (protocol) {
+	case PROTOCOL_BBIO:
+		if (command <= 0x04) {
+			/* Mode entry, answered by the new mode's identifier.  The
+			   other modes are not framed. */
+			*reply_length = IDENTIFIER_REPLY_LENGTH;
+			return true;
+		}
+		switch (command) {
+		case 0x10: /* short self test */
+		case 0x11: /* full self test */
+		case 0x13: /* clear PWM */
+			return true;
+		case 0x12: /* setup PWM: prescaler, duty cycle, period */
+			*command_length = 6;
+			return available >= *command_length;
+		case 0x14: /* one shot ADC reading */
+			*reply_length = 2;
+			return true;
+		case 0x18: /* JTAG, answered by "XSV1" on v4 only */
+			*reply_length = IDENTIFIER_REPLY_LENGTH;
+			return true;
+		}
+		/* Pin direction and pin state updates answer with the pins. */
+		return command >= 0x40;
+
+	case PROTOCOL_SPI:
+		if (command == 0x04 || command == 0x05) {
+			/* write then read: write count, read count, data */
+			if (available < 5)
+				return false;
+			*command_length = 5 + word_at(request, offset + 1);
+			*reply_length = 1 + word_at(request, offset + 3);
+			return available >= *command_length;
+		}
+		if (command == 0x01) {
+			*reply_length = IDENTIFIER_REPLY_LENGTH;
+			return true;
+		}
+		if (command == 0x02 || command == 0x03)
+			return true;
+		if ((command & 0xF0) == 0x10) {
+			/* bulk transfer, one byte back for each byte sent */
+			*command_length = 1 + (command & 0x0F) + 1;
+			*reply_length = *command_length;
+			return available >= *command_length;
+		}
+		/* Sniffers, streaming and scripts have open ended answers. */
+		return command >= 0x20;
+
+	case PROTOCOL_I2C:
+		switch (command) {
+		case 0x01:
+			*reply_length = IDENTIFIER_REPLY_LENGTH;
+			return true;
+		case 0x02: /* start */
+		case 0x03: /* stop */
+		case 0x04: /* read byte */
+		case 0x06: /* ACK */
+		case 0x07: /* NACK */
+			return true;
+		case 0x05: /* clock stretch timeout */
+			*command_length = 3;
+			return available >= *command_length;
+		case 0x08: /* write then read: write count, read count, data */
+			if (available < 5)
+				return false;
+			*command_length = 5 + word_at(request, offset + 1);
+			*reply_length = 1 + word_at(request, offset + 3);
+			return available >= *command_length;
+		}
+		if ((command & 0xF0) == 0x10) {
+			/* bulk write, an ACK bit back for each byte sent */
+			*command_length = 1 + (command & 0x0F) + 1;
+			*reply_length = *command_length;
+			return available >= *command_length;
+		}
+		return command >= 0x20;
+
+	case PROTOCOL_UART:
+	case PROTOCOL_ONEWIRE:
+		if (command == 0x01) {
+			*reply_length = IDENTIFIER_REPLY_LENGTH;
+			return true;
+		}
+		/* UART echo on and off, 1-Wire bus reset and read byte */
+		if (command == 0x02 || (protocol == PROTOCOL_UART ? command == 0x03 : command == 0x04))
+			return true;
+		if ((command & 0xF0) == 0x10) {
+			*command_length = 1 + (command & 0x0F) + 1;
+			*reply_length = *command_length;
+			return available >= *command_length;
+		}
+		return command >= 0x40;
+	}
+	return false;
+}
+
+int BinModeFrame::reply_length(BinModeProtocol protocol, const QByteArray &request)
+{
+	int command_length, length, total = 0, offset = 0;
+
+	while (offset < request.size()) {
+		if (!frame(protocol, request, offset, &command_length, &length))
+			return REPLY_UNTIL_IDLE;
+		total += length;
+		protocol = next_protocol(protocol, request.mid(offset, command_length));
+		offset += command_length;
+	}
+	return total;
+}
+
+BinModeProtocol BinModeFrame::next_protocol(BinModeProtocol protocol, const QByteArray &request)
+{
+	int command_length, length, offset = 0;
+
+	while (offset < request.size()) {
+		unsigned char command = request.at(offset);
+		if (!frame(protocol, request, offset, &command_length, &length))
+			break;
+		if (command == 0x00) {
+			/* A reset in a protocol mode goes back to bitbang mode; in
+			   bitbang mode it only repeats the identifier. */
+			protocol = PROTOCOL_BBIO;
+		} else if (protocol == PROTOCOL_BBIO) {
+			switch (command) {
+			case 0x01: protocol = PROTOCOL_SPI;     break;
+			case 0x02: protocol = PROTOCOL_I2C;     break;
+			case 0x03: protocol = PROTOCOL_UART;    break;
+			case 0x04: protocol = PROTOCOL_ONEWIRE; break;
+			case 0x18: protocol = PROTOCOL_JTAG;    break;
+			}
+		}
+		offset += command_length;
+	}
+	return protocol;
+}
@@ -0,0 +1,43 @@
+#ifndef __BINMODEFRAME_H
+#define __BINMODEFRAME_H
+
+#include <QByteArray>
+
+/* Command set the firmware is listening with.  Each binary mode reuses
+   the same command bytes for different things, so a request can only be
+   framed once the current mode is known. */
+enum BinModeProtocol
+{
+	PROTOCOL_BBIO,
+	PROTOCOL_SPI,
+	PROTOCOL_I2C,
+	PROTOCOL_UART,
+	PROTOCOL_ONEWIRE,
+	PROTOCOL_JTAG,
+};
+
+/* Knows how long the firmware's answer to each binary command is, so a
+   reply can be collected as soon as its last byte is in instead of after
+   a guessed delay.  A request may hold several commands back to back.
+   Mirrors the dispatch loops in binary_io.c, spi.c, i2c.c, uart.c and
+   1wire.c and jtag.c; anything not listed there is left to REPLY_UNTIL_IDLE. */
+class BinModeFrame
+{
+public:
+	/* Total reply length for every command in request, or
+	   REPLY_UNTIL_IDLE if any of them has an open ended answer. */
+	static int reply_length(BinModeProtocol protocol, const QByteArray &request);
+
+	/* Protocol the firmware switches to once a request was answered. */
+	static BinModeProtocol next_protocol(BinModeProtocol protocol, const QByteArray &request);
+
+private:
+	/* Length of the command starting at offset, parameters and payload
+	   included, and the length of its answer.  Returns false if the
+	   answer is open ended or the command is cut short. */
+	static bool frame(BinModeProtocol protocol, const QByteArray &request, int offset,
+		int *command_length, int *reply_length);
+	static int word_at(const QByteArray &request, int offset);
+};
+
+#endif
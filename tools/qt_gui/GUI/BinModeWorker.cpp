@@ -0,0 +1,165 @@
+#include <QtCore>
+#include "qextserialport/qextserialport.h"
+#include "BinModeWorker.h"
+
+BinModeWorker::BinModeWorker() : QObject(), timer(this)
+{
+	serial = NULL;
+	bytes_in_flight = 0;
+	timer.setSingleShot(true);
+	connect(&timer, SIGNAL(timeout()), this, SLOT(reply_timeout()));
+}
+
+BinModeWorker::~BinModeWorker()
+{
+	port_close();
+}
+
+/* Port Manipulation */
+void BinModeWorker::port_configure(QString name, int baud, int databits, int stopbits, int parity, int flow)
+{
+	if (serial == NULL) {
+		serial = new QextSerialPort(name, QextSerialPort::EventDriven);
+		serial->setParent(this);
+		connect(serial, SIGNAL(readyRead()), this, SLOT(data_ready()));
+	}
+	if (!serial->isOpen())
+		serial->setPortName(name);
+	serial->setBaudRate((BaudRateType)baud);
+	serial->setDataBits((DataBitsType)databits);
+	serial->setStopBits((StopBitsType)stopbits);
+	serial->setParity((ParityType)parity);
+	serial->setFlowControl((FlowType)flow);
+}
+
+bool BinModeWorker::port_open(QString name, int baud, int databits, int stopbits, int parity, int flow)
+{
+	port_configure(name, baud, databits, stopbits, parity, flow);
+	if (serial->isOpen())
+		return true;
+	bool ret = serial->open(QIODevice::ReadWrite);
+	/* Whatever was queued in the driver belongs to nobody. */
+	serial->flush();
+	received.clear();
+	qDebug() << "Serial Port Opened:" << serial->portName() << "is open-" << serial->isOpen();
+	return ret;
+}
+
+void BinModeWorker::port_close(void)
+{
+	if (serial == NULL || !serial->isOpen())
+		return;
+	serial->close();
+	qDebug() << "Serial Port Closed:" << serial->portName() << "is open-" << serial->isOpen();
+
+	/* Nothing in flight will be answered now. */
+	while (!in_flight.isEmpty())
+		finish(false);
+	pump();
+}
+
+bool BinModeWorker::is_open(void)
+{
+	return serial != NULL && serial->isOpen();
+}
+
+/* Request Queue */
+void BinModeWorker::submit(quint32 id, QByteArray data, int reply_length, int timeout)
+{
+	Request request;
+	request.id = id;
+	request.data = data;
+	request.reply_length = reply_length;
+	request.timeout = timeout;
+	waiting.enqueue(request);
+	pump();
+}
+
+void BinModeWorker::pump(void)
+{
+	do {
+		while (!waiting.isEmpty()) {
+			const Request &next = waiting.head();
+			if (!in_flight.isEmpty()) {
+				/* An answer of unknown length must be alone on the wire. */
+				if (next.reply_length == REPLY_UNTIL_IDLE ||
+				    in_flight.last().reply_length == REPLY_UNTIL_IDLE)
+					break;
+				if (bytes_in_flight + next.data.size() > MAX_BYTES_IN_FLIGHT)
+					break;
+			}
+
+			Request request = waiting.dequeue();
+			if (!is_open()) {
+				emit replied(request.id, QByteArray(), false);
+				continue;
+			}
+			serial->write(request.data);
+			in_flight.enqueue(request);
+			bytes_in_flight += request.data.size();
+			if (in_flight.size() == 1)
+				wait_for_head();
+		}
+	} while (deliver());
+}
+
+bool BinModeWorker::deliver(void)
+{
+	bool delivered = false;
+	while (!in_flight.isEmpty()) {
+		int length = in_flight.head().reply_length;
+		if (length == REPLY_UNTIL_IDLE || received.size() < length)
+			break;
+		finish(true);
+		delivered = true;
+	}
+	return delivered;
+}
+
+void BinModeWorker::finish(bool complete)
+{
+	Request request = in_flight.dequeue();
+	QByteArray reply;
+
+	bytes_in_flight -= request.data.size();
+	if (request.reply_length == REPLY_UNTIL_IDLE) {
+		reply = received;
+		received.clear();
+	} else {
+		reply = received.left(request.reply_length);
+		received.remove(0, reply.size());
+	}
+	wait_for_head();
+	emit replied(request.id, reply, complete);
+}
+
+void BinModeWorker::wait_for_head(void)
+{
+	if (in_flight.isEmpty())
+		timer.stop();
+	else
+		timer.start(in_flight.head().timeout);
+}
+
+void BinModeWorker::data_ready(void)
+{
+	QByteArray data = serial->readAll();
+	if (in_flight.isEmpty()) {
+		qDebug() << "unexpected data:" << data.toHex();
+		return;
+	}
+	received.append(data);
+	/* Timeouts count silence, a long answer may take as long as it needs. */
+	wait_for_head();
+	pump();
+}
+
+void BinModeWorker::reply_timeout(void)
+{
+	if (in_flight.isEmpty())
+		return;
+	if (in_flight.head().reply_length != REPLY_UNTIL_IDLE)
+		qDebug() << "reply timeout, got" << received.toHex();
+	finish(in_flight.head().reply_length == REPLY_UNTIL_IDLE);
+	pump();
+}
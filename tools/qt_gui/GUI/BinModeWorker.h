@@ -0,0 +1,65 @@
+#ifndef __BINMODEWORKER_H
+#define __BINMODEWORKER_H
+
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include "qextserialport/qextserialport.h"
+
+/* Reply length for requests whose answer is whatever arrives until the
+   port goes quiet, such as mode banners and the terminal. */
+#define REPLY_UNTIL_IDLE    -1
+
+/* How many request bytes may be waiting for their answer at once.  The v3
+   firmware only has a small receive ring in front of the UART. */
+#define MAX_BYTES_IN_FLIGHT 64
+
+/* Owns the serial port on its own thread.  Requests are written in order
+   as soon as there is room, and answers are cut out of the incoming data
+   by their expected length, so nothing waits on fixed timeouts unless the
+   length of the answer is not known in advance. */
+class BinModeWorker : public QObject
+{
+Q_OBJECT
+public:
+	BinModeWorker();
+	~BinModeWorker();
+
+public slots:
+	bool port_open(QString name, int baud, int databits, int stopbits, int parity, int flow);
+	void port_configure(QString name, int baud, int databits, int stopbits, int parity, int flow);
+	void port_close(void);
+	bool is_open(void);
+	void submit(quint32 id, QByteArray data, int reply_length, int timeout);
+
+signals:
+	/* complete is false when the answer timed out short of reply_length. */
+	void replied(quint32 id, QByteArray reply, bool complete);
+
+private slots:
+	void data_ready(void);
+	void reply_timeout(void);
+
+private:
+	struct Request
+	{
+		quint32    id;
+		QByteArray data;
+		int        reply_length;
+		int        timeout;
+	};
+
+	void pump(void);
+	bool deliver(void);
+	void finish(bool complete);
+	void wait_for_head(void);
+
+	QextSerialPort *serial;
+	QQueue<Request> waiting;
+	QQueue<Request> in_flight;
+	int             bytes_in_flight;
+	QByteArray      received;
+	QTimer          timer;
+};
+
+#endif
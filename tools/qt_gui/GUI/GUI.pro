@@ -29,15 +29,22 @@ unix:VERSION = 1.0.0
 HEADERS += 	\
 			configure.h \
 			BinMode.h \
+			BinModeFrame.h \
+			BinModeWorker.h \
 			BPSettings.h \
 			Events.h \
+			HexView.h \
 			Interface.h \
-			MainWin.h
+			MainWin.h \
+			PortDiscovery.h
 
 SOURCES += 	\
 			BinMode.cpp \
+			BinModeFrame.cpp \
+			BinModeWorker.cpp \
 			BPSettings.cpp \
 			Events.cpp \
+			HexView.cpp \
 			Interface_i2c.cpp \
 			Interface_jtag.cpp \
 			Interface_onewire.cpp \
@@ -46,5 +53,6 @@ SOURCES += 	\
 			Interface_rawwire.cpp \
 			#Interface_spi.cpp \
 			MainWin.cpp \
+			PortDiscovery.cpp \
 			main.cpp
 
@@ -0,0 +1,142 @@
+#include <QtWidgets>
+#include "HexView.h"
+
+/* The last column holds the ASCII of the whole row. */
+#define ASCII_COLUMN HEX_VIEW_ROW_BYTES
+
+HexDumpModel::HexDumpModel(QObject *parent) : QAbstractTableModel(parent)
+{
+	bytes = NULL;
+	size = 0;
+}
+
+HexDumpModel::~HexDumpModel()
+{
+	unload();
+}
+
+bool HexDumpModel::load(const QString &path)
+{
+	beginResetModel();
+	unload();
+	file.setFileName(path);
+	if (file.open(QIODevice::ReadOnly))
+	{
+		size = file.size();
+		if (size > 0)
+			bytes = file.map(0, size);
+		if (bytes == NULL)
+		{
+			size = 0;
+			file.close();
+		}
+	}
+	endResetModel();
+	return bytes != NULL;
+}
+
+void HexDumpModel::unload(void)
+{
+	if (bytes != NULL)
+		file.unmap(bytes);
+	bytes = NULL;
+	size = 0;
+	if (file.isOpen())
+		file.close();
+}
+
+int HexDumpModel::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid())
+		return 0;
+	return (int)((size + HEX_VIEW_ROW_BYTES - 1) / HEX_VIEW_ROW_BYTES);
+}
+
+int HexDumpModel::columnCount(const QModelIndex &parent) const
+{
+	if (parent.isValid())
+		return 0;
+	return HEX_VIEW_ROW_BYTES + 1;
+}
+
+QString HexDumpModel::ascii_row(qint64 offset) const
+{
+	QString text;
+	qint64 end = qMin(offset + HEX_VIEW_ROW_BYTES, size);
+
+	for (; offset < end; offset++)
+		text.append((bytes[offset] >= 0x20 && bytes[offset] < 0x7F) ?
+			QChar(bytes[offset]) : QChar('.'));
+	return text;
+}
+
+QVariant HexDumpModel::data(const QModelIndex &index, int role) const
+{
+	qint64 offset;
+
+	if (!index.isValid() || bytes == NULL)
+		return QVariant();
+
+	offset = (qint64)index.row() * HEX_VIEW_ROW_BYTES;
+	switch (role)
+	{
+	case Qt::DisplayRole:
+		if (index.column() == ASCII_COLUMN)
+			return ascii_row(offset);
+		offset += index.column();
+		if (offset >= size)
+			return QVariant();
+		return QString("%1").arg(bytes[offset], 2, 16, QChar('0')).toUpper();
+	case Qt::TextAlignmentRole:
+		if (index.column() == ASCII_COLUMN)
+			return (int)(Qt::AlignLeft | Qt::AlignVCenter);
+		return (int)Qt::AlignCenter;
+	default:
+		return QVariant();
+	}
+}
+
+QVariant HexDumpModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (role != Qt::DisplayRole)
+		return QVariant();
+	if (orientation == Qt::Vertical)
+		return QString("%1").arg((qint64)section * HEX_VIEW_ROW_BYTES, 6, 16, QChar('0')).toUpper();
+	if (section == ASCII_COLUMN)
+		return QString("ASCII");
+	return QString("%1").arg(section, 0, 16).toUpper();
+}
+
+HexView::HexView(QWidget *parent) : QTableView(parent)
+{
+	QFont font("Monospace");
+	font.setStyleHint(QFont::TypeWriter);
+	setFont(font);
+
+	model = new HexDumpModel(this);
+	setModel(model);
+
+	/* Fixed sizes let the view work out what is visible without asking
+	   the model about every row. */
+	verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	verticalHeader()->setDefaultSectionSize(fontMetrics().height() + 2);
+	horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	horizontalHeader()->setDefaultSectionSize(fontMetrics().width("000"));
+	horizontalHeader()->setStretchLastSection(true);
+	setShowGrid(false);
+	setWordWrap(false);
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+}
+
+bool HexView::load(const QString &path)
+{
+	bool ret = model->load(path);
+	scrollToTop();
+	return ret;
+}
+
+void HexView::clear(void)
+{
+	model->load(QString());
+}
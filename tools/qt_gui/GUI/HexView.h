@@ -0,0 +1,57 @@
+#ifndef __HEXVIEW_H
+#define __HEXVIEW_H
+
+#include <QAbstractTableModel>
+#include <QFile>
+#include <QTableView>
+
+/* Bytes shown on each row. */
+#define HEX_VIEW_ROW_BYTES 16
+
+/* Presents a dump file as rows of an address, HEX_VIEW_ROW_BYTES hex
+   columns and their ASCII.  The file is memory mapped and each cell is
+   formatted when the view asks for it, so a 16 MiB flash image opens at
+   once and costs no more memory than a small one. */
+class HexDumpModel : public QAbstractTableModel
+{
+Q_OBJECT
+public:
+	HexDumpModel(QObject *parent = 0);
+	~HexDumpModel();
+
+	/* Maps path in place of the current file, returns false if it
+	   cannot be opened. */
+	bool load(const QString &path);
+	void unload(void);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+	QVariant headerData(int section, Qt::Orientation orientation,
+		int role = Qt::DisplayRole) const;
+
+private:
+	QString ascii_row(qint64 offset) const;
+
+	QFile  file;
+	uchar *bytes;
+	qint64 size;
+};
+
+/* Table view over a HexDumpModel.  Rows all have the same height, so
+   only the visible ones are ever laid out or drawn. */
+class HexView : public QTableView
+{
+Q_OBJECT
+public:
+	HexView(QWidget *parent = 0);
+
+	bool load(const QString &path);
+	/* Lets go of the file, which must be done before it is rewritten. */
+	void clear(void);
+
+private:
+	HexDumpModel *model;
+};
+
+#endif
@@ -31,6 +31,7 @@ enum spi_cfg
 };
 
 class MainWidgetFrame;
+class HexView;
 /*class SpiGui : public QWidget
 {
 Q_OBJECT
@@ -40,10 +41,20 @@ private slots:
 	void read_spi();
 	void write_spi();
 	void spi_chip_id();
+signals:
+	void progress(int percent);
 private:
+	bool setup_spi(void);
+	bool wait_write_done(void);
+	void report_progress(unsigned long done, unsigned long total);
+	static QByteArray address_command(char command, unsigned long address);
+
 	MainWidgetFrame *parent;
 	QLineEdit *file;
 	QTextEdit *msglog;
+	HexView *dump_view;
+	QProgressBar *progress_bar;
+	QElapsedTimer progress_timer;
 protected:
 	virtual void customEvent(QEvent *ev);
 public:
@@ -62,7 +73,13 @@ private:
 	QLineEdit *file;
 	QLineEdit *file_size;
 	QLineEdit *start_addr;
+	QLineEdit *page_size;
+	QComboBox *addr_width;
 	QTextEdit *msglog;
+	HexView *dump_view;
+
+	bool setup_i2c(void);
+	QByteArray memory_address(unsigned long address);
 private slots:
 	void search_i2c(void);
 	void write_i2c(void);
@@ -120,11 +137,34 @@ class JtagGui : public QWidget
 Q_OBJECT
 public:
 	JtagGui(MainWidgetFrame *p);
+private slots:
+	void program_xsvf(void);
+	void xsvf_replied(quint32 id, QByteArray reply, bool complete);
+signals:
+	void progress(int percent);
 private:
+	void stage_chunk(void);
+	void send_chunk(void);
+	void finish_xsvf(int result);
+	void report_progress(void);
+
 	MainWidgetFrame *parent;
-	QLineEdit *device_addr;
 	QLineEdit *file;
 	QTextEdit *msglog;
+	QPushButton *program_btn;
+	QProgressBar *progress_bar;
+	QElapsedTimer progress_timer;
+
+	/* The XSVF file being played, mapped for the whole run. */
+	QFile image;
+	const uchar *image_data;
+	qint64 image_size;
+	qint64 offset;
+	int chunk_size;
+	/* Header and data of the chunk answering the next request. */
+	QByteArray chunk;
+	quint32 request;
+	bool sent_end;
 protected:
 	virtual void customEvent(QEvent *ev);
 public:
@@ -141,10 +181,14 @@ public:
 	void postMsgEvent(const char* msg);
 private slots:
 	void ExecuteFile(void);
+	void flush_log(void);
 private:
-	QTextEdit *msglog;
+	QPlainTextEdit *msglog;
 	QLineEdit *raw_file;
 	MainWidgetFrame *parent;
+	/* Lines waiting for the next flush_log(). */
+	QStringList pending;
+	QTimer flush_timer;
 };
 
 /*class PowerGui : public QWidget
@@ -4,6 +4,11 @@
 #include "MainWin.h"
 #include "Interface.h"
 #include "Events.h"
+#include "HexView.h"
+
+/* Largest read in one write-then-read, the firmware buffers it in its
+   terminal buffer, which is at least this large on every board. */
+#define I2C_READ_CHUNK_SIZE 4096
 
 I2CGui::I2CGui(MainWidgetFrame *parent) : QWidget(parent)
 {
@@ -15,6 +20,8 @@ I2CGui::I2CGui(MainWidgetFrame *parent) : QWidget(parent)
 	QLabel *file_size_label = new QLabel("Data: ");
 	QLabel *log_label = new QLabel("Log: ");
 	QLabel *dev_prop_saddr_label = new QLabel("Start Mem Addr: ");
+	QLabel *page_size_label = new QLabel("Page Size: ");
+	QLabel *file_label = new QLabel("File: ");
 
 	QPushButton *scan = new QPushButton("Scan I2C");
 	scan->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
@@ -40,14 +47,23 @@ I2CGui::I2CGui(MainWidgetFrame *parent) : QWidget(parent)
 	device_addr_read = new QLineEdit("0xA1");
 	device_addr_read->setValidator(hex_valid);
 	device_addr_read->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-	//start_addr = new QLineEdit("0x00");
-	//start_addr->setValidator(hex_valid);
-	//start_addr->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	start_addr = new QLineEdit("0x0000");
+	start_addr->setValidator(new QRegExpValidator(QRegExp("^(0x){,1}[a-fA-F0-9]{1,5}$"), this));
+	start_addr->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	addr_width = new QComboBox;
+	addr_width->addItem("1 Address Byte");
+	addr_width->addItem("2 Address Bytes");
+	addr_width->setCurrentIndex(1);
+	page_size = new QLineEdit("64");
+	page_size->setValidator(new QIntValidator(1, 4096, this));
+	page_size->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 	file_size = new QLineEdit;
 	file_size->setValidator(new QRegExpValidator(rx_int, this));
+	file = new QLineEdit;
 
 	msglog = new QTextEdit;
 	msglog->setReadOnly(true);
+	dump_view = new HexView;
 	
 	hlayout->addWidget(scan);
 	hlayout->addWidget(read_btn);
@@ -58,21 +74,28 @@ I2CGui::I2CGui(MainWidgetFrame *parent) : QWidget(parent)
 	dev_addr_layout->addWidget(device_addr_write_label);
 	dev_addr_layout->addWidget(device_addr_write);
 	
-	//dev_addr_layout2->addWidget(dev_prop_saddr_label);
-	//dev_addr_layout2->addWidget(start_addr);
+	dev_addr_layout2->addWidget(dev_prop_saddr_label);
+	dev_addr_layout2->addWidget(start_addr);
+	dev_addr_layout2->addWidget(addr_width);
+	dev_addr_layout2->addWidget(page_size_label);
+	dev_addr_layout2->addWidget(page_size);
 	dev_addr_layout3->addWidget(file_size_label);
 	dev_addr_layout3->addWidget(file_size);
+	file_line->addWidget(file_label);
+	file_line->addWidget(file);
 	
 	vlayout->addSpacing(10);
 	vlayout->addWidget(device_label);
 	vlayout->addLayout(dev_addr_layout);
-	//vlayout->addLayout(dev_addr_layout2);
+	vlayout->addLayout(dev_addr_layout2);
 	vlayout->addLayout(dev_addr_layout3);
+	vlayout->addLayout(file_line);
 	vlayout->addSpacing(10);
 	vlayout->addLayout(hlayout);
 	vlayout->addSpacing(50);
 	vlayout->addWidget(log_label);
 	vlayout->addWidget(msglog);
+	vlayout->addWidget(dump_view);
 	
 	connect(scan, SIGNAL(clicked()), this, SLOT(search_i2c()));
 	connect(read_btn, SIGNAL(clicked()), this, SLOT(read_i2c()));
@@ -95,8 +118,7 @@ void I2CGui::search_i2c()
 		addr = i>>1;
 
 		parent->bp->i2c_start();
-		parent->bp->serial->write((char*)&dev, 1);
-		parent->bp->i2c_byte_read();
+		parent->bp->bbio_bulk_trans(QByteArray(1, (char)dev), 1);
 		if ((addr & 0x01)==0) 
 		{
 			rw = 'W';
@@ -113,78 +135,138 @@ void I2CGui::search_i2c()
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(end_msg));
 }
 
+bool I2CGui::setup_i2c(void)
+{
+	if (!parent->bp->is_open())
+		return false;
+	if (!parent->bp->enter_mode_i2c())
+	{
+		postMsgEvent("I2C Failed.");
+		return false;
+	}
+	// power and pull-ups on, 100kHz
+	if (!parent->bp->bbio_peripherial_set(BB_POWER | BB_PULLUPS) ||
+	    !parent->bp->bbio_speed_set(0x02))
+	{
+		postMsgEvent("I2C Config Failed.");
+		parent->bp->reset_bbio();
+		return false;
+	}
+	return true;
+}
+
+QByteArray I2CGui::memory_address(unsigned long address)
+{
+	bool ok;
+	int width = addr_width->currentIndex() + 1;
+	QByteArray data;
+
+	// memory address bits past the address bytes go in the device address,
+	// as 24C04/08/16 and 24CM01/02 parts expect
+	data.append((char)((device_addr_write->text().toInt(&ok, 16) & 0xFE) |
+		((address >> (width * 8 - 1)) & 0x0E)));
+	if (width == 2)
+		data.append((char)(address >> 8));
+	data.append((char)address);
+	return data;
+}
+
 void I2CGui::write_i2c(void)
 {
 	bool ok;
+	unsigned long address, offset, chunk, page;
 	QByteArray data;
 	QString start_msg = "Writing I2C Device...";
 	QString end_msg = "Writing I2C Device...Done!";
+	QString fail_msg = "Writing I2C Device...Failed";
 
 	QFile qfile(file->text());
 	if (!qfile.open(QIODevice::ReadOnly))
 		return;
+	data = qfile.readAll();
+	qfile.close();
 
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(start_msg));
+	if (!setup_i2c())
+		goto err;
 
-	// i2c start
-	parent->bp->i2c_start();
-	// write chip address (w)
-	parent->bp->serial->write((char*)device_addr_write->text().toInt(&ok, 16), 1);
-	// write memory address
-	parent->bp->serial->write((char*)start_addr->text().toInt(&ok, 16), 1);
-	// values to write
-	data = qfile.readAll();
-	parent->bp->serial->write(data.data(), sizeof(data.data()));
-	// i2c stop
-	parent->bp->i2c_stop();
-
-	qfile.close();
+	// the firmware writes page by page and polls the chip for an ACK
+	// after each one, so only one round trip per page is left
+	address = start_addr->text().toULong(&ok, 16);
+	page = page_size->text().toULong();
+	if (!parent->bp->i2c_eeprom_program(device_addr_write->text().toInt(&ok, 16),
+		addr_width->currentIndex() + 1, page, address, data.size()))
+	{
+		postMsgEvent("EEPROM Program: Refused.");
+		parent->bp->reset_bbio();
+		goto err;
+	}
+	for (offset = 0; offset < (unsigned long)data.size(); offset += chunk)
+	{
+		// pages are aligned, the first and last ones can be short
+		chunk = qMin(page - ((address + offset) % page), data.size() - offset);
+		if (!parent->bp->i2c_eeprom_program_page(data.mid(offset, chunk)))
+		{
+			postMsgEvent(QString("EEPROM Program: No ACK at 0x%1.")
+				.arg(address + offset, 0, 16).toLatin1());
+			parent->bp->reset_bbio();
+			goto err;
+		}
+	}
+	parent->bp->reset_bbio();
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(end_msg));
+	return;
+err:
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(fail_msg));
 }
 
 void I2CGui::read_i2c(void)
 {
-	int i=0;
-	int fsize = file_size->text().toInt();
-	bool more = false;
 	bool ok;
-	QByteArray data;
+	unsigned long address, offset, chunk, block;
+	unsigned long fsize = file_size->text().toULong();
+	QByteArray reply;
 	QString start_msg = "Reading I2C Device...";
 	QString end_msg = "Reading I2C Device...Done!";
+	QString fail_msg = "Reading I2C Device...Failed";
 
+	// the old dump may be the file about to be overwritten
+	dump_view->clear();
 	QFile qfile(file->text());
 	if (!qfile.open(QIODevice::WriteOnly))
 		return;
 
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(start_msg));
-	// i2c start
-	parent->bp->i2c_start();
-	// write chip (w) address
-	parent->bp->serial->write((char*)device_addr_write->text().toInt(&ok, 16), 1);
-	// write memory address
-	parent->bp->serial->write((char*)start_addr->text().toInt(&ok, 16), 1);
-	// i2c stop
-	parent->bp->i2c_stop();
-
-	// i2c start
-	parent->bp->i2c_start();
-	// write chip (r) address
-	parent->bp->serial->write((char*)device_addr_read->text().toInt(&ok, 16), 1);
-
-	for (i=0; i<fsize; i++)
+	if (!setup_i2c())
+		goto err;
+
+	// one write-then-read per chunk: start, device and memory address,
+	// restart, then the data with the ACKs and NACK handled on the device;
+	// chunks never cross into the next device address
+	address = start_addr->text().toULong(&ok, 16);
+	block = 1UL << ((addr_width->currentIndex() + 1) * 8);
+	for (offset = 0; offset < fsize; offset += chunk)
 	{
-		// read byte
-		data = parent->bp->i2c_byte_read();
-		qfile.write(data);
-		// send ack (if for more) else send nack
-		if (i<fsize) parent->bp->i2c_ack_send();
-		
+		chunk = qMin((unsigned long)I2C_READ_CHUNK_SIZE, fsize - offset);
+		chunk = qMin(chunk, block - ((address + offset) % block));
+		reply = parent->bp->i2c_write_then_read(memory_address(address + offset), chunk);
+		if (!reply.startsWith("\x01") || reply.size() != (int)chunk + 1)
+		{
+			postMsgEvent(QString("Read: No ACK at 0x%1.")
+				.arg(address + offset, 0, 16).toLatin1());
+			parent->bp->reset_bbio();
+			goto err;
+		}
+		qfile.write(reply.constData() + 1, chunk);
 	}
-	parent->bp->i2c_nack_send();
-	// i2c stop
-	parent->bp->i2c_stop();
+	parent->bp->reset_bbio();
 	qfile.close();
+	dump_view->load(file->text());
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(end_msg));
+	return;
+err:
+	qfile.close();
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(fail_msg));
 }
 
 void I2CGui::customEvent(QEvent *ev)
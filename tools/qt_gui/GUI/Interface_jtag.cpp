@@ -5,9 +5,214 @@
 #include "Interface.h"
 #include "Events.h"
 
+/* The XSVF player sends XSVF_READY_FOR_DATA for every chunk, answered by
+   a 16-bit byte count, MSB first, and that many bytes; a zero count ends
+   the file.  Anything else is the player's result. */
+#define XSVF_PLAYER           '\x03'
+#define XSVF_READY_FOR_DATA   0xFF
+#define XSVF_ERROR_NONE       0x00
+#define XSVF_CHUNK_HEADER     2
+/* What firmware without the chunk size query takes. */
+#define XSVF_CHUNK_DEFAULT    2048
+/* Milliseconds of silence before the player is given up on, a single
+   XRUNTEST may wait through a whole erase. */
+#define XSVF_REPLY_TIMEOUT    5000
+/* Milliseconds between progress updates. */
+#define JTAG_PROGRESS_INTERVAL 250
+
+static const char *XSVF_RESULT[] = {
+	"Success!",
+	"Unknown error: XSVF_ERROR_UNKNOWN",
+	"Device did not respond as expected: XSVF_ERROR_TDOMISMATCH",
+	"Device did not respond: XSVF_ERROR_MAXRETRIES",
+	"Unknown XSVF command: XSVF_ERROR_ILLEGALCMD",
+	"Unknown JTAG state: XSVF_ERROR_ILLEGALSTATE",
+	"Error, data overflow: XSVF_ERROR_DATAOVERFLOW",
+	"Some other error: XSVF_ERROR_LAST",
+};
+
 JtagGui::JtagGui(MainWidgetFrame *parent) : QWidget(parent)
 {
 	this->parent = parent;
+	image_data = NULL;
+	image_size = 0;
+	offset = 0;
+	chunk_size = XSVF_CHUNK_DEFAULT;
+	request = 0;
+	sent_end = false;
+
+	QLabel *file_label = new QLabel("XSVF File: ");
+	QLabel *log_label = new QLabel("Log: ");
+
+	program_btn = new QPushButton("Program XSVF");
+
+	file = new QLineEdit;
+	msglog = new QTextEdit;
+	msglog->setReadOnly(true);
+	progress_bar = new QProgressBar;
+	progress_bar->setRange(0, 100);
+	progress_bar->setValue(0);
+
+	QVBoxLayout *vlayout = new QVBoxLayout;
+
+	connect(program_btn, SIGNAL(clicked()), this, SLOT(program_xsvf()));
+	connect(this, SIGNAL(progress(int)), progress_bar, SLOT(setValue(int)));
+
+	vlayout->addWidget(file_label);
+	vlayout->addWidget(file);
+	vlayout->addWidget(program_btn);
+	vlayout->addWidget(progress_bar);
+	vlayout->addSpacing(50);
+	vlayout->addWidget(log_label);
+	vlayout->addWidget(msglog);
+
+	setLayout(vlayout);
+}
+
+void JtagGui::program_xsvf(void)
+{
+	QString qmsg_start = QString("Programming XSVF...");
+	QString qmsg_fail = QString("Programming XSVF...Failed");
+
+	if (image_data != NULL)
+		return;
+
+	image.setFileName(file->text());
+	if (!image.open(QIODevice::ReadOnly))
+	{
+		postMsgEvent("Could not open the XSVF file.");
+		return;
+	}
+	image_size = image.size();
+	if (image_size > 0)
+		image_data = image.map(0, image_size);
+	if (image_data == NULL)
+	{
+		postMsgEvent("Could not map the XSVF file.");
+		image.close();
+		return;
+	}
+
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_start));
+	progress_timer.invalidate();
+	emit progress(0);
+
+	if (!parent->bp->is_open() || !parent->bp->enter_mode_jtag())
+	{
+		postMsgEvent("JTAG Failed, it needs a v4.");
+		QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_fail));
+		finish_xsvf(-1);
+		return;
+	}
+	postMsgEvent("JTAG OK.");
+
+	chunk_size = parent->bp->jtag_xsvf_chunk_size();
+	if (chunk_size == 0)
+		chunk_size = XSVF_CHUNK_DEFAULT;
+	postMsgEvent(QString("Chunk size %1 bytes.").arg(chunk_size).toLatin1().constData());
+
+	/* From here on replies come in through reply_ready(), so the GUI
+	   only wakes up to hand over a chunk that is already staged. */
+	program_btn->setEnabled(false);
+	offset = 0;
+	sent_end = false;
+	stage_chunk();
+	connect(parent->bp, SIGNAL(reply_ready(quint32, QByteArray, bool)),
+		this, SLOT(xsvf_replied(quint32, QByteArray, bool)));
+	request = parent->bp->submit(QByteArray(1, XSVF_PLAYER), 1, XSVF_REPLY_TIMEOUT);
+}
+
+void JtagGui::stage_chunk(void)
+{
+	int length = (int)qMin((qint64)chunk_size, image_size - offset);
+
+	chunk.resize(XSVF_CHUNK_HEADER);
+	chunk[0] = (char)(length >> 8);
+	chunk[1] = (char)length;
+	if (length > 0)
+		chunk.append((const char *)image_data + offset, length);
+}
+
+void JtagGui::send_chunk(void)
+{
+	int length = chunk.size() - XSVF_CHUNK_HEADER;
+
+	/* The answer to this chunk is the request for the next one, which
+	   the firmware sends as soon as it starts playing this one. */
+	request = parent->bp->submit(chunk, 1, XSVF_REPLY_TIMEOUT);
+	offset += length;
+	if (length == 0)
+	{
+		sent_end = true;
+		postMsgEvent("End of file reached, waiting for result...");
+		return;
+	}
+	report_progress();
+	stage_chunk();
+}
+
+void JtagGui::xsvf_replied(quint32 id, QByteArray reply, bool complete)
+{
+	unsigned char result;
+
+	if (id != request)
+		return;
+	if (!complete || reply.isEmpty())
+	{
+		postMsgEvent("No reply.... Quitting.");
+		finish_xsvf(-1);
+		return;
+	}
+	result = (unsigned char)reply.at(0);
+	/* A request after the empty chunk is a result of its own. */
+	if (result == XSVF_READY_FOR_DATA && !sent_end)
+	{
+		send_chunk();
+		return;
+	}
+	finish_xsvf(result);
+}
+
+void JtagGui::report_progress(void)
+{
+	/* A chunk plays in a few milliseconds, the bar needs far fewer
+	   redraws than that. */
+	if (offset < image_size && progress_timer.isValid() &&
+	    progress_timer.elapsed() < JTAG_PROGRESS_INTERVAL)
+		return;
+	progress_timer.start();
+	emit progress((int)((offset * 100) / image_size));
+}
+
+void JtagGui::finish_xsvf(int result)
+{
+	QString qmsg_fail = QString("Programming XSVF...Failed");
+	QString qmsg_success = QString("Programming XSVF...Success!");
+
+	disconnect(parent->bp, SIGNAL(reply_ready(quint32, QByteArray, bool)),
+		this, SLOT(xsvf_replied(quint32, QByteArray, bool)));
+	if (image_data != NULL)
+		image.unmap((uchar *)image_data);
+	image_data = NULL;
+	image.close();
+	chunk.clear();
+	program_btn->setEnabled(true);
+
+	if (result < 0)
+		return;
+	if (result < (int)(sizeof(XSVF_RESULT) / sizeof(XSVF_RESULT[0])))
+		postMsgEvent(XSVF_RESULT[result]);
+	else
+		postMsgEvent(QString("Unknown result 0x%1.").arg(result, 2, 16, QChar('0')).toLatin1().constData());
+	if (result == XSVF_ERROR_NONE)
+	{
+		emit progress(100);
+		QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_success));
+	} else {
+		QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_fail));
+	}
+	/* jtag() never returns, only a hardware reset leaves it. */
+	postMsgEvent("Reset the Bus Pirate to leave JTAG mode.");
 }
 
 void JtagGui::customEvent(QEvent *ev)
@@ -23,4 +228,3 @@ void JtagGui::postMsgEvent(const char* msg)
 	QString qmsg = QString(msg);
 	QCoreApplication::sendEvent(this, new JtagLogMsgEvent(qmsg));
 }
-
@@ -5,8 +5,13 @@
 #include "Interface.h"
 #include "Events.h"
 
+/* Milliseconds incoming lines are gathered for before being shown. */
+#define RAW_TEXT_FLUSH_INTERVAL 50
+/* Lines kept in the log, older ones are dropped. */
+#define RAW_TEXT_MAX_LINES      10000
+
 /* Interface: Raw Ascii Text */
-RawTextGui::RawTextGui(MainWidgetFrame *parent) : QWidget(parent)
+RawTextGui::RawTextGui(MainWidgetFrame *parent) : QWidget(parent), flush_timer(this)
 {
 	this->parent = parent;
 
@@ -15,7 +20,14 @@ RawTextGui::RawTextGui(MainWidgetFrame *parent) : QWidget(parent)
 	raw_file = new QLineEdit("test_hex_ascii.txt");
 	QPushButton *button = new QPushButton("Run");
 	QLabel *log_label = new QLabel("Log: ");
-	msglog = new QTextEdit;
+	msglog = new QPlainTextEdit;
+	msglog->setReadOnly(true);
+	msglog->setMaximumBlockCount(RAW_TEXT_MAX_LINES);
+	msglog->setUndoRedoEnabled(false);
+
+	flush_timer.setSingleShot(true);
+	flush_timer.setInterval(RAW_TEXT_FLUSH_INTERVAL);
+	connect(&flush_timer, SIGNAL(timeout()), this, SLOT(flush_log()));
 	
 	connect(button, SIGNAL(clicked()), this, SLOT(ExecuteFile()));
 
@@ -33,14 +45,35 @@ void RawTextGui::customEvent(QEvent *ev)
 {
 	if (static_cast<BPEventType>(ev->type()) == AsciiHexLogMsgEventType)
 	{
-		msglog->append(dynamic_cast<AsciiHexLogMsgEvent* >(ev)->msg);
+		/* Laying the widget out once per line is what stalls a fast
+		   stream, lines are shown a batch per timer tick instead. */
+		pending.append(dynamic_cast<AsciiHexLogMsgEvent* >(ev)->msg);
+		if (!flush_timer.isActive())
+			flush_timer.start();
 	}
 }
 
+void RawTextGui::flush_log(void)
+{
+	QScrollBar *scroll = msglog->verticalScrollBar();
+	bool follow = scroll->value() == scroll->maximum();
+
+	if (pending.isEmpty())
+		return;
+
+	msglog->setUpdatesEnabled(false);
+	msglog->appendPlainText(pending.join("\n"));
+	pending.clear();
+	if (follow)
+		scroll->setValue(scroll->maximum());
+	msglog->setUpdatesEnabled(true);
+}
+
 void RawTextGui::postMsgEvent(const char* msg)
 {
 	QString qmsg = QString(msg);
-	QCoreApplication::sendEvent(this, new AsciiHexLogMsgEvent(qmsg));
+	AsciiHexLogMsgEvent event(qmsg);
+	QCoreApplication::sendEvent(this, &event);
 }
 
 void RawTextGui::ExecuteFile()
@@ -74,8 +107,9 @@ void RawTextGui::ExecuteFile()
 		response = parent->bp->command(d);
 		qmsg = str.arg(i++, 3, 10, QChar('0')).arg(byte.data())
 			.arg(d, 3, 10, QChar('0')).arg(response.toHex().data());
-		QCoreApplication::sendEvent(this, new AsciiHexLogMsgEvent(qmsg));
+		postMsgEvent(qmsg.toLatin1());
 	}
+	flush_log();
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_success));
 }
 
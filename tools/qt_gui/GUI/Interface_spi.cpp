@@ -5,6 +5,17 @@
 #include "MainWin.h"
 #include "Interface.h"
 #include "Events.h"
+#include "HexView.h"
+
+/* One write-then-read per chunk, the firmware buffers it in its terminal
+   buffer, which is at least this large on every board. */
+#define SPI_CHUNK_SIZE        4096
+#define SPI_PAGE_SIZE         256
+#define SPI_CHUNKS_IN_FLIGHT  4
+/* Milliseconds between progress updates. */
+#define SPI_PROGRESS_INTERVAL 250
+/* Status register reads before a page write is given up on. */
+#define SPI_WRITE_POLLS       100
 
 SpiGui::SpiGui(MainWidgetFrame *parent) : QWidget(parent)
 {
@@ -20,6 +31,10 @@ SpiGui::SpiGui(MainWidgetFrame *parent) : QWidget(parent)
 	file = new QLineEdit;
 	msglog = new QTextEdit;
 	msglog->setReadOnly(true);
+	dump_view = new HexView;
+	progress_bar = new QProgressBar;
+	progress_bar->setRange(0, 100);
+	progress_bar->setValue(0);
 
 	QVBoxLayout *vlayout = new QVBoxLayout;
 	QHBoxLayout *hlayout = new QHBoxLayout;
@@ -27,6 +42,7 @@ SpiGui::SpiGui(MainWidgetFrame *parent) : QWidget(parent)
 	connect(read_btn, SIGNAL(clicked()), this, SLOT(read_spi()));
 	connect(write_btn, SIGNAL(clicked()), this, SLOT(write_spi()));
 	connect(chip_id_btn, SIGNAL(clicked()), this, SLOT(spi_chip_id()));
+	connect(this, SIGNAL(progress(int)), progress_bar, SLOT(setValue(int)));
 
 	vlayout->addWidget(file_label);
 	vlayout->addWidget(file);
@@ -36,28 +52,21 @@ SpiGui::SpiGui(MainWidgetFrame *parent) : QWidget(parent)
 	hlayout->addWidget(chip_id_btn);
 	
 	vlayout->addLayout(hlayout);
+	vlayout->addWidget(progress_bar);
 	vlayout->addSpacing(50);
 	vlayout->addWidget(log_label);
 	vlayout->addWidget(msglog);
+	vlayout->addWidget(dump_view);
 
 	setLayout(vlayout);
 }
 
-void SpiGui::read_spi(void)
+bool SpiGui::setup_spi(void)
 {
-	int ret = 0, i = 0;
-	unsigned long chipsize = 262144;
-	QString qmsg_start = QString("Reading SPI Chip...");
-	QString qmsg_fail = QString("Reading SPI Chip...Failed");
-	QString qmsg_success = QString("Reading SPI Chip...Success!");
-	QByteArray data_byte("\x03\x00\x00\x00");
-	QByteArray read_cmd, read_resp;
-
-	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_start));
-	postMsgEvent("JEDEC READ");
+	int ret = 0;
 
-	if (!parent->bp->serial->isOpen())
-		goto err;
+	if (!parent->bp->is_open())
+		return false;
 
 	ret = parent->bp->enter_mode_spi();
 	if (ret)
@@ -65,7 +74,7 @@ void SpiGui::read_spi(void)
 		postMsgEvent("SPI OK.");
 	} else {
 		postMsgEvent("SPI Failed.");
-		goto err;
+		return false;
 	}
 
 	ret = parent->bp->bbio_peripherial_set(0x0B);
@@ -74,7 +83,7 @@ void SpiGui::read_spi(void)
 		postMsgEvent("Peripherial Config Ok.");
 	} else {
 		postMsgEvent("Peripherial Config Failed.");
-		goto err;
+		return false;
 	}
 
 	ret = parent->bp->bbio_speed_set(0x06);
@@ -83,7 +92,7 @@ void SpiGui::read_spi(void)
 		postMsgEvent("SPI Speed Config Ok.");
 	} else {
 		postMsgEvent("SPI Speed Config Failed.");
-		goto err;
+		return false;
 	}
 
 	ret = parent->bp->spi_configure_set(0x08);
@@ -92,64 +101,172 @@ void SpiGui::read_spi(void)
 		postMsgEvent("SPI Config Ok.");
 	} else {
 		postMsgEvent("SPI Config Failed.");
-		goto err;
+		return false;
 	}
+	return true;
+}
 
-	ret = parent->bp->spi_cs_low();
-	if (ret)
-	{
-		postMsgEvent("CS Low: Ok.");
-	} else {
-		postMsgEvent("CS Low: Failed.");
-	}
+void SpiGui::report_progress(unsigned long done, unsigned long total)
+{
+	/* Redrawing the bar for every chunk would cost more than the chunk. */
+	if (done < total && progress_timer.isValid() &&
+	    progress_timer.elapsed() < SPI_PROGRESS_INTERVAL)
+		return;
+	progress_timer.start();
+	emit progress((int)((done * 100) / total));
+}
+
+QByteArray SpiGui::address_command(char command, unsigned long address)
+{
+	QByteArray data;
+	data.append(command);
+	data.append((char)(address >> 16));
+	data.append((char)(address >> 8));
+	data.append((char)address);
+	return data;
+}
+
+void SpiGui::read_spi(void)
+{
+	unsigned long chipsize = 262144;
+	unsigned long address = 0, done = 0;
+	QString qmsg_start = QString("Reading SPI Chip...");
+	QString qmsg_fail = QString("Reading SPI Chip...Failed");
+	QString qmsg_success = QString("Reading SPI Chip...Success!");
+	QQueue<quint32> pending;
+	QByteArray read_resp;
 
-	//for (i = 0; i <chipsize; i+=16)
-	//{
-		read_cmd = parent->bp->bbio_bulk_trans(data_byte, 4);
-		if (read_cmd.contains("\x01"))
+	/* The old dump may be the file about to be overwritten. */
+	dump_view->clear();
+	QFile qfile(file->text());
+	if (!qfile.open(QIODevice::WriteOnly))
+		return;
+
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_start));
+	postMsgEvent("JEDEC READ");
+	progress_timer.invalidate();
+	emit progress(0);
+
+	if (!setup_spi())
+		goto err;
+
+	/* Each chunk is one write-then-read, a few are kept queued so the
+	   link never waits on the round trip in between. */
+	while (done < chipsize)
+	{
+		while (address < chipsize && pending.size() < SPI_CHUNKS_IN_FLIGHT)
 		{
-			postMsgEvent("Reading...");
-		} else {
-			postMsgEvent("Reading...Failed!");
+			pending.enqueue(parent->bp->post(BinMode::spi_write_then_read_request(
+				address_command(READ, address), SPI_CHUNK_SIZE)));
+			address += SPI_CHUNK_SIZE;
 		}
 
-	for (i=0; i<chipsize; i+=16)
-	{
-		QByteArray ba;
-		ba.resize(16);
-		read_resp = parent->bp->bbio_bulk_trans(ba, 16);
-		if (read_resp.contains("\x01"))
+		read_resp = parent->bp->collect(pending.dequeue());
+		if (!read_resp.startsWith("\x01") || read_resp.size() != SPI_CHUNK_SIZE + 1)
 		{
-			for (i=0; i<16; i++)  postMsgEvent(QString("0x%1 ").arg((QString)read_resp.mid(i,1).toHex()).toAscii());
-		} else {
 			postMsgEvent("Reading...Failed!");
+			while (!pending.isEmpty())
+				parent->bp->collect(pending.dequeue());
+			goto err;
 		}
+		qfile.write(read_resp.constData() + 1, SPI_CHUNK_SIZE);
+		done += SPI_CHUNK_SIZE;
+		report_progress(done, chipsize);
 	}
+	postMsgEvent("Reading...Ok.");
+	qfile.close();
+	dump_view->load(file->text());
 
-	ret = parent->bp->spi_cs_high();
-	if (ret)
+	if (parent->bp->reset_bbio())
 	{
-		postMsgEvent("CS High: Ok.");
+		postMsgEvent("Reset to BBIO mode: Ok.");
 	} else {
-		postMsgEvent("CS High: Failed.");
+		postMsgEvent("Reset to BBIO mode: Failed.");
 	}
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_success));
+	return;	
+err:
+	parent->bp->reset_bbio();
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_fail));
+}
 
-	ret = parent->bp->reset_bbio();
-	if (ret)
+bool SpiGui::wait_write_done(void)
+{
+	QByteArray status;
+	int i;
+
+	for (i = 0; i < SPI_WRITE_POLLS; i++)
+	{
+		status = parent->bp->spi_write_then_read(QByteArray(1, RDSR), 1);
+		if (status.size() == 2 && status.startsWith("\x01") && !(status.at(1) & 0x01))
+			return true;
+	}
+	return false;
+}
+
+void SpiGui::write_spi(void)
+{
+	unsigned long address, done = 0, total;
+	QString qmsg_start = QString("Writing SPI Chip...");
+	QString qmsg_fail = QString("Writing SPI Chip...Failed");
+	QString qmsg_success = QString("Writing SPI Chip...Success!");
+	QList<QByteArray> requests, replies;
+	QByteArray data, chunk;
+	int page, i;
+
+	QFile qfile(file->text());
+	if (!qfile.open(QIODevice::ReadOnly))
+		return;
+	data = qfile.readAll();
+	qfile.close();
+	total = data.size();
+
+	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_start));
+	progress_timer.invalidate();
+	emit progress(0);
+
+	if (total == 0 || !setup_spi())
+		goto err;
+
+	for (address = 0; address < total; address += SPI_CHUNK_SIZE)
+	{
+		chunk = data.mid(address, SPI_CHUNK_SIZE);
+		for (page = 0; page < chunk.size(); page += SPI_PAGE_SIZE)
+		{
+			/* PW erases and programs the page in one go, the write
+			   enable ahead of it is queued along with it. */
+			requests.clear();
+			requests.append(BinMode::spi_write_then_read_request(QByteArray(1, WREN), 0));
+			requests.append(BinMode::spi_write_then_read_request(
+				address_command(PW, address + page) + chunk.mid(page, SPI_PAGE_SIZE), 0));
+			replies = parent->bp->exchange_all(requests);
+			for (i = 0; i < replies.size(); i++)
+				if (!replies.at(i).startsWith("\x01"))
+					break;
+			if (i < replies.size() || !wait_write_done())
+			{
+				postMsgEvent("Writing...Failed!");
+				goto err;
+			}
+		}
+		done += chunk.size();
+		report_progress(done, total);
+	}
+	postMsgEvent("Writing...Ok.");
+
+	if (parent->bp->reset_bbio())
 	{
 		postMsgEvent("Reset to BBIO mode: Ok.");
 	} else {
 		postMsgEvent("Reset to BBIO mode: Failed.");
 	}
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_success));
-	return;	
+	return;
 err:
+	parent->bp->reset_bbio();
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_fail));
 }
 
-void SpiGui::write_spi(void)
-{}
-
 void SpiGui::spi_chip_id(void)
 {
 	QString qmsg_start = QString("Getting SPI Chip Id...");
@@ -162,7 +279,7 @@ void SpiGui::spi_chip_id(void)
 	QCoreApplication::sendEvent(parent->parent, new BPStatusMsgEvent(qmsg_start));
 	postMsgEvent("JEDEC RDID");
 	
-	if (!parent->bp->serial->isOpen())
+	if (!parent->bp->is_open())
 		goto err;
 
 	ret = parent->bp->enter_mode_spi();
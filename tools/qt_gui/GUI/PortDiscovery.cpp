@@ -0,0 +1,136 @@
+#include <QtCore>
+#include "BPSettings.h"
+#include "PortDiscovery.h"
+
+/* USB IDs a Bus Pirate shows up with: the v3 FT232RL and the v4 CDC. */
+static const struct
+{
+	int vendor;
+	int product;
+} BUS_PIRATE_IDS[] = {
+	{ 0x0403, 0x6001 },
+	{ 0x04D8, 0xFB00 },
+};
+
+PortDiscovery::PortDiscovery(BPSettings *cfg, QObject *parent) : QObject(parent), timer(this)
+{
+	this->cfg = cfg;
+	timer.setSingleShot(true);
+	connect(&timer, SIGNAL(timeout()), this, SLOT(probe_timeout()));
+}
+
+bool PortDiscovery::is_candidate(const QextPortInfo &info)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(BUS_PIRATE_IDS) / sizeof(BUS_PIRATE_IDS[0]); i++)
+		if (info.vendorID == BUS_PIRATE_IDS[i].vendor &&
+		    info.productID == BUS_PIRATE_IDS[i].product)
+			return true;
+	return false;
+}
+
+QString PortDiscovery::cache_key(const QString &serial)
+{
+	return QString("/discovery/") + serial;
+}
+
+bool PortDiscovery::is_running(void) const
+{
+	return timer.isActive() || !probes.isEmpty();
+}
+
+QStringList PortDiscovery::present_ports(void) const
+{
+	return present;
+}
+
+void PortDiscovery::start(bool use_cache)
+{
+	if (is_running())
+		return;
+	bus_pirates.clear();
+	present.clear();
+
+	foreach (QextPortInfo info, QextSerialEnumerator::getPorts())
+	{
+		if (!is_candidate(info))
+			continue;
+		present.append(info.portName);
+
+		if (use_cache && !info.serialNumber.isEmpty() &&
+		    cfg->contains(cache_key(info.serialNumber)))
+		{
+			if (cfg->value(cache_key(info.serialNumber)).toBool())
+				bus_pirates.append(info.portName);
+			continue;
+		}
+
+		QextSerialPort *port = new QextSerialPort(info.portName, QextSerialPort::EventDriven);
+		port->setParent(this);
+		port->setBaudRate((BaudRateType)cfg->baud_rate);
+		port->setDataBits((DataBitsType)cfg->databits);
+		port->setStopBits((StopBitsType)cfg->stopbits);
+		port->setParity((ParityType)cfg->parity);
+		port->setFlowControl((FlowType)cfg->flowctrl);
+		if (!port->open(QIODevice::ReadWrite))
+		{
+			/* Busy, most likely with another program, which says
+			   nothing about what it is. */
+			delete port;
+			continue;
+		}
+		port->flush();
+		connect(port, SIGNAL(readyRead()), this, SLOT(probe_replied()));
+
+		Probe probe;
+		probe.serial = info.serialNumber;
+		probes.insert(port, probe);
+		port->write(QByteArray(DISCOVERY_ENTRY_LENGTH, '\x00'));
+	}
+
+	timer.start(probes.isEmpty() ? 0 : DISCOVERY_TIMEOUT);
+}
+
+void PortDiscovery::probe_replied(void)
+{
+	QextSerialPort *port = qobject_cast<QextSerialPort *>(sender());
+
+	if (port == NULL || !probes.contains(port))
+		return;
+	probes[port].reply.append(port->readAll());
+	if (probes[port].reply.contains("BBIO1"))
+		end_probe(port, true);
+}
+
+void PortDiscovery::probe_timeout(void)
+{
+	if (probes.isEmpty())
+	{
+		bus_pirates.sort();
+		emit finished(bus_pirates);
+		return;
+	}
+	foreach (QextSerialPort *port, probes.keys())
+		end_probe(port, false);
+}
+
+void PortDiscovery::end_probe(QextSerialPort *port, bool found)
+{
+	Probe probe = probes.take(port);
+
+	if (!probe.serial.isEmpty())
+		cfg->setValue(cache_key(probe.serial), found);
+	if (found)
+		bus_pirates.append(port->portName());
+	disconnect(port, SIGNAL(readyRead()), this, SLOT(probe_replied()));
+	port->close();
+	port->deleteLater();
+
+	if (probes.isEmpty())
+	{
+		timer.stop();
+		bus_pirates.sort();
+		emit finished(bus_pirates);
+	}
+}
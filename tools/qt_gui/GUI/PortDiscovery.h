@@ -0,0 +1,65 @@
+#ifndef __PORTDISCOVERY_H
+#define __PORTDISCOVERY_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include "qextserialport/qextserialport.h"
+#include "qextserialport/qextserialenumerator.h"
+
+/* Milliseconds every probe gets to answer, they all run at once. */
+#define DISCOVERY_TIMEOUT       300
+/* Zeros sent to a probed port, a terminal needs 20 to enter bitbang mode
+   and answers "BBIO1"; a board already in binary mode answers the first. */
+#define DISCOVERY_ENTRY_LENGTH  20
+
+class BPSettings;
+
+/* Looks for Bus Pirates among the USB serial ports the enumerator lists.
+   Every candidate port is opened and probed at the same time and the
+   answers come in on the event loop, so a fixture with many adapters
+   costs one DISCOVERY_TIMEOUT instead of one per port.  What a probe
+   found out is kept in the settings by USB serial number, and a device
+   seen before is not opened again unless the cache is skipped.  Ports
+   that answer are left in bitbang mode. */
+class PortDiscovery : public QObject
+{
+Q_OBJECT
+public:
+	PortDiscovery(BPSettings *cfg, QObject *parent = 0);
+
+	/* finished() always follows from the event loop, even when every
+	   port was known. */
+	void start(bool use_cache = true);
+	bool is_running(void) const;
+
+	/* Every candidate port present during the last start(). */
+	QStringList present_ports(void) const;
+
+signals:
+	void finished(QStringList bus_pirates);
+
+private slots:
+	void probe_replied(void);
+	void probe_timeout(void);
+
+private:
+	struct Probe
+	{
+		QString    serial;
+		QByteArray reply;
+	};
+
+	static bool is_candidate(const QextPortInfo &info);
+	static QString cache_key(const QString &serial);
+	void end_probe(QextSerialPort *port, bool found);
+
+	BPSettings *cfg;
+	QHash<QextSerialPort *, Probe> probes;
+	QStringList bus_pirates;
+	QStringList present;
+	QTimer timer;
+};
+
+#endif
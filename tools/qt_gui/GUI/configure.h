@@ -6,7 +6,7 @@
 #define ENABLE_1WIRE    1
 #define ENABLE_RAWWIRE  0
 #define ENABLE_ASCII    1
-#define ENABLE_JTAG     0
+#define ENABLE_JTAG     1
 
 #endif
 
@@ -6,6 +6,12 @@
 #include <QMutexLocker>
 #include <QDebug>
 
+/*
+ * Bytes taken from the driver per read() in event driven mode. A whole burst
+ * normally fits, so it costs one system call however it is read back.
+ */
+#define POSIX_READ_AHEAD 65536
+
 /*!
 Copy constructor.
 */
@@ -762,9 +768,10 @@ bool QextSerialPort::open(OpenMode mode)
             setTimeout(Settings.Timeout_Millisec);
             tcsetattr(fd, TCSAFLUSH, &Posix_CommConfig);
 
+            readAhead.clear();
             if (queryMode() == QextSerialPort::EventDriven) {
                 readNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
-                connect(readNotifier, SIGNAL(activated(int)), this, SIGNAL(readyRead()));
+                connect(readNotifier, SIGNAL(activated(int)), this, SLOT(readNotified()));
             }
         } else {
             qDebug() << "could not open file:" << strerror(errno);
@@ -795,6 +802,7 @@ void QextSerialPort::close()
             delete readNotifier;
             readNotifier = 0;
         }
+        readAhead.clear();
     }
 }
 
@@ -805,8 +813,10 @@ associated with the class is not currently open.
 void QextSerialPort::flush()
 {
     QMutexLocker lock(mutex);
-    if (isOpen())
+    if (isOpen()) {
         tcflush(fd, TCIOFLUSH);
+        readAhead.clear();
+    }
 }
 
 /*!
@@ -826,17 +836,19 @@ qint64 QextSerialPort::size() const
 
 /*!
 Returns the number of bytes waiting in the port's receive queue.  This function will return 0 if
-the port is not currently open, or -1 on error.
+the port is not currently open, or -1 on error.  An event driven port only counts what already
+arrived through readyRead(), without asking the driver.
 */
 qint64 QextSerialPort::bytesAvailable() const
 {
     QMutexLocker lock(mutex);
     if (isOpen()) {
-        int bytesQueued;
-        if (ioctl(fd, FIONREAD, &bytesQueued) == -1) {
+        int bytesQueued = 0;
+        if (queryMode() != QextSerialPort::EventDriven &&
+            ioctl(fd, FIONREAD, &bytesQueued) == -1) {
             return (qint64)-1;
         }
-        return bytesQueued + QIODevice::bytesAvailable();
+        return bytesQueued + readAhead.size() + QIODevice::bytesAvailable();
     }
     return 0;
 }
@@ -981,6 +993,13 @@ qint64 QextSerialPort::readData(char * data, qint64 maxSize)
 {
     QMutexLocker lock(mutex);
     int retVal = 0;
+    if (queryMode() == QextSerialPort::EventDriven) {
+        // everything the driver had was already taken when readyRead() fired
+        retVal = (int)qMin(maxSize, (qint64)readAhead.size());
+        memcpy(data, readAhead.constData(), retVal);
+        readAhead.remove(0, retVal);
+        return retVal;
+    }
     retVal = ::read(fd, data, maxSize);
     if (retVal == -1)
         lastErr = E_READ_FAILED;
@@ -988,6 +1007,41 @@ qint64 QextSerialPort::readData(char * data, qint64 maxSize)
     return retVal;
 }
 
+/*!
+Called when the port becomes readable in event driven mode.  Reads until the driver is empty,
+which is a single read() for anything up to POSIX_READ_AHEAD bytes, and emits readyRead() once
+for all of it.  A port that fails to read, such as a USB adapter that was unplugged, stops
+being watched instead of waking the event loop forever.
+*/
+void QextSerialPort::readNotified()
+{
+    bool readable = false;
+    {
+        QMutexLocker lock(mutex);
+        if (!isOpen())
+            return;
+        for (;;) {
+            int offset = readAhead.size();
+            readAhead.resize(offset + POSIX_READ_AHEAD);
+            int retVal = ::read(fd, readAhead.data() + offset, POSIX_READ_AHEAD);
+            readAhead.resize(offset + (retVal > 0 ? retVal : 0));
+            if (retVal > 0)
+                readable = true;
+            if (retVal == -1 && errno != EAGAIN && errno != EINTR) {
+                lastErr = E_READ_FAILED;
+                if (readNotifier)
+                    readNotifier->setEnabled(false);
+                break;
+            }
+            if (retVal < POSIX_READ_AHEAD)
+                break;
+        }
+    }
+    // outside the lock, slots connected to readyRead() read straight away
+    if (readable)
+        emit readyRead();
+}
+
 /*!
 Writes a block of data to the serial port.  This function will write maxSize bytes
 from the buffer pointed to by data to the serial port.  Return value is the number
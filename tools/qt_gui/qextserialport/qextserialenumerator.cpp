@@ -5,6 +5,7 @@
 #include <QDebug>
 #include <QMetaType>
 #include <QRegExp>
+#include <QStringList>
 
 QextSerialEnumerator::QextSerialEnumerator( )
 {
@@ -233,6 +234,17 @@ QextSerialEnumerator::~QextSerialEnumerator( )
             portInfo->productID = idRx.cap(2).toInt(&dummy, 16);
             //qDebug() << "got vid:" << vid << "pid:" << pid;
         }
+        // USB\VID_04D8&PID_FB00\<serial>, FTDIBUS\VID_0403+PID_6001+<serial>A\0000;
+        // an instance with '&' in it is made up from the hub port instead
+        DWORD nSize = 0;
+        TCHAR buf[MAX_PATH];
+        if ( SetupDiGetDeviceInstanceId(devInfo, devData, buf, sizeof(buf), &nSize) ) {
+            QStringList instance = TCHARToQString(buf).split("\\");
+            if( instance.size() == 3 && instance.at(0) == "FTDIBUS" )
+                portInfo->serialNumber = instance.at(1).section('+', 2);
+            else if( instance.size() == 3 && !instance.at(2).contains('&') )
+                portInfo->serialNumber = instance.at(2);
+        }
         return true;
     }
 
@@ -507,6 +519,52 @@ void QextSerialEnumerator::setUpNotificationOSX( )
     // arm the callback, and clear any devices that are terminated
     deviceTerminatedCallbackOSX( this, portIterator );
 }
+#else // Q_OS_MAC
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+QString QextSerialEnumerator::readSysfsAttribute(const QString & dir, const char * name)
+{
+    QFile attribute(dir + "/" + name);
+    if (!attribute.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromLatin1(attribute.readAll()).trimmed();
+}
+
+/*
+ * Every tty the kernel knows is under /sys/class/tty, the ones on a USB device
+ * have it a few levels up from their device link, where idVendor lives.
+ */
+void QextSerialEnumerator::scanPortsNix(QList<QextPortInfo> & infoList)
+{
+    QDir ttys("/sys/class/tty");
+    foreach (QString name, ttys.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFileInfo device(ttys.filePath(name) + "/device");
+        if (!device.exists())
+            continue;
+        QString dir = device.canonicalFilePath();
+        int levels;
+        for (levels = 0; levels < 4 && !dir.isEmpty(); levels++) {
+            if (QFile::exists(dir + "/idVendor"))
+                break;
+            dir = QFileInfo(dir).path();
+        }
+        if (levels == 4 || !QFile::exists(dir + "/idVendor"))
+            continue;
+
+        QextPortInfo info;
+        bool ok;
+        info.portName = "/dev/" + name;
+        info.physName = info.portName;
+        info.friendName = readSysfsAttribute(dir, "product");
+        info.enumName = "usb";
+        info.vendorID = readSysfsAttribute(dir, "idVendor").toInt(&ok, 16);
+        info.productID = readSysfsAttribute(dir, "idProduct").toInt(&ok, 16);
+        info.serialNumber = readSysfsAttribute(dir, "serial");
+        infoList.append(info);
+    }
+}
 #endif // Q_OS_MAC
 
 #endif // Q_OS_UNIX
@@ -537,7 +595,7 @@ QList<QextPortInfo> QextSerialEnumerator::getPorts()
         #ifdef Q_OS_MAC
             scanPortsOSX(ports);
         #else
-            qCritical("Enumeration for POSIX systems is not implemented yet.");
+            scanPortsNix(ports);
         #endif /* Q_OS_MAC */
     #endif /*Q_OS_UNIX*/
 
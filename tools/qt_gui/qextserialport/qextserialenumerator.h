@@ -32,6 +32,7 @@ struct QextPortInfo {
     QString enumName;   ///< Enumerator name.
     int vendorID;       ///< Vendor ID.
     int productID;      ///< Product ID
+    QString serialNumber; ///< USB serial number, empty if the device has none.
 };
 
 #ifdef Q_OS_WIN
@@ -158,10 +159,11 @@ Q_OBJECT
 
             #else // Q_OS_MAC
               /*!
-               * Search for serial ports on unix.
+               * Search for USB serial ports on unix, through sysfs.
                *    \param infoList list with result.
                */
-              // static void scanPortsNix(QList<QextPortInfo> & infoList);
+              static void scanPortsNix(QList<QextPortInfo> & infoList);
+              static QString readSysfsAttribute(const QString & dir, const char * name);
             #endif // Q_OS_MAC
         #endif /* Q_OS_UNIX */
 
@@ -280,6 +280,7 @@ class QextSerialPort: public QIODevice
 #ifdef Q_OS_UNIX
         int fd;
         QSocketNotifier *readNotifier;
+        QByteArray readAhead;
         struct termios Posix_CommConfig;
         struct termios old_termios;
         struct timeval Posix_Timeout;
@@ -308,6 +309,13 @@ class QextSerialPort: public QIODevice
         qint64 readData(char * data, qint64 maxSize);
         qint64 writeData(const char * data, qint64 maxSize);
 
+    private slots:
+        /*!
+         * Drains the driver into the read-ahead buffer of an event driven port
+         * and emits readyRead(). POSIX only, does nothing elsewhere.
+         */
+        void readNotified();
+
     signals:
 //        /**
 //         * This signal is emitted whenever port settings are updated.
@@ -53,6 +53,12 @@ void QextSerialPort::platformSpecificDestruct() {
     delete bytesToWriteLock;
 }
 
+/*!
+Only used by the POSIX read-ahead, Windows reports reads from its event thread.
+*/
+void QextSerialPort::readNotified()
+{}
+
 /*!
 Overrides the = operator
 */